@@ -34,6 +34,7 @@
 ****************************************************************************/
 
 #include <pdal/KernelFactory.hpp>
+#include <pdal/PluginManager.hpp>
 #include <pdal/StageFactory.hpp>
 #include <pdal/pdal_config.hpp>
 
@@ -269,10 +270,12 @@ int main(int argc, char* argv[])
         }
     }
 
-    // If the kernel was not available, then light up the plugins and retry
+    // If the kernel was not available, then light up the plugin named for
+    // the command (or all of the kernel plugins if it isn't found) and retry
     if (!isValidKernel)
     {
-        KernelFactory f(false);
+        PluginManager::getInstance().guessLoadByPath("kernels." +
+            boost::algorithm::to_lower_copy(command));
         loaded_kernels.clear();
         loaded_kernels = f.getKernelNames();
 
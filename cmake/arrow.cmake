@@ -0,0 +1,34 @@
+#
+# Arrow and Parquet support
+#
+
+find_package(Arrow CONFIG QUIET)
+if (Arrow_FOUND)
+    find_package(Parquet CONFIG QUIET
+        HINTS ${Arrow_DIR}/../Parquet)
+endif()
+mark_as_advanced(CLEAR Arrow_DIR)
+mark_as_advanced(CLEAR Parquet_DIR)
+
+# Arrow's headers need C++17, while the rest of PDAL is C++11.  The flag is
+# given only to the plugin's own targets (see plugins/arrow), and only the
+# plugin's sources include Arrow headers; they are otherwise kept to C++11
+# like the rest of the tree.
+include(CheckCXXCompilerFlag)
+if (MSVC)
+    set(ARROW_CXX_FLAGS "/std:c++17")
+else()
+    set(ARROW_CXX_FLAGS "-std=c++17")
+endif()
+check_cxx_compiler_flag(${ARROW_CXX_FLAGS} PDAL_HAVE_CXX17_FLAG)
+
+set(ARROW_PLUGIN_FOUND FALSE)
+if (NOT Arrow_FOUND OR NOT Parquet_FOUND)
+    message(WARNING "Arrow or Parquet not found.  "
+        "The Arrow plugin will not be built.")
+elseif (NOT PDAL_HAVE_CXX17_FLAG)
+    message(WARNING "The compiler doesn't accept ${ARROW_CXX_FLAGS}, "
+        "which Arrow needs.  The Arrow plugin will not be built.")
+else()
+    set(ARROW_PLUGIN_FOUND TRUE)
+endif()
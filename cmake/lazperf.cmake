@@ -1,5 +1,5 @@
 option(WITH_LAZPERF
-    "Choose to use laz-perf compression for database drivers" FALSE)
+    "Choose to use laz-perf compression for database drivers and LAZ" FALSE)
 if (WITH_LAZPERF)
     find_package(Lazperf)
     set_package_properties(Lazperf PROPERTIES TYPE OPTIONAL)
@@ -0,0 +1,16 @@
+#
+# LZ4 support
+#
+option(WITH_LZ4 "Choose to use LZ4 compression for BPF" FALSE)
+if (WITH_LZ4)
+    find_package(LZ4)
+    set_package_properties(LZ4 PROPERTIES TYPE OPTIONAL
+        PURPOSE "Fast compression support in BPF")
+    if (LZ4_FOUND)
+        include_directories(${LZ4_INCLUDE_DIR})
+        set(PDAL_HAVE_LZ4 1)
+    else()
+        set(LZ4_LIBRARY "")
+        set(WITH_LZ4 FALSE)
+    endif()
+endif()
@@ -0,0 +1,41 @@
+###############################################################################
+#
+# CMake module to search for the LZ4 library
+#
+# On success, the macro sets the following variables:
+# LZ4_FOUND       = if the library found
+# LZ4_LIBRARIES   = full path to the library
+# LZ4_INCLUDE_DIR = where to find the library headers also defined,
+#                       but not for general use are
+# LZ4_LIBRARY     = where to find the lz4 library.
+#
+# Redistribution and use is allowed according to the terms of the BSD license.
+# For details see the accompanying COPYING-CMAKE-SCRIPTS file.
+#
+###############################################################################
+
+IF(LZ4_INCLUDE_DIR)
+  # Already in cache, be silent
+  SET(LZ4_FIND_QUIETLY TRUE)
+ENDIF()
+
+FIND_PATH(LZ4_INCLUDE_DIR
+  lz4.h
+  PATHS
+  /usr/include
+  /usr/local/include)
+
+FIND_LIBRARY(LZ4_LIBRARY
+  NAMES lz4
+  PATHS
+  /usr/lib
+  /usr/local/lib)
+
+# Handle the QUIETLY and REQUIRED arguments and set LZ4_FOUND to TRUE
+# if all listed variables are TRUE
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(LZ4 DEFAULT_MSG LZ4_LIBRARY LZ4_INCLUDE_DIR)
+
+IF(LZ4_FOUND)
+  SET(LZ4_LIBRARIES ${LZ4_LIBRARY})
+ENDIF()
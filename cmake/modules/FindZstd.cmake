@@ -0,0 +1,41 @@
+###############################################################################
+#
+# CMake module to search for the Zstd library
+#
+# On success, the macro sets the following variables:
+# ZSTD_FOUND       = if the library found
+# ZSTD_LIBRARIES   = full path to the library
+# ZSTD_INCLUDE_DIR = where to find the library headers also defined,
+#                       but not for general use are
+# ZSTD_LIBRARY     = where to find the zstd library.
+#
+# Redistribution and use is allowed according to the terms of the BSD license.
+# For details see the accompanying COPYING-CMAKE-SCRIPTS file.
+#
+###############################################################################
+
+IF(ZSTD_INCLUDE_DIR)
+  # Already in cache, be silent
+  SET(ZSTD_FIND_QUIETLY TRUE)
+ENDIF()
+
+FIND_PATH(ZSTD_INCLUDE_DIR
+  zstd.h
+  PATHS
+  /usr/include
+  /usr/local/include)
+
+FIND_LIBRARY(ZSTD_LIBRARY
+  NAMES zstd
+  PATHS
+  /usr/lib
+  /usr/local/lib)
+
+# Handle the QUIETLY and REQUIRED arguments and set ZSTD_FOUND to TRUE
+# if all listed variables are TRUE
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(Zstd DEFAULT_MSG ZSTD_LIBRARY ZSTD_INCLUDE_DIR)
+
+IF(ZSTD_FOUND)
+  SET(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+ENDIF()
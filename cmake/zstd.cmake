@@ -0,0 +1,16 @@
+#
+# Zstd support
+#
+option(WITH_ZSTD "Choose to use Zstd compression for BPF" FALSE)
+if (WITH_ZSTD)
+    find_package(Zstd)
+    set_package_properties(Zstd PROPERTIES TYPE OPTIONAL
+        PURPOSE "Fast compression support in BPF")
+    if (ZSTD_FOUND)
+        include_directories(${ZSTD_INCLUDE_DIR})
+        set(PDAL_HAVE_ZSTD 1)
+    else()
+        set(ZSTD_LIBRARY "")
+        set(WITH_ZSTD FALSE)
+    endif()
+endif()
@@ -33,6 +33,12 @@
 
 #include "ChipperFilter.hpp"
 
+#include <pdal/RadixSort.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <mortonorder/MortonOrderFilter.hpp>
+
+#include <cmath>
+#include <future>
 #include <iostream>
 #include <limits>
 
@@ -81,6 +87,14 @@ std::string ChipperFilter::getName() const { return s_info.name; }
 void ChipperFilter::processOptions(const Options& options)
 {
     m_threshold = options.getValueOrDefault<uint32_t>("capacity", 5000u);
+    m_stream = options.getValueOrDefault<bool>("stream", false);
+    m_cellSize = options.getValueOrDefault<double>("cell_size", 0);
+    if (m_threshold == 0)
+        throw pdal_error(getName() + ": option 'capacity' must be greater "
+            "than 0.");
+    if (m_cellSize < 0)
+        throw pdal_error(getName() + ": option 'cell_size' can't be "
+            "negative.");
 }
 
 
@@ -89,62 +103,243 @@ Options ChipperFilter::getDefaultOptions()
     Options options;
     Option capacity("capacity", 5000u, "Tile capacity");
     options.add(capacity);
+    options.add("stream", false, "Gather chips from the cells of a grid "
+        "so that points can be streamed");
+    options.add("cell_size", 0, "Width of the grid cells when streaming.  "
+        "Estimated from the first points if 0");
     return options;
 }
 
 
-PointViewSet ChipperFilter::run(PointViewPtr view)
+void ChipperFilter::prepared(PointTableRef table)
 {
-    if (view->size() == 0)
-        return m_outViews;
+    // Chips are handed on in the chunks they're gathered from, so they
+    // can't be bigger than one.
+    FixedPointTable *fixed = dynamic_cast<FixedPointTable *>(&table);
+    if (m_stream && fixed && m_threshold > fixed->capacity())
+    {
+        std::ostringstream oss;
+        oss << getName() << ": option 'capacity' can't be greater than the "
+            "number of points streamed at a time (" << fixed->capacity() <<
+            ").";
+        throw pdal_error(oss.str());
+    }
+}
 
-    m_inView = view;
-    load(*view.get(), m_xvec, m_yvec, m_spare);
-    partition(m_xvec.size());
-    decideSplit(m_xvec, m_yvec, m_spare, 0, m_partitions.size() - 1);
-    return m_outViews;
+
+void ChipperFilter::ready(PointTableRef table)
+{
+    m_cells.clear();
+    m_full.clear();
+    m_gridSize = m_cellSize;
+    m_dims = table.layout()->dimTypes();
+    m_packedSize = 0;
+    for (auto& d : m_dims)
+        m_packedSize += Dimension::size(d.m_type);
 }
 
 
-void ChipperFilter::load(PointView& view, ChipRefList& xvec, ChipRefList& yvec,
-    ChipRefList& spare)
+// Morton key of the grid cell holding a position.  Cells are counted from
+// the origin, offset so that positions to its left or below still have
+// positive cell numbers.
+uint64_t ChipperFilter::cellKey(double x, double y) const
 {
-    point_count_t idx;
-    std::vector<ChipPtRef>::iterator it;
+    const double offset = 2147483648.0;
+    const double limit = 4294967295.0;
+    double cx = std::floor((x - m_originX) / m_gridSize) + offset;
+    double cy = std::floor((y - m_originY) / m_gridSize) + offset;
+    cx = (std::min)((std::max)(cx, 0.0), limit);
+    cy = (std::min)((std::max)(cy, 0.0), limit);
+    return MortonOrderFilter::mortonKey((uint32_t)cx, (uint32_t)cy);
+}
 
-    xvec.reserve(view.size());
-    yvec.reserve(view.size());
-    spare.resize(view.size());
 
-    for (PointId i = 0; i < view.size(); ++i)
-    {
-        ChipPtRef xref;
+// Copy the points of a chunk into the chips of their cells, then put the
+// chips that are full back into the chunk's points, as many as fit, and
+// hand them on.
+PointViewSet ChipperFilter::runStream(PointViewPtr view)
+{
+    m_outViews.clear();
+    const point_count_t count = view->size();
+    if (count == 0)
+        return m_outViews;
 
-        xref.m_pos = view.getFieldAs<double>(Dimension::Id::X, i);
-        xref.m_ptindex = i;
-        xvec.push_back(xref);
+    std::vector<double> xs(count);
+    std::vector<double> ys(count);
+    view->getFieldArray(Dimension::Id::X, 0, count, xs.data());
+    view->getFieldArray(Dimension::Id::Y, 0, count, ys.data());
 
-        ChipPtRef yref;
+    // Without a cell size, pick one that would put 'capacity' points in a
+    // cell if the points spread like those of the first chunk.
+    if (m_gridSize <= 0)
+    {
+        BOX3D bounds;
+        for (point_count_t i = 0; i < count; ++i)
+            bounds.grow(xs[i], ys[i]);
+        double area =
+            (bounds.maxx - bounds.minx) * (bounds.maxy - bounds.miny);
+        m_gridSize = std::sqrt(area * m_threshold / count);
+        if (!(m_gridSize > 0) || !std::isfinite(m_gridSize))
+            m_gridSize = (std::max)(bounds.maxx - bounds.minx,
+                bounds.maxy - bounds.miny);
+        if (!(m_gridSize > 0) || !std::isfinite(m_gridSize))
+            m_gridSize = 1;
+        m_originX = bounds.minx;
+        m_originY = bounds.miny;
+        log()->get(LogLevel::Debug) << getName() << ": streaming with "
+            "cells " << m_gridSize << " wide." << std::endl;
+    }
 
-        yref.m_pos = view.getFieldAs<double>(Dimension::Id::Y, i);
-        yref.m_ptindex = i;
-        yvec.push_back(yref);
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        uint64_t key = cellKey(xs[i], ys[i]);
+        Chip& chip = m_cells[key];
+        if (chip.m_points.empty())
+            chip.m_points.reserve(m_threshold * m_packedSize);
+        chip.m_points.resize((chip.m_count + 1) * m_packedSize);
+        view->getPackedPoint(m_dims, i,
+            chip.m_points.data() + chip.m_count * m_packedSize);
+        if (++chip.m_count == m_threshold)
+        {
+            m_full.push_back(std::move(chip));
+            m_cells.erase(key);
+        }
     }
 
-    // Sort xvec and assign other index in yvec to sorted indices in xvec.
-    std::stable_sort(xvec.begin(), xvec.end());
-    for (size_t i = 0; i < xvec.size(); ++i)
+    // The chunk's points have all been copied, so their storage is free
+    // for the chips.
+    PointId next = 0;
+    while (m_full.size() && next + m_full.front().m_count <= count)
     {
-        idx = xvec[i].m_ptindex;
-        yvec[idx].m_oindex = i;
+        Chip& chip = m_full.front();
+        PointViewPtr out = view->makeNew();
+        for (point_count_t i = 0; i < chip.m_count; ++i, ++next)
+        {
+            view->setPackedPoint(m_dims, next,
+                chip.m_points.data() + i * m_packedSize);
+            out->appendPoint(*view, next);
+        }
+        m_outViews.insert(out);
+        m_full.pop_front();
     }
+    return m_outViews;
+}
+
 
-    // Sort yvec.
-    std::stable_sort(yvec.begin(), yvec.end());
+// Hand on the chips that are left once all points have been streamed, full
+// ones first and then the rest in Morton order of their cells.
+PointViewSet ChipperFilter::flush(PointViewPtr view, point_count_t count)
+{
+    for (auto& c : m_cells)
+        m_full.push_back(std::move(c.second));
+    m_cells.clear();
 
-    // Iterate through the yvector, setting the xvector appropriately.
-    for (size_t i = 0; i < yvec.size(); ++i)
-        xvec[yvec[i].m_oindex].m_oindex = i;
+    PointViewSet viewSet;
+    point_count_t total = 0;
+    while (m_full.size() && total + m_full.front().m_count <= count)
+    {
+        Chip& chip = m_full.front();
+        PointViewPtr out = view->makeNew();
+        for (point_count_t i = 0; i < chip.m_count; ++i)
+            out->setPackedPoint(m_dims, i,
+                chip.m_points.data() + i * m_packedSize);
+        total += chip.m_count;
+        viewSet.insert(out);
+        m_full.pop_front();
+    }
+    return viewSet;
+}
+
+
+PointViewSet ChipperFilter::run(PointViewPtr view)
+{
+    if (m_stream)
+        return runStream(view);
+
+    m_outViews.clear();
+    m_partitions.clear();
+    if (view->size() == 0)
+        return m_outViews;
+
+    load(*view.get(), m_xvec, m_yvec, m_spare);
+    partition(m_xvec.size());
+    m_order.resize(view->size());
+    decideSplit(m_xvec, m_yvec, m_spare, 0, m_partitions.size() - 1);
+
+    // Chips are laid out one after another in a single view and each is
+    // handed out as a subset, so the output views share one index.  Each
+    // chip is a partition.
+    PointViewPtr chipView = view->makeSubset(0, view->size());
+    chipView->applyPermutation(m_order);
+    for (size_t p = 0; p + 1 < m_partitions.size(); ++p)
+        m_outViews.insert(chipView->makeSubset(m_partitions[p],
+            m_partitions[p + 1]));
+    return m_outViews;
+}
+
+
+void ChipperFilter::load(PointView& view, ChipRefList& xvec, ChipRefList& yvec,
+    ChipRefList& spare)
+{
+    // The positions are copied out on this thread, so the work handed to
+    // the pool below never touches the point table and doesn't need it
+    // to be threadSafe().
+    const point_count_t count = view.size();
+    memory::Vector<double, memory::Temporary> xs(count);
+    memory::Vector<double, memory::Temporary> ys(count);
+    view.getFieldArray(Dimension::Id::X, 0, count, xs.data());
+    view.getFieldArray(Dimension::Id::Y, 0, count, ys.data());
+
+    xvec.resize(count);
+    yvec.resize(count);
+    spare.resize(count);
+
+    // Sort each direction.  The radix sort is stable, so points at the
+    // same position stay in point order.
+    auto sortDir = [count](const memory::Vector<double, memory::Temporary>& pos,
+        ChipRefList& vec)
+    {
+        std::vector<RadixPair> pairs(count);
+        ThreadPool::shared().parallelFor(count, 65536,
+            [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+                pairs[i] = std::make_pair(radixKey(pos[i]), (PointId)i);
+        });
+        radixSort(pairs);
+        ThreadPool::shared().parallelFor(count, 65536,
+            [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                vec[i].m_ptindex = pairs[i].second;
+                vec[i].m_pos = pos[pairs[i].second];
+            }
+        });
+    };
+    sortDir(xs, xvec);
+    sortDir(ys, yvec);
+
+    // Link each entry to the entry of the same point in the other
+    // direction.  Each point appears once in each list, so the writes
+    // don't collide.
+    memory::Vector<uint32_t, memory::Temporary> yindex(count);
+    ThreadPool::shared().parallelFor(count, 65536,
+        [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+            yindex[yvec[i].m_ptindex] = (uint32_t)i;
+    });
+    ThreadPool::shared().parallelFor(count, 65536,
+        [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            uint32_t y = yindex[xvec[i].m_ptindex];
+            xvec[i].m_oindex = y;
+            yvec[y].m_oindex = (uint32_t)i;
+        }
+    });
 }
 
 
@@ -239,13 +434,29 @@ void ChipperFilter::split(ChipRefList& wide, ChipRefList& narrow, ChipRefList& s
             }
         }
 
-        // Save away the direction so we know which array is X and which is Y
-        // so that when we emit, we can properly label the max/min points.
-        Direction dir = narrow.m_dir;
-        spare.m_dir = dir;
-        decideSplit(wide, spare, narrow, pleft, pcenter);
-        decideSplit(wide, spare, narrow, pcenter, pright);
-        narrow.m_dir = dir;
+        // The two halves touch separate ranges of the arrays, so they can
+        // be split at once.  Small blocks aren't worth a task.
+        if (right - left > 65536)
+        {
+            std::future<void> leftDone = ThreadPool::shared().submit(
+                [this, &wide, &spare, &narrow, pleft, pcenter]()
+                { decideSplit(wide, spare, narrow, pleft, pcenter); });
+            try
+            {
+                decideSplit(wide, spare, narrow, pcenter, pright);
+            }
+            catch (...)
+            {
+                ThreadPool::shared().wait(leftDone);
+                throw;
+            }
+            ThreadPool::shared().wait(leftDone);
+        }
+        else
+        {
+            decideSplit(wide, spare, narrow, pleft, pcenter);
+            decideSplit(wide, spare, narrow, pcenter, pright);
+        }
     }
 }
 
@@ -314,14 +525,12 @@ void ChipperFilter::finalSplit(ChipRefList& wide, ChipRefList& narrow,
          right);
 }
 
+// Place the chip's points in the output order.  The positions in the
+// sorted arrays are the positions in the output.
 void ChipperFilter::emit(ChipRefList& wide, PointId widemin, PointId widemax)
 {
-    PointViewPtr view = m_inView->makeNew();
     for (size_t idx = widemin; idx <= widemax; ++idx)
-        view->appendPoint(*m_inView.get(), wide[idx].m_ptindex);
-
-    m_outViews.insert(view);
+        m_order[idx] = wide[idx].m_ptindex;
 }
 
 } // namespace pdal
-
@@ -42,8 +42,11 @@
 #pragma once
 
 #include <pdal/Filter.hpp>
+#include <pdal/MemoryAccount.hpp>
 #include <pdal/PointView.hpp>
 
+#include <deque>
+#include <map>
 #include <vector>
 
 extern "C" int32_t ChipperFilter_ExitFunc();
@@ -88,20 +91,22 @@ class PDAL_DLL ChipRefList
     friend class ChipperFilter;
 
 private:
-    std::vector<ChipPtRef> m_vec;
+    typedef memory::Vector<ChipPtRef, memory::Temporary> Refs;
+
+    Refs m_vec;
     Direction m_dir;
 
     ChipRefList(Direction dir = DIR_NONE) : m_dir(dir)
     {}
-    std::vector<ChipPtRef>::size_type size() const
+    Refs::size_type size() const
     {
         return m_vec.size();
     }
-    void reserve(std::vector<ChipPtRef>::size_type n)
+    void reserve(Refs::size_type n)
     {
         m_vec.reserve(n);
     }
-    void resize(std::vector<ChipPtRef>::size_type n)
+    void resize(Refs::size_type n)
     {
         m_vec.resize(n);
     }
@@ -109,11 +114,11 @@ private:
     {
         m_vec.push_back(ref);
     }
-    std::vector<ChipPtRef>::iterator begin()
+    Refs::iterator begin()
     {
         return m_vec.begin();
     }
-    std::vector<ChipPtRef>::iterator end()
+    Refs::iterator end()
     {
         return m_vec.end();
     }
@@ -137,7 +142,8 @@ class PDAL_DLL ChipperFilter : public pdal::Filter
 {
 public:
     ChipperFilter() : Filter(),
-        m_xvec(DIR_X), m_yvec(DIR_Y), m_spare(DIR_NONE)
+        m_xvec(DIR_X), m_yvec(DIR_Y), m_spare(DIR_NONE), m_stream(false),
+        m_cellSize(0), m_gridSize(0), m_originX(0), m_originY(0)
     {}
 
     static void * create();
@@ -146,9 +152,32 @@ public:
 
     Options getDefaultOptions();
 
+    // In streaming mode points are gathered into the cells of a grid and
+    // each cell is handed on as a chip once it holds 'capacity' points.
+    // Chips are only approximately square and the last of them, handed on
+    // once the input is done, hold fewer points.
+    virtual bool streamable() const
+        { return m_stream; }
+
 private:
+    // The points, packed, of a chip being gathered or waiting to be handed
+    // on.
+    struct Chip
+    {
+        Chip() : m_count(0)
+            {}
+
+        std::vector<char> m_points;
+        point_count_t m_count;
+    };
+
     virtual void processOptions(const Options& options);
+    virtual void prepared(PointTableRef table);
+    virtual void ready(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
+    virtual PointViewSet flush(PointViewPtr view, point_count_t count);
+    PointViewSet runStream(PointViewPtr view);
+    uint64_t cellKey(double x, double y) const;
 
     void load(PointView& view, ChipRefList& xvec,
         ChipRefList& yvec, ChipRefList& spare);
@@ -162,13 +191,27 @@ private:
     void emit(ChipRefList& wide, PointId widemin, PointId widemax);
 
     PointId m_threshold;
-    PointViewPtr m_inView;
     PointViewSet m_outViews;
+    // Point IDs in chip order.
+    std::vector<PointId> m_order;
     std::vector<PointId> m_partitions;
     ChipRefList m_xvec;
     ChipRefList m_yvec;
     ChipRefList m_spare;
 
+    bool m_stream;
+    double m_cellSize;
+    // Cell size in use when streaming, from 'cell_size' or the first chunk.
+    double m_gridSize;
+    double m_originX;
+    double m_originY;
+    DimTypeList m_dims;
+    size_t m_packedSize;
+    // Chips being gathered, by the Morton key of their cell.
+    std::map<uint64_t, Chip> m_cells;
+    // Chips that are full, in the order they filled.
+    std::deque<Chip> m_full;
+
     ChipperFilter& operator=(const ChipperFilter&); // not implemented
     ChipperFilter(const ChipperFilter&); // not implemented
 };
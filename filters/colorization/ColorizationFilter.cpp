@@ -40,7 +40,12 @@
 #include <gdal.h>
 #include <ogr_spatialref.h>
 
-#include <array>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <vector>
 
 namespace pdal
 {
@@ -54,15 +59,111 @@ CREATE_STATIC_PLUGIN(1, 0, ColorizationFilter, Filter, s_info)
 
 std::string ColorizationFilter::getName() const { return s_info.name; }
 
-struct GDALSourceDeleter
+namespace
 {
-    template <typename T>
-    void operator()(T* ptr)
+
+// Values of a raster band, read in tiles of whole blocks and kept in
+// memory.  When the cache is full the least recently used tile is
+// replaced.
+class BandCache
+{
+public:
+    BandCache(GDALRasterBandH band, int width, int height, size_t capacity) :
+        m_band(band), m_width(width), m_height(height),
+        m_capacity((std::max)(capacity, (size_t)1))
+    {
+        int blockWidth(0);
+        int blockHeight(0);
+        GDALGetBlockSize(band, &blockWidth, &blockHeight);
+
+        // Strips and small blocks are read as tiles of at least 64K
+        // pixels.
+        m_tileWidth = (std::min)((std::max)(blockWidth, 1), 1024);
+        m_tileHeight = (std::max)(blockHeight, 65536 / m_tileWidth);
+        m_tilesX = (uint64_t)(width + m_tileWidth - 1) / m_tileWidth;
+    }
+
+    uint64_t tileKey(int32_t pixel, int32_t line) const
+    {
+        return (line / m_tileHeight) * m_tilesX + (pixel / m_tileWidth);
+    }
+
+    // Fetch the value at a pixel and line.  Returns false if the raster
+    // couldn't be read there.
+    bool value(int32_t pixel, int32_t line, double& v)
+    {
+        const Tile& t = tile(tileKey(pixel, line));
+        if (!t.m_valid)
+            return false;
+        v = t.m_data[(line - t.m_line) * t.m_width + (pixel - t.m_pixel)];
+        return true;
+    }
+
+private:
+    struct Tile
+    {
+        uint64_t m_key;
+        int32_t m_pixel;
+        int32_t m_line;
+        int32_t m_width;
+        bool m_valid;
+        std::vector<double> m_data;
+    };
+    typedef std::list<Tile> TileList;
+
+    const Tile& tile(uint64_t key)
+    {
+        if (m_tiles.size() && m_tiles.front().m_key == key)
+            return m_tiles.front();
+
+        auto ti = m_index.find(key);
+        if (ti != m_index.end())
+        {
+            m_tiles.splice(m_tiles.begin(), m_tiles, ti->second);
+            return m_tiles.front();
+        }
+
+        // Reuse the least recently used tile if the cache is full.
+        if (m_tiles.size() < m_capacity)
+            m_tiles.emplace_front();
+        else
+        {
+            m_tiles.splice(m_tiles.begin(), m_tiles,
+                std::prev(m_tiles.end()));
+            m_index.erase(m_tiles.front().m_key);
+        }
+        Tile& t = m_tiles.front();
+        load(key, t);
+        m_index[key] = m_tiles.begin();
+        return t;
+    }
+
+    void load(uint64_t key, Tile& t)
     {
-        ::GDALClose(ptr);
+        t.m_key = key;
+        t.m_pixel = (int32_t)(key % m_tilesX) * m_tileWidth;
+        t.m_line = (int32_t)(key / m_tilesX) * m_tileHeight;
+        t.m_width = (std::min)(m_tileWidth, m_width - t.m_pixel);
+        int32_t height = (std::min)(m_tileHeight, m_height - t.m_line);
+        t.m_data.resize((size_t)t.m_width * height);
+        t.m_valid = (GDALRasterIO(m_band, GF_Read, t.m_pixel, t.m_line,
+            t.m_width, height, t.m_data.data(), t.m_width, height,
+            GDT_Float64, 0, 0) == CE_None);
     }
+
+    GDALRasterBandH m_band;
+    int32_t m_width;
+    int32_t m_height;
+    size_t m_capacity;
+    int32_t m_tileWidth;
+    int32_t m_tileHeight;
+    uint64_t m_tilesX;
+    TileList m_tiles;
+    std::unordered_map<uint64_t, TileList::iterator> m_index;
 };
 
+} // unnamed namespace
+
 
 void ColorizationFilter::initialize()
 {
@@ -113,7 +214,15 @@ Options ColorizationFilter::getDefaultOptions()
 
 void ColorizationFilter::processOptions(const Options& options)
 {
-    m_rasterFilename = options.getValueOrThrow<std::string>("raster");
+    std::vector<Option> rasters = options.getOptions("raster");
+    if (rasters.empty())
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'raster' must be specified.";
+        throw pdal_error(oss.str());
+    }
+    for (const Option& r : rasters)
+        m_rasters.emplace_back(r.getValue<std::string>());
     std::vector<Option> dimensions = options.getOptions("dimension");
 
     if (dimensions.size() == 0)
@@ -141,26 +250,65 @@ void ColorizationFilter::processOptions(const Options& options)
             dimensionOptions->getValueOrDefault<double>("scale", 1.0);
         m_bands.emplace_back(name, Dimension::Id::Unknown, bandId, scale);
     }
+    m_cacheBlocks = options.getValueOrDefault<size_t>("cache_blocks", 16);
+    m_sortByBlock = options.getValueOrDefault<bool>("sort_by_block", false);
+
+    std::string interpolation =
+        options.getValueOrDefault<std::string>("interpolation", "nearest");
+    if (interpolation == "bilinear")
+        m_bilinear = true;
+    else if (interpolation != "nearest")
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Invalid 'interpolation' value '" <<
+            interpolation << "'.  Must be 'nearest' or 'bilinear'.";
+        throw pdal_error(oss.str());
+    }
 }
 
 
 void ColorizationFilter::ready(PointTableRef table)
 {
-    m_forward_transform.assign(0.0);
-    m_inverse_transform.assign(0.0);
-
-    log()->get(LogLevel::Debug) << "Using " << m_rasterFilename <<
-        " for raster" << std::endl;
-    m_ds = GDALOpen(m_rasterFilename.c_str(), GA_ReadOnly);
-    if (m_ds == NULL)
-        throw pdal_error("Unable to open GDAL datasource!");
-
-    if (GDALGetGeoTransform(m_ds, &(m_forward_transform.front())) != CE_None)
-        throw pdal_error("unable to fetch forward geotransform for raster!");
-
-    if (!GDALInvGeoTransform(&(m_forward_transform.front()),
-        &(m_inverse_transform.front())))
-        throw pdal_error("unable to fetch inverse geotransform for raster!");
+    // Only the georeferencing of the rasters is read here.  The handle
+    // opened to read it goes back to the raster's pool for colorizing.
+    m_bounds.clear();
+    m_pools.clear();
+    for (Raster& r : m_rasters)
+    {
+        log()->get(LogLevel::Debug) << "Using " << r.m_filename <<
+            " for raster" << std::endl;
+        m_pools.emplace_back(new gdal::DatasetPool(r.m_filename));
+        gdal::DatasetPool::Dataset ds = m_pools.back()->acquire();
+
+        r.m_forward_transform.assign(0.0);
+        r.m_inverse_transform.assign(0.0);
+        if (GDALGetGeoTransform(ds.get(), &(r.m_forward_transform.front())) !=
+            CE_None)
+            throw pdal_error("unable to fetch forward geotransform for "
+                "raster!");
+
+        if (!GDALInvGeoTransform(&(r.m_forward_transform.front()),
+            &(r.m_inverse_transform.front())))
+            throw pdal_error("unable to fetch inverse geotransform for "
+                "raster!");
+
+        r.m_width = GDALGetRasterXSize(ds.get());
+        r.m_height = GDALGetRasterYSize(ds.get());
+        if (!r.m_width || !r.m_height)
+            throw pdal_error("Unable to get X or Y size from raster!");
+
+        const boost::array<double, 6>& f = r.m_forward_transform;
+        r.m_bounds.clear();
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            double pixel = (corner & 1) ? r.m_width : 0;
+            double line = (corner & 2) ? r.m_height : 0;
+            r.m_bounds.grow(f[0] + f[1] * pixel + f[2] * line,
+                f[3] + f[4] * pixel + f[5] * line);
+        }
+        m_bounds.grow(r.m_bounds);
+    }
+    buildRasterIndex();
 
     for (auto bi = m_bands.begin(); bi != m_bands.end(); ++bi)
     {
@@ -173,73 +321,206 @@ void ColorizationFilter::ready(PointTableRef table)
 }
 
 
-void ColorizationFilter::filter(PointView& view)
+void ColorizationFilter::done(PointTableRef /*table*/)
 {
-    int32_t pixel(0);
-    int32_t line(0);
+    m_pools.clear();
+}
+
 
-    std::array<double, 2> pix = { {0.0, 0.0} };
-    for (PointId idx = 0; idx < view.size(); ++idx)
+void ColorizationFilter::buildRasterIndex()
+{
+    const size_t MaxCells = 4096;
+
+    const double width = m_bounds.maxx - m_bounds.minx;
+    const double height = m_bounds.maxy - m_bounds.miny;
+    double cellSize = std::sqrt(width * height / m_rasters.size());
+    if (!(cellSize > 0))
+        cellSize = 1;
+
+    m_cellsX = (std::min)(MaxCells,
+        (std::max)((size_t)1, (size_t)std::ceil(width / cellSize)));
+    m_cellsY = (std::min)(MaxCells,
+        (std::max)((size_t)1, (size_t)std::ceil(height / cellSize)));
+    m_cellWidth = width > 0 ? width / m_cellsX : 1;
+    m_cellHeight = height > 0 ? height / m_cellsY : 1;
+    m_cells.assign(m_cellsX * m_cellsY, std::vector<uint32_t>());
+
+    auto cellX = [this](double x)
+    {
+        return (std::min)((size_t)((x - m_bounds.minx) / m_cellWidth),
+            m_cellsX - 1);
+    };
+    auto cellY = [this](double y)
     {
-        double x = view.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = view.getFieldAs<double>(Dimension::Id::Y, idx);
+        return (std::min)((size_t)((y - m_bounds.miny) / m_cellHeight),
+            m_cellsY - 1);
+    };
+    for (size_t i = 0; i < m_rasters.size(); ++i)
+    {
+        const BOX3D& b = m_rasters[i].m_bounds;
+        for (size_t y = cellY(b.miny); y <= cellY(b.maxy); ++y)
+            for (size_t x = cellX(b.minx); x <= cellX(b.maxx); ++x)
+                m_cells[y * m_cellsX + x].push_back((uint32_t)i);
+    }
+}
 
-        if (!getPixelAndLinePosition(x, y, m_inverse_transform, pixel,
-                line, m_ds))
-            continue;
 
-        for (auto bi = m_bands.begin(); bi != m_bands.end(); ++bi)
-        {
-            BandInfo& b = *bi;
-            GDALRasterBandH hBand = GDALGetRasterBand(m_ds, b.m_band);
-            if (hBand == NULL)
-            {
-                std::ostringstream oss;
-                oss << "Unable to get band " << b.m_band <<
-                    " from data source!";
-                throw pdal_error(oss.str());
-            }
-            if (GDALRasterIO(hBand, GF_Read, pixel, line, 1, 1,
-                &pix[0], 1, 1, GDT_CFloat64, 0, 0) == CE_None)
-                view.setField(b.m_dim, idx, pix[0] * b.m_scale);
-        }
+// Find the first raster, in the order given, that covers a point.  Returns
+// the index of the raster, or -1 if no raster covers the point.  No
+// reprojection is done at this time.
+int ColorizationFilter::findRaster(double x, double y, double& pixel,
+    double& line) const
+{
+    if (x < m_bounds.minx || x > m_bounds.maxx ||
+        y < m_bounds.miny || y > m_bounds.maxy)
+        return -1;
+
+    size_t cx = (std::min)((size_t)((x - m_bounds.minx) / m_cellWidth),
+        m_cellsX - 1);
+    size_t cy = (std::min)((size_t)((y - m_bounds.miny) / m_cellHeight),
+        m_cellsY - 1);
+    for (uint32_t i : m_cells[cy * m_cellsX + cx])
+    {
+        const Raster& r = m_rasters[i];
+        const boost::array<double, 6>& inverse = r.m_inverse_transform;
+        pixel = inverse[0] + (inverse[1] * x) + (inverse[2] * y);
+        line = inverse[3] + (inverse[4] * x) + (inverse[5] * y);
+        if (pixel >= 0 && line >= 0 && pixel < r.m_width &&
+            line < r.m_height)
+            return (int)i;
     }
+    return -1;
 }
 
 
-// Determines the pixel/line position given an x/y.
-// No reprojection is done at this time.
-bool ColorizationFilter::getPixelAndLinePosition(double x, double y,
-    boost::array<double, 6> const& inverse, int32_t& pixel,
-    int32_t& line, void *ds)
+void ColorizationFilter::filter(PointView& view)
 {
-    pixel = (int32_t)std::floor(inverse[0] + (inverse[1] * x) +
-        (inverse[2] * y));
-    line = (int32_t) std::floor(inverse[3] + (inverse[4] * x) +
-        (inverse[5] * y));
+    auto colorize = [this, &view](PointId first, PointId last)
+    {
+        colorizeRange(view, first, last);
+    };
+    parallelFilter(view, colorize);
+}
 
-    int xs = GDALGetRasterXSize(ds);
-    int ys = GDALGetRasterYSize(ds);
 
-    if (!xs || !ys)
-        throw pdal_error("Unable to get X or Y size from raster!");
+void ColorizationFilter::colorizeRange(PointView& view, PointId first,
+    PointId last)
+{
+    // GDAL dataset handles can't be shared between threads, so each range
+    // takes the handles it needs from the pools for as long as it runs.
+    // Errors go to this thread's capture rather than the global handler,
+    // which throws from inside GDAL.  A tile that can't be read leaves its
+    // points uncolored.
+    gdal::ErrorCapture errors;
+    struct Source
+    {
+        gdal::DatasetPool::Dataset m_ds;
+        std::vector<BandCache> m_caches;
+    };
+    std::vector<Source> sources(m_rasters.size());
 
-    if (pixel < 0 || line < 0 || pixel >= xs || line  >= ys)
+    auto source = [this, &sources](int r) -> Source&
     {
-        // The x, y is not coincident with this raster
-        return false;
-    }
+        Source& src = sources[r];
+        if (src.m_ds)
+            return src;
 
-    return true;
-}
+        src.m_ds = m_pools[r]->acquire();
+        src.m_caches.reserve(m_bands.size());
+        for (auto bi = m_bands.begin(); bi != m_bands.end(); ++bi)
+        {
+            GDALRasterBandH hBand =
+                GDALGetRasterBand(src.m_ds.get(), bi->m_band);
+            if (hBand == NULL)
+            {
+                std::ostringstream oss;
+                oss << "Unable to get band " << bi->m_band <<
+                    " from data source '" << m_rasters[r].m_filename << "'!";
+                throw pdal_error(oss.str());
+            }
+            src.m_caches.emplace_back(hBand, m_rasters[r].m_width,
+                m_rasters[r].m_height, m_cacheBlocks);
+        }
+        return src;
+    };
+
+    const point_count_t batchSize = 65536;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    std::vector<int> rasters(batchSize);
+    std::vector<double> pixels(batchSize);
+    std::vector<double> lines(batchSize);
+    // Raster, block and batch index of each point that's on a raster,
+    // combined so that a sort orders the points by raster and block.
+    std::vector<std::pair<uint64_t, PointId>> order;
+    order.reserve(batchSize);
+
+    for (PointId begin = first; begin < last; begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, last - begin);
+        view.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+        view.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
 
+        order.clear();
+        for (PointId i = 0; i < count; ++i)
+        {
+            rasters[i] = findRaster(xs[i], ys[i], pixels[i], lines[i]);
+            if (rasters[i] < 0)
+                continue;
+            uint64_t key = 0;
+            if (m_sortByBlock)
+            {
+                Source& src = source(rasters[i]);
+                if (src.m_caches.size())
+                    key = src.m_caches[0].tileKey((int32_t)pixels[i],
+                        (int32_t)lines[i]);
+                key |= (uint64_t)rasters[i] << 40;
+            }
+            order.push_back(std::make_pair(key, i));
+        }
+        if (m_sortByBlock)
+            std::sort(order.begin(), order.end());
 
-void ColorizationFilter::done(PointTableRef /*table*/)
-{
-    if (m_ds != 0)
-    {
-        GDALClose(m_ds);
-        m_ds = 0;
+        for (auto& o : order)
+        {
+            PointId i = o.second;
+            const Raster& r = m_rasters[rasters[i]];
+            Source& src = source(rasters[i]);
+            for (size_t b = 0; b < m_bands.size(); ++b)
+            {
+                BandCache& cache = src.m_caches[b];
+                double v;
+                if (m_bilinear)
+                {
+                    // Interpolate between the centers of the four
+                    // surrounding pixels.  Pixels off the edge of the
+                    // raster are replaced by the nearest edge pixel.
+                    double fp = pixels[i] - 0.5;
+                    double fl = lines[i] - 0.5;
+                    double p0 = std::floor(fp);
+                    double l0 = std::floor(fl);
+                    double dx = fp - p0;
+                    double dy = fl - l0;
+                    int32_t px0 = (std::max)((int32_t)p0, 0);
+                    int32_t ln0 = (std::max)((int32_t)l0, 0);
+                    int32_t px1 = (std::min)((int32_t)p0 + 1, r.m_width - 1);
+                    int32_t ln1 = (std::min)((int32_t)l0 + 1, r.m_height - 1);
+                    double v00, v10, v01, v11;
+                    if (!cache.value(px0, ln0, v00) ||
+                        !cache.value(px1, ln0, v10) ||
+                        !cache.value(px0, ln1, v01) ||
+                        !cache.value(px1, ln1, v11))
+                        continue;
+                    v = (1 - dy) * ((1 - dx) * v00 + dx * v10) +
+                        dy * ((1 - dx) * v01 + dx * v11);
+                }
+                else if (!cache.value((int32_t)pixels[i], (int32_t)lines[i],
+                    v))
+                    continue;
+                view.setField(m_bands[b].m_dim, begin + i,
+                    v * m_bands[b].m_scale);
+            }
+        }
     }
 }
 
@@ -43,6 +43,7 @@
 #include <pdal/GDALUtils.hpp>
 
 #include <map>
+#include <memory>
 
 extern "C" int32_t ColorizationFilter_ExitFunc();
 extern "C" PF_ExitFunc ColorizationFilter_InitPlugin();
@@ -71,13 +72,31 @@ struct BandInfo
     double m_scale;
 };
 
+struct Raster
+{
+    Raster(const std::string& filename) : m_filename(filename), m_width(0),
+        m_height(0)
+    {}
+
+    std::string m_filename;
+    boost::array<double, 6> m_forward_transform;
+    boost::array<double, 6> m_inverse_transform;
+    int m_width;
+    int m_height;
+    BOX3D m_bounds;
+};
+
 public:
-    ColorizationFilter()
+    ColorizationFilter() : m_cacheBlocks(16), m_sortByBlock(false),
+        m_bilinear(false), m_cellsX(0), m_cellsY(0), m_cellWidth(1),
+        m_cellHeight(1)
     {}
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
 
     Options getDefaultOptions();
 
@@ -88,17 +107,29 @@ private:
     virtual void filter(PointView& view);
     virtual void done(PointTableRef table);
 
-    bool getPixelAndLinePosition(double x, double y,
-        boost::array<double, 6> const& inverse, int32_t& pixel,
-        int32_t& line, void *ds);
+    void colorizeRange(PointView& view, PointId first, PointId last);
+    void buildRasterIndex();
+    int findRaster(double x, double y, double& pixel, double& line) const;
 
-    std::string m_rasterFilename;
+    std::vector<Raster> m_rasters;
+    // Open handles to each raster, shared by the colorizing threads.
+    std::vector<std::unique_ptr<gdal::DatasetPool>> m_pools;
     std::vector<BandInfo> m_bands;
-
-    boost::array<double, 6> m_forward_transform;
-    boost::array<double, 6> m_inverse_transform;
-
-    GDALDatasetH m_ds;
+    // Number of raster blocks cached per band by each thread.
+    size_t m_cacheBlocks;
+    // Visit the points of each batch in raster block order.
+    bool m_sortByBlock;
+    // Interpolate between the four nearest pixels.
+    bool m_bilinear;
+
+    // A grid over the extent of the rasters.  Each cell lists the rasters
+    // that overlap it.
+    BOX3D m_bounds;
+    std::vector<std::vector<uint32_t>> m_cells;
+    size_t m_cellsX;
+    size_t m_cellsY;
+    double m_cellWidth;
+    double m_cellHeight;
 
     ColorizationFilter& operator=(const ColorizationFilter&); // not implemented
     ColorizationFilter(const ColorizationFilter&); // not implemented
@@ -34,11 +34,15 @@
 
 #include "CropFilter.hpp"
 
+#include <pdal/GEOSUtils.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/Reader.hpp>
 #include <pdal/StageFactory.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <sstream>
-#include <cstdarg>
 
 namespace pdal
 {
@@ -52,42 +56,14 @@ CREATE_STATIC_PLUGIN(1, 0, CropFilter, Filter, s_info)
 
 std::string CropFilter::getName() const { return s_info.name; }
 
-#ifdef PDAL_HAVE_GEOS
-namespace geos
-{
-static void _GEOSErrorHandler(const char *fmt, ...)
-{
-    va_list args;
-
-    va_start(args, fmt);
-    char buf[1024];
-
-    vsnprintf(buf, sizeof(buf), fmt, args);
-    std::cerr << "GEOS Error: " << buf << std::endl;
-
-    va_end(args);
-}
-
-static void _GEOSWarningHandler(const char *fmt, ...)
-{
-    va_list args;
-
-    char buf[1024];
-    vsnprintf(buf, sizeof(buf), fmt, args);
-    std::cout << "GEOS warning: " << buf << std::endl;
-
-    va_end(args);
-}
-
-} // geos
-#endif
-
 CropFilter::CropFilter() : pdal::Filter()
 {
     m_cropOutside = false;
     m_geosEnvironment = 0;
-    m_geosGeometry = 0;
-    m_geosPreparedGeometry = 0;
+    m_cellsX = 0;
+    m_cellsY = 0;
+    m_cellWidth = 1;
+    m_cellHeight = 1;
 }
 
 
@@ -96,53 +72,101 @@ void CropFilter::processOptions(const Options& options)
     m_bounds =
         options.getValueOrDefault<BOX3D>("bounds", BOX3D());
     m_cropOutside = options.getValueOrDefault<bool>("outside", false);
-    m_poly = options.getValueOrDefault<std::string>("polygon", "");
+    m_polys.clear();
+    for (const Option& o : options.getOptions("polygon"))
+    {
+        std::string poly = o.getValue<std::string>();
+        if (!poly.empty())
+            m_polys.push_back(poly);
+    }
+    if (m_polys.size() > 1 && m_cropOutside)
+        throw pdal_error("filters.crop: option 'outside' can't be used with "
+            "more than one polygon.");
 
 #if !defined(PDAL_HAVE_GEOS)
-    if (!m_poly.empty())
+    if (!m_polys.empty())
         throw pdal_error("Polygon cropping not supported unless built with GEOS");
 #endif
 }
 
 
+// When this filter reads straight from a reader, have the reader skip the
+// points outside the bounds if it can.  Polygon bounds aren't known until
+// the WKT is read in ready(), after the reader is readied.
+void CropFilter::initialize()
+{
+    const std::vector<Stage *>& inputs = getInputs();
+    if (m_cropOutside || !m_polys.empty() || m_bounds.empty() ||
+        inputs.size() != 1)
+        return;
+    Reader *reader = dynamic_cast<Reader *>(inputs[0]);
+    if (reader && reader->setBounds(m_bounds))
+        log()->get(LogLevel::Debug) << getName() << ": " <<
+            reader->getName() << " reads only points inside " << m_bounds <<
+            std::endl;
+}
+
+
 void CropFilter::ready(PointTableRef /*table*/)
 {
+    m_polygons.clear();
+    m_cells.clear();
 #ifdef PDAL_HAVE_GEOS
-    if (!m_poly.empty())
+    if (!m_polys.empty())
     {
-        m_geosEnvironment = initGEOS_r(pdal::geos::_GEOSWarningHandler,
-            pdal::geos::_GEOSErrorHandler);
-        m_geosGeometry = GEOSGeomFromWKT_r(m_geosEnvironment, m_poly.c_str());
-        if (!m_geosGeometry)
-            throw pdal_error("unable to import polygon WKT");
-
-        int gtype = GEOSGeomTypeId_r(m_geosEnvironment, m_geosGeometry);
-        if (!(gtype == GEOS_POLYGON || gtype == GEOS_MULTIPOLYGON))
-            throw pdal_error("input WKT was not a POLYGON or MULTIPOLYGON");
-
-        char* out_wkt = GEOSGeomToWKT_r(m_geosEnvironment, m_geosGeometry);
-        log()->get(LogLevel::Debug2) << "Ingested WKT for filters.crop: " <<
-            std::string(out_wkt) <<std::endl;
-        GEOSFree_r(m_geosEnvironment, out_wkt);
-
-        if (!GEOSisValid_r(m_geosEnvironment, m_geosGeometry))
+        m_geosEnvironment = geos::context();
+        geos::clearError();
+
+        // The GEOS geometries are only needed to check the WKT and to
+        // prepare the polygons.
+        m_polygons.resize(m_polys.size());
+        BOX3D bounds;
+        for (size_t i = 0; i < m_polys.size(); ++i)
         {
-            char* reason =
-                GEOSisValidReason_r(m_geosEnvironment, m_geosGeometry);
-            std::ostringstream oss;
-            oss << "WKT is invalid: " << std::string(reason) << std::endl;
-            GEOSFree_r(m_geosEnvironment, reason);
-            throw pdal_error(oss.str());
+            GEOSGeometry *geometry =
+                GEOSGeomFromWKT_r(m_geosEnvironment, m_polys[i].c_str());
+            if (!geometry)
+                throw pdal_error("unable to import polygon WKT: " +
+                    geos::lastError());
+            try
+            {
+                int gtype = GEOSGeomTypeId_r(m_geosEnvironment, geometry);
+                if (!(gtype == GEOS_POLYGON || gtype == GEOS_MULTIPOLYGON))
+                    throw pdal_error("input WKT was not a POLYGON or "
+                        "MULTIPOLYGON");
+
+                char* out_wkt = GEOSGeomToWKT_r(m_geosEnvironment, geometry);
+                log()->get(LogLevel::Debug2) << "Ingested WKT for "
+                    "filters.crop: " << std::string(out_wkt) <<std::endl;
+                GEOSFree_r(m_geosEnvironment, out_wkt);
+
+                if (!GEOSisValid_r(m_geosEnvironment, geometry))
+                {
+                    char* reason =
+                        GEOSisValidReason_r(m_geosEnvironment, geometry);
+                    std::ostringstream oss;
+                    oss << "WKT is invalid: " << std::string(reason) <<
+                        std::endl;
+                    GEOSFree_r(m_geosEnvironment, reason);
+                    throw pdal_error(oss.str());
+                }
+
+                buildEdgeGrid(geometry, m_polygons[i]);
+                m_polygons[i].m_bounds = computeBounds(geometry);
+            }
+            catch (...)
+            {
+                GEOSGeom_destroy_r(m_geosEnvironment, geometry);
+                throw;
+            }
+            GEOSGeom_destroy_r(m_geosEnvironment, geometry);
+            bounds.grow(m_polygons[i].m_bounds);
         }
-
-        m_geosPreparedGeometry =
-            GEOSPrepare_r(m_geosEnvironment, m_geosGeometry);
-        if (!m_geosPreparedGeometry)
-            throw pdal_error("unable to prepare geometry for "
-                "index-accelerated intersection");
-        m_bounds = computeBounds(m_geosGeometry);
+        m_bounds = bounds;
         log()->get(LogLevel::Debug) << "Computed bounds from given WKT: " <<
             m_bounds <<std::endl;
+        if (m_polygons.size() > 1)
+            buildPolygonIndex();
     }
     else
     {
@@ -178,117 +202,308 @@ BOX3D CropFilter::computeBounds(GEOSGeometry const *geometry)
 
 #ifdef PDAL_HAVE_GEOS
 
-    GEOSGeometry const* ring = GEOSGetExteriorRing_r(m_geosEnvironment,
-        geometry);
-    GEOSCoordSequence const* coords = GEOSGeom_getCoordSeq_r(m_geosEnvironment,
-        ring);
+    int numPolys = GEOSGetNumGeometries_r(m_geosEnvironment, geometry);
+    for (int p = 0; p < numPolys; ++p)
+    {
+        GEOSGeometry const* poly = GEOSGetGeometryN_r(m_geosEnvironment,
+            geometry, p);
+        GEOSGeometry const* ring = GEOSGetExteriorRing_r(m_geosEnvironment,
+            poly);
+        GEOSCoordSequence const* coords =
+            GEOSGeom_getCoordSeq_r(m_geosEnvironment, ring);
+
+        GEOSCoordSeq_getDimensions_r(m_geosEnvironment, coords,
+            &numInputDims);
+        log()->get(LogLevel::Debug) << "Inputted WKT had " << numInputDims <<
+            " dimensions" <<std::endl;
+
+        uint32_t count(0);
+        GEOSCoordSeq_getSize_r(m_geosEnvironment, coords, &count);
+
+        double x(0.0);
+        double y(0.0);
+        double z(0.0);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            GEOSCoordSeq_getOrdinate_r(m_geosEnvironment, coords, i, 0, &x);
+            GEOSCoordSeq_getOrdinate_r(m_geosEnvironment, coords, i, 1, &y);
+            if (numInputDims > 2)
+                GEOSCoordSeq_getOrdinate_r(m_geosEnvironment, coords, i, 2,
+                    &z);
+            output.grow(x, y, z);
+        }
+    }
+#endif
+    return output;
+}
 
-    GEOSCoordSeq_getDimensions_r(m_geosEnvironment, coords, &numInputDims);
-    log()->get(LogLevel::Debug) << "Inputted WKT had " << numInputDims <<
-        " dimensions" <<std::endl;
 
-    uint32_t count(0);
-    GEOSCoordSeq_getSize_r(m_geosEnvironment, coords, &count);
+// Collect the edges of the rings of each polygon of the geometry and file
+// each in the rows of the grid whose range of Y it crosses.  There are
+// about as many rows as edges, so a point is tested against only the few
+// edges of its row.
+void CropFilter::buildEdgeGrid(GEOSGeometry const *geometry,
+    Polygon& polygon)
+{
+    std::vector<Edge> edges;
 
-    double x(0.0);
-    double y(0.0);
-    double z(0.0);
-    for (unsigned i = 0; i < count; ++i)
+#ifdef PDAL_HAVE_GEOS
+    auto addRing = [this, &edges](GEOSGeometry const *ring)
     {
-        GEOSCoordSeq_getOrdinate_r(m_geosEnvironment, coords, i, 0, &x);
-        GEOSCoordSeq_getOrdinate_r(m_geosEnvironment, coords, i, 1, &y);
-        if (numInputDims > 2)
-            GEOSCoordSeq_getOrdinate_r(m_geosEnvironment, coords, i, 2, &z);
-        output.grow(x, y, z);
+        GEOSCoordSequence const* coords =
+            GEOSGeom_getCoordSeq_r(m_geosEnvironment, ring);
+        uint32_t count(0);
+        GEOSCoordSeq_getSize_r(m_geosEnvironment, coords, &count);
+
+        double prevX(0.0);
+        double prevY(0.0);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            double x(0.0);
+            double y(0.0);
+            GEOSCoordSeq_getX_r(m_geosEnvironment, coords, i, &x);
+            GEOSCoordSeq_getY_r(m_geosEnvironment, coords, i, &y);
+            // Horizontal edges never cross a horizontal ray.
+            if (i > 0 && y != prevY)
+            {
+                Edge e;
+                e.m_x1 = prevX;
+                e.m_y1 = prevY;
+                e.m_y2 = y;
+                e.m_dxdy = (x - prevX) / (y - prevY);
+                edges.push_back(e);
+            }
+            prevX = x;
+            prevY = y;
+        }
+    };
+
+    int numPolys = GEOSGetNumGeometries_r(m_geosEnvironment, geometry);
+    for (int p = 0; p < numPolys; ++p)
+    {
+        GEOSGeometry const* poly = GEOSGetGeometryN_r(m_geosEnvironment,
+            geometry, p);
+        addRing(GEOSGetExteriorRing_r(m_geosEnvironment, poly));
+        int numHoles = GEOSGetNumInteriorRings_r(m_geosEnvironment, poly);
+        for (int h = 0; h < numHoles; ++h)
+            addRing(GEOSGetInteriorRingN_r(m_geosEnvironment, poly, h));
     }
 #endif
-    return output;
+
+    polygon.m_rows.clear();
+    if (edges.empty())
+        return;
+
+    polygon.m_rowMinY = (std::numeric_limits<double>::max)();
+    polygon.m_rowMaxY = std::numeric_limits<double>::lowest();
+    for (const Edge& e : edges)
+    {
+        polygon.m_rowMinY =
+            (std::min)(polygon.m_rowMinY, (std::min)(e.m_y1, e.m_y2));
+        polygon.m_rowMaxY =
+            (std::max)(polygon.m_rowMaxY, (std::max)(e.m_y1, e.m_y2));
+    }
+    const size_t numRows = (std::min)(edges.size(), (size_t)4096);
+    polygon.m_rowHeight = (polygon.m_rowMaxY - polygon.m_rowMinY) / numRows;
+    polygon.m_rows.resize(numRows);
+
+    auto row = [&polygon, numRows](double y)
+    {
+        return (std::min)(
+            (size_t)((y - polygon.m_rowMinY) / polygon.m_rowHeight),
+            numRows - 1);
+    };
+    for (const Edge& e : edges)
+    {
+        size_t first = row((std::min)(e.m_y1, e.m_y2));
+        size_t last = row((std::max)(e.m_y1, e.m_y2));
+        for (size_t r = first; r <= last; ++r)
+            polygon.m_rows[r].push_back(e);
+    }
+}
+
+
+// Whether a point is inside the polygon, by counting the edges that a ray
+// from the point in the +X direction crosses.  Holes and the polygons of a
+// multipolygon are handled alike, since they don't overlap in valid
+// geometry.
+bool CropFilter::Polygon::contains(double x, double y) const
+{
+    if (m_rows.empty() || y < m_rowMinY || y > m_rowMaxY)
+        return false;
+
+    size_t r = (std::min)((size_t)((y - m_rowMinY) / m_rowHeight),
+        m_rows.size() - 1);
+    bool inside = false;
+    for (const Edge& e : m_rows[r])
+        if (((e.m_y1 > y) != (e.m_y2 > y)) &&
+            x < e.m_x1 + (y - e.m_y1) * e.m_dxdy)
+            inside = !inside;
+    return inside;
+}
+
+
+// File each polygon in the cells of a grid over the bounds of all the
+// polygons that its bounds overlap.  There are about as many cells as
+// polygons, so a point is tested against only the few polygons near it.
+void CropFilter::buildPolygonIndex()
+{
+    const size_t MaxCells = 4096;
+
+    const double width = m_bounds.maxx - m_bounds.minx;
+    const double height = m_bounds.maxy - m_bounds.miny;
+    double cellSize = std::sqrt(width * height / m_polygons.size());
+    if (!(cellSize > 0))
+        cellSize = (std::max)(width, height) / m_polygons.size();
+    if (!(cellSize > 0))
+        cellSize = 1;
+
+    m_cellsX = (std::min)(MaxCells,
+        (std::max)((size_t)1, (size_t)std::ceil(width / cellSize)));
+    m_cellsY = (std::min)(MaxCells,
+        (std::max)((size_t)1, (size_t)std::ceil(height / cellSize)));
+    m_cellWidth = width > 0 ? width / m_cellsX : 1;
+    m_cellHeight = height > 0 ? height / m_cellsY : 1;
+    m_cells.assign(m_cellsX * m_cellsY, std::vector<uint32_t>());
+
+    auto cellX = [this](double x)
+    {
+        return (std::min)((size_t)((x - m_bounds.minx) / m_cellWidth),
+            m_cellsX - 1);
+    };
+    auto cellY = [this](double y)
+    {
+        return (std::min)((size_t)((y - m_bounds.miny) / m_cellHeight),
+            m_cellsY - 1);
+    };
+    for (size_t i = 0; i < m_polygons.size(); ++i)
+    {
+        const BOX3D& b = m_polygons[i].m_bounds;
+        for (size_t y = cellY(b.miny); y <= cellY(b.maxy); ++y)
+            for (size_t x = cellX(b.minx); x <= cellX(b.maxx); ++x)
+                m_cells[y * m_cellsX + x].push_back((uint32_t)i);
+    }
 }
 
 
 PointViewSet CropFilter::run(PointViewPtr view)
 {
     PointViewSet viewSet;
-    PointViewPtr outView = view->makeNew();
-    crop(*view.get(), *outView.get());
-    viewSet.insert(outView);
+    if (m_polygons.size() > 1)
+    {
+        // A view for each polygon, in the order they were given.
+        std::vector<PointViewPtr> outViews;
+        for (size_t i = 0; i < m_polygons.size(); ++i)
+            outViews.push_back(view->makeNew());
+        cropPolygons(*view.get(), outViews);
+        viewSet.insert(outViews.begin(), outViews.end());
+    }
+    else
+    {
+        PointViewPtr outView = view->makeNew();
+        crop(*view.get(), *outView.get());
+        viewSet.insert(outView);
+    }
     return viewSet;
 }
 
 
+// Points are cropped in batches.  The coordinates of a batch are fetched
+// as arrays, each point is tested without branching on the result and the
+// ids of those kept are gathered before they're added to the output.
 void CropFilter::crop(PointView& input, PointView& output)
 {
-    bool logOutput = (log()->getLevel() > LogLevel::Debug4);
+    bool logOutput = log()->enabled(LogLevel::Debug5);
     if (logOutput)
-        log()->floatPrecision(8);
+        log()->floatPrecision(10);
 
-    for (PointId idx = 0; idx < input.size(); ++idx)
-    {
-        double x = input.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = input.getFieldAs<double>(Dimension::Id::Y, idx);
-        double z = input.getFieldAs<double>(Dimension::Id::Z, idx);
+    const point_count_t batchSize = 4096;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    std::vector<double> zs(batchSize);
+    std::vector<PointId> keep(batchSize);
+    const BOX3D& b = m_bounds;
 
+    for (PointId begin = 0; begin < input.size(); begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, input.size() - begin);
+        input.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+        input.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        input.getFieldArray(Dimension::Id::Z, begin, count, zs.data());
         if (logOutput)
-        {
-            log()->floatPrecision(10);
-            log()->get(LogLevel::Debug5) << "input: " << x << " y: " << y <<
-                " z: " << z << std::endl;
-        }
+            for (PointId i = 0; i < count; ++i)
+                log()->get(LogLevel::Debug5) << "input: " << xs[i] <<
+                    " y: " << ys[i] << " z: " << zs[i] << std::endl;
 
-        if (m_poly.empty())
+        point_count_t numKept = 0;
+        if (m_polygons.empty())
         {
             // We don't have a polygon, just a bounds. Filter on that
             // by itself.
-            if (!m_cropOutside && m_bounds.contains(x, y, z))
-                output.appendPoint(input, idx);
+            for (PointId i = 0; i < count; ++i)
+            {
+                bool in = (b.minx <= xs[i]) & (xs[i] <= b.maxx) &
+                    (b.miny <= ys[i]) & (ys[i] <= b.maxy) &
+                    (b.minz <= zs[i]) & (zs[i] <= b.maxz);
+                keep[numKept] = begin + i;
+                numKept += (in != m_cropOutside);
+            }
         }
-#ifdef PDAL_HAVE_GEOS
         else
         {
-            int ret(0);
-
-            // precise filtering based on the geometry
-            GEOSCoordSequence* coords =
-                GEOSCoordSeq_create_r(m_geosEnvironment, 1, 3);
-            if (!coords)
-                throw pdal_error("unable to allocate coordinate sequence");
-            ret = GEOSCoordSeq_setX_r(m_geosEnvironment, coords, 0, x);
-            if (!ret)
-                throw pdal_error("unable to set x for coordinate sequence");
-            ret = GEOSCoordSeq_setY_r(m_geosEnvironment, coords, 0, y);
-            if (!ret)
-                throw pdal_error("unable to set y for coordinate sequence");
-            ret = GEOSCoordSeq_setZ_r(m_geosEnvironment, coords, 0, z);
-            if (!ret)
-                throw pdal_error("unable to set z for coordinate sequence");
-
-            GEOSGeometry* p = GEOSGeom_createPoint_r(m_geosEnvironment, coords);
-            if (!p)
-                throw pdal_error("unable to allocate candidate test point");
-
-            if (static_cast<bool>(GEOSPreparedContains_r(m_geosEnvironment,
-                m_geosPreparedGeometry, p)) != m_cropOutside)
-                output.appendPoint(input, idx);
-            GEOSGeom_destroy_r(m_geosEnvironment, p);
+            // The polygon is 2D, so only its X and Y bounds are checked
+            // before the precise test.
+            for (PointId i = 0; i < count; ++i)
+            {
+                bool in = b.minx <= xs[i] && xs[i] <= b.maxx &&
+                    b.miny <= ys[i] && ys[i] <= b.maxy &&
+                    m_polygons[0].contains(xs[i], ys[i]);
+                keep[numKept] = begin + i;
+                numKept += (in != m_cropOutside);
+            }
         }
-#endif
+        for (PointId i = 0; i < numKept; ++i)
+            output.appendPoint(input, keep[i]);
     }
 }
 
 
-void CropFilter::done(PointTableRef /*table*/)
+// Add each point to the view of each polygon that contains it, in one
+// pass over the points.
+void CropFilter::cropPolygons(PointView& input,
+    std::vector<PointViewPtr>& outputs)
 {
-#ifdef PDAL_HAVE_GEOS
-    if (m_geosPreparedGeometry)
-        GEOSPreparedGeom_destroy_r(m_geosEnvironment, m_geosPreparedGeometry);
-
-    if (m_geosGeometry)
-        GEOSGeom_destroy_r(m_geosEnvironment, m_geosGeometry);
+    const point_count_t batchSize = 4096;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    const BOX3D& b = m_bounds;
 
-    if (m_geosEnvironment)
-        finishGEOS_r(m_geosEnvironment);
-#endif
+    for (PointId begin = 0; begin < input.size(); begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, input.size() - begin);
+        input.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+        input.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        for (PointId i = 0; i < count; ++i)
+        {
+            const double x = xs[i];
+            const double y = ys[i];
+            if (x < b.minx || x > b.maxx || y < b.miny || y > b.maxy)
+                continue;
+
+            size_t cx = (std::min)((size_t)((x - b.minx) / m_cellWidth),
+                m_cellsX - 1);
+            size_t cy = (std::min)((size_t)((y - b.miny) / m_cellHeight),
+                m_cellsY - 1);
+            for (uint32_t p : m_cells[cy * m_cellsX + cx])
+            {
+                const Polygon& poly = m_polygons[p];
+                const BOX3D& pb = poly.m_bounds;
+                if (pb.minx <= x && x <= pb.maxx &&
+                    pb.miny <= y && y <= pb.maxy && poly.contains(x, y))
+                    outputs[p]->appendPoint(input, begin + i);
+            }
+        }
+    }
 }
 
-
 } // namespace pdal
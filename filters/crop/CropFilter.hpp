@@ -36,6 +36,8 @@
 
 #include <pdal/Filter.hpp>
 
+#include <vector>
+
 #ifdef PDAL_HAVE_GEOS
 #include <geos_c.h>
 #endif
@@ -62,27 +64,62 @@ public:
     const BOX3D& getBounds() const;
 
 private:
+    // An edge of a polygon ring, as tested against a ray in the +X
+    // direction.
+    struct Edge
+    {
+        double m_x1;
+        double m_y1;
+        double m_y2;
+        // Change in X per unit of Y along the edge.
+        double m_dxdy;
+    };
+
+    // A polygon prepared for testing points.  The edges of all its rings
+    // are stored in each row of a grid of horizontal rows over the
+    // polygon's bounds that they cross.
+    struct Polygon
+    {
+        BOX3D m_bounds;
+        std::vector<std::vector<Edge>> m_rows;
+        double m_rowMinY;
+        double m_rowMaxY;
+        double m_rowHeight;
+
+        bool contains(double x, double y) const;
+    };
+
     BOX3D m_bounds;
     bool m_cropOutside;
-    std::string m_poly;
+    std::vector<std::string> m_polys;
+    std::vector<Polygon> m_polygons;
+
+    // With more than one polygon, a grid of cells over the bounds of all
+    // of them, each listing the polygons whose bounds overlap it.
+    std::vector<std::vector<uint32_t>> m_cells;
+    size_t m_cellsX;
+    size_t m_cellsY;
+    double m_cellWidth;
+    double m_cellHeight;
 
+    // The GEOS context of the thread that prepared the filter, owned by
+    // geos::context().
 #ifdef PDAL_HAVE_GEOS
 	GEOSContextHandle_t m_geosEnvironment;
-    GEOSGeometry* m_geosGeometry;
-    GEOSPreparedGeometry const* m_geosPreparedGeometry;
 #else
     void* m_geosEnvironment;
-    void* m_geosGeometry;
-    void* m_geosPreparedGeometry;
     typedef struct GEOSGeometry* GEOSGeometryHS;
 #endif
 
     virtual void processOptions(const Options& options);
+    virtual void initialize();
     virtual void ready(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
-    virtual void done(PointTableRef table);
     void crop(PointView& input, PointView& output);
+    void cropPolygons(PointView& input, std::vector<PointViewPtr>& outputs);
     BOX3D computeBounds(GEOSGeometry const *geometry);
+    void buildEdgeGrid(GEOSGeometry const *geometry, Polygon& polygon);
+    void buildPolygonIndex();
 
     CropFilter& operator=(const CropFilter&); // not implemented
     CropFilter(const CropFilter&); // not implemented
@@ -34,14 +34,82 @@
 
 #include "DecimationFilter.hpp"
 
+#include <pdal/PointTable.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/RadixSort.hpp>
+#include <pdal/Reader.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
 
 namespace pdal
 {
 
+namespace
+{
+
+const point_count_t batchSize = 4096;
+
+struct Cell
+{
+    int64_t m_x;
+    int64_t m_y;
+    int64_t m_z;
+
+    bool operator==(const Cell& other) const
+    {
+        return m_x == other.m_x && m_y == other.m_y && m_z == other.m_z;
+    }
+};
+
+struct CellHash
+{
+    size_t operator()(const Cell& c) const
+    {
+        uint64_t h = (uint64_t)c.m_x * 0x9E3779B97F4A7C15ULL;
+        h ^= (uint64_t)c.m_y * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+        h ^= (uint64_t)c.m_z * 0x165667B19E3779F9ULL + (h << 6) + (h >> 2);
+        return (size_t)h;
+    }
+};
+
+typedef std::unordered_map<Cell, PointId, CellHash> CellMap;
+
+// Divide, rounding toward negative infinity.
+int64_t floorDiv(int64_t a, int64_t b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+uint64_t tileKey(int64_t tx, int64_t ty)
+{
+    return ((uint64_t)(uint32_t)(int32_t)tx << 32) | (uint32_t)(int32_t)ty;
+}
+
+uint64_t mix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Random key of the point at a position in the input.  Keys come from the
+// position rather than from a generator so that a sample doesn't depend on
+// the number of threads or on whether the points are streamed.
+uint64_t sampleKey(uint64_t seed, PointId idx)
+{
+    return mix(idx ^ mix(seed + 0x9E3779B97F4A7C15ULL));
+}
+
+} // unnamed namespace
+
 static PluginInfo const s_info = PluginInfo(
     "filters.decimation",
-    "Rank decimation filter. Keep every Nth point",
+    "Rank decimation filter. Keep every Nth point, or thin the points "
+        "to an even density.",
     "http://pdal.io/stages/filters.decimation.html" );
 
 CREATE_STATIC_PLUGIN(1, 0, DecimationFilter, Filter,  s_info)
@@ -50,17 +118,121 @@ std::string DecimationFilter::getName() const { return s_info.name; }
 
 void DecimationFilter::processOptions(const Options& options)
 {
+    std::string mode =
+        options.getValueOrDefault<std::string>("mode", "step");
+    if (mode == "step")
+        m_mode = Step;
+    else if (mode == "voxel")
+        m_mode = Voxel;
+    else if (mode == "poisson")
+        m_mode = Poisson;
+    else if (mode == "random")
+        m_mode = Random;
+    else if (mode == "stratified")
+        m_mode = Stratified;
+    else
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Invalid 'mode' value '" << mode <<
+            "'.  Must be 'step', 'voxel', 'poisson', 'random' or "
+            "'stratified'.";
+        throw pdal_error(oss.str());
+    }
+
+    m_cell = options.getValueOrDefault<double>("cell", 1.0);
+    m_radius = options.getValueOrDefault<double>("radius", 1.0);
+    m_count = options.getValueOrDefault<point_count_t>("count", 0);
+    std::string strata =
+        options.getValueOrDefault<std::string>("strata", "cell");
+    if (strata == "cell")
+        m_strata = CellStrata;
+    else if (strata == "classification")
+        m_strata = ClassStrata;
+    else
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Invalid 'strata' value '" << strata <<
+            "'.  Must be 'cell' or 'classification'.";
+        throw pdal_error(oss.str());
+    }
+
+    std::string bad;
+    if ((m_mode == Voxel ||
+        (m_mode == Stratified && m_strata == CellStrata)) && !(m_cell > 0))
+        bad = "cell";
+    else if (m_mode == Poisson && !(m_radius > 0))
+        bad = "radius";
+    else if ((m_mode == Random || m_mode == Stratified) && m_count == 0)
+        bad = "count";
+    if (bad.size())
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option '" << bad <<
+            "' must be greater than 0.";
+        throw pdal_error(oss.str());
+    }
+    m_seed = options.getValueOrDefault<uint64_t>("seed", 0);
     m_step = options.getValueOrDefault<uint32_t>("step", 1);
     m_offset = options.getValueOrDefault<uint32_t>("offset", 0);
     m_limit = options.getValueOrDefault<point_count_t>("limit", 0);
 }
 
 
+// When this filter reads straight from a reader, have the reader read only
+// the points that are kept if it can.
+void DecimationFilter::initialize()
+{
+    m_readerStride = false;
+    const std::vector<Stage *>& inputs = getInputs();
+    if (m_mode == Step && inputs.size() == 1 && m_step > 0)
+    {
+        Reader *reader = dynamic_cast<Reader *>(inputs[0]);
+        m_readerStride = reader && reader->setStride(m_offset, m_step);
+    }
+}
+
+
+void DecimationFilter::ready(PointTableRef table)
+{
+    m_streaming = dynamic_cast<FixedPointTable *>(&table) != nullptr;
+    m_seen = 0;
+    m_reservoirs.clear();
+    m_sampled.clear();
+    m_flushed = 0;
+    m_dims = table.layout()->dimTypes();
+    m_packedSize = 0;
+    for (auto& d : m_dims)
+        m_packedSize += Dimension::size(d.m_type);
+}
+
+
 PointViewSet DecimationFilter::run(PointViewPtr inView)
 {
     PointViewSet viewSet;
+    if (m_mode == Step && m_readerStride && m_limit == 0)
+    {
+        viewSet.insert(inView);
+        return viewSet;
+    }
+    if ((m_mode == Random || m_mode == Stratified) && m_streaming)
+        return sampleStream(*inView.get());
+
     PointViewPtr outView = inView->makeNew();
-    decimate(*inView.get(), *outView.get());
+    if (m_mode == Step)
+        decimate(*inView.get(), *outView.get());
+    else
+    {
+        std::vector<char> keep(inView->size());
+        if (m_mode == Voxel)
+            voxel(*inView.get(), keep);
+        else if (m_mode == Poisson)
+            poisson(*inView.get(), keep);
+        else
+            sample(*inView.get(), keep);
+        for (PointId idx = 0; idx < inView->size(); ++idx)
+            if (keep[idx])
+                outView->appendPoint(*inView.get(), idx);
+    }
     viewSet.insert(outView);
     return viewSet;
 }
@@ -68,9 +240,365 @@ PointViewSet DecimationFilter::run(PointViewPtr inView)
 
 void DecimationFilter::decimate(PointView& input, PointView& output)
 {
+    if (m_readerStride)
+    {
+        // Only the points before the limit are left to drop.
+        PointId last_idx = 0;
+        if (m_limit > m_offset)
+            last_idx = (m_limit - m_offset + m_step - 1) / m_step;
+        last_idx = std::min<PointId>(last_idx, input.size());
+        for (PointId idx = 0; idx < last_idx; ++idx)
+            output.appendPoint(input, idx);
+        return;
+    }
+
     PointId last_idx = (m_limit > 0) ? m_limit : input.size();
     for (PointId idx = m_offset; idx < last_idx; idx += m_step)
         output.appendPoint(input, idx);
 }
 
+
+// Keep the first point in each cube of a grid with sides of m_cell.
+void DecimationFilter::voxel(PointView& input, std::vector<char>& keep)
+{
+    const point_count_t count = input.size();
+    ThreadPool& pool = ThreadPool::shared();
+    // Points of a table that isn't threadSafe() are read as one chunk.
+    const size_t chunks = !input.table().threadSafe() ? 1 :
+        (std::max)((size_t)1,
+            (std::min)(pool.size(), (size_t)(count / 65536)));
+    auto chunkBegin = [count, chunks](size_t c)
+        { return (PointId)((count * c) / chunks); };
+
+    // Each chunk of points finds the first of its points in each cell.
+    std::vector<CellMap> chunkCells(chunks);
+    pool.parallelFor(chunks, 1, [&](size_t first, size_t last)
+    {
+        std::vector<double> xs(batchSize);
+        std::vector<double> ys(batchSize);
+        std::vector<double> zs(batchSize);
+        for (size_t c = first; c < last; ++c)
+        {
+            CellMap& cells = chunkCells[c];
+            for (PointId begin = chunkBegin(c); begin < chunkBegin(c + 1);
+                begin += batchSize)
+            {
+                point_count_t n = (std::min)(batchSize,
+                    (point_count_t)(chunkBegin(c + 1) - begin));
+                input.getFieldArray(Dimension::Id::X, begin, n, xs.data());
+                input.getFieldArray(Dimension::Id::Y, begin, n, ys.data());
+                input.getFieldArray(Dimension::Id::Z, begin, n, zs.data());
+                for (PointId i = 0; i < n; ++i)
+                {
+                    Cell cell = { (int64_t)std::floor(xs[i] / m_cell),
+                        (int64_t)std::floor(ys[i] / m_cell),
+                        (int64_t)std::floor(zs[i] / m_cell) };
+                    cells.insert(std::make_pair(cell, begin + i));
+                }
+            }
+        }
+    });
+
+    // The first chunk to find a cell holds its first point.
+    CellMap& cells = chunkCells[0];
+    for (size_t c = 1; c < chunks; ++c)
+    {
+        cells.insert(chunkCells[c].begin(), chunkCells[c].end());
+        CellMap().swap(chunkCells[c]);
+    }
+    for (auto& cp : cells)
+        keep[cp.second] = 1;
+}
+
+
+// Keep points so that no two kept points are within m_radius of one another
+// and every dropped point is within m_radius of a kept one.
+//
+// Points are binned into cells with sides of half the radius, so a cell
+// holds at most one kept point and the kept points within the radius of a
+// point lie in the cells up to two away.  The cells are grouped into square
+// columns of tiles.  Tiles are visited in four passes, by the parity of
+// their position, so that the tiles of a pass have no neighbors in common
+// and can be thinned in parallel.  Within a tile points are visited in
+// order, so the result doesn't depend on the number of threads.
+void DecimationFilter::poisson(PointView& input, std::vector<char>& keep)
+{
+    const point_count_t count = input.size();
+    ThreadPool& pool = ThreadPool::shared();
+    const size_t chunks = (std::max)((size_t)1,
+        (std::min)(pool.size(), (size_t)(count / 65536)));
+    auto chunkBegin = [count, chunks](size_t c)
+        { return (PointId)((count * c) / chunks); };
+
+    const double cellSize = m_radius / 2;
+    const double r2 = m_radius * m_radius;
+    const int64_t tileCells = 32;
+
+    std::vector<double> xs(count);
+    std::vector<double> ys(count);
+    std::vector<double> zs(count);
+    std::vector<Cell> cells(count);
+    std::vector<RadixPair> order(count);
+    auto bin = [&](size_t first, size_t last)
+    {
+        for (size_t c = first; c < last; ++c)
+        {
+            PointId begin = chunkBegin(c);
+            point_count_t n = chunkBegin(c + 1) - begin;
+            input.getFieldArray(Dimension::Id::X, begin, n, xs.data() + begin);
+            input.getFieldArray(Dimension::Id::Y, begin, n, ys.data() + begin);
+            input.getFieldArray(Dimension::Id::Z, begin, n, zs.data() + begin);
+            for (PointId idx = begin; idx < begin + n; ++idx)
+            {
+                Cell& cell = cells[idx];
+                cell.m_x = (int64_t)std::floor(xs[idx] / cellSize);
+                cell.m_y = (int64_t)std::floor(ys[idx] / cellSize);
+                cell.m_z = (int64_t)std::floor(zs[idx] / cellSize);
+                order[idx] = RadixPair(tileKey(floorDiv(cell.m_x, tileCells),
+                    floorDiv(cell.m_y, tileCells)), idx);
+            }
+        }
+    };
+    // The points are read on one thread when the table isn't threadSafe().
+    if (input.table().threadSafe())
+        pool.parallelFor(chunks, 1, bin);
+    else
+        bin(0, chunks);
+    radixSort(order);
+
+    struct Tile
+    {
+        int64_t m_x;
+        int64_t m_y;
+        size_t m_begin;
+        size_t m_end;
+        CellMap m_kept;
+    };
+    std::vector<Tile> tiles;
+    std::unordered_map<uint64_t, size_t> tileIndex;
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        if (i && order[i].first == order[i - 1].first)
+            continue;
+        const Cell& cell = cells[order[i].second];
+        Tile tile;
+        tile.m_x = floorDiv(cell.m_x, tileCells);
+        tile.m_y = floorDiv(cell.m_y, tileCells);
+        tile.m_begin = i;
+        if (tiles.size())
+            tiles.back().m_end = i;
+        tileIndex[order[i].first] = tiles.size();
+        tiles.push_back(std::move(tile));
+    }
+    if (tiles.size())
+        tiles.back().m_end = order.size();
+
+    // Whether a point is within the radius of a kept point.
+    auto covered = [&](const Tile& tile, PointId idx)
+    {
+        const Cell& cell = cells[idx];
+        for (int64_t dx = -2; dx <= 2; ++dx)
+        for (int64_t dy = -2; dy <= 2; ++dy)
+        {
+            const Cell column = { cell.m_x + dx, cell.m_y + dy, 0 };
+            int64_t tx = floorDiv(column.m_x, tileCells);
+            int64_t ty = floorDiv(column.m_y, tileCells);
+            const Tile *t = &tile;
+            if (tx != tile.m_x || ty != tile.m_y)
+            {
+                auto ti = tileIndex.find(tileKey(tx, ty));
+                if (ti == tileIndex.end())
+                    continue;
+                t = &tiles[ti->second];
+            }
+            if (t->m_kept.empty())
+                continue;
+            for (int64_t dz = -2; dz <= 2; ++dz)
+            {
+                const Cell c = { column.m_x, column.m_y, cell.m_z + dz };
+                auto ki = t->m_kept.find(c);
+                if (ki == t->m_kept.end())
+                    continue;
+                PointId k = ki->second;
+                double dX = xs[k] - xs[idx];
+                double dY = ys[k] - ys[idx];
+                double dZ = zs[k] - zs[idx];
+                if (dX * dX + dY * dY + dZ * dZ < r2)
+                    return true;
+            }
+        }
+        return false;
+    };
+
+    for (int64_t pass = 0; pass < 4; ++pass)
+    {
+        std::vector<size_t> active;
+        for (size_t t = 0; t < tiles.size(); ++t)
+            if (((tiles[t].m_x & 1) | ((tiles[t].m_y & 1) << 1)) == pass)
+                active.push_back(t);
+        pool.parallelFor(active.size(), 1, [&](size_t first, size_t last)
+        {
+            for (size_t a = first; a < last; ++a)
+            {
+                Tile& tile = tiles[active[a]];
+                for (size_t i = tile.m_begin; i < tile.m_end; ++i)
+                {
+                    PointId idx = order[i].second;
+                    if (!covered(tile, idx))
+                    {
+                        tile.m_kept[cells[idx]] = idx;
+                        keep[idx] = 1;
+                    }
+                }
+            }
+        });
+    }
+}
+
+
+// Stratum of a point in stratified mode.  Random mode has just one.
+uint64_t DecimationFilter::stratum(const PointView& view, PointId idx) const
+{
+    if (m_mode == Random)
+        return 0;
+    if (m_strata == ClassStrata)
+        return view.getFieldAs<uint8_t>(Dimension::Id::Classification, idx);
+    return tileKey(
+        (int64_t)std::floor(view.getFieldAs<double>(Dimension::Id::X, idx) /
+            m_cell),
+        (int64_t)std::floor(view.getFieldAs<double>(Dimension::Id::Y, idx) /
+            m_cell));
+}
+
+
+// Add a candidate to a sample if it's among the 'count' with the least
+// keys seen so far.  Returns whether it was added.
+bool DecimationFilter::offer(std::vector<Candidate>& heap,
+    const Candidate& c) const
+{
+    if (heap.size() < m_count)
+    {
+        heap.push_back(c);
+        std::push_heap(heap.begin(), heap.end());
+        return true;
+    }
+    if (!(c < heap.front()))
+        return false;
+    std::pop_heap(heap.begin(), heap.end());
+    heap.back() = c;
+    std::push_heap(heap.begin(), heap.end());
+    return true;
+}
+
+
+// Keep 'count' points chosen at random from all points or from each
+// stratum.  Every point gets a random key and the points with the least
+// keys are kept, so each chunk of points can find its own least keys in
+// parallel and the chunks' samples merge into the sample of them all.
+void DecimationFilter::sample(PointView& input, std::vector<char>& keep)
+{
+    typedef std::map<uint64_t, std::vector<Candidate>> StrataMap;
+
+    const point_count_t count = input.size();
+    ThreadPool& pool = ThreadPool::shared();
+    // Points of a table that isn't threadSafe() are read as one chunk.
+    const size_t chunks = !input.table().threadSafe() ? 1 :
+        (std::max)((size_t)1,
+            (std::min)(pool.size(), (size_t)(count / 65536)));
+    auto chunkBegin = [count, chunks](size_t c)
+        { return (PointId)((count * c) / chunks); };
+
+    std::vector<StrataMap> chunkStrata(chunks);
+    pool.parallelFor(chunks, 1, [&](size_t first, size_t last)
+    {
+        for (size_t c = first; c < last; ++c)
+        {
+            StrataMap& strata = chunkStrata[c];
+            for (PointId idx = chunkBegin(c); idx < chunkBegin(c + 1); ++idx)
+            {
+                Candidate cand = { sampleKey(m_seed, idx), idx, 0 };
+                offer(strata[stratum(input, idx)], cand);
+            }
+        }
+    });
+
+    StrataMap& strata = chunkStrata[0];
+    for (size_t c = 1; c < chunks; ++c)
+    {
+        for (auto& sp : chunkStrata[c])
+        {
+            std::vector<Candidate>& heap = strata[sp.first];
+            for (const Candidate& cand : sp.second)
+                offer(heap, cand);
+        }
+        StrataMap().swap(chunkStrata[c]);
+    }
+    for (auto& sp : strata)
+        for (const Candidate& cand : sp.second)
+            keep[cand.m_index] = 1;
+}
+
+
+// Gather the sample from a streamed chunk.  Points in the sample so far
+// are copied, packed, into their stratum's reservoir, in the place of the
+// point they push out, so only the sample is held.  Nothing is handed on
+// until flush().
+PointViewSet DecimationFilter::sampleStream(PointView& view)
+{
+    for (PointId i = 0; i < view.size(); ++i)
+    {
+        PointId idx = m_seen + i;
+        Candidate cand = { sampleKey(m_seed, idx), idx, 0 };
+        Reservoir& r = m_reservoirs[stratum(view, i)];
+        if (r.m_heap.size() < m_count)
+            cand.m_slot = r.m_heap.size();
+        else if (cand < r.m_heap.front())
+            cand.m_slot = r.m_heap.front().m_slot;
+        else
+            continue;
+        offer(r.m_heap, cand);
+        if (r.m_points.size() < (cand.m_slot + 1) * m_packedSize)
+            r.m_points.resize((cand.m_slot + 1) * m_packedSize);
+        view.getPackedPoint(m_dims, i,
+            r.m_points.data() + cand.m_slot * m_packedSize);
+    }
+    m_seen += view.size();
+    return PointViewSet();
+}
+
+
+// Hand on the streamed sample in the order its points were read.
+PointViewSet DecimationFilter::flush(PointViewPtr view, point_count_t count)
+{
+    PointViewSet viewSet;
+    if (m_mode != Random && m_mode != Stratified)
+        return viewSet;
+
+    if (m_flushed == 0 && m_sampled.empty())
+    {
+        for (auto& rp : m_reservoirs)
+            for (const Candidate& cand : rp.second.m_heap)
+                m_sampled.push_back(std::make_pair(&rp.second, cand));
+        std::sort(m_sampled.begin(), m_sampled.end(),
+            [](const std::pair<Reservoir *, Candidate>& a,
+                const std::pair<Reservoir *, Candidate>& b)
+            { return a.second.m_index < b.second.m_index; });
+    }
+
+    point_count_t n = (std::min)(count,
+        (point_count_t)(m_sampled.size() - m_flushed));
+    if (n == 0)
+        return viewSet;
+    PointViewPtr out = view->makeNew();
+    for (point_count_t i = 0; i < n; ++i)
+    {
+        auto& s = m_sampled[m_flushed + i];
+        out->setPackedPoint(m_dims, i,
+            s.first->m_points.data() + s.second.m_slot * m_packedSize);
+    }
+    m_flushed += n;
+    viewSet.insert(out);
+    return viewSet;
+}
+
 } // pdal
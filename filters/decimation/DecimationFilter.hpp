@@ -36,6 +36,8 @@
 
 #include <pdal/Filter.hpp>
 
+#include <map>
+
 extern "C" int32_t DecimationFilter_ExitFunc();
 extern "C" PF_ExitFunc DecimationFilter_InitPlugin();
 
@@ -43,24 +45,101 @@ namespace pdal
 {
 
 // we keep only 1 out of every step points; if step=100, we get 1% of the file
+// The voxel and poisson modes instead thin the points to an even density.
+// The random and stratified modes keep an exact number of points chosen at
+// random, from all points or from each cell or class.
 class PDAL_DLL DecimationFilter : public Filter
 {
 public:
-    DecimationFilter()
+    DecimationFilter() : m_mode(Step), m_readerStride(false),
+        m_streaming(false)
         {}
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    // When the reader skips the points that are dropped there's nothing
+    // left to do, so chunks can be passed on as they're read.  Random
+    // samples are gathered from the chunks and handed on at the end.
+    virtual bool streamable() const
+    {
+        return (m_mode == Step && m_readerStride && m_limit == 0) ||
+            m_mode == Random || m_mode == Stratified;
+    }
 
 private:
+    enum Mode
+    {
+        Step,
+        Voxel,
+        Poisson,
+        Random,
+        Stratified
+    };
+
+    enum Strata
+    {
+        CellStrata,
+        ClassStrata
+    };
+
+    // A point in a sample, by the random key that ranks it.  The points
+    // with the least keys are kept.
+    struct Candidate
+    {
+        uint64_t m_key;
+        PointId m_index;
+        // Where a streamed point's packed data is in its reservoir.
+        size_t m_slot;
+
+        bool operator<(const Candidate& other) const
+            { return m_key < other.m_key; }
+    };
+
+    // The sample of one stratum, a heap with the greatest key on top.
+    struct Reservoir
+    {
+        std::vector<Candidate> m_heap;
+        std::vector<char> m_points;
+    };
+
+    Mode m_mode;
+    // Edge of a voxel in voxel mode.
+    double m_cell;
+    // Least distance between kept points in poisson mode.
+    double m_radius;
     uint32_t m_step;
     uint32_t m_offset;
     point_count_t m_limit;
+    // Points kept, in all or in each stratum, in random and stratified
+    // modes.
+    point_count_t m_count;
+    uint64_t m_seed;
+    Strata m_strata;
+    // Whether the input reader skips the points that aren't kept.
+    bool m_readerStride;
+
+    // Samples gathered while streaming.
+    bool m_streaming;
+    point_count_t m_seen;
+    DimTypeList m_dims;
+    size_t m_packedSize;
+    std::map<uint64_t, Reservoir> m_reservoirs;
+    std::vector<std::pair<Reservoir *, Candidate>> m_sampled;
+    size_t m_flushed;
 
     virtual void processOptions(const Options& options);
+    virtual void initialize();
+    virtual void ready(PointTableRef table);
     PointViewSet run(PointViewPtr view);
+    virtual PointViewSet flush(PointViewPtr view, point_count_t count);
     void decimate(PointView& input, PointView& output);
+    void voxel(PointView& input, std::vector<char>& keep);
+    void poisson(PointView& input, std::vector<char>& keep);
+    void sample(PointView& input, std::vector<char>& keep);
+    PointViewSet sampleStream(PointView& view);
+    uint64_t stratum(const PointView& view, PointId idx) const;
+    bool offer(std::vector<Candidate>& heap, const Candidate& c) const;
 
     DecimationFilter& operator=(const DecimationFilter&); // not implemented
     DecimationFilter(const DecimationFilter&); // not implemented
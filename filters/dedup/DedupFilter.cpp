@@ -0,0 +1,258 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "DedupFilter.hpp"
+
+#include <pdal/PointView.hpp>
+#include <pdal/RadixSort.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "filters.dedup",
+    "Remove duplicate points, keeping the first of each.",
+    "http://pdal.io/stages/filters.dedup.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, DedupFilter, Filter, s_info)
+
+std::string DedupFilter::getName() const { return s_info.name; }
+
+namespace
+{
+
+const point_count_t batchSize = 4096;
+
+struct Key
+{
+    int64_t m_x;
+    int64_t m_y;
+    int64_t m_z;
+    int64_t m_t;
+
+    bool operator==(const Key& other) const
+    {
+        return m_x == other.m_x && m_y == other.m_y && m_z == other.m_z &&
+            m_t == other.m_t;
+    }
+
+    uint64_t hash() const
+    {
+        uint64_t h = (uint64_t)m_x * 0x9E3779B97F4A7C15ULL;
+        h ^= (uint64_t)m_y * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+        h ^= (uint64_t)m_z * 0x165667B19E3779F9ULL + (h << 6) + (h >> 2);
+        h ^= (uint64_t)m_t * 0x27D4EB2F165667C5ULL + (h << 6) + (h >> 2);
+        return h ^ (h >> 29);
+    }
+};
+
+// Quantize a value to the cell of a grid with sides of 'tolerance' that
+// holds it, or to its bits when the tolerance is 0.
+int64_t quantize(double v, double tolerance)
+{
+    if (tolerance > 0)
+        return (int64_t)std::floor(v / tolerance);
+    if (v == 0)
+        return 0;  // -0 and 0 are the same point.
+    int64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+// Interleave the low 32 bits of x and y.
+uint64_t morton(int64_t x, int64_t y)
+{
+    auto spread = [](uint64_t v)
+    {
+        v &= 0xFFFFFFFFULL;
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+        v = (v | (v << 8)) & 0x00FF00FF00FF00FFULL;
+        v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        v = (v | (v << 2)) & 0x3333333333333333ULL;
+        v = (v | (v << 1)) & 0x5555555555555555ULL;
+        return v;
+    };
+    return spread((uint64_t)x) | (spread((uint64_t)y) << 1);
+}
+
+} // unnamed namespace
+
+
+void DedupFilter::processOptions(const Options& options)
+{
+    m_tolerance = options.getValueOrDefault<double>("tolerance", 0);
+    m_timeTolerance = options.getValueOrDefault<double>("time_tolerance", 0);
+    m_useTime = options.getValueOrDefault<bool>("gpstime", false);
+    if (m_tolerance < 0 || m_timeTolerance < 0)
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Options 'tolerance' and 'time_tolerance' "
+            "can't be negative.";
+        throw pdal_error(oss.str());
+    }
+}
+
+
+PointViewSet DedupFilter::run(PointViewPtr inView)
+{
+    if (m_useTime && !inView->hasDim(Dimension::Id::GpsTime))
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'gpstime' is set but the points have "
+            "no GpsTime.";
+        throw pdal_error(oss.str());
+    }
+
+    std::vector<char> keep(inView->size());
+    findFirst(*inView, keep);
+
+    PointViewPtr outView = inView->makeNew();
+    for (PointId idx = 0; idx < inView->size(); ++idx)
+        if (keep[idx])
+            outView->appendPoint(*inView, idx);
+    log()->get(LogLevel::Debug) << getName() << ": Removed " <<
+        (inView->size() - outView->size()) << " duplicates of " <<
+        inView->size() << " points." << std::endl;
+
+    PointViewSet viewSet;
+    viewSet.insert(outView);
+    return viewSet;
+}
+
+
+// Mark the first point with each key to keep.
+//
+// Points are sorted by the Morton code of their X and Y cells.  Duplicates
+// have the same code, and the sort is stable, so they are together and in
+// order.  The sorted points are split into ranges that don't split a
+// code, and each range finds its duplicates in parallel with an
+// open-addressing hash table sized from the range.
+void DedupFilter::findFirst(PointView& view, std::vector<char>& keep)
+{
+    using namespace Dimension;
+
+    const point_count_t count = view.size();
+    ThreadPool& pool = ThreadPool::shared();
+    const size_t chunks = (std::max)((size_t)1,
+        (std::min)(pool.size(), (size_t)(count / 65536)));
+    auto chunkBegin = [count, chunks](size_t c)
+        { return (PointId)((count * c) / chunks); };
+
+    std::vector<Key> keys(count);
+    std::vector<RadixPair> order(count);
+    auto extract = [&](size_t first, size_t last)
+    {
+        std::vector<double> xs(batchSize);
+        std::vector<double> ys(batchSize);
+        std::vector<double> zs(batchSize);
+        std::vector<double> ts(batchSize);
+        for (size_t c = first; c < last; ++c)
+            for (PointId begin = chunkBegin(c); begin < chunkBegin(c + 1);
+                begin += batchSize)
+            {
+                point_count_t n = (std::min)(batchSize,
+                    (point_count_t)(chunkBegin(c + 1) - begin));
+                view.getFieldArray(Id::X, begin, n, xs.data());
+                view.getFieldArray(Id::Y, begin, n, ys.data());
+                view.getFieldArray(Id::Z, begin, n, zs.data());
+                if (m_useTime)
+                    view.getFieldArray(Id::GpsTime, begin, n, ts.data());
+                for (PointId i = 0; i < n; ++i)
+                {
+                    Key& key = keys[begin + i];
+                    key.m_x = quantize(xs[i], m_tolerance);
+                    key.m_y = quantize(ys[i], m_tolerance);
+                    key.m_z = quantize(zs[i], m_tolerance);
+                    key.m_t = m_useTime ?
+                        quantize(ts[i], m_timeTolerance) : 0;
+                    order[begin + i] =
+                        RadixPair(morton(key.m_x, key.m_y), begin + i);
+                }
+            }
+    };
+    // The keys are read on one thread when the table isn't threadSafe().
+    if (view.table().threadSafe())
+        pool.parallelFor(chunks, 1, extract);
+    else
+        extract(0, chunks);
+    radixSort(order);
+
+    // Move each range boundary past the points with the code before it.
+    std::vector<size_t> bounds(chunks + 1);
+    bounds[chunks] = count;
+    for (size_t c = 1; c < chunks; ++c)
+    {
+        size_t b = (std::max)(bounds[c - 1], (size_t)chunkBegin(c));
+        while (b > 0 && b < count && order[b].first == order[b - 1].first)
+            b++;
+        bounds[c] = b;
+    }
+
+    pool.parallelFor(chunks, 1, [&](size_t first, size_t last)
+    {
+        const PointId empty = (std::numeric_limits<PointId>::max)();
+        std::vector<PointId> table;
+        for (size_t c = first; c < last; ++c)
+        {
+            size_t size = bounds[c + 1] - bounds[c];
+            size_t capacity = 16;
+            while (capacity < 2 * size)
+                capacity *= 2;
+            table.assign(capacity, empty);
+            const size_t mask = capacity - 1;
+            for (size_t i = bounds[c]; i < bounds[c + 1]; ++i)
+            {
+                PointId idx = order[i].second;
+                const Key& key = keys[idx];
+                size_t slot = (size_t)key.hash() & mask;
+                while (table[slot] != empty && !(keys[table[slot]] == key))
+                    slot = (slot + 1) & mask;
+                if (table[slot] == empty)
+                {
+                    table[slot] = idx;
+                    keep[idx] = 1;
+                }
+            }
+        }
+    });
+}
+
+} // namespace pdal
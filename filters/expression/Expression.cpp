@@ -0,0 +1,555 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "Expression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace pdal
+{
+
+// Recursive descent over the text, emitting instructions in postfix
+// order.  From loosest to tightest binding the operators are ||, &&,
+// comparisons, + and -, * and /, and unary - and !.
+class Expression::Parser
+{
+public:
+    Parser(Expression& expr) : m_expr(expr), m_text(expr.m_text), m_pos(0)
+        {}
+
+    void parse()
+    {
+        // A leading name followed by a single '=' is an assignment.
+        std::size_t start = skipSpace(0);
+        std::size_t end = start;
+        while (end < m_text.size() && isNameChar(m_text[end], end == start))
+            end++;
+        std::size_t eq = skipSpace(end);
+        if (end > start && eq < m_text.size() && m_text[eq] == '=' &&
+            (eq + 1 == m_text.size() || m_text[eq + 1] != '='))
+        {
+            m_expr.m_target = m_text.substr(start, end - start);
+            m_pos = eq + 1;
+        }
+
+        parseOr();
+        m_pos = skipSpace(m_pos);
+        if (m_pos != m_text.size())
+            error("unexpected '" + m_text.substr(m_pos, 1) + "'");
+    }
+
+private:
+    Expression& m_expr;
+    const std::string& m_text;
+    std::size_t m_pos;
+
+    static bool isNameChar(char c, bool first)
+    {
+        return std::isalpha((unsigned char)c) || c == '_' ||
+            (!first && std::isdigit((unsigned char)c));
+    }
+
+    std::size_t skipSpace(std::size_t pos) const
+    {
+        while (pos < m_text.size() && std::isspace((unsigned char)m_text[pos]))
+            pos++;
+        return pos;
+    }
+
+    void error(const std::string& what) const
+    {
+        std::ostringstream oss;
+        oss << "Invalid expression '" << m_text << "': " << what <<
+            " at position " << (m_pos + 1) << ".";
+        throw pdal_error(oss.str());
+    }
+
+    // Consume 'tok' if it's next.
+    bool accept(const std::string& tok)
+    {
+        std::size_t pos = skipSpace(m_pos);
+        if (m_text.compare(pos, tok.size(), tok) != 0)
+            return false;
+        // Don't take the start of a longer operator.
+        std::size_t next = pos + tok.size();
+        if ((tok == "<" || tok == ">" || tok == "!") &&
+            next < m_text.size() && m_text[next] == '=')
+            return false;
+        m_pos = next;
+        return true;
+    }
+
+    void expect(const std::string& tok)
+    {
+        if (!accept(tok))
+        {
+            m_pos = skipSpace(m_pos);
+            error("expected '" + tok + "'");
+        }
+    }
+
+    void emit(Op op, double value = 0)
+        { m_expr.m_code.push_back(Instr(op, value)); }
+
+    // Emit a binary operation whose operands start at 'left'.  Constant
+    // operands are folded into the instruction, and constant expressions
+    // are evaluated here.
+    void emitBinary(Op op, std::size_t left)
+    {
+        std::vector<Instr>& code = m_expr.m_code;
+        if (code.size() - left == 2 && code[left].m_op == Op::Const &&
+            code[left + 1].m_op == Op::Const)
+        {
+            double v[2] = { code[left].m_value, code[left + 1].m_value };
+            code.erase(code.begin() + left, code.end());
+            code.push_back(Instr(Op::Const, v[0]));
+            Instr instr(op, v[1], true);
+            Expression::apply(instr, 1, v, NULL);
+            code.back().m_value = v[0];
+        }
+        else if (code.back().m_op == Op::Const)
+        {
+            double v = code.back().m_value;
+            code.back() = Instr(op, v, true);
+        }
+        else
+            emit(op);
+    }
+
+    void emitUnary(Op op)
+    {
+        std::vector<Instr>& code = m_expr.m_code;
+        if (code.back().m_op == Op::Const)
+            Expression::apply(Instr(op), 1, &code.back().m_value, NULL);
+        else
+            emit(op);
+    }
+
+    void parseOr()
+    {
+        std::size_t left = m_expr.m_code.size();
+        parseAnd();
+        while (accept("||"))
+        {
+            parseAnd();
+            emitBinary(Op::Or, left);
+        }
+    }
+
+    void parseAnd()
+    {
+        std::size_t left = m_expr.m_code.size();
+        parseCompare();
+        while (accept("&&"))
+        {
+            parseCompare();
+            emitBinary(Op::And, left);
+        }
+    }
+
+    void parseCompare()
+    {
+        static const std::vector<std::pair<std::string, Op>> ops {
+            { "==", Op::Eq }, { "!=", Op::Ne }, { "<=", Op::Le },
+            { ">=", Op::Ge }, { "<", Op::Lt }, { ">", Op::Gt } };
+
+        std::size_t left = m_expr.m_code.size();
+        parseSum();
+        for (auto& op : ops)
+            if (accept(op.first))
+            {
+                parseSum();
+                emitBinary(op.second, left);
+                break;
+            }
+    }
+
+    void parseSum()
+    {
+        std::size_t left = m_expr.m_code.size();
+        parseProduct();
+        while (true)
+        {
+            Op op;
+            if (accept("+"))
+                op = Op::Add;
+            else if (accept("-"))
+                op = Op::Sub;
+            else
+                break;
+            parseProduct();
+            emitBinary(op, left);
+        }
+    }
+
+    void parseProduct()
+    {
+        std::size_t left = m_expr.m_code.size();
+        parseUnary();
+        while (true)
+        {
+            Op op;
+            if (accept("*"))
+                op = Op::Mul;
+            else if (accept("/"))
+                op = Op::Div;
+            else
+                break;
+            parseUnary();
+            emitBinary(op, left);
+        }
+    }
+
+    void parseUnary()
+    {
+        if (accept("-"))
+        {
+            parseUnary();
+            emitUnary(Op::Neg);
+        }
+        else if (accept("!"))
+        {
+            parseUnary();
+            emitUnary(Op::Not);
+        }
+        else if (accept("+"))
+            parseUnary();
+        else
+            parsePrimary();
+    }
+
+    void parsePrimary()
+    {
+        m_pos = skipSpace(m_pos);
+        if (m_pos == m_text.size())
+            error("unexpected end");
+
+        if (accept("("))
+        {
+            parseOr();
+            expect(")");
+            return;
+        }
+
+        char c = m_text[m_pos];
+        if (std::isdigit((unsigned char)c) || c == '.')
+        {
+            const char *start = m_text.c_str() + m_pos;
+            char *end;
+            double v = std::strtod(start, &end);
+            if (end == start)
+                error("invalid number");
+            m_pos += end - start;
+            emit(Op::Const, v);
+            return;
+        }
+
+        if (!isNameChar(c, true))
+            error("unexpected '" + m_text.substr(m_pos, 1) + "'");
+        std::size_t start = m_pos;
+        while (m_pos < m_text.size() && isNameChar(m_text[m_pos], false))
+            m_pos++;
+        std::string name = m_text.substr(start, m_pos - start);
+        if (accept("("))
+            parseFunction(name, start);
+        else
+            load(name);
+    }
+
+    void parseFunction(const std::string& name, std::size_t start)
+    {
+        static const std::vector<std::pair<std::string, Op>> unary {
+            { "abs", Op::Abs }, { "sqrt", Op::Sqrt }, { "floor", Op::Floor },
+            { "ceil", Op::Ceil }, { "round", Op::Round } };
+        static const std::vector<std::pair<std::string, Op>> binary {
+            { "min", Op::Min }, { "max", Op::Max } };
+
+        for (auto& f : unary)
+            if (f.first == name)
+            {
+                parseOr();
+                expect(")");
+                emitUnary(f.second);
+                return;
+            }
+        for (auto& f : binary)
+            if (f.first == name)
+            {
+                std::size_t left = m_expr.m_code.size();
+                parseOr();
+                expect(",");
+                parseOr();
+                expect(")");
+                emitBinary(f.second, left);
+                return;
+            }
+        m_pos = start;
+        error("unknown function '" + name + "'");
+    }
+
+    void load(const std::string& name)
+    {
+        std::vector<std::string>& names = m_expr.m_dimNames;
+        auto di = std::find(names.begin(), names.end(), name);
+        Instr instr(Op::Load);
+        instr.m_column = di - names.begin();
+        if (di == names.end())
+            names.push_back(name);
+        m_expr.m_code.push_back(instr);
+    }
+};
+
+
+void Expression::parse(const std::string& text)
+{
+    m_text = text;
+    m_target.clear();
+    m_targetId = Dimension::Id::Unknown;
+    m_code.clear();
+    m_dimNames.clear();
+    m_dims.clear();
+
+    Parser(*this).parse();
+
+    // Find the most values the program holds at once.
+    std::size_t depth = 0;
+    m_depth = 0;
+    for (const Instr& instr : m_code)
+    {
+        if (instr.m_op == Op::Load || instr.m_op == Op::Const)
+            depth++;
+        else if (instr.m_op >= Op::Add && !instr.m_imm)
+            depth--;
+        m_depth = (std::max)(m_depth, depth);
+    }
+}
+
+
+void Expression::prepare(PointLayoutPtr layout)
+{
+    m_dims.clear();
+    for (const std::string& name : m_dimNames)
+    {
+        Dimension::Id::Enum id = layout->findDim(name);
+        if (id == Dimension::Id::Unknown)
+            throw pdal_error("Dimension '" + name + "' of expression '" +
+                m_text + "' not found.");
+        m_dims.push_back(id);
+    }
+    if (assignment())
+    {
+        m_targetId = layout->findDim(m_target);
+        if (m_targetId == Dimension::Id::Unknown)
+            throw pdal_error("Dimension '" + m_target + "' assigned by "
+                "expression '" + m_text + "' not found.");
+    }
+}
+
+
+namespace
+{
+
+template<typename F>
+void unary(double *a, std::size_t n, F f)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        a[i] = f(a[i]);
+}
+
+template<typename F>
+void binary(double *a, const double *b, std::size_t n, F f)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        a[i] = f(a[i], b[i]);
+}
+
+template<typename F>
+void binary(double *a, double b, std::size_t n, F f)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        a[i] = f(a[i], b);
+}
+
+// Apply a binary operation to 'a' with 'b' either a block of values or,
+// when 'b' is NULL, the immediate value of the instruction.
+template<typename F>
+void binaryOp(double *a, const double *b, double imm, std::size_t n, F f)
+{
+    if (b)
+        binary(a, b, n, f);
+    else
+        binary(a, imm, n, f);
+}
+
+} // unnamed namespace
+
+
+// Apply an operation other than a load or constant to the 'n' values at
+// 'a', with 'b' the right operand of a binary operation that isn't
+// immediate.
+void Expression::apply(const Instr& instr, std::size_t n, double *a,
+    const double *b)
+{
+    const double v = instr.m_value;
+    switch (instr.m_op)
+    {
+    case Op::Neg:
+        unary(a, n, [](double x){ return -x; });
+        break;
+    case Op::Not:
+        unary(a, n, [](double x){ return (double)(x == 0); });
+        break;
+    case Op::Abs:
+        unary(a, n, [](double x){ return std::fabs(x); });
+        break;
+    case Op::Sqrt:
+        unary(a, n, [](double x){ return std::sqrt(x); });
+        break;
+    case Op::Floor:
+        unary(a, n, [](double x){ return std::floor(x); });
+        break;
+    case Op::Ceil:
+        unary(a, n, [](double x){ return std::ceil(x); });
+        break;
+    case Op::Round:
+        unary(a, n, [](double x){ return std::round(x); });
+        break;
+    case Op::Add:
+        binaryOp(a, b, v, n, [](double x, double y){ return x + y; });
+        break;
+    case Op::Sub:
+        binaryOp(a, b, v, n, [](double x, double y){ return x - y; });
+        break;
+    case Op::Mul:
+        binaryOp(a, b, v, n, [](double x, double y){ return x * y; });
+        break;
+    case Op::Div:
+        binaryOp(a, b, v, n, [](double x, double y){ return x / y; });
+        break;
+    case Op::Min:
+        binaryOp(a, b, v, n, [](double x, double y){ return y < x ? y : x; });
+        break;
+    case Op::Max:
+        binaryOp(a, b, v, n, [](double x, double y){ return y > x ? y : x; });
+        break;
+    case Op::Lt:
+        binaryOp(a, b, v, n,
+            [](double x, double y){ return (double)(x < y); });
+        break;
+    case Op::Le:
+        binaryOp(a, b, v, n,
+            [](double x, double y){ return (double)(x <= y); });
+        break;
+    case Op::Gt:
+        binaryOp(a, b, v, n,
+            [](double x, double y){ return (double)(x > y); });
+        break;
+    case Op::Ge:
+        binaryOp(a, b, v, n,
+            [](double x, double y){ return (double)(x >= y); });
+        break;
+    case Op::Eq:
+        binaryOp(a, b, v, n,
+            [](double x, double y){ return (double)(x == y); });
+        break;
+    case Op::Ne:
+        binaryOp(a, b, v, n,
+            [](double x, double y){ return (double)(x != y); });
+        break;
+    case Op::And:
+        binaryOp(a, b, v, n,
+            [](double x, double y){ return (double)(x != 0 && y != 0); });
+        break;
+    case Op::Or:
+        binaryOp(a, b, v, n,
+            [](double x, double y){ return (double)(x != 0 || y != 0); });
+        break;
+    case Op::Load:
+    case Op::Const:
+        break;
+    }
+}
+
+
+// Run the program over 'n' points whose dimensions have been loaded into
+// 'columns'.  The result is left at the bottom of the stack.
+void Expression::run(std::size_t n, double *columns, double *stack) const
+{
+    double *top = stack - BlockSize;
+    for (const Instr& instr : m_code)
+    {
+        if (instr.m_op == Op::Load)
+        {
+            top += BlockSize;
+            std::copy(columns + instr.m_column * BlockSize,
+                columns + instr.m_column * BlockSize + n, top);
+        }
+        else if (instr.m_op == Op::Const)
+        {
+            top += BlockSize;
+            std::fill(top, top + n, instr.m_value);
+        }
+        else if (instr.m_op >= Op::Add && !instr.m_imm)
+        {
+            apply(instr, n, top - BlockSize, top);
+            top -= BlockSize;
+        }
+        else
+            apply(instr, n, top, NULL);
+    }
+}
+
+
+void Expression::evaluate(const PointView& view, PointId begin,
+    point_count_t count, std::vector<double>& scratch, double *out) const
+{
+    scratch.resize((m_dims.size() + m_depth) * BlockSize);
+    double *columns = scratch.data();
+    double *stack = columns + m_dims.size() * BlockSize;
+
+    for (PointId b = begin; b < begin + count; b += BlockSize)
+    {
+        std::size_t n = (std::min)((point_count_t)BlockSize, begin + count - b);
+        for (std::size_t c = 0; c < m_dims.size(); ++c)
+            view.getFieldArray(m_dims[c], b, n, columns + c * BlockSize);
+        run(n, columns, stack);
+        std::copy(stack, stack + n, out + (b - begin));
+    }
+}
+
+} // namespace pdal
@@ -0,0 +1,122 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/PointView.hpp>
+
+#include <string>
+#include <vector>
+
+namespace pdal
+{
+
+// An expression over the dimensions of a point, such as
+// "Classification == 2 && Z > 100", or an assignment to one, such as
+// "Z = Z * 0.3048".  The text is compiled to a program for a stack machine
+// whose instructions each work on a block of points at once, so that the
+// cost of interpreting them is spread over the block and their loops can
+// be vectorized by the compiler.  All values are doubles; comparisons and
+// logical operators give 1 for true and 0 for false.
+class PDAL_DLL Expression
+{
+public:
+    // The number of points evaluated by each pass of the program.
+    static const point_count_t BlockSize = 1024;
+
+    Expression() : m_targetId(Dimension::Id::Unknown), m_depth(0)
+        {}
+
+    // Compile 'text'.  Throws pdal_error if it isn't a valid expression.
+    void parse(const std::string& text);
+    // Resolve the dimensions the expression uses in 'layout'.  Throws
+    // pdal_error if one isn't there.
+    void prepare(PointLayoutPtr layout);
+
+    const std::string& text() const
+        { return m_text; }
+    // Whether the expression assigns to a dimension rather than tests
+    // points.
+    bool assignment() const
+        { return m_target.size(); }
+    // The name of the dimension assigned to.
+    const std::string& target() const
+        { return m_target; }
+    Dimension::Id::Enum targetId() const
+        { return m_targetId; }
+
+    // Evaluate the expression for the 'count' points of 'view' starting at
+    // 'begin', leaving the results in 'out'.  'scratch' holds the
+    // machine's registers and may be reused from call to call.
+    void evaluate(const PointView& view, PointId begin, point_count_t count,
+        std::vector<double>& scratch, double *out) const;
+
+private:
+    enum class Op
+    {
+        Load, Const, Neg, Not, Abs, Sqrt, Floor, Ceil, Round,
+        Add, Sub, Mul, Div, Min, Max, Lt, Le, Gt, Ge, Eq, Ne, And, Or
+    };
+
+    // Binary operations with m_imm set take their right operand from
+    // m_value rather than the stack.  Loads push column m_column.
+    struct Instr
+    {
+        Instr(Op op, double value = 0, bool imm = false) : m_op(op),
+            m_value(value), m_imm(imm), m_column(0)
+            {}
+
+        Op m_op;
+        double m_value;
+        bool m_imm;
+        std::size_t m_column;
+    };
+
+    class Parser;
+
+    std::string m_text;
+    std::string m_target;
+    Dimension::Id::Enum m_targetId;
+    std::vector<Instr> m_code;
+    // Dimensions loaded by the program, each once for each block.
+    std::vector<std::string> m_dimNames;
+    std::vector<Dimension::Id::Enum> m_dims;
+    std::size_t m_depth;
+
+    static void apply(const Instr& instr, std::size_t n, double *a,
+        const double *b);
+    void run(std::size_t n, double *columns, double *stack) const;
+};
+
+} // namespace pdal
@@ -0,0 +1,179 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "ExpressionFilter.hpp"
+
+#include <algorithm>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "filters.expression",
+    "Set dimensions and pass points with expressions over their "
+        "dimensions.",
+    "http://pdal.io/stages/filters.expression.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, ExpressionFilter, Filter, s_info)
+
+std::string ExpressionFilter::getName() const { return s_info.name; }
+
+
+Options ExpressionFilter::getDefaultOptions()
+{
+    Options options;
+    options.add("expression", "", "Assignment, such as 'Z = Z * 0.3048', "
+        "or test, such as 'Classification == 2 && Z > 100'.  May be given "
+        "more than once.");
+    return options;
+}
+
+
+void ExpressionFilter::processOptions(const Options& options)
+{
+    m_exprs.clear();
+    m_tests = false;
+    for (const Option& opt : options.getOptions("expression"))
+    {
+        Expression expr;
+        try
+        {
+            expr.parse(opt.getValue<std::string>());
+        }
+        catch (pdal_error& err)
+        {
+            throw pdal_error(getName() + ": " + err.what());
+        }
+        if (!expr.assignment())
+            m_tests = true;
+        m_exprs.push_back(expr);
+    }
+    if (m_exprs.empty())
+        throw pdal_error(getName() + ": Option 'expression' must be "
+            "specified.");
+}
+
+
+// Dimensions that are assigned to but don't exist are added as doubles.
+void ExpressionFilter::addDimensions(PointLayoutPtr layout)
+{
+    for (const Expression& expr : m_exprs)
+    {
+        if (!expr.assignment() ||
+            layout->findDim(expr.target()) != Dimension::Id::Unknown)
+            continue;
+        Dimension::Id::Enum id = Dimension::id(expr.target());
+        if (id != Dimension::Id::Unknown)
+            layout->registerDim(id);
+        else
+            layout->assignDim(expr.target(), Dimension::Type::Double);
+    }
+}
+
+
+void ExpressionFilter::ready(PointTableRef table)
+{
+    for (Expression& expr : m_exprs)
+    {
+        try
+        {
+            expr.prepare(table.layout());
+        }
+        catch (pdal_error& err)
+        {
+            throw pdal_error(getName() + ": " + err.what());
+        }
+    }
+}
+
+
+// Run the expressions over a range of points a block at a time, so that
+// the values one sets are still in cache for the next.  Points failing a
+// test have 0 set in 'keep'.
+void ExpressionFilter::evaluate(PointView& view, PointId begin,
+    point_count_t count, char *keep) const
+{
+    const point_count_t blockSize = Expression::BlockSize;
+    std::vector<double> scratch;
+    std::vector<double> values(blockSize);
+
+    for (PointId b = begin; b < begin + count; b += blockSize)
+    {
+        point_count_t n = (std::min)(blockSize, begin + count - b);
+        for (const Expression& expr : m_exprs)
+        {
+            expr.evaluate(view, b, n, scratch, values.data());
+            if (expr.assignment())
+                view.setFieldArray(expr.targetId(), b, n, values.data());
+            else if (keep)
+                for (PointId i = 0; i < n; ++i)
+                    keep[b - begin + i] &= (values[i] != 0);
+        }
+    }
+}
+
+
+void ExpressionFilter::filterRange(PointView& view, PointId first,
+    PointId last)
+{
+    evaluate(view, first, last - first, NULL);
+}
+
+
+PointViewSet ExpressionFilter::run(PointViewPtr inView)
+{
+    PointViewSet viewSet;
+    if (!m_tests)
+    {
+        auto range = [this, &inView](PointId begin, PointId end)
+            { filterRange(*inView, begin, end); };
+        parallelFilter(*inView, range);
+        viewSet.insert(inView);
+        return viewSet;
+    }
+
+    std::vector<char> keep(inView->size(), 1);
+    auto test = [this, &inView, &keep](PointId begin, PointId end)
+        { evaluate(*inView, begin, end - begin, keep.data() + begin); };
+    parallelFilter(*inView, test);
+
+    PointViewPtr outView = inView->makeNew();
+    for (PointId i = 0; i < inView->size(); ++i)
+        if (keep[i])
+            outView->appendPoint(*inView, i);
+    viewSet.insert(outView);
+    return viewSet;
+}
+
+} // namespace pdal
@@ -0,0 +1,90 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Filter.hpp>
+
+#include "Expression.hpp"
+
+#include <string>
+#include <vector>
+
+extern "C" int32_t ExpressionFilter_ExitFunc();
+extern "C" PF_ExitFunc ExpressionFilter_InitPlugin();
+
+namespace pdal
+{
+
+// Evaluates expressions over the dimensions of each point.  Assignments
+// set a dimension and tests pass only the points for which they're true.
+class PDAL_DLL ExpressionFilter : public Filter
+{
+public:
+    ExpressionFilter() : m_tests(false)
+    {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+    Options getDefaultOptions();
+
+    virtual bool streamable() const
+        { return true; }
+    virtual bool viewParallel() const
+        { return true; }
+    // Filters that only assign keep every point.
+    virtual bool pointwise() const
+        { return !m_tests; }
+
+private:
+    // Evaluated in order, so an assignment's value is seen by the
+    // expressions that follow it.
+    std::vector<Expression> m_exprs;
+    bool m_tests;
+
+    virtual void processOptions(const Options& options);
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void ready(PointTableRef table);
+    virtual PointViewSet run(PointViewPtr view);
+    virtual void filterRange(PointView& view, PointId first, PointId last);
+
+    void evaluate(PointView& view, PointId begin, point_count_t count,
+        char *keep) const;
+
+    ExpressionFilter& operator=(const ExpressionFilter&); // not implemented
+    ExpressionFilter(const ExpressionFilter&); // not implemented
+};
+
+} // namespace pdal
@@ -92,11 +92,17 @@ void FerryFilter::processOptions(const Options& options)
         m_name_map.insert(std::make_pair(name, to_dim));
     }
 }
+// A new dimension takes the type of the one it's copied from, so that
+// values are copied exactly and as stored.
 void FerryFilter::addDimensions(PointLayoutPtr layout)
 {
     for (const auto& dim_par : m_name_map)
     {
-        layout->registerOrAssignDim(dim_par.second, Dimension::Type::Double);
+        Dimension::Type::Enum type = Dimension::Type::Double;
+        Dimension::Id::Enum from = layout->findDim(dim_par.first);
+        if (from != Dimension::Id::Unknown)
+            type = layout->dimType(from);
+        layout->registerOrAssignDim(dim_par.second, type);
     }
 }
 
@@ -107,21 +113,22 @@ void FerryFilter::ready(PointTableRef table)
     {
         Dimension::Id::Enum f = layout->findDim(dim_par.first);
         Dimension::Id::Enum t = layout->findDim(dim_par.second);
+        if (f == Dimension::Id::Unknown)
+        {
+            std::ostringstream oss;
+            oss << getName() << ": Dimension '" << dim_par.first <<
+                "' not found.";
+            throw pdal_error(oss.str());
+        }
         m_dimensions_map.insert(std::make_pair(f,t));
     }
 }
 
 
-void FerryFilter::filter(PointView& view)
+void FerryFilter::filterRange(PointView& view, PointId first, PointId last)
 {
-    for (PointId id = 0; id < view.size(); ++id)
-    {
-        for (const auto& dim_par : m_dimensions_map)
-        {
-            double v = view.getFieldAs<double>(dim_par.first, id);
-            view.setField(dim_par.second, id, v);
-        }
-    }
+    for (const auto& dim_par : m_dimensions_map)
+        view.copyField(dim_par.first, dim_par.second, first, last - first);
 }
 
 
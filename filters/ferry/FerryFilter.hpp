@@ -54,6 +54,12 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool viewParallel() const
+        { return true; }
+    virtual bool pointwise() const
+        { return true; }
 
     Options getDefaultOptions();
 
@@ -61,7 +67,7 @@ private:
     virtual void processOptions(const Options&);
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void ready(PointTableRef table);
-    virtual void filter(PointView& view);
+    virtual void filterRange(PointView& view, PointId first, PointId last);
 
     FerryFilter& operator=(const FerryFilter&); // not implemented
     FerryFilter(const FerryFilter&); // not implemented
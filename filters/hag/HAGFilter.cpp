@@ -0,0 +1,242 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "HAGFilter.hpp"
+
+#include <pdal/PointView.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "filters.hag",
+    "Compute the height of each point above a raster of the ground points.",
+    "http://pdal.io/stages/filters.hag.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, HAGFilter, Filter, s_info)
+
+std::string HAGFilter::getName() const { return s_info.name; }
+
+void HAGFilter::processOptions(const Options& options)
+{
+    m_resolution = options.getValueOrDefault<double>("resolution", 1.0);
+    m_class = options.getValueOrDefault<int>("class", 2);
+    if (!(m_resolution > 0))
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'resolution' must be greater than 0.";
+        throw pdal_error(oss.str());
+    }
+}
+
+
+void HAGFilter::addDimensions(PointLayoutPtr layout)
+{
+    layout->registerDim(Dimension::Id::HeightAboveGround);
+}
+
+
+// Average the Z of the ground points in each cell of a raster that covers
+// them.  The raster is aligned to multiples of the resolution so that
+// views of the same data give the same cells.
+void HAGFilter::buildGround(PointView& view)
+{
+    using namespace Dimension;
+
+    const point_count_t batchSize = 4096;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    std::vector<double> zs(batchSize);
+    std::vector<int> classes(batchSize);
+
+    BOX3D bounds;
+    point_count_t groundCount = 0;
+    for (PointId begin = 0; begin < view.size(); begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, view.size() - begin);
+        view.getFieldArray(Id::X, begin, count, xs.data());
+        view.getFieldArray(Id::Y, begin, count, ys.data());
+        view.getFieldArray(Id::Classification, begin, count, classes.data());
+        for (PointId i = 0; i < count; ++i)
+            if (classes[i] == m_class)
+            {
+                bounds.grow(xs[i], ys[i]);
+                groundCount++;
+            }
+    }
+    if (groundCount == 0)
+    {
+        std::ostringstream oss;
+        oss << getName() << ": No points with classification " << m_class <<
+            " to compute the height above.";
+        throw pdal_error(oss.str());
+    }
+
+    m_originX = std::floor(bounds.minx / m_resolution) * m_resolution;
+    m_originY = std::floor(bounds.miny / m_resolution) * m_resolution;
+    m_cols = (size_t)((bounds.maxx - m_originX) / m_resolution) + 1;
+    m_rows = (size_t)((bounds.maxy - m_originY) / m_resolution) + 1;
+    m_ground.assign(m_cols * m_rows, 0);
+    std::vector<point_count_t> counts(m_cols * m_rows);
+
+    for (PointId begin = 0; begin < view.size(); begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, view.size() - begin);
+        view.getFieldArray(Id::X, begin, count, xs.data());
+        view.getFieldArray(Id::Y, begin, count, ys.data());
+        view.getFieldArray(Id::Z, begin, count, zs.data());
+        view.getFieldArray(Id::Classification, begin, count, classes.data());
+        for (PointId i = 0; i < count; ++i)
+        {
+            if (classes[i] != m_class)
+                continue;
+            size_t col = (std::min)(m_cols - 1,
+                (size_t)((xs[i] - m_originX) / m_resolution));
+            size_t row = (std::min)(m_rows - 1,
+                (size_t)((ys[i] - m_originY) / m_resolution));
+            m_ground[row * m_cols + col] += zs[i];
+            counts[row * m_cols + col]++;
+        }
+    }
+    for (size_t c = 0; c < m_ground.size(); ++c)
+        if (counts[c])
+            m_ground[c] /= counts[c];
+    fillGround(counts);
+}
+
+
+// Give each cell without ground the mean of its neighbors that have it,
+// working out from the cells with ground a ring at a time.
+void HAGFilter::fillGround(std::vector<point_count_t>& counts)
+{
+    std::vector<size_t> ring;
+    std::vector<double> values;
+    while (true)
+    {
+        ring.clear();
+        values.clear();
+        for (size_t row = 0; row < m_rows; ++row)
+            for (size_t col = 0; col < m_cols; ++col)
+            {
+                if (counts[row * m_cols + col])
+                    continue;
+                double sum = 0;
+                size_t filled = 0;
+                for (size_t r = (row ? row - 1 : 0);
+                    r <= (std::min)(row + 1, m_rows - 1); ++r)
+                    for (size_t c = (col ? col - 1 : 0);
+                        c <= (std::min)(col + 1, m_cols - 1); ++c)
+                        if (counts[r * m_cols + c])
+                        {
+                            sum += m_ground[r * m_cols + c];
+                            filled++;
+                        }
+                if (filled)
+                {
+                    ring.push_back(row * m_cols + col);
+                    values.push_back(sum / filled);
+                }
+            }
+        if (ring.empty())
+            break;
+        for (size_t i = 0; i < ring.size(); ++i)
+        {
+            m_ground[ring[i]] = values[i];
+            counts[ring[i]] = 1;
+        }
+    }
+}
+
+
+// Interpolate the ground bilinearly between the centers of the cells
+// around a position.  Positions beyond the centers of the outer cells take
+// the height of the edge.
+double HAGFilter::groundHeight(double x, double y) const
+{
+    auto locate = [this](double v, double origin, size_t count,
+        size_t& low, size_t& high) -> double
+    {
+        double f = (v - origin) / m_resolution - .5;
+        f = (std::max)(0.0, (std::min)(f, (double)(count - 1)));
+        low = (size_t)f;
+        high = (std::min)(low + 1, count - 1);
+        return f - low;
+    };
+
+    size_t c0, c1, r0, r1;
+    double tx = locate(x, m_originX, m_cols, c0, c1);
+    double ty = locate(y, m_originY, m_rows, r0, r1);
+    double bottom = m_ground[r0 * m_cols + c0] * (1 - tx) +
+        m_ground[r0 * m_cols + c1] * tx;
+    double top = m_ground[r1 * m_cols + c0] * (1 - tx) +
+        m_ground[r1 * m_cols + c1] * tx;
+    return bottom * (1 - ty) + top * ty;
+}
+
+
+void HAGFilter::filter(PointView& view)
+{
+    if (view.empty())
+        return;
+    if (!view.hasDim(Dimension::Id::Classification))
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Points must have a Classification to find "
+            "the ground.";
+        throw pdal_error(oss.str());
+    }
+
+    buildGround(view);
+    log()->get(LogLevel::Debug) << getName() << ": Ground raster is " <<
+        m_cols << " x " << m_rows << " cells." << std::endl;
+
+    auto compute = [this, &view](PointId first, PointId last)
+    {
+        using namespace Dimension;
+
+        for (PointId i = first; i < last; ++i)
+        {
+            double x = view.getFieldAs<double>(Id::X, i);
+            double y = view.getFieldAs<double>(Id::Y, i);
+            double z = view.getFieldAs<double>(Id::Z, i);
+            view.setField(Id::HeightAboveGround, i, z - groundHeight(x, y));
+        }
+    };
+    parallelFilter(view, compute);
+}
+
+} // namespace pdal
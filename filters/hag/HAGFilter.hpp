@@ -0,0 +1,83 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Filter.hpp>
+
+#include <vector>
+
+extern "C" int32_t HAGFilter_ExitFunc();
+extern "C" PF_ExitFunc HAGFilter_InitPlugin();
+
+namespace pdal
+{
+
+// Compute the height of each point above the ground.  The ground points,
+// found by their classification, are averaged into a raster once, with
+// cells that have no ground filled from their neighbors, and the height
+// of a point is its Z less the raster interpolated at its position.
+class PDAL_DLL HAGFilter : public Filter
+{
+public:
+    HAGFilter() : Filter()
+        {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+private:
+    double m_resolution;
+    int m_class;
+
+    // Ground raster, by row from the minimum Y.
+    double m_originX;
+    double m_originY;
+    size_t m_cols;
+    size_t m_rows;
+    std::vector<double> m_ground;
+
+    virtual void processOptions(const Options& options);
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void filter(PointView& view);
+    void buildGround(PointView& view);
+    void fillGround(std::vector<point_count_t>& counts);
+    double groundHeight(double x, double y) const;
+
+    HAGFilter& operator=(const HAGFilter&); // not implemented
+    HAGFilter(const HAGFilter&); // not implemented
+};
+
+} // namespace pdal
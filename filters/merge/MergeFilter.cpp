@@ -34,6 +34,11 @@
 
 #include "MergeFilter.hpp"
 
+#include <pdal/RadixSort.hpp>
+
+#include <algorithm>
+#include <queue>
+
 namespace pdal
 {
 
@@ -46,5 +51,149 @@ CREATE_STATIC_PLUGIN(1, 0, MergeFilter, Filter, s_info)
 
 std::string MergeFilter::getName() const { return s_info.name; }
 
+
+Options MergeFilter::getDefaultOptions()
+{
+    Options options;
+    options.add("sort_dimension", "", "Dimension by which each input is "
+        "sorted.  Points are interleaved so that the output is sorted too.");
+    return options;
+}
+
+
+void MergeFilter::processOptions(const Options& options)
+{
+    m_dimName = options.getValueOrDefault<std::string>("sort_dimension", "");
+}
+
+
+void MergeFilter::ready(PointTableRef table)
+{
+    m_view.reset(new PointView(table));
+    m_inViews.clear();
+
+    m_dim = Dimension::Id::Unknown;
+    if (m_dimName.empty())
+        return;
+    m_dim = table.layout()->findDim(m_dimName);
+    if (m_dim == Dimension::Id::Unknown)
+        log()->get(LogLevel::Warning) << getName() << ": Dimension '" <<
+            m_dimName << "' not found.  Points will be appended in the "
+            "order they were read." << std::endl;
+}
+
+
+void MergeFilter::done(PointTableRef table)
+{
+    if (m_dim == Dimension::Id::Unknown || m_inViews.size() < 2)
+        m_view->append(m_inViews);
+    else
+        mergeSorted();
+    m_inViews.clear();
+}
+
+
+namespace
+{
+
+template<typename T>
+void extractKeys(PointView& view, Dimension::Id::Enum dim,
+    std::vector<RadixPair>& keys)
+{
+    const point_count_t batchSize = 4096;
+    std::vector<T> vals(batchSize);
+    keys.resize(view.size());
+    for (PointId b = 0; b < view.size(); b += batchSize)
+    {
+        point_count_t n = (std::min)(batchSize, view.size() - b);
+        view.getFieldArray(dim, b, n, vals.data());
+        for (PointId i = 0; i < n; ++i)
+            keys[b + i] = RadixPair(radixKey(vals[i]), b + i);
+    }
+}
+
+} // unnamed namespace
+
+
+// Take the point with the smallest key of those at the heads of the
+// views, k-way, so that n points from k views take O(n log k) rather than
+// the O(n log n) of sorting them all.  Equal keys are taken in the order
+// the views were run.
+void MergeFilter::mergeSorted()
+{
+    std::vector<std::vector<RadixPair>> keys(m_inViews.size());
+    for (size_t v = 0; v < m_inViews.size(); ++v)
+    {
+        PointView& view = *m_inViews[v];
+        switch (view.layout()->dimType(m_dim))
+        {
+        case Dimension::Type::Float:
+            extractKeys<float>(view, m_dim, keys[v]);
+            break;
+        case Dimension::Type::Signed8:
+            extractKeys<int8_t>(view, m_dim, keys[v]);
+            break;
+        case Dimension::Type::Signed16:
+            extractKeys<int16_t>(view, m_dim, keys[v]);
+            break;
+        case Dimension::Type::Signed32:
+            extractKeys<int32_t>(view, m_dim, keys[v]);
+            break;
+        case Dimension::Type::Signed64:
+            extractKeys<int64_t>(view, m_dim, keys[v]);
+            break;
+        case Dimension::Type::Unsigned8:
+            extractKeys<uint8_t>(view, m_dim, keys[v]);
+            break;
+        case Dimension::Type::Unsigned16:
+            extractKeys<uint16_t>(view, m_dim, keys[v]);
+            break;
+        case Dimension::Type::Unsigned32:
+            extractKeys<uint32_t>(view, m_dim, keys[v]);
+            break;
+        case Dimension::Type::Unsigned64:
+            extractKeys<uint64_t>(view, m_dim, keys[v]);
+            break;
+        case Dimension::Type::Double:
+        default:
+            extractKeys<double>(view, m_dim, keys[v]);
+            break;
+        }
+
+        // An input that isn't sorted would leave the output unsorted.
+        auto less = [](const RadixPair& a, const RadixPair& b)
+            { return a.first < b.first; };
+        if (!std::is_sorted(keys[v].begin(), keys[v].end(), less))
+        {
+            log()->get(LogLevel::Warning) << getName() << ": Input " <<
+                (v + 1) << " isn't sorted by '" << m_dimName <<
+                "' and will be sorted first." << std::endl;
+            radixSort(keys[v]);
+        }
+    }
+
+    std::vector<size_t> pos(m_inViews.size(), 0);
+    auto greater = [&keys, &pos](size_t a, size_t b)
+    {
+        uint64_t ka = keys[a][pos[a]].first;
+        uint64_t kb = keys[b][pos[b]].first;
+        return ka > kb || (ka == kb && a > b);
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)>
+        heap(greater);
+    for (size_t v = 0; v < m_inViews.size(); ++v)
+        if (keys[v].size())
+            heap.push(v);
+
+    while (!heap.empty())
+    {
+        size_t v = heap.top();
+        heap.pop();
+        m_view->appendPoint(*m_inViews[v], keys[v][pos[v]].second);
+        if (++pos[v] < keys[v].size())
+            heap.push(v);
+    }
+}
+
 } // namespace pdal
 
@@ -45,28 +45,44 @@ namespace pdal
 class PDAL_DLL MergeFilter : public MultiFilter
 {
 public:
-    MergeFilter ()
+    MergeFilter () : m_dim(Dimension::Id::Unknown)
     {}
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    Options getDefaultOptions();
+    // Appending inputs in turn can be streamed.  Interleaving sorted
+    // inputs needs all of their points.
+    virtual bool streamable() const
+        { return m_dimName.empty(); }
 
 private:
     PointViewPtr m_view;
+    // Views to merge, in the order they were run.
+    std::vector<PointViewPtr> m_inViews;
+    // Dimension by which the points of views that are each sorted by it
+    // are interleaved, or Unknown to append the views in turn.
+    std::string m_dimName;
+    Dimension::Id::Enum m_dim;
 
-    virtual void ready(PointTableRef table)
-        { m_view.reset(new PointView(table)); }
+    virtual void processOptions(const Options& options);
+    virtual void ready(PointTableRef table);
 
+    // The views are only gathered here.  The merged view is filled once
+    // all have been seen, so that its index is built in a single pass.
     virtual PointViewSet run(PointViewPtr in)
     {
         PointViewSet viewSet;
 
-        m_view->append(*in.get());
+        m_inViews.push_back(in);
         viewSet.insert(m_view);
         return viewSet;
     }
 
+    virtual void done(PointTableRef table);
+    void mergeSorted();
+
     MergeFilter& operator=(const MergeFilter&); // not implemented
     MergeFilter(const MergeFilter&); // not implemented
 };
@@ -34,9 +34,17 @@
 
 #include "MortonOrderFilter.hpp"
 
-#include <iostream>
+#include <pdal/QuadIndex.hpp>
+#include <pdal/RadixSort.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <algorithm>
 #include <limits>
-#include <map>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 namespace pdal
 {
@@ -57,65 +65,148 @@ Options MortonOrderFilter::getDefaultOptions()
 }
 
 
-//This used to be a lambda, but the VS compiler exploded, I guess.
-typedef std::pair<double, double> Coord;
+void MortonOrderFilter::processOptions(const Options& options)
+{
+    std::string order =
+        options.getValueOrDefault<std::string>("order", "morton");
+    if (order == "morton")
+        m_order = Morton;
+    else if (order == "hilbert")
+        m_order = Hilbert;
+    else if (order == "lod")
+        m_order = Lod;
+    else
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Invalid 'order' value '" << order <<
+            "'.  Must be 'morton', 'hilbert' or 'lod'.";
+        throw pdal_error(oss.str());
+    }
+}
+
+
 namespace
 {
-bool less_msb(const int& x, const int& y)
+
+// Spread the bits of 'v' to the even bits of the result.
+inline uint64_t spread(uint32_t v)
 {
-    return x < y && x < (x ^ y);
-};
+#if defined(__BMI2__)
+    return _pdep_u64(v, 0x5555555555555555ULL);
+#else
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+#endif
+}
+
+} // unnamed namespace
 
-class CmpZOrder
+
+// X occupies the odd bits so that it's the more significant axis.
+uint64_t MortonOrderFilter::mortonKey(uint32_t x, uint32_t y)
 {
-public:
-    bool operator()(const Coord& c1, const Coord& c2) const
-    {
-        int a[2] = {(int)(c1.first * INT_MAX), (int)(c1.second * INT_MAX)};
-        int b[2] = {(int)(c2.first * INT_MAX), (int)(c2.second * INT_MAX)};
+    return (spread(x) << 1) | spread(y);
+}
 
-        int j = 0;
-        int x = 0;
 
-        for (int k = 0; k < 2; k++)
+// Distance along the Hilbert curve that fills the 2^32 x 2^32 grid.
+uint64_t MortonOrderFilter::hilbertKey(uint32_t x, uint32_t y)
+{
+    uint64_t d = 0;
+    for (uint32_t s = 1u << 31; s; s >>= 1)
+    {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += (uint64_t)s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant.
+        if (!ry)
         {
-            int y = a[k] ^ b[k];
-            if (less_msb(x, y))
+            if (rx)
             {
-                j = k;
-                x = y;
+                x = ~x;
+                y = ~y;
             }
+            std::swap(x, y);
         }
-        return (a[j] - b[j]) < 0;
-    };
-};
+    }
+    return d;
 }
 
+
 PointViewSet MortonOrderFilter::run(PointViewPtr inView)
 {
     PointViewSet viewSet;
     if (!inView->size())
         return viewSet;
-    CmpZOrder compare;
-    std::multimap<Coord, PointId, CmpZOrder> sorted(compare);
+    if (m_order == Lod)
+        return lodOrder(inView);
+
+    BOX3D const& bounds = inView->calculateBounds();
+    const double xrange = bounds.maxx - bounds.minx;
+    const double yrange = bounds.maxy - bounds.miny;
+    const double maxGrid = (std::numeric_limits<uint32_t>::max)();
+    const double xscale = xrange > 0 ? maxGrid / xrange : 0;
+    const double yscale = yrange > 0 ? maxGrid / yrange : 0;
+
+    // Quantize the points to a 32 bit grid over the bounds and compute
+    // the key of each.
+    const point_count_t batchSize = 4096;
+    std::vector<RadixPair> pairs(inView->size());
+    auto quantize = [&](size_t first, size_t last)
+    {
+        std::vector<double> xs(batchSize);
+        std::vector<double> ys(batchSize);
+        for (PointId begin = first; begin < last; begin += batchSize)
+        {
+            point_count_t count =
+                (std::min)(batchSize, (point_count_t)(last - begin));
+            inView->getFieldArray(Dimension::Id::X, begin, count, xs.data());
+            inView->getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+            for (PointId i = 0; i < count; ++i)
+            {
+                double fx = (xs[i] - bounds.minx) * xscale;
+                double fy = (ys[i] - bounds.miny) * yscale;
+                uint32_t x = (uint32_t)(std::min)((std::max)(fx, 0.0),
+                    maxGrid);
+                uint32_t y = (uint32_t)(std::min)((std::max)(fy, 0.0),
+                    maxGrid);
+                pairs[begin + i] = std::make_pair(m_order == Hilbert ?
+                    hilbertKey(x, y) : mortonKey(x, y), begin + i);
+            }
+        }
+    };
+    if (inView->table().threadSafe())
+        ThreadPool::shared().parallelFor(inView->size(), batchSize,
+            quantize);
+    else
+        quantize(0, inView->size());
+    radixSort(pairs);
 
-    BOX3D const& buffer_bounds = inView->calculateBounds();
-    double xrange = buffer_bounds.maxx - buffer_bounds.minx;
-    double yrange = buffer_bounds.maxy - buffer_bounds.miny;
+    inView->applyPermutation(pairs);
+    viewSet.insert(inView);
 
-    for (PointId idx = 0; idx < inView->size(); idx++)
-    {
-        double xpos = (inView->getFieldAs<double>(Dimension::Id::X, idx) - buffer_bounds.minx) / xrange;
-        double ypos = (inView->getFieldAs<double>(Dimension::Id::Y, idx) - buffer_bounds.miny) / yrange;
-        Coord loc(xpos, ypos);
-        sorted.insert(std::make_pair(loc, idx));
-    }
+    return viewSet;
+}
+
+
+// Order the points by level of a quadtree, so that any leading run of the
+// output covers the bounds of the data evenly.
+PointViewSet MortonOrderFilter::lodOrder(PointViewPtr inView)
+{
+    PointViewSet viewSet;
 
+    QuadIndex index(*inView);
     PointViewPtr outView = inView->makeNew();
-    std::multimap<Coord, PointId, CmpZOrder>::iterator pos;
-    for (pos = sorted.begin(); pos != sorted.end(); ++pos)
+    std::size_t cursor(0);
+    while (cursor <= index.getDepth())
     {
-        outView->appendPoint(*inView, pos->second);
+        for (PointId id : index.getNextLevels(cursor))
+            outView->appendPoint(*inView, id);
     }
     viewSet.insert(outView);
 
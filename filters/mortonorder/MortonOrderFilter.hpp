@@ -45,7 +45,7 @@ namespace pdal
 class PDAL_DLL MortonOrderFilter : public pdal::Filter
 {
 public:
-    MortonOrderFilter()
+    MortonOrderFilter() : m_order(Morton)
     {}
 
     static void * create();
@@ -54,9 +54,26 @@ public:
 
     Options getDefaultOptions();
 
+    // Position of a cell of the 2^32 x 2^32 grid along each curve, for
+    // code that keys points itself, such as the external sort of
+    // 'pdal sort'.
+    static uint64_t mortonKey(uint32_t x, uint32_t y);
+    static uint64_t hilbertKey(uint32_t x, uint32_t y);
+
 private:
-    virtual void processOptions(const Options& ) {};
+    virtual void processOptions(const Options& options);
     virtual PointViewSet run(PointViewPtr view);
+    PointViewSet lodOrder(PointViewPtr view);
+
+    enum Order
+    {
+        Morton,
+        Hilbert,
+        // Coarse-to-fine, by level of a QuadIndex.
+        Lod
+    };
+
+    Order m_order;
 
     MortonOrderFilter& operator=(const MortonOrderFilter&); // not implemented
     MortonOrderFilter(const MortonOrderFilter&); // not implemented
@@ -0,0 +1,308 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "NormalFilter.hpp"
+
+#include <pdal/GridIndex.hpp>
+#include <pdal/KDIndex.hpp>
+#include <pdal/PointView.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "filters.normal",
+    "Estimate the surface normal and curvature of each point from its "
+        "nearest neighbors.",
+    "http://pdal.io/stages/filters.normal.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, NormalFilter, Filter, s_info)
+
+std::string NormalFilter::getName() const { return s_info.name; }
+
+namespace
+{
+
+// Find the eigenvector of the smallest eigenvalue of the symmetric 3x3
+// matrix 'a' with the closed-form (trigonometric) solution of its
+// characteristic polynomial.  Returns the eigenvalue.
+double smallestEigen(double a[3][3], double v[3])
+{
+    // Scale the matrix so that the tests below don't depend on its size.
+    double scale = 0;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            scale = (std::max)(scale, std::fabs(a[i][j]));
+    v[0] = 0;
+    v[1] = 0;
+    v[2] = 1;
+    if (scale == 0)
+        return 0;
+    double m[3][3];
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            m[i][j] = a[i][j] / scale;
+
+    double q = (m[0][0] + m[1][1] + m[2][2]) / 3;
+    double p1 = m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+    double lambda;
+    if (p1 == 0)
+    {
+        // Diagonal, and the eigenvalues are the diagonal.
+        int axis = 0;
+        for (int i = 1; i < 3; ++i)
+            if (m[i][i] < m[axis][axis])
+                axis = i;
+        v[2] = 0;
+        v[axis] = 1;
+        return a[axis][axis];
+    }
+    double p2 = (m[0][0] - q) * (m[0][0] - q) + (m[1][1] - q) * (m[1][1] - q) +
+        (m[2][2] - q) * (m[2][2] - q) + 2 * p1;
+    double p = std::sqrt(p2 / 6);
+    double b[3][3];
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            b[i][j] = (m[i][j] - (i == j ? q : 0)) / p;
+    double r = (b[0][0] * (b[1][1] * b[2][2] - b[1][2] * b[2][1]) -
+        b[0][1] * (b[1][0] * b[2][2] - b[1][2] * b[2][0]) +
+        b[0][2] * (b[1][0] * b[2][1] - b[1][1] * b[2][0])) / 2;
+    r = (std::max)(-1.0, (std::min)(1.0, r));
+    double phi = std::acos(r) / 3;
+    lambda = q + 2 * p * std::cos(phi + 2 * M_PI / 3);
+
+    // The eigenvector is orthogonal to the rows of m - lambda * I, so it's
+    // the largest of the cross products of pairs of rows.
+    double rows[3][3];
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            rows[i][j] = m[i][j] - (i == j ? lambda : 0);
+    auto cross = [](const double *s, const double *t, double *out)
+    {
+        out[0] = s[1] * t[2] - s[2] * t[1];
+        out[1] = s[2] * t[0] - s[0] * t[2];
+        out[2] = s[0] * t[1] - s[1] * t[0];
+        return out[0] * out[0] + out[1] * out[1] + out[2] * out[2];
+    };
+    auto norm2 = [](const double *s)
+        { return s[0] * s[0] + s[1] * s[1] + s[2] * s[2]; };
+
+    const int pairs[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+    double best = 0;
+    for (auto& pr : pairs)
+    {
+        double c[3];
+        double len = cross(rows[pr[0]], rows[pr[1]], c);
+        if (len > best)
+        {
+            best = len;
+            std::copy(c, c + 3, v);
+        }
+    }
+    if (best < 1e-20)
+    {
+        // The two smallest eigenvalues are the same, so the rows are
+        // parallel and any vector orthogonal to them will do.  Cross the
+        // longest row with the axis it is least along.
+        int row = 0;
+        for (int i = 1; i < 3; ++i)
+            if (norm2(rows[i]) > norm2(rows[row]))
+                row = i;
+        if (norm2(rows[row]) < 1e-20)
+        {
+            // All the eigenvalues are the same.
+            v[0] = 0;
+            v[1] = 0;
+            v[2] = 1;
+            return lambda * scale;
+        }
+        int axis = 0;
+        for (int i = 1; i < 3; ++i)
+            if (std::fabs(rows[row][i]) < std::fabs(rows[row][axis]))
+                axis = i;
+        double e[3] = { 0, 0, 0 };
+        e[axis] = 1;
+        best = cross(rows[row], e, v);
+    }
+    double len = std::sqrt(best);
+    for (int i = 0; i < 3; ++i)
+        v[i] /= len;
+
+    // The Rayleigh quotient is more accurate than the root found above
+    // when the eigenvalue is near zero, as it is for flat surfaces.
+    double rayleigh = 0;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            rayleigh += v[i] * m[i][j] * v[j];
+    return (std::max)(0.0, rayleigh) * scale;
+}
+
+} // unnamed namespace
+
+
+void NormalFilter::processOptions(const Options& options)
+{
+    m_knn = options.getValueOrDefault<point_count_t>("knn", 8);
+    if (m_knn < 3)
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'knn' must be at least 3.";
+        throw pdal_error(oss.str());
+    }
+
+    std::string index =
+        options.getValueOrDefault<std::string>("index", "kdtree");
+    if (index == "kdtree")
+        m_gridIndex = false;
+    else if (index == "grid")
+        m_gridIndex = true;
+    else
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Invalid 'index' value '" << index <<
+            "'.  Must be 'kdtree' or 'grid'.";
+        throw pdal_error(oss.str());
+    }
+}
+
+
+void NormalFilter::addDimensions(PointLayoutPtr layout)
+{
+    using namespace Dimension;
+
+    layout->registerDim(Id::NormalX);
+    layout->registerDim(Id::NormalY);
+    layout->registerDim(Id::NormalZ);
+    layout->registerDim(Id::Curvature);
+}
+
+
+void NormalFilter::filter(PointView& view)
+{
+    if (view.empty())
+        return;
+
+    // The view's own KD index is kept for later stages.
+    GridIndex grid(view);
+    const KDIndex *index = NULL;
+    if (m_gridIndex)
+        grid.build();
+    else
+        index = &view.spatialIndex();
+    point_count_t k = (std::min)(m_knn, view.size());
+
+    auto estimate = [this, &view, index, &grid, k](PointId first,
+        PointId last)
+    {
+        using namespace Dimension;
+
+        // Neighbors are found a block of points at a time, into buffers
+        // that are reused for each block of the range.
+        const point_count_t blockSize = 256;
+        std::vector<double> xyz;
+        std::vector<PointId> ids;
+        std::vector<double> sqrDists;
+        std::vector<double> xs(k);
+        std::vector<double> ys(k);
+        std::vector<double> zs(k);
+        for (PointId begin = first; begin < last; begin += blockSize)
+        {
+            point_count_t count = (std::min)(blockSize, last - begin);
+            xyz.resize(count * 3);
+            for (PointId j = 0; j < count; ++j)
+            {
+                xyz[j * 3] = view.getFieldAs<double>(Id::X, begin + j);
+                xyz[j * 3 + 1] = view.getFieldAs<double>(Id::Y, begin + j);
+                xyz[j * 3 + 2] = view.getFieldAs<double>(Id::Z, begin + j);
+            }
+            ids.resize(count * k);
+            sqrDists.resize(count * k);
+            if (m_gridIndex)
+                grid.knnBatch(xyz.data(), count, k, ids.data(),
+                    sqrDists.data());
+            else
+                index->knnBatch(xyz.data(), count, k, ids.data(),
+                    sqrDists.data());
+
+            for (PointId b = 0; b < count; ++b)
+            {
+                PointId i = begin + b;
+                const PointId *nbrs = &ids[b * k];
+                double mean[3] = { 0, 0, 0 };
+                for (size_t j = 0; j < k; ++j)
+                {
+                    xs[j] = view.getFieldAs<double>(Id::X, nbrs[j]);
+                    ys[j] = view.getFieldAs<double>(Id::Y, nbrs[j]);
+                    zs[j] = view.getFieldAs<double>(Id::Z, nbrs[j]);
+                    mean[0] += xs[j];
+                    mean[1] += ys[j];
+                    mean[2] += zs[j];
+                }
+                for (double& m : mean)
+                    m /= k;
+
+                double cov[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+                for (size_t j = 0; j < k; ++j)
+                {
+                    double d[3] = { xs[j] - mean[0], ys[j] - mean[1],
+                        zs[j] - mean[2] };
+                    for (int r = 0; r < 3; ++r)
+                        for (int c = r; c < 3; ++c)
+                            cov[r][c] += d[r] * d[c];
+                }
+                for (int r = 0; r < 3; ++r)
+                    for (int c = 0; c < r; ++c)
+                        cov[r][c] = cov[c][r];
+
+                double normal[3];
+                double lambda = smallestEigen(cov, normal);
+                double trace = cov[0][0] + cov[1][1] + cov[2][2];
+                if (normal[2] < 0)
+                    for (double& v : normal)
+                        v = -v;
+                view.setField(Id::NormalX, i, normal[0]);
+                view.setField(Id::NormalY, i, normal[1]);
+                view.setField(Id::NormalZ, i, normal[2]);
+                view.setField(Id::Curvature, i, trace > 0 ? lambda / trace : 0);
+            }
+        }
+    };
+    parallelFilter(view, estimate);
+}
+
+} // namespace pdal
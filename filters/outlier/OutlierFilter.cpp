@@ -0,0 +1,337 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "OutlierFilter.hpp"
+
+#include <pdal/GridIndex.hpp>
+#include <pdal/KDIndex.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "filters.outlier",
+    "Mark the points that are far from their neighbors as outliers.",
+    "http://pdal.io/stages/filters.outlier.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, OutlierFilter, Filter, s_info)
+
+std::string OutlierFilter::getName() const { return s_info.name; }
+
+void OutlierFilter::processOptions(const Options& options)
+{
+    std::string mode =
+        options.getValueOrDefault<std::string>("mode", "statistical");
+    if (mode == "statistical")
+        m_method = Statistical;
+    else if (mode == "radius")
+        m_method = Radius;
+    else
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Invalid 'mode' value '" << mode <<
+            "'.  Must be 'statistical' or 'radius'.";
+        throw pdal_error(oss.str());
+    }
+
+    m_meanK = options.getValueOrDefault<point_count_t>("mean_k", 8);
+    m_multiplier = options.getValueOrDefault<double>("multiplier", 2.0);
+    m_radius = options.getValueOrDefault<double>("radius", 1.0);
+    m_minK = options.getValueOrDefault<point_count_t>("min_k", 2);
+    m_class = options.getValueOrDefault<int>("class", 7);
+    m_tileSize = options.getValueOrDefault<double>("tile_size", 0);
+    m_buffer = options.getValueOrDefault<double>("buffer",
+        m_method == Radius ? m_radius : m_tileSize / 10);
+
+    std::string index =
+        options.getValueOrDefault<std::string>("index", "kdtree");
+    if (index == "kdtree")
+        m_gridIndex = false;
+    else if (index == "grid")
+        m_gridIndex = true;
+    else
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Invalid 'index' value '" << index <<
+            "'.  Must be 'kdtree' or 'grid'.";
+        throw pdal_error(oss.str());
+    }
+    if ((m_method == Statistical && m_meanK == 0) ||
+        (m_method == Radius && !(m_radius > 0)))
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option '" <<
+            (m_method == Statistical ? "mean_k" : "radius") <<
+            "' must be greater than 0.";
+        throw pdal_error(oss.str());
+    }
+}
+
+
+void OutlierFilter::addDimensions(PointLayoutPtr layout)
+{
+    layout->registerDim(Dimension::Id::Classification);
+}
+
+
+// Score the points 'ids' of a view with the mean distance to their
+// nearest neighbors or with the number of points within the radius.  When
+// the view is only part of the input, a point that doesn't have enough
+// neighbors in it is infinitely far from them.
+void OutlierFilter::score(const PointView& view,
+    const std::vector<PointId>& ids, double *scores, bool partial) const
+{
+    // Radius queries always use the KD index, which is the view's own so
+    // that later stages can use it too.
+    const bool useGrid = m_gridIndex && m_method == Statistical;
+    GridIndex grid(view);
+    const KDIndex *index = NULL;
+    if (useGrid)
+        grid.build();
+    else
+        index = &view.spatialIndex();
+
+    // The point itself is among its nearest neighbors.
+    const point_count_t k = (std::min)(m_meanK + 1, view.size());
+
+    auto scoreRange = [this, &view, &ids, index, &grid, useGrid, scores,
+        partial, k](size_t first, size_t last)
+    {
+        using namespace Dimension;
+
+        // Points are looked up a block at a time into buffers that are
+        // reused for each block of the range.
+        const size_t blockSize = 256;
+        std::vector<double> xyz;
+        std::vector<PointId> neighbors;
+        std::vector<double> sqrDists;
+        for (size_t begin = first; begin < last; begin += blockSize)
+        {
+            size_t count = (std::min)(blockSize, last - begin);
+            xyz.resize(count * 3);
+            for (size_t j = 0; j < count; ++j)
+            {
+                PointId i = ids[begin + j];
+                xyz[j * 3] = view.getFieldAs<double>(Id::X, i);
+                xyz[j * 3 + 1] = view.getFieldAs<double>(Id::Y, i);
+                xyz[j * 3 + 2] = view.getFieldAs<double>(Id::Z, i);
+            }
+
+            if (m_method == Radius)
+            {
+                // KDIndex takes the square of the radius.
+                for (size_t j = 0; j < count; ++j)
+                    scores[begin + j] = (double)index->radius(xyz[j * 3],
+                        xyz[j * 3 + 1], xyz[j * 3 + 2],
+                        m_radius * m_radius).size();
+                continue;
+            }
+
+            neighbors.resize(count * k);
+            sqrDists.resize(count * k);
+            if (useGrid)
+                grid.knnBatch(xyz.data(), count, k, neighbors.data(),
+                    sqrDists.data());
+            else
+                index->knnBatch(xyz.data(), count, k, neighbors.data(),
+                    sqrDists.data());
+            for (size_t j = 0; j < count; ++j)
+            {
+                PointId i = ids[begin + j];
+                double sum = 0;
+                point_count_t found = 0;
+                for (point_count_t m = 0; m < k; ++m)
+                {
+                    if (neighbors[j * k + m] == i || found == k - 1)
+                        continue;
+                    sum += std::sqrt(sqrDists[j * k + m]);
+                    found++;
+                }
+                if (partial && found < m_meanK)
+                    scores[begin + j] =
+                        std::numeric_limits<double>::infinity();
+                else
+                    scores[begin + j] = found ? sum / found : 0;
+            }
+        }
+    };
+    ThreadPool::shared().parallelFor(ids.size(), 1024, scoreRange);
+}
+
+
+// Score points a tile at a time.  Each tile is indexed with the points
+// within the buffer of it, so that points near its edges find their
+// neighbors, and scores only the points inside it.
+void OutlierFilter::scoreTiles(PointView& view, std::vector<double>& scores)
+{
+    BOX3D bounds = view.calculateBounds();
+    size_t tileCols = (size_t)((bounds.maxx - bounds.minx) / m_tileSize) + 1;
+    size_t tileRows = (size_t)((bounds.maxy - bounds.miny) / m_tileSize) + 1;
+
+    // Tile column or row of a coordinate, clamped to the tiles.
+    auto tileIndex = [this](double v, double minv, size_t count) -> size_t
+    {
+        double t = std::floor((v - minv) / m_tileSize);
+        return (size_t)(std::max)(0.0, (std::min)(t, (double)count - 1));
+    };
+
+    std::vector<std::vector<PointId>> members(tileCols * tileRows);
+    std::vector<std::vector<PointId>> cores(tileCols * tileRows);
+    const point_count_t batchSize = 4096;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    for (PointId begin = 0; begin < view.size(); begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, view.size() - begin);
+        view.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+        view.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        for (PointId i = 0; i < count; ++i)
+        {
+            double x = xs[i];
+            double y = ys[i];
+            size_t c0 = tileIndex(x - m_buffer, bounds.minx, tileCols);
+            size_t c1 = tileIndex(x + m_buffer, bounds.minx, tileCols);
+            size_t r0 = tileIndex(y - m_buffer, bounds.miny, tileRows);
+            size_t r1 = tileIndex(y + m_buffer, bounds.miny, tileRows);
+            size_t core = tileIndex(y, bounds.miny, tileRows) * tileCols +
+                tileIndex(x, bounds.minx, tileCols);
+            for (size_t r = r0; r <= r1; ++r)
+                for (size_t c = c0; c <= c1; ++c)
+                {
+                    size_t t = r * tileCols + c;
+                    if (t == core)
+                        cores[t].push_back(members[t].size());
+                    members[t].push_back(begin + i);
+                }
+        }
+    }
+
+    // Views are made up front, as making them isn't thread-safe.  They
+    // share the points of the input rather than copying them.
+    std::vector<PointViewPtr> tiles(members.size());
+    for (size_t t = 0; t < members.size(); ++t)
+    {
+        if (cores[t].empty())
+            continue;
+        tiles[t] = view.makeNew();
+        for (PointId id : members[t])
+            tiles[t]->appendPoint(view, id);
+    }
+
+    auto scoreTile = [this, &tiles, &members, &cores, &scores](size_t first,
+        size_t last)
+    {
+        std::vector<double> tileScores;
+        for (size_t t = first; t < last; ++t)
+        {
+            if (!tiles[t])
+                continue;
+            tileScores.resize(cores[t].size());
+            score(*tiles[t], cores[t], tileScores.data(), true);
+            for (size_t i = 0; i < cores[t].size(); ++i)
+                scores[members[t][cores[t][i]]] = tileScores[i];
+            tiles[t].reset();
+        }
+    };
+    ThreadPool::shared().parallelFor(tiles.size(), 1, scoreTile);
+}
+
+
+void OutlierFilter::filter(PointView& view)
+{
+    if (view.empty())
+        return;
+
+    std::vector<double> scores(view.size());
+    if (m_tileSize > 0)
+        scoreTiles(view, scores);
+    else
+    {
+        std::vector<PointId> ids(view.size());
+        for (PointId i = 0; i < ids.size(); ++i)
+            ids[i] = i;
+        score(view, ids, scores.data(), false);
+    }
+
+    // In radius mode the points counted include the point itself.
+    double threshold = m_minK + 1;
+    if (m_method == Statistical)
+    {
+        double mean = 0;
+        point_count_t n = 0;
+        for (double s : scores)
+            if (std::isfinite(s))
+            {
+                mean += s;
+                n++;
+            }
+        if (n)
+            mean /= n;
+        double variance = 0;
+        for (double s : scores)
+            if (std::isfinite(s))
+                variance += (s - mean) * (s - mean);
+        if (n > 1)
+            variance /= (n - 1);
+        threshold = mean + m_multiplier * std::sqrt(variance);
+    }
+
+    std::vector<char> outlier(view.size());
+    point_count_t count = 0;
+    for (PointId i = 0; i < view.size(); ++i)
+    {
+        outlier[i] = m_method == Statistical ? scores[i] > threshold :
+            scores[i] < threshold;
+        count += outlier[i];
+    }
+    log()->get(LogLevel::Debug) << getName() << ": Marked " << count <<
+        " of " << view.size() << " points as outliers." << std::endl;
+
+    auto mark = [this, &view, &outlier](PointId first, PointId last)
+    {
+        for (PointId i = first; i < last; ++i)
+            if (outlier[i])
+                view.setField(Dimension::Id::Classification, i, m_class);
+    };
+    parallelFilter(view, mark);
+}
+
+} // namespace pdal
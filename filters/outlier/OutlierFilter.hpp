@@ -0,0 +1,95 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Filter.hpp>
+
+extern "C" int32_t OutlierFilter_ExitFunc();
+extern "C" PF_ExitFunc OutlierFilter_InitPlugin();
+
+namespace pdal
+{
+
+// Mark the points that are far from their neighbors with a classification.
+// In statistical mode a point is an outlier when its mean distance to its
+// nearest neighbors is well above the mean for all the points.  In radius
+// mode it is one when too few points are within a distance of it.
+class PDAL_DLL OutlierFilter : public Filter
+{
+public:
+    OutlierFilter() : Filter()
+        {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+    virtual bool viewParallel() const
+        { return true; }
+
+private:
+    enum Method
+    {
+        Statistical,
+        Radius
+    };
+
+    Method m_method;
+    // Number of neighbors that a point's mean distance is taken over.
+    point_count_t m_meanK;
+    // Standard deviations above the mean distance at which a point is an
+    // outlier.
+    double m_multiplier;
+    double m_radius;
+    // Least number of other points within the radius of a point that isn't
+    // an outlier.
+    point_count_t m_minK;
+    int m_class;
+    double m_tileSize;
+    double m_buffer;
+    // Find nearest neighbors with a GridIndex rather than a KDIndex.
+    bool m_gridIndex;
+
+    virtual void processOptions(const Options& options);
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void filter(PointView& view);
+    void score(const PointView& view, const std::vector<PointId>& ids,
+        double *scores, bool partial) const;
+    void scoreTiles(PointView& view, std::vector<double>& scores);
+
+    OutlierFilter& operator=(const OutlierFilter&); // not implemented
+    OutlierFilter(const OutlierFilter&); // not implemented
+};
+
+} // namespace pdal
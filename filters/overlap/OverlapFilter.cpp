@@ -0,0 +1,206 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "OverlapFilter.hpp"
+
+#include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "filters.overlap",
+    "Mark the points where flightlines overlap.",
+    "http://pdal.io/stages/filters.overlap.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, OverlapFilter, Filter, s_info)
+
+std::string OverlapFilter::getName() const { return s_info.name; }
+
+namespace
+{
+
+const point_count_t batchSize = 4096;
+
+// Least and greatest point source of the points in a cell.
+struct Sources
+{
+    Sources() : m_min(0xFFFF), m_max(0)
+        {}
+
+    uint16_t m_min;
+    uint16_t m_max;
+
+    void add(uint16_t source)
+    {
+        m_min = (std::min)(m_min, source);
+        m_max = (std::max)(m_max, source);
+    }
+
+    void merge(const Sources& other)
+    {
+        m_min = (std::min)(m_min, other.m_min);
+        m_max = (std::max)(m_max, other.m_max);
+    }
+};
+
+} // unnamed namespace
+
+
+void OverlapFilter::processOptions(const Options& options)
+{
+    m_resolution = options.getValueOrDefault<double>("resolution", 1.0);
+    m_class = options.getValueOrDefault<int>("class", 12);
+    if (!(m_resolution > 0))
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'resolution' must be greater than 0.";
+        throw pdal_error(oss.str());
+    }
+}
+
+
+void OverlapFilter::addDimensions(PointLayoutPtr layout)
+{
+    layout->registerDim(Dimension::Id::Classification);
+}
+
+
+void OverlapFilter::filter(PointView& view)
+{
+    using namespace Dimension;
+
+    if (view.empty())
+        return;
+    if (!view.hasDim(Id::PointSourceId))
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Points must have a PointSourceId to find "
+            "the overlap.";
+        throw pdal_error(oss.str());
+    }
+
+    BOX3D bounds = view.calculateBounds();
+    const size_t cols =
+        (size_t)((bounds.maxx - bounds.minx) / m_resolution) + 1;
+    const size_t rows =
+        (size_t)((bounds.maxy - bounds.miny) / m_resolution) + 1;
+    const size_t cells = cols * rows;
+    log()->get(LogLevel::Debug) << getName() << ": Grid is " << cols <<
+        " x " << rows << " cells." << std::endl;
+
+    auto cellOf = [&](double x, double y)
+    {
+        size_t col = (std::min)(cols - 1,
+            (size_t)((x - bounds.minx) / m_resolution));
+        size_t row = (std::min)(rows - 1,
+            (size_t)((y - bounds.miny) / m_resolution));
+        return row * cols + col;
+    };
+
+    const point_count_t count = view.size();
+    ThreadPool& pool = ThreadPool::shared();
+    // Points of a table that isn't threadSafe() are read as one chunk, as
+    // parallelFilter() does below.
+    const size_t chunks = !view.table().threadSafe() ? 1 :
+        (std::max)((size_t)1,
+            (std::min)(pool.size(), (size_t)(count / 65536)));
+    auto chunkBegin = [count, chunks](size_t c)
+        { return (PointId)((count * c) / chunks); };
+
+    // Each chunk of points fills a grid of its own, and the grids are
+    // merged into the first.
+    std::vector<std::vector<Sources>> grids(chunks);
+    pool.parallelFor(chunks, 1, [&](size_t first, size_t last)
+    {
+        std::vector<double> xs(batchSize);
+        std::vector<double> ys(batchSize);
+        std::vector<uint16_t> sources(batchSize);
+        for (size_t c = first; c < last; ++c)
+        {
+            std::vector<Sources>& grid = grids[c];
+            grid.resize(cells);
+            for (PointId begin = chunkBegin(c); begin < chunkBegin(c + 1);
+                begin += batchSize)
+            {
+                point_count_t n = (std::min)(batchSize,
+                    (point_count_t)(chunkBegin(c + 1) - begin));
+                view.getFieldArray(Id::X, begin, n, xs.data());
+                view.getFieldArray(Id::Y, begin, n, ys.data());
+                view.getFieldArray(Id::PointSourceId, begin, n,
+                    sources.data());
+                for (PointId i = 0; i < n; ++i)
+                    grid[cellOf(xs[i], ys[i])].add(sources[i]);
+            }
+        }
+    });
+    std::vector<Sources>& grid = grids[0];
+    pool.parallelFor(cells, 65536, [&](size_t first, size_t last)
+    {
+        for (size_t c = 1; c < chunks; ++c)
+            for (size_t cell = first; cell < last; ++cell)
+                grid[cell].merge(grids[c][cell]);
+    });
+    grids.resize(1);
+    size_t overlapCells = 0;
+    for (const Sources& s : grid)
+        if (s.m_min < s.m_max)
+            overlapCells++;
+    log()->get(LogLevel::Debug) << getName() << ": " << overlapCells <<
+        " cells have more than one source." << std::endl;
+
+    auto mark = [this, &view, &grid, &cellOf](PointId first, PointId last)
+    {
+        std::vector<double> xs(batchSize);
+        std::vector<double> ys(batchSize);
+        std::vector<uint16_t> sources(batchSize);
+        for (PointId begin = first; begin < last; begin += batchSize)
+        {
+            point_count_t n = (std::min)(batchSize, last - begin);
+            view.getFieldArray(Id::X, begin, n, xs.data());
+            view.getFieldArray(Id::Y, begin, n, ys.data());
+            view.getFieldArray(Id::PointSourceId, begin, n, sources.data());
+            for (PointId i = 0; i < n; ++i)
+                if (sources[i] != grid[cellOf(xs[i], ys[i])].m_min)
+                    view.setField(Id::Classification, begin + i, m_class);
+        }
+    };
+    parallelFilter(view, mark);
+}
+
+} // namespace pdal
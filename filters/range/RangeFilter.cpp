@@ -34,6 +34,7 @@
 
 #include "RangeFilter.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <map>
@@ -79,46 +80,230 @@ void RangeFilter::processOptions(const Options& options)
         Range range;
         range.min = min;
         range.max = max;
+        range.invert = dimensionOptions->getValueOrDefault<bool>("invert",
+            false);
 
-        m_name_map.insert(std::make_pair(name, range));
+        // Several ranges for one dimension are alternatives.
+        m_name_map[name].push_back(range);
     }
 }
 
 void RangeFilter::ready(PointTableRef table)
 {
     const PointLayoutPtr layout(table.layout());
+    m_clauses.clear();
     for (auto const& d : m_name_map)
     {
-        m_dimensions_map.insert(
-                std::make_pair(
-                    layout->findDim(d.first),
-                    d.second));
+        Clause clause;
+        clause.m_dim = layout->findDim(d.first);
+        if (clause.m_dim == Dimension::Id::Unknown)
+        {
+            std::ostringstream oss;
+            oss << getName() << ": Dimension '" << d.first <<
+                "' not found.";
+            throw pdal_error(oss.str());
+        }
+        clause.m_type = layout->dimType(clause.m_dim);
+        clause.m_ranges = d.second;
+
+        const Dimension::Detail *dd = layout->dimDetail(clause.m_dim);
+        if (dd->packed())
+            for (int v = 0; v <= dd->mask(); ++v)
+            {
+                char pass = 0;
+                for (const Range& r : clause.m_ranges)
+                    pass |= (char)((v >= r.min && v <= r.max) ^ r.invert);
+                clause.m_flags.push_back(pass);
+            }
+        m_clauses.push_back(clause);
+    }
+}
+
+
+namespace
+{
+
+// Bounds of a range converted to a dimension's type.  For integer types
+// the bounds are rounded inward, so comparisons need no conversion of the
+// values.
+template<typename T>
+struct TypedRange
+{
+    TypedRange(const Range& r) : m_invert(r.invert)
+    {
+        if (std::numeric_limits<T>::is_integer)
+        {
+            const double lowest = (double)(std::numeric_limits<T>::min)();
+            const double highest = (double)(std::numeric_limits<T>::max)();
+            double lo = std::ceil(r.min);
+            double hi = std::floor(r.max);
+            m_empty = lo > hi || lo > highest || hi < lowest;
+            m_min = lo <= lowest ? (std::numeric_limits<T>::min)() : (T)lo;
+            m_max = hi >= highest ? (std::numeric_limits<T>::max)() : (T)hi;
+        }
+        else
+        {
+            m_empty = r.min > r.max;
+            m_min = (T)r.min;
+            m_max = (T)r.max;
+        }
+    }
+
+    T m_min;
+    T m_max;
+    bool m_empty;
+    bool m_invert;
+};
+
+template<typename T>
+void evaluateClause(PointView& view, Dimension::Id::Enum dim,
+    const std::vector<Range>& ranges, PointId begin, point_count_t count,
+    char *keep, std::vector<char>& match)
+{
+    std::vector<T> vals(count);
+    view.getFieldArray(dim, begin, count, vals.data());
+
+    std::fill(match.begin(), match.begin() + count, 0);
+    for (const Range& range : ranges)
+    {
+        TypedRange<T> r(range);
+        const char inv = r.m_invert ? 1 : 0;
+        if (r.m_empty)
+        {
+            // Nothing is inside an empty range; everything is outside.
+            if (inv)
+                std::fill(match.begin(), match.begin() + count, 1);
+            continue;
+        }
+        const T lo = r.m_min;
+        const T hi = r.m_max;
+        for (PointId i = 0; i < count; ++i)
+            match[i] |= (char)((vals[i] >= lo && vals[i] <= hi) ^ inv);
+    }
+    for (PointId i = 0; i < count; ++i)
+        keep[i] &= match[i];
+}
+
+// Floats are promoted to double, exactly, and compared with the bounds
+// as given.
+template<>
+void evaluateClause<float>(PointView& view, Dimension::Id::Enum dim,
+    const std::vector<Range>& ranges, PointId begin, point_count_t count,
+    char *keep, std::vector<char>& match)
+{
+    std::vector<float> vals(count);
+    view.getFieldArray(dim, begin, count, vals.data());
+
+    std::fill(match.begin(), match.begin() + count, 0);
+    for (const Range& r : ranges)
+    {
+        const char inv = r.invert ? 1 : 0;
+        const double lo = r.min;
+        const double hi = r.max;
+        for (PointId i = 0; i < count; ++i)
+        {
+            double v = vals[i];
+            match[i] |= (char)((v >= lo && v <= hi) ^ inv);
+        }
+    }
+    for (PointId i = 0; i < count; ++i)
+        keep[i] &= match[i];
+}
+
+} // unnamed namespace
+
+
+// Evaluate the clauses for a block of points, one column at a time,
+// leaving 1 in 'keep' for points that pass.
+void RangeFilter::evaluate(PointView& view, PointId begin,
+    point_count_t count, char *keep) const
+{
+    std::fill(keep, keep + count, 1);
+    std::vector<char> match(count);
+    for (const Clause& c : m_clauses)
+    {
+        // Packed values are tested without unpacking them.
+        if (c.m_flags.size())
+        {
+            view.matchPacked(c.m_dim, begin, count, c.m_flags.data(),
+                match.data());
+            for (PointId i = 0; i < count; ++i)
+                keep[i] &= match[i];
+            continue;
+        }
+
+        switch (c.m_type)
+        {
+        case Dimension::Type::Float:
+            evaluateClause<float>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        case Dimension::Type::Signed8:
+            evaluateClause<int8_t>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        case Dimension::Type::Signed16:
+            evaluateClause<int16_t>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        case Dimension::Type::Signed32:
+            evaluateClause<int32_t>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        case Dimension::Type::Signed64:
+            evaluateClause<int64_t>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        case Dimension::Type::Unsigned8:
+            evaluateClause<uint8_t>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        case Dimension::Type::Unsigned16:
+            evaluateClause<uint16_t>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        case Dimension::Type::Unsigned32:
+            evaluateClause<uint32_t>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        case Dimension::Type::Unsigned64:
+            evaluateClause<uint64_t>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        case Dimension::Type::Double:
+        default:
+            evaluateClause<double>(view, c.m_dim, c.m_ranges, begin, count,
+                keep, match);
+            break;
+        }
     }
 }
 
+
 PointViewSet RangeFilter::run(PointViewPtr inView)
 {
     PointViewSet viewSet;
     if (!inView->size())
         return viewSet;
 
-    PointViewPtr outView = inView->makeNew();
-
-    for (PointId i = 0; i < inView->size(); ++i)
+    // Test the points in parallel, then append the survivors in order.
+    std::vector<char> keep(inView->size());
+    auto test = [this, &inView, &keep](PointId first, PointId last)
     {
-        bool keep_point = true;
-        for (auto const& d : m_dimensions_map)
+        const point_count_t batchSize = 4096;
+        for (PointId begin = first; begin < last; begin += batchSize)
         {
-            double v = inView->getFieldAs<double>(d.first, i);
-            if (v < d.second.min || v > d.second.max)
-            {
-                keep_point = false;
-                break;
-            }
+            point_count_t count =
+                (std::min)(batchSize, (point_count_t)(last - begin));
+            evaluate(*inView, begin, count, keep.data() + begin);
         }
-        if (keep_point)
+    };
+    parallelFilter(*inView, test);
+
+    PointViewPtr outView = inView->makeNew();
+    for (PointId i = 0; i < inView->size(); ++i)
+        if (keep[i])
             outView->appendPoint(*inView, i);
-    }
 
     viewSet.insert(outView);
 
@@ -126,4 +311,3 @@ PointViewSet RangeFilter::run(PointViewPtr inView)
 }
 
 } // pdal
-
@@ -39,6 +39,7 @@
 #include <memory>
 #include <map>
 #include <string>
+#include <vector>
 
 extern "C" int32_t RangeFilter_ExitFunc();
 extern "C" PF_ExitFunc RangeFilter_InitPlugin();
@@ -52,6 +53,8 @@ struct Range
 {
     double min;
     double max;
+    // Pass points outside the range rather than inside it.
+    bool invert;
 };
 
 class PDAL_DLL RangeFilter : public pdal::Filter
@@ -63,15 +66,34 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool viewParallel() const
+        { return true; }
 
 private:
-    std::map<std::string, Range> m_name_map;
-    std::map<Dimension::Id::Enum, Range> m_dimensions_map;
+    // The ranges of a dimension.  A point passes a clause if it passes any
+    // of its ranges, and passes the filter if it passes every clause.
+    struct Clause
+    {
+        Dimension::Id::Enum m_dim;
+        Dimension::Type::Enum m_type;
+        std::vector<Range> m_ranges;
+        // For packed dimensions, whether each value the dimension can hold
+        // passes.
+        std::vector<char> m_flags;
+    };
+
+    std::map<std::string, std::vector<Range>> m_name_map;
+    std::vector<Clause> m_clauses;
 
     virtual void processOptions(const Options&options);
     virtual void ready(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
 
+    void evaluate(PointView& view, PointId begin, point_count_t count,
+        char *keep) const;
+
     RangeFilter& operator=(const RangeFilter&); // not implemented
     RangeFilter(const RangeFilter&); // not implemented
 };
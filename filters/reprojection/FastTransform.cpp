@@ -0,0 +1,282 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "FastTransform.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pdal
+{
+
+namespace
+{
+
+const double c_degToRad = M_PI / 180.0;
+const double c_radToDeg = 180.0 / M_PI;
+
+} // unnamed namespace
+
+FastTransform::FastTransform(const System& from, const System& to)
+{
+    setup(m_from, from);
+    setup(m_to, to);
+}
+
+
+void FastTransform::setup(Projection& proj, const System& sys)
+{
+    proj.m_sys = sys;
+
+    double f = sys.m_invFlattening ? 1.0 / sys.m_invFlattening : 0.0;
+    proj.m_e2 = f * (2.0 - f);
+    proj.m_e = std::sqrt(proj.m_e2);
+
+    double n = f / (2.0 - f);
+    double n2 = n * n;
+    double n3 = n2 * n;
+    double n4 = n3 * n;
+    proj.m_n = n;
+    proj.m_kA = sys.m_scale * sys.m_a / (1.0 + n) *
+        (1.0 + n2 / 4.0 + n4 / 64.0);
+
+    proj.m_alpha[0] = n / 2.0 - 2.0 * n2 / 3.0 + 5.0 * n3 / 16.0 +
+        41.0 * n4 / 180.0;
+    proj.m_alpha[1] = 13.0 * n2 / 48.0 - 3.0 * n3 / 5.0 +
+        557.0 * n4 / 1440.0;
+    proj.m_alpha[2] = 61.0 * n3 / 240.0 - 103.0 * n4 / 140.0;
+    proj.m_alpha[3] = 49561.0 * n4 / 161280.0;
+
+    proj.m_beta[0] = n / 2.0 - 2.0 * n2 / 3.0 + 37.0 * n3 / 96.0 -
+        n4 / 360.0;
+    proj.m_beta[1] = n2 / 48.0 + n3 / 15.0 - 437.0 * n4 / 1440.0;
+    proj.m_beta[2] = 17.0 * n3 / 480.0 - 37.0 * n4 / 840.0;
+    proj.m_beta[3] = 4397.0 * n4 / 161280.0;
+
+    // The northing of the latitude of origin on the central meridian is
+    // subtracted from the series result.
+    proj.m_northOrigin = 0.0;
+    if (sys.m_kind == TransverseMercator && sys.m_latOrigin != 0.0)
+    {
+        double taup = conformal(proj,
+            std::tan(sys.m_latOrigin * c_degToRad));
+        double xi = std::atan(taup);
+        double sum = xi;
+        for (int j = 0; j < 4; ++j)
+            sum += proj.m_alpha[j] * std::sin(2 * (j + 1) * xi);
+        proj.m_northOrigin = proj.m_kA * sum;
+    }
+}
+
+
+// Tangent of the conformal latitude from the tangent of the geodetic
+// latitude.
+double FastTransform::conformal(const Projection& proj, double tau) const
+{
+    double tau1 = std::sqrt(1.0 + tau * tau);
+    double sig = std::sinh(proj.m_e * std::atanh(proj.m_e * tau / tau1));
+    return tau * std::sqrt(1.0 + sig * sig) - sig * tau1;
+}
+
+
+// Invert conformal() with Newton's method.  Two or three iterations
+// suffice for terrestrial latitudes.
+double FastTransform::geodetic(const Projection& proj, double taup) const
+{
+    const double e2m = 1.0 - proj.m_e2;
+    double tau = taup / e2m;
+    for (int i = 0; i < 5; ++i)
+    {
+        double taupa = conformal(proj, tau);
+        double dtau = (taup - taupa) * (1.0 + e2m * tau * tau) /
+            (e2m * std::sqrt(1.0 + tau * tau) * std::sqrt(1.0 + taupa * taupa));
+        tau += dtau;
+        if (std::fabs(dtau) < 1e-14 * (std::max)(1.0, std::fabs(tau)))
+            break;
+    }
+    return tau;
+}
+
+
+void FastTransform::toGeographic(const Projection& proj, double& x,
+    double& y, double& z) const
+{
+    const System& sys = proj.m_sys;
+    switch (sys.m_kind)
+    {
+    case Geographic:
+        break;
+    case WebMercator:
+        x = x / sys.m_a * c_radToDeg;
+        y = (2.0 * std::atan(std::exp(y / sys.m_a)) - M_PI / 2.0) *
+            c_radToDeg;
+        break;
+    case TransverseMercator:
+    {
+        double eta = (x - sys.m_falseEasting) / proj.m_kA;
+        double xi = (y - sys.m_falseNorthing + proj.m_northOrigin) /
+            proj.m_kA;
+        double xip = xi;
+        double etap = eta;
+        for (int j = 0; j < 4; ++j)
+        {
+            double k = 2.0 * (j + 1);
+            xip -= proj.m_beta[j] * std::sin(k * xi) * std::cosh(k * eta);
+            etap -= proj.m_beta[j] * std::cos(k * xi) * std::sinh(k * eta);
+        }
+        double sinhEtap = std::sinh(etap);
+        double cosXip = std::cos(xip);
+        double taup = std::sin(xip) /
+            std::sqrt(sinhEtap * sinhEtap + cosXip * cosXip);
+        y = std::atan(geodetic(proj, taup)) * c_radToDeg;
+        x = sys.m_centralMeridian +
+            std::atan2(sinhEtap, cosXip) * c_radToDeg;
+        break;
+    }
+    case Geocentric:
+    {
+        // Heikkinen's closed form.
+        const double a = sys.m_a;
+        const double e2 = proj.m_e2;
+        const double b = a * std::sqrt(1.0 - e2);
+        const double a2 = a * a;
+        const double b2 = b * b;
+        double p = std::sqrt(x * x + y * y);
+        double lon = std::atan2(y, x);
+        double lat;
+        double h;
+        if (p < 1e-9)
+        {
+            lat = z < 0 ? -M_PI / 2.0 : M_PI / 2.0;
+            h = std::fabs(z) - b;
+        }
+        else
+        {
+            double z2 = z * z;
+            double F = 54.0 * b2 * z2;
+            double G = p * p + (1.0 - e2) * z2 - e2 * (a2 - b2);
+            double c = e2 * e2 * F * p * p / (G * G * G);
+            double s = std::cbrt(1.0 + c + std::sqrt(c * c + 2.0 * c));
+            double k = s + 1.0 + 1.0 / s;
+            double P = F / (3.0 * k * k * G * G);
+            double Q = std::sqrt(1.0 + 2.0 * e2 * e2 * P);
+            double r0 = -P * e2 * p / (1.0 + Q) +
+                std::sqrt(a2 / 2.0 * (1.0 + 1.0 / Q) -
+                P * (1.0 - e2) * z2 / (Q * (1.0 + Q)) - P * p * p / 2.0);
+            double t = p - e2 * r0;
+            double U = std::sqrt(t * t + z2);
+            double V = std::sqrt(t * t + (1.0 - e2) * z2);
+            double z0 = b2 * z / (a * V);
+            h = U * (1.0 - b2 / (a * V));
+            lat = std::atan2(z + (a2 - b2) / b2 * z0, p);
+        }
+        x = lon * c_radToDeg;
+        y = lat * c_radToDeg;
+        z = h;
+        break;
+    }
+    }
+}
+
+
+void FastTransform::fromGeographic(const Projection& proj, double& x,
+    double& y, double& z) const
+{
+    const System& sys = proj.m_sys;
+    switch (sys.m_kind)
+    {
+    case Geographic:
+        break;
+    case WebMercator:
+        x = sys.m_a * x * c_degToRad;
+        y = sys.m_a * std::log(std::tan(M_PI / 4.0 + y * c_degToRad / 2.0));
+        break;
+    case TransverseMercator:
+    {
+        double lam = (x - sys.m_centralMeridian) * c_degToRad;
+        double taup = conformal(proj, std::tan(y * c_degToRad));
+        double cosLam = std::cos(lam);
+        double xip = std::atan2(taup, cosLam);
+        double etap = std::asinh(std::sin(lam) /
+            std::sqrt(taup * taup + cosLam * cosLam));
+        double xi = xip;
+        double eta = etap;
+        for (int j = 0; j < 4; ++j)
+        {
+            double k = 2.0 * (j + 1);
+            xi += proj.m_alpha[j] * std::sin(k * xip) * std::cosh(k * etap);
+            eta += proj.m_alpha[j] * std::cos(k * xip) * std::sinh(k * etap);
+        }
+        x = sys.m_falseEasting + proj.m_kA * eta;
+        y = sys.m_falseNorthing + proj.m_kA * xi - proj.m_northOrigin;
+        break;
+    }
+    case Geocentric:
+    {
+        double lon = x * c_degToRad;
+        double lat = y * c_degToRad;
+        double sinLat = std::sin(lat);
+        double cosLat = std::cos(lat);
+        double n = sys.m_a / std::sqrt(1.0 - proj.m_e2 * sinLat * sinLat);
+        x = (n + z) * cosLat * std::cos(lon);
+        y = (n + z) * cosLat * std::sin(lon);
+        z = (n * (1.0 - proj.m_e2) + z) * sinLat;
+        break;
+    }
+    }
+}
+
+
+void FastTransform::transform(point_count_t count, double *x, double *y,
+    double *z) const
+{
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        toGeographic(m_from, x[i], y[i], z[i]);
+        fromGeographic(m_to, x[i], y[i], z[i]);
+    }
+}
+
+
+bool FastTransform::agrees(double x, double y, double z, double refX,
+    double refY, double refZ) const
+{
+    const double tolerance =
+        (m_to.m_sys.m_kind == Geographic) ? 1e-8 : 1e-3;
+    return std::fabs(x - refX) <= tolerance &&
+        std::fabs(y - refY) <= tolerance &&
+        std::fabs(z - refZ) <= 1e-3;
+}
+
+} // namespace pdal
@@ -0,0 +1,116 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+// Transforms between geographic, transverse mercator, web mercator and
+// geocentric coordinates that share a datum, without GDAL.  Geographic
+// coordinates are longitude/latitude in degrees and heights are above the
+// ellipsoid.  Transverse mercator uses the Kruger series to fourth order,
+// which is good to well under a millimeter within a UTM zone.
+class PDAL_DLL FastTransform
+{
+public:
+    enum Kind
+    {
+        Geographic,
+        TransverseMercator,
+        WebMercator,
+        Geocentric
+    };
+
+    struct System
+    {
+        System() : m_kind(Geographic), m_a(6378137.0),
+            m_invFlattening(298.257223563), m_centralMeridian(0.0),
+            m_latOrigin(0.0), m_scale(1.0), m_falseEasting(0.0),
+            m_falseNorthing(0.0)
+        {}
+
+        Kind m_kind;
+        // Semi-major axis and inverse flattening of the ellipsoid.  Web
+        // mercator is projected from a sphere of radius m_a.
+        double m_a;
+        double m_invFlattening;
+        // Projection parameters, in degrees and meters.
+        double m_centralMeridian;
+        double m_latOrigin;
+        double m_scale;
+        double m_falseEasting;
+        double m_falseNorthing;
+    };
+
+    FastTransform(const System& from, const System& to);
+
+    // Transform 'count' points in place.
+    void transform(point_count_t count, double *x, double *y,
+        double *z) const;
+    // Whether a transformed point is within a millimeter (or its angular
+    // equivalent) of a reference point.
+    bool agrees(double x, double y, double z, double refX, double refY,
+        double refZ) const;
+
+private:
+    struct Projection
+    {
+        System m_sys;
+        double m_e2;
+        double m_e;
+        double m_n;
+        // Rectifying radius scaled by the scale factor.
+        double m_kA;
+        // Northing of the origin latitude.
+        double m_northOrigin;
+        double m_alpha[4];
+        double m_beta[4];
+    };
+
+    void setup(Projection& proj, const System& sys);
+    void toGeographic(const Projection& proj, double& x, double& y,
+        double& z) const;
+    void fromGeographic(const Projection& proj, double& x, double& y,
+        double& z) const;
+    double conformal(const Projection& proj, double tau) const;
+    double geodetic(const Projection& proj, double taup) const;
+
+    Projection m_from;
+    Projection m_to;
+};
+
+} // namespace pdal
@@ -34,12 +34,17 @@
 
 #include "ReprojectionFilter.hpp"
 
-#include <pdal/PointView.hpp>
+#include <pdal/GDALUtils.hpp>
 #include <pdal/GlobalEnvironment.hpp>
+#include <pdal/PointView.hpp>
 
 #include <gdal.h>
 #include <ogr_spatialref.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
 #include <memory>
 
 namespace pdal
@@ -54,35 +59,6 @@ CREATE_STATIC_PLUGIN(1, 0, ReprojectionFilter, Filter, s_info)
 
 std::string ReprojectionFilter::getName() const { return s_info.name; }
 
-struct OGRSpatialReferenceDeleter
-{
-    template <typename T>
-    void operator()(T* ptr)
-    {
-        ::OSRDestroySpatialReference(ptr);
-    }
-};
-
-struct OSRTransformDeleter
-{
-    template <typename T>
-    void operator()(T* ptr)
-    {
-        ::OCTDestroyCoordinateTransformation(ptr);
-    }
-};
-
-
-struct GDALSourceDeleter
-{
-    template <typename T>
-    void operator()(T* ptr)
-    {
-        ::GDALClose(ptr);
-    }
-};
-
-
 void ReprojectionFilter::processOptions(const Options& options)
 {
     try
@@ -121,6 +97,13 @@ void ReprojectionFilter::processOptions(const Options& options)
         }
         m_inferInputSRS = false;
     }
+    m_fast = options.getValueOrDefault<bool>("fast", false);
+    if (options.hasOption("matrix"))
+    {
+        m_matrix = transformationMatrixFromString(
+            options.getValueOrThrow<std::string>("matrix"));
+        m_hasMatrix = true;
+    }
 }
 
 void ReprojectionFilter::initialize()
@@ -130,6 +113,7 @@ void ReprojectionFilter::initialize()
 
 void ReprojectionFilter::ready(PointTableRef table)
 {
+    m_fastFailed = false;
     if (m_inferInputSRS)
     {
         m_inSRS = table.spatialRef();
@@ -138,15 +122,17 @@ void ReprojectionFilter::ready(PointTableRef table)
                 "is specified with the 'in_srs' option.");
     }
 
-    m_in_ref_ptr = ReferencePtr(OSRNewSpatialReference(0),
-        OGRSpatialReferenceDeleter());
-    m_out_ref_ptr = ReferencePtr(OSRNewSpatialReference(0),
-        OGRSpatialReferenceDeleter());
-
-    int result =
-        OSRSetFromUserInput(m_in_ref_ptr.get(),
-            m_inSRS.getWKT(pdal::SpatialReference::eCompoundOK).c_str());
-    if (result != OGRERR_NONE)
+    // References and transforms come from the process-wide cache, so a
+    // pipeline run against many files in the same system parses the
+    // references once.
+    gdal::SrsCache& cache = gdal::SrsCache::get();
+    m_inWkt = m_inSRS.getWKT(pdal::SpatialReference::eCompoundOK);
+    m_outWkt = m_outSRS.getWKT(pdal::SpatialReference::eCompoundOK);
+    try
+    {
+        m_in_ref_ptr = cache.reference(m_inWkt);
+    }
+    catch (pdal_error&)
     {
         std::ostringstream msg;
         msg << "Invalid input spatial reference '" << m_inSRS.getWKT() <<
@@ -155,9 +141,11 @@ void ReprojectionFilter::ready(PointTableRef table)
         throw pdal_error(msg.str());
     }
 
-    result = OSRSetFromUserInput(m_out_ref_ptr.get(),
-        m_outSRS.getWKT(pdal::SpatialReference::eCompoundOK).c_str());
-    if (result != OGRERR_NONE)
+    try
+    {
+        m_out_ref_ptr = cache.reference(m_outWkt);
+    }
+    catch (pdal_error&)
     {
         std::ostringstream msg;
         msg << "Invalid output spatial reference '" << m_outSRS.getWKT() <<
@@ -165,24 +153,110 @@ void ReprojectionFilter::ready(PointTableRef table)
             "option.";
         throw pdal_error(msg.str());
     }
-    m_transform_ptr = TransformPtr(
-        OCTNewCoordinateTransformation(m_in_ref_ptr.get(),
-            m_out_ref_ptr.get()), OSRTransformDeleter());
+    // Make sure a transform can be made before any points are seen.
+    giveTransform(takeTransform());
+    m_fastTransform.reset();
+    if (m_fast)
+        createFastTransform();
+
+    setSpatialReference(m_outSRS);
+}
+
+
+namespace
+{
+
+// Describe a reference as a FastTransform system.  Returns false if the
+// reference is something FastTransform doesn't handle.
+bool describe(OGRSpatialReferenceH ref, FastTransform::System& sys)
+{
+    if (OSRIsCompound(ref) || OSRIsLocal(ref))
+        return false;
+
+    OGRErr err;
+    sys.m_a = OSRGetSemiMajor(ref, &err);
+    if (err != OGRERR_NONE)
+        return false;
+    sys.m_invFlattening = OSRGetInvFlattening(ref, &err);
+    if (err != OGRERR_NONE)
+        return false;
+    const char *primem = OSRGetAttrValue(ref, "PRIMEM", 1);
+    if (primem && std::atof(primem) != 0.0)
+        return false;
+
+    if (OSRIsGeocentric(ref))
+    {
+        sys.m_kind = FastTransform::Geocentric;
+        return OSRGetLinearUnits(ref, NULL) == 1.0;
+    }
+    if (OSRIsGeographic(ref))
+    {
+        sys.m_kind = FastTransform::Geographic;
+        double units = OSRGetAngularUnits(ref, NULL);
+        return std::fabs(units - M_PI / 180.0) < 1e-12;
+    }
+    if (!OSRIsProjected(ref) || OSRGetLinearUnits(ref, NULL) != 1.0)
+        return false;
 
-    if (!m_transform_ptr.get())
+    const char *projection = OSRGetAttrValue(ref, "PROJECTION", 0);
+    if (!projection)
+        return false;
+    std::string proj(projection);
+    if (proj == SRS_PT_TRANSVERSE_MERCATOR)
     {
-        std::string msg = "Could not construct CoordinateTransformation in "
-            "ReprojectionFilter:: ";
-        throw std::runtime_error(msg);
+        sys.m_kind = FastTransform::TransverseMercator;
+        sys.m_centralMeridian =
+            OSRGetProjParm(ref, SRS_PP_CENTRAL_MERIDIAN, 0.0, NULL);
+        sys.m_latOrigin =
+            OSRGetProjParm(ref, SRS_PP_LATITUDE_OF_ORIGIN, 0.0, NULL);
+        sys.m_scale = OSRGetProjParm(ref, SRS_PP_SCALE_FACTOR, 1.0, NULL);
+        sys.m_falseEasting =
+            OSRGetProjParm(ref, SRS_PP_FALSE_EASTING, 0.0, NULL);
+        sys.m_falseNorthing =
+            OSRGetProjParm(ref, SRS_PP_FALSE_NORTHING, 0.0, NULL);
+        return true;
     }
 
-    setSpatialReference(m_outSRS);
+    // Web mercator is written as a mercator on the WGS84 ellipsoid, so
+    // it's recognized by its code.
+    const char *code = OSRGetAuthorityCode(ref, NULL);
+    if (code && (std::string(code) == "3857" ||
+        std::string(code) == "900913"))
+    {
+        sys.m_kind = FastTransform::WebMercator;
+        return OSRGetProjParm(ref, SRS_PP_CENTRAL_MERIDIAN, 0.0, NULL) ==
+                0.0 &&
+            OSRGetProjParm(ref, SRS_PP_FALSE_EASTING, 0.0, NULL) == 0.0 &&
+            OSRGetProjParm(ref, SRS_PP_FALSE_NORTHING, 0.0, NULL) == 0.0;
+    }
+    return false;
+}
+
+} // unnamed namespace
+
+
+void ReprojectionFilter::createFastTransform()
+{
+    FastTransform::System from;
+    FastTransform::System to;
+
+    if (!describe(m_in_ref_ptr.get(), from) ||
+        !describe(m_out_ref_ptr.get(), to) ||
+        !OSRIsSameGeogCS(m_in_ref_ptr.get(), m_out_ref_ptr.get()) ||
+        from.m_a != to.m_a || from.m_invFlattening != to.m_invFlattening)
+    {
+        log()->get(LogLevel::Debug) << getName() << ": fast transform "
+            "not available for these references.  Using GDAL." << std::endl;
+        return;
+    }
+    m_fastTransform.reset(new FastTransform(from, to));
 }
 
 
-void ReprojectionFilter::transform(double& x, double& y, double& z)
+void ReprojectionFilter::transform(void *transform, double& x, double& y,
+    double& z)
 {
-    int ret = OCTTransform(m_transform_ptr.get(), 1, &x, &y, &z);
+    int ret = OCTTransform(transform, 1, &x, &y, &z);
     if (ret == 0)
     {
         std::ostringstream msg;
@@ -193,19 +267,113 @@ void ReprojectionFilter::transform(double& x, double& y, double& z)
 }
 
 
-void ReprojectionFilter::filter(PointView& view)
+// Transform a batch of points at once.  Should any point fail, GDAL may have
+// failed the lot, so those points are tried again one at a time from their
+// original values.
+void ReprojectionFilter::gdalTransform(void *transform, PointView& view,
+    PointId begin, point_count_t count, double *xs, double *ys, double *zs,
+    int *success)
 {
-    for (PointId id = 0; id < view.size(); ++id)
+    std::fill(success, success + count, 0);
+    OCTTransformEx(transform, (int)count, xs, ys, zs, success);
+    for (PointId i = 0; i < count; ++i)
+        if (!success[i])
+        {
+            xs[i] = view.getFieldAs<double>(Dimension::Id::X, begin + i);
+            ys[i] = view.getFieldAs<double>(Dimension::Id::Y, begin + i);
+            zs[i] = view.getFieldAs<double>(Dimension::Id::Z, begin + i);
+            this->transform(transform, xs[i], ys[i], zs[i]);
+        }
+}
+
+
+// A coordinate transformation can't be shared between threads, so a range
+// takes one that nothing else is using from the cache, which makes one if
+// there are none.
+ReprojectionFilter::TransformPtr ReprojectionFilter::takeTransform()
+{
+    try
     {
-        double x = view.getFieldAs<double>(Dimension::Id::X, id);
-        double y = view.getFieldAs<double>(Dimension::Id::Y, id);
-        double z = view.getFieldAs<double>(Dimension::Id::Z, id);
+        return gdal::SrsCache::get().takeTransform(m_inWkt, m_outWkt);
+    }
+    catch (pdal_error&)
+    {
+        throw pdal_error("Could not construct CoordinateTransformation in "
+            "ReprojectionFilter:: ");
+    }
+}
+
+
+void ReprojectionFilter::giveTransform(TransformPtr transform)
+{
+    gdal::SrsCache::get().giveTransform(m_inWkt, m_outWkt, transform);
+}
 
-        transform(x, y, z);
 
-        view.setField(Dimension::Id::X, id, x);
-        view.setField(Dimension::Id::Y, id, y);
-        view.setField(Dimension::Id::Z, id, z);
+void ReprojectionFilter::filterRange(PointView& view, PointId first,
+    PointId last)
+{
+    TransformPtr transformPtr = takeTransform();
+
+    const point_count_t batchSize = 4096;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    std::vector<double> zs(batchSize);
+    std::vector<int> success(batchSize);
+
+    for (PointId begin = first; begin < last; begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, last - begin);
+        view.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+        view.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        view.getFieldArray(Dimension::Id::Z, begin, count, zs.data());
+
+        // The fast transform is checked against GDAL with the first
+        // point of each batch.  If they disagree, GDAL is used from
+        // then on.
+        if (m_fastTransform && !m_fastFailed)
+        {
+            double x = xs[0];
+            double y = ys[0];
+            double z = zs[0];
+            transform(transformPtr.get(), x, y, z);
+            m_fastTransform->transform(count, xs.data(), ys.data(),
+                zs.data());
+            if (!m_fastTransform->agrees(xs[0], ys[0], zs[0], x, y, z))
+            {
+                m_fastFailed = true;
+                view.getFieldArray(Dimension::Id::X, begin, count,
+                    xs.data());
+                view.getFieldArray(Dimension::Id::Y, begin, count,
+                    ys.data());
+                view.getFieldArray(Dimension::Id::Z, begin, count,
+                    zs.data());
+                gdalTransform(transformPtr.get(), view, begin, count,
+                    xs.data(), ys.data(), zs.data(), success.data());
+            }
+        }
+        else
+            gdalTransform(transformPtr.get(), view, begin, count,
+                xs.data(), ys.data(), zs.data(), success.data());
+
+        if (m_hasMatrix)
+            transformPoints(m_matrix, count, xs.data(), ys.data(),
+                zs.data());
+        view.setFieldArray(Dimension::Id::X, begin, count, xs.data());
+        view.setFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        view.setFieldArray(Dimension::Id::Z, begin, count, zs.data());
+    }
+    giveTransform(transformPtr);
+}
+
+
+void ReprojectionFilter::done(PointTableRef /*table*/)
+{
+    if (m_fastFailed)
+    {
+        log()->get(LogLevel::Warning) << getName() << ": fast transform "
+            "disagrees with GDAL.  Using GDAL." << std::endl;
+        m_fastTransform.reset();
     }
 }
 
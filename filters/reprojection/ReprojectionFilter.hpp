@@ -36,7 +36,13 @@
 
 #include <pdal/Filter.hpp>
 
+#include <atomic>
 #include <memory>
+#include <vector>
+
+#include <transformation/TransformationFilter.hpp>
+
+#include "FastTransform.hpp"
 
 extern "C" int32_t ReprojectionFilter_ExitFunc();
 extern "C" PF_ExitFunc ReprojectionFilter_InitPlugin();
@@ -52,31 +58,55 @@ namespace gdal
 class PDAL_DLL ReprojectionFilter : public Filter
 {
 public:
-    ReprojectionFilter() : m_inferInputSRS(true)
+    ReprojectionFilter() : m_inferInputSRS(true), m_fast(false),
+        m_fastFailed(false), m_hasMatrix(false)
     {}
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool pointwise() const
+        { return true; }
 
 private:
     virtual void processOptions(const Options& options);
     virtual void ready(PointTableRef table);
     virtual void initialize();
-    virtual void filter(PointView& view);
+    virtual void filterRange(PointView& view, PointId first, PointId last);
+    virtual void done(PointTableRef table);
+
+    typedef std::shared_ptr<void> ReferencePtr;
+    typedef std::shared_ptr<void> TransformPtr;
 
     void updateBounds();
-    void transform(double& x, double& y, double& z);
+    TransformPtr takeTransform();
+    void giveTransform(TransformPtr transform);
+    void transform(void *transform, double& x, double& y, double& z);
+    void gdalTransform(void *transform, PointView& view, PointId begin,
+        point_count_t count, double *xs, double *ys, double *zs,
+        int *success);
+    void createFastTransform();
 
     SpatialReference m_inSRS;
     SpatialReference m_outSRS;
     bool m_inferInputSRS;
 
-    typedef std::shared_ptr<void> ReferencePtr;
-    typedef std::shared_ptr<void> TransformPtr;
+    // The references' WKT, by which the transforms are cached.
+    std::string m_inWkt;
+    std::string m_outWkt;
     ReferencePtr m_in_ref_ptr;
     ReferencePtr m_out_ref_ptr;
-    TransformPtr m_transform_ptr;
+    // Use FastTransform instead of GDAL when the references allow it.
+    bool m_fast;
+    std::unique_ptr<FastTransform> m_fastTransform;
+    // Set once the fast transform disagrees with GDAL.
+    std::atomic<bool> m_fastFailed;
+    // Matrix applied to the reprojected points, saving a separate pass
+    // through filters.transformation.
+    bool m_hasMatrix;
+    TransformationMatrix m_matrix;
 
     ReprojectionFilter& operator=(const ReprojectionFilter&); // not implemented
     ReprojectionFilter(const ReprojectionFilter&); // not implemented
@@ -34,6 +34,13 @@
 
 #include "SortFilter.hpp"
 
+#include <pdal/ThreadPool.hpp>
+#include <pdal/Utils.hpp>
+
+#include <cstdio>
+#include <memory>
+#include <queue>
+
 namespace pdal
 {
 
@@ -46,5 +53,284 @@ CREATE_STATIC_PLUGIN(1, 0, SortFilter, Filter, s_info)
 
 std::string SortFilter::getName() const { return s_info.name; }
 
+
+void SortFilter::processOptions(const Options& options)
+{
+    // Dimensions may be given as a list or as several options.
+    for (const Option& opt : options.getOptions("dimension"))
+        for (std::string name :
+            Utils::split2(opt.getValue<std::string>(), ','))
+        {
+            Utils::trim(name);
+            if (name.size())
+                m_dimNames.push_back(name);
+        }
+    if (m_dimNames.empty())
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'dimension' must be specified.";
+        throw pdal_error(oss.str());
+    }
+    m_maxMemory = options.getValueOrDefault<size_t>("max_memory", 0) *
+        1024 * 1024;
+}
+
+
+void SortFilter::ready(PointTableRef table)
+{
+    m_dims.clear();
+    for (const std::string& name : m_dimNames)
+    {
+        Dimension::Id::Enum dim = table.layout()->findDim(name);
+        if (dim == Dimension::Id::Unknown)
+        {
+            log()->get(LogLevel::Warning) << getName() << ": Dimension '" <<
+                name << "' not found.  Points won't be sorted." << std::endl;
+            m_dims.clear();
+            return;
+        }
+        m_dims.push_back(dim);
+    }
+}
+
+
+namespace
+{
+
+template<typename T>
+void extract(PointView& view, Dimension::Id::Enum dim, PointId begin,
+    point_count_t count, std::vector<uint64_t>& keys)
+{
+    const point_count_t batchSize = 4096;
+    auto fill = [&](size_t first, size_t last)
+    {
+        std::vector<T> vals(batchSize);
+        for (PointId b = first; b < last; b += batchSize)
+        {
+            point_count_t n =
+                (std::min)(batchSize, (point_count_t)(last - b));
+            view.getFieldArray(dim, begin + b, n, vals.data());
+            for (PointId i = 0; i < n; ++i)
+                keys[b + i] = radixKey(vals[i]);
+        }
+    };
+    if (view.table().threadSafe())
+        ThreadPool::shared().parallelFor(count, batchSize, fill);
+    else
+        fill(0, count);
+}
+
+// Reads the records of a sorted run back from its file.
+class RunReader
+{
+public:
+    RunReader(std::FILE *f, size_t recordSize) : m_file(f, std::fclose),
+        m_recordSize(recordSize), m_buf(recordSize * 4096), m_pos(0),
+        m_len(0)
+    {}
+
+    // Advance to the next record.  Returns false at the end of the run.
+    bool next()
+    {
+        m_pos += m_recordSize;
+        if (m_pos < m_len)
+            return true;
+        size_t n = std::fread(m_buf.data(), sizeof(uint64_t), m_buf.size(),
+            m_file.get());
+        m_len = n - (n % m_recordSize);
+        m_pos = 0;
+        return m_len > 0;
+    }
+
+    const uint64_t *record() const
+        { return m_buf.data() + m_pos; }
+
+private:
+    std::unique_ptr<std::FILE, int (*)(std::FILE *)> m_file;
+    size_t m_recordSize;
+    std::vector<uint64_t> m_buf;
+    size_t m_pos;
+    size_t m_len;
+};
+
+} // unnamed namespace
+
+
+void SortFilter::filter(PointView& view)
+{
+    if (m_dims.empty() || view.size() < 2)
+        return;
+
+    // The sort uses a key and two radix pairs per point in memory.
+    const size_t bytesPerPoint = m_dims.size() * 8 + 2 * sizeof(RadixPair);
+    if (m_maxMemory && view.size() * bytesPerPoint > m_maxMemory)
+    {
+        point_count_t runSize =
+            (std::max)((size_t)1, m_maxMemory / bytesPerPoint);
+        log()->get(LogLevel::Debug) << getName() << ": Sorting " <<
+            view.size() << " points in runs of " << runSize << "." <<
+            std::endl;
+        view.applyPermutation(externalSort(view, runSize));
+    }
+    else
+    {
+        std::vector<std::vector<uint64_t>> keys;
+        extractKeys(view, 0, view.size(), keys);
+        std::vector<RadixPair> pairs;
+        sortRun(keys, 0, pairs);
+        view.applyPermutation(pairs);
+    }
+}
+
+
+// Extract the keys of 'count' points starting at 'begin' for each sort
+// dimension.
+void SortFilter::extractKeys(PointView& view, PointId begin,
+    point_count_t count, std::vector<std::vector<uint64_t>>& keys)
+{
+    keys.resize(m_dims.size());
+    for (size_t k = 0; k < m_dims.size(); ++k)
+    {
+        Dimension::Id::Enum dim = m_dims[k];
+        std::vector<uint64_t>& kk = keys[k];
+        kk.resize(count);
+
+        // Resolve the dimension's type once rather than for each point.
+        switch (view.layout()->dimType(dim))
+        {
+        case Dimension::Type::Float:
+            extract<float>(view, dim, begin, count, kk);
+            break;
+        case Dimension::Type::Signed8:
+            extract<int8_t>(view, dim, begin, count, kk);
+            break;
+        case Dimension::Type::Signed16:
+            extract<int16_t>(view, dim, begin, count, kk);
+            break;
+        case Dimension::Type::Signed32:
+            extract<int32_t>(view, dim, begin, count, kk);
+            break;
+        case Dimension::Type::Signed64:
+            extract<int64_t>(view, dim, begin, count, kk);
+            break;
+        case Dimension::Type::Unsigned8:
+            extract<uint8_t>(view, dim, begin, count, kk);
+            break;
+        case Dimension::Type::Unsigned16:
+            extract<uint16_t>(view, dim, begin, count, kk);
+            break;
+        case Dimension::Type::Unsigned32:
+            extract<uint32_t>(view, dim, begin, count, kk);
+            break;
+        case Dimension::Type::Unsigned64:
+            extract<uint64_t>(view, dim, begin, count, kk);
+            break;
+        case Dimension::Type::Double:
+        default:
+            extract<double>(view, dim, begin, count, kk);
+            break;
+        }
+    }
+}
+
+
+// Sort the points with the given keys, whose IDs start at 'begin'.  The
+// radix sort is stable, so sorting by the least significant dimension
+// first and the most significant last orders the points by all of them.
+void SortFilter::sortRun(const std::vector<std::vector<uint64_t>>& keys,
+    PointId begin, std::vector<RadixPair>& pairs)
+{
+    const point_count_t count = keys[0].size();
+    pairs.resize(count);
+    for (PointId i = 0; i < count; ++i)
+        pairs[i].second = i;
+
+    for (size_t k = keys.size(); k--;)
+    {
+        const std::vector<uint64_t>& kk = keys[k];
+        for (RadixPair& p : pairs)
+            p.first = kk[p.second];
+        radixSort(pairs);
+    }
+    for (RadixPair& p : pairs)
+        p.second += begin;
+}
+
+
+// Sort runs of points that fit in the memory limit and write each to a
+// temporary file as records of the keys followed by the point ID.  The
+// runs are then merged.  Ties are broken by point ID, which keeps the
+// sort stable.
+std::vector<PointId> SortFilter::externalSort(PointView& view,
+    point_count_t runSize)
+{
+    const size_t recordSize = m_dims.size() + 1;
+    std::vector<std::unique_ptr<RunReader>> runs;
+
+    std::vector<std::vector<uint64_t>> keys;
+    std::vector<RadixPair> pairs;
+    std::vector<uint64_t> records;
+    for (PointId begin = 0; begin < view.size(); begin += runSize)
+    {
+        point_count_t count =
+            (std::min)(runSize, (point_count_t)(view.size() - begin));
+        extractKeys(view, begin, count, keys);
+        sortRun(keys, begin, pairs);
+
+        std::FILE *f = std::tmpfile();
+        if (!f)
+            throw pdal_error(getName() + ": Unable to create temporary "
+                "file for sort.");
+        runs.emplace_back(new RunReader(f, recordSize));
+
+        records.clear();
+        for (const RadixPair& p : pairs)
+        {
+            for (size_t k = 0; k < keys.size(); ++k)
+                records.push_back(keys[k][p.second - begin]);
+            records.push_back(p.second);
+        }
+        if (std::fwrite(records.data(), sizeof(uint64_t), records.size(),
+            f) != records.size() || std::fflush(f) != 0)
+            throw pdal_error(getName() + ": Unable to write temporary "
+                "file for sort.");
+        std::rewind(f);
+    }
+    keys.clear();
+    pairs.clear();
+    records.clear();
+    records.shrink_to_fit();
+
+    // Merge the runs, taking the smallest of the runs' next records each
+    // time.
+    auto greater = [&runs, recordSize](size_t a, size_t b)
+    {
+        const uint64_t *ra = runs[a]->record();
+        const uint64_t *rb = runs[b]->record();
+        return std::lexicographical_compare(rb, rb + recordSize,
+            ra, ra + recordSize);
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)>
+        heap(greater);
+    for (size_t r = 0; r < runs.size(); ++r)
+        if (runs[r]->next())
+            heap.push(r);
+
+    std::vector<PointId> order;
+    order.reserve(view.size());
+    while (!heap.empty())
+    {
+        size_t r = heap.top();
+        heap.pop();
+        order.push_back(runs[r]->record()[recordSize - 1]);
+        if (runs[r]->next())
+            heap.push(r);
+    }
+    if (order.size() != view.size())
+        throw pdal_error(getName() + ": Unable to read temporary file "
+            "for sort.");
+    return order;
+}
+
 } // namespace pdal
 
@@ -35,7 +35,7 @@
 #pragma once
 
 #include <pdal/Filter.hpp>
-#include <pdal/PointViewIter.hpp>
+#include <pdal/RadixSort.hpp>
 
 extern "C" int32_t SortFilter_ExitFunc();
 extern "C" PF_ExitFunc SortFilter_InitPlugin();
@@ -46,7 +46,7 @@ namespace pdal
 class PDAL_DLL SortFilter : public Filter
 {
 public:
-    SortFilter()
+    SortFilter() : m_maxMemory(0)
     {}
 
     static void * create();
@@ -54,27 +54,24 @@ public:
     std::string getName() const;
 
 private:
-    // Dimension on which to sort.
-    Dimension::Id::Enum m_dim;
-    // Dimension name.
-    std::string m_dimName;
+    // Dimensions on which to sort, most significant first.
+    std::vector<Dimension::Id::Enum> m_dims;
+    // Dimension names.
+    std::vector<std::string> m_dimNames;
+    // Memory the sort may use beyond the point data, in bytes.  Zero means
+    // no limit.
+    size_t m_maxMemory;
 
-    virtual void processOptions(const Options& options)
-        { m_dimName = options.getValueOrThrow<std::string>("dimension"); }
+    virtual void processOptions(const Options& options);
+    virtual void ready(PointTableRef table);
+    virtual void filter(PointView& view);
 
-    virtual void ready(PointTableRef table)
-        { m_dim = table.layout()->findDim(m_dimName); }
-
-    virtual void filter(PointView& view)
-    {
-        if (m_dim == Dimension::Id::Unknown)
-            return;
-
-        auto cmp = [this](const PointRef& p1, const PointRef& p2)
-            { return p1.compare(m_dim, p2); };
-
-        std::sort(view.begin(), view.end(), cmp);
-    }
+    void extractKeys(PointView& view, PointId begin, point_count_t count,
+        std::vector<std::vector<uint64_t>>& keys);
+    void sortRun(const std::vector<std::vector<uint64_t>>& keys,
+        PointId begin, std::vector<RadixPair>& pairs);
+    std::vector<PointId> externalSort(PointView& view,
+        point_count_t runSize);
 
     SortFilter& operator=(const SortFilter&); // not implemented
     SortFilter(const SortFilter&); // not implemented
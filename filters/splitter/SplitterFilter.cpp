@@ -35,9 +35,12 @@
 #include "SplitterFilter.hpp"
 
 #include <pdal/pdal_macros.hpp>
+#include <pdal/ThreadPool.hpp>
 
-#include <iostream>
-#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
 
 namespace pdal
 {
@@ -54,6 +57,16 @@ std::string SplitterFilter::getName() const { return s_info.name; }
 void SplitterFilter::processOptions(const Options& options)
 {
     m_length = options.getValueOrDefault<uint32_t>("length", 1000);
+    if (m_length == 0)
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'length' must be greater than 0.";
+        throw pdal_error(oss.str());
+    }
+    m_hasOrigin = options.hasOption("origin_x") ||
+        options.hasOption("origin_y");
+    m_xOrigin = options.getValueOrDefault<double>("origin_x", 0.0);
+    m_yOrigin = options.getValueOrDefault<double>("origin_y", 0.0);
 }
 
 
@@ -67,58 +80,151 @@ Options SplitterFilter::getDefaultOptions()
 }
 
 
-//This used to be a lambda, but the VS compiler exploded, I guess.
-typedef std::pair<int, int> Coord;
-namespace
-{
-class CoordCompare
-{
-public:
-    bool operator () (const Coord& c1, const Coord& c2) const
-    {
-        return c1.first < c2.first ? true :
-            c1.first > c2.first ? false :
-            c1.second < c2.second ? true :
-            false;
-    };
-};
-}
-
 PointViewSet SplitterFilter::run(PointViewPtr inView)
 {
     PointViewSet viewSet;
     if (!inView->size())
         return viewSet;
 
-    CoordCompare compare;
-    std::map<Coord, PointViewPtr, CoordCompare> viewMap(compare);
+    const point_count_t count = inView->size();
+    ThreadPool& pool = ThreadPool::shared();
+    const size_t chunks = (std::max)((size_t)1,
+        (std::min)(pool.size(), (size_t)(count / 65536)));
+    auto chunkBegin = [count, chunks](size_t c)
+        { return (PointId)((count * c) / chunks); };
+
+    // Without a given origin, the first point is the origin and cells are
+    // numbered by truncation, as they always have been.  A given origin
+    // aligns the grid so that cells line up across runs.
+    double xOrigin = m_xOrigin;
+    double yOrigin = m_yOrigin;
+    if (!m_hasOrigin)
+    {
+        xOrigin = inView->getFieldAs<double>(Dimension::Id::X, 0);
+        yOrigin = inView->getFieldAs<double>(Dimension::Id::Y, 0);
+    }
 
-    // Use the location of the first point as the origin.
-    double xOrigin = inView->getFieldAs<double>(Dimension::Id::X, 0);
-    double yOrigin = inView->getFieldAs<double>(Dimension::Id::Y, 0);
+    // Overlay a grid of squares on the points (m_length sides).  Each chunk
+    // of points numbers the squares as it finds them and counts the points
+    // in each.
+    struct Chunk
+    {
+        std::unordered_map<uint64_t, uint32_t> m_cells;
+        std::vector<uint64_t> m_keys;
+        std::vector<uint32_t> m_remap;
+        std::vector<PointId> m_offsets;
+    };
+    std::vector<Chunk> chunkInfo(chunks);
+    std::vector<uint32_t> cells(count);
 
-    // Overlay a grid of squares on the points (m_length sides).  Each square
-    // corresponds to a new point buffer.  Place the points falling in the
-    // each square in the corresponding point buffer.
-    for (PointId idx = 0; idx < inView->size(); idx++)
+    auto number = [&](size_t first, size_t last)
+    {
+        const point_count_t batchSize = 4096;
+        std::vector<double> xs(batchSize);
+        std::vector<double> ys(batchSize);
+        for (size_t c = first; c < last; ++c)
+        {
+            Chunk& chunk = chunkInfo[c];
+            std::vector<PointId> counts;
+            for (PointId begin = chunkBegin(c); begin < chunkBegin(c + 1);
+                begin += batchSize)
+            {
+                point_count_t n = (std::min)(batchSize,
+                    (point_count_t)(chunkBegin(c + 1) - begin));
+                inView->getFieldArray(Dimension::Id::X, begin, n, xs.data());
+                inView->getFieldArray(Dimension::Id::Y, begin, n, ys.data());
+                for (PointId i = 0; i < n; ++i)
+                {
+                    double fx = (xs[i] - xOrigin) / m_length;
+                    double fy = (ys[i] - yOrigin) / m_length;
+                    if (m_hasOrigin)
+                    {
+                        fx = std::floor(fx);
+                        fy = std::floor(fy);
+                    }
+                    uint64_t key = ((uint64_t)(uint32_t)(int32_t)fx << 32) |
+                        (uint32_t)(int32_t)fy;
+                    auto ci = chunk.m_cells.find(key);
+                    if (ci == chunk.m_cells.end())
+                    {
+                        ci = chunk.m_cells.insert(
+                            std::make_pair(key, (uint32_t)counts.size())).first;
+                        chunk.m_keys.push_back(key);
+                        counts.push_back(0);
+                    }
+                    cells[begin + i] = ci->second;
+                    counts[ci->second]++;
+                }
+            }
+            chunk.m_offsets.swap(counts);
+        }
+    };
+    // The chunks are read on one thread when the table isn't threadSafe().
+    if (inView->table().threadSafe())
+        pool.parallelFor(chunks, 1, number);
+    else
+        number(0, chunks);
+
+    // Number the squares across all chunks in the order they're first
+    // found and total their points.
+    std::unordered_map<uint64_t, uint32_t> cellMap;
+    std::vector<PointId> starts;
+    for (Chunk& chunk : chunkInfo)
     {
-        int xpos = (inView->getFieldAs<double>(Dimension::Id::X, idx) - xOrigin) /
-            m_length;
-        int ypos = (inView->getFieldAs<double>(Dimension::Id::Y, idx) - yOrigin) /
-            m_length;
-        Coord loc(xpos, ypos);
-        PointViewPtr& outView = viewMap[loc];
-        if (!outView)
+        chunk.m_remap.resize(chunk.m_keys.size());
+        for (size_t local = 0; local < chunk.m_keys.size(); ++local)
         {
-            outView = inView->makeNew();
+            auto ci = cellMap.find(chunk.m_keys[local]);
+            if (ci == cellMap.end())
+            {
+                ci = cellMap.insert(std::make_pair(chunk.m_keys[local],
+                    (uint32_t)starts.size())).first;
+                starts.push_back(0);
+            }
+            chunk.m_remap[local] = ci->second;
+            starts[ci->second] += chunk.m_offsets[local];
         }
-        outView->appendPoint(*inView.get(), idx);
     }
 
-    // Pull the buffers out of the map and stick them in the standard
-    // output set, setting the bounds as we go.
-    for (auto bi = viewMap.begin(); bi != viewMap.end(); ++bi)
-        viewSet.insert(bi->second);
+    // Lay the points out grouped by square in a single view.  Within a
+    // square, each chunk's points follow those of the chunks before it.
+    std::vector<PointId> sizes(starts);
+    PointId start = 0;
+    for (size_t cell = 0; cell < starts.size(); ++cell)
+    {
+        PointId n = starts[cell];
+        starts[cell] = start;
+        start += n;
+    }
+    std::vector<PointId> next(starts);
+    for (Chunk& chunk : chunkInfo)
+        for (size_t local = 0; local < chunk.m_keys.size(); ++local)
+        {
+            PointId& pos = next[chunk.m_remap[local]];
+            PointId n = chunk.m_offsets[local];
+            chunk.m_offsets[local] = pos;
+            pos += n;
+        }
+
+    std::vector<PointId> order(count);
+    pool.parallelFor(chunks, 1, [&](size_t first, size_t last)
+    {
+        for (size_t c = first; c < last; ++c)
+        {
+            std::vector<PointId>& offsets = chunkInfo[c].m_offsets;
+            for (PointId idx = chunkBegin(c); idx < chunkBegin(c + 1); ++idx)
+                order[offsets[cells[idx]]++] = idx;
+        }
+    });
+
+    PointViewPtr grouped = inView->makeSubset(0, count);
+    grouped->applyPermutation(order);
+
+    // Each square's points are a range of the grouped view, so the output
+    // views share its index rather than copying it.
+    for (size_t cell = 0; cell < starts.size(); ++cell)
+        viewSet.insert(grouped->makeSubset(starts[cell],
+            starts[cell] + sizes[cell]));
     return viewSet;
 }
 
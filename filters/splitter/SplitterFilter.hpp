@@ -45,7 +45,8 @@ namespace pdal
 class PDAL_DLL SplitterFilter : public pdal::Filter
 {
 public:
-    SplitterFilter() : Filter()
+    SplitterFilter() : Filter(), m_length(1000), m_hasOrigin(false),
+        m_xOrigin(0.0), m_yOrigin(0.0)
         {}
 
     static void * create();
@@ -56,6 +57,11 @@ public:
 
 private:
     uint32_t m_length;
+    // Whether the grid's origin was given.  Otherwise the first point is
+    // the origin.
+    bool m_hasOrigin;
+    double m_xOrigin;
+    double m_yOrigin;
 
     virtual void processOptions(const Options& options);
     virtual PointViewSet run(PointViewPtr view);
@@ -35,8 +35,12 @@
 #include "StatsFilter.hpp"
 
 #include <pdal/pdal_export.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/Utils.hpp>
 
+#include <algorithm>
+#include <sstream>
+
 namespace pdal
 {
 
@@ -52,6 +56,239 @@ std::string StatsFilter::getName() const { return s_info.name; }
 namespace stats
 {
 
+void Quantiles::reset()
+{
+    m_count = 0;
+    m_size = 0;
+    m_maxSize = 0;
+    m_levels.clear();
+}
+
+
+// Levels hold fewer values the further they are below the top level.
+size_t Quantiles::capacity(size_t level) const
+{
+    size_t depth = m_levels.size() - 1 - level;
+    return (std::max)((size_t)2,
+        (size_t)std::ceil(m_k * std::pow(2.0 / 3.0, (double)depth)));
+}
+
+
+void Quantiles::insert(double value)
+{
+    if (m_levels.empty())
+    {
+        m_levels.emplace_back();
+        m_maxSize = capacity(0);
+    }
+    m_levels[0].push_back(value);
+    m_size++;
+    m_count++;
+    if (m_size >= m_maxSize)
+        compress();
+}
+
+
+void Quantiles::merge(const Quantiles& other)
+{
+    if (other.m_levels.size() > m_levels.size())
+        m_levels.resize(other.m_levels.size());
+    for (size_t level = 0; level < other.m_levels.size(); ++level)
+        m_levels[level].insert(m_levels[level].end(),
+            other.m_levels[level].begin(), other.m_levels[level].end());
+    m_count += other.m_count;
+    m_size += other.m_size;
+    m_maxSize = 0;
+    for (size_t level = 0; level < m_levels.size(); ++level)
+        m_maxSize += capacity(level);
+    if (m_size >= m_maxSize)
+        compress();
+}
+
+
+// Compact the lowest full level until the sketch is within its size.
+void Quantiles::compress()
+{
+    while (m_size >= m_maxSize)
+    {
+        for (size_t level = 0; level < m_levels.size(); ++level)
+            if (m_levels[level].size() >= capacity(level))
+            {
+                compact(level);
+                break;
+            }
+        m_maxSize = 0;
+        for (size_t level = 0; level < m_levels.size(); ++level)
+            m_maxSize += capacity(level);
+    }
+}
+
+
+// Move every other value of a level, in order, to the level above.  Whether
+// the odd or even values move is chosen at random so that the errors of
+// successive compactions cancel out on average.  Each value that moves
+// stands for two, so the total weight is unchanged.
+void Quantiles::compact(size_t level)
+{
+    if (level + 1 == m_levels.size())
+        m_levels.emplace_back();
+    std::vector<double>& values = m_levels[level];
+    std::vector<double>& up = m_levels[level + 1];
+
+    std::sort(values.begin(), values.end());
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 7;
+    m_random ^= m_random << 17;
+
+    // With an odd number of values, the largest stays behind.
+    size_t pairs = values.size() / 2;
+    for (size_t i = m_random & 1; i < pairs * 2; i += 2)
+        up.push_back(values[i]);
+    values.erase(values.begin(), values.begin() + pairs * 2);
+    m_size -= pairs;
+}
+
+
+double Quantiles::quantile(double q) const
+{
+    if (!m_count)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    std::vector<std::pair<double, point_count_t>> weighted;
+    weighted.reserve(m_size);
+    for (size_t level = 0; level < m_levels.size(); ++level)
+        for (double v : m_levels[level])
+            weighted.push_back(std::make_pair(v, (point_count_t)1 << level));
+    std::sort(weighted.begin(), weighted.end());
+
+    double rank = (std::max)(0.0, (std::min)(1.0, q)) * m_count;
+    point_count_t total = 0;
+    for (auto& w : weighted)
+    {
+        total += w.second;
+        if (total >= rank)
+            return w.first;
+    }
+    return weighted.back().first;
+}
+
+
+void Histogram::reset()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_underflow = 0;
+    m_overflow = 0;
+}
+
+
+void Histogram::merge(const Histogram& other)
+{
+    if (other.m_counts.size() != m_counts.size())
+        throw pdal_error("Can't merge histograms with different bins.");
+    for (size_t i = 0; i < m_counts.size(); ++i)
+        m_counts[i] += other.m_counts[i];
+    m_underflow += other.m_underflow;
+    m_overflow += other.m_overflow;
+}
+
+
+void Histogram::extractMetadata(MetadataNode& m) const
+{
+    std::ostringstream counts;
+    for (size_t i = 0; i < m_counts.size(); ++i)
+        counts << (i ? " " : "") << m_counts[i];
+
+    MetadataNode h = m.add("histogram");
+    h.add("minimum", m_min, "minimum");
+    h.add("maximum", m_max, "maximum");
+    h.add("bins", (uint32_t)m_counts.size(), "bins");
+    h.add("counts", counts.str(), "counts");
+    h.add("underflow", m_underflow, "count of values below the minimum");
+    h.add("overflow", m_overflow, "count of values above the maximum");
+}
+
+
+double Summary::percentile(double percent) const
+{
+    if (std::find(m_percentiles.begin(), m_percentiles.end(), percent) ==
+        m_percentiles.end())
+    {
+        std::ostringstream oss;
+        oss << "Percentile " << percent << " of dimension " << m_name <<
+            " wasn't computed.";
+        throw pdal_error(oss.str());
+    }
+    // The ends are known exactly.
+    if (percent == 0)
+        return m_min;
+    if (percent == 100)
+        return m_max;
+    return m_quantiles.quantile(percent / 100.0);
+}
+
+
+// The values are summarized on their own and then merged, which is both
+// quicker and more accurate than summarizing one value at a time.
+void Summary::insert(const double *values, point_count_t count)
+{
+    if (!count)
+        return;
+
+    double min = values[0];
+    double max = values[0];
+    double sum = 0;
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        min = (std::min)(min, values[i]);
+        max = (std::max)(max, values[i]);
+        sum += values[i];
+    }
+    double avg = sum / count;
+    double m2 = 0;
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        double delta = values[i] - avg;
+        m2 += delta * delta;
+    }
+    merge(count, min, max, avg, m2);
+
+    if (m_percentiles.size())
+        for (point_count_t i = 0; i < count; ++i)
+            m_quantiles.insert(values[i]);
+    if (!m_histogram.empty())
+        for (point_count_t i = 0; i < count; ++i)
+            m_histogram.insert(values[i]);
+}
+
+
+void Summary::merge(const Summary& other)
+{
+    merge(other.m_cnt, other.m_min, other.m_max, other.m_avg, other.m_m2);
+    if (m_percentiles.size())
+        m_quantiles.merge(other.m_quantiles);
+    if (!m_histogram.empty())
+        m_histogram.merge(other.m_histogram);
+}
+
+
+// Combine the average and squared differences of two sets of values as
+// given by Chan et al.
+void Summary::merge(point_count_t count, double min, double max, double avg,
+    double m2)
+{
+    if (!count)
+        return;
+
+    point_count_t total = m_cnt + count;
+    double delta = avg - m_avg;
+    m_avg += delta * ((double)count / total);
+    m_m2 += m2 + delta * delta * ((double)m_cnt * count / total);
+    m_cnt = total;
+    m_min = (std::min)(m_min, min);
+    m_max = (std::max)(m_max, max);
+}
+
+
 void Summary::extractMetadata(MetadataNode &m) const
 {
     uint32_t cnt = static_cast<uint32_t>(count());
@@ -59,7 +296,18 @@ void Summary::extractMetadata(MetadataNode &m) const
     m.add("minimum", minimum(), "minimum");
     m.add("maximum", maximum(), "maximum");
     m.add("average", average(), "average");
+    m.add("variance", variance(), "sample variance");
+    m.add("stddev", stddev(), "sample standard deviation");
     m.add("name", m_name, "name");
+    if (m_cnt)
+        for (double percent : m_percentiles)
+        {
+            std::ostringstream name;
+            name << "percentile_" << percent;
+            m.add(name.str(), percentile(percent), "approximate percentile");
+        }
+    if (!m_histogram.empty())
+        m_histogram.extractMetadata(m);
 }
 
 } // namespace stats
@@ -68,14 +316,45 @@ using namespace stats;
 
 void StatsFilter::filter(PointView& view)
 {
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    const point_count_t count = view.size();
+    ThreadPool& pool = ThreadPool::shared();
+    // Points of a table that isn't threadSafe() are read one chunk at a
+    // time.
+    const size_t chunks = !view.table().threadSafe() ? 1 :
+        (std::max)((size_t)1,
+            (std::min)(pool.size(), (size_t)(count / 65536)));
+    auto chunkBegin = [count, chunks](size_t c)
+        { return (PointId)((count * c) / chunks); };
+
+    // Each chunk of points is summarized on its own and the summaries are
+    // merged in order.
+    std::vector<std::vector<Summary>> partial(chunks);
+    pool.parallelFor(chunks, 1, [&](size_t first, size_t last)
     {
-        for (auto p = m_stats.begin(); p != m_stats.end(); ++p)
-        {
-            Dimension::Id::Enum d = p->first;
-            Summary& c = p->second;
-            c.insert(view.getFieldAs<double>(d, idx));
-        }
+        const point_count_t batchSize = 4096;
+        std::vector<double> values(batchSize);
+        for (size_t c = first; c < last; ++c)
+            for (auto p = m_stats.begin(); p != m_stats.end(); ++p)
+            {
+                Summary s(p->second);
+                s.reset();
+                for (PointId begin = chunkBegin(c); begin < chunkBegin(c + 1);
+                    begin += batchSize)
+                {
+                    point_count_t n = (std::min)(batchSize,
+                        (point_count_t)(chunkBegin(c + 1) - begin));
+                    view.getFieldArray(p->first, begin, n, values.data());
+                    s.insert(values.data(), n);
+                }
+                partial[c].push_back(s);
+            }
+    });
+
+    for (size_t c = 0; c < chunks; ++c)
+    {
+        auto si = partial[c].begin();
+        for (auto p = m_stats.begin(); p != m_stats.end(); ++p, ++si)
+            p->second.merge(*si);
     }
 }
 
@@ -88,6 +367,52 @@ void StatsFilter::done(PointTableRef table)
 void StatsFilter::processOptions(const Options& options)
 {
     m_dimNames = m_options.getValueOrDefault<std::string>("dimensions", "");
+
+    auto splits = [](char c)
+        { return c == ' ' || c == ','; };
+    std::string percentiles =
+        options.getValueOrDefault<std::string>("percentiles", "");
+    for (const std::string& p : Utils::split2(percentiles, splits))
+    {
+        double percent;
+        std::istringstream iss(p);
+        if (!(iss >> percent) || !iss.eof() || percent < 0 || percent > 100)
+        {
+            std::ostringstream oss;
+            oss << getName() << ": Invalid percentile '" << p <<
+                "'.  Percentiles must be from 0 to 100.";
+            throw pdal_error(oss.str());
+        }
+        m_percentiles.push_back(percent);
+    }
+
+    // Histograms are given as <dimension>:<minimum>:<maximum>:<bins>.
+    std::string histograms =
+        options.getValueOrDefault<std::string>("histograms", "");
+    for (const std::string& h : Utils::split2(histograms, splits))
+    {
+        std::vector<std::string> parts = Utils::split(h, ':');
+        double min = 0;
+        double max = 0;
+        size_t bins = 0;
+        bool ok = parts.size() == 4;
+        if (ok)
+        {
+            std::istringstream minStream(parts[1]);
+            std::istringstream maxStream(parts[2]);
+            std::istringstream binStream(parts[3]);
+            ok = (minStream >> min) && (maxStream >> max) &&
+                (binStream >> bins) && min < max && bins > 0;
+        }
+        if (!ok)
+        {
+            std::ostringstream oss;
+            oss << getName() << ": Invalid histogram '" << h <<
+                "'.  Must be <dimension>:<minimum>:<maximum>:<bins>.";
+            throw pdal_error(oss.str());
+        }
+        m_histograms[parts[0]] = Histogram(min, max, bins);
+    }
 }
 
 
@@ -119,7 +444,14 @@ void StatsFilter::ready(PointTableRef table)
 
     auto ni = dimNames.begin();
     for (auto di = dims.begin(); di != dims.end(); ++di, ++ni)
-        m_stats.insert(std::make_pair(*di, Summary(*ni)));
+    {
+        Summary summary(*ni);
+        summary.setPercentiles(m_percentiles);
+        auto hi = m_histograms.find(*ni);
+        if (hi != m_histograms.end())
+            summary.setHistogram(hi->second);
+        m_stats.insert(std::make_pair(*di, summary));
+    }
 }
 
 
@@ -36,6 +36,9 @@
 
 #include <pdal/Filter.hpp>
 
+#include <cmath>
+#include <vector>
+
 extern "C" int32_t StatsFilter_ExitFunc();
 extern "C" PF_ExitFunc StatsFilter_InitPlugin();
 
@@ -44,6 +47,91 @@ namespace pdal
 namespace stats
 {
 
+// Approximate quantiles of a stream of values with a KLL sketch.  Values
+// are kept in levels of sorted compactors; when a level is full, every
+// other value moves up a level with double the weight.  The sketch keeps
+// O(k) values however many are inserted and sketches can be merged, so
+// parts of a stream can be summarized separately.  The rank error is
+// around 1.7 / k.
+class PDAL_DLL Quantiles
+{
+public:
+    Quantiles(size_t k = 200) : m_k(k), m_count(0), m_size(0),
+        m_maxSize(0), m_random(0x9E3779B97F4A7C15ULL)
+        {}
+
+    point_count_t count() const
+        { return m_count; }
+    void reset();
+    void insert(double value);
+    void merge(const Quantiles& other);
+    // Value with about fraction 'q' (0 - 1) of the values below it.
+    double quantile(double q) const;
+
+private:
+    size_t m_k;
+    point_count_t m_count;
+    // Number of values held and the number at which to compact.
+    size_t m_size;
+    size_t m_maxSize;
+    std::vector<std::vector<double>> m_levels;
+    uint64_t m_random;
+
+    size_t capacity(size_t level) const;
+    void compress();
+    void compact(size_t level);
+};
+
+// Counts of values in equal bins from a minimum to a maximum.  Values
+// outside the range are counted separately.
+class PDAL_DLL Histogram
+{
+public:
+    Histogram() : m_min(0), m_max(0), m_underflow(0), m_overflow(0)
+        {}
+    Histogram(double min, double max, size_t bins) : m_min(min),
+        m_max(max), m_counts(bins), m_underflow(0), m_overflow(0)
+        {}
+
+    bool empty() const
+        { return m_counts.empty(); }
+    double minimum() const
+        { return m_min; }
+    double maximum() const
+        { return m_max; }
+    const std::vector<point_count_t>& counts() const
+        { return m_counts; }
+    point_count_t underflow() const
+        { return m_underflow; }
+    point_count_t overflow() const
+        { return m_overflow; }
+
+    void reset();
+    // The maximum falls in the last bin.
+    void insert(double value)
+    {
+        if (value < m_min)
+            m_underflow++;
+        else if (value > m_max)
+            m_overflow++;
+        else
+        {
+            size_t bin = (size_t)((value - m_min) / (m_max - m_min) *
+                m_counts.size());
+            m_counts[(std::min)(bin, m_counts.size() - 1)]++;
+        }
+    }
+    void merge(const Histogram& other);
+    void extractMetadata(MetadataNode& m) const;
+
+private:
+    double m_min;
+    double m_max;
+    std::vector<point_count_t> m_counts;
+    point_count_t m_underflow;
+    point_count_t m_overflow;
+};
+
 class PDAL_DLL Summary
 {
 public:
@@ -56,19 +144,41 @@ public:
         { return m_max; }
     double average() const
         { return m_avg; }
+    // Sample variance.
+    double variance() const
+        { return m_cnt > 1 ? m_m2 / (m_cnt - 1) : 0.0; }
+    double stddev() const
+        { return std::sqrt(variance()); }
     point_count_t count() const
         { return m_cnt; }
     std::string name() const
         { return m_name; }
+    // Approximate value below which 'percent' of the values fall.  Only
+    // available for the percentiles that were asked for.
+    double percentile(double percent) const;
+    const Histogram& histogram() const
+        { return m_histogram; }
+
+    // Compute the given percentiles (0 - 100) when the summary is
+    // extracted.
+    void setPercentiles(const std::vector<double>& percentiles)
+        { m_percentiles = percentiles; }
+    void setHistogram(const Histogram& histogram)
+        { m_histogram = histogram; m_histogram.reset(); }
 
     void extractMetadata(MetadataNode &m) const;
 
+    // Clear the values summarized, keeping the percentiles and histogram
+    // that were asked for.
     void reset()
     {
         m_max = (std::numeric_limits<double>::lowest)();
         m_min = (std::numeric_limits<double>::max)();
         m_cnt = 0;
         m_avg = 0.0;
+        m_m2 = 0.0;
+        m_quantiles.reset();
+        m_histogram.reset();
     }
 
     void insert(double value)
@@ -76,15 +186,34 @@ public:
         m_cnt++;
         m_min = (std::min)(m_min, value);
         m_max = (std::max)(m_max, value);
-        m_avg += (value - m_avg) / m_cnt;
+        double delta = value - m_avg;
+        m_avg += delta / m_cnt;
+        m_m2 += delta * (value - m_avg);
+        if (m_percentiles.size())
+            m_quantiles.insert(value);
+        if (!m_histogram.empty())
+            m_histogram.insert(value);
     }
+    // Summarize an array of values.
+    void insert(const double *values, point_count_t count);
+    // Add the values summarized by 'other', which must have been asked
+    // for the same percentiles and histogram.
+    void merge(const Summary& other);
 
 private:
     double m_max;
     double m_min;
     double m_avg;
+    // Sum of squared differences from the average.
+    double m_m2;
     point_count_t m_cnt;
     std::string m_name;
+    std::vector<double> m_percentiles;
+    Quantiles m_quantiles;
+    Histogram m_histogram;
+
+    void merge(point_count_t count, double min, double max, double avg,
+        double m2);
 };
 
 } // namespace stats
@@ -100,6 +229,8 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
 
     const stats::Summary& getStats(Dimension::Id::Enum d) const;
     void reset();
@@ -114,6 +245,8 @@ private:
     void extractMetadata();
 
     std::string m_dimNames;
+    std::vector<double> m_percentiles;
+    std::map<std::string, stats::Histogram> m_histograms;
     std::map<Dimension::Id::Enum, stats::Summary> m_stats;
 };
 
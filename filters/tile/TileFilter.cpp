@@ -0,0 +1,272 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "TileFilter.hpp"
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageWrapper.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "filters.tile",
+    "Run filters on square tiles of the points, each with a buffer of the "
+        "points around it.",
+    "http://pdal.io/stages/filters.tile.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, TileFilter, Filter, s_info)
+
+std::string TileFilter::getName() const { return s_info.name; }
+
+void TileFilter::processOptions(const Options& options)
+{
+    m_tileSize = options.getValueOrDefault<double>("tile_size", 100);
+    m_buffer = options.getValueOrDefault<double>("buffer", m_tileSize / 10);
+    if (!(m_tileSize > 0) || m_buffer < 0)
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'tile_size' must be greater than 0 "
+            "and 'buffer' can't be negative.";
+        throw pdal_error(oss.str());
+    }
+
+    // Each 'filter' option names a filter of the chain, in order, and
+    // holds its options.
+    m_stages.clear();
+    for (const Option& opt : options.getOptions("filter"))
+    {
+        std::string type = opt.getValue<std::string>();
+        std::unique_ptr<Stage> stage(m_factory.createStage(type));
+        if (!dynamic_cast<Filter *>(stage.get()))
+        {
+            std::ostringstream oss;
+            oss << getName() << ": '" << type << "' isn't a known filter.";
+            throw pdal_error(oss.str());
+        }
+        boost::optional<Options const&> stageOptions = opt.getOptions();
+        if (stageOptions)
+            stage->setOptions(*stageOptions);
+        m_stages.push_back(std::move(stage));
+    }
+    if (m_stages.empty())
+    {
+        std::ostringstream oss;
+        oss << getName() << ": No 'filter' option to run on the tiles.";
+        throw pdal_error(oss.str());
+    }
+}
+
+
+// The filters of the chain have no inputs, so preparing them only
+// processes their options and adds their dimensions to the table.  They
+// share this filter's callback, so interrupting it interrupts them.
+void TileFilter::prepared(PointTableRef table)
+{
+    for (auto& stage : m_stages)
+    {
+        stage->setUserCallback(m_callback);
+        stage->prepare(table);
+    }
+}
+
+
+void TileFilter::ready(PointTableRef table)
+{
+    for (auto& stage : m_stages)
+        StageWrapper::ready(*stage, table);
+}
+
+
+void TileFilter::done(PointTableRef table)
+{
+    for (auto& stage : m_stages)
+        StageWrapper::done(*stage, table);
+}
+
+
+PointViewSet TileFilter::runTile(PointViewPtr tile)
+{
+    PointViewSet views;
+    views.insert(tile);
+    for (auto& stage : m_stages)
+    {
+        PointViewSet next;
+        for (auto& v : views)
+        {
+            PointViewSet out = StageWrapper::run(*stage, v);
+            next.insert(out.begin(), out.end());
+        }
+        views.swap(next);
+    }
+    return views;
+}
+
+
+PointViewSet TileFilter::run(PointViewPtr view)
+{
+    PointViewSet viewSet;
+    if (view->empty())
+    {
+        viewSet.insert(view);
+        return viewSet;
+    }
+
+    BOX3D bounds = view->calculateBounds();
+    size_t tileCols = (size_t)((bounds.maxx - bounds.minx) / m_tileSize) + 1;
+    size_t tileRows = (size_t)((bounds.maxy - bounds.miny) / m_tileSize) + 1;
+
+    // Tile column or row of a coordinate, clamped to the tiles.
+    auto tileIndex = [this](double v, double minv, size_t count) -> size_t
+    {
+        double t = std::floor((v - minv) / m_tileSize);
+        return (size_t)(std::max)(0.0, (std::min)(t, (double)count - 1));
+    };
+
+    // A tile's points are those inside it and those in its buffer.
+    std::vector<std::vector<PointId>> members(tileCols * tileRows);
+    std::vector<std::vector<char>> inside(tileCols * tileRows);
+    const point_count_t batchSize = 4096;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    for (PointId begin = 0; begin < view->size(); begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, view->size() - begin);
+        view->getFieldArray(Dimension::Id::X, begin, count, xs.data());
+        view->getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        for (PointId i = 0; i < count; ++i)
+        {
+            double x = xs[i];
+            double y = ys[i];
+            size_t c0 = tileIndex(x - m_buffer, bounds.minx, tileCols);
+            size_t c1 = tileIndex(x + m_buffer, bounds.minx, tileCols);
+            size_t r0 = tileIndex(y - m_buffer, bounds.miny, tileRows);
+            size_t r1 = tileIndex(y + m_buffer, bounds.miny, tileRows);
+            size_t core = tileIndex(y, bounds.miny, tileRows) * tileCols +
+                tileIndex(x, bounds.minx, tileCols);
+            for (size_t r = r0; r <= r1; ++r)
+                for (size_t c = c0; c <= c1; ++c)
+                {
+                    size_t t = r * tileCols + c;
+                    members[t].push_back(begin + i);
+                    inside[t].push_back(t == core);
+                }
+        }
+    }
+
+    // Tiles share the points inside them with the input, and are given
+    // copies of their buffer points, so that a filter setting the fields of
+    // a buffer point doesn't change the point for the tile it's inside.
+    // Copying adds points to the table, so tiles are made up front.
+    DimTypeList dims = view->dimTypes();
+    std::vector<char> packed(view->pointSize());
+    std::vector<PointViewPtr> tiles(members.size());
+    std::vector<std::vector<PointId>> cores(members.size());
+    std::vector<std::vector<PointId>> copies(members.size());
+    for (size_t t = 0; t < members.size(); ++t)
+    {
+        if (std::find(inside[t].begin(), inside[t].end(), 1) ==
+            inside[t].end())
+            continue;
+        PointViewPtr tile = view->makeNew();
+        for (size_t i = 0; i < members[t].size(); ++i)
+        {
+            PointId id = members[t][i];
+            if (inside[t][i])
+            {
+                tile->appendPoint(*view, id);
+                cores[t].push_back(view->tableId(id));
+                continue;
+            }
+            view->getPackedPoint(dims, id, packed.data());
+            tile->setPackedPoint(dims, tile->size(), packed.data());
+            copies[t].push_back(tile->tableId(tile->size() - 1));
+        }
+        std::sort(cores[t].begin(), cores[t].end());
+        std::sort(copies[t].begin(), copies[t].end());
+        tiles[t] = tile;
+        std::vector<PointId>().swap(members[t]);
+        std::vector<char>().swap(inside[t]);
+    }
+
+    std::vector<PointViewSet> results(tiles.size());
+    auto runTiles = [this, &tiles, &results](size_t first, size_t last)
+    {
+        for (size_t t = first; t < last; ++t)
+            if (tiles[t])
+            {
+                results[t] = runTile(tiles[t]);
+                tiles[t].reset();
+            }
+    };
+    bool parallel = view->table().threadSafe();
+    for (auto& stage : m_stages)
+        parallel = parallel && (stage->viewParallel() ||
+            (stage->appendParallel() && view->table().appendSafe()));
+    if (parallel)
+        ThreadPool::shared().parallelFor(tiles.size(), 1, runTiles);
+    else
+        runTiles(0, tiles.size());
+
+    // Keep the filtered points that were inside their tile, and the points
+    // the filters made that are inside it, such as smoothed or resampled
+    // points, so that the tiles are stitched together without overlap.
+    PointViewPtr outView = view->makeNew();
+    for (size_t t = 0; t < results.size(); ++t)
+        for (auto& v : results[t])
+            for (PointId i = 0; i < v->size(); ++i)
+            {
+                PointId id = v->tableId(i);
+                if (std::binary_search(cores[t].begin(), cores[t].end(), id))
+                    outView->appendPoint(*v, i);
+                else if (!std::binary_search(copies[t].begin(),
+                    copies[t].end(), id))
+                {
+                    double x = v->getFieldAs<double>(Dimension::Id::X, i);
+                    double y = v->getFieldAs<double>(Dimension::Id::Y, i);
+                    if (tileIndex(x, bounds.minx, tileCols) == t % tileCols &&
+                        tileIndex(y, bounds.miny, tileRows) == t / tileCols)
+                        outView->appendPoint(*v, i);
+                }
+            }
+    viewSet.insert(outView);
+    return viewSet;
+}
+
+} // namespace pdal
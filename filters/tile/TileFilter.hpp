@@ -0,0 +1,83 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Filter.hpp>
+#include <pdal/StageFactory.hpp>
+
+#include <memory>
+#include <vector>
+
+extern "C" int32_t TileFilter_ExitFunc();
+extern "C" PF_ExitFunc TileFilter_InitPlugin();
+
+namespace pdal
+{
+
+// Run a chain of filters on square tiles of a view.  Each tile is given
+// copies of the points within a buffer around it, so that filters that look
+// at the neighbors of a point see them near the tile's edges.  Of the
+// filtered points only those inside their tile are kept: points of the
+// input by whether they're buffer copies, and points the filters make by
+// their position.  Tiles are run in parallel when every filter of the chain
+// allows it.
+class PDAL_DLL TileFilter : public Filter
+{
+public:
+    TileFilter() : Filter()
+        {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+private:
+    double m_tileSize;
+    double m_buffer;
+    StageFactory m_factory;
+    std::vector<std::unique_ptr<Stage>> m_stages;
+
+    virtual void processOptions(const Options& options);
+    virtual void prepared(PointTableRef table);
+    virtual void ready(PointTableRef table);
+    virtual void done(PointTableRef table);
+    virtual PointViewSet run(PointViewPtr view);
+    PointViewSet runTile(PointViewPtr tile);
+
+    TileFilter& operator=(const TileFilter&); // not implemented
+    TileFilter(const TileFilter&); // not implemented
+};
+
+} // namespace pdal
@@ -37,7 +37,15 @@
 #include <pdal/pdal_error.hpp>
 #include <pdal/pdal_export.hpp>
 
+#include <algorithm>
 #include <sstream>
+#include <vector>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 namespace pdal
 {
@@ -85,28 +93,142 @@ TransformationMatrix transformationMatrixFromString(const std::string& s)
 }
 
 
-void TransformationFilter::processOptions(const Options& options)
+void transformPoints(const TransformationMatrix& m, point_count_t count,
+    double *x, double *y, double *z)
 {
-    m_matrix = transformationMatrixFromString(options.getValueOrThrow<std::string>("matrix"));
+    point_count_t i = 0;
+
+    // Each row of the matrix is broadcast into a vector register and then
+    // applied to as many points at once as the register holds.  The
+    // instruction set is chosen at compile time; the scalar loop picks up
+    // the remainder.  Multiplies and adds are kept separate so that every
+    // path gives the same result.
+#if defined(__AVX__)
+    const __m256d m0 = _mm256_set1_pd(m[0]);
+    const __m256d m1 = _mm256_set1_pd(m[1]);
+    const __m256d m2 = _mm256_set1_pd(m[2]);
+    const __m256d m3 = _mm256_set1_pd(m[3]);
+    const __m256d m4 = _mm256_set1_pd(m[4]);
+    const __m256d m5 = _mm256_set1_pd(m[5]);
+    const __m256d m6 = _mm256_set1_pd(m[6]);
+    const __m256d m7 = _mm256_set1_pd(m[7]);
+    const __m256d m8 = _mm256_set1_pd(m[8]);
+    const __m256d m9 = _mm256_set1_pd(m[9]);
+    const __m256d m10 = _mm256_set1_pd(m[10]);
+    const __m256d m11 = _mm256_set1_pd(m[11]);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d xv = _mm256_loadu_pd(x + i);
+        __m256d yv = _mm256_loadu_pd(y + i);
+        __m256d zv = _mm256_loadu_pd(z + i);
+
+        __m256d tx = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(xv, m0), _mm256_mul_pd(yv, m1)),
+            _mm256_mul_pd(zv, m2)), m3);
+        __m256d ty = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(xv, m4), _mm256_mul_pd(yv, m5)),
+            _mm256_mul_pd(zv, m6)), m7);
+        __m256d tz = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(xv, m8), _mm256_mul_pd(yv, m9)),
+            _mm256_mul_pd(zv, m10)), m11);
+
+        _mm256_storeu_pd(x + i, tx);
+        _mm256_storeu_pd(y + i, ty);
+        _mm256_storeu_pd(z + i, tz);
+    }
+#elif defined(__SSE2__)
+    const __m128d m0 = _mm_set1_pd(m[0]);
+    const __m128d m1 = _mm_set1_pd(m[1]);
+    const __m128d m2 = _mm_set1_pd(m[2]);
+    const __m128d m3 = _mm_set1_pd(m[3]);
+    const __m128d m4 = _mm_set1_pd(m[4]);
+    const __m128d m5 = _mm_set1_pd(m[5]);
+    const __m128d m6 = _mm_set1_pd(m[6]);
+    const __m128d m7 = _mm_set1_pd(m[7]);
+    const __m128d m8 = _mm_set1_pd(m[8]);
+    const __m128d m9 = _mm_set1_pd(m[9]);
+    const __m128d m10 = _mm_set1_pd(m[10]);
+    const __m128d m11 = _mm_set1_pd(m[11]);
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128d xv = _mm_loadu_pd(x + i);
+        __m128d yv = _mm_loadu_pd(y + i);
+        __m128d zv = _mm_loadu_pd(z + i);
+
+        __m128d tx = _mm_add_pd(_mm_add_pd(_mm_add_pd(
+            _mm_mul_pd(xv, m0), _mm_mul_pd(yv, m1)),
+            _mm_mul_pd(zv, m2)), m3);
+        __m128d ty = _mm_add_pd(_mm_add_pd(_mm_add_pd(
+            _mm_mul_pd(xv, m4), _mm_mul_pd(yv, m5)),
+            _mm_mul_pd(zv, m6)), m7);
+        __m128d tz = _mm_add_pd(_mm_add_pd(_mm_add_pd(
+            _mm_mul_pd(xv, m8), _mm_mul_pd(yv, m9)),
+            _mm_mul_pd(zv, m10)), m11);
+
+        _mm_storeu_pd(x + i, tx);
+        _mm_storeu_pd(y + i, ty);
+        _mm_storeu_pd(z + i, tz);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 2 <= count; i += 2)
+    {
+        float64x2_t xv = vld1q_f64(x + i);
+        float64x2_t yv = vld1q_f64(y + i);
+        float64x2_t zv = vld1q_f64(z + i);
+
+        float64x2_t tx = vaddq_f64(vaddq_f64(vaddq_f64(
+            vmulq_n_f64(xv, m[0]), vmulq_n_f64(yv, m[1])),
+            vmulq_n_f64(zv, m[2])), vdupq_n_f64(m[3]));
+        float64x2_t ty = vaddq_f64(vaddq_f64(vaddq_f64(
+            vmulq_n_f64(xv, m[4]), vmulq_n_f64(yv, m[5])),
+            vmulq_n_f64(zv, m[6])), vdupq_n_f64(m[7]));
+        float64x2_t tz = vaddq_f64(vaddq_f64(vaddq_f64(
+            vmulq_n_f64(xv, m[8]), vmulq_n_f64(yv, m[9])),
+            vmulq_n_f64(zv, m[10])), vdupq_n_f64(m[11]));
+
+        vst1q_f64(x + i, tx);
+        vst1q_f64(y + i, ty);
+        vst1q_f64(z + i, tz);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        double xv = x[i];
+        double yv = y[i];
+        double zv = z[i];
+
+        x[i] = xv * m[0] + yv * m[1] + zv * m[2] + m[3];
+        y[i] = xv * m[4] + yv * m[5] + zv * m[6] + m[7];
+        z[i] = xv * m[8] + yv * m[9] + zv * m[10] + m[11];
+    }
 }
 
 
-void TransformationFilter::filter(PointView& view)
+void TransformationFilter::processOptions(const Options& options)
 {
-    for (PointId idx = 0; idx < view.size(); ++idx)
-    {
-        double x = view.getFieldAs<double>(Dimension::Id::X, idx);
-        double y = view.getFieldAs<double>(Dimension::Id::Y, idx);
-        double z = view.getFieldAs<double>(Dimension::Id::Z, idx);
+    m_matrix = transformationMatrixFromString(options.getValueOrThrow<std::string>("matrix"));
+}
 
-        view.setField(Dimension::Id::X, idx,
-            x * m_matrix[0] + y * m_matrix[1] + z * m_matrix[2] + m_matrix[3]);
 
-        view.setField(Dimension::Id::Y, idx,
-            x * m_matrix[4] + y * m_matrix[5] + z * m_matrix[6] + m_matrix[7]);
+void TransformationFilter::filterRange(PointView& view, PointId first,
+    PointId last)
+{
+    const point_count_t batchSize = 4096;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    std::vector<double> zs(batchSize);
 
-        view.setField(Dimension::Id::Z, idx,
-            x * m_matrix[8] + y * m_matrix[9] + z * m_matrix[10] + m_matrix[11]);
+    for (PointId begin = first; begin < last; begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, last - begin);
+        view.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+        view.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        view.getFieldArray(Dimension::Id::Z, begin, count, zs.data());
+        transformPoints(m_matrix, count, xs.data(), ys.data(), zs.data());
+        view.setFieldArray(Dimension::Id::X, begin, count, xs.data());
+        view.setFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        view.setFieldArray(Dimension::Id::Z, begin, count, zs.data());
     }
 }
 
@@ -53,6 +53,12 @@ typedef std::array<double, 16> TransformationMatrix;
 
 TransformationMatrix PDAL_DLL transformationMatrixFromString(const std::string& s);
 
+// Apply the affine part of 'matrix' to 'count' points whose coordinates are
+// held in the arrays 'x', 'y' and 'z'.  The bottom row of the matrix is
+// ignored.
+void PDAL_DLL transformPoints(const TransformationMatrix& matrix,
+    point_count_t count, double *x, double *y, double *z);
+
 
 class PDAL_DLL TransformationFilter : public Filter
 {
@@ -63,12 +69,18 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+    virtual bool viewParallel() const
+        { return true; }
+    virtual bool pointwise() const
+        { return true; }
 
 private:
     TransformationFilter& operator=(const TransformationFilter&); // not implemented
     TransformationFilter(const TransformationFilter&); // not implemented
     virtual void processOptions(const Options& options);
-    virtual void filter(PointView& view);
+    virtual void filterRange(PointView& view, PointId first, PointId last);
 
     TransformationMatrix m_matrix;
 };
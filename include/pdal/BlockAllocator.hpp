@@ -0,0 +1,167 @@
+/******************************************************************************
+* Copyright (c) 2014, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <pdal/MemoryAccount.hpp>
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+// Provides the memory blocks in which a point table stores its points.
+class PDAL_DLL BlockAllocator
+{
+public:
+    virtual ~BlockAllocator()
+        {}
+
+    virtual char *allocate(std::size_t size) = 0;
+    virtual void deallocate(char *buf, std::size_t size) = 0;
+};
+typedef std::shared_ptr<BlockAllocator> BlockAllocatorPtr;
+
+
+// Allocates blocks from the heap.  This is what tables use by default.
+class PDAL_DLL HeapAllocator : public BlockAllocator
+{
+public:
+    virtual char *allocate(std::size_t size)
+        { return new char[size]; }
+    virtual void deallocate(char *buf, std::size_t /*size*/)
+        { delete [] buf; }
+};
+
+
+// Maps blocks directly from the operating system.
+//
+// With 'hugePages', blocks come from the reserved huge page pool when the
+// system has one and are otherwise marked as candidates for transparent
+// huge pages.  Either way the number of TLB misses and page faults when
+// walking a large table drops considerably.
+//
+// With 'prefault', all pages of a block are faulted in when it's allocated.
+// This keeps page faults out of the loops that fill the table and, under
+// the default first-touch policy, places the block's memory on the NUMA
+// node of the allocating thread.
+//
+// Where memory mapping isn't supported this falls back to the heap.
+class PDAL_DLL MappedAllocator : public BlockAllocator
+{
+public:
+    MappedAllocator(bool hugePages = true, bool prefault = true) :
+        m_hugePages(hugePages), m_prefault(prefault)
+        {}
+
+    virtual char *allocate(std::size_t size);
+    virtual void deallocate(char *buf, std::size_t size);
+
+private:
+    bool m_hugePages;
+    bool m_prefault;
+
+    std::size_t mappedSize(std::size_t size) const;
+};
+
+
+// Keeps the blocks returned to it for reuse.  Tables that are built one
+// after another in a long-running process, or at the same time by several
+// threads, can share a pool so that they don't go back to the system for
+// memory each time.
+class PDAL_DLL PoolAllocator : public BlockAllocator
+{
+public:
+    // \param source    Allocator from which new blocks are taken and to
+    //    which released blocks are returned.
+    // \param maxBytes  Maximum number of bytes to hold for reuse, or 0 for
+    //    no limit.  Blocks returned past the limit are freed immediately.
+    PoolAllocator(BlockAllocatorPtr source =
+            BlockAllocatorPtr(new HeapAllocator),
+        std::size_t maxBytes = 0) :
+        m_source(source), m_maxBytes(maxBytes), m_pooledBytes(0)
+        {}
+    virtual ~PoolAllocator()
+        { release(); }
+
+    virtual char *allocate(std::size_t size);
+    virtual void deallocate(char *buf, std::size_t size);
+
+    // Return all blocks held for reuse to the source allocator.
+    void release();
+    std::size_t pooledBytes() const;
+
+private:
+    BlockAllocatorPtr m_source;
+    std::size_t m_maxBytes;
+    std::size_t m_pooledBytes;
+    // Free blocks, by size.
+    std::map<std::size_t, std::vector<char *>> m_free;
+    mutable std::mutex m_mutex;
+
+    PoolAllocator& operator=(const PoolAllocator&); // not implemented
+    PoolAllocator(const PoolAllocator&); // not implemented
+};
+
+
+// Charges the blocks of another allocator to the memory account that's
+// current when each is allocated (see memory::Account).  Point tables wrap
+// their allocators in one of these so that point storage shows up in the
+// profile of the stage that caused it to be allocated.
+class PDAL_DLL AccountingAllocator : public BlockAllocator
+{
+public:
+    AccountingAllocator(BlockAllocatorPtr source) : m_source(source)
+        {}
+    virtual ~AccountingAllocator();
+
+    virtual char *allocate(std::size_t size);
+    virtual void deallocate(char *buf, std::size_t size);
+
+private:
+    BlockAllocatorPtr m_source;
+    // Account charged for each block.
+    std::map<char *, memory::Account *> m_accounts;
+    std::mutex m_mutex;
+
+    AccountingAllocator& operator=(const AccountingAllocator&);
+    AccountingAllocator(const AccountingAllocator&);
+};
+
+} // namespace pdal
@@ -44,17 +44,29 @@ namespace pdal
 class PDAL_DLL BufferReader : public pdal::Reader
 {
 public:
-    BufferReader() : Reader()
+    BufferReader() : Reader(), m_external(NULL)
         {}
     void addView(const PointViewPtr& view)
         { m_views.insert(view); }
+    // Read the points held in the caller's arrays of 'table', in place.
+    // The reader must be executed with 'table'.
+    void addExternal(ExternalPointTable& table)
+        { m_external = &table; }
     std::string getName() const { return "readers.buffer"; }
 
 private:
     PointViewSet m_views;
+    ExternalPointTable *m_external;
 
-    virtual PointViewSet run(PointViewPtr /*view*/)
-        { return m_views; }
+    virtual PointViewSet run(PointViewPtr view)
+    {
+        if (!m_external)
+            return m_views;
+        PointViewSet viewSet(m_views);
+        m_external->appendExternal(*view);
+        viewSet.insert(view);
+        return viewSet;
+    }
 };
 
 } // namespace pdal
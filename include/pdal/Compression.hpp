@@ -49,6 +49,9 @@
 
 #include <pdal/Dimension.hpp>
 
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <map>
 #include <vector>
 
@@ -58,6 +61,99 @@ namespace pdal
 namespace
 {
 
+// A Float or Double dimension with a scale or offset is compressed as the
+// nearest integer multiple of its scale, which the integer models predict
+// far better than the bits of a floating-point number.  The values are only
+// as precise as the scale.
+struct QuantizedField
+{
+    size_t m_offset;
+    Dimension::Type::Enum m_type;
+    XForm m_xform;
+};
+
+inline bool quantized(const DimType& dim)
+{
+    return (dim.m_type == Dimension::Type::Float ||
+        dim.m_type == Dimension::Type::Double) && dim.m_xform.nonstandard();
+}
+
+inline std::vector<QuantizedField> quantizedFields(const DimTypeList& dims)
+{
+    std::vector<QuantizedField> fields;
+    size_t offset = 0;
+    for (auto di = dims.begin(); di != dims.end(); ++di)
+    {
+        if (quantized(*di))
+            fields.push_back({ offset, di->m_type, di->m_xform });
+        offset += Dimension::size(di->m_type);
+    }
+    return fields;
+}
+
+// Replace the quantized fields of a packed point with their integers.
+inline void quantize(const std::vector<QuantizedField>& fields, char *point)
+{
+    for (const QuantizedField& f : fields)
+    {
+        char *pos = point + f.m_offset;
+        double d;
+        if (f.m_type == Dimension::Type::Float)
+        {
+            float v;
+            memcpy(&v, pos, sizeof(v));
+            d = v;
+        }
+        else
+            memcpy(&d, pos, sizeof(d));
+        d = std::round((d - f.m_xform.m_offset) / f.m_xform.m_scale);
+        if (std::isnan(d))
+            d = 0;
+
+        if (f.m_type == Dimension::Type::Float)
+        {
+            d = (std::max)(d, (double)(std::numeric_limits<int32_t>::min)());
+            d = (std::min)(d, (double)(std::numeric_limits<int32_t>::max)());
+            int32_t i = (int32_t)d;
+            memcpy(pos, &i, sizeof(i));
+        }
+        else
+        {
+            // The largest double below 2^63.
+            const double limit = 9223372036854774784.0;
+            d = (std::max)(d, -limit);
+            d = (std::min)(d, limit);
+            int64_t i = (int64_t)d;
+            memcpy(pos, &i, sizeof(i));
+        }
+    }
+}
+
+// Replace the integers of the quantized fields of a packed point with the
+// values they stand for.
+inline void dequantize(const std::vector<QuantizedField>& fields,
+    char *point)
+{
+    for (const QuantizedField& f : fields)
+    {
+        char *pos = point + f.m_offset;
+        if (f.m_type == Dimension::Type::Float)
+        {
+            int32_t i;
+            memcpy(&i, pos, sizeof(i));
+            float v = (float)(i * f.m_xform.m_scale + f.m_xform.m_offset);
+            memcpy(pos, &v, sizeof(v));
+        }
+        else
+        {
+            int64_t i;
+            memcpy(&i, pos, sizeof(i));
+            double v = i * f.m_xform.m_scale + f.m_xform.m_offset;
+            memcpy(pos, &v, sizeof(v));
+        }
+    }
+}
+
 template<typename LasZipEngine>
 size_t addFields(LasZipEngine& engine, const DimTypeList& dims)
 {
@@ -82,8 +178,15 @@ size_t addFields(LasZipEngine& engine, const DimTypeList& dims)
         case Type::Signed8:
             engine->template add_field<int8_t>();
             break;
-        case Type::Unsigned64:
         case Type::Double:
+            if (quantized(*di))
+            {
+                engine->template add_field<int32_t>();
+                engine->template add_field<int32_t>();
+                break;
+            }
+            // Fall through.
+        case Type::Unsigned64:
             engine->template add_field<uint32_t>();
             engine->template add_field<uint32_t>();
             break;
@@ -161,8 +264,12 @@ public:
         m_encoder(output),
         m_compressor(laszip::formats::make_dynamic_compressor(m_encoder)),
         m_pointSize(0),
+        m_quantized(quantizedFields(dims)),
         m_done(false)
-    { m_pointSize = addFields(m_compressor, dims); }
+    {
+        m_pointSize = addFields(m_compressor, dims);
+        m_point.resize(m_pointSize);
+    }
 
     ~LazPerfCompressor()
     {
@@ -180,7 +287,14 @@ public:
         const char *end = inbuf + bufsize;
         while (inbuf + m_pointSize <= end)
         {
-            m_compressor->compress(inbuf);
+            if (m_quantized.empty())
+                m_compressor->compress(inbuf);
+            else
+            {
+                memcpy(m_point.data(), inbuf, m_pointSize);
+                quantize(m_quantized, m_point.data());
+                m_compressor->compress(m_point.data());
+            }
             inbuf += m_pointSize;
             numRead++;
         }
@@ -200,6 +314,9 @@ private:
             Compressor;
     Compressor m_compressor;
     size_t m_pointSize;
+    std::vector<QuantizedField> m_quantized;
+    // A point with its quantized fields replaced.
+    std::vector<char> m_point;
     bool m_done;
 };
 
@@ -210,7 +327,8 @@ class LazPerfDecompressor
 public:
     LazPerfDecompressor(InputStream& input, const DimTypeList& dims) :
         m_decoder(input),
-        m_decompressor(laszip::formats::make_dynamic_decompressor(m_decoder))
+        m_decompressor(laszip::formats::make_dynamic_decompressor(m_decoder)),
+        m_quantized(quantizedFields(dims))
     { m_pointSize = addFields(m_decompressor, dims); }
 
     size_t pointSize() const
@@ -223,6 +341,8 @@ public:
         while (outbuf + m_pointSize <= end)
         {
             m_decompressor->decompress(outbuf);
+            if (m_quantized.size())
+                dequantize(m_quantized, outbuf);
             outbuf += m_pointSize;
             numWritten++;
         }
@@ -236,6 +356,7 @@ private:
         Decompressor;
     Decompressor m_decompressor;
     size_t m_pointSize;
+    std::vector<QuantizedField> m_quantized;
 };
 #endif  // PDAL_HAVE_LAZPERF
 
@@ -0,0 +1,96 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+// Idle database connections kept for reuse, so that stages that connect to
+// the same database, and pipelines that are run many times in one process,
+// don't each pay for setting up a session.  Connections are keyed by the
+// kind of database and the connection string.  A connection belongs to
+// the stage that acquired it until that stage releases it, which it should
+// only do once the connection is back in a clean state.
+class PDAL_DLL ConnectionPool
+{
+public:
+    // Closes a connection that's dropped from the pool.
+    typedef void (*Closer)(void *conn);
+
+    // Keep up to 'maxIdle' idle connections for each key.
+    explicit ConnectionPool(std::size_t maxIdle);
+    // Closes the idle connections.
+    ~ConnectionPool();
+
+    // The pool shared by all stages.  It keeps up to four idle connections
+    // for each key unless the PDAL_DB_POOL_SIZE environment variable says
+    // otherwise.  A size of 0 turns pooling off.
+    static ConnectionPool& shared();
+
+    // Take an idle connection for 'key', or NULL if there isn't one.
+    void *acquire(const std::string& key);
+    // Give 'conn' to the pool for a later acquire() of 'key'.  The
+    // connection is closed with 'close' if the pool is full.
+    void release(const std::string& key, void *conn, Closer close);
+    // Close every idle connection.  Plugins that made the connections must
+    // still be loaded.
+    void clear();
+    // Number of idle connections for 'key'.
+    std::size_t idle(const std::string& key);
+
+private:
+    struct Idle
+    {
+        void *m_conn;
+        Closer m_close;
+    };
+
+    std::mutex m_mutex;
+    std::map<std::string, std::vector<Idle>> m_idle;
+    std::size_t m_maxIdle;
+
+    ConnectionPool& operator=(const ConnectionPool&); // not implemented
+    ConnectionPool(const ConnectionPool&); // not implemented
+};
+
+} // namespace pdal
@@ -42,7 +42,8 @@ namespace pdal
 class PDAL_DLL DbReader : public Reader
 {
 protected:
-    DbReader() : m_orientation(Orientation::PointMajor), m_packedPointSize(0)
+    DbReader() : m_orientation(Orientation::PointMajor), m_packedPointSize(0),
+        m_unpackPlanned(false), m_unpackIdentity(false)
     {}
 
     DimTypeList dbDimTypes() const;
@@ -52,6 +53,14 @@ protected:
     void writeField(PointView& view, const char *pos, const DimType& dim,
         PointId idx);
     void writePoint(PointView& view, PointId idx, const char *buf);
+    void unpackPoints(PointView& view, PointId begin, point_count_t count,
+        const char *buf);
+    // Work out how points are unpacked ahead of calls to unpackPoints()
+    // from several threads at once.
+    void readyUnpack()
+        { if (!m_unpackPlanned) planUnpack(); }
+    void unpackDimensional(const char *buf, size_t size,
+        point_count_t count, std::vector<char>& out) const;
     size_t packedPointSize() const
         { return m_packedPointSize; }
     size_t dimOffset(Dimension::Id::Enum id) const;
@@ -59,10 +68,26 @@ protected:
         { return m_orientation; }
 
 private:
+    // How one dimension is unpacked from the DB point record.
+    struct UnpackField
+    {
+        DimType m_dimType;
+        size_t m_offset;
+        bool m_scaled; // X, Y or Z stored as Signed32 with a transform.
+        bool m_raw;    // Stored in the point table as packed.
+    };
+
+    void planUnpack();
+    void unpackField(PointView& view, const UnpackField& f, PointId begin,
+        point_count_t count, const char *buf);
+
     PointLayoutPtr m_layout;
     XMLDimList m_dims;
     Orientation::Enum m_orientation;
     size_t m_packedPointSize;
+    std::vector<UnpackField> m_unpackPlan;
+    bool m_unpackPlanned;
+    bool m_unpackIdentity; // Table points are laid out as packed.
 
     DbReader& operator=(const DbReader&); // not implemented
     DbReader(const DbReader&); // not implemented
@@ -35,7 +35,9 @@
 
 #include <pdal/Writer.hpp>
 
+#include <map>
 #include <string>
+#include <vector>
 
 namespace pdal
 {
@@ -49,6 +51,12 @@ class PDAL_DLL DbWriter : public Writer
     friend class SQLiteWriter;
     friend class PgWriter;
     friend class OciWriter;
+public:
+    // Each view is written as a patch of its own, so the points of a
+    // streaming chipper (see filters.chipper) can be streamed.
+    virtual bool streamable() const
+        { return true; }
+
 protected:
     DbWriter()
     {}
@@ -57,18 +65,43 @@ protected:
     size_t readField(const PointView& view, char *pos, DimType dimType,
         PointId idx);
     size_t readPoint(const PointView& view, PointId idx, char *outbuf);
+    size_t packPoints(const PointView& view, PointId begin,
+        point_count_t count, char *outbuf) const;
+    void packDimensional(const PointView& view, PointId begin,
+        point_count_t count, std::vector<char>& out, bool delta) const;
+    void processPrecision(const Options& options, bool lazperf);
 
 private:
+    // How one dimension is packed into the DB point record.
+    struct PackField
+    {
+        Dimension::Id::Enum m_id;
+        Dimension::Type::Enum m_type;
+        size_t m_offset;
+        XForm m_xform;
+        bool m_scaled; // X, Y or Z written as Signed32 with m_xform.
+        bool m_raw;    // Stored in the point table as packed.
+    };
+
     virtual void prepared(PointTableRef table);
     virtual void ready(PointTableRef table);
     DimTypeList dimTypes(PointTableRef table);
 
     DimTypeList m_dimTypes;
-    int m_xPackedOffset;
-    int m_yPackedOffset;
-    int m_zPackedOffset;
+    // Precision of the Float and Double dimensions named in the 'precision'
+    // option.
+    StringList m_precisionSpec;
+    std::map<Dimension::Id::Enum, double> m_precision;
     size_t m_packedPointSize;
+    DimTypeList m_otherDimTypes;
+    size_t m_otherPointSize;
+    DimHandle<double> m_xHandle;
+    DimHandle<double> m_yHandle;
+    DimHandle<double> m_zHandle;
     bool m_locationScaling;
+    std::vector<PackField> m_packPlan;
+    size_t m_dbPointSize;
+    bool m_packIdentity; // Table points are laid out as packed.
 
     DbWriter& operator=(const DbWriter&); // not implemented
     DbWriter(const DbWriter&); // not implemented
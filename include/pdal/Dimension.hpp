@@ -36,6 +36,7 @@
 
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
@@ -183,7 +184,12 @@ enum Enum
     Alpha,
     EchoRange,
     ScanChannel,
-    Infrared
+    Infrared,
+    NormalX,
+    NormalY,
+    NormalZ,
+    Curvature,
+    HeightAboveGround
 };
 } // namespace Id
 typedef std::vector<Id::Enum> IdList;
@@ -318,6 +324,17 @@ inline std::string description(Id::Enum id)
         return "Scan Channel";
     case Id::Infrared:
         return "Near Infrared";
+    case Id::NormalX:
+        return "X component of the surface normal";
+    case Id::NormalY:
+        return "Y component of the surface normal";
+    case Id::NormalZ:
+        return "Z component of the surface normal";
+    case Id::Curvature:
+        return "Surface curvature: the smallest eigenvalue of the "
+            "neighborhood's covariance over the sum of the eigenvalues.";
+    case Id::HeightAboveGround:
+        return "Height of the point above the ground surface";
     case Id::Unknown:
         return "";
     }
@@ -331,108 +348,73 @@ inline std::string description(Id::Enum id)
 ///    if the name doesn't map to a predefined dimension.
 inline Id::Enum id(std::string s)
 {
+    typedef std::unordered_map<std::string, Id::Enum> NameMap;
+    static const NameMap names =
+    {
+        { "X", Id::X },
+        { "Y", Id::Y },
+        { "Z", Id::Z },
+        { "INTENSITY", Id::Intensity },
+        { "AMPLITUDE", Id::Amplitude },
+        { "REFLECTANCE", Id::Reflectance },
+        { "RETURNNUMBER", Id::ReturnNumber },
+        { "NUMBEROFRETURNS", Id::NumberOfReturns },
+        { "SCANDIRECTIONFLAG", Id::ScanDirectionFlag },
+        { "EDGEOFFLIGHTLINE", Id::EdgeOfFlightLine },
+        { "CLASSIFICATION", Id::Classification },
+        { "SCANANGLERANK", Id::ScanAngleRank },
+        { "SCANANGLE", Id::ScanAngleRank },
+        { "USERDATA", Id::UserData },
+        { "POINTSOURCEID", Id::PointSourceId },
+        { "RED", Id::Red },
+        { "GREEN", Id::Green },
+        { "BLUE", Id::Blue },
+        { "ALPHA", Id::Alpha },
+        { "GPSTIME", Id::GpsTime },
+        { "INTERNALTIME", Id::InternalTime },
+        { "TIME", Id::OffsetTime },
+        { "OFFSETTIME", Id::OffsetTime },
+        { "ISPPSLOCKED", Id::IsPpsLocked },
+        { "STARTPULSE", Id::StartPulse },
+        { "RELFECTEDPULSE", Id::ReflectedPulse },
+        { "REFLECTEDPULSE", Id::ReflectedPulse },
+        { "PITCH", Id::Pitch },
+        { "ROLL", Id::Roll },
+        { "PDOP", Id::Pdop },
+        { "PULSEWIDTH", Id::PulseWidth },
+        { "DEVIATION", Id::Deviation },
+        { "PASSIVESIGNAL", Id::PassiveSignal },
+        { "BACKGROUNDRADIATION", Id::BackgroundRadiation },
+        { "PASSIVEX", Id::PassiveX },
+        { "PASSIVEY", Id::PassiveY },
+        { "PASSIVEZ", Id::PassiveZ },
+        { "XVELOCITY", Id::XVelocity },
+        { "YVELOCITY", Id::YVelocity },
+        { "ZVELOCITY", Id::ZVelocity },
+        { "PLATFORMHEADING", Id::PlatformHeading },
+        { "WANDERANGLE", Id::WanderAngle },
+        { "XBODYACCEL", Id::XBodyAccel },
+        { "YBODYACCEL", Id::YBodyAccel },
+        { "ZBODYACCEL", Id::ZBodyAccel },
+        { "XBODYANGRATE", Id::XBodyAngRate },
+        { "YBODYANGRATE", Id::YBodyAngRate },
+        { "ZBODYANGRATE", Id::ZBodyAngRate },
+        { "MARK", Id::Mark },
+        { "FLAG", Id::Flag },
+        { "ECHORANGE", Id::EchoRange },
+        { "SCANCHANNEL", Id::ScanChannel },
+        { "INFRARED", Id::Infrared },
+        { "NEARINFRARED", Id::Infrared },
+        { "NORMALX", Id::NormalX },
+        { "NORMALY", Id::NormalY },
+        { "NORMALZ", Id::NormalZ },
+        { "CURVATURE", Id::Curvature },
+        { "HEIGHTABOVEGROUND", Id::HeightAboveGround },
+    };
+
     boost::to_upper(s);
-    if (s == "X")
-        return Id::X;
-    else if (s == "Y")
-        return Id::Y;
-    else if (s == "Z")
-        return Id::Z;
-    else if (s == "INTENSITY")
-        return Id::Intensity;
-    else if (s == "AMPLITUDE")
-        return Id::Amplitude;
-    else if (s == "REFLECTANCE")
-        return Id::Reflectance;
-    else if (s == "RETURNNUMBER")
-        return Id::ReturnNumber;
-    else if (s == "NUMBEROFRETURNS")
-        return Id::NumberOfReturns;
-    else if (s == "SCANDIRECTIONFLAG")
-        return Id::ScanDirectionFlag;
-    else if (s == "EDGEOFFLIGHTLINE")
-        return Id::EdgeOfFlightLine;
-    else if (s == "CLASSIFICATION")
-        return Id::Classification;
-    else if (s == "SCANANGLERANK" || s == "SCANANGLE")
-        return Id::ScanAngleRank;
-    else if (s == "USERDATA")
-        return Id::UserData;
-    else if (s == "POINTSOURCEID")
-        return Id::PointSourceId;
-    else if (s == "RED")
-        return Id::Red;
-    else if (s == "GREEN")
-        return Id::Green;
-    else if (s == "BLUE")
-        return Id::Blue;
-    else if (s == "ALPHA")
-        return Id::Alpha;
-    else if (s == "GPSTIME")
-        return Id::GpsTime;
-    else if (s == "INTERNALTIME")
-        return Id::InternalTime;
-    else if (s == "TIME" || s == "OFFSETTIME")
-        return Id::OffsetTime;
-    else if (s == "ISPPSLOCKED")
-        return Id::IsPpsLocked;
-    else if (s == "STARTPULSE")
-        return Id::StartPulse;
-    else if (s == "RELFECTEDPULSE")
-        return Id::ReflectedPulse;
-    else if (s == "PITCH")
-        return Id::Pitch;
-    else if (s == "ROLL")
-        return Id::Roll;
-    else if (s == "PDOP")
-        return Id::Pdop;
-    else if (s == "PULSEWIDTH")
-        return Id::PulseWidth;
-    else if (s == "DEVIATION")
-        return Id::Deviation;
-    else if (s == "PASSIVESIGNAL")
-        return Id::PassiveSignal;
-    else if (s == "BACKGROUNDRADIATION")
-        return Id::BackgroundRadiation;
-    else if (s == "PASSIVEX")
-        return Id::PassiveX;
-    else if (s == "PASSIVEY")
-        return Id::PassiveY;
-    else if (s == "PASSIVEZ")
-        return Id::PassiveZ;
-    else if (s == "XVELOCITY")
-        return Id::XVelocity;
-    else if (s == "YVELOCITY")
-        return Id::YVelocity;
-    else if (s == "ZVELOCITY")
-        return Id::ZVelocity;
-    else if (s == "PLATFORMHEADING")
-        return Id::PlatformHeading;
-    else if (s == "WANDERANGLE")
-        return Id::WanderAngle;
-    else if (s == "XBODYACCEL")
-        return Id::XBodyAccel;
-    else if (s == "YBODYACCEL")
-        return Id::YBodyAccel;
-    else if (s == "ZBODYACCEL")
-        return Id::ZBodyAccel;
-    else if (s == "XBODYANGRATE")
-        return Id::XBodyAngRate;
-    else if (s == "YBODYANGRATE")
-        return Id::YBodyAngRate;
-    else if (s == "ZBODYANGRATE")
-        return Id::ZBodyAngRate;
-    else if (s == "MARK")
-        return Id::Mark;
-    else if (s == "FLAG")
-        return Id::Flag;
-    else if (s == "ECHORANGE")
-        return Id::EchoRange;
-    else if (s == "SCANCHANNEL")
-        return Id::ScanChannel;
-    else if (s == "INFRARED" || s == "NEARINFRARED")
-        return Id::Infrared;
-    return Id::Unknown;
+    auto ni = names.find(s);
+    return (ni != names.end() ? ni->second : Id::Unknown);
 }
 
 /// Get the name of a predefined dimension.
@@ -542,6 +524,16 @@ inline std::string name(Id::Enum id)
         return "ScanChannel";
     case Id::Infrared:
         return "Infrared";
+    case Id::NormalX:
+        return "NormalX";
+    case Id::NormalY:
+        return "NormalY";
+    case Id::NormalZ:
+        return "NormalZ";
+    case Id::Curvature:
+        return "Curvature";
+    case Id::HeightAboveGround:
+        return "HeightAboveGround";
     case Id::Unknown:
         return "";
     }
@@ -659,6 +651,16 @@ inline Type::Enum defaultType(Id::Enum id)
         return Unsigned8;
     case Id::Infrared:
         return Unsigned16;
+    case Id::NormalX:
+        return Double;
+    case Id::NormalY:
+        return Double;
+    case Id::NormalZ:
+        return Double;
+    case Id::Curvature:
+        return Double;
+    case Id::HeightAboveGround:
+        return Double;
     case Id::Unknown:
         throw pdal_error("No type for undefined dimension ID.");
     }
@@ -729,10 +731,47 @@ inline Type::Enum type(std::string s)
     return Type::None;
 }
 
+/// Get the type enumeration value corresponding to a C++ type.
+/// \return  Corresponding type enumeration value.
+template<typename T>
+inline Type::Enum type()
+    { return Type::None; }
+template<>
+inline Type::Enum type<int8_t>()
+    { return Type::Signed8; }
+template<>
+inline Type::Enum type<int16_t>()
+    { return Type::Signed16; }
+template<>
+inline Type::Enum type<int32_t>()
+    { return Type::Signed32; }
+template<>
+inline Type::Enum type<int64_t>()
+    { return Type::Signed64; }
+template<>
+inline Type::Enum type<uint8_t>()
+    { return Type::Unsigned8; }
+template<>
+inline Type::Enum type<uint16_t>()
+    { return Type::Unsigned16; }
+template<>
+inline Type::Enum type<uint32_t>()
+    { return Type::Unsigned32; }
+template<>
+inline Type::Enum type<uint64_t>()
+    { return Type::Unsigned64; }
+template<>
+inline Type::Enum type<float>()
+    { return Type::Float; }
+template<>
+inline Type::Enum type<double>()
+    { return Type::Double; }
+
 class Detail
 {
 public:
-    Detail() : m_id(Id::Unknown), m_offset(-1), m_type(Type::None)
+    Detail() : m_id(Id::Unknown), m_offset(-1), m_type(Type::None),
+        m_bits(0), m_shift(0), m_computed(false)
     {}
     //NOTE - This is strange, but for some reason things run faster with
     // this NOOP virtual dtor.  Perhaps it has something to do with
@@ -758,11 +797,42 @@ public:
         { return Dimension::size(m_type); }
     BaseType::Enum base() const
         { return Dimension::base(m_type); }
+    // Dimensions stored as scaled values hold (value - offset) / scale.
+    void setXForm(const XForm& xform)
+        { m_xform = xform; }
+    const XForm& xform() const
+        { return m_xform; }
+    bool scaled() const
+        { return m_xform.nonstandard(); }
+    // Packed dimensions hold an unsigned byte value in 'bits' bits that
+    // start at bit 'shift' of the byte at offset(), which they share with
+    // other packed dimensions.
+    void setPacking(int bits, int shift)
+        { m_bits = bits; m_shift = shift; }
+    bool packed() const
+        { return m_bits != 0; }
+    int bits() const
+        { return m_bits; }
+    int shift() const
+        { return m_shift; }
+    uint8_t mask() const
+        { return (uint8_t)((1 << m_bits) - 1); }
+    // Computed dimensions take no space in the point.  Their values are
+    // produced from other dimensions when read (see
+    // PointLayout::registerComputedDim()).
+    void setComputed(bool computed)
+        { m_computed = computed; }
+    bool computed() const
+        { return m_computed; }
 
 private:
     Id::Enum m_id; 
     int m_offset;
     Type::Enum m_type;
+    XForm m_xform;
+    int m_bits;
+    int m_shift;
+    bool m_computed;
 };
 typedef std::vector<Detail> DetailList;
 
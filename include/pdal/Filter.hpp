@@ -62,6 +62,28 @@ public:
     // for xml serializion of pipelines
     virtual boost::property_tree::ptree serializePipeline() const;
 
+    // Whether the filter is point-wise: it keeps every point of a view,
+    // sets the fields of each point from the fields of that point alone,
+    // and does its work in filterRange().  A run of point-wise filters is
+    // fused when executed, so that each block of points passes through
+    // every filter of the run while it's in cache.
+    virtual bool pointwise() const
+        { return false; }
+    // Run point-wise filters, first filter first, on a view a block of
+    // points at a time.  Blocks are filtered in parallel as by
+    // parallelFilter().
+    static void filterFused(const std::vector<Filter *>& filters,
+        PointView& view);
+
+protected:
+    // Call f(begin, end) for ranges of the points of 'view', in parallel
+    // on the shared thread pool when the view's table is thread-safe and
+    // the view is large enough to be worth splitting.  f may only read and
+    // set fields of the points in its range, and any state it changes
+    // (a coordinate transform, say) must belong to that range.
+    void parallelFilter(PointView& view,
+        const std::function<void(PointId, PointId)>& f);
+
 private:
     virtual PointViewSet run(PointViewPtr view)
     {
@@ -70,7 +92,13 @@ private:
         viewSet.insert(view);
         return viewSet;
     }
-    virtual void filter(PointView& /*view*/)
+    // Point-wise filters filter the view's points with filterRange().
+    virtual void filter(PointView& view);
+    // Filter the points in [begin, end) of 'view'.  Called for different
+    // ranges of a view from several threads at once, under the same rules
+    // as the function passed to parallelFilter().
+    virtual void filterRange(PointView& /*view*/, PointId /*begin*/,
+        PointId /*end*/)
     {}
 
     Filter& operator=(const Filter&); // not implemented
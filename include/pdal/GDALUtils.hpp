@@ -39,7 +39,12 @@
 
 #include <pdal/Log.hpp>
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/function.hpp>
@@ -90,7 +95,11 @@ class PDAL_DLL GlobalDebug
 public:
     GlobalDebug();
 
-    void addLog(LogPtr alog) { m_logs.push_back(alog); }
+    void addLog(LogPtr alog)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_logs.push_back(alog);
+    }
 
     ~GlobalDebug();
 
@@ -108,11 +117,163 @@ public:
     }
 
 private:
+    std::mutex m_mutex;
     std::vector<LogPtr> m_logs;
     boost::function<void(CPLErr, int, char const*)> m_gdal_callback;
 };
 
 
+// Collects the GDAL errors reported on the calling thread while in scope.
+// GDAL keeps a stack of error handlers for each thread, so each thread of
+// a parallel stage can have its own capture.  Unlike Debug, nothing is
+// thrown from inside GDAL; call check() once the GDAL call has returned.
+class PDAL_DLL ErrorCapture
+{
+public:
+    ErrorCapture(LogPtr log = LogPtr());
+    ~ErrorCapture();
+
+    bool failed() const
+        { return m_failed; }
+    int lastErrorNum() const
+        { return m_errorNum; }
+    const std::string& lastError() const
+        { return m_error; }
+    void clear();
+    // Throw a gdal_error led by 'context' if a failure was captured.
+    void check(const std::string& context) const;
+
+    static void CPL_STDCALL trampoline(::CPLErr code, int num,
+        char const* msg);
+
+private:
+    LogPtr m_log;
+    bool m_failed;
+    int m_errorNum;
+    std::string m_error;
+
+    ErrorCapture(const ErrorCapture&); // not implemented
+    ErrorCapture& operator=(const ErrorCapture&); // not implemented
+};
+
+
+// Read-only handles to one GDAL dataset.  A dataset handle can't be used
+// by more than one thread at a time, so a caller acquires a handle for as
+// long as it needs one and the handle goes back to the pool when the
+// Dataset is destroyed.  Handles are opened as they're needed and closed
+// with the pool, so no more handles are open than there have been
+// concurrent users.
+class PDAL_DLL DatasetPool
+{
+public:
+    class PDAL_DLL Dataset
+    {
+    public:
+        Dataset() : m_pool(NULL), m_ds(NULL)
+        {}
+        Dataset(Dataset&& other) : m_pool(other.m_pool), m_ds(other.m_ds)
+            { other.m_ds = NULL; }
+        Dataset& operator=(Dataset&& other);
+        ~Dataset()
+            { release(); }
+
+        GDALDatasetH get() const
+            { return m_ds; }
+        explicit operator bool() const
+            { return m_ds != NULL; }
+        void release();
+
+    private:
+        friend class DatasetPool;
+
+        Dataset(DatasetPool *pool, GDALDatasetH ds) : m_pool(pool), m_ds(ds)
+        {}
+
+        DatasetPool *m_pool;
+        GDALDatasetH m_ds;
+
+        Dataset(const Dataset&); // not implemented
+        Dataset& operator=(const Dataset&); // not implemented
+    };
+
+    DatasetPool(const std::string& filename) : m_filename(filename),
+        m_opened(0)
+    {}
+    ~DatasetPool();
+
+    // Take a handle, opening a new one if none is free.  Throws gdal_error
+    // if the dataset can't be opened.
+    Dataset acquire();
+    const std::string& filename() const
+        { return m_filename; }
+    // Number of handles opened so far.
+    size_t opened() const
+        { return m_opened; }
+
+private:
+    void release(GDALDatasetH ds);
+
+    std::string m_filename;
+    std::mutex m_mutex;
+    std::vector<GDALDatasetH> m_free;
+    size_t m_opened;
+
+    DatasetPool(const DatasetPool&); // not implemented
+    DatasetPool& operator=(const DatasetPool&); // not implemented
+};
+
+
+// A process-wide cache of spatial references parsed by OGR and of the
+// coordinate transformations between them, keyed by their WKT.  Jobs that
+// run over many files in the same system parse it once.  OGR objects
+// can't be shared between threads: reference() returns a copy of the
+// cached parse, and a transformation is taken from the cache and given
+// back when the caller is done with it.
+class PDAL_DLL SrsCache
+{
+public:
+    typedef std::shared_ptr<void> ReferencePtr;
+    typedef std::shared_ptr<void> TransformPtr;
+
+    static SrsCache& get();
+
+    // A reference parsed from WKT or other user input.  Throws pdal_error
+    // if OGR can't parse it.
+    ReferencePtr reference(const std::string& wkt);
+    // A transformation between two references, made if none is free.
+    // Throws pdal_error if OGR can't make one.
+    TransformPtr takeTransform(const std::string& inWkt,
+        const std::string& outWkt);
+    void giveTransform(const std::string& inWkt, const std::string& outWkt,
+        TransformPtr transform);
+    void clear();
+
+    // Number of references parsed and transformations made since the
+    // cache was cleared.
+    size_t parsed() const
+        { return m_parsed; }
+    size_t created() const
+        { return m_created; }
+
+private:
+    typedef std::pair<std::string, std::string> TransformKey;
+
+    SrsCache() : m_parsed(0), m_created(0)
+    {}
+
+    ReferencePtr parsedReference(const std::string& wkt);
+
+    std::mutex m_mutex;
+    std::map<std::string, ReferencePtr> m_references;
+    std::map<TransformKey, std::vector<TransformPtr>> m_transforms;
+    size_t m_parsed;
+    size_t m_created;
+
+    SrsCache(const SrsCache&); // not implemented
+    SrsCache& operator=(const SrsCache&); // not implemented
+};
+
+
 class PDAL_DLL VSILFileBuffer
 {
 public:
@@ -0,0 +1,84 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include <pdal/PointView.hpp>
+
+namespace pdal
+{
+
+// Exact nearest neighbor index that searches the cells of a uniform grid
+// by brute force.  The points are bucketed into cells sized to hold a few
+// points each, and a query searches shells of cells outward from its own
+// until no cell left can hold a nearer point.  It answers the same batch
+// queries as KDIndex and builds in linear time, which pays off for large,
+// evenly spread clouds.
+class PDAL_DLL GridIndex
+{
+public:
+    GridIndex(const PointView& buf);
+
+    void build(bool b3d = true);
+
+    point_count_t size() const
+        { return (point_count_t)m_ids.size(); }
+
+    // Find the 'k' nearest neighbors of each of 'n' query points, as
+    // KDIndex::knnBatch() does.
+    void knnBatch(const double *xyz, point_count_t n, point_count_t k,
+            PointId *ids, double *sqrDists) const;
+
+private:
+    const PointView& m_buf;
+    // Number of coordinates per point in m_coords.
+    std::size_t m_dims;
+    double m_min[3];
+    double m_cellSize;
+    std::size_t m_cells[3];
+    // Position in m_ids of the first point of each cell, and the end.
+    std::vector<PointId> m_offsets;
+    // The points and their coordinates, packed by point, grouped by cell.
+    std::vector<PointId> m_ids;
+    std::vector<double> m_coords;
+
+    std::size_t cell(const double *xyz, std::size_t d) const;
+
+    GridIndex(const GridIndex&);
+    GridIndex& operator=(GridIndex&);
+};
+
+} // namespace pdal
@@ -35,6 +35,10 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
+
+#include <pdal/MemoryAccount.hpp>
 #include <pdal/PointView.hpp>
 
 namespace nanoflann
@@ -50,6 +54,9 @@ namespace nanoflann
 namespace pdal
 {
 
+// Nearest neighbor index over the points of a view.  build() copies the
+// coordinates into a packed array that the tree reads from, so queries
+// don't touch the view.
 class PDAL_DLL KDIndex
 {
 public:
@@ -58,7 +65,8 @@ public:
 
     std::size_t kdtree_get_point_count() const;
 
-    double kdtree_get_pt(const PointId idx, int dim) const;
+    double kdtree_get_pt(const PointId idx, int dim) const
+        { return m_coords[idx * m_dims + dim]; }
 
     double kdtree_distance(
             const PointId idx_p2,
@@ -66,19 +74,20 @@ public:
 
     template <class BBOX> bool kdtree_get_bbox(BBOX &bb) const
     {
-        BOX3D bounds = m_buf.calculateBounds();
-        if (bounds.empty())
+        if (m_coords.empty())
             return false;
 
+        // The tree is built right after the coordinates are copied, so the
+        // view's bounds, which are often already cached, are theirs.
+        BOX3D bounds = m_buf.calculateBounds(m_dims == 3);
         bb[0].low = bounds.minx;
         bb[0].high = bounds.maxx;
         bb[1].low = bounds.miny;
         bb[1].high = bounds.maxy;
-
-        if (m_3d)
+        if (m_dims == 3)
         {
-            bb[2].low = bounds.minx;
-            bb[2].high = bounds.maxx;
+            bb[2].low = bounds.minz;
+            bb[2].high = bounds.maxz;
         }
         return true;
     }
@@ -95,16 +104,61 @@ public:
             double const& z,
             point_count_t count = 1) const;
 
+    // Find the 'count' nearest neighbors of a point into caller buffers,
+    // which are resized to the number of neighbors found, so that repeated
+    // queries needn't allocate.
+    void neighbors(
+            double const& x,
+            double const& y,
+            double const& z,
+            point_count_t count,
+            std::vector<PointId>& ids,
+            std::vector<double>& sqrDists) const;
+
+    // Find the 'k' nearest neighbors of each of 'n' query points.  'xyz'
+    // holds the X, Y and Z of each query point (Z is ignored by a 2D
+    // index).  'ids' and 'sqrDists' receive 'k' entries for each query
+    // point, nearest first.  Queries are answered in parallel on the
+    // shared thread pool.  'k' may not be more than the number of points
+    // indexed.
+    void knnBatch(const double *xyz, point_count_t n, point_count_t k,
+            PointId *ids, double *sqrDists) const;
+
     void build(bool b3d = true);
+    // Build the index, or load it from 'cacheFile' if that holds an index
+    // of the same points.  A newly built index is saved to 'cacheFile'.
+    void build(const std::string& cacheFile, bool b3d = true);
+
+    // Load an index saved by save().  Returns false, leaving the index
+    // unbuilt, if the file can't be read or doesn't hold an index of
+    // these points with the same number of dimensions.
+    bool load(const std::string& filename, bool b3d = true);
+    // Save the built index.  The file is tagged with a hash of the indexed
+    // coordinates so that load() can tell whether it still applies.
+    void save(const std::string& filename) const;
+
+    // Whether the index is built, with 'b3d', over the points of 'view'
+    // as they are now.  The coordinates are read again and compared,
+    // which costs much less than a build.
+    bool current(const PointView& view, bool b3d = true) const;
 
 private:
     const PointView& m_buf;
     bool m_3d;
+    // Number of coordinates per point in m_coords.
+    std::size_t m_dims;
+    // X, Y and, for a 3D index, Z of each point, packed by point.
+    memory::Vector<double, memory::SpatialIndex> m_coords;
 
     typedef nanoflann::KDTreeSingleIndexAdaptor<nanoflann::L2_Adaptor<
         double, KDIndex, double>, KDIndex, -1, std::size_t> my_kd_tree_t;
 
     std::unique_ptr<my_kd_tree_t> m_index;
+    // The tree allocates its own nodes, so it's charged once it's built.
+    memory::Charge m_treeCharge;
+
+    void fillCache(bool b3d);
+    uint64_t hash() const;
 
     KDIndex(const KDIndex&);
     KDIndex& operator=(KDIndex&);
@@ -127,6 +127,14 @@ protected:
         m_stages.push_back(std::unique_ptr<Stage>(s));
         return *s;
     }
+    // Hand ownership of the stages made so far to the caller, so that
+    // stages built for one of many runs can be freed when the run is done.
+    std::vector<std::unique_ptr<Stage>> takeStages()
+    {
+        std::vector<std::unique_ptr<Stage>> stages;
+        stages.swap(m_stages);
+        return stages;
+    }
     bool m_usestdin;
 
 private:
@@ -148,6 +156,7 @@ private:
     std::string m_showOptions;
     bool m_showVersion;
     bool m_showTime;
+    std::string m_traceFile;
     int m_argc;
     const char** m_argv;
     std::string m_appName;
@@ -69,8 +69,14 @@ public:
     // makes a writer, from just the filename and some other
     // options (and the input stage)
     static PipelineManager* makePipeline(const std::string& filename);
+    // As above, but the pipeline uses 'table' to hold its points.
+    static PipelineManager* makePipeline(const std::string& filename,
+        PointTableRef table);
 
 private:
+    static void addInput(PipelineManager& manager,
+        const std::string& filename);
+
     KernelSupport& operator=(const KernelSupport&); // not implemented
     KernelSupport(const KernelSupport&); // not implemented
 };
@@ -52,6 +52,7 @@ typedef boost::iostreams::stream<sink> null_stream;
 namespace pdal
 {
 
+class AsyncLogBuf;
 
 /// pdal::Log is a logging object that is provided by pdal::Stage to
 /// facilitate logging operations.
@@ -94,6 +95,12 @@ public:
         m_level = v;
     }
 
+    /// @return Whether entries of the given level are logged.
+    bool enabled(LogLevel::Enum level) const
+    {
+        return level <= m_level;
+    }
+
     /// @return A string representing the LogLevel
     std::string getLevelString(LogLevel::Enum v) const;
 
@@ -113,6 +120,26 @@ public:
     /// an ostream with a boost::iostreams::null_sink is returned.
     std::ostream& get(LogLevel::Enum level = LogLevel::Info);
 
+    /// Log an entry written by a function, which is only called if the
+    /// level is enabled.  For entries that take more than an expression
+    /// to build; see PDAL_LOG for those that don't.
+    /// @param level logging level of the entry
+    /// @param f function called with the log stream
+    template <typename FUNC>
+    void write(LogLevel::Enum level, FUNC f)
+    {
+        if (enabled(level))
+            f(get(level));
+    }
+
+    /// Have a background thread write the log stream, so that logging
+    /// never waits on the output.  Lines are passed to the thread through
+    /// a ring buffer that holds 'capacity' lines.  Lines logged while the
+    /// ring is full are dropped and their number is logged in their place.
+    /// Stages that share this log's stream share the thread.
+    /// @param capacity number of lines the ring holds
+    void setAsync(std::size_t capacity);
+
     /// Sets the floating point precision
     void floatPrecision(int level);
 
@@ -125,6 +152,10 @@ public:
 protected:
     std::ostream* m_log;
     null_stream m_null_stream;
+    // Stream written by the background thread when logging is asynchronous.
+    std::ostream* m_target;
+    std::unique_ptr<AsyncLogBuf> m_asyncBuf;
+    std::unique_ptr<std::ostream> m_asyncStream;
 
 private:
     Log(const Log&);
@@ -140,4 +171,11 @@ typedef std::shared_ptr<Log> LogPtr;
 
 } // namespace pdal
 
+/// Log to a pdal::Log (or LogPtr) at a level.  When the level isn't
+/// enabled, this is a single test and nothing that follows it is
+/// evaluated:
+///     PDAL_LOG(log(), LogLevel::Debug5) << "x: " << x << std::endl;
+#define PDAL_LOG(log, level) \
+    if (!(log)->enabled(level)) {} else (log)->get(level)
+
 #endif
@@ -0,0 +1,253 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+// Accounting of the memory used by stages.  Each stage has an account that
+// is made current on the threads doing the stage's work.  Memory allocated
+// while an account is current is charged to it, by category, and credited
+// back to the same account when it's freed, whichever thread frees it.
+namespace memory
+{
+
+enum Category
+{
+    TableBlocks,    // Point storage of tables.
+    ViewIndex,      // Point ID lists of views.
+    SpatialIndex,   // KD and quad trees and their coordinates.
+    Temporary,      // Working storage of stages.
+    NumCategories
+};
+
+// Name of a category as used in profile output, like "view_index".
+PDAL_DLL const char *categoryName(Category c);
+
+// Bytes charged to a stage.  An account is reference counted, and each
+// allocation charged to it holds a reference, so that memory can outlive
+// the stage that allocated it.
+class PDAL_DLL Account
+{
+public:
+    Account() : m_refs(0)
+    {
+        for (auto& c : m_counts)
+            c.m_current = c.m_peak = c.m_total = 0;
+    }
+
+    void allocated(Category c, std::size_t bytes);
+    void freed(Category c, std::size_t bytes);
+
+    // Bytes in use now.
+    uint64_t current(Category c) const
+        { return m_counts[c].m_current; }
+    // The most bytes in use at once.
+    uint64_t peak(Category c) const
+        { return m_counts[c].m_peak; }
+    // All bytes ever allocated.
+    uint64_t total(Category c) const
+        { return m_counts[c].m_total; }
+
+    void retain()
+        { m_refs.fetch_add(1, std::memory_order_relaxed); }
+    void release()
+    {
+        if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+private:
+    struct Counts
+    {
+        std::atomic<uint64_t> m_current;
+        std::atomic<uint64_t> m_peak;
+        std::atomic<uint64_t> m_total;
+    };
+
+    std::atomic<int> m_refs;
+    Counts m_counts[NumCategories];
+
+    Account(const Account&) = delete;
+    Account& operator=(const Account&) = delete;
+};
+
+
+// Shared ownership of an account.
+class PDAL_DLL AccountPtr
+{
+public:
+    AccountPtr(Account *a = NULL) : m_account(a)
+        { if (m_account) m_account->retain(); }
+    AccountPtr(const AccountPtr& other) : m_account(other.m_account)
+        { if (m_account) m_account->retain(); }
+    ~AccountPtr()
+        { if (m_account) m_account->release(); }
+    AccountPtr& operator=(AccountPtr other)
+    {
+        std::swap(m_account, other.m_account);
+        return *this;
+    }
+
+    Account *get() const
+        { return m_account; }
+    Account *operator->() const
+        { return m_account; }
+
+private:
+    Account *m_account;
+};
+
+
+// The account current on the calling thread, or NULL.
+PDAL_DLL Account *current();
+
+// Makes an account current on the calling thread for the life of the scope.
+class PDAL_DLL Scope
+{
+public:
+    Scope(Account *a);
+    ~Scope();
+
+private:
+    Account *m_prev;
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+// Charge 'bytes' to the current account.  Returns the account charged,
+// with a reference held for the allocation, or NULL if there's none.
+PDAL_DLL Account *charge(Category c, std::size_t bytes);
+// Credit 'bytes' back to an account returned by charge().
+PDAL_DLL void credit(Account *a, Category c, std::size_t bytes);
+
+
+// A charge for memory that isn't allocated through an accounting
+// allocator, like that of a third-party structure whose size is known once
+// it's built.
+class PDAL_DLL Charge
+{
+public:
+    Charge() : m_account(NULL), m_category(Temporary), m_bytes(0)
+        {}
+    Charge(Category c, std::size_t bytes) : m_account(charge(c, bytes)),
+        m_category(c), m_bytes(bytes)
+        {}
+    Charge(Charge&& other) : m_account(other.m_account),
+        m_category(other.m_category), m_bytes(other.m_bytes)
+        { other.m_account = NULL; }
+    ~Charge()
+        { credit(m_account, m_category, m_bytes); }
+    Charge& operator=(Charge&& other)
+    {
+        std::swap(m_account, other.m_account);
+        std::swap(m_category, other.m_category);
+        std::swap(m_bytes, other.m_bytes);
+        return *this;
+    }
+
+private:
+    Account *m_account;
+    Category m_category;
+    std::size_t m_bytes;
+
+    Charge(const Charge&) = delete;
+    Charge& operator=(const Charge&) = delete;
+};
+
+
+// Standard allocator that charges the current account.  Each allocation
+// carries the account it was charged to in a small header, so allocators
+// are interchangeable and containers can be moved and swapped freely.
+template<typename T, Category C>
+class Allocator
+{
+public:
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind
+    {
+        typedef Allocator<U, C> other;
+    };
+
+    Allocator()
+        {}
+    template<typename U>
+    Allocator(const Allocator<U, C>&)
+        {}
+
+    T *allocate(std::size_t n)
+    {
+        char *buf = static_cast<char *>(
+            ::operator new(n * sizeof(T) + HeaderSize));
+        *reinterpret_cast<Account **>(buf) = charge(C, n * sizeof(T));
+        return reinterpret_cast<T *>(buf + HeaderSize);
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        char *buf = reinterpret_cast<char *>(p) - HeaderSize;
+        credit(*reinterpret_cast<Account **>(buf), C, n * sizeof(T));
+        ::operator delete(buf);
+    }
+
+private:
+    // Keeps the storage after the header as aligned as ::operator new's.
+    static const std::size_t HeaderSize = alignof(std::max_align_t);
+};
+
+template<typename T, typename U, Category C>
+bool operator==(const Allocator<T, C>&, const Allocator<U, C>&)
+    { return true; }
+template<typename T, typename U, Category C>
+bool operator!=(const Allocator<T, C>&, const Allocator<U, C>&)
+    { return false; }
+
+template<typename T, Category C>
+using Vector = std::vector<T, Allocator<T, C>>;
+
+} // namespace memory
+} // namespace pdal
+
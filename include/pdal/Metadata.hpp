@@ -44,8 +44,10 @@
 #include <pdal/Utils.hpp>
 #include <pdal/SpatialReference.hpp>
 
+#include <limits>
 #include <map>
 #include <memory>
+#include <type_traits>
 #include <vector>
 #include <stdint.h>
 
@@ -88,6 +90,7 @@ enum Enum
 } // namespace MetadataType
 
 class Metadata;
+class MetadataJsonWriter;
 class MetadataNode;
 class MetadataNodeImpl;
 typedef std::shared_ptr<MetadataNodeImpl> MetadataNodeImplPtr;
@@ -98,18 +101,78 @@ typedef std::vector<MetadataNode> MetadataNodeList;
 class MetadataNodeImpl
 {
     friend class MetadataNode;
+    friend class MetadataJsonWriter;
 
-private:
-    MetadataNodeImpl(const std::string& name) : m_kind(MetadataType::Instance)
+    // Types of values.  Nodes hold the index of their type's name rather
+    // than a copy of it.
+    enum TypeName
     {
-//ABELL
-//        m_name = sanitize(name);
-        m_name = name;
-    }
+        NoType,
+        BooleanType,
+        StringType,
+        FloatType,
+        DoubleType,
+        SpatialReferenceType,
+        BoundsType,
+        NonNegativeIntegerType,
+        IntegerType,
+        UuidType,
+        Base64BinaryType
+    };
+
+    // How the value is held.  Numbers are kept as they're given and
+    // converted to text only when the text is wanted.
+    enum ValueKind
+    {
+        TextValue,
+        SignedValue,
+        UnsignedValue,
+        FloatValue,
+        DoubleValue
+    };
+
+    // Lets std::make_shared() use the constructors, which are otherwise
+    // only for MetadataNode.
+    struct Private
+    {};
 
-    MetadataNodeImpl() : m_kind(MetadataType::Instance)
+public:
+    MetadataNodeImpl(Private, const std::string& name) :
+        m_name(name), m_type(NoType), m_valueKind(TextValue),
+        m_kind(MetadataType::Instance)
     {}
 
+    MetadataNodeImpl(Private) : m_type(NoType), m_valueKind(TextValue),
+        m_kind(MetadataType::Instance)
+    {}
+
+private:
+    // The node and its control block are a single allocation.
+    static MetadataNodeImplPtr create(const std::string& name)
+        { return std::make_shared<MetadataNodeImpl>(Private(), name); }
+
+    static MetadataNodeImplPtr create()
+        { return std::make_shared<MetadataNodeImpl>(Private()); }
+
+    static const std::string& typeName(TypeName type)
+    {
+        static const std::string names[] =
+        {
+            "",
+            "boolean",
+            "string",
+            "float",
+            "double",
+            "spatialreference",
+            "bounds",
+            "nonNegativeInteger",
+            "integer",
+            "uuid",
+            "base64Binary"
+        };
+        return names[type];
+    }
+
     void makeArray(MetadataImplList& l)
     {
         for (auto li = l.begin(); li != l.end(); ++li)
@@ -121,7 +184,7 @@ private:
 
     MetadataNodeImplPtr add(const std::string& name)
     {
-        MetadataNodeImplPtr sub(new MetadataNodeImpl(name));
+        MetadataNodeImplPtr sub(create(name));
         MetadataImplList& l = m_subnodes[name];
         l.push_back(sub);
         if (l.size() > 1)
@@ -131,7 +194,7 @@ private:
 
     MetadataNodeImplPtr addList(const std::string& name)
     {
-        MetadataNodeImplPtr sub(new MetadataNodeImpl(name));
+        MetadataNodeImplPtr sub(create(name));
         MetadataImplList& l = m_subnodes[name];
         l.push_back(sub);
         makeArray(l);
@@ -158,7 +221,7 @@ private:
     bool operator == (const MetadataNodeImpl& m) const
     {
         if (m_name != m.m_name || m_descrip != m.m_descrip ||
-            m_type != m.m_type || m_value != m.m_value)
+            m_type != m.m_type || value() != m.value())
             return false;
         if (m_subnodes.size() != m.m_subnodes.size())
             return false;
@@ -190,6 +253,108 @@ private:
     template <std::size_t N>
     inline void setValue(const char(& c)[N]);
 
+    void setText(TypeName type, const std::string& s)
+    {
+        m_type = type;
+        m_valueKind = TextValue;
+        m_value = s;
+    }
+
+    void setSigned(int64_t i)
+    {
+        m_type = IntegerType;
+        m_valueKind = SignedValue;
+        m_signed = i;
+        m_value.clear();
+    }
+
+    void setUnsigned(uint64_t u)
+    {
+        m_type = NonNegativeIntegerType;
+        m_valueKind = UnsignedValue;
+        m_unsigned = u;
+        m_value.clear();
+    }
+
+    // The text of the value, converted from the number when the value is
+    // a number.  The conversion is that of boost::lexical_cast, as it's
+    // always been.  As the text is kept once made, the first read of a
+    // node's value mustn't race another.
+    const std::string& value() const
+    {
+        if (m_valueKind != TextValue && m_value.empty())
+        {
+            switch (m_valueKind)
+            {
+            case SignedValue:
+                m_value = boost::lexical_cast<std::string>(m_signed);
+                break;
+            case UnsignedValue:
+                m_value = boost::lexical_cast<std::string>(m_unsigned);
+                break;
+            case FloatValue:
+                m_value = boost::lexical_cast<std::string>(m_float);
+                break;
+            case DoubleValue:
+                m_value = boost::lexical_cast<std::string>(m_double);
+                break;
+            default:
+                break;
+            }
+        }
+        return m_value;
+    }
+
+    // Fetch a number of the type it was stored as, or of an integral type
+    // that holds it, without going through its text.  Returns false if
+    // the value must be converted from text.
+    template <typename T>
+    bool number(T& t) const
+        { return integral(t, std::is_integral<T>()); }
+
+    bool number(double& d) const
+    {
+        if (m_valueKind != DoubleValue)
+            return false;
+        d = m_double;
+        return true;
+    }
+
+    bool number(float& f) const
+    {
+        if (m_valueKind != FloatValue)
+            return false;
+        f = m_float;
+        return true;
+    }
+
+    template <typename T>
+    bool integral(T& t, std::true_type) const
+    {
+        // Characters and booleans convert from text differently than
+        // numbers do.
+        if (sizeof(T) == 1 || std::is_same<T, bool>::value)
+            return false;
+        if (m_valueKind == SignedValue && std::is_signed<T>::value &&
+            m_signed >= (int64_t)(std::numeric_limits<T>::min)() &&
+            m_signed <= (int64_t)(std::numeric_limits<T>::max)())
+        {
+            t = (T)m_signed;
+            return true;
+        }
+        if (m_valueKind == UnsignedValue && std::is_unsigned<T>::value &&
+            m_unsigned <= (uint64_t)(std::numeric_limits<T>::max)())
+        {
+            t = (T)m_unsigned;
+            return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    bool integral(T&, std::false_type) const
+        { return false; }
+
     MetadataImplList& subnodes(const std::string &name)
     {
         auto si = m_subnodes.find(name);
@@ -219,8 +384,16 @@ private:
 
     std::string m_name;
     std::string m_descrip;
-    std::string m_type;
-    std::string m_value;
+    TypeName m_type;
+    ValueKind m_valueKind;
+    union
+    {
+        int64_t m_signed;
+        uint64_t m_unsigned;
+        float m_float;
+        double m_double;
+    };
+    mutable std::string m_value;
     MetadataType::Enum m_kind;
     MetadataSubnodes m_subnodes;
 };
@@ -228,43 +401,43 @@ private:
 template <>
 inline void MetadataNodeImpl::setValue(const bool& b)
 {
-    m_type = "boolean";
-    m_value = b ? "true" : "false";
+    setText(BooleanType, b ? "true" : "false");
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const std::string& s)
 {
-    m_type = "string";
-    m_value = s;
+    setText(StringType, s);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const char * const & c)
 {
-    m_type = "string";
-    m_value = c;
+    setText(StringType, c);
 }
 
 template <std::size_t N>
 inline void MetadataNodeImpl::setValue(const char(& c)[N])
 {
-    m_type = "string";
-    m_value = c;
+    setText(StringType, c);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const float& f)
 {
-    m_type = "float";
-    m_value = boost::lexical_cast<std::string>(f);
+    m_type = FloatType;
+    m_valueKind = FloatValue;
+    m_float = f;
+    m_value.clear();
 }
 
 template <>
 inline void MetadataNodeImpl::setValue<double>(const double& d)
 {
-    m_type = "double";
-    m_value = boost::lexical_cast<std::string>(d);
+    m_type = DoubleType;
+    m_valueKind = DoubleValue;
+    m_double = d;
+    m_value.clear();
 }
 
 template <>
@@ -272,8 +445,7 @@ inline void MetadataNodeImpl::setValue(const SpatialReference& ref)
 {
     std::ostringstream oss;
     oss << ref;
-    m_type = "spatialreference";
-    m_value = oss.str();
+    setText(SpatialReferenceType, oss.str());
 }
 
 template <>
@@ -281,85 +453,73 @@ inline void MetadataNodeImpl::setValue(const BOX3D& b)
 {
     std::ostringstream oss;
     oss << b;
-    m_type = "bounds";
-    m_value = oss.str();
+    setText(BoundsType, oss.str());
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const unsigned char& u)
 {
-    m_type = "nonNegativeInteger";
-    m_value = boost::lexical_cast<std::string>((unsigned)u);
+    setUnsigned(u);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const unsigned short& u)
 {
-    m_type = "nonNegativeInteger";
-    m_value = boost::lexical_cast<std::string>(u);
+    setUnsigned(u);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const unsigned int& u)
 {
-    m_type = "nonNegativeInteger";
-    m_value = boost::lexical_cast<std::string>(u);
+    setUnsigned(u);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const unsigned long& u)
 {
-    m_type = "nonNegativeInteger";
-    m_value = boost::lexical_cast<std::string>(u);
+    setUnsigned(u);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const unsigned long long& u)
 {
-    m_type = "nonNegativeInteger";
-    m_value = boost::lexical_cast<std::string>(u);
+    setUnsigned(u);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const char& i)
 {
-    m_type = "integer";
-    m_value = boost::lexical_cast<std::string>((int)i);
+    setSigned(i);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const signed char& i)
 {
-    m_type = "integer";
-    m_value = boost::lexical_cast<std::string>((int)i);
+    setSigned(i);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const short& s)
 {
-    m_type = "integer";
-    m_value = boost::lexical_cast<std::string>(s);
+    setSigned(s);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const int& i)
 {
-    m_type = "integer";
-    m_value = boost::lexical_cast<std::string>(i);
+    setSigned(i);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const long& l)
 {
-    m_type = "integer";
-    m_value = boost::lexical_cast<std::string>(l);
+    setSigned(l);
 }
 
 template <>
 inline void MetadataNodeImpl::setValue(const long long& l)
 {
-    m_type = "integer";
-    m_value = boost::lexical_cast<std::string>(l);
+    setSigned(l);
 }
 
 template <>
@@ -367,24 +527,25 @@ inline void MetadataNodeImpl::setValue(const boost::uuids::uuid& u)
 {
     std::ostringstream oss;
     oss << u;
-    m_type = "uuid";
-    m_value = oss.str();
+    setText(UuidType, oss.str());
 }
 
 
 class PDAL_DLL MetadataNode
 {
     friend class Metadata;
+    friend class MetadataJsonWriter;
     friend inline
         bool operator == (const MetadataNode& m1, const MetadataNode& m2);
     friend inline
         bool operator != (const MetadataNode& m1, const MetadataNode& m2);
 
 public:
-    MetadataNode() : m_impl(new MetadataNodeImpl())
+    MetadataNode() : m_impl(MetadataNodeImpl::create())
         {}
 
-    MetadataNode(const std::string& name) : m_impl(new MetadataNodeImpl(name))
+    MetadataNode(const std::string& name) :
+        m_impl(MetadataNodeImpl::create(name))
         {}
 
     MetadataNode add(const std::string& name)
@@ -396,7 +557,7 @@ public:
     MetadataNode clone(const std::string& name)
     {
         MetadataNode node;
-        node.m_impl.reset(new MetadataNodeImpl(*m_impl));
+        node.m_impl = std::make_shared<MetadataNodeImpl>(*m_impl);
         node.m_impl->m_name = name;
         return node;
     }
@@ -413,7 +574,7 @@ public:
     {
         MetadataNodeImplPtr impl = m_impl->add(name);
         impl->setValue(Utils::base64_encode(buf, size));
-        impl->m_type = "base64Binary";
+        impl->m_type = MetadataNodeImpl::Base64BinaryType;
         impl->m_descrip = descrip;
         return MetadataNode(impl);
     }
@@ -424,7 +585,7 @@ public:
     {
         MetadataNodeImplPtr impl = m_impl->addList(name);
         impl->setValue(Utils::base64_encode(buf, size));
-        impl->m_type = "base64Binary";
+        impl->m_type = MetadataNodeImpl::Base64BinaryType;
         impl->m_descrip = descrip;
         return MetadataNode(impl);
     }
@@ -472,8 +633,8 @@ public:
         return m;
     }
 
-    std::string type() const
-        { return m_impl->m_type; }
+    const std::string& type() const
+        { return MetadataNodeImpl::typeName(m_impl->m_type); }
 
     MetadataType::Enum kind() const
         { return m_impl->m_kind; }
@@ -486,25 +647,25 @@ public:
     {
         T t;
 
-        if (m_impl->m_type == "base64Binary")
+        if (m_impl->m_type == MetadataNodeImpl::Base64BinaryType)
         {
             std::vector<uint8_t> encVal =
-                Utils::base64_decode(m_impl->m_value);
+                Utils::base64_decode(m_impl->value());
             encVal.resize(sizeof(T));
             memcpy(&t, encVal.data(), sizeof(T));
         }
-        else
+        else if (!m_impl->number(t))
         {
             try
             {
-                t = boost::lexical_cast<T>(m_impl->m_value);
+                t = boost::lexical_cast<T>(m_impl->value());
             }
             catch (boost::bad_lexical_cast&)
             {
                 // Static to get default initialization.
                 static T t2;
                 std::cerr << "Error converting metadata [" << name() <<
-                    "] = " << m_impl->m_value << " to type " <<
+                    "] = " << m_impl->value() << " to type " <<
                     Utils::typeidName<T>() << " -- return default initialized.";
                 t = t2;
             }
@@ -512,14 +673,15 @@ public:
         return t;
     }
 
-    std::string value() const
-        { return m_impl->m_value; }
+    const std::string& value() const
+        { return m_impl->value(); }
 
     std::string jsonValue() const
     {
         std::string val;
-        if (m_impl->m_type == "string" || m_impl->m_type == "base64Binary" ||
-            m_impl->m_type == "uuid")
+        if (m_impl->m_type == MetadataNodeImpl::StringType ||
+            m_impl->m_type == MetadataNodeImpl::Base64BinaryType ||
+            m_impl->m_type == MetadataNodeImpl::UuidType)
         {
             std::string val("\"");
             val += escapeQuotes(value()) + "\"";
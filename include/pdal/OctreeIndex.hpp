@@ -0,0 +1,108 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <pdal/pdal_export.hpp>
+#include <pdal/pdal_types.hpp>
+#include <pdal/util/Bounds.hpp>
+
+namespace pdal
+{
+
+class PointView;
+
+// The 3D counterpart of QuadIndex.  Each node of the tree holds the point
+// nearest the center of its bounds and passes the rest on to its eight
+// octants.  Depths are counted from 'topLevel' at the root, as with
+// QuadIndex.
+class PDAL_DLL OctreeIndex
+{
+public:
+    OctreeIndex(const PointView& view, std::size_t topLevel = 0);
+    ~OctreeIndex();
+
+    BOX3D getBounds() const;
+
+    std::size_t getDepth() const;
+
+    // Return the number of nodes at each level of the tree.
+    std::vector<std::size_t> getFills() const;
+
+    // Return all points at depth levels strictly less than depthEnd.
+    // A depthEnd value of zero returns all points in the tree.
+    std::vector<PointId> getPoints(std::size_t depthEnd = 0) const;
+
+    // Return all points at depth levels between [depthBegin, depthEnd).
+    // A depthEnd value of zero will return all points at levels >= depthBegin.
+    std::vector<PointId> getPoints(
+            std::size_t depthBegin,
+            std::size_t depthEnd) const;
+
+    // Return all points within the query box, searching only up to depth
+    // levels strictly less than depthEnd.  The box includes its faces.
+    std::vector<PointId> getPoints(
+            const BOX3D& box,
+            std::size_t depthEnd = 0) const;
+
+    // Return all points within the query box at depth levels between
+    // [depthBegin, depthEnd).
+    std::vector<PointId> getPoints(
+            const BOX3D& box,
+            std::size_t depthBegin,
+            std::size_t depthEnd) const;
+
+    // Voxelize a single level of the tree.  The bounds are split into a
+    // grid of 2^n voxels along each axis, where n is the level below the
+    // top, and the voxel at (x, y, z) is at ((z * 2^n) + y) * 2^n + x.
+    // Empty voxels contain std::numeric_limits<PointId>::max().
+    std::vector<PointId> getVoxels(
+            std::size_t depth,
+            double& xStep,
+            double& yStep,
+            double& zStep) const;
+
+private:
+    struct OImpl;
+    std::unique_ptr<OImpl> m_oImpl;
+
+    // Disable copying and assignment.
+    OctreeIndex(const OctreeIndex&);
+    OctreeIndex& operator=(OctreeIndex&);
+};
+
+} // namespace pdal
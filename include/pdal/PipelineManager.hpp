@@ -48,10 +48,54 @@ class Options;
 class PDAL_DLL PipelineManager
 {
 public:
-    PipelineManager() : m_tablePtr(new PointTable()), m_table(*m_tablePtr)
+    PipelineManager() : m_tablePtr(new PointTable()), m_table(*m_tablePtr),
+        m_concurrency(1), m_cacheHit(false)
         {}
-    PipelineManager(PointTableRef table) : m_table(table)
+    PipelineManager(PointTableRef table) : m_table(table), m_concurrency(1),
+        m_cacheHit(false)
         {}
+    // Use a point table that stores points in blocks of 'blockPtCnt'.
+    explicit PipelineManager(point_count_t blockPtCnt) :
+        m_tablePtr(new PointTable(BlockAllocatorPtr(new HeapAllocator),
+            blockPtCnt)), m_table(*m_tablePtr), m_concurrency(1),
+        m_cacheHit(false)
+        {}
+
+    // Limit the memory the manager's point table uses for point storage,
+    // spilling the rest to disk.  See PointTable::setMemoryBudget().
+    // Throws pdal_error if the manager was given a point table.
+    void setMemoryBudget(std::size_t bytes,
+        const std::string& spillDir = std::string());
+    // The number of bytes of point data spilled to disk.
+    uint64_t spilledBytes() const
+        { return m_tablePtr ? m_tablePtr->spilledBytes() : 0; }
+
+    // Run up to 'count' stages at once in execute() once their inputs have
+    // run, so that independent branches of the pipeline (the readers
+    // feeding a merge, say) overlap.  Stages run one at a time if 'count'
+    // is less than two or the point table isn't appendSafe().
+    void setConcurrency(std::size_t count)
+        { m_concurrency = count; }
+    std::size_t concurrency() const
+        { return m_concurrency; }
+
+    // Give every stage of the pipeline 'callback' when it's prepared, so
+    // that calling its interrupt() from any thread stops the whole
+    // pipeline.  The manager takes ownership.
+    void setUserCallback(UserCallback *callback)
+        { m_callback.reset(callback); }
+
+    // Keep a record in directory 'dir' of each run of execute() whose
+    // readers and writers all name files.  A later execute() with the same
+    // stages and options, over input files of the same size and time,
+    // skips running the pipeline if the files the recorded run wrote are
+    // as it left them.  It returns the recorded point count and leaves
+    // views() empty.  An empty 'dir' turns the cache off.
+    void setResultCache(const std::string& dir)
+        { m_cacheDir = dir; }
+    // Whether the last execute() reused a cached result.
+    bool cacheHit() const
+        { return m_cacheHit; }
 
     // Use these to manually add stages into the pipeline manager.
     Stage& addReader(const std::string& type);
@@ -65,9 +109,18 @@ public:
     // return the pipeline reader endpoint (or NULL, if not a reader pipeline)
     Stage* getStage() const
         { return m_stages.empty() ? NULL : m_stages.back().get(); }
+    // The stages that end the pipeline: the last stage added and any
+    // writer that no stage takes as input, such as the writers of a
+    // <Writers> element, which share their input.  execute() runs the
+    // stages feeding several writers once.
+    std::vector<Stage *> endpoints() const;
 
     void prepare() const;
     point_count_t execute();
+    // Prepare the pipeline with 'table' and execute it a chunk of points at
+    // a time.  See Stage::executeStream().  No views are retained.  Throws
+    // pdal_error if the pipeline has more than one endpoint.
+    point_count_t executeStream(FixedPointTable& table);
 
     // Get the resulting point views.
     const PointViewSet& views() const
@@ -83,12 +136,21 @@ private:
     StageFactory m_factory;
     std::unique_ptr<PointTable> m_tablePtr;
     PointTableRef m_table;
+    std::size_t m_concurrency;
+    std::shared_ptr<UserCallback> m_callback;
+    std::string m_cacheDir;
+    bool m_cacheHit;
 
     PointViewSet m_viewSet;
 
     typedef std::vector<std::unique_ptr<Stage> > StagePtrList;
     StagePtrList m_stages;
 
+    void shareCallback() const;
+    std::string cacheRecord() const;
+    bool readCacheRecord(const std::string& record, point_count_t& count);
+    void writeCacheRecord(const std::string& record, point_count_t count);
+
     PipelineManager& operator=(const PipelineManager&); // not implemented
     PipelineManager(const PipelineManager&); // not implemented
 };
@@ -72,7 +72,9 @@ private:
         const boost::property_tree::ptree& subtree);
     Stage *parseElement_Reader(const boost::property_tree::ptree& tree);
     Stage *parseElement_Filter(const boost::property_tree::ptree& tree);
-    Stage *parseElement_Writer(const boost::property_tree::ptree& tree);
+    Stage *parseElement_Writer(const boost::property_tree::ptree& tree,
+        Stage *input = NULL);
+    void parseElement_Writers(const boost::property_tree::ptree& tree);
     Option parseElement_Option(const boost::property_tree::ptree& tree);
     void collect_attributes(map_t& attrs,
         const boost::property_tree::ptree& tree);
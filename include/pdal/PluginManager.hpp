@@ -80,6 +80,13 @@ public:
         const PF_RegisterParams* params);
     const RegistrationMap& getRegistrationMap();
 
+    // Number of plugin libraries loaded and the seconds spent finding and
+    // loading them.
+    std::size_t loadedCount() const
+        { return m_dynamicLibraryMap.size(); }
+    double loadTime() const
+        { return m_loadTime; }
+
 private:
     ~PluginManager();
     PluginManager();
@@ -87,6 +94,7 @@ private:
 
     DynamicLibrary *loadLibrary(const std::string& path,
         std::string& errorString);
+    const std::vector<std::string>& pluginPaths();
 
     bool m_inInitializePlugin;
     PF_PluginAPI_Version m_version;
@@ -94,6 +102,11 @@ private:
     ExitFuncVec m_exitFuncVec;
     RegistrationMap m_tempExactMatchMap;
     RegistrationMap m_exactMatchMap;
+    // Libraries in the plugin directories, found the first time they're
+    // needed so that the directories are scanned only once.
+    std::vector<std::string> m_pluginPaths;
+    bool m_scanned;
+    double m_loadTime;
 };
 
 } // namespace pdal
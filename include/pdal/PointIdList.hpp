@@ -0,0 +1,235 @@
+/******************************************************************************
+* Copyright (c) 2014, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include <pdal/MemoryAccount.hpp>
+#include <pdal/pdal_types.hpp>
+
+namespace pdal
+{
+
+// Maps the point IDs of a view onto the IDs of points in its point table.
+//
+// A freshly read view usually refers to a run of consecutive table IDs.
+// Such a list is stored as just the first ID and a count, so filling a view
+// doesn't grow a vector and lookups are a single addition.  The list is
+// expanded into a contiguous vector the first time a change would break
+// the run.
+//
+// Expanded storage can be shared by several lists, each of which refers to
+// a range of it (see slice()).  Storage is copied before an element that
+// another list can see is changed.  A list may append to shared storage
+// without copying when it covers the end of the storage, since no other
+// list refers to anything past that.
+class PDAL_DLL PointIdList
+{
+public:
+    // Expanded storage, which is charged to the current memory account.
+    typedef memory::Vector<PointId, memory::ViewIndex> Ids;
+
+    PointIdList() : m_identity(true), m_first(0), m_size(0), m_offset(0)
+        {}
+
+    point_count_t size() const
+        { return m_size; }
+    bool empty() const
+        { return m_size == 0; }
+
+    // Whether entry i is simply first() + i for the whole list.
+    bool identity() const
+        { return m_identity; }
+    PointId first() const
+        { return m_first; }
+
+    PointId operator[](PointId i) const
+        { return m_identity ? m_first + i : (*m_ids)[m_offset + i]; }
+
+    void set(PointId i, PointId rawId)
+    {
+        if (m_identity)
+        {
+            if (rawId == m_first + i)
+                return;
+            expand();
+        }
+        detach();
+        (*m_ids)[i] = rawId;
+    }
+
+    void push_back(PointId rawId)
+    {
+        if (m_identity)
+        {
+            if (m_size == 0)
+                m_first = rawId;
+            if (rawId == m_first + m_size)
+            {
+                m_size++;
+                return;
+            }
+            expand();
+        }
+        if (!ownsTail())
+            detach();
+        m_ids->push_back(rawId);
+        m_size++;
+    }
+
+    // Append the 'count' consecutive IDs starting at 'first'.
+    void pushRange(PointId first, point_count_t count)
+    {
+        if (count == 0)
+            return;
+        if (m_identity && (m_size == 0 || first == m_first + m_size))
+        {
+            if (m_size == 0)
+                m_first = first;
+            m_size += count;
+            return;
+        }
+        expand();
+        if (!ownsTail())
+            detach();
+        std::size_t pos = m_ids->size();
+        m_ids->resize(pos + count);
+        std::iota(m_ids->begin() + pos, m_ids->end(), first);
+        m_size += count;
+    }
+
+    // Insert the first 'count' entries of 'src' before position 'pos'.
+    void insert(PointId pos, const PointIdList& src, point_count_t count)
+    {
+        if (count == 0)
+            return;
+        if (m_identity && src.m_identity && pos == m_size &&
+            (m_size == 0 || src.m_first == m_first + m_size))
+        {
+            if (m_size == 0)
+                m_first = src.m_first;
+            m_size += count;
+            return;
+        }
+        expand();
+        if (pos != m_size || !ownsTail())
+            detach();
+        Ids& ids(*m_ids);
+        if (src.m_identity)
+        {
+            ids.insert(ids.begin() + pos, count, 0);
+            std::iota(ids.begin() + pos, ids.begin() + pos + count,
+                src.m_first);
+        }
+        else
+        {
+            auto srcBegin = src.m_ids->begin() + src.m_offset;
+            // Copy first in case 'src' refers to our own storage.
+            std::vector<PointId> temp(srcBegin, srcBegin + count);
+            ids.insert(ids.begin() + pos, temp.begin(), temp.end());
+        }
+        m_size += count;
+    }
+
+    // Return a list of 'count' entries starting at 'begin' that shares
+    // this list's storage.
+    PointIdList slice(PointId begin, point_count_t count) const
+    {
+        PointIdList l(*this);
+        l.m_size = count;
+        if (m_identity)
+            l.m_first = m_first + begin;
+        else
+            l.m_offset = m_offset + begin;
+        return l;
+    }
+
+    void reserve(point_count_t count)
+    {
+        if (!m_identity && ownsTail())
+            m_ids->reserve(m_offset + count);
+    }
+
+    // Replace the entries with 'ids'.
+    void assign(Ids&& ids)
+    {
+        m_size = ids.size();
+        m_ids.reset(new Ids(std::move(ids)));
+        m_offset = 0;
+        m_identity = false;
+    }
+
+    // Pointer to contiguous storage of the IDs.  This forces the list
+    // to be expanded.
+    const PointId *data()
+    {
+        expand();
+        return m_ids->data() + m_offset;
+    }
+
+private:
+    bool m_identity;
+    PointId m_first;
+    point_count_t m_size;
+    std::shared_ptr<Ids> m_ids;
+    point_count_t m_offset;
+
+    bool ownsTail() const
+        { return m_offset + m_size == m_ids->size(); }
+
+    void expand()
+    {
+        if (!m_identity)
+            return;
+        m_ids.reset(new Ids(m_size));
+        std::iota(m_ids->begin(), m_ids->end(), m_first);
+        m_offset = 0;
+        m_identity = false;
+    }
+
+    // Make sure this list has storage of its own, exactly 'm_size' long.
+    void detach()
+    {
+        if (m_ids.use_count() == 1 && m_offset == 0 && ownsTail())
+            return;
+        auto begin = m_ids->begin() + m_offset;
+        m_ids.reset(new Ids(begin, begin + m_size));
+        m_offset = 0;
+    }
+};
+
+} // namespace pdal
@@ -35,8 +35,10 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "pdal/Dimension.hpp"
@@ -44,13 +46,20 @@
 namespace pdal
 {
 
+class PointView;
+
 class PDAL_DLL PointLayout
 {
 public:
+    // Fills 'out' with one value for each point in 'view', in order.
+    typedef std::function<void(PointView& view, double *out)> ComputeFunc;
+
     PointLayout();
     virtual ~PointLayout() {}
 
     void finalize();
+    bool finalized() const
+        { return m_finalized; }
 
     void registerDims(std::vector<Dimension::Id::Enum> ids);
     void registerDims(Dimension::Id::Enum *id);
@@ -61,6 +70,23 @@ public:
     // is already larger, this does nothing.
     void registerDim(Dimension::Id::Enum id, Dimension::Type::Enum type);
 
+    // Register the dimension to be stored as a value of 'type' (normally
+    // an integer type) that is scaled by 'xform' when it's read or written.
+    // A value v is stored as (v - xform.m_offset) / xform.m_scale.  If the
+    // dimension is registered in any other way, it's stored unscaled as a
+    // double.
+    void registerScaledDim(Dimension::Id::Enum id, Dimension::Type::Enum type,
+        const XForm& xform);
+
+    // Register the dimension as an unsigned byte whose values fit in
+    // 'bits' bits (1 to 8).  Packed dimensions share bytes at the end of
+    // the point, so several small fields (return numbers, flags) take a
+    // byte between them rather than a byte or more each.  Setting a value
+    // that doesn't fit is an error.  If the dimension is registered with
+    // any other type it's stored unpacked.  Throws pdal_error if 'bits' is
+    // out of range.
+    void registerPackedDim(Dimension::Id::Enum id, int bits);
+
     // The type and size are REQUESTS, not absolutes.  If someone else
     // has already registered with the same name, you get the existing
     // dimension size/type.
@@ -69,9 +95,25 @@ public:
             Dimension::Type::Enum type);
 
     Dimension::Id::Enum registerOrAssignDim(
-            const std::string name,
+            const std::string& name,
             Dimension::Type::Enum type);
 
+    // Register a dimension whose values aren't stored but are computed
+    // from the dimensions in 'deps' when first read.  Values are doubles,
+    // computed a block of points at a time and cached by the point table
+    // until one of 'deps' is set through a view.  Computed dimensions
+    // can't be set.  Registering the dimension in any other way makes it
+    // an ordinary, stored dimension.
+    void registerComputedDim(Dimension::Id::Enum id,
+        const Dimension::IdList& deps, ComputeFunc func);
+    Dimension::Id::Enum assignComputedDim(const std::string& name,
+        const Dimension::IdList& deps, ComputeFunc func);
+
+    // @return the function that computes a computed dimension.
+    const ComputeFunc& computeFunc(Dimension::Id::Enum id) const;
+    // @return the computed dimensions whose values depend on 'id'.
+    const Dimension::IdList& dependents(Dimension::Id::Enum id) const;
+
     DimTypeList dimTypes() const;
     DimType findDimType(const std::string& name) const;
     Dimension::Id::Enum findDim(const std::string& name) const;
@@ -84,13 +126,16 @@ public:
     // @return reference to vector of currently used dimensions
     const Dimension::IdList& dims() const;
 
-    // @return the current type for a given id
+    // @return the current type for a given id.  Scaled dimensions are
+    //         doubles as far as users of the layout are concerned; the
+    //         type in which they are stored is in the dimension's detail.
     Dimension::Type::Enum dimType(Dimension::Id::Enum id) const;
 
     // @return the current size in bytes of the dimension
     //         with the given id.
     size_t dimSize(Dimension::Id::Enum id) const;
     size_t dimOffset(Dimension::Id::Enum id) const;
+    // @return the number of bytes used to store a point.
     size_t pointSize() const;
 
     const Dimension::Detail *dimDetail(Dimension::Id::Enum id) const;
@@ -101,11 +146,18 @@ private:
     Dimension::Type::Enum resolveType(
             Dimension::Type::Enum t1,
             Dimension::Type::Enum t2);
+    Dimension::Detail storedDetail(Dimension::Id::Enum id) const;
+    void updateComputed(const Dimension::Detail& dd,
+        const Dimension::IdList& deps, ComputeFunc func);
 
 protected:
     std::vector<Dimension::Detail> m_detail;
     Dimension::IdList m_used;
-    std::map<std::string, Dimension::Id::Enum> m_propIds;
+    std::unordered_map<std::string, Dimension::Id::Enum> m_propIds;
+    // Names of the proprietary dimensions, indexed from PROPRIETARY.
+    std::vector<std::string> m_propNames;
+    std::unordered_map<int, ComputeFunc> m_computeFuncs;
+    std::unordered_map<int, Dimension::IdList> m_dependents;
     int m_nextFree;
     std::size_t m_pointSize;
     bool m_finalized;
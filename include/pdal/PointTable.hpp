@@ -34,10 +34,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "pdal/BlockAllocator.hpp"
 #include "pdal/Dimension.hpp"
 #include "pdal/PointLayout.hpp"
 #include "pdal/Metadata.hpp"
@@ -50,7 +59,8 @@ class PDAL_DLL BasePointTable
     friend class PointView;
 
 public:
-    BasePointTable() : m_metadata(new Metadata())
+    BasePointTable() : m_coordsChanged(false), m_coordsGeneration(0),
+            m_hasComputed(false), m_metadata(new Metadata())
         {}
     virtual ~BasePointTable()
         {}
@@ -59,6 +69,27 @@ public:
     // Layout operations.
     virtual PointLayoutPtr layout() const = 0;
 
+    // Storage operations.
+    // Make room for 'count' points beyond those already in the table so
+    // that adding them allocates no more memory.  Readers that know the
+    // number of points they'll add should call this from ready().  Tables
+    // that can't make use of the hint ignore it.
+    virtual void reserve(point_count_t count)
+        {}
+    // Whether fields of existing points can be read and set from several
+    // threads at once, provided no two threads use the same point and no
+    // points are added meanwhile.
+    virtual bool threadSafe() const
+        { return false; }
+    // Whether points can be added from several threads at once while other
+    // threads read and set fields of points already added.  Each thread
+    // may only use the points it added or was handed by another.
+    virtual bool appendSafe() const
+        { return false; }
+    // The number of bytes of memory allocated to hold points, if known.
+    virtual uint64_t storageBytes() const
+        { return 0; }
+
     // Metadata operations.
     MetadataNode metadata()
         { return m_metadata->getNode(); }
@@ -73,13 +104,93 @@ private:
         const void *value) = 0;
     virtual void getField(const Dimension::Detail *d, PointId idx,
         void *value) = 0;
+    // Copy the values of dimension 'from' to dimension 'to', which must be
+    // of the same type, for the 'count' points starting at 'idx'.
+    virtual void copyField(const Dimension::Detail *from,
+        const Dimension::Detail *to, PointId idx, point_count_t count);
+    // Memory holding dimension 'd' of the 'count' points starting at 'idx',
+    // with 'stride' set to the bytes between the values of consecutive
+    // points, or NULL if the values aren't evenly spaced in memory.
+    virtual char *getFieldSpan(const Dimension::Detail * /*d*/,
+            PointId /*idx*/, point_count_t /*count*/,
+            std::ptrdiff_t& /*stride*/)
+        { return NULL; }
+    // Copy the bytes holding packed dimension 'd' of the 'count' points
+    // starting at 'idx' to 'out'.  Bits of other packed dimensions stored
+    // in the same bytes may be copied too, or left clear.
+    virtual void getPackedBytes(const Dimension::Detail *d, PointId idx,
+        point_count_t count, uint8_t *out);
+
+    // Note that X, Y or Z of points in the table may have been set, so
+    // that bounds cached by views of the table are recomputed.  Views
+    // call this for every such set, from any thread, so the flag is only
+    // written when it isn't already set.
+    void coordsChanged()
+    {
+        if (!m_coordsChanged.load(std::memory_order_relaxed))
+            m_coordsChanged.store(true, std::memory_order_relaxed);
+    }
+    // A count that advances whenever X, Y or Z values have been set since
+    // it was last asked for.
+    uint64_t coordsGeneration()
+    {
+        if (m_coordsChanged.exchange(false))
+            return ++m_coordsGeneration;
+        return m_coordsGeneration.load();
+    }
+
+    std::atomic<bool> m_coordsChanged;
+    std::atomic<uint64_t> m_coordsGeneration;
+
+    // Values of computed dimensions (see
+    // PointLayout::registerComputedDim()), kept by dimension and block of
+    // point ids.
+    struct ComputedBlock
+    {
+        std::vector<double> m_values;
+        std::vector<char> m_valid;
+    };
+    static const point_count_t ComputedBlockPtCnt = 4096;
+
+    static uint64_t computedKey(Dimension::Id::Enum id, PointId idx)
+        { return ((uint64_t)id << 48) | (idx / ComputedBlockPtCnt); }
+    // Get the cached value of computed dimension 'id' of point 'idx'.
+    // Returns false if there is none.
+    bool getComputed(Dimension::Id::Enum id, PointId idx, double& value);
+    void setComputed(Dimension::Id::Enum id, const PointId *ids,
+        const double *values, point_count_t count);
+    // Discard the cached values of point 'idx' that depend on 'id'.
+    void clearDependents(Dimension::Id::Enum id, PointId idx);
+    bool hasComputed() const
+        { return m_hasComputed.load(std::memory_order_relaxed); }
+
+    std::mutex m_computedMutex;
+    std::unordered_map<uint64_t, ComputedBlock> m_computed;
+    std::atomic<bool> m_hasComputed;
 
 protected:
+    // Add 'count' points with consecutive IDs and return the ID of the
+    // first.  Tables that are appendSafe() claim the whole range at once,
+    // so threads adding ranges only contend when blocks are allocated.
+    virtual PointId reserveRange(point_count_t count);
+    // Discard all cached values of computed dimensions.  Called when the
+    // ids of points are reused.
+    void clearComputed();
+    // Wrap the allocator of a table's storage so that its blocks are
+    // charged to the memory account of the stage that allocates them.
+    static BlockAllocatorPtr accounted(BlockAllocatorPtr allocator)
+        { return BlockAllocatorPtr(new AccountingAllocator(allocator)); }
+    static BlockAllocatorPtr accounted(BlockAllocator *allocator)
+        { return accounted(BlockAllocatorPtr(allocator)); }
+
     MetadataPtr m_metadata;
 };
 typedef BasePointTable& PointTableRef;
 
 
+// The default number of points in each memory block of a point table.
+static const point_count_t DefaultBlockPtCnt = 65536;
+
 // This provides a context for processing a set of points and allows the library
 // to be used to process multiple point sets simultaneously.
 class PDAL_DLL PointTable : public BasePointTable
@@ -87,29 +198,125 @@ class PDAL_DLL PointTable : public BasePointTable
 private:
     // Point storage.
     std::vector<char *> m_blocks;
-    point_count_t m_numPts;
+    // Memory obtained from the allocator.  Blocks are carved from these
+    // so that a reservation is a single allocation.
+    std::vector<std::pair<char *, std::size_t>> m_slabs;
+    std::atomic<point_count_t> m_numPts;
     std::unique_ptr<PointLayout> m_layout;
+    BlockAllocatorPtr m_allocator;
+    // The number of points in each memory block.
+    point_count_t m_blockPtCnt;
+
+    // Concurrent addition.  Points are read through m_blockPtrs, which is
+    // only changed once the blocks it lists are ready.  Block lists that
+    // have been replaced are kept in m_oldBlockLists since other threads
+    // may still be reading them.
+    std::atomic<char **> m_blockPtrs;
+    std::atomic<point_count_t> m_capacity;
+    std::vector<std::vector<char *>> m_oldBlockLists;
+    std::mutex m_addMutex;
+
+    // Spilling.  When a memory budget is set, blocks beyond the budget are
+    // written to a temporary file, least recently used first, and their
+    // entries in m_blocks are set to NULL until they're read back.
+    std::size_t m_memoryBudget;
+    std::string m_spillDir;
+    std::FILE *m_spillFile;
+    // Blocks in memory, most recently used first.
+    std::list<std::size_t> m_lru;
+    std::vector<std::list<std::size_t>::iterator> m_lruPos;
+    // Position of each block in the spill file, or -1 if never spilled.
+    std::vector<int64_t> m_spillPos;
+    int64_t m_spillEnd;
+    std::size_t m_lastBlock;
+    uint64_t m_spilledBytes;
+    uint64_t m_loadedBytes;
 
 public:
-    PointTable() : m_numPts(0), m_layout(new PointLayout())
+    PointTable() : m_numPts(0), m_layout(new PointLayout()),
+        m_allocator(accounted(new HeapAllocator)),
+        m_blockPtCnt(DefaultBlockPtCnt), m_blockPtrs(NULL), m_capacity(0),
+        m_memoryBudget(0), m_spillFile(NULL), m_spillEnd(0), m_lastBlock(0),
+        m_spilledBytes(0), m_loadedBytes(0)
+        {}
+    // Use 'allocator' to provide the memory in which points are stored,
+    // in blocks of 'blockPtCnt' points.
+    PointTable(BlockAllocatorPtr allocator,
+            point_count_t blockPtCnt = DefaultBlockPtCnt) :
+        m_numPts(0), m_layout(new PointLayout()),
+        m_allocator(accounted(allocator)), m_blockPtCnt(blockPtCnt),
+        m_blockPtrs(NULL), m_capacity(0),
+        m_memoryBudget(0), m_spillFile(NULL), m_spillEnd(0), m_lastBlock(0),
+        m_spilledBytes(0), m_loadedBytes(0)
         {}
     virtual ~PointTable();
 
     virtual PointLayoutPtr layout() const
         { return m_layout.get(); }
 
+    virtual void reserve(point_count_t count);
+    // The number of points the table can hold without allocating memory.
+    point_count_t capacity() const
+        { return m_capacity; }
+    point_count_t blockSize() const
+        { return m_blockPtCnt; }
+    // Set the number of points in each memory block.  Larger blocks mean
+    // fewer allocations; smaller ones waste less memory on small point
+    // sets.  Throws pdal_error if storage has already been allocated.
+    void setBlockSize(point_count_t blockPtCnt);
+    // Limit the memory used for point storage to about 'bytes' (at least
+    // two blocks are always kept in memory).  Blocks that don't fit are
+    // spilled to a temporary file in 'spillDir', or the system's temporary
+    // directory if it's empty, and read back when they're accessed.  A
+    // budget of 0 means no limit.  Throws pdal_error if storage has already
+    // been allocated.
+    void setMemoryBudget(std::size_t bytes,
+        const std::string& spillDir = std::string());
+    std::size_t memoryBudget() const
+        { return m_memoryBudget; }
+    // Reading a spilled block changes which blocks are in memory.
+    virtual bool threadSafe() const
+        { return m_memoryBudget == 0; }
+    virtual bool appendSafe() const
+        { return m_memoryBudget == 0; }
+    virtual uint64_t storageBytes() const
+        { return (uint64_t)capacity() * m_layout->pointSize(); }
+    // The number of bytes written to the spill file.
+    uint64_t spilledBytes() const
+        { return m_spilledBytes; }
+    // The number of bytes read back from the spill file.
+    uint64_t loadedBytes() const
+        { return m_loadedBytes; }
+
 private:
     // Point data operations.
     virtual PointId addPoint();
-    virtual char *getPoint(PointId idx);
+    virtual PointId reserveRange(point_count_t count);
+    virtual char *getPoint(PointId idx)
+    {
+        std::size_t block = idx / m_blockPtCnt;
+        char *buf = m_blockPtrs.load(std::memory_order_acquire)[block];
+        if (m_memoryBudget && block != m_lastBlock)
+            buf = touchBlock(block);
+        return buf + pointsToBytes(idx % m_blockPtCnt);
+    }
     virtual void setField(const Dimension::Detail *d, PointId idx,
         const void *value);
     virtual void getField(const Dimension::Detail *d, PointId idx,
         void *value);
+    virtual void copyField(const Dimension::Detail *from,
+        const Dimension::Detail *to, PointId idx, point_count_t count);
+    virtual char *getFieldSpan(const Dimension::Detail *d, PointId idx,
+        point_count_t count, std::ptrdiff_t& stride);
+    virtual void getPackedBytes(const Dimension::Detail *d, PointId idx,
+        point_count_t count, uint8_t *out);
 
-    // The number of points in each memory block.
-    static const point_count_t m_blockPtCnt = 65536;
-
+    void allocateBlocks(std::size_t count);
+    void addBlock(char *buf);
+    std::size_t residentLimit() const;
+    char *touchBlock(std::size_t block);
+    char *evictBlock();
+    void openSpillFile();
     char *getDimension(const Dimension::Detail *d, PointId idx)
         { return getPoint(idx) + d->offset(); }
 
@@ -117,5 +324,369 @@ private:
         { return m_layout->pointSize() * numPts; }
 };
 
+
+// Point storage that keeps the values of each dimension in its own
+// contiguous array rather than packing them into rows.  Stages that only
+// touch a few dimensions of a wide layout (X/Y/Z of a LAS 1.4 file, say)
+// pull far fewer bytes through the cache than with PointTable.
+class PDAL_DLL ColumnPointTable : public BasePointTable
+{
+private:
+    struct Column
+    {
+        Column(std::size_t size) : m_size(size)
+            {}
+
+        std::vector<char *> m_blocks;
+        std::size_t m_size;
+    };
+
+    // Point storage.
+    std::vector<Column> m_columns;
+    // Maps a dimension's offset in the layout to its column.  Offsets are
+    // fixed once the layout is finalized and are unique for each dimension
+    // but packed ones, which share the column of their byte.
+    std::vector<std::size_t> m_colIndex;
+    // Memory obtained from the allocator, as in PointTable.
+    std::vector<std::pair<char *, std::size_t>> m_slabs;
+    point_count_t m_numPts;
+    std::unique_ptr<PointLayout> m_layout;
+    BlockAllocatorPtr m_allocator;
+    // The number of points in each memory block.
+    point_count_t m_blockPtCnt;
+    // The number of blocks allocated for each column.
+    std::size_t m_numBlocks;
+
+public:
+    ColumnPointTable() : m_numPts(0), m_layout(new PointLayout()),
+        m_allocator(accounted(new HeapAllocator)),
+        m_blockPtCnt(DefaultBlockPtCnt), m_numBlocks(0)
+        {}
+    // Use 'allocator' to provide the memory in which points are stored,
+    // in blocks of 'blockPtCnt' points.
+    ColumnPointTable(BlockAllocatorPtr allocator,
+            point_count_t blockPtCnt = DefaultBlockPtCnt) :
+        m_numPts(0), m_layout(new PointLayout()),
+        m_allocator(accounted(allocator)), m_blockPtCnt(blockPtCnt),
+        m_numBlocks(0)
+        {}
+    virtual ~ColumnPointTable();
+
+    virtual PointLayoutPtr layout() const
+        { return m_layout.get(); }
+    virtual bool threadSafe() const
+        { return true; }
+    virtual uint64_t storageBytes() const
+        { return (uint64_t)capacity() * m_layout->pointSize(); }
+
+    virtual void reserve(point_count_t count);
+    // The number of points the table can hold without allocating memory.
+    point_count_t capacity() const
+        { return m_numBlocks * m_blockPtCnt; }
+    point_count_t blockSize() const
+        { return m_blockPtCnt; }
+    // Set the number of points in each memory block.  Throws pdal_error if
+    // storage has already been allocated.
+    void setBlockSize(point_count_t blockPtCnt);
+
+private:
+    // Point data operations.
+    virtual PointId addPoint();
+    virtual char *getPoint(PointId idx);
+    virtual void setField(const Dimension::Detail *d, PointId idx,
+        const void *value);
+    virtual void getField(const Dimension::Detail *d, PointId idx,
+        void *value);
+    virtual void copyField(const Dimension::Detail *from,
+        const Dimension::Detail *to, PointId idx, point_count_t count);
+    virtual char *getFieldSpan(const Dimension::Detail *d, PointId idx,
+        point_count_t count, std::ptrdiff_t& stride);
+    virtual void getPackedBytes(const Dimension::Detail *d, PointId idx,
+        point_count_t count, uint8_t *out);
+
+    void initColumns();
+    void allocateBlocks(std::size_t count);
+    char *getDimension(const Dimension::Detail *d, PointId idx)
+    {
+        Column& c = m_columns[m_colIndex[d->offset()]];
+        return c.m_blocks[idx / m_blockPtCnt] +
+            (c.m_size * (idx % m_blockPtCnt));
+    }
+};
+
+
+// Read-only point storage for uncompressed, point-major files.  The point
+// records of the file are mapped into memory and their fields are decoded
+// on access, so a file need not fit in memory and isn't decoded up front.
+// A reader describes the records with mapFile() and mapDim() in its
+// ready() and then adds the points to its views with
+// PointView::appendTablePoints().  Fields of mapped points that aren't in
+// the file (those added by filters, say) and all fields of points added
+// later are kept in a side table.  Setting a mapped field of a mapped point
+// is an error.
+class PDAL_DLL MappedPointTable : public BasePointTable
+{
+private:
+    // Description of a dimension as stored in a mapped record.
+    struct MappedDim
+    {
+        MappedDim() : m_type(Dimension::Type::None), m_pos(0), m_scale(1.0),
+            m_offset(0.0), m_shift(0), m_mask(0)
+            {}
+
+        Dimension::Type::Enum m_type;
+        std::size_t m_pos;
+        double m_scale;
+        double m_offset;
+        int m_shift;
+        uint64_t m_mask;
+    };
+
+    struct Column
+    {
+        Column(std::size_t size) : m_size(size)
+            {}
+
+        std::vector<char *> m_blocks;
+        std::size_t m_size;
+    };
+
+    // Mapped storage.
+    char *m_map;
+    std::size_t m_mapSize;
+    const char *m_records;
+    point_count_t m_mappedCnt;
+    std::size_t m_recordSize;
+    // Indexed by slot(), as packed dimensions share their offsets.
+    std::vector<MappedDim> m_mappedDims;
+    // Side storage.  Blocks are allocated as they're written so that
+    // dimensions that are never set take no memory.
+    std::vector<Column> m_columns;
+    std::vector<std::size_t> m_colIndex;
+    point_count_t m_numPts;
+    std::unique_ptr<PointLayout> m_layout;
+    BlockAllocatorPtr m_allocator;
+
+public:
+    MappedPointTable() : m_map(NULL), m_mapSize(0), m_records(NULL),
+        m_mappedCnt(0), m_recordSize(0), m_numPts(0),
+        m_layout(new PointLayout()),
+        m_allocator(accounted(new HeapAllocator))
+        {}
+    virtual ~MappedPointTable();
+
+    virtual PointLayoutPtr layout() const
+        { return m_layout.get(); }
+
+    // Map 'count' records of 'recordSize' bytes that start 'offset' bytes
+    // into 'filename'.  The layout must be finalized and no points may have
+    // been added.  Throws pdal_error if the file can't be mapped.
+    void mapFile(const std::string& filename, uint64_t offset,
+        point_count_t count, std::size_t recordSize);
+    // Describe dimension 'id' as stored at byte 'pos' of each record with
+    // little-endian type 'type'.  The value stored is multiplied by 'scale'
+    // and 'offset' is added before conversion to the layout's type.
+    void mapDim(Dimension::Id::Enum id, std::size_t pos,
+        Dimension::Type::Enum type, double scale = 1.0, double offset = 0.0);
+    // Describe dimension 'id' as a field of 'bits' bits that starts at bit
+    // 'shift' of the unsigned byte at 'pos' of each record.
+    void mapBits(Dimension::Id::Enum id, std::size_t pos, int shift,
+        int bits);
+    bool mapped() const
+        { return m_records != NULL; }
+    point_count_t mappedCount() const
+        { return m_mappedCnt; }
+    // Returns true iff values of dimension 'id' come from the mapped file.
+    bool isMapped(Dimension::Id::Enum id) const;
+
+private:
+    // Point data operations.
+    virtual PointId addPoint();
+    // Mapped points are returned in the record format of the file, not
+    // that of the layout.
+    virtual char *getPoint(PointId idx);
+    virtual void setField(const Dimension::Detail *d, PointId idx,
+        const void *value);
+    virtual void getField(const Dimension::Detail *d, PointId idx,
+        void *value);
+
+    // The number of points in each memory block.
+    static const point_count_t m_blockPtCnt = 65536;
+
+    void initColumns();
+    char *getSideDimension(const Dimension::Detail *d, PointId idx,
+        bool create);
+    void getMappedField(const MappedDim& m, const Dimension::Detail *d,
+        PointId idx, void *value) const;
+    void unmap();
+    std::size_t slot(const Dimension::Detail *d) const
+        { return d->offset() * 8 + d->shift(); }
+};
+
+
+// Point storage backed by arrays that the caller owns, so that points an
+// application already holds can be processed without copying them.  Each
+// dimension given with addArray() is read from and written to the
+// caller's array for the first 'count' points, which a BufferReader given
+// the table with addExternal() reads.  An array may be a column of values
+// or a field of an array of records, with 'stride' the bytes between the
+// values of consecutive points.  Dimensions without an array and all
+// fields of points added later are kept in side storage by the table.
+// The arrays must outlive the table.
+class PDAL_DLL ExternalPointTable : public BasePointTable
+{
+private:
+    // The caller's array of the values of a dimension.
+    struct Array
+    {
+        Array() : m_type(Dimension::Type::None), m_data(NULL), m_stride(0)
+            {}
+
+        Dimension::Type::Enum m_type;
+        char *m_data;
+        std::ptrdiff_t m_stride;
+    };
+
+    struct Column
+    {
+        Column(std::size_t size, bool external) : m_size(size),
+                m_external(external)
+            {}
+
+        std::vector<char *> m_blocks;
+        std::size_t m_size;
+        // Whether the external points' values of the column are held in an
+        // array, so its blocks of only external points aren't allocated.
+        bool m_external;
+    };
+
+    point_count_t m_externalCnt;
+    std::map<Dimension::Id::Enum, Array> m_arrays;
+    // Arrays by the offset of their dimension in the layout.
+    std::vector<Array> m_offsetArrays;
+    std::vector<Column> m_columns;
+    std::vector<std::size_t> m_colIndex;
+    point_count_t m_numPts;
+    std::unique_ptr<PointLayout> m_layout;
+    BlockAllocatorPtr m_allocator;
+    uint64_t m_sideBytes;
+
+public:
+    // A table whose first 'count' points are held in the caller's arrays.
+    explicit ExternalPointTable(point_count_t count) : m_externalCnt(count),
+        m_numPts(0), m_layout(new PointLayout()),
+        m_allocator(accounted(new HeapAllocator)), m_sideBytes(0)
+        {}
+    virtual ~ExternalPointTable();
+
+    virtual PointLayoutPtr layout() const
+        { return m_layout.get(); }
+    // Side storage is allocated as points are added, so fields can be set
+    // from several threads.
+    virtual bool threadSafe() const
+        { return true; }
+    virtual uint64_t storageBytes() const
+        { return m_sideBytes; }
+
+    // Hold dimension 'id' of the external points in the caller's array of
+    // values of type 'type' at 'data', 'stride' bytes apart (the size of
+    // the type when 0).  Registers the dimension with the layout.  Throws
+    // pdal_error once the layout is finalized.
+    void addArray(Dimension::Id::Enum id, Dimension::Type::Enum type,
+        void *data, std::ptrdiff_t stride = 0);
+    point_count_t externalCount() const
+        { return m_externalCnt; }
+    // Add the external points to 'view', a view of this table.  Throws
+    // pdal_error if the table already holds points.
+    void appendExternal(PointView& view);
+
+private:
+    // Point data operations.
+    virtual PointId addPoint();
+    virtual char *getPoint(PointId idx);
+    virtual void setField(const Dimension::Detail *d, PointId idx,
+        const void *value);
+    virtual void getField(const Dimension::Detail *d, PointId idx,
+        void *value);
+    virtual char *getFieldSpan(const Dimension::Detail *d, PointId idx,
+        point_count_t count, std::ptrdiff_t& stride);
+
+    // The number of points in each block of side storage.
+    static const point_count_t m_blockPtCnt = 65536;
+
+    void initColumns();
+    char *getSideDimension(const Dimension::Detail *d, PointId idx)
+    {
+        Column& c = m_columns[m_colIndex[d->offset()]];
+        return c.m_blocks[idx / m_blockPtCnt] +
+            (c.m_size * (idx % m_blockPtCnt));
+    }
+    // The array holding dimension 'd' of point 'idx', if any.
+    const Array *array(const Dimension::Detail *d, PointId idx) const
+    {
+        if (idx >= m_externalCnt || d->packed())
+            return NULL;
+        const Array& a = m_offsetArrays[d->offset()];
+        return a.m_data ? &a : NULL;
+    }
+};
+
+
+// Point storage for a fixed number of points, used for streaming execution
+// (see Stage::executeStream()).  A reader fills the table a chunk at a time
+// and the table is reset before the next chunk, so memory use doesn't
+// depend on the number of points processed.  A table with more than one
+// chunk slot lets the stages of a pipeline work on different chunks at
+// once.
+class PDAL_DLL FixedPointTable : public BasePointTable
+{
+public:
+    FixedPointTable(point_count_t capacity, int slots = 1) :
+        m_layout(new PointLayout()), m_capacity(capacity),
+        m_slots((std::max)(slots, 1)), m_base(0), m_numPts(0)
+        {}
+
+    virtual PointLayoutPtr layout() const
+        { return m_layout.get(); }
+    // Number of points in a chunk.
+    point_count_t capacity() const
+        { return m_capacity; }
+    virtual uint64_t storageBytes() const
+        { return m_buf.size(); }
+    // Number of chunks the table can hold at once.
+    int slots() const
+        { return m_slots; }
+    virtual bool threadSafe() const
+        { return true; }
+    // Discard all points so that their storage can be reused.
+    void reset()
+        { startChunk(0); }
+    // Discard the points in a chunk slot and add points to it from now on.
+    // Points in other slots are unaffected.
+    void startChunk(int slot)
+        { m_base = slot * m_capacity; m_numPts = 0; clearComputed(); }
+    // Set every field of the points in a chunk slot to zero, for readers
+    // that don't set all of the dimensions in the layout.
+    void zeroChunk(int slot);
+
+private:
+    std::unique_ptr<PointLayout> m_layout;
+    memory::Vector<char, memory::TableBlocks> m_buf;
+    point_count_t m_capacity;
+    int m_slots;
+    PointId m_base;
+    point_count_t m_numPts;
+
+    virtual PointId addPoint();
+    virtual char *getPoint(PointId idx)
+        { return m_buf.data() + idx * m_layout->pointSize(); }
+    virtual void setField(const Dimension::Detail *d, PointId idx,
+        const void *value);
+    virtual void getField(const Dimension::Detail *d, PointId idx,
+        void *value);
+    virtual void getPackedBytes(const Dimension::Detail *d, PointId idx,
+        point_count_t count, uint8_t *out);
+};
+
 } //namespace
 
@@ -36,14 +36,15 @@
 
 #include <pdal/util/Bounds.hpp>
 #include <pdal/pdal_internal.hpp>
+#include <pdal/PointIdList.hpp>
 #include <pdal/PointLayout.hpp>
 #include <pdal/PointTable.hpp>
 
+#include <atomic>
 #include <memory>
 #include <queue>
 #include <set>
 #include <vector>
-#include <deque>
 
 #ifdef PDAL_COMPILER_MSVC
 #  pragma warning(disable: 4244)  // conversion from 'type1' to 'type2', possible loss of data
@@ -57,6 +58,36 @@ namespace plang
 }
 
 struct PointViewLess;
+
+/// A dimension resolved against a point layout for access as values of
+/// type T.  The dimension's detail is looked up once when the handle is
+/// made, and when T is the type in which the dimension is stored, values
+/// are copied to and from the point table without conversion.
+template<typename T>
+class DimHandle
+{
+    friend class PointView;
+public:
+    DimHandle() : m_detail(NULL), m_native(false)
+    {}
+    explicit DimHandle(const Dimension::Detail *detail) : m_detail(detail),
+        m_native(detail && !detail->scaled() && !detail->computed() &&
+            detail->type() == Dimension::type<T>())
+    {}
+
+    bool valid() const
+        { return m_detail && m_detail->type() != Dimension::Type::None; }
+    Dimension::Id::Enum id() const
+        { return m_detail ? m_detail->id() : Dimension::Id::Unknown; }
+    /// \return  Whether T is the type in which the dimension is stored.
+    bool native() const
+        { return m_native; }
+
+private:
+    const Dimension::Detail *m_detail;
+    bool m_native;
+};
+class KDIndex;
 class PointView;
 class PointViewIter;
 
@@ -70,9 +101,11 @@ class PDAL_DLL PointView
     friend struct PointViewLess;
 public:
     PointView(PointTableRef pointTable) : m_pointTable(pointTable),
-        m_size(0), m_id(0)
+        m_size(0), m_id(0), m_boundsDims(0), m_boundsSize(0),
+        m_boundsGeneration(0)
     {
-        static int lastId = 0;
+        // Views may be made by stages running in parallel.
+        static std::atomic<int> lastId(0);
         m_id = ++lastId;
     }
 
@@ -92,22 +125,83 @@ public:
         { return m_size == 0; }
 
     inline void appendPoint(const PointView& buffer, PointId id);
+    /// The ID in the point table of point 'id' of this view.  Views that
+    /// share a point give it the same table ID.
+    PointId tableId(PointId id) const
+        { return m_index[id]; }
+    /// Make room for 'count' points beyond those already in the view, both
+    /// in the view and in its point table.
+    void reserve(point_count_t count)
+    {
+        m_index.reserve(m_index.size() + count);
+        m_pointTable.reserve(count);
+    }
+    /// Add 'count' new points from the point table to the end of the view
+    /// without setting any of their fields.  This is for readers whose
+    /// point table already holds the point data (see MappedPointTable).
+    void appendTablePoints(point_count_t count)
+        { appendRange(count); }
+    /// Add 'count' new points to the end of the view, with consecutive IDs
+    /// claimed from the point table at once, and return the ID in this
+    /// view of the first.  Their fields are then set with setField().  If
+    /// the table is appendSafe(), views of it may append ranges from
+    /// several threads at once, and if it's threadSafe(), the points of a
+    /// range may be filled from several threads.
+    PointId appendRange(point_count_t count)
+    {
+        assert(m_temps.empty());
+        PointId first = m_size;
+        m_index.pushRange(m_pointTable.reserveRange(count), count);
+        m_size += count;
+        return first;
+    }
     void append(const PointView& buf)
     {
         // We use size() instead of the index end because temp points
         // might have been placed at the end of the buffer.
-        auto thisEnd = m_index.begin() + size();
-        auto bufEnd = buf.m_index.begin() + buf.size();
-        m_index.insert(thisEnd, buf.m_index.begin(), bufEnd);
+        m_index.insert(size(), buf.m_index, buf.size());
         m_size += buf.size();
         clearTemps();
     }
+    /// Append the points of several views.  The index is built in a single
+    /// pass, and not at all while the views' points follow on from one
+    /// another in the point table.
+    void append(const std::vector<PointViewPtr>& views);
 
     /// Return a new point view with the same point table as this
     /// point buffer.
     PointViewPtr makeNew() const
         { return PointViewPtr(new PointView(m_pointTable)); }
 
+    /// Return a new point view containing the points with IDs in the range
+    /// [begin, end) of this view.  The new view shares this view's index
+    /// until one of them is modified, so making a subset doesn't copy
+    /// point IDs.
+    PointViewPtr makeSubset(PointId begin, PointId end) const
+    {
+        assert(begin <= end && end <= size());
+        PointViewPtr view(makeNew());
+        view->m_index = m_index.slice(begin, end - begin);
+        view->m_size = end - begin;
+        return view;
+    }
+
+    /// Rearrange the points of this view so that point i is the point that
+    /// was at order[i].  'order' must be a permutation of the view's IDs.
+    /// Only the view's index is rewritten, in one pass; no point data is
+    /// moved.
+    void applyPermutation(const std::vector<PointId>& order)
+        { permute(order, [](PointId id){ return id; }); }
+
+    /// Rearrange the points of this view in the order of the IDs held by
+    /// sorted (key, PointId) pairs, as left by radixSort().
+    template<typename K>
+    void applyPermutation(const std::vector<std::pair<K, PointId>>& sorted)
+    {
+        permute(sorted,
+            [](const std::pair<K, PointId>& p){ return p.second; });
+    }
+
     template<class T>
     T getFieldAs(Dimension::Id::Enum dim, PointId pointIndex) const;
 
@@ -120,6 +214,86 @@ public:
     inline void setField(Dimension::Id::Enum dim, Dimension::Type::Enum type,
         PointId idx, const void *val);
 
+    /// Fetch the values of a dimension for a range of points.  The
+    /// dimension is looked up once and values are converted as they
+    /// would be by setField().
+    /// \param[in] dim    Dimension to fetch.
+    /// \param[in] begin  Index of the first point to fetch.
+    /// \param[in] count  Number of points to fetch.
+    /// \param[out] out   Buffer of at least \a count values to fill.
+    template<typename T>
+    void getFieldArray(Dimension::Id::Enum dim, PointId begin,
+        point_count_t count, T *out) const;
+
+    /// Set the values of a dimension for a range of points.  As with
+    /// setField(), points are added when the range extends past the end
+    /// of the view.
+    /// \param[in] dim    Dimension to set.
+    /// \param[in] begin  Index of the first point to set.
+    /// \param[in] count  Number of points to set.
+    /// \param[in] in     Buffer of at least \a count values.
+    template<typename T>
+    void setFieldArray(Dimension::Id::Enum dim, PointId begin,
+        point_count_t count, const T *in);
+
+    /// Copy the values of one dimension to another for a range of points.
+    /// Values are copied as stored when the dimensions have the same type
+    /// and scaling, and are converted as by setField() otherwise.
+    /// \param[in] from   Dimension to copy.
+    /// \param[in] to     Dimension to set.
+    /// \param[in] begin  Index of the first point to copy.
+    /// \param[in] count  Number of points to copy.
+    void copyField(Dimension::Id::Enum from, Dimension::Id::Enum to,
+        PointId begin, point_count_t count);
+
+    /// Test the values of a packed dimension (see
+    /// PointLayout::registerPackedDim()) for a range of points.  The bytes
+    /// holding the dimension are looked up in a table built once from
+    /// \a flags, so values are never unpacked.
+    /// \param[in] dim    Packed dimension to test.
+    /// \param[in] begin  Index of the first point to test.
+    /// \param[in] count  Number of points to test.
+    /// \param[in] flags  Result for each value the dimension can hold,
+    ///     from 0 to 2^bits - 1.
+    /// \param[out] match  Buffer of at least \a count results to fill.
+    void matchPacked(Dimension::Id::Enum dim, PointId begin,
+        point_count_t count, const char *flags, char *match) const;
+
+    /// Make a handle for typed access to a dimension.
+    /// \param[in] dim  Dimension to access.
+    /// \return  Handle for use with getField(), setField() and compare().
+    template<typename T>
+    DimHandle<T> handle(Dimension::Id::Enum dim) const
+        { return DimHandle<T>(m_pointTable.layout()->dimDetail(dim)); }
+
+    template<typename T>
+    T getField(const DimHandle<T>& h, PointId idx) const
+    {
+        if (!h.m_native)
+            return getFieldAs<T>(h.m_detail->id(), idx);
+        T t;
+        m_pointTable.getField(h.m_detail, m_index[idx], &t);
+        return t;
+    }
+
+    template<typename T>
+    void setField(const DimHandle<T>& h, PointId idx, T val)
+    {
+        if (!h.m_native || idx >= size())
+            setField(h.m_detail->id(), idx, val);
+        else
+        {
+            m_pointTable.setField(h.m_detail, m_index[idx], &val);
+            if (isCoord(h.m_detail->id()))
+                m_pointTable.coordsChanged();
+            fieldChanged(h.m_detail->id(), m_index[idx]);
+        }
+    }
+
+    template<typename T>
+    bool compare(const DimHandle<T>& h, PointId id1, PointId id2) const
+        { return getField(h, id1) < getField(h, id2); }
+
     template <typename T>
     bool compare(Dimension::Id::Enum dim, PointId id1, PointId id2)
     {
@@ -169,10 +343,52 @@ public:
         }
     }
 
+    /// Get the value of a dimension as it is stored in the point table.
+    /// Scaled dimensions aren't unscaled.
     void getRawField(Dimension::Id::Enum dim, PointId idx, void *buf) const
     {
         getFieldInternal(dim, idx, buf);
     }
+    /// Set the value of a dimension as it is stored in the point table.
+    /// The value of a scaled dimension must already be scaled.
+    void setRawField(Dimension::Id::Enum dim, PointId idx, const void *buf)
+    {
+        setFieldInternal(dim, idx, buf);
+    }
+    /// Memory of the point table holding dimension 'dim' of the 'count'
+    /// points from 'begin', as it is stored, for code that reads or sets
+    /// the values in place.  'stride' is set to the bytes between the
+    /// values of consecutive points.  Returns NULL when the values aren't
+    /// evenly spaced: the points aren't consecutive in the table, or span
+    /// blocks of its storage, or the table can't say.
+    char *fieldSpan(Dimension::Id::Enum dim, PointId begin,
+        point_count_t count, std::ptrdiff_t& stride)
+    {
+        // The values may be set through the span.
+        if (isCoord(dim))
+            m_pointTable.coordsChanged();
+        if (m_pointTable.hasComputed() &&
+                m_pointTable.layout()->dependents(dim).size())
+            m_pointTable.clearComputed();
+        return const_cast<char *>(
+            const_cast<const PointView *>(this)->fieldSpan(dim, begin,
+                count, stride));
+    }
+    const char *fieldSpan(Dimension::Id::Enum dim, PointId begin,
+        point_count_t count, std::ptrdiff_t& stride) const
+    {
+        if (count == 0 || begin + count > size())
+            return NULL;
+        PointId first = m_index[begin];
+        if (!m_index.identity())
+            for (PointId i = 1; i < count; ++i)
+                if (m_index[begin + i] != first + i)
+                    return NULL;
+        const Dimension::Detail *dd = m_pointTable.layout()->dimDetail(dim);
+        if (dd->computed())
+            return NULL;
+        return m_pointTable.getFieldSpan(dd, first, count, stride);
+    }
 
     /*! @return a cumulated bounds of all points in the PointView.
         \verbatim embed:rst
@@ -183,11 +399,28 @@ public:
             type using the :cpp:func:`pdal::Dimension::applyScaling`
             method. Otherwise, an exception will be thrown.
         \endverbatim
+
+        The bounds are kept and returned by later calls until X, Y or Z
+        of a point in the view's table is set or points are added to the
+        view.  Not safe to call on one view from several threads at once.
     */
     BOX3D calculateBounds(bool bis3d=true) const;
     static BOX3D calculateBounds(const PointViewSet&, bool bis3d=true);
 
+    /// A KD index of the points of the view, built when first asked for
+    /// and kept for later stages.  Each call checks the index against the
+    /// view's coordinates and rebuilds it if they have changed, as they
+    /// do when points are transformed or added.  The check reads the
+    /// coordinates once, which is much cheaper than a build.  Not safe to
+    /// call on one view from several threads at once.
+    /// \param[in] b3d  Index X, Y and Z rather than only X and Y.
+    const KDIndex& spatialIndex(bool b3d = true) const;
+
     void dump(std::ostream& ostr) const;
+    PointLayoutPtr layout() const
+        { return m_pointTable.layout(); }
+    PointTableRef table() const
+        { return m_pointTable; }
     bool hasDim(Dimension::Id::Enum id) const
         { return m_pointTable.layout()->hasDim(id); }
     std::string dimName(Dimension::Id::Enum id) const
@@ -219,11 +452,14 @@ public:
     /// \param[in] dims  Dimension/types of data in packed order
     /// \param[in] idx   Index of point to write.
     /// \param[in] buf   Packed data buffer.
+    /// Values of computed dimensions are skipped.
     void setPackedPoint(const DimTypeList& dims, PointId idx, const char *buf)
     {
+        PointLayoutPtr layout = m_pointTable.layout();
         for (auto di = dims.begin(); di != dims.end(); ++di)
         {
-            setField(di->m_id, di->m_type, idx, (const void *)buf);
+            if (!layout->dimDetail(di->m_id)->computed())
+                setField(di->m_id, di->m_type, idx, (const void *)buf);
             buf += Dimension::size(di->m_type);
         }
     }
@@ -232,7 +468,10 @@ public:
     /// Provides access to the memory storing the point data.  Though this
     /// function is public, other access methods are safer and preferred.
     char *getPoint(PointId id)
-        { return m_pointTable.getPoint(m_index[id]); }
+    {
+        m_pointTable.coordsChanged();
+        return m_pointTable.getPoint(m_index[id]);
+    }
 
     // The standard idiom is swapping with a stack-created empty queue, but
     // that invokes the ctor and probably allocates.  We've probably only got
@@ -243,18 +482,80 @@ public:
             m_temps.pop();
     }
 
+    template<typename List, typename F>
+    void permute(const List& order, F id)
+    {
+        assert(order.size() == size());
+        PointIdList::Ids index;
+        index.reserve(m_index.size());
+        for (const auto& o : order)
+            index.push_back(m_index[id(o)]);
+        // Temporary points follow the view's points in the index.
+        for (PointId i = size(); i < m_index.size(); ++i)
+            index.push_back(m_index[i]);
+        m_index.assign(std::move(index));
+    }
+
 protected:
     PointTableRef m_pointTable;
-    std::deque<PointId> m_index;
+    PointIdList m_index;
     // The index might be larger than the size to support temporary point
     // references.
     point_count_t m_size;
     int m_id;
     std::queue<PointId> m_temps;
+    mutable std::shared_ptr<KDIndex> m_spatialIndex;
+    // Bounds cached by calculateBounds(), of 2 or 3 dimensions, or 0 if
+    // none are cached, and the view size and table coordinate generation
+    // when they were calculated.
+    mutable BOX3D m_bounds;
+    mutable int m_boundsDims;
+    mutable point_count_t m_boundsSize;
+    mutable uint64_t m_boundsGeneration;
 
 private:
+    static bool isCoord(Dimension::Id::Enum dim)
+    {
+        return dim == Dimension::Id::X || dim == Dimension::Id::Y ||
+            dim == Dimension::Id::Z;
+    }
+
+    // Read a field of a point of the view, computing it if the dimension
+    // is computed.
+    void readField(const Dimension::Detail *dd, PointId idx, void *buf) const
+    {
+        if (dd->computed())
+            *(double *)buf = computedField(dd, idx);
+        else
+            m_pointTable.getField(dd, m_index[idx], buf);
+    }
+    double computedField(const Dimension::Detail *dd, PointId idx) const;
+    void checkSettable(const Dimension::Detail *dd) const
+    {
+        if (dd->computed())
+            throw pdal_error("Can't set computed dimension '" +
+                m_pointTable.layout()->dimName(dd->id()) + "'.");
+    }
+    // Discard cached values computed from dimension 'dim' of the point
+    // with table id 'rawId', which has been set.
+    void fieldChanged(Dimension::Id::Enum dim, PointId rawId)
+    {
+        if (m_pointTable.hasComputed())
+            m_pointTable.clearDependents(dim, rawId);
+    }
+
+    template<typename T_IN, typename T_OUT>
+    static bool convert(T_IN in, T_OUT& out);
     template<typename T_IN, typename T_OUT>
     bool convertAndSet(Dimension::Id::Enum dim, PointId idx, T_IN in);
+    template<typename T>
+    void setFieldUnscaled(const Dimension::Detail *dd, PointId idx, T val);
+    template<typename T_IN, typename T_OUT>
+    void getFieldArrayInternal(const Dimension::Detail *dd, PointId begin,
+        point_count_t count, T_OUT *out) const;
+    template<typename T_IN, typename T_OUT>
+    void setFieldArrayInternal(const Dimension::Detail *dd, PointId begin,
+        point_count_t count, const T_IN *in);
 
     inline void setFieldInternal(Dimension::Id::Enum dim, PointId pointIndex,
         const void *value);
@@ -413,6 +714,8 @@ inline T PointView::getFieldAs(Dimension::Id::Enum dim,
         val = 0;
         break;
     }
+    if (dd->scaled())
+        val = val * dd->xform().m_scale + dd->xform().m_offset;
 #ifdef PDAL_COMPILER_MSVC
 // warning C4127: conditional expression is constant
 #pragma warning(push)
@@ -449,7 +752,7 @@ inline T PointView::getFieldAs(Dimension::Id::Enum dim,
 
 
 template<typename T_IN, typename T_OUT>
-bool PointView::convertAndSet(Dimension::Id::Enum dim, PointId idx, T_IN in)
+bool PointView::convert(T_IN in, T_OUT& out)
 {
 // This mess, instead of just using boost::numeric_cast, is here to:
 //   1) Prevent the throwing of exceptions.  The entrance/exit of the try
@@ -468,8 +771,6 @@ bool PointView::convertAndSet(Dimension::Id::Enum dim, PointId idx, T_IN in)
         }
     };
 
-    T_OUT out;
-
     typedef numeric::conversion_traits<T_OUT, T_IN> conv_traits;
     typedef numeric::numeric_cast_traits<T_OUT, T_IN> cast_traits;
     typedef numeric::converter<
@@ -493,14 +794,22 @@ bool PointView::convertAndSet(Dimension::Id::Enum dim, PointId idx, T_IN in)
         out = in;
     else
         out = localConverter::convert(in);
-    if (!ok)
-        return false;
+    return ok;
 
 #ifdef PDAL_COMPILER_MSVC
 // warning C4127: conditional expression is constant
 #pragma warning(pop)
 #endif
+}
+
+
+template<typename T_IN, typename T_OUT>
+bool PointView::convertAndSet(Dimension::Id::Enum dim, PointId idx, T_IN in)
+{
+    T_OUT out;
 
+    if (!convert(in, out))
+        return false;
     setFieldInternal(dim, idx, (void *)&out);
     return true;
 }
@@ -511,6 +820,20 @@ void PointView::setField(Dimension::Id::Enum dim, PointId idx, T val)
 {
     const Dimension::Detail *dd = m_pointTable.layout()->dimDetail(dim);
 
+    if (dd->scaled())
+        setFieldUnscaled(dd, idx, ((double)val - dd->xform().m_offset) /
+            dd->xform().m_scale);
+    else
+        setFieldUnscaled(dd, idx, val);
+}
+
+
+template<typename T>
+void PointView::setFieldUnscaled(const Dimension::Detail *dd, PointId idx,
+    T val)
+{
+    Dimension::Id::Enum dim = dd->id();
+
     bool ok = true;
     switch (dd->type())
     {
@@ -560,17 +883,180 @@ void PointView::setField(Dimension::Id::Enum dim, PointId idx, T val)
 }
 
 
+template<typename T>
+void PointView::getFieldArray(Dimension::Id::Enum dim, PointId begin,
+    point_count_t count, T *out) const
+{
+    const Dimension::Detail *dd = m_pointTable.layout()->dimDetail(dim);
+
+    switch (dd->type())
+    {
+    case Dimension::Type::Float:
+        getFieldArrayInternal<float>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Double:
+        getFieldArrayInternal<double>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Signed8:
+        getFieldArrayInternal<int8_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Signed16:
+        getFieldArrayInternal<int16_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Signed32:
+        getFieldArrayInternal<int32_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Signed64:
+        getFieldArrayInternal<int64_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned8:
+        getFieldArrayInternal<uint8_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned16:
+        getFieldArrayInternal<uint16_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned32:
+        getFieldArrayInternal<uint32_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::Unsigned64:
+        getFieldArrayInternal<uint64_t>(dd, begin, count, out);
+        break;
+    case Dimension::Type::None:
+        std::fill(out, out + count, T(0));
+        break;
+    }
+}
+
+
+template<typename T_IN, typename T_OUT>
+void PointView::getFieldArrayInternal(const Dimension::Detail *dd,
+    PointId begin, point_count_t count, T_OUT *out) const
+{
+    T_IN in;
+    const XForm& xform = dd->xform();
+    bool scaled = dd->scaled();
+
+    for (PointId idx = begin; idx < begin + count; ++idx)
+    {
+        readField(dd, idx, &in);
+        bool ok = scaled ?
+            convert(in * xform.m_scale + xform.m_offset, *out++) :
+            convert(in, *out++);
+        if (!ok)
+        {
+            std::ostringstream oss;
+            oss << "Unable to fetch data and convert as requested: ";
+            oss << Dimension::name(dd->id()) << ":" <<
+                Dimension::interpretationName(dd->type()) <<
+                "(" << (double)in << ") -> " << Utils::typeidName<T_OUT>();
+            throw pdal_error(oss.str());
+        }
+    }
+}
+
+
+template<typename T>
+void PointView::setFieldArray(Dimension::Id::Enum dim, PointId begin,
+    point_count_t count, const T *in)
+{
+    const Dimension::Detail *dd = m_pointTable.layout()->dimDetail(dim);
+
+    switch (dd->type())
+    {
+    case Dimension::Type::Float:
+        setFieldArrayInternal<T, float>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Double:
+        setFieldArrayInternal<T, double>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Signed8:
+        setFieldArrayInternal<T, int8_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Signed16:
+        setFieldArrayInternal<T, int16_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Signed32:
+        setFieldArrayInternal<T, int32_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Signed64:
+        setFieldArrayInternal<T, int64_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned8:
+        setFieldArrayInternal<T, uint8_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned16:
+        setFieldArrayInternal<T, uint16_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned32:
+        setFieldArrayInternal<T, uint32_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::Unsigned64:
+        setFieldArrayInternal<T, uint64_t>(dd, begin, count, in);
+        break;
+    case Dimension::Type::None:
+        break;
+    }
+}
+
+
+template<typename T_IN, typename T_OUT>
+void PointView::setFieldArrayInternal(const Dimension::Detail *dd,
+    PointId begin, point_count_t count, const T_IN *in)
+{
+    if (begin > size())
+        throw pdal_error("Point index must increment.");
+    checkSettable(dd);
+
+    T_OUT out;
+    const XForm& xform = dd->xform();
+    bool scaled = dd->scaled();
+    if (isCoord(dd->id()))
+        m_pointTable.coordsChanged();
+
+    for (PointId idx = begin; idx < begin + count; ++idx, ++in)
+    {
+        bool ok = scaled ?
+            convert((*in - xform.m_offset) / xform.m_scale, out) :
+            convert(*in, out);
+        if (!ok)
+        {
+            std::ostringstream oss;
+            oss << "Unable to set data and convert as requested: ";
+            oss << Dimension::name(dd->id()) << ":" <<
+                Utils::typeidName<T_IN>() << "(" << (double)*in << ") -> " <<
+                Dimension::interpretationName(dd->type());
+            throw pdal_error(oss.str());
+        }
+
+        PointId rawId;
+        if (idx == size())
+        {
+            rawId = m_pointTable.addPoint();
+            m_index.push_back(rawId);
+            m_size++;
+            assert(m_temps.empty());
+        }
+        else
+            rawId = m_index[idx];
+        m_pointTable.setField(dd, rawId, &out);
+        fieldChanged(dd->id(), rawId);
+    }
+}
+
+
 inline void PointView::getFieldInternal(Dimension::Id::Enum dim,
     PointId id, void *buf) const
 {
-    m_pointTable.getField(m_pointTable.layout()->dimDetail(dim),
-        m_index[id], buf);
+    readField(m_pointTable.layout()->dimDetail(dim), id, buf);
 }
 
 
 inline void PointView::setFieldInternal(Dimension::Id::Enum dim,
     PointId id, const void *value)
 {
+    const Dimension::Detail *dd = m_pointTable.layout()->dimDetail(dim);
+    checkSettable(dd);
+
     PointId rawId = 0;
     if (id == size())
     {
@@ -589,8 +1075,10 @@ inline void PointView::setFieldInternal(Dimension::Id::Enum dim,
     {
         rawId = m_index[id];
     }
-    m_pointTable.setField(m_pointTable.layout()->dimDetail(dim),
-        rawId, value);
+    m_pointTable.setField(dd, rawId, value);
+    if (isCoord(dim))
+        m_pointTable.coordsChanged();
+    fieldChanged(dim, rawId);
 }
 
 
@@ -612,7 +1100,7 @@ inline PointId PointView::getTemp(PointId id)
     {
         newid = m_temps.front();
         m_temps.pop();
-        m_index[newid] = m_index[id];
+        m_index.set(newid, m_index[id]);
     }
     else
     {
@@ -76,18 +76,21 @@ public:
             m_tmp = true;
         }
         else
-            m_buf->m_index[m_id] = r.m_buf->m_index[r.m_id];
+            m_buf->m_index.set(m_id, r.m_buf->m_index[r.m_id]);
         return *this;
     }
 
     bool compare(Dimension::Id::Enum dim, const PointRef& p) const
         { return m_buf->compare(dim, m_id, p.m_id); }
+    template<typename T>
+    bool compare(const DimHandle<T>& h, const PointRef& p) const
+        { return m_buf->compare(h, m_id, p.m_id); }
 
     void swap(PointRef& p)
     {
         PointId id = m_buf->m_index[m_id];
-        m_buf->m_index[m_id] = p.m_buf->m_index[p.m_id];
-        p.m_buf->m_index[p.m_id] = id;
+        m_buf->m_index.set(m_id, p.m_buf->m_index[p.m_id]);
+        p.m_buf->m_index.set(p.m_id, id);
     }
 };
 
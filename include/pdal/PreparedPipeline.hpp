@@ -0,0 +1,90 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#pragma once
+
+#include <pdal/PipelineManager.hpp>
+
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pdal
+{
+
+// A pipeline that's read once and then run against many input files.  The
+// XML is parsed and the stages are created only once.  Each run gets a
+// fresh point table and prepares the stages again, so nothing carries over
+// from one run to the next.
+class PDAL_DLL PreparedPipeline
+{
+public:
+    // Read the pipeline from an XML file or stream.  Throws pdal_error if
+    // the pipeline is invalid.
+    explicit PreparedPipeline(const std::string& filename);
+    explicit PreparedPipeline(std::istream& input);
+
+    // Run the pipeline with every reader reading 'inFilename' and, if
+    // 'outFilename' isn't empty, the writer writing 'outFilename'.
+    // Returns the number of points in the resulting views.
+    point_count_t execute(const std::string& inFilename,
+        const std::string& outFilename = std::string());
+
+    bool isWriterPipeline() const
+        { return m_isWriter; }
+    Stage *getStage() const
+        { return m_manager.getStage(); }
+    // The views and table of the last run.  They're discarded by the next.
+    const PointViewSet& views() const
+        { return m_viewSet; }
+    PointTableRef pointTable() const
+        { return *m_table; }
+
+private:
+    PipelineManager m_manager;
+    bool m_isWriter;
+    std::vector<Stage *> m_readers;
+    std::unique_ptr<PointTable> m_table;
+    PointViewSet m_viewSet;
+
+    void findReaders(Stage *stage);
+    static void setFilename(Stage *stage, const std::string& filename);
+
+    PreparedPipeline& operator=(const PreparedPipeline&); // not implemented
+    PreparedPipeline(const PreparedPipeline&); // not implemented
+};
+
+} // namespace pdal
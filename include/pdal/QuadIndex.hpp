@@ -36,6 +36,7 @@
 
 #include <vector>
 #include <memory>
+#include <string>
 
 #include <pdal/pdal_export.hpp>
 #include <pdal/pdal_types.hpp>
@@ -81,6 +82,12 @@ class PDAL_DLL QuadIndex
 {
 public:
     QuadIndex(const PointView& view, std::size_t topLevel = 0);
+    // Load the index from 'cacheFile' if that holds an index of the same
+    // points, and otherwise build it and save it to 'cacheFile'.
+    QuadIndex(
+            const PointView& view,
+            const std::string& cacheFile,
+            std::size_t topLevel = 0);
     QuadIndex(
             const PointView& view,
             double xMin,
@@ -97,6 +104,10 @@ public:
             std::size_t topLevel = 0);
     ~QuadIndex();
 
+    // Save the index.  The file is tagged with a hash of the indexed
+    // coordinates so that a later load can tell whether it still applies.
+    void save(const std::string& filename) const;
+
     void getBounds(
             double& xMin,
             double& yMin,
@@ -169,6 +180,22 @@ public:
             std::size_t depthBegin,
             std::size_t depthEnd) const;
 
+    // Return the points of the next 'levels' depth levels, starting from
+    // level 'cursor' relative to the top of the tree, and advance the
+    // cursor past them.  Start with a cursor of zero to visit the points
+    // coarse-to-fine.  Once the cursor is greater than getDepth() no points
+    // remain.  The cursor is a plain level number, so it can be kept to
+    // continue later from another index of the same points.
+    std::vector<PointId> getNextLevels(
+            std::size_t& cursor,
+            std::size_t levels = 1) const;
+
+    // As above, limited to the points within 'box'.
+    std::vector<PointId> getNextLevels(
+            const BOX3D& box,
+            std::size_t& cursor,
+            std::size_t levels = 1) const;
+
 private:
     struct QImpl;
     std::unique_ptr<QImpl> m_qImpl;
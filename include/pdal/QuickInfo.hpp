@@ -37,6 +37,7 @@
 #include <vector>
 
 #include <pdal/util/Bounds.hpp>
+#include <pdal/Metadata.hpp>
 #include <pdal/SpatialReference.hpp>
 
 namespace pdal
@@ -49,6 +50,8 @@ public:
     SpatialReference m_srs;
     point_count_t m_pointCount;
     std::vector<std::string> m_dimNames;
+    // Format-specific information found without reading points.
+    MetadataNode m_metadata;
     bool m_valid;
 
     QuickInfo() : m_pointCount(0), m_valid(false)
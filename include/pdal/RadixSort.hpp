@@ -0,0 +1,73 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+typedef std::pair<uint64_t, PointId> RadixPair;
+
+// Sort pairs by key with a parallel least-significant-digit radix sort.
+// The sort is stable, so pairs with equal keys keep their order.  Memory
+// use is a second buffer the size of 'pairs'.
+PDAL_DLL void radixSort(std::vector<RadixPair>& pairs);
+
+// Map a value onto an unsigned key that sorts in the same order.
+template<typename T>
+uint64_t radixKey(T v)
+{
+    if (!std::numeric_limits<T>::is_integer)
+    {
+        // Flip every bit of negative numbers and only the sign bit of
+        // positive ones.
+        double d = (double)v;
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return (bits & (1ULL << 63)) ? ~bits : (bits | (1ULL << 63));
+    }
+    if (std::numeric_limits<T>::is_signed)
+        return (uint64_t)(int64_t)v ^ (1ULL << 63);
+    return (uint64_t)v;
+}
+
+} // namespace pdal
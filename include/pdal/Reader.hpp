@@ -36,6 +36,7 @@
 
 #include <pdal/Stage.hpp>
 #include <pdal/Options.hpp>
+#include <pdal/Trace.hpp>
 
 namespace pdal
 {
@@ -47,27 +48,66 @@ class PDAL_DLL Reader : public Stage
 public:
     typedef std::function<void(PointView&, PointId)> PointReadFunc;
 
-    Reader() : m_count(std::numeric_limits<point_count_t>::max())
+    Reader() : m_count(std::numeric_limits<point_count_t>::max()),
+        m_streamCount(0)
     {}
 
     void setReadCb(PointReadFunc cb)
         { m_cb = cb; }
 
+    // Have the reader return only the points start, start + stride, ...
+    // of those it would otherwise read, so that points a following filter
+    // would drop are never read.  Returns false if the reader can't skip
+    // points itself.
+    virtual bool setStride(point_count_t /*start*/, point_count_t /*stride*/)
+        { return false; }
+
+    // Have the reader skip points outside 'bounds' if it can do so
+    // cheaply, such as with a spatial index, so that points a following
+    // crop would drop need not be read.  The reader may still return some
+    // points outside the bounds.  If the bounds' Z range is empty, only X
+    // and Y are checked.  Returns false if the reader can't skip points.
+    virtual bool setBounds(const BOX3D& /*bounds*/)
+        { return false; }
+
+    // Have the reader return only the points with the indices 'ids',
+    // seeking to each instead of reading the points between.  The points
+    // are returned once each in ascending order of index, whatever the
+    // order of 'ids'.  Indices past the last point are ignored.  Must be called once the reader is prepared and before it's
+    // executed.  Returns false if the reader can't seek to points.
+    virtual bool setPointIds(const std::vector<PointId>& /*ids*/)
+        { return false; }
+
 protected:
     std::string m_filename;
     point_count_t m_count;
     PointReadFunc m_cb;
 
 private:
+    // Number of points read so far when streaming.
+    point_count_t m_streamCount;
+
     virtual PointViewSet run(PointViewPtr view)
     {
         PointViewSet viewSet;
 
         view->clearTemps();
-        read(view, m_count);
+        {
+            trace::Span span("io", "read", *this);
+            read(view, m_count);
+        }
         viewSet.insert(view);
         return viewSet;
     }
+    virtual point_count_t readChunk(PointViewPtr view, point_count_t count)
+    {
+        view->clearTemps();
+        count = std::min(count, m_count - m_streamCount);
+        count = count ? read(view, count) : 0;
+        // Start over should the pipeline be streamed again.
+        m_streamCount = count ? m_streamCount + count : 0;
+        return count;
+    }
     virtual void readerProcessOptions(const Options& options);
     virtual point_count_t read(PointViewPtr /*view*/, point_count_t /*num*/)
         { return 0; }
@@ -39,6 +39,7 @@
 
 #include <pdal/Dimension.hpp>
 #include <pdal/Log.hpp>
+#include <pdal/MemoryAccount.hpp>
 #include <pdal/Metadata.hpp>
 #include <pdal/Options.hpp>
 #include <pdal/PointTable.hpp>
@@ -52,15 +53,47 @@
 namespace pdal
 {
 
+class Filter;
 class Iterator;
+class PipelineScheduler;
 class StageSequentialIterator;
 class StageRandomIterator;
 class StageBlockIterator;
 class StageRunner;
 class StageWrapper;
 
+/// Time, point counts and memory recorded as a stage prepares and executes.
+/// Times are in seconds and don't include time spent in the stage's
+/// inputs.  CPU time is that of the whole process, so it includes the work
+/// of stages running at the same time.
+struct PDAL_DLL StageProfile
+{
+    StageProfile() : m_prepareTime(0.0), m_prepareCpuTime(0.0),
+        m_executeTime(0.0), m_executeCpuTime(0.0), m_pointsIn(0),
+        m_pointsOut(0), m_peakTableBytes(0)
+    {
+        for (int c = 0; c < memory::NumCategories; ++c)
+            m_peakBytes[c] = m_allocatedBytes[c] = 0;
+    }
+
+    double m_prepareTime;
+    double m_prepareCpuTime;
+    // Covers ready(), run() (or reading chunks) and done().
+    double m_executeTime;
+    double m_executeCpuTime;
+    point_count_t m_pointsIn;
+    point_count_t m_pointsOut;
+    // Point storage in the table once the stage had run.
+    uint64_t m_peakTableBytes;
+    // Memory charged to the stage, by memory::Category: the most in use at
+    // once and the total allocated.
+    uint64_t m_peakBytes[memory::NumCategories];
+    uint64_t m_allocatedBytes[memory::NumCategories];
+};
+
 class PDAL_DLL Stage
 {
+    friend class PipelineScheduler;
     friend class StageWrapper;
     friend class StageRunner;
 public:
@@ -79,6 +112,44 @@ public:
     }
     void prepare(PointTableRef table);
     PointViewSet execute(PointTableRef table);
+    /// Execute the pipeline ending at this stage a chunk of points at a
+    /// time.  Each chunk is read into the table, passed through each
+    /// stage in turn and discarded, so memory use is bounded by the table's
+    /// capacity rather than the number of points.  Every stage must be
+    /// streamable() and have no more than one input, except that a stage
+    /// whose inputs are all readers is streamed by reading those readers
+    /// one after the other.  Throws pdal_error otherwise.  Points a stage
+    /// holds back are handed on from its flush() once the sources are done.
+    /// If the table has more than one chunk slot, the reader,
+    /// the filters and the last stage each run on their own thread so that
+    /// reading, filtering and writing overlap.
+    /// \param[in] table  Table prepared for the pipeline.
+    /// \return  Number of points read.
+    point_count_t executeStream(FixedPointTable& table);
+    /// Whether the stage can process its points a chunk at a time.  Stages
+    /// that need all points at once (sorting, chipping) return false.  A
+    /// streamable stage may hold points back from the chunks it's given
+    /// and hand them on from flush() at the end.  Only meaningful once the
+    /// stage has been prepared.
+    virtual bool streamable() const
+        { return false; }
+    /// Whether every stage of the pipeline ending at this stage is
+    /// streamable.  A stage with several inputs qualifies only when each
+    /// input is a streamable reader.
+    bool pipelineStreamable() const;
+    /// Whether run() may be called for different views from different
+    /// threads at once.  A stage that returns true promises that, once
+    /// ready() has been called, its filter() or run() changes no stage
+    /// state without synchronization, reads and sets fields only of the
+    /// points of the view it's given, and adds no points to the table.
+    /// Views are then processed in parallel when the table is threadSafe().
+    virtual bool viewParallel() const
+        { return false; }
+    /// Like viewParallel(), except that the stage may also add points to
+    /// the table, with PointView::appendRange().  Views are processed in
+    /// parallel when the table is appendSafe().
+    virtual bool appendParallel() const
+        { return false; }
 
     void setSpatialReference(SpatialReference const&);
     const SpatialReference& getSpatialReference() const;
@@ -119,12 +190,25 @@ public:
     inline MetadataNode getMetadata() const
         { return m_metadata; }
 
+    /// Time and point counts recorded the last time the stage was prepared
+    /// and executed.  The time spent filtering points by a fused run of
+    /// point-wise filters is recorded against the last filter of the run.
+    const StageProfile& profile() const
+        { return m_profile; }
+    /// A "pipeline_profile" metadata node with a child holding the profile
+    /// of each stage of the pipeline ending at this stage, readers first.
+    MetadataNode pipelineProfile() const;
+
     /// Sets the UserCallback to manage progress/cancel operations
     void setUserCallback(UserCallback* userCallback)
         { m_callback.reset(userCallback); }
+    /// Sets a UserCallback that may be shared with other stages, so that
+    /// one interrupt() stops them all.
+    void setUserCallback(std::shared_ptr<UserCallback> userCallback)
+        { m_callback = userCallback; }
 
 protected:
-    std::unique_ptr<UserCallback> m_callback;
+    std::shared_ptr<UserCallback> m_callback;
     Options m_options;
     MetadataNode m_metadata;
 
@@ -136,6 +220,9 @@ private:
     std::vector<Stage *> m_inputs;
     LogPtr m_log;
     SpatialReference m_spatialReference;
+    StageProfile m_profile;
+    // Charged with the memory allocated while the stage is working.
+    memory::AccountPtr m_account;
 
     Stage& operator=(const Stage&); // not implemented
     Stage(const Stage&); // not implemented
@@ -149,6 +236,28 @@ private:
         {}
     void l_initialize(PointTableRef table);
     void l_done(PointTableRef table);
+    void prepareStage(PointTableRef table);
+    void startRun(PointTableRef table);
+    PointViewSet runViews(PointTableRef table, const PointViewSet& views);
+    void finishRun(PointTableRef table);
+    void recordMemory();
+    std::vector<Filter *> fusedRun();
+    PointViewSet executeFused(const std::vector<Filter *>& run,
+        PointTableRef table);
+    point_count_t l_readChunk(PointViewPtr view, point_count_t count);
+    PointViewSet l_run(PointViewPtr view);
+    PointViewSet l_flush(PointViewPtr view, point_count_t count);
+    void addProfile(MetadataNode& parent) const;
+    static PointViewSet runChunk(std::vector<Stage *>::const_iterator begin,
+        std::vector<Stage *>::const_iterator end, PointViewSet views);
+    static point_count_t readSources(const std::vector<Stage *>& sources,
+        std::size_t& current, PointViewPtr view, point_count_t count);
+    static point_count_t streamSerial(const std::vector<Stage *>& sources,
+        const std::vector<Stage *>& stages, FixedPointTable& table);
+    static point_count_t streamPipelined(const std::vector<Stage *>& sources,
+        const std::vector<Stage *>& stages, FixedPointTable& table);
+    static void flushStages(const std::vector<Stage *>& stages,
+        FixedPointTable& table);
     virtual QuickInfo inspect()
         { return QuickInfo(); }
     virtual void initialize()
@@ -166,6 +275,16 @@ private:
         std::cerr << "Can't run stage = " << getName() << "!\n";
         return PointViewSet();
     }
+    virtual point_count_t readChunk(PointViewPtr /*view*/,
+            point_count_t /*count*/)
+        { return 0; }
+    // When streaming, hand on the points a stage has held back from the
+    // chunks given to run(), once the sources are done.  'view' is empty
+    // and may be given up to 'count' new points.  Called until it returns
+    // no views.
+    virtual PointViewSet flush(PointViewPtr /*view*/,
+            point_count_t /*count*/)
+        { return PointViewSet(); }
 };
 
 PDAL_DLL std::ostream& operator<<(std::ostream& ostr, const Stage&);
@@ -0,0 +1,303 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Filter.hpp>
+#include <pdal/PointView.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace pdal
+{
+
+namespace pointwise
+{
+
+// The positions of a block of points, and whether each is kept, as they're
+// handed to the kernels of a StaticPipeline.  A block is small enough to
+// stay in cache while every kernel runs over it.
+struct PointBlock
+{
+    static const point_count_t capacity = 1024;
+
+    point_count_t m_size;
+    double m_x[capacity];
+    double m_y[capacity];
+    double m_z[capacity];
+    char m_keep[capacity];
+};
+
+// A kernel is a copyable type with an inline
+//
+//     void operator()(PointBlock& block) const;
+//
+// that sets the positions of the block's points or clears the keep flags
+// of points to drop, and two constants, 'movesPoints' and 'dropsPoints',
+// that say which it does.  It may be called for different blocks from
+// several threads at once.
+
+// Apply the affine part of a row-major 4x4 matrix to each point, as
+// filters.transformation does.
+class Transform
+{
+public:
+    static const bool movesPoints = true;
+    static const bool dropsPoints = false;
+
+    explicit Transform(const std::array<double, 16>& matrix) :
+        m_matrix(matrix)
+    {}
+
+    void operator()(PointBlock& block) const
+    {
+        const double *m = m_matrix.data();
+        for (point_count_t i = 0; i < block.m_size; ++i)
+        {
+            double x = block.m_x[i];
+            double y = block.m_y[i];
+            double z = block.m_z[i];
+
+            block.m_x[i] = x * m[0] + y * m[1] + z * m[2] + m[3];
+            block.m_y[i] = x * m[4] + y * m[5] + z * m[6] + m[7];
+            block.m_z[i] = x * m[8] + y * m[9] + z * m[10] + m[11];
+        }
+    }
+
+private:
+    std::array<double, 16> m_matrix;
+};
+
+// Keep only the points within a box, edges included.
+class Crop
+{
+public:
+    static const bool movesPoints = false;
+    static const bool dropsPoints = true;
+
+    explicit Crop(const BOX3D& bounds) : m_bounds(bounds)
+    {}
+
+    void operator()(PointBlock& block) const
+    {
+        for (point_count_t i = 0; i < block.m_size; ++i)
+            block.m_keep[i] &= (char)(
+                (block.m_x[i] >= m_bounds.minx) &
+                (block.m_x[i] <= m_bounds.maxx) &
+                (block.m_y[i] >= m_bounds.miny) &
+                (block.m_y[i] <= m_bounds.maxy) &
+                (block.m_z[i] >= m_bounds.minz) &
+                (block.m_z[i] <= m_bounds.maxz));
+    }
+
+private:
+    BOX3D m_bounds;
+};
+
+// Keep only the points with a coordinate in [min, max], as filters.range
+// does for a single range.
+template<Dimension::Id::Enum DIM>
+class Range
+{
+public:
+    static_assert(DIM == Dimension::Id::X || DIM == Dimension::Id::Y ||
+        DIM == Dimension::Id::Z, "A point block holds only X, Y and Z.");
+
+    static const bool movesPoints = false;
+    static const bool dropsPoints = true;
+
+    Range(double min, double max) : m_min(min), m_max(max)
+    {}
+
+    void operator()(PointBlock& block) const
+    {
+        const double *v = DIM == Dimension::Id::X ? block.m_x :
+            DIM == Dimension::Id::Y ? block.m_y : block.m_z;
+        for (point_count_t i = 0; i < block.m_size; ++i)
+            block.m_keep[i] &= (char)((v[i] >= m_min) & (v[i] <= m_max));
+    }
+
+private:
+    double m_min;
+    double m_max;
+};
+
+namespace detail
+{
+
+template<typename... Kernels>
+struct Traits
+{
+    static const bool movesPoints = false;
+    static const bool dropsPoints = false;
+};
+
+template<typename Kernel, typename... Rest>
+struct Traits<Kernel, Rest...>
+{
+    static const bool movesPoints =
+        Kernel::movesPoints || Traits<Rest...>::movesPoints;
+    static const bool dropsPoints =
+        Kernel::dropsPoints || Traits<Rest...>::dropsPoints;
+};
+
+template<std::size_t I, std::size_t N>
+struct Apply
+{
+    template<typename Tuple>
+    static void run(const Tuple& kernels, PointBlock& block)
+    {
+        std::get<I>(kernels)(block);
+        Apply<I + 1, N>::run(kernels, block);
+    }
+};
+
+template<std::size_t N>
+struct Apply<N, N>
+{
+    template<typename Tuple>
+    static void run(const Tuple& /*kernels*/, PointBlock& /*block*/)
+    {}
+};
+
+} // namespace detail
+
+} // namespace pointwise
+
+// A filter made of a chain of point-wise kernels fixed at compile time.
+// Each block of points passes through every kernel in turn, with the calls
+// inlined, so the compiler can fuse and vectorize the chain.  It's a
+// Filter like any other and sits between dynamic stages:
+//
+//     LasReader reader;
+//     StaticPipeline<pointwise::Range<Dimension::Id::Z>,
+//         pointwise::Transform> chain(
+//             pointwise::Range<Dimension::Id::Z>(0, 100),
+//             pointwise::Transform(matrix));
+//     chain.setInput(reader);
+//     LasWriter writer;
+//     writer.setInput(chain);
+//
+// Kernels see only the positions of the points; filters that need other
+// dimensions remain dynamic stages.
+template<typename... Kernels>
+class StaticPipeline : public Filter
+{
+public:
+    typedef pointwise::detail::Traits<Kernels...> Traits;
+
+    explicit StaticPipeline(const Kernels&... kernels) :
+        m_kernels(kernels...)
+    {}
+
+    std::string getName() const
+        { return "filters.static"; }
+    virtual bool streamable() const
+        { return true; }
+    virtual bool viewParallel() const
+        { return true; }
+
+    // Run the kernels, first kernel first, on a block of points.
+    void operator()(pointwise::PointBlock& block) const
+    {
+        pointwise::detail::Apply<0, sizeof...(Kernels)>::run(m_kernels,
+            block);
+    }
+
+private:
+    std::tuple<Kernels...> m_kernels;
+
+    virtual PointViewSet run(PointViewPtr inView)
+    {
+        using namespace pointwise;
+
+        PointViewSet viewSet;
+        const bool moves = Traits::movesPoints;
+        const bool drops = Traits::dropsPoints;
+        std::vector<char> keep(drops ? inView->size() : 0);
+
+        auto range = [this, &inView, &keep, moves, drops](PointId first,
+            PointId last)
+        {
+            const point_count_t capacity = PointBlock::capacity;
+            std::unique_ptr<PointBlock> block(new PointBlock);
+            PointView& view = *inView;
+            for (PointId begin = first; begin < last; begin += capacity)
+            {
+                point_count_t count =
+                    (std::min)(capacity, (point_count_t)(last - begin));
+                block->m_size = count;
+                view.getFieldArray(Dimension::Id::X, begin, count,
+                    block->m_x);
+                view.getFieldArray(Dimension::Id::Y, begin, count,
+                    block->m_y);
+                view.getFieldArray(Dimension::Id::Z, begin, count,
+                    block->m_z);
+                std::fill(block->m_keep, block->m_keep + count, 1);
+                (*this)(*block);
+                if (moves)
+                {
+                    view.setFieldArray(Dimension::Id::X, begin, count,
+                        block->m_x);
+                    view.setFieldArray(Dimension::Id::Y, begin, count,
+                        block->m_y);
+                    view.setFieldArray(Dimension::Id::Z, begin, count,
+                        block->m_z);
+                }
+                if (drops)
+                    std::copy(block->m_keep, block->m_keep + count,
+                        keep.begin() + begin);
+            }
+        };
+        parallelFilter(*inView, range);
+
+        if (!drops)
+        {
+            viewSet.insert(inView);
+            return viewSet;
+        }
+        PointViewPtr outView = inView->makeNew();
+        for (PointId i = 0; i < inView->size(); ++i)
+            if (keep[i])
+                outView->appendPoint(*inView, i);
+        viewSet.insert(outView);
+        return viewSet;
+    }
+};
+
+} // namespace pdal
@@ -36,6 +36,8 @@
 #define INCLUDED_STREAMFACTORY_HPP
 
 #include <pdal/pdal_internal.hpp>
+#include <pdal/util/Charbuf.hpp>
+#include <pdal/util/MappedFile.hpp>
 
 #include <boost/iostreams/stream.hpp>
 #include <boost/iostreams/device/file.hpp>
@@ -50,6 +52,7 @@
 
 #include <ostream>
 #include <istream>
+#include <memory>
 #include <vector>
 #include <map>
 #include <set>
@@ -144,6 +147,96 @@ private:
 };
 
 
+// Hands out streams over a region of a memory-mapped file.  Reads are
+// served straight from the mapping, and every stream allocated shares it,
+// so readers that open a stream per thread don't each open the file.
+// Positions in the streams are relative to the start of the region.
+class PDAL_DLL MappedSubsetStreamFactory : public StreamFactory
+{
+public:
+    // Throws pdal_error if the file can't be mapped or is shorter than
+    // the region.
+    MappedSubsetStreamFactory(const std::string& file, uint64_t offset,
+        uint64_t length);
+    virtual ~MappedSubsetStreamFactory();
+
+    virtual std::istream& allocate();
+    virtual void deallocate(std::istream&);
+
+private:
+    MappedFile m_file;
+    const char *m_begin;
+    std::size_t m_length;
+
+    struct StreamSet
+    {
+        StreamSet(const char *begin, std::size_t length);
+
+        // The mapping is read-only, but the put area of the buffer is
+        // never used by an istream.
+        Charbuf m_buf;
+        std::istream m_stream;
+    };
+    typedef std::map<std::istream*, StreamSet*> Map;
+    Map m_streams;
+};
+
+
+class RemoteFile;
+class RemoteStreambuf;
+
+// Hands out streams over a remote file named by an http://, https:// or
+// s3:// URL.  The file is read in blocks with range requests through
+// GDAL's network file systems (/vsicurl/ and /vsis3/, configured with the
+// usual GDAL and AWS environment variables).  Blocks are kept in a cache
+// shared by every stream allocated, the least recently used going first,
+// and when a stream reads blocks in order the blocks that follow are
+// fetched ahead of it in parallel.  Other paths are read through GDAL's
+// virtual file system as they stand.
+class PDAL_DLL RemoteStreamFactory : public StreamFactory
+{
+public:
+    static const std::size_t DefaultBlockSize = 1 << 20;
+    static const std::size_t DefaultCacheBlocks = 64;
+    static const std::size_t DefaultReadAhead = 4;
+
+    // \param url  URL or path of the file.
+    // \param blockSize  Size of the range requested for each block.
+    // \param cacheBlocks  Number of blocks kept in the cache.
+    // \param readAhead  Number of blocks fetched ahead of sequential reads,
+    //   which is also the number of requests made at once.
+    // Throws pdal_error if the file can't be opened.
+    RemoteStreamFactory(const std::string& url,
+        std::size_t blockSize = DefaultBlockSize,
+        std::size_t cacheBlocks = DefaultCacheBlocks,
+        std::size_t readAhead = DefaultReadAhead);
+    virtual ~RemoteStreamFactory();
+
+    // Whether 'path' is a URL that should be read with this factory.
+    static bool remote(const std::string& path);
+
+    // Size of the file.
+    uint64_t size() const;
+
+    virtual std::istream& allocate();
+    virtual void deallocate(std::istream&);
+
+private:
+    std::shared_ptr<RemoteFile> m_file;
+
+    struct StreamSet
+    {
+        StreamSet(std::shared_ptr<RemoteFile> file);
+        ~StreamSet();
+
+        std::unique_ptr<RemoteStreambuf> m_buf;
+        std::istream m_stream;
+    };
+    typedef std::map<std::istream*, StreamSet*> Map;
+    Map m_streams;
+};
+
+
 // Many of our writer classes want to take a filename or a stream
 // in their ctors, which means that we need a common piece of code that
 // creates and takes ownership of the stream, if needed.
@@ -0,0 +1,118 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+// A fixed set of worker threads that run queued tasks.  Each worker has its
+// own queue.  Tasks submitted from a worker go on that worker's queue and
+// idle workers steal from the queues of busy ones, so tasks that spawn
+// tasks keep every worker busy without contending for a single queue.
+class PDAL_DLL ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    // Start 'numThreads' workers (at least one).
+    explicit ThreadPool(std::size_t numThreads);
+    // Runs any tasks still queued before the workers are stopped.
+    ~ThreadPool();
+
+    // The pool shared by all stages.  It has one worker for each hardware
+    // thread unless the PDAL_NUM_THREADS environment variable says
+    // otherwise.
+    static ThreadPool& shared();
+
+    // The number of workers that run tasks.
+    std::size_t size() const
+        { return m_active; }
+    // Let only the first 'count' workers (at least one, at most the number
+    // started) run tasks, so that the effect of the number of threads can
+    // be measured without restarting the pool.  The others sleep.
+    void setActive(std::size_t count);
+
+    // Queue a task to be run by a worker.
+    std::future<void> submit(Task task);
+    // Wait for a submitted task to finish, rethrowing any exception it
+    // threw.  The waiting thread runs queued tasks in the meantime, so a
+    // task that waits on other tasks can't deadlock the pool.
+    void wait(std::future<void>& future);
+    // Split [0, count) into ranges of at least 'grain' items and call
+    // f(begin, end) for each range on the pool's workers, returning once
+    // every call has finished.  Ranges run at once, so f must only touch
+    // state belonging to its own range.
+    void parallelFor(std::size_t count, std::size_t grain,
+        const std::function<void(std::size_t, std::size_t)>& f);
+
+private:
+    typedef std::shared_ptr<std::packaged_task<void()>> TaskPtr;
+    struct Queue
+    {
+        std::mutex m_mutex;
+        std::deque<TaskPtr> m_tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    // Guards m_pending, m_stop and changes to m_active.
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::size_t m_pending;
+    std::size_t m_next;
+    std::atomic<std::size_t> m_active;
+    bool m_stop;
+
+    void work(std::size_t index);
+    bool runOne(std::size_t index);
+    std::size_t currentQueue();
+
+    ThreadPool& operator=(const ThreadPool&); // not implemented
+    ThreadPool(const ThreadPool&); // not implemented
+};
+
+} // namespace pdal
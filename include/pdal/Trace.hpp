@@ -0,0 +1,107 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+
+#include <atomic>
+#include <string>
+
+namespace pdal
+{
+
+class Stage;
+
+// Timeline tracing of a run, written as Chrome trace JSON that can be
+// loaded in chrome://tracing or Perfetto.  Tracing is off unless started
+// with start() or by setting PDAL_TRACE to the name of the output file,
+// in which case the trace is written when the program exits.
+namespace trace
+{
+
+namespace detail
+{
+    extern PDAL_DLL std::atomic<bool> g_enabled;
+}
+
+inline bool enabled()
+    { return detail::g_enabled.load(std::memory_order_relaxed); }
+
+// Discard anything recorded so far and record spans until stop().
+PDAL_DLL void start(const std::string& filename);
+
+// Stop recording and write the trace to the file passed to start().
+// Does nothing if tracing isn't on.
+PDAL_DLL void stop();
+
+// A span of time on the calling thread, from construction to destruction.
+// Nothing is recorded unless tracing was on when the span was created.
+class PDAL_DLL Span
+{
+public:
+    Span(const char *category, const std::string& name) : m_start(-1)
+    {
+        if (enabled())
+            begin(category, name);
+    }
+    // Names the span for a phase of a stage's work, as "<stage> <phase>".
+    Span(const char *category, const char *phase, const Stage& stage) :
+        m_start(-1)
+    {
+        if (enabled())
+            begin(category, phase, stage);
+    }
+    ~Span()
+    {
+        if (m_start >= 0)
+            end();
+    }
+
+private:
+    const char *m_category;
+    std::string m_name;
+    double m_start;
+
+    void begin(const char *category, const std::string& name);
+    void begin(const char *category, const char *phase, const Stage& stage);
+    void end();
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+};
+
+} // namespace trace
+} // namespace pdal
+
@@ -0,0 +1,95 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace pdal
+{
+
+class PointView;
+
+// The position and attitude of a platform over time, such as readers.sbet
+// produces, for looking up the pose at which each point was taken.
+class PDAL_DLL Trajectory
+{
+public:
+    struct Pose
+    {
+        double time;
+        double x;       // Longitude, radians
+        double y;       // Latitude, radians
+        double z;       // Height, metres
+        double roll;    // radians
+        double pitch;   // radians
+        double heading; // radians
+    };
+
+    Trajectory()
+        {}
+    // Make a trajectory from the GpsTime, X, Y, Z, Roll, Pitch and
+    // PlatformHeading of the points of 'view', which must be in time order.
+    explicit Trajectory(const PointView& view);
+
+    // Append a pose.  Throws pdal_error if it is earlier than the last.
+    void add(const Pose& pose);
+
+    std::size_t size() const
+        { return m_poses.size(); }
+    bool empty() const
+        { return m_poses.empty(); }
+    const Pose& operator[](std::size_t i) const
+        { return m_poses[i]; }
+
+    // Pose at 'time', interpolated between the poses either side of it.
+    // Times before the first pose or after the last give that pose.
+    // Throws pdal_error if the trajectory is empty.
+    Pose interpolate(double time) const;
+    // As above, but starting the search for 'time' at the pose segment in
+    // 'hint', which is updated to the segment found.  When successive
+    // times are close together, as those of consecutive points are, each
+    // lookup takes constant time.  Start 'hint' at zero.
+    Pose interpolate(double time, std::size_t& hint) const;
+
+private:
+    std::vector<Pose> m_poses;
+
+    std::size_t findSegment(double time, std::size_t hint) const;
+};
+
+} // namespace pdal
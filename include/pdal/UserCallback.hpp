@@ -36,6 +36,8 @@
 
 #include <pdal/pdal_internal.hpp>
 
+#include <atomic>
+
 namespace pdal
 {
 
@@ -85,8 +87,7 @@ public:
     {
         ++m_heartbeats;
         callback();
-        if (m_interruptFlag)
-            throw pipeline_interrupt("user requested interrupt");
+        checkInterrupt();
     }
 
     // This will be called by the pipeline (via check()) at various times
@@ -105,16 +106,63 @@ public:
     inline uint64_t getHeartbeats() const
         { return m_heartbeats; }
 
+    // Ask the pipeline to stop.  This may be called from any thread (a
+    // watchdog, say).  Stages stop with a pipeline_interrupt the next time
+    // they poll the callback.
+    void interrupt()
+        { m_interruptFlag = true; }
+
+    // Unlike invoke(), this may be called from several threads at once.
+    bool interrupted() const
+        { return m_interruptFlag; }
+
+    // Throw pipeline_interrupt if an interrupt has been requested.
+    void checkInterrupt() const
+    {
+        if (m_interruptFlag)
+            throw pipeline_interrupt("user requested interrupt");
+    }
+
 protected:
     void setInterruptFlag(bool value)
         { m_interruptFlag = value; }
 
 private:
     double m_percentComplete;  // in range [0..100]
-    bool m_interruptFlag; // true iff user would like the pipeline to abort
+    // true iff user would like the pipeline to abort
+    std::atomic<bool> m_interruptFlag;
     uint64_t m_heartbeats; // number of times the check routine has been called
     point_count_t m_total;
 };
 
+
+// Reports progress to a UserCallback from a loop over points.  Invoking the
+// callback for every point would cost more than the work itself, so poll()
+// invokes it only every 'interval' points and otherwise just compares.
+class PDAL_DLL ProgressPoller
+{
+public:
+    ProgressPoller(UserCallback& callback, point_count_t interval = 65536) :
+        m_callback(callback), m_interval(std::max(interval,
+        (point_count_t)1)), m_next(0)
+    {}
+
+    // Note that 'count' points have been processed in all.  Throws
+    // pipeline_interrupt if an interrupt has been requested.
+    void poll(point_count_t count)
+    {
+        if (count >= m_next)
+        {
+            m_next = count + m_interval;
+            m_callback.invoke(count);
+        }
+    }
+
+private:
+    UserCallback& m_callback;
+    point_count_t m_interval;
+    point_count_t m_next;
+};
+
 } // namespace pdal
 
@@ -46,6 +46,7 @@
 #include <istream>
 #include <limits>
 #include <cstring>
+#include <ctime>
 #include <sstream>
 #include <vector>
 #include <map>
@@ -178,6 +179,17 @@ namespace Utils
         return i;
     }
 
+    // 64-bit FNV-1a hash of a buffer.  Pass the result of an earlier call
+    // as 'h' to hash several buffers as one.
+    inline uint64_t hash64(const void *buf, size_t size,
+        uint64_t h = 14695981039346656037ULL)
+    {
+        const unsigned char *p = (const unsigned char *)buf;
+        while (size--)
+            h = (h ^ *p++) * 1099511628211ULL;
+        return h;
+    }
+
     template<typename Target, typename Source>
     Target saturation_cast(Source const& src)
     {
@@ -202,6 +214,8 @@ namespace Utils
     PDAL_DLL char *getenv(const char *env);
     PDAL_DLL std::string getenv(std::string const& name);
     PDAL_DLL int putenv(const char *env);
+    // Thread-safe std::gmtime().  Returns false if 't' can't be converted.
+    PDAL_DLL bool gmtime(std::time_t t, std::tm& tm);
 
     // aid to operator>> parsers
     PDAL_DLL void eatwhitespace(std::istream& s);
@@ -38,6 +38,7 @@
 #include <pdal/Options.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/Stage.hpp>
+#include <pdal/Trace.hpp>
 
 #include <string>
 
@@ -75,7 +76,10 @@ private:
     virtual PointViewSet run(PointViewPtr view)
     {
         PointViewSet viewSet;
-        write(view);
+        {
+            trace::Span span("io", "write", *this);
+            write(view);
+        }
         viewSet.insert(view);
         return viewSet;
     }
@@ -43,6 +43,7 @@
 #include <pdal/Dimension.hpp>
 #include <pdal/Metadata.hpp>
 
+#include <memory>
 #include <string>
 #include <stdarg.h>
 #include <vector>
@@ -94,8 +95,10 @@ public:
     XMLSchema() : m_orientation(Orientation::PointMajor)
     {}
 
-    ~XMLSchema()
-        { xmlCleanupParser(); }
+    // Parsed schemas are shared and never freed, so a reader that sees the
+    // same schema for each patch or block parses it only once.
+    static std::shared_ptr<const XMLSchema> cached(const std::string& xml,
+        const std::string& xsd = "");
 
     std::string xml() const;
     DimTypeList dimTypes() const;
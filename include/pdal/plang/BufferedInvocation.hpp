@@ -42,16 +42,29 @@ namespace pdal
 namespace plang
 {
 
+// Passes the dimensions of points to a script as numpy arrays and sets
+// the dimensions from the arrays the script outputs.  Where the values of
+// a dimension are evenly spaced in the point table, which they are for the
+// points of a freshly read view within a block of the table, the array
+// refers to the table's memory rather than to a copy of it, so a script
+// that changes an input array in place changes the points.
 class PDAL_DLL BufferedInvocation : public Invocation
 {
 public:
     BufferedInvocation(const Script& script);
 
-    void begin(PointView& view);
-    void end(PointView& view);
+    void begin(PointView& view)
+        { begin(view, 0, view.size()); }
+    void end(PointView& view)
+        { end(view, 0, view.size()); }
+    // Pass and set only the 'count' points of the view from 'first'.
+    void begin(PointView& view, PointId first, point_count_t count);
+    void end(PointView& view, PointId first, point_count_t count);
 
 private:
     std::vector<void *> m_buffers;
+    // The memory passed in place for each dimension, or NULL.
+    std::vector<char *> m_spans;
     BufferedInvocation& operator=(BufferedInvocation const& rhs); // nope
 };
 
@@ -58,13 +58,22 @@ public:
 
 
     // creates a Python variable pointing to a (one dimensional) C array
-    // adds the new variable to the arguments dictionary
+    // adds the new variable to the arguments dictionary.  The values are
+    // 'stride' bytes apart, or packed if it's 0.  The array refers to
+    // 'data' rather than copying it.
     void insertArgument(std::string const& name,
                         uint8_t* data,
                         Dimension::Type::Enum t,
-                        point_count_t count);
+                        point_count_t count,
+                        std::ptrdiff_t stride = 0);
     void *extractResult(const std::string& name,
                         Dimension::Type::Enum dataType);
+    // As above, but checks that the array has at least 'count' values and
+    // sets 'stride' to the bytes between them.
+    void *extractResult(const std::string& name,
+                        Dimension::Type::Enum dataType,
+                        point_count_t count,
+                        std::ptrdiff_t& stride);
 
     bool hasOutputVariable(const std::string& name) const;
 
@@ -108,3 +108,182 @@
             *last = *first; \
             *first = x; \
         }} while(false)
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <pdal/portable_endian.hpp>
+
+namespace pdal
+{
+
+// Conversion of arrays of values between host order and little- or
+// big-endian order.  The loops work on one value at a time with shifts so
+// that compilers can turn them into vector byte shuffles, and conversions
+// that are no-ops on the host compile away.
+namespace Endian
+{
+
+inline bool hostIsLittle()
+    { return htole16((uint16_t)1) == 1; }
+
+namespace detail
+{
+
+template<std::size_t SIZE>
+struct Word;
+
+template<>
+struct Word<1>
+{
+    typedef uint8_t type;
+    static type swap(type v)
+        { return v; }
+};
+
+template<>
+struct Word<2>
+{
+    typedef uint16_t type;
+    static type swap(type v)
+        { return (type)((v >> 8) | (v << 8)); }
+};
+
+template<>
+struct Word<4>
+{
+    typedef uint32_t type;
+    static type swap(type v)
+    {
+        return (v >> 24) | ((v >> 8) & 0xFF00u) | ((v << 8) & 0xFF0000u) |
+            (v << 24);
+    }
+};
+
+template<>
+struct Word<8>
+{
+    typedef uint64_t type;
+    static type swap(type v)
+    {
+        return ((type)Word<4>::swap((uint32_t)v) << 32) |
+            Word<4>::swap((uint32_t)(v >> 32));
+    }
+};
+
+// Read a value of type T from 'src', swapping its bytes if 'swap' is set.
+template<typename T>
+inline T load(const char *src, bool swap)
+{
+    typedef Word<sizeof(T)> W;
+    typename W::type u;
+    std::memcpy(&u, src, sizeof(T));
+    if (swap)
+        u = W::swap(u);
+    T v;
+    std::memcpy(&v, &u, sizeof(T));
+    return v;
+}
+
+// Write a value of type T to 'dst', swapping its bytes if 'swap' is set.
+template<typename T>
+inline void store(T v, char *dst, bool swap)
+{
+    typedef Word<sizeof(T)> W;
+    typename W::type u;
+    std::memcpy(&u, &v, sizeof(T));
+    if (swap)
+        u = W::swap(u);
+    std::memcpy(dst, &u, sizeof(T));
+}
+
+template<typename T, typename OUT>
+inline void decode(const char *src, std::size_t count, OUT *out, bool swap)
+{
+    if (swap)
+        for (std::size_t i = 0; i < count; ++i, src += sizeof(T))
+            out[i] = (OUT)load<T>(src, true);
+    else
+        for (std::size_t i = 0; i < count; ++i, src += sizeof(T))
+            out[i] = (OUT)load<T>(src, false);
+}
+
+template<typename T, typename IN>
+inline void encode(const IN *in, std::size_t count, char *dst, bool swap)
+{
+    if (swap)
+        for (std::size_t i = 0; i < count; ++i, dst += sizeof(T))
+            store((T)in[i], dst, true);
+    else
+        for (std::size_t i = 0; i < count; ++i, dst += sizeof(T))
+            store((T)in[i], dst, false);
+}
+
+} // namespace detail
+
+/// Reverse the bytes of each of 'count' values of type T in place.
+template<typename T>
+inline void swapBytes(T *v, std::size_t count)
+{
+    char *buf = (char *)v;
+    for (std::size_t i = 0; i < count; ++i, buf += sizeof(T))
+        detail::store(detail::load<T>(buf, true), buf, false);
+}
+
+/// Convert 'count' little-endian values to host order in place.
+template<typename T>
+inline void littleToHost(T *v, std::size_t count)
+{
+    if (!hostIsLittle())
+        swapBytes(v, count);
+}
+
+/// Convert 'count' big-endian values to host order in place.
+template<typename T>
+inline void bigToHost(T *v, std::size_t count)
+{
+    if (hostIsLittle())
+        swapBytes(v, count);
+}
+
+/// Convert 'count' values in host order to little-endian in place.
+template<typename T>
+inline void hostToLittle(T *v, std::size_t count)
+    { littleToHost(v, count); }
+
+/// Convert 'count' values in host order to big-endian in place.
+template<typename T>
+inline void hostToBig(T *v, std::size_t count)
+    { bigToHost(v, count); }
+
+/// Decode 'count' little-endian values of type T from a buffer, which
+/// needn't be aligned, converting them to OUT.
+/// \param src  Buffer of encoded values.
+/// \param count  Number of values to decode.
+/// \param out  Array to hold the decoded values.
+template<typename T, typename OUT>
+inline void fromLittle(const char *src, std::size_t count, OUT *out)
+    { detail::decode<T>(src, count, out, !hostIsLittle()); }
+
+/// Decode 'count' big-endian values of type T from a buffer, which needn't
+/// be aligned, converting them to OUT.
+template<typename T, typename OUT>
+inline void fromBig(const char *src, std::size_t count, OUT *out)
+    { detail::decode<T>(src, count, out, hostIsLittle()); }
+
+/// Encode 'count' values as little-endian values of type T.
+/// \param in  Values to encode.
+/// \param count  Number of values to encode.
+/// \param dst  Buffer of at least count * sizeof(T) bytes.
+template<typename T, typename IN>
+inline void toLittle(const IN *in, std::size_t count, char *dst)
+    { detail::encode<T>(in, count, dst, !hostIsLittle()); }
+
+/// Encode 'count' values as big-endian values of type T.
+template<typename T, typename IN>
+inline void toBig(const IN *in, std::size_t count, char *dst)
+    { detail::encode<T>(in, count, dst, hostIsLittle()); }
+
+} // namespace Endian
+} // namespace pdal
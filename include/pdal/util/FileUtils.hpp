@@ -37,10 +37,12 @@
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <ctime>
 #include <istream>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #ifndef PDAL_DLL
 #if defined(_WIN32)
@@ -80,6 +82,8 @@ public:
     static void renameFile(const std::string& dest, const std::string& src);
     static bool fileExists(const std::string& filename);
     static uintmax_t fileSize(const std::string& filename);
+    // Time of the last change to a file, in seconds since the epoch.
+    static std::time_t lastWriteTime(const std::string& filename);
 
     // reads a file into a text string for you
     static std::string readFileIntoString(const std::string& filename);
@@ -111,6 +115,11 @@ public:
     
     static std::string readFileAsString(std::string const& filename);
 
+    // return the files matching a pattern, sorted by name.  '*' and '?'
+    // match any run of characters or any single character in the
+    // filename part of the pattern, e.g. "d:/foo/*.la?"
+    static std::vector<std::string> glob(const std::string& pattern);
+
 private:
     static std::string addTrailingSlash(std::string path);
 
@@ -36,6 +36,8 @@
 
 #include <pdal/pdal_export.hpp>
 
+#include <cstddef>
+
 namespace pdal
 {
 namespace georeference
@@ -88,5 +90,18 @@ inline RotationMatrix createIdentityMatrix()
 PDAL_DLL Xyz georeferenceWgs84(double range, double scanAngle,
                       const RotationMatrix& boresightMatrix,
                       const RotationMatrix& imuMatrix, const Xyz& gpsPoint);
+
+
+// Georeference 'count' returns at once.  Element i of each array describes
+// return i: its range and scan angle, and the IMU matrix and GPS point
+// (longitude, latitude, height) of the trajectory sample it was taken at.
+// Results are written to 'out', which must hold 'count' points.  Runs of
+// returns that share a scan angle or latitude, as the returns of one pulse
+// do, reuse the trigonometry of the first.
+PDAL_DLL void georeferenceWgs84(std::size_t count, const double *range,
+                    const double *scanAngle,
+                    const RotationMatrix& boresightMatrix,
+                    const RotationMatrix *imuMatrix, const Xyz *gpsPoint,
+                    Xyz *out);
 }
 }
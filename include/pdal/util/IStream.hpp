@@ -37,11 +37,13 @@
 #include <sys/types.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
 #include <stack>
 #include <vector>
 #include <cstring>
+#include <string>
 
 #include <pdal/portable_endian.hpp>
 #include <pdal/pdal_export.hpp>
@@ -325,6 +327,212 @@ private:
 };
 
 
+/// Stream wrapper for input of little-endian binary data that reads the
+/// stream a window at a time.  Values are decoded from the window and the
+/// window is refilled with a single read when it runs out, rather than
+/// calling the stream for each value.  The wrapped stream is positioned
+/// ahead of the data that has been extracted, so it shouldn't be read
+/// directly while the wrapper is in use.
+class PDAL_DLL BufferedILeStream
+{
+public:
+    static const size_t DefaultWindow = 1 << 16;
+
+    BufferedILeStream(std::istream *stream, size_t window = DefaultWindow) :
+        m_stream(stream), m_buf(std::max(window, sizeof(uint64_t))),
+        m_gptr(0), m_egptr(0), m_good(true)
+        { m_bufPos = m_stream->tellg(); }
+
+    operator bool ()
+        { return m_good; }
+    bool good() const
+        { return m_good; }
+    std::streampos position() const
+        { return m_bufPos + (std::streamoff)m_gptr; }
+    std::istream *stream()
+        { return m_stream; }
+
+    void seek(std::streampos pos)
+    {
+        // Seeks inside the window just move the get location.
+        if (pos >= m_bufPos && pos <= m_bufPos + (std::streamoff)m_egptr)
+        {
+            m_gptr = (size_t)(pos - m_bufPos);
+            return;
+        }
+        m_stream->clear();
+        m_stream->seekg(pos, std::istream::beg);
+        m_bufPos = pos;
+        m_gptr = m_egptr = 0;
+        m_good = (bool)(*m_stream);
+    }
+    void skip(std::streamoff offset)
+        { seek(position() + offset); }
+
+    void get(std::string& s, size_t size)
+    {
+        std::unique_ptr<char[]> buf(new char[size + 1]);
+        get(buf.get(), size);
+        buf[size] = '\0';
+        s = buf.get();
+    }
+
+    void get(std::vector<char>& buf)
+        { get(buf.data(), buf.size()); }
+
+    void get(std::vector<unsigned char>& buf)
+        { get((char *)buf.data(), buf.size()); }
+
+    void get(unsigned char *buf, size_t size)
+        { get((char *)buf, size); }
+
+    void get(char *buf, size_t size)
+    {
+        size_t avail = std::min(size, m_egptr - m_gptr);
+        std::memcpy(buf, m_buf.data() + m_gptr, avail);
+        m_gptr += avail;
+        size -= avail;
+        if (size == 0)
+            return;
+        buf += avail;
+
+        // Blocks larger than the window are read straight into the caller's
+        // buffer.
+        if (size >= m_buf.size())
+        {
+            m_bufPos += (std::streamoff)m_egptr;
+            m_gptr = m_egptr = 0;
+            m_stream->read(buf, size);
+            m_bufPos += m_stream->gcount();
+            if ((size_t)m_stream->gcount() != size)
+                m_good = false;
+            return;
+        }
+        if (!fill(size))
+            return;
+        std::memcpy(buf, m_buf.data(), size);
+        m_gptr = size;
+    }
+
+    BufferedILeStream& operator >> (uint8_t& v)
+    {
+        extract(v);
+        return *this;
+    }
+
+    BufferedILeStream& operator >> (int8_t& v)
+    {
+        extract(v);
+        return *this;
+    }
+
+    BufferedILeStream& operator >> (uint16_t& v)
+    {
+        extract(v);
+        v = le16toh(v);
+        return *this;
+    }
+
+    BufferedILeStream& operator >> (int16_t& v)
+    {
+        extract(v);
+        v = (int16_t)le16toh((uint16_t)v);
+        return *this;
+    }
+
+    BufferedILeStream& operator >> (uint32_t& v)
+    {
+        extract(v);
+        v = le32toh(v);
+        return *this;
+    }
+
+    BufferedILeStream& operator >> (int32_t& v)
+    {
+        extract(v);
+        v = (int32_t)le32toh((uint32_t)v);
+        return *this;
+    }
+
+    BufferedILeStream& operator >> (uint64_t& v)
+    {
+        extract(v);
+        v = le64toh(v);
+        return *this;
+    }
+
+    BufferedILeStream& operator >> (int64_t& v)
+    {
+        extract(v);
+        v = (int64_t)le64toh((uint64_t)v);
+        return *this;
+    }
+
+    BufferedILeStream& operator >> (float& v)
+    {
+        uint32_t tmp;
+        extract(tmp);
+        tmp = le32toh(tmp);
+        std::memcpy(&v, &tmp, sizeof(tmp));
+        return *this;
+    }
+
+    BufferedILeStream& operator >> (double& v)
+    {
+        uint64_t tmp;
+        extract(tmp);
+        tmp = le64toh(tmp);
+        std::memcpy(&v, &tmp, sizeof(tmp));
+        return *this;
+    }
+
+private:
+    std::istream *m_stream;
+    std::vector<char> m_buf;
+    // Stream position of the start of the window.
+    std::streampos m_bufPos;
+    // Current get location in the window.
+    size_t m_gptr;
+    // End of the valid data in the window.
+    size_t m_egptr;
+    bool m_good;
+
+    template<typename T>
+    void extract(T& v)
+    {
+        if (m_egptr - m_gptr < sizeof(T) && !fill(sizeof(T)))
+        {
+            v = 0;
+            return;
+        }
+        std::memcpy(&v, m_buf.data() + m_gptr, sizeof(T));
+        m_gptr += sizeof(T);
+    }
+
+    // Move the unread data to the front of the window and fill the rest
+    // of it with one read.  Returns false if 'need' bytes aren't available.
+    bool fill(size_t need)
+    {
+        size_t left = m_egptr - m_gptr;
+        std::copy(m_buf.begin() + m_gptr, m_buf.begin() + m_egptr,
+            m_buf.begin());
+        m_bufPos += (std::streamoff)m_gptr;
+        m_gptr = 0;
+        m_stream->read(m_buf.data() + left, m_buf.size() - left);
+        m_egptr = left + (size_t)m_stream->gcount();
+        if (m_egptr < need)
+        {
+            m_good = false;
+            return false;
+        }
+        return true;
+    }
+
+    BufferedILeStream(const BufferedILeStream&); // not implemented
+    BufferedILeStream& operator=(const BufferedILeStream&); // not implemented
+};
+
+
 /// Stream position marker with rewinding support.
 class IStreamMarker
 {
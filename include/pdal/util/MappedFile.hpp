@@ -0,0 +1,75 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <pdal/util/FileUtils.hpp>
+
+namespace pdal
+{
+
+// A read-only view of a whole file.  The file is memory mapped where the
+// platform allows and read into memory otherwise.
+class PDAL_DLL MappedFile
+{
+public:
+    MappedFile() : m_data(NULL), m_size(0), m_mapped(false)
+        {}
+    ~MappedFile()
+        { close(); }
+
+    // Map 'filename', replacing any file already open.  Throws pdal_error
+    // if the file can't be opened or mapped.
+    void open(const std::string& filename);
+    void close();
+
+    const char *data() const
+        { return m_data; }
+    std::size_t size() const
+        { return m_size; }
+
+private:
+    const char *m_data;
+    std::size_t m_size;
+    bool m_mapped;
+    std::string m_buf;
+
+    MappedFile& operator=(const MappedFile&); // not implemented
+    MappedFile(const MappedFile&); // not implemented
+};
+
+} // namespace pdal
@@ -36,9 +36,12 @@
 #include <sys/types.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <fstream>
 #include <cstring>
 #include <stack>
+#include <string>
+#include <vector>
 
 #include <pdal/portable_endian.hpp>
 #include <pdal/pdal_internal.hpp>
@@ -86,6 +89,8 @@ public:
         { m_stream->write((const char *)c, len); }
     std::streampos position() const
         { return m_stream->tellp(); }
+    std::ostream *stream()
+        { return m_stream; }
     void pushStream(std::ostream *strm)
     {
         m_streams.push(m_stream);
@@ -196,6 +201,150 @@ public:
     }
 };
 
+/// Stream wrapper for output of binary data in little-endian format that
+/// collects values in a buffer and writes the buffer to the stream with
+/// a single write when it fills or is flushed.  The buffer is flushed when
+/// the wrapper is destroyed.
+class PDAL_DLL BufferedOLeStream
+{
+public:
+    static const size_t DefaultBufferSize = 1 << 16;
+
+    BufferedOLeStream(std::ostream *stream,
+            size_t size = DefaultBufferSize) :
+        m_stream(stream), m_buf(std::max(size, sizeof(uint64_t))),
+        m_pptr(0)
+        {}
+    ~BufferedOLeStream()
+        { flush(); }
+
+    void flush()
+    {
+        if (m_pptr)
+            m_stream->write(m_buf.data(), m_pptr);
+        m_pptr = 0;
+    }
+    operator bool ()
+        { return (bool)(*m_stream); }
+    void seek(std::streampos pos)
+    {
+        flush();
+        m_stream->seekp(pos, std::ostream::beg);
+    }
+    std::streampos position() const
+        { return m_stream->tellp() + (std::streamoff)m_pptr; }
+    std::ostream *stream()
+        { return m_stream; }
+
+    void put(const std::string& s)
+        { put(s, s.size()); }
+    void put(const std::string& s, size_t len)
+    {
+        std::string os = s;
+        os.resize(len);
+        put(os.c_str(), len);
+    }
+    void put(const unsigned char *c, size_t len)
+        { put((const char *)c, len); }
+    void put(const char *c, size_t len)
+    {
+        if (len > m_buf.size() - m_pptr)
+        {
+            flush();
+            // Blocks larger than the buffer are written as they stand.
+            if (len >= m_buf.size())
+            {
+                m_stream->write(c, len);
+                return;
+            }
+        }
+        std::memcpy(m_buf.data() + m_pptr, c, len);
+        m_pptr += len;
+    }
+
+    BufferedOLeStream& operator << (uint8_t v)
+    {
+        insert(v);
+        return *this;
+    }
+
+    BufferedOLeStream& operator << (int8_t v)
+    {
+        insert(v);
+        return *this;
+    }
+
+    BufferedOLeStream& operator << (uint16_t v)
+    {
+        insert(htole16(v));
+        return *this;
+    }
+
+    BufferedOLeStream& operator << (int16_t v)
+    {
+        insert((int16_t)htole16((uint16_t)v));
+        return *this;
+    }
+
+    BufferedOLeStream& operator << (uint32_t v)
+    {
+        insert(htole32(v));
+        return *this;
+    }
+
+    BufferedOLeStream& operator << (int32_t v)
+    {
+        insert((int32_t)htole32((uint32_t)v));
+        return *this;
+    }
+
+    BufferedOLeStream& operator << (uint64_t v)
+    {
+        insert(htole64(v));
+        return *this;
+    }
+
+    BufferedOLeStream& operator << (int64_t v)
+    {
+        insert((int64_t)htole64((uint64_t)v));
+        return *this;
+    }
+
+    BufferedOLeStream& operator << (float v)
+    {
+        uint32_t tmp(0);
+        std::memcpy(&tmp, &v, sizeof(v));
+        insert(htole32(tmp));
+        return *this;
+    }
+
+    BufferedOLeStream& operator << (double v)
+    {
+        uint64_t tmp(0);
+        std::memcpy(&tmp, &v, sizeof(v));
+        insert(htole64(tmp));
+        return *this;
+    }
+
+private:
+    std::ostream *m_stream;
+    std::vector<char> m_buf;
+    // Current put location in the buffer.
+    size_t m_pptr;
+
+    template<typename T>
+    void insert(T v)
+    {
+        if (m_buf.size() - m_pptr < sizeof(T))
+            flush();
+        std::memcpy(m_buf.data() + m_pptr, &v, sizeof(T));
+        m_pptr += sizeof(T);
+    }
+
+    BufferedOLeStream(const BufferedOLeStream&); // not implemented
+    BufferedOLeStream& operator=(const BufferedOLeStream&); // not implemented
+};
+
 /// Stream position marker with rewinding/reset support.
 class OStreamMarker
 {
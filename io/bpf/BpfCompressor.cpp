@@ -34,19 +34,143 @@
 
 #include "BpfCompressor.hpp"
 
+#include <algorithm>
+
 #include <pdal/pdal_internal.hpp>
 
+#ifdef PDAL_HAVE_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#ifdef PDAL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 namespace pdal
 {
 
+bool BpfCompressor::supported(BpfCompression::Enum codec)
+{
+    switch (codec)
+    {
+    case BpfCompression::Zlib:
+        return true;
+#ifdef PDAL_HAVE_LZ4
+    case BpfCompression::Lz4:
+        return true;
+#endif
+#ifdef PDAL_HAVE_ZSTD
+    case BpfCompression::Zstd:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+
+int BpfCompressor::defaultLevel(BpfCompression::Enum codec)
+{
+    switch (codec)
+    {
+    case BpfCompression::Zlib:
+        return Z_DEFAULT_COMPRESSION;
+    case BpfCompression::Zstd:
+        return 3;
+    default:
+        // LZ4's fast mode.  Levels above 0 use LZ4HC.
+        return 0;
+    }
+}
+
+
+bool BpfCompressor::decompress(BpfCompression::Enum codec,
+    const char *inbuf, size_t insize, char *outbuf, size_t outsize)
+{
+    if (insize == 0)
+        return true;
+
+    switch (codec)
+    {
+    case BpfCompression::Zlib:
+    {
+        z_stream strm;
+
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        strm.avail_in = 0;
+        strm.next_in = Z_NULL;
+        if (inflateInit(&strm) != Z_OK)
+            return false;
+
+        strm.avail_in = insize;
+        strm.next_in =
+            reinterpret_cast<unsigned char *>(const_cast<char *>(inbuf));
+        strm.avail_out = outsize;
+        strm.next_out = (unsigned char *)outbuf;
+
+        int ret = ::inflate(&strm, Z_NO_FLUSH);
+        (void)inflateEnd(&strm);
+        return ret == Z_STREAM_END;
+    }
+#ifdef PDAL_HAVE_LZ4
+    case BpfCompression::Lz4:
+        return LZ4_decompress_safe(inbuf, outbuf, (int)insize,
+            (int)outsize) == (int)outsize;
+#endif
+#ifdef PDAL_HAVE_ZSTD
+    case BpfCompression::Zstd:
+        return ZSTD_decompress(outbuf, outsize, inbuf, insize) == outsize;
+#endif
+    default:
+        return false;
+    }
+}
+
+
+bool BpfCompressor::deltaDim(Dimension::Id::Enum id)
+{
+    return id == Dimension::Id::X || id == Dimension::Id::Y ||
+        id == Dimension::Id::Z || id == Dimension::Id::GpsTime;
+}
+
+
+void BpfCompressor::shuffle(char *buf, size_t size)
+{
+    const size_t count = size / sizeof(uint32_t);
+    std::vector<char> tmp(buf, buf + count * sizeof(uint32_t));
+    for (size_t i = 0; i < count; ++i)
+        for (size_t b = 0; b < sizeof(uint32_t); ++b)
+            buf[b * count + i] = tmp[i * sizeof(uint32_t) + b];
+}
+
+
+void BpfCompressor::unshuffle(char *buf, size_t size)
+{
+    const size_t count = size / sizeof(uint32_t);
+    std::vector<char> tmp(buf, buf + count * sizeof(uint32_t));
+    for (size_t i = 0; i < count; ++i)
+        for (size_t b = 0; b < sizeof(uint32_t); ++b)
+            buf[i * sizeof(uint32_t) + b] = tmp[b * count + i];
+}
+
+
 void BpfCompressor::startBlock()
 {
-    // Initialize the stream.
-    m_strm.zalloc = Z_NULL;
-    m_strm.zfree = Z_NULL;
-    m_strm.opaque = Z_NULL;
-    if (deflateInit(&m_strm, Z_DEFAULT_COMPRESSION) != Z_OK)
-        throw pdal_error("Could not initialize BPF compressor.");
+    if (m_codec == BpfCompression::Zlib)
+    {
+        // Initialize the stream.
+        m_strm.zalloc = Z_NULL;
+        m_strm.zfree = Z_NULL;
+        m_strm.opaque = Z_NULL;
+        if (deflateInit(&m_strm, m_level) != Z_OK)
+            throw pdal_error("Could not initialize BPF compressor.");
+    }
+    else if (!supported(m_codec))
+        throw pdal_error("BPF compression codec not supported by this "
+            "build of PDAL.");
+    m_block.clear();
 
     m_rawSize = 0;
     m_compressedSize = 0;
@@ -76,19 +200,28 @@ void BpfCompressor::compress()
 
     m_rawSize += rawWritten;
 
-    // Deflate the data in the buffer and write it to the output stream.
-    m_strm.avail_in = rawWritten;
-    m_strm.next_in = (unsigned char *)m_inbuf.data();
-    m_strm.avail_out = CHUNKSIZE;
-    m_strm.next_out = m_tmpbuf;
-    while (m_strm.avail_in)
+    if (m_codec != BpfCompression::Zlib || m_shuffle)
     {
-        int ret = ::deflate(&m_strm, Z_NO_FLUSH);
-        size_t written = CHUNKSIZE - m_strm.avail_out;
-        m_compressedSize += written;
-        m_out.put(m_tmpbuf, written);
+        // The block is compressed all at once when it's finished.
+        m_block.insert(m_block.end(), m_inbuf.data(),
+            m_inbuf.data() + rawWritten);
+    }
+    else
+    {
+        // Deflate the data in the buffer and write it to the output stream.
+        m_strm.avail_in = rawWritten;
+        m_strm.next_in = (unsigned char *)m_inbuf.data();
         m_strm.avail_out = CHUNKSIZE;
         m_strm.next_out = m_tmpbuf;
+        while (m_strm.avail_in)
+        {
+            ::deflate(&m_strm, Z_NO_FLUSH);
+            size_t written = CHUNKSIZE - m_strm.avail_out;
+            m_compressedSize += written;
+            m_out.put(m_tmpbuf, written);
+            m_strm.avail_out = CHUNKSIZE;
+            m_strm.next_out = m_tmpbuf;
+        }
     }
 
     // All data has been written.  Reinitialize input buffer's streambuf and
@@ -103,20 +236,25 @@ void BpfCompressor::finish()
     // Pop our special stream so that we can write the the file.
     m_out.popStream();
 
-    // Deflate and write the result to the output file.
-    int ret = Z_OK;
-    while (ret == Z_OK)
+    if (m_codec != BpfCompression::Zlib || m_shuffle)
+        finishBlock();
+    else
     {
-        ret = ::deflate(&m_strm, Z_FINISH);
-        size_t written = CHUNKSIZE - m_strm.avail_out;
-        m_compressedSize += written;
-        m_out.put(m_tmpbuf, written);
-        m_strm.avail_out = CHUNKSIZE;
-        m_strm.next_out = m_tmpbuf;
+        // Deflate and write the result to the output file.
+        int ret = Z_OK;
+        while (ret == Z_OK)
+        {
+            ret = ::deflate(&m_strm, Z_FINISH);
+            size_t written = CHUNKSIZE - m_strm.avail_out;
+            m_compressedSize += written;
+            m_out.put(m_tmpbuf, written);
+            m_strm.avail_out = CHUNKSIZE;
+            m_strm.next_out = m_tmpbuf;
+        }
+        if (ret != Z_STREAM_END)
+            throw pdal_error("Couldn't close BPF compression stream.");
+        deflateEnd(&m_strm);
     }
-    if (ret != Z_STREAM_END)
-        throw pdal_error("Couldn't close BPF compression stream.");
-    deflateEnd(&m_strm);
 
     // Mark our position so that we can get back here.
     OStreamMarker blockEnd(m_out);
@@ -128,5 +266,71 @@ void BpfCompressor::finish()
     // Set the position back to the end of the block.
     blockEnd.rewind();
 }
+
+
+// Compress the raw data of the block all at once, shuffling it first if
+// requested, and write the result to the output file.
+void BpfCompressor::finishBlock()
+{
+    std::vector<char> out;
+    size_t written = 0;
+
+    if (m_shuffle)
+        shuffle(m_block.data(), m_block.size());
+    switch (m_codec)
+    {
+    case BpfCompression::Zlib:
+    {
+        m_strm.avail_in = m_block.size();
+        m_strm.next_in = (unsigned char *)m_block.data();
+        int ret = Z_OK;
+        while (ret == Z_OK)
+        {
+            m_strm.avail_out = CHUNKSIZE;
+            m_strm.next_out = m_tmpbuf;
+            ret = ::deflate(&m_strm, Z_FINISH);
+            size_t size = CHUNKSIZE - m_strm.avail_out;
+            out.insert(out.end(), m_tmpbuf, m_tmpbuf + size);
+        }
+        if (ret != Z_STREAM_END)
+            throw pdal_error("Couldn't close BPF compression stream.");
+        deflateEnd(&m_strm);
+        written = out.size();
+        break;
+    }
+#ifdef PDAL_HAVE_LZ4
+    case BpfCompression::Lz4:
+    {
+        out.resize(LZ4_compressBound((int)m_block.size()));
+        int size = m_level > 0 ?
+            LZ4_compress_HC(m_block.data(), out.data(), (int)m_block.size(),
+                (int)out.size(), m_level) :
+            LZ4_compress_default(m_block.data(), out.data(),
+                (int)m_block.size(), (int)out.size());
+        if (size <= 0 && m_block.size())
+            throw pdal_error("Couldn't compress BPF block with LZ4.");
+        written = (size_t)(std::max)(size, 0);
+        break;
+    }
+#endif
+#ifdef PDAL_HAVE_ZSTD
+    case BpfCompression::Zstd:
+    {
+        out.resize(ZSTD_compressBound(m_block.size()));
+        written = ZSTD_compress(out.data(), out.size(), m_block.data(),
+            m_block.size(), m_level);
+        if (ZSTD_isError(written))
+            throw pdal_error("Couldn't compress BPF block with Zstd.");
+        break;
+    }
+#endif
+    default:
+        throw pdal_error("BPF compression codec not supported by this "
+            "build of PDAL.");
+    }
+    m_out.put(out.data(), written);
+    m_compressedSize = written;
+    m_block.clear();
+}
    
 } // namespace pdal
@@ -35,25 +35,56 @@
 #pragma once
 
 #include <ostream>
+#include <vector>
 #include <zlib.h>
 
+#include <pdal/pdal_internal.hpp>
 #include <pdal/util/Charbuf.hpp>
 #include <pdal/util/OStream.hpp>
 
+#include "BpfHeader.hpp"
+
 namespace pdal
 {
 
+// Compresses blocks of BPF point data with one of the supported codecs.
+// Data written to the output stream between startBlock() and finish() is
+// captured and written as a single compressed block preceded by its
+// raw and compressed sizes.
 class BpfCompressor
 {
 public:
-    BpfCompressor(OLeStream& out, size_t maxSize) :
+    BpfCompressor(OLeStream& out, size_t maxSize,
+            BpfCompression::Enum codec = BpfCompression::Zlib,
+            int level = defaultLevel(BpfCompression::Zlib),
+            bool shuffle = false) :
         m_out(out), m_inbuf(maxSize), m_blockStart(out), m_rawSize(0),
-        m_compressedSize(0)
+        m_compressedSize(0), m_codec(codec), m_level(level),
+        m_shuffle(shuffle)
     {}
     void startBlock();
     void finish();
     void compress();
-   
+
+    // Whether PDAL was built with support for the codec.
+    static bool supported(BpfCompression::Enum codec);
+    // The level that the codec's library uses when none is given.
+    static int defaultLevel(BpfCompression::Enum codec);
+    // Decompress a block into 'outbuf', which holds exactly the
+    // uncompressed size of the block.
+    // \return  Whether the block was decompressed.
+    static bool decompress(BpfCompression::Enum codec, const char *inbuf,
+        size_t insize, char *outbuf, size_t outsize);
+    // Whether values of the dimension are delta-encoded by the
+    // DeltaShuffle transform.
+    static bool deltaDim(Dimension::Id::Enum id);
+    // Rearrange a block of four byte values so that the first bytes of
+    // every value come first, then the second bytes and so on.  Bytes past
+    // the last whole value are left in place.
+    static void shuffle(char *buf, size_t size);
+    // Reverse shuffle().
+    static void unshuffle(char *buf, size_t size);
+
 private:
     static const int CHUNKSIZE = 1000000;
 
@@ -65,6 +96,13 @@ private:
     OStreamMarker m_blockStart;
     size_t m_rawSize;
     size_t m_compressedSize;
+    BpfCompression::Enum m_codec;
+    int m_level;
+    bool m_shuffle;
+    // Raw data of the block when it's compressed all at once.
+    std::vector<char> m_block;
+
+    void finishBlock();
 };
 
 } // namespace pdal
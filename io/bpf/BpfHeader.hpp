@@ -61,6 +61,12 @@ struct BpfMuellerMatrix
 
     double m_vals[16];
 
+    bool identity() const
+    {
+        BpfMuellerMatrix m;
+        return memcmp(m_vals, m.m_vals, sizeof(m_vals)) == 0;
+    }
+
     void apply(double& x, double& y, double& z)
     {
         double w = x * m_vals[12] + y * m_vals[13] + z * m_vals[14] +
@@ -102,8 +108,17 @@ enum Enum
     None,
     QuickLZ,
     FastLZ,
-    Zlib
+    Zlib,
+    // Not part of the BPF specification.  Written by PDAL for scratch files.
+    Lz4,
+    Zstd
 };
+
+// Set in the compression byte along with the codec when the values of X,
+// Y, Z and GpsTime are delta-encoded and the bytes of each block are
+// shuffled into planes before compression.  Not part of the BPF
+// specification.
+const uint8_t DeltaShuffle = 0x80;
 }
 
 struct BpfDimension
@@ -152,6 +167,13 @@ struct BpfHeader
 
     void setLog(const LogPtr& log)
          { m_log = log; }
+    BpfCompression::Enum codec() const
+    {
+        return (BpfCompression::Enum)
+            (m_compression & ~BpfCompression::DeltaShuffle);
+    }
+    bool deltaShuffle() const
+        { return m_compression & BpfCompression::DeltaShuffle; }
     bool read(ILeStream& stream);
     bool write(OLeStream& stream);
     bool readV3(ILeStream& stream);
@@ -34,10 +34,16 @@
 
 #include "BpfReader.hpp"
 
-#include <zlib.h>
+#include <algorithm>
+#include <sstream>
+#include <string.h>
 
 #include <pdal/Options.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/pdal_export.hpp>
+#include <pdal/util/Endian.hpp>
+
+#include "BpfCompressor.hpp"
 
 namespace pdal
 {
@@ -99,6 +105,8 @@ QuickInfo BpfReader::inspect()
 // the dimensions in the PointView.
 void BpfReader::initialize()
 {
+    m_selectIds = false;
+    m_curId = 0;
     m_stream.open(m_filename);
 
     // Resets the stream position in case it was already open.
@@ -210,26 +218,74 @@ bool BpfReader::readPolarData()
 }
 
 
-void BpfReader::ready(PointTableRef)
+// Only uncompressed point-major records can be found by seeking.
+bool BpfReader::setPointIds(const std::vector<PointId>& ids)
+{
+    if (m_header.m_compression ||
+        m_header.m_pointFormat != BpfFormat::PointMajor || m_selectIds ||
+        m_count != (std::numeric_limits<point_count_t>::max)())
+        return false;
+    m_selectIds = true;
+    m_pointIds.clear();
+    for (PointId id : ids)
+        if (id < numPoints())
+            m_pointIds.push_back(id);
+    // Points are read in file order, so the reader only seeks forward.
+    std::sort(m_pointIds.begin(), m_pointIds.end());
+    m_pointIds.erase(std::unique(m_pointIds.begin(), m_pointIds.end()),
+        m_pointIds.end());
+    return true;
+}
+
+
+void BpfReader::ready(PointTableRef table)
 {
     m_index = 0;
+    m_curId = 0;
     m_start = m_stream.position();
+    m_mapTable = dynamic_cast<MappedPointTable *>(&table);
+    if (m_mapTable && !mapPoints(*m_mapTable))
+        m_mapTable = NULL;
+    if (!m_mapTable)
+        table.reserve(std::min(m_count, numPoints()));
     if (m_header.m_compression)
     {
-        m_deflateBuf.resize(numPoints() * m_dims.size() * sizeof(float));
-        size_t index = 0;
-        size_t bytesRead = 0;
-        do
+        if (!BpfCompressor::supported(m_header.codec()))
         {
-            bytesRead = readBlock(m_deflateBuf, index);
-            index += bytesRead;
-        } while (bytesRead > 0 && index < m_deflateBuf.size());
+            std::ostringstream oss;
+            oss << "Can't read BPF points compressed with codec " <<
+                (int)m_header.m_compression << ".";
+            throw pdal_error(oss.str());
+        }
+        m_deflateBuf.resize(numPoints() * m_dims.size() * sizeof(float));
+        inflateBlocks();
+        if (m_header.deltaShuffle())
+            undoDelta();
         m_charbuf.initialize(m_deflateBuf.data(), m_deflateBuf.size(), m_start);
         m_stream.pushStream(new std::istream(&m_charbuf));
     }
 }
 
 
+// Map uncompressed point-major records into the point table.  Returns
+// false if the points need to be read and decoded instead.
+bool BpfReader::mapPoints(MappedPointTable& table)
+{
+    if (m_header.m_compression ||
+        m_header.m_pointFormat != BpfFormat::PointMajor ||
+        !m_header.m_xform.identity() || table.mapped() || numPoints() == 0 ||
+        m_selectIds)
+        return false;
+
+    table.mapFile(m_filename, (uint64_t)m_start, numPoints(),
+        m_dims.size() * sizeof(float));
+    for (size_t d = 0; d < m_dims.size(); ++d)
+        table.mapDim(m_dims[d].m_id, d * sizeof(float),
+            Dimension::Type::Float, 1.0, m_dims[d].m_offset);
+    return true;
+}
+
+
 void BpfReader::done(PointTableRef)
 {
      delete m_stream.popStream();
@@ -238,6 +294,23 @@ void BpfReader::done(PointTableRef)
 
 point_count_t BpfReader::read(PointViewPtr data, point_count_t count)
 {
+    if (m_mapTable)
+    {
+        // The point data is already in the table.
+        count = std::min(count, numPoints() - m_index);
+        PointId nextId = data->size();
+        data->appendTablePoints(count);
+        if (m_cb)
+            for (PointId i = 0; i < count; ++i)
+                m_cb(*data, nextId + i);
+        m_index += count;
+        return count;
+    }
+
+    if (m_selectIds)
+        return readPointIds(data, count);
+
+    data->reserve(std::min(count, numPoints() - m_index));
     switch (m_header.m_pointFormat)
     {
     case BpfFormat::PointMajor:
@@ -253,43 +326,182 @@ point_count_t BpfReader::read(PointViewPtr data, point_count_t count)
 }
 
 
-size_t BpfReader::readBlock(std::vector<char>& outBuf, size_t index)
+/// Compressed point data is a sequence of blocks that are each compressed
+/// on their own and preceded by their raw and compressed sizes.  The
+/// blocks are read in turn and then decompressed on the thread pool, each
+/// into its place in the deflate buffer.
+void BpfReader::inflateBlocks()
 {
-    uint32_t finalBytes;
-    uint32_t compressBytes;
+    struct Block
+    {
+        std::vector<char> m_data;
+        size_t m_pos;
+        size_t m_size;
+    };
+
+    std::vector<Block> blocks;
+    size_t index = 0;
+    while (index < m_deflateBuf.size())
+    {
+        uint32_t finalBytes;
+        uint32_t compressBytes;
+
+        m_stream >> finalBytes;
+        m_stream >> compressBytes;
+        if (!m_stream || finalBytes == 0 ||
+            finalBytes > m_deflateBuf.size() - index)
+            break;
+
+        Block block;
+        block.m_pos = index;
+        block.m_size = finalBytes;
+        block.m_data.resize(compressBytes);
+        m_stream.get(block.m_data);
+        if (!m_stream)
+            break;
+        blocks.push_back(std::move(block));
+        index += finalBytes;
+    }
 
-    m_stream >> finalBytes;
-    m_stream >> compressBytes;
+    // As when a block is missing, points of a block that can't be
+    // decompressed are left zero.
+    const BpfCompression::Enum codec = m_header.codec();
+    // Byte-major blocks are single byte planes, which aren't shuffled.
+    const bool shuffled = m_header.deltaShuffle() &&
+        m_header.m_pointFormat != BpfFormat::ByteMajor;
+    std::vector<char> failed(blocks.size());
+    ThreadPool::shared().parallelFor(blocks.size(), 1,
+        [this, codec, shuffled, &blocks, &failed](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            Block& b = blocks[i];
+            char *out = m_deflateBuf.data() + b.m_pos;
+            failed[i] = !BpfCompressor::decompress(codec, b.m_data.data(),
+                b.m_data.size(), out, b.m_size);
+            if (shuffled && !failed[i])
+                BpfCompressor::unshuffle(out, b.m_size);
+        }
+    });
+    for (size_t i = 0; i < blocks.size(); ++i)
+        if (failed[i])
+        {
+            std::fill(m_deflateBuf.begin() + blocks[i].m_pos,
+                m_deflateBuf.begin() + blocks[i].m_pos + blocks[i].m_size, 0);
+            log()->get(LogLevel::Warning) << "Couldn't decompress block " <<
+                i << " of compressed BPF points." << std::endl;
+        }
+}
 
-    std::vector<char> in(compressBytes);
 
-    // Fill the input bytes from the stream.
-    m_stream.get(in);
-    int ret = inflate(in.data(), compressBytes,
-        outBuf.data() + index, finalBytes);
-    return (ret ? 0 : finalBytes);
+/// Restore the values of delta-encoded dimensions in the deflate buffer by
+/// summing the differences through each dimension in file order.
+void BpfReader::undoDelta()
+{
+    const size_t numDims = m_dims.size();
+    const size_t count = numPoints();
+    char *buf = m_deflateBuf.data();
+
+    auto get = [buf](size_t pos)
+    {
+        uint32_t u;
+        memcpy(&u, buf + pos, sizeof(u));
+        return le32toh(u);
+    };
+    auto put = [buf](size_t pos, uint32_t u)
+    {
+        u = htole32(u);
+        memcpy(buf + pos, &u, sizeof(u));
+    };
+
+    for (size_t d = 0; d < numDims; ++d)
+    {
+        if (!BpfCompressor::deltaDim(m_dims[d].m_id))
+            continue;
+
+        uint32_t prev = 0;
+        switch (m_header.m_pointFormat)
+        {
+        case BpfFormat::PointMajor:
+            for (size_t i = 0; i < count; ++i)
+            {
+                size_t pos = (i * numDims + d) * sizeof(uint32_t);
+                prev += get(pos);
+                put(pos, prev);
+            }
+            break;
+        case BpfFormat::DimMajor:
+            for (size_t i = 0; i < count; ++i)
+            {
+                size_t pos = (d * count + i) * sizeof(uint32_t);
+                prev += get(pos);
+                put(pos, prev);
+            }
+            break;
+        case BpfFormat::ByteMajor:
+        {
+            // The bytes of each value are spread across four planes.
+            unsigned char *plane =
+                (unsigned char *)buf + d * count * sizeof(uint32_t);
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint32_t u = 0;
+                for (size_t b = 0; b < sizeof(uint32_t); ++b)
+                    u |= (uint32_t)plane[b * count + i] << (b * CHAR_BIT);
+                prev += u;
+                for (size_t b = 0; b < sizeof(uint32_t); ++b)
+                    plane[b * count + i] = (unsigned char)(prev >>
+                        (b * CHAR_BIT));
+            }
+            break;
+        }
+        }
+    }
 }
 
 
 bool BpfReader::eof()
 {
+    if (m_selectIds)
+        return m_curId >= m_pointIds.size();
     return m_index >= numPoints();
 }
 
 
+// Read the next of the points set with setPointIds(), seeking to each.
+point_count_t BpfReader::readPointIds(PointViewPtr data, point_count_t count)
+{
+    point_count_t numRead = 0;
+    while (numRead < count && m_curId < m_pointIds.size())
+    {
+        m_index = m_pointIds[m_curId++];
+        numRead += readPointMajor(data, 1);
+    }
+    return numRead;
+}
+
+
 point_count_t BpfReader::readPointMajor(PointViewPtr data, point_count_t count)
 {
     PointId nextId = data->size();
     PointId idx = m_index;
     point_count_t numRead = 0;
     seekPointMajor(idx);
+
+    // Read the records through a window sized to the points wanted so that
+    // a single point read doesn't pull in a full window.
+    const size_t pointSize = m_dims.size() * sizeof(float);
+    const size_t wanted = idx < numPoints() ?
+        std::min(count, numPoints() - idx) * pointSize : 0;
+    BufferedILeStream in(m_stream.stream(),
+        std::min<size_t>(wanted, BufferedILeStream::DefaultWindow * 16));
     while (numRead < count && idx < numPoints())
     {
         for (size_t d = 0; d < m_dims.size(); ++d)
         {
             float f;
 
-            m_stream >> f;
+            in >> f;
             data->setField(m_dims[d].m_id, nextId, f + m_dims[d].m_offset);
         }
 
@@ -315,35 +527,39 @@ point_count_t BpfReader::readPointMajor(PointViewPtr data, point_count_t count)
 
 point_count_t BpfReader::readDimMajor(PointViewPtr data, point_count_t count)
 {
-    PointId idx(0);
     PointId startId = data->size();
-    point_count_t numRead = 0;
+    point_count_t numRead = m_index < numPoints() ?
+        std::min(count, numPoints() - m_index) : 0;
+
+    // The values of each dimension are stored together, so they're read
+    // a column at a time and set in one call.
+    std::vector<char> buf(numRead * sizeof(float));
+    std::vector<double> column(numRead);
     for (size_t d = 0; d < m_dims.size(); ++d)
     {
-        idx = m_index;
-        PointId nextId = startId;
-        numRead = 0;
-        seekDimMajor(d, idx);
-        for (; numRead < count && idx < numPoints(); idx++, numRead++, nextId++)
-        {
-            float f;
-
-            m_stream >> f;
-            data->setField(m_dims[d].m_id, nextId, f + m_dims[d].m_offset);
-        }
+        seekDimMajor(d, m_index);
+        m_stream.get(buf);
+        Endian::fromLittle<float>(buf.data(), numRead, column.data());
+        for (point_count_t i = 0; i < numRead; ++i)
+            column[i] += m_dims[d].m_offset;
+        data->setFieldArray(m_dims[d].m_id, startId, numRead, column.data());
     }
-    m_index = idx;
+    m_index += numRead;
 
     // Transformation only applies to X, Y and Z
+    const bool xform = !m_header.m_xform.identity();
     for (PointId idx = startId; idx < data->size(); idx++)
     {
-        double x = data->getFieldAs<double>(Dimension::Id::X, idx);
-        double y = data->getFieldAs<double>(Dimension::Id::Y, idx);
-        double z = data->getFieldAs<double>(Dimension::Id::Z, idx);
-        m_header.m_xform.apply(x, y, z);
-        data->setField(Dimension::Id::X, idx, x);
-        data->setField(Dimension::Id::Y, idx, y);
-        data->setField(Dimension::Id::Z, idx, z);
+        if (xform)
+        {
+            double x = data->getFieldAs<double>(Dimension::Id::X, idx);
+            double y = data->getFieldAs<double>(Dimension::Id::Y, idx);
+            double z = data->getFieldAs<double>(Dimension::Id::Z, idx);
+            m_header.m_xform.apply(x, y, z);
+            data->setField(Dimension::Id::X, idx, x);
+            data->setField(Dimension::Id::Y, idx, y);
+            data->setField(Dimension::Id::Z, idx, z);
+        }
 
         if (m_cb)
             m_cb(*data, idx);
@@ -375,6 +591,7 @@ point_count_t BpfReader::readByteMajor(PointViewPtr data, point_count_t count)
             numRead = 0;
             PointId nextId = startId;
             seekByteMajor(d, b, idx);
+            BufferedILeStream in(m_stream.stream());
 
             for (;numRead < count && idx < numPoints();
                 idx++, numRead++, nextId++)
@@ -384,7 +601,7 @@ point_count_t BpfReader::readByteMajor(PointViewPtr data, point_count_t count)
                 if (b == 0)
                     u.u32 = 0;
                 uint8_t u8;
-                m_stream >> u8;
+                in >> u8;
                 u.u32 |= ((uint32_t)u8 << (b * CHAR_BIT));
                 if (b == 3)
                 {
@@ -439,32 +656,4 @@ void BpfReader::seekByteMajor(size_t dimIdx, size_t byteIdx, PointId ptIdx)
     m_stream.seek(m_start + offset);
 }
 
-
-int BpfReader::inflate(char *buf, size_t insize, char *outbuf, size_t outsize)
-{
-   if (insize == 0)
-        return 0;
-
-    int ret;
-    z_stream strm;
-
-    /* allocate inflate state */
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    strm.avail_in = 0;
-    strm.next_in = Z_NULL;
-    if (inflateInit(&strm) != Z_OK)
-        return -2;
-
-    strm.avail_in = insize;
-    strm.next_in = (unsigned char *)buf;
-    strm.avail_out = outsize;
-    strm.next_out = (unsigned char *)outbuf;
-
-    ret = ::inflate(&strm, Z_NO_FLUSH);
-    (void)inflateEnd(&strm);
-    return ret == Z_STREAM_END ? 0 : -1;
-}
-
 } //namespace pdal
@@ -57,9 +57,12 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
 
     virtual point_count_t numPoints() const
         {  return (point_count_t)m_header.m_numPts; }
+    virtual bool setPointIds(const std::vector<PointId>& ids);
 private:
     ILeStream m_stream;
     BpfHeader m_header;
@@ -77,12 +80,20 @@ private:
     std::vector<char> m_deflateBuf;
     /// Streambuf for deflated data.
     Charbuf m_charbuf;
+    /// Table into which point records are mapped, if any.
+    MappedPointTable *m_mapTable;
+    /// Whether only the points m_pointIds are read.
+    bool m_selectIds;
+    std::vector<PointId> m_pointIds;
+    /// Index in m_pointIds of the next point to read.
+    size_t m_curId;
 
     virtual void processOptions(const Options& options);
     virtual QuickInfo inspect();
     virtual void initialize();
     virtual void addDimensions(PointLayoutPtr Layout);
     virtual void ready(PointTableRef table);
+    bool mapPoints(MappedPointTable& table);
     virtual point_count_t read(PointViewPtr data, point_count_t num);
     virtual void done(PointTableRef table);
     virtual bool eof();
@@ -92,11 +103,11 @@ private:
     bool readHeaderExtraData();
     bool readPolarData();
     point_count_t readPointMajor(PointViewPtr data, point_count_t count);
+    point_count_t readPointIds(PointViewPtr data, point_count_t count);
     point_count_t readDimMajor(PointViewPtr data, point_count_t count);
     point_count_t readByteMajor(PointViewPtr data, point_count_t count);
-    size_t readBlock(std::vector<char>& outBuf, size_t index);
-
-    int inflate(char *inbuf, size_t insize, char *outbuf, size_t outsize);
+    void inflateBlocks();
+    void undoDelta();
 
     void seekPointMajor(PointId ptIdx);
     void seekDimMajor(size_t dimIdx, PointId ptIdx);
@@ -60,11 +60,16 @@ Options BpfWriter::getDefaultOptions()
     Options ops;
 
     ops.add("filename", "", "Filename for BPF output");
-    ops.add("compression", false, "Whether zlib compression should be used");
+    ops.add("compression", false, "Compression codec: \"false\", "
+        "\"true\" or \"zlib\", \"lz4\" or \"zstd\"");
+    ops.add("compression_level", "", "Level of compression for the codec.  "
+        "The codec's default is used if not given.");
     ops.add("format", "dimension", "Point output format: "
         "non-interleaved(\"dimension\"), interleaved(\"point\") or "
         "byte-segregated(\"byte\")");
     ops.add("coord_id", 0, "Coordinate ID (UTM zone).");
+    ops.add("delta_shuffle", false, "Delta-encode X, Y, Z and GpsTime and "
+        "shuffle the bytes of values into planes before compression.");
     return ops;
 }
 
@@ -73,9 +78,34 @@ void BpfWriter::processOptions(const Options& options)
 {
     if (m_filename.empty())
         throw pdal_error("Can't write BPF file without filename.");
-    bool compression = options.getValueOrDefault("compression", false);
-    m_header.m_compression = compression ? BpfCompression::Zlib :
-        BpfCompression::None;
+    std::string compression =
+        options.getValueOrDefault<std::string>("compression", "false");
+    std::transform(compression.begin(), compression.end(),
+        compression.begin(), ::toupper);
+    BpfCompression::Enum codec;
+    if (compression == "FALSE" || compression == "NONE")
+        codec = BpfCompression::None;
+    else if (compression == "TRUE" || compression == "ZLIB")
+        codec = BpfCompression::Zlib;
+    else if (compression == "LZ4")
+        codec = BpfCompression::Lz4;
+    else if (compression == "ZSTD")
+        codec = BpfCompression::Zstd;
+    else
+        throw pdal_error("Invalid BPF compression '" + compression + "'.");
+    if (codec != BpfCompression::None && !BpfCompressor::supported(codec))
+        throw pdal_error("Can't write BPF with " + compression +
+            " compression.  PDAL not built with it.");
+    m_header.m_compression = codec;
+    m_compressionLevel = BpfCompressor::defaultLevel(codec);
+    if (options.hasOption("compression_level"))
+        m_compressionLevel = options.getValueOrThrow<int>("compression_level");
+    if (options.getValueOrDefault("delta_shuffle", false))
+    {
+        if (codec == BpfCompression::None)
+            throw pdal_error("Option 'delta_shuffle' requires compression.");
+        m_header.m_compression |= BpfCompression::DeltaShuffle;
+    }
 
     std::string fileFormat =
         options.getValueOrDefault<std::string>("format", "POINT");
@@ -103,6 +133,7 @@ void BpfWriter::processOptions(const Options& options)
 void BpfWriter::ready(PointTableRef table)
 {
     loadBpfDimensions(table.layout());
+    m_deltaPrev.assign(m_dims.size(), 0);
     m_stream = FileUtils::createFile(m_filename, true);
     m_header.m_version = 3;
     m_header.m_numDim = m_dims.size();
@@ -179,20 +210,24 @@ void BpfWriter::writePointMajor(const PointView* data)
     // For compression we're going to write to a buffer so that it can be
     // compressed before it's written to the file stream.
     BpfCompressor compressor(m_stream,
-        blockpoints * sizeof(float) * m_dims.size());
+        blockpoints * sizeof(float) * m_dims.size(), codec(),
+        m_compressionLevel, m_header.deltaShuffle());
     PointId idx = 0;
     while (idx < data->size())
     {
         if (m_header.m_compression)
             compressor.startBlock();
-        size_t blockId;
-        for (blockId = 0; idx < data->size() && blockId < blockpoints;
-            ++idx, ++blockId)
+        // The output buffer is flushed at the end of the block, before
+        // the block is compressed.
         {
-            for (auto & bpfDim : m_dims)
+            BufferedOLeStream out(m_stream.stream());
+            size_t blockId;
+            for (blockId = 0; idx < data->size() && blockId < blockpoints;
+                ++idx, ++blockId)
             {
-                double d = getAdjustedValue(data, bpfDim, idx);
-                m_stream << (float)d;
+                for (size_t d = 0; d < m_dims.size(); ++d)
+                    out << encodeValue(d,
+                        (float)getAdjustedValue(data, m_dims[d], idx));
             }
         }
         if (m_header.m_compression)
@@ -207,17 +242,20 @@ void BpfWriter::writePointMajor(const PointView* data)
 void BpfWriter::writeDimMajor(const PointView* data)
 {
     // We're going to pretend for now that we only even have one point buffer.
-    BpfCompressor compressor(m_stream, data->size() * sizeof(float));
+    // Each dimension is compressed as a block of its own.
+    BpfCompressor compressor(m_stream, data->size() * sizeof(float), codec(),
+        m_compressionLevel, m_header.deltaShuffle());
 
-    for (auto & bpfDim : m_dims)
+    for (size_t d = 0; d < m_dims.size(); ++d)
     {
 
         if (m_header.m_compression)
             compressor.startBlock();
-        for (PointId idx = 0; idx < data->size(); ++idx)
         {
-            double d = getAdjustedValue(data, bpfDim, idx);
-            m_stream << (float)d;
+            BufferedOLeStream out(m_stream.stream());
+            for (PointId idx = 0; idx < data->size(); ++idx)
+                out << encodeValue(d,
+                    (float)getAdjustedValue(data, m_dims[d], idx));
         }
         if (m_header.m_compression)
         {
@@ -230,36 +268,52 @@ void BpfWriter::writeDimMajor(const PointView* data)
 
 void BpfWriter::writeByteMajor(const PointView* data)
 {
-    union
-    {
-        float f;
-        uint32_t u32;
-    } uu;
-
     // We're going to pretend for now that we only even have one point buffer.
 
-    BpfCompressor compressor(m_stream,
-        data->size() * sizeof(float) * m_dims.size());
+    // Each byte plane is compressed as a block of its own so that readers
+    // can inflate the planes in parallel.  The planes are already
+    // shuffled, so the compressor doesn't shuffle them again.
+    BpfCompressor compressor(m_stream, data->size(), codec(),
+        m_compressionLevel);
 
-    if (m_header.m_compression)
-        compressor.startBlock();
-    for (auto & bpfDim : m_dims)
+    std::vector<uint32_t> values(data->size());
+    for (size_t d = 0; d < m_dims.size(); ++d)
     {
+        for (PointId idx = 0; idx < data->size(); ++idx)
+            values[idx] = encodeValue(d,
+                (float)getAdjustedValue(data, m_dims[d], idx));
         for (size_t b = 0; b < sizeof(float); b++)
         {
-            for (PointId idx = 0; idx < data->size(); ++idx)
+            if (m_header.m_compression)
+                compressor.startBlock();
+            {
+                BufferedOLeStream out(m_stream.stream());
+                for (PointId idx = 0; idx < data->size(); ++idx)
+                    out << (uint8_t)(values[idx] >> (b * CHAR_BIT));
+            }
+            if (m_header.m_compression)
             {
-                uu.f = (float)getAdjustedValue(data, bpfDim, idx);
-                uint8_t u8 = (uint8_t)(uu.u32 >> (b * CHAR_BIT));
-                m_stream << u8;
+                compressor.compress();
+                compressor.finish();
             }
         }
     }
-    if (m_header.m_compression)
-    {
-        compressor.compress();
-        compressor.finish();
-    }
+}
+
+
+/// Get the bits of a value to write.  With the DeltaShuffle transform,
+/// values of delta-encoded dimensions are stored as the difference from
+/// the bits of the dimension's previous value.
+uint32_t BpfWriter::encodeValue(size_t dimIdx, float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    if (!m_header.deltaShuffle() ||
+        !BpfCompressor::deltaDim(m_dims[dimIdx].m_id))
+        return u;
+    uint32_t delta = u - m_deltaPrev[dimIdx];
+    m_deltaPrev[dimIdx] = u;
+    return delta;
 }
 
 
@@ -61,6 +61,9 @@ private:
     OLeStream m_stream;
     BpfHeader m_header;
     BpfDimensionList m_dims;
+    int m_compressionLevel;
+    // The last value of each dimension written, for delta encoding.
+    std::vector<uint32_t> m_deltaPrev;
 
     virtual void processOptions(const Options& options);
     virtual void ready(PointTableRef table);
@@ -69,6 +72,9 @@ private:
 
     double getAdjustedValue(const PointView* data, BpfDimension& bpfDim,
         PointId idx);
+    BpfCompression::Enum codec() const
+        { return m_header.codec(); }
+    uint32_t encodeValue(size_t dimIdx, float f);
     void loadBpfDimensions(PointLayoutPtr layout);
     void writePointMajor(const PointView* data);
     void writeDimMajor(const PointView* data);
@@ -39,6 +39,8 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <ctime>
 
 namespace pdal
@@ -60,6 +62,7 @@ static Mode string2mode(const std::string& str)
     if (boost::iequals(str, "ramp")) return Ramp;
     if (boost::iequals(str, "uniform")) return Uniform;
     if (boost::iequals(str, "normal")) return Normal;
+    if (boost::iequals(str, "terrain")) return Terrain;
     throw pdal_error("invalid Mode option: " + str);
 }
 
@@ -95,6 +98,48 @@ void FauxReader::processOptions(const Options& options)
     m_numReturns = options.getValueOrDefault("number_of_returns", 0);
     if (m_numReturns > 10)
         throw pdal_error("faux: number_of_returns option must be 10 or less.");
+
+    std::string timeOrder =
+        options.getValueOrDefault<std::string>("time_order", "sorted");
+    if (boost::iequals(timeOrder, "shuffled"))
+        m_shuffleTime = true;
+    else if (boost::iequals(timeOrder, "sorted"))
+        m_shuffleTime = false;
+    else
+        throw pdal_error("faux: invalid time_order option: " + timeOrder);
+
+    m_seed = options.getValueOrDefault<uint32_t>("seed",
+        static_cast<uint32_t>(std::time(NULL)));
+    m_numViews = options.getValueOrDefault<point_count_t>("num_views", 1);
+    if (m_numViews == 0)
+        throw pdal_error("faux: num_views option must be at least 1.");
+    m_numClusters = options.getValueOrDefault<int>("clusters", 8);
+    if (m_numClusters < 1)
+        throw pdal_error("faux: clusters option must be at least 1.");
+
+    m_extraDims.clear();
+    std::string extraDims =
+        options.getValueOrDefault<std::string>("extra_dims", "");
+    for (std::string dim : Utils::split2(extraDims, ','))
+    {
+        Utils::trim(dim);
+        if (dim.empty())
+            continue;
+        std::vector<std::string> s = Utils::split(dim, '=');
+        if (s.size() != 2)
+            throw pdal_error("faux: invalid extra dimension specified: '" +
+                dim + "'.  Need <dimension>=<type>.");
+        Utils::trim(s[0]);
+        Utils::trim(s[1]);
+        ExtraDim ed;
+        ed.m_name = s[0];
+        ed.m_type = Dimension::type(s[1]);
+        ed.m_id = Dimension::Id::Unknown;
+        if (ed.m_name.empty() || ed.m_type == Dimension::Type::None)
+            throw pdal_error("faux: invalid extra dimension specified: '" +
+                dim + "'.  Need <dimension>=<type>.");
+        m_extraDims.push_back(ed);
+    }
 }
 
 Options FauxReader::getDefaultOptions()
@@ -114,6 +159,46 @@ void FauxReader::addDimensions(PointLayoutPtr layout)
         layout->registerDim(Dimension::Id::ReturnNumber);
         layout->registerDim(Dimension::Id::NumberOfReturns);
     }
+    for (ExtraDim& ed : m_extraDims)
+        ed.m_id = layout->registerOrAssignDim(ed.m_name, ed.m_type);
+}
+
+
+void FauxReader::ready(PointTableRef table)
+{
+    m_returnNum = 1;
+    m_time = 0;
+    m_generator.seed(m_seed);
+
+    // The clusters are part of the generated data, so they come from the
+    // seeded generator as well.
+    std::uniform_real_distribution<double> dx(m_minX, m_maxX);
+    std::uniform_real_distribution<double> dy(m_minY, m_maxY);
+    m_clusterX.resize(m_numClusters);
+    m_clusterY.resize(m_numClusters);
+    for (int i = 0; i < m_numClusters; ++i)
+    {
+        m_clusterX[i] = dx(m_generator);
+        m_clusterY[i] = dy(m_generator);
+    }
+}
+
+
+PointViewSet FauxReader::run(PointViewPtr view)
+{
+    PointViewSet viewSet;
+
+    // Split the points as evenly as possible among the views.
+    view->clearTemps();
+    for (point_count_t i = 0; i < m_numViews; ++i)
+    {
+        PointViewPtr v = i ? view->makeNew() : view;
+        point_count_t count = m_count / m_numViews +
+            (i < m_count % m_numViews ? 1 : 0);
+        read(v, count);
+        viewSet.insert(v);
+    }
+    return viewSet;
 }
 
 
@@ -136,10 +221,31 @@ point_count_t FauxReader::read(PointViewPtr view, point_count_t count)
     const double delY = (m_maxY - m_minY) / numDeltas;
     const double delZ = (m_maxZ - m_minZ) / numDeltas;
 
-    log()->get(LogLevel::Debug5) << "Reading a point view of " <<
+    PDAL_LOG(log(), LogLevel::Debug5) << "Reading a point view of " <<
         count << " points." << std::endl;
 
-    uint32_t seed = static_cast<uint32_t>(std::time(NULL));
+    std::uniform_real_distribution<double> uniformX(m_minX, m_maxX);
+    std::uniform_real_distribution<double> uniformY(m_minY, m_maxY);
+    std::uniform_real_distribution<double> uniformZ(m_minZ, m_maxZ);
+    std::normal_distribution<double> normalX(m_mean_x, m_stdev_x);
+    std::normal_distribution<double> normalY(m_mean_y, m_stdev_y);
+    std::normal_distribution<double> normalZ(m_mean_z, m_stdev_z);
+
+    // Terrain clusters spread over a twentieth of the extent, with the
+    // surface's noise a fiftieth of the Z range.
+    std::uniform_int_distribution<int> cluster(0, m_numClusters - 1);
+    std::normal_distribution<double> spreadX(0, (m_maxX - m_minX) / 20);
+    std::normal_distribution<double> spreadY(0, (m_maxY - m_minY) / 20);
+    std::normal_distribution<double> noise(0, 0.02);
+
+    std::vector<uint64_t> times;
+    if (m_shuffleTime)
+    {
+        times.resize(count);
+        for (PointId idx = 0; idx < count; ++idx)
+            times[idx] = m_time + idx;
+        std::shuffle(times.begin(), times.end(), m_generator);
+    }
 
     for (PointId idx = 0; idx < count; ++idx)
     {
@@ -148,11 +254,6 @@ point_count_t FauxReader::read(PointViewPtr view, point_count_t count)
         double z;
         switch (m_mode)
         {
-            case Random:
-                x = Utils::random(m_minX, m_maxX);
-                y = Utils::random(m_minY, m_maxY);
-                z = Utils::random(m_minZ, m_maxZ);
-                break;
             case Constant:
                 x = m_minX;
                 y = m_minY;
@@ -163,16 +264,39 @@ point_count_t FauxReader::read(PointViewPtr view, point_count_t count)
                 y = m_minY + delY * idx;
                 z = m_minZ + delZ * idx;
                 break;
+            case Random:
             case Uniform:
-                x = Utils::uniform(m_minX, m_maxX, seed++);
-                y = Utils::uniform(m_minY, m_maxY, seed++);
-                z = Utils::uniform(m_minZ, m_maxZ, seed++);
+                x = uniformX(m_generator);
+                y = uniformY(m_generator);
+                z = uniformZ(m_generator);
                 break;
             case Normal:
-                x = Utils::normal(m_mean_x, m_stdev_x, seed++);
-                y = Utils::normal(m_mean_y, m_stdev_y, seed++);
-                z = Utils::normal(m_mean_z, m_stdev_z, seed++);
+                x = normalX(m_generator);
+                y = normalY(m_generator);
+                z = normalZ(m_generator);
                 break;
+            case Terrain:
+            {
+                int c = cluster(m_generator);
+                x = m_clusterX[c] + spreadX(m_generator);
+                y = m_clusterY[c] + spreadY(m_generator);
+                x = (std::min)((std::max)(x, m_minX), m_maxX);
+                y = (std::min)((std::max)(y, m_minY), m_maxY);
+
+                // Rolling hills across the extent.
+                const double u = (m_maxX > m_minX) ?
+                    (x - m_minX) / (m_maxX - m_minX) : 0;
+                const double v = (m_maxY > m_minY) ?
+                    (y - m_minY) / (m_maxY - m_minY) : 0;
+                double h = 0.5 +
+                    0.25 * std::sin(2 * M_PI * 1.5 * u) *
+                        std::cos(2 * M_PI * 1.2 * v) +
+                    0.15 * std::sin(2 * M_PI * (4 * u + 3 * v)) +
+                    noise(m_generator);
+                h = (std::min)((std::max)(h, 0.0), 1.0);
+                z = m_minZ + h * (m_maxZ - m_minZ);
+                break;
+            }
             default:
                 throw pdal_error("invalid mode in FauxReader");
                 break;
@@ -181,18 +305,61 @@ point_count_t FauxReader::read(PointViewPtr view, point_count_t count)
         view->setField(Dimension::Id::X, idx, x);
         view->setField(Dimension::Id::Y, idx, y);
         view->setField(Dimension::Id::Z, idx, z);
-        view->setField(Dimension::Id::OffsetTime, idx, m_time++);
+        view->setField(Dimension::Id::OffsetTime, idx,
+            m_shuffleTime ? times[idx] : m_time + idx);
         if (m_numReturns > 0)
         {
             view->setField(Dimension::Id::ReturnNumber, idx, m_returnNum);
             view->setField(Dimension::Id::NumberOfReturns, idx, m_numReturns);
             m_returnNum = (m_returnNum % m_numReturns) + 1;
         }
+        setExtraDims(*view, idx);
 
         if (m_cb)
             m_cb(*view, idx);
     }
+    m_time += count;
     return count;
 }
 
+
+// Set the extra dimensions to values spread over the range of their types,
+// or over [0, 1) for floating-point dimensions.
+void FauxReader::setExtraDims(PointView& view, PointId idx)
+{
+    using namespace Dimension;
+
+    for (const ExtraDim& ed : m_extraDims)
+    {
+        switch (ed.m_type)
+        {
+        case Type::Float:
+        case Type::Double:
+            view.setField(ed.m_id, idx,
+                std::generate_canonical<double, 53>(m_generator));
+            break;
+        case Type::Signed8:
+        case Type::Signed16:
+        case Type::Signed32:
+        case Type::Signed64:
+        {
+            // Take the low bytes of a random 64-bit value, sign extended.
+            const int bits = (int)Dimension::size(ed.m_type) * 8;
+            uint64_t r = (uint64_t)m_generator() << 32 | m_generator();
+            int64_t v = (int64_t)(r << (64 - bits)) >> (64 - bits);
+            view.setField(ed.m_id, idx, v);
+            break;
+        }
+        default:
+        {
+            const int bits = (int)Dimension::size(ed.m_type) * 8;
+            uint64_t r = (uint64_t)m_generator() << 32 | m_generator();
+            uint64_t v = (bits == 64) ? r : r >> (64 - bits);
+            view.setField(ed.m_id, idx, v);
+            break;
+        }
+        }
+    }
+}
+
 } // namespace pdal
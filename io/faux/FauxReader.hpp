@@ -36,6 +36,8 @@
 
 #include <pdal/Reader.hpp>
 
+#include <random>
+
 extern "C" int32_t FauxReader_ExitFunc();
 extern "C" PF_ExitFunc FauxReader_InitPlugin();
 
@@ -48,7 +50,8 @@ enum Mode
     Random,
     Ramp,
     Uniform,
-    Normal
+    Normal,
+    Terrain
 };
 
 
@@ -73,13 +76,21 @@ enum Mode
 //     given bounding box
 //   - "normal" generates points that are normally distributed with a given
 //     mean and standard deviation in each of the XYZ dimensions
-// In all these modes, however, the Time field is always set to the point
-// number.
+//   - "terrain" generates points in clusters within the XY extent of the
+//     bounding box, with Z following a smooth surface plus some noise
+// In all these modes, however, the Time field is set to the point number,
+// in order unless "time_order" is "shuffled", in which case the times of
+// the points of each block read are shuffled.
 //
 // ReturnNumber and NumberOfReturns are not included by default, but can be
 // activated by passing a numeric value as "number_of_returns" to the
 // reader constructor.
 //
+// Additional dimensions with random values can be added with "extra_dims",
+// a list of name=type pairs, and the points can be split among
+// "num_views" views.  Given a "seed", the same points are generated each
+// time the reader is run.
+//
 class PDAL_DLL FauxReader : public Reader
 {
 public:
@@ -91,6 +102,10 @@ public:
 
     static Dimension::IdList getDefaultDimensions();
     Options getDefaultOptions();
+    // Ramps are spread over the points of each read, so they can't be
+    // generated a chunk at a time.
+    virtual bool streamable() const
+        { return m_numViews == 1 && m_mode != Ramp; }
 
 private:
     Mode m_mode;
@@ -109,15 +124,29 @@ private:
     uint64_t m_time;
     int m_numReturns;
     int m_returnNum;
+    bool m_shuffleTime;
+    uint32_t m_seed;
+    std::mt19937 m_generator;
+    point_count_t m_numViews;
+    int m_numClusters;
+    // Centers of the clusters of points in terrain mode.
+    std::vector<double> m_clusterX;
+    std::vector<double> m_clusterY;
+
+    struct ExtraDim
+    {
+        std::string m_name;
+        Dimension::Type::Enum m_type;
+        Dimension::Id::Enum m_id;
+    };
+    std::vector<ExtraDim> m_extraDims;
 
     virtual void processOptions(const Options& options);
     virtual void addDimensions(PointLayoutPtr layout);
-    virtual void ready(PointTableRef table)
-    {
-        m_returnNum = 1;
-        m_time = 0;
-    }
+    virtual void ready(PointTableRef table);
+    virtual PointViewSet run(PointViewPtr view);
     virtual point_count_t read(PointViewPtr view, point_count_t count);
+    void setExtraDims(PointView& view, PointId idx);
     virtual bool eof()
         { return false; }
 
@@ -0,0 +1,249 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "GDALGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace pdal
+{
+
+GDALGrid::GDALGrid(double originX, double originY, double resolution,
+        double radius, double power, int stats) :
+    m_originX(originX), m_originY(originY), m_resolution(resolution),
+    m_radius(radius), m_power(power), m_stats(stats), m_col0(0), m_row0(0),
+    m_width(0), m_height(0)
+{
+    // Mean is needed to update the sum of squared deviations.
+    if (m_stats & statStdDev)
+        m_stats |= statMean;
+    m_stats |= statCount;
+}
+
+
+bool GDALGrid::cellsFor(double minx, double miny, double maxx, double maxy,
+    int& col0, int& row0, int& col1, int& row1) const
+{
+    // Cells whose square contains some point of the rectangle.
+    if (m_radius == 0)
+    {
+        col0 = (int)std::floor((minx - m_originX) / m_resolution + .5);
+        col1 = (int)std::floor((maxx - m_originX) / m_resolution + .5);
+        row0 = (int)std::floor((miny - m_originY) / m_resolution + .5);
+        row1 = (int)std::floor((maxy - m_originY) / m_resolution + .5);
+        return true;
+    }
+    col0 = (int)std::ceil((minx - m_radius - m_originX) / m_resolution);
+    col1 = (int)std::floor((maxx + m_radius - m_originX) / m_resolution);
+    row0 = (int)std::ceil((miny - m_radius - m_originY) / m_resolution);
+    row1 = (int)std::floor((maxy + m_radius - m_originY) / m_resolution);
+    return col0 <= col1 && row0 <= row1;
+}
+
+
+// Copy the cells of 'v' to a vector for a grid of 'width' columns and
+// 'cells' cells in which the current first cell is at 'start'.
+template<typename T>
+void GDALGrid::regrid(std::vector<T>& v, T init, size_t cells, size_t start,
+    size_t width) const
+{
+    std::vector<T> n(cells, init);
+    for (size_t j = 0; j < m_height; ++j)
+        std::copy(v.begin() + j * m_width, v.begin() + (j + 1) * m_width,
+            n.begin() + start + j * width);
+    v.swap(n);
+}
+
+
+void GDALGrid::grow(int col0, int row0, int col1, int row1)
+{
+    if (m_width && m_height)
+    {
+        col0 = (std::min)(col0, m_col0);
+        row0 = (std::min)(row0, m_row0);
+        col1 = (std::max)(col1, m_col0 + (int)m_width - 1);
+        row1 = (std::max)(row1, m_row0 + (int)m_height - 1);
+        if (col0 == m_col0 && row0 == m_row0 &&
+            col1 - col0 + 1 == (int)m_width &&
+            row1 - row0 + 1 == (int)m_height)
+            return;
+    }
+
+    const size_t width = col1 - col0 + 1;
+    const size_t height = row1 - row0 + 1;
+    const size_t cells = width * height;
+    // Cell of the new grid that holds the first cell of the old one.
+    const size_t start = m_width ?
+        (m_row0 - row0) * width + (m_col0 - col0) : 0;
+    const double huge = (std::numeric_limits<double>::max)();
+
+    regrid(m_count, (uint64_t)0, cells, start, width);
+    if (m_stats & statMin)
+        regrid(m_min, huge, cells, start, width);
+    if (m_stats & statMax)
+        regrid(m_max, -huge, cells, start, width);
+    if (m_stats & statMean)
+        regrid(m_mean, 0.0, cells, start, width);
+    if (m_stats & statStdDev)
+        regrid(m_m2, 0.0, cells, start, width);
+    if (m_stats & statIdw)
+    {
+        regrid(m_idwSum, 0.0, cells, start, width);
+        regrid(m_idwWeight, 0.0, cells, start, width);
+    }
+
+    m_col0 = col0;
+    m_row0 = row0;
+    m_width = width;
+    m_height = height;
+}
+
+
+void GDALGrid::addPoint(double x, double y, double z)
+{
+    int col0, row0, col1, row1;
+    if (!cellsFor(x, y, x, y, col0, row0, col1, row1))
+        return;
+
+    col0 = (std::max)(col0, m_col0);
+    row0 = (std::max)(row0, m_row0);
+    col1 = (std::min)(col1, m_col0 + (int)m_width - 1);
+    row1 = (std::min)(row1, m_row0 + (int)m_height - 1);
+
+    for (int row = row0; row <= row1; ++row)
+    {
+        const double dy = y - cellY(row);
+        size_t cell = (row - m_row0) * m_width + (col0 - m_col0);
+        for (int col = col0; col <= col1; ++col, ++cell)
+        {
+            const double dx = x - cellX(col);
+            const double dist = std::sqrt(dx * dx + dy * dy);
+            if (dist <= m_radius || m_radius == 0)
+                update(cell, z, dist);
+        }
+    }
+}
+
+
+void GDALGrid::update(size_t cell, double z, double dist)
+{
+    const uint64_t count = ++m_count[cell];
+    if (m_stats & statMin)
+        m_min[cell] = (std::min)(m_min[cell], z);
+    if (m_stats & statMax)
+        m_max[cell] = (std::max)(m_max[cell], z);
+    if (m_stats & statMean)
+    {
+        const double delta = z - m_mean[cell];
+        m_mean[cell] += delta / count;
+        if (m_stats & statStdDev)
+            m_m2[cell] += delta * (z - m_mean[cell]);
+    }
+    if (m_stats & statIdw)
+    {
+        // A point at a cell center would have infinite weight, so
+        // distances are held to a tiny fraction of the cell size.
+        dist = (std::max)(dist, m_resolution * 1e-6);
+        const double weight = 1.0 / std::pow(dist, m_power);
+        m_idwSum[cell] += z * weight;
+        m_idwWeight[cell] += weight;
+    }
+}
+
+
+void GDALGrid::merge(const GDALGrid& other)
+{
+    if (other.m_col0 != m_col0 || other.m_row0 != m_row0 ||
+        other.m_width != m_width || other.m_height != m_height ||
+        other.m_stats != m_stats)
+        throw pdal_error("Can't merge grids of different extents.");
+
+    for (size_t cell = 0; cell < m_count.size(); ++cell)
+    {
+        const uint64_t n2 = other.m_count[cell];
+        if (n2 == 0)
+            continue;
+        const uint64_t n1 = m_count[cell];
+        const uint64_t n = n1 + n2;
+        m_count[cell] = n;
+        if (m_stats & statMin)
+            m_min[cell] = (std::min)(m_min[cell], other.m_min[cell]);
+        if (m_stats & statMax)
+            m_max[cell] = (std::max)(m_max[cell], other.m_max[cell]);
+        if (m_stats & statMean)
+        {
+            const double delta = other.m_mean[cell] - m_mean[cell];
+            m_mean[cell] += delta * n2 / n;
+            if (m_stats & statStdDev)
+                m_m2[cell] += other.m_m2[cell] +
+                    delta * delta * ((double)n1 * n2 / n);
+        }
+        if (m_stats & statIdw)
+        {
+            m_idwSum[cell] += other.m_idwSum[cell];
+            m_idwWeight[cell] += other.m_idwWeight[cell];
+        }
+    }
+}
+
+
+double GDALGrid::value(int stat, size_t i, size_t j, double noData) const
+{
+    const size_t cell = j * m_width + i;
+    const uint64_t count = m_count[cell];
+    if (count == 0)
+        return noData;
+
+    switch (stat)
+    {
+    case statCount:
+        return (double)count;
+    case statMin:
+        return m_min[cell];
+    case statMax:
+        return m_max[cell];
+    case statMean:
+        return m_mean[cell];
+    case statIdw:
+        return m_idwSum[cell] / m_idwWeight[cell];
+    case statStdDev:
+        return std::sqrt(m_m2[cell] / count);
+    default:
+        throw pdal_error("Invalid grid statistic.");
+    }
+}
+
+} // namespace pdal
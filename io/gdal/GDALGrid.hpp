@@ -0,0 +1,143 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+
+#include <vector>
+
+namespace pdal
+{
+
+// Cells of a raster that accumulate statistics of the points near their
+// centers.  Cell centers lie on a lattice of spacing 'resolution' with a
+// cell centered on the origin, and a grid covers a rectangle of lattice
+// cells that can be grown as points arrive.  Grids with the same lattice
+// and extent can be merged, so points can be added to separate grids on
+// separate threads.
+class PDAL_DLL GDALGrid
+{
+public:
+    enum
+    {
+        statCount = 1,
+        statMin = 2,
+        statMax = 4,
+        statMean = 8,
+        statIdw = 16,
+        statStdDev = 32,
+        statAll = 63
+    };
+
+    // \param originX - X of the center of lattice cell (0, 0).
+    // \param originY - Y of the center of lattice cell (0, 0).
+    // \param resolution - Distance between cell centers.
+    // \param radius - A point contributes to every cell whose center is
+    //   no farther than this from the point.  With 0, a point contributes
+    //   only to the cell that contains it.
+    // \param power - Power of the distance used to weight points for IDW.
+    // \param stats - Statistics kept, a set of the stat flags.
+    GDALGrid(double originX, double originY, double resolution,
+        double radius, double power, int stats);
+
+    // Lattice column of the first column of the grid.
+    int col0() const
+        { return m_col0; }
+    // Lattice row of the first row of the grid.  Rows increase with Y.
+    int row0() const
+        { return m_row0; }
+    size_t width() const
+        { return m_width; }
+    size_t height() const
+        { return m_height; }
+    double resolution() const
+        { return m_resolution; }
+    double radius() const
+        { return m_radius; }
+    int stats() const
+        { return m_stats; }
+    // X and Y of the center of lattice cell (col, row).
+    double cellX(int col) const
+        { return m_originX + col * m_resolution; }
+    double cellY(int row) const
+        { return m_originY + row * m_resolution; }
+
+    // Lattice cells whose centers are no farther than the radius from
+    // some point of the rectangle.  Returns false if there are none.
+    bool cellsFor(double minx, double miny, double maxx, double maxy,
+        int& col0, int& row0, int& col1, int& row1) const;
+    // Cover the lattice cells from (col0, row0) through (col1, row1) as
+    // well as the cells already covered.  Accumulated values are kept.
+    void grow(int col0, int row0, int col1, int row1);
+    // Add a point to every cell of the grid near it.  Points near no cell
+    // of the grid are ignored.
+    void addPoint(double x, double y, double z);
+    // Add the values of a grid with the same lattice, extent and stats.
+    void merge(const GDALGrid& other);
+    // Value of a statistic of grid cell (i, j), or 'noData' if no point
+    // is near the cell.
+    double value(int stat, size_t i, size_t j, double noData) const;
+
+private:
+    double m_originX;
+    double m_originY;
+    double m_resolution;
+    double m_radius;
+    double m_power;
+    int m_stats;
+    int m_col0;
+    int m_row0;
+    size_t m_width;
+    size_t m_height;
+
+    // Statistics of each cell, row by row.  Only the vectors needed for
+    // the stats kept are allocated.  Mean and the sum of squared
+    // deviations are kept as in Welford's method so that partial grids
+    // can be merged without loss of precision.
+    std::vector<uint64_t> m_count;
+    std::vector<double> m_min;
+    std::vector<double> m_max;
+    std::vector<double> m_mean;
+    std::vector<double> m_m2;
+    std::vector<double> m_idwSum;
+    std::vector<double> m_idwWeight;
+
+    void update(size_t cell, double z, double dist);
+    template<typename T>
+    void regrid(std::vector<T>& v, T init, size_t cells, size_t start,
+        size_t width) const;
+};
+
+} // namespace pdal
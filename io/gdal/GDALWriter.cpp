@@ -0,0 +1,376 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "GDALWriter.hpp"
+
+#include <pdal/GlobalEnvironment.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <gdal.h>
+#include <cpl_conv.h>
+#include <cpl_string.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "writers.gdal",
+    "Write a raster of point statistics with GDAL.",
+    "http://pdal.io/stages/writers.gdal.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, GDALWriter, Writer, s_info)
+
+std::string GDALWriter::getName() const { return s_info.name; }
+
+namespace
+{
+
+struct StatInfo
+{
+    int m_stat;
+    const char *m_name;
+};
+
+const StatInfo s_statInfo[] =
+{
+    { GDALGrid::statMin, "min" },
+    { GDALGrid::statMax, "max" },
+    { GDALGrid::statMean, "mean" },
+    { GDALGrid::statIdw, "idw" },
+    { GDALGrid::statCount, "count" },
+    { GDALGrid::statStdDev, "stdev" }
+};
+
+} // unnamed namespace
+
+
+Options GDALWriter::getDefaultOptions()
+{
+    Options options;
+
+    options.add("filename", "", "Name of the raster file to write.");
+    options.add("resolution", 0.0, "Distance between cell centers.");
+    options.add("radius", 0.0, "Points within this distance of a cell "
+        "center are used for the cell's values.  Defaults to the "
+        "resolution times the square root of two.  With 0, each point is "
+        "used only for the cell that contains it.");
+    options.add("output_type", "all", "Statistics to write, one band "
+        "each: min, max, mean, idw, count, stdev or all.");
+    options.add("power", 1.0, "Power of the distance used to weight "
+        "points for idw.");
+    options.add("nodata", -9999.0, "Value of cells with no nearby points.");
+    options.add("gdaldriver", "GTiff", "GDAL driver used for the raster.");
+    options.add("gdalopts", "TILED=YES,COMPRESS=DEFLATE",
+        "GDAL creation options.");
+    options.add("bounds", BOX3D(), "Extent of the raster.  Defaults to "
+        "the extent of the points.");
+    return options;
+}
+
+
+void GDALWriter::processOptions(const Options& options)
+{
+    m_filename = options.getValueOrThrow<std::string>("filename");
+    m_resolution = options.getValueOrDefault<double>("resolution", 0.0);
+    if (m_resolution <= 0)
+        throw pdal_error(getName() + ": Option 'resolution' must be "
+            "greater than zero.");
+    m_radius = options.getValueOrDefault<double>("radius",
+        m_resolution * std::sqrt(2.0));
+    if (m_radius < 0)
+        throw pdal_error(getName() + ": Option 'radius' can't be "
+            "negative.");
+    m_power = options.getValueOrDefault<double>("power", 1.0);
+    m_noData = options.getValueOrDefault<double>("nodata", -9999.0);
+    m_driver = options.getValueOrDefault<std::string>("gdaldriver", "GTiff");
+    m_creationOptions = options.getValueOrDefault<StringList>("gdalopts",
+        StringList { "TILED=YES", "COMPRESS=DEFLATE" });
+    m_bounds = options.getValueOrDefault<BOX3D>("bounds", BOX3D());
+
+    StringList types = options.getValueOrDefault<StringList>("output_type",
+        StringList { "all" });
+    m_stats = 0;
+    for (const std::string& type : types)
+    {
+        if (boost::iequals(type, "all"))
+        {
+            m_stats = GDALGrid::statAll;
+            continue;
+        }
+        bool found = false;
+        for (const StatInfo& info : s_statInfo)
+            if (boost::iequals(type, info.m_name))
+            {
+                m_stats |= info.m_stat;
+                found = true;
+            }
+        if (!found)
+            throw pdal_error(getName() + ": Invalid output type '" + type +
+                "'.");
+    }
+}
+
+
+void GDALWriter::ready(PointTableRef table)
+{
+    GlobalEnvironment::get().initializeGDAL(log());
+    if (!GDALGetDriverByName(m_driver.c_str()))
+        throw pdal_error(getName() + ": Unknown GDAL driver '" +
+            m_driver + "'.");
+
+    m_srs = getSpatialReference().empty() ?
+        table.spatialRef() : getSpatialReference();
+    m_grids.clear();
+    m_haveExtent = !m_bounds.empty();
+    if (m_haveExtent)
+    {
+        // The raster covers the cells centered in the bounds.
+        m_originX = m_bounds.minx;
+        m_originY = m_bounds.miny;
+        m_col0 = m_rasterCol0 = 0;
+        m_row0 = m_rasterRow0 = 0;
+        m_col1 = m_rasterCol1 =
+            (int)std::floor((m_bounds.maxx - m_bounds.minx) / m_resolution);
+        m_row1 = m_rasterRow1 =
+            (int)std::floor((m_bounds.maxy - m_bounds.miny) / m_resolution);
+    }
+}
+
+
+std::unique_ptr<GDALGrid> GDALWriter::takeGrid()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::unique_ptr<GDALGrid> grid;
+    if (m_grids.size())
+    {
+        grid = std::move(m_grids.back());
+        m_grids.pop_back();
+    }
+    else
+    {
+        grid.reset(new GDALGrid(m_originX, m_originY, m_resolution,
+            m_radius, m_power, m_stats));
+        grid->grow(m_col0, m_row0, m_col1, m_row1);
+    }
+    return grid;
+}
+
+
+void GDALWriter::returnGrid(std::unique_ptr<GDALGrid> grid)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_grids.push_back(std::move(grid));
+}
+
+
+void GDALWriter::growExtent(const BOX3D& bounds)
+{
+    // Without bounds, cells are centered on multiples of the resolution
+    // so that the raster doesn't depend on how the points were chunked.
+    if (!m_haveExtent)
+    {
+        m_originX = 0;
+        m_originY = 0;
+    }
+
+    int col0, row0, col1, row1;
+    GDALGrid lattice(m_originX, m_originY, m_resolution, m_radius, m_power,
+        0);
+    lattice.cellsFor(bounds.minx, bounds.miny, bounds.maxx, bounds.maxy,
+        col0, row0, col1, row1);
+    if (!m_haveExtent)
+    {
+        m_rasterCol0 = m_col0 = col0;
+        m_rasterRow0 = m_row0 = row0;
+        m_rasterCol1 = m_col1 = col1;
+        m_rasterRow1 = m_row1 = row1;
+        m_haveExtent = true;
+        return;
+    }
+
+    m_rasterCol0 = (std::min)(m_rasterCol0, col0);
+    m_rasterRow0 = (std::min)(m_rasterRow0, row0);
+    m_rasterCol1 = (std::max)(m_rasterCol1, col1);
+    m_rasterRow1 = (std::max)(m_rasterRow1, row1);
+    if (col0 >= m_col0 && row0 >= m_row0 && col1 <= m_col1 && row1 <= m_row1)
+        return;
+
+    // Grow each side that must grow by at least half the grids' size.
+    const int width = m_col1 - m_col0 + 1;
+    const int height = m_row1 - m_row0 + 1;
+    if (col0 < m_col0)
+        m_col0 = (std::min)(col0, m_col0 - width / 2);
+    if (row0 < m_row0)
+        m_row0 = (std::min)(row0, m_row0 - height / 2);
+    if (col1 > m_col1)
+        m_col1 = (std::max)(col1, m_col1 + width / 2);
+    if (row1 > m_row1)
+        m_row1 = (std::max)(row1, m_row1 + height / 2);
+    for (auto& grid : m_grids)
+        grid->grow(m_col0, m_row0, m_col1, m_row1);
+}
+
+
+void GDALWriter::write(const PointViewPtr view)
+{
+    if (view->empty())
+        return;
+
+    // With bounds the grids are fixed and points outside are ignored.
+    if (m_bounds.empty())
+        growExtent(view->calculateBounds(false));
+
+    auto add = [this, &view](PointId begin, PointId end)
+    {
+        m_callback->checkInterrupt();
+        std::unique_ptr<GDALGrid> grid = takeGrid();
+        for (PointId idx = begin; idx < end; ++idx)
+            grid->addPoint(
+                view->getFieldAs<double>(Dimension::Id::X, idx),
+                view->getFieldAs<double>(Dimension::Id::Y, idx),
+                view->getFieldAs<double>(Dimension::Id::Z, idx));
+        returnGrid(std::move(grid));
+    };
+
+    // Below this many points per range the cost of handing ranges to the
+    // pool outweighs the work.
+    const point_count_t grain = 16384;
+    if (!view->table().threadSafe() || view->size() < 2 * grain)
+        add(0, view->size());
+    else
+        ThreadPool::shared().parallelFor(view->size(), grain, add);
+}
+
+
+void GDALWriter::done(PointTableRef)
+{
+    if (!m_haveExtent)
+        throw pdal_error(getName() + ": Can't write '" + m_filename +
+            "' without points or bounds.");
+
+    std::unique_ptr<GDALGrid> grid = takeGrid();
+    for (auto& partial : m_grids)
+        grid->merge(*partial);
+    m_grids.clear();
+    writeRaster(*grid);
+}
+
+
+void GDALWriter::writeRaster(const GDALGrid& grid)
+{
+    GDALDriverH driver = GDALGetDriverByName(m_driver.c_str());
+    const size_t width = m_rasterCol1 - m_rasterCol0 + 1;
+    const size_t height = m_rasterRow1 - m_rasterRow0 + 1;
+
+    std::vector<int> stats;
+    for (const StatInfo& info : s_statInfo)
+        if (m_stats & info.m_stat)
+            stats.push_back(info.m_stat);
+
+    // Drivers that can't create a raster (ASCII grids, for instance) are
+    // written by copying one made in memory.
+    const bool canCreate =
+        GDALGetMetadataItem(driver, GDAL_DCAP_CREATE, NULL) != NULL;
+    char **opts = NULL;
+    for (const std::string& opt : m_creationOptions)
+        opts = CSLAddString(opts, opt.c_str());
+    GDALDatasetH ds = GDALCreate(
+        canCreate ? driver : GDALGetDriverByName("MEM"),
+        canCreate ? m_filename.c_str() : "", (int)width, (int)height,
+        (int)stats.size(), GDT_Float64, canCreate ? opts : NULL);
+    if (!ds)
+    {
+        CSLDestroy(opts);
+        throw pdal_error(getName() + ": Unable to create '" + m_filename +
+            "': " + CPLGetLastErrorMsg());
+    }
+
+    // GDAL rows run from north to south and the corner of the raster is
+    // the corner of its first cell.
+    double transform[6];
+    transform[0] = grid.cellX(m_rasterCol0) - m_resolution / 2;
+    transform[1] = m_resolution;
+    transform[2] = 0;
+    transform[3] = grid.cellY(m_rasterRow1) + m_resolution / 2;
+    transform[4] = 0;
+    transform[5] = -m_resolution;
+    GDALSetGeoTransform(ds, transform);
+    if (!m_srs.empty())
+        GDALSetProjection(ds, m_srs.getWKT().c_str());
+
+    std::vector<double> row(width);
+    const size_t i0 = m_rasterCol0 - grid.col0();
+    const size_t j0 = m_rasterRow0 - grid.row0();
+    CPLErr err = CE_None;
+    for (size_t b = 0; b < stats.size() && err == CE_None; ++b)
+    {
+        GDALRasterBandH band = GDALGetRasterBand(ds, (int)b + 1);
+        for (const StatInfo& info : s_statInfo)
+            if (info.m_stat == stats[b])
+                GDALSetDescription(band, info.m_name);
+        GDALSetRasterNoDataValue(band, m_noData);
+        for (size_t r = 0; r < height && err == CE_None; ++r)
+        {
+            const size_t j = j0 + height - 1 - r;
+            for (size_t i = 0; i < width; ++i)
+                row[i] = grid.value(stats[b], i0 + i, j, m_noData);
+            err = GDALRasterIO(band, GF_Write, 0, (int)r, (int)width, 1,
+                row.data(), (int)width, 1, GDT_Float64, 0, 0);
+        }
+    }
+
+    if (err == CE_None && !canCreate)
+    {
+        GDALDatasetH copy = GDALCreateCopy(driver, m_filename.c_str(), ds,
+            FALSE, opts, NULL, NULL);
+        if (copy)
+            GDALClose(copy);
+        else
+            err = CE_Failure;
+    }
+    CSLDestroy(opts);
+    GDALClose(ds);
+    if (err != CE_None)
+        throw pdal_error(getName() + ": Unable to write '" + m_filename +
+            "': " + CPLGetLastErrorMsg());
+}
+
+} // namespace pdal
@@ -0,0 +1,120 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Writer.hpp>
+
+#include "GDALGrid.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C" int32_t GDALWriter_ExitFunc();
+extern "C" PF_ExitFunc GDALWriter_InitPlugin();
+
+namespace pdal
+{
+
+// Writes a raster of statistics of the points near each cell center.
+// Points are added to partial grids on the shared thread pool as each
+// view arrives, so the writer can be streamed, and the partial grids are
+// merged and written with GDAL in done().
+class PDAL_DLL GDALWriter : public Writer
+{
+public:
+    GDALWriter() : m_stats(0), m_haveExtent(false)
+        {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+    Options getDefaultOptions();
+
+    virtual bool streamable() const
+        { return true; }
+
+private:
+    std::string m_filename;
+    std::string m_driver;
+    StringList m_creationOptions;
+    double m_resolution;
+    double m_radius;
+    double m_power;
+    double m_noData;
+    int m_stats;
+    BOX3D m_bounds;
+    SpatialReference m_srs;
+
+    // Partial grids that aren't being added to.  A task takes one, adds
+    // its points and puts it back, so there are never more partial grids
+    // than tasks that run at once.  Between views every grid has the
+    // extent below.
+    std::vector<std::unique_ptr<GDALGrid>> m_grids;
+    std::mutex m_mutex;
+    // Origin of the lattice of cell centers and the lattice cells of the
+    // raster.  Set from the bounds, or else grown to cover each view.
+    bool m_haveExtent;
+    double m_originX;
+    double m_originY;
+    int m_rasterCol0;
+    int m_rasterRow0;
+    int m_rasterCol1;
+    int m_rasterRow1;
+    // Lattice cells covered by the grids.  Grids grow by more than is
+    // needed so that views that each extend the raster a little don't
+    // each copy the grids.
+    int m_col0;
+    int m_row0;
+    int m_col1;
+    int m_row1;
+
+    virtual void processOptions(const Options& options);
+    virtual void ready(PointTableRef table);
+    virtual void write(const PointViewPtr view);
+    virtual void done(PointTableRef table);
+
+    std::unique_ptr<GDALGrid> takeGrid();
+    void returnGrid(std::unique_ptr<GDALGrid> grid);
+    void growExtent(const BOX3D& bounds);
+    void writeRaster(const GDALGrid& grid);
+
+    GDALWriter& operator=(const GDALWriter&); // not implemented
+    GDALWriter(const GDALWriter&); // not implemented
+};
+
+} // namespace pdal
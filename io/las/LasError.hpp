@@ -33,6 +33,7 @@
 
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 #include <pdal/Utils.hpp>
@@ -52,7 +53,10 @@ public:
     void returnNumWarning(int returnNum)
     {
         static std::vector<int> warned;
+        static std::mutex mutex;
 
+        // Points may be decoded on several threads.
+        std::lock_guard<std::mutex> lock(mutex);
         if (!Utils::contains(warned, returnNum))
         {
             warned.push_back(returnNum);
@@ -64,7 +68,10 @@ public:
     void numReturnsWarning(int numReturns)
     {
         static std::vector<int> warned;
+        static std::mutex mutex;
 
+        // Points may be decoded on several threads.
+        std::lock_guard<std::mutex> lock(mutex);
         if (!Utils::contains(warned, numReturns))
         {
             warned.push_back(numReturns);
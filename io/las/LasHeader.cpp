@@ -72,11 +72,11 @@ LasHeader::LasHeader() : m_fileSig(FILE_SIGNATURE), m_sourceId(0),
 {
     std::time_t now;
     std::time(&now);
-    std::tm* ptm = std::gmtime(&now);
-    if (ptm)
+    std::tm tm;
+    if (Utils::gmtime(now, tm))
     {
-        m_createDOY = static_cast<uint16_t>(ptm->tm_yday);
-        m_createYear = static_cast<uint16_t>(ptm->tm_year + 1900);
+        m_createDOY = static_cast<uint16_t>(tm.tm_yday);
+        m_createYear = static_cast<uint16_t>(tm.tm_year + 1900);
     }
 
     m_pointLen = basePointLen(m_pointFormat);
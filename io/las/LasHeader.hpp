@@ -242,7 +242,7 @@ public:
     /// Get the point count by return number.
     /// \param index - Return number.
     /// \return - Point count.
-    uint64_t pointCountByReturn(std::size_t index)
+    uint64_t pointCountByReturn(std::size_t index) const
         { return m_pointCountByReturn[index]; }
 
     size_t maxReturnCount() const
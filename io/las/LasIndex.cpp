@@ -0,0 +1,315 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "LasIndex.hpp"
+
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+
+#include <pdal/pdal_error.hpp>
+#include <pdal/util/IStream.hpp>
+#include <pdal/util/OStream.hpp>
+
+namespace pdal
+{
+
+namespace
+{
+
+// Cells of all levels are numbered together, level by level, starting
+// from the single cell of level 0.
+uint32_t levelOffset(uint32_t level)
+{
+    return ((1u << (2 * level)) - 1) / 3;
+}
+
+void checkSignature(ILeStream& in, const std::string& expected)
+{
+    std::string signature;
+    in.get(signature, 4);
+    if (!in || signature != expected)
+        throw pdal_error("Invalid LAX index: expected '" + expected + "'.");
+}
+
+} // unnamed namespace
+
+
+LasIndex::LasIndex() : m_levels(0), m_minX(0), m_maxX(0), m_minY(0),
+    m_maxY(0)
+{}
+
+
+std::string LasIndex::filename(const std::string& lasFilename)
+{
+    boost::filesystem::path p(lasFilename);
+    p.replace_extension(".lax");
+    return p.string();
+}
+
+
+// The extent is grown to whole cells and then to a square power of two
+// cells on a side, as LAStools does, so that the indexes it reads have the
+// same cells.
+void LasIndex::setup(const BOX3D& bounds, double cellSize)
+{
+    auto low = [cellSize](double v)
+    {
+        int32_t c = (int32_t)(v / cellSize);
+        return (float)(cellSize * (v >= 0 ? c : c - 1));
+    };
+    auto high = [cellSize](double v)
+    {
+        int32_t c = (int32_t)(v / cellSize);
+        return (float)(cellSize * (v >= 0 ? c + 1 : c));
+    };
+    m_minX = low(bounds.minx);
+    m_maxX = high(bounds.maxx);
+    m_minY = low(bounds.miny);
+    m_maxY = high(bounds.maxy);
+
+    uint32_t cellsX = (uint32_t)((m_maxX - m_minX) / cellSize + .5);
+    uint32_t cellsY = (uint32_t)((m_maxY - m_minY) / cellSize + .5);
+    if (cellsX == 0 || cellsY == 0)
+        throw pdal_error("Can't index points with an empty extent.");
+
+    uint32_t c = std::max(cellsX, cellsY) - 1;
+    m_levels = 0;
+    while (c)
+    {
+        c >>= 1;
+        m_levels++;
+    }
+
+    uint32_t padX = (1u << m_levels) - cellsX;
+    m_minX -= (float)((padX / 2) * cellSize);
+    m_maxX += (float)((padX - padX / 2) * cellSize);
+    uint32_t padY = (1u << m_levels) - cellsY;
+    m_minY -= (float)((padY / 2) * cellSize);
+    m_maxY += (float)((padY - padY / 2) * cellSize);
+
+    m_cells.clear();
+}
+
+
+void LasIndex::addPoint(point_count_t idx, double x, double y)
+{
+    Cell& cell = m_cells[cellIndex(x, y)];
+    if (cell.m_intervals.size() && cell.m_intervals.back().second + 1 == idx)
+        cell.m_intervals.back().second = (uint32_t)idx;
+    else
+        cell.m_intervals.push_back(
+            std::make_pair((uint32_t)idx, (uint32_t)idx));
+    cell.m_numPoints++;
+}
+
+
+void LasIndex::complete(point_count_t threshold)
+{
+    for (auto& c : m_cells)
+    {
+        auto& intervals = c.second.m_intervals;
+        std::vector<std::pair<uint32_t, uint32_t>> merged;
+        for (auto& i : intervals)
+        {
+            if (merged.size() &&
+                    i.first - merged.back().second - 1 < threshold)
+                merged.back().second = i.second;
+            else
+                merged.push_back(i);
+        }
+        intervals.swap(merged);
+    }
+}
+
+
+void LasIndex::read(std::istream& stream)
+{
+    ILeStream in(&stream);
+
+    uint32_t version;
+    checkSignature(in, "LASX");
+    in >> version;
+
+    uint32_t type;
+    checkSignature(in, "LASS");
+    in >> type;
+    if (type != 0)
+        throw pdal_error("Invalid LAX index: unsupported spatial index.");
+    checkSignature(in, "LASQ");
+    uint32_t levelIndex;
+    uint32_t implicitLevels;
+    in >> version >> m_levels >> levelIndex >> implicitLevels;
+    in >> m_minX >> m_maxX >> m_minY >> m_maxY;
+
+    int32_t numCells;
+    checkSignature(in, "LASV");
+    in >> version >> numCells;
+    m_cells.clear();
+    for (int32_t i = 0; i < numCells; ++i)
+    {
+        int32_t index;
+        uint32_t numIntervals;
+        Cell cell;
+        in >> index >> numIntervals >> cell.m_numPoints;
+        for (uint32_t j = 0; j < numIntervals; ++j)
+        {
+            uint32_t start, end;
+            in >> start >> end;
+            cell.m_intervals.push_back(std::make_pair(start, end));
+        }
+        if (!in)
+            throw pdal_error("Invalid LAX index: file is truncated.");
+        m_cells[index] = std::move(cell);
+    }
+}
+
+
+void LasIndex::write(std::ostream& stream) const
+{
+    OLeStream out(&stream);
+
+    out.put("LASX");
+    out << (uint32_t)0;
+
+    out.put("LASS");
+    out << (uint32_t)0;  // Quadtree
+    out.put("LASQ");
+    out << (uint32_t)0 << m_levels << (uint32_t)0 << (uint32_t)0;
+    out << m_minX << m_maxX << m_minY << m_maxY;
+
+    out.put("LASV");
+    out << (uint32_t)0 << (int32_t)m_cells.size();
+    for (auto& c : m_cells)
+    {
+        const Cell& cell = c.second;
+        out << c.first << (uint32_t)cell.m_intervals.size() <<
+            cell.m_numPoints;
+        for (auto& i : cell.m_intervals)
+            out << i.first << i.second;
+    }
+}
+
+
+LasIndex::IntervalList LasIndex::intervals(const BOX3D& bounds) const
+{
+    IntervalList list;
+    for (auto& c : m_cells)
+    {
+        BOX3D b = cellBounds(c.first);
+        if (b.minx > bounds.maxx || b.maxx < bounds.minx ||
+            b.miny > bounds.maxy || b.maxy < bounds.miny)
+            continue;
+        for (auto& i : c.second.m_intervals)
+            list.push_back(Interval(i.first, (point_count_t)i.second + 1));
+    }
+    std::sort(list.begin(), list.end());
+
+    IntervalList merged;
+    for (auto& i : list)
+    {
+        if (merged.size() && i.first <= merged.back().second)
+            merged.back().second = std::max(merged.back().second, i.second);
+        else
+            merged.push_back(i);
+    }
+    return merged;
+}
+
+
+// Descend the quadtree to the cell containing (x, y) at the finest level,
+// splitting cells at float midpoints as LAStools does.
+int32_t LasIndex::cellIndex(double x, double y) const
+{
+    float minX = m_minX;
+    float maxX = m_maxX;
+    float minY = m_minY;
+    float maxY = m_maxY;
+
+    uint32_t index = 0;
+    for (uint32_t level = 0; level < m_levels; ++level)
+    {
+        index <<= 2;
+        float midX = (minX + maxX) / 2;
+        float midY = (minY + maxY) / 2;
+        if (x < midX)
+            maxX = midX;
+        else
+        {
+            minX = midX;
+            index |= 1;
+        }
+        if (y < midY)
+            maxY = midY;
+        else
+        {
+            minY = midY;
+            index |= 2;
+        }
+    }
+    return (int32_t)(levelOffset(m_levels) + index);
+}
+
+
+// Cells at any level are handled, since LAStools joins sparse cells into
+// their parents.
+BOX3D LasIndex::cellBounds(int32_t cell) const
+{
+    uint32_t level = 0;
+    while (level < m_levels && levelOffset(level + 1) <= (uint32_t)cell)
+        level++;
+    uint32_t index = (uint32_t)cell - levelOffset(level);
+
+    float minX = m_minX;
+    float maxX = m_maxX;
+    float minY = m_minY;
+    float maxY = m_maxY;
+    while (level--)
+    {
+        uint32_t quad = (index >> (2 * level)) & 3;
+        float midX = (minX + maxX) / 2;
+        float midY = (minY + maxY) / 2;
+        if (quad & 1)
+            minX = midX;
+        else
+            maxX = midX;
+        if (quad & 2)
+            minY = midY;
+        else
+            maxY = midY;
+    }
+    return BOX3D(minX, minY, maxX, maxY);
+}
+
+} // namespace pdal
@@ -0,0 +1,106 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+#include <pdal/util/Bounds.hpp>
+
+namespace pdal
+{
+
+// The spatial index that LAStools writes beside a LAS/LAZ file as a .lax
+// file.  The XY extent of the points is divided into the cells of a
+// quadtree, and each cell lists the ranges of point numbers that hold its
+// points.  Ranges may also hold points outside of the cell, so points read
+// through the index still need to be checked against the area wanted.
+class PDAL_DLL LasIndex
+{
+public:
+    // A range [first, second) of point numbers.
+    typedef std::pair<point_count_t, point_count_t> Interval;
+    typedef std::vector<Interval> IntervalList;
+
+    LasIndex();
+
+    // The name of the index file for a LAS file: foo.laz -> foo.lax
+    static std::string filename(const std::string& lasFilename);
+
+    // Start an empty index of the points in 'bounds' using cells no smaller
+    // than 'cellSize' on a side.
+    void setup(const BOX3D& bounds, double cellSize);
+    // Add the next point to the index.  Points must be added in order.
+    void addPoint(point_count_t idx, double x, double y);
+    // Join the ranges of a cell that are separated by fewer than
+    // 'threshold' points, trading a few extra points read for fewer seeks.
+    void complete(point_count_t threshold);
+
+    // Throws pdal_error if the stream doesn't hold an index.
+    void read(std::istream& in);
+    void write(std::ostream& out) const;
+
+    // The sorted, non-overlapping ranges of points in cells that overlap
+    // the XY extent of 'bounds'.
+    IntervalList intervals(const BOX3D& bounds) const;
+    std::size_t cellCount() const
+        { return m_cells.size(); }
+
+private:
+    struct Cell
+    {
+        Cell() : m_numPoints(0)
+        {}
+
+        uint32_t m_numPoints;
+        // Inclusive ranges, as stored in the file.
+        std::vector<std::pair<uint32_t, uint32_t>> m_intervals;
+    };
+
+    uint32_t m_levels;
+    float m_minX;
+    float m_maxX;
+    float m_minY;
+    float m_maxY;
+    std::map<int32_t, Cell> m_cells;
+
+    int32_t cellIndex(double x, double y) const;
+    BOX3D cellBounds(int32_t cell) const;
+};
+
+} // namespace pdal
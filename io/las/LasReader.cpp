@@ -34,18 +34,27 @@
 
 #include "LasReader.hpp"
 
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <mutex>
 #include <sstream>
 #include <string.h>
 
+#include <boost/algorithm/string/predicate.hpp>
+
 #include <pdal/Metadata.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/QuickInfo.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/util/Extractor.hpp>
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/util/IStream.hpp>
+#include <pdal/Utils.hpp>
 
 #include "GeotiffSupport.hpp"
 #include "LasHeader.hpp"
+#include "LasIndex.hpp"
 #include "VariableLengthRecord.hpp"
 #include "ZipPoint.hpp"
 
@@ -98,12 +107,85 @@ double toDouble(const Everything& e, Dimension::Type::Enum type)
     return d;
 }
 
+
+// Read the little-endian field at 'offset' of each of 'count' records that
+// are 'stride' bytes apart.
+template<typename T>
+void extractColumn(const char *buf, size_t stride, size_t offset,
+    point_count_t count, T *out)
+{
+    LeExtractor in(buf, stride * count);
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        in.seek(i * stride + offset);
+        in >> out[i];
+    }
+}
+
+
+// Set a dimension of 'count' points starting at 'begin' from a field of
+// the records in 'buf'.  Fields of dimensions that weren't registered
+// aren't decoded.
+template<typename T>
+void setColumn(PointView& data, Dimension::Id::Enum dim, PointId begin,
+    const char *buf, size_t stride, size_t offset, point_count_t count,
+    std::vector<T>& scratch)
+{
+    if (!data.hasDim(dim))
+        return;
+    scratch.resize(count);
+    extractColumn(buf, stride, offset, count, scratch.data());
+    data.setFieldArray(dim, begin, count, scratch.data());
+}
+
 } // unnamed namespace
 
 void LasReader::processOptions(const Options& options)
 {
     StringList extraDims = options.getValueOrDefault<StringList>("extra_dims");
     m_extraDims = LasUtils::parse(extraDims);
+    m_compactXyz = options.getValueOrDefault<bool>("compact_xyz", false);
+    m_compactFlags = options.getValueOrDefault<bool>("compact_flags", false);
+    m_bounds = options.getValueOrDefault<BOX3D>("bounds", BOX3D());
+    m_start = options.getValueOrDefault<point_count_t>("start", 0);
+    m_stride = options.getValueOrDefault<point_count_t>("stride", 1);
+    if (m_stride == 0)
+        throw pdal_error("Option 'stride' must be greater than 0.");
+    m_dimNames = options.getValueOrDefault<StringList>("dimensions");
+
+#ifdef PDAL_HAVE_LASZIP
+    std::string engine("laszip");
+#else
+    std::string engine("lazperf");
+#endif
+    engine = Utils::tolower(
+        options.getValueOrDefault<std::string>("compression", engine));
+    if (engine == "lazperf")
+        m_lazPerf = true;
+    else if (engine == "laszip")
+        m_lazPerf = false;
+    else
+        throw pdal_error("Invalid value '" + engine + "' for 'compression' "
+            "option.  Use 'laszip' or 'lazperf'.");
+
+    m_filenames.clear();
+    StringList filenames = options.getValueOrDefault<StringList>("filenames");
+    for (auto& f : filenames)
+    {
+        if (f.find_first_of("*?") == std::string::npos)
+        {
+            m_filenames.push_back(f);
+            continue;
+        }
+        StringList matches = FileUtils::glob(f);
+        if (matches.empty())
+            throw pdal_error("No files match '" + f + "'.");
+        m_filenames.insert(m_filenames.end(), matches.begin(), matches.end());
+    }
+    if (m_filenames.size() && (m_start != 0 || m_stride != 1 ||
+            m_compactXyz || m_compactFlags))
+        throw pdal_error("Options 'start', 'stride', 'compact_xyz' and "
+            "'compact_flags' can't be used with option 'filenames'.");
 
     m_error.setFilename(m_filename);
 }
@@ -124,8 +206,24 @@ QuickInfo LasReader::inspect()
     QuickInfo qi;
     PointLayoutPtr layout(new PointLayout());
 
-    addDimensions(layout);
+    // The dimensions depend on the point format and extra bytes VLR.
     initialize();
+    addDimensions(layout);
+
+    if (m_filenames.size())
+    {
+        for (auto& dim : layout->dims())
+            qi.m_dimNames.push_back(layout->dimName(dim));
+        for (auto& file : m_files)
+        {
+            qi.m_pointCount += Utils::saturation_cast<point_count_t>(
+                file->m_lasHeader.pointCount());
+            qi.m_bounds.grow(file->m_lasHeader.getBounds());
+        }
+        qi.m_srs = m_filesSrs;
+        qi.m_metadata.add("file_count", m_files.size());
+        return qi;
+    }
 
     Dimension::IdList dims = layout->dims();
     for (auto di = dims.begin(); di != dims.end(); ++di)
@@ -134,12 +232,35 @@ QuickInfo LasReader::inspect()
         Utils::saturation_cast<point_count_t>(m_lasHeader.pointCount());
     qi.m_bounds = m_lasHeader.getBounds();
     qi.m_srs = getSrsFromVlrs();
+
+    MetadataNode& m = qi.m_metadata;
+    extractHeaderMetadata(m);
+    for (size_t i = 0; i < m_lasHeader.maxReturnCount(); ++i)
+        m.addList("count_by_return", m_lasHeader.pointCountByReturn(i));
+    for (auto& dim : m_extraDims)
+    {
+        MetadataNode ed = m.addList("extra_dims");
+        ed.add("name", dim.m_name);
+        ed.add("type", Dimension::interpretationName(dim.m_dimType.m_type));
+        ed.add("scale", dim.m_dimType.m_xform.m_scale);
+        ed.add("offset", dim.m_dimType.m_xform.m_offset);
+    }
+
+    // Callers may inspect many files, so don't hold this one open.
+    m_streamFactory->deallocate(*m_istream);
+    m_istream = NULL;
     return qi;
 }
 
 
 void LasReader::initialize()
 {
+    if (m_filenames.size())
+    {
+        initializeFiles();
+        return;
+    }
+
     m_streamFactory = createFactory();
     m_istream = &(m_streamFactory->allocate());
 
@@ -156,65 +277,277 @@ void LasReader::initialize()
     }
 
     // We need to read the VLRs in initialize() because they may contain an
-    // extra-bytes VLR that is needed to determine dimensions.
+    // extra-bytes VLR that is needed to determine dimensions.  Only the
+    // record headers are read here.  findVlr() reads the data of the
+    // records that are wanted.
+    m_vlrs.clear();
+    m_vlrData.clear();
     m_istream->seekg(m_lasHeader.vlrOffset());
-    for (size_t i = 0; i < m_lasHeader.vlrCount(); ++i)
-    {
-        VariableLengthRecord r;
-        in >> r;
-        m_vlrs.push_back(std::move(r));
-    }
+    readVlrHeaders<VariableLengthRecord>(in, m_lasHeader.vlrCount());
 
     if (m_lasHeader.versionAtLeast(1, 4))
     {
         m_istream->seekg(m_lasHeader.eVlrOffset());
-        for (size_t i = 0; i < m_lasHeader.eVlrCount(); ++i)
-        {
-            ExtVariableLengthRecord r;
-            in >> r;
-            m_vlrs.push_back(std::move(r));
-        }
+        readVlrHeaders<ExtVariableLengthRecord>(in, m_lasHeader.eVlrCount());
         readExtraBytesVlr();
     }
     fixupVlrs();
 }
 
 
+/// Prepare a reader for each of the files named by the "filenames" option.
+/// The headers are read on the thread pool.  Files whose header bounds
+/// don't overlap the "bounds" option are dropped.  Each reader closes its
+/// file until the points are read, so many files can be read in turn.
+void LasReader::initializeFiles()
+{
+    Options ops(m_options);
+    ops.remove("filenames");
+    ops.remove("filename");
+
+    std::vector<std::unique_ptr<LasReader>> files(m_filenames.size());
+    auto open = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            std::unique_ptr<LasReader> file(new LasReader);
+            Options fileOps(ops);
+            fileOps.add("filename", m_filenames[i]);
+            file->setOptions(fileOps);
+            file->m_part = true;
+            PointTable table;
+            file->prepare(table);
+
+            BOX3D bounds(m_bounds);
+            bool keep = bounds.empty() ||
+                bounds.overlaps(file->m_lasHeader.getBounds());
+            // Read the SRS records now, so that they're at hand once the
+            // file is closed.
+            if (keep)
+                for (size_t v = 0; v < file->m_vlrs.size(); ++v)
+                    if (file->m_vlrs[v].matches(TRANSFORM_USER_ID) ||
+                        file->m_vlrs[v].matches(LIBLAS_USER_ID))
+                        file->loadVlr(v);
+            file->m_streamFactory->deallocate(*file->m_istream);
+            file->m_istream = NULL;
+            if (keep)
+                files[i] = std::move(file);
+        }
+    };
+    ThreadPool::shared().parallelFor(files.size(), 1, open);
+
+    m_files.clear();
+    for (auto& file : files)
+        if (file)
+            m_files.push_back(std::move(file));
+    if (m_files.size())
+        m_filesSrs = m_files.front()->getSrsFromVlrs();
+}
+
+
+bool LasReader::setStride(point_count_t start, point_count_t stride)
+{
+    // Point numbers given to a following filter must be file point numbers.
+    if (m_filenames.size() || m_start != 0 || m_stride != 1 || !m_bounds.empty() ||
+        m_count != (std::numeric_limits<point_count_t>::max)() || stride == 0)
+        return false;
+    m_start = start;
+    m_stride = stride;
+    return true;
+}
+
+
+bool LasReader::setPointIds(const std::vector<PointId>& ids)
+{
+    if (m_filenames.size() || m_start != 0 || m_stride != 1 ||
+        !m_bounds.empty() || m_selectIds ||
+        m_count != (std::numeric_limits<point_count_t>::max)())
+        return false;
+    m_selectIds = true;
+    m_pointIds.clear();
+    for (PointId id : ids)
+        if (id < getNumPoints())
+            m_pointIds.push_back(id);
+    // Points are read in file order, so the reader only seeks forward.
+    std::sort(m_pointIds.begin(), m_pointIds.end());
+    m_pointIds.erase(std::unique(m_pointIds.begin(), m_pointIds.end()),
+        m_pointIds.end());
+    return true;
+}
+
+
+bool LasReader::setBounds(const BOX3D& bounds)
+{
+    // The 'count', 'start' and 'stride' options are of the points in the
+    // file, not of those inside the bounds.
+    if (bounds.empty() || !m_bounds.empty() || m_start != 0 ||
+        m_stride != 1 ||
+        m_count != (std::numeric_limits<point_count_t>::max)())
+        return false;
+    m_bounds = bounds;
+
+    // The files were prepared without the bounds, so drop those outside
+    // them and have the rest read only the points inside.
+    if (m_filenames.size())
+    {
+        std::vector<std::unique_ptr<LasReader>> files;
+        for (auto& file : m_files)
+            if (m_bounds.overlaps(file->m_lasHeader.getBounds()))
+            {
+                file->m_bounds = m_bounds;
+                files.push_back(std::move(file));
+            }
+        m_files.swap(files);
+    }
+    return true;
+}
+
+
 void LasReader::ready(PointTableRef table, MetadataNode& m)
 {
-    m_index = 0;
+    if (m_filenames.size())
+    {
+        // Each file is readied when reading gets to it.
+        m_curFile = 0;
+        m_table = &table;
+        m_filesMetadata = m;
+        if (getSpatialReference().empty())
+            setSpatialReference(m, m_filesSrs);
+        point_count_t count = 0;
+        for (auto& file : m_files)
+            count += file->getNumPoints();
+        m.add("count", count, "Number of points in the files.");
+        m.add("file_count", m_files.size(), "Number of files with points "
+            "that may be read.");
+        return;
+    }
+
+    m_index = m_start;
+    m_curId = 0;
 
     setSrsFromVlrs(m);
     extractHeaderMetadata(m);
 
     if (m_lasHeader.compressed())
+        readyCompression();
+
+    if (!m_bounds.empty())
+        findIntervals();
+
+    m_mapTable = dynamic_cast<MappedPointTable *>(&table);
+    if (m_mapTable && !mapPoints(*m_mapTable))
+        m_mapTable = NULL;
+    if (!m_mapTable)
+        table.reserve(std::min(m_count, pointsLeft()));
+}
+
+
+// Map the point records into the point table.  Returns false if the
+// points need to be read and decoded instead.
+bool LasReader::mapPoints(MappedPointTable& table)
+{
+    using namespace Dimension;
+
+    const LasHeader& h = m_lasHeader;
+    if (m_part || h.compressed() || table.mapped() || getNumPoints() == 0 ||
+        !m_bounds.empty() || m_start != 0 || m_stride != 1 || m_selectIds ||
+        RemoteStreamFactory::remote(m_filename))
+        return false;
+    switch (h.pointFormat())
     {
-#ifdef PDAL_HAVE_LASZIP
-        VariableLengthRecord *vlr = findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
-        m_zipPoint.reset(new ZipPoint(vlr));
+    case 0: case 1: case 2: case 3: case 6: case 7: case 8:
+        break;
+    default:
+        return false;
+    }
 
-        if (!m_unzipper)
-        {
-            m_unzipper.reset(new LASunzipper());
+    table.mapFile(m_filename, fileOffset() + h.pointOffset(),
+        getNumPoints(), h.pointLen());
 
-            m_istream->seekg(m_lasHeader.pointOffset(), std::ios::beg);
+    // Only registered dimensions can be mapped.
+    PointLayoutPtr layout = table.layout();
+    auto mapScaled = [&table, layout](Id::Enum id, size_t pos,
+        Type::Enum type, double scale, double offset)
+    {
+        if (layout->hasDim(id))
+            table.mapDim(id, pos, type, scale, offset);
+    };
+    auto mapDim = [&mapScaled](Id::Enum id, size_t pos, Type::Enum type)
+        { mapScaled(id, pos, type, 1.0, 0.0); };
+    auto mapBits = [&table, layout](Id::Enum id, size_t pos, int shift,
+        int bits)
+    {
+        if (layout->hasDim(id))
+            table.mapBits(id, pos, shift, bits);
+    };
 
-            // Once we open the zipper, don't touch the stream until the
-            // zipper is closed or bad things happen.
-            if (!m_unzipper->open(*m_istream, m_zipPoint->GetZipper()))
-            {
-                std::ostringstream oss;
-                const char* err = m_unzipper->get_error();
-                if (err == NULL)
-                    err = "(unknown error)";
-                oss << "Failed to open LASzip stream: " << std::string(err);
-                throw pdal_error(oss.str());
-            }
+    mapScaled(Id::X, 0, Type::Signed32, h.scaleX(), h.offsetX());
+    mapScaled(Id::Y, 4, Type::Signed32, h.scaleY(), h.offsetY());
+    mapScaled(Id::Z, 8, Type::Signed32, h.scaleZ(), h.offsetZ());
+    mapDim(Id::Intensity, 12, Type::Unsigned16);
+
+    size_t pos;
+    if (h.has14Format())
+    {
+        mapBits(Id::ReturnNumber, 14, 0, 4);
+        mapBits(Id::NumberOfReturns, 14, 4, 4);
+        mapBits(Id::ScanChannel, 15, 4, 2);
+        mapBits(Id::ScanDirectionFlag, 15, 6, 1);
+        mapBits(Id::EdgeOfFlightLine, 15, 7, 1);
+        mapDim(Id::Classification, 16, Type::Unsigned8);
+        mapDim(Id::UserData, 17, Type::Unsigned8);
+        mapScaled(Id::ScanAngleRank, 18, Type::Signed16, .006, 0.0);
+        mapDim(Id::PointSourceId, 20, Type::Unsigned16);
+        mapDim(Id::GpsTime, 22, Type::Double);
+        pos = 30;
+    }
+    else
+    {
+        mapBits(Id::ReturnNumber, 14, 0, 3);
+        mapBits(Id::NumberOfReturns, 14, 3, 3);
+        mapBits(Id::ScanDirectionFlag, 14, 6, 1);
+        mapBits(Id::EdgeOfFlightLine, 14, 7, 1);
+        mapDim(Id::Classification, 15, Type::Unsigned8);
+        mapDim(Id::ScanAngleRank, 16, Type::Signed8);
+        mapDim(Id::UserData, 17, Type::Unsigned8);
+        mapDim(Id::PointSourceId, 18, Type::Unsigned16);
+        pos = 20;
+        if (h.hasTime())
+        {
+            mapDim(Id::GpsTime, pos, Type::Double);
+            pos += 8;
         }
-#else
-        throw pdal_error("LASzip is not enabled.  Can't read LAZ data.");
-#endif
     }
+    if (h.hasColor())
+    {
+        mapDim(Id::Red, pos, Type::Unsigned16);
+        mapDim(Id::Green, pos + 2, Type::Unsigned16);
+        mapDim(Id::Blue, pos + 4, Type::Unsigned16);
+        pos += 6;
+    }
+    if (h.hasInfrared())
+    {
+        mapDim(Id::Infrared, pos, Type::Unsigned16);
+        pos += 2;
+    }
+
+    for (auto& dim : m_extraDims)
+    {
+        Type::Enum type = dim.m_dimType.m_type;
+        if (type == Type::None)
+        {
+            pos += dim.m_size;
+            continue;
+        }
+        if (dim.m_dimType.m_xform.nonstandard())
+            mapScaled(dim.m_dimType.m_id, pos, type,
+                dim.m_dimType.m_xform.m_scale,
+                dim.m_dimType.m_xform.m_offset);
+        else
+            mapDim(dim.m_dimType.m_id, pos, type);
+        pos += Dimension::size(type);
+    }
+    return true;
 }
 
 
@@ -224,6 +557,23 @@ Options LasReader::getDefaultOptions()
     options.add("filename", "", "file to read from");
     options.add("extra_dims", "", "Extra dimensions not part of the LAS "
         "point format to be read from each point.");
+    options.add("compact_xyz", false, "Store X, Y and Z as scaled integers "
+        "rather than doubles.");
+    options.add("compact_flags", false, "Store return numbers, scan "
+        "channel and flags in as many bits as the file does rather than a "
+        "byte each.");
+    options.add("bounds", BOX3D(), "Only read points inside these bounds.  "
+        "If the file has a .lax index only the parts of the file that may "
+        "hold such points are read.");
+    options.add("start", 0, "Number of the first point to read.");
+    options.add("stride", 1, "Read every Nth point starting at 'start'.");
+    options.add("dimensions", "", "Comma-separated names of the dimensions "
+        "to read.  X, Y and Z are always read.  All dimensions are read if "
+        "none are given.");
+    options.add("filenames", "", "Comma-separated names of files to read "
+        "in turn instead of 'filename'.  The names may be glob patterns.");
+    options.add("compression", "laszip", "Engine that decompresses LAZ "
+        "data: 'laszip' or 'lazperf'.");
     return options;
 }
 
@@ -410,15 +760,48 @@ SpatialReference LasReader::getSrsFromVlrs()
 }
 
 
-VariableLengthRecord *LasReader::findVlr(const std::string& userId,
-    uint16_t recordId)
+template<typename VLR>
+void LasReader::readVlrHeaders(ILeStream& in, size_t count)
 {
-    for (auto vi = m_vlrs.begin(); vi != m_vlrs.end(); ++vi)
+    for (size_t i = 0; i < count; ++i)
     {
-        VariableLengthRecord& vlr = *vi;
-        if (vlr.matches(userId, recordId))
-            return &vlr;
+        VLR r;
+        VlrData data;
+        data.m_len = r.readHeader(in);
+        data.m_pos = in.position();
+        data.m_read = false;
+        in.skip(data.m_len);
+        m_vlrs.push_back(std::move(r));
+        m_vlrData.push_back(data);
     }
+}
+
+
+/// Make sure that the data of a VLR has been read.
+/// \param  i - Index of the VLR.
+/// \return  The VLR.
+VariableLengthRecord& LasReader::loadVlr(size_t i)
+{
+    VariableLengthRecord& vlr = m_vlrs[i];
+    VlrData& data = m_vlrData[i];
+    if (!data.m_read)
+    {
+        ILeStream in(m_istream);
+        in.seek(data.m_pos);
+        vlr.setDataLen(data.m_len);
+        in.get(vlr.data(), (size_t)data.m_len);
+        data.m_read = true;
+    }
+    return vlr;
+}
+
+
+VariableLengthRecord *LasReader::findVlr(const std::string& userId,
+    uint16_t recordId)
+{
+    for (size_t i = 0; i < m_vlrs.size(); ++i)
+        if (m_vlrs[i].matches(userId, recordId))
+            return &loadVlr(i);
     return NULL;
 }
 
@@ -487,12 +870,12 @@ void LasReader::extractVlrMetadata(MetadataNode& m)
 {
     static const size_t DATA_LEN_MAX = 1000000;
 
-    int i = 0;
-    for (auto vi = m_vlrs.begin(); vi != m_vlrs.end(); ++vi, ++i)
+    for (size_t i = 0; i < m_vlrs.size(); ++i)
     {
-        const VariableLengthRecord& vlr = *vi;
-        if (vlr.dataLen() > DATA_LEN_MAX)
+        // Huge records aren't put in metadata, so don't bother reading them.
+        if (m_vlrData[i].m_len > DATA_LEN_MAX)
             continue;
+        const VariableLengthRecord& vlr = loadVlr(i);
 
         std::ostringstream name;
         name << "vlr_" << i;
@@ -513,106 +896,679 @@ void LasReader::addDimensions(PointLayoutPtr layout)
 {
     using namespace Dimension;
 
-    layout->registerDim(Id::X, Type::Double);
-    layout->registerDim(Id::Y, Type::Double);
-    layout->registerDim(Id::Z, Type::Double);
-    layout->registerDim(Id::Intensity, Type::Unsigned16);
-    layout->registerDim(Id::ReturnNumber, Type::Unsigned8);
-    layout->registerDim(Id::NumberOfReturns, Type::Unsigned8);
-    layout->registerDim(Id::ScanDirectionFlag, Type::Unsigned8);
-    layout->registerDim(Id::EdgeOfFlightLine, Type::Unsigned8);
-    layout->registerDim(Id::Classification, Type::Unsigned8);
-    layout->registerDim(Id::ScanAngleRank, Type::Signed8);
-    layout->registerDim(Id::UserData, Type::Unsigned8);
-    layout->registerDim(Id::PointSourceId, Type::Unsigned16);
-
-    if (m_lasHeader.hasTime())
-        layout->registerDim(Id::GpsTime, Type::Double);
-    if (m_lasHeader.hasColor())
-    {
-        layout->registerDim(Id::Red, Type::Unsigned16);
-        layout->registerDim(Id::Green, Type::Unsigned16);
-        layout->registerDim(Id::Blue, Type::Unsigned16);
-    }
-    if (m_lasHeader.hasInfrared())
-        layout->registerDim(Id::Infrared);
-    if (m_lasHeader.versionAtLeast(1, 4))
-        layout->registerDim(Id::ScanChannel);
+    // The layout holds the dimensions of every file.
+    if (m_filenames.size())
+    {
+        layout->registerDim(Id::X, Type::Double);
+        layout->registerDim(Id::Y, Type::Double);
+        layout->registerDim(Id::Z, Type::Double);
+        for (auto& file : m_files)
+            file->addDimensions(layout);
+        return;
+    }
+
+    // Dimensions that weren't asked for are neither registered nor decoded.
+    StringList unused(m_dimNames);
+    auto wanted = [this, &unused](const std::string& name)
+    {
+        if (m_dimNames.empty())
+            return true;
+        auto matches = [&name](const std::string& s)
+            { return boost::iequals(s, name); };
+        unused.erase(std::remove_if(unused.begin(), unused.end(), matches),
+            unused.end());
+        return std::any_of(m_dimNames.begin(), m_dimNames.end(), matches);
+    };
+    auto reg = [&](Id::Enum id, Type::Enum type)
+    {
+        if (wanted(Dimension::name(id)))
+            layout->registerDim(id, type);
+    };
+    auto regBits = [&](Id::Enum id, int bits)
+    {
+        if (!wanted(Dimension::name(id)))
+            return;
+        if (m_compactFlags)
+            layout->registerPackedDim(id, bits);
+        else
+            layout->registerDim(id, Type::Unsigned8);
+    };
+
+    const LasHeader& h = m_lasHeader;
+    wanted("X");
+    wanted("Y");
+    wanted("Z");
+    if (m_compactXyz)
+    {
+        layout->registerScaledDim(Id::X, Type::Signed32,
+            XForm(h.scaleX(), h.offsetX()));
+        layout->registerScaledDim(Id::Y, Type::Signed32,
+            XForm(h.scaleY(), h.offsetY()));
+        layout->registerScaledDim(Id::Z, Type::Signed32,
+            XForm(h.scaleZ(), h.offsetZ()));
+    }
+    else
+    {
+        layout->registerDim(Id::X, Type::Double);
+        layout->registerDim(Id::Y, Type::Double);
+        layout->registerDim(Id::Z, Type::Double);
+    }
+    reg(Id::Intensity, Type::Unsigned16);
+    const int returnBits = h.has14Format() ? 4 : 3;
+    regBits(Id::ReturnNumber, returnBits);
+    regBits(Id::NumberOfReturns, returnBits);
+    regBits(Id::ScanDirectionFlag, 1);
+    regBits(Id::EdgeOfFlightLine, 1);
+    reg(Id::Classification, Type::Unsigned8);
+    reg(Id::ScanAngleRank, Type::Signed8);
+    reg(Id::UserData, Type::Unsigned8);
+    reg(Id::PointSourceId, Type::Unsigned16);
+
+    if (h.hasTime())
+        reg(Id::GpsTime, Type::Double);
+    if (h.hasColor())
+    {
+        reg(Id::Red, Type::Unsigned16);
+        reg(Id::Green, Type::Unsigned16);
+        reg(Id::Blue, Type::Unsigned16);
+    }
+    if (h.hasInfrared())
+        reg(Id::Infrared, defaultType(Id::Infrared));
+    if (h.versionAtLeast(1, 4))
+    {
+        if (m_compactFlags)
+            regBits(Id::ScanChannel, 2);
+        else
+            reg(Id::ScanChannel, defaultType(Id::ScanChannel));
+    }
 
     for (auto& dim : m_extraDims)
     {
         Dimension::Type::Enum type = dim.m_dimType.m_type;
-        if (type == Dimension::Type::None)
+        dim.m_dimType.m_id = Id::Unknown;
+        if (type == Dimension::Type::None || !wanted(dim.m_name))
             continue;
         if (dim.m_dimType.m_xform.nonstandard())
             type = Dimension::Type::Double;
         dim.m_dimType.m_id = layout->assignDim(dim.m_name, type);
     }
+
+    if (unused.size())
+    {
+        std::ostringstream oss;
+        oss << "Invalid dimension '" << unused.front() << "' specified for "
+            "'dimensions' option.";
+        throw pdal_error(oss.str());
+    }
 }
 
 
 point_count_t LasReader::read(PointViewPtr view, point_count_t count)
 {
+    if (m_filenames.size())
+        return readFiles(view, count);
+
     size_t pointByteCount = m_lasHeader.pointLen();
-    count = std::min(count, getNumPoints() - m_index);
+    count = std::min(count, pointsLeft());
+    view->reserve(count);
+
+    m_callback->setTotal(getNumPoints());
+    ProgressPoller poller(*m_callback);
+
+    if (m_selectIds)
+        return readPointIds(*view, count, poller);
+    if (!m_bounds.empty())
+        return readBounded(*view, count, poller);
+    if (m_stride > 1)
+        return readStrided(*view, count, poller);
 
     PointId i = 0;
-    if (m_zipPoint)
+    if (m_mapTable)
     {
-#ifdef PDAL_HAVE_LASZIP
-        for (i = 0; i < count; i++)
+        // The point data is already in the table.
+        PointId nextId = view->size();
+        view->appendTablePoints(count);
+        if (m_cb)
+            for (i = 0; i < count; ++i)
+                m_cb(*view, nextId + i);
+        i = count;
+    }
+    else if (m_lasHeader.compressed())
+    {
+        if (unzipParallel(*view, count))
         {
-            if (!m_unzipper->read(m_zipPoint->m_lz_point))
-            {
-                std::string error = "Error reading compressed point data: ";
-                const char* err = m_unzipper->get_error();
-                if (!err)
-                    err = "(unknown error)";
-                error += err;
-                throw pdal_error(error);
-            }
-            loadPoint(*view.get(), (char *)m_zipPoint->m_lz_point_data.data(),
+            readCompressedParallel(*view, count);
+            i = count;
+            poller.poll(m_index + i);
+        }
+        for (; i < count; i++)
+        {
+            poller.poll(m_index + i);
+            loadPoint(*view.get(), view->size(), readCompressedPoint(),
                 pointByteCount);
         }
-#else
-        throw pdal_error("LASzip is not enabled for this "
-            "LasReader::processBuffer");
-#endif
     }
     else
     {
-        m_istream->seekg(m_lasHeader.pointOffset());
+        m_istream->seekg(m_lasHeader.pointOffset() +
+            m_index * pointByteCount);
         point_count_t remaining = count;
 
-        // Make a buffer at most a meg.
+        // Make buffers at most a meg.  The next block is read on a worker
+        // while the current one is decoded, so reading from the file and
+        // decoding overlap.
         size_t bufsize = std::min<size_t>((point_count_t)1000000,
             count * pointByteCount);
         std::vector<char> buf(bufsize);
+        std::vector<char> next;
+        if (count * pointByteCount > bufsize)
+            next.resize(bufsize);
+
+        ThreadPool& pool = ThreadPool::shared();
+        std::future<void> pending;
+        point_count_t nextPoints = 0;
+        // The worker reads into 'next', so it must be done before we leave.
+        auto finish = [&pool, &pending]()
+        {
+            if (pending.valid())
+                pool.wait(pending);
+        };
         try
         {
-            do
+            point_count_t blockPoints = readFileBlock(buf, remaining);
+            while (blockPoints)
             {
-                point_count_t blockPoints = readFileBlock(buf, remaining);
                 remaining -= blockPoints;
-                char *pos = buf.data();
-                while (blockPoints--)
+                if (remaining)
+                    pending = pool.submit([this, &next, &nextPoints,
+                        remaining]()
+                        { nextPoints = readFileBlock(next, remaining); });
+                poller.poll(m_index + i);
+                loadBlock(*view.get(), buf.data(), blockPoints);
+                i += blockPoints;
+
+                blockPoints = 0;
+                if (pending.valid())
                 {
-                    loadPoint(*view.get(), pos, pointByteCount);
-                    pos += pointByteCount;
-                    i++;
+                    finish();
+                    buf.swap(next);
+                    blockPoints = nextPoints;
                 }
-            } while (remaining);
+            }
         }
         catch (std::out_of_range&)
-        {}
+        {
+            finish();
+        }
         catch (pdal::invalid_stream&)
-        {}
+        {
+            finish();
+        }
+        catch (...)
+        {
+            try
+            {
+                finish();
+            }
+            catch (...)
+            {}
+            throw;
+        }
     }
     m_index += i;
     return (point_count_t)i;
 }
 
 
+// Open the decompressor chosen by the "compression" option and move it to
+// the first point to read.
+void LasReader::readyCompression()
+{
+    if (m_lazPerf)
+    {
+#ifdef PDAL_HAVE_LAZPERF
+        VariableLengthRecord *vlr =
+            findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
+        if (!vlr)
+            throw pdal_error("Can't read LAZ data: no LASzip VLR.");
+        m_lazPerfDecompressor.reset(new LazPerfVlrDecompressor(*m_istream,
+            vlr->data(), (size_t)vlr->dataLen(), m_lasHeader.pointOffset()));
+        m_lazPerfPoint.resize(m_lasHeader.pointLen());
+        if (m_index && m_index < getNumPoints())
+            m_lazPerfDecompressor->seek(m_index);
+#else
+        throw pdal_error("Can't read LAZ data with lazperf.  "
+            "PDAL not built with laz-perf.");
+#endif
+        return;
+    }
+
+#ifdef PDAL_HAVE_LASZIP
+    VariableLengthRecord *vlr = findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
+    m_zipPoint.reset(new ZipPoint(vlr));
+
+    if (!m_unzipper)
+    {
+        m_unzipper.reset(new LASunzipper());
+
+        m_istream->seekg(m_lasHeader.pointOffset(), std::ios::beg);
+
+        // Once we open the zipper, don't touch the stream until the
+        // zipper is closed or bad things happen.
+        if (!m_unzipper->open(*m_istream, m_zipPoint->GetZipper()))
+        {
+            std::ostringstream oss;
+            const char* err = m_unzipper->get_error();
+            if (err == NULL)
+                err = "(unknown error)";
+            oss << "Failed to open LASzip stream: " << std::string(err);
+            throw pdal_error(oss.str());
+        }
+    }
+    if (m_index && m_index < getNumPoints() &&
+        !m_unzipper->seek((unsigned)m_index))
+        throwUnzipError(m_unzipper->get_error());
+#else
+    throw pdal_error("LASzip is not enabled.  Can't read LAZ data.");
+#endif
+}
+
+
+// Decompress the next point record.
+// \return  The record, which is valid until the next point is read.
+char *LasReader::readCompressedPoint()
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazPerfDecompressor)
+    {
+        m_lazPerfDecompressor->decompress(m_lazPerfPoint.data());
+        return m_lazPerfPoint.data();
+    }
+#endif
+#ifdef PDAL_HAVE_LASZIP
+    if (!m_unzipper->read(m_zipPoint->m_lz_point))
+        throwUnzipError(m_unzipper->get_error());
+    return (char *)m_zipPoint->m_lz_point_data.data();
+#else
+    return NULL;
+#endif
+}
+
+
+// Position the decompressor so that point 'idx' is read next.
+void LasReader::seekCompressed(point_count_t idx)
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazPerfDecompressor)
+    {
+        m_lazPerfDecompressor->seek(idx);
+        return;
+    }
+#endif
+#ifdef PDAL_HAVE_LASZIP
+    if (!m_unzipper->seek((unsigned)idx))
+        throwUnzipError(m_unzipper->get_error());
+#endif
+}
+
+
+// Number of points in each chunk of compressed data, or 0 if the data
+// isn't divided into chunks that can be found with a chunk table.
+point_count_t LasReader::chunkSize() const
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazPerfDecompressor)
+        return m_lazPerfDecompressor->chunkSize();
+#endif
+#ifdef PDAL_HAVE_LASZIP
+    if (m_zipPoint)
+    {
+        const uint32_t size = m_zipPoint->GetZipper()->chunk_size;
+        if (size != (std::numeric_limits<uint32_t>::max)())
+            return size;
+    }
+#endif
+    return 0;
+}
+
+
+void LasReader::throwUnzipError(const char *err)
+{
+    std::string error = "Error reading compressed point data: ";
+    if (!err)
+        err = "(unknown error)";
+    error += err;
+    throw pdal_error(error);
+}
+
+
+// Points can be decompressed on several threads when the file is divided
+// into fixed size chunks, since each chunk is coded on its own.
+bool LasReader::unzipParallel(PointView& view, point_count_t count)
+{
+    const point_count_t chunkSize = this->chunkSize();
+    if (chunkSize == 0)
+        return false;
+    return !m_cb && m_bounds.empty() && view.table().threadSafe() &&
+        count >= 2 * chunkSize && ThreadPool::shared().size() > 1;
+}
+
+
+// Decompress the next 'count' points into the view, a range of chunks on
+// each worker.  Every worker reads from its own stream and decompressor,
+// using the chunk table to seek to the first of its chunks, and sets the
+// fields of points that were added to the view beforehand.
+void LasReader::readCompressedParallel(PointView& view, point_count_t count)
+{
+    const point_count_t chunkSize = this->chunkSize();
+    const point_count_t begin = m_index;
+    const point_count_t end = m_index + count;
+    const point_count_t firstChunk = begin / chunkSize;
+    const point_count_t numChunks = (end - 1) / chunkSize - firstChunk + 1;
+    VariableLengthRecord *vlr = findVlr(LASZIP_USER_ID, LASZIP_RECORD_ID);
+
+    const PointId baseId = view.size();
+    view.appendTablePoints(count);
+
+    std::mutex streamMutex;
+    auto unzip = [&](size_t chunkBegin, size_t chunkEnd)
+    {
+        point_count_t first = (std::max)(begin,
+            (point_count_t)(firstChunk + chunkBegin) * chunkSize);
+        point_count_t last = (std::min)(end,
+            (point_count_t)(firstChunk + chunkEnd) * chunkSize);
+
+        std::istream *in;
+        {
+            std::lock_guard<std::mutex> lock(streamMutex);
+            in = &m_streamFactory->allocate();
+        }
+        try
+        {
+            unzipRange(*in, vlr, view, baseId + (first - begin), first, last);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(streamMutex);
+            m_streamFactory->deallocate(*in);
+            throw;
+        }
+        std::lock_guard<std::mutex> lock(streamMutex);
+        m_streamFactory->deallocate(*in);
+    };
+    ThreadPool::shared().parallelFor(numChunks, 1, unzip);
+
+    // Bring the reader's own decompressor up to the next unread point.
+    if (end < getNumPoints())
+        seekCompressed(end);
+}
+
+
+// Decompress the points [first, last) of the file into the view starting
+// at 'id'.
+void LasReader::unzipRange(std::istream& in, VariableLengthRecord *vlr,
+    PointView& view, PointId id, point_count_t first, point_count_t last)
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazPerf)
+    {
+        const point_count_t chunkSize = this->chunkSize();
+        const size_t pointByteCount = m_lasHeader.pointLen();
+        LazPerfVlrDecompressor decompressor(in, vlr->data(),
+            (size_t)vlr->dataLen(), m_lasHeader.pointOffset());
+        std::vector<char> point(pointByteCount);
+        decompressor.seek(first);
+        for (point_count_t pos = first; pos < last; ++pos, ++id)
+        {
+            if (pos % chunkSize == 0)
+                m_callback->checkInterrupt();
+            decompressor.decompress(point.data());
+            loadPoint(view, id, point.data(), pointByteCount);
+        }
+        return;
+    }
+#endif
+#ifdef PDAL_HAVE_LASZIP
+    const point_count_t chunkSize = this->chunkSize();
+    const size_t pointByteCount = m_lasHeader.pointLen();
+    ZipPoint zipPoint(vlr);
+    LASunzipper unzipper;
+    in.seekg(m_lasHeader.pointOffset(), std::ios::beg);
+    if (!unzipper.open(in, zipPoint.GetZipper()) ||
+        !unzipper.seek((unsigned)first))
+        throwUnzipError(unzipper.get_error());
+
+    for (point_count_t pos = first; pos < last; ++pos, ++id)
+    {
+        if (pos % chunkSize == 0)
+            m_callback->checkInterrupt();
+        if (!unzipper.read(zipPoint.m_lz_point))
+            throwUnzipError(unzipper.get_error());
+        loadPoint(view, id, (char *)zipPoint.m_lz_point_data.data(),
+            pointByteCount);
+    }
+    unzipper.close();
+#endif
+}
+
+
+// Find the ranges of points to read to get those inside the bounds.
+void LasReader::findIntervals()
+{
+    m_intervals.clear();
+    m_curInterval = 0;
+
+    std::string indexFile = LasIndex::filename(m_filename);
+    if (FileUtils::fileExists(indexFile))
+    {
+        std::istream *in = FileUtils::openFile(indexFile);
+        try
+        {
+            LasIndex index;
+            index.read(*in);
+            m_intervals = index.intervals(m_bounds);
+            for (auto& i : m_intervals)
+                i.second = (std::min)(i.second, getNumPoints());
+            log()->get(LogLevel::Debug) << "Reading " <<
+                m_intervals.size() << " ranges of points found in " <<
+                indexFile << std::endl;
+            FileUtils::closeFile(in);
+            return;
+        }
+        catch (pdal_error& err)
+        {
+            log()->get(LogLevel::Warning) << "Ignoring index " <<
+                indexFile << ": " << err.what() << std::endl;
+        }
+        FileUtils::closeFile(in);
+    }
+    m_intervals.push_back(LasIndex::Interval(0, getNumPoints()));
+}
+
+
+// Read up to 'count' points that are inside the bounds from the ranges
+// found by findIntervals().
+point_count_t LasReader::readBounded(PointView& view, point_count_t count,
+    ProgressPoller& poller)
+{
+    const LasHeader& h = m_lasHeader;
+    const size_t pointLen = h.pointLen();
+    const bool checkZ = !m_bounds.is_z_empty();
+
+    auto seek = [this, pointLen](point_count_t idx)
+    {
+        if (m_lasHeader.compressed())
+            seekCompressed(idx);
+        else
+            m_istream->seekg(m_lasHeader.pointOffset() + idx * pointLen);
+        m_index = idx;
+    };
+    // Add point 'idx', whose record is in 'buf', to the view if it's one
+    // of the stride and inside the bounds.
+    auto load = [&](point_count_t idx, char *buf) -> bool
+    {
+        if ((idx - m_start) % m_stride)
+            return false;
+        LeExtractor in(buf, pointLen);
+        int32_t xi, yi, zi;
+        in >> xi >> yi >> zi;
+        double x = xi * h.scaleX() + h.offsetX();
+        double y = yi * h.scaleY() + h.offsetY();
+        double z = zi * h.scaleZ() + h.offsetZ();
+        if (x < m_bounds.minx || x > m_bounds.maxx ||
+            y < m_bounds.miny || y > m_bounds.maxy ||
+            (checkZ && (z < m_bounds.minz || z > m_bounds.maxz)))
+            return false;
+        loadPoint(view, view.size(), buf, pointLen);
+        return true;
+    };
+
+    std::vector<char> buf(
+        h.compressed() ? pointLen : (1000000 / pointLen + 1) * pointLen);
+    bool positioned = false;
+    point_count_t added = 0;
+    while (added < count && m_curInterval < m_intervals.size())
+    {
+        const LasIndex::Interval& interval = m_intervals[m_curInterval];
+        if (m_index >= interval.second)
+        {
+            m_curInterval++;
+            continue;
+        }
+        if (!positioned || m_index < interval.first)
+            seek((std::max)(m_index, interval.first));
+        positioned = true;
+        poller.poll(m_index);
+
+        if (h.compressed())
+        {
+            memcpy(buf.data(), readCompressedPoint(), pointLen);
+            if (load(m_index++, buf.data()))
+                added++;
+        }
+        else
+        {
+            // Read a block, but no more than could be added.
+            point_count_t blockPoints = readFileBlock(buf,
+                (std::min)(interval.second - m_index, count - added));
+            char *pos = buf.data();
+            for (point_count_t i = 0; i < blockPoints; ++i, pos += pointLen)
+                if (load(m_index + i, pos))
+                    added++;
+            m_index += blockPoints;
+        }
+    }
+    return added;
+}
+
+
+// Read the next of the points set with setPointIds().  Uncompressed points
+// are read by seeking to each record.  Compressed points in the chunk being
+// decompressed are reached by decompressing those before them, and others
+// by seeking to their chunk with the chunk table.
+point_count_t LasReader::readPointIds(PointView& view, point_count_t count,
+    ProgressPoller& poller)
+{
+    const size_t pointLen = m_lasHeader.pointLen();
+    const point_count_t chunkSize =
+        m_lasHeader.compressed() ? this->chunkSize() : 0;
+    std::vector<char> buf(pointLen);
+
+    point_count_t added = 0;
+    for (; added < count && m_curId < m_pointIds.size(); ++added)
+    {
+        point_count_t idx = m_pointIds[m_curId++];
+        poller.poll(idx);
+        if (m_lasHeader.compressed())
+        {
+            // The indices ascend, so the decompressor only moves forward.
+            if (chunkSize && idx / chunkSize != m_index / chunkSize)
+            {
+                seekCompressed(idx);
+                m_index = idx;
+            }
+            for (; m_index < idx; ++m_index)
+                readCompressedPoint();
+            memcpy(buf.data(), readCompressedPoint(), pointLen);
+            m_index++;
+        }
+        else
+        {
+            m_istream->seekg(m_lasHeader.pointOffset() + idx * pointLen);
+            m_istream->read(buf.data(), pointLen);
+            if (!*m_istream)
+                break;
+        }
+        loadPoint(view, view.size(), buf.data(), pointLen);
+    }
+    return added;
+}
+
+
+// Read every m_stride'th point.  Uncompressed points that are close
+// together are read in blocks and picked out; those farther apart are read
+// one at a time.  Compressed points are skipped by decompressing them when
+// the next point is in the same chunk and by seeking to it otherwise.
+point_count_t LasReader::readStrided(PointView& view, point_count_t count,
+    ProgressPoller& poller)
+{
+    const size_t pointLen = m_lasHeader.pointLen();
+    point_count_t added = 0;
+
+    if (m_lasHeader.compressed())
+    {
+        const point_count_t chunkSize = this->chunkSize();
+        const bool chunked = chunkSize != 0;
+
+        // The decompressor is at m_index on entry and exit.
+        for (; added < count; ++added)
+        {
+            poller.poll(m_index);
+            loadPoint(view, view.size(), readCompressedPoint(), pointLen);
+
+            point_count_t pos = m_index + 1;
+            m_index += m_stride;
+            if (m_index >= getNumPoints())
+                continue;
+            // Without a chunk table, seeking would decompress from the
+            // start of the file.
+            if (!chunked || m_index / chunkSize == pos / chunkSize)
+            {
+                for (; pos < m_index; ++pos)
+                    readCompressedPoint();
+            }
+            else
+                seekCompressed(m_index);
+        }
+        return added;
+    }
+
+    // Read a block of records that takes in as many points of the stride
+    // as fit in about a meg, unless the points are far apart.
+    const point_count_t maxRecords =
+        (std::max)((size_t)1, (size_t)1000000 / pointLen);
+    const point_count_t perBlock = (m_stride * pointLen > 65536) ? 1 :
+        (std::max)((point_count_t)1, maxRecords / m_stride);
+    std::vector<char> buf(((perBlock - 1) * m_stride + 1) * pointLen);
+    while (added < count)
+    {
+        poller.poll(m_index);
+        point_count_t points = (std::min)(perBlock, count - added);
+        point_count_t records = (points - 1) * m_stride + 1;
+        m_istream->seekg(m_lasHeader.pointOffset() + m_index * pointLen);
+        m_istream->read(buf.data(), records * pointLen);
+        if (!*m_istream)
+            break;
+        for (point_count_t i = 0; i < points; ++i)
+            loadPoint(view, view.size(), buf.data() + i * m_stride * pointLen,
+                pointLen);
+        added += points;
+        m_index += points * m_stride;
+    }
+    return added;
+}
+
+
 point_count_t LasReader::readFileBlock(std::vector<char>& buf,
     point_count_t maxpoints)
 {
@@ -625,21 +1581,153 @@ point_count_t LasReader::readFileBlock(std::vector<char>& buf,
 }
 
 
-void LasReader::loadPoint(PointView& data, char *buf, size_t bufsize)
+// Decode a block of uncompressed point records a field at a time.  Each
+// field is pulled from every record in the block and set on the points with
+// one call, so dimensions are looked up once per block rather than once per
+// point and the conversion loops are simple enough for the compiler to
+// vectorize.
+void LasReader::loadBlock(PointView& data, const char *buf,
+    point_count_t count)
+{
+    using namespace Dimension;
+
+    const LasHeader& h = m_lasHeader;
+    const size_t len = h.pointLen();
+    const PointId begin = data.size();
+
+    std::vector<int32_t> ints(count);
+    std::vector<double> doubles(count);
+    std::vector<uint8_t> bytes(count);
+    std::vector<uint8_t> bits(count);
+    std::vector<uint16_t> shorts;
+
+    // Setting X adds the points to the view.
+    auto coord = [&](Id::Enum dim, size_t offset, double scale,
+        double shift)
+    {
+        extractColumn(buf, len, offset, count, ints.data());
+        for (point_count_t i = 0; i < count; ++i)
+            doubles[i] = ints[i] * scale + shift;
+        data.setFieldArray(dim, begin, count, doubles.data());
+    };
+    coord(Id::X, 0, h.scaleX(), h.offsetX());
+    coord(Id::Y, 4, h.scaleY(), h.offsetY());
+    coord(Id::Z, 8, h.scaleZ(), h.offsetZ());
+    setColumn(data, Id::Intensity, begin, buf, len, 12, count, shorts);
+
+    // Set a dimension from bits of the bytes last extracted.
+    auto bitColumn = [&](Id::Enum dim, int shift, uint8_t mask)
+    {
+        if (!data.hasDim(dim))
+            return;
+        for (point_count_t i = 0; i < count; ++i)
+            bits[i] = (bytes[i] >> shift) & mask;
+        data.setFieldArray(dim, begin, count, bits.data());
+    };
+
+    size_t pos;
+    if (h.has14Format())
+    {
+        extractColumn(buf, len, 14, count, bytes.data());
+        bitColumn(Id::ReturnNumber, 0, 0x0F);
+        bitColumn(Id::NumberOfReturns, 4, 0x0F);
+        extractColumn(buf, len, 15, count, bytes.data());
+        bitColumn(Id::ScanChannel, 4, 0x03);
+        bitColumn(Id::ScanDirectionFlag, 6, 0x01);
+        bitColumn(Id::EdgeOfFlightLine, 7, 0x01);
+        setColumn(data, Id::Classification, begin, buf, len, 16, count,
+            bytes);
+        setColumn(data, Id::UserData, begin, buf, len, 17, count, bytes);
+
+        if (data.hasDim(Id::ScanAngleRank))
+        {
+            std::vector<int16_t> angles(count);
+            extractColumn(buf, len, 18, count, angles.data());
+            for (point_count_t i = 0; i < count; ++i)
+                doubles[i] = angles[i] * .006;
+            data.setFieldArray(Id::ScanAngleRank, begin, count,
+                doubles.data());
+        }
+
+        setColumn(data, Id::PointSourceId, begin, buf, len, 20, count,
+            shorts);
+        setColumn(data, Id::GpsTime, begin, buf, len, 22, count, doubles);
+        pos = 30;
+    }
+    else
+    {
+        extractColumn(buf, len, 14, count, bytes.data());
+        for (point_count_t i = 0; i < count; ++i)
+        {
+            uint8_t returnNum = bytes[i] & 0x07;
+            uint8_t numReturns = (bytes[i] >> 3) & 0x07;
+            if (returnNum == 0 || returnNum > 5)
+                m_error.returnNumWarning(returnNum);
+            if (numReturns == 0 || numReturns > 5)
+                m_error.numReturnsWarning(numReturns);
+        }
+        bitColumn(Id::ReturnNumber, 0, 0x07);
+        bitColumn(Id::NumberOfReturns, 3, 0x07);
+        bitColumn(Id::ScanDirectionFlag, 6, 0x01);
+        bitColumn(Id::EdgeOfFlightLine, 7, 0x01);
+        setColumn(data, Id::Classification, begin, buf, len, 15, count,
+            bytes);
+
+        std::vector<int8_t> angles;
+        setColumn(data, Id::ScanAngleRank, begin, buf, len, 16, count,
+            angles);
+        setColumn(data, Id::UserData, begin, buf, len, 17, count, bytes);
+        setColumn(data, Id::PointSourceId, begin, buf, len, 18, count,
+            shorts);
+        pos = 20;
+        if (h.hasTime())
+        {
+            setColumn(data, Id::GpsTime, begin, buf, len, pos, count,
+                doubles);
+            pos += 8;
+        }
+    }
+
+    if (h.hasColor())
+    {
+        setColumn(data, Id::Red, begin, buf, len, pos, count, shorts);
+        setColumn(data, Id::Green, begin, buf, len, pos + 2, count, shorts);
+        setColumn(data, Id::Blue, begin, buf, len, pos + 4, count, shorts);
+        pos += 6;
+    }
+    if (h.hasInfrared())
+    {
+        setColumn(data, Id::Infrared, begin, buf, len, pos, count, shorts);
+        pos += 2;
+    }
+
+    if (m_extraDims.size())
+        for (point_count_t i = 0; i < count; ++i)
+        {
+            LeExtractor istream(buf + i * len + pos, len - pos);
+            loadExtraDims(istream, data, begin + i);
+        }
+    if (m_cb)
+        for (point_count_t i = 0; i < count; ++i)
+            m_cb(data, begin + i);
+}
+
+
+void LasReader::loadPoint(PointView& data, PointId nextId, char *buf,
+    size_t bufsize)
 {
     if (m_lasHeader.has14Format())
-        loadPointV14(data, buf, bufsize);
+        loadPointV14(data, nextId, buf, bufsize);
     else
-        loadPointV10(data, buf, bufsize);
+        loadPointV10(data, nextId, buf, bufsize);
 }
 
 
-void LasReader::loadPointV10(PointView& data, char *buf, size_t bufsize)
+void LasReader::loadPointV10(PointView& data, PointId nextId, char *buf,
+    size_t bufsize)
 {
     LeExtractor istream(buf, bufsize);
 
-    PointId nextId = data.size();
-
     int32_t xi, yi, zi;
     istream >> xi >> yi >> zi;
 
@@ -705,12 +1793,11 @@ void LasReader::loadPointV10(PointView& data, char *buf, size_t bufsize)
         m_cb(data, nextId);
 }
 
-void LasReader::loadPointV14(PointView& data, char *buf, size_t bufsize)
+void LasReader::loadPointV14(PointView& data, PointId nextId, char *buf,
+    size_t bufsize)
 {
     LeExtractor istream(buf, bufsize);
 
-    PointId nextId = data.size();
-
     int32_t xi, yi, zi;
     istream >> xi >> yi >> zi;
 
@@ -789,6 +1876,12 @@ void LasReader::loadExtraDims(LeExtractor& istream, PointView& data,
             istream.skip(dim.m_size);
             continue;
         }
+        // The dimension wasn't asked for.
+        if (dim.m_dimType.m_id == Dimension::Id::Unknown)
+        {
+            istream.skip(Dimension::size(dim.m_dimType.m_type));
+            continue;
+        }
 
         istream.get(dim.m_dimType.m_type, e);
 
@@ -805,14 +1898,47 @@ void LasReader::loadExtraDims(LeExtractor& istream, PointView& data,
 }
 
 
-void LasReader::done(PointTableRef)
+/// Read points from the files named by the "filenames" option, opening
+/// and readying each file when the one before it has been read.
+point_count_t LasReader::readFiles(PointViewPtr view, point_count_t count)
+{
+    point_count_t total = 0;
+    while (total < count && m_curFile < m_files.size())
+    {
+        LasReader& file = *m_files[m_curFile];
+        if (!file.m_istream)
+        {
+            file.m_istream = &file.m_streamFactory->allocate();
+            file.m_cb = m_cb;
+            file.m_callback = m_callback;
+            MetadataNode m = m_filesMetadata.addList("files");
+            file.ready(*m_table, m);
+        }
+        point_count_t read = file.read(view, count - total);
+        total += read;
+        if (read == 0 || file.eof())
+        {
+            file.done(*m_table);
+            m_curFile++;
+        }
+    }
+    return total;
+}
+
+
+void LasReader::done(PointTableRef table)
 {
+    for (auto& file : m_files)
+        if (file->m_istream)
+            file->done(table);
 #ifdef PDAL_HAVE_LASZIP
     m_zipPoint.reset();
     m_unzipper.reset();
 #endif
+    m_lazPerfDecompressor.reset();
     if (m_istream)
         m_streamFactory->deallocate(*m_istream);
+    m_istream = NULL;
 }
 
 } // namespace pdal
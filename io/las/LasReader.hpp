@@ -40,7 +40,9 @@
 
 #include "LasError.hpp"
 #include "LasHeader.hpp"
+#include "LasIndex.hpp"
 #include "LasUtils.hpp"
+#include "LazPerfVlrCompression.hpp"
 #include "ZipPoint.hpp"
 
 extern "C" int32_t LasReader_ExitFunc();
@@ -59,12 +61,17 @@ class PDAL_DLL LasReader : public pdal::Reader
     friend class NitfReader;
 public:
     LasReader() : pdal::Reader(), m_index(0),
-            m_istream(NULL)
+            m_istream(NULL), m_lazPerf(false), m_mapTable(NULL), m_compactXyz(false),
+            m_compactFlags(false),
+            m_curInterval(0), m_start(0), m_stride(1), m_selectIds(false),
+            m_curId(0), m_curFile(0), m_table(NULL), m_part(false)
         {}
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
 
     Options getDefaultOptions();
 
@@ -72,6 +79,9 @@ public:
         { return m_lasHeader; }
     point_count_t getNumPoints() const
         { return m_lasHeader.pointCount(); }
+    virtual bool setStride(point_count_t start, point_count_t stride);
+    virtual bool setBounds(const BOX3D& bounds);
+    virtual bool setPointIds(const std::vector<PointId>& ids);
 
 private:
     LasError m_error;
@@ -82,16 +92,67 @@ private:
     std::unique_ptr<LASunzipper> m_unzipper;
     point_count_t m_index;
     std::istream* m_istream;
+    // Decompress with laz-perf rather than LASzip.
+    bool m_lazPerf;
+    std::unique_ptr<LazPerfVlrDecompressor> m_lazPerfDecompressor;
+    // The last record decoded by the laz-perf decompressor.
+    std::vector<char> m_lazPerfPoint;
     VlrList m_vlrs;
+    // Where the data of each of m_vlrs is in the file.  EVLRs in particular
+    // can be huge, so a record's data is only read when the record is used.
+    struct VlrData
+    {
+        std::streampos m_pos;
+        uint64_t m_len;
+        bool m_read;
+    };
+    std::vector<VlrData> m_vlrData;
     std::vector<ExtraDim> m_extraDims;
+    MappedPointTable *m_mapTable;
+    bool m_compactXyz;
+    bool m_compactFlags;
+    BOX3D m_bounds;
+    // Ranges of points that may be inside m_bounds.
+    LasIndex::IntervalList m_intervals;
+    size_t m_curInterval;
+    point_count_t m_start;
+    point_count_t m_stride;
+    // Whether only the points m_pointIds are read, and the next of them.
+    bool m_selectIds;
+    std::vector<PointId> m_pointIds;
+    size_t m_curId;
+    // Names of the dimensions to read.  All are read if this is empty.
+    StringList m_dimNames;
+    // Files to read instead of 'filename', with glob patterns expanded.
+    StringList m_filenames;
+    // A reader for each of m_filenames that may hold points to read.  Each
+    // is prepared up front but keeps its file closed until it's read.
+    std::vector<std::unique_ptr<LasReader>> m_files;
+    size_t m_curFile;
+    // The table being read into, for readying each file in turn.
+    BasePointTable *m_table;
+    MetadataNode m_filesMetadata;
+    SpatialReference m_filesSrs;
+    // Whether this reads one of the files of another LasReader.
+    bool m_part;
 
     virtual StreamFactoryPtr createFactory() const
-        { return StreamFactoryPtr(new FilenameStreamFactory(m_filename)); }
+    {
+        if (RemoteStreamFactory::remote(m_filename))
+            return StreamFactoryPtr(new RemoteStreamFactory(m_filename));
+        return StreamFactoryPtr(new FilenameStreamFactory(m_filename));
+    }
+    // Offset of the LAS data in the file named by the "filename" option.
+    virtual uint64_t fileOffset() const
+        { return 0; }
     virtual void processOptions(const Options& options);
     virtual void initialize();
     virtual void addDimensions(PointLayoutPtr layout);
     void fixupVlrs();
     VariableLengthRecord *findVlr(const std::string& userId, uint16_t recordId);
+    template<typename VLR>
+    void readVlrHeaders(ILeStream& in, size_t count);
+    VariableLengthRecord& loadVlr(size_t i);
     void setSrsFromVlrs(MetadataNode& m);
     void readExtraBytesVlr();
     SpatialReference getSrsFromVlrs();
@@ -103,13 +164,51 @@ private:
     virtual void ready(PointTableRef table)
         { ready(table, m_metadata); }
     virtual void ready(PointTableRef table, MetadataNode& m);
+    bool mapPoints(MappedPointTable& table);
     virtual point_count_t read(PointViewPtr view, point_count_t count);
     virtual void done(PointTableRef table);
     virtual bool eof()
-        { return m_index >= getNumPoints(); }
-    void loadPoint(PointView& data, char *buf, size_t bufsize);
-    void loadPointV10(PointView& data, char *buf, size_t bufsize);
-    void loadPointV14(PointView& data, char *buf, size_t bufsize);
+    {
+        if (m_filenames.size())
+            return m_curFile >= m_files.size();
+        if (m_selectIds)
+            return m_curId >= m_pointIds.size();
+        return m_bounds.empty() ? m_index >= getNumPoints() :
+            m_curInterval >= m_intervals.size();
+    }
+    void initializeFiles();
+    point_count_t readFiles(PointViewPtr view, point_count_t count);
+    // Number of points left to read, ignoring any bounds.
+    point_count_t pointsLeft() const
+    {
+        if (m_selectIds)
+            return m_pointIds.size() - m_curId;
+        return m_index >= getNumPoints() ? 0 :
+            (getNumPoints() - m_index + m_stride - 1) / m_stride;
+    }
+    point_count_t readStrided(PointView& view, point_count_t count,
+        ProgressPoller& poller);
+    void findIntervals();
+    point_count_t readBounded(PointView& view, point_count_t count,
+        ProgressPoller& poller);
+    point_count_t readPointIds(PointView& view, point_count_t count,
+        ProgressPoller& poller);
+    void loadBlock(PointView& data, const char *buf, point_count_t count);
+    void loadPoint(PointView& data, PointId nextId, char *buf,
+        size_t bufsize);
+    void loadPointV10(PointView& data, PointId nextId, char *buf,
+        size_t bufsize);
+    void loadPointV14(PointView& data, PointId nextId, char *buf,
+        size_t bufsize);
+    void readyCompression();
+    char *readCompressedPoint();
+    void seekCompressed(point_count_t idx);
+    point_count_t chunkSize() const;
+    void throwUnzipError(const char *err);
+    bool unzipParallel(PointView& view, point_count_t count);
+    void readCompressedParallel(PointView& view, point_count_t count);
+    void unzipRange(std::istream& in, VariableLengthRecord *vlr,
+        PointView& view, PointId id, point_count_t first, point_count_t last);
     void loadExtraDims(LeExtractor& istream, PointView& data, PointId nextId);
     point_count_t readFileBlock(
             std::vector<char>& buf,
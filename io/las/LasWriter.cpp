@@ -38,7 +38,9 @@
 #include <iostream>
 
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/util/Inserter.hpp>
+#include <pdal/util/IStream.hpp>
 #include <pdal/util/OStream.hpp>
 #include <pdal/Utils.hpp>
 
@@ -50,13 +52,89 @@ namespace pdal
 
 static PluginInfo const s_info = PluginInfo(
     "writers.las",
-    "ASPRS LAS 1.0 - 1.4 writer. LASzip support is also \n" \
-        "available if enabled at compile-time. Note that LAZ \n" \
+    "ASPRS LAS 1.0 - 1.4 writer. LASzip and laz-perf support is \n" \
+        "also available if enabled at compile-time. Note that LAZ \n" \
         "does not provide LAS 1.4 support at this time.",
     "http://pdal.io/stages/writers.las.html" );
 
 CREATE_STATIC_PLUGIN(1, 0, LasWriter, Writer, s_info)
 
+namespace
+{
+
+// Store values as the little-endian field at 'offset' of 'count' records
+// that are 'pointLen' bytes long.
+template<typename T>
+void insertColumn(char *buf, size_t pointLen, size_t offset,
+    point_count_t count, const T *values)
+{
+    LeInserter out(buf, pointLen * count);
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        out.seek(i * pointLen + offset);
+        out << values[i];
+    }
+}
+
+
+template<typename T>
+void writeColumn(const PointView& view, Dimension::Id::Enum dim,
+    PointId begin, point_count_t count, char *buf, size_t pointLen,
+    size_t offset)
+{
+    std::vector<T> values(count);
+    view.getFieldArray(dim, begin, count, values.data());
+    insertColumn(buf, pointLen, offset, count, values.data());
+}
+
+
+// Copy a dimension of a range of points into a field of point records,
+// converting to the type of the field.
+void writeColumn(const PointView& view, Dimension::Id::Enum dim,
+    Dimension::Type::Enum type, PointId begin, point_count_t count,
+    char *buf, size_t pointLen, size_t offset)
+{
+    using namespace Dimension::Type;
+
+    switch (type)
+    {
+    case Unsigned8:
+        writeColumn<uint8_t>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case Unsigned16:
+        writeColumn<uint16_t>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case Unsigned32:
+        writeColumn<uint32_t>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case Unsigned64:
+        writeColumn<uint64_t>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case Signed8:
+        writeColumn<int8_t>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case Signed16:
+        writeColumn<int16_t>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case Signed32:
+        writeColumn<int32_t>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case Signed64:
+        writeColumn<int64_t>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case Float:
+        writeColumn<float>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case Double:
+        writeColumn<double>(view, dim, begin, count, buf, pointLen, offset);
+        break;
+    case None:
+        break;
+    }
+}
+
+} // unnamed namespace
+
 std::string LasWriter::getName() const { return s_info.name; }
 
 void LasWriter::construct()
@@ -66,6 +144,25 @@ void LasWriter::construct()
     m_zXform.m_scale = .01;
     m_numPointsWritten = 0;
     m_streamOffset = 0;
+    m_append = false;
+    m_lazPerf = false;
+    m_sharded = false;
+    m_shardPoints = 0;
+    m_shardBytes = 0;
+    m_shardCount = 0;
+    m_shardPointsWritten = 0;
+}
+
+
+LasWriter::~LasWriter()
+{
+    // Shards still being written refer to the writer.
+    try
+    {
+        waitShards();
+    }
+    catch (...)
+    {}
 }
 
 
@@ -78,6 +175,7 @@ void LasWriter::flush()
         m_zipPoint.reset();
     }
 #endif
+    m_lazPerfCompressor.reset();
     m_ostream->flush();
 }
 
@@ -87,7 +185,8 @@ Options LasWriter::getDefaultOptions()
     Options options;
 
     options.add("filename", "", "Name of the file for LAS/LAZ output.");
-    options.add("compression", false, "Do we LASzip-compress the data?");
+    options.add("compression", "false", "Compress the points: 'false', "
+        "'laszip', 'lazperf' or 'true' for the default engine.");
     options.add("format", 3, "Point format to write");
     options.add("major_version", 1, "LAS Major version");
     options.add("minor_version", 2, "LAS Minor version");
@@ -104,6 +203,13 @@ Options LasWriter::getDefaultOptions()
         "the file as necessary");
     options.add("extra_dims", "", "Extra dimensions not part of the LAS "
         "point format to be added to each point.");
+    options.add("append", false, "Add points to the end of an existing "
+        "uncompressed file with the same point format, scale and offset.");
+    options.add("shard_points", 0, "Write no more than this many points to "
+        "a file when the filename has a '#'.  0 means no limit.");
+    options.add("shard_bytes", 0, "Write no more than this many bytes of "
+        "point records, before compression, to a file when the filename "
+        "has a '#'.  0 means no limit.");
 
     return options;
 }
@@ -113,23 +219,72 @@ void LasWriter::processOptions(const Options& options)
 {
     if (options.hasOption("a_srs"))
         setSpatialReference(options.getValueOrDefault("a_srs", std::string()));
-    m_lasHeader.setCompressed(options.getValueOrDefault("compression", false));
+    setCompression(options.getValueOrDefault<std::string>("compression",
+        "false"));
     m_discardHighReturnNumbers = options.getValueOrDefault(
         "discard_high_return_numbers", false);
     StringList extraDims = options.getValueOrDefault<StringList>("extra_dims");
     m_extraDims = LasUtils::parse(extraDims);
+    m_append = options.getValueOrDefault("append", false);
+    m_shardPoints = options.getValueOrDefault<point_count_t>("shard_points",
+        0);
+    m_shardBytes = options.getValueOrDefault<uint64_t>("shard_bytes", 0);
+    m_sharded = !m_ostream && m_filename.find('#') != std::string::npos;
+    if ((m_shardPoints || m_shardBytes) && !m_sharded)
+        throw pdal_error("Options 'shard_points' and 'shard_bytes' require "
+            "a '#' in the filename.");
+    if (m_sharded && m_append)
+        throw pdal_error("Can't append to sharded output.");
 
-#ifndef PDAL_HAVE_LASZIP
-    if (m_lasHeader.compressed())
-        throw pdal_error("Can't write LAZ output.  "
-            "PDAL not built with LASzip.");
-#endif // PDAL_HAVE_LASZIP
     getHeaderOptions(options);
     getVlrOptions(options);
     m_error.setFilename(m_filename);
 }
 
 
+/// Choose the engine that compresses the points, if any.  "true" picks
+/// LASzip when PDAL was built with it and laz-perf otherwise.
+/// \param  compression - Value of the compression option.
+void LasWriter::setCompression(const std::string& compression)
+{
+    std::string engine = Utils::tolower(compression);
+    if (engine == "false" || engine == "none")
+    {
+        m_lasHeader.setCompressed(false);
+        return;
+    }
+    if (engine == "true")
+    {
+#ifdef PDAL_HAVE_LASZIP
+        engine = "laszip";
+#else
+        engine = "lazperf";
+#endif
+    }
+
+    if (engine == "laszip")
+    {
+#ifndef PDAL_HAVE_LASZIP
+        throw pdal_error("Can't write LAZ output.  "
+            "PDAL not built with LASzip.");
+#endif
+        m_lazPerf = false;
+    }
+    else if (engine == "lazperf")
+    {
+#ifndef PDAL_HAVE_LAZPERF
+        throw pdal_error("Can't write LAZ output with lazperf.  "
+            "PDAL not built with laz-perf.");
+#endif
+        m_lazPerf = true;
+    }
+    else
+        throw pdal_error("Invalid value '" + compression + "' for "
+            "'compression' option.  Use 'false', 'laszip' or 'lazperf'.");
+    m_lasHeader.setCompressed(true);
+}
+
+
 void LasWriter::prepared(PointTableRef table)
 {
     m_extraByteLen = 0;
@@ -175,9 +330,10 @@ void LasWriter::getHeaderOptions(const Options &options)
 
     std::time_t now;
     std::time(&now);
-    std::tm* ptm = std::gmtime(&now);
-    uint16_t year = ptm->tm_year + 1900;
-    uint16_t doy = ptm->tm_yday;
+    std::tm tm;
+    Utils::gmtime(now, tm);
+    uint16_t year = tm.tm_year + 1900;
+    uint16_t doy = tm.tm_yday;
 
     metaOptionValue("format", "3");
     metaOptionValue("minor_version", "2");
@@ -230,6 +386,38 @@ void LasWriter::ready(PointTableRef table)
     const SpatialReference& srs = getSpatialReference().empty() ?
         table.spatialRef() : getSpatialReference();
 
+    m_numPointsWritten = 0;
+    if (m_sharded)
+    {
+        // The files are written as the views arrive.
+        if (m_shardBytes)
+        {
+            m_lasHeader.setPointFormat((uint8_t)headerVal<unsigned>("format"));
+            point_count_t limit = (std::max)((uint64_t)1, m_shardBytes /
+                (m_lasHeader.basePointLen() + m_extraByteLen));
+            m_shardPoints = m_shardPoints ?
+                (std::min)(m_shardPoints, limit) : limit;
+        }
+        m_shardSrs = srs;
+        m_shardCount = 0;
+        m_shardPointsWritten = 0;
+        return;
+    }
+    readyFile(table.layout(), srs);
+}
+
+
+/// Open the output file and write all that precedes the points.
+/// \param  layout - Layout of the points to be written.
+/// \param  srs - Spatial reference of the points.
+void LasWriter::readyFile(PointLayoutPtr layout, const SpatialReference& srs)
+{
+    if (m_append && !m_ostream && FileUtils::fileExists(m_filename))
+    {
+        readyAppend();
+        planFields(layout);
+        return;
+    }
     if (!m_ostream)
         m_ostream = FileUtils::createFile(m_filename, true);
     setVlrsFromMetadata();
@@ -259,6 +447,110 @@ void LasWriter::ready(PointTableRef table)
     m_lasHeader.setPointOffset((uint32_t)m_ostream->tellp());
     if (m_lasHeader.compressed())
         openCompression();
+    planFields(layout);
+}
+
+
+/// Work out once where each field of a point record comes from, so that
+/// filling a record doesn't have to look for dimensions point by point.
+/// \param  layout - Layout of the points to be written.
+void LasWriter::planFields(PointLayoutPtr layout)
+{
+    using namespace Dimension;
+
+    m_fieldPlan.clear();
+    auto plan = [this, layout](Id::Enum dim, Type::Enum type, size_t offset)
+    {
+        if (layout->hasDim(dim))
+            m_fieldPlan.push_back({ dim, type, offset });
+    };
+
+    // X, Y and Z occupy the first twelve bytes and the return byte is the
+    // fifteenth.  Those are handled by fillWriteBuf() itself.
+    plan(Id::Intensity, Type::Unsigned16, 12);
+    plan(Id::Classification, Type::Unsigned8, 15);
+    plan(Id::ScanAngleRank, Type::Signed8, 16);
+    plan(Id::UserData, Type::Unsigned8, 17);
+    plan(Id::PointSourceId, Type::Unsigned16, 18);
+
+    size_t offset = 20;
+    if (m_lasHeader.hasTime())
+    {
+        plan(Id::GpsTime, Type::Double, offset);
+        offset += sizeof(double);
+    }
+    if (m_lasHeader.hasColor())
+    {
+        plan(Id::Red, Type::Unsigned16, offset);
+        plan(Id::Green, Type::Unsigned16, offset + 2);
+        plan(Id::Blue, Type::Unsigned16, offset + 4);
+        offset += 3 * sizeof(uint16_t);
+    }
+    for (auto& dim : m_extraDims)
+    {
+        Type::Enum type = dim.m_dimType.m_type;
+        if (type != Type::None)
+            m_fieldPlan.push_back({ dim.m_dimType.m_id, type, offset });
+        offset += Dimension::size(type);
+    }
+
+    m_hasReturnNumber = layout->hasDim(Id::ReturnNumber);
+    m_hasNumberOfReturns = layout->hasDim(Id::NumberOfReturns);
+    m_hasScanDirectionFlag = layout->hasDim(Id::ScanDirectionFlag);
+    m_hasEdgeOfFlightLine = layout->hasDim(Id::EdgeOfFlightLine);
+}
+
+
+/// Open an existing file to add points to its end.  Nothing before the
+/// end of the points is rewritten but the header, in done().
+void LasWriter::readyAppend()
+{
+    m_appendStream.reset(new std::fstream(m_filename,
+        std::ios::in | std::ios::out | std::ios::binary));
+    if (!*m_appendStream)
+        throw pdal_error("Couldn't open '" + m_filename + "' to append "
+            "points.");
+
+    LasHeader header;
+    ILeStream in(m_appendStream.get());
+    in >> header;
+
+    auto fail = [this](const std::string& reason)
+    {
+        m_appendStream.reset();
+        throw pdal_error("Can't append to '" + m_filename + "': " + reason);
+    };
+    if (!header.valid())
+        fail("not a LAS file.");
+    // LASzip has no way to add chunks to a finished stream.
+    if (header.compressed() || m_lasHeader.compressed())
+        fail("compressed files can't be appended to.");
+    if (header.eVlrCount())
+        fail("extended VLRs follow the points.");
+    if (header.pointFormat() != headerVal<unsigned>("format"))
+        fail("point format differs.");
+    if (header.pointLen() != header.basePointLen() + m_extraByteLen)
+        fail("extra bytes differ.");
+
+    // Points must be stored just like those already in the file.  Auto
+    // scales and offsets are taken from the file.
+    auto matchXform = [&fail](XForm& xform, double scale, double offset)
+    {
+        if (!xform.m_autoScale && xform.m_scale != scale)
+            fail("scale differs.");
+        if (!xform.m_autoOffset && xform.m_offset != offset)
+            fail("offset differs.");
+        xform = XForm(scale, offset);
+    };
+    matchXform(m_xXform, header.scaleX(), header.offsetX());
+    matchXform(m_yXform, header.scaleY(), header.offsetY());
+    matchXform(m_zXform, header.scaleZ(), header.offsetZ());
+
+    m_lasHeader = header;
+    m_summaryData.addHeader(header);
+    m_ostream = m_appendStream.get();
+    m_ostream->seekp(header.pointOffset() +
+        header.pointCount() * header.pointLen());
 }
 
 
@@ -464,15 +756,27 @@ void LasWriter::fillHeader()
 
 void LasWriter::readyCompression()
 {
+    std::vector<uint8_t> data;
+    if (m_lazPerf)
+    {
+#ifdef PDAL_HAVE_LAZPERF
+        m_lazPerfCompressor.reset(new LazPerfVlrCompressor(*m_ostream,
+            m_lasHeader.pointFormat(), m_lasHeader.pointLen()));
+        data = m_lazPerfCompressor->vlrData();
+#endif
+    }
+    else
+    {
 #ifdef PDAL_HAVE_LASZIP
-    m_zipPoint.reset(new ZipPoint(m_lasHeader.pointFormat(),
-        m_lasHeader.pointLen()));
-    m_zipper.reset(new LASzipper());
+        m_zipPoint.reset(new ZipPoint(m_lasHeader.pointFormat(),
+            m_lasHeader.pointLen()));
+        m_zipper.reset(new LASzipper());
+        data = m_zipPoint->vlrData();
+#endif
+    }
     // Note: this will make the VLR count in the header incorrect, but we
     // rewrite that bit in done() to fix it up.
-    std::vector<uint8_t> data = m_zipPoint->vlrData();
     addVlr(LASZIP_USER_ID, LASZIP_RECORD_ID, "http://laszip.org", data);
-#endif
 }
 
 
@@ -480,6 +784,9 @@ void LasWriter::readyCompression()
 /// \param  pointFormat - Formt of points we're writing.
 void LasWriter::openCompression()
 {
+    // The laz-perf compressor starts writing with the first point.
+    if (m_lazPerf)
+        return;
 #ifdef PDAL_HAVE_LASZIP
     if (!m_zipper->open(*m_ostream, m_zipPoint->GetZipper()))
     {
@@ -495,203 +802,393 @@ void LasWriter::openCompression()
 
 
 void LasWriter::write(const PointViewPtr view)
+{
+    if (m_sharded)
+        writeShards(view);
+    else
+        writePoints(view);
+}
+
+
+/// Get the name of a shard's file from the filename template.
+/// \param  shard - Number of the shard, starting from 1.
+std::string LasWriter::shardFilename(int shard) const
+{
+    std::string filename(m_filename);
+    filename.replace(filename.find('#'), 1, std::to_string(shard));
+    return filename;
+}
+
+
+/// Queue a view, split into parts of no more than m_shardPoints points, to
+/// be written to files of its own.  The parts are numbered in order here
+/// and written at once on the thread pool.  done() waits for them.
+void LasWriter::writeShards(const PointViewPtr view)
+{
+    ThreadPool& pool = ThreadPool::shared();
+    point_count_t size = view->size();
+    point_count_t limit = m_shardPoints ? m_shardPoints : size;
+    for (PointId begin = 0; begin < size; begin += limit)
+    {
+        PointViewPtr part =
+            view->makeSubset(begin, (std::min)(begin + limit, size));
+        std::string filename = shardFilename(++m_shardCount);
+        m_shardTasks.push_back(pool.submit([this, part, filename]()
+            { writeShard(part, filename); }));
+    }
+}
+
+
+/// Write points to a file with a writer configured like this one.  Only
+/// the configuration of this writer is read, so shards can be written from
+/// several threads at once.
+/// \param  view - Points to write.
+/// \param  filename - Name of the file.
+void LasWriter::writeShard(const PointViewPtr view,
+    const std::string& filename)
+{
+    LasWriter shard;
+    shard.m_filename = filename;
+    shard.m_error.setFilename(filename);
+    shard.m_metadata = m_metadata;
+    shard.m_lasHeader = m_lasHeader;
+    shard.m_lazPerf = m_lazPerf;
+    shard.m_discardHighReturnNumbers = m_discardHighReturnNumbers;
+    shard.m_headerVals = m_headerVals;
+    shard.m_optionInfos = m_optionInfos;
+    shard.m_extraDims = m_extraDims;
+    shard.m_extraByteLen = m_extraByteLen;
+    shard.m_xXform = m_xXform;
+    shard.m_yXform = m_yXform;
+    shard.m_zXform = m_zXform;
+
+    try
+    {
+        shard.readyFile(view->layout(), m_shardSrs);
+        shard.writePoints(view);
+        shard.finishFile();
+    }
+    catch (...)
+    {
+        FileUtils::closeFile(shard.m_ostream);
+        throw;
+    }
+    FileUtils::closeFile(shard.m_ostream);
+    m_shardPointsWritten += shard.m_numPointsWritten;
+}
+
+
+/// Wait for the shards to be written.  Every task has to finish before an
+/// error is passed on since the tasks refer to this writer.
+void LasWriter::waitShards()
+{
+    ThreadPool& pool = ThreadPool::shared();
+    std::exception_ptr error;
+    for (auto& task : m_shardTasks)
+    {
+        try
+        {
+            pool.wait(task);
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    m_shardTasks.clear();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+void LasWriter::writePoints(const PointViewPtr view)
 {
     setAutoOffset(view);
 
     size_t pointLen = m_lasHeader.pointLen();
 
+    const PointView& viewRef(*view.get());
+
+    m_callback->setTotal(m_numPointsWritten + view->size());
+    ProgressPoller poller(*m_callback);
+
+    if (m_lasHeader.compressed())
+    {
+        m_numPointsWritten += writeCompressed(viewRef, poller);
+        return;
+    }
+
     // Make a buffer of at most a meg.
     std::vector<char> buf(std::min((size_t)1000000, pointLen * view->size()));
 
-    const PointView& viewRef(*view.get());
-
-    //ABELL - Removed callback handling for now.
     point_count_t remaining = view->size();
     PointId idx = 0;
     while (remaining)
     {
-        point_count_t filled = fillWriteBuf(viewRef, idx, buf);
+        poller.poll(m_numPointsWritten + idx);
+        point_count_t records;
+        point_count_t filled = fillWriteBuf(viewRef, idx, buf, records,
+            m_summaryData);
         idx += filled;
         remaining -= filled;
+        m_ostream->write(buf.data(), records * pointLen);
+        m_numPointsWritten += records;
+    }
+}
 
-#ifdef PDAL_HAVE_LASZIP
-        if (m_lasHeader.compressed())
-        {
-            char *pos = buf.data();
-            for (point_count_t i = 0; i < filled; i++)
+
+// Only the compression has to happen in order through the one compressor,
+// so the next block of points is packed into LAS records on the thread
+// pool while the current block is compressed.
+point_count_t LasWriter::writeCompressed(const PointView& view,
+    ProgressPoller& poller)
+{
+    size_t pointLen = m_lasHeader.pointLen();
+    size_t bufSize = std::min((size_t)1000000, pointLen * view.size());
+    std::vector<char> bufs[2] = { std::vector<char>(bufSize),
+        std::vector<char>(bufSize) };
+    ThreadPool& pool = ThreadPool::shared();
+
+    int current = 0;
+    PointId idx = 0;
+    point_count_t written = 0;
+    point_count_t records;
+    point_count_t filled = fillWriteBuf(view, idx, bufs[current], records,
+        m_summaryData);
+    while (filled)
+    {
+        poller.poll(m_numPointsWritten + idx);
+
+        PointId nextIdx = idx + filled;
+        point_count_t nextFilled = 0;
+        point_count_t nextRecords = 0;
+        // The packing task summarizes its points separately so that it
+        // shares nothing with this thread.
+        SummaryData nextSummary;
+        std::vector<char>& nextBuf = bufs[1 - current];
+        std::future<void> next;
+        if (nextIdx < view.size())
+            next = pool.submit([this, &view, &nextBuf, &nextFilled,
+                &nextRecords, &nextSummary, nextIdx]()
             {
-                memcpy(m_zipPoint->m_lz_point_data.data(), pos, pointLen);
-                if (!m_zipper->write(m_zipPoint->m_lz_point))
-                {
-                    std::ostringstream oss;
-                    const char* err = m_zipper->get_error();
-                    if (err == NULL)
-                        err = "(unknown error)";
-                    oss << "Error writing point: " << std::string(err);
-                    throw pdal_error(oss.str());
-                }
-                pos += pointLen;
-            }
+                nextFilled = fillWriteBuf(view, nextIdx, nextBuf,
+                    nextRecords, nextSummary);
+            });
+
+        try
+        {
+            compressBuf(bufs[current], records);
+            written += records;
         }
-        else
-            m_ostream->write(buf.data(), filled * pointLen);
-#else
-        m_ostream->write(buf.data(), filled * pointLen);
-#endif
+        catch (...)
+        {
+            // The packing task refers to this frame.
+            if (next.valid())
+                next.wait();
+            throw;
+        }
+        if (next.valid())
+        {
+            pool.wait(next);
+            m_summaryData.merge(nextSummary);
+        }
+
+        idx = nextIdx;
+        filled = nextFilled;
+        records = nextRecords;
+        current = 1 - current;
     }
+    return written;
+}
+
 
-    m_numPointsWritten = view->size() - remaining;
+void LasWriter::compressBuf(const std::vector<char>& buf,
+    point_count_t count)
+{
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazPerfCompressor)
+    {
+        size_t pointLen = m_lasHeader.pointLen();
+        const char *pos = buf.data();
+        for (point_count_t i = 0; i < count; i++, pos += pointLen)
+            m_lazPerfCompressor->compress(pos);
+        return;
+    }
+#endif
+#ifdef PDAL_HAVE_LASZIP
+    size_t pointLen = m_lasHeader.pointLen();
+    const char *pos = buf.data();
+    for (point_count_t i = 0; i < count; i++)
+    {
+        memcpy(m_zipPoint->m_lz_point_data.data(), pos, pointLen);
+        if (!m_zipper->write(m_zipPoint->m_lz_point))
+        {
+            std::ostringstream oss;
+            const char* err = m_zipper->get_error();
+            if (err == NULL)
+                err = "(unknown error)";
+            oss << "Error writing point: " << std::string(err);
+            throw pdal_error(oss.str());
+        }
+        pos += pointLen;
+    }
+#endif
 }
 
+/// Pack a block of points into LAS point records.
+/// \param  view - Points to write.
+/// \param  startId - Index of the first point of the block.
+/// \param  buf - Buffer to fill with records.
+/// \param  records - Set to the number of records placed in the buffer,
+///    which is less than the number of points when points with high return
+///    numbers are discarded.
+/// \param  summary - Summary to which the written points are added.  The
+///    block touches no other state of the writer but warnings, so blocks
+///    can be filled on other threads with summaries merged afterward.
+/// \return  Number of points consumed from the view.
 point_count_t LasWriter::fillWriteBuf(const PointView& view,
-    PointId startId, std::vector<char>& buf)
+    PointId startId, std::vector<char>& buf, point_count_t& records,
+    SummaryData& summary)
 {
-    point_count_t blocksize = buf.size() / m_lasHeader.pointLen();
-    blocksize = std::min(blocksize, view.size() - startId);
+    using namespace Dimension;
 
-    bool hasColor = m_lasHeader.hasColor();
-    bool hasTime = m_lasHeader.hasTime();
-    PointId lastId = startId + blocksize;
-    static const size_t maxReturnCount = m_lasHeader.maxReturnCount();
-    LeInserter ostream(buf.data(), buf.size());
-    for (PointId idx = startId; idx < lastId; idx++)
+    const size_t pointLen = m_lasHeader.pointLen();
+    point_count_t blocksize = buf.size() / pointLen;
+    blocksize = std::min(blocksize, view.size() - startId);
+    const size_t maxReturnCount = m_lasHeader.maxReturnCount();
+
+    // Fields without a source dimension are zero.
+    std::fill(buf.begin(), buf.begin() + blocksize * pointLen, 0);
+
+    std::vector<double> x(blocksize);
+    std::vector<double> y(blocksize);
+    std::vector<double> z(blocksize);
+    view.getFieldArray(Id::X, startId, blocksize, x.data());
+    view.getFieldArray(Id::Y, startId, blocksize, y.data());
+    view.getFieldArray(Id::Z, startId, blocksize, z.data());
+
+    // Coordinates that are already stored with the output's scale and
+    // offset are written without being requantized.
+    std::vector<int32_t> ints(blocksize);
+    auto coord = [&](Id::Enum dim, const std::vector<double>& d,
+        const XForm& xform, size_t offset)
     {
-        // we always write the base fields
-        using namespace Dimension;
-
-        uint8_t returnNumber(1);
-        uint8_t numberOfReturns(1);
-        if (view.hasDim(Id::ReturnNumber))
+        const Detail *dd = view.layout()->dimDetail(dim);
+        if (dd->scaled() && dd->type() == Type::Signed32 &&
+            dd->xform().m_scale == xform.m_scale &&
+            dd->xform().m_offset == xform.m_offset)
+        {
+            for (point_count_t i = 0; i < blocksize; ++i)
+                view.getRawField(dim, startId + i, &ints[i]);
+        }
+        else
         {
-            returnNumber = view.getFieldAs<uint8_t>(Id::ReturnNumber,
-                idx);
-            if (returnNumber < 1 || returnNumber > maxReturnCount)
-                m_error.returnNumWarning(returnNumber);
+            for (point_count_t i = 0; i < blocksize; ++i)
+                ints[i] = boost::numeric_cast<int32_t>(
+                    lround((d[i] - xform.m_offset) / xform.m_scale));
         }
-        if (view.hasDim(Id::NumberOfReturns))
-            numberOfReturns = view.getFieldAs<uint8_t>(
-                Id::NumberOfReturns, idx);
-        if (numberOfReturns == 0)
+        insertColumn(buf.data(), pointLen, offset, blocksize, ints.data());
+    };
+    coord(Id::X, x, m_xXform, 0);
+    coord(Id::Y, y, m_yXform, 4);
+    coord(Id::Z, z, m_zXform, 8);
+
+    for (const FieldPlan& f : m_fieldPlan)
+        writeColumn(view, f.m_dim, f.m_type, startId, blocksize,
+            buf.data(), pointLen, f.m_offset);
+
+    std::vector<uint8_t> returnNumber(blocksize, 1);
+    std::vector<uint8_t> numberOfReturns(blocksize, 1);
+    std::vector<uint8_t> scanDirectionFlag(blocksize, 0);
+    std::vector<uint8_t> edgeOfFlightLine(blocksize, 0);
+    if (m_hasReturnNumber)
+        view.getFieldArray(Id::ReturnNumber, startId, blocksize,
+            returnNumber.data());
+    if (m_hasNumberOfReturns)
+        view.getFieldArray(Id::NumberOfReturns, startId, blocksize,
+            numberOfReturns.data());
+    if (m_hasScanDirectionFlag)
+        view.getFieldArray(Id::ScanDirectionFlag, startId, blocksize,
+            scanDirectionFlag.data());
+    if (m_hasEdgeOfFlightLine)
+        view.getFieldArray(Id::EdgeOfFlightLine, startId, blocksize,
+            edgeOfFlightLine.data());
+
+    // Pack the return byte and drop the records of discarded points by
+    // moving those that are kept down over them.
+    records = 0;
+    char *pos = buf.data();
+    for (point_count_t i = 0; i < blocksize; ++i)
+    {
+        uint8_t& numReturns = numberOfReturns[i];
+        if (m_hasReturnNumber &&
+            (returnNumber[i] < 1 || returnNumber[i] > maxReturnCount))
+            m_error.returnNumWarning(returnNumber[i]);
+        if (numReturns == 0)
             m_error.numReturnsWarning(0);
-        if (numberOfReturns > maxReturnCount)
+        if (numReturns > maxReturnCount)
         {
             if (m_discardHighReturnNumbers)
             {
                 // If this return number is too high, pitch the point.
-                if (returnNumber > maxReturnCount)
+                if (returnNumber[i] > maxReturnCount)
                     continue;
-                numberOfReturns = maxReturnCount;
+                numReturns = maxReturnCount;
             }
             else
-                m_error.numReturnsWarning(numberOfReturns);
-        }
-
-        double xOrig = view.getFieldAs<double>(Id::X, idx);
-        double yOrig = view.getFieldAs<double>(Id::Y, idx);
-        double zOrig = view.getFieldAs<double>(Id::Z, idx);
-
-        double x = (xOrig - m_xXform.m_offset) / m_xXform.m_scale;
-        double y = (yOrig - m_yXform.m_offset) / m_yXform.m_scale;
-        double z = (zOrig - m_zXform.m_offset) / m_zXform.m_scale;
-
-        ostream << boost::numeric_cast<int32_t>(lround(x));
-        ostream << boost::numeric_cast<int32_t>(lround(y));
-        ostream << boost::numeric_cast<int32_t>(lround(z));
-
-        uint16_t intensity = 0;
-        if (view.hasDim(Id::Intensity))
-            intensity = view.getFieldAs<uint16_t>(Id::Intensity, idx);
-        ostream << intensity;
-
-        uint8_t scanDirectionFlag(0);
-        if (view.hasDim(Id::ScanDirectionFlag))
-            scanDirectionFlag = view.getFieldAs<uint8_t>(
-                Id::ScanDirectionFlag, idx);
-
-        uint8_t edgeOfFlightLine(0);
-        if (view.hasDim(Id::EdgeOfFlightLine))
-            edgeOfFlightLine = view.getFieldAs<uint8_t>(
-                Id::EdgeOfFlightLine, idx);
-
-        uint8_t bits = returnNumber | (numberOfReturns<<3) |
-            (scanDirectionFlag << 6) | (edgeOfFlightLine << 7);
-        ostream << bits;
-
-        uint8_t classification = 0;
-        if (view.hasDim(Id::Classification))
-            classification = view.getFieldAs<uint8_t>(Id::Classification,
-                idx);
-        ostream << classification;
-
-        int8_t scanAngleRank = 0;
-        if (view.hasDim(Id::ScanAngleRank))
-            scanAngleRank = view.getFieldAs<int8_t>(Id::ScanAngleRank,
-                idx);
-        ostream << scanAngleRank;
-
-        uint8_t userData = 0;
-        if (view.hasDim(Id::UserData))
-            userData = view.getFieldAs<uint8_t>(Id::UserData, idx);
-        ostream << userData;
-
-        uint16_t pointSourceId = 0;
-        if (view.hasDim(Id::PointSourceId))
-            pointSourceId = view.getFieldAs<uint16_t>(Id::PointSourceId,
-                idx);
-        ostream << pointSourceId;
-
-        if (hasTime)
-        {
-            double t = 0.0;
-            if (view.hasDim(Id::GpsTime))
-                t = view.getFieldAs<double>(Id::GpsTime, idx);
-            ostream << t;
-        }
-
-        if (hasColor)
-        {
-            uint16_t red = 0;
-            uint16_t green = 0;
-            uint16_t blue = 0;
-            if (view.hasDim(Id::Red))
-                red = view.getFieldAs<uint16_t>(Id::Red, idx);
-            if (view.hasDim(Id::Green))
-                green = view.getFieldAs<uint16_t>(Id::Green, idx);
-            if (view.hasDim(Id::Blue))
-                blue = view.getFieldAs<uint16_t>(Id::Blue, idx);
-
-            ostream << red << green << blue;
+                m_error.numReturnsWarning(numReturns);
         }
 
-        Everything e;
-        for (auto& dim : m_extraDims)
-        {
-            view.getField((char *)&e, dim.m_dimType.m_id,
-                dim.m_dimType.m_type, idx);
-            ostream.put(dim.m_dimType.m_type, e);
-        }
+        char *record = buf.data() + i * pointLen;
+        if (record != pos)
+            memmove(pos, record, pointLen);
+        pos[14] = returnNumber[i] | (numReturns << 3) |
+            (scanDirectionFlag[i] << 6) | (edgeOfFlightLine[i] << 7);
+        pos += pointLen;
+        records++;
 
-        using namespace Dimension;
-        m_summaryData.addPoint(xOrig, yOrig, zOrig, returnNumber);
+        summary.addPoint(x[i], y[i], z[i], returnNumber[i]);
     }
     return blocksize;
 }
 
 void LasWriter::done(PointTableRef table)
+{
+    if (m_sharded)
+    {
+        waitShards();
+        log()->get(LogLevel::Debug) << "Wrote " <<
+            m_shardPointsWritten.load() << " points to " << m_shardCount <<
+            " LAS files" << std::endl;
+        return;
+    }
+    finishFile();
+    log()->get(LogLevel::Debug) << "Wrote " << m_numPointsWritten <<
+        " points to the LAS file" << std::endl;
+}
+
+
+/// Write all that follows the points and update the header.
+void LasWriter::finishFile()
 {
     //ABELL - The zipper has to be closed right after all the points
     // are written or bad things happen since this call expects the
     // stream to be positioned at a particular position.
+#ifdef PDAL_HAVE_LAZPERF
+    if (m_lazPerfCompressor)
+        m_lazPerfCompressor->done();
+#endif
 #ifdef PDAL_HAVE_LASZIP
-    if (m_lasHeader.compressed())
+    if (m_zipper)
         m_zipper->close();
 #endif
 
-    log()->get(LogLevel::Debug) << "Wrote " << m_numPointsWritten <<
-        " points to the LAS file" << std::endl;
-
     OLeStream out(m_ostream);
 
+    // The EVLRs follow the points.
+    if (m_eVlrs.size())
+        m_lasHeader.setEVlrOffset((uint64_t)m_ostream->tellp());
     for (auto vi = m_eVlrs.begin(); vi != m_eVlrs.end(); ++vi)
     {
         ExtVariableLengthRecord evlr = *vi;
@@ -705,12 +1202,20 @@ void LasWriter::done(PointTableRef table)
     m_lasHeader.setPointCount(m_numPointsWritten);
     // The summary is calculated as points are written.
     m_lasHeader.setSummary(m_summaryData);
-    // VLR count may change as LAS records are written.
-    m_lasHeader.setVlrCount(m_vlrs.size());
+    // VLR count may change as LAS records are written.  An appended file
+    // keeps the VLRs it had.
+    if (!m_appendStream)
+        m_lasHeader.setVlrCount(m_vlrs.size());
 
     out.seek(m_streamOffset);
     out << m_lasHeader;
     out.seek(m_lasHeader.pointOffset());
+
+    if (m_appendStream)
+    {
+        m_appendStream.reset();
+        m_ostream = NULL;
+    }
 }
 
 } // namespace pdal
@@ -36,9 +36,14 @@
 
 #include <pdal/Writer.hpp>
 
+#include <atomic>
+#include <fstream>
+#include <future>
+
 #include "LasError.hpp"
 #include "LasHeader.hpp"
 #include "LasUtils.hpp"
+#include "LazPerfVlrCompression.hpp"
 #include "SummaryData.hpp"
 #include "ZipPoint.hpp"
 
@@ -68,11 +73,20 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    // Auto offsets are computed from the points of each write, so they
+    // would differ from chunk to chunk.  A file is written for each view
+    // when sharding.
+    virtual bool streamable() const
+    {
+        return !m_xXform.m_autoOffset && !m_yXform.m_autoOffset &&
+            !m_zXform.m_autoOffset && !m_sharded;
+    }
 
     LasWriter() : m_ostream(NULL)
          { construct(); }
     LasWriter(std::ostream *stream) : m_ostream(stream)
         { construct(); }
+    ~LasWriter();
 
     Options getDefaultOptions();
 
@@ -85,6 +99,9 @@ private:
     SummaryData m_summaryData;
     std::unique_ptr<LASzipper> m_zipper;
     std::unique_ptr<ZipPoint> m_zipPoint;
+    // Compress with laz-perf rather than LASzip.
+    bool m_lazPerf;
+    std::unique_ptr<LazPerfVlrCompressor> m_lazPerfCompressor;
     bool m_discardHighReturnNumbers;
     std::map<std::string, std::string> m_headerVals;
     std::vector<VlrOptionInfo> m_optionInfos;
@@ -94,6 +111,35 @@ private:
     std::vector<ExtVariableLengthRecord> m_eVlrs;
     std::vector<ExtraDim> m_extraDims;
     uint16_t m_extraByteLen;
+    bool m_append;
+    // The existing file that points are being added to, if appending.
+    std::unique_ptr<std::fstream> m_appendStream;
+
+    // A field of the point record that is copied from a dimension of the
+    // same name.  Fields whose dimension isn't in the layout are left zero.
+    struct FieldPlan
+    {
+        Dimension::Id::Enum m_dim;
+        Dimension::Type::Enum m_type;
+        size_t m_offset;
+    };
+    std::vector<FieldPlan> m_fieldPlan;
+    // Which of the dimensions packed into the return byte are present.
+    bool m_hasReturnNumber;
+    bool m_hasNumberOfReturns;
+    bool m_hasScanDirectionFlag;
+    bool m_hasEdgeOfFlightLine;
+
+    // When the filename has a '#', each view, or each part of a view of
+    // no more than m_shardPoints points, is written to a file of its own
+    // on the thread pool.  The '#' is replaced by the number of the file.
+    bool m_sharded;
+    point_count_t m_shardPoints;
+    uint64_t m_shardBytes;
+    int m_shardCount;
+    SpatialReference m_shardSrs;
+    std::vector<std::future<void>> m_shardTasks;
+    std::atomic<point_count_t> m_shardPointsWritten;
 
     virtual void processOptions(const Options& options);
     virtual void prepared(PointTableRef table);
@@ -102,13 +148,23 @@ private:
     virtual void done(PointTableRef table);
 
     void construct();
+    void readyFile(PointLayoutPtr layout, const SpatialReference& srs);
+    void writePoints(const PointViewPtr view);
+    void finishFile();
+    std::string shardFilename(int shard) const;
+    void writeShards(const PointViewPtr view);
+    void writeShard(const PointViewPtr view, const std::string& filename);
+    void waitShards();
     void getHeaderOptions(const Options& options);
     void getVlrOptions(const Options& opts);
     template<typename T>
     T headerVal(const std::string& name);
     void fillHeader();
+    void readyAppend();
+    void planFields(PointLayoutPtr layout);
     point_count_t fillWriteBuf(const PointView& view, PointId startId,
-        std::vector<char>& buf);
+        std::vector<char>& buf, point_count_t& records,
+        SummaryData& summary);
     void setVlrsFromMetadata();
     MetadataNode findVlrMetadata(MetadataNode node, uint16_t recordId,
         const std::string& userId);
@@ -116,6 +172,10 @@ private:
     void setVlrsFromSpatialRef(const SpatialReference& srs);
     void readyCompression();
     void openCompression();
+    void setCompression(const std::string& compression);
+    point_count_t writeCompressed(const PointView& view,
+        ProgressPoller& poller);
+    void compressBuf(const std::vector<char>& buf, point_count_t count);
     void addVlr(const std::string& userId, uint16_t recordId,
         const std::string& description, std::vector<uint8_t>& data);
     bool addGeotiffVlr(GeotiffSupport& geotiff, uint16_t recordId,
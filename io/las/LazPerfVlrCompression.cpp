@@ -0,0 +1,455 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <limits>
+#include <sstream>
+
+#include <pdal/pdal_internal.hpp>
+
+#ifdef PDAL_HAVE_LAZPERF
+
+#include <pdal/Compression.hpp>
+#include <pdal/util/Extractor.hpp>
+#include <pdal/util/IStream.hpp>
+#include <pdal/util/Inserter.hpp>
+#include <pdal/util/OStream.hpp>
+
+#include "LazPerfVlrCompression.hpp"
+
+namespace pdal
+{
+
+namespace
+{
+
+// Values from the LASzip VLR.
+const uint16_t PointwiseChunked = 2;
+const uint16_t ItemPoint10 = 6;
+const uint16_t ItemGpstime11 = 7;
+const uint16_t ItemRgb12 = 8;
+const uint32_t DefaultChunkSize = 50000;
+
+bool hasTime(uint8_t format)
+{
+    return format == 1 || format == 3;
+}
+
+bool hasColor(uint8_t format)
+{
+    return format == 2 || format == 3;
+}
+
+uint16_t baseLen(uint8_t format)
+{
+    return 20 + (hasTime(format) ? 8 : 0) + (hasColor(format) ? 6 : 0);
+}
+
+// Adapters that give laz-perf's coders byte access to a standard stream.
+class LazPerfOutStream
+{
+public:
+    LazPerfOutStream(std::ostream& out) : m_out(out)
+    {}
+
+    void putBytes(const unsigned char *b, size_t len)
+        { m_out.write((const char *)b, len); }
+    void putByte(const unsigned char b)
+        { m_out.put((char)b); }
+
+private:
+    std::ostream& m_out;
+};
+
+class LazPerfInStream
+{
+public:
+    LazPerfInStream(std::istream& in) : m_in(in)
+    {}
+
+    unsigned char getByte()
+        { return (unsigned char)m_in.get(); }
+    void getBytes(unsigned char *b, int len)
+        { m_in.read((char *)b, len); }
+
+private:
+    std::istream& m_in;
+};
+
+} // anonymous namespace
+
+
+class LazPerfVlrCompressorImpl
+{
+    typedef laszip::encoders::arithmetic<LazPerfOutStream> Encoder;
+    typedef laszip::formats::dynamic_field_compressor<Encoder>::ptr
+        Compressor;
+
+public:
+    LazPerfVlrCompressorImpl(std::ostream& out, uint8_t format,
+            uint16_t pointLen) :
+        m_out(out), m_stream(out), m_format(format), m_chunkPoints(0),
+        m_chunkTablePos(0), m_chunkStart(0)
+    {
+        if (format > 3 || pointLen != baseLen(format))
+        {
+            std::ostringstream oss;
+            oss << "lazperf compression supports point formats 0 - 3 "
+                "without extra bytes, not format " << (int)format <<
+                " with " << pointLen << " byte records.";
+            throw pdal_error(oss.str());
+        }
+    }
+
+    std::vector<uint8_t> vlrData() const
+    {
+        const uint16_t numItems =
+            1 + (hasTime(m_format) ? 1 : 0) + (hasColor(m_format) ? 1 : 0);
+        std::vector<uint8_t> data(34 + 6 * numItems);
+        LeInserter out(data.data(), data.size());
+
+        out << PointwiseChunked << (uint16_t)0;  // compressor, coder
+        out << (uint8_t)2 << (uint8_t)2 << (uint16_t)0;  // LASzip version
+        out << (uint32_t)0 << DefaultChunkSize;  // options, chunk size
+        out << (int64_t)-1 << (int64_t)-1;  // no special EVLRs
+        out << numItems;
+        out << ItemPoint10 << (uint16_t)20 << (uint16_t)2;
+        if (hasTime(m_format))
+            out << ItemGpstime11 << (uint16_t)8 << (uint16_t)2;
+        if (hasColor(m_format))
+            out << ItemRgb12 << (uint16_t)6 << (uint16_t)2;
+        return data;
+    }
+
+    void compress(const char *inbuf)
+    {
+        if (!m_compressor)
+        {
+            // Leave room for the offset of the chunk table.
+            m_chunkTablePos = m_out.tellp();
+            OLeStream out(&m_out);
+            out << (int64_t)-1;
+            m_chunkStart = m_out.tellp();
+            resetCompressor();
+        }
+        else if (m_chunkPoints == DefaultChunkSize)
+        {
+            endChunk();
+            resetCompressor();
+        }
+        m_compressor->compress(inbuf);
+        m_chunkPoints++;
+    }
+
+    void done()
+    {
+        if (!m_compressor)
+            return;
+        endChunk();
+
+        std::streampos tablePos = m_out.tellp();
+        OLeStream out(&m_out);
+        out << (uint32_t)0 << (uint32_t)m_chunkSizes.size();
+
+        // Chunk sizes are coded as the difference from the previous one.
+        Encoder encoder(m_stream);
+        laszip::compressors::integer ic(32, 2);
+        ic.init();
+        uint32_t prev = 0;
+        for (uint32_t size : m_chunkSizes)
+        {
+            ic.compress(encoder, prev, size, 1);
+            prev = size;
+        }
+        encoder.done();
+
+        std::streampos end = m_out.tellp();
+        m_out.seekp(m_chunkTablePos);
+        out << (int64_t)tablePos;
+        m_out.seekp(end);
+        m_compressor.reset();
+        m_encoder.reset();
+    }
+
+private:
+    void resetCompressor()
+    {
+        using namespace laszip::formats;
+
+        m_encoder.reset(new Encoder(m_stream));
+        m_compressor = make_dynamic_compressor(*m_encoder);
+        m_compressor->add_field<las::point10>();
+        if (hasTime(m_format))
+            m_compressor->add_field<las::gpstime>();
+        if (hasColor(m_format))
+            m_compressor->add_field<las::rgb>();
+        m_chunkPoints = 0;
+    }
+
+    void endChunk()
+    {
+        m_encoder->done();
+        std::streampos pos = m_out.tellp();
+        m_chunkSizes.push_back((uint32_t)(pos - m_chunkStart));
+        m_chunkStart = pos;
+    }
+
+    std::ostream& m_out;
+    LazPerfOutStream m_stream;
+    uint8_t m_format;
+    std::unique_ptr<Encoder> m_encoder;
+    Compressor m_compressor;
+    uint32_t m_chunkPoints;
+    std::streampos m_chunkTablePos;
+    std::streampos m_chunkStart;
+    std::vector<uint32_t> m_chunkSizes;
+};
+
+
+class LazPerfVlrDecompressorImpl
+{
+    typedef laszip::decoders::arithmetic<LazPerfInStream> Decoder;
+    typedef laszip::formats::dynamic_field_decompressor<Decoder>::ptr
+        Decompressor;
+
+public:
+    LazPerfVlrDecompressorImpl(std::istream& in, const char *vlrData,
+            size_t vlrLen, std::streamoff pointOffset) :
+        m_in(in), m_stream(in), m_hasTime(false), m_hasColor(false),
+        m_chunkSize(0), m_chunkPoints(0), m_chunk(0)
+    {
+        readVlr(vlrData, vlrLen);
+        readChunkTable(pointOffset);
+        seek(0);
+    }
+
+    point_count_t chunkSize() const
+        { return m_chunkSize; }
+
+    void decompress(char *outbuf)
+    {
+        if (m_chunkPoints == m_chunkSize)
+        {
+            if (m_chunk + 1 >= m_chunkStarts.size())
+                throw pdal_error("Attempt to read past the end of the "
+                    "compressed points.");
+            resetDecompressor(m_chunk + 1);
+        }
+        m_decompressor->decompress(outbuf);
+        m_chunkPoints++;
+    }
+
+    void seek(point_count_t idx)
+    {
+        size_t chunk = (size_t)(idx / m_chunkSize);
+        if (chunk >= m_chunkStarts.size())
+            throw pdal_error("Attempt to seek past the end of the "
+                "compressed points.");
+        resetDecompressor(chunk);
+        std::vector<char> buf(m_pointLen);
+        for (point_count_t skip = idx % m_chunkSize; skip; --skip)
+            decompress(buf.data());
+    }
+
+private:
+    void readVlr(const char *vlrData, size_t vlrLen)
+    {
+        auto fail = [](const std::string& msg)
+        {
+            throw pdal_error("Can't decompress with lazperf: " + msg);
+        };
+
+        if (!vlrData || vlrLen < 34)
+            fail("invalid LASzip VLR.");
+        LeExtractor in(vlrData, vlrLen);
+        uint16_t compressor, coder, revision, numItems;
+        uint8_t major, minor;
+        uint32_t options;
+        int64_t evlrCount, evlrOffset;
+        in >> compressor >> coder >> major >> minor >> revision >>
+            options >> m_chunkSize >> evlrCount >> evlrOffset >> numItems;
+        if (compressor != PointwiseChunked)
+            fail("points aren't compressed in chunks.");
+        if (m_chunkSize == 0 ||
+            m_chunkSize == (std::numeric_limits<uint32_t>::max)())
+            fail("variable sized chunks aren't supported.");
+        if (vlrLen < 34 + 6 * (size_t)numItems)
+            fail("invalid LASzip VLR.");
+
+        m_pointLen = 0;
+        for (uint16_t i = 0; i < numItems; ++i)
+        {
+            uint16_t type, size, version;
+            in >> type >> size >> version;
+            if (version != 2)
+                fail("only version 2 compressed items are supported.");
+            if (type == ItemPoint10 && i == 0)
+                ;
+            else if (type == ItemGpstime11 && i == 1)
+                m_hasTime = true;
+            else if (type == ItemRgb12 && (i == 1 || (i == 2 && m_hasTime)))
+                m_hasColor = true;
+            else
+                fail("only point formats 0 - 3 without extra bytes "
+                    "are supported.");
+            m_pointLen += size;
+        }
+        if (numItems == 0)
+            fail("no compressed items.");
+    }
+
+    // Find the start of each chunk from the chunk table.  LASzip writes
+    // the table's offset at the start of the points, or at the end of
+    // the file if it couldn't seek back to do that.
+    void readChunkTable(std::streamoff pointOffset)
+    {
+        ILeStream in(&m_in);
+        int64_t tableOffset;
+        m_in.seekg(pointOffset);
+        in >> tableOffset;
+        if (tableOffset == -1)
+        {
+            m_in.seekg(-8, std::ios::end);
+            in >> tableOffset;
+        }
+        m_in.seekg(tableOffset);
+
+        uint32_t version, numChunks;
+        in >> version >> numChunks;
+        if (!m_in || version != 0)
+            throw pdal_error("Can't decompress with lazperf: invalid "
+                "chunk table.");
+
+        Decoder decoder(m_stream);
+        laszip::decompressors::integer ic(32, 2);
+        decoder.readInitBytes();
+        ic.init();
+        std::streamoff start = pointOffset + 8;
+        uint32_t prev = 0;
+        for (uint32_t i = 0; i < numChunks; ++i)
+        {
+            m_chunkStarts.push_back(start);
+            prev = (uint32_t)ic.decompress(decoder, prev, 1);
+            start += prev;
+        }
+    }
+
+    void resetDecompressor(size_t chunk)
+    {
+        using namespace laszip::formats;
+
+        m_in.clear();
+        m_in.seekg(m_chunkStarts[chunk]);
+        m_decoder.reset(new Decoder(m_stream));
+        m_decompressor = make_dynamic_decompressor(*m_decoder);
+        m_decompressor->add_field<las::point10>();
+        if (m_hasTime)
+            m_decompressor->add_field<las::gpstime>();
+        if (m_hasColor)
+            m_decompressor->add_field<las::rgb>();
+        m_chunk = chunk;
+        m_chunkPoints = 0;
+    }
+
+    std::istream& m_in;
+    LazPerfInStream m_stream;
+    bool m_hasTime;
+    bool m_hasColor;
+    uint16_t m_pointLen;
+    uint32_t m_chunkSize;
+    std::unique_ptr<Decoder> m_decoder;
+    Decompressor m_decompressor;
+    std::vector<std::streamoff> m_chunkStarts;
+    uint32_t m_chunkPoints;
+    size_t m_chunk;
+};
+
+
+LazPerfVlrCompressor::LazPerfVlrCompressor(std::ostream& out, uint8_t format,
+        uint16_t pointLen) :
+    m_impl(new LazPerfVlrCompressorImpl(out, format, pointLen))
+{}
+
+
+LazPerfVlrCompressor::~LazPerfVlrCompressor()
+{}
+
+
+std::vector<uint8_t> LazPerfVlrCompressor::vlrData() const
+{
+    return m_impl->vlrData();
+}
+
+
+void LazPerfVlrCompressor::compress(const char *inbuf)
+{
+    m_impl->compress(inbuf);
+}
+
+
+void LazPerfVlrCompressor::done()
+{
+    m_impl->done();
+}
+
+
+LazPerfVlrDecompressor::LazPerfVlrDecompressor(std::istream& in,
+        const char *vlrData, size_t vlrLen, std::streamoff pointOffset) :
+    m_impl(new LazPerfVlrDecompressorImpl(in, vlrData, vlrLen, pointOffset))
+{}
+
+
+LazPerfVlrDecompressor::~LazPerfVlrDecompressor()
+{}
+
+
+point_count_t LazPerfVlrDecompressor::chunkSize() const
+{
+    return m_impl->chunkSize();
+}
+
+
+void LazPerfVlrDecompressor::decompress(char *outbuf)
+{
+    m_impl->decompress(outbuf);
+}
+
+
+void LazPerfVlrDecompressor::seek(point_count_t idx)
+{
+    m_impl->seek(idx);
+}
+
+} // namespace pdal
+
+#endif // PDAL_HAVE_LAZPERF
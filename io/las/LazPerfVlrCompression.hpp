@@ -0,0 +1,110 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace pdal
+{
+
+#ifdef PDAL_HAVE_LAZPERF
+
+class LazPerfVlrCompressorImpl;
+class LazPerfVlrDecompressorImpl;
+
+// Writes LAZ point data with laz-perf.  The output is the chunked stream
+// that LASzip writes: the offset of the chunk table, the chunks of
+// compressed points and then the chunk table, so that files can be read
+// with either engine.  Only point formats 0 - 3 without extra bytes are
+// supported.
+class PDAL_DLL LazPerfVlrCompressor
+{
+public:
+    LazPerfVlrCompressor(std::ostream& out, uint8_t format, uint16_t pointLen);
+    ~LazPerfVlrCompressor();
+
+    // Data for the LASzip VLR that describes the stream.
+    std::vector<uint8_t> vlrData() const;
+    // Compress one LAS point record.
+    void compress(const char *inbuf);
+    // Finish the last chunk and write the chunk table.
+    void done();
+
+private:
+    std::unique_ptr<LazPerfVlrCompressorImpl> m_impl;
+
+    // not implemented
+    LazPerfVlrCompressor& operator=(const LazPerfVlrCompressor&);
+    LazPerfVlrCompressor(const LazPerfVlrCompressor&);
+};
+
+// Reads LAZ point data written by LASzip or LazPerfVlrCompressor.
+class PDAL_DLL LazPerfVlrDecompressor
+{
+public:
+    // \param in - Stream of the LAZ file.
+    // \param vlrData - Data of the file's LASzip VLR.
+    // \param vlrLen - Length of the VLR data.
+    // \param pointOffset - Position of the point data in the stream.
+    LazPerfVlrDecompressor(std::istream& in, const char *vlrData,
+        size_t vlrLen, std::streamoff pointOffset);
+    ~LazPerfVlrDecompressor();
+
+    // Number of points in each chunk.
+    point_count_t chunkSize() const;
+    // Decompress the next point record into 'outbuf'.
+    void decompress(char *outbuf);
+    // Position the decompressor so that the next point read is 'idx'.
+    void seek(point_count_t idx);
+
+private:
+    std::unique_ptr<LazPerfVlrDecompressorImpl> m_impl;
+
+    // not implemented
+    LazPerfVlrDecompressor& operator=(const LazPerfVlrDecompressor&);
+    LazPerfVlrDecompressor(const LazPerfVlrDecompressor&);
+};
+
+#else // PDAL_HAVE_LAZPERF
+// As with ZipPoint, these are only tested against NULL.
+typedef char LazPerfVlrCompressor;
+typedef char LazPerfVlrDecompressor;
+#endif
+
+} // namespace pdal
@@ -50,6 +50,11 @@ public:
     SummaryData();
 
     void addPoint(double x, double y, double z, int returnNumber);
+    // Add the points already counted in a file's header.
+    void addHeader(const LasHeader& header);
+    // Add the points counted by another summary, so that parts of a set of
+    // points can be summarized separately and then combined.
+    void merge(const SummaryData& other);
     uint32_t getTotalNumPoints() const
         { return m_totalNumPoints; }
     BOX3D getBounds() const;
@@ -66,9 +71,6 @@ private:
     double m_maxZ;
     std::array<point_count_t, LasHeader::RETURN_COUNT> m_returnCounts;
     point_count_t m_totalNumPoints;
-
-    SummaryData& operator=(const SummaryData&); // not implemented
-    SummaryData(const SummaryData&); // not implemented
 };
 
 PDAL_DLL std::ostream& operator<<(std::ostream& ostr, const SummaryData&);
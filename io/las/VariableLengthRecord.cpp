@@ -40,16 +40,22 @@ namespace pdal
 const uint16_t VariableLengthRecord::MAX_DATA_SIZE =
     (std::numeric_limits<uint16_t>::max)();
 
-ILeStream& operator>>(ILeStream& in, VariableLengthRecord& v)
+uint64_t VariableLengthRecord::readHeader(ILeStream& in)
 {
     uint16_t reserved;
     uint16_t dataLen;
 
     in >> reserved;
-    in.get(v.m_userId, 16);
-    in >> v.m_recordId >> dataLen;
-    in.get(v.m_description, 32);
-    v.m_data.resize(dataLen);
+    in.get(m_userId, 16);
+    in >> m_recordId >> dataLen;
+    in.get(m_description, 32);
+    return dataLen;
+}
+
+
+ILeStream& operator>>(ILeStream& in, VariableLengthRecord& v)
+{
+    v.m_data.resize((size_t)v.readHeader(in));
     in.get(v.m_data);
 
     return in;
@@ -68,15 +74,21 @@ OLeStream& operator<<(OLeStream& out, const VariableLengthRecord& v)
 }
 
 
-ILeStream& operator>>(ILeStream& in, ExtVariableLengthRecord& v)
+uint64_t ExtVariableLengthRecord::readHeader(ILeStream& in)
 {
     uint64_t dataLen;
 
-    in >> v.m_recordSig;
-    in.get(v.m_userId, 16);
-    in >> v.m_recordId >> dataLen;
-    in.get(v.m_description, 32);
-    v.m_data.resize(dataLen);
+    in >> m_recordSig;
+    in.get(m_userId, 16);
+    in >> m_recordId >> dataLen;
+    in.get(m_description, 32);
+    return dataLen;
+}
+
+
+ILeStream& operator>>(ILeStream& in, ExtVariableLengthRecord& v)
+{
+    v.m_data.resize((size_t)v.readHeader(in));
     in.get(v.m_data);
 
     return in;
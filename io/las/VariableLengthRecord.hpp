@@ -94,6 +94,9 @@ public:
     void setDataLen(uint64_t size)
         { m_data.resize((size_t)size); }
     void write(OLeStream& out, uint16_t recordSig);
+    // Read the header of a record, leaving the stream at the record's data.
+    // \return  Length of the data.
+    uint64_t readHeader(ILeStream& in);
 
     friend ILeStream& operator>>(ILeStream& in, VariableLengthRecord& v);
     friend OLeStream& operator<<(OLeStream& out, const VariableLengthRecord& v);
@@ -116,6 +119,8 @@ public:
     ExtVariableLengthRecord()
     {}
 
+    uint64_t readHeader(ILeStream& in);
+
     friend ILeStream& operator>>(ILeStream& in, ExtVariableLengthRecord& v);
     friend OLeStream& operator<<(OLeStream& out,
         const ExtVariableLengthRecord& v);
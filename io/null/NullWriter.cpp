@@ -1,5 +1,7 @@
 #include "NullWriter.hpp"
 
+#include <pdal/PointView.hpp>
+
 namespace pdal
 {
 
@@ -13,4 +15,84 @@ CREATE_STATIC_PLUGIN(1, 0, NullWriter, Writer, s_info)
 
 std::string NullWriter::getName() const { return s_info.name; }
 
+namespace
+{
+
+// Add the execution time of 'stage' and the stages before it to 'm',
+// readers first.
+void addStageTimes(const Stage& stage, MetadataNode& m, LogPtr log)
+{
+    for (const Stage *s : stage.getInputs())
+        addStageTimes(*s, m, log);
+
+    const StageProfile& p = stage.profile();
+    MetadataNode sm = m.addList(stage.getName());
+    sm.add("execute_time", p.m_executeTime,
+        "Seconds spent executing the stage");
+    sm.add("points_out", p.m_pointsOut, "Points produced by the stage");
+    log->get(LogLevel::Info) << "  " << stage.getName() << ": " <<
+        p.m_executeTime << " s, " << p.m_pointsOut << " points" << std::endl;
+}
+
+} // unnamed namespace
+
+
+void NullWriter::processOptions(const Options& options)
+{
+    m_benchmark = options.getValueOrDefault<bool>("benchmark", false);
+}
+
+
+// Stages before this one execute before its ready() is called unless
+// the pipeline is streamed, so time is measured from the end of prepare().
+void NullWriter::prepared(PointTableRef)
+{
+    m_start = std::chrono::steady_clock::now();
+}
+
+
+void NullWriter::ready(PointTableRef)
+{
+    m_points = 0;
+    m_bytes = 0;
+}
+
+
+void NullWriter::write(const PointViewPtr view)
+{
+    if (m_benchmark)
+    {
+        m_points += view->size();
+        m_bytes += view->size() * view->pointSize();
+    }
 }
+
+
+void NullWriter::done(PointTableRef)
+{
+    if (!m_benchmark)
+        return;
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - m_start;
+    const double seconds = elapsed.count();
+    const double pointRate = seconds > 0 ? m_points / seconds : 0;
+    const double byteRate = seconds > 0 ? m_bytes / seconds : 0;
+
+    MetadataNode m = m_metadata.add("benchmark");
+    m.add("points", m_points, "Points written");
+    m.add("bytes", m_bytes, "Bytes of point data written");
+    m.add("seconds", seconds, "Seconds from prepare to done");
+    m.add("points_per_second", pointRate, "Points written per second");
+    m.add("bytes_per_second", byteRate, "Bytes written per second");
+
+    log()->get(LogLevel::Info) << getName() << ": " << m_points <<
+        " points, " << m_bytes << " bytes in " << seconds << " s (" <<
+        pointRate << " points/s, " << byteRate / (1024 * 1024) <<
+        " MB/s)" << std::endl;
+    MetadataNode stages = m.add("stages");
+    for (const Stage *s : getInputs())
+        addStageTimes(*s, stages, log());
+}
+
+} // namespace pdal
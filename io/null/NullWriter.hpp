@@ -38,21 +38,43 @@
 
 #include <pdal/Writer.hpp>
 
+#include <chrono>
+
 extern "C" int32_t NullWriter_ExitFunc();
 extern "C" PF_ExitFunc NullWriter_InitPlugin();
 
 namespace pdal
 {
 
+// Discards its points.  With the "benchmark" option, it counts the points
+// and bytes of point data it's passed and, once done, logs and adds to its
+// metadata the rate at which they arrived since the pipeline was prepared
+// and the time spent executing each stage before it.
 class PDAL_DLL NullWriter : public Writer
 {
 public:
+    NullWriter() : m_benchmark(false), m_points(0), m_bytes(0)
+        {}
+
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
 private:
-    virtual void write(const PointViewPtr /*view*/)
-        {}
+    bool m_benchmark;
+    point_count_t m_points;
+    uint64_t m_bytes;
+    std::chrono::steady_clock::time_point m_start;
+
+    virtual void processOptions(const Options& options);
+    virtual void prepared(PointTableRef table);
+    virtual void ready(PointTableRef table);
+    virtual void write(const PointViewPtr view);
+    virtual void done(PointTableRef table);
+
+    NullWriter& operator=(const NullWriter&); // not implemented
+    NullWriter(const NullWriter&); // not implemented
 };
 
 } // namespace pdal
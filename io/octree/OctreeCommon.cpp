@@ -0,0 +1,85 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "OctreeCommon.hpp"
+
+#include <pdal/Utils.hpp>
+
+#include <limits>
+
+namespace pdal
+{
+
+BOX3D OctreeKey::bounds(const BOX3D& cube) const
+{
+    double size = (cube.maxx - cube.minx) / ((uint64_t)1 << d);
+    double minx = cube.minx + x * size;
+    double miny = cube.miny + y * size;
+    double minz = cube.minz + z * size;
+    return BOX3D(minx, miny, minz, minx + size, miny + size, minz + size);
+}
+
+
+std::string OctreeKey::toString() const
+{
+    return std::to_string(d) + "-" + std::to_string(x) + "-" +
+        std::to_string(y) + "-" + std::to_string(z);
+}
+
+
+bool OctreeKey::parse(const std::string& s)
+{
+    StringList parts = Utils::split2(s, '-');
+    if (parts.size() != 4)
+        return false;
+    uint32_t vals[4];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        const std::string& p = parts[i];
+        if (p.empty() || p.size() > 10 ||
+            p.find_first_not_of("0123456789") != std::string::npos)
+            return false;
+        uint64_t v = std::stoull(p);
+        if (v > std::numeric_limits<uint32_t>::max())
+            return false;
+        vals[i] = (uint32_t)v;
+    }
+    d = vals[0];
+    x = vals[1];
+    y = vals[2];
+    z = vals[3];
+    return true;
+}
+
+} // namespace pdal
@@ -0,0 +1,89 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+#include <pdal/util/Bounds.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace pdal
+{
+
+// A node of an octree written by writers.octree: its depth and position
+// among the nodes of that depth.
+struct PDAL_DLL OctreeKey
+{
+    OctreeKey() : d(0), x(0), y(0), z(0)
+        {}
+    OctreeKey(uint32_t d, uint32_t x, uint32_t y, uint32_t z) :
+        d(d), x(x), y(y), z(z)
+        {}
+
+    // Child 'i', where bits 0, 1 and 2 of 'i' select the upper half in X,
+    // Y and Z.
+    OctreeKey child(int i) const
+    {
+        return OctreeKey(d + 1, (x << 1) | (i & 1),
+            (y << 1) | ((i >> 1) & 1), (z << 1) | ((i >> 2) & 1));
+    }
+    // Bounds of the node in an octree whose root is 'cube'.
+    BOX3D bounds(const BOX3D& cube) const;
+    // The key as written, "D-X-Y-Z".
+    std::string toString() const;
+    // Set the key from its string form.  Returns false if 's' isn't a key.
+    bool parse(const std::string& s);
+
+    bool operator<(const OctreeKey& other) const
+    {
+        if (d != other.d)
+            return d < other.d;
+        if (x != other.x)
+            return x < other.x;
+        if (y != other.y)
+            return y < other.y;
+        return z < other.z;
+    }
+    bool operator==(const OctreeKey& other) const
+        { return d == other.d && x == other.x && y == other.y && z == other.z; }
+
+    uint32_t d;
+    uint32_t x;
+    uint32_t y;
+    uint32_t z;
+};
+
+} // namespace pdal
@@ -0,0 +1,426 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include "OctreeReader.hpp"
+
+#include <pdal/Options.hpp>
+#include <pdal/pdal_error.hpp>
+#include <pdal/StreamFactory.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <las/LasReader.hpp>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <deque>
+#include <limits>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "readers.octree",
+    "Octree of LAS/LAZ nodes written by writers.octree",
+    "http://pdal.io/stages/readers.octree.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, OctreeReader, Reader, s_info)
+
+namespace
+{
+    // Nodes fetched ahead of the one being read, for each worker.
+    const std::size_t PrefetchPerThread = 2;
+}
+
+// A node read into its own table.
+struct OctreeReader::Node
+{
+    Node() : m_table(new PointTable)
+        {}
+
+    std::unique_ptr<PointTable> m_table;
+    PointViewPtr m_view;
+};
+
+
+OctreeReader::OctreeReader() : m_pointSize(0), m_next(0), m_submitted(0)
+{}
+
+
+OctreeReader::~OctreeReader()
+{
+    // Tasks still fetching nodes refer to the reader.
+    drain();
+}
+
+
+std::string OctreeReader::getName() const
+{
+    return s_info.name;
+}
+
+
+Options OctreeReader::getDefaultOptions()
+{
+    Options options;
+    options.add("bounds", BOX3D(), "Only read points inside these bounds.  "
+        "If the Z range is empty, only X and Y are checked.");
+    options.add("depth", (std::numeric_limits<uint32_t>::max)(),
+        "Deepest level of nodes read, the root being 0");
+    options.add("resolution", 0,
+        "Only read nodes down to the depth whose points are spaced at "
+        "least this closely");
+    return options;
+}
+
+
+void OctreeReader::processOptions(const Options& options)
+{
+    m_bounds = options.getValueOrDefault<BOX3D>("bounds", BOX3D());
+    m_depth = options.getValueOrDefault<uint32_t>("depth",
+        (std::numeric_limits<uint32_t>::max)());
+    m_resolution = options.getValueOrDefault<double>("resolution", 0);
+    if (m_resolution < 0)
+        throw pdal_error("OctreeReader: Option 'resolution' can't be "
+            "negative.");
+}
+
+
+bool OctreeReader::setBounds(const BOX3D& bounds)
+{
+    // 'count' is of the points in the octree, not of those inside the
+    // bounds.
+    if (bounds.empty() || !m_bounds.empty() ||
+        m_count != (std::numeric_limits<point_count_t>::max)())
+        return false;
+    m_bounds = bounds;
+    return true;
+}
+
+
+void OctreeReader::initialize()
+{
+    readIndex();
+
+    // The nodes are all written with the same dimensions, which are read
+    // from the header of the first.
+    auto it = m_hierarchy.begin();
+    while (it != m_hierarchy.end() && it->second == 0)
+        ++it;
+    if (it == m_hierarchy.end())
+    {
+        for (const char *name : { "X", "Y", "Z" })
+            m_dims.push_back(std::make_pair(std::string(name),
+                Dimension::Type::Double));
+        return;
+    }
+
+    Options options;
+    options.add("filename", nodeFilename(it->first));
+    PointTable table;
+    LasReader reader;
+    reader.setOptions(options);
+    reader.prepare(table);
+    PointLayoutPtr layout = table.layout();
+    for (const auto& dt : layout->dimTypes())
+        m_dims.push_back(std::make_pair(layout->dimName(dt.m_id),
+            dt.m_type));
+}
+
+
+// Read octree.json, from 'filename' itself or from the directory it
+// names.
+void OctreeReader::readIndex()
+{
+    namespace pt = boost::property_tree;
+
+    const std::string indexName("octree.json");
+    std::string index;
+    m_base = m_filename;
+    if (m_base.size() >= indexName.size() &&
+        m_base.compare(m_base.size() - indexName.size(), indexName.size(),
+            indexName) == 0)
+    {
+        index = m_base;
+        m_base.erase(m_base.size() - indexName.size());
+        if (m_base.empty())
+            m_base = ".";
+    }
+    while (m_base.size() > 1 && m_base[m_base.size() - 1] == '/')
+        m_base.erase(m_base.size() - 1);
+    if (index.empty())
+        index = m_base + "/" + indexName;
+
+    pt::ptree tree;
+    try
+    {
+        std::unique_ptr<StreamFactory> factory;
+        if (RemoteStreamFactory::remote(index))
+            factory.reset(new RemoteStreamFactory(index));
+        else
+            factory.reset(new FilenameStreamFactory(index));
+        std::istream& in = factory->allocate();
+        pt::read_json(in, tree);
+        factory->deallocate(in);
+    }
+    catch (const pt::json_parser_error& err)
+    {
+        throw pdal_error("OctreeReader: Unable to parse '" + index + "': " +
+            err.message());
+    }
+
+    try
+    {
+        if (tree.get<int>("version") != 1)
+            throw pdal_error("OctreeReader: Unsupported version of '" +
+                index + "'.");
+
+        std::vector<double> b;
+        for (const auto& v : tree.get_child("bounds"))
+            b.push_back(v.second.get_value<double>());
+        if (b.size() != 6)
+            throw pdal_error("OctreeReader: Invalid bounds in '" + index +
+                "'.");
+        m_cube = BOX3D(b[0], b[1], b[2], b[3], b[4], b[5]);
+        m_nodeResolution = tree.get<uint32_t>("resolution");
+        m_dataType = tree.get<std::string>("dataType");
+
+        m_hierarchy.clear();
+        for (const auto& node : tree.get_child("hierarchy"))
+        {
+            OctreeKey key;
+            if (!key.parse(node.first))
+                throw pdal_error("OctreeReader: Invalid node '" +
+                    node.first + "' in '" + index + "'.");
+            m_hierarchy[key] = node.second.get_value<point_count_t>();
+        }
+
+        std::string srs = tree.get<std::string>("srs", "");
+        if (getSpatialReference().empty() && srs.size())
+            setSpatialReference(SpatialReference(srs));
+    }
+    catch (const pt::ptree_error& err)
+    {
+        throw pdal_error("OctreeReader: Invalid index '" + index + "': " +
+            err.what());
+    }
+}
+
+
+void OctreeReader::addDimensions(PointLayoutPtr layout)
+{
+    m_dimTypes.clear();
+    m_pointSize = 0;
+    for (const auto& dim : m_dims)
+    {
+        Dimension::Id::Enum id =
+            layout->registerOrAssignDim(dim.first, dim.second);
+        m_dimTypes.push_back(DimType(id, dim.second));
+        m_pointSize += Dimension::size(dim.second);
+    }
+}
+
+
+// Depth of the deepest nodes read.  The points of a node are spaced about
+// the node's size over the resolution of the octree.
+uint32_t OctreeReader::maxDepth() const
+{
+    uint32_t depth = m_depth;
+    if (m_resolution > 0)
+    {
+        double spacing = (m_cube.maxx - m_cube.minx) / m_nodeResolution;
+        uint32_t d = 0;
+        while (d < depth && spacing > m_resolution)
+        {
+            spacing /= 2;
+            ++d;
+        }
+        depth = d;
+    }
+    return depth;
+}
+
+
+std::string OctreeReader::nodeFilename(const OctreeKey& key) const
+{
+    return m_base + "/data/" + key.toString() + "." + m_dataType;
+}
+
+
+void OctreeReader::ready(PointTableRef /*table*/)
+{
+    drain();
+    m_keys.clear();
+    m_current.reset();
+    m_next = 0;
+    m_submitted = 0;
+
+    // Walk the octree from the root, shallowest nodes first, skipping the
+    // subtrees outside the bounds.
+    const uint32_t depth = maxDepth();
+    std::deque<OctreeKey> todo;
+    if (m_hierarchy.count(OctreeKey()))
+        todo.push_back(OctreeKey());
+    while (todo.size())
+    {
+        OctreeKey key = todo.front();
+        todo.pop_front();
+        if (!m_bounds.empty() && !m_bounds.overlaps(key.bounds(m_cube)))
+            continue;
+        if (m_hierarchy[key])
+            m_keys.push_back(key);
+        if (key.d < depth)
+            for (int i = 0; i < 8; ++i)
+            {
+                OctreeKey child = key.child(i);
+                if (m_hierarchy.count(child))
+                    todo.push_back(child);
+            }
+    }
+    m_nodes.clear();
+    m_nodes.resize(m_keys.size());
+    m_tasks.clear();
+    m_tasks.resize(m_keys.size());
+
+    m_metadata.add("nodes", m_keys.size(), "Number of nodes read.");
+    m_metadata.add("depth", depth, "Deepest level of nodes read.");
+    prefetch();
+}
+
+
+// Read a node, keeping only the points inside the bounds.
+std::unique_ptr<OctreeReader::Node> OctreeReader::fetch(
+    const OctreeKey& key) const
+{
+    std::unique_ptr<Node> node(new Node);
+
+    Options options;
+    options.add("filename", nodeFilename(key));
+    if (!m_bounds.empty())
+        options.add("bounds", m_bounds);
+    LasReader reader;
+    reader.setOptions(options);
+    reader.prepare(*node->m_table);
+    PointViewSet views = reader.execute(*node->m_table);
+    node->m_view = *views.begin();
+    return node;
+}
+
+
+// Start fetching the nodes that follow the one being read.
+void OctreeReader::prefetch()
+{
+    ThreadPool& pool = ThreadPool::shared();
+    const std::size_t window = PrefetchPerThread * pool.size();
+    while (m_submitted < m_keys.size() && m_submitted < m_next + window)
+    {
+        std::size_t i = m_submitted++;
+        m_tasks[i] = pool.submit([this, i]()
+            { m_nodes[i] = fetch(m_keys[i]); });
+    }
+}
+
+
+// Wait for the nodes being fetched.  Their errors no longer matter.
+void OctreeReader::drain()
+{
+    for (auto& task : m_tasks)
+        if (task.valid())
+        {
+            try
+            {
+                ThreadPool::shared().wait(task);
+            }
+            catch (...)
+            {}
+        }
+}
+
+
+point_count_t OctreeReader::read(PointViewPtr view, point_count_t count)
+{
+    std::vector<char> buf(m_pointSize);
+    point_count_t numRead = 0;
+    while (numRead < count)
+    {
+        if (!m_current)
+        {
+            if (m_next >= m_keys.size())
+                break;
+            ThreadPool::shared().wait(m_tasks[m_next]);
+            m_current = std::move(m_nodes[m_next]);
+            ++m_next;
+            prefetch();
+
+            PointLayoutPtr layout = m_current->m_table->layout();
+            m_currentTypes.clear();
+            for (const auto& dim : m_dims)
+            {
+                Dimension::Id::Enum id = layout->findDim(dim.first);
+                if (id == Dimension::Id::Unknown)
+                    throw pdal_error("OctreeReader: Node '" +
+                        m_keys[m_next - 1].toString() + "' has no "
+                        "dimension '" + dim.first + "'.");
+                m_currentTypes.push_back(DimType(id, dim.second));
+            }
+            m_currentIdx = 0;
+        }
+
+        PointView& src = *m_current->m_view;
+        while (m_currentIdx < src.size() && numRead < count)
+        {
+            src.getPackedPoint(m_currentTypes, m_currentIdx++, buf.data());
+            PointId idx = view->size();
+            view->setPackedPoint(m_dimTypes, idx, buf.data());
+            if (m_cb)
+                m_cb(*view, idx);
+            ++numRead;
+        }
+        if (m_currentIdx == src.size())
+            m_current.reset();
+    }
+    return numRead;
+}
+
+
+void OctreeReader::done(PointTableRef /*table*/)
+{
+    drain();
+    m_current.reset();
+    m_nodes.clear();
+    m_tasks.clear();
+}
+
+} // namespace pdal
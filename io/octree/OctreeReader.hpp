@@ -0,0 +1,131 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#pragma once
+
+#include <pdal/pdal_export.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/Reader.hpp>
+#include <pdal/util/Bounds.hpp>
+
+#include "OctreeCommon.hpp"
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" int32_t OctreeReader_ExitFunc();
+extern "C" PF_ExitFunc OctreeReader_InitPlugin();
+
+namespace pdal
+{
+
+// Reads an octree written by writers.octree.  Only the nodes that overlap
+// the bounds asked for, down to the depth that gives the resolution asked
+// for, are read.  The nodes are fetched and decompressed in parallel, a
+// few ahead of the one being read, and their points are returned
+// shallowest node first.
+class PDAL_DLL OctreeReader : public Reader
+{
+public:
+    OctreeReader();
+    ~OctreeReader();
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+    virtual bool streamable() const
+        { return true; }
+
+    Options getDefaultOptions();
+
+    virtual bool setBounds(const BOX3D& bounds);
+
+private:
+    struct Node;
+
+    BOX3D m_bounds;
+    uint32_t m_depth;
+    double m_resolution;
+
+    // Where the octree is: the directory or URL holding octree.json.
+    std::string m_base;
+    BOX3D m_cube;
+    uint32_t m_nodeResolution;
+    std::string m_dataType;
+    std::map<OctreeKey, point_count_t> m_hierarchy;
+
+    // The dimensions of the nodes' points, by name, and as registered in
+    // the table read into.
+    std::vector<std::pair<std::string, Dimension::Type::Enum>> m_dims;
+    DimTypeList m_dimTypes;
+    std::size_t m_pointSize;
+
+    // Nodes to read, in order, and those fetched or being fetched.
+    std::vector<OctreeKey> m_keys;
+    std::vector<std::unique_ptr<Node>> m_nodes;
+    std::vector<std::future<void>> m_tasks;
+    std::size_t m_next;
+    std::size_t m_submitted;
+    // The node being read and the types of its dimensions, in its own
+    // table's ids.
+    std::unique_ptr<Node> m_current;
+    DimTypeList m_currentTypes;
+    PointId m_currentIdx;
+
+    virtual void processOptions(const Options& options);
+    virtual void initialize();
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void ready(PointTableRef table);
+    virtual point_count_t read(PointViewPtr view, point_count_t count);
+    virtual void done(PointTableRef table);
+
+    void readIndex();
+    uint32_t maxDepth() const;
+    std::string nodeFilename(const OctreeKey& key) const;
+    std::unique_ptr<Node> fetch(const OctreeKey& key) const;
+    void prefetch();
+    void drain();
+
+    OctreeReader& operator=(const OctreeReader&); // not implemented
+    OctreeReader(const OctreeReader&); // not implemented
+};
+
+} // namespace pdal
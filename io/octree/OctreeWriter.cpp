@@ -0,0 +1,712 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "OctreeWriter.hpp"
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/Options.hpp>
+#include <pdal/pdal_error.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/Utils.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include <las/LasWriter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <unordered_map>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "writers.octree",
+    "Octree of LAS/LAZ nodes",
+    "http://pdal.io/stages/writers.octree.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, OctreeWriter, Writer, s_info)
+
+namespace
+{
+    // Depth of the grid on which the points are counted to split the
+    // octree into chunks.
+    const uint32_t MaxGridDepth = 6;
+    // Aim for at least this many chunks per worker, so that the work
+    // evens out.
+    const size_t ChunksPerThread = 4;
+    // Largest chunk, in points, unless a cell of the grid holds more.
+    const point_count_t MaxChunkPoints = 1 << 22;
+
+    struct Xyz
+    {
+        double x;
+        double y;
+        double z;
+    };
+
+    // Position of the packed point 'id' in 'buf'.
+    inline Xyz position(const char *buf, size_t pointSize, uint32_t id)
+    {
+        Xyz p;
+        std::memcpy(&p, buf + id * pointSize, sizeof(p));
+        return p;
+    }
+
+    // Cell of 'v' among 'cells' equal divisions of [min, min + size).
+    inline uint32_t cell(double v, double min, double size, uint32_t cells)
+    {
+        double c = std::floor((v - min) / size * cells);
+        if (c < 0)
+            return 0;
+        if (c >= cells)
+            return cells - 1;
+        return (uint32_t)c;
+    }
+} // anonymous namespace
+
+
+struct OctreeWriter::Node
+{
+    Node(const Key& key) : m_key(key), m_hasChildren(false), m_built(false)
+        {}
+
+    Key m_key;
+    // Points of the node, by index in the buffer of packed points that
+    // the node was built from.
+    std::vector<uint32_t> m_ids;
+    std::unique_ptr<Node> m_children[8];
+    bool m_hasChildren;
+    // Whether the node's points have been sampled from its children.
+    bool m_built;
+};
+
+
+// A subtree of the octree that is built by a single task.
+struct OctreeWriter::Chunk
+{
+    Chunk(const Key& key) : m_key(key)
+        {}
+
+    Key m_key;
+    // Ids of the points in m_points.
+    std::vector<PointId> m_points;
+    // Once built, the root of the subtree, whose points are packed in
+    // m_data.  The nodes below it have been written.
+    std::unique_ptr<Node> m_root;
+    std::vector<char> m_data;
+};
+
+
+std::string OctreeWriter::getName() const
+{
+    return s_info.name;
+}
+
+
+Options OctreeWriter::getDefaultOptions()
+{
+    Options options;
+    options.add("overwrite", false, "Overwrite existing files?");
+    options.add("max_node_points", 65536,
+        "Most points in a node that isn't split");
+    options.add("max_depth", 16, "Depth below which nodes aren't split");
+    options.add("resolution", 128,
+        "Cells of the sampling grid along each axis of a node");
+    options.add("memory_budget", 0,
+        "Megabytes of points to hold in memory before spilling to disk");
+    options.add("scale", .01, "Scale of the X, Y and Z values written");
+    options.add("compression", "true", "Compression of the nodes");
+    return options;
+}
+
+
+void OctreeWriter::processOptions(const Options& options)
+{
+    m_overwrite = options.getValueOrDefault<bool>("overwrite", false);
+    m_maxNodePoints =
+        options.getValueOrDefault<point_count_t>("max_node_points", 65536);
+    m_maxDepth = options.getValueOrDefault<uint32_t>("max_depth", 16);
+    m_resolution = options.getValueOrDefault<uint32_t>("resolution", 128);
+    m_memoryBudget = options.getValueOrDefault<std::size_t>("memory_budget",
+        0) * 1024 * 1024;
+    m_scale = options.getValueOrDefault<double>("scale", .01);
+    if (m_maxNodePoints == 0)
+        throw pdal_error("OctreeWriter: Option 'max_node_points' must be "
+            "greater than 0.");
+    // Keys hold the position of a node in 32 bits.
+    if (m_maxDepth > 31)
+        throw pdal_error("OctreeWriter: Option 'max_depth' can't be greater "
+            "than 31.");
+    if (m_resolution == 0)
+        throw pdal_error("OctreeWriter: Option 'resolution' must be greater "
+            "than 0.");
+    if (m_scale <= 0)
+        throw pdal_error("OctreeWriter: Option 'scale' must be greater "
+            "than 0.");
+
+    // The nodes are written with LasWriter, which is given these options
+    // and the name and offsets of each node.
+    std::string compression =
+        options.getValueOrDefault<std::string>("compression", "true");
+    std::string c = Utils::tolower(compression);
+    m_extension = (c == "false" || c == "none") ? ".las" : ".laz";
+
+    m_lasOptions = Options();
+    m_lasOptions.add("compression", compression);
+    m_lasOptions.add("scale_x", m_scale);
+    m_lasOptions.add("scale_y", m_scale);
+    m_lasOptions.add("scale_z", m_scale);
+    for (const std::string name :
+            { "dataformat_id", "minor_version", "extra_dims" })
+        if (options.hasOption(name))
+            m_lasOptions.add(name, options.getValueOrThrow<std::string>(name));
+}
+
+
+void OctreeWriter::ready(PointTableRef table)
+{
+    if (FileUtils::directoryExists(m_filename))
+    {
+        if (!m_overwrite)
+            throw pdal_error("OctreeWriter: Requested directory already "
+                "exists.  Use writers.octree.overwrite to delete the "
+                "existing directory.");
+        FileUtils::deleteDirectory(m_filename);
+    }
+    if (!FileUtils::createDirectory(m_filename) ||
+        !FileUtils::createDirectory(m_filename + "/data"))
+        throw pdal_error("OctreeWriter: Error creating directory '" +
+            m_filename + "'.");
+
+    m_srs = getSpatialReference().empty() ?
+        table.spatialRef() : getSpatialReference();
+
+    // The positions come first so that they can be read from the packed
+    // points directly.
+    using namespace Dimension;
+    PointLayoutPtr layout = table.layout();
+    m_dimTypes.clear();
+    m_dimTypes.push_back(DimType(Id::X, Type::Double));
+    m_dimTypes.push_back(DimType(Id::Y, Type::Double));
+    m_dimTypes.push_back(DimType(Id::Z, Type::Double));
+    for (const auto& dt : layout->dimTypes())
+        if (dt.m_id != Id::X && dt.m_id != Id::Y && dt.m_id != Id::Z)
+            m_dimTypes.push_back(dt);
+
+    m_store.reset(new PointTable);
+    if (m_memoryBudget)
+        m_store->setMemoryBudget(m_memoryBudget);
+    m_storeTypes.clear();
+    m_pointSize = 0;
+    for (const auto& dt : m_dimTypes)
+    {
+        Id::Enum id = m_store->layout()->registerOrAssignDim(
+            layout->dimName(dt.m_id), dt.m_type);
+        m_storeTypes.push_back(DimType(id, dt.m_type));
+        m_pointSize += Dimension::size(dt.m_type);
+    }
+    m_store->layout()->finalize();
+    m_points.reset(new PointView(*m_store));
+    m_bounds.clear();
+    m_hierarchy.clear();
+}
+
+
+// Points may arrive a chunk at a time when streaming, so they're copied to
+// the writer's own table and the octree is built once they've all arrived.
+void OctreeWriter::write(const PointViewPtr view)
+{
+    if (view->empty())
+        return;
+
+    std::vector<char> buf(m_pointSize);
+    for (PointId idx = 0; idx < view->size(); ++idx)
+    {
+        view->getPackedPoint(m_dimTypes, idx, buf.data());
+        m_points->setPackedPoint(m_storeTypes, m_points->size(), buf.data());
+    }
+    m_bounds.grow(view->calculateBounds());
+}
+
+
+void OctreeWriter::done(PointTableRef table)
+{
+    // The octree is a cube around the points.
+    if (m_points->size())
+    {
+        double size = (std::max)({ m_bounds.maxx - m_bounds.minx,
+            m_bounds.maxy - m_bounds.miny, m_bounds.maxz - m_bounds.minz });
+        if (size == 0)
+            size = 1;
+        double half = size / 2;
+        double midx = (m_bounds.minx + m_bounds.maxx) / 2;
+        double midy = (m_bounds.miny + m_bounds.maxy) / 2;
+        double midz = (m_bounds.minz + m_bounds.maxz) / 2;
+        m_cube = BOX3D(midx - half, midy - half, midz - half,
+            midx + half, midy + half, midz + half);
+
+        std::vector<Chunk> chunks = findChunks();
+
+        // The chunks are independent, so they're built at once.  Every
+        // task has to finish before an error is passed on since the tasks
+        // refer to the chunks.
+        ThreadPool& pool = ThreadPool::shared();
+        std::vector<std::future<void>> tasks;
+        for (Chunk& chunk : chunks)
+            tasks.push_back(pool.submit([this, &chunk]()
+                { buildChunk(chunk); }));
+        std::exception_ptr error;
+        for (auto& task : tasks)
+        {
+            try
+            {
+                pool.wait(task);
+            }
+            catch (...)
+            {
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+        if (error)
+            std::rethrow_exception(error);
+
+        // Hang the roots of the chunks from the nodes above them, which
+        // are then built from the roots' points.
+        std::vector<char> buf;
+        std::unique_ptr<Node> root(new Node(Key()));
+        for (Chunk& chunk : chunks)
+        {
+            uint32_t base = (uint32_t)(buf.size() / m_pointSize);
+            buf.insert(buf.end(), chunk.m_data.begin(), chunk.m_data.end());
+            std::vector<char>().swap(chunk.m_data);
+            for (uint32_t& id : chunk.m_root->m_ids)
+                id += base;
+
+            const Key& key = chunk.m_key;
+            if (key.d == 0)
+            {
+                root = std::move(chunk.m_root);
+                break;
+            }
+            Node *node = root.get();
+            for (uint32_t d = 1; d < key.d; ++d)
+            {
+                uint32_t shift = key.d - d;
+                int i = ((key.x >> shift) & 1) | (((key.y >> shift) & 1) << 1) |
+                    (((key.z >> shift) & 1) << 2);
+                std::unique_ptr<Node>& child = node->m_children[i];
+                if (!child)
+                    child.reset(new Node(node->m_key.child(i)));
+                node->m_hasChildren = true;
+                node = child.get();
+            }
+            int i = (key.x & 1) | ((key.y & 1) << 1) | ((key.z & 1) << 2);
+            node->m_children[i] = std::move(chunk.m_root);
+            node->m_hasChildren = true;
+        }
+        finish(*root, buf.data());
+        writeNode(*root, buf.data());
+    }
+    writeIndex();
+
+    m_points.reset();
+    m_store.reset();
+}
+
+
+// Count the points in each cell of a grid over the cube and split the
+// octree into subtrees of no more than a chunk's worth of points.
+std::vector<OctreeWriter::Chunk> OctreeWriter::findChunks()
+{
+    const point_count_t count = m_points->size();
+    const uint32_t depth = (std::min)(m_maxDepth, MaxGridDepth);
+    const uint32_t cells = 1 << depth;
+    const double size = m_cube.maxx - m_cube.minx;
+
+    std::vector<uint32_t> pointCells(count);
+    auto locate = [&](size_t begin, size_t end)
+    {
+        using namespace Dimension;
+        for (PointId idx = begin; idx < end; ++idx)
+        {
+            uint32_t x = cell(m_points->getFieldAs<double>(Id::X, idx),
+                m_cube.minx, size, cells);
+            uint32_t y = cell(m_points->getFieldAs<double>(Id::Y, idx),
+                m_cube.miny, size, cells);
+            uint32_t z = cell(m_points->getFieldAs<double>(Id::Z, idx),
+                m_cube.minz, size, cells);
+            pointCells[idx] = (z * cells + y) * cells + x;
+        }
+    };
+    ThreadPool& pool = ThreadPool::shared();
+    if (m_store->threadSafe())
+        pool.parallelFor(count, 4096, locate);
+    else
+        locate(0, count);
+
+    // Counts of the points in the nodes at each depth down to the grid.
+    std::vector<std::vector<point_count_t>> counts(depth + 1);
+    counts[depth].resize((size_t)cells * cells * cells);
+    for (uint32_t c : pointCells)
+        counts[depth][c]++;
+    for (uint32_t d = depth; d > 0; --d)
+    {
+        uint32_t n = 1 << d;
+        uint32_t m = n / 2;
+        counts[d - 1].resize((size_t)m * m * m);
+        for (uint32_t z = 0; z < n; ++z)
+            for (uint32_t y = 0; y < n; ++y)
+                for (uint32_t x = 0; x < n; ++x)
+                    counts[d - 1][((z / 2) * m + y / 2) * m + x / 2] +=
+                        counts[d][(z * n + y) * n + x];
+    }
+
+    point_count_t limit = count / (pool.size() * ChunksPerThread);
+    limit = (std::min)(limit, MaxChunkPoints);
+    limit = (std::max)(limit, m_maxNodePoints);
+
+    std::vector<Chunk> chunks;
+    std::vector<Key> keys(1, Key());
+    while (keys.size())
+    {
+        Key key = keys.back();
+        keys.pop_back();
+        uint32_t n = 1 << key.d;
+        point_count_t num = counts[key.d][(key.z * n + key.y) * n + key.x];
+        if (num == 0)
+            continue;
+        if (num <= limit || key.d == depth)
+            chunks.push_back(Chunk(key));
+        else
+            for (int i = 0; i < 8; ++i)
+                keys.push_back(key.child(i));
+    }
+
+    // Sort the points into the chunks by the cells they're in.
+    std::vector<uint32_t> cellChunks(counts[depth].size());
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        const Key& key = chunks[i].m_key;
+        uint32_t shift = depth - key.d;
+        uint32_t span = 1 << shift;
+        for (uint32_t z = 0; z < span; ++z)
+            for (uint32_t y = 0; y < span; ++y)
+                for (uint32_t x = 0; x < span; ++x)
+                    cellChunks[(((key.z << shift) + z) * cells +
+                        (key.y << shift) + y) * cells + (key.x << shift) + x] =
+                        (uint32_t)i;
+    }
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        const Key& key = chunks[i].m_key;
+        uint32_t n = 1 << key.d;
+        chunks[i].m_points.reserve(
+            counts[key.d][(key.z * n + key.y) * n + key.x]);
+    }
+    for (PointId idx = 0; idx < count; ++idx)
+        chunks[cellChunks[pointCells[idx]]].m_points.push_back(idx);
+    return chunks;
+}
+
+
+// Build and write the nodes of the chunk below its root.
+void OctreeWriter::buildChunk(Chunk& chunk)
+{
+    const point_count_t count = chunk.m_points.size();
+    std::vector<char> buf(count * m_pointSize);
+    {
+        std::unique_lock<std::mutex> lock(m_storeMutex, std::defer_lock);
+        if (!m_store->threadSafe())
+            lock.lock();
+        char *pos = buf.data();
+        for (PointId idx : chunk.m_points)
+        {
+            m_points->getPackedPoint(m_storeTypes, idx, pos);
+            pos += m_pointSize;
+        }
+    }
+    std::vector<PointId>().swap(chunk.m_points);
+
+    std::vector<uint32_t> ids(count);
+    for (uint32_t i = 0; i < count; ++i)
+        ids[i] = i;
+    chunk.m_root.reset(new Node(chunk.m_key));
+    build(*chunk.m_root, ids, buf.data());
+
+    // Keep the points of the root, which is finished with the nodes above.
+    std::vector<uint32_t>& rootIds = chunk.m_root->m_ids;
+    chunk.m_data.resize(rootIds.size() * m_pointSize);
+    for (uint32_t i = 0; i < rootIds.size(); ++i)
+    {
+        std::memcpy(chunk.m_data.data() + i * m_pointSize,
+            buf.data() + rootIds[i] * m_pointSize, m_pointSize);
+        rootIds[i] = i;
+    }
+}
+
+
+// Split the points among the children of the node until they're few enough
+// to be a leaf, then fill the node from the children and write them.
+void OctreeWriter::build(Node& node, std::vector<uint32_t>& ids,
+    const char *buf)
+{
+    node.m_built = true;
+    if (ids.size() <= m_maxNodePoints || node.m_key.d >= m_maxDepth)
+    {
+        node.m_ids.swap(ids);
+        return;
+    }
+
+    BOX3D b = node.m_key.bounds(m_cube);
+    double midx = (b.minx + b.maxx) / 2;
+    double midy = (b.miny + b.maxy) / 2;
+    double midz = (b.minz + b.maxz) / 2;
+    std::vector<uint32_t> childIds[8];
+    for (uint32_t id : ids)
+    {
+        Xyz p = position(buf, m_pointSize, id);
+        int i = (p.x >= midx ? 1 : 0) | (p.y >= midy ? 2 : 0) |
+            (p.z >= midz ? 4 : 0);
+        childIds[i].push_back(id);
+    }
+    std::vector<uint32_t>().swap(ids);
+
+    for (int i = 0; i < 8; ++i)
+        if (childIds[i].size())
+        {
+            node.m_children[i].reset(new Node(node.m_key.child(i)));
+            node.m_hasChildren = true;
+            build(*node.m_children[i], childIds[i], buf);
+        }
+    sample(node, buf);
+    for (auto& child : node.m_children)
+        if (child)
+        {
+            writeNode(*child, buf);
+            child.reset();
+        }
+}
+
+
+// Build and write the nodes above the roots of the chunks, which have
+// been built already.
+void OctreeWriter::finish(Node& node, const char *buf)
+{
+    if (node.m_built)
+        return;
+    for (auto& child : node.m_children)
+        if (child)
+            finish(*child, buf);
+    sample(node, buf);
+    node.m_built = true;
+    for (auto& child : node.m_children)
+        if (child)
+        {
+            writeNode(*child, buf);
+            child.reset();
+        }
+}
+
+
+// Move the points of the children nearest the centers of the cells of the
+// node's sampling grid up to the node, one per cell.
+void OctreeWriter::sample(Node& node, const char *buf)
+{
+    struct Candidate
+    {
+        double m_dist;
+        int m_child;
+        size_t m_pos;
+    };
+
+    BOX3D b = node.m_key.bounds(m_cube);
+    const double size = b.maxx - b.minx;
+    const double cellSize = size / m_resolution;
+    const uint64_t res = m_resolution;
+
+    std::unordered_map<uint64_t, Candidate> best;
+    for (int i = 0; i < 8; ++i)
+    {
+        if (!node.m_children[i])
+            continue;
+        const std::vector<uint32_t>& ids = node.m_children[i]->m_ids;
+        for (size_t pos = 0; pos < ids.size(); ++pos)
+        {
+            Xyz p = position(buf, m_pointSize, ids[pos]);
+            uint32_t x = cell(p.x, b.minx, size, m_resolution);
+            uint32_t y = cell(p.y, b.miny, size, m_resolution);
+            uint32_t z = cell(p.z, b.minz, size, m_resolution);
+            double dx = p.x - (b.minx + (x + .5) * cellSize);
+            double dy = p.y - (b.miny + (y + .5) * cellSize);
+            double dz = p.z - (b.minz + (z + .5) * cellSize);
+            Candidate c { dx * dx + dy * dy + dz * dz, i, pos };
+
+            auto r = best.insert(std::make_pair((z * res + y) * res + x, c));
+            if (!r.second && c.m_dist < r.first->second.m_dist)
+                r.first->second = c;
+        }
+    }
+
+    std::vector<std::vector<bool>> taken(8);
+    for (int i = 0; i < 8; ++i)
+        if (node.m_children[i])
+            taken[i].resize(node.m_children[i]->m_ids.size());
+    for (const auto& cell : best)
+        taken[cell.second.m_child][cell.second.m_pos] = true;
+
+    node.m_ids.reserve(node.m_ids.size() + best.size());
+    for (int i = 0; i < 8; ++i)
+    {
+        if (!node.m_children[i])
+            continue;
+        std::vector<uint32_t>& ids = node.m_children[i]->m_ids;
+        std::vector<uint32_t> kept;
+        kept.reserve(ids.size());
+        for (size_t pos = 0; pos < ids.size(); ++pos)
+            if (taken[i][pos])
+                node.m_ids.push_back(ids[pos]);
+            else
+                kept.push_back(ids[pos]);
+        ids.swap(kept);
+    }
+}
+
+
+// Write the points of the node to a file of its own, named by its key.
+void OctreeWriter::writeNode(const Node& node, const char *buf)
+{
+    if (node.m_ids.empty())
+    {
+        // A node without points is only recorded if there are nodes
+        // below it.
+        if (node.m_hasChildren)
+        {
+            std::lock_guard<std::mutex> lock(m_hierarchyMutex);
+            m_hierarchy[node.m_key] = 0;
+        }
+        return;
+    }
+
+    PointTable table;
+    PointLayoutPtr layout = table.layout();
+    DimTypeList dimTypes;
+    for (const auto& dt : m_storeTypes)
+    {
+        Dimension::Id::Enum id = layout->registerOrAssignDim(
+            m_store->layout()->dimName(dt.m_id), dt.m_type);
+        dimTypes.push_back(DimType(id, dt.m_type));
+    }
+    layout->finalize();
+    table.setSpatialRef(m_srs);
+
+    PointViewPtr view(new PointView(table));
+    for (PointId idx = 0; idx < node.m_ids.size(); ++idx)
+        view->setPackedPoint(dimTypes, idx,
+            buf + node.m_ids[idx] * m_pointSize);
+
+    Options options(m_lasOptions);
+    options.add("filename", m_filename + "/data/" + node.m_key.toString() +
+        m_extension);
+    options.add("offset_x", (m_cube.minx + m_cube.maxx) / 2);
+    options.add("offset_y", (m_cube.miny + m_cube.maxy) / 2);
+    options.add("offset_z", (m_cube.minz + m_cube.maxz) / 2);
+
+    BufferReader reader;
+    reader.addView(view);
+    LasWriter writer;
+    writer.setOptions(options);
+    writer.setInput(reader);
+    writer.prepare(table);
+    writer.execute(table);
+
+    std::lock_guard<std::mutex> lock(m_hierarchyMutex);
+    m_hierarchy[node.m_key] = node.m_ids.size();
+}
+
+
+// Write octree.json, which describes the octree and lists the number of
+// points in each node.
+void OctreeWriter::writeIndex()
+{
+    std::string filename(m_filename + "/octree.json");
+    std::ofstream out(filename);
+    if (!out)
+        throw pdal_error("OctreeWriter: Unable to open '" + filename + "'.");
+
+    auto box = [&out](const BOX3D& b)
+    {
+        out << "[" << b.minx << ", " << b.miny << ", " << b.minz << ", " <<
+            b.maxx << ", " << b.maxy << ", " << b.maxz << "]";
+    };
+
+    point_count_t count = 0;
+    for (const auto& node : m_hierarchy)
+        count += node.second;
+
+    out << std::setprecision(15);
+    out << "{\n";
+    out << "    \"version\": 1,\n";
+    out << "    \"bounds\": ";
+    box(m_hierarchy.empty() ? BOX3D() : m_cube);
+    out << ",\n";
+    out << "    \"dataBounds\": ";
+    box(m_hierarchy.empty() ? BOX3D() : m_bounds);
+    out << ",\n";
+    out << "    \"points\": " << count << ",\n";
+    out << "    \"maxNodePoints\": " << m_maxNodePoints << ",\n";
+    out << "    \"resolution\": " << m_resolution << ",\n";
+    out << "    \"scale\": " << m_scale << ",\n";
+    out << "    \"dataType\": \"" << m_extension.substr(1) << "\",\n";
+    out << "    \"srs\": \"" << Utils::escapeJSON(m_srs.getWKT()) << "\",\n";
+    out << "    \"hierarchy\": {";
+    const char *sep = "\n";
+    for (const auto& node : m_hierarchy)
+    {
+        out << sep << "        \"" << node.first.toString() << "\": " <<
+            node.second;
+        sep = ",\n";
+    }
+    out << "\n    }\n";
+    out << "}\n";
+    if (!out)
+        throw pdal_error("OctreeWriter: Error writing '" + filename + "'.");
+}
+
+} // namespace pdal
@@ -0,0 +1,132 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_export.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/Writer.hpp>
+#include <pdal/util/Bounds.hpp>
+
+#include "OctreeCommon.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C" int32_t OctreeWriter_ExitFunc();
+extern "C" PF_ExitFunc OctreeWriter_InitPlugin();
+
+namespace pdal
+{
+
+// Writes the points as an octree of LAS/LAZ files, one per node, and a
+// JSON index of the nodes, so that clients can fetch the parts of the data
+// and the level of detail they need.  Each node holds a sample of the
+// points below it, at most one for each cell of a grid laid over the node,
+// and leaves hold the rest.
+class PDAL_DLL OctreeWriter : public Writer
+{
+public:
+    typedef OctreeKey Key;
+
+    OctreeWriter()
+        {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+    // Points are copied as they arrive and the octree is built in done().
+    virtual bool streamable() const
+        { return true; }
+
+    Options getDefaultOptions();
+
+private:
+    struct Node;
+    struct Chunk;
+
+    bool m_overwrite;
+    uint32_t m_maxDepth;
+    point_count_t m_maxNodePoints;
+    uint32_t m_resolution;
+    std::size_t m_memoryBudget;
+    double m_scale;
+    Options m_lasOptions;
+    std::string m_extension;
+
+    // The points sent to the writer, which are its own so that they can
+    // be streamed in and spilled to disk if they don't fit in the budget.
+    std::unique_ptr<PointTable> m_store;
+    PointViewPtr m_points;
+    // The dimensions of a point as packed: X, Y and Z as doubles followed
+    // by the other dimensions, in the ids of the input table and of
+    // m_store.
+    DimTypeList m_dimTypes;
+    DimTypeList m_storeTypes;
+    std::size_t m_pointSize;
+    BOX3D m_bounds;
+    BOX3D m_cube;
+    SpatialReference m_srs;
+
+    // Points in each node written, or 0 for nodes that have children but
+    // no points of their own.
+    std::map<Key, point_count_t> m_hierarchy;
+    std::mutex m_hierarchyMutex;
+    // Held while reading m_store from a chunk's task if the store isn't
+    // thread safe.
+    std::mutex m_storeMutex;
+
+    virtual void processOptions(const Options& options);
+    virtual void ready(PointTableRef table);
+    virtual void write(const PointViewPtr view);
+    virtual void done(PointTableRef table);
+
+    std::vector<Chunk> findChunks();
+    void buildChunk(Chunk& chunk);
+    void build(Node& node, std::vector<uint32_t>& ids, const char *buf);
+    void finish(Node& node, const char *buf);
+    void sample(Node& node, const char *buf);
+    void writeNode(const Node& node, const char *buf);
+    void writeIndex();
+
+    OctreeWriter& operator=(const OctreeWriter&); // not implemented
+    OctreeWriter(const OctreeWriter&); // not implemented
+};
+
+} // namespace pdal
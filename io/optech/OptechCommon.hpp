@@ -93,20 +93,23 @@ typedef struct
 inline pdal::georeference::RotationMatrix
 createOptechRotationMatrix(double roll, double pitch, double heading)
 {
+    const double sr = std::sin(roll);
+    const double cr = std::cos(roll);
+    const double sp = std::sin(pitch);
+    const double cp = std::cos(pitch);
+    const double sh = std::sin(heading);
+    const double ch = std::cos(heading);
+
     return georeference::RotationMatrix(
-        std::cos(roll) * std::cos(heading) +
-            std::sin(pitch) * std::sin(roll) * std::sin(heading), // m00
-        std::cos(pitch) * std::sin(heading),                      // m01
-        std::cos(heading) * std::sin(roll) -
-            std::cos(roll) * std::sin(pitch) * std::sin(heading), // m02
-        std::cos(heading) * std::sin(pitch) * std::sin(roll) -
-            std::cos(roll) * std::sin(heading), // m10
-        std::cos(pitch) * std::cos(heading),    // m11
-        -std::sin(roll) * std::sin(heading) -
-            std::cos(roll) * std::cos(heading) * std::sin(pitch), // m12
-        -std::cos(pitch) * std::sin(roll),                        // m20
-        std::sin(pitch),                                          // m21
-        std::cos(pitch) * std::cos(roll)                          // m22
+        cr * ch + sp * sr * sh,   // m00
+        cp * sh,                  // m01
+        ch * sr - cr * sp * sh,   // m02
+        ch * sp * sr - cr * sh,   // m10
+        cp * ch,                  // m11
+        -sr * sh - cr * ch * sp,  // m12
+        -cp * sr,                 // m20
+        sp,                       // m21
+        cp * cr                   // m22
         );
 }
 }
@@ -61,6 +61,7 @@ std::string OptechReader::getName() const
 const size_t OptechReader::MaximumNumberOfReturns;
 const size_t OptechReader::MaxNumRecordsInBuffer;
 const size_t OptechReader::NumBytesInRecord;
+const size_t OptechReader::MaxNumReturnsInBatch;
 #endif
 
 OptechReader::OptechReader()
@@ -173,88 +174,139 @@ point_count_t OptechReader::read(PointViewPtr data,
     point_count_t numRead = 0;
     point_count_t dataIndex = data->size();
 
-    while (numRead < countRequested)
+    // Returns are gathered a batch at a time and georeferenced together.
+    std::vector<CsdPulse> pulses;
+    std::vector<size_t> pulseIndices;
+    std::vector<size_t> returnIndices;
+    std::vector<double> ranges;
+    std::vector<double> scanAngles;
+    std::vector<georeference::RotationMatrix> imuMatrices;
+    std::vector<georeference::Xyz> gpsPoints;
+    std::vector<georeference::Xyz> points;
+
+    bool eof = false;
+    while (numRead < countRequested && !eof)
     {
-        if (m_returnIndex == 0)
+        size_t batchSize = std::min<point_count_t>(
+            countRequested - numRead, MaxNumReturnsInBatch);
+        pulses.clear();
+        pulseIndices.clear();
+        returnIndices.clear();
+        ranges.clear();
+        scanAngles.clear();
+        imuMatrices.clear();
+        gpsPoints.clear();
+
+        // A pulse whose returns were only partly read last time carries
+        // over into this batch.
+        if (m_returnIndex != 0)
+            pulses.push_back(m_pulse);
+
+        while (ranges.size() < batchSize)
         {
-            if (!m_extractor.good())
+            if (m_returnIndex == 0)
             {
-                if (m_recordIndex >= m_header.numRecords)
+                if (!m_extractor.good())
                 {
-                    break;
+                    if (m_recordIndex >= m_header.numRecords)
+                    {
+                        eof = true;
+                        break;
+                    }
+                    m_recordIndex += fillBuffer();
+                }
+
+                m_extractor >> m_pulse.gpsTime >> m_pulse.returnCount >>
+                    m_pulse.range[0] >> m_pulse.range[1] >>
+                    m_pulse.range[2] >> m_pulse.range[3] >>
+                    m_pulse.intensity[0] >> m_pulse.intensity[1] >>
+                    m_pulse.intensity[2] >> m_pulse.intensity[3] >>
+                    m_pulse.scanAngle >> m_pulse.roll >> m_pulse.pitch >>
+                    m_pulse.heading >> m_pulse.latitude >>
+                    m_pulse.longitude >> m_pulse.elevation;
+
+                if (m_pulse.returnCount == 0)
+                {
+                    m_returnIndex = 0;
+                    continue;
                 }
-                m_recordIndex += fillBuffer();
-            }
 
-            m_extractor >> m_pulse.gpsTime >> m_pulse.returnCount >>
-                m_pulse.range[0] >> m_pulse.range[1] >> m_pulse.range[2] >>
-                m_pulse.range[3] >> m_pulse.intensity[0] >>
-                m_pulse.intensity[1] >> m_pulse.intensity[2] >>
-                m_pulse.intensity[3] >> m_pulse.scanAngle >> m_pulse.roll >>
-                m_pulse.pitch >> m_pulse.heading >> m_pulse.latitude >>
-                m_pulse.longitude >> m_pulse.elevation;
+                // In all the csd files that we've tested, the longitude
+                // values have been less than -2pi.
+                if (m_pulse.longitude < -M_PI * 2)
+                {
+                    m_pulse.longitude = m_pulse.longitude + M_PI * 2;
+                }
+                else if (m_pulse.longitude > M_PI * 2)
+                {
+                    m_pulse.longitude = m_pulse.longitude - M_PI * 2;
+                }
+                pulses.push_back(m_pulse);
+            }
 
-            if (m_pulse.returnCount == 0)
+            const CsdPulse& pulse = pulses.back();
+            if (returnIndices.empty() || m_returnIndex == 0)
+                imuMatrices.push_back(createOptechRotationMatrix(pulse.roll,
+                    pulse.pitch, pulse.heading));
+            else
+                imuMatrices.push_back(imuMatrices.back());
+            gpsPoints.push_back(georeference::Xyz(pulse.longitude,
+                pulse.latitude, pulse.elevation));
+            ranges.push_back(pulse.range[m_returnIndex]);
+            scanAngles.push_back(pulse.scanAngle);
+            pulseIndices.push_back(pulses.size() - 1);
+            returnIndices.push_back(m_returnIndex);
+
+            ++m_returnIndex;
+            if (m_returnIndex >= pulse.returnCount ||
+                m_returnIndex >= MaximumNumberOfReturns)
             {
                 m_returnIndex = 0;
-                continue;
             }
+        }
+
+        points.assign(ranges.size(), georeference::Xyz(0, 0, 0));
+        georeference::georeferenceWgs84(ranges.size(), ranges.data(),
+            scanAngles.data(), m_boresightMatrix, imuMatrices.data(),
+            gpsPoints.data(), points.data());
 
-            // In all the csd files that we've tested, the longitude
-            // values have been less than -2pi.
-            if (m_pulse.longitude < -M_PI * 2)
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const CsdPulse& pulse = pulses[pulseIndices[i]];
+            size_t returnIndex = returnIndices[i];
+            const georeference::Xyz& point = points[i];
+
+            data->setField(Dimension::Id::X, dataIndex,
+                point.X * 180 / M_PI);
+            data->setField(Dimension::Id::Y, dataIndex,
+                point.Y * 180 / M_PI);
+            data->setField(Dimension::Id::Z, dataIndex, point.Z);
+            data->setField(Dimension::Id::GpsTime, dataIndex,
+                pulse.gpsTime);
+            if (returnIndex == MaximumNumberOfReturns - 1)
             {
-                m_pulse.longitude = m_pulse.longitude + M_PI * 2;
+                data->setField(Dimension::Id::ReturnNumber, dataIndex,
+                              pulse.returnCount);
             }
-            else if (m_pulse.longitude > M_PI * 2)
+            else
             {
-                m_pulse.longitude = m_pulse.longitude - M_PI * 2;
+                data->setField(Dimension::Id::ReturnNumber, dataIndex,
+                              returnIndex + 1);
             }
-        }
-
-        georeference::Xyz gpsPoint = georeference::Xyz(
-            m_pulse.longitude, m_pulse.latitude, m_pulse.elevation);
-        georeference::RotationMatrix rotationMatrix =
-            createOptechRotationMatrix(m_pulse.roll, m_pulse.pitch,
-                                       m_pulse.heading);
-        georeference::Xyz point = pdal::georeference::georeferenceWgs84(
-            m_pulse.range[m_returnIndex], m_pulse.scanAngle,
-            m_boresightMatrix, rotationMatrix, gpsPoint);
-
-        data->setField(Dimension::Id::X, dataIndex, point.X * 180 / M_PI);
-        data->setField(Dimension::Id::Y, dataIndex, point.Y * 180 / M_PI);
-        data->setField(Dimension::Id::Z, dataIndex, point.Z);
-        data->setField(Dimension::Id::GpsTime, dataIndex, m_pulse.gpsTime);
-        if (m_returnIndex == MaximumNumberOfReturns - 1)
-        {
-            data->setField(Dimension::Id::ReturnNumber, dataIndex,
-                          m_pulse.returnCount);
-        }
-        else
-        {
-            data->setField(Dimension::Id::ReturnNumber, dataIndex,
-                          m_returnIndex + 1);
-        }
-        data->setField(Dimension::Id::NumberOfReturns, dataIndex,
-                      m_pulse.returnCount);
-        data->setField(Dimension::Id::EchoRange, dataIndex,
-                      m_pulse.range[m_returnIndex]);
-        data->setField(Dimension::Id::Intensity, dataIndex,
-                      m_pulse.intensity[m_returnIndex]);
-        data->setField(Dimension::Id::ScanAngleRank, dataIndex,
-                      m_pulse.scanAngle * 180 / M_PI);
-
-        if (m_cb)
-            m_cb(*data, dataIndex);
-
-        ++dataIndex;
-        ++numRead;
-        ++m_returnIndex;
-
-        if (m_returnIndex >= m_pulse.returnCount ||
-            m_returnIndex >= MaximumNumberOfReturns)
-        {
-            m_returnIndex = 0;
+            data->setField(Dimension::Id::NumberOfReturns, dataIndex,
+                          pulse.returnCount);
+            data->setField(Dimension::Id::EchoRange, dataIndex,
+                          pulse.range[returnIndex]);
+            data->setField(Dimension::Id::Intensity, dataIndex,
+                          pulse.intensity[returnIndex]);
+            data->setField(Dimension::Id::ScanAngleRank, dataIndex,
+                          pulse.scanAngle * 180 / M_PI);
+
+            if (m_cb)
+                m_cb(*data, dataIndex);
+
+            ++dataIndex;
+            ++numRead;
         }
     }
     return numRead;
@@ -62,6 +62,7 @@ public:
     static const size_t MaximumNumberOfReturns = 4;
     static const size_t NumBytesInRecord = 69;
     static const size_t MaxNumRecordsInBuffer = 1e6 / NumBytesInRecord;
+    static const size_t MaxNumReturnsInBatch = 4096;
 
     OptechReader();
 
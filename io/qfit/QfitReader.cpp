@@ -169,7 +169,9 @@ Word #       Content
 #include "QfitReader.hpp"
 
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/portable_endian.hpp>
+#include <pdal/util/Endian.hpp>
 #include <pdal/util/Extractor.hpp>
 
 #include <algorithm>
@@ -192,6 +194,14 @@ CREATE_STATIC_PLUGIN(1, 0, QfitReader, Reader, s_info)
 
 std::string QfitReader::getName() const { return s_info.name; }
 
+namespace
+{
+
+// Points are read from the file in blocks of this many records.
+const point_count_t BlockPoints = 16384;
+
+} // unnamed namespace
+
 QfitReader::QfitReader()
     : pdal::Reader()
     , m_format(QFIT_Format_Unknown)
@@ -292,6 +302,7 @@ void QfitReader::processOptions(const Options& ops)
 {
     m_flip_x = ops.getValueOrDefault("flip_coordinates", true);
     m_scale_z = ops.getValueOrDefault("scale_z", 0.001);
+    m_start = ops.getValueOrDefault<point_count_t>("start", 0);
 }
 
 
@@ -339,9 +350,10 @@ void QfitReader::ready(PointTableRef)
             "inconsistent with point size.";
         throw qfit_error(msg.str());
     }
-    m_index = 0;
+    // Skip to the first point to read.  The records are of fixed size.
+    m_index = std::min(m_start, m_numPoints);
     m_istream.reset(new IStream(m_filename));
-    m_istream->seek(getPointDataOffset());
+    m_istream->seek(getPointDataOffset() + m_index * m_size);
 }
 
 
@@ -357,78 +369,97 @@ point_count_t QfitReader::read(PointViewPtr data, point_count_t count)
     }
 
     count = std::min(m_numPoints - m_index, count);
-    std::vector<char> buf(m_size);
-    PointId nextId = data->size();
+
+    // Records are all 32-bit words.  Read blocks of records, swap the
+    // words of a block to host order in one pass and decode the records
+    // into points added to the view beforehand, on worker threads when the
+    // table is threadSafe().
+    const size_t numWords = m_size / sizeof(int32_t);
+    std::vector<int32_t> words;
     point_count_t numRead = 0;
-    while (count--)
+    while (numRead < count)
     {
-        m_istream->get(buf);
-        SwitchableExtractor extractor(buf.data(), m_size, m_littleEndian);
-
-        // always read the base fields
+        const point_count_t blockCount = std::min(BlockPoints,
+            count - numRead);
+        words.resize(blockCount * numWords);
+        m_istream->get((char *)words.data(), blockCount * m_size);
+        if (!m_istream->good())
+            throw qfit_error("Unable to read points from file '" +
+                m_filename + "'.");
+
+        if (m_littleEndian)
+            Endian::littleToHost(words.data(), words.size());
+        else
+            Endian::bigToHost(words.data(), words.size());
+
+        const PointId baseId = data->size();
+        data->appendTablePoints(blockCount);
+        auto load = [this, &data, &words, numWords, baseId](size_t begin,
+            size_t end)
         {
-            int32_t time, y, xi, z, start_pulse, reflected_pulse, scan_angle,
-                pitch, roll;
-            extractor >> time >> y >> xi >> z >> start_pulse >>
-                reflected_pulse >> scan_angle >> pitch >> roll;
-            double x = xi / 1000000.0;
-            if (m_flip_x && x > 180)
-                x -= 360;
-
-            data->setField(Dimension::Id::OffsetTime, nextId, time);
-            data->setField(Dimension::Id::Y, nextId, y / 1000000.0);
-            data->setField(Dimension::Id::X, nextId, x);
-            data->setField(Dimension::Id::Z, nextId, z * m_scale_z);
-            data->setField(Dimension::Id::StartPulse, nextId, start_pulse);
-            data->setField(Dimension::Id::ReflectedPulse, nextId,
-                reflected_pulse);
-            data->setField(Dimension::Id::ScanAngleRank, nextId,
-                scan_angle / 1000.0);
-            data->setField(Dimension::Id::Pitch, nextId, pitch / 1000.0);
-            data->setField(Dimension::Id::Roll, nextId, roll / 1000.0);
-        }
-
-        if (m_format == QFIT_Format_12)
-        {
-            int32_t pdop, pulse_width;
-            extractor >> pdop >> pulse_width;
-            data->setField(Dimension::Id::Pdop, nextId, pdop / 10.0);
-            data->setField(Dimension::Id::PulseWidth, nextId, pulse_width);
-        }
-        else if (m_format == QFIT_Format_14)
-        {
-            int32_t passive_signal, passive_y, passive_x, passive_z;
-            extractor >> passive_signal >> passive_y >> passive_x >> passive_z;
-            double x = passive_x / 1000000.0;
-            if (m_flip_x && x > 180)
-                x -= 360;
-            data->setField(Dimension::Id::PassiveSignal, nextId, passive_signal);
-            data->setField(Dimension::Id::PassiveY, nextId,
-                passive_y / 1000000.0);
-            data->setField(Dimension::Id::PassiveX, nextId, x);
-            data->setField(Dimension::Id::PassiveZ, nextId,
-                passive_z * m_scale_z);
-        }
-        // GPS time is really a GPS offset from the start of the GPS day
-        // encoded in this odd way: 153320100 = 15 hours 33 minutes
-        // 20 seconds 100 milliseconds.
-        // Not sure why we have that AND the other offset time.  For now
-        // we'll just extract this time and drop it.
-        int32_t gpstime;
-        extractor >> gpstime;
+            for (size_t i = begin; i < end; ++i)
+                loadPoint(*data, baseId + i, words.data() + i * numWords);
+        };
+        if (data->table().threadSafe())
+            ThreadPool::shared().parallelFor(blockCount, 1024, load);
+        else
+            load(0, blockCount);
 
         if (m_cb)
-            m_cb(*data, nextId);
-
-        numRead++;
-        nextId++;
+            for (PointId id = baseId; id < baseId + blockCount; ++id)
+                m_cb(*data, id);
+        numRead += blockCount;
+        m_index += blockCount;
     }
-    m_index += numRead;
 
     return numRead;
 }
 
 
+// Set point 'id' of the view from the words of its record.
+void QfitReader::loadPoint(PointView& data, PointId id,
+    const int32_t *words) const
+{
+    // always read the base fields
+    {
+        double x = words[2] / 1000000.0;
+        if (m_flip_x && x > 180)
+            x -= 360;
+
+        data.setField(Dimension::Id::OffsetTime, id, words[0]);
+        data.setField(Dimension::Id::Y, id, words[1] / 1000000.0);
+        data.setField(Dimension::Id::X, id, x);
+        data.setField(Dimension::Id::Z, id, words[3] * m_scale_z);
+        data.setField(Dimension::Id::StartPulse, id, words[4]);
+        data.setField(Dimension::Id::ReflectedPulse, id, words[5]);
+        data.setField(Dimension::Id::ScanAngleRank, id, words[6] / 1000.0);
+        data.setField(Dimension::Id::Pitch, id, words[7] / 1000.0);
+        data.setField(Dimension::Id::Roll, id, words[8] / 1000.0);
+    }
+
+    if (m_format == QFIT_Format_12)
+    {
+        data.setField(Dimension::Id::Pdop, id, words[9] / 10.0);
+        data.setField(Dimension::Id::PulseWidth, id, words[10]);
+    }
+    else if (m_format == QFIT_Format_14)
+    {
+        double x = words[11] / 1000000.0;
+        if (m_flip_x && x > 180)
+            x -= 360;
+        data.setField(Dimension::Id::PassiveSignal, id, words[9]);
+        data.setField(Dimension::Id::PassiveY, id, words[10] / 1000000.0);
+        data.setField(Dimension::Id::PassiveX, id, x);
+        data.setField(Dimension::Id::PassiveZ, id, words[12] * m_scale_z);
+    }
+    // The last word, GPS time, is really a GPS offset from the start of
+    // the GPS day encoded in this odd way: 153320100 = 15 hours 33 minutes
+    // 20 seconds 100 milliseconds.
+    // Not sure why we have that AND the other offset time.  For now
+    // we'll just drop it.
+}
+
+
 Dimension::IdList QfitReader::getDefaultDimensions()
 {
     Dimension::IdList ids;
@@ -103,6 +103,7 @@ private:
     point_count_t m_numPoints;
     std::unique_ptr<IStream> m_istream;
     point_count_t m_index;
+    point_count_t m_start;
 
     virtual void processOptions(const Options& ops);
     virtual void initialize();
@@ -110,6 +111,7 @@ private:
     virtual void ready(PointTableRef table);
     virtual point_count_t read(PointViewPtr buf, point_count_t count);
     virtual void done(PointTableRef table);
+    void loadPoint(PointView& view, PointId id, const int32_t *words) const;
 
     QfitReader& operator=(const QfitReader&); // not implemented
     QfitReader(const QfitReader&); // not implemented
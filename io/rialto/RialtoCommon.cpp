@@ -34,12 +34,12 @@
 
 #include "RialtoCommon.hpp"
 
-#include <pdal/Log.hpp>
+#include <pdal/pdal_error.hpp>
 #include <pdal/pdal_types.hpp>
-#include <pdal/PointView.hpp>
 #include <pdal/util/FileUtils.hpp>
 
 #include <cmath>
+#include <string>
 
 namespace pdal
 {
@@ -49,32 +49,19 @@ Tile::Tile(
         int32_t tx,
         int32_t ty,
         Rectangle r,
-        int32_t maxLevel,
-        const PointTableRef table,
-        LogPtr log) :
+        int32_t maxLevel) :
     m_level(level),
     m_tileX(tx),
     m_tileY(ty),
+    m_children(NULL),
     m_rect(r),
     m_maxLevel(maxLevel),
-    m_skip(0),
-    m_table(table),
-    m_log(log)
+    m_skip(0)
 {
     assert(m_level >= 0);
     assert(m_tileX >= 0);
     assert(m_tileY >= 0);
     assert(m_maxLevel >= 0);
-    m_log->get(LogLevel::Debug1) << "created tb (l=" << m_level
-        << ", tx=" << m_tileX
-        << ", ty=" << m_tileY
-        << ") (slip" << m_skip
-        << ")  --  w" << m_rect.m_west
-        << " s" << m_rect.m_south
-        << " e" << m_rect.m_east
-        << " n" << m_rect.m_north << "\n";
-
-    m_children = NULL;
 
     // level N+1 has 1/4 the points of level N
     //
@@ -90,48 +77,39 @@ Tile::Tile(
     // 3-0=3  skip 64    4^3
     //
     m_skip = std::pow(4, (m_maxLevel - m_level));
-    m_log->get(LogLevel::Debug1) << "level=" << m_level
-        << "  skip=" << m_skip << "\n";
 }
 
 
 Tile::~Tile()
 {
-    if (m_children == NULL)
-    {
-        for (size_t i=0; i<m_points.size(); ++i)
-        {
-            char* p = m_points[i];
-            delete[] p;
-        }
-    }
-    else
+    if (m_children)
     {
         for (int i=0; i<4; ++i)
-        {
-            if (m_children[i])
-            {
-                delete m_children[i];
-            }
-        }
+            delete m_children[i];
         delete[] m_children;
     }
 }
 
-void Tile::add(PointId pointNumber, char* p, double lon, double lat)
+
+void Tile::add(PointId pointNumber, PointId pos, double lon, double lat)
 {
-    assert(m_rect.contains(lon, lat));
+    Tile *tile = this;
+    while (tile)
+        tile = tile->addLocal(pointNumber, pos, lon, lat);
+}
 
-    m_log->get(LogLevel::Debug5) << "-- -- " << pointNumber
-        << " " << m_skip
-        << " " << (pointNumber % m_skip == 0) << "\n";
+
+Tile *Tile::addLocal(PointId pointNumber, PointId pos, double lon,
+    double lat)
+{
+    assert(m_rect.contains(lon, lat));
 
     if (pointNumber % m_skip == 0)
     {
-        m_points.push_back(p);
+        m_points.push_back(pos);
     }
 
-    if (m_level == m_maxLevel) return;
+    if (m_level == m_maxLevel) return NULL;
 
     if (!m_children)
     {
@@ -143,7 +121,6 @@ void Tile::add(PointId pointNumber, char* p, double lon, double lat)
     }
 
     Quad q = m_rect.getQuadrantOf(lon, lat);
-    m_log->get(LogLevel::Debug5) << "which=" << q << "\n";
 
     Tile* child = m_children[q];
     if (child == NULL)
@@ -152,16 +129,16 @@ void Tile::add(PointId pointNumber, char* p, double lon, double lat)
         switch (q)
         {
             case QuadSW:
-                child = new Tile(m_level+1, m_tileX*2, m_tileY*2+1, r, m_maxLevel, m_table, m_log);
+                child = new Tile(m_level+1, m_tileX*2, m_tileY*2+1, r, m_maxLevel);
                 break;
             case QuadNW:
-                child = new Tile(m_level+1, m_tileX*2, m_tileY*2, r, m_maxLevel, m_table, m_log);
+                child = new Tile(m_level+1, m_tileX*2, m_tileY*2, r, m_maxLevel);
                 break;
             case QuadSE:
-                child = new Tile(m_level+1, m_tileX*2+1, m_tileY*2+1, r, m_maxLevel, m_table, m_log);
+                child = new Tile(m_level+1, m_tileX*2+1, m_tileY*2+1, r, m_maxLevel);
                 break;
             case QuadNE:
-                child = new Tile(m_level+1, m_tileX*2+1, m_tileY*2, r, m_maxLevel, m_table, m_log);
+                child = new Tile(m_level+1, m_tileX*2+1, m_tileY*2, r, m_maxLevel);
                 break;
             default:
                 assert(0);
@@ -169,10 +146,11 @@ void Tile::add(PointId pointNumber, char* p, double lon, double lat)
         m_children[q] = child;
     }
 
-    child->add(pointNumber, p, lon, lat);
+    return child;
 }
 
-void Tile::collectStats(std::vector<int32_t> numTilesPerLevel, std::vector<int64_t> numPointsPerLevel) const
+void Tile::collectStats(std::vector<int32_t>& numTilesPerLevel,
+    std::vector<int64_t>& numPointsPerLevel) const
 {
     numPointsPerLevel[m_level] += m_points.size();
     ++numTilesPerLevel[m_level];
@@ -186,28 +164,49 @@ void Tile::collectStats(std::vector<int32_t> numTilesPerLevel, std::vector<int64
     }
 }
 
-void Tile::write(const char* prefix) const
+void Tile::write(const char* prefix, const PointView& view,
+    const DimTypeList& dims, size_t pointSize) const
 {
-    char* filename = new char[strlen(prefix) + 1024];
+    writeTile(prefix, view, dims, pointSize);
 
-    sprintf(filename, "%s", prefix);
-    FileUtils::createDirectory(filename);
+    if (m_children)
+    {
+        for (int i=0; i<4; ++i)
+        {
+            if (m_children[i])
+            {
+                m_children[i]->write(prefix, view, dims, pointSize);
+            }
+        }
+    }
+}
 
-    sprintf(filename, "%s/%d", prefix, m_level);
-    FileUtils::createDirectory(filename);
 
-    sprintf(filename, "%s/%d/%d", prefix, m_level, m_tileX);
+void Tile::writeTile(const char* prefix, const PointView& view,
+    const DimTypeList& dims, size_t pointSize) const
+{
+    // Tiles may be written from several threads at once.  Creating a
+    // directory that already exists isn't an error.
+    std::string filename(prefix);
     FileUtils::createDirectory(filename);
 
-    sprintf(filename, "%s/%d/%d/%d.ria", prefix, m_level, m_tileX, m_tileY);
+    filename += "/" + std::to_string(m_level);
+    FileUtils::createDirectory(filename);
 
-    m_log->get(LogLevel::Debug1) << "--> " << filename << "\n";
+    filename += "/" + std::to_string(m_tileX);
+    FileUtils::createDirectory(filename);
 
-    FILE* fp = fopen(filename, "wb");
+    filename += "/" + std::to_string(m_tileY) + ".ria";
 
-    writeData(fp);
+    // The points, followed by the child mask.
+    std::vector<char> buf(m_points.size() * pointSize + 1);
+    char *p = buf.data();
+    for (size_t i=0; i<m_points.size(); ++i)
+    {
+        view.getPackedPoint(dims, m_points[i], p);
+        p += pointSize;
+    }
 
-    // child mask
     uint8_t mask = 0x0;
     if (m_children)
     {
@@ -216,41 +215,17 @@ void Tile::write(const char* prefix) const
         if (m_children[QuadNE]) mask += 4;
         if (m_children[QuadNW]) mask += 8;
     }
-    fwrite(&mask, 1, 1, fp);
+    *p = (char)mask;
 
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+        throw pdal_error("RialtoWriter: Unable to open tile file '" +
+            filename + "'.");
+    size_t written = fwrite(buf.data(), 1, buf.size(), fp);
     fclose(fp);
-
-    if (m_children)
-    {
-        for (int i=0; i<4; ++i)
-        {
-            if (m_children[i])
-            {
-                m_children[i]->write(prefix);
-            }
-        }
-    }
-
-    delete[] filename;
-}
-
-
-void Tile::writeData(FILE* fp) const
-{
-    const PointLayoutPtr layout(m_table.layout());
-    for (size_t i=0; i<m_points.size(); ++i)
-    {
-        char* p = m_points[i];
-
-        for (const auto& dim : layout->dims())
-        {
-            size_t size = Dimension::size(layout->dimType(dim));
-
-            fwrite(p, size, 1, fp);
-
-            p += size;
-        }
-    }
+    if (written != buf.size())
+        throw pdal_error("RialtoWriter: Error writing tile file '" +
+            filename + "'.");
 }
 
 } // namespace pdal
@@ -35,6 +35,7 @@
 #pragma once
 
 #include <pdal/pdal_types.hpp>
+#include <pdal/PointView.hpp>
 #include <pdal/Writer.hpp>
 
 #include <cassert>
@@ -119,32 +120,49 @@ public:
 class Tile
 {
 public:
-    Tile(int32_t level, int32_t tx, int32_t ty, Rectangle r, int32_t maxLevel,
-        const PointTableRef table, LogPtr log);
+    Tile(int32_t level, int32_t tx, int32_t ty, Rectangle r,
+        int32_t maxLevel);
     ~Tile();
 
-    std::vector<char*>& points()
+    // Ids of the tile's points in the view of all points written.
+    const std::vector<PointId>& points() const
         { return m_points; }
 
     size_t numPoints() const
         { return m_points.size(); }
 
-    void add(PointId pointNumber, char* data, double lon, double lat);
-    void collectStats(std::vector<int32_t> numTilesPerLevel, std::vector<int64_t> numPointsPerLevel) const;
-    void write(const char* dir) const;
-    void writeData(FILE*) const;
+    int32_t level() const
+        { return m_level; }
+
+    // Add point 'pointNumber' of its view, which is point 'pos' of the view
+    // of all points written, to this tile and the tiles below it.
+    void add(PointId pointNumber, PointId pos, double lon, double lat);
+    // Add the point to this tile alone and return the child tile that it
+    // belongs in, creating the child if need be.  Returns NULL at the
+    // maximum level.
+    Tile *addLocal(PointId pointNumber, PointId pos, double lon, double lat);
+    void collectStats(std::vector<int32_t>& numTilesPerLevel,
+        std::vector<int64_t>& numPointsPerLevel) const;
+    // Write this tile and the tiles below it, packing the points' 'dims'
+    // from 'view' into 'pointSize' bytes each.
+    void write(const char* dir, const PointView& view,
+        const DimTypeList& dims, size_t pointSize) const;
+    // Write this tile alone.
+    void writeTile(const char* dir, const PointView& view,
+        const DimTypeList& dims, size_t pointSize) const;
 
 private:
     int32_t m_level;
     int32_t m_tileX;
     int32_t m_tileY;
-    std::vector<char*> m_points;
+    std::vector<PointId> m_points;
     Tile** m_children;
     Rectangle m_rect;
     int32_t m_maxLevel;
     int64_t m_skip;
-    const PointTableRef m_table;
-    LogPtr m_log;
+
+    Tile& operator=(const Tile&); // not implemented
+    Tile(const Tile&); // not implemented
 };
 
 } // namespace pdal
@@ -41,6 +41,7 @@
 #include <pdal/pdal_types.hpp>
 #include <pdal/PointTable.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/util/Bounds.hpp>
 #include <pdal/util/FileUtils.hpp>
 
@@ -48,6 +49,7 @@
 
 #include "RialtoCommon.hpp"
 
+#include <algorithm>
 #include <cstdint>
 
 namespace pdal
@@ -62,19 +64,18 @@ CREATE_STATIC_PLUGIN(1, 0, RialtoWriter, Writer, s_info)
 
 namespace
 {
-    char* getPointData(const PointView& buf, PointId& idx)
+    // Split tiles until there are at least this many subtrees per worker
+    // to build and write, or none are worth splitting.
+    const size_t PartsPerThread = 4;
+    // Subtrees with fewer points than this aren't split further.
+    const size_t MinSplitPoints = 4096;
+
+    // A subtree of the pyramid and the points that fall in it.
+    struct Part
     {
-        char* p = new char[buf.pointSize()];
-        char* q = p;
-
-        for (const auto& dim : buf.dims())
-        {
-            buf.getRawField(dim, idx, q);
-            q += buf.dimSize(dim);
-        }
-
-        return p;
-    }
+        Tile *m_tile;
+        std::vector<PointId> m_points;
+    };
 
     void writeHeader(
             std::string dir,
@@ -196,27 +197,101 @@ void RialtoWriter::ready(PointTableRef table)
     Rectangle r00(-180, -90, 0, 90);
     Rectangle r10(0, -90, 180, 90);
     m_roots = new Tile*[2];
-    m_roots[0] = new Tile(0, 0, 0, r00, m_maxLevel, *m_table, log());
-    m_roots[1] = new Tile(0, 1, 0, r10, m_maxLevel, *m_table, log());
+    m_roots[0] = new Tile(0, 0, 0, r00, m_maxLevel);
+    m_roots[1] = new Tile(0, 1, 0, r10, m_maxLevel);
+    m_view.reset(new PointView(table));
 }
 
 void RialtoWriter::write(const PointViewPtr view)
 {
     const PointView& viewRef(*view.get());
+    ThreadPool& pool = ThreadPool::shared();
+
+    // Scaled dimensions are written as doubles, so the size of the data
+    // can differ from the size of the point as stored.
+    const DimTypeList dimTypes(viewRef.dimTypes());
+    m_bytesPerPoint = 0;
+    for (const auto& dt : dimTypes)
+        m_bytesPerPoint += Dimension::size(dt.m_type);
+
+    // The view of all points only holds the points' ids; their data stays
+    // in the point table.
+    const point_count_t count = viewRef.size();
+    const PointId base = m_view->size();
+    for (PointId idx = 0; idx < count; ++idx)
+        m_view->appendPoint(viewRef, idx);
+
+    std::vector<double> lons(count);
+    std::vector<double> lats(count);
+    // Points are only read from several threads if the table is
+    // threadSafe().
+    const bool parallel = viewRef.table().threadSafe();
+    auto locate = [&](size_t begin, size_t end)
+    {
+        for (PointId idx = begin; idx < end; ++idx)
+        {
+            lons[idx] = viewRef.getFieldAs<double>(Dimension::Id::X, idx);
+            lats[idx] = viewRef.getFieldAs<double>(Dimension::Id::Y, idx);
+        }
+    };
+    if (parallel)
+        pool.parallelFor(count, 4096, locate);
+    else
+        locate(0, count);
+
+    // Start with a subtree for each root and split the largest until
+    // there's enough work to go around.  The tiles that are split are kept
+    // so that they can be written themselves.
+    std::vector<Part> parts(2);
+    parts[0].m_tile = m_roots[0];
+    parts[1].m_tile = m_roots[1];
+    for (PointId idx = 0; idx < count; ++idx)
+        parts[lons[idx] < 0 ? 0 : 1].m_points.push_back(idx);
+
+    std::vector<Tile *> splitTiles;
+    while (parts.size() < pool.size() * PartsPerThread)
+    {
+        auto largest = parts.end();
+        for (auto pi = parts.begin(); pi != parts.end(); ++pi)
+            if (pi->m_tile->level() < m_maxLevel &&
+                pi->m_points.size() >= MinSplitPoints &&
+                (largest == parts.end() ||
+                    pi->m_points.size() > largest->m_points.size()))
+                largest = pi;
+        if (largest == parts.end())
+            break;
+
+        Part part;
+        std::swap(part, *largest);
+        parts.erase(largest);
+        splitTiles.push_back(part.m_tile);
+
+        std::vector<Part> children;
+        for (PointId idx : part.m_points)
+        {
+            Tile *child = part.m_tile->addLocal(idx, base + idx, lons[idx],
+                lats[idx]);
+            auto ci = std::find_if(children.begin(), children.end(),
+                [child](const Part& p){ return p.m_tile == child; });
+            if (ci == children.end())
+            {
+                children.push_back(Part());
+                ci = children.end() - 1;
+                ci->m_tile = child;
+            }
+            ci->m_points.push_back(idx);
+        }
+        for (Part& child : children)
+            parts.push_back(std::move(child));
+    }
 
     // build the tiles
-    for (PointId idx = 0; idx < viewRef.size(); ++idx)
+    pool.parallelFor(parts.size(), 1, [&](size_t begin, size_t end)
     {
-        char* p = getPointData(viewRef, idx);
-
-        double lon = viewRef.getFieldAs<double>(Dimension::Id::X, idx);
-        double lat = viewRef.getFieldAs<double>(Dimension::Id::Y, idx);
-
-        if (lon < 0)
-            m_roots[0]->add(idx, p, lon, lat);
-        else
-            m_roots[1]->add(idx, p, lon, lat);
-    }
+        for (size_t i = begin; i < end; ++i)
+            for (PointId idx : parts[i].m_points)
+                parts[i].m_tile->add(idx, base + idx, lons[idx], lats[idx]);
+    });
 
     // dump tile info
     if (log()->getLevel() >= LogLevel::Debug)
@@ -233,8 +308,21 @@ void RialtoWriter::write(const PointViewPtr view)
     }
 
     // write the tiles and the header
-    m_roots[0]->write(m_filename.c_str());
-    m_roots[1]->write(m_filename.c_str());
+    const PointView& all(*m_view);
+    auto writeTiles = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            if (i < splitTiles.size())
+                splitTiles[i]->writeTile(m_filename.c_str(), all, dimTypes,
+                    m_bytesPerPoint);
+            else
+                parts[i - splitTiles.size()].m_tile->write(m_filename.c_str(),
+                    all, dimTypes, m_bytesPerPoint);
+    };
+    if (parallel)
+        pool.parallelFor(splitTiles.size() + parts.size(), 1, writeTiles);
+    else
+        writeTiles(0, splitTiles.size() + parts.size());
 
     writeHeader(
             m_filename,
@@ -250,6 +338,7 @@ void RialtoWriter::done(PointTableRef table)
     delete m_roots[0];
     delete m_roots[1];
     delete[] m_roots;
+    m_view.reset();
 }
 
 } // namespace pdal
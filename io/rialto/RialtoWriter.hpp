@@ -69,6 +69,7 @@ private:
     virtual void write(const PointViewPtr view);
     virtual void done(PointTableRef table);
 
+    // Size of a point as written.
     int32_t m_bytesPerPoint;
     int32_t m_maxLevel;
     int32_t m_numTilesX;
@@ -77,6 +78,10 @@ private:
     Rectangle m_rectangle;
     Tile** m_roots;
     BasePointTable *m_table;
+    // Points of all the views written so far.  The tiles refer to these
+    // by id and their data is packed from the point table as each tile is
+    // written.
+    PointViewPtr m_view;
 
     RialtoWriter& operator=(const RialtoWriter&); // not implemented
     RialtoWriter(const RialtoWriter&); // not implemented
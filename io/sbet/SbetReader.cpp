@@ -34,6 +34,10 @@
 
 #include "SbetReader.hpp"
 
+#include <pdal/util/Endian.hpp>
+
+#include <algorithm>
+
 namespace pdal
 {
 
@@ -59,7 +63,7 @@ void SbetReader::addDimensions(PointLayoutPtr layout)
 }
 
 
-void SbetReader::ready(PointTableRef)
+void SbetReader::ready(PointTableRef table)
 {
     size_t fileSize = FileUtils::fileSize(m_filename);
     size_t pointSize = getDefaultDimensions().size() * sizeof(double);
@@ -67,48 +71,69 @@ void SbetReader::ready(PointTableRef)
         throw pdal_error("invalid sbet file size");
     m_numPts = fileSize / pointSize;
     m_index = 0;
-    m_stream.reset(new ILeStream(m_filename));
+
+    // Records are all little-endian doubles, so they can be mapped into
+    // a mapped point table as they stand.  Otherwise they're decoded from
+    // a mapping of the file.
+    m_mapTable = dynamic_cast<MappedPointTable *>(&table);
+    if (m_mapTable && (m_mapTable->mapped() || m_numPts == 0))
+        m_mapTable = NULL;
+    if (m_mapTable)
+    {
+        m_mapTable->mapFile(m_filename, 0, m_numPts, pointSize);
+        Dimension::IdList dims = getDefaultDimensions();
+        for (size_t d = 0; d < dims.size(); ++d)
+            m_mapTable->mapDim(dims[d], d * sizeof(double),
+                Dimension::Type::Double);
+    }
+    else
+        m_file.open(m_filename);
 }
 
 
 point_count_t SbetReader::read(PointViewPtr view, point_count_t count)
 {
+    count = std::min(count, m_numPts - m_index);
     PointId nextId = view->size();
-    PointId idx = m_index;
-    point_count_t numRead = 0;
-    seek(idx);
+    if (m_mapTable)
+    {
+        view->appendTablePoints(count);
+        if (m_cb)
+            for (PointId i = 0; i < count; ++i)
+                m_cb(*view, nextId + i);
+        m_index += count;
+        return count;
+    }
+
     Dimension::IdList dims = getDefaultDimensions();
-    while (numRead < count && idx < m_numPts)
+    size_t pointSize = dims.size() * sizeof(double);
+    std::vector<double> values(count * dims.size());
+    Endian::fromLittle<double>(m_file.data() + m_index * pointSize,
+        values.size(), values.data());
+    const double *d = values.data();
+    for (point_count_t i = 0; i < count; ++i)
     {
         for (auto di = dims.begin(); di != dims.end(); ++di)
-        {
-            double d;
-            *m_stream >> d;
-            Dimension::Id::Enum dim = *di;
-            view->setField(dim, nextId, d);
-        }
+            view->setField(*di, nextId, *d++);
 
         if (m_cb)
             m_cb(*view, nextId);
-
-        idx++;
         nextId++;
-        numRead++;
     }
-    m_index = idx;
-    return numRead;
+    m_index += count;
+    return count;
 }
 
 
-bool SbetReader::eof()
+void SbetReader::done(PointTableRef)
 {
-    return m_index >= m_numPts;
+    m_file.close();
 }
 
 
-void SbetReader::seek(PointId idx)
+bool SbetReader::eof()
 {
-    m_stream->seek(idx * sizeof(double) * getDefaultDimensions().size());
+    return m_index >= m_numPts;
 }
 
 } // namespace pdal
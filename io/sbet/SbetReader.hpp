@@ -34,9 +34,10 @@
 
 #pragma once
 
+#include <pdal/PointTable.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/Reader.hpp>
-#include <pdal/util/IStream.hpp>
+#include <pdal/util/MappedFile.hpp>
 
 #include "SbetCommon.hpp"
 
@@ -49,7 +50,7 @@ namespace pdal
 class PDAL_DLL SbetReader : public pdal::Reader
 {
 public:
-    SbetReader() : Reader()
+    SbetReader() : Reader(), m_mapTable(NULL)
         {}
 
     static void * create();
@@ -61,7 +62,10 @@ public:
         { return fileDimensions(); }
 
 private:
-    std::unique_ptr<ILeStream> m_stream;
+    // The file's records, when they aren't mapped into the point table.
+    MappedFile m_file;
+    // Table that the file's records are mapped into, if any.
+    MappedPointTable *m_mapTable;
     // Number of points in the file.
     point_count_t m_numPts;
     point_count_t m_index;
@@ -69,9 +73,8 @@ private:
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void ready(PointTableRef table);
     virtual point_count_t read(PointViewPtr view, point_count_t count);
+    virtual void done(PointTableRef table);
     virtual bool eof();
-
-    void seek(PointId idx);
 };
 
 } // namespace pdal
@@ -35,6 +35,8 @@
 #include "SbetWriter.hpp"
 
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/util/Inserter.hpp>
 
 namespace pdal
 {
@@ -62,21 +64,44 @@ void SbetWriter::ready(PointTableRef)
 
 void SbetWriter::write(const PointViewPtr view)
 {
+    // Points are packed into blocks of this many records on worker threads
+    // and each block is written at once.
+    const point_count_t BlockPoints = 65536;
+
     m_callback->setTotal(view->size());
     m_callback->invoke(0);
 
-    Dimension::IdList dims = getDefaultDimensions();
-    for (PointId idx = 0; idx < view->size(); ++idx)
+    // If a dimension doesn't exist, write 0.
+    const Dimension::IdList fileDims = getDefaultDimensions();
+    Dimension::IdList dims;
+    for (auto dim : fileDims)
+        if (view->hasDim(dim))
+            dims.push_back(dim);
+        else
+            dims.push_back(Dimension::Id::Unknown);
+    const size_t recordSize = dims.size() * sizeof(double);
+
+    std::vector<char> buf;
+    for (PointId first = 0; first < view->size(); first += BlockPoints)
     {
-        for (auto di = dims.begin(); di != dims.end(); ++di)
+        const point_count_t count =
+            std::min(BlockPoints, view->size() - first);
+        buf.resize(count * recordSize);
+        auto pack = [&](size_t begin, size_t end)
         {
-            // If a dimension doesn't exist, write 0.
-            Dimension::Id::Enum dim = *di;
-            *m_stream << (view->hasDim(dim) ?
-                view->getFieldAs<double>(dim, idx) : 0.0);
-        }
-        if (idx % 100 == 0)
-            m_callback->invoke(idx + 1);
+            LeInserter out(buf.data() + begin * recordSize,
+                (end - begin) * recordSize);
+            for (PointId idx = first + begin; idx < first + end; ++idx)
+                for (auto dim : dims)
+                    out << (dim == Dimension::Id::Unknown ? 0.0 :
+                        view->getFieldAs<double>(dim, idx));
+        };
+        if (view->table().threadSafe())
+            ThreadPool::shared().parallelFor(count, 4096, pack);
+        else
+            pack(0, count);
+        m_stream->put(buf.data(), buf.size());
+        m_callback->invoke(first + count);
     }
     m_callback->invoke(view->size());
 }
@@ -35,6 +35,7 @@
 #include "TerrasolidReader.hpp"
 
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/util/Extractor.hpp>
 
 #include <map>
@@ -51,6 +52,21 @@ CREATE_STATIC_PLUGIN(1, 0, TerrasolidReader, Reader, s_info)
 
 std::string TerrasolidReader::getName() const { return s_info.name; }
 
+namespace
+{
+
+// Points are read from the file in blocks of this many records.
+const point_count_t BlockPoints = 16384;
+
+} // unnamed namespace
+
+
+void TerrasolidReader::processOptions(const Options& options)
+{
+    m_start = options.getValueOrDefault<point_count_t>("start", 0);
+}
+
+
 void TerrasolidReader::initialize()
 {
     ILeStream stream(m_filename);
@@ -159,9 +175,20 @@ Dimension::IdList TerrasolidReader::getDefaultDimensions()
 void TerrasolidReader::ready(PointTableRef)
 {
     m_istream.reset(new IStream(m_filename));
-    // Skip to the beginning of points.
-    m_istream->seek(56);
-    m_index = 0;
+
+    // Times are offsets from that of the first point in the file, even
+    // when reading doesn't start there.
+    if (m_haveTime)
+    {
+        std::vector<char> buf(sizeof(m_baseTime));
+        m_istream->seek(56 + (m_format == TERRASOLID_Format_1 ? 16 : 20));
+        m_istream->get(buf);
+        LeExtractor(buf.data(), buf.size()) >> m_baseTime;
+    }
+
+    // Skip to the first point to read.  The records are of fixed size.
+    m_index = std::min(m_start, getNumPoints());
+    m_istream->seek(56 + m_index * m_size);
 }
 
 
@@ -169,9 +196,47 @@ point_count_t TerrasolidReader::read(PointViewPtr view, point_count_t count)
 {
     count = std::min(count, getNumPoints() - m_index);
 
-    std::vector<char> buf(m_size * count);
-    m_istream->get(buf);
-    LeExtractor extractor(buf.data(), buf.size());
+    // Read blocks of records and decode each into points added to the view
+    // beforehand, on worker threads when the table is threadSafe().
+    std::vector<char> buf;
+    point_count_t numRead = 0;
+    while (numRead < count)
+    {
+        const point_count_t blockCount = std::min(BlockPoints,
+            count - numRead);
+        buf.resize(blockCount * m_size);
+        m_istream->get(buf);
+        if (!m_istream->good())
+            throw terrasolid_error("Unable to read points from file '" +
+                m_filename + "'.");
+
+        const PointId baseId = view->size();
+        view->appendTablePoints(blockCount);
+        auto load = [this, &view, &buf, baseId](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                loadPoint(*view, baseId + i, buf.data() + i * m_size);
+        };
+        if (view->table().threadSafe())
+            ThreadPool::shared().parallelFor(blockCount, 1024, load);
+        else
+            load(0, blockCount);
+
+        if (m_cb)
+            for (PointId id = baseId; id < baseId + blockCount; ++id)
+                m_cb(*view, id);
+        numRead += blockCount;
+        m_index += blockCount;
+    }
+    return numRead;
+}
+
+
+// Decode the record at 'buf' into point 'id' of the view.
+void TerrasolidReader::loadPoint(PointView& view, PointId id,
+    const char *buf) const
+{
+    LeExtractor extractor(buf, m_size);
 
     // See https://www.terrasolid.com/download/tscan.pdf
     // This spec is awful, but it's something.
@@ -180,108 +245,86 @@ point_count_t TerrasolidReader::read(PointViewPtr view, point_count_t count)
     // says.
     // Also modified the fetch of time/color based on header flag (rather
     // than just not write the data into the buffer).
-    PointId nextId = view->size();
-    while (!eof())
+    uint8_t echo;
+    if (m_format == TERRASOLID_Format_1)
     {
-        if (m_format == TERRASOLID_Format_1)
-        {
-            uint8_t classification, flight_line, echo_int, x, y, z;
-
-            extractor >> classification >> flight_line >> echo_int >> x >> y >>
-                z;
-
-            view->setField(Dimension::Id::Classification, nextId,
-                          classification);
-            view->setField(Dimension::Id::PointSourceId, nextId, flight_line);
-            switch (echo_int)
-            {
-            case 0: // only echo
-                view->setField(Dimension::Id::ReturnNumber, nextId, 1);
-                view->setField(Dimension::Id::NumberOfReturns, nextId, 1);
-                break;
-            case 1: // first of many echos
-                view->setField(Dimension::Id::ReturnNumber, nextId, 1);
-                break;
-            default: // intermediate echo or last of many echos
-                break;
-            }
-            view->setField(Dimension::Id::X, nextId,
-                          (x - m_header->OrgX) / m_header->Units);
-            view->setField(Dimension::Id::Y, nextId,
-                          (y - m_header->OrgY) / m_header->Units);
-            view->setField(Dimension::Id::Z, nextId,
-                          (z - m_header->OrgZ) / m_header->Units);
-        }
-
-        if (m_format == TERRASOLID_Format_2)
-        {
-            int32_t x, y, z;
-            uint8_t classification, echo_int, flag, mark;
-            uint16_t flight_line, intensity;
-
-            extractor >> x >> y >> z >> classification >> echo_int >> flag >>
-                mark >> flight_line >> intensity;
-
-            view->setField(Dimension::Id::X, nextId,
-                          (x - m_header->OrgX) / m_header->Units);
-            view->setField(Dimension::Id::Y, nextId,
-                          (y - m_header->OrgY) / m_header->Units);
-            view->setField(Dimension::Id::Z, nextId,
-                          (z - m_header->OrgZ) / m_header->Units);
-            view->setField(Dimension::Id::Classification, nextId,
-                          classification);
-            switch (echo_int)
-            {
-            case 0: // only echo
-                view->setField(Dimension::Id::ReturnNumber, nextId, 1);
-                view->setField(Dimension::Id::NumberOfReturns, nextId, 1);
-                break;
-            case 1: // first of many echos
-                view->setField(Dimension::Id::ReturnNumber, nextId, 1);
-                break;
-            default: // intermediate echo or last of many echos
-                break;
-            }
-            view->setField(Dimension::Id::Flag, nextId, flag);
-            view->setField(Dimension::Id::Mark, nextId, mark);
-            view->setField(Dimension::Id::PointSourceId, nextId, flight_line);
-            view->setField(Dimension::Id::Intensity, nextId, intensity);
-        }
-
-        if (m_haveTime)
-        {
-            uint32_t t;
+        // The echo is the top two bits of the intensity.
+        int32_t x, y, z;
+        uint8_t classification, flight_line;
+        uint16_t echo_int;
+
+        extractor >> classification >> flight_line >> echo_int >> x >> y >>
+            z;
+
+        echo = echo_int >> 14;
+        view.setField(Dimension::Id::Classification, id, classification);
+        view.setField(Dimension::Id::PointSourceId, id, flight_line);
+        view.setField(Dimension::Id::Intensity, id, echo_int & 0x3FFF);
+        view.setField(Dimension::Id::X, id,
+                      (x - m_header->OrgX) / m_header->Units);
+        view.setField(Dimension::Id::Y, id,
+                      (y - m_header->OrgY) / m_header->Units);
+        view.setField(Dimension::Id::Z, id,
+                      (z - m_header->OrgZ) / m_header->Units);
+    }
+    else
+    {
+        int32_t x, y, z;
+        uint8_t classification, flag, mark;
+        uint16_t flight_line, intensity;
+
+        extractor >> x >> y >> z >> classification >> echo >> flag >>
+            mark >> flight_line >> intensity;
+
+        view.setField(Dimension::Id::X, id,
+                      (x - m_header->OrgX) / m_header->Units);
+        view.setField(Dimension::Id::Y, id,
+                      (y - m_header->OrgY) / m_header->Units);
+        view.setField(Dimension::Id::Z, id,
+                      (z - m_header->OrgZ) / m_header->Units);
+        view.setField(Dimension::Id::Classification, id, classification);
+        view.setField(Dimension::Id::Flag, id, flag);
+        view.setField(Dimension::Id::Mark, id, mark);
+        view.setField(Dimension::Id::PointSourceId, id, flight_line);
+        view.setField(Dimension::Id::Intensity, id, intensity);
+    }
 
-            extractor >> t;
+    switch (echo)
+    {
+    case 0: // only echo
+        view.setField(Dimension::Id::ReturnNumber, id, 1);
+        view.setField(Dimension::Id::NumberOfReturns, id, 1);
+        break;
+    case 1: // first of many echos
+        view.setField(Dimension::Id::ReturnNumber, id, 1);
+        break;
+    default: // intermediate echo or last of many echos
+        break;
+    }
 
-            if (m_index == 0)
-                m_baseTime = t;
-            t -= m_baseTime; // Offset from the beginning of the read.
-            // instead of GPS week.
-            t /= 5; // 5000ths of a second to milliseconds
-            view->setField(Dimension::Id::OffsetTime, nextId, t);
-        }
+    if (m_haveTime)
+    {
+        uint32_t t;
 
-        if (m_haveColor)
-        {
-            uint8_t red, green, blue, alpha;
+        extractor >> t;
 
-            extractor >> red >> green >> blue >> alpha;
+        t -= m_baseTime; // Offset from the beginning of the file
+        // instead of GPS week.
+        t /= 5; // 5000ths of a second to milliseconds
+        view.setField(Dimension::Id::OffsetTime, id, t);
+    }
 
-            view->setField(Dimension::Id::Red, nextId, red);
-            view->setField(Dimension::Id::Green, nextId, green);
-            view->setField(Dimension::Id::Blue, nextId, blue);
-            view->setField(Dimension::Id::Alpha, nextId, alpha);
-        }
+    if (m_haveColor)
+    {
+        uint8_t red, green, blue, alpha;
 
-        if (m_cb)
-            m_cb(*view, nextId);
+        extractor >> red >> green >> blue >> alpha;
 
-        nextId++;
-        m_index++;
+        view.setField(Dimension::Id::Red, id, red);
+        view.setField(Dimension::Id::Green, id, green);
+        view.setField(Dimension::Id::Blue, id, blue);
+        view.setField(Dimension::Id::Alpha, id, alpha);
     }
-
-    return count;
 }
 
 
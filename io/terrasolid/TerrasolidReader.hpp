@@ -124,7 +124,9 @@ private:
     uint32_t m_baseTime;
     std::unique_ptr<IStream> m_istream;
     point_count_t m_index;
+    point_count_t m_start;
 
+    virtual void processOptions(const Options& options);
     virtual void initialize();
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void ready(PointTableRef table);
@@ -132,6 +134,7 @@ private:
     virtual void done(PointTableRef table);
     virtual bool eof()
         { return m_index >= getNumPoints(); }
+    void loadPoint(PointView& view, PointId id, const char *buf) const;
 
     TerrasolidReader& operator=(const TerrasolidReader&); // not implemented
     TerrasolidReader(const TerrasolidReader&); // not implemented
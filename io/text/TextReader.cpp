@@ -0,0 +1,453 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "TextReader.hpp"
+
+#include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/util/Algorithm.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/algorithm/string.hpp>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "readers.text",
+    "Text Reader",
+    "http://pdal.io/stages/readers.text.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, TextReader, Reader, s_info)
+
+std::string TextReader::getName() const { return s_info.name; }
+
+// Points parsed from the lines [begin, end) of the file.
+struct TextReader::Chunk
+{
+    std::size_t begin;
+    std::size_t end;
+    // Values of each column.
+    std::vector<std::vector<double>> columns;
+    // Offset just past each line that held a point.
+    std::vector<std::size_t> lineEnds;
+};
+
+namespace
+{
+
+// Size of the pieces the file is split into for parsing.
+const std::size_t ChunkBytes = 1 << 20;
+
+const double s_scales[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+    1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+    1e20, 1e21, 1e22 };
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char *skipBlanks(const char *p, const char *end)
+{
+    while (p < end && isBlank(*p))
+        p++;
+    return p;
+}
+
+// Find the end of the value that starts at 'p'.
+inline const char *valueEnd(const char *p, const char *end, char separator)
+{
+    while (p < end && !isBlank(*p) && *p != '\n' && *p != separator)
+        p++;
+    return p;
+}
+
+// Parse the number in [p, end).  Numbers with at most 19 significant
+// digits whose decimal exponent is small enough that both the digits and
+// the power of ten are exact doubles are converted with a single, correctly
+// rounded multiply or divide.  Everything else is left to strtod().
+bool parseDouble(const char *p, const char *end, double& v)
+{
+    if (p == end)
+        return false;
+
+    const char *start = p;
+    bool neg = (*p == '-');
+    if (*p == '-' || *p == '+')
+        p++;
+
+    uint64_t mant = 0;
+    int digits = 0;
+    int exp10 = 0;
+    bool any = false;
+    bool exact = true;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+    {
+        any = true;
+        if (mant || *p != '0')
+        {
+            if (digits++ < 19)
+                mant = mant * 10 + (*p - '0');
+            else
+                exact = false;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+        {
+            any = true;
+            if (mant || *p != '0')
+            {
+                if (digits++ < 19)
+                    mant = mant * 10 + (*p - '0');
+                else
+                    exact = false;
+            }
+            exp10--;
+        }
+    }
+    if (any && p < end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool expNeg = (p < end && *p == '-');
+        if (p < end && (*p == '-' || *p == '+'))
+            ++p;
+        int e = 0;
+        bool expAny = false;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+        {
+            expAny = true;
+            if (e < 10000)
+                e = e * 10 + (*p - '0');
+        }
+        if (!expAny)
+            any = false;
+        exp10 += expNeg ? -e : e;
+    }
+
+    if (any && exact && p == end && mant <= (1ULL << 53) &&
+        exp10 >= -22 && exp10 <= 22)
+    {
+        v = (double)mant;
+        v = (exp10 < 0) ? v / s_scales[-exp10] : v * s_scales[exp10];
+        if (neg)
+            v = -v;
+        return true;
+    }
+
+    std::string s(start, end);
+    char *last;
+    v = strtod(s.c_str(), &last);
+    return last == s.c_str() + s.size();
+}
+
+// Split a line into its values' text.
+std::vector<std::string> splitLine(const std::string& line, char separator)
+{
+    std::vector<std::string> fields;
+    const char *p = line.data();
+    const char *end = p + line.size();
+    while (true)
+    {
+        p = skipBlanks(p, end);
+        if (p == end)
+            break;
+        const char *e = valueEnd(p, end, separator);
+        fields.push_back(std::string(p, e));
+        p = skipBlanks(e, end);
+        if (separator && p < end && *p == separator)
+            p++;
+    }
+    return fields;
+}
+
+} // unnamed namespace
+
+
+Options TextReader::getDefaultOptions()
+{
+    Options options;
+
+    options.add("separator", "", "Character between values.  By default "
+        "values are separated by a comma if the first line has one and by "
+        "whitespace otherwise");
+    options.add("header", "", "Comma-separated names of the columns, "
+        "used in place of the file's header line");
+
+    return options;
+}
+
+
+void TextReader::processOptions(const Options& ops)
+{
+    std::string separator = ops.getValueOrDefault<std::string>("separator",
+        "");
+    if (separator.size() > 1)
+        throw pdal_error("Option 'separator' must be a single character.");
+    m_separator = separator.size() ? separator[0] : 0;
+    if (isBlank(m_separator) || m_separator == '\n')
+        m_separator = 0;
+
+    std::string header = ops.getValueOrDefault<std::string>("header", "");
+    m_names.clear();
+    if (header.size())
+        m_names = splitLine(header, ',');
+}
+
+
+void TextReader::initialize()
+{
+    // Probe the first line for the separator and the column names.
+    std::istream *in = FileUtils::openFile(m_filename);
+    if (!in)
+        throw pdal_error("Unable to open text file '" + m_filename + "'.");
+    std::string line;
+    while (std::getline(*in, line))
+        if (splitLine(line, 0).size())
+            break;
+    FileUtils::closeFile(in);
+
+    if (!m_separator && line.find(',') != std::string::npos)
+        m_separator = ',';
+    std::vector<std::string> fields = splitLine(line, m_separator);
+    if (fields.empty())
+        throw pdal_error("Text file '" + m_filename + "' has no data.");
+
+    m_hasHeader = false;
+    for (auto& f : fields)
+    {
+        double v;
+        if (!parseDouble(f.data(), f.data() + f.size(), v))
+            m_hasHeader = true;
+    }
+
+    if (m_names.empty())
+    {
+        if (m_hasHeader)
+        {
+            for (auto& f : fields)
+            {
+                boost::trim_if(f, boost::is_any_of("\"'"));
+                m_names.push_back(f);
+            }
+        }
+        else
+        {
+            static const char *const defaults[] = { "X", "Y", "Z" };
+            for (size_t i = 0; i < fields.size(); ++i)
+                m_names.push_back(i < 3 ? std::string(defaults[i]) :
+                    "Column" + std::to_string(i + 1));
+        }
+    }
+    if (m_names.size() != fields.size())
+        throw pdal_error("Text file '" + m_filename + "' has " +
+            std::to_string(fields.size()) + " columns, but " +
+            std::to_string(m_names.size()) + " names were given.");
+}
+
+
+void TextReader::addDimensions(PointLayoutPtr layout)
+{
+    m_dims.clear();
+    for (auto& name : m_names)
+    {
+        Dimension::Id::Enum id =
+            layout->registerOrAssignDim(name, Dimension::Type::Double);
+        if (contains(m_dims, id))
+            throw pdal_error("Text file '" + m_filename + "' names the "
+                "column '" + name + "' more than once.");
+        m_dims.push_back(id);
+    }
+}
+
+
+void TextReader::ready(PointTableRef)
+{
+    m_file.open(m_filename);
+    m_data = m_file.data();
+    m_size = m_file.size();
+
+    m_pos = 0;
+    if (m_hasHeader)
+    {
+        // Skip any blank lines and the header line itself.
+        const char *p = m_data;
+        const char *end = m_data + m_size;
+        while (p < end)
+        {
+            const char *next = (const char *)memchr(p, '\n', end - p);
+            next = next ? next + 1 : end;
+            bool blank = (skipBlanks(p, next) == next ||
+                *skipBlanks(p, next) == '\n');
+            p = next;
+            if (!blank)
+                break;
+        }
+        m_pos = p - m_data;
+    }
+}
+
+
+void TextReader::done(PointTableRef)
+{
+    m_file.close();
+    m_data = NULL;
+    m_size = 0;
+}
+
+
+void TextReader::parseChunk(Chunk& chunk) const
+{
+    const char *p = m_data + chunk.begin;
+    const char *end = m_data + chunk.end;
+
+    chunk.columns.resize(m_dims.size());
+    for (auto& c : chunk.columns)
+        c.clear();
+    chunk.lineEnds.clear();
+
+    while (p < end)
+    {
+        p = skipBlanks(p, end);
+        if (p == end)
+            break;
+        if (*p == '\n')
+        {
+            p++;
+            continue;
+        }
+        for (size_t i = 0; i < m_dims.size(); ++i)
+        {
+            if (i)
+            {
+                p = skipBlanks(p, end);
+                if (m_separator && p < end && *p == m_separator)
+                    p = skipBlanks(p + 1, end);
+            }
+            const char *e = valueEnd(p, end, m_separator);
+            double v;
+            if (!parseDouble(p, e, v))
+            {
+                if (p == e)
+                    throw pdal_error("Line in text file '" + m_filename +
+                        "' has fewer than " + std::to_string(m_dims.size()) +
+                        " values.");
+                throw pdal_error("Invalid value '" + std::string(p, e) +
+                    "' in text file '" + m_filename + "'.");
+            }
+            chunk.columns[i].push_back(v);
+            p = e;
+        }
+        p = skipBlanks(p, end);
+        if (p < end && *p != '\n')
+            throw pdal_error("Line in text file '" + m_filename +
+                "' has more than " + std::to_string(m_dims.size()) +
+                " values.");
+        if (p < end)
+            p++;
+        chunk.lineEnds.push_back(p - m_data);
+    }
+}
+
+
+point_count_t TextReader::read(PointViewPtr view, point_count_t count)
+{
+    ThreadPool& pool = ThreadPool::shared();
+    const size_t batch = pool.size() * 4;
+    std::vector<Chunk> chunks(batch);
+
+    PointId nextId = view->size();
+    point_count_t numRead = 0;
+    while (numRead < count && m_pos < m_size)
+    {
+        // Don't parse much more of the file than the points asked for.
+        double want = std::min((double)(count - numRead) * m_lineSize * 1.1,
+            (double)(m_size - m_pos));
+        size_t chunkBytes = std::min(ChunkBytes,
+            std::max((size_t)4096, (size_t)(want / pool.size())));
+
+        // Split the next part of the file after line ends.
+        size_t numChunks = 0;
+        size_t pos = m_pos;
+        while (numChunks < batch && pos < m_size &&
+            (numChunks == 0 || pos - m_pos < want))
+        {
+            Chunk& c = chunks[numChunks++];
+            c.begin = pos;
+            size_t split = std::min(pos + chunkBytes, m_size);
+            const char *nl = (const char *)memchr(m_data + split - 1, '\n',
+                m_size - split + 1);
+            c.end = nl ? (nl - m_data) + 1 : m_size;
+            pos = c.end;
+        }
+
+        pool.parallelFor(numChunks, 1, [this, &chunks](size_t begin,
+            size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                parseChunk(chunks[i]);
+        });
+
+        // Copy the points to the view in file order.
+        point_count_t lines = 0;
+        for (size_t i = 0; i < numChunks && numRead < count; ++i)
+        {
+            Chunk& c = chunks[i];
+            point_count_t num = std::min<point_count_t>(c.lineEnds.size(),
+                count - numRead);
+            for (size_t d = 0; d < m_dims.size(); ++d)
+                view->setFieldArray(m_dims[d], nextId, num,
+                    c.columns[d].data());
+            if (m_cb)
+                for (PointId idx = nextId; idx < nextId + num; ++idx)
+                    m_cb(*view, idx);
+            nextId += num;
+            numRead += num;
+            lines += num;
+            m_pos = (num == c.lineEnds.size()) ? c.end :
+                c.lineEnds[num - 1];
+        }
+        if (lines)
+            m_lineSize = (double)(m_pos - chunks[0].begin) / lines;
+    }
+    return numRead;
+}
+
+} // namespace pdal
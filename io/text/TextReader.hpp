@@ -0,0 +1,102 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_export.hpp>
+#include <pdal/Reader.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/util/MappedFile.hpp>
+
+#include <string>
+#include <vector>
+
+extern "C" int32_t TextReader_ExitFunc();
+extern "C" PF_ExitFunc TextReader_InitPlugin();
+
+namespace pdal
+{
+
+// Reads delimited text with one point per line, such as the CSV that
+// writers.text produces or plain XYZ files.  The file is mapped and split
+// at line ends into chunks that are parsed on the thread pool.
+class PDAL_DLL TextReader : public Reader
+{
+public:
+    TextReader() : m_separator(0), m_hasHeader(false), m_data(NULL),
+        m_size(0), m_pos(0), m_lineSize(64)
+    {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+    Options getDefaultOptions();
+
+private:
+    struct Chunk;
+
+    // Column names from the 'header' option, the file's header line or
+    // the default X, Y, Z, ...
+    std::vector<std::string> m_names;
+    Dimension::IdList m_dims;
+    // Character between values.  Zero means values are separated by
+    // whitespace.
+    char m_separator;
+    // Whether the first line of the file names the columns.
+    bool m_hasHeader;
+    MappedFile m_file;
+    // The file's contents.
+    const char *m_data;
+    std::size_t m_size;
+    // Offset of the first line that hasn't been read.
+    std::size_t m_pos;
+    // Average length of a line, used to size the chunks parsed when only
+    // a few points are wanted.
+    double m_lineSize;
+
+    virtual void processOptions(const Options& options);
+    virtual void initialize();
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void ready(PointTableRef table);
+    virtual point_count_t read(PointViewPtr view, point_count_t count);
+    virtual void done(PointTableRef table);
+
+    void parseChunk(Chunk& chunk) const;
+
+    TextReader& operator=(const TextReader&); // not implemented
+    TextReader(const TextReader&); // not implemented
+};
+
+} // namespace pdal
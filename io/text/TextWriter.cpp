@@ -36,9 +36,12 @@
 
 #include <pdal/pdal_export.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/util/Algorithm.hpp>
 
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <map>
 
@@ -56,6 +59,78 @@ static PluginInfo const s_info = PluginInfo(
 
 CREATE_STATIC_PLUGIN(1, 0, TextWriter, Writer, s_info)
 
+namespace
+{
+
+// Number of points formatted into each buffer.
+const point_count_t ChunkSize = 16384;
+
+// Largest precision handled without snprintf.
+const int MaxFastPrecision = 15;
+
+// The scaled value must be below 2^43 so that the error of the scaling
+// multiply, at most half an ulp, stays under 2^-11.
+const double MaxFastScaled = 8796093022208.0;
+
+// Scaled values whose fraction is this close to one half might round
+// either way and are left to snprintf.
+const double TieWindow = 1.0 / 512;
+
+const double s_scales[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+    1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+// Append 'v' to 's' as an ostream set to std::fixed and 'precision' would
+// write it.  Values that fit well within a double's mantissa once scaled
+// are rounded and printed with integer arithmetic.  Anything near a
+// rounding tie, too large or not finite goes through snprintf, so the
+// text is the same in every case.
+void appendFixed(std::string& s, double v, int precision)
+{
+    if (precision >= 0 && precision <= MaxFastPrecision && std::isfinite(v))
+    {
+        double scaled = std::fabs(v) * s_scales[precision];
+        double whole = std::floor(scaled);
+        double frac = scaled - whole;
+        if (scaled < MaxFastScaled && std::fabs(frac - .5) > TieWindow)
+        {
+            uint64_t u = (uint64_t)whole + (frac > .5 ? 1 : 0);
+
+            char buf[32];
+            char *end = buf + sizeof(buf);
+            char *p = end;
+            for (int i = 0; i < precision; ++i)
+            {
+                *--p = '0' + (u % 10);
+                u /= 10;
+            }
+            if (precision)
+                *--p = '.';
+            do
+            {
+                *--p = '0' + (u % 10);
+                u /= 10;
+            } while (u);
+            if (std::signbit(v))
+                *--p = '-';
+            s.append(p, end);
+            return;
+        }
+    }
+
+    char buf[64];
+    int len = snprintf(buf, sizeof(buf), "%.*f", precision, v);
+    if (len < (int)sizeof(buf))
+        s.append(buf, len);
+    else
+    {
+        std::vector<char> big(len + 1);
+        snprintf(big.data(), big.size(), "%.*f", precision, v);
+        s.append(big.data(), len);
+    }
+}
+
+} // unnamed namespace
+
 std::string TextWriter::getName() const { return s_info.name; }
 
 struct FileStreamDeleter
@@ -107,9 +182,6 @@ void TextWriter::processOptions(const Options& ops)
 
 void TextWriter::ready(PointTableRef table)
 {
-    m_stream->precision(m_precision);
-    *m_stream << std::fixed;
-
     typedef boost::tokenizer<boost::char_separator<char>> tokenizer;
 
     // Find the dimensions listed and put them on the id list.
@@ -191,50 +263,94 @@ void TextWriter::writeCSVHeader(PointTableRef table)
     *m_stream << m_newline;
 }
 
+void TextWriter::writeBuffered(const PointViewPtr view,
+    const std::function<void(std::string&, PointId)>& formatPoint)
+{
+    ThreadPool& pool = ThreadPool::shared();
+
+    // Chunks are formatted a batch at a time so that the text held in
+    // memory stays bounded, and written in order once the batch is done.
+    // Chunks of a batch are formatted concurrently if the table is
+    // threadSafe().
+    const size_t batch = pool.size() * 4;
+    const point_count_t numChunks = (view->size() + ChunkSize - 1) / ChunkSize;
+    std::vector<std::string> bufs(batch);
+    for (point_count_t first = 0; first < numChunks; first += batch)
+    {
+        size_t count = (size_t)std::min<point_count_t>(batch,
+            numChunks - first);
+        auto format = [&](size_t begin, size_t end)
+        {
+            for (size_t c = begin; c < end; ++c)
+            {
+                std::string& buf = bufs[c];
+                buf.clear();
+                PointId idx = (first + c) * ChunkSize;
+                PointId last = std::min<PointId>(idx + ChunkSize,
+                    view->size());
+                for (; idx < last; ++idx)
+                    formatPoint(buf, idx);
+            }
+        };
+        if (view->table().threadSafe())
+            pool.parallelFor(count, 1, format);
+        else
+            format(0, count);
+        for (size_t c = 0; c < count; ++c)
+            m_stream->write(bufs[c].data(), bufs[c].size());
+    }
+}
+
 void TextWriter::writeCSVBuffer(const PointViewPtr view)
 {
-    for (PointId idx = 0; idx < view->size(); ++idx)
+    writeBuffered(view, [this, &view](std::string& s, PointId idx)
     {
         for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
         {
             if (di != m_dims.begin())
-                *m_stream << m_delimiter;
-            *m_stream << view->getFieldAs<double>(*di, idx);
+                s += m_delimiter;
+            appendFixed(s, view->getFieldAs<double>(*di, idx), m_precision);
         }
-        *m_stream << m_newline;
-    }
+        s += m_newline;
+    });
 }
 
 void TextWriter::writeGeoJSONBuffer(const PointViewPtr view)
 {
     using namespace Dimension;
 
-    for (PointId idx = 0; idx < view->size(); ++idx)
+    std::vector<std::string> props;
+    for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
+    {
+        std::string prop(di == m_dims.begin() ? "" : ",");
+        props.push_back(prop + "\"" + view->dimName(*di) + "\":\"");
+    }
+
+    writeBuffered(view, [this, &view, &props](std::string& s, PointId idx)
     {
         if (idx)
-            *m_stream << ",";
+            s += ",";
 
-        *m_stream << "{ \"type\":\"Feature\",\"geometry\": "
+        s += "{ \"type\":\"Feature\",\"geometry\": "
             "{ \"type\": \"Point\", \"coordinates\": [";
-        *m_stream << view->getFieldAs<double>(Id::X, idx) << ",";
-        *m_stream << view->getFieldAs<double>(Id::Y, idx) << ",";
-        *m_stream << view->getFieldAs<double>(Id::Z, idx) << "]},";
-
-        *m_stream << "\"properties\": {";
-
-        for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
+        appendFixed(s, view->getFieldAs<double>(Id::X, idx), m_precision);
+        s += ",";
+        appendFixed(s, view->getFieldAs<double>(Id::Y, idx), m_precision);
+        s += ",";
+        appendFixed(s, view->getFieldAs<double>(Id::Z, idx), m_precision);
+        s += "]},";
+
+        s += "\"properties\": {";
+        for (size_t i = 0; i < m_dims.size(); ++i)
         {
-            if (di != m_dims.begin())
-                *m_stream << ",";
-
-            *m_stream << "\"" << view->dimName(*di) << "\":";
-            *m_stream << "\"";
-            *m_stream << view->getFieldAs<double>(*di, idx);
-            *m_stream <<"\"";
+            s += props[i];
+            appendFixed(s, view->getFieldAs<double>(m_dims[i], idx),
+                m_precision);
+            s += "\"";
         }
-        *m_stream << "}"; // end properties
-        *m_stream << "}"; // end feature
-    }
+        s += "}"; // end properties
+        s += "}"; // end feature
+    });
 }
 
 void TextWriter::write(const PointViewPtr view)
@@ -39,6 +39,7 @@
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/Writer.hpp>
 
+#include <functional>
 #include <memory>
 #include <vector>
 #include <string>
@@ -74,6 +75,10 @@ private:
     void writeGeoJSONHeader();
     void writeCSVHeader(PointTableRef table);
 
+    // Format the points of 'view' in chunks on the thread pool and write
+    // the chunks to the stream in order.
+    void writeBuffered(const PointViewPtr view,
+        const std::function<void(std::string&, PointId)>& formatPoint);
     void writeGeoJSONBuffer(const PointViewPtr view);
     void writeCSVBuffer(const PointViewPtr view);
 
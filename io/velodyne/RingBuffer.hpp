@@ -0,0 +1,106 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace pdal
+{
+
+// A fixed-size queue for one thread that adds items and one that takes
+// them, without locks.  Each side only advances its own index, so neither
+// waits for the other; the producer finds out the queue is full instead.
+template<typename T>
+class RingBuffer
+{
+public:
+    // A queue that holds at least 'capacity' items.
+    explicit RingBuffer(std::size_t capacity) : m_head(0), m_tail(0)
+    {
+        std::size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        m_items.resize(size);
+        m_mask = size - 1;
+    }
+
+    std::size_t capacity() const
+        { return m_items.size(); }
+    // The number of items queued.  Exact only on the consumer's thread
+    // while the producer is idle.
+    std::size_t size() const
+        { return m_tail.load(std::memory_order_acquire) -
+            m_head.load(std::memory_order_acquire); }
+
+    // Add all 'count' items, or none if there isn't room.  Called only by
+    // the producer.
+    bool push(const T *items, std::size_t count)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t head = m_head.load(std::memory_order_acquire);
+        if (capacity() - (tail - head) < count)
+            return false;
+        for (std::size_t i = 0; i < count; ++i)
+            m_items[(tail + i) & m_mask] = items[i];
+        m_tail.store(tail + count, std::memory_order_release);
+        return true;
+    }
+
+    // Take up to 'count' items, oldest first, into 'out'.  Returns the
+    // number taken.  Called only by the consumer.
+    std::size_t pop(T *out, std::size_t count)
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        std::size_t tail = m_tail.load(std::memory_order_acquire);
+        count = (std::min)(count, tail - head);
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = m_items[(head + i) & m_mask];
+        m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::vector<T> m_items;
+    std::size_t m_mask;
+    // Items before m_head have been taken and items from m_head up to
+    // m_tail are queued.  The indices only grow.
+    std::atomic<std::size_t> m_head;
+    std::atomic<std::size_t> m_tail;
+};
+
+} // namespace pdal
@@ -0,0 +1,437 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "VelodyneReader.hpp"
+
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace pdal
+{
+
+namespace
+{
+
+const std::size_t BlockCount = 12;
+const std::size_t BlockSize = 100;
+const std::size_t LaserCount = 16;
+
+// Elevation of each laser of a VLP-16, in degrees.
+const double s_elevation[LaserCount] =
+    { -15, 1, -13, 3, -11, 5, -9, 7, -7, 9, -5, 11, -3, 13, -1, 15 };
+
+// Timing of the firings, in microseconds.
+const double LaserTime = 2.304;
+const double SequenceTime = 55.296;
+
+uint16_t le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+        ((uint32_t)p[3] << 24);
+}
+
+double seconds(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double>(d).count();
+}
+
+} // unnamed namespace
+
+static PluginInfo const s_info = PluginInfo(
+    "readers.velodyne",
+    "Live Velodyne VLP-16 packet stream reader",
+    "http://pdal.io/stages/readers.velodyne.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, VelodyneReader, Reader, s_info)
+
+std::string VelodyneReader::getName() const { return s_info.name; }
+
+
+VelodyneReader::VelodyneReader() : m_port(2368), m_bufferSize(0),
+    m_latency(0), m_timeout(0), m_streaming(false), m_socket(-1),
+    m_stop(false), m_ended(false), m_packets(0), m_droppedPackets(0),
+    m_droppedPoints(0), m_badPackets(0)
+{}
+
+
+VelodyneReader::~VelodyneReader()
+{
+    stop();
+}
+
+
+Options VelodyneReader::getDefaultOptions()
+{
+    Options options;
+    options.add("protocol", "udp");
+    options.add("port", 2368);
+    options.add("buffer_size", 1 << 20);
+    options.add("latency", 0.1);
+    options.add("timeout", 1.0);
+    return options;
+}
+
+
+Dimension::IdList VelodyneReader::getDefaultDimensions()
+{
+    Dimension::IdList ids;
+
+    ids.push_back(Dimension::Id::X);
+    ids.push_back(Dimension::Id::Y);
+    ids.push_back(Dimension::Id::Z);
+    ids.push_back(Dimension::Id::Intensity);
+    ids.push_back(Dimension::Id::ScanChannel);
+    ids.push_back(Dimension::Id::GpsTime);
+    return ids;
+}
+
+
+void VelodyneReader::processOptions(const Options& options)
+{
+    m_protocol = options.getValueOrDefault<std::string>("protocol", "udp");
+    if (m_protocol != "udp" && m_protocol != "tcp")
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Invalid 'protocol' value '" << m_protocol <<
+            "'.  Must be 'udp' or 'tcp'.";
+        throw pdal_error(oss.str());
+    }
+    m_address = options.getValueOrDefault<std::string>("address",
+        m_protocol == "udp" ? "0.0.0.0" : "127.0.0.1");
+    m_port = options.getValueOrDefault<uint16_t>("port", 2368);
+    m_bufferSize = options.getValueOrDefault<std::size_t>("buffer_size",
+        1 << 20);
+    m_latency = options.getValueOrDefault<double>("latency", 0.1);
+    m_timeout = options.getValueOrDefault<double>("timeout", 1.0);
+    if (m_bufferSize < BlockCount * LaserCount * 2)
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'buffer_size' must hold at least "
+            "the points of one packet (" << BlockCount * LaserCount * 2 <<
+            ").";
+        throw pdal_error(oss.str());
+    }
+}
+
+
+void VelodyneReader::addDimensions(PointLayoutPtr layout)
+{
+    layout->registerDims(getDefaultDimensions());
+}
+
+
+// Each of the twelve blocks of a packet holds two firings of the sixteen
+// lasers.  The second firing is at the azimuth halfway to the next block.
+bool VelodyneReader::decodePacket(const uint8_t *packet,
+    std::vector<Point>& points)
+{
+    double azimuth[BlockCount];
+    for (std::size_t b = 0; b < BlockCount; ++b)
+    {
+        const uint8_t *block = packet + b * BlockSize;
+        if (block[0] != 0xFF || block[1] != 0xEE)
+            return false;
+        azimuth[b] = le16(block + 2) / 100.0;
+    }
+    const double stamp = le32(packet + BlockCount * BlockSize);
+
+    for (std::size_t b = 0; b < BlockCount; ++b)
+    {
+        const uint8_t *block = packet + b * BlockSize;
+        double gap = b + 1 < BlockCount ? azimuth[b + 1] - azimuth[b] :
+            azimuth[b] - azimuth[b - 1];
+        if (gap < 0)
+            gap += 360;
+        for (std::size_t seq = 0; seq < 2; ++seq)
+            for (std::size_t laser = 0; laser < LaserCount; ++laser)
+            {
+                const uint8_t *ret = block + 4 +
+                    (seq * LaserCount + laser) * 3;
+                uint16_t raw = le16(ret);
+                if (raw == 0)
+                    continue;
+
+                double within = seq * SequenceTime + laser * LaserTime;
+                double offset = b * 2 * SequenceTime + within;
+                double az = std::fmod(azimuth[b] +
+                    gap * within / (2 * SequenceTime), 360.0);
+                double alpha = az * M_PI / 180.0;
+                double omega = s_elevation[laser] * M_PI / 180.0;
+                double d = raw * 0.002;
+
+                Point p;
+                p.m_x = d * std::cos(omega) * std::sin(alpha);
+                p.m_y = d * std::cos(omega) * std::cos(alpha);
+                p.m_z = d * std::sin(omega);
+                p.m_time = (stamp + offset) * 1e-6;
+                p.m_intensity = ret[2];
+                p.m_channel = (uint8_t)laser;
+                points.push_back(p);
+            }
+    }
+    return true;
+}
+
+
+void VelodyneReader::ready(PointTableRef table)
+{
+    m_streaming = dynamic_cast<FixedPointTable *>(&table) != nullptr;
+    m_packets = 0;
+    m_droppedPackets = 0;
+    m_droppedPoints = 0;
+    m_badPackets = 0;
+    m_ring.reset(new RingBuffer<Point>(m_bufferSize));
+    m_batch.clear();
+    open();
+    m_stop = false;
+    m_ended = false;
+    m_thread = std::thread(&VelodyneReader::receive, this);
+}
+
+
+void VelodyneReader::open()
+{
+#ifndef _WIN32
+    bool udp = (m_protocol == "udp");
+    std::ostringstream where;
+    where << m_address << ":" << m_port;
+
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = udp ? SOCK_DGRAM : SOCK_STREAM;
+    struct addrinfo *info = NULL;
+    std::string port = std::to_string(m_port);
+    if (getaddrinfo(m_address.c_str(), port.c_str(), &hints, &info) != 0 ||
+        !info)
+        throw pdal_error(getName() + ": Unable to resolve '" + where.str() +
+            "'.");
+
+    m_socket = socket(info->ai_family, info->ai_socktype, 0);
+    int result = -1;
+    if (m_socket >= 0)
+    {
+        if (udp)
+        {
+            int on = 1;
+            setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            // Scanners send faster than a busy reader thread drains the
+            // socket, so give the kernel room to queue packets.
+            int bytes = 8 << 20;
+            setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &bytes,
+                sizeof(bytes));
+            result = bind(m_socket, info->ai_addr, info->ai_addrlen);
+        }
+        else
+            result = connect(m_socket, info->ai_addr, info->ai_addrlen);
+    }
+    freeaddrinfo(info);
+    if (result != 0)
+    {
+        std::string err = std::strerror(errno);
+        if (m_socket >= 0)
+            close(m_socket);
+        m_socket = -1;
+        throw pdal_error(getName() + ": Unable to " +
+            (udp ? "listen on '" : "connect to '") + where.str() + "': " +
+            err + ".");
+    }
+
+    // Receives time out so that the thread notices it's asked to stop.
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 100000;
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+#else
+    throw pdal_error(getName() + ": Live streams aren't supported on this "
+        "platform.");
+#endif
+}
+
+
+// Receive packets until asked to stop or, for TCP, until the sender closes
+// the stream.  Packets of TCP streams are read whole from the bytes
+// received.
+void VelodyneReader::receive()
+{
+#ifndef _WIN32
+    const bool udp = (m_protocol == "udp");
+    std::vector<uint8_t> packet(PacketSize + 1);
+    std::size_t have = 0;
+    std::vector<Point> points;
+    points.reserve(BlockCount * LaserCount * 2);
+
+    while (!m_stop)
+    {
+        ssize_t got;
+        if (udp)
+            got = recv(m_socket, packet.data(), packet.size(), 0);
+        else
+            got = recv(m_socket, packet.data() + have, PacketSize - have, 0);
+        if (got < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                continue;
+            break;
+        }
+        if (!udp)
+        {
+            if (got == 0)
+                break;
+            have += got;
+            if (have < PacketSize)
+                continue;
+            have = 0;
+        }
+        else if ((std::size_t)got != PacketSize)
+        {
+            // Position packets and anything else that isn't point data.
+            m_badPackets++;
+            continue;
+        }
+
+        points.clear();
+        if (!decodePacket(packet.data(), points))
+        {
+            m_badPackets++;
+            continue;
+        }
+        m_packets++;
+        if (!m_ring->push(points.data(), points.size()))
+        {
+            m_droppedPackets++;
+            m_droppedPoints += points.size();
+        }
+    }
+#endif
+    m_ended = true;
+}
+
+
+// Take points from the ring buffer until 'count' have been read, the stream
+// has been idle for the timeout or, when streaming, the chunk has waited
+// as long as it may.
+point_count_t VelodyneReader::read(PointViewPtr view, point_count_t count)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const Clock::time_point start = Clock::now();
+    Clock::time_point lastData = start;
+    PointId nextId = view->size();
+    point_count_t n = 0;
+    m_batch.resize(4096);
+    while (n < count)
+    {
+        std::size_t got = m_ring->pop(m_batch.data(),
+            (std::min)((point_count_t)m_batch.size(), count - n));
+        for (std::size_t i = 0; i < got; ++i, ++nextId)
+        {
+            const Point& p = m_batch[i];
+            view->setField(Dimension::Id::X, nextId, p.m_x);
+            view->setField(Dimension::Id::Y, nextId, p.m_y);
+            view->setField(Dimension::Id::Z, nextId, p.m_z);
+            view->setField(Dimension::Id::Intensity, nextId, p.m_intensity);
+            view->setField(Dimension::Id::ScanChannel, nextId, p.m_channel);
+            view->setField(Dimension::Id::GpsTime, nextId, p.m_time);
+            if (m_cb)
+                m_cb(*view, nextId);
+        }
+        n += got;
+        if (got)
+        {
+            lastData = Clock::now();
+            continue;
+        }
+
+        // The thread may have queued its last points just before ending.
+        if (m_ended && m_ring->size() == 0)
+            break;
+        Clock::time_point now = Clock::now();
+        if (m_streaming && n && seconds(now - start) >= m_latency)
+            break;
+        if (m_timeout > 0 && seconds(now - lastData) >= m_timeout)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return n;
+}
+
+
+void VelodyneReader::stop()
+{
+    m_stop = true;
+    if (m_thread.joinable())
+        m_thread.join();
+#ifndef _WIN32
+    if (m_socket >= 0)
+        close(m_socket);
+#endif
+    m_socket = -1;
+}
+
+
+void VelodyneReader::done(PointTableRef table)
+{
+    stop();
+    m_metadata.add("packets", (uint64_t)m_packets);
+    m_metadata.add("packets_dropped", (uint64_t)m_droppedPackets);
+    m_metadata.add("points_dropped", (uint64_t)m_droppedPoints);
+    m_metadata.add("bad_packets", (uint64_t)m_badPackets);
+    if (m_droppedPackets)
+        log()->get(LogLevel::Warning) << getName() << ": dropped " <<
+            m_droppedPackets << " packets (" << m_droppedPoints <<
+            " points) while the buffer was full." << std::endl;
+}
+
+} // namespace pdal
@@ -0,0 +1,130 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Reader.hpp>
+
+#include "RingBuffer.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+extern "C" int32_t VelodyneReader_ExitFunc();
+extern "C" PF_ExitFunc VelodyneReader_InitPlugin();
+
+namespace pdal
+{
+
+// Reads the data packets of a live Velodyne VLP-16 scanner from UDP, as
+// the scanner sends them, or from a TCP stream of packets.  A thread
+// receives and decodes packets into a ring buffer while the points are
+// read out in chunks, so the filters of a pipeline can run on the scan as
+// it's made.  Packets that arrive while the buffer is full are dropped and
+// counted.
+class PDAL_DLL VelodyneReader : public Reader
+{
+public:
+    // A decoded return.
+    struct Point
+    {
+        double m_x;
+        double m_y;
+        double m_z;
+        // Seconds since the top of the hour.
+        double m_time;
+        uint8_t m_intensity;
+        uint8_t m_channel;
+    };
+
+    static const std::size_t PacketSize = 1206;
+
+    VelodyneReader();
+    ~VelodyneReader();
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+    Options getDefaultOptions();
+    static Dimension::IdList getDefaultDimensions();
+    virtual bool streamable() const
+        { return true; }
+
+    // Decode the returns of a data packet of PacketSize bytes, adding them
+    // to 'points'.  Returns false if the packet isn't a data packet.
+    static bool decodePacket(const uint8_t *packet,
+        std::vector<Point>& points);
+
+private:
+    std::string m_protocol;
+    std::string m_address;
+    uint16_t m_port;
+    std::size_t m_bufferSize;
+    // Longest a streamed chunk waits to fill, and how long without a
+    // packet ends the stream, in seconds.
+    double m_latency;
+    double m_timeout;
+    bool m_streaming;
+
+    int m_socket;
+    std::thread m_thread;
+    std::atomic<bool> m_stop;
+    // Set by the receiving thread when the stream has ended or failed.
+    std::atomic<bool> m_ended;
+    std::unique_ptr<RingBuffer<Point>> m_ring;
+    std::vector<Point> m_batch;
+
+    std::atomic<uint64_t> m_packets;
+    std::atomic<uint64_t> m_droppedPackets;
+    std::atomic<uint64_t> m_droppedPoints;
+    std::atomic<uint64_t> m_badPackets;
+
+    virtual void processOptions(const Options& options);
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void ready(PointTableRef table);
+    virtual point_count_t read(PointViewPtr view, point_count_t count);
+    virtual void done(PointTableRef table);
+
+    void open();
+    void receive();
+    void stop();
+
+    VelodyneReader& operator=(const VelodyneReader&); // not implemented
+    VelodyneReader(const VelodyneReader&); // not implemented
+};
+
+} // namespace pdal
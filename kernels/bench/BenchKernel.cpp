@@ -0,0 +1,394 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "BenchKernel.hpp"
+
+#include <pdal/PDALUtils.hpp>
+#include <pdal/PipelineReader.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "kernels.bench",
+    "Bench Kernel",
+    "http://pdal.io/apps.html#bench-command" );
+
+CREATE_STATIC_PLUGIN(1, 0, BenchKernel, Kernel, s_info)
+
+std::string BenchKernel::getName() const { return s_info.name; }
+
+namespace
+{
+
+// Every stage of the pipeline, each after its inputs.
+void collectStages(Stage *stage, std::vector<Stage *>& stages)
+{
+    if (std::find(stages.begin(), stages.end(), stage) != stages.end())
+        return;
+    for (Stage *s : stage->getInputs())
+        collectStages(s, stages);
+    stages.push_back(stage);
+}
+
+
+// The most memory the process has used so far, in bytes, or 0 if it
+// can't be told.
+uint64_t peakRss()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+
+template<typename T>
+std::vector<T> parseList(const std::string& list, const std::string& name)
+{
+    std::vector<T> values;
+    for (std::string s : Utils::split2(list, ','))
+    {
+        Utils::trim(s);
+        try
+        {
+            values.push_back(boost::lexical_cast<T>(s));
+        }
+        catch (boost::bad_lexical_cast&)
+        {
+            throw app_usage_error("invalid value '" + s + "' for --" + name);
+        }
+    }
+    return values;
+}
+
+} // unnamed namespace
+
+
+BenchKernel::BenchKernel() : m_runs(5), m_warmup(1)
+{}
+
+
+void BenchKernel::addSwitches()
+{
+    po::options_description* file_options =
+        new po::options_description("file options");
+
+    file_options->add_options()
+        ("input,i", po::value<std::string>(&m_inputFile)->default_value(""),
+            "pipeline file name")
+        ("runs", po::value<int>(&m_runs)->default_value(5),
+            "Number of timed runs of each configuration")
+        ("warmup", po::value<int>(&m_warmup)->default_value(1),
+            "Number of untimed runs before the timed ones")
+        ("threads", po::value<std::string>(&m_threadList)->default_value(""),
+            "Comma-separated numbers of worker threads to run with "
+            "(default: all of the shared thread pool)")
+        ("sizes", po::value<std::string>(&m_sizeList)->default_value(""),
+            "Comma-separated numbers of points for each reader to read "
+            "(default: all)")
+        ("output,o", po::value<std::string>(&m_outputFile)->default_value(""),
+            "Write the results to this file as JSON")
+        ("compare", po::value<std::string>(&m_baselineFile)->default_value(""),
+            "Compare the results with those written to this file by an "
+            "earlier run")
+        ;
+
+    addSwitchSet(file_options);
+    addPositionalSwitch("input", 1);
+}
+
+
+void BenchKernel::validateSwitches()
+{
+    if (m_inputFile.empty())
+        throw app_usage_error("input file name required");
+    if (m_runs < 1)
+        throw app_usage_error("--runs must be at least 1");
+    if (m_warmup < 0)
+        throw app_usage_error("--warmup can't be negative");
+
+    m_threads = parseList<std::size_t>(m_threadList, "threads");
+    if (m_threads.empty())
+        m_threads.push_back(ThreadPool::shared().size());
+    m_sizes = parseList<point_count_t>(m_sizeList, "sizes");
+    // Peak memory only grows, so smaller inputs run first.
+    std::sort(m_sizes.begin(), m_sizes.end());
+    if (m_sizes.empty())
+        m_sizes.push_back(0);
+}
+
+
+int BenchKernel::execute()
+{
+    if (!FileUtils::fileExists(m_inputFile))
+        throw app_runtime_error("file not found: " + m_inputFile);
+
+    std::vector<Result> results;
+    for (point_count_t count : m_sizes)
+        for (std::size_t threads : m_threads)
+            results.push_back(runConfig(threads, count));
+    ThreadPool::shared().setActive(std::numeric_limits<std::size_t>::max());
+
+    report(results, std::cout);
+    if (m_baselineFile.size())
+        compare(results, std::cout);
+    if (m_outputFile.size())
+        writeJSON(results);
+    return 0;
+}
+
+
+BenchKernel::Result BenchKernel::runConfig(std::size_t threads,
+    point_count_t count)
+{
+    ThreadPool::shared().setActive(threads);
+
+    Result result;
+    result.m_threads = ThreadPool::shared().size();
+    result.m_count = count;
+    result.m_meanTime = 0;
+    result.m_minTime = std::numeric_limits<double>::max();
+
+    double time;
+    for (int i = 0; i < m_warmup; ++i)
+        runOnce(count, time, result);
+    result.m_stages.clear();
+    for (int i = 0; i < m_runs; ++i)
+    {
+        runOnce(count, time, result);
+        result.m_meanTime += time / m_runs;
+        result.m_minTime = (std::min)(result.m_minTime, time);
+    }
+    for (auto& st : result.m_stages)
+        st.m_time /= m_runs;
+    result.m_peakRss = peakRss();
+    return result;
+}
+
+
+// Run the pipeline once, adding the time spent in each of its stages to
+// 'result'.
+void BenchKernel::runOnce(point_count_t count, double& time, Result& result)
+{
+    PipelineManager manager;
+    PipelineReader reader(manager, isDebug(), getVerboseLevel());
+    // Pipelines without a writer are fine: they time reading and filtering.
+    reader.readPipeline(m_inputFile);
+
+    std::vector<Stage *> stages;
+    for (Stage *s : manager.endpoints())
+        collectStages(s, stages);
+
+    for (Stage *s : stages)
+    {
+        Options opts = s->getOptions();
+        auto pi = getExtraStageOptions().find(s->getName());
+        if (pi != getExtraStageOptions().end())
+            for (const auto& o : pi->second.getOptions())
+                opts.add(o);
+        if (count && s->getInputs().empty())
+        {
+            opts.remove("count");
+            opts.add("count", count);
+        }
+        s->setOptions(opts);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    manager.execute();
+    time = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    result.m_points = 0;
+    for (Stage *s : stages)
+        if (s->getInputs().empty())
+            result.m_points += s->profile().m_pointsOut;
+    result.m_bytes = (uint64_t)result.m_points *
+        manager.pointTable().layout()->pointSize();
+
+    if (result.m_stages.empty())
+        for (Stage *s : stages)
+            result.m_stages.push_back(StageTime{ s->getName(), 0.0 });
+    for (std::size_t i = 0; i < stages.size(); ++i)
+        result.m_stages[i].m_time += stages[i]->profile().m_executeTime;
+}
+
+
+void BenchKernel::report(const std::vector<Result>& results,
+    std::ostream& out)
+{
+    out << std::left << std::setw(9) << "threads" << std::right <<
+        std::setw(12) << "points" << std::setw(11) << "mean (s)" <<
+        std::setw(11) << "min (s)" << std::setw(12) << "Mpts/s" <<
+        std::setw(10) << "MB/s" << std::setw(14) << "peak RSS (MB)" <<
+        std::endl;
+    out << std::fixed;
+    for (const Result& r : results)
+    {
+        out << std::left << std::setw(9) << r.m_threads << std::right <<
+            std::setw(12) << r.m_points <<
+            std::setprecision(3) << std::setw(11) << r.m_meanTime <<
+            std::setw(11) << r.m_minTime <<
+            std::setw(12) << r.pointsPerSec() / 1e6 <<
+            std::setprecision(1) << std::setw(10) << r.mbPerSec() <<
+            std::setw(14) << r.m_peakRss / 1e6 << std::endl;
+    }
+
+    for (const Result& r : results)
+    {
+        out << std::endl << "Stages with " << r.m_threads << " thread(s), " <<
+            r.m_points << " points:" << std::endl;
+        for (const StageTime& st : r.m_stages)
+        {
+            double share = r.m_meanTime > 0 ?
+                100 * st.m_time / r.m_meanTime : 0;
+            out << "  " << std::left << std::setw(28) << st.m_name <<
+                std::right << std::setprecision(3) << std::setw(10) <<
+                st.m_time << " s" << std::setprecision(1) <<
+                std::setw(8) << share << "%" << std::endl;
+        }
+    }
+    out.unsetf(std::ios_base::floatfield);
+}
+
+
+void BenchKernel::writeJSON(const std::vector<Result>& results)
+{
+    MetadataNode root("bench");
+    root.add("pipeline", m_inputFile);
+    root.add("runs", m_runs);
+    root.add("warmup", m_warmup);
+    for (const Result& r : results)
+    {
+        MetadataNode m = root.addList("results");
+        m.add("threads", r.m_threads);
+        m.add("count", r.m_count, "Points each reader was limited to, or 0");
+        m.add("points", r.m_points);
+        m.add("bytes", r.m_bytes, "Bytes of point data read");
+        m.add("mean_time", r.m_meanTime);
+        m.add("min_time", r.m_minTime);
+        m.add("points_per_sec", r.pointsPerSec());
+        m.add("mb_per_sec", r.mbPerSec());
+        m.add("peak_rss", r.m_peakRss);
+        for (const StageTime& st : r.m_stages)
+        {
+            MetadataNode s = m.addList("stages");
+            s.add("name", st.m_name);
+            s.add("execute_time", st.m_time);
+        }
+    }
+
+    std::ofstream out(m_outputFile);
+    if (!out)
+        throw app_runtime_error("Can't open '" + m_outputFile +
+            "' for writing.");
+    utils::toJSON(root, out);
+}
+
+
+// Print the change in throughput from a baseline for every configuration
+// found in both.
+void BenchKernel::compare(const std::vector<Result>& results,
+    std::ostream& out)
+{
+    using boost::property_tree::ptree;
+
+    ptree baseline;
+    try
+    {
+        boost::property_tree::read_json(m_baselineFile, baseline);
+    }
+    catch (boost::property_tree::json_parser_error& err)
+    {
+        throw app_runtime_error("Can't read baseline '" + m_baselineFile +
+            "': " + err.message());
+    }
+
+    std::map<std::pair<std::size_t, point_count_t>, const ptree *> base;
+    if (auto list = baseline.get_child_optional("bench.results"))
+        for (const auto& ri : *list)
+            base[std::make_pair(ri.second.get<std::size_t>("threads", 0),
+                ri.second.get<point_count_t>("count", 0))] = &ri.second;
+
+    out << std::endl << "Compared with " << m_baselineFile << ":" <<
+        std::endl;
+    out << std::left << std::setw(9) << "threads" << std::right <<
+        std::setw(12) << "count" << std::setw(14) << "base Mpts/s" <<
+        std::setw(12) << "Mpts/s" << std::setw(10) << "change" << std::endl;
+    out << std::fixed;
+    for (const Result& r : results)
+    {
+        auto bi = base.find(std::make_pair(r.m_threads, r.m_count));
+        if (bi == base.end())
+            continue;
+        double before = bi->second->get<double>("points_per_sec", 0);
+        double after = r.pointsPerSec();
+        out << std::left << std::setw(9) << r.m_threads << std::right <<
+            std::setw(12) << r.m_count << std::setprecision(3) <<
+            std::setw(14) << before / 1e6 << std::setw(12) << after / 1e6;
+        if (before > 0)
+            out << std::setprecision(1) << std::setw(9) << std::showpos <<
+                100 * (after - before) / before << "%" << std::noshowpos;
+        out << std::endl;
+    }
+    out.unsetf(std::ios_base::floatfield);
+}
+
+} // namespace pdal
@@ -0,0 +1,106 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Kernel.hpp>
+#include <pdal/PipelineManager.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" int32_t BenchKernel_ExitFunc();
+extern "C" PF_ExitFunc BenchKernel_InitPlugin();
+
+namespace pdal
+{
+
+// Runs a pipeline several times for each combination of a number of
+// threads and an input size and reports its throughput, peak memory and
+// the time spent in each stage.
+class PDAL_DLL BenchKernel : public Kernel
+{
+public:
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+    int execute();
+
+private:
+    struct StageTime
+    {
+        std::string m_name;
+        double m_time;
+    };
+
+    struct Result
+    {
+        std::size_t m_threads;
+        point_count_t m_count;
+        point_count_t m_points;
+        uint64_t m_bytes;
+        double m_meanTime;
+        double m_minTime;
+        uint64_t m_peakRss;
+        std::vector<StageTime> m_stages;
+
+        double pointsPerSec() const
+            { return m_meanTime > 0 ? m_points / m_meanTime : 0; }
+        double mbPerSec() const
+            { return m_meanTime > 0 ? m_bytes / m_meanTime / 1e6 : 0; }
+    };
+
+    BenchKernel();
+    void addSwitches();
+    void validateSwitches();
+
+    Result runConfig(std::size_t threads, point_count_t count);
+    void runOnce(point_count_t count, double& time, Result& result);
+    void report(const std::vector<Result>& results, std::ostream& out);
+    void writeJSON(const std::vector<Result>& results);
+    void compare(const std::vector<Result>& results, std::ostream& out);
+
+    std::string m_inputFile;
+    std::string m_outputFile;
+    std::string m_baselineFile;
+    std::string m_threadList;
+    std::string m_sizeList;
+    int m_runs;
+    int m_warmup;
+    std::vector<std::size_t> m_threads;
+    std::vector<point_count_t> m_sizes;
+};
+
+} // namespace pdal
@@ -34,6 +34,15 @@
 
 #include "DeltaKernel.hpp"
 
+#include <pdal/RadixSort.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
 #include <boost/format.hpp>
 #include <boost/program_options.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -58,6 +67,10 @@ DeltaKernel::DeltaKernel()
     , m_OutputDetail(false)
     , m_useXML(false)
     , m_useJSON(false)
+    , m_radius(0)
+    , m_exactCount(0)
+    , m_inexactCount(0)
+    , m_unmatchedCount(0)
 {}
 
 
@@ -77,6 +90,8 @@ void DeltaKernel::addSwitches()
          "output file name")
         ("2d", po::value<bool>(&m_3d)->zero_tokens()->implicit_value(false),
          "only 2D comparisons/indexing")
+        ("index_cache", po::value<std::string>(&m_indexCache),
+         "file to load the candidate index from or save it to")
         ("detail",
          po::value<bool>(&m_OutputDetail)->zero_tokens()->implicit_value(true),
          "Output deltas per-point")
@@ -92,7 +107,9 @@ void DeltaKernel::addSwitches()
     po::options_description* processing_options =
         new po::options_description("processing options");
 
-    processing_options->add_options();
+    processing_options->add_options()
+        ("radius", po::value<double>(&m_radius),
+         "find approximate neighbors from a grid of cells this wide");
     addSwitchSet(processing_options);
 
     addPositionalSwitch("source", 1);
@@ -111,117 +128,385 @@ std::ostream& writeHeader(std::ostream& strm, bool b3D)
 }
 
 
-std::map<Point, Point>* cumulatePoints(PointView& source_data,
-    PointView& candidate_data, KDIndex* index)
+namespace
 {
-    std::map<Point, Point> *output = new std::map<Point, Point>;
-    point_count_t count(std::min(source_data.size(), candidate_data.size()));
 
-    for (PointId i = 0; i < count; ++i)
-    {
-        double sx = source_data.getFieldAs<double>(Dimension::Id::X, i);
-        double sy = source_data.getFieldAs<double>(Dimension::Id::Y, i);
-        double sz = source_data.getFieldAs<double>(Dimension::Id::Z, i);
+// Run f(begin, end) over [0, count) on the pool's workers if the tables of
+// both views are threadSafe(), and on this thread otherwise.
+void forPoints(const PointView& a, const PointView& b, std::size_t count,
+    std::size_t grain, const std::function<void(std::size_t, std::size_t)>& f)
+{
+    if (a.table().threadSafe() && b.table().threadSafe())
+        ThreadPool::shared().parallelFor(count, grain, f);
+    else
+        f(0, count);
+}
 
-        std::vector<PointId> ids = index->neighbors(sx, sy, sz);
-        if (!ids.size())
+// Read the coordinates of the first 'count' points of a view, three to a
+// point.
+std::vector<double> coordinates(PointView& view, point_count_t count)
+{
+    std::vector<double> xyz(count * 3);
+    forPoints(view, view, count, 16384,
+        [&](std::size_t first, std::size_t last)
+    {
+        for (PointId i = first; i < last; ++i)
         {
-            std::ostringstream oss;
-            oss << "unable to find point for id '"  << i <<"'";
-            throw app_runtime_error(oss.str() );
+            xyz[i * 3] = view.getFieldAs<double>(Dimension::Id::X, i);
+            xyz[i * 3 + 1] = view.getFieldAs<double>(Dimension::Id::Y, i);
+            xyz[i * 3 + 2] = view.getFieldAs<double>(Dimension::Id::Z, i);
         }
+    });
+    return xyz;
+}
 
-        PointId id = ids[0];
-        double cx = candidate_data.getFieldAs<double>(Dimension::Id::X, id);
-        double cy = candidate_data.getFieldAs<double>(Dimension::Id::Y, id);
-        double cz = candidate_data.getFieldAs<double>(Dimension::Id::Z, id);
-
-        Point s(sx, sy, sz, i);
-        Point c(cx, cy, cz, id);
-        output->insert(std::pair<Point, Point>(s, c));
-    }
+const PointId NotFound = (std::numeric_limits<PointId>::max)();
+// Number of source points handled by each task.
+const point_count_t BlockSize = 16384;
+// Number of source points whose detail is formatted before it's written.
+const point_count_t DetailBatchSize = 1 << 20;
 
-    return output;
+// Find the difference between source point 'i' and candidate point 'id'.
+void delta(const PointView& source, const PointView& candidate, PointId i,
+    PointId id, double *d)
+{
+    using namespace Dimension;
+
+    d[0] = source.getFieldAs<double>(Id::X, i) -
+        candidate.getFieldAs<double>(Id::X, id);
+    d[1] = source.getFieldAs<double>(Id::Y, i) -
+        candidate.getFieldAs<double>(Id::Y, id);
+    d[2] = source.getFieldAs<double>(Id::Z, i) -
+        candidate.getFieldAs<double>(Id::Z, id);
 }
 
-void DeltaKernel::outputDetail(PointView& source_data, PointView& candidate_data) const
+// Minimum, maximum and sum of the differences of some points.
+struct DeltaSummary
 {
-    std::ostream& ostr = m_outputStream ? *m_outputStream : std::cout;
+    DeltaSummary() : m_count(0)
+    {
+        for (int d = 0; d < 3; ++d)
+        {
+            m_min[d] = (std::numeric_limits<double>::max)();
+            m_max[d] = std::numeric_limits<double>::lowest();
+            m_sum[d] = 0;
+        }
+    }
 
-    point_count_t count(std::min(source_data.size(), candidate_data.size()));
+    void add(const double *delta)
+    {
+        for (int d = 0; d < 3; ++d)
+        {
+            m_min[d] = (std::min)(m_min[d], delta[d]);
+            m_max[d] = (std::max)(m_max[d], delta[d]);
+            m_sum[d] += delta[d];
+        }
+        m_count++;
+    }
 
-    boost::property_tree::ptree output;
-    for (PointId i = 0; i < count; ++i)
+    void merge(const DeltaSummary& other)
     {
-        double sx = source_data.getFieldAs<double>(Dimension::Id::X, i);
-        double sy = source_data.getFieldAs<double>(Dimension::Id::Y, i);
-        double sz = source_data.getFieldAs<double>(Dimension::Id::Z, i);
+        for (int d = 0; d < 3; ++d)
+        {
+            m_min[d] = (std::min)(m_min[d], other.m_min[d]);
+            m_max[d] = (std::max)(m_max[d], other.m_max[d]);
+            m_sum[d] += other.m_sum[d];
+        }
+        m_count += other.m_count;
+    }
 
-        std::vector<PointId> ids = m_index->neighbors(sx, sy, sz);
+    double mean(int d) const
+    {
+        return m_count ? m_sum[d] / m_count :
+            std::numeric_limits<double>::quiet_NaN();
+    }
 
-        if (!ids.size())
+    point_count_t m_count;
+    double m_min[3];
+    double m_max[3];
+    double m_sum[3];
+};
+
+// Summarize the differences between source points and their nearest
+// candidate points.  Blocks of points are summarized in parallel when the
+// tables allow it, each into a summary of its own, and the summaries merged
+// in order.
+DeltaSummary summarize(const PointView& source, const PointView& candidate,
+    const std::vector<PointId>& nearest)
+{
+    std::size_t numBlocks = (nearest.size() + BlockSize - 1) / BlockSize;
+    std::vector<DeltaSummary> summaries(numBlocks);
+    forPoints(source, candidate, numBlocks, 1,
+        [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t b = first; b < last; ++b)
         {
-            std::ostringstream oss;
-            oss << "unable to find point for id '"  << i <<"'";
-            throw app_runtime_error(oss.str() );
+            std::size_t end = (std::min)(nearest.size(),
+                (std::size_t)((b + 1) * BlockSize));
+            for (std::size_t i = b * BlockSize; i < end; ++i)
+            {
+                if (nearest[i] == NotFound)
+                    continue;
+                double d[3];
+                delta(source, candidate, i, nearest[i], d);
+                summaries[b].add(d);
+            }
         }
+    });
 
-        PointId id = ids[0];
-        double cx = candidate_data.getFieldAs<double>(Dimension::Id::X, id);
-        double cy = candidate_data.getFieldAs<double>(Dimension::Id::Y, id);
-        double cz = candidate_data.getFieldAs<double>(Dimension::Id::Z, id);
+    DeltaSummary summary;
+    for (auto const& s : summaries)
+        summary.merge(s);
+    return summary;
+}
 
-        Point s(sx, sy, sz, id);
-        Point c(cx, cy, cz, id);
+// Approximate nearest neighbors from a hash grid of cells 'radius' wide.
+// Any point within 'radius' of a query is in one of the cells adjacent to
+// the query's, so a neighbor found that near is the nearest.  A neighbor
+// found farther away may not be, and a query with no points in the
+// adjacent cells gets none.
+class GridIndex
+{
+public:
+    GridIndex(PointView& view, double radius, bool b3d)
+        : m_radius(radius), m_3d(b3d)
+    {
+        std::vector<double> xyz(coordinates(view, view.size()));
+
+        // Sort the points by cell so that each cell is a run of them.
+        std::vector<RadixPair> pairs(view.size());
+        for (PointId i = 0; i < view.size(); ++i)
+            pairs[i] = std::make_pair(key(cell(xyz.data() + i * 3)), i);
+        radixSort(pairs);
+
+        m_coords.resize(xyz.size());
+        m_ids.resize(pairs.size());
+        PointId end(0);
+        for (PointId begin = 0; begin < pairs.size(); begin = end)
+        {
+            for (end = begin; end < pairs.size() &&
+                pairs[end].first == pairs[begin].first; ++end)
+            {
+                const PointId id(pairs[end].second);
+                std::copy(xyz.begin() + id * 3, xyz.begin() + id * 3 + 3,
+                    m_coords.begin() + end * 3);
+                m_ids[end] = id;
+            }
+            m_cells[pairs[begin].first] = std::make_pair(begin, end);
+        }
+    }
 
-        double xd = sx - cx;
-        double yd = sy - cy;
-        double zd = sz - cz;
-        boost::property_tree::ptree pt;
-        pt.put<int32_t>("i", i);
-        pt.put<float>("xd", xd);
-        pt.put<float>("yd", yd);
-        if (m_3d)
-            pt.put<float>("zd", zd);
+    // Return the nearest point found to 'xyz', or the largest PointId if
+    // there's none.
+    PointId nearest(const double *xyz, double& sqrDist) const
+    {
+        PointId id((std::numeric_limits<PointId>::max)());
+        sqrDist = (std::numeric_limits<double>::max)();
+
+        Cell c(cell(xyz));
+        const int64_t zSpan(m_3d ? 1 : 0);
+        for (int64_t dx = -1; dx <= 1; ++dx)
+            for (int64_t dy = -1; dy <= 1; ++dy)
+                for (int64_t dz = -zSpan; dz <= zSpan; ++dz)
+                {
+                    Cell n = { { c.i[0] + dx, c.i[1] + dy, c.i[2] + dz } };
+                    auto it = m_cells.find(key(n));
+                    if (it == m_cells.end())
+                        continue;
+                    for (PointId i = it->second.first;
+                        i < it->second.second; ++i)
+                    {
+                        const double *p(m_coords.data() + i * 3);
+                        double d = (p[0] - xyz[0]) * (p[0] - xyz[0]) +
+                            (p[1] - xyz[1]) * (p[1] - xyz[1]);
+                        if (m_3d)
+                            d += (p[2] - xyz[2]) * (p[2] - xyz[2]);
+                        if (d < sqrDist)
+                        {
+                            sqrDist = d;
+                            id = m_ids[i];
+                        }
+                    }
+                }
+        return id;
+    }
 
-        output.add_child("delta", pt);
+private:
+    struct Cell
+    {
+        int64_t i[3];
+    };
 
+    Cell cell(const double *xyz) const
+    {
+        Cell c = { { (int64_t)std::floor(xyz[0] / m_radius),
+            (int64_t)std::floor(xyz[1] / m_radius),
+            m_3d ? (int64_t)std::floor(xyz[2] / m_radius) : 0 } };
+        return c;
     }
 
-    if (m_useXML)
+    // Pack the low 21 bits of each cell index.  Cells that share a key are
+    // far apart, so they only add points to compare.
+    static uint64_t key(const Cell& c)
     {
-        boost::property_tree::write_xml(ostr, output);
-    } else if (m_useJSON)
+        const uint64_t mask((1 << 21) - 1);
+        return ((uint64_t)c.i[0] & mask) |
+            (((uint64_t)c.i[1] & mask) << 21) |
+            (((uint64_t)c.i[2] & mask) << 42);
+    }
+
+    double m_radius;
+    bool m_3d;
+    // The coordinates and IDs of the points, sorted by cell.
+    std::vector<double> m_coords;
+    std::vector<PointId> m_ids;
+    // The range of points of each cell.
+    std::unordered_map<uint64_t, std::pair<PointId, PointId>> m_cells;
+};
+
+} // unnamed namespace
+
+
+// Find the nearest candidate point to each of the first 'count' source
+// points.  'count' is no more than the number of candidate points, so
+// there's always an exact neighbor to find.  Approximate neighbors that
+// aren't found are the largest PointId.
+std::vector<PointId> DeltaKernel::nearestPoints(PointView& source_data,
+    PointView& candidate_data, point_count_t count)
+{
+    std::vector<PointId> ids(count);
+    if (!count)
+        return ids;
+    std::vector<double> xyz(coordinates(source_data, count));
+    std::vector<double> sqrDists(count);
+    if (m_radius <= 0)
     {
-        boost::property_tree::write_json(ostr, output);
+        m_index->knnBatch(xyz.data(), count, 1, ids.data(), sqrDists.data());
+        return ids;
+    }
 
-    } else
+    GridIndex grid(candidate_data, m_radius, m_3d);
+    ThreadPool::shared().parallelFor(count, 1024,
+        [&](std::size_t first, std::size_t last)
     {
-        writeHeader(ostr, m_3d);
+        for (std::size_t i = first; i < last; ++i)
+            ids[i] = grid.nearest(xyz.data() + i * 3, sqrDists[i]);
+    });
 
-        for (auto b = output.begin(); b != output.end(); ++b)
-        {
-            ostr << b->second.get<int32_t>("i")  << ",";
-            uint32_t precision = 12;
-            ostr.setf(std::ios_base::fixed, std::ios_base::floatfield);
-            ostr.precision(precision);
-            ostr << b->second.get<float>("xd") << ",";
+    m_exactCount = m_inexactCount = m_unmatchedCount = 0;
+    for (PointId i = 0; i < count; ++i)
+    {
+        if (ids[i] == (std::numeric_limits<PointId>::max)())
+            m_unmatchedCount++;
+        else if (sqrDists[i] <= m_radius * m_radius)
+            m_exactCount++;
+        else
+            m_inexactCount++;
+    }
+    return ids;
+}
+
+
+// Write the difference between each source point and its nearest candidate
+// point.  Batches of points are formatted in parallel blocks, each into a
+// buffer of its own, and written in order, so that output starts at once
+// and memory use doesn't grow with the number of points.
+void DeltaKernel::outputDetail(PointView& source_data,
+    PointView& candidate_data, const std::vector<PointId>& nearest) const
+{
+    std::ostream& ostr = m_outputStream ? *m_outputStream : std::cout;
 
-            ostr.precision(precision);
-            ostr << b->second.get<float>("yd");
+    if (m_useXML)
+        ostr << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+    else if (m_useJSON)
+        ostr << "{\n    \"delta\": [";
+    else
+        writeHeader(ostr, m_3d);
 
+    auto format = [&](std::ostream& out, PointId i, const double *d)
+    {
+        if (m_useXML)
+        {
+            out << "<delta><i>" << i << "</i><xd>" << (float)d[0] <<
+                "</xd><yd>" << (float)d[1] << "</yd>";
+            if (m_3d)
+                out << "<zd>" << (float)d[2] << "</zd>";
+            out << "</delta>";
+        }
+        else if (m_useJSON)
+        {
+            // Every record is preceded by a separator.  The first one
+            // written is dropped.
+            out << ",\n        { \"i\": " << i << ", \"xd\": " <<
+                (float)d[0] << ", \"yd\": " << (float)d[1];
             if (m_3d)
+                out << ", \"zd\": " << (float)d[2];
+            out << " }";
+        }
+        else
+        {
+            out << i << "," << (float)d[0] << "," << (float)d[1];
+            if (m_3d)
+                out << "," << (float)d[2];
+            out << "\n";
+        }
+    };
+
+    bool first = true;
+    for (std::size_t batch = 0; batch < nearest.size();
+        batch += DetailBatchSize)
+    {
+        std::size_t batchEnd = (std::min)(nearest.size(),
+            (std::size_t)(batch + DetailBatchSize));
+        std::size_t numBlocks = (batchEnd - batch + BlockSize - 1) /
+            BlockSize;
+        std::vector<std::string> text(numBlocks);
+        forPoints(source_data, candidate_data, numBlocks, 1,
+            [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t b = begin; b < end; ++b)
             {
-                ostr << ",";
-                ostr.precision(precision);
-                ostr << b->second.get<float>("zd");
+                std::ostringstream out;
+                if (m_useXML || m_useJSON)
+                    out.precision(std::numeric_limits<float>::max_digits10);
+                else
+                {
+                    out.setf(std::ios_base::fixed, std::ios_base::floatfield);
+                    out.precision(12);
+                }
+
+                std::size_t last = (std::min)(batchEnd,
+                    (std::size_t)(batch + (b + 1) * BlockSize));
+                for (std::size_t i = batch + b * BlockSize; i < last; ++i)
+                {
+                    if (nearest[i] == NotFound)
+                        continue;
+                    double d[3];
+                    delta(source_data, candidate_data, i, nearest[i], d);
+                    format(out, i, d);
+                }
+                text[b] = out.str();
             }
-            ostr << std::endl;
-        }
+        });
 
+        for (auto const& t : text)
+        {
+            if (t.empty())
+                continue;
+            if (m_useJSON && first)
+                ostr << t.substr(1);
+            else
+                ostr << t;
+            first = false;
+        }
+    }
 
+    if (m_useXML)
+        ostr << std::endl;
+    else if (m_useJSON)
+        ostr << "\n    ]\n}" << std::endl;
+    else
         ostr << std::endl;
-    }
 
     if (m_outputStream)
     {
@@ -251,6 +536,19 @@ void DeltaKernel::outputRST(boost::property_tree::ptree const& tree) const
     std::cout << " Mean       " << fmt % tree.get<float>("mean.x") << "            " << fmt % tree.get<float>("mean.y") << "            " << fmt % tree.get<float>("mean.z")<<std::endl;
     std::cout << thead << std::endl;
 
+    if (tree.count("approximation"))
+    {
+        std::cout << std::endl;
+        std::cout << " Approximate neighbors within " <<
+            tree.get<double>("approximation.radius") << ":" << std::endl;
+        std::cout << "   Nearest       " <<
+            tree.get<point_count_t>("approximation.exact") << std::endl;
+        std::cout << "   Maybe farther " <<
+            tree.get<point_count_t>("approximation.inexact") << std::endl;
+        std::cout << "   Not found     " <<
+            tree.get<point_count_t>("approximation.unmatched") << std::endl;
+    }
+
 }
 
 
@@ -306,44 +604,46 @@ int DeltaKernel::execute()
     if (m_outputFileName.size())
         m_outputStream = FileUtils::createFile(m_outputFileName);
 
-    // Index the candidate data.
-    m_index = std::unique_ptr<KDIndex>(new KDIndex(*candidateView.get()));
-    m_index->build(m_3d);
+    // Index the candidate data.  Approximate neighbors are found from a
+    // grid instead.
+    if (m_radius <= 0)
+    {
+        m_index = std::unique_ptr<KDIndex>(new KDIndex(*candidateView.get()));
+        if (m_indexCache.size())
+            m_index->build(m_indexCache, m_3d);
+        else
+            m_index->build(m_3d);
+    }
+
+    point_count_t count(std::min(sourceCount, candidateCount));
+    std::vector<PointId> nearest =
+        nearestPoints(*sourceView.get(), *candidateView.get(), count);
+    if (m_radius > 0 && m_unmatchedCount)
+        std::cerr << m_unmatchedCount << " source points have no candidate "
+            "point within the radius and are left out." << std::endl;
 
-    std::unique_ptr<std::map<Point, Point>>
-        points(cumulatePoints(*sourceView.get(), *candidateView.get(), m_index.get()));
     if (m_OutputDetail)
     {
-        outputDetail(*sourceView.get(), *candidateView.get());
+        outputDetail(*sourceView.get(), *candidateView.get(), nearest);
         return 0;
     }
 
-    for (auto i = points->begin(); i != points->end(); ++i)
-    {
-        Point const& s = i->first;
-        Point const& c = i->second;
-
-        double xd = s.x - c.x;
-        double yd = s.y - c.y;
-        double zd = s.z - c.z;
-        m_summary_x(xd);
-        m_summary_y(yd);
-        m_summary_z(zd);
-    }
+    DeltaSummary summary = summarize(*sourceView.get(),
+        *candidateView.get(), nearest);
 
     using boost::property_tree::ptree;
     ptree output;
 
-    double sminx  = (boost::accumulators::min)(m_summary_x);
-    double sminy  = (boost::accumulators::min)(m_summary_y);
-    double sminz  = (boost::accumulators::min)(m_summary_z);
-    double smaxx  = (boost::accumulators::max)(m_summary_x);
-    double smaxy  = (boost::accumulators::max)(m_summary_y);
-    double smaxz  = (boost::accumulators::max)(m_summary_z);
+    double sminx  = summary.m_min[0];
+    double sminy  = summary.m_min[1];
+    double sminz  = summary.m_min[2];
+    double smaxx  = summary.m_max[0];
+    double smaxy  = summary.m_max[1];
+    double smaxz  = summary.m_max[2];
 
-    double smeanx  = (boost::accumulators::mean)(m_summary_x);
-    double smeany  = (boost::accumulators::mean)(m_summary_y);
-    double smeanz  = (boost::accumulators::mean)(m_summary_z);
+    double smeanx  = summary.mean(0);
+    double smeany  = summary.mean(1);
+    double smeanz  = summary.mean(2);
 
     output.put<float>("min.x", sminx);
     output.put<float>("min.y", sminy);
@@ -356,6 +656,14 @@ int DeltaKernel::execute()
     output.put<float>("mean.z", smeanz);
     output.put<std::string>("source", m_sourceFile);
     output.put<std::string>("candidate", m_candidateFile);
+    if (m_radius > 0)
+    {
+        output.put<double>("approximation.radius", m_radius);
+        output.put<point_count_t>("approximation.exact", m_exactCount);
+        output.put<point_count_t>("approximation.inexact", m_inexactCount);
+        output.put<point_count_t>("approximation.unmatched",
+            m_unmatchedCount);
+    }
 
     if (m_useJSON)
         outputJSON(output);
@@ -42,14 +42,6 @@
 
 #include <boost/property_tree/xml_parser.hpp>
 #include <boost/property_tree/json_parser.hpp>
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/stats.hpp>
-#include <boost/accumulators/statistics/mean.hpp>
-//#include <boost/accumulators/statistics/moment.hpp>
-#include <boost/accumulators/statistics/max.hpp>
-#include <boost/accumulators/statistics/min.hpp>
-#include <boost/accumulators/statistics/count.hpp>
-//#include <boost/accumulators/statistics/density.hpp>
 
 extern "C" int32_t DeltaKernel_ExitFunc();
 extern "C" PF_ExitFunc DeltaKernel_InitPlugin();
@@ -57,12 +49,6 @@ extern "C" PF_ExitFunc DeltaKernel_InitPlugin();
 namespace pdal
 {
 
-
-typedef boost::accumulators::accumulator_set<double, boost::accumulators::features<     boost::accumulators::droppable<boost::accumulators::tag::mean>,
-        boost::accumulators::droppable<boost::accumulators::tag::max>,
-        boost::accumulators::droppable<boost::accumulators::tag::min>,
-        boost::accumulators::droppable<boost::accumulators::tag::count> > > summary_accumulator;
-
 class PDAL_DLL Point
 {
 public:
@@ -113,26 +99,33 @@ private:
 
     std::string m_sourceFile;
     std::string m_candidateFile;
+    std::string m_indexCache;
     std::string m_wkt;
 
     std::ostream* m_outputStream;
     std::string m_outputFileName;
 
-    summary_accumulator m_summary_x;
-    summary_accumulator m_summary_y;
-    summary_accumulator m_summary_z;
-
     bool m_3d;
     bool m_OutputDetail;
     bool m_useXML;
     bool m_useJSON;
+    // Search radius of approximate neighbors, or zero for exact neighbors.
+    double m_radius;
     std::unique_ptr<KDIndex> m_index;
 
+    // Number of source points whose approximate neighbor was within the
+    // radius, so the nearest, beyond it, or not found.
+    point_count_t m_exactCount;
+    point_count_t m_inexactCount;
+    point_count_t m_unmatchedCount;
 
+    std::vector<PointId> nearestPoints(PointView& source_data,
+        PointView& candidate_data, point_count_t count);
     void outputRST(boost::property_tree::ptree const&) const;
     void outputXML(boost::property_tree::ptree const&) const;
     void outputJSON(boost::property_tree::ptree const&) const;
-    void outputDetail(PointView& source_data, PointView& candidate_data) const;
+    void outputDetail(PointView& source_data, PointView& candidate_data,
+        const std::vector<PointId>& nearest) const;
 };
 
 } // namespace pdal
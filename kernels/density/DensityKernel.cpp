@@ -0,0 +1,186 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "DensityKernel.hpp"
+
+#include <pdal/StageFactory.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include <boost/program_options.hpp>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "kernels.density",
+    "Density Kernel",
+    "http://pdal.io/apps.html#density-command" );
+
+CREATE_STATIC_PLUGIN(1, 0, DensityKernel, Kernel, s_info)
+
+std::string DensityKernel::getName() const { return s_info.name; }
+
+
+DensityKernel::DensityKernel() : m_resolution(0), m_chunkSize(1000000)
+{}
+
+
+void DensityKernel::addSwitches()
+{
+    po::options_description* file_options =
+        new po::options_description("file options");
+
+    file_options->add_options()
+        ("input,i", po::value<std::string>(&m_inputFile)->default_value(""),
+            "input file name")
+        ("output,o", po::value<std::string>(&m_outputFile)->default_value(""),
+            "output raster file name")
+        ("resolution", po::value<double>(&m_resolution)->default_value(0),
+            "Length of the sides of the raster cells")
+        ("boundary", po::value<std::string>(&m_boundaryFile)->
+            default_value(""), "Name of a file to which the WKT of the "
+            "hexagonal boundary of the points is written")
+        ("chunk", po::value<point_count_t>(&m_chunkSize)->
+            default_value(1000000), "Number of points read at a time")
+        ;
+
+    addSwitchSet(file_options);
+    addPositionalSwitch("input", 1);
+    addPositionalSwitch("output", 1);
+}
+
+
+void DensityKernel::validateSwitches()
+{
+    if (m_inputFile.empty())
+        throw app_usage_error("input file name required");
+    if (m_outputFile.empty())
+        throw app_usage_error("output file name required");
+    if (m_resolution <= 0)
+        throw app_usage_error("--resolution must be greater than 0");
+    if (m_chunkSize == 0)
+        throw app_usage_error("--chunk must be greater than 0");
+}
+
+
+int DensityKernel::execute()
+{
+    auto applyExtraOptions = [this](Stage& stage)
+    {
+        auto pi = getExtraStageOptions().find(stage.getName());
+        if (pi == getExtraStageOptions().end())
+            return;
+        Options opts = stage.getOptions();
+        for (const auto& o : pi->second.getOptions())
+            opts.add(o);
+        stage.setOptions(opts);
+    };
+
+    StageFactory factory;
+    auto createStage = [this, &factory](const std::string& name) -> Stage&
+    {
+        Stage *stage = factory.createStage(name);
+        if (!stage)
+            throw app_runtime_error("can't create stage " + name);
+        return ownStage(stage);
+    };
+
+    Stage& reader = makeReader(m_inputFile);
+    Options readerOptions;
+    readerOptions.add("filename", m_inputFile);
+    readerOptions.add("debug", isDebug());
+    readerOptions.add("verbose", getVerboseLevel());
+    reader.setOptions(readerOptions);
+    applyExtraOptions(reader);
+    Stage *last = &reader;
+
+    Stage *hexbin = NULL;
+    if (m_boundaryFile.size())
+    {
+        hexbin = &createStage("filters.hexbin");
+        hexbin->setInput(*last);
+        applyExtraOptions(*hexbin);
+        last = hexbin;
+    }
+
+    // A radius of 0 bins each point into the one cell that contains it.
+    Stage& writer = createStage("writers.gdal");
+    Options writerOptions;
+    writerOptions.add("filename", m_outputFile);
+    writerOptions.add("resolution", m_resolution);
+    writerOptions.add("radius", 0);
+    writerOptions.add("output_type", "count");
+    writerOptions.add("nodata", 0);
+    setCommonOptions(writerOptions);
+    writer.setOptions(writerOptions);
+    applyExtraOptions(writer);
+    writer.setInput(*last);
+
+    // Two chunk slots let the reader fill one chunk while the points of
+    // the other are counted.
+    point_count_t count;
+    FixedPointTable streamTable(m_chunkSize, 2);
+    writer.prepare(streamTable);
+    if (writer.pipelineStreamable())
+        count = writer.executeStream(streamTable);
+    else
+    {
+        std::cerr << "Input can't be streamed.  Reading all points at "
+            "once." << std::endl;
+        PointTable table;
+        writer.prepare(table);
+        PointViewSet views = writer.execute(table);
+        count = 0;
+        for (auto const& view : views)
+            count += view->size();
+    }
+
+    if (hexbin)
+    {
+        MetadataNode boundary = hexbin->getMetadata().findChild("boundary");
+        std::ostream *out = FileUtils::createFile(m_boundaryFile, false);
+        if (!out)
+            throw app_runtime_error("can't create boundary file " +
+                m_boundaryFile);
+        *out << boundary.value() << std::endl;
+        FileUtils::closeFile(out);
+    }
+
+    if (getVerboseLevel())
+        std::cerr << "Counted " << count << " points in cells of " <<
+            m_resolution << "." << std::endl;
+    return 0;
+}
+
+} // namespace pdal
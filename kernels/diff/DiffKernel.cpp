@@ -34,10 +34,19 @@
 
 #include "DiffKernel.hpp"
 
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <thread>
 
 #include <pdal/PDALUtils.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/Utils.hpp>
+#include <pdal/Writer.hpp>
+
+#include "BoundedQueue.hpp"
 
 #include <boost/program_options.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -57,12 +66,80 @@ CREATE_STATIC_PLUGIN(1, 0, DiffKernel, Kernel, s_info)
 
 std::string DiffKernel::getName() const { return s_info.name; }
 
+namespace
+{
+
+// Points of a chunk, packed with the types being compared.  A null chunk
+// marks the end of an input.
+typedef std::shared_ptr<std::vector<char>> PackedChunk;
+
+// Thrown to stop reading an input once the diff is done with it.
+struct DiffStopped
+{};
+
+// Terminates a streamed pipeline.  Each chunk it's given is packed and
+// passed through a queue to the thread doing the comparison.
+class ChunkQueueWriter : public Writer
+{
+public:
+    ChunkQueueWriter(BoundedQueue<PackedChunk>& queue) : m_queue(queue),
+        m_pointSize(0)
+    {}
+
+    std::string getName() const
+        { return "writers.diffqueue"; }
+    void setDims(const DimTypeList& dims, std::size_t pointSize)
+    {
+        m_dims = dims;
+        m_pointSize = pointSize;
+    }
+    virtual bool streamable() const
+        { return true; }
+
+private:
+    BoundedQueue<PackedChunk>& m_queue;
+    DimTypeList m_dims;
+    std::size_t m_pointSize;
+
+    virtual void write(const PointViewPtr view)
+    {
+        PackedChunk chunk(new std::vector<char>(view->size() * m_pointSize));
+        char *pos = chunk->data();
+        for (PointId idx = 0; idx < view->size(); ++idx)
+        {
+            view->getPackedPoint(m_dims, idx, pos);
+            pos += m_pointSize;
+        }
+        if (!m_queue.push(chunk))
+            throw DiffStopped();
+    }
+
+    ChunkQueueWriter& operator=(const ChunkQueueWriter&); // not implemented
+    ChunkQueueWriter(const ChunkQueueWriter&); // not implemented
+};
+
+// Number of points packed at once.
+const point_count_t DefaultChunkSize = 65536;
+// Number of points compared by each task.
+const point_count_t BlockSize = 4096;
+
+} // unnamed namespace
+
+
 DiffKernel::DiffKernel()
     : Kernel()
     , m_sourceFile("")
     , m_candidateFile("")
     , m_useXML(false)
     , m_useJSON(false)
+    , m_stream(false)
+    , m_ignoreMetadata(false)
+    , m_maxDiffs(20)
+    , m_chunkSize(DefaultChunkSize)
+    , m_defaultTolerance(-1.0)
+    , m_pointSize(0)
+    , m_exact(true)
+    , m_diffCount(0)
 
 {}
 
@@ -73,6 +150,34 @@ void DiffKernel::validateSwitches()
         throw app_runtime_error("No source file given!");
     if (!m_candidateFile.size())
         throw app_runtime_error("No candidate file given!");
+    if (m_chunkSize == 0)
+        throw app_usage_error("--chunk-size must be greater than 0");
+
+    // Tolerances are a list of <dimension>=<tolerance>.  A tolerance
+    // without a dimension applies to every dimension not listed.
+    StringList specs = Utils::split2(m_toleranceSpec, ',');
+    for (auto spec : specs)
+    {
+        std::string name;
+        std::string value(spec);
+        std::string::size_type pos = spec.find('=');
+        if (pos != std::string::npos)
+        {
+            name = spec.substr(0, pos);
+            value = spec.substr(pos + 1);
+            Utils::trim(name);
+        }
+        Utils::trim(value);
+
+        double tolerance;
+        std::istringstream iss(value);
+        if (!(iss >> tolerance) || !iss.eof() || tolerance < 0)
+            throw app_usage_error("Invalid --tolerance '" + spec + "'");
+        if (name.empty())
+            m_defaultTolerance = tolerance;
+        else
+            m_tolerances[name] = tolerance;
+    }
 }
 
 
@@ -99,7 +204,26 @@ void DiffKernel::addSwitches()
     po::options_description* processing_options =
         new po::options_description("processing options");
 
-    processing_options->add_options();
+    processing_options->add_options()
+        ("stream",
+            po::value<bool>(&m_stream)->zero_tokens()->implicit_value(true),
+            "read both files a chunk at a time rather than all at once")
+        ("chunk-size",
+            po::value<point_count_t>(&m_chunkSize)->
+                default_value(DefaultChunkSize),
+            "number of points read at a time when streaming")
+        ("tolerance", po::value<std::string>(&m_toleranceSpec),
+            "largest differences allowed, as a list of "
+            "<dimension>=<tolerance>.  A tolerance without a dimension "
+            "applies to all other dimensions")
+        ("ignore-metadata",
+            po::value<bool>(&m_ignoreMetadata)->zero_tokens()->
+                implicit_value(true),
+            "don't compare the metadata of the files")
+        ("max-diffs",
+            po::value<point_count_t>(&m_maxDiffs)->default_value(20),
+            "stop after this many differences (0 for no limit)")
+    ;
 
     addSwitchSet(processing_options);
 
@@ -108,70 +232,358 @@ void DiffKernel::addSwitches()
 }
 
 
+Stage& DiffKernel::makeDiffReader(const std::string& filename)
+{
+    Options options;
+    options.add<std::string>("filename", filename);
+    options.add<bool>("debug", isDebug());
+    options.add<uint32_t>("verbose", getVerboseLevel());
+
+    Stage& reader = makeReader(filename);
+    reader.setOptions(options);
+    return reader;
+}
+
+
+// Match the dimensions of the inputs by name and pick the types with which
+// points are packed for comparison.  Returns false, noting the error, if
+// the inputs don't have the same dimensions.
+bool DiffKernel::selectDims(const PointLayoutPtr source,
+    const PointLayoutPtr candidate, ptree& errors)
+{
+    if (candidate->dims().size() != source->dims().size())
+    {
+        std::ostringstream oss;
+
+        oss << "Source and candidate files do not have the same "
+            "number of dimensions";
+        errors.put<std::string>("schema.error", oss.str());
+        return false;
+    }
+
+    m_dims.clear();
+    m_sourceTypes.clear();
+    m_candidateTypes.clear();
+    m_pointSize = 0;
+    m_exact = true;
+    for (auto sd : source->dims())
+    {
+        DiffDim dim;
+        dim.m_name = source->dimName(sd);
+        Dimension::Id::Enum cd = candidate->findDim(dim.m_name);
+        if (cd == Dimension::Id::Unknown)
+        {
+            errors.put<std::string>("schema.error", "Candidate file has "
+                "no dimension \"" + dim.m_name + "\"");
+            return false;
+        }
+
+        auto ti = m_tolerances.find(dim.m_name);
+        dim.m_tolerance = (ti == m_tolerances.end()) ?
+            m_defaultTolerance : ti->second;
+
+        // The values of a dimension whose types differ, or that is
+        // compared with a tolerance, are compared as doubles.
+        dim.m_type = source->dimType(sd);
+        if (dim.m_type != candidate->dimType(cd) || dim.m_tolerance >= 0)
+            dim.m_type = Dimension::Type::Double;
+        if (dim.m_tolerance >= 0)
+            m_exact = false;
+
+        dim.m_offset = m_pointSize;
+        m_pointSize += Dimension::size(dim.m_type);
+        m_sourceTypes.push_back(DimType(sd, dim.m_type));
+        m_candidateTypes.push_back(DimType(cd, dim.m_type));
+        m_dims.push_back(dim);
+    }
+    return true;
+}
+
+
+void DiffKernel::checkMetadata(MetadataNode source, MetadataNode candidate,
+    ptree& errors)
+{
+    if (!m_ignoreMetadata && source != candidate)
+    {
+        std::ostringstream oss;
+
+        oss << "Source and candidate files do not have the same metadata count";
+        errors.put("metadata.error", oss.str());
+        errors.put_child("metadata.source", utils::toPTree(source));
+        errors.put_child("metadata.candidate", utils::toPTree(candidate));
+    }
+}
+
+
+// Compare 'count' packed points of each input.  Blocks of points are
+// compared in parallel on the shared thread pool.  Blocks are first
+// compared whole with memcmp() when no tolerances apply, so identical data
+// costs little more than a read.  Differences are noted in point order.
+void DiffKernel::compareChunk(const char *source, const char *candidate,
+    point_count_t count, PointId first, ptree& errors)
+{
+    // A difference is the index of a point within the chunk and the index
+    // of the dimension that differs.
+    typedef std::vector<std::pair<PointId, std::size_t>> DiffList;
+
+    const point_count_t limit = m_maxDiffs ? m_maxDiffs - m_diffCount :
+        (std::numeric_limits<point_count_t>::max)();
+    const std::size_t numBlocks = (count + BlockSize - 1) / BlockSize;
+    std::vector<DiffList> diffs(numBlocks);
+
+    auto differs = [](const DiffDim& dim, const char *s, const char *c)
+    {
+        s += dim.m_offset;
+        c += dim.m_offset;
+        if (dim.m_tolerance < 0)
+            return memcmp(s, c, Dimension::size(dim.m_type)) != 0;
+
+        double sv;
+        double cv;
+        memcpy(&sv, s, sizeof(sv));
+        memcpy(&cv, c, sizeof(cv));
+        if (std::isnan(sv) || std::isnan(cv))
+            return std::isnan(sv) != std::isnan(cv);
+        return std::fabs(sv - cv) > dim.m_tolerance;
+    };
+
+    ThreadPool::shared().parallelFor(numBlocks, 1,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t b = begin; b < end; ++b)
+            {
+                PointId start = b * BlockSize;
+                PointId stop = (std::min)(count, start + BlockSize);
+                if (m_exact && memcmp(source + start * m_pointSize,
+                        candidate + start * m_pointSize,
+                        (stop - start) * m_pointSize) == 0)
+                    continue;
+
+                DiffList& list = diffs[b];
+                for (PointId idx = start; idx < stop; ++idx)
+                {
+                    const char *s = source + idx * m_pointSize;
+                    const char *c = candidate + idx * m_pointSize;
+                    if (m_exact && memcmp(s, c, m_pointSize) == 0)
+                        continue;
+                    for (std::size_t d = 0; d < m_dims.size(); ++d)
+                        if (list.size() < limit && differs(m_dims[d], s, c))
+                            list.push_back(std::make_pair(idx, d));
+                    if (list.size() >= limit)
+                        break;
+                }
+            }
+        });
+
+    for (auto const& list : diffs)
+        for (auto const& diff : list)
+        {
+            if (limitReached())
+                return;
+            std::ostringstream oss;
+
+            oss << "Point " << (first + diff.first) << " differs for "
+                "dimension \"" << m_dims[diff.second].m_name <<
+                "\" for source and candidate";
+            errors.add<std::string>("data.error", oss.str());
+            m_diffCount++;
+        }
+}
+
+
 void DiffKernel::checkPoints(const PointView& source_data,
     const PointView& candidate_data, ptree& errors)
 {
-    uint32_t MAX_BADBYTES(20);
-    uint32_t badbytes(0);
+    std::vector<char> sbuf;
+    std::vector<char> cbuf;
+    for (PointId first = 0; first < source_data.size(); first += m_chunkSize)
+    {
+        point_count_t count = (std::min)(m_chunkSize,
+            source_data.size() - first);
+        sbuf.resize(count * m_pointSize);
+        cbuf.resize(count * m_pointSize);
+        for (PointId idx = 0; idx < count; ++idx)
+        {
+            source_data.getPackedPoint(m_sourceTypes, first + idx,
+                sbuf.data() + idx * m_pointSize);
+            candidate_data.getPackedPoint(m_candidateTypes, first + idx,
+                cbuf.data() + idx * m_pointSize);
+        }
+        compareChunk(sbuf.data(), cbuf.data(), count, first, errors);
+        if (limitReached())
+            break;
+    }
+}
 
-    // Both schemas have already been determined to be equal, so are the
-    // same size and in the same order.
-    Dimension::IdList const& sourceDims = source_data.dims();
-    Dimension::IdList const& candidateDims = candidate_data.dims();
 
-    char sbuf[8];
-    char cbuf[8];
-    for (PointId idx = 0; idx < source_data.size(); ++idx)
+// Read both files a chunk at a time, each on a thread of its own, and
+// compare the points in step as the chunks arrive.  Readers may return
+// chunks of different sizes, so each input keeps its place in its current
+// chunk.
+void DiffKernel::streamPoints(ptree& errors)
+{
+    Stage& source = makeDiffReader(m_sourceFile);
+    Stage& candidate = makeDiffReader(m_candidateFile);
+
+    // Two chunks can be queued from each input while one is compared.
+    BoundedQueue<PackedChunk> sourceQueue(2);
+    BoundedQueue<PackedChunk> candidateQueue(2);
+    ChunkQueueWriter sourceSink(sourceQueue);
+    ChunkQueueWriter candidateSink(candidateQueue);
+    sourceSink.setInput(source);
+    candidateSink.setInput(candidate);
+
+    FixedPointTable sourceTable(m_chunkSize);
+    FixedPointTable candidateTable(m_chunkSize);
+    sourceSink.prepare(sourceTable);
+    candidateSink.prepare(candidateTable);
+    if (!selectDims(sourceTable.layout(), candidateTable.layout(), errors))
+        return;
+    sourceSink.setDims(m_sourceTypes, m_pointSize);
+    candidateSink.setDims(m_candidateTypes, m_pointSize);
+
+    auto run = [](Stage& sink, FixedPointTable& table,
+        BoundedQueue<PackedChunk>& queue, std::exception_ptr& error)
     {
-        for (size_t d = 0; d < sourceDims.size(); ++d)
+        try
         {
-            Dimension::Id::Enum sd = sourceDims[d];
-            Dimension::Id::Enum cd = candidateDims[d];
-
-            source_data.getRawField(sd, idx, (void *)sbuf);
-            candidate_data.getRawField(cd, idx, (void *)cbuf);
-            Dimension::Type::Enum t = Dimension::defaultType(cd);
-            size_t size = Dimension::size(t);
-            if (memcmp(sbuf, cbuf, size))
-            {
-                std::ostringstream oss;
+            sink.executeStream(table);
+            queue.push(PackedChunk());
+        }
+        catch (DiffStopped&)
+        {}
+        catch (...)
+        {
+            error = std::current_exception();
+            queue.close();
+        }
+    };
+
+    std::exception_ptr sourceError;
+    std::exception_ptr candidateError;
+    std::thread sourceThread(run, std::ref(sourceSink),
+        std::ref(sourceTable), std::ref(sourceQueue), std::ref(sourceError));
+    std::thread candidateThread(run, std::ref(candidateSink),
+        std::ref(candidateTable), std::ref(candidateQueue),
+        std::ref(candidateError));
+
+    // Take the next chunk from an input once the current one is used up.
+    // Returns false at the end of the input.
+    auto next = [this](BoundedQueue<PackedChunk>& queue, PackedChunk& chunk,
+        point_count_t& pos)
+    {
+        if (chunk && pos < chunk->size() / m_pointSize)
+            return true;
+        pos = 0;
+        if (!queue.pop(chunk))
+            chunk.reset();
+        return (bool)chunk;
+    };
+
+    PackedChunk sourceChunk;
+    PackedChunk candidateChunk;
+    point_count_t sourcePos = 0;
+    point_count_t candidatePos = 0;
+    point_count_t sourceCount = 0;
+    point_count_t candidateCount = 0;
+    bool sourceMore = true;
+    bool candidateMore = true;
+    try
+    {
+        while (!limitReached())
+        {
+            sourceMore = next(sourceQueue, sourceChunk, sourcePos);
+            candidateMore = next(candidateQueue, candidateChunk,
+                candidatePos);
+            if (!sourceMore || !candidateMore)
+                break;
+
+            point_count_t count = (std::min)(
+                sourceChunk->size() / m_pointSize - sourcePos,
+                candidateChunk->size() / m_pointSize - candidatePos);
+            compareChunk(sourceChunk->data() + sourcePos * m_pointSize,
+                candidateChunk->data() + candidatePos * m_pointSize,
+                count, sourceCount, errors);
+            sourcePos += count;
+            candidatePos += count;
+            sourceCount += count;
+            candidateCount += count;
+        }
 
-                oss << "Point " << idx << " differs for dimension \"" <<
-                    Dimension::name(sd) << "\" for source and candidate";
-                errors.put<std::string>("data.error", oss.str());
-                badbytes++;
+        // Read the rest of an input that's longer than the other to count
+        // its points.
+        if (!limitReached() && sourceMore != candidateMore)
+        {
+            BoundedQueue<PackedChunk>& queue =
+                sourceMore ? sourceQueue : candidateQueue;
+            PackedChunk& chunk = sourceMore ? sourceChunk : candidateChunk;
+            point_count_t& pos = sourceMore ? sourcePos : candidatePos;
+            point_count_t& total = sourceMore ? sourceCount : candidateCount;
+            while (next(queue, chunk, pos))
+            {
+                point_count_t count = chunk->size() / m_pointSize - pos;
+                pos += count;
+                total += count;
             }
         }
-        if (badbytes > MAX_BADBYTES )
-            break;
     }
+    catch (...)
+    {
+        sourceQueue.close();
+        candidateQueue.close();
+        sourceThread.join();
+        candidateThread.join();
+        throw;
+    }
+
+    // Closing the queues stops an input that we're done with.
+    sourceQueue.close();
+    candidateQueue.close();
+    sourceThread.join();
+    candidateThread.join();
+    if (sourceError)
+        std::rethrow_exception(sourceError);
+    if (candidateError)
+        std::rethrow_exception(candidateError);
+
+    if (!limitReached() && sourceCount != candidateCount)
+    {
+        std::ostringstream oss;
+
+        oss << "Source and candidate files do not have the same point count";
+        errors.put("count.error", oss.str());
+        errors.put("count.candidate", candidateCount);
+        errors.put("count.source", sourceCount);
+    }
+    checkMetadata(sourceTable.metadata(), candidateTable.metadata(), errors);
 }
 
 
 int DiffKernel::execute()
 {
-    PointTable sourceTable;
+    ptree errors;
+
+    if (m_stream)
+    {
+        streamPoints(errors);
+        if (m_diffCount)
+            errors.put("data.count", m_diffCount);
+        if (errors.size())
+        {
+            write_json(std::cout, errors);
+            return 1;
+        }
+        return 0;
+    }
 
-    Options sourceOptions;
-    sourceOptions.add<std::string>("filename", m_sourceFile);
-    sourceOptions.add<bool>("debug", isDebug());
-    sourceOptions.add<uint32_t>("verbose", getVerboseLevel());
+    PointTable sourceTable;
 
-    Stage& source = makeReader(m_sourceFile);
-    source.setOptions(sourceOptions);
+    Stage& source = makeDiffReader(m_sourceFile);
     source.prepare(sourceTable);
     PointViewSet sourceSet = source.execute(sourceTable);
 
-    ptree errors;
-
     PointTable candidateTable;
-    Options candidateOptions;
-    candidateOptions.add<std::string>("filename", m_candidateFile);
-    candidateOptions.add<bool>("debug", isDebug());
-    candidateOptions.add<uint32_t>("verbose", getVerboseLevel());
-
-    Stage& candidate = makeReader(m_candidateFile);
-    candidate.setOptions(candidateOptions);
+    Stage& candidate = makeDiffReader(m_candidateFile);
     candidate.prepare(candidateTable);
     PointViewSet candidateSet = candidate.execute(candidateTable);
 
@@ -189,45 +601,23 @@ int DiffKernel::execute()
         errors.put("count.source", sourceView->size());
     }
 
-    MetadataNode source_metadata = sourceTable.metadata();
-    MetadataNode candidate_metadata = candidateTable.metadata();
-    if (source_metadata != candidate_metadata)
-    {
-        std::ostringstream oss;
-
-        oss << "Source and candidate files do not have the same metadata count";
-        errors.put("metadata.error", oss.str());
-        errors.put_child("metadata.source", utils::toPTree(source_metadata));
-        errors.put_child("metadata.candidate",
-            utils::toPTree(candidate_metadata));
-    }
-
-    if (candidateTable.layout()->dims().size() !=
-        sourceTable.layout()->dims().size())
-    {
-        std::ostringstream oss;
-
-        oss << "Source and candidate files do not have the same "
-            "number of dimensions";
-        errors.put<std::string>("schema.error", oss.str());
-        //Need to "ptree" the PointTable dimension list in some way
-        // errors.put_child("schema.source", sourceTable.schema()->toPTree());
-        // errors.put_child("schema.candidate",
-        //     candidateTable.schema()->toPTree());
-    }
+    checkMetadata(sourceTable.metadata(), candidateTable.metadata(), errors);
+    bool dimsMatch = selectDims(sourceTable.layout(), candidateTable.layout(),
+        errors);
 
     if (errors.size())
     {
         write_json(std::cout, errors);
         return 1;
     }
-    else
+    else if (dimsMatch)
     {
         // If we made it this far with no errors, now we'll
         // check the points.
         checkPoints(*sourceView, *candidateView, errors);
         if (errors.size())
         {
+            errors.put("data.count", m_diffCount);
             write_json(std::cout, errors);
             return 1;
         }
@@ -236,4 +626,3 @@ int DiffKernel::execute()
 }
 
 } // namespace pdal
-
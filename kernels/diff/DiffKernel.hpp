@@ -40,6 +40,8 @@
 
 #include <boost/property_tree/ptree.hpp>
 
+#include <map>
+
 extern "C" int32_t DiffKernel_ExitFunc();
 extern "C" PF_ExitFunc DiffKernel_InitPlugin();
 
@@ -62,13 +64,54 @@ private:
     void addSwitches(); // overrride
     void validateSwitches(); // overrride
 
+    // A dimension compared, found by name in both inputs.  Points of
+    // both inputs are packed with the same types, so that a dimension's
+    // values are at the same offset in both.
+    struct DiffDim
+    {
+        std::string m_name;
+        Dimension::Type::Enum m_type;
+        std::size_t m_offset;
+        // Largest difference allowed, or negative if values must be
+        // identical.  Dimensions with a tolerance are packed as doubles.
+        double m_tolerance;
+    };
+
+    Stage& makeDiffReader(const std::string& filename);
+    bool selectDims(const PointLayoutPtr source,
+        const PointLayoutPtr candidate, boost::property_tree::ptree& errors);
+    void checkMetadata(MetadataNode source, MetadataNode candidate,
+        boost::property_tree::ptree& errors);
     void checkPoints(const PointView& source_data,
         const PointView& candidate_data,
         boost::property_tree::ptree& errors);
+    void streamPoints(boost::property_tree::ptree& errors);
+    void compareChunk(const char *source, const char *candidate,
+        point_count_t count, PointId first,
+        boost::property_tree::ptree& errors);
+    bool limitReached() const
+        { return m_maxDiffs && m_diffCount >= m_maxDiffs; }
+
     std::string m_sourceFile;
     std::string m_candidateFile;
     bool m_useXML;
     bool m_useJSON;
+    bool m_stream;
+    bool m_ignoreMetadata;
+    std::string m_toleranceSpec;
+    point_count_t m_maxDiffs;
+    point_count_t m_chunkSize;
+
+    std::map<std::string, double> m_tolerances;
+    double m_defaultTolerance;
+    std::vector<DiffDim> m_dims;
+    DimTypeList m_sourceTypes;
+    DimTypeList m_candidateTypes;
+    std::size_t m_pointSize;
+    // Whether every dimension must be identical, so that points can be
+    // compared with memcmp().
+    bool m_exact;
+    point_count_t m_diffCount;
 };
 
 } // namespace pdal
@@ -39,10 +39,16 @@
 #include <pdal/KDIndex.hpp>
 #include <pdal/PipelineWriter.hpp>
 #include <pdal/PDALUtils.hpp>
+#include <pdal/Reader.hpp>
 #include <pdal/pdal_config.hpp>
+#include <pdal/ThreadPool.hpp>
 
 #include <boost/program_options.hpp>
 
+#include <atomic>
+#include <mutex>
+#include <random>
+
 namespace pdal
 {
 
@@ -61,9 +67,18 @@ InfoKernel::InfoKernel()
     , m_showAll(false)
     , m_showMetadata(false)
     , m_boundary(false)
+    , m_seekPoints(false)
     , m_useJSON(false)
     , m_showSummary(false)
+    , m_mapInput(false)
+    , m_threads(0)
+    , m_sample(0)
+    , m_sampleStep(1)
+    , m_sampleOffset(0)
+    , m_sampleRandom(false)
     , m_statsStage(NULL)
+    , m_hexbinStage(NULL)
+    , m_reader(NULL)
 {}
 
 
@@ -90,6 +105,8 @@ void InfoKernel::validateSwitches()
         throw pdal_error("Incompatible options.");
     else if (functions == 0)
         m_showStats = true;
+    if (m_sample && (m_pointIndexes.size() || m_QueryPoint.size()))
+        throw pdal_error("--sample can't be used with --point or --query.");
 }
 
 
@@ -125,6 +142,11 @@ void InfoKernel::addSwitches()
          "compute a hexagonal hull/boundary of dataset")
         ("dimensions", po::value<std::string >(&m_Dimensions),
          "dimensions on which to compute statistics")
+        ("percentiles", po::value<std::string>(&m_percentiles),
+         "percentiles (0 - 100) to estimate with statistics")
+        ("histograms", po::value<std::string>(&m_histograms),
+         "histograms to compute with statistics, as "
+         "<dimension>:<minimum>:<maximum>:<bins>")
         ("schema",
          po::value<bool>(&m_showSchema)->zero_tokens()->implicit_value(true),
          "dump the schema")
@@ -132,10 +154,23 @@ void InfoKernel::addSwitches()
          po::value<std::string>(&m_pipelineFile)->default_value(""), "")
         ("summary",
          po::value<bool>(&m_showSummary)->zero_tokens()->implicit_value(true),
-        "dump summary of the info")
+        "dump summary of the info read from the file header.  An input "
+        "pattern such as 'tiles/*.las' summarizes every matching file")
+        ("threads",
+         po::value<size_t>(&m_threads)->default_value(0),
+         "Number of files summarized at once.  Zero uses one for each "
+         "hardware thread")
         ("metadata",
          po::value<bool>(&m_showMetadata)->zero_tokens()->implicit_value(true),
         "dump file metadata info")
+        ("mmap",
+         po::value<bool>(&m_mapInput)->zero_tokens()->implicit_value(true),
+        "map uncompressed LAS or BPF point data into memory instead of "
+        "reading it")
+        ("sample",
+         po::value<point_count_t>(&m_sample)->default_value(0),
+        "compute approximate statistics and boundary from about this many "
+        "points spread evenly through the file")
         ;
 
     addSwitchSet(processing_options);
@@ -200,13 +235,24 @@ MetadataNode InfoKernel::dumpPoints(PointViewPtr inView) const
     MetadataNode root;
     PointViewPtr outView = inView->makeNew();
 
-    // Stick points in a inViewfer.
+    // Stick points in a inViewfer.  When the reader sought to the points,
+    // the view holds those of m_readIds that are in the file.
     std::vector<PointId> points = getListOfPoints(m_pointIndexes);
+    std::vector<PointId> found;
     for (size_t i = 0; i < points.size(); ++i)
     {
         PointId id = (PointId)points[i];
+        if (m_seekPoints)
+        {
+            auto it = std::lower_bound(m_readIds.begin(), m_readIds.end(),
+                id);
+            id = (PointId)(it - m_readIds.begin());
+        }
         if (id < inView->size())
+        {
             outView->appendPoint(*inView.get(), id);
+            found.push_back(points[i]);
+        }
     }
 
     MetadataNode tree = utils::toMetadata(outView);
@@ -214,7 +260,7 @@ MetadataNode InfoKernel::dumpPoints(PointViewPtr inView) const
     for (size_t i = 0; i < outView->size(); ++i)
     {
         MetadataNode n = tree.findChild(std::to_string(i));
-        n.add("PointId", points[i]);
+        n.add("PointId", found[i]);
         root.add(n.clone("point"));
     }
     return root;
@@ -247,6 +293,9 @@ MetadataNode InfoKernel::dumpSummary(const QuickInfo& qi)
            dims += ", ";
     }
     summary.add("dimensions", dims);
+    MetadataNode metadata = qi.m_metadata;
+    if (metadata.valid())
+        summary.add(metadata.clone("metadata"));
     return summary;
 }
 
@@ -262,19 +311,73 @@ void InfoKernel::dump(std::ostream& o, const std::string& filename)
         QuickInfo qi = m_reader->preview();
         MetadataNode summary = dumpSummary(qi).clone("summary");
         root.add(summary);
+
+        // The summary comes from the header, so there are no points to read.
+        if (!m_showAll && m_pipelineFile.empty())
+        {
+            root.add("pdal_version", pdal::GetFullVersionString());
+            utils::toJSON(root, o);
+            return;
+        }
+    }
+
+    // Unless points are to be looked at afterward, stream them so that
+    // the reader, statistics and boundary all work on each chunk of
+    // points as it's read, and no more than a few chunks are held at once.
+    // Whether a pipeline can be streamed is only known once it's prepared,
+    // so one that can't is built again and read whole.
+    bool streamed(false);
+    if (!m_pointIndexes.size() && !m_QueryPoint.size() && !m_mapInput)
+    {
+        m_streamTable.reset(new FixedPointTable(1 << 20, 2));
+        m_manager->getStage()->prepare(*m_streamTable);
+        streamed = m_manager->getStage()->pipelineStreamable();
+        if (!streamed)
+        {
+            m_streamTable.reset();
+            makePipeline(filename);
+        }
     }
+
     if (m_showSchema || m_showAll)
     {
-        m_manager->prepare();
+        if (!streamed)
+            m_manager->prepare();
         bPrepared = true;
-        MetadataNode schema =
+        MetadataNode schema = streamed ?
+            utils::toMetadata(*m_streamTable).clone("schema") :
             utils::toMetadata(m_manager->pointTable()).clone("schema");
         root.add(schema);
     }
-    if (!bPrepared)
+    if (!bPrepared && !streamed)
         m_manager->prepare();
 
-    m_manager->execute();
+    // Have a reader that can seek read only the points to dump.
+    if (m_pointIndexes.size() && m_reader == m_manager->getStage())
+    {
+        m_readIds = getListOfPoints(m_pointIndexes);
+        std::sort(m_readIds.begin(), m_readIds.end());
+        m_readIds.erase(std::unique(m_readIds.begin(), m_readIds.end()),
+            m_readIds.end());
+        Reader *reader = dynamic_cast<Reader *>(m_reader);
+        m_seekPoints = reader && reader->setPointIds(m_readIds);
+    }
+
+    if (streamed)
+        m_manager->getStage()->executeStream(*m_streamTable);
+    else
+        m_manager->execute();
+    if (m_sampleRandom)
+    {
+        MetadataNode sample = root.add("sample");
+        sample.add("count", m_sample);
+    }
+    else if (m_sampleStep > 1)
+    {
+        MetadataNode sample = root.add("sample");
+        sample.add("step", m_sampleStep);
+        sample.add("offset", m_sampleOffset);
+    }
     if (m_showStats || m_showAll)
     {
         MetadataNode stats = m_statsStage->getMetadata().clone("stats");
@@ -304,8 +407,6 @@ void InfoKernel::dump(std::ostream& o, const std::string& filename)
     }
     if (m_boundary || m_showAll)
     {
-        PointViewSet viewSet = m_manager->views();
-        assert(viewSet.size() == 1);
         MetadataNode boundary = m_hexbinStage->getMetadata().clone("boundary");
         root.add(boundary);
     }
@@ -337,8 +438,7 @@ MetadataNode InfoKernel::dumpQuery(PointViewPtr inView) const
 
     PointViewPtr outView = inView->makeNew();
 
-    KDIndex kdi(*inView);
-    kdi.build(is3d);
+    const KDIndex& kdi = inView->spatialIndex(is3d);
     std::vector<PointId> ids = kdi.neighbors(x, y, z, inView->size());
     for (auto i = ids.begin(); i != ids.end(); ++i)
         outView->appendPoint(*inView.get(), *i);
@@ -347,26 +447,140 @@ MetadataNode InfoKernel::dumpQuery(PointViewPtr inView) const
 }
 
 
-int InfoKernel::execute()
+// Write a JSON array with the summary of each file that matches the input
+// pattern, in order.  Headers are read on several threads since the time
+// goes to waiting on the file system rather than to the CPU.
+int InfoKernel::summarizeFiles(std::ostream& o)
+{
+    std::vector<std::string> inputs = FileUtils::glob(m_inputFile);
+    if (inputs.empty())
+        throw app_runtime_error("no input files match " + m_inputFile);
+
+    size_t threads = m_threads ? m_threads :
+        std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, inputs.size());
+
+    std::mutex stageMutex;
+    std::atomic<size_t> failed(0);
+    std::vector<std::string> results(inputs.size());
+    auto summarizeOne = [&](size_t i)
+    {
+        MetadataNode root;
+        root.add("filename", inputs[i]);
+        try
+        {
+            std::vector<std::unique_ptr<Stage>> stages;
+            Stage *reader;
+            {
+                std::lock_guard<std::mutex> lock(stageMutex);
+                reader = &makeReader(inputs[i]);
+                stages = takeStages();
+            }
+            Options readerOptions;
+            readerOptions.add("filename", inputs[i]);
+            reader->setOptions(readerOptions);
+            root.add(dumpSummary(reader->preview()).clone("summary"));
+        }
+        catch (std::exception& e)
+        {
+            failed++;
+            root.add("error", e.what());
+        }
+        std::ostringstream oss;
+        utils::toJSON(root, oss);
+        results[i] = oss.str();
+    };
+
+    ThreadPool pool(threads);
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < inputs.size(); ++i)
+        futures.push_back(pool.submit(std::bind(summarizeOne, i)));
+
+    // Write each summary as soon as those before it are done, so results
+    // needn't all be held at once.
+    o << "[" << std::endl;
+    for (size_t i = 0; i < futures.size(); ++i)
+    {
+        pool.wait(futures[i]);
+        if (i)
+            o << "," << std::endl;
+        o << results[i];
+        results[i].clear();
+        results[i].shrink_to_fit();
+    }
+    o << std::endl << "]" << std::endl;
+
+    if (failed)
+    {
+        std::cerr << "PDAL: " << failed << " of " << inputs.size() <<
+            " files couldn't be summarized." << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+
+// Build the pipeline: the reader, then a filter that picks the sample if
+// one was asked for, then the stages that compute what's to be shown.
+void InfoKernel::makePipeline(const std::string& filename)
 {
     Options readerOptions;
 
-    std::string filename = m_usestdin ? std::string("STDIN") : m_inputFile;
     readerOptions.add("filename", filename);
     if (m_showMetadata)
         readerOptions.add("count", 0);
 
-    m_manager = std::unique_ptr<PipelineManager>(
-        KernelSupport::makePipeline(filename));
+    if (m_mapInput)
+    {
+        m_mapTable.reset(new MappedPointTable);
+        m_manager = std::unique_ptr<PipelineManager>(
+            KernelSupport::makePipeline(filename, *m_mapTable));
+    }
+    else
+        m_manager = std::unique_ptr<PipelineManager>(
+            KernelSupport::makePipeline(filename));
     m_reader = m_manager->getStage();
     Stage *stage = m_reader;
 
-    if (m_Dimensions.size())
-        m_options.add("dimensions", m_Dimensions, "List of dimensions");
-
     Options options = m_options + readerOptions;
     m_reader->setOptions(options);
 
+    // The sample is every n'th point from a random start, which readers
+    // that can seek read without touching the points between.
+    if (m_sample)
+    {
+        // Without the number of points there's no step to take, so
+        // gather a random sample of the points as they're read instead.
+        QuickInfo qi = m_reader->preview();
+        if (!qi.valid())
+        {
+            m_sampleRandom = true;
+            Options sampleOptions;
+            sampleOptions.add("mode", "random");
+            sampleOptions.add("count", m_sample);
+            sampleOptions.add("seed", std::random_device{}());
+            Stage& sampler = m_manager->addFilter("filters.decimation");
+            sampler.setOptions(sampleOptions);
+            sampler.setInput(*stage);
+            stage = &sampler;
+        }
+        else if (qi.m_pointCount > m_sample)
+        {
+            m_sampleStep = (qi.m_pointCount + m_sample - 1) / m_sample;
+            std::mt19937 gen(std::random_device{}());
+            m_sampleOffset = std::uniform_int_distribution<point_count_t>(
+                0, m_sampleStep - 1)(gen);
+
+            Options sampleOptions;
+            sampleOptions.add("step", m_sampleStep);
+            sampleOptions.add("offset", m_sampleOffset);
+            Stage& sampler = m_manager->addFilter("filters.decimation");
+            sampler.setOptions(sampleOptions);
+            sampler.setInput(*stage);
+            stage = &sampler;
+        }
+    }
+
     if (m_showStats || m_showAll)
     {
         m_statsStage = &(m_manager->addFilter("filters.stats"));
@@ -381,7 +595,25 @@ int InfoKernel::execute()
         m_hexbinStage->setInput(*stage);
         stage = m_hexbinStage;
     }
+}
+
+
+int InfoKernel::execute()
+{
+    if (m_showSummary && !m_usestdin &&
+        m_inputFile.find_first_of("*?") != std::string::npos)
+        return summarizeFiles(std::cout);
+
+    std::string filename = m_usestdin ? std::string("STDIN") : m_inputFile;
+
+    if (m_Dimensions.size())
+        m_options.add("dimensions", m_Dimensions, "List of dimensions");
+    if (m_percentiles.size())
+        m_options.add("percentiles", m_percentiles, "List of percentiles");
+    if (m_histograms.size())
+        m_options.add("histograms", m_histograms, "List of histograms");
 
+    makePipeline(filename);
     dump(std::cout, filename);
 
     return 0;
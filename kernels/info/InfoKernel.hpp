@@ -68,7 +68,9 @@ private:
     void addSwitches(); // overrride
     void validateSwitches(); // overrride
 
+    void makePipeline(const std::string& filename);
     void dump(std::ostream& o, const std::string& filename);
+    int summarizeFiles(std::ostream& o);
 
     MetadataNode dumpPoints(PointViewPtr inView) const;
     MetadataNode dumpStats() const;
@@ -84,18 +86,38 @@ private:
     bool m_boundary;
     pdal::Options m_options;
     std::string m_pointIndexes;
+    // Whether the reader reads only the points to dump, which are then
+    // those of m_readIds that it has.
+    bool m_seekPoints;
+    std::vector<PointId> m_readIds;
     bool m_useJSON;
     std::string m_Dimensions;
+    std::string m_percentiles;
+    std::string m_histograms;
     std::string m_QueryPoint;
     double m_QueryDistance;
     std::string m_pipelineFile;
     bool m_showSummary;
+    bool m_mapInput;
+    size_t m_threads;
+    point_count_t m_sample;
+    // Every m_sampleStep'th point from m_sampleOffset is read when
+    // sampling.
+    point_count_t m_sampleStep;
+    point_count_t m_sampleOffset;
+    // Whether a random sample of m_sample points is taken instead, when
+    // the number of points isn't known.
+    bool m_sampleRandom;
 
     Stage *m_statsStage;
     Stage *m_hexbinStage;
     Stage *m_reader;
 
     MetadataNode m_tree;
+    // The table must outlive the pipeline that uses it.
+    std::unique_ptr<MappedPointTable> m_mapTable;
+    // Holds a chunk of points at a time when the pipeline is streamed.
+    std::unique_ptr<FixedPointTable> m_streamTable;
     std::unique_ptr<PipelineManager> m_manager;
 };
 
@@ -0,0 +1,139 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "LasIndexKernel.hpp"
+
+#include <pdal/util/FileUtils.hpp>
+#include <las/LasIndex.hpp>
+#include <las/LasReader.hpp>
+
+#include <boost/program_options.hpp>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "kernels.lasindex",
+    "LAS Index Kernel",
+    "http://pdal.io/kernels/kernels.lasindex.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, LasIndexKernel, Kernel, s_info)
+
+std::string LasIndexKernel::getName() const
+{
+    return s_info.name;
+}
+
+
+LasIndexKernel::LasIndexKernel() : m_cellSize(100), m_threshold(1000)
+{}
+
+
+void LasIndexKernel::validateSwitches()
+{
+    if (m_inputFile == "")
+        throw app_usage_error("--input/-i required");
+    if (m_cellSize <= 0)
+        throw app_usage_error("--cell_size must be positive");
+}
+
+
+void LasIndexKernel::addSwitches()
+{
+    po::options_description* file_options =
+        new po::options_description("file options");
+
+    file_options->add_options()
+        ("input,i", po::value<std::string>(&m_inputFile)->default_value(""),
+         "LAS or LAZ file to index")
+        ("output,o", po::value<std::string>(&m_outputFile)->default_value(""),
+         "Index file name.  Defaults to the input name with a .lax "
+         "extension")
+        ("cell_size",
+         po::value<double>(&m_cellSize)->default_value(100),
+         "Smallest width of an index cell, in file units")
+        ("threshold",
+         po::value<point_count_t>(&m_threshold)->default_value(1000),
+         "Join the point ranges of a cell that are fewer than this many "
+         "points apart")
+        ;
+
+    addSwitchSet(file_options);
+    addPositionalSwitch("input", 1);
+    addPositionalSwitch("output", 1);
+}
+
+
+int LasIndexKernel::execute()
+{
+    Options readerOptions;
+    readerOptions.add("filename", m_inputFile);
+    readerOptions.add("debug", isDebug());
+    readerOptions.add("verbose", getVerboseLevel());
+
+    LasReader reader;
+    reader.setOptions(readerOptions);
+
+    // Only the position of each point is needed, so points are streamed
+    // through a small table rather than all held at once.
+    FixedPointTable table(100000);
+    reader.prepare(table);
+
+    LasIndex index;
+    index.setup(reader.header().getBounds(), m_cellSize);
+
+    point_count_t idx = 0;
+    reader.setReadCb([&index, &idx](PointView& view, PointId id)
+    {
+        index.addPoint(idx++, view.getFieldAs<double>(Dimension::Id::X, id),
+            view.getFieldAs<double>(Dimension::Id::Y, id));
+    });
+    reader.executeStream(table);
+    index.complete(m_threshold);
+
+    std::string filename = m_outputFile.size() ? m_outputFile :
+        LasIndex::filename(m_inputFile);
+    std::ostream *out = FileUtils::createFile(filename);
+    if (!out)
+        throw app_runtime_error("can't create index file " + filename);
+    index.write(*out);
+    FileUtils::closeFile(out);
+
+    if (isDebug())
+        std::cerr << "Wrote " << index.cellCount() << " cells for " <<
+            idx << " points to " << filename << std::endl;
+    return 0;
+}
+
+} // namespace pdal
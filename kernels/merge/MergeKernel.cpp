@@ -0,0 +1,243 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "MergeKernel.hpp"
+
+#include <pdal/StageFactory.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "kernels.merge",
+    "Merge Kernel",
+    "http://pdal.io/apps.html#merge-command" );
+
+CREATE_STATIC_PLUGIN(1, 0, MergeKernel, Kernel, s_info)
+
+std::string MergeKernel::getName() const { return s_info.name; }
+
+
+namespace
+{
+
+// Whether two inputs have the same dimensions, in any order.
+bool sameDims(std::vector<std::string> a, std::vector<std::string> b)
+{
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    return a == b;
+}
+
+} // unnamed namespace
+
+
+MergeKernel::MergeKernel() : m_chunkSize(100000), m_slots(3)
+{}
+
+
+void MergeKernel::addSwitches()
+{
+    po::options_description* file_options =
+        new po::options_description("file options");
+
+    file_options->add_options()
+        ("files,f", po::value<std::vector<std::string>>(&m_files)->
+            multitoken(), "Input file names or patterns, then the output "
+            "file name")
+        ("chunk", po::value<point_count_t>(&m_chunkSize)->default_value(100000),
+            "Number of points read at a time")
+        ("slots", po::value<int>(&m_slots)->default_value(3),
+            "Number of chunks in flight at once.  With more than one, "
+            "reading and writing overlap")
+        ;
+
+    addSwitchSet(file_options);
+    addPositionalSwitch("files", -1);
+}
+
+
+void MergeKernel::validateSwitches()
+{
+    if (m_files.size() < 2)
+        throw app_usage_error("input and output file names required");
+    if (m_chunkSize == 0)
+        throw app_usage_error("--chunk must be greater than 0");
+    if (m_slots < 1)
+        throw app_usage_error("--slots must be at least 1");
+
+    m_outputFile = m_files.back();
+    m_inputFiles.clear();
+    for (auto fi = m_files.begin(); fi + 1 != m_files.end(); ++fi)
+    {
+        std::vector<std::string> matches = FileUtils::glob(*fi);
+        if (matches.empty())
+            throw app_usage_error("no input files match " + *fi);
+        m_inputFiles.insert(m_inputFiles.end(), matches.begin(),
+            matches.end());
+    }
+}
+
+
+int MergeKernel::execute()
+{
+    auto applyExtraOptions = [this](Stage& stage)
+    {
+        auto pi = getExtraStageOptions().find(stage.getName());
+        if (pi == getExtraStageOptions().end())
+            return;
+        Options opts = stage.getOptions();
+        for (const auto& o : pi->second.getOptions())
+            opts.add(o);
+        stage.setOptions(opts);
+    };
+
+    // Creating stages loads plugins, which isn't safe on several threads.
+    std::vector<Stage *> readers;
+    for (auto const& filename : m_inputFiles)
+    {
+        Stage& reader = makeReader(filename);
+        Options readerOptions;
+        readerOptions.add("filename", filename);
+        readerOptions.add("debug", isDebug());
+        readerOptions.add("verbose", getVerboseLevel());
+        reader.setOptions(readerOptions);
+        applyExtraOptions(reader);
+        readers.push_back(&reader);
+    }
+
+    // Reading headers is mostly waiting on the file system, so the
+    // inputs are looked at in parallel.
+    std::vector<QuickInfo> infos(readers.size());
+    std::vector<std::string> errors(readers.size());
+    ThreadPool::shared().parallelFor(readers.size(), 1,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                try
+                {
+                    infos[i] = readers[i]->preview();
+                }
+                catch (std::exception& e)
+                {
+                    errors[i] = e.what();
+                }
+            }
+        });
+
+    BOX3D bounds;
+    point_count_t total = 0;
+    bool countKnown = true;
+    for (std::size_t i = 0; i < readers.size(); ++i)
+    {
+        if (errors[i].size())
+            throw app_runtime_error("can't read " + m_inputFiles[i] + ": " +
+                errors[i]);
+        // Readers that can't look at their headers report nothing.
+        const QuickInfo& info = infos[i];
+        if (info.m_dimNames.empty())
+        {
+            countKnown = false;
+            continue;
+        }
+        const QuickInfo& first = infos[0];
+        if (i && first.m_dimNames.size())
+        {
+            if (info.m_srs != first.m_srs)
+                std::cerr << "Warning: " << m_inputFiles[i] << " has a "
+                    "different spatial reference from " << m_inputFiles[0] <<
+                    "." << std::endl;
+            if (!sameDims(info.m_dimNames, first.m_dimNames))
+                std::cerr << "Warning: " << m_inputFiles[i] << " has "
+                    "different dimensions from " << m_inputFiles[0] <<
+                    ".  Dimensions an input lacks will be 0." << std::endl;
+        }
+        if (!info.m_bounds.empty())
+            bounds.grow(info.m_bounds);
+        total += info.m_pointCount;
+    }
+    if (getVerboseLevel())
+    {
+        std::cerr << "Merging " << readers.size() << " files";
+        if (countKnown)
+            std::cerr << ", " << total << " points";
+        std::cerr << "." << std::endl;
+        if (!bounds.empty())
+            std::cerr << "Bounds: " << bounds << std::endl;
+    }
+
+    StageFactory factory;
+    Stage& merge = ownStage(factory.createStage("filters.merge"));
+    for (Stage *reader : readers)
+        merge.setInput(*reader);
+    applyExtraOptions(merge);
+
+    Stage& writer = makeWriter(m_outputFile, merge);
+    Options writerOptions;
+    writerOptions.add("filename", m_outputFile);
+    setCommonOptions(writerOptions);
+    writer.setOptions(writerOptions + writer.getOptions());
+    applyExtraOptions(writer);
+
+    FixedPointTable streamTable(m_chunkSize, m_slots);
+    writer.prepare(streamTable);
+    point_count_t count;
+    if (writer.pipelineStreamable())
+        count = writer.executeStream(streamTable);
+    else
+    {
+        std::cerr << "Pipeline can't be streamed.  Reading all points at "
+            "once." << std::endl;
+        PointTable table;
+        writer.prepare(table);
+        PointViewSet views = writer.execute(table);
+        count = 0;
+        for (auto const& view : views)
+            count += view->size();
+    }
+
+    if (getVerboseLevel())
+        std::cerr << "Wrote " << count << " points to " << m_outputFile <<
+            "." << std::endl;
+    return 0;
+}
+
+} // namespace pdal
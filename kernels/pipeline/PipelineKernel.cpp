@@ -34,6 +34,8 @@
 
 #include "PipelineKernel.hpp"
 
+#include <pdal/PDALUtils.hpp>
+
 #include <boost/program_options.hpp>
 
 namespace pdal
@@ -48,7 +50,9 @@ CREATE_STATIC_PLUGIN(1, 0, PipelineKernel, Kernel, s_info)
 
 std::string PipelineKernel::getName() const { return s_info.name; }
 
-PipelineKernel::PipelineKernel() : m_validate(false)
+PipelineKernel::PipelineKernel() : m_validate(false), m_memoryBudget(0),
+    m_concurrency(1), m_streamChunkSize(0), m_streamSlots(3),
+    m_profile(false)
 {}
 
 
@@ -76,12 +80,59 @@ void PipelineKernel::addSwitches()
             po::value<bool>(&m_validate)->zero_tokens()->implicit_value(true),
             "Validate the pipeline (including serialization), but do not "
             "execute writing of points")
+        ("memory-budget",
+            po::value<std::size_t>(&m_memoryBudget)->default_value(0),
+            "Limit point storage to this many megabytes, spilling the rest "
+            "to disk (0 for no limit)")
+        ("spill-dir",
+            po::value<std::string>(&m_spillDir)->default_value(""),
+            "Directory for point data spilled to disk")
+        ("concurrency",
+            po::value<std::size_t>(&m_concurrency)->default_value(1),
+            "Run up to this many independent branches of the pipeline at "
+            "once")
+        ("stream",
+            po::value<point_count_t>(&m_streamChunkSize)->default_value(0),
+            "Process points in chunks of this many points rather than all "
+            "at once, if every stage of the pipeline allows it")
+        ("stream-slots",
+            po::value<int>(&m_streamSlots)->default_value(3),
+            "Number of chunks held at once when streaming.  More than one "
+            "lets reading, filtering and writing overlap")
+        ("result-cache",
+            po::value<std::string>(&m_resultCache)->default_value(""),
+            "Directory of records of earlier runs.  The pipeline isn't run "
+            "again if its options and input files are unchanged and its "
+            "output files are as it left them")
+        ("profile",
+            po::value<bool>(&m_profile)->zero_tokens()->implicit_value(true),
+            "Write the time, point counts and memory of each stage to "
+            "stdout as JSON")
         ;
 
     addSwitchSet(file_options);
     addPositionalSwitch("input", 1);
 }
 
+bool PipelineKernel::runStreamed(PipelineManager& manager)
+{
+    if (!m_streamChunkSize)
+        return false;
+
+    Stage *stage = manager.getStage();
+    FixedPointTable streamTable(m_streamChunkSize, m_streamSlots);
+    stage->prepare(streamTable);
+    if (manager.endpoints().size() > 1 || !stage->pipelineStreamable())
+    {
+        std::cerr << "Pipeline can't be streamed.  Processing all points "
+            "at once." << std::endl;
+        return false;
+    }
+    stage->executeStream(streamTable);
+    return true;
+}
+
+
 int PipelineKernel::execute()
 {
     if (!FileUtils::fileExists(m_inputFile))
@@ -109,9 +160,19 @@ int PipelineKernel::execute()
         }
     }
 
-    PointTable table;
-    manager.getStage()->prepare(table);
-    manager.getStage()->execute(table);
+    manager.setMemoryBudget(m_memoryBudget * 1024 * 1024, m_spillDir);
+    manager.setConcurrency(m_concurrency);
+    manager.setResultCache(m_resultCache);
+    if (!runStreamed(manager))
+        manager.execute();
+    if (manager.cacheHit() && getVerboseLevel())
+        std::cerr << "Pipeline unchanged since its last run; outputs "
+            "reused." << std::endl;
+    if (manager.spilledBytes() && getVerboseLevel())
+        std::cerr << "Spilled " << manager.spilledBytes() <<
+            " bytes of point data to disk." << std::endl;
+    if (m_profile)
+        utils::toJSON(manager.getStage()->pipelineProfile(), std::cout);
     if (m_pipelineFile.size() > 0)
     {
         pdal::PipelineWriter writer(manager);
@@ -58,10 +58,18 @@ private:
     PipelineKernel();
     void addSwitches();
     void validateSwitches();
+    bool runStreamed(PipelineManager& manager);
 
     std::string m_inputFile;
     std::string m_pipelineFile;
     bool m_validate;
+    std::size_t m_memoryBudget;
+    std::string m_spillDir;
+    std::size_t m_concurrency;
+    point_count_t m_streamChunkSize;
+    int m_streamSlots;
+    std::string m_resultCache;
+    bool m_profile;
 };
 
 } // pdal
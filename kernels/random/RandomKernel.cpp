@@ -34,8 +34,20 @@
 
 #include "RandomKernel.hpp"
 
+#include <pdal/Reader.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <thread>
+
 namespace pdal
 {
 
@@ -48,10 +60,48 @@ CREATE_STATIC_PLUGIN(1, 0, RandomKernel, Kernel, s_info)
 
 std::string RandomKernel::getName() const { return s_info.name; }
 
+namespace
+{
+
+// Points written to measure the output size per point for --size.
+const point_count_t CalibrationCount = 100000;
+const point_count_t StreamChunkSize = 1 << 16;
+
+typedef std::chrono::steady_clock Clock;
+
+// Read callback that holds a reader to a number of points per second by
+// sleeping every so often until the points read so far are due.
+struct Throttle
+{
+    Throttle(double rate) : m_rate(rate), m_count(0)
+    {}
+
+    void operator()(PointView&, PointId)
+    {
+        if (m_count++ == 0)
+            m_start = Clock::now();
+        else if (m_count % 1024 == 0)
+            std::this_thread::sleep_until(m_start +
+                std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(m_count / m_rate)));
+    }
+
+    double m_rate;
+    point_count_t m_count;
+    Clock::time_point m_start;
+};
+
+} // unnamed namespace
+
 RandomKernel::RandomKernel()
     : m_bCompress(false)
     , m_numPointsToWrite(0)
     , m_distribution("uniform")
+    , m_shards(1)
+    , m_threads(0)
+    , m_seed(0)
+    , m_rate(0)
+    , m_size(0)
 {
 }
 
@@ -60,6 +110,12 @@ void RandomKernel::validateSwitches()
 {
     if (m_outputFile == "")
         throw app_usage_error("--output/-o required");
+    if (m_shards == 0)
+        throw app_usage_error("--shards must be at least 1");
+    if (m_size && m_numPointsToWrite)
+        throw app_usage_error("--count and --size can't both be given");
+    if (m_rate < 0)
+        throw app_usage_error("--rate can't be negative");
 }
 
 
@@ -75,6 +131,11 @@ void RandomKernel::addSwitches()
     ("mean", po::value< std::string >(&m_means), "A comma-separated or quoted, space-separated list of means (normal mode): \n--mean 0.0,0.0,0.0\n--mean \"0.0 0.0 0.0\"")
     ("stdev", po::value< std::string >(&m_stdevs), "A comma-separated or quoted, space-separated list of standard deviations (normal mode): \n--stdev 0.0,0.0,0.0\n--stdev \"0.0 0.0 0.0\"")
     ("distribution", po::value<std::string>(&m_distribution)->default_value("uniform"), "Distribution (uniform / normal)")
+    ("shards", po::value<size_t>(&m_shards)->default_value(1), "Number of files to split the points among.  Each '#' in the output name is replaced with the file number, which is otherwise added before the extension")
+    ("threads", po::value<size_t>(&m_threads)->default_value(0), "Number of files to write at once (0 = one per core)")
+    ("seed", po::value<uint32_t>(&m_seed)->default_value(0), "Seed from which the seed of each file's points is derived (0 = based on the current time)")
+    ("rate", po::value<double>(&m_rate)->default_value(0), "Points per second to write in all, for generating load (0 = as fast as possible)")
+    ("size", po::value<uint64_t>(&m_size)->default_value(0), "Approximate number of bytes to write in all, in place of --count")
     ;
 
     addSwitchSet(file_options);
@@ -105,88 +166,231 @@ Stage& RandomKernel::makeReader(Options readerOptions)
 }
 
 
-int RandomKernel::execute()
+// Options of the reader, other than the number of points and the seed,
+// which differ from file to file.
+Options RandomKernel::readerOptions() const
 {
     Options readerOptions;
-    {
-        boost::char_separator<char> sep(SEPARATORS);
-        std::vector<double> means;
-        tokenizer mean_tokens(m_means, sep);
-        for (tokenizer::iterator t = mean_tokens.begin();
-            t != mean_tokens.end(); ++t)
-        {
-            means.push_back(boost::lexical_cast<double>(*t));
-        }
-
-        if (means.size())
-        {
-            readerOptions.add<double >("mean_x", means[0]);
-            readerOptions.add<double >("mean_y", means[1]);
-            readerOptions.add<double >("mean_z", means[2]);
-        }
-
-        std::vector<double> stdevs;
-        tokenizer stdev_tokens(m_stdevs, sep);
-        for (tokenizer::iterator t = stdev_tokens.begin();
-            t != stdev_tokens.end(); ++t)
-        {
-            stdevs.push_back(boost::lexical_cast<double>(*t));
-        }
 
-        if (stdevs.size())
-        {
-            readerOptions.add<double >("stdev_x", stdevs[0]);
-            readerOptions.add<double >("stdev_y", stdevs[1]);
-            readerOptions.add<double >("stdev_z", stdevs[2]);
-        }
+    boost::char_separator<char> sep(SEPARATORS);
+    std::vector<double> means;
+    tokenizer mean_tokens(m_means, sep);
+    for (tokenizer::iterator t = mean_tokens.begin();
+        t != mean_tokens.end(); ++t)
+    {
+        means.push_back(boost::lexical_cast<double>(*t));
+    }
 
-        if (!m_bounds.empty())
-            readerOptions.add<BOX3D >("bounds", m_bounds);
-
-        if (boost::iequals(m_distribution, "uniform"))
-            readerOptions.add<std::string>("mode", "uniform");
-        else if (boost::iequals(m_distribution, "normal"))
-            readerOptions.add<std::string>("mode", "normal");
-        else if (boost::iequals(m_distribution, "random"))
-            readerOptions.add<std::string>("mode", "random");
-        else
-            throw pdal_error("invalid distribution: " + m_distribution);
-        readerOptions.add<int>("num_points", m_numPointsToWrite);
-        readerOptions.add<bool>("debug", isDebug());
-        readerOptions.add<uint32_t>("verbose", getVerboseLevel());
+    if (means.size())
+    {
+        readerOptions.add<double >("mean_x", means[0]);
+        readerOptions.add<double >("mean_y", means[1]);
+        readerOptions.add<double >("mean_z", means[2]);
     }
 
-    Options writerOptions;
+    std::vector<double> stdevs;
+    tokenizer stdev_tokens(m_stdevs, sep);
+    for (tokenizer::iterator t = stdev_tokens.begin();
+        t != stdev_tokens.end(); ++t)
     {
-        writerOptions.add<std::string>("filename", m_outputFile);
-        setCommonOptions(writerOptions);
+        stdevs.push_back(boost::lexical_cast<double>(*t));
+    }
 
-        if (m_bCompress)
-        {
-            writerOptions.add<bool>("compression", true);
-        }
+    if (stdevs.size())
+    {
+        readerOptions.add<double >("stdev_x", stdevs[0]);
+        readerOptions.add<double >("stdev_y", stdevs[1]);
+        readerOptions.add<double >("stdev_z", stdevs[2]);
     }
 
-    Stage& writer = makeWriter(m_outputFile, makeReader(readerOptions));
+    if (!m_bounds.empty())
+        readerOptions.add<BOX3D >("bounds", m_bounds);
+
+    if (boost::iequals(m_distribution, "uniform"))
+        readerOptions.add<std::string>("mode", "uniform");
+    else if (boost::iequals(m_distribution, "normal"))
+        readerOptions.add<std::string>("mode", "normal");
+    else if (boost::iequals(m_distribution, "random"))
+        readerOptions.add<std::string>("mode", "random");
+    else
+        throw pdal_error("invalid distribution: " + m_distribution);
+    readerOptions.add<bool>("debug", isDebug());
+    readerOptions.add<uint32_t>("verbose", getVerboseLevel());
+    return readerOptions;
+}
+
+
+// Each '#' in the output name is replaced with the shard number.  Names
+// without a '#' get the number before the extension.
+std::string RandomKernel::shardFilename(size_t shard) const
+{
+    if (m_shards == 1)
+        return m_outputFile;
+
+    size_t width = std::to_string(m_shards - 1).size();
+    std::ostringstream oss;
+    oss << std::setw(width) << std::setfill('0') << shard;
+    if (m_outputFile.find('#') != std::string::npos)
+        return boost::algorithm::replace_all_copy(m_outputFile, "#",
+            oss.str());
+    boost::filesystem::path out(m_outputFile);
+    std::string name = out.stem().string() + "_" + oss.str() +
+        out.extension().string();
+    return (out.parent_path() / name).string();
+}
+
+
+Stage& RandomKernel::makePipeline(Options readerOptions,
+    const std::string& filename, double rate)
+{
+    Stage& reader = makeReader(readerOptions);
+    if (rate > 0)
+        dynamic_cast<Reader&>(reader).setReadCb(Throttle(rate));
+
+    Options writerOptions;
+    writerOptions.add<std::string>("filename", filename);
+    setCommonOptions(writerOptions);
+    if (m_bCompress)
+        writerOptions.add<bool>("compression", true);
+
+    Stage& writer = makeWriter(filename, reader);
     writer.setOptions(writerOptions);
+    return writer;
+}
 
-    PointTable table;
 
-    UserCallback* callback;
-    if (!getProgressShellCommand().size())
-        callback = static_cast<UserCallback*>(new PercentageCallback);
-    else
-        callback = static_cast<UserCallback*>(
-            new ShellScriptCallback(getProgressShellCommand()));
-    writer.setUserCallback(callback);
+// Write a few points to the first file to see how many bytes each takes
+// with the writer's format and options.  The file is overwritten by the
+// real run.
+point_count_t RandomKernel::countForSize(const Options& readerOptions)
+{
+    std::string filename = shardFilename(0);
+    Options options(readerOptions);
+    options.add("num_points", CalibrationCount);
+    options.add("seed", m_seed);
+
+    std::vector<std::unique_ptr<Stage>> stages;
+    Stage& writer = makePipeline(options, filename, 0);
+    stages = takeStages();
+    writeShard(writer);
+
+    uintmax_t bytes = FileUtils::fileSize(filename);
+    if (bytes == 0)
+        throw app_runtime_error("can't determine the size of the points "
+            "written to " + filename);
+    return (point_count_t)std::max<uintmax_t>(1,
+        m_size * CalibrationCount / bytes);
+}
+
+
+// Write the points of one file, a chunk at a time when the writer allows.
+point_count_t RandomKernel::writeShard(Stage& writer)
+{
+    if (!isVisualize())
+    {
+        FixedPointTable streamTable(StreamChunkSize, 3);
+        writer.prepare(streamTable);
+        if (writer.pipelineStreamable())
+            return writer.executeStream(streamTable);
+    }
+
+    PointTable table;
     writer.prepare(table);
     PointViewSet viewSet = writer.execute(table);
-
     if (isVisualize())
         visualize(*viewSet.begin());
 
+    point_count_t count = 0;
+    for (auto const& view : viewSet)
+        count += view->size();
+    return count;
+}
+
+
+int RandomKernel::execute()
+{
+    Options options = readerOptions();
+    if (m_seed == 0)
+        m_seed = static_cast<uint32_t>(std::time(NULL));
+    point_count_t total = m_size ? countForSize(options) : m_numPointsToWrite;
+
+    size_t threads = m_threads ? m_threads :
+        std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, m_shards);
+
+    // As in batch translation, pipelines are built one at a time and run
+    // on all of the workers at once.  Each file's points come from a seed
+    // of its own, so the files are independent streams that can be
+    // regenerated from --seed.
+    std::mutex stageMutex;
+    std::mutex outputMutex;
+    std::atomic<size_t> failed(0);
+    std::atomic<point_count_t> written(0);
+    auto writeOne = [&](size_t shard)
+    {
+        std::string filename = shardFilename(shard);
+        try
+        {
+            std::seed_seq seq{ m_seed, (uint32_t)shard };
+            uint32_t seed;
+            seq.generate(&seed, &seed + 1);
+
+            Options shardOptions(options);
+            shardOptions.add("num_points", total / m_shards +
+                (shard < total % m_shards ? 1 : 0));
+            shardOptions.add("seed", seed);
+
+            std::vector<std::unique_ptr<Stage>> stages;
+            Stage *writer;
+            {
+                std::lock_guard<std::mutex> lock(stageMutex);
+                writer = &makePipeline(shardOptions, filename,
+                    m_rate / m_shards);
+                stages = takeStages();
+            }
+
+            auto start = Clock::now();
+            point_count_t count = writeShard(*writer);
+            std::chrono::duration<double> secs = Clock::now() - start;
+            written += count;
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << filename << ": " << count << " points in " <<
+                secs.count() << " s (" <<
+                (point_count_t)(count / std::max(secs.count(), 1e-9)) <<
+                " points/s)" << std::endl;
+        }
+        catch (std::exception& e)
+        {
+            failed++;
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cerr << "PDAL: " << filename << ": " << e.what() <<
+                std::endl;
+        }
+    };
+
+    auto start = Clock::now();
+    ThreadPool pool(threads);
+    std::vector<std::future<void>> futures;
+    for (size_t shard = 0; shard < m_shards; ++shard)
+        futures.push_back(pool.submit(std::bind(writeOne, shard)));
+    for (auto& f : futures)
+        pool.wait(f);
+    std::chrono::duration<double> secs = Clock::now() - start;
+
+    if (m_shards > 1)
+        std::cout << "total: " << written << " points in " <<
+            secs.count() << " s (" <<
+            (point_count_t)(written / std::max(secs.count(), 1e-9)) <<
+            " points/s)" << std::endl;
+
+    if (failed)
+    {
+        std::cerr << "PDAL: " << failed << " of " << m_shards <<
+            " files failed to write." << std::endl;
+        return 1;
+    }
     return 0;
 }
 
 } // pdal
-
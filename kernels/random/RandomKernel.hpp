@@ -64,6 +64,13 @@ private:
     void validateSwitches();
 
     Stage& makeReader(Options readerOptions);
+    Options readerOptions() const;
+    std::string shardFilename(size_t shard) const;
+    Stage& makePipeline(Options readerOptions, const std::string& filename,
+        double rate);
+    point_count_t countForSize(const Options& readerOptions);
+    point_count_t writeShard(Stage& writer);
+    int executeShards();
 
     std::string m_outputFile;
     bool m_bCompress;
@@ -72,6 +79,11 @@ private:
     std::string m_distribution;
     std::string m_means;
     std::string m_stdevs;
+    size_t m_shards;
+    size_t m_threads;
+    uint32_t m_seed;
+    double m_rate;
+    uint64_t m_size;
 };
 
 } // pdal
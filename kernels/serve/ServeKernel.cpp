@@ -0,0 +1,372 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "ServeKernel.hpp"
+
+#include <pdal/PDALUtils.hpp>
+#include <pdal/PipelineManager.hpp>
+#include <pdal/PipelineReader.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PDAL_HAVE_UNIX_SOCKETS
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "kernels.serve",
+    "Serve Kernel",
+    "http://pdal.io/apps.html#serve-command" );
+
+CREATE_STATIC_PLUGIN(1, 0, ServeKernel, Kernel, s_info)
+
+std::string ServeKernel::getName() const { return s_info.name; }
+
+namespace
+{
+
+// Pipelines bigger than this are refused rather than buffered.
+const std::size_t MaxRequestSize = 16 * 1024 * 1024;
+// A client that sends nothing for this long loses its job thread.
+const int ReceiveTimeout = 30;
+
+volatile std::sig_atomic_t s_stopRequested = 0;
+
+extern "C" void requestStop(int)
+{
+    s_stopRequested = 1;
+}
+
+} // unnamed namespace
+
+
+ServeKernel::ServeKernel() : m_jobs(0), m_memoryBudget(0), m_stop(false)
+{}
+
+
+void ServeKernel::addSwitches()
+{
+    po::options_description* file_options =
+        new po::options_description("file options");
+
+    file_options->add_options()
+        ("socket", po::value<std::string>(&m_socketPath)->default_value(""),
+            "Path of the Unix domain socket to listen on")
+        ("jobs", po::value<std::size_t>(&m_jobs)->default_value(0),
+            "Number of pipelines to run at once (default: the number of "
+            "threads of the shared thread pool)")
+        ("memory-budget",
+            po::value<std::size_t>(&m_memoryBudget)->default_value(0),
+            "Limit the point storage of each job to this many megabytes, "
+            "spilling the rest to disk (0 for no limit)")
+        ("spill-dir",
+            po::value<std::string>(&m_spillDir)->default_value(""),
+            "Directory for point data spilled to disk")
+        ;
+
+    addSwitchSet(file_options);
+    addPositionalSwitch("socket", 1);
+}
+
+
+void ServeKernel::validateSwitches()
+{
+    if (m_socketPath.empty())
+        throw app_usage_error("socket path required");
+    if (m_jobs == 0)
+        m_jobs = ThreadPool::shared().size();
+}
+
+
+#ifdef PDAL_HAVE_UNIX_SOCKETS
+
+int ServeKernel::execute()
+{
+    // Load every plugin up front.  Jobs create their stages at once on
+    // several threads, and the plugin tables are only safe to share while
+    // nothing is being added to them.
+    StageFactory factory;
+
+    int listenFd = listen();
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < m_jobs; ++i)
+        workers.push_back(std::thread(&ServeKernel::work, this));
+
+    if (getVerboseLevel())
+        std::cerr << "Serving on " << m_socketPath << " with " << m_jobs <<
+            " job thread(s)." << std::endl;
+
+    while (!s_stopRequested)
+    {
+        pollfd pfd;
+        pfd.fd = listenFd;
+        pfd.events = POLLIN;
+        // Wake up now and then to notice a stop request.
+        if (poll(&pfd, 1, 250) <= 0)
+            continue;
+
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0)
+            continue;
+
+        timeval tv;
+        tv.tv_sec = ReceiveTimeout;
+        tv.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(fd);
+        m_cv.notify_one();
+    }
+
+    // Jobs already accepted are run before the job threads stop.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& t : workers)
+        t.join();
+
+    close(listenFd);
+    unlink(m_socketPath.c_str());
+    return 0;
+}
+
+
+// Bind and listen on the socket path, replacing a socket left behind by a
+// server that's no longer running.
+int ServeKernel::listen()
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (m_socketPath.size() >= sizeof(addr.sun_path))
+        throw app_usage_error("socket path '" + m_socketPath +
+            "' is too long");
+    std::strcpy(addr.sun_path, m_socketPath.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        throw app_runtime_error("Can't create socket: " +
+            std::string(std::strerror(errno)));
+
+    struct stat st;
+    if (stat(m_socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        if (connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0)
+        {
+            close(fd);
+            throw app_runtime_error("A server is already listening on '" +
+                m_socketPath + "'.");
+        }
+        unlink(m_socketPath.c_str());
+    }
+
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0)
+    {
+        std::string err(std::strerror(errno));
+        close(fd);
+        throw app_runtime_error("Can't listen on '" + m_socketPath + "': " +
+            err);
+    }
+    return fd;
+}
+
+
+// Take accepted connections off the queue and serve them until told to
+// stop.  Jobs run on threads of their own, each waiting on its client and
+// then on its pipeline, while the stages of every job share the work of
+// the shared thread pool.
+void ServeKernel::work()
+{
+    while (true)
+    {
+        int fd;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_stop || m_pending.size(); });
+            if (m_pending.empty())
+                return;
+            fd = m_pending.front();
+            m_pending.pop_front();
+        }
+        serve(fd);
+        close(fd);
+    }
+}
+
+
+// Read a pipeline from a client until it shuts down its end of the
+// connection, run it and send back the result.
+void ServeKernel::serve(int fd)
+{
+    std::string xml;
+    char buf[65536];
+    while (true)
+    {
+        ssize_t count = read(fd, buf, sizeof(buf));
+        if (count == 0)
+            break;
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // Timed out or reset: there's no one to answer.
+            return;
+        }
+        xml.append(buf, count);
+        if (xml.size() > MaxRequestSize)
+            break;
+    }
+
+    std::string reply;
+    if (xml.size() > MaxRequestSize)
+    {
+        MetadataNode root("result");
+        root.add("status", "error");
+        root.add("message", "Pipeline is too large.");
+        reply = utils::toJSON(root);
+    }
+    else
+        reply = runJob(xml);
+
+    const char *pos = reply.data();
+    std::size_t left = reply.size();
+    while (left)
+    {
+        ssize_t count = write(fd, pos, left);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return;
+        pos += count;
+        left -= count;
+    }
+}
+
+#else
+
+int ServeKernel::execute()
+{
+    throw app_runtime_error("pdal serve needs Unix domain sockets, which "
+        "aren't available on this platform.");
+}
+
+int ServeKernel::listen()
+{
+    return -1;
+}
+
+void ServeKernel::work()
+{}
+
+void ServeKernel::serve(int)
+{}
+
+#endif // PDAL_HAVE_UNIX_SOCKETS
+
+
+// Run a pipeline and describe the result as JSON: its status, the number
+// of points, the time taken and the pipeline's metadata, or the error that
+// stopped it.
+std::string ServeKernel::runJob(const std::string& xml)
+{
+    MetadataNode root("result");
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        PipelineManager manager;
+        PipelineReader reader(manager, isDebug(), getVerboseLevel());
+        std::istringstream in(xml);
+        reader.readPipeline(in);
+
+        if (manager.getStage())
+            for (const auto& pi : getExtraStageOptions())
+                for (Stage *s : manager.getStage()->findStage(pi.first))
+                {
+                    Options opts = s->getOptions();
+                    for (const auto& o : pi.second.getOptions())
+                        opts.add(o);
+                    s->setOptions(opts);
+                }
+
+        manager.setMemoryBudget(m_memoryBudget * 1024 * 1024, m_spillDir);
+        point_count_t count = manager.execute();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        root.add("status", "ok");
+        root.add("count", count);
+        root.add("time", elapsed.count());
+        if (manager.spilledBytes())
+            root.add("spilled_bytes", manager.spilledBytes());
+        root.add(manager.getMetadata());
+    }
+    catch (std::exception& e)
+    {
+        root = MetadataNode("result");
+        root.add("status", "error");
+        root.add("message", e.what());
+    }
+    return utils::toJSON(root);
+}
+
+} // namespace pdal
@@ -0,0 +1,85 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Kernel.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+
+extern "C" int32_t ServeKernel_ExitFunc();
+extern "C" PF_ExitFunc ServeKernel_InitPlugin();
+
+namespace pdal
+{
+
+// A long-running process that runs pipelines sent to it over a local
+// socket.  Plugins stay loaded and the process-wide caches (spatial
+// references, transforms, database connections, GDAL datasets) stay warm
+// from one job to the next, so a job costs only the running of its
+// pipeline.
+class PDAL_DLL ServeKernel : public Kernel
+{
+public:
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+    int execute();
+
+private:
+    ServeKernel();
+    void addSwitches();
+    void validateSwitches();
+
+    int listen();
+    void work();
+    void serve(int fd);
+    std::string runJob(const std::string& xml);
+
+    std::string m_socketPath;
+    std::size_t m_jobs;
+    std::size_t m_memoryBudget;
+    std::string m_spillDir;
+
+    // Accepted connections waiting for a job thread.
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<int> m_pending;
+    bool m_stop;
+};
+
+} // namespace pdal
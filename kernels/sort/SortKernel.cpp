@@ -36,10 +36,22 @@
 
 #include <pdal/BufferReader.hpp>
 #include <pdal/KernelSupport.hpp>
+#include <pdal/RadixSort.hpp>
+#include <pdal/Reader.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/Writer.hpp>
+#include <mortonorder/MortonOrderFilter.hpp>
 
+#include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+
 namespace pdal
 {
 
@@ -55,8 +67,168 @@ std::string SortKernel::getName() const
     return s_info.name;
 }
 
+namespace
+{
+
+// Number of points read, merged and written at once.
+const point_count_t StreamChunkSize = 65536;
+// Size of the buffer of each stream of a run.
+const std::size_t RunBufferSize = 1 << 20;
+
+typedef std::function<void(PointView&)> ChunkFunc;
+
+// Terminates a streamed pipeline, handing each chunk to a function.
+class ChunkWriter : public Writer
+{
+public:
+    ChunkWriter(ChunkFunc func) : m_func(func)
+    {}
+
+    std::string getName() const
+        { return "writers.sortchunk"; }
+    virtual bool streamable() const
+        { return true; }
+
+private:
+    ChunkFunc m_func;
+
+    virtual void write(const PointViewPtr view)
+        { m_func(*view); }
+
+    ChunkWriter& operator=(const ChunkWriter&); // not implemented
+    ChunkWriter(const ChunkWriter&); // not implemented
+};
+
+struct RunDim
+{
+    std::string m_name;
+    Dimension::Type::Enum m_type;
+};
+
+// Reads the points of sorted runs in key order.  Each run is a file of
+// records of a 64 bit key followed by a point packed with the types of
+// the run's dimensions.
+class RunMergeReader : public Reader
+{
+public:
+    RunMergeReader(const std::vector<std::string>& runFiles,
+            const std::vector<RunDim>& runDims, const SpatialReference& srs) :
+        m_runFiles(runFiles), m_runDims(runDims), m_pointSize(0), m_srs(srs)
+    {}
+
+    std::string getName() const
+        { return "readers.sortmerge"; }
+    virtual bool streamable() const
+        { return true; }
+
+private:
+    struct Run
+    {
+        std::unique_ptr<std::ifstream> m_in;
+        std::vector<char> m_buf;
+        std::vector<char> m_record;
+    };
+    // Key and run of the next record of each run.
+    typedef std::pair<uint64_t, std::size_t> HeapEntry;
+
+    std::vector<std::string> m_runFiles;
+    std::vector<RunDim> m_runDims;
+    DimTypeList m_dims;
+    std::size_t m_pointSize;
+    SpatialReference m_srs;
+    std::vector<Run> m_runs;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>,
+        std::greater<HeapEntry>> m_heap;
+
+    virtual void initialize()
+        { setSpatialReference(m_srs); }
+
+    virtual void addDimensions(PointLayoutPtr layout)
+    {
+        m_dims.clear();
+        m_pointSize = 0;
+        for (const RunDim& d : m_runDims)
+        {
+            m_dims.push_back(DimType(
+                layout->registerOrAssignDim(d.m_name, d.m_type), d.m_type));
+            m_pointSize += Dimension::size(d.m_type);
+        }
+    }
+
+    virtual void ready(PointTableRef /*table*/)
+    {
+        m_heap = decltype(m_heap)();
+        m_runs.clear();
+        m_runs.resize(m_runFiles.size());
+        for (std::size_t i = 0; i < m_runs.size(); ++i)
+        {
+            Run& run = m_runs[i];
+            run.m_buf.resize(RunBufferSize);
+            run.m_record.resize(sizeof(uint64_t) + m_pointSize);
+            run.m_in.reset(new std::ifstream);
+            run.m_in->rdbuf()->pubsetbuf(run.m_buf.data(), run.m_buf.size());
+            run.m_in->open(m_runFiles[i], std::ios::in | std::ios::binary);
+            if (!*run.m_in)
+                throw pdal_error(getName() + ": can't open sorted run '" +
+                    m_runFiles[i] + "'.");
+            next(i);
+        }
+    }
+
+    // Queue the next record of run 'i', if it has one.
+    void next(std::size_t i)
+    {
+        Run& run = m_runs[i];
+        if (!run.m_in->read(run.m_record.data(), run.m_record.size()))
+            return;
+        uint64_t key;
+        std::memcpy(&key, run.m_record.data(), sizeof(key));
+        m_heap.push(std::make_pair(key, i));
+    }
+
+    virtual point_count_t read(PointViewPtr view, point_count_t count)
+    {
+        PointId idx = view->size();
+        point_count_t num = 0;
+        while (num < count && !m_heap.empty())
+        {
+            std::size_t i = m_heap.top().second;
+            m_heap.pop();
+            view->setPackedPoint(m_dims, idx,
+                m_runs[i].m_record.data() + sizeof(uint64_t));
+            if (m_cb)
+                m_cb(*view, idx);
+            idx++;
+            num++;
+            next(i);
+        }
+        return num;
+    }
+
+    virtual void done(PointTableRef /*table*/)
+        { m_runs.clear(); }
 
-SortKernel::SortKernel() : m_bCompress(false), m_bForwardMetadata(false)
+    RunMergeReader& operator=(const RunMergeReader&); // not implemented
+    RunMergeReader(const RunMergeReader&); // not implemented
+};
+
+// Removes the files of the sorted runs however the sort ends.
+struct RunFiles
+{
+    ~RunFiles()
+    {
+        for (const std::string& name : m_names)
+            FileUtils::deleteFile(name);
+    }
+
+    std::vector<std::string> m_names;
+};
+
+} // unnamed namespace
+
+
+SortKernel::SortKernel() : m_bCompress(false), m_bForwardMetadata(false),
+    m_order("morton"), m_runSize(0)
 {}
 
 
@@ -66,6 +238,10 @@ void SortKernel::validateSwitches()
         throw app_usage_error("--input/-i required");
     if (m_outputFile == "")
         throw app_usage_error("--output/-o required");
+    if (m_order != "morton" && m_order != "hilbert" && m_order != "lod")
+        throw app_usage_error("--order must be 'morton', 'hilbert' or 'lod'");
+    if (m_runSize && m_order == "lod")
+        throw app_usage_error("--run_size can't be used with --order lod");
 }
 
 
@@ -85,6 +261,14 @@ void SortKernel::addSwitches()
     ("metadata,m",
      po::value< bool >(&m_bForwardMetadata)->implicit_value(true),
      "Forward metadata (VLRs, header entries, etc) from previous stages")
+    ("order", po::value<std::string>(&m_order)->default_value("morton"),
+     "Sort order: 'morton', 'hilbert' or 'lod'")
+    ("run_size", po::value<point_count_t>(&m_runSize)->default_value(0),
+     "Sort out of core: sort runs of this many points to temporary files "
+     "and merge them into the output (0 = sort all points in memory)")
+    ("temp_dir", po::value<std::string>(&m_tempDir)->default_value(""),
+     "Directory for the runs of an out-of-core sort (default: the system's "
+     "temporary directory)")
     ;
 
     addSwitchSet(file_options);
@@ -113,40 +297,8 @@ Stage& SortKernel::makeReader(Options readerOptions)
 }
 
 
-int SortKernel::execute()
+Stage& SortKernel::makeSortWriter(Stage& parent)
 {
-    PointTable table;
-
-    Options readerOptions;
-    readerOptions.add("filename", m_inputFile);
-    readerOptions.add("debug", isDebug());
-    readerOptions.add("verbose", getVerboseLevel());
-
-    Stage& readerStage = makeReader(readerOptions);
-
-    // go ahead and prepare/execute on reader stage only to grab input
-    // PointViewSet, this makes the input PointView available to both the
-    // processing pipeline and the visualizer
-    readerStage.prepare(table);
-    PointViewSet viewSetIn = readerStage.execute(table);
-
-    // the input PointViewSet will be used to populate a BufferReader that is
-    // consumed by the processing pipeline
-    PointViewPtr inView = *viewSetIn.begin();
-
-    BufferReader bufferReader;
-    bufferReader.setOptions(readerOptions);
-    bufferReader.addView(inView);
-
-    Options sortOptions;
-    sortOptions.add<bool>("debug", isDebug());
-    sortOptions.add<uint32_t>("verbose", getVerboseLevel());
-
-    StageFactory f;
-    Stage& sortStage = ownStage(f.createStage("filters.mortonorder"));
-    sortStage.setInput(bufferReader);
-    sortStage.setOptions(sortOptions);
-
     Options writerOptions;
     writerOptions.add("filename", m_outputFile);
     setCommonOptions(writerOptions);
@@ -161,7 +313,7 @@ int SortKernel::execute()
         cmd.size() ? (UserCallback *)new ShellScriptCallback(cmd) :
         (UserCallback *)new HeartbeatCallback();
 
-    Stage& writer = makeWriter(m_outputFile, sortStage);
+    Stage& writer = makeWriter(m_outputFile, parent);
 
     // Some options are inferred by makeWriter based on filename
     // (compression, driver type, etc).
@@ -182,6 +334,181 @@ int SortKernel::execute()
             s->setOptions(opts);
         }
     }
+    return writer;
+}
+
+
+// Sort more points than fit in memory.  The input is streamed a run at a
+// time and each run is keyed on a grid over the bounds of all the points,
+// sorted and written to a temporary file.  The runs are then merged, a
+// chunk at a time, into the output.
+int SortKernel::externalSort(Stage& reader)
+{
+    // Keys must come from the same grid for every run, so the bounds are
+    // taken from the header when the reader has one and from a pass over
+    // the points otherwise.
+    QuickInfo qi = reader.preview();
+    BOX3D bounds = qi.valid() ? qi.m_bounds : BOX3D();
+    if (bounds.empty())
+    {
+        ChunkWriter boundsWriter([&bounds](PointView& view)
+            { bounds.grow(view.calculateBounds()); });
+        boundsWriter.setInput(reader);
+        FixedPointTable boundsTable(StreamChunkSize, 2);
+        boundsWriter.prepare(boundsTable);
+        if (!boundsWriter.pipelineStreamable())
+            throw app_runtime_error("can't sort " + m_inputFile +
+                " out of core: its reader can't read points in chunks");
+        boundsWriter.executeStream(boundsTable);
+    }
+
+    const double xrange = bounds.maxx - bounds.minx;
+    const double yrange = bounds.maxy - bounds.miny;
+    const double maxGrid = (std::numeric_limits<uint32_t>::max)();
+    const double xscale = xrange > 0 ? maxGrid / xrange : 0;
+    const double yscale = yrange > 0 ? maxGrid / yrange : 0;
+    const bool hilbert = (m_order == "hilbert");
+
+    boost::filesystem::path tempDir = m_tempDir.size() ?
+        boost::filesystem::path(m_tempDir) :
+        boost::filesystem::temp_directory_path();
+    RunFiles runs;
+    DimTypeList dims;
+    std::size_t pointSize = 0;
+
+    // Sort each run by key as it's read and write its records.
+    auto writeRun = [&](PointView& view)
+    {
+        const point_count_t batchSize = 4096;
+        std::vector<RadixPair> pairs(view.size());
+        ThreadPool::shared().parallelFor(view.size(), batchSize,
+            [&](size_t first, size_t last)
+        {
+            std::vector<double> xs(batchSize);
+            std::vector<double> ys(batchSize);
+            for (PointId begin = first; begin < last; begin += batchSize)
+            {
+                point_count_t count =
+                    (std::min)(batchSize, (point_count_t)(last - begin));
+                view.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+                view.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+                for (PointId i = 0; i < count; ++i)
+                {
+                    double fx = (xs[i] - bounds.minx) * xscale;
+                    double fy = (ys[i] - bounds.miny) * yscale;
+                    uint32_t x = (uint32_t)(std::min)((std::max)(fx, 0.0),
+                        maxGrid);
+                    uint32_t y = (uint32_t)(std::min)((std::max)(fy, 0.0),
+                        maxGrid);
+                    pairs[begin + i] = std::make_pair(hilbert ?
+                        MortonOrderFilter::hilbertKey(x, y) :
+                        MortonOrderFilter::mortonKey(x, y), begin + i);
+                }
+            }
+        });
+        radixSort(pairs);
+
+        std::string name = (tempDir /
+            boost::filesystem::unique_path("pdal-sort-%%%%-%%%%-%%%%.run")).
+            string();
+        runs.m_names.push_back(name);
+        std::vector<char> buf(RunBufferSize);
+        std::ofstream out;
+        out.rdbuf()->pubsetbuf(buf.data(), buf.size());
+        out.open(name, std::ios::out | std::ios::binary | std::ios::trunc);
+        std::vector<char> record(sizeof(uint64_t) + pointSize);
+        for (const RadixPair& p : pairs)
+        {
+            std::memcpy(record.data(), &p.first, sizeof(uint64_t));
+            view.getPackedPoint(dims, p.second,
+                record.data() + sizeof(uint64_t));
+            out.write(record.data(), record.size());
+        }
+        out.close();
+        if (!out)
+            throw app_runtime_error("can't write sorted run " + name);
+    };
+
+    ChunkWriter runWriter(writeRun);
+    runWriter.setInput(reader);
+    FixedPointTable runTable(m_runSize, 2);
+    runWriter.prepare(runTable);
+    if (!runWriter.pipelineStreamable())
+        throw app_runtime_error("can't sort " + m_inputFile +
+            " out of core: its reader can't read points in chunks");
+
+    std::vector<RunDim> runDims;
+    PointLayoutPtr layout = runTable.layout();
+    for (const DimType& dt : layout->dimTypes())
+    {
+        RunDim d;
+        d.m_name = layout->dimName(dt.m_id);
+        d.m_type = dt.m_type;
+        runDims.push_back(d);
+        dims.push_back(DimType(dt.m_id, dt.m_type));
+        pointSize += Dimension::size(dt.m_type);
+    }
+    runWriter.executeStream(runTable);
+    if (isDebug())
+        std::cerr << "Sorted " << runs.m_names.size() << " runs of up to " <<
+            m_runSize << " points." << std::endl;
+
+    RunMergeReader merge(runs.m_names, runDims, reader.getSpatialReference());
+    Stage& writer = makeSortWriter(merge);
+    FixedPointTable outTable(StreamChunkSize, 3);
+    writer.prepare(outTable);
+    if (writer.pipelineStreamable())
+        writer.executeStream(outTable);
+    else
+    {
+        std::cerr << "Sorted output can't be streamed.  Writing all points "
+            "at once." << std::endl;
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+    return 0;
+}
+
+
+int SortKernel::execute()
+{
+    PointTable table;
+
+    Options readerOptions;
+    readerOptions.add("filename", m_inputFile);
+    readerOptions.add("debug", isDebug());
+    readerOptions.add("verbose", getVerboseLevel());
+
+    Stage& readerStage = makeReader(readerOptions);
+    if (m_runSize)
+        return externalSort(readerStage);
+
+    // go ahead and prepare/execute on reader stage only to grab input
+    // PointViewSet, this makes the input PointView available to both the
+    // processing pipeline and the visualizer
+    readerStage.prepare(table);
+    PointViewSet viewSetIn = readerStage.execute(table);
+
+    // the input PointViewSet will be used to populate a BufferReader that is
+    // consumed by the processing pipeline
+    PointViewPtr inView = *viewSetIn.begin();
+
+    BufferReader bufferReader;
+    bufferReader.setOptions(readerOptions);
+    bufferReader.addView(inView);
+
+    Options sortOptions;
+    sortOptions.add<bool>("debug", isDebug());
+    sortOptions.add<uint32_t>("verbose", getVerboseLevel());
+    sortOptions.add<std::string>("order", m_order);
+
+    StageFactory f;
+    Stage& sortStage = ownStage(f.createStage("filters.mortonorder"));
+    sortStage.setInput(bufferReader);
+    sortStage.setOptions(sortOptions);
+
+    Stage& writer = makeSortWriter(sortStage);
     writer.prepare(table);
 
     // process the data, grabbing the PointViewSet for visualization of the
@@ -194,4 +521,3 @@ int SortKernel::execute()
 }
 
 } // namespace pdal
-
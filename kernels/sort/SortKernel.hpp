@@ -56,11 +56,16 @@ private:
     void validateSwitches();
 
     Stage& makeReader(Options readerOptions);
+    Stage& makeSortWriter(Stage& parent);
+    int externalSort(Stage& reader);
 
     std::string m_inputFile;
     std::string m_outputFile;
     bool m_bCompress;
     bool m_bForwardMetadata;
+    std::string m_order;
+    point_count_t m_runSize;
+    std::string m_tempDir;
 };
 
 } // namespace pdal
@@ -0,0 +1,453 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "TileKernel.hpp"
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/Writer.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <list>
+#include <map>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "kernels.tile",
+    "Tile Kernel",
+    "http://pdal.io/apps.html#tile-command" );
+
+CREATE_STATIC_PLUGIN(1, 0, TileKernel, Kernel, s_info)
+
+std::string TileKernel::getName() const { return s_info.name; }
+
+namespace
+{
+
+// The points of a tile routed so far.  The most recent are in memory and
+// the rest are in the tile's spill file.
+struct Tile
+{
+    Tile(int32_t col, int32_t row) : m_col(col), m_row(row), m_count(0),
+        m_spilled(0), m_file(NULL)
+        {}
+
+    int32_t m_col;
+    int32_t m_row;
+    std::vector<char> m_buf;
+    point_count_t m_count;
+    point_count_t m_spilled;
+    std::string m_spillName;
+    std::FILE *m_file;
+    std::list<Tile *>::iterator m_lruPos;
+};
+
+
+// The last stage of the pipeline that reads the input.  It packs the
+// points of each chunk it's given into the buffers of their tiles, and
+// spills the biggest buffers once the points buffered use too much memory.
+class TileRouter : public Writer
+{
+public:
+    TileRouter(double length, double xOrigin, double yOrigin,
+            std::size_t bufferBytes, std::size_t maxOpen,
+            const std::string& spillDir) :
+        m_length(length), m_xOrigin(xOrigin), m_yOrigin(yOrigin),
+        m_bufferBytes(bufferBytes), m_maxOpen((std::max)(maxOpen,
+        (std::size_t)1)), m_spillDir(spillDir), m_pointSize(0),
+        m_buffered(0), m_spilledBytes(0), m_last(NULL)
+        {}
+    ~TileRouter()
+        { closeAll(); }
+
+    std::string getName() const
+        { return "kernels.tile.router"; }
+    bool streamable() const
+        { return true; }
+
+    // The dimensions of a packed point, with their names.
+    const DimTypeList& dims() const
+        { return m_dims; }
+    const std::vector<std::string>& dimNames() const
+        { return m_names; }
+    std::map<uint64_t, Tile>& tiles()
+        { return m_tiles; }
+    uint64_t spilledBytes() const
+        { return m_spilledBytes; }
+
+    void closeAll()
+    {
+        for (Tile *t : m_open)
+        {
+            std::fclose(t->m_file);
+            t->m_file = NULL;
+        }
+        m_open.clear();
+    }
+
+    // Add the points of a tile to 'view', which packs them as 'dims', and
+    // free the tile's storage.
+    void load(Tile& tile, PointView& view, const DimTypeList& dims)
+    {
+        PointId id = view.appendRange(tile.m_count);
+        if (tile.m_spilled)
+        {
+            std::FILE *f = std::fopen(tile.m_spillName.c_str(), "rb");
+            if (!f)
+                throw pdal_error("Unable to open tile spill file '" +
+                    tile.m_spillName + "'.");
+            std::vector<char> buf(m_pointSize * 65536);
+            point_count_t left = tile.m_spilled;
+            while (left)
+            {
+                point_count_t count = (std::min)(left, (point_count_t)65536);
+                if (std::fread(buf.data(), m_pointSize, count, f) != count)
+                {
+                    std::fclose(f);
+                    throw pdal_error("Unable to read tile spill file '" +
+                        tile.m_spillName + "'.");
+                }
+                for (point_count_t i = 0; i < count; ++i)
+                    view.setPackedPoint(dims, id++,
+                        buf.data() + i * m_pointSize);
+                left -= count;
+            }
+            std::fclose(f);
+            std::remove(tile.m_spillName.c_str());
+        }
+        for (std::size_t pos = 0; pos < tile.m_buf.size(); pos += m_pointSize)
+            view.setPackedPoint(dims, id++, tile.m_buf.data() + pos);
+        m_buffered -= tile.m_buf.size();
+        std::vector<char>().swap(tile.m_buf);
+    }
+
+private:
+    double m_length;
+    double m_xOrigin;
+    double m_yOrigin;
+    std::size_t m_bufferBytes;
+    std::size_t m_maxOpen;
+    std::string m_spillDir;
+    DimTypeList m_dims;
+    std::vector<std::string> m_names;
+    std::size_t m_pointSize;
+    std::size_t m_buffered;
+    uint64_t m_spilledBytes;
+    std::map<uint64_t, Tile> m_tiles;
+    // Tiles with open spill files, most recently used first.
+    std::list<Tile *> m_open;
+    // Points tend to come in runs from the same tile.
+    uint64_t m_lastKey;
+    Tile *m_last;
+
+    virtual void ready(PointTableRef table)
+    {
+        // Scaled values are packed as doubles, and computed ones are left
+        // to be computed again.
+        PointLayoutPtr layout = table.layout();
+        m_dims.clear();
+        m_names.clear();
+        m_pointSize = 0;
+        for (Dimension::Id::Enum id : layout->dims())
+        {
+            const Dimension::Detail *d = layout->dimDetail(id);
+            if (d->computed())
+                continue;
+            Dimension::Type::Enum type = d->scaled() ?
+                Dimension::Type::Double : d->type();
+            m_dims.push_back(DimType(id, type));
+            m_names.push_back(layout->dimName(id));
+            m_pointSize += Dimension::size(type);
+        }
+    }
+
+    virtual void write(const PointViewPtr view)
+    {
+        for (PointId i = 0; i < view->size(); ++i)
+        {
+            double x = view->getFieldAs<double>(Dimension::Id::X, i);
+            double y = view->getFieldAs<double>(Dimension::Id::Y, i);
+            int32_t col = (int32_t)std::floor((x - m_xOrigin) / m_length);
+            int32_t row = (int32_t)std::floor((y - m_yOrigin) / m_length);
+            uint64_t key = ((uint64_t)(uint32_t)col << 32) | (uint32_t)row;
+            if (!m_last || key != m_lastKey)
+            {
+                m_last = &m_tiles.insert(
+                    std::make_pair(key, Tile(col, row))).first->second;
+                m_lastKey = key;
+            }
+
+            std::size_t pos = m_last->m_buf.size();
+            m_last->m_buf.resize(pos + m_pointSize);
+            view->getPackedPoint(m_dims, i, m_last->m_buf.data() + pos);
+            m_last->m_count++;
+            m_buffered += m_pointSize;
+        }
+
+        // Spilling down to half the limit keeps tiles from being spilled
+        // a few points at a time.
+        if (m_buffered > m_bufferBytes)
+            while (m_buffered > m_bufferBytes / 2)
+            {
+                Tile *biggest = NULL;
+                for (auto& ti : m_tiles)
+                    if (!biggest ||
+                        ti.second.m_buf.size() > biggest->m_buf.size())
+                        biggest = &ti.second;
+                spill(*biggest);
+            }
+    }
+
+    void spill(Tile& tile)
+    {
+        std::FILE *f = open(tile);
+        std::size_t size = tile.m_buf.size();
+        if (std::fwrite(tile.m_buf.data(), 1, size, f) != size)
+            throw pdal_error("Unable to write tile spill file '" +
+                tile.m_spillName + "'.");
+        tile.m_spilled += size / m_pointSize;
+        m_spilledBytes += size;
+        m_buffered -= size;
+        std::vector<char>().swap(tile.m_buf);
+    }
+
+    // The spill file of a tile, opened if need be.  Only 'm_maxOpen' files
+    // are kept open, the least recently used being closed first.
+    std::FILE *open(Tile& tile)
+    {
+        if (tile.m_file)
+        {
+            m_open.splice(m_open.begin(), m_open, tile.m_lruPos);
+            return tile.m_file;
+        }
+        if (m_open.size() >= m_maxOpen)
+        {
+            Tile *t = m_open.back();
+            m_open.pop_back();
+            std::fclose(t->m_file);
+            t->m_file = NULL;
+        }
+
+        const char *mode = "ab";
+        if (tile.m_spillName.empty())
+        {
+            tile.m_spillName = m_spillDir + "/" +
+                std::to_string(tile.m_col) + "_" + std::to_string(tile.m_row);
+            mode = "wb";
+        }
+        tile.m_file = std::fopen(tile.m_spillName.c_str(), mode);
+        if (!tile.m_file)
+            throw pdal_error("Unable to open tile spill file '" +
+                tile.m_spillName + "'.");
+        m_open.push_front(&tile);
+        tile.m_lruPos = m_open.begin();
+        return tile.m_file;
+    }
+};
+
+
+// A temporary directory that's removed with everything in it.
+struct TempDir
+{
+    TempDir(const std::string& parent)
+    {
+        boost::filesystem::path base = parent.empty() ?
+            boost::filesystem::temp_directory_path() :
+            boost::filesystem::path(parent);
+        m_path = base / boost::filesystem::unique_path("pdal_tile_%%%%%%%%");
+        boost::filesystem::create_directories(m_path);
+    }
+    ~TempDir()
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(m_path, ec);
+    }
+
+    boost::filesystem::path m_path;
+};
+
+} // unnamed namespace
+
+
+TileKernel::TileKernel() : m_length(1000), m_xOrigin(0), m_yOrigin(0),
+    m_chunkSize(100000), m_bufferSize(256), m_maxOpen(100)
+{}
+
+
+void TileKernel::addSwitches()
+{
+    po::options_description* file_options =
+        new po::options_description("file options");
+
+    file_options->add_options()
+        ("input,i", po::value<std::string>(&m_inputFile)->default_value(""),
+            "input file name")
+        ("output,o", po::value<std::string>(&m_outputFile)->default_value(""),
+            "Output file name, in which '#' is replaced by the column and "
+            "row of each tile")
+        ("length", po::value<double>(&m_length)->default_value(1000),
+            "Length of the sides of the tiles")
+        ("origin_x", po::value<double>(&m_xOrigin)->default_value(0),
+            "X of the corner of tile 0_0")
+        ("origin_y", po::value<double>(&m_yOrigin)->default_value(0),
+            "Y of the corner of tile 0_0")
+        ("chunk", po::value<point_count_t>(&m_chunkSize)->default_value(100000),
+            "Number of points read at a time")
+        ("buffer", po::value<std::size_t>(&m_bufferSize)->default_value(256),
+            "Megabytes of points held in memory before some are spilled to "
+            "disk")
+        ("max_open", po::value<std::size_t>(&m_maxOpen)->default_value(100),
+            "Number of spill files kept open at once")
+        ("spill-dir",
+            po::value<std::string>(&m_spillDir)->default_value(""),
+            "Directory for points spilled to disk")
+        ;
+
+    addSwitchSet(file_options);
+    addPositionalSwitch("input", 1);
+    addPositionalSwitch("output", 1);
+}
+
+
+void TileKernel::validateSwitches()
+{
+    if (m_inputFile.empty())
+        throw app_usage_error("input file name required");
+    if (m_outputFile.empty())
+        throw app_usage_error("output file name required");
+    if (m_outputFile.find('#') == std::string::npos)
+        throw app_usage_error("output file name must contain '#'");
+    if (m_length <= 0)
+        throw app_usage_error("--length must be greater than 0");
+    if (m_chunkSize == 0)
+        throw app_usage_error("--chunk must be greater than 0");
+}
+
+
+int TileKernel::execute()
+{
+    auto applyExtraOptions = [this](Stage& stage)
+    {
+        auto pi = getExtraStageOptions().find(stage.getName());
+        if (pi == getExtraStageOptions().end())
+            return;
+        Options opts = stage.getOptions();
+        for (const auto& o : pi->second.getOptions())
+            opts.add(o);
+        stage.setOptions(opts);
+    };
+
+    TempDir spillDir(m_spillDir);
+    TileRouter router(m_length, m_xOrigin, m_yOrigin,
+        m_bufferSize * 1024 * 1024, m_maxOpen, spillDir.m_path.string());
+
+    Stage& reader = makeReader(m_inputFile);
+    Options readerOptions;
+    readerOptions.add("filename", m_inputFile);
+    readerOptions.add("debug", isDebug());
+    readerOptions.add("verbose", getVerboseLevel());
+    reader.setOptions(readerOptions);
+    applyExtraOptions(reader);
+    router.setInput(reader);
+
+    SpatialReference srs;
+    FixedPointTable streamTable(m_chunkSize);
+    router.prepare(streamTable);
+    if (router.pipelineStreamable())
+    {
+        router.executeStream(streamTable);
+        srs = streamTable.spatialRef();
+    }
+    else
+    {
+        std::cerr << "Input can't be streamed.  Reading all points at "
+            "once." << std::endl;
+        PointTable table;
+        router.prepare(table);
+        router.execute(table);
+        srs = table.spatialRef();
+    }
+    router.closeAll();
+    // The tiles are written by pipelines of their own.
+    takeStages();
+
+    if (getVerboseLevel())
+        std::cerr << router.tiles().size() << " tiles, " <<
+            router.spilledBytes() << " bytes spilled." << std::endl;
+
+    for (auto& ti : router.tiles())
+    {
+        Tile& tile = ti.second;
+
+        PointTable table;
+        DimTypeList dims;
+        for (std::size_t i = 0; i < router.dims().size(); ++i)
+        {
+            Dimension::Type::Enum type = router.dims()[i].m_type;
+            dims.push_back(DimType(table.layout()->registerOrAssignDim(
+                router.dimNames()[i], type), type));
+        }
+        table.layout()->finalize();
+        PointViewPtr view(new PointView(table));
+        router.load(tile, *view, dims);
+
+        BufferReader bufferReader;
+        bufferReader.addView(view);
+        bufferReader.setSpatialReference(srs);
+
+        std::string filename(m_outputFile);
+        filename.replace(filename.find('#'), 1,
+            std::to_string(tile.m_col) + "_" + std::to_string(tile.m_row));
+        Stage& writer = makeWriter(filename, bufferReader);
+        Options writerOptions;
+        writerOptions.add("filename", filename);
+        setCommonOptions(writerOptions);
+        writer.setOptions(writerOptions + writer.getOptions());
+        applyExtraOptions(writer);
+
+        writer.prepare(table);
+        writer.execute(table);
+        takeStages();
+    }
+    return 0;
+}
+
+} // namespace pdal
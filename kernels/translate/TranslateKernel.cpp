@@ -36,11 +36,18 @@
 
 #include <pdal/BufferReader.hpp>
 #include <pdal/KernelSupport.hpp>
+#include <pdal/PDALUtils.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <reprojection/ReprojectionFilter.hpp>
 
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 
+#include <atomic>
+#include <mutex>
+
 namespace pdal
 {
 
@@ -61,14 +68,17 @@ TranslateKernel::TranslateKernel() :
     m_input_srs(pdal::SpatialReference()),
     m_output_srs(pdal::SpatialReference()), m_bForwardMetadata(false),
     m_decimation_step(1), m_decimation_offset(0),
-    m_decimation_leaf_size(1), m_decimation_limit(0)
+    m_decimation_leaf_size(1), m_decimation_limit(0),
+    m_streamChunkSize(0), m_streamSlots(3), m_profile(false), m_threads(0)
 {}
 
 
 void TranslateKernel::validateSwitches()
 {
-    if (m_inputFile == "")
-        throw app_usage_error("--input/-i required");
+    if (m_inputFile == "" && m_batch == "")
+        throw app_usage_error("--input/-i or --batch required");
+    if (m_inputFile != "" && m_batch != "")
+        throw app_usage_error("--input/-i and --batch can't both be given");
     if (m_outputFile == "")
         throw app_usage_error("--output/-o required");
     //
@@ -176,6 +186,28 @@ void TranslateKernel::addSwitches()
         ("d_limit",
          po::value<point_count_t>(&m_decimation_limit)->default_value(0),
          "Decimation limit")
+        ("stream",
+         po::value<point_count_t>(&m_streamChunkSize)->default_value(0),
+         "Process points in chunks of this many points rather than all at "
+         "once, if every stage of the translation allows it")
+        ("stream_slots",
+         po::value<int>(&m_streamSlots)->default_value(3),
+         "Number of chunks held at once when streaming.  More than one lets "
+         "reading, filtering and writing overlap")
+        ("profile",
+         po::value<bool>(&m_profile)->zero_tokens()->implicit_value(true),
+         "Write the time, point counts and memory of each stage to stdout "
+         "as JSON")
+        ("batch",
+         po::value<std::string>(&m_batch)->default_value(""),
+         "Translate many files in one run.  Either a pattern such as "
+         "'tiles/*.laz' or a file listing one input per line.  Each '#' "
+         "in --output is replaced by the input name without its extension; "
+         "with no '#' --output is the directory to write to")
+        ("threads",
+         po::value<size_t>(&m_threads)->default_value(0),
+         "Number of files translated at once in batch mode.  Zero uses "
+         "one for each hardware thread")
         ;
 
     addSwitchSet(file_options);
@@ -183,7 +215,8 @@ void TranslateKernel::addSwitches()
     addPositionalSwitch("output", 1);
 }
 
-Stage& TranslateKernel::makeReader(Options readerOptions)
+Stage& TranslateKernel::makeReader(const std::string& inputFile,
+    Options readerOptions)
 {
     if (isDebug())
     {
@@ -196,7 +229,7 @@ Stage& TranslateKernel::makeReader(Options readerOptions)
         readerOptions.add("log", "STDERR");
     }
 
-    Stage& reader = Kernel::makeReader(m_inputFile);
+    Stage& reader = Kernel::makeReader(inputFile);
     reader.setOptions(readerOptions);
 
     return reader;
@@ -322,18 +355,17 @@ Stage& TranslateKernel::makeTranslate(Options translateOptions, Stage& parent)
 }
 
 
-int TranslateKernel::execute()
+Stage& TranslateKernel::makePipeline(const std::string& inputFile,
+    const std::string& outputFile)
 {
-    PointTable table;
-
     Options readerOptions;
-    readerOptions.add("filename", m_inputFile);
+    readerOptions.add("filename", inputFile);
     readerOptions.add("debug", isDebug());
     readerOptions.add("verbose", getVerboseLevel());
     if (!m_input_srs.empty())
         readerOptions.add("spatialreference", m_input_srs.getWKT());
 
-    Stage& readerStage = makeReader(readerOptions);
+    Stage& readerStage = makeReader(inputFile, readerOptions);
 
     // go ahead and prepare/execute on reader stage only to grab input
     // PointViewSet, this makes the input PointView available to both the
@@ -352,7 +384,7 @@ int TranslateKernel::execute()
     Stage& finalStage = makeTranslate(readerOptions, readerStage);
 
     Options writerOptions;
-    writerOptions.add("filename", m_outputFile);
+    writerOptions.add("filename", outputFile);
     setCommonOptions(writerOptions);
 
     if (!m_input_srs.empty())
@@ -363,12 +395,7 @@ int TranslateKernel::execute()
     if (m_bForwardMetadata)
         writerOptions.add("forward_metadata", true);
 
-    std::vector<std::string> cmd = getProgressShellCommand();
-    UserCallback *callback =
-        cmd.size() ? (UserCallback *)new ShellScriptCallback(cmd) :
-        (UserCallback *)new HeartbeatCallback();
-
-    Stage& writer = makeWriter(m_outputFile, finalStage);
+    Stage& writer = makeWriter(outputFile, finalStage);
     if (!m_output_srs.empty())
         writer.setSpatialReference(m_output_srs);
 
@@ -391,10 +418,53 @@ int TranslateKernel::execute()
             s->setOptions(opts);
         }
     }
+    return writer;
+}
+
+
+bool TranslateKernel::runStreamed(Stage& writer)
+{
+    if (!m_streamChunkSize || isVisualize())
+        return false;
+
+    FixedPointTable streamTable(m_streamChunkSize, m_streamSlots);
+    writer.prepare(streamTable);
+    if (!writer.pipelineStreamable())
+    {
+        std::cerr << "Translation can't be streamed.  Processing all "
+            "points at once." << std::endl;
+        return false;
+    }
+    writer.executeStream(streamTable);
+    return true;
+}
+
+
+int TranslateKernel::execute()
+{
+    if (m_batch.size())
+        return executeBatch();
+
+    std::vector<std::string> cmd = getProgressShellCommand();
+    UserCallback *callback =
+        cmd.size() ? (UserCallback *)new ShellScriptCallback(cmd) :
+        (UserCallback *)new HeartbeatCallback();
+
+    Stage& writer = makePipeline(m_inputFile, m_outputFile);
+    if (runStreamed(writer))
+    {
+        if (m_profile)
+            utils::toJSON(writer.pipelineProfile(), std::cout);
+        return 0;
+    }
+
+    PointTable table;
     writer.prepare(table);
 
     // process the data, grabbing the PointViewSet for visualization of the
     PointViewSet viewSetOut = writer.execute(table);
+    if (m_profile)
+        utils::toJSON(writer.pipelineProfile(), std::cout);
 
     if (isVisualize())
         visualize(*viewSetOut.begin());
@@ -402,5 +472,106 @@ int TranslateKernel::execute()
     return 0;
 }
 
+
+std::vector<std::string> TranslateKernel::batchInputs() const
+{
+    if (m_batch.find_first_of("*?") != std::string::npos)
+        return FileUtils::glob(m_batch);
+
+    // Otherwise the batch names a file that lists one input per line.
+    std::vector<std::string> inputs;
+    std::istream *in = FileUtils::openFile(m_batch, false);
+    if (!in)
+        throw app_runtime_error("can't open batch file list " + m_batch);
+    std::string line;
+    while (std::getline(*in, line))
+    {
+        boost::algorithm::trim(line);
+        if (line.size())
+            inputs.push_back(line);
+    }
+    FileUtils::closeFile(in);
+    return inputs;
+}
+
+
+// Each '#' in the output template is replaced with the input filename
+// without its directory or extension.  A template with no '#' is taken as
+// the directory to write files of the input name to.
+std::string TranslateKernel::batchOutput(const std::string& inputFile) const
+{
+    boost::filesystem::path in(inputFile);
+    if (m_outputFile.find('#') != std::string::npos)
+        return boost::algorithm::replace_all_copy(m_outputFile, "#",
+            in.stem().string());
+    return (boost::filesystem::path(m_outputFile) / in.filename()).string();
+}
+
+
+int TranslateKernel::executeBatch()
+{
+    std::vector<std::string> inputs = batchInputs();
+    if (inputs.empty())
+        throw app_runtime_error("no input files match " + m_batch);
+
+    size_t threads = m_threads ? m_threads :
+        std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, inputs.size());
+
+    // Stage creation touches state shared by the kernel and the plugin
+    // manager, so pipelines are built one at a time.  Running them, which
+    // is where the time goes, happens on all of the workers at once.
+    std::mutex stageMutex;
+    std::mutex outputMutex;
+    std::atomic<size_t> failed(0);
+    auto translateOne = [&](const std::string& inputFile)
+    {
+        std::string outputFile = batchOutput(inputFile);
+        try
+        {
+            std::vector<std::unique_ptr<Stage>> stages;
+            Stage *writer;
+            {
+                std::lock_guard<std::mutex> lock(stageMutex);
+                writer = &makePipeline(inputFile, outputFile);
+                stages = takeStages();
+            }
+            if (!runStreamed(*writer))
+            {
+                PointTable table;
+                writer->prepare(table);
+                writer->execute(table);
+            }
+            std::lock_guard<std::mutex> lock(outputMutex);
+            if (m_profile)
+                utils::toJSON(writer->pipelineProfile(), std::cout);
+            if (isDebug())
+                std::cerr << inputFile << " -> " << outputFile << std::endl;
+        }
+        catch (std::exception& e)
+        {
+            failed++;
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cerr << "PDAL: " << inputFile << ": " << e.what() <<
+                std::endl;
+        }
+    };
+
+    ThreadPool pool(threads);
+    std::vector<std::future<void>> futures;
+    for (const auto& inputFile : inputs)
+        futures.push_back(pool.submit(std::bind(translateOne, inputFile)));
+    for (auto& f : futures)
+        pool.wait(f);
+
+    if (failed)
+    {
+        std::cerr << "PDAL: " << failed << " of " << inputs.size() <<
+            " files failed to translate." << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 } // namespace pdal
 
@@ -56,9 +56,15 @@ private:
     void addSwitches();
     void validateSwitches();
 
-    Stage& makeReader(Options readerOptions);
+    Stage& makeReader(const std::string& inputFile, Options readerOptions);
     Stage& makeTranslate(Options translateOptions, Stage& parent);
+    Stage& makePipeline(const std::string& inputFile,
+        const std::string& outputFile);
     void forwardMetadata(Options& options, Metadata metadata);
+    bool runStreamed(Stage& writer);
+    int executeBatch();
+    std::vector<std::string> batchInputs() const;
+    std::string batchOutput(const std::string& inputFile) const;
 
     std::string m_inputFile;
     std::string m_outputFile;
@@ -73,6 +79,11 @@ private:
     double m_decimation_leaf_size;
     std::string m_decimation_method;
     point_count_t m_decimation_limit;
+    point_count_t m_streamChunkSize;
+    int m_streamSlots;
+    bool m_profile;
+    std::string m_batch;
+    size_t m_threads;
 };
 
 } // namespace pdal
@@ -0,0 +1,538 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include "ArrowCommon.hpp"
+
+#include <pdal/Options.hpp>
+#include <pdal/Utils.hpp>
+
+#include <arrow/util/compression.h>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+namespace pdal
+{
+
+namespace arrowsupport
+{
+
+std::shared_ptr<arrow::DataType> arrowType(Dimension::Type::Enum type)
+{
+    using namespace Dimension::Type;
+
+    switch (type)
+    {
+    case Signed8:
+        return arrow::int8();
+    case Signed16:
+        return arrow::int16();
+    case Signed32:
+        return arrow::int32();
+    case Signed64:
+        return arrow::int64();
+    case Unsigned8:
+        return arrow::uint8();
+    case Unsigned16:
+        return arrow::uint16();
+    case Unsigned32:
+        return arrow::uint32();
+    case Unsigned64:
+        return arrow::uint64();
+    case Float:
+        return arrow::float32();
+    case Double:
+        return arrow::float64();
+    default:
+        throw pdal_error("Dimensions of type '" +
+            Dimension::interpretationName(type) + "' can't be written to "
+            "Arrow columns.");
+    }
+}
+
+
+Dimension::Type::Enum pdalType(const arrow::DataType& type)
+{
+    using namespace Dimension::Type;
+
+    switch (type.id())
+    {
+    case arrow::Type::INT8:
+        return Signed8;
+    case arrow::Type::INT16:
+        return Signed16;
+    case arrow::Type::INT32:
+        return Signed32;
+    case arrow::Type::INT64:
+        return Signed64;
+    case arrow::Type::UINT8:
+        return Unsigned8;
+    case arrow::Type::UINT16:
+        return Unsigned16;
+    case arrow::Type::UINT32:
+        return Unsigned32;
+    case arrow::Type::UINT64:
+        return Unsigned64;
+    case arrow::Type::FLOAT:
+        return Float;
+    case arrow::Type::DOUBLE:
+        return Double;
+    default:
+        return None;
+    }
+}
+
+} // namespace arrowsupport
+
+using namespace arrowsupport;
+
+namespace
+{
+
+template <typename B, typename T>
+void appendValues(arrow::ArrayBuilder& builder, const PointView& view,
+    Dimension::Id::Enum id, PointId begin, point_count_t count)
+{
+    B& b = static_cast<B&>(builder);
+    for (PointId idx = begin; idx < begin + count; ++idx)
+        b.UnsafeAppend(view.getFieldAs<T>(id, idx));
+}
+
+
+// Append the values of a dimension of points [begin, begin + count) of
+// 'view' to the column's builder, which has room for them.
+void appendColumn(arrow::ArrayBuilder& builder, const DimType& dt,
+    const PointView& view, PointId begin, point_count_t count)
+{
+    using namespace Dimension::Type;
+
+    switch (dt.m_type)
+    {
+    case Signed8:
+        appendValues<arrow::Int8Builder, int8_t>(builder, view, dt.m_id,
+            begin, count);
+        break;
+    case Signed16:
+        appendValues<arrow::Int16Builder, int16_t>(builder, view, dt.m_id,
+            begin, count);
+        break;
+    case Signed32:
+        appendValues<arrow::Int32Builder, int32_t>(builder, view, dt.m_id,
+            begin, count);
+        break;
+    case Signed64:
+        appendValues<arrow::Int64Builder, int64_t>(builder, view, dt.m_id,
+            begin, count);
+        break;
+    case Unsigned8:
+        appendValues<arrow::UInt8Builder, uint8_t>(builder, view, dt.m_id,
+            begin, count);
+        break;
+    case Unsigned16:
+        appendValues<arrow::UInt16Builder, uint16_t>(builder, view,
+            dt.m_id, begin, count);
+        break;
+    case Unsigned32:
+        appendValues<arrow::UInt32Builder, uint32_t>(builder, view,
+            dt.m_id, begin, count);
+        break;
+    case Unsigned64:
+        appendValues<arrow::UInt64Builder, uint64_t>(builder, view,
+            dt.m_id, begin, count);
+        break;
+    case Float:
+        appendValues<arrow::FloatBuilder, float>(builder, view, dt.m_id,
+            begin, count);
+        break;
+    case Double:
+        appendValues<arrow::DoubleBuilder, double>(builder, view, dt.m_id,
+            begin, count);
+        break;
+    default:
+        break;
+    }
+}
+
+
+template <typename A>
+void copyValues(const arrow::Array& array, Dimension::Id::Enum id,
+    const std::vector<int64_t>& rows, PointView& view, PointId first)
+{
+    const A& a = static_cast<const A&>(array);
+    for (std::size_t i = 0; i < rows.size(); ++i)
+    {
+        int64_t row = rows[i];
+        view.setField(id, first + i,
+            a.IsNull(row) ? typename A::value_type() : a.Value(row));
+    }
+}
+
+
+// Set dimension 'id' of points first, first + 1, ... of 'view' from the
+// values of 'rows' of a column.  Nulls are read as 0.
+void copyColumn(const arrow::Array& array, Dimension::Id::Enum id,
+    const std::vector<int64_t>& rows, PointView& view, PointId first)
+{
+    switch (array.type_id())
+    {
+    case arrow::Type::INT8:
+        copyValues<arrow::Int8Array>(array, id, rows, view, first);
+        break;
+    case arrow::Type::INT16:
+        copyValues<arrow::Int16Array>(array, id, rows, view, first);
+        break;
+    case arrow::Type::INT32:
+        copyValues<arrow::Int32Array>(array, id, rows, view, first);
+        break;
+    case arrow::Type::INT64:
+        copyValues<arrow::Int64Array>(array, id, rows, view, first);
+        break;
+    case arrow::Type::UINT8:
+        copyValues<arrow::UInt8Array>(array, id, rows, view, first);
+        break;
+    case arrow::Type::UINT16:
+        copyValues<arrow::UInt16Array>(array, id, rows, view, first);
+        break;
+    case arrow::Type::UINT32:
+        copyValues<arrow::UInt32Array>(array, id, rows, view, first);
+        break;
+    case arrow::Type::UINT64:
+        copyValues<arrow::UInt64Array>(array, id, rows, view, first);
+        break;
+    case arrow::Type::FLOAT:
+        copyValues<arrow::FloatArray>(array, id, rows, view, first);
+        break;
+    case arrow::Type::DOUBLE:
+        copyValues<arrow::DoubleArray>(array, id, rows, view, first);
+        break;
+    default:
+        break;
+    }
+}
+
+
+template <typename A>
+double value(const arrow::Array& array, int64_t row)
+{
+    return static_cast<double>(static_cast<const A&>(array).Value(row));
+}
+
+
+// Value of 'row' of a numeric column as a double.
+double valueAsDouble(const arrow::Array& array, int64_t row)
+{
+    switch (array.type_id())
+    {
+    case arrow::Type::INT8:
+        return value<arrow::Int8Array>(array, row);
+    case arrow::Type::INT16:
+        return value<arrow::Int16Array>(array, row);
+    case arrow::Type::INT32:
+        return value<arrow::Int32Array>(array, row);
+    case arrow::Type::INT64:
+        return value<arrow::Int64Array>(array, row);
+    case arrow::Type::UINT8:
+        return value<arrow::UInt8Array>(array, row);
+    case arrow::Type::UINT16:
+        return value<arrow::UInt16Array>(array, row);
+    case arrow::Type::UINT32:
+        return value<arrow::UInt32Array>(array, row);
+    case arrow::Type::UINT64:
+        return value<arrow::UInt64Array>(array, row);
+    case arrow::Type::FLOAT:
+        return value<arrow::FloatArray>(array, row);
+    case arrow::Type::DOUBLE:
+        return value<arrow::DoubleArray>(array, row);
+    default:
+        return 0;
+    }
+}
+
+} // unnamed namespace
+
+
+ArrowWriterBase::ArrowWriterBase() : m_batchSize(65536),
+    m_compression(arrow::Compression::UNCOMPRESSED), m_rows(0)
+{}
+
+
+void ArrowWriterBase::setCompression(const std::string& name)
+{
+    std::string codec = Utils::tolower(name);
+    if (codec == "none" || codec == "false")
+        codec = "uncompressed";
+    arrow::Result<arrow::Compression::type> type =
+        arrow::util::Codec::GetCompressionType(codec);
+    if (!type.ok() || !arrow::util::Codec::IsAvailable(*type))
+        throw pdal_error(getName() + ": Compression '" + name +
+            "' isn't available.");
+    m_compression = *type;
+}
+
+
+void ArrowWriterBase::ready(PointTableRef table)
+{
+    PointLayoutPtr layout = table.layout();
+
+    m_dimTypes.clear();
+    if (m_outputDims.empty())
+        m_dimTypes = layout->dimTypes();
+    for (const std::string& s : m_outputDims)
+    {
+        DimType dt = layout->findDimType(s);
+        if (dt.m_id == Dimension::Id::Unknown)
+        {
+            std::ostringstream oss;
+            oss << "Invalid dimension '" << s << "' specified for "
+                "'output_dims' option.";
+            throw pdal_error(oss.str());
+        }
+        m_dimTypes.push_back(dt);
+    }
+
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    m_builders.clear();
+    for (const auto& dt : m_dimTypes)
+    {
+        std::shared_ptr<arrow::DataType> type = arrowType(dt.m_type);
+        fields.push_back(arrow::field(layout->dimName(dt.m_id), type,
+            false));
+        m_builders.push_back(check(arrow::MakeBuilder(type),
+            getName() + ": Unable to create column"));
+        check(m_builders.back()->Reserve(m_batchSize),
+            getName() + ": Unable to allocate column");
+    }
+
+    const SpatialReference& srs = getSpatialReference().empty() ?
+        table.spatialRef() : getSpatialReference();
+    std::shared_ptr<arrow::KeyValueMetadata> metadata;
+    if (!srs.empty())
+        metadata = arrow::key_value_metadata({ SrsKey }, { srs.getWKT() });
+    m_schema = arrow::schema(fields, metadata);
+    m_rows = 0;
+    openFile(m_schema);
+}
+
+
+void ArrowWriterBase::write(const PointViewPtr view)
+{
+    PointId begin = 0;
+    while (begin < view->size())
+    {
+        point_count_t count = std::min<point_count_t>(view->size() - begin,
+            m_batchSize - m_rows);
+        for (std::size_t i = 0; i < m_dimTypes.size(); ++i)
+            appendColumn(*m_builders[i], m_dimTypes[i], *view, begin, count);
+        m_rows += count;
+        begin += count;
+        if (m_rows == m_batchSize)
+            flush();
+    }
+}
+
+
+// Hand the points appended so far to writeBatch() as a batch.
+void ArrowWriterBase::flush()
+{
+    if (m_rows == 0)
+        return;
+
+    std::vector<std::shared_ptr<arrow::Array>> columns;
+    for (auto& builder : m_builders)
+    {
+        std::shared_ptr<arrow::Array> column;
+        check(builder->Finish(&column), getName() + ": Unable to finish "
+            "column");
+        columns.push_back(column);
+        check(builder->Reserve(m_batchSize),
+            getName() + ": Unable to allocate column");
+    }
+    writeBatch(arrow::RecordBatch::Make(m_schema, m_rows, columns));
+    m_rows = 0;
+}
+
+
+void ArrowWriterBase::done(PointTableRef /*table*/)
+{
+    flush();
+    closeFile();
+}
+
+
+ArrowReaderBase::ArrowReaderBase() : m_xColumn(-1), m_yColumn(-1),
+    m_zColumn(-1), m_row(0)
+{}
+
+
+Options ArrowReaderBase::getDefaultOptions()
+{
+    Options options;
+    options.add("bounds", BOX3D(), "Only read points inside these bounds.  "
+        "If the Z range is empty, only X and Y are checked.");
+    return options;
+}
+
+
+void ArrowReaderBase::processOptions(const Options& options)
+{
+    m_bounds = options.getValueOrDefault<BOX3D>("bounds", BOX3D());
+}
+
+
+bool ArrowReaderBase::setBounds(const BOX3D& bounds)
+{
+    // 'count' is of the points in the file, not of those inside the
+    // bounds.
+    if (bounds.empty() || !m_bounds.empty() ||
+        m_count != (std::numeric_limits<point_count_t>::max)())
+        return false;
+    m_bounds = bounds;
+    return true;
+}
+
+
+void ArrowReaderBase::initialize()
+{
+    std::shared_ptr<arrow::Schema> schema = openFile();
+
+    m_fields.clear();
+    for (int i = 0; i < schema->num_fields(); ++i)
+    {
+        const std::shared_ptr<arrow::Field>& field = schema->field(i);
+        Dimension::Type::Enum type = pdalType(*field->type());
+        if (type == Dimension::Type::None)
+        {
+            log()->get(LogLevel::Warning) << getName() << ": Skipping "
+                "column '" << field->name() << "' of type " <<
+                field->type()->ToString() << "." << std::endl;
+            continue;
+        }
+        m_fields.push_back(Field(i, field->name(), type));
+        if (field->name() == "X")
+            m_xColumn = i;
+        else if (field->name() == "Y")
+            m_yColumn = i;
+        else if (field->name() == "Z")
+            m_zColumn = i;
+    }
+
+    std::shared_ptr<const arrow::KeyValueMetadata> metadata =
+        schema->metadata();
+    if (metadata && getSpatialReference().empty())
+    {
+        int index = metadata->FindKey(SrsKey);
+        if (index >= 0)
+            setSpatialReference(SpatialReference(metadata->value(index)));
+    }
+}
+
+
+void ArrowReaderBase::addDimensions(PointLayoutPtr layout)
+{
+    m_dimTypes.clear();
+    for (const auto& field : m_fields)
+        m_dimTypes.push_back(DimType(
+            layout->registerOrAssignDim(field.m_name, field.m_type),
+            field.m_type));
+}
+
+
+void ArrowReaderBase::ready(PointTableRef /*table*/)
+{
+    if (!m_bounds.empty() && (m_xColumn < 0 || m_yColumn < 0 ||
+        (!m_bounds.is_z_empty() && m_zColumn < 0)))
+        throw pdal_error(getName() + ": Can't read points inside bounds "
+            "without X, Y and Z columns.");
+    rewind();
+    m_batch.reset();
+    m_row = 0;
+}
+
+
+bool ArrowReaderBase::inBounds(int64_t row) const
+{
+    if (m_bounds.empty())
+        return true;
+
+    double x = valueAsDouble(*m_batch->column(m_xColumn), row);
+    double y = valueAsDouble(*m_batch->column(m_yColumn), row);
+    if (x < m_bounds.minx || x > m_bounds.maxx ||
+        y < m_bounds.miny || y > m_bounds.maxy)
+        return false;
+    if (m_bounds.is_z_empty())
+        return true;
+    double z = valueAsDouble(*m_batch->column(m_zColumn), row);
+    return z >= m_bounds.minz && z <= m_bounds.maxz;
+}
+
+
+point_count_t ArrowReaderBase::read(PointViewPtr view, point_count_t count)
+{
+    PointId nextId = view->size();
+    point_count_t numRead = 0;
+    std::vector<int64_t> rows;
+    while (numRead < count)
+    {
+        if (!m_batch || m_row == m_batch->num_rows())
+        {
+            m_batch = nextBatch();
+            m_row = 0;
+            if (!m_batch)
+                break;
+        }
+
+        // Pick the rows to read from the batch and then copy them a
+        // column at a time.
+        rows.clear();
+        while (m_row < m_batch->num_rows() && rows.size() < count - numRead)
+        {
+            if (inBounds(m_row))
+                rows.push_back(m_row);
+            m_row++;
+        }
+        for (std::size_t i = 0; i < m_fields.size(); ++i)
+            copyColumn(*m_batch->column(m_fields[i].m_column),
+                m_dimTypes[i].m_id, rows, *view, nextId);
+        if (m_cb)
+            for (std::size_t i = 0; i < rows.size(); ++i)
+                m_cb(*view, nextId + i);
+        nextId += rows.size();
+        numRead += rows.size();
+    }
+    return numRead;
+}
+
+} // namespace pdal
@@ -0,0 +1,179 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#pragma once
+
+#include <pdal/Dimension.hpp>
+#include <pdal/pdal_error.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/Reader.hpp>
+#include <pdal/Writer.hpp>
+#include <pdal/util/Bounds.hpp>
+
+#include <arrow/api.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pdal
+{
+
+namespace arrowsupport
+{
+
+// Key of the schema metadata holding the spatial reference, as WKT.
+const std::string SrsKey("pdal:srs");
+
+// Arrow type of a dimension.
+std::shared_ptr<arrow::DataType> arrowType(Dimension::Type::Enum type);
+// Type of the dimension read from an Arrow column, or None if columns of
+// 'type' aren't read.
+Dimension::Type::Enum pdalType(const arrow::DataType& type);
+
+inline void check(const arrow::Status& status, const std::string& what)
+{
+    if (!status.ok())
+        throw pdal_error(what + ": " + status.ToString());
+}
+
+template <typename T>
+T check(arrow::Result<T> result, const std::string& what)
+{
+    check(result.status(), what);
+    return std::move(result).ValueUnsafe();
+}
+
+} // namespace arrowsupport
+
+
+// Writes the points as record batches of Arrow columns, one column per
+// dimension.  The points of each view are appended to the columns as
+// they arrive, so the writer can be streamed to, and a batch is handed to
+// writeBatch() each time m_batchSize points have been appended.
+class PDAL_DLL ArrowWriterBase : public Writer
+{
+public:
+    ArrowWriterBase();
+
+    virtual bool streamable() const
+        { return true; }
+
+protected:
+    point_count_t m_batchSize;
+    arrow::Compression::type m_compression;
+
+    // Set m_compression from the name of a codec.
+    void setCompression(const std::string& name);
+
+private:
+    std::shared_ptr<arrow::Schema> m_schema;
+    DimTypeList m_dimTypes;
+    std::vector<std::unique_ptr<arrow::ArrayBuilder>> m_builders;
+    point_count_t m_rows;
+
+    virtual void ready(PointTableRef table);
+    virtual void write(const PointViewPtr view);
+    virtual void done(PointTableRef table);
+
+    virtual void openFile(std::shared_ptr<arrow::Schema> schema) = 0;
+    virtual void writeBatch(std::shared_ptr<arrow::RecordBatch> batch) = 0;
+    virtual void closeFile() = 0;
+
+    void flush();
+
+    ArrowWriterBase& operator=(const ArrowWriterBase&); // not implemented
+    ArrowWriterBase(const ArrowWriterBase&); // not implemented
+};
+
+
+// Reads points from record batches of Arrow columns.  Columns of numeric
+// types become dimensions of the same name and others are skipped.  Points
+// outside the 'bounds' option are skipped too, and the bounds are handed to
+// subclasses that can skip whole batches.
+class PDAL_DLL ArrowReaderBase : public Reader
+{
+public:
+    ArrowReaderBase();
+
+    Options getDefaultOptions();
+
+    virtual bool setBounds(const BOX3D& bounds);
+
+protected:
+    BOX3D m_bounds;
+    // Columns of X, Y and Z in the schema, or -1.
+    int m_xColumn;
+    int m_yColumn;
+    int m_zColumn;
+
+private:
+    struct Field
+    {
+        Field(int column, const std::string& name,
+                Dimension::Type::Enum type) :
+            m_column(column), m_name(name), m_type(type)
+            {}
+
+        int m_column;
+        std::string m_name;
+        Dimension::Type::Enum m_type;
+    };
+
+    std::vector<Field> m_fields;
+    DimTypeList m_dimTypes;
+    std::shared_ptr<arrow::RecordBatch> m_batch;
+    int64_t m_row;
+
+    virtual void processOptions(const Options& options);
+    virtual void initialize();
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void ready(PointTableRef table);
+    virtual point_count_t read(PointViewPtr view, point_count_t count);
+
+    // Open the file and return its schema.
+    virtual std::shared_ptr<arrow::Schema> openFile() = 0;
+    // Start reading batches from the first.
+    virtual void rewind() = 0;
+    // The next batch, or null once all have been read.
+    virtual std::shared_ptr<arrow::RecordBatch> nextBatch() = 0;
+
+    bool inBounds(int64_t row) const;
+
+    ArrowReaderBase& operator=(const ArrowReaderBase&); // not implemented
+    ArrowReaderBase(const ArrowReaderBase&); // not implemented
+};
+
+} // namespace pdal
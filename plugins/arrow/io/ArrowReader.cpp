@@ -0,0 +1,76 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include "ArrowReader.hpp"
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "readers.arrow",
+    "Arrow IPC (Feather) reader",
+    "http://pdal.io/stages/readers.arrow.html" );
+
+CREATE_SHARED_PLUGIN(1, 0, ArrowReader, Reader, s_info)
+
+std::string ArrowReader::getName() const { return s_info.name; }
+
+using namespace arrowsupport;
+
+std::shared_ptr<arrow::Schema> ArrowReader::openFile()
+{
+    m_file = check(arrow::io::ReadableFile::Open(m_filename),
+        getName() + ": Unable to open '" + m_filename + "'");
+    m_reader = check(arrow::ipc::RecordBatchFileReader::Open(m_file),
+        getName() + ": Unable to read '" + m_filename + "'");
+    return m_reader->schema();
+}
+
+
+void ArrowReader::rewind()
+{
+    m_nextBatch = 0;
+}
+
+
+std::shared_ptr<arrow::RecordBatch> ArrowReader::nextBatch()
+{
+    if (m_nextBatch >= m_reader->num_record_batches())
+        return std::shared_ptr<arrow::RecordBatch>();
+    return check(m_reader->ReadRecordBatch(m_nextBatch++),
+        getName() + ": Unable to read '" + m_filename + "'");
+}
+
+} // namespace pdal
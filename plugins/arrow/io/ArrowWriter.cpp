@@ -0,0 +1,115 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include "ArrowWriter.hpp"
+
+#include <pdal/Options.hpp>
+
+#include <arrow/util/compression.h>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "writers.arrow",
+    "Arrow IPC (Feather) writer",
+    "http://pdal.io/stages/writers.arrow.html" );
+
+CREATE_SHARED_PLUGIN(1, 0, ArrowWriter, Writer, s_info)
+
+std::string ArrowWriter::getName() const { return s_info.name; }
+
+using namespace arrowsupport;
+
+Options ArrowWriter::getDefaultOptions()
+{
+    Options options;
+    options.add("batch_size", 65536, "Points in each record batch");
+    options.add("compression", "none",
+        "Compression of the columns: none, lz4 or zstd");
+    return options;
+}
+
+
+void ArrowWriter::processOptions(const Options& options)
+{
+    m_batchSize = options.getValueOrDefault<point_count_t>("batch_size",
+        65536);
+    if (m_batchSize == 0)
+        throw pdal_error(getName() + ": Option 'batch_size' must be greater "
+            "than 0.");
+    setCompression(options.getValueOrDefault<std::string>("compression",
+        "none"));
+    if (m_compression != arrow::Compression::UNCOMPRESSED &&
+        m_compression != arrow::Compression::LZ4_FRAME &&
+        m_compression != arrow::Compression::ZSTD)
+        throw pdal_error(getName() + ": Arrow files can only be compressed "
+            "with lz4 or zstd.");
+}
+
+
+void ArrowWriter::openFile(std::shared_ptr<arrow::Schema> schema)
+{
+    m_file = check(arrow::io::FileOutputStream::Open(m_filename),
+        getName() + ": Unable to open '" + m_filename + "'");
+
+    arrow::ipc::IpcWriteOptions options =
+        arrow::ipc::IpcWriteOptions::Defaults();
+    if (m_compression != arrow::Compression::UNCOMPRESSED)
+        options.codec = check(arrow::util::Codec::Create(m_compression),
+            getName() + ": Unable to create codec");
+    m_writer = check(arrow::ipc::MakeFileWriter(m_file, schema, options),
+        getName() + ": Unable to write '" + m_filename + "'");
+}
+
+
+void ArrowWriter::writeBatch(std::shared_ptr<arrow::RecordBatch> batch)
+{
+    check(m_writer->WriteRecordBatch(*batch),
+        getName() + ": Unable to write '" + m_filename + "'");
+}
+
+
+void ArrowWriter::closeFile()
+{
+    check(m_writer->Close(),
+        getName() + ": Unable to write '" + m_filename + "'");
+    check(m_file->Close(),
+        getName() + ": Unable to close '" + m_filename + "'");
+    m_writer.reset();
+    m_file.reset();
+}
+
+} // namespace pdal
@@ -0,0 +1,76 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#pragma once
+
+#include "ArrowCommon.hpp"
+
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+
+#include <memory>
+#include <string>
+
+namespace pdal
+{
+
+// Writes the points to an Arrow IPC file (Feather version 2), a record
+// batch of columns for every 'batch_size' points.
+class PDAL_DLL ArrowWriter : public ArrowWriterBase
+{
+public:
+    ArrowWriter()
+        {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+    Options getDefaultOptions();
+
+private:
+    std::shared_ptr<arrow::io::FileOutputStream> m_file;
+    std::shared_ptr<arrow::ipc::RecordBatchWriter> m_writer;
+
+    virtual void processOptions(const Options& options);
+    virtual void openFile(std::shared_ptr<arrow::Schema> schema);
+    virtual void writeBatch(std::shared_ptr<arrow::RecordBatch> batch);
+    virtual void closeFile();
+
+    ArrowWriter& operator=(const ArrowWriter&); // not implemented
+    ArrowWriter(const ArrowWriter&); // not implemented
+};
+
+} // namespace pdal
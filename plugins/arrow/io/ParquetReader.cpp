@@ -0,0 +1,168 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include "ParquetReader.hpp"
+
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/statistics.h>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "readers.parquet",
+    "Parquet reader",
+    "http://pdal.io/stages/readers.parquet.html" );
+
+CREATE_SHARED_PLUGIN(1, 0, ParquetReader, Reader, s_info)
+
+std::string ParquetReader::getName() const { return s_info.name; }
+
+using namespace arrowsupport;
+
+namespace
+{
+
+// Range of the values of a column chunk, if its statistics hold one.
+bool chunkRange(const parquet::RowGroupMetaData& rowGroup, int column,
+    double& low, double& high)
+{
+    std::shared_ptr<parquet::Statistics> stats =
+        rowGroup.ColumnChunk(column)->statistics();
+    if (!stats || !stats->HasMinMax())
+        return false;
+
+    switch (stats->physical_type())
+    {
+    case parquet::Type::DOUBLE:
+    {
+        auto s = std::static_pointer_cast<parquet::DoubleStatistics>(stats);
+        low = s->min();
+        high = s->max();
+        return true;
+    }
+    case parquet::Type::FLOAT:
+    {
+        auto s = std::static_pointer_cast<parquet::FloatStatistics>(stats);
+        low = s->min();
+        high = s->max();
+        return true;
+    }
+    default:
+        // Integer statistics may be ordered as unsigned or signed, so
+        // they aren't relied on.
+        return false;
+    }
+}
+
+} // unnamed namespace
+
+
+std::shared_ptr<arrow::Schema> ParquetReader::openFile()
+{
+    m_file = check(arrow::io::ReadableFile::Open(m_filename),
+        getName() + ": Unable to open '" + m_filename + "'");
+
+    parquet::arrow::FileReaderBuilder builder;
+    check(builder.Open(m_file), getName() + ": Unable to read '" +
+        m_filename + "'");
+    check(builder.Build(&m_reader), getName() + ": Unable to read '" +
+        m_filename + "'");
+
+    std::shared_ptr<arrow::Schema> schema;
+    check(m_reader->GetSchema(&schema), getName() + ": Unable to read "
+        "the schema of '" + m_filename + "'");
+    return schema;
+}
+
+
+void ParquetReader::rewind()
+{
+    m_nextRowGroup = 0;
+    m_batches.clear();
+}
+
+
+// Whether the statistics of row group 'rowGroup' allow for points inside
+// the bounds.  The columns of the file's schema are flat, so the index of
+// a column in the schema is that of its chunk in each row group.
+bool ParquetReader::overlaps(int rowGroup) const
+{
+    std::unique_ptr<parquet::RowGroupMetaData> meta =
+        m_reader->parquet_reader()->metadata()->RowGroup(rowGroup);
+
+    double low;
+    double high;
+    if (chunkRange(*meta, m_xColumn, low, high) &&
+        (high < m_bounds.minx || low > m_bounds.maxx))
+        return false;
+    if (chunkRange(*meta, m_yColumn, low, high) &&
+        (high < m_bounds.miny || low > m_bounds.maxy))
+        return false;
+    if (!m_bounds.is_z_empty() &&
+        chunkRange(*meta, m_zColumn, low, high) &&
+        (high < m_bounds.minz || low > m_bounds.maxz))
+        return false;
+    return true;
+}
+
+
+std::shared_ptr<arrow::RecordBatch> ParquetReader::nextBatch()
+{
+    while (m_batches.empty())
+    {
+        if (m_nextRowGroup >= m_reader->num_row_groups())
+            return std::shared_ptr<arrow::RecordBatch>();
+
+        int rowGroup = m_nextRowGroup++;
+        if (!m_bounds.empty() && !overlaps(rowGroup))
+            continue;
+
+        std::shared_ptr<arrow::Table> table;
+        check(m_reader->ReadRowGroup(rowGroup, &table), getName() +
+            ": Unable to read '" + m_filename + "'");
+        arrow::TableBatchReader batches(table);
+        for (auto& batch : check(batches.ToRecordBatches(), getName() +
+                ": Unable to read '" + m_filename + "'"))
+            m_batches.push_back(batch);
+    }
+
+    std::shared_ptr<arrow::RecordBatch> batch = m_batches.front();
+    m_batches.pop_front();
+    return batch;
+}
+
+} // namespace pdal
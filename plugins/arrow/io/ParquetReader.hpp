@@ -0,0 +1,80 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#pragma once
+
+#include "ArrowCommon.hpp"
+
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+
+namespace pdal
+{
+
+// Reads points from a Parquet file, such as one written by
+// writers.parquet.  When reading points inside bounds, row groups whose
+// X, Y or Z statistics show they hold no such points aren't read.
+class PDAL_DLL ParquetReader : public ArrowReaderBase
+{
+public:
+    ParquetReader() : m_nextRowGroup(0)
+        {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+private:
+    std::shared_ptr<arrow::io::ReadableFile> m_file;
+    std::unique_ptr<parquet::arrow::FileReader> m_reader;
+    int m_nextRowGroup;
+    // Batches of the row group being read.
+    std::deque<std::shared_ptr<arrow::RecordBatch>> m_batches;
+
+    virtual std::shared_ptr<arrow::Schema> openFile();
+    virtual void rewind();
+    virtual std::shared_ptr<arrow::RecordBatch> nextBatch();
+
+    bool overlaps(int rowGroup) const;
+
+    ParquetReader& operator=(const ParquetReader&); // not implemented
+    ParquetReader(const ParquetReader&); // not implemented
+};
+
+} // namespace pdal
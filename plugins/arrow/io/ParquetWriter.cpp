@@ -0,0 +1,118 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include "ParquetWriter.hpp"
+
+#include <pdal/Options.hpp>
+
+#include <parquet/properties.h>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "writers.parquet",
+    "Parquet writer",
+    "http://pdal.io/stages/writers.parquet.html" );
+
+CREATE_SHARED_PLUGIN(1, 0, ParquetWriter, Writer, s_info)
+
+std::string ParquetWriter::getName() const { return s_info.name; }
+
+using namespace arrowsupport;
+
+Options ParquetWriter::getDefaultOptions()
+{
+    Options options;
+    options.add("row_group_size", 1048576, "Points in each row group");
+    options.add("compression", "snappy", "Compression of the columns: "
+        "none, snappy, gzip, brotli, lz4 or zstd");
+    return options;
+}
+
+
+void ParquetWriter::processOptions(const Options& options)
+{
+    m_batchSize = options.getValueOrDefault<point_count_t>("row_group_size",
+        1048576);
+    if (m_batchSize == 0)
+        throw pdal_error(getName() + ": Option 'row_group_size' must be "
+            "greater than 0.");
+    setCompression(options.getValueOrDefault<std::string>("compression",
+        "snappy"));
+}
+
+
+void ParquetWriter::openFile(std::shared_ptr<arrow::Schema> schema)
+{
+    m_schema = schema;
+    m_file = check(arrow::io::FileOutputStream::Open(m_filename),
+        getName() + ": Unable to open '" + m_filename + "'");
+
+    parquet::WriterProperties::Builder builder;
+    builder.compression(m_compression);
+    builder.enable_statistics();
+    builder.max_row_group_length(m_batchSize);
+    parquet::ArrowWriterProperties::Builder arrowBuilder;
+    arrowBuilder.store_schema();
+    m_writer = check(parquet::arrow::FileWriter::Open(*schema,
+        arrow::default_memory_pool(), m_file, builder.build(),
+        arrowBuilder.build()),
+        getName() + ": Unable to write '" + m_filename + "'");
+}
+
+
+// Each batch is written as a row group of its own.
+void ParquetWriter::writeBatch(std::shared_ptr<arrow::RecordBatch> batch)
+{
+    std::shared_ptr<arrow::Table> table =
+        check(arrow::Table::FromRecordBatches(m_schema, { batch }),
+            getName() + ": Unable to write '" + m_filename + "'");
+    check(m_writer->WriteTable(*table, m_batchSize),
+        getName() + ": Unable to write '" + m_filename + "'");
+}
+
+
+void ParquetWriter::closeFile()
+{
+    check(m_writer->Close(),
+        getName() + ": Unable to write '" + m_filename + "'");
+    check(m_file->Close(),
+        getName() + ": Unable to close '" + m_filename + "'");
+    m_writer.reset();
+    m_file.reset();
+}
+
+} // namespace pdal
@@ -0,0 +1,79 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#pragma once
+
+#include "ArrowCommon.hpp"
+
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+
+#include <memory>
+#include <string>
+
+namespace pdal
+{
+
+// Writes the points to a Parquet file, a row group for every
+// 'row_group_size' points.  Each column chunk is compressed and carries
+// the minimum and maximum of its values, which readers.parquet uses to
+// skip row groups outside the bounds it's asked for.
+class PDAL_DLL ParquetWriter : public ArrowWriterBase
+{
+public:
+    ParquetWriter()
+        {}
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+    Options getDefaultOptions();
+
+private:
+    std::shared_ptr<arrow::io::FileOutputStream> m_file;
+    std::unique_ptr<parquet::arrow::FileWriter> m_writer;
+    std::shared_ptr<arrow::Schema> m_schema;
+
+    virtual void processOptions(const Options& options);
+    virtual void openFile(std::shared_ptr<arrow::Schema> schema);
+    virtual void writeBatch(std::shared_ptr<arrow::RecordBatch> batch);
+    virtual void closeFile();
+
+    ParquetWriter& operator=(const ParquetWriter&); // not implemented
+    ParquetWriter(const ParquetWriter&); // not implemented
+};
+
+} // namespace pdal
@@ -0,0 +1,241 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/Options.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/util/Bounds.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+Options fauxOptions(point_count_t count, const std::string& mode)
+{
+    Options options;
+    options.add("bounds", BOX3D(1.0, 2.0, 3.0, 101.0, 52.0, 13.0));
+    options.add("count", count);
+    options.add("mode", mode);
+    options.add("seed", 1234);
+    options.add("number_of_returns", 3);
+    return options;
+}
+
+PointViewPtr readFaux(PointTableRef table, point_count_t count,
+    const std::string& mode)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(fauxOptions(count, mode));
+    reader->prepare(table);
+    PointViewSet views = reader->execute(table);
+    return *views.begin();
+}
+
+void write(const std::string& driver, const Options& writerOptions,
+    point_count_t count, const std::string& mode)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(fauxOptions(count, mode));
+    std::unique_ptr<Stage> writer(f.createStage(driver));
+    writer->setOptions(writerOptions);
+    writer->setInput(*reader);
+
+    PointTable table;
+    writer->prepare(table);
+    writer->execute(table);
+}
+
+PointViewPtr read(PointTableRef table, const std::string& driver,
+    const Options& readerOptions)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage(driver));
+    reader->setOptions(readerOptions);
+    reader->prepare(table);
+    PointViewSet views = reader->execute(table);
+    EXPECT_EQ(views.size(), 1u);
+    return *views.begin();
+}
+
+// Write points from the faux reader and check that they read back the
+// same.
+void testRoundTrip(const std::string& format, const std::string& compression)
+{
+    const std::string filename(Support::temppath("arrowtest." + format));
+    FileUtils::deleteFile(filename);
+
+    Options wo;
+    wo.add("filename", filename);
+    wo.add("compression", compression);
+    wo.add(format == "parquet" ? "row_group_size" : "batch_size", 1000);
+    write("writers." + format, wo, 2500, "random");
+
+    PointTable inTable;
+    PointViewPtr in = readFaux(inTable, 2500, "random");
+
+    Options ro;
+    ro.add("filename", filename);
+    PointTable outTable;
+    PointViewPtr out = read(outTable, "readers." + format, ro);
+    ASSERT_EQ(out->size(), in->size());
+
+    PointLayoutPtr inLayout = inTable.layout();
+    PointLayoutPtr outLayout = outTable.layout();
+    for (const auto& dt : inLayout->dimTypes())
+    {
+        std::string name = inLayout->dimName(dt.m_id);
+        DimType outDt = outLayout->findDimType(name);
+        ASSERT_NE(outDt.m_id, Dimension::Id::Unknown) << name;
+        EXPECT_EQ(outDt.m_type, dt.m_type) << name;
+        for (PointId idx = 0; idx < in->size(); ++idx)
+            EXPECT_EQ(in->getFieldAs<double>(dt.m_id, idx),
+                out->getFieldAs<double>(outDt.m_id, idx)) << name;
+    }
+    FileUtils::deleteFile(filename);
+}
+
+} // unnamed namespace
+
+TEST(ArrowTest, roundTripArrow)
+{
+    testRoundTrip("arrow", "none");
+    testRoundTrip("arrow", "zstd");
+}
+
+TEST(ArrowTest, roundTripParquet)
+{
+    testRoundTrip("parquet", "none");
+    testRoundTrip("parquet", "snappy");
+}
+
+TEST(ArrowTest, outputDims)
+{
+    const std::string filename(Support::temppath("arrowtest.parquet"));
+    FileUtils::deleteFile(filename);
+
+    Options wo;
+    wo.add("filename", filename);
+    wo.add("output_dims", "X,Y,Z");
+    write("writers.parquet", wo, 100, "random");
+
+    Options ro;
+    ro.add("filename", filename);
+    PointTable table;
+    PointViewPtr view = read(table, "readers.parquet", ro);
+    EXPECT_EQ(view->size(), 100u);
+    EXPECT_EQ(table.layout()->dims().size(), 3u);
+    FileUtils::deleteFile(filename);
+}
+
+TEST(ArrowTest, stream)
+{
+    const std::string filename(Support::temppath("arrowtest.parquet"));
+    FileUtils::deleteFile(filename);
+
+    Options wo;
+    wo.add("filename", filename);
+    wo.add("row_group_size", 1000);
+
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(fauxOptions(2500, "random"));
+    std::unique_ptr<Stage> writer(f.createStage("writers.parquet"));
+    writer->setOptions(wo);
+    writer->setInput(*reader);
+
+    FixedPointTable table(100);
+    writer->prepare(table);
+    EXPECT_EQ(writer->executeStream(table), 2500u);
+
+    Options ro;
+    ro.add("filename", filename);
+    std::unique_ptr<Stage> parquet(f.createStage("readers.parquet"));
+    parquet->setOptions(ro);
+    std::unique_ptr<Stage> null(f.createStage("writers.null"));
+    null->setInput(*parquet);
+
+    FixedPointTable readTable(100);
+    null->prepare(readTable);
+    EXPECT_EQ(null->executeStream(readTable), 2500u);
+    FileUtils::deleteFile(filename);
+}
+
+// Points read inside bounds are those of the file inside them, whether or
+// not row groups are skipped.
+TEST(ArrowTest, bounds)
+{
+    BOX3D bounds(20.0, 10.0, 0.0, 50.0, 40.0, 20.0);
+
+    PointTable inTable;
+    PointViewPtr in = readFaux(inTable, 10000, "ramp");
+    point_count_t inside = 0;
+    for (PointId idx = 0; idx < in->size(); ++idx)
+        if (bounds.contains(in->getFieldAs<double>(Dimension::Id::X, idx),
+                in->getFieldAs<double>(Dimension::Id::Y, idx),
+                in->getFieldAs<double>(Dimension::Id::Z, idx)))
+            inside++;
+    EXPECT_TRUE(inside > 0);
+    EXPECT_TRUE(inside < in->size());
+
+    for (const std::string format : { "arrow", "parquet" })
+    {
+        const std::string filename(Support::temppath("arrowtest." +
+            format));
+        FileUtils::deleteFile(filename);
+
+        Options wo;
+        wo.add("filename", filename);
+        wo.add(format == "parquet" ? "row_group_size" : "batch_size", 500);
+        write("writers." + format, wo, 10000, "ramp");
+
+        Options ro;
+        ro.add("filename", filename);
+        ro.add("bounds", bounds);
+        PointTable table;
+        PointViewPtr view = read(table, "readers." + format, ro);
+        EXPECT_EQ(view->size(), inside) << format;
+        EXPECT_TRUE(bounds.contains(view->calculateBounds())) << format;
+        FileUtils::deleteFile(filename);
+    }
+}
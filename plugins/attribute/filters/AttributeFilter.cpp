@@ -34,13 +34,18 @@
 
 #include "AttributeFilter.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <pdal/GlobalEnvironment.hpp>
 #include <pdal/GDALUtils.hpp>
 
 #include <pdal/StageFactory.hpp>
-#include <pdal/QuadIndex.hpp>
+#include <pdal/KDIndex.hpp>
 
 #include <ogr_geometry.h>
 #include <geos_c.h>
@@ -87,6 +92,231 @@ struct OGRFeatureDeleter
     }
 };
 
+// Polygons rasterized into a grid of cells.  Each cell records the last
+// polygon that covers it completely and the polygons whose boundaries pass
+// through it.  Points in cells without boundaries are labelled directly;
+// the rest are tested exactly against the boundary polygons, last first,
+// so that, as when reading features, later polygons win.
+class LabelGrid
+{
+public:
+    LabelGrid(double resolution) : m_resolution(resolution), m_cols(0),
+        m_rows(0)
+    {}
+
+    // Add a polygon (or multipolygon) given as its rings of x/y pairs.
+    void add(std::vector<std::vector<double>>&& rings, int32_t value)
+    {
+        for (auto& r : rings)
+            for (size_t i = 0; i + 1 < r.size(); i += 2)
+                m_bounds.grow(r[i], r[i + 1]);
+        m_polys.push_back(Polygon{std::move(rings), value});
+    }
+
+    // Rasterize the polygons that have been added.
+    void build()
+    {
+        if (m_polys.empty())
+            return;
+        double cols = std::floor((m_bounds.maxx - m_bounds.minx) /
+            m_resolution) + 1;
+        double rows = std::floor((m_bounds.maxy - m_bounds.miny) /
+            m_resolution) + 1;
+        if (cols * rows > (double)(1 << 27))
+        {
+            std::ostringstream oss;
+            oss << "filters.attribute: Resolution " << m_resolution <<
+                " gives a grid of " << cols * rows << " cells.";
+            throw pdal_error(oss.str());
+        }
+        m_cols = (size_t)cols;
+        m_rows = (size_t)rows;
+        m_interior.assign(m_cols * m_rows, 0);
+        for (uint32_t p = 0; p < m_polys.size(); ++p)
+            rasterize(p);
+
+        // A polygon that covers the whole cell hides those before it.
+        for (auto& b : m_boundary)
+        {
+            std::vector<uint32_t>& polys = b.second;
+            uint32_t interior = m_interior[b.first];
+            polys.erase(std::remove_if(polys.begin(), polys.end(),
+                [interior](uint32_t p){ return p + 1 < interior; }),
+                polys.end());
+            std::reverse(polys.begin(), polys.end());
+        }
+    }
+
+    // Find the value of the last polygon containing (x, y).
+    bool lookup(double x, double y, int32_t& value) const
+    {
+        if (m_interior.empty())
+            return false;
+        double c = std::floor((x - m_bounds.minx) / m_resolution);
+        double r = std::floor((y - m_bounds.miny) / m_resolution);
+        if (c < 0 || r < 0 || c >= m_cols || r >= m_rows)
+            return false;
+        size_t cell = (size_t)r * m_cols + (size_t)c;
+
+        auto bi = m_boundary.find(cell);
+        if (bi != m_boundary.end())
+            for (uint32_t p : bi->second)
+                if (contains(m_polys[p], x, y))
+                {
+                    value = m_polys[p].m_value;
+                    return true;
+                }
+        uint32_t interior = m_interior[cell];
+        if (!interior)
+            return false;
+        value = m_polys[interior - 1].m_value;
+        return true;
+    }
+
+private:
+    struct Polygon
+    {
+        std::vector<std::vector<double>> m_rings;
+        int32_t m_value;
+    };
+
+    double m_resolution;
+    BOX3D m_bounds;
+    size_t m_cols;
+    size_t m_rows;
+    std::vector<Polygon> m_polys;
+    // Index + 1 of the last polygon covering each cell, or 0.
+    std::vector<uint32_t> m_interior;
+    std::unordered_map<size_t, std::vector<uint32_t>> m_boundary;
+
+    // Even-odd test of a point against all the rings of a polygon.
+    static bool contains(const Polygon& poly, double x, double y)
+    {
+        bool inside = false;
+        for (auto& r : poly.m_rings)
+        {
+            size_t n = r.size() / 2;
+            for (size_t i = 0, j = n - 1; i < n; j = i++)
+            {
+                double xi = r[2 * i];
+                double yi = r[2 * i + 1];
+                double xj = r[2 * j];
+                double yj = r[2 * j + 1];
+                if ((yi > y) != (yj > y) &&
+                    x < (xj - xi) * (y - yi) / (yj - yi) + xi)
+                    inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    // Range of cells that touch the closed interval [lo, hi], given in
+    // cell units, clamped to [0, count).
+    static std::pair<long, long> cellRange(double lo, double hi,
+        size_t count)
+    {
+        long first = (long)std::ceil(lo) - 1;
+        long last = (long)std::floor(hi);
+        first = (std::max)(first, 0L);
+        last = (std::min)(last, (long)count - 1);
+        return std::make_pair(first, last);
+    }
+
+    void rasterize(uint32_t p)
+    {
+        const Polygon& poly = m_polys[p];
+        const double ox = m_bounds.minx;
+        const double oy = m_bounds.miny;
+
+        // Every cell an edge passes through, found by clipping the edge
+        // to each row it spans.
+        std::vector<size_t> boundary;
+        double ymin = (std::numeric_limits<double>::max)();
+        double ymax = std::numeric_limits<double>::lowest();
+        for (auto& ring : poly.m_rings)
+        {
+            size_t n = ring.size() / 2;
+            for (size_t i = 0, j = n - 1; i < n; j = i++)
+            {
+                double x0 = (ring[2 * j] - ox) / m_resolution;
+                double y0 = (ring[2 * j + 1] - oy) / m_resolution;
+                double x1 = (ring[2 * i] - ox) / m_resolution;
+                double y1 = (ring[2 * i + 1] - oy) / m_resolution;
+                ymin = (std::min)(ymin, y0);
+                ymax = (std::max)(ymax, y0);
+                if (y0 > y1)
+                {
+                    std::swap(x0, x1);
+                    std::swap(y0, y1);
+                }
+                auto rows = cellRange(y0, y1, m_rows);
+                for (long r = rows.first; r <= rows.second; ++r)
+                {
+                    double xa = x0;
+                    double xb = x1;
+                    if (y1 > y0)
+                    {
+                        double ya = (std::max)(y0, (double)r);
+                        double yb = (std::min)(y1, (double)(r + 1));
+                        xa = x0 + (x1 - x0) * (ya - y0) / (y1 - y0);
+                        xb = x0 + (x1 - x0) * (yb - y0) / (y1 - y0);
+                    }
+                    if (xa > xb)
+                        std::swap(xa, xb);
+                    auto cols = cellRange(xa, xb, m_cols);
+                    for (long c = cols.first; c <= cols.second; ++c)
+                        boundary.push_back(r * m_cols + c);
+                }
+            }
+        }
+        std::sort(boundary.begin(), boundary.end());
+        boundary.erase(std::unique(boundary.begin(), boundary.end()),
+            boundary.end());
+        for (size_t cell : boundary)
+            m_boundary[cell].push_back(p);
+
+        // Cells whose centers are inside and that no edge touches are
+        // covered.  Find the crossings of each row's center line.
+        std::vector<double> xs;
+        auto rows = cellRange(ymin, ymax, m_rows);
+        for (long r = rows.first; r <= rows.second; ++r)
+        {
+            double y = oy + (r + .5) * m_resolution;
+            xs.clear();
+            for (auto& ring : poly.m_rings)
+            {
+                size_t n = ring.size() / 2;
+                for (size_t i = 0, j = n - 1; i < n; j = i++)
+                {
+                    double xi = ring[2 * i];
+                    double yi = ring[2 * i + 1];
+                    double xj = ring[2 * j];
+                    double yj = ring[2 * j + 1];
+                    if ((yi > y) != (yj > y))
+                        xs.push_back((xj - xi) * (y - yi) / (yj - yi) + xi);
+                }
+            }
+            std::sort(xs.begin(), xs.end());
+            for (size_t i = 0; i + 1 < xs.size(); i += 2)
+            {
+                double lo = (xs[i] - ox) / m_resolution - .5;
+                double hi = (xs[i + 1] - ox) / m_resolution - .5;
+                long first = (std::max)((long)std::floor(lo) + 1, 0L);
+                long last = (std::min)((long)std::ceil(hi) - 1,
+                    (long)m_cols - 1);
+                for (long c = first; c <= last; ++c)
+                {
+                    size_t cell = r * m_cols + c;
+                    if (!std::binary_search(boundary.begin(),
+                            boundary.end(), cell))
+                        m_interior[cell] = p + 1;
+                }
+            }
+        }
+    }
+};
+
+
 void AttributeFilter::initialize()
 {
     GlobalEnvironment::get().initializeGDAL(log());
@@ -147,6 +377,15 @@ void AttributeFilter::processOptions(const Options& options)
             info.column = dimensionOptions->getValueOrDefault<std::string>("column",""); // take first column
             info.query = dimensionOptions->getValueOrDefault<std::string>("query","");
             info.layer = dimensionOptions->getValueOrDefault<std::string>("layer",""); // take first layer
+            info.resolution =
+                dimensionOptions->getValueOrDefault<double>("resolution", 0);
+            if (info.resolution < 0)
+            {
+                std::ostringstream oss;
+                oss << getName() << ": Resolution for dimension '" <<
+                    name << "' must be positive.";
+                throw pdal_error(oss.str());
+            }
 
         }
 
@@ -175,6 +414,8 @@ void AttributeFilter::ready(PointTableRef table)
                 throw pdal_error(oss.str());
             }
             dim_par.second.ds = ds;
+            if (dim_par.second.resolution > 0)
+                buildGrid(dim_par.second);
         }
 
     }
@@ -236,35 +477,38 @@ GEOSGeometry* createGEOSPoint(GEOSContextHandle_t ctx, double x, double y, doubl
     return p;
 }
 
-void AttributeFilter::UpdateGEOSBuffer(PointView& view, AttributeInfo& info)
+void AttributeFilter::openLayer(AttributeInfo& info)
 {
-    QuadIndex idx(view);
+    if (info.lyr) // the layer is awake
+        return;
 
-    if (!info.lyr) // wake up the layer
+    if (info.layer.size())
+        info.lyr = OGR_DS_GetLayerByName(info.ds.get(), info.layer.c_str());
+    else if (info.query.size())
     {
-        if (info.layer.size())
-            info.lyr = OGR_DS_GetLayerByName(info.ds.get(), info.layer.c_str());
-        else if (info.query.size())
-        {
-            info.lyr = OGR_DS_ExecuteSQL(info.ds.get(), info.query.c_str(), 0, 0);
-        }
-        else
-            info.lyr = OGR_DS_GetLayer(info.ds.get(), 0);
-        if (!info.lyr)
-        {
-            std::ostringstream oss;
-            oss << "Unable to select layer '" << info.layer << "'";
-            throw pdal_error(oss.str());
-        }
+        info.lyr = OGR_DS_ExecuteSQL(info.ds.get(), info.query.c_str(), 0, 0);
+    }
+    else
+        info.lyr = OGR_DS_GetLayer(info.ds.get(), 0);
+    if (!info.lyr)
+    {
+        std::ostringstream oss;
+        oss << "Unable to select layer '" << info.layer << "'";
+        throw pdal_error(oss.str());
     }
+}
 
-    OGRFeaturePtr feature = OGRFeaturePtr(OGR_L_GetNextFeature(info.lyr), OGRFeatureDeleter());
 
+namespace
+{
+
+int fieldIndex(OGRFeatureH feature, const AttributeInfo& info)
+{
     int field_index(1); // default to first column if nothing was set
-    if (info.column.size())
+    if (info.column.size() && feature)
     {
 
-        field_index = OGR_F_GetFieldIndex(feature.get(), info.column.c_str());
+        field_index = OGR_F_GetFieldIndex(feature, info.column.c_str());
         if (field_index == -1)
         {
             std::ostringstream oss;
@@ -272,21 +516,121 @@ void AttributeFilter::UpdateGEOSBuffer(PointView& view, AttributeInfo& info)
             throw pdal_error(oss.str());
         }
     }
+    return field_index;
+}
 
-    while(feature)
+
+OGRGeometryH checkedGeometry(OGRFeatureH feature)
+{
+    OGRGeometryH geom = OGR_F_GetGeometryRef(feature);
+    OGRwkbGeometryType t = OGR_G_GetGeometryType(geom);
+
+    if (!(t == wkbPolygon ||
+        t == wkbMultiPolygon ||
+        t == wkbPolygon25D ||
+        t == wkbMultiPolygon25D))
     {
-        OGRGeometryH geom = OGR_F_GetGeometryRef(feature.get());
-        OGRwkbGeometryType t = OGR_G_GetGeometryType(geom);
+        std::ostringstream oss;
+        oss << "Geometry is not Polygon or MultiPolygon!";
+        throw pdal::pdal_error(oss.str());
+    }
+    return geom;
+}
 
-        if (!(t == wkbPolygon ||
-            t == wkbMultiPolygon ||
-            t == wkbPolygon25D ||
-            t == wkbMultiPolygon25D))
+
+// Append the rings of a polygon as x/y pairs.
+void appendRings(OGRGeometryH poly, std::vector<std::vector<double>>& rings)
+{
+    for (int i = 0; i < OGR_G_GetGeometryCount(poly); ++i)
+    {
+        OGRGeometryH ring = OGR_G_GetGeometryRef(poly, i);
+        std::vector<double> xy;
+        int count = OGR_G_GetPointCount(ring);
+        xy.reserve(2 * count);
+        for (int j = 0; j < count; ++j)
         {
-            std::ostringstream oss;
-            oss << "Geometry is not Polygon or MultiPolygon!";
-            throw pdal::pdal_error(oss.str());
+            xy.push_back(OGR_G_GetX(ring, j));
+            xy.push_back(OGR_G_GetY(ring, j));
         }
+        rings.push_back(std::move(xy));
+    }
+}
+
+} // unnamed namespace
+
+
+void AttributeFilter::buildGrid(AttributeInfo& info)
+{
+    openLayer(info);
+    OGR_L_ResetReading(info.lyr);
+
+    info.grid.reset(new LabelGrid(info.resolution));
+    OGRFeaturePtr feature = OGRFeaturePtr(OGR_L_GetNextFeature(info.lyr),
+        OGRFeatureDeleter());
+    int field_index = fieldIndex(feature.get(), info);
+    while (feature)
+    {
+        OGRGeometryH geom = checkedGeometry(feature.get());
+
+        std::vector<std::vector<double>> rings;
+        if (wkbFlatten(OGR_G_GetGeometryType(geom)) == wkbMultiPolygon)
+            for (int i = 0; i < OGR_G_GetGeometryCount(geom); ++i)
+                appendRings(OGR_G_GetGeometryRef(geom, i), rings);
+        else
+            appendRings(geom, rings);
+        info.grid->add(std::move(rings),
+            OGR_F_GetFieldAsInteger(feature.get(), field_index));
+
+        feature = OGRFeaturePtr(OGR_L_GetNextFeature(info.lyr),
+            OGRFeatureDeleter());
+    }
+    info.grid->build();
+}
+
+
+void AttributeFilter::updateFromGrid(PointView& view, AttributeInfo& info)
+{
+    const LabelGrid& grid = *info.grid;
+    const Dimension::Id::Enum dim = info.dim;
+
+    auto label = [&view, &grid, dim](PointId first, PointId last)
+    {
+        const point_count_t batchSize = 4096;
+        std::vector<double> xs(batchSize);
+        std::vector<double> ys(batchSize);
+        for (PointId begin = first; begin < last; begin += batchSize)
+        {
+            point_count_t count = (std::min)(batchSize, last - begin);
+            view.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+            view.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+            for (PointId i = 0; i < count; ++i)
+            {
+                int32_t v;
+                if (grid.lookup(xs[i], ys[i], v))
+                    view.setField(dim, begin + i, v);
+            }
+        }
+    };
+    parallelFilter(view, label);
+}
+
+
+void AttributeFilter::UpdateGEOSBuffer(PointView& view, AttributeInfo& info)
+{
+    if (view.empty())
+        return;
+    // The view keeps its index, so other dimensions and later stages
+    // don't rebuild it.
+    const KDIndex& idx = view.spatialIndex(false);
+
+    openLayer(info);
+
+    OGRFeaturePtr feature = OGRFeaturePtr(OGR_L_GetNextFeature(info.lyr), OGRFeatureDeleter());
+
+    int field_index = fieldIndex(feature.get(), info);
+    while(feature)
+    {
+        OGRGeometryH geom = checkedGeometry(feature.get());
 
         OGRGeometry* ogr_g = (OGRGeometry*) geom;
         GEOSGeometry* geos_g (0);
@@ -306,16 +650,24 @@ void AttributeFilter::UpdateGEOSBuffer(PointView& view, AttributeInfo& info)
         if (!geos_pg)
             throw pdal_error("unable to prepare geometry for index-accelerated intersection");
 
-        // Compute a total bounds for the geometry. Query the QuadTree to
-        // find out the points that are inside the bbox. Then test each
-        // point in the bbox against the prepared geometry.
+        // Compute a total bounds for the geometry. Query the index for
+        // the points in the circle around the bbox and keep those inside
+        // the bbox. Then test each point in the bbox against the prepared
+        // geometry.
         BOX3D box = computeBounds(m_geosEnvironment, geos_g);
-        std::vector<PointId> ids = idx.getPoints(box);
+        const double cx = (box.minx + box.maxx) / 2;
+        const double cy = (box.miny + box.maxy) / 2;
+        const double rx = box.maxx - cx;
+        const double ry = box.maxy - cy;
+        // The index takes the square of the radius.
+        std::vector<size_t> ids = idx.radius(cx, cy, 0, rx * rx + ry * ry);
         for (const auto& i : ids)
         {
 
             double x = view.getFieldAs<double>(Dimension::Id::X, i);
             double y = view.getFieldAs<double>(Dimension::Id::Y, i);
+            if (x < box.minx || x > box.maxx || y < box.miny || y > box.maxy)
+                continue;
             double z = view.getFieldAs<double>(Dimension::Id::Z, i);
 
             GEOSGeometry* p = createGEOSPoint(m_geosEnvironment, x, y ,z);
@@ -341,7 +693,9 @@ void AttributeFilter::filter(PointView& view)
 
     for (auto& dim_par : m_dimensions)
     {
-        if (dim_par.second.isogr)
+        if (dim_par.second.grid)
+            updateFromGrid(view, dim_par.second);
+        else if (dim_par.second.isogr)
         {
             UpdateGEOSBuffer(view, dim_par.second);
         }  else
@@ -58,10 +58,13 @@ typedef std::shared_ptr<void> OGRDSPtr;
 typedef std::shared_ptr<void> OGRFeaturePtr;
 typedef std::shared_ptr<void> OGRGeometryPtr;
 
+class LabelGrid;
+typedef std::shared_ptr<LabelGrid> LabelGridPtr;
+
 class AttributeInfo
 {
 public:
-    AttributeInfo() : ds(0), lyr(0), isogr(true) {};
+    AttributeInfo() : ds(0), lyr(0), isogr(true), resolution(0) {};
 
     std::string connection;
     std::string column;
@@ -73,6 +76,10 @@ public:
     std::string value;
     bool isogr;
     Dimension::Id::Enum dim;
+    // Cell size of the grid into which the polygons are rasterized, or 0
+    // to query each polygon against an index of the points.
+    double resolution;
+    LabelGridPtr grid;
     AttributeInfo(const AttributeInfo& other)
         : connection(other.connection)
         , column(other.column)
@@ -83,7 +90,9 @@ public:
         , layer(other.layer)
         , value(other.value)
         , isogr(other.isogr)
-        , dim(other.dim) {};
+        , dim(other.dim)
+        , resolution(other.resolution)
+        , grid(other.grid) {};
     AttributeInfo& operator=(const AttributeInfo& other)
     {
         if (&other != this)
@@ -98,6 +107,8 @@ public:
             layer = other.layer;
             isogr = other.isogr;
             dim = other.dim;
+            resolution = other.resolution;
+            grid = other.grid;
         }
         return *this;
     }
@@ -134,6 +145,9 @@ private:
     GEOSContextHandle_t m_geosEnvironment;
     std::shared_ptr<pdal::gdal::Debug> m_gdal_debug;
     void UpdateGEOSBuffer(PointView& view, AttributeInfo& info);
+    void updateFromGrid(PointView& view, AttributeInfo& info);
+    void openLayer(AttributeInfo& info);
+    void buildGrid(AttributeInfo& info);
 
 };
 
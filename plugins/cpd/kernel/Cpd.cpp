@@ -35,7 +35,13 @@
 #include "kernel/Cpd.hpp"
 
 #include <pdal/BufferReader.hpp>
+#include <pdal/KDIndex.hpp>
 #include <pdal/KernelFactory.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
 
 #include "chipper/ChipperFilter.hpp"
 #include "crop/CropFilter.hpp"
@@ -60,6 +66,12 @@ void CpdKernel::validateSwitches()
         throw app_usage_error("--filey/-y required");
     if (m_output == "")
         throw app_usage_error("--output/-o required");
+    if (m_levels < 1)
+        throw app_usage_error("--levels must be at least 1");
+    if (m_voxel_size < 0)
+        throw app_usage_error("--voxel-size can't be negative");
+    if (m_voxel_size > 0 && m_chipped)
+        throw app_usage_error("--voxel-size can't be used with --chipped");
 }
 
 
@@ -107,6 +119,10 @@ void CpdKernel::addSwitches()
             "The width of the buffer around each chip")
         ("sigma2", po::value<float>(&m_sigma2)->default_value(DefaultSigma2),
             "The starting sigma2 value. To improve CPD runs, set to a bit more than you expect the average motion to be")
+        ("voxel-size", po::value<float>(&m_voxel_size)->default_value(0),
+            "Register points downsampled to voxels of this size, then apply the result to all points. Zero registers all points directly.")
+        ("levels", po::value<int>(&m_levels)->default_value(1),
+            "Number of coarse-to-fine levels when --voxel-size is set. Each coarser level doubles the voxel size and initializes the next finer one.")
         ;
 
     addSwitchSet(file_options);
@@ -236,18 +252,22 @@ int CpdKernel::execute()
     }
     else
     {
-        result = reg.run(X, Y);
+        arma::mat moved;
+        if (m_voxel_size > 0)
+            moved = multiresRegister(reg, X, Y);
+        else
+            moved = reg.run(X, Y)->Y;
         for (arma::uword i = 0; i < Y.n_rows; ++i)
         {
-            outView->setField<double>(Dimension::Id::X, i, result->Y(i, 0));
-            outView->setField<double>(Dimension::Id::Y, i, result->Y(i, 1));
-            outView->setField<double>(Dimension::Id::Z, i, result->Y(i, 2));
+            outView->setField<double>(Dimension::Id::X, i, moved(i, 0));
+            outView->setField<double>(Dimension::Id::Y, i, moved(i, 1));
+            outView->setField<double>(Dimension::Id::Z, i, moved(i, 2));
             outView->setField<double>(Dimension::Id::XVelocity, i,
-                Y(i, 0) - result->Y(i, 0));
+                Y(i, 0) - moved(i, 0));
             outView->setField<double>(Dimension::Id::YVelocity, i,
-                Y(i, 1) - result->Y(i, 1));
+                Y(i, 1) - moved(i, 1));
             outView->setField<double>(Dimension::Id::ZVelocity, i,
-                Y(i, 2) - result->Y(i, 2));
+                Y(i, 2) - moved(i, 2));
         }
     }
 
@@ -327,5 +347,118 @@ cpd::Registration::ResultPtr CpdKernel::chipThenRegister(
     return result;
 }
 
+
+// Replace the points of X with the centroid of the points in each voxel
+// of edge 'size'.  Voxels are output in the order in which they're first
+// touched.
+arma::mat voxelDownsample(const arma::mat& X, double size)
+{
+    const arma::rowvec minv = arma::min(X, 0);
+    const arma::rowvec maxv = arma::max(X, 0);
+    uint64_t ncols = (uint64_t)((maxv(0) - minv(0)) / size) + 1;
+    uint64_t nrows = (uint64_t)((maxv(1) - minv(1)) / size) + 1;
+
+    std::unordered_map<uint64_t, arma::uword> voxels;
+    std::vector<arma::uword> counts;
+    arma::mat sums(X.n_rows, 3, arma::fill::zeros);
+    for (arma::uword i = 0; i < X.n_rows; ++i)
+    {
+        uint64_t col = (uint64_t)((X(i, 0) - minv(0)) / size);
+        uint64_t row = (uint64_t)((X(i, 1) - minv(1)) / size);
+        uint64_t lvl = (uint64_t)((X(i, 2) - minv(2)) / size);
+        uint64_t key = (lvl * nrows + row) * ncols + col;
+
+        auto vi = voxels.insert(std::make_pair(key, counts.size()));
+        if (vi.second)
+            counts.push_back(0);
+        arma::uword v = vi.first->second;
+        sums.row(v) += X.row(i);
+        counts[v]++;
+    }
+
+    arma::mat out(counts.size(), 3);
+    for (arma::uword v = 0; v < counts.size(); ++v)
+        out.row(v) = sums.row(v) / (double)counts[v];
+    return out;
+}
+
+
+// Give each point of 'to' the displacement of its nearest point in 'from'.
+// The queries run in parallel, so this is cheap for the full point set.
+arma::mat interpolateDisplacement(const arma::mat& from,
+    const arma::mat& disp, const arma::mat& to)
+{
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+    PointView view(table);
+    for (arma::uword i = 0; i < from.n_rows; ++i)
+    {
+        view.setField(Dimension::Id::X, i, from(i, 0));
+        view.setField(Dimension::Id::Y, i, from(i, 1));
+        view.setField(Dimension::Id::Z, i, from(i, 2));
+    }
+    KDIndex index(view);
+    index.build();
+
+    arma::mat out(to.n_rows, 3);
+    ThreadPool::shared().parallelFor(to.n_rows, 4096,
+        [&](std::size_t begin, std::size_t end)
+        {
+            std::vector<PointId> ids;
+            std::vector<double> sqrDists;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                index.neighbors(to(i, 0), to(i, 1), to(i, 2), 1, ids,
+                    sqrDists);
+                out.row(i) = disp.row(ids[0]);
+            }
+        });
+    return out;
+}
+
+
+// Register downsampled copies of X and Y, coarsest first.  Each level
+// starts from Y moved by the displacements found at the level before, and
+// the displacements of the finest level are applied to all of Y.
+arma::mat CpdKernel::multiresRegister(const cpd::NonrigidLowrank& reg,
+    const arma::mat& X, const arma::mat& Y)
+{
+    arma::mat prevY;
+    arma::mat disp;
+    for (int level = m_levels - 1; level >= 0; --level)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        double size = m_voxel_size * std::pow(2.0, level);
+        arma::mat Xl = voxelDownsample(X, size);
+        arma::mat Yl = voxelDownsample(Y, size);
+        arma::mat Yinit(Yl);
+        if (!prevY.is_empty())
+            Yinit += interpolateDisplacement(prevY, disp, Yl);
+
+        cpd::Registration::ResultPtr result = reg.run(Xl, Yinit);
+        disp = result->Y - Yl;
+        prevY = Yl;
+
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        std::cerr << "Level " << (m_levels - level) << " of " << m_levels <<
+            " (voxel size " << size << "): " << Xl.n_rows << " x " <<
+            Yl.n_rows << " points in " << elapsed.count() << "s" <<
+            std::endl;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    arma::mat moved = Y + interpolateDisplacement(prevY, disp, Y);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cerr << "Applied to " << Y.n_rows << " points in " <<
+        elapsed.count() << "s" << std::endl;
+    return moved;
+}
+
 } // namespace pdal
 
@@ -60,6 +60,8 @@ private:
     cpd::Registration::ResultPtr chipThenRegister(
         const cpd::NonrigidLowrank& reg, const arma::mat& X, const arma::mat& Y,
         const PointViewPtr& bufX, const PointTableRef table);
+    arma::mat multiresRegister(const cpd::NonrigidLowrank& reg,
+        const arma::mat& X, const arma::mat& Y);
 
     std::string m_filex;
     std::string m_filey;
@@ -79,6 +81,8 @@ private:
     int m_chip_capacity;
     float m_chip_buffer;
     float m_sigma2;
+    int m_levels;
+    float m_voxel_size;
 };
 
 } // namespace pdal
@@ -38,6 +38,7 @@
 #include <pdal/KernelFactory.hpp>
 #include <pdal/Filter.hpp>
 #include <pdal/Reader.hpp>
+#include <pdal/StageFactory.hpp>
 #include "Support.hpp"
 
 
@@ -122,5 +123,42 @@ TEST_F(CpdKernelTest, Execution)
 }
 
 
+TEST_F(CpdKernelTest, Multires)
+{
+    KernelFactory f;
+    std::unique_ptr<Kernel> cpdKernel = f.createKernel("kernels.cpd");
+
+    int argc = 11;
+    const char * argv[11] = {
+        "cpd",
+        "-x",
+        m_x.c_str(),
+        "-y",
+        m_y.c_str(),
+        "-o",
+        m_outfile.c_str(),
+        "--voxel-size",
+        "10",
+        "--levels",
+        "2"
+    };
+
+    int retval = cpdKernel->run(argc, argv, "cpd");
+    EXPECT_EQ(0, retval);
+
+    // Every point of the full cloud is written, not just the voxels.
+    Options ops;
+    ops.add("filename", m_outfile);
+    StageFactory sf;
+    std::unique_ptr<Stage> reader(sf.createStage("readers.las"));
+    reader->setOptions(ops);
+    PointTable table;
+    reader->prepare(table);
+    PointViewSet viewSet = reader->execute(table);
+    ASSERT_EQ(1u, viewSet.size());
+    EXPECT_EQ(1065u, (*viewSet.begin())->size());
+}
+
+
 } // namespace pdal
 
@@ -233,6 +233,9 @@ namespace pdal
 
     void GeoWaveReader::ready(PointTableRef table)
     {
+        m_fields.clear();
+        m_fieldsResolved = false;
+
         if (m_bounds.empty())
             return;
 
@@ -274,9 +277,6 @@ namespace pdal
 
     point_count_t GeoWaveReader::read(PointViewPtr view, point_count_t count)
     {
-        using namespace Dimension;
-
-        String location = java_new<String>("location");
         point_count_t numRead = 0;
 
         if (m_useFeatCollDataAdapter)
@@ -289,16 +289,7 @@ namespace pdal
                 while (featItr.hasNext() && count-- > 0)
                 {
                     SimpleFeature simpleFeature = java_cast<SimpleFeature>(featItr.next());
-                    List attribs = simpleFeature.getType().getAttributeDescriptors();
-
-                    Coordinate coord = java_cast<Point>(simpleFeature.getAttribute(location)).getCoordinate();
-
-                    for (int i = 0; i < attribs.size(); ++i){
-                        String name = java_cast<AttributeDescriptor>(attribs.get(i)).getLocalName();
-
-                        if (!name.equals(location))
-                            view->setField(id(name), numRead, java_cast<Double>(simpleFeature.getAttribute(name)).doubleValue());
-                    }
+                    readFeature(*view, simpleFeature, numRead);
 
                     if (m_cb)
                         m_cb(*view, numRead);
@@ -312,16 +303,7 @@ namespace pdal
         {
             while (m_iterator.hasNext() && count-- > 0){
                 SimpleFeature simpleFeature = java_cast<SimpleFeature>(m_iterator.next());
-                List attribs = simpleFeature.getType().getAttributeDescriptors();
-
-                Coordinate coord = java_cast<Point>(simpleFeature.getAttribute(location)).getCoordinate();
-
-                for (int i = 0; i < attribs.size(); ++i){
-                    String name = java_cast<AttributeDescriptor>(attribs.get(i)).getLocalName();
-
-                    if (!name.equals(location))
-                        view->setField(id(name), numRead, java_cast<Double>(simpleFeature.getAttribute(name)).doubleValue());
-                }
+                readFeature(*view, simpleFeature, numRead);
 
                 if (m_cb)
                     m_cb(*view, numRead);
@@ -333,6 +315,28 @@ namespace pdal
         return numRead;
     }
 
+    // Every call through a proxy crosses into the JVM.  The features of a
+    // query share a type, so the attributes are looked up by name once and
+    // then fetched by index, which takes two calls per value instead of the
+    // several needed to find an attribute by name.
+    void GeoWaveReader::readFeature(PointView& view, SimpleFeature& feature, PointId idx)
+    {
+        if (!m_fieldsResolved)
+        {
+            List attribs = feature.getType().getAttributeDescriptors();
+            for (int i = 0; i < attribs.size(); ++i)
+            {
+                std::string name = java_cast<AttributeDescriptor>(attribs.get(i)).getLocalName();
+                if (name.compare("location") != 0)
+                    m_fields.push_back(std::make_pair(i, Dimension::id(name)));
+            }
+            m_fieldsResolved = true;
+        }
+
+        for (auto fi = m_fields.begin(); fi != m_fields.end(); ++fi)
+            view.setField(fi->second, idx, java_cast<Double>(feature.getAttribute(JInt(fi->first))).doubleValue());
+    }
+
     void GeoWaveReader::done(PointTableRef table)
     {
         m_iterator.close();
@@ -42,8 +42,13 @@
 #include <geos_c.h>
 #endif
 
+#include <utility>
+#include <vector>
+
 #include "jace/proxy/mil/nga/giat/geowave/store/CloseableIterator.h"
 using jace::proxy::mil::nga::giat::geowave::store::CloseableIterator;
+#include "jace/proxy/org/opengis/feature/simple/SimpleFeature.h"
+using jace::proxy::org::opengis::feature::simple::SimpleFeature;
 
 extern "C" int32_t GeoWaveReader_ExitFunc();
 extern "C" PF_ExitFunc GeoWaveReader_InitPlugin();
@@ -71,6 +76,7 @@ namespace pdal
 
 	Dimension::IdList getDefaultDimensions();
         int createJvm();
+        void readFeature(PointView& view, SimpleFeature& feature, PointId idx);
 
         std::string m_zookeeperUrl;
         std::string m_instanceName;
@@ -84,6 +90,10 @@ namespace pdal
         BOX3D m_bounds;
 
         CloseableIterator m_iterator;
+
+        // Index of each attribute read and the dimension it's read into.
+        std::vector<std::pair<int, Dimension::Id::Enum>> m_fields;
+        bool m_fieldsResolved;
     };
 
 } // namespace pdal
@@ -261,6 +261,15 @@ namespace pdal
             UUID::randomUUID().toString(),
             TYPE);
 
+        // Every call through a proxy crosses into the JVM, so the attribute
+        // names are made once, and each feature is named after a single
+        // UUID for the view rather than asking Java for a UUID per point.
+        std::vector<std::pair<String, Id::Enum>> fields;
+        for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
+            if (view->hasDim(*di))
+                fields.push_back(std::make_pair(java_new<String>(view->dimName(*di)), *di));
+        const std::string featurePrefix = UUID::randomUUID().toString() + "-";
+
         for (PointId idx = 0; idx < view->size(); ++idx)
         {
             JDouble X = view->getFieldAs<double>(Id::X, idx);
@@ -273,11 +282,10 @@ namespace pdal
 
             builder.set(location, point);
 
-            for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
-                if (view->hasDim(*di))
-                    builder.set(java_new<String>(view->dimName(*di)), java_new<Double>(view->getFieldAs<double>(*di, idx)));
+            for (auto fi = fields.begin(); fi != fields.end(); ++fi)
+                builder.set(fi->first, java_new<Double>(view->getFieldAs<double>(fi->second, idx)));
 
-            SimpleFeature feature = builder.buildFeature(UUID::randomUUID().toString());
+            SimpleFeature feature = builder.buildFeature(java_new<String>(featurePrefix + std::to_string(idx)));
 
             if (m_useFeatCollDataAdapter)
                 featureCollection.add(feature);
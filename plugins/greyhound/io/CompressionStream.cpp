@@ -6,6 +6,7 @@
 CompressionStream::CompressionStream()
     : m_data()
     , m_index(0)
+    , m_aborted(false)
     , m_mutex()
     , m_cv()
 { }
@@ -26,7 +27,11 @@ uint8_t CompressionStream::getByte()
 {
     // Make sure we have enough data to hand out before continuing.
     std::unique_lock<std::mutex> lock(m_mutex);
-    m_cv.wait(lock, [this]()->bool { return m_index < m_data.size(); });
+    m_cv.wait(lock, [this]()->bool {
+        return m_index < m_data.size() || m_aborted;
+    });
+    if (m_index >= m_data.size())
+        throw std::runtime_error("Compressed stream ended early");
     return m_data.at(m_index++);
 }
 
@@ -36,10 +41,20 @@ void CompressionStream::getBytes(uint8_t* bytes, std::size_t length)
 
     // Make sure we have enough data to hand out before continuing.
     m_cv.wait(lock, [this, length]()->bool {
-        return m_index + length <= m_data.size();
+        return m_index + length <= m_data.size() || m_aborted;
     });
+    if (m_index + length > m_data.size())
+        throw std::runtime_error("Compressed stream ended early");
 
     std::memcpy(bytes, m_data.data() + m_index, length);
     m_index += length;
 }
 
+void CompressionStream::abort()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_aborted = true;
+    lock.unlock();
+    m_cv.notify_all();
+}
+
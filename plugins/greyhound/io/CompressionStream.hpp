@@ -13,13 +13,18 @@ public:
     // Called by us as we receive data.
     void putBytes(const uint8_t* bytes, std::size_t length);
 
-    // Called by laz-perf as it decompresses.
+    // Called by laz-perf as it decompresses.  These throw once the stream
+    // is aborted and they're asked for bytes that won't arrive.
     uint8_t getByte();
     void getBytes(uint8_t* bytes, std::size_t length);
 
+    // No more bytes will be put.
+    void abort();
+
 private:
     std::vector<uint8_t> m_data;
     std::size_t m_index;
+    bool m_aborted;
 
     std::mutex m_mutex;
     std::condition_variable m_cv;
@@ -32,6 +32,8 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <algorithm>
+
 #include <pdal/pdal_error.hpp>
 
 #include "Exchanges.hpp"
@@ -203,21 +205,23 @@ std::vector<DimData> GetSchema::schema() const
 // Read exchange
 
 Read::Read(
-        PointViewPtr view,
         const PointLayoutPtr layout,
         const std::string& sessionId,
         bool compress,
         int offset,
         int count)
     : Exchange("read")
-    , m_view(view)
     , m_layout(layout)
     , m_initialized(false)
     , m_error(false)
+    , m_record(false)
     , m_pointsToRead(0)
     , m_numBytes(0)
     , m_numBytesReceived(0)
     , m_data()
+    , m_raw()
+    , m_spans()
+    , m_destSize(0)
 {
     m_req["session"] = sessionId;
     m_req["compress"] = compress;
@@ -225,6 +229,32 @@ Read::Read(
     if (count != -1) m_req["count"] = count;
 }
 
+void Read::query(
+        const BOX3D& bounds,
+        const uint32_t depthBegin,
+        const uint32_t depthEnd)
+{
+    m_req.removeMember("start");
+    m_req.removeMember("count");
+
+    if (!bounds.empty())
+    {
+        Json::Value& jsonBounds(m_req["bounds"]);
+        jsonBounds.append(bounds.minx);
+        jsonBounds.append(bounds.miny);
+        if (!bounds.is_z_empty())
+            jsonBounds.append(bounds.minz);
+        jsonBounds.append(bounds.maxx);
+        jsonBounds.append(bounds.maxy);
+        if (!bounds.is_z_empty())
+            jsonBounds.append(bounds.maxz);
+    }
+
+    m_req["depthBegin"] = depthBegin;
+    if (depthEnd)
+        m_req["depthEnd"] = depthEnd;
+}
+
 bool Read::check()
 {
     bool valid(false);
@@ -240,38 +270,77 @@ bool Read::check()
             jsonResponse.isMember("numBytes") &&
             jsonResponse["numBytes"].isIntegral())
         {
-            m_pointsToRead =
-                std::max<int>(jsonResponse["numPoints"].asInt(), 0);
-            m_numBytes =
-                std::max<int>(jsonResponse["numBytes"].asInt(), 0);
-
-            if (m_pointsToRead * m_layout->pointSize() != m_numBytes)
-            {
-                valid = false;
-                m_error = true;
-            }
-            else
-            {
-                valid = true;
-            }
+            valid = setCounts(
+                std::max<int>(jsonResponse["numPoints"].asInt(), 0),
+                std::max<int>(jsonResponse["numBytes"].asInt(), 0));
         }
     }
 
     return valid;
 }
 
+bool Read::setCounts(const std::size_t numPoints, const std::size_t numBytes)
+{
+    m_pointsToRead = numPoints;
+    m_numBytes = numBytes;
+
+    if (m_pointsToRead * m_layout->pointSize() != m_numBytes ||
+        (m_spans.size() && m_numBytes > m_destSize))
+    {
+        m_error = true;
+        return false;
+    }
+    return true;
+}
+
+void Read::setDestination(const PointSpanList& spans)
+{
+    m_spans = spans;
+    m_destSize = 0;
+    for (const auto& span : m_spans)
+        m_destSize += span.m_size;
+}
+
+void Read::prepareOutput()
+{
+    if (m_spans.size())
+        return;
+    m_data.resize(m_numBytes);
+    m_spans.push_back(PointSpan{m_data.data(), m_data.size()});
+    m_destSize = m_data.size();
+}
+
+void Read::store(const char *bytes, std::size_t size)
+{
+    std::size_t offset(m_numBytesReceived);
+    for (const auto& span : m_spans)
+    {
+        if (!size)
+            break;
+        if (offset >= span.m_size)
+        {
+            offset -= span.m_size;
+            continue;
+        }
+        const std::size_t n(std::min(size, span.m_size - offset));
+        std::copy(bytes, bytes + n, span.m_pos + offset);
+        bytes += n;
+        size -= n;
+        offset = 0;
+    }
+}
+
 std::size_t Read::numRead() const
 {
     return m_pointsToRead;
 }
 
 ReadUncompressed::ReadUncompressed(
-        PointViewPtr view,
         const PointLayoutPtr layout,
         const std::string& sessionId,
         int offset,
         int count)
-    : Read(view, layout, sessionId, false, offset, count)
+    : Read(layout, sessionId, false, offset, count)
 { }
 
 bool ReadUncompressed::done()
@@ -285,44 +354,24 @@ void ReadUncompressed::handleRx(const message_ptr message)
     {
         m_initialized = check();
         if (!m_initialized) m_error = true;
+        else prepareOutput();
     }
     else
     {
         if (message->get_opcode() == websocketpp::frame::opcode::binary)
         {
             const std::string& bytes(message->get_payload());
-            const std::size_t rawNumBytes(bytes.size());
-            const std::size_t stride(m_layout->pointSize());
-
-            m_data.insert(m_data.end(), bytes.begin(), bytes.end());
-
-            const std::size_t wholePoints(m_data.size() / stride);
-
-            PointId nextId(m_view->size());
-            const PointId doneId(nextId + wholePoints);
 
-            const char* pos(m_data.data());
-
-            while (nextId < doneId)
+            // The frames are copied straight to where the points go.
+            if (m_numBytesReceived + bytes.size() > m_numBytes)
             {
-                for (const auto& dim : m_layout->dims())
-                {
-                    m_view->setField(
-                            dim,
-                            m_layout->dimType(dim),
-                            nextId,
-                            pos);
-
-                    pos += m_layout->dimSize(dim);
-                }
-
-                ++nextId;
+                m_error = true;
+                return;
             }
-
-            m_numBytesReceived += rawNumBytes;
-            m_data.assign(
-                    m_data.begin() + wholePoints * stride,
-                    m_data.end());
+            store(bytes.data(), bytes.size());
+            m_numBytesReceived += bytes.size();
+            if (m_record)
+                m_raw.append(bytes);
         }
         else
         {
@@ -331,28 +380,54 @@ void ReadUncompressed::handleRx(const message_ptr message)
     }
 }
 
+bool ReadUncompressed::replay(
+        const std::size_t numPoints,
+        const std::size_t numBytes,
+        const std::string& raw)
+{
+    m_initialized = setCounts(numPoints, numBytes) && raw.size() == numBytes;
+    if (!m_initialized)
+        return false;
+
+    prepareOutput();
+    store(raw.data(), raw.size());
+    m_numBytesReceived = raw.size();
+    return true;
+}
+
 #ifdef PDAL_HAVE_LAZPERF
 ReadCompressed::ReadCompressed(
-        PointViewPtr view,
         const PointLayoutPtr layout,
         const std::string& sessionId,
         int offset,
         int count)
-    : Read(view, layout, sessionId, true, offset, count)
+    : Read(layout, sessionId, true, offset, count)
     , m_decompressionThread()
     , m_compressionStream()
     , m_decompressor(m_compressionStream, layout->dimTypes())
     , m_done(false)
-    , m_doneCv()
     , m_doneMutex()
     , m_mutex()
 { }
 
+ReadCompressed::~ReadCompressed()
+{
+    // Let a decompression that's waiting on bytes that won't come finish.
+    m_compressionStream.abort();
+    if (m_decompressionThread.joinable())
+        m_decompressionThread.join();
+}
+
+bool ReadCompressed::check()
+{
+    std::lock_guard<std::mutex> lock(m_doneMutex);
+    return !m_error && Read::check();
+}
+
 bool ReadCompressed::done()
 {
-    std::unique_lock<std::mutex> lock(m_doneMutex);
-    m_doneCv.wait(lock, [this]()->bool { return m_done; });
-    return true;
+    std::lock_guard<std::mutex> lock(m_doneMutex);
+    return m_done || m_error;
 }
 
 void ReadCompressed::handleRx(const message_ptr message)
@@ -360,34 +435,15 @@ void ReadCompressed::handleRx(const message_ptr message)
     std::lock_guard<std::mutex> lock(m_mutex);
     if (!m_initialized)
     {
-        m_initialized = check();
-        if (!m_initialized) m_error = true;
-
-        m_data.resize(m_numBytes);
-
-        m_decompressionThread = std::thread([this]()->void {
-            m_decompressor.decompress(m_data.data(), m_data.size());
-
-            const char* pos(m_data.data());
-            for (PointId i(0); i < m_pointsToRead; ++i)
-            {
-                for (const auto& dim : m_layout->dims())
-                {
-                    m_view->setField(
-                            dim,
-                            m_layout->dimType(dim),
-                            i,
-                            pos);
-
-                    pos += m_layout->dimSize(dim);
-                }
-            }
-
-            m_done = true;
-            m_doneCv.notify_all();
-        });
+        m_initialized = Read::check();
+        if (!m_initialized)
+        {
+            std::lock_guard<std::mutex> doneLock(m_doneMutex);
+            m_error = true;
+            return;
+        }
 
-        m_decompressionThread.detach();
+        startDecompression();
     }
     else
     {
@@ -398,13 +454,70 @@ void ReadCompressed::handleRx(const message_ptr message)
             m_compressionStream.putBytes(
                     reinterpret_cast<const uint8_t*>(bytes.data()),
                     bytes.size());
+            if (m_record)
+                m_raw.append(bytes);
         }
         else
         {
+            std::lock_guard<std::mutex> doneLock(m_doneMutex);
             m_error = true;
         }
     }
 }
+
+bool ReadCompressed::replay(
+        const std::size_t numPoints,
+        const std::size_t numBytes,
+        const std::string& raw)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_initialized = setCounts(numPoints, numBytes);
+        if (!m_initialized)
+            return false;
+
+        startDecompression();
+        m_compressionStream.putBytes(
+                reinterpret_cast<const uint8_t*>(raw.data()), raw.size());
+    }
+
+    // A truncated response leaves the decompressor short of bytes.
+    m_compressionStream.abort();
+    wait();
+    return done() && !m_error;
+}
+
+void ReadCompressed::startDecompression()
+{
+    prepareOutput();
+
+    // Points are decompressed straight into the spans, which hold whole
+    // points.
+    m_decompressionThread = std::thread([this]()->void {
+        bool ok(true);
+        try
+        {
+            std::size_t remaining(m_numBytes);
+            for (const auto& span : m_spans)
+            {
+                const std::size_t n(std::min(remaining, span.m_size));
+                m_decompressor.decompress(span.m_pos, n);
+                remaining -= n;
+            }
+        }
+        catch (...)
+        {
+            ok = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> doneLock(m_doneMutex);
+            m_done = ok;
+            m_error = m_error || !ok;
+        }
+        finish();
+    });
+}
 #endif
 
 
@@ -42,6 +42,7 @@
 
 #include <pdal/Dimension.hpp>
 #include <pdal/Compression.hpp>
+#include <pdal/util/Bounds.hpp>
 
 #include "WebSocketClient.hpp"
 #include "GreyhoundReader.hpp"
@@ -111,40 +112,83 @@ private:
     std::vector<DimData> m_dimData;
 };
 
+// Memory that points are decoded into.
+struct PointSpan
+{
+    char *m_pos;
+    std::size_t m_size;
+};
+typedef std::vector<PointSpan> PointSpanList;
+
+// Reads a range of points, or the points of a spatial query.  The points
+// are kept as packed records, with the fields in the order of the layout's
+// dimensions, so that reads can run on several threads without touching a
+// point table.
 class Read : public Exchange
 {
 public:
     Read(
-            PointViewPtr view,
             const PointLayoutPtr layout,
             const std::string& sessionId,
             bool compress,
             int offset,
             int count);
 
+    // Ask for the points within 'bounds' (if not empty) whose tree depth is
+    // in [depthBegin, depthEnd) rather than a range of points.  A depthEnd
+    // of 0 leaves the depth unbounded.
+    void query(const BOX3D& bounds, uint32_t depthBegin, uint32_t depthEnd);
+    // Keep the response bytes as they arrive, for raw().
+    void record()
+        { m_record = true; }
+    // Decode the points into 'spans', filled in order, rather than into
+    // data().  A response too large for them is an error.
+    void setDestination(const PointSpanList& spans);
+
     virtual bool check();
     virtual bool done() = 0;
     virtual void handleRx(const message_ptr message) = 0;
+    // Handle a response that was recorded earlier instead of one from the
+    // server.  Returns false if the response isn't valid.
+    virtual bool replay(std::size_t numPoints, std::size_t numBytes,
+        const std::string& raw) = 0;
 
     std::size_t numRead() const;
+    std::size_t numBytes() const
+        { return m_numBytes; }
+    // The points read, once the exchange is done, unless they were
+    // decoded into a destination.
+    const std::vector<char>& data() const
+        { return m_data; }
+    // The bytes of the response as they came, if recorded.
+    const std::string& raw() const
+        { return m_raw; }
 
 protected:
-    PointViewPtr m_view;
     const PointLayoutPtr m_layout;
 
     bool m_initialized;
     bool m_error;
+    bool m_record;
     std::size_t m_pointsToRead;
     std::size_t m_numBytes;
     std::size_t m_numBytesReceived;
     std::vector<char> m_data;
+    std::string m_raw;
+    PointSpanList m_spans;
+    std::size_t m_destSize;
+
+    bool setCounts(std::size_t numPoints, std::size_t numBytes);
+    // Point the output at data() unless a destination was set.
+    void prepareOutput();
+    // Copy bytes of points to the output, after those already received.
+    void store(const char *bytes, std::size_t size);
 };
 
 class ReadUncompressed : public Read
 {
 public:
     ReadUncompressed(
-            PointViewPtr view,
             const PointLayoutPtr,
             const std::string& sessionId,
             int offset = 0,
@@ -152,21 +196,28 @@ public:
 
     virtual bool done();
     virtual void handleRx(const message_ptr message);
+    virtual bool replay(std::size_t numPoints, std::size_t numBytes,
+        const std::string& raw);
 };
 
 #ifdef PDAL_HAVE_LAZPERF
+// Points are decompressed on a thread of their own as the compressed bytes
+// arrive.
 class ReadCompressed : public Read
 {
 public:
     ReadCompressed(
-            PointViewPtr view,
             const PointLayoutPtr,
             const std::string& sessionId,
             int offset = 0,
             int count = -1);
+    ~ReadCompressed();
 
+    virtual bool check();
     virtual bool done();
     virtual void handleRx(const message_ptr message);
+    virtual bool replay(std::size_t numPoints, std::size_t numBytes,
+        const std::string& raw);
 
 private:
     std::thread m_decompressionThread;
@@ -175,11 +226,13 @@ private:
 
     LazPerfDecompressor<CompressionStream> m_decompressor;
 
+    // Guards m_done and m_error, which the decompression thread sets.
     bool m_done;
-    std::condition_variable m_doneCv;
     std::mutex m_doneMutex;
 
     std::mutex m_mutex;
+
+    void startDecompression();
 };
 #endif
 
@@ -0,0 +1,155 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "GreyhoundReadCache.hpp"
+
+#include <cstdio>
+#include <random>
+
+#include <pdal/pdal_error.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/IStream.hpp>
+#include <pdal/util/OStream.hpp>
+
+namespace pdal
+{
+
+namespace
+{
+
+const std::string c_magic("GHCACHE1");
+
+// FNV-1a, which unlike std::hash is the same from one build to the next.
+uint64_t hashKey(const std::string& key)
+{
+    uint64_t hash(14695981039346656037ULL);
+    for (unsigned char c : key)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // unnamed namespace
+
+GreyhoundReadCache::GreyhoundReadCache(const std::string& dir)
+    : m_dir(dir)
+{
+    if (!FileUtils::directoryExists(m_dir) &&
+            !FileUtils::createDirectory(m_dir))
+        throw pdal_error("Unable to create Greyhound cache directory '" +
+            dir + "'.");
+}
+
+std::string GreyhoundReadCache::path(const std::string& key) const
+{
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx",
+        static_cast<unsigned long long>(hashKey(key)));
+    return m_dir + "/" + name + ".ghc";
+}
+
+bool GreyhoundReadCache::get(const std::string& key, Entry& entry) const
+{
+    const std::string filename(path(key));
+    if (!FileUtils::fileExists(filename))
+        return false;
+
+    ILeStream in(filename);
+    if (!in)
+        return false;
+
+    std::string magic(c_magic.size(), '\0');
+    in.get(&magic[0], magic.size());
+    if (!in || magic != c_magic)
+        return false;
+
+    uint64_t keySize(0);
+    in >> keySize;
+    if (!in || keySize != key.size())
+        return false;
+    std::string storedKey(keySize, '\0');
+    in.get(&storedKey[0], keySize);
+    if (!in || storedKey != key)
+        return false;
+
+    uint64_t dataSize(0);
+    in >> entry.m_numPoints >> entry.m_numBytes >> dataSize;
+    if (!in)
+        return false;
+
+    entry.m_data.assign(dataSize, '\0');
+    if (dataSize)
+        in.get(&entry.m_data[0], dataSize);
+    return (bool)in;
+}
+
+void GreyhoundReadCache::put(const std::string& key, const Entry& entry) const
+{
+    const std::string filename(path(key));
+
+    std::random_device rd;
+    const std::string temp(filename + "." + std::to_string(rd()) + ".tmp");
+
+    bool ok(false);
+    {
+        OLeStream out(temp);
+        if (out)
+        {
+            out.put(c_magic);
+            out << (uint64_t)key.size();
+            out.put(key);
+            out << entry.m_numPoints << entry.m_numBytes <<
+                (uint64_t)entry.m_data.size();
+            out.put(entry.m_data);
+            out.flush();
+            ok = (bool)out;
+        }
+    }
+
+    try
+    {
+        if (ok)
+        {
+            FileUtils::renameFile(filename, temp);
+            return;
+        }
+    }
+    catch (...)
+    {}
+    std::remove(temp.c_str());
+}
+
+} // namespace pdal
@@ -0,0 +1,83 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace pdal
+{
+
+// An on-disk cache of Greyhound read responses.  Each entry holds the bytes
+// of one response as they came over the wire, compressed or not, so that a
+// repeated read of the same points needn't go to the server.  Entries are
+// keyed by a string that names the resource and the query; a file is never
+// trusted unless the key in it matches.
+class GreyhoundReadCache
+{
+public:
+    struct Entry
+    {
+        Entry() : m_numPoints(0), m_numBytes(0), m_data()
+        {}
+
+        uint64_t m_numPoints;
+        // Size of the points once decompressed.
+        uint64_t m_numBytes;
+        std::string m_data;
+    };
+
+    // The directory is created if it doesn't exist.
+    GreyhoundReadCache(const std::string& dir);
+
+    // Fill 'entry' from the cache.  Returns false if the key isn't cached
+    // or the file can't be read.
+    bool get(const std::string& key, Entry& entry) const;
+    // Store an entry.  The file is written aside and renamed into place, so
+    // that readers at once never see part of an entry.  A failure to write
+    // isn't an error, as the points are in hand anyway.
+    void put(const std::string& key, const Entry& entry) const;
+
+private:
+    std::string m_dir;
+
+    std::string path(const std::string& key) const;
+
+    // not implemented
+    GreyhoundReadCache& operator=(const GreyhoundReadCache&);
+    GreyhoundReadCache(const GreyhoundReadCache&);
+};
+
+} // namespace pdal
@@ -34,7 +34,13 @@
 
 #include "GreyhoundReader.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <utility>
+
 #include "Exchanges.hpp"
+#include "GreyhoundReadCache.hpp"
 
 namespace pdal
 {
@@ -56,10 +62,21 @@ GreyhoundReader::GreyhoundReader()
     , m_wsClient()
     , m_numPoints(0)
     , m_index(0)
+    , m_chunkSize(100000)
+    , m_concurrency(4)
+    , m_depthBegin(0)
+    , m_depthEnd(0)
+    , m_packedIdentity(false)
+    , m_firstDim(Dimension::Id::Unknown)
+    , m_responseOffset(0)
 { }
 
 GreyhoundReader::~GreyhoundReader()
 {
+    for (auto& response : m_responses)
+        if (response.m_done.valid())
+            response.m_done.wait();
+
     // Tell Greyhound we're done using this session.
     exchanges::Destroy destroyExchange(m_sessionId);
     m_wsClient.exchange(destroyExchange);
@@ -77,6 +94,19 @@ void GreyhoundReader::processOptions(const Options& options)
 {
     m_url = options.getValueOrThrow<std::string>("url");
     m_pipelineId = options.getValueOrThrow<std::string>("pipelineId");
+    m_chunkSize = options.getValueOrDefault<point_count_t>("chunk_size",
+        100000);
+    m_concurrency = options.getValueOrDefault<uint32_t>("concurrency", 4);
+    if (m_chunkSize == 0 || m_concurrency == 0)
+        throw pdal_error(getName() + ": options 'chunk_size' and "
+            "'concurrency' must be greater than 0.");
+    m_bounds = options.getValueOrDefault<BOX3D>("bounds", BOX3D());
+    m_depthBegin = options.getValueOrDefault<uint32_t>("depthBegin", 0);
+    m_depthEnd = options.getValueOrDefault<uint32_t>("depthEnd", 0);
+    if (m_depthEnd && m_depthEnd <= m_depthBegin)
+        throw pdal_error(getName() + ": option 'depthEnd' must be greater "
+            "than 'depthBegin'.");
+    m_cacheDir = options.getValueOrDefault<std::string>("cache_dir", "");
 
     m_wsClient.initialize(m_url);
 }
@@ -99,30 +129,344 @@ void GreyhoundReader::addDimensions(PointLayoutPtr layout)
 
 void GreyhoundReader::ready(PointTableRef)
 {
-    // Get number of points.
-    exchanges::GetNumPoints numPointsExchange(m_sessionId);
-    m_wsClient.exchange(numPointsExchange);
-    m_numPoints = numPointsExchange.count();
+    m_index = 0;
+    m_responses.clear();
+    m_responseOffset = 0;
+
+    if (!m_pool)
+        m_pool.reset(new ThreadPool(m_concurrency));
+    if (!m_cacheDir.empty() && !m_cache)
+        m_cache.reset(new GreyhoundReadCache(m_cacheDir));
+
+    std::size_t offset(0);
+    m_packedIdentity = true;
+    m_firstDim = Dimension::Id::Unknown;
+    for (const auto& dim : m_layout->dims())
+    {
+        const Dimension::Detail *dd(m_layout->dimDetail(dim));
+        if (dd->offset() != (int)offset)
+            m_packedIdentity = false;
+        if (dd->offset() == 0)
+            m_firstDim = dim;
+        offset += dd->size();
+    }
+    m_packedIdentity = m_packedIdentity && offset == m_layout->pointSize() &&
+        m_firstDim != Dimension::Id::Unknown;
+
+    if (!spatialQuery())
+    {
+        // Get number of points.
+        exchanges::GetNumPoints numPointsExchange(m_sessionId);
+        m_wsClient.exchange(numPointsExchange);
+        m_numPoints = numPointsExchange.count();
+        return;
+    }
+
+    // The number of points in a query isn't known until it's been made, so
+    // the whole query is fetched here.  Greyhound's depths don't overlap,
+    // so a bounded range of depths is asked for a depth at a time, with
+    // the depths in flight at once and cached apart.
+    std::vector<std::pair<uint32_t, uint32_t>> depths;
+    if (m_depthEnd)
+        for (uint32_t depth(m_depthBegin); depth < m_depthEnd; ++depth)
+            depths.push_back(std::make_pair(depth, depth + 1));
+    else
+        depths.push_back(std::make_pair(m_depthBegin, m_depthEnd));
+
+    try
+    {
+        for (const auto& depth : depths)
+        {
+            const BOX3D bounds(m_bounds);
+            const PointLayoutPtr layout(m_layout);
+            const std::string sessionId(m_sessionId);
+            ReadMaker make([bounds, depth, layout, sessionId]()
+            {
+#ifdef PDAL_HAVE_LAZPERF
+                exchanges::Read *read(new exchanges::ReadCompressed(
+#else
+                exchanges::Read *read(new exchanges::ReadUncompressed(
+#endif
+                        layout, sessionId));
+                read->query(bounds, depth.first, depth.second);
+                return read;
+            });
+
+            // References to the elements of a deque survive push_back().
+            m_responses.push_back(Request());
+            Request& request(m_responses.back());
+            std::unique_ptr<exchanges::Read> *slot(&request.m_read);
+            request.m_done = m_pool->submit([this, slot, make]()
+            {
+                fetch(*slot, make);
+            });
+        }
+
+        m_numPoints = 0;
+        for (auto& response : m_responses)
+        {
+            m_pool->wait(response.m_done);
+            response.m_count = response.m_read->numRead();
+            m_numPoints += response.m_count;
+        }
+    }
+    catch (...)
+    {
+        for (auto& response : m_responses)
+            if (response.m_done.valid())
+                response.m_done.wait();
+        m_responses.clear();
+        throw;
+    }
+}
+
+bool GreyhoundReader::spatialQuery() const
+{
+    return !m_bounds.empty() || m_depthBegin || m_depthEnd;
+}
+
+void GreyhoundReader::fetch(
+        std::unique_ptr<exchanges::Read>& read,
+        const ReadMaker& make) const
+{
+    read.reset(make());
+
+    // The request names the points asked for, so together with the
+    // resource it keys the cache.  The session is left out, as it's new
+    // for every run.
+    std::string key;
+    if (m_cache)
+    {
+        Json::Value req(read->req());
+        req.removeMember("session");
+        Json::FastWriter writer;
+        key = m_url + "\n" + m_pipelineId + "\n" + writer.write(req);
+
+        GreyhoundReadCache::Entry entry;
+        if (m_cache->get(key, entry))
+        {
+            if (read->replay(entry.m_numPoints, entry.m_numBytes,
+                    entry.m_data))
+                return;
+            // A bad entry is fetched again, and replaced.
+            read.reset(make());
+        }
+        read->record();
+    }
+
+    WebSocketClient client(m_url);
+    client.exchange(*read);
+
+    if (m_cache)
+    {
+        GreyhoundReadCache::Entry entry;
+        entry.m_numPoints = read->numRead();
+        entry.m_numBytes = read->numBytes();
+        entry.m_data = read->raw();
+        m_cache->put(key, entry);
+    }
 }
 
 point_count_t GreyhoundReader::read(
         PointViewPtr view,
         const point_count_t count)
 {
-    // Read data.
+    const point_count_t total(
+            std::min<point_count_t>(count, m_numPoints - m_index));
+    point_count_t requested(0);
+    point_count_t numRead(0);
+    bool shortRead(false);
+
+    if (spatialQuery())
+    {
+        while (numRead < total && !m_responses.empty())
+        {
+            Request& response(m_responses.front());
+            const point_count_t n(std::min(total - numRead,
+                response.m_count - m_responseOffset));
+            const char *pos(response.m_read->data().data() +
+                m_responseOffset * m_layout->pointSize());
+            const PointId begin(view->size());
+            std::vector<exchanges::PointSpan> spans;
+            if (prepareSpans(*view, n, spans))
+            {
+                for (const auto& span : spans)
+                {
+                    std::copy(pos, pos + span.m_size, span.m_pos);
+                    pos += span.m_size;
+                }
+            }
+            else
+                unpack(*view, begin, pos, n);
+            numRead += n;
+            m_responseOffset += n;
+            if (m_responseOffset == response.m_count)
+            {
+                m_responses.pop_front();
+                m_responseOffset = 0;
+            }
+        }
+        m_index += numRead;
+        return numRead;
+    }
+
+    // Ranges of points are asked for on sockets of their own, several at
+    // once, so that the latency of one request is hidden behind the others.
+    // Compressed responses are decompressed as they arrive.  When the
+    // records Greyhound sends are laid out as the table's points are, the
+    // points of a request are added to the view up front and the response
+    // is decoded straight into the table.  Otherwise the points are set in
+    // the view as requests complete, in order.
+    const PointId viewBegin(view->size());
+    std::deque<Request> inFlight;
+    auto submit = [this, &view, &inFlight, &requested, total, viewBegin]()
+    {
+        const point_count_t n(std::min(m_chunkSize, total - requested));
+        const point_count_t start(m_index + requested);
+        const PointLayoutPtr layout(m_layout);
+        const std::string sessionId(m_sessionId);
+
+        const PointId begin(viewBegin + requested);
+        std::vector<exchanges::PointSpan> spans;
+        const bool inPlace(prepareSpans(*view, n, spans));
+        ReadMaker make([layout, sessionId, start, n, inPlace, spans]()
+        {
 #ifdef PDAL_HAVE_LAZPERF
-    exchanges::ReadCompressed readExchange(
+            exchanges::Read *read(new exchanges::ReadCompressed(
 #else
-    exchanges::ReadUncompressed readExchange(
+            exchanges::Read *read(new exchanges::ReadUncompressed(
 #endif
-            view,
-            m_layout,
-            m_sessionId,
-            m_index,
-            count);
-
-    m_wsClient.exchange(readExchange);
-    return readExchange.numRead();
+                    layout, sessionId, start, n));
+            if (inPlace)
+                read->setDestination(spans);
+            return read;
+        });
+
+        // References to the elements of a deque survive push_back() and
+        // pop_front().
+        inFlight.push_back(Request());
+        Request& request(inFlight.back());
+        request.m_count = n;
+        request.m_begin = begin;
+        request.m_inPlace = inPlace;
+        std::unique_ptr<exchanges::Read> *slot(&request.m_read);
+        request.m_done = m_pool->submit([this, slot, make]()
+        {
+            fetch(*slot, make);
+        });
+        requested += n;
+    };
+
+    try
+    {
+        while (requested < total && inFlight.size() < m_concurrency)
+            submit();
+
+        while (!inFlight.empty())
+        {
+            Request& request(inFlight.front());
+            m_pool->wait(request.m_done);
+
+            // A short read means the server has no more points, and the
+            // ranges after it can't be appended.  Points already added to
+            // the view can't be taken back, so then it's an error.
+            const point_count_t n(request.m_read->numRead());
+            if (!shortRead)
+            {
+                if (n < request.m_count && m_packedIdentity)
+                    throw pdal_error(getName() + ": server sent fewer "
+                        "points than it reported.");
+                if (!request.m_inPlace)
+                    unpack(*view, request.m_begin,
+                        request.m_read->data().data(), n);
+                numRead += n;
+                shortRead = (n < request.m_count);
+            }
+            inFlight.pop_front();
+
+            if (!shortRead && requested < total)
+                submit();
+        }
+    }
+    catch (...)
+    {
+        // The exchanges still running belong to the requests.
+        for (auto& request : inFlight)
+            if (request.m_done.valid())
+                request.m_done.wait();
+        throw;
+    }
+
+    m_index = shortRead ? m_numPoints : m_index + numRead;
+    return numRead;
+}
+
+// When the records match the table's points, add 'count' points to the end
+// of the view and find the runs of table memory that hold them, so that
+// they can be decoded in place.  The points of a run share a block of the
+// table's storage.  Returns false if the points can't be decoded in place,
+// in which case any that were added are left to be set by unpack().
+bool GreyhoundReader::prepareSpans(
+        PointView& view,
+        const point_count_t count,
+        std::vector<exchanges::PointSpan>& spans) const
+{
+    if (!m_packedIdentity || count == 0)
+        return false;
+
+    const std::size_t pointSize(m_layout->pointSize());
+    PointId begin(view.size());
+    const PointId end(begin + count);
+    view.appendTablePoints(count);
+
+    std::ptrdiff_t stride;
+    while (begin < end)
+    {
+        // The longest run from 'begin' that's one span of memory.
+        point_count_t good(0);
+        char *pos(nullptr);
+        point_count_t lo(1);
+        point_count_t hi(end - begin);
+        while (lo <= hi)
+        {
+            const point_count_t mid(lo + (hi - lo) / 2);
+            char *p(view.fieldSpan(m_firstDim, begin, mid, stride));
+            if (p && stride == (std::ptrdiff_t)pointSize)
+            {
+                good = mid;
+                pos = p;
+                lo = mid + 1;
+            }
+            else
+                hi = mid - 1;
+        }
+        if (!good)
+        {
+            spans.clear();
+            return false;
+        }
+        spans.push_back(exchanges::PointSpan{pos, good * pointSize});
+        begin += good;
+    }
+    return true;
+}
+
+void GreyhoundReader::unpack(
+        PointView& view,
+        const PointId begin,
+        const char *pos,
+        const point_count_t count) const
+{
+    PointId nextId(begin);
+
+    for (point_count_t i(0); i < count; ++i, ++nextId)
+    {
+        for (const auto& dim : m_layout->dims())
+        {
+            view.setField(dim, m_layout->dimType(dim), nextId, pos);
+            pos += m_layout->dimSize(dim);
+        }
+    }
 }
 
 bool GreyhoundReader::eof() const
@@ -36,12 +36,28 @@
 
 #include <pdal/Reader.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/util/Bounds.hpp>
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
 
 #include "WebSocketClient.hpp"
 
 namespace pdal
 {
 
+class GreyhoundReadCache;
+
+namespace exchanges
+{
+    class Read;
+    struct PointSpan;
+}
+
 class PDAL_DLL GreyhoundReader : public pdal::Reader
 {
 public:
@@ -60,6 +76,49 @@ private:
     WebSocketClient m_wsClient;
     point_count_t m_numPoints;
     point_count_t m_index;
+    // Points asked for by each read request, and the number of requests
+    // that are in flight at once, each on a socket of its own.
+    point_count_t m_chunkSize;
+    uint32_t m_concurrency;
+    std::unique_ptr<ThreadPool> m_pool;
+    // A spatial query, made instead of reading the resource by index when
+    // the bounds or a depth is given.
+    BOX3D m_bounds;
+    uint32_t m_depthBegin;
+    uint32_t m_depthEnd;
+    std::string m_cacheDir;
+    std::unique_ptr<GreyhoundReadCache> m_cache;
+
+    // Whether the packed records sent by Greyhound are laid out as the
+    // points of the table are, so that they can be decoded in place.  The
+    // dimension stored first in a point locates a run of points.
+    bool m_packedIdentity;
+    Dimension::Id::Enum m_firstDim;
+
+    struct Request
+    {
+        std::unique_ptr<exchanges::Read> m_read;
+        std::future<void> m_done;
+        point_count_t m_count;
+        // Index in the view of the first point, and whether the points are
+        // decoded straight into the table.
+        PointId m_begin;
+        bool m_inPlace;
+    };
+    typedef std::function<exchanges::Read *()> ReadMaker;
+
+    // Responses to the spatial query that are yet to be added to a view,
+    // and the number of points of the first that already have been.
+    std::deque<Request> m_responses;
+    point_count_t m_responseOffset;
+
+    bool spatialQuery() const;
+    void fetch(std::unique_ptr<exchanges::Read>& read,
+        const ReadMaker& make) const;
+    bool prepareSpans(PointView& view, point_count_t count,
+        std::vector<exchanges::PointSpan>& spans) const;
+    void unpack(PointView& view, PointId begin, const char *pos,
+        point_count_t count) const;
 
     virtual void initialize();
     virtual void processOptions(const Options& options);
@@ -47,8 +47,6 @@ WebSocketClient::WebSocketClient(bool enableLogging)
     : m_uri()
     , m_client()
     , m_jsonReader()
-    , m_cv()
-    , m_mutex()
     , m_initialized(false)
 {
     if (!enableLogging)
@@ -64,8 +62,6 @@ WebSocketClient::WebSocketClient(const std::string& uri, bool enableLogging)
     : m_uri(uri)
     , m_client()
     , m_jsonReader()
-    , m_cv()
-    , m_mutex()
     , m_initialized(true)
 {
     if (!enableLogging)
@@ -87,53 +83,42 @@ void WebSocketClient::exchange(WebSocketExchange& exchange)
 {
     if (!m_initialized) return;
 
-    bool done(false);
-
-    std::thread t([this, &exchange, &done]()
+    m_client.set_open_handler(
+        [this, &exchange](websocketpp::connection_hdl hdl)
     {
-        m_client.set_open_handler(
-            [this, &exchange](websocketpp::connection_hdl hdl)
-        {
-            m_client.send(
-                    hdl,
-                    exchange.req().toStyledString(),
-                    websocketpp::frame::opcode::text);
-        });
-
-        m_client.set_message_handler(
-                [this, &exchange, &done](
-                    websocketpp::connection_hdl,
-                    message_ptr msg)
-        {
-            exchange.addResponse(msg);
-
-            std::thread tDone([this, &exchange, &done]() {
-                if (exchange.done())
-                {
-                    std::unique_lock<std::mutex> lock(this->m_mutex);
-                    done = true;
-                    lock.unlock();
-                    this->m_cv.notify_all();
-                }
-            });
-
-            tDone.detach();
-        });
-
-        websocketpp::lib::error_code ec;
-        m_client.reset();
-        m_client.connect(m_client.get_connection(m_uri, ec));
-        m_client.run();
+        m_client.send(
+                hdl,
+                exchange.req().toStyledString(),
+                websocketpp::frame::opcode::text);
     });
 
-    t.detach();
-
-    std::unique_lock<std::mutex> lock(m_mutex);
-    m_cv.wait(lock, [&done]()->bool { return done; });
+    m_client.set_message_handler(
+            [&exchange](websocketpp::connection_hdl, message_ptr msg)
+    {
+        exchange.addResponse(msg);
+    });
 
+    // A connection that can't be made, or that closes early, leaves the
+    // exchange unfinished, which is caught below.
+    m_client.set_fail_handler(
+            [&exchange](websocketpp::connection_hdl) { exchange.finish(); });
+    m_client.set_close_handler(
+            [&exchange](websocketpp::connection_hdl) { exchange.finish(); });
+
+    websocketpp::lib::error_code ec;
+    m_client.reset();
+    asioClient::connection_ptr connection(m_client.get_connection(m_uri, ec));
+    if (ec)
+        throw pdal_error("Unable to connect to '" + m_uri + "': " +
+            ec.message());
+    m_client.connect(connection);
+
+    std::thread t([this]() { m_client.run(); });
+    exchange.wait();
     m_client.stop();
+    t.join();
 
-    if (!exchange.check())
+    if (!exchange.done() || !exchange.check())
     {
         Json::Value jsonResponse;
         Json::Reader jsonReader;
@@ -150,7 +135,7 @@ void WebSocketClient::exchange(WebSocketExchange& exchange)
             std::cout << message << std::endl;
         }
 
-        throw new pdal_error(message);
+        throw pdal_error(message);
     }
 }
 
@@ -51,27 +51,55 @@ typedef websocketpp::config::asio_client::message_type::ptr message_ptr;
 class WebSocketExchange
 {
 public:
+    virtual ~WebSocketExchange() { }
+
     const Json::Value& req() const { return m_req; }
     const std::vector<message_ptr>& res() const { return m_res; }
     void addResponse(message_ptr message)
     {
         m_res.push_back(message);
         handleRx(message);
+        if (done())
+            finish();
     }
 
+    // Whether the whole response has been handled, or the exchange has
+    // failed.  This mustn't block.
     virtual bool done() { return true; }
     virtual bool check() { return true; }
 
+    // Wake the thread that's waiting for the exchange.  This is called once
+    // the exchange is done, or when the connection goes away.
+    void finish()
+    {
+        std::lock_guard<std::mutex> lock(m_finishMutex);
+        m_finished = true;
+        m_finishCv.notify_all();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_finishMutex);
+        m_finishCv.wait(lock, [this]()->bool { return m_finished; });
+    }
+
 protected:
-    WebSocketExchange() : m_req(), m_res() { }
+    WebSocketExchange() : m_req(), m_res(), m_finished(false) { }
     virtual void handleRx(const message_ptr) { }
 
     Json::Value m_req;
 
 private:
     std::vector<message_ptr> m_res;
+
+    bool m_finished;
+    std::mutex m_finishMutex;
+    std::condition_variable m_finishCv;
 };
 
+// A client makes one exchange at a time, each on a connection of its own.
+// Exchanges can be run at once on separate clients.
+
 class WebSocketClient
 {
 public:
@@ -86,9 +114,6 @@ private:
     asioClient m_client;
     Json::Reader m_jsonReader;
 
-    std::condition_variable m_cv;
-    std::mutex m_mutex;
-
     bool m_initialized;
 };
 
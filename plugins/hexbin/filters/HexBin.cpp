@@ -36,6 +36,11 @@
 
 #include <hexer/HexIter.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
 
 using namespace hexer;
 
@@ -54,6 +59,13 @@ void HexBin::processOptions(const Options& options)
     m_sampleSize = options.getValueOrDefault<uint32_t>("sample_size", 5000);
     m_density = options.getValueOrDefault<uint32_t>("threshold", 15);
     m_outputTesselation = options.getValueOrDefault<bool>("output_tesselation", false);
+    m_stride = options.getValueOrDefault<uint32_t>("stride", 1);
+    if (m_stride == 0)
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'stride' must be greater than 0.";
+        throw pdal_error(oss.str());
+    }
 
     if (options.hasOption("edge_length"))
         m_edgeLength = options.getValueOrDefault<double>("edge_length", 0.0);
@@ -63,31 +75,207 @@ void HexBin::processOptions(const Options& options)
 }
 
 
+namespace
+{
+
+typedef std::pair<int, int> GridPos;
+
+// Points counted in a hexagon by all the chunks.
+struct HexCount
+{
+    HexCount() : m_x(0), m_y(0), m_count(0)
+    {}
+
+    double m_x;
+    double m_y;
+    int m_count;
+};
+
+} // unnamed namespace
+
+
+// With a stride, hexagons are only sent a share of their points, so the
+// count needed for them to be full is reduced to match.
+int32_t HexBin::denseLimit() const
+{
+    return (std::max)(1, (int32_t)std::ceil((double)m_density / m_stride));
+}
+
+
 void HexBin::ready(PointTableRef table)
 {
+    m_partials.clear();
+    m_haveSeed = false;
+    m_gridEmpty = true;
+    m_height = 0;
     if (m_edgeLength == 0.0)  // 0 can always be represented exactly.
     {
-        m_grid.reset(new HexGrid(m_density));
+        m_grid.reset(new HexGrid(denseLimit()));
         m_grid->setSampleSize(m_sampleSize);
     }
     else
-        m_grid.reset(new HexGrid(m_edgeLength * sqrt(3), m_density));
+    {
+        m_height = m_edgeLength * sqrt(3);
+        m_grid.reset(new HexGrid(m_height, denseLimit()));
+    }
+}
+
+
+// Estimate the hexagon size from the first points, as the grid itself
+// would, and start a grid of that size.
+void HexBin::estimateSize(PointView& view)
+{
+    HexGrid sample(denseLimit());
+    sample.setSampleSize(m_sampleSize);
+    point_count_t count = (std::min)((point_count_t)m_sampleSize,
+        view.size());
+    for (PointId idx = 0; idx < count; ++idx)
+        sample.addPoint(view.getFieldAs<double>(Dimension::Id::X, idx),
+            view.getFieldAs<double>(Dimension::Id::Y, idx));
+    sample.processSample();
+    m_height = sample.height();
+    m_grid.reset(new HexGrid(m_height, denseLimit()));
 }
 
 
 void HexBin::filter(PointView& view)
 {
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    if (view.empty())
+        return;
+    if (!m_haveSeed)
+    {
+        m_seedX = view.getFieldAs<double>(Dimension::Id::X, 0);
+        m_seedY = view.getFieldAs<double>(Dimension::Id::Y, 0);
+        m_haveSeed = true;
+    }
+    if (m_height == 0)
+        estimateSize(view);
+
+    ThreadPool& pool = ThreadPool::shared();
+    point_count_t count = view.size();
+    size_t chunks = (std::max)((size_t)1,
+        (std::min)(pool.size(), (size_t)(count / 65536)));
+
+    // Small views go straight into the grid.
+    if (chunks == 1 && m_partials.empty())
+    {
+        for (PointId idx = 0; idx < count; idx += m_stride)
+        {
+            double x = view.getFieldAs<double>(Dimension::Id::X, idx);
+            double y = view.getFieldAs<double>(Dimension::Id::Y, idx);
+            m_grid->addPoint(x, y);
+        }
+        m_gridEmpty = false;
+        return;
+    }
+
+    // Otherwise each chunk counts its points in a grid of its own.  Those
+    // grids treat every hexagon with a point as full so that they can all
+    // be walked when merging.
+    size_t first = m_partials.size();
+    m_partials.resize(first + chunks);
+    for (size_t c = 0; c < chunks; ++c)
+    {
+        m_partials[first + c].reset(new HexGrid(m_height, 1));
+        m_partials[first + c]->addPoint(m_seedX, m_seedY);
+    }
+
+    auto bin = [this, &view, first, chunks, count](size_t begin,
+        size_t end)
+    {
+        const point_count_t batchSize = 4096;
+        std::vector<double> xs(batchSize);
+        std::vector<double> ys(batchSize);
+        for (size_t c = begin; c < end; ++c)
+        {
+            HexGrid& grid = *m_partials[first + c];
+            PointId cBegin = count * c / chunks;
+            PointId cEnd = count * (c + 1) / chunks;
+            if (m_stride > 1)
+            {
+                // Start on a multiple of the stride so that the same
+                // points are used however the view is split.
+                cBegin = (cBegin + m_stride - 1) / m_stride * m_stride;
+                for (PointId idx = cBegin; idx < cEnd; idx += m_stride)
+                    grid.addPoint(
+                        view.getFieldAs<double>(Dimension::Id::X, idx),
+                        view.getFieldAs<double>(Dimension::Id::Y, idx));
+                continue;
+            }
+            for (PointId b = cBegin; b < cEnd; b += batchSize)
+            {
+                point_count_t n = (std::min)(batchSize, cEnd - b);
+                view.getFieldArray(Dimension::Id::X, b, n, xs.data());
+                view.getFieldArray(Dimension::Id::Y, b, n, ys.data());
+                for (PointId i = 0; i < n; ++i)
+                    grid.addPoint(xs[i], ys[i]);
+            }
+        }
+    };
+    pool.parallelFor(chunks, 1, bin);
+
+    // When streaming, every chunk adds grids, so fold them into the main
+    // grid before they pile up.
+    if (m_partials.size() >= 4 * pool.size())
+        merge();
+}
+
+
+// Add the hexagons counted by the chunks to the grid.  Each is added at
+// its center, once for each point unless the hexagons are only needed to
+// be full.
+void HexBin::merge()
+{
+    if (m_partials.empty())
+        return;
+
+    // The seed's hexagon, which is the same in every grid.
+    HexGrid seedGrid(m_height, 1);
+    seedGrid.addPoint(m_seedX, m_seedY);
+    HexInfo seedHex = *seedGrid.hexBegin();
+    GridPos seedPos(seedHex.xgrid(), seedHex.ygrid());
+
+    std::map<GridPos, HexCount> hexes;
+    for (auto& part : m_partials)
+    {
+        for (HexIter hi = part->hexBegin(); hi != part->hexEnd(); ++hi)
+        {
+            HexInfo h = *hi;
+            GridPos pos(h.xgrid(), h.ygrid());
+            HexCount& hex = hexes[pos];
+            hex.m_x = h.x();
+            hex.m_y = h.y();
+            hex.m_count += h.density();
+            if (pos == seedPos)
+                hex.m_count--;
+        }
+    }
+    m_partials.clear();
+
+    // A grid that hasn't been sent a point is started with the seed, which
+    // then counts as one of its hexagon's points.
+    if (m_gridEmpty)
+    {
+        m_grid->addPoint(m_seedX, m_seedY);
+        hexes[seedPos].m_count--;
+        m_gridEmpty = false;
+    }
+
+    int limit = denseLimit();
+    for (auto& hi : hexes)
     {
-        double x = view.getFieldAs<double>(pdal::Dimension::Id::X, idx);
-        double y = view.getFieldAs<double>(pdal::Dimension::Id::Y, idx);
-        m_grid->addPoint(x, y);
+        HexCount& hex = hi.second;
+        int count = m_outputTesselation ? hex.m_count :
+            (std::min)(hex.m_count, limit);
+        for (int i = 0; i < count; ++i)
+            m_grid->addPoint(hex.m_x, hex.m_y);
     }
 }
 
 
 void HexBin::done(PointTableRef table)
 {
+    merge();
     m_grid->processSample();
     m_grid->findShapes();
     m_grid->findParentPaths();
@@ -40,6 +40,9 @@
 #include <hexer/HexGrid.hpp>
 #include <hexer/Processor.hpp>
 
+#include <memory>
+#include <vector>
+
 namespace pdal
 {
 
@@ -52,16 +55,32 @@ public:
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const { return "filters.hexbin"; }
+    virtual bool streamable() const
+        { return true; }
 
 private:
 
     std::unique_ptr<hexer::HexGrid> m_grid;
+    // Hexagons counted from parts of views, merged into m_grid when done.
+    std::vector<std::unique_ptr<hexer::HexGrid>> m_partials;
     std::string m_xDimName;
     std::string m_yDimName;
     uint32_t m_sampleSize;
     int32_t m_density;
     double m_edgeLength;
     bool m_outputTesselation;
+    uint32_t m_stride;
+    double m_height;
+    // The first point seen.  Every grid is started with it so that all of
+    // their hexagons line up.
+    bool m_haveSeed;
+    double m_seedX;
+    double m_seedY;
+    bool m_gridEmpty;
+
+    int32_t denseLimit() const;
+    void estimateSize(PointView& view);
+    void merge();
 
     virtual void processOptions(const Options& options);
     virtual void ready(PointTableRef table);
@@ -101,3 +101,45 @@ TEST(HexbinFilterTest, HexbinFilterTest_test_1)
 
     EXPECT_TRUE(ok);
 }
+
+// Sum the densities of the hexagons found from random points.
+static int hexbinCount(point_count_t numPoints, uint32_t stride)
+{
+    StageFactory f;
+
+    Options readerOptions;
+    readerOptions.add("mode", "random");
+    readerOptions.add("bounds", BOX3D(0.0, 0.0, 0.0, 100.0, 100.0, 100.0));
+    readerOptions.add("num_points", numPoints);
+    readerOptions.add("seed", 17);
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(readerOptions);
+
+    Options options;
+    options.add("edge_length", 5);
+    options.add("threshold", 1);
+    options.add("output_tesselation", true);
+    options.add("stride", stride);
+    std::unique_ptr<Stage> hexbin(f.createStage("filters.hexbin"));
+    hexbin->setOptions(options);
+    hexbin->setInput(*reader);
+
+    PointTable table;
+    hexbin->prepare(table);
+    hexbin->execute(table);
+
+    MetadataNode m = table.metadata().findChild(hexbin->getName());
+    int total = 0;
+    for (auto& hex : m.findChild("hexagons").children("hexagon"))
+        total += hex.findChild("density").value<int>();
+    return total;
+}
+
+// Large views are counted in parallel.  Every point must be counted once,
+// however the view was split.
+TEST(HexbinFilterTest, parallel)
+{
+    EXPECT_EQ(hexbinCount(300000, 1), 300000);
+    EXPECT_EQ(hexbinCount(300000, 3), 100000);
+    EXPECT_EQ(hexbinCount(1000, 4), 250);
+}
@@ -52,6 +52,8 @@ void Hdf5Handler::initialize(
         const std::string& filename,
         const std::vector<Hdf5ColumnData>& columns)
 {
+    m_columnDataMap.clear();
+    m_numPoints = 0;
     try
     {
         m_h5File.reset(new H5::H5File(filename, H5F_ACC_RDONLY));
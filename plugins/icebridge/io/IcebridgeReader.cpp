@@ -35,6 +35,7 @@
 #include "IcebridgeReader.hpp"
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
 
 #include <map>
 
@@ -55,6 +56,10 @@ namespace
         { "instrument_parameters/pulse_width",  H5::PredType::NATIVE_FLOAT },
         { "instrument_parameters/rel_time",     H5::PredType::NATIVE_FLOAT }
     };
+
+    // Columns are read in hyperslabs of this many entries, so memory use
+    // beyond the point table is bounded.
+    const pdal::point_count_t ChunkPoints = 65536;
 }
 
 namespace pdal
@@ -116,66 +121,79 @@ void IcebridgeReader::ready(PointTableRef table)
 
 point_count_t IcebridgeReader::read(PointViewPtr view, point_count_t count)
 {
-    //All data we read for icebridge is currently 4 bytes wide, so
-    //  just allocate once and forget it.
-    //This could be a huge allocation.  Perhaps we should do something
-    //  in the icebridge handler?
-
-    PointId startId = view->size();
     point_count_t remaining = m_hdf5Handler.getNumPoints() - m_index;
     count = std::min(count, remaining);
 
-    std::unique_ptr<unsigned char>
-        rawData(new unsigned char[count * sizeof(float)]);
+    //All data we read for icebridge is currently 4 bytes wide.
+    std::vector<std::vector<char>> rawData(hdf5Columns.size());
+    const Dimension::IdList dims = getDefaultDimensions();
 
-    //Not loving the position-linked data, but fine for now.
-    Dimension::IdList dims = getDefaultDimensions();
-    auto di = dims.begin();
-    for (auto ci = hdf5Columns.begin(); ci != hdf5Columns.end(); ++ci, ++di)
+    point_count_t numRead = 0;
+    while (numRead < count)
     {
-        PointId nextId = startId;
-        PointId idx = m_index;
-        const hdf5::Hdf5ColumnData& column = *ci;
+        const point_count_t chunkCount =
+            std::min(ChunkPoints, count - numRead);
 
-        try
+        // HDF5 libraries usually aren't built thread-safe, so the
+        // hyperslabs are read one after another.
+        for (size_t c = 0; c < hdf5Columns.size(); ++c)
         {
-            m_hdf5Handler.getColumnEntries(rawData.get(), column.name, count,
-                m_index);
-            void *p = (void *)rawData.get();
-
-            // This is ugly but avoids a test in a tight loop.
-            if (column.predType == H5::PredType::NATIVE_FLOAT)
+            rawData[c].resize(chunkCount * sizeof(float));
+            try
             {
-                // Offset time is in ms but icebridge stores in seconds.
-                if (*di == Dimension::Id::OffsetTime)
-                {
-                    float *fval = (float *)p;
-                    for (PointId i = 0; i < count; ++i)
-                    {
-                        view->setField(*di, nextId++, *fval * 1000);
-                        fval++;
-                    }
-                }
-                else
-                {
-                    float *fval = (float *)p;
-                    for (PointId i = 0; i < count; ++i)
-                        view->setField(*di, nextId++, *fval++);
-                }
+                m_hdf5Handler.getColumnEntries(rawData[c].data(),
+                    hdf5Columns[c].name, chunkCount, m_index);
             }
-            else if (column.predType == H5::PredType::NATIVE_INT)
+            catch(...)
             {
-                int32_t *ival = (int32_t *)p;
-                for (PointId i = 0; i < count; ++i)
-                    view->setField(*di, nextId++, *ival++);
+                throw icebridge_error("Error fetching column data");
             }
         }
-        catch(...)
+
+        // Offset time is in ms but icebridge stores in seconds.
+        for (size_t c = 0; c < hdf5Columns.size(); ++c)
+            if (dims[c] == Dimension::Id::OffsetTime &&
+                hdf5Columns[c].predType == H5::PredType::NATIVE_FLOAT)
+            {
+                float *fval = (float *)rawData[c].data();
+                for (PointId i = 0; i < chunkCount; ++i)
+                    fval[i] *= 1000;
+            }
+
+        // Once the points exist, ranges of them can be set concurrently if
+        // the table is threadSafe().  Every range sets all the columns,
+        // since dimensions of one point may share storage.
+        const PointId startId = view->size();
+        view->appendTablePoints(chunkCount);
+        auto setRange = [&](size_t begin, size_t end)
         {
-            throw icebridge_error("Error fetching column data");
-        }
+            //Not loving the position-linked data, but fine for now.
+            for (size_t c = 0; c < hdf5Columns.size(); ++c)
+            {
+                const hdf5::Hdf5ColumnData& column = hdf5Columns[c];
+                const Dimension::Id::Enum dim = dims[c];
+                char *p = rawData[c].data();
+
+                if (column.predType == H5::PredType::NATIVE_FLOAT)
+                    view->setFieldArray(dim, startId + begin, end - begin,
+                        (float *)p + begin);
+                else if (column.predType == H5::PredType::NATIVE_INT)
+                    view->setFieldArray(dim, startId + begin, end - begin,
+                        (int32_t *)p + begin);
+            }
+        };
+        if (view->table().threadSafe())
+            ThreadPool::shared().parallelFor(chunkCount, 4096, setRange);
+        else
+            setRange(0, chunkCount);
+
+        if (m_cb)
+            for (PointId id = startId; id < startId + chunkCount; ++id)
+                m_cb(*view, id);
+        numRead += chunkCount;
+        m_index += chunkCount;
     }
-    return count;
+    return numRead;
 }
 
 
@@ -138,6 +138,28 @@ TEST(IcebridgeReaderTest, testRead)
             0.0);           // relTime
 }
 
+TEST(IcebridgeReaderTest, testCount)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.icebridge"));
+    EXPECT_TRUE(reader.get());
+
+    Options options;
+    options.add("filename", getFilePath());
+    options.add("count", 1);
+    reader->setOptions(options);
+
+    PointTable table;
+    reader->prepare(table);
+    PointViewSet viewSet = reader->execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 1u);
+
+    checkDimension(*view, 0, Dimension::Id::StartPulse, 2408);
+    checkDimension(*view, 0, Dimension::Id::ReflectedPulse, 181);
+}
+
 TEST(IcebridgeReaderTest, testPipeline)
 {
     PipelineManager manager;
@@ -34,10 +34,16 @@
 
 #include "MrsidReader.hpp"
 
-#include <pdal/PointBuffer.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/util/Algorithm.hpp>
+
+#include <lidar/MG4PointReader.h>
+#include <lidar/PointIterator.h>
 
 #include <boost/algorithm/string.hpp>
 
+#include <limits>
+
 namespace pdal
 {
 
@@ -50,391 +56,307 @@ CREATE_SHARED_PLUGIN(1, 0, MrsidReader, Reader, s_info)
 
 std::string MrsidReader::getName() const { return s_info.name; }
 
-MrsidReader::MrsidReader(LizardTech::PointSource *ps)
-    : pdal::Reader()
-    , m_PS(ps), m_iter(NULL)
+namespace
 {
-    m_PS->retain();
-    return;
-}
 
-MrsidReader::~MrsidReader()
+// Points are decoded in blocks of this many, a channel at a time.
+const point_count_t BlockPoints = 65536;
+
+// Map LT common names to PDAL common names (from readers.las).
+std::string channelToDimName(const std::string& channel)
 {
-    m_iter->release();
-    m_PS->release();
+    static const std::vector<std::pair<std::string, std::string>> names =
+    {
+        { CHANNEL_NAME_EdgeFlightLine, "EdgeOfFlightLine" },
+        { CHANNEL_NAME_ClassId, "Classification" },
+        { CHANNEL_NAME_ScanAngle, "ScanAngleRank" },
+        { CHANNEL_NAME_ScanDir, "ScanDirectionFlag" },
+        { CHANNEL_NAME_GPSTime, "GpsTime" },
+        { CHANNEL_NAME_SourceId, "PointSourceId" },
+        { CHANNEL_NAME_ReturnNum, "ReturnNumber" },
+        { CHANNEL_NAME_NumReturns, "NumberOfReturns" }
+    };
+
+    for (const auto& n : names)
+        if (boost::iequals(channel, n.first))
+            return n.second;
+    return channel;
 }
 
-Dimension MrsidReader::LTChannelToPDalDimension(const LizardTech::ChannelInfo & channel, pdal::Schema const& dimensions) const
+Dimension::Type::Enum channelType(LizardTech::DataType type)
 {
+    using namespace Dimension::Type;
 
-    std::string name = channel.getName();
-
-    // Map LT common names to PDAL common names (from drivers.las)
-    if (boost::iequals(channel.getName(), CHANNEL_NAME_EdgeFlightLine)) name = "EdgeOfFlightLine";
-    if (boost::iequals(channel.getName(), CHANNEL_NAME_ClassId)) name = "Classification";
-    if (boost::iequals(channel.getName(), CHANNEL_NAME_ScanAngle)) name = "ScanAngleRank";
-    if (boost::iequals(channel.getName(), CHANNEL_NAME_ScanDir)) name = "ScanDirectionFlag";
-    if (boost::iequals(channel.getName(), CHANNEL_NAME_GPSTime)) name = "Time";
-    if (boost::iequals(channel.getName(), CHANNEL_NAME_SourceId)) name = "PointSourceId";
-    if (boost::iequals(channel.getName(), CHANNEL_NAME_ReturnNum)) name = "ReturnNumber";
-    if (boost::iequals(channel.getName(), CHANNEL_NAME_NumReturns)) name = "NumberOfReturns";
-
-    Dimension retval = dimensions.getDimension(name);
+    switch (type)
+    {
+    case LizardTech::DATATYPE_UINT8:
+        return Unsigned8;
+    case LizardTech::DATATYPE_SINT8:
+        return Signed8;
+    case LizardTech::DATATYPE_UINT16:
+        return Unsigned16;
+    case LizardTech::DATATYPE_SINT16:
+        return Signed16;
+    case LizardTech::DATATYPE_UINT32:
+        return Unsigned32;
+    case LizardTech::DATATYPE_SINT32:
+        return Signed32;
+    case LizardTech::DATATYPE_UINT64:
+        return Unsigned64;
+    case LizardTech::DATATYPE_SINT64:
+        return Signed64;
+    case LizardTech::DATATYPE_FLOAT32:
+        return Float;
+    case LizardTech::DATATYPE_FLOAT64:
+        return Double;
+    default:
+        return None;
+    }
+}
 
-    return retval;
+template<typename T>
+void setChannel(PointView& view, Dimension::Id::Enum id, PointId begin,
+    point_count_t count, const void *data)
+{
+    view.setFieldArray(id, begin, count, static_cast<const T *>(data));
 }
 
+} // unnamed namespace
 
-void MrsidReader::initialize()
-{
-    const LizardTech::PointInfo& pointinfo = m_PS->getPointInfo();
 
-    Schema const& dimensions(getDefaultDimensions());
-    for (unsigned int i=0; i<pointinfo.getNumChannels(); i++)
-    {
-        const LizardTech::ChannelInfo &channel = pointinfo.getChannel(i);
-        Dimension dim = LTChannelToPDalDimension(channel, dimensions);
-        m_schema.appendDimension(dim);
-    }
+MrsidReader::MrsidReader()
+    : pdal::Reader()
+    , m_PS(NULL)
+    , m_iter(NULL)
+    , m_fraction(1.0)
+    , m_eof(false)
+{}
+
 
-    setNumPoints(m_PS->getNumPoints());
-    pdal::Bounds<double> b(m_PS->getBounds().x.min, m_PS->getBounds().x.max,
-        m_PS->getBounds().y.min, m_PS->getBounds().y.max,
-        m_PS->getBounds().z.min,m_PS->getBounds().z.max);
-    setBounds(b);
-    m_iter = m_PS->createIterator(m_PS->getBounds(), 1.0,
-        m_PS->getPointInfo(), NULL);
+MrsidReader::~MrsidReader()
+{
+    closeIterator();
+    if (m_PS)
+        m_PS->release();
 }
 
 
 Options MrsidReader::getDefaultOptions()
 {
     Options options;
+
+    options.add("filename", "", "file to read from");
+    options.add("bounds", BOX3D(), "Only read points inside these bounds.  "
+        "Only the parts of the file that may hold such points are decoded.");
+    options.add("fraction", 1.0, "Fraction of the points to read, taken "
+        "from the coarsest levels of detail first.");
+    options.add("dimensions", "", "Comma-separated names of the dimensions "
+        "to read.  X, Y and Z are always read.  All dimensions are read if "
+        "none are given.");
     return options;
 }
 
-pdal::StageSequentialIterator* MrsidReader::createSequentialIterator(PointBuffer& buffer) const
+
+void MrsidReader::processOptions(const Options& options)
 {
-    return new pdal::iterators::sequential::MrsidReader(*this, buffer, getNumPoints());
+    m_bounds = options.getValueOrDefault<BOX3D>("bounds", BOX3D());
+    m_fraction = options.getValueOrDefault<double>("fraction", 1.0);
+    if (m_fraction <= 0.0 || m_fraction > 1.0)
+        throw pdal_error(getName() + ": option 'fraction' must be greater "
+            "than 0 and no greater than 1.");
+    m_dimNames = options.getValueOrDefault<StringList>("dimensions");
 }
 
-int MrsidReader::SchemaToPointInfo(const Schema &schema, LizardTech::PointInfo &pointInfo) const
+
+bool MrsidReader::setBounds(const BOX3D& bounds)
 {
-    schema::index_by_index const& dims = schema.getDimensions().get<schema::index>();
+    if (m_bounds.empty())
+        m_bounds = bounds;
+    else
+        m_bounds.clip(bounds);
+    return true;
+}
 
-    pointInfo.init(dims.size());
-    for (unsigned int idx=0; idx<dims.size(); idx++)
-    {
-        Dimension const& dim = dims[idx];
-
-        std::string name = dim.getName();
-        if (boost::iequals(dim.getName(),"EdgeOfFlightLine")) name = CHANNEL_NAME_EdgeFlightLine;
-        if (boost::iequals(dim.getName(), "Classification")) name = CHANNEL_NAME_ClassId;
-        if (boost::iequals(dim.getName(), "ScanAngleRank")) name = CHANNEL_NAME_ScanAngle;
-        if (boost::iequals(dim.getName(), "ScanDirectionFlag")) name = CHANNEL_NAME_ScanDir;
-        if (boost::iequals(dim.getName(), "Time")) name = CHANNEL_NAME_GPSTime;
-        if (boost::iequals(dim.getName(), "PointSourceId")) name = CHANNEL_NAME_SourceId;
-        if (boost::iequals(dim.getName(), "ReturnNumber")) name = CHANNEL_NAME_ReturnNum;
-        if (boost::iequals(dim.getName(), "NumberOfReturns")) name = CHANNEL_NAME_NumReturns;
-
-        if (dim.getInterpretation() == dimension::Float)
-        {
-            if (dim.getByteSize() == 8)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_FLOAT64, 64);
-            if (dim.getByteSize() == 4)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_FLOAT32, 32);
-        }
-        if (dim.getInterpretation() == dimension::SignedInteger)
-        {
-            if (dim.getByteSize() == 8)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_SINT64, 64);
-            if (dim.getByteSize() == 4)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_SINT32, 32);
-            if (dim.getByteSize() == 2)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_SINT16, 16);
-            if (dim.getByteSize() == 1)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_SINT8, 8);
-        }
-        if (dim.getInterpretation() == dimension::UnsignedInteger)
-        {
-            if (dim.getByteSize() == 8)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_UINT64, 64);
-            if (dim.getByteSize() == 4)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_UINT32, 32);
-            if (dim.getByteSize() == 2)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_UINT16, 16);
-            if (dim.getByteSize() == 1)
-                pointInfo.getChannel(idx).init(name.c_str(), LizardTech::DATATYPE_UINT8, 8);
-        }
 
+void MrsidReader::initialize()
+{
+    if (m_PS)
+        return;
+
+    LizardTech::MG4PointReader *reader = LizardTech::MG4PointReader::create();
+    try
+    {
+        reader->init(m_filename.c_str());
     }
-    return 0; //bug, do error checking
+    catch (...)
+    {
+        reader->release();
+        throw pdal_error(getName() + ": unable to open '" + m_filename +
+            "'.");
+    }
+    m_PS = reader;
 }
 
 
-uint32_t MrsidReader::processBuffer(PointBuffer& data, uint64_t index) const
+// Only the channels that are read are in the PointInfo the iterator is made
+// with, so the others are never decoded.
+void MrsidReader::addDimensions(PointLayoutPtr layout)
 {
-    const Schema& schema = data.getSchema();
-
-    // how many are they asking for?
-    uint64_t numPointsWanted = data.getCapacity();
+    using namespace Dimension;
 
-    // we can only give them as many as we have left
-    uint64_t numPointsAvailable = getNumPoints() - index;
-    if (numPointsAvailable < numPointsWanted)
-        numPointsWanted = numPointsAvailable;
+    const LizardTech::PointInfo& pointInfo = m_PS->getPointInfo();
 
+    m_channels.clear();
+    for (size_t i = 0; i < pointInfo.getNumChannels(); ++i)
+    {
+        const LizardTech::ChannelInfo& channel = pointInfo.getChannel(i);
 
-    LizardTech::PointData points;
-    // to do:  specify a PointInfo structure that reads only the channels we will output.
-    points.init(m_PS->getPointInfo(), (size_t)numPointsWanted);
-    size_t count = m_iter->getNextPoints(points);
+        Channel c;
+        c.m_index = i;
+        c.m_name = channel.getName();
+        c.m_type = channelType(channel.getDataType());
+        if (c.m_type == Type::None)
+        {
+            log()->get(LogLevel::Warning) << getName() << ": skipping "
+                "channel '" << c.m_name << "' of unsupported type." <<
+                std::endl;
+            continue;
+        }
 
-    uint32_t cnt = 0;
-    data.setNumPoints(0);
+        const std::string name = channelToDimName(c.m_name);
+        const Id::Enum id = Dimension::id(name);
+        if (m_dimNames.size() && id != Id::X && id != Id::Y &&
+                id != Id::Z && !contains(m_dimNames, name))
+            continue;
 
-    schema::index_by_index const& dims = schema.getDimensions().get<schema::index>();
+        c.m_id = layout->registerOrAssignDim(name, c.m_type);
+        m_channels.push_back(c);
+    }
 
-    for (uint32_t pointIndex=0; pointIndex<count; pointIndex++)
+    m_pointInfo.init(m_channels.size());
+    for (size_t i = 0; i < m_channels.size(); ++i)
     {
-        ++cnt;
-
-        for (unsigned int i=0; i < dims.size(); i++)
-        {
-            Dimension const& d = dims[i];
+        const LizardTech::ChannelInfo& channel =
+            pointInfo.getChannel(m_channels[i].m_index);
+        m_pointInfo.getChannel(i).init(channel.getName(),
+            channel.getDataType(), channel.getBits());
+    }
+}
 
-            if (d.getName() == "X" && d.getInterpretation() == dimension::Float && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_X))
-            {
-                double *pData = static_cast<double*>(points.getChannel(CHANNEL_NAME_X)->getData());
-                double value = static_cast<double>(pData[pointIndex]);
-                data.setField<double>(d, pointIndex, value);
-            }
-            else if (d.getName() == "X" && d.getInterpretation() == dimension::SignedInteger && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_X))
-            {
-                double *pData = static_cast<double*>(points.getChannel(CHANNEL_NAME_X)->getData());
-                int32_t value = static_cast<int32_t>(pData[pointIndex]);
-                data.setField<int32_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "Y" && d.getInterpretation() == dimension::Float && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_Y))
-            {
-                double *pData = static_cast<double*>(points.getChannel(CHANNEL_NAME_Y)->getData());
-                double value = static_cast<double>(pData[pointIndex]);
-                data.setField<double>(d, pointIndex, value);
-            }
-            else if (d.getName() == "Y" && d.getInterpretation() == dimension::SignedInteger && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_Y))
-            {
-                double *pData = static_cast<double*>(points.getChannel(CHANNEL_NAME_Y)->getData());
-                int32_t value = static_cast<int32_t>(pData[pointIndex]);
-                data.setField<int32_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "Z" && d.getInterpretation() == dimension::Float && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_Z))
-            {
-                double *pData = static_cast<double*>(points.getChannel(CHANNEL_NAME_Z)->getData());
-                double value = static_cast<double>(pData[pointIndex]);
-                data.setField<double>(d, pointIndex, value);
-            }
-            else if (d.getName() == "Z" && d.getInterpretation() == dimension::SignedInteger && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_Z))
-            {
-                double *pData = static_cast<double*>(points.getChannel(CHANNEL_NAME_Z)->getData());
-                int32_t value = static_cast<int32_t>(pData[pointIndex]);
-                data.setField<int32_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "Time" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_GPSTime))
-            {
-                double *pData = static_cast<double*>(points.getChannel(CHANNEL_NAME_GPSTime)->getData());
-                uint64_t  value = static_cast<uint64_t>(pData[pointIndex]);
-                data.setField<uint64_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "Intensity" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_Intensity))
-            {
-                uint16_t *pData = static_cast<uint16_t*>(points.getChannel(CHANNEL_NAME_Intensity)->getData());
-                uint16_t value = static_cast<uint16_t>(pData[pointIndex]);
-                data.setField<uint16_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "ReturnNumber" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_ReturnNum))
-            {
-                uint8_t *pData = static_cast<uint8_t*>(points.getChannel(CHANNEL_NAME_ReturnNum)->getData());
-                uint8_t value = static_cast<uint8_t>(pData[pointIndex]);
-                data.setField<uint8_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "NumberOfReturns" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_NumReturns))
-            {
-                uint8_t *pData = static_cast<uint8_t*>(points.getChannel(CHANNEL_NAME_NumReturns)->getData());
-                uint8_t value = static_cast<uint8_t>(pData[pointIndex]);
-                data.setField<uint8_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "ScanDirectionFlag" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_ScanDir))
-            {
-                uint8_t *pData = static_cast<uint8_t*>(points.getChannel(CHANNEL_NAME_NumReturns)->getData());
-                uint8_t value = static_cast<uint8_t>(pData[pointIndex]);
-                data.setField<uint8_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "ScanAngleRank" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_ScanAngle))
-            {
-                int8_t *pData = static_cast<int8_t*>(points.getChannel(CHANNEL_NAME_NumReturns)->getData());
-                int8_t value = static_cast<int8_t>(pData[pointIndex]);
-                data.setField<int8_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "EdgeOfFlightLine" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_EdgeFlightLine))
-            {
-                uint8_t *pData = static_cast<uint8_t*>(points.getChannel(CHANNEL_NAME_NumReturns)->getData());
-                uint8_t value = static_cast<uint8_t>(pData[pointIndex]);
-                data.setField<uint8_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "Classification" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_ClassId))
-            {
-                uint8_t *pData = static_cast<uint8_t*>(points.getChannel(CHANNEL_NAME_NumReturns)->getData());
-                uint8_t value = static_cast<uint8_t>(pData[pointIndex]);
-                data.setField<uint8_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "UserData" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_UserData))
-            {
-                uint8_t *pData = static_cast<uint8_t*>(points.getChannel(CHANNEL_NAME_NumReturns)->getData());
-                uint8_t value = static_cast<uint8_t>(pData[pointIndex]);
-                data.setField<uint8_t>(d, pointIndex, value);
-            }
-            else if (d.getName() == "PointSourceId" && m_PS->getPointInfo().hasChannel(CHANNEL_NAME_SourceId))
-            {
-                uint16_t *pData = static_cast<uint16_t*>(points.getChannel(CHANNEL_NAME_NumReturns)->getData());
-                uint16_t value = static_cast<uint16_t>(pData[pointIndex]);
-                data.setField<uint16_t>(d, pointIndex, value);
-            }
 
+void MrsidReader::ready(PointTableRef table)
+{
+    closeIterator();
 
-        }
+    LizardTech::Bounds bounds(m_PS->getBounds());
+    if (!m_bounds.empty())
+    {
+        const double huge = std::numeric_limits<double>::max();
+        bounds = LizardTech::Bounds(m_bounds.minx, m_bounds.maxx,
+            m_bounds.miny, m_bounds.maxy,
+            m_bounds.is_z_empty() ? -huge : m_bounds.minz,
+            m_bounds.is_z_empty() ? huge : m_bounds.maxz);
     }
-    data.setNumPoints(cnt);
-    assert(cnt <= data.getCapacity());
 
-    return cnt;
+    m_iter = m_PS->createIterator(bounds, m_fraction, m_pointInfo, NULL);
+    m_eof = false;
 }
 
-std::vector<Dimension> MrsidReader::getDefaultDimensions()
+
+point_count_t MrsidReader::read(PointViewPtr view, point_count_t count)
 {
-    std::vector<Dimension> output;
-
-    Dimension x("X", dimension::Float, 8);
-    x.setUUID("8c54ff0c-234f-43a2-8959-d9681ad1dea3");
-    x.setNamespace(s_getName());
-    output.push_back(x);
-
-    Dimension y("Y", dimension::Float, 8);
-    y.setUUID("9cee971b-2505-40cd-b7e9-f32c399afac7");
-    y.setNamespace(s_getName());
-    output.push_back(y);
-
-    Dimension z("Z", dimension::Float, 8);
-    z.setUUID("89dc4e36-6166-4bc8-bf95-5660657b0ea6");
-    z.setNamespace(s_getName());
-    output.push_back(z);
-
-    Dimension t("Time", dimension::Float, 8);
-    t.setUUID("3aea2826-4a6e-4c1b-ae27-7b2f24763ce1");
-    t.setNamespace(s_getName());
-    output.push_back(t);
-
-    Dimension blue("Blue", dimension::UnsignedInteger, 2);
-    blue.setUUID("f69977e3-23e8-4483-91b6-14cad981e9fd");
-    blue.setNamespace(s_getName());
-    output.push_back(blue);
-
-    Dimension red("Red", dimension::UnsignedInteger, 2);
-    red.setUUID("40a02a80-c399-42f0-a587-a286635b446e");
-    red.setNamespace(s_getName());
-    output.push_back(red);
-
-    Dimension green("Green", dimension::UnsignedInteger, 2);
-    green.setUUID("b329df2d-44f1-4f35-8993-d183dacaa1ff");
-    green.setNamespace(s_getName());
-    output.push_back(green);
-
-    Dimension cls("Classification", dimension::UnsignedInteger, 1);
-    cls.setUUID("ba1e2af8-6dfd-46a7-972a-ecc00f68914d");
-    cls.setNamespace(s_getName());
-    output.push_back(cls);
-
-    Dimension edge("EdgeOfFlightLine", dimension::UnsignedInteger, 1);
-    edge.setUUID("daed3bfc-650d-4265-93a7-d8093cbd75a0");
-    edge.setNamespace(s_getName());
-    output.push_back(edge);
-
-    Dimension intensity("Intensity", dimension::UnsignedInteger, 2);
-    intensity.setUUID("a43332a8-26b3-4609-a2b1-ddfda30e0565");
-    intensity.setNamespace(s_getName());
-    output.push_back(intensity);
-
-    Dimension num_returns("NumberOfReturns", dimension::UnsignedInteger, 1);
-    num_returns.setUUID("fa7c5d56-fb2b-4f81-9126-f183000c3cd8");
-    num_returns.setNamespace(s_getName());
-    output.push_back(num_returns);
-
-    Dimension return_no("ReturnNumber", dimension::UnsignedInteger, 1);
-    return_no.setUUID("e38cc121-8d26-482a-8920-c5599b2cdd19");
-    return_no.setNamespace(s_getName());
-    output.push_back(return_no);
-
-    Dimension scan_angle("ScanAngleRank", dimension::UnsignedInteger, 1);
-    scan_angle.setUUID("5d816875-10a5-4048-ad9d-fd3b8d065a6a");
-    scan_angle.setNamespace(s_getName());
-    output.push_back(scan_angle);
-
-    Dimension scan_dir("ScanDirectionFlag", dimension::UnsignedInteger, 1);
-    scan_dir.setUUID("d1054379-8bf6-4685-abfc-1f0ec37aa819");
-    scan_dir.setNamespace(s_getName());
-    output.push_back(scan_dir);
-
-    Dimension ptsource("PointSourceId", dimension::UnsignedInteger, 2);
-    ptsource.setUUID("be6e71af-b2f7-4107-a902-96e2fb71343f");
-    ptsource.setNamespace(s_getName());
-    output.push_back(ptsource);
-
-    Dimension userdata("UserData", dimension::UnsignedInteger, 1);
-    userdata.setUUID("551ca4be-cb6e-47a4-93a9-e403e9a06a8a");
-    userdata.setNamespace(s_getName());
-    output.push_back(userdata);
-
-    return output;
-}
+    using namespace Dimension;
 
+    LizardTech::PointData points;
+    point_count_t capacity = 0;
+    point_count_t numRead = 0;
 
-namespace iterators
-{
+    while (numRead < count && !m_eof)
+    {
+        const point_count_t wanted = std::min(BlockPoints, count - numRead);
+        if (wanted != capacity)
+        {
+            points.init(m_pointInfo, (size_t)wanted);
+            capacity = wanted;
+        }
 
-namespace sequential
-{
+        const point_count_t n = m_iter->getNextPoints(points);
+        if (n == 0)
+        {
+            m_eof = true;
+            break;
+        }
 
+        const PointId begin = view->size();
+        view->appendTablePoints(n);
+        for (size_t i = 0; i < m_channels.size(); ++i)
+        {
+            const Channel& c = m_channels[i];
+            const void *data =
+                points.getChannel(c.m_name.c_str())->getData();
 
-MrsidReader::MrsidReader(const pdal::MrsidReader& reader, PointBuffer& buffer, uint32_t numPoints)
-    : pdal::ReaderSequentialIterator(buffer)
-    , m_numPoints(numPoints)
-    , m_reader(reader)
-{
-    return;
-}
+            switch (c.m_type)
+            {
+            case Type::Unsigned8:
+                setChannel<uint8_t>(*view, c.m_id, begin, n, data);
+                break;
+            case Type::Signed8:
+                setChannel<int8_t>(*view, c.m_id, begin, n, data);
+                break;
+            case Type::Unsigned16:
+                setChannel<uint16_t>(*view, c.m_id, begin, n, data);
+                break;
+            case Type::Signed16:
+                setChannel<int16_t>(*view, c.m_id, begin, n, data);
+                break;
+            case Type::Unsigned32:
+                setChannel<uint32_t>(*view, c.m_id, begin, n, data);
+                break;
+            case Type::Signed32:
+                setChannel<int32_t>(*view, c.m_id, begin, n, data);
+                break;
+            case Type::Unsigned64:
+                setChannel<uint64_t>(*view, c.m_id, begin, n, data);
+                break;
+            case Type::Signed64:
+                setChannel<int64_t>(*view, c.m_id, begin, n, data);
+                break;
+            case Type::Float:
+                setChannel<float>(*view, c.m_id, begin, n, data);
+                break;
+            case Type::Double:
+                setChannel<double>(*view, c.m_id, begin, n, data);
+                break;
+            default:
+                break;
+            }
+        }
 
+        if (m_cb)
+            for (PointId idx = begin; idx < begin + n; ++idx)
+                m_cb(*view, idx);
+        numRead += n;
 
-uint64_t MrsidReader::skipImpl(uint64_t count)
-{
-    return count;
+        // The iterator hands out fewer points than asked for only once it
+        // has run out.
+        if (n < wanted)
+            m_eof = true;
+    }
+    return numRead;
 }
 
 
-bool MrsidReader::atEndImpl() const
+void MrsidReader::done(PointTableRef table)
 {
-    // const uint64_t numPoints = getStage().getNumPoints();
-    const uint64_t currPoint = getIndex();
-    return currPoint >= m_numPoints;
+    closeIterator();
 }
 
 
-uint32_t MrsidReader::readBufferImpl(PointBuffer& data)
+void MrsidReader::closeIterator()
 {
-    return m_reader.processBuffer(data, getIndex());
+    if (m_iter)
+        m_iter->release();
+    m_iter = NULL;
 }
 
-} // sequential
-
-
-} // iterators
-
-} // namespaces
+} // namespace pdal
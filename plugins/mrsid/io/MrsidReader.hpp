@@ -35,101 +35,71 @@
 #pragma once
 
 #include <pdal/Reader.hpp>
-#include <pdal/ReaderIterator.hpp>
-
+#include <pdal/StageFactory.hpp>
 #include <pdal/util/Bounds.hpp>
 
 #include <lidar/PointSource.h>
 
-namespace pdal
-{
-class PointBuffer;
-}
+#include <string>
+#include <vector>
+
 namespace LizardTech
 {
-class PointSource;
+class PointIterator;
 }
 
 namespace pdal
 {
 
-
-// The MrSIDReader wraps LT's PointSource abstraction
-//
+// The MrSIDReader wraps LT's PointSource abstraction.  Points are read
+// through an iterator over the channels that are read, the points within
+// the bounds and the fraction of the levels of detail asked for, so that
+// a subset of an MG4 file is all that's decoded.
 class PDAL_DLL MrsidReader : public pdal::Reader
 {
-
 public:
+    MrsidReader();
     virtual ~MrsidReader();
-    MrsidReader() : Writer() {};
-    MrsidReader(LizardTech::PointSource *ps);
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
 
     Options getDefaultOptions();
-    static std::vector<Dimension> getDefaultDimensions();
-    pdal::StageSequentialIterator*
-        createSequentialIterator(PointBuffer& buffer) const;
-
-    // this is called by the stage's iterator
-    uint32_t processBuffer(PointBuffer& data, uint64_t index) const;
+    virtual bool setBounds(const BOX3D& bounds);
 
 private:
+    struct Channel
+    {
+        // Index of the channel in the file's PointInfo.
+        size_t m_index;
+        std::string m_name;
+        Dimension::Id::Enum m_id;
+        Dimension::Type::Enum m_type;
+    };
+
     LizardTech::PointSource *m_PS;
     LizardTech::PointIterator *m_iter;
-
+    // The channels that are read, in the order of the PointInfo the
+    // iterator is made with.
+    std::vector<Channel> m_channels;
+    LizardTech::PointInfo m_pointInfo;
+    BOX3D m_bounds;
+    double m_fraction;
+    StringList m_dimNames;
+    bool m_eof;
+
+    virtual void processOptions(const Options& options);
     virtual void initialize();
-    int SchemaToPointInfo(const Schema &schema, LizardTech::PointInfo &pointInfo) const;
-    Dimension LTChannelToPDalDimension(const LizardTech::ChannelInfo & channel, pdal::Schema const& dimensions) const;
-    MrsidReader& operator=(const MrsidReader&); // not implemented
-    MrsidReader(const MrsidReader&); // not implemented
-};
-
-namespace iterators
-{
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void ready(PointTableRef table);
+    virtual point_count_t read(PointViewPtr view, point_count_t count);
+    virtual void done(PointTableRef table);
 
-namespace sequential
-{
-
-class MrsidReader : public pdal::ReaderSequentialIterator
-{
-public:
-    MrsidReader(const pdal::MrsidReader& reader, PointBuffer& buffer, uint32_t numPoints);
-
-private:
-    uint64_t skipImpl(uint64_t);
-    point_count_t readBufferImpl(PointBuffer&);
-    bool atEndImpl() const;
-    uint32_t m_numPoints;
-
-    const pdal::MrsidReader& m_reader;
-};
-
-} // sequential
-
-namespace random
-{
-
-class MrsidReader : public pdal::ReaderRandomIterator
-{
-public:
-    MrsidReader(const pdal::MrsidReader& reader,
-           PointBuffer& buffer, uint32_t numPoints);
-
-private:
-    uint64_t seekImpl(uint64_t);
-    uint32_t readBufferImpl(PointBuffer&);
-
-    const pdal::drivers::mrsid::MrsidReader& m_reader;
-    uint32_t m_numPoints;
+    void closeIterator();
 
+    MrsidReader& operator=(const MrsidReader&); // not implemented
+    MrsidReader(const MrsidReader&); // not implemented
 };
 
-
-} // random
-} // iterators
-
-
 } // namespaces
@@ -61,8 +61,10 @@ private:
     virtual StreamFactoryPtr createFactory() const
     {
         return StreamFactoryPtr(
-            new FilenameSubsetStreamFactory(m_filename, m_offset, m_length));
+            new MappedSubsetStreamFactory(m_filename, m_offset, m_length));
     }
+    virtual uint64_t fileOffset() const
+        { return m_offset; }
 
     NitfReader& operator=(const NitfReader&); // not implemented
     NitfReader(const NitfReader&); // not implemented
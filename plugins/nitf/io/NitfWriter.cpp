@@ -32,6 +32,7 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <cstdio>
 #include <memory>
 #include <vector>
 
@@ -132,7 +133,7 @@ BOX3D reprojectBoxToDD(const SpatialReference& reference, const BOX3D& box)
     return output;
 }
 
-NitfWriter::NitfWriter() :  LasWriter(&m_oss)
+NitfWriter::NitfWriter() :  LasWriter(&m_spool)
 {
     register_tre_plugins();
 }
@@ -167,6 +168,17 @@ void NitfWriter::processOptions(const Options& options)
     {}
 }
 
+void NitfWriter::ready(PointTableRef table)
+{
+    m_spoolName = m_filename + ".las.tmp";
+    m_spool.open(m_spoolName, std::ios::in | std::ios::out |
+        std::ios::trunc | std::ios::binary);
+    if (!m_spool)
+        throw pdal_error(getName() + ": Unable to create temporary file '" +
+            m_spoolName + "'.");
+    LasWriter::ready(table);
+}
+
 void NitfWriter::write(const PointViewPtr view)
 {
     m_bounds.grow(view->calculateBounds(true));
@@ -213,13 +225,10 @@ void NitfWriter::done(PointTableRef table)
         fld.setType(::nitf::Field::BINARY);
 
         flush();
-        m_oss.flush();
-        std::streambuf *buf = m_oss.rdbuf();
-        long size = buf->pubseekoff(0, m_oss.end);
-        buf->pubseekoff(0, m_oss.beg);
-
-        std::vector<char> bytes(size);
-        buf->sgetn(bytes.data(), size);
+        m_spool.close();
+        if (!m_spool)
+            throw pdal_error(getName() + ": Unable to write temporary "
+                "file '" + m_spoolName + "'.");
 
         des.getSubheader().setSubheaderFields(usrHdr);
 
@@ -339,7 +348,9 @@ void NitfWriter::done(PointTableRef table)
 
         ::nitf::SegmentWriter sWriter = writer.newDEWriter(0);
 
-        ::nitf::SegmentMemorySource sSource(bytes.data(), size, 0, 0, false);
+        ::nitf::IOHandle spool_io(m_spoolName.c_str(), NITF_ACCESS_READONLY,
+            NITF_OPEN_EXISTING);
+        ::nitf::SegmentFileSource sSource(spool_io, 0, 0);
         sWriter.attachSource(sSource);
 
         ::nitf::ImageWriter iWriter = writer.newImageWriter(0);
@@ -347,13 +358,19 @@ void NitfWriter::done(PointTableRef table)
 
         writer.write();
         output_io.close();
+        spool_io.close();
     }
     catch (except::Throwable & t)
     {
-        std::ostringstream oss;
-        // std::cout << t.getTrace();
+        std::remove(m_spoolName.c_str());
         throw pdal_error(t.getMessage());
     }
+    catch (...)
+    {
+        std::remove(m_spoolName.c_str());
+        throw;
+    }
+    std::remove(m_spoolName.c_str());
 }
 
 } // namespaces
@@ -34,6 +34,8 @@
 
 #pragma once
 
+#include <fstream>
+
 #include <pdal/StageFactory.hpp>
 #include <las/LasWriter.hpp>
 
@@ -52,6 +54,7 @@ public:
 
 private:
     virtual void processOptions(const Options& options);
+    virtual void ready(PointTableRef table);
     virtual void done(PointTableRef table);
     virtual void write(const PointViewPtr view);
 
@@ -73,7 +76,10 @@ private:
     std::string m_imgIdentifier2;
     std::string m_sic;
     std::string m_igeolob;
-    std::stringstream m_oss;
+    // The LAS output is spooled to a file next to the NITF file, which
+    // is streamed into the DES when the NITF file is written.
+    std::string m_spoolName;
+    std::fstream m_spool;
 
     NitfWriter& operator=(const NitfWriter&); // not implemented
     NitfWriter(const NitfWriter&); // not implemented
@@ -37,6 +37,7 @@
 
 #include <iostream>
 
+#include <pdal/ConnectionPool.hpp>
 #include <pdal/Dimension.hpp>
 #include <pdal/Utils.hpp>
 #include <pdal/util/FileUtils.hpp>
@@ -93,6 +94,45 @@ Connection connect(std::string connSpec)
 }
 
 
+namespace
+{
+
+std::string poolKey(const std::string& connSpec)
+{
+    return "oci:" + connSpec;
+}
+
+void closeConnection(void *con)
+{
+    delete (Connection *)con;
+}
+
+} // unnamed namespace
+
+
+Connection acquireConnection(std::string connSpec)
+{
+    ConnectionPool& pool = ConnectionPool::shared();
+    if (Connection *pooled = (Connection *)pool.acquire(poolKey(connSpec)))
+    {
+        Connection con(*pooled);
+        delete pooled;
+        return con;
+    }
+    return connect(connSpec);
+}
+
+
+void releaseConnection(std::string connSpec, Connection con)
+{
+    // Rolling back also tells us that the session is still good.
+    if (!con || con.use_count() != 1 || !con->Succeeded() || !con->Rollback())
+        return;
+    ConnectionPool::shared().release(poolKey(connSpec), new Connection(con),
+        closeConnection);
+}
+
+
 XMLSchema fetchSchema(Statement stmt, BlockPtr block)
 {
     // Fetch the XML that defines the schema for this point cloud
@@ -126,9 +166,7 @@ XMLSchema fetchSchema(Statement stmt, BlockPtr block)
         pc_schema_xml = pc_schema;
         CPLFree(pc_schema);
     }
-    std::ostringstream fname;
-    int cloudId = stmt->GetInteger(&(block->pc->pc_id)) ;
-    return XMLSchema(pc_schema_xml);
+    return *XMLSchema::cached(pc_schema_xml);
 }
 
 
@@ -119,6 +119,11 @@ public:
 typedef std::shared_ptr<Block> BlockPtr;
 
 PDAL_DLL Connection connect(std::string connSpec);
+// Take an idle session for 'connSpec' from the connection pool, or connect.
+PDAL_DLL Connection acquireConnection(std::string connSpec);
+// Roll back what wasn't committed and give the session to the connection
+// pool.  The session is dropped instead if anything else still holds it.
+PDAL_DLL void releaseConnection(std::string connSpec, Connection con);
 PDAL_DLL XMLSchema fetchSchema(Statement stmt, BlockPtr block);
 
 } // namespace pdal
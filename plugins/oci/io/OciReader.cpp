@@ -64,20 +64,48 @@ void OciReader::processOptions(const Options& options)
 
     m_updatePointSourceId =  options.getValueOrDefault<bool>(
         "populate_pointsourceid", false);
+    m_prefetchRows = options.getValueOrDefault<uint32_t>("prefetch_rows", 100);
+    m_prefetchMemory =
+        options.getValueOrDefault<uint32_t>("prefetch_memory", 0);
+    m_lobPrefetchSize =
+        options.getValueOrDefault<uint32_t>("lob_prefetch_size", 0);
+    m_readAhead = options.getValueOrDefault<bool>("read_ahead", true);
 }
 
+OciReader::~OciReader()
+{
+    if (m_fetch.valid())
+        m_fetch.wait();
+    m_stmt.reset();
+    m_block.reset();
+    m_current.reset();
+    if (!m_connection)
+        return;
+
+    // Don't hand the LOB prefetch setting on to the session's next user.
+    if (m_lobPrefetchSize)
+        m_connection->SetLobPrefetchSize(0);
+    releaseConnection(m_connSpec, std::move(m_connection));
+}
+
+
 void OciReader::initialize()
 {
     m_compression = false;
+    m_dimensional = false;
     GlobalEnvironment::get().initializeGDAL(log());
-    m_connection = connect(m_connSpec);
+    m_connection = acquireConnection(m_connSpec);
     m_block = BlockPtr(new Block(m_connection));
+    m_current = BlockPtr(new Block(m_connection));
 
     if (m_query.empty())
         throw pdal_error("'query' statement is empty. No data can be read "
             "from pdal::OciReader");
 
+    if (m_lobPrefetchSize)
+        m_connection->SetLobPrefetchSize(m_lobPrefetchSize);
     m_stmt = Statement(m_connection->CreateStatement(m_query.c_str()));
+    m_stmt->SetPrefetch(m_prefetchRows, m_prefetchMemory);
     m_stmt->Execute(0);
 
     validateQuery();
@@ -95,6 +123,10 @@ void OciReader::initialize()
         setSpatialReference(*m_spatialRef);
     else
         setSpatialReference(fetchSpatialReference(m_stmt, m_block));
+
+    // A single thread fetches the next block while one is unpacked.
+    if (m_readAhead)
+        m_pool.reset(new ThreadPool(1));
 }
 
 
@@ -151,9 +183,27 @@ Options OciReader::getDefaultOptions()
     Option xml_schema_dump("xml_schema_dump", std::string(),
         "Filename to dump the XML schema to.");
 
+    Option prefetch_rows("prefetch_rows", 100, "Number of block rows "
+        "fetched from the database ahead of those being read.");
+
+    Option prefetch_memory("prefetch_memory", 0, "Memory, in bytes, to "
+        "use for rows fetched ahead.  0 means no limit beyond "
+        "'prefetch_rows'.");
+
+    Option lob_prefetch_size("lob_prefetch_size", 0, "Bytes of each "
+        "block's point data returned with its row.  0 leaves the "
+        "session default.");
+
+    Option read_ahead("read_ahead", true, "Fetch the next block while "
+        "the points of the current one are unpacked.");
+
     options.add(connection);
     options.add(query);
     options.add(xml_schema_dump);
+    options.add(prefetch_rows);
+    options.add(prefetch_memory);
+    options.add(lob_prefetch_size);
+    options.add(read_ahead);
 
     return options;
 }
@@ -249,6 +299,7 @@ void OciReader::addDimensions(PointLayoutPtr layout)
     loadSchema(layout, schema);
     MetadataNode comp = schema.getMetadata().findChild("compression");
     m_compression = (comp.value() == "lazperf");
+    m_dimensional = (comp.value() == "dimensional");
 
     if (m_schemaFile.size())
     {
@@ -268,16 +319,16 @@ point_count_t OciReader::read(PointViewPtr view, point_count_t count)
     point_count_t totalNumRead = 0;
     while (totalNumRead < count)
     {
-        if (m_block->numRemaining() == 0)
+        if (m_current->numRemaining() == 0)
             if (!readOci(m_stmt, m_block))
                 return totalNumRead;
         PointId bufBegin = view->size();
 
         point_count_t numRead = 0;
         if (orientation() == Orientation::DimensionMajor)
-            numRead = readDimMajor(*view, m_block, count - totalNumRead);
+            numRead = readDimMajor(*view, m_current, count - totalNumRead);
         else if (orientation() == Orientation::PointMajor)
-            numRead = readPointMajor(*view, m_block, count - totalNumRead);
+            numRead = readPointMajor(*view, m_current, count - totalNumRead);
         PointId bufEnd = bufBegin + numRead;
         totalNumRead += numRead;
     }
@@ -355,18 +406,12 @@ point_count_t OciReader::readPointMajor(PointView& view,
     else
     {
         char *pos = seekPointMajor(block);
-        while (numRead < numPts && numRemaining > 0)
-        {
-            writePoint(view, nextId, pos);
-
-            if (m_cb)
-                m_cb(view, nextId);
-
-            pos += packedPointSize();
-            numRemaining--;
-            nextId++;
-            numRead++;
-        }
+        numRead = (std::min)(numPts, (point_count_t)numRemaining);
+        unpackPoints(view, nextId, numRead, pos);
+        if (m_cb)
+            for (PointId idx = nextId; idx < nextId + numRead; ++idx)
+                m_cb(view, idx);
+        numRemaining -= numRead;
     }
     block->setNumRemaining(numRemaining);
     return numRead;
@@ -387,27 +432,81 @@ char *OciReader::seekPointMajor(BlockPtr block)
 }
 
 
-// Read a block (set of points) from the database.
+void OciReader::done(PointTableRef table)
+{
+    // Don't leave a fetch running for a block that won't be read.
+    if (m_fetch.valid())
+        m_fetch.wait();
+}
+
+
+// Read a block (set of points) from the database into 'm_current'.
 bool OciReader::readOci(Statement stmt, BlockPtr block)
+{
+    bool fetched;
+    if (m_fetch.valid())
+    {
+        m_pool->wait(m_fetch);
+        fetched = m_fetchOk;
+    }
+    else
+        fetched = fetchBlock(stmt, block);
+    if (!fetched)
+    {
+        m_atEnd = true;
+        return false;
+    }
+
+    XMLSchema *s = findSchema(stmt, block);
+    updateSchema(*s);
+    MetadataNode comp = s->getMetadata().findChild("compression");
+    m_compression = (comp.value() == "lazperf");
+    m_dimensional = (comp.value() == "dimensional");
+
+    // Move the points out of the fetched row so that the next row can be
+    // fetched into 'block' while they're unpacked.
+    m_current->chunk.swap(block->chunk);
+    m_current->obj_id = block->obj_id;
+    m_current->num_points = block->num_points;
+    m_current->reset();
+    block->clearFetched();
+
+    if (m_readAhead)
+        m_fetch = m_pool->submit([this, stmt, block]()
+            { m_fetchOk = fetchBlock(stmt, block); });
+
+    // Dimensional blocks are decoded to packed points, while the next block
+    // is fetched, so that they're read like any other point-major block.
+    if (m_dimensional)
+    {
+        std::vector<char> points;
+        unpackDimensional((const char *)m_current->chunk.data(),
+            m_current->chunk.size(), m_current->numPoints(), points);
+        m_current->chunk.assign(points.begin(), points.end());
+    }
+    return true;
+}
+
+
+// Fetch a row, if one isn't already waiting, and read its points.  This
+// runs on the read-ahead thread, where the GDAL error handler that turns
+// OCI errors into exceptions isn't installed, so check for errors here.
+bool OciReader::fetchBlock(Statement stmt, BlockPtr block)
 {
     if (!block->fetched())
     {
+        CPLErrorReset();
         if (!stmt->Fetch())
         {
-            m_atEnd = true;
+            if (CPLGetLastErrorType() == CE_Failure)
+                throw pdal_error(getName() + ": Unable to fetch block: " +
+                    CPLGetLastErrorMsg());
             return false;
         }
         block->setFetched();
     }
     // Read the points from the blob in the row.
     readBlob(stmt, block);
-    XMLSchema *s = findSchema(stmt, block);
-    updateSchema(*s);
-    MetadataNode comp = s->getMetadata().findChild("compression");
-    m_compression = (comp.value() == "lazperf");
-
-    block->reset();
-    block->clearFetched();
     return true;
 }
 
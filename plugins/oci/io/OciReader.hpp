@@ -34,10 +34,13 @@
 
 #pragma once
 
+#include <future>
+#include <memory>
 #include <vector>
 
 #include <pdal/DbReader.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/ThreadPool.hpp>
 
 #include "OciCommon.hpp"
 
@@ -49,6 +52,7 @@ class PDAL_DLL OciReader : public DbReader
 public:
     OciReader()
     {}
+    ~OciReader();
 
     static void * create();
     static int32_t destroy(void *);
@@ -65,6 +69,7 @@ private:
     virtual point_count_t read(PointViewPtr view, point_count_t);
     virtual bool eof()
         { return m_atEnd; }
+    virtual void done(PointTableRef table);
 
     void validateQuery();
     void defineBlock(Statement statement, BlockPtr block) const;
@@ -79,11 +84,13 @@ private:
     char *seekDimMajor(const DimType& d, BlockPtr block);
     char *seekPointMajor(BlockPtr block);
     bool readOci(Statement stmt, BlockPtr block);
+    bool fetchBlock(Statement stmt, BlockPtr block);
     XMLSchema *findSchema(Statement stmt, BlockPtr block);
 
     Connection m_connection;
     Statement m_stmt;
-    BlockPtr m_block;
+    BlockPtr m_block;   // Row fetched from the query.
+    BlockPtr m_current; // Points being unpacked.
     std::string m_query;
     std::string m_schemaFile;
     std::string m_connSpec;
@@ -92,6 +99,14 @@ private:
     bool m_atEnd;
     std::map<int32_t, XMLSchema> m_schemas;
     bool m_compression;
+    bool m_dimensional;
+    uint32_t m_prefetchRows;
+    uint32_t m_prefetchMemory;
+    uint32_t m_lobPrefetchSize;
+    bool m_readAhead;
+    bool m_fetchOk;
+    std::future<void> m_fetch;
+    std::unique_ptr<ThreadPool> m_pool;
 
     OciReader& operator=(const OciReader&); // not implemented
     OciReader(const OciReader&); // not implemented
@@ -586,6 +586,35 @@ bool OWConnection::Commit()
     return true;
 }
 
+bool OWConnection::Rollback()
+{
+    if (CheckError(OCITransRollback(
+                   hSvcCtx,
+                   hError,
+                   OCI_DEFAULT), hError))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Set the amount of LOB data returned along with the locator when a row is
+// fetched, saving a round trip for each LOB that fits.
+bool OWConnection::SetLobPrefetchSize(unsigned int nBytes)
+{
+    ub4 nSize = (ub4) nBytes;
+
+    if (CheckError(OCIAttrSet((dvoid *) hSession, (ub4) OCI_HTYPE_SESSION,
+        (dvoid *) &nSize, (ub4) 0,
+        (ub4) OCI_ATTR_DEFAULT_LOBPREFETCH_SIZE, hError), hError))
+    {
+        return false;
+    }
+
+    return true;
+}
+
 /*****************************************************************************/
 /*                           OWStatement                                     */
 /*****************************************************************************/
@@ -702,6 +731,30 @@ bool OWStatement::Fetch(int nRows)
 }
 
 
+// Set the number of rows and the amount of memory the client fetches ahead
+// of the rows requested by Fetch().  Must be called before Execute().
+bool OWStatement::SetPrefetch(unsigned int nRows, unsigned int nMemory)
+{
+    ub4 nPrefetchRows = (ub4) nRows;
+    ub4 nPrefetchMemory = (ub4) nMemory;
+
+    if (CheckError(OCIAttrSet((dvoid *) hStmt, (ub4) OCI_HTYPE_STMT,
+        (dvoid *) &nPrefetchRows, (ub4) 0,
+        (ub4) OCI_ATTR_PREFETCH_ROWS, hError), hError))
+    {
+        return false;
+    }
+
+    if (CheckError(OCIAttrSet((dvoid *) hStmt, (ub4) OCI_HTYPE_STMT,
+        (dvoid *) &nPrefetchMemory, (ub4) 0,
+        (ub4) OCI_ATTR_PREFETCH_MEMORY, hError), hError))
+    {
+        return false;
+    }
+
+    return true;
+}
+
 bool OWStatement::GetNextField(
     int nIndex,
     char* pszName,
@@ -2166,6 +2219,69 @@ void OWStatement::BindArray(void* pData, long nSize)
                    (ub4) 0), hError);
 }
 
+// Bind an array of LONG VARRAW values.  Each element is 'nSize' bytes long
+// and starts with a four byte length of the data that follows.
+void OWStatement::BindLongVarRaw(char* pData, long nSize)
+{
+    OCIBind* hBind = NULL;
+
+    nNextBnd++;
+
+    CheckError(OCIBindByPos(
+                   hStmt,
+                   &hBind,
+                   hError,
+                   (ub4) nNextBnd,
+                   (dvoid*) pData,
+                   (sb4) nSize,
+                   (ub2) SQLT_LVB,
+                   (void*) NULL,
+                   (ub2*) NULL,
+                   (ub2*) NULL,
+                   (ub4) NULL,
+                   (ub4*) NULL,
+                   (ub4) OCI_DEFAULT), hError);
+
+    CheckError(OCIBindArrayOfStruct(
+                   hBind,
+                   hError,
+                   (ub4) nSize,
+                   (ub4) 0,
+                   (ub4) 0,
+                   (ub4) 0), hError);
+}
+
+// Bind an array of LOB locators, one for each row of the statement.
+void OWStatement::BindBlobArray(OCILobLocator** pphLocator)
+{
+    OCIBind* hBind = NULL;
+
+    nNextBnd++;
+
+    CheckError(OCIBindByPos(
+                   hStmt,
+                   &hBind,
+                   hError,
+                   (ub4) nNextBnd,
+                   (dvoid*) pphLocator,
+                   (sb4) sizeof(OCILobLocator*),
+                   (ub2) SQLT_BLOB,
+                   (void*) NULL,
+                   (ub2*) NULL,
+                   (ub2*) NULL,
+                   (ub4) NULL,
+                   (ub4*) NULL,
+                   (ub4) OCI_DEFAULT), hError);
+
+    CheckError(OCIBindArrayOfStruct(
+                   hBind,
+                   hError,
+                   (ub4) sizeof(OCILobLocator*),
+                   (ub4) 0,
+                   (ub4) 0,
+                   (ub4) 0), hError);
+}
+
 /*****************************************************************************/
 /*               Check for valid integer number in a string                  */
 /*****************************************************************************/
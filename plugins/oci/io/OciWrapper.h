@@ -372,6 +372,8 @@ public:
     OCIType*            GetPCType() {return hPCTDO; }
 
     bool                Commit(); // OCITransCommit()
+    bool                Rollback(); // OCITransRollback()
+    bool                SetLobPrefetchSize( unsigned int nBytes );
     bool                StartTransaction(); //  //OCITransStart()
     bool                EndTransaction() {return Commit(); }
 
@@ -405,6 +407,8 @@ public:
 
     bool                Execute( int nRows = 1 );
     bool                Fetch( int nRows = 1 );
+    bool                SetPrefetch( unsigned int nRows,
+                            unsigned int nMemory = 0 );
     unsigned int        nFetchCount;
 
     bool                GetNextField(
@@ -454,6 +458,8 @@ public:
     void                BindName( const char* pszName,
                             OCILobLocator** pphLocator );
     void                BindArray( void* pData, long nSize = 1);
+    void                BindLongVarRaw( char* pData, long nSize );
+    void                BindBlobArray( OCILobLocator** pphLocator );
     static void         Free( OCILobLocator** ppphLocator,
                             int nCount );
     bool                OpenBlob(OCILobLocator* phLocator, bool bReadOnly=true);
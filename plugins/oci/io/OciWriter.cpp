@@ -41,6 +41,8 @@
 
 #include "OciWriter.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
 #include <boost/algorithm/string.hpp>
@@ -70,14 +72,30 @@ OciWriter::OciWriter()
     , m_chunkCount(16)
     , m_capacity(0)
     , m_streamChunks(false)
+    , m_dimensional(false)
     , m_orientation(Orientation::PointMajor)
+    , m_batchSize(100)
+    , m_sessions(1)
+    , m_nextLoader(0)
 {}
 
 
+OciWriter::~OciWriter()
+{
+    // Don't tear down the sessions while an insert is still using them.
+    for (auto& load : m_loads)
+        if (load.valid())
+            load.wait();
+    for (auto& loader : m_loaders)
+        releaseConnection(m_connSpec, std::move(loader));
+    releaseConnection(m_connSpec, std::move(m_connection));
+}
+
+
 void OciWriter::initialize()
 {
     GlobalEnvironment::get().initializeGDAL(log());
-    m_connection = connect(m_connSpec);
+    m_connection = acquireConnection(m_connSpec);
     m_gtype = getGType();
 }
 
@@ -160,6 +178,10 @@ Options OciWriter::getDefaultOptions()
     Option store_dimensional_orientation("store_dimensional_orientation", false,
         "Store the points oriented in DIMENSION_INTERLEAVED instead of "
         "POINT_INTERLEAVED orientation");
+    Option batch_size("batch_size", 100,
+        "Number of blocks to insert with each statement execution");
+    Option sessions("sessions", 1,
+        "Number of database sessions used to insert blocks concurrently");
     options.add(is3d);
     options.add(solid);
     options.add(overwrite);
@@ -184,6 +206,8 @@ Options OciWriter::getDefaultOptions()
     options.add(stream_chunks);
     options.add(blob_chunk_count);
     options.add(store_dimensional_orientation);
+    options.add(batch_size);
+    options.add(sessions);
 
     return options;
 }
@@ -549,6 +573,12 @@ void OciWriter::createPCEntry()
         r.add("compression", "lazperf");
         r.add("version", "1.0");
     }
+    else if (m_dimensional)
+    {
+        MetadataNode r = node.add("root");
+        r.add("compression", "dimensional");
+        r.add("version", "1.0");
+    }
     XMLSchema schema(dbDimTypes(), node, m_orientation);
     std::string schemaData = schema.xml();
 
@@ -710,11 +740,30 @@ void OciWriter::processOptions(const Options& options)
         Orientation::PointMajor;
     m_capacity = options.getValueOrThrow<uint32_t>("capacity");
     m_connSpec = options.getValueOrDefault<std::string>("connection", "");
-    m_compression = options.getValueOrDefault<bool>("compression", false);
-
-    if (m_compression && (m_orientation == Orientation::DimensionMajor))
-        throw pdal_error("LAZperf compression not supported for "
+    // 'compression' was a switch for LAZperf and still accepts a boolean.
+    std::string compression =
+        options.getValueOrDefault<std::string>("compression", "false");
+    m_compression = false;
+    m_dimensional = boost::iequals(compression, "dimensional");
+    if (boost::iequals(compression, "lazperf"))
+        m_compression = true;
+    else if (!m_dimensional && !boost::iequals(compression, "none"))
+        m_compression = options.getValueOrDefault<bool>("compression", false);
+    processPrecision(options, m_compression);
+
+    if ((m_compression || m_dimensional) &&
+        (m_orientation == Orientation::DimensionMajor))
+        throw pdal_error("Patch compression not supported for "
             "dimension-major point storage."); 
+
+    m_batchSize = getDefaultedOption<uint32_t>(options, "batch_size");
+    if (m_batchSize == 0)
+        throw pdal_error(getName() + ": option 'batch_size' must be "
+            "greater than 0.");
+    m_sessions = getDefaultedOption<uint32_t>(options, "sessions");
+    if (m_sessions == 0)
+        throw pdal_error(getName() + ": option 'sessions' must be "
+            "greater than 0.");
 }
 
 
@@ -758,6 +807,18 @@ void OciWriter::writeInit()
     }
     createPCEntry();
     m_triggerName = shutOff_SDO_PC_Trigger();
+    m_blockInsert = blockInsertSql();
+
+    // With more than one session, blocks are inserted on sessions of their
+    // own, leaving this one for the point cloud entry and the DDL.
+    if (m_sessions > 1)
+    {
+        m_pool.reset(new ThreadPool(m_sessions));
+        for (uint32_t i = 0; i < m_sessions; ++i)
+            m_loaders.push_back(acquireConnection(m_connSpec));
+        m_loadBatches.resize(m_sessions);
+        m_loads.resize(m_sessions);
+    }
     m_sdo_pc_is_initialized = true;
 }
 
@@ -782,6 +843,8 @@ void OciWriter::done(PointTableRef table)
     if (!m_connection)
         return;
 
+    flushBlocks();
+    finishLoads();
     m_connection->Commit();
     if (m_createIndex && m_bDidCreateBlockTable)
     {
@@ -799,38 +862,6 @@ void OciWriter::done(PointTableRef table)
 }
 
 
-void OciWriter::setElements(Statement statement, OCIArray* elem_info)
-{
-    statement->AddElement(elem_info, 1);
-    if (m_solid == true)
-    {
-        //"(1,1007,3)";
-        statement->AddElement(elem_info, 1007);
-    }
-    else
-    {
-        //"(1,1003,3)";
-        statement->AddElement(elem_info, 1003);
-    }
-    statement->AddElement(elem_info, 3);
-}
-
-
-void OciWriter::setOrdinates(Statement statement, OCIArray* ordinates,
-    const BOX3D& extent)
-{
-
-    statement->AddElement(ordinates, extent.minx);
-    statement->AddElement(ordinates, extent.miny);
-    if (m_3d)
-        statement->AddElement(ordinates, extent.minz);
-
-    statement->AddElement(ordinates, extent.maxx);
-    statement->AddElement(ordinates, extent.maxy);
-    if (m_3d)
-        statement->AddElement(ordinates, extent.maxz);
-}
-
 void OciWriter::writePointMajor(PointViewPtr view, std::vector<char>& outbuf)
 {
     m_callback->setTotal(view->size());
@@ -842,30 +873,25 @@ void OciWriter::writePointMajor(PointViewPtr view, std::vector<char>& outbuf)
         SignedLazPerfBuf compBuf(outbuf);
         LazPerfCompressor<SignedLazPerfBuf> compressor(compBuf, dbDimTypes());
 
-        std::vector<char> ptBuf(m_packedPointSize);
-        for (PointId idx = 0; idx < view->size(); ++idx)
-        {
-            size_t size = readPoint(*view, idx, ptBuf.data());
-            compressor.compress(ptBuf.data(), size);
-        }
+        // Pack all the points, then compress them one at a time.
+        std::vector<char> ptBuf(m_packedPointSize * view->size());
+        size_t size = packPoints(*view, 0, view->size(), ptBuf.data());
+        size_t pointSize = view->size() ? size / view->size() : 0;
+        for (size_t pos = 0; pos < size; pos += pointSize)
+            compressor.compress(ptBuf.data() + pos, pointSize);
         compressor.done();
 #else
         throw pdal_error("Can't compress without LAZperf.");
 #endif
     }
+    else if (m_dimensional)
+    {
+        outbuf.resize(0);
+        packDimensional(*view, 0, view->size(), outbuf, true);
+    }
     else
     {
-        size_t totalSize = 0;
-        char *pos = outbuf.data();
-        for (PointId idx = 0; idx < view->size(); ++idx)
-        {
-            size_t size = readPoint(*view.get(), idx, pos);
-            totalSize += size;
-            if (idx % 100 == 0)
-                m_callback->invoke(idx);
-            pos += size;
-        }
-        outbuf.resize(totalSize);
+        outbuf.resize(packPoints(*view, 0, view->size(), outbuf.data()));
     }
     m_callback->invoke(view->size());
 }
@@ -893,10 +919,12 @@ void OciWriter::writeDimMajor(PointViewPtr view, std::vector<char>& outbuf)
 }
 
 
-void OciWriter::writeTile(const PointViewPtr view)
+std::string OciWriter::blockInsertSql()
 {
     bool usePartition = (m_blockTablePartitionColumn.size() != 0);
 
+    // Values that are the same for every block go in the statement text so
+    // that only the per-block columns need array binds.
     std::ostringstream oss;
     oss << "INSERT INTO "<< m_blockTableName <<
         "(OBJ_ID, BLK_ID, NUM_POINTS, POINTS, PCBLK_MIN_RES, BLK_EXTENT, "
@@ -904,116 +932,189 @@ void OciWriter::writeTile(const PointViewPtr view)
     if (usePartition)
         oss << "," << m_blockTablePartitionColumn;
     oss << ") "
-        "VALUES ( :1, :2, :3, :4, 1, mdsys.sdo_geometry(:5, :6, null,:7, :8)"
-        ", 1, 0, 1";
+        "VALUES (" << m_pc_id << ", :1, :2, :3, 1, "
+        "mdsys.sdo_geometry(" << m_gtype << ", ";
+    if (m_srid == 0)
+        oss << "null";
+    else
+        oss << m_srid;
+    oss << ", null, mdsys.sdo_elem_info_array" << createPCElemInfo() <<
+        ", mdsys.sdo_ordinate_array(:4, :5, :6, :7";
+    if (m_3d)
+        oss << ", :8, :9";
+    oss << ")), 1, 0, 1";
     if (usePartition)
-        oss << ", :9";
-    oss <<")";
- 
-    Statement statement(m_connection->CreateStatement(oss.str().c_str()));
-
-    // :1
-    statement->Bind(&m_pc_id);
-    log()->get(LogLevel::Debug4) << "Block obj_id " << m_pc_id << std::endl;
-
-    // :2
-    statement->Bind(&m_lastBlockId);
-    m_lastBlockId++;
-    log()->get(LogLevel::Debug4) << "Last BlockId " <<
-        m_lastBlockId << std::endl;
-
-    // :3
-    long long_num_points = static_cast<long>(view->size());
-    statement->Bind(&long_num_points);
-    log()->get(LogLevel::Debug4) << "Num points " <<
-        long_num_points << std::endl;
+        oss << ", " << m_blockTablePartitionValue;
+    oss << ")";
+    return oss.str();
+}
 
-    // :4
 
+void OciWriter::writeTile(const PointViewPtr view)
+{
     //NOTE: packed point size is guaranteed to be of sufficient size to hold
     // a point's data, but it may be larger than the actual size of a point
     // if location scaling is being used. 
     std::vector<char> outbuf(m_packedPointSize * view->size());
-    size_t totalSize = 0;
     if (m_orientation == Orientation::DimensionMajor)
         writeDimMajor(view, outbuf);
     else if (m_orientation == Orientation::PointMajor)
         writePointMajor(view, outbuf);
 
+    // x0, x1, y0, y1, z0, z1, bUse3d
+    BOX3D bounds = view->calculateBounds(true);
+    // Cumulate a total bounds for the file.
+    m_pcExtent.grow(bounds);
 
-    log()->get(LogLevel::Debug4) << "Blob size " << outbuf.size() << std::endl;
-    OCILobLocator* locator;
-    if (m_streamChunks)
+    m_lastBlockId++;
+    PDAL_LOG(log(), LogLevel::Debug4) << "Block id " << m_lastBlockId <<
+        ", num points " << view->size() << ", blob size " <<
+        outbuf.size() << std::endl;
+    PDAL_LOG(log(), LogLevel::Debug4) << "Bounds " << bounds << std::endl;
+
+    m_batch.m_ids.push_back(m_lastBlockId);
+    m_batch.m_numPoints.push_back(static_cast<long>(view->size()));
+    m_batch.m_points.push_back(std::move(outbuf));
+
+    std::vector<double> ordinates;
+    ordinates.push_back(bounds.minx);
+    ordinates.push_back(bounds.miny);
+    if (m_3d)
+        ordinates.push_back(bounds.minz);
+    ordinates.push_back(bounds.maxx);
+    ordinates.push_back(bounds.maxy);
+    if (m_3d)
+        ordinates.push_back(bounds.maxz);
+    for (size_t i = 0; i < ordinates.size(); ++i)
+        m_batch.m_ordinates[i].push_back(ordinates[i]);
+
+    if (m_batch.size() >= m_batchSize)
+        flushBlocks();
+}
+
+
+void OciWriter::flushBlocks()
+{
+    if (m_batch.size() == 0)
+        return;
+
+    PDAL_LOG(log(), LogLevel::Debug4) << "Inserting " << m_batch.size() <<
+        " blocks" << std::endl;
+    if (m_loaders.empty())
     {
-        statement->WriteBlob(&locator, outbuf.data(), (long)outbuf.size(),
-            m_chunkCount);
-        statement->BindBlob(&locator);
+        insertBlocks(m_connection, m_batch);
+        m_batch = BlockBatch();
+        return;
     }
-    else
-        statement->Bind(outbuf.data(), (long)outbuf.size());
 
-    // :5
-    long long_gtype = static_cast<long>(m_gtype);
-    statement->Bind(&long_gtype);
-    log()->get(LogLevel::Debug4) << "OCI geometry type " <<
-        m_gtype << std::endl;
+    // Hand the batch to the sessions in turn.  A session inserts one
+    // batch at a time, so wait for its last one first.
+    size_t loader = m_nextLoader;
+    m_nextLoader = (m_nextLoader + 1) % m_loaders.size();
+    if (m_loads[loader].valid())
+        m_pool->wait(m_loads[loader]);
 
-    // :6
-    long srid;
+    m_loadBatches[loader].reset(new BlockBatch(std::move(m_batch)));
+    m_batch = BlockBatch();
 
-    if (m_srid != 0)
-        srid = m_srid;
-    statement->Bind(&srid);
-    log()->get(LogLevel::Debug4) << "OCI SRID " << srid << std::endl;
+    Connection connection = m_loaders[loader];
+    BlockBatch *batch = m_loadBatches[loader].get();
+    m_loads[loader] = m_pool->submit([this, connection, batch]()
+        { insertBlocks(connection, *batch); });
+}
 
 
-    // :7
-    OCIArray* sdo_elem_info = 0;
-    m_connection->CreateType(&sdo_elem_info, m_connection->GetElemInfoType());
-    setElements(statement, sdo_elem_info);
-    statement->Bind(&sdo_elem_info, m_connection->GetElemInfoType());
+void OciWriter::finishLoads()
+{
+    for (auto& load : m_loads)
+        if (load.valid())
+            m_pool->wait(load);
+    for (auto& connection : m_loaders)
+        connection->Commit();
+    m_loadBatches.clear();
+}
 
-    // :8
-    OCIArray* sdo_ordinates = 0;
-    m_connection->CreateType(&sdo_ordinates, m_connection->GetOrdinateType());
 
-    // x0, x1, y0, y1, z0, z1, bUse3d
-    BOX3D bounds = view->calculateBounds(true);
-    // Cumulate a total bounds for the file.
-    m_pcExtent.grow(bounds);
+// Insert a batch of blocks with one execution of the insert statement.
+// This may run on a thread of the pool, so it only reads the writer's
+// settings.
+void OciWriter::insertBlocks(Connection connection, BlockBatch& batch)
+{
+    size_t count = batch.size();
+    Statement statement(connection->CreateStatement(m_blockInsert.c_str()));
 
-    setOrdinates(statement, sdo_ordinates, bounds);
-    statement->Bind(&sdo_ordinates, m_connection->GetOrdinateType());
-    log()->get(LogLevel::Debug4) << "Bounds " << bounds << std::endl;
+    // :1, :2
+    statement->Bind(batch.m_ids.data());
+    statement->Bind(batch.m_numPoints.data());
 
-    // :9
-    if (usePartition)
+    // :3
+    std::vector<OCILobLocator*> locators;
+    std::vector<char> points;
+    if (m_streamChunks)
+    {
+        locators.resize(count, NULL);
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::vector<char>& buf = batch.m_points[i];
+            statement->WriteBlob(&locators[i], buf.data(), (int)buf.size(),
+                m_chunkCount);
+        }
+        statement->BindBlobArray(locators.data());
+    }
+    else
     {
-        long long_partition_id = (long)m_blockTablePartitionValue;
-        statement->Bind(&long_partition_id);
-        log()->get(LogLevel::Debug4) << "Partition ID " << long_partition_id <<
-            std::endl;
+        // Each LONG VARRAW element is a four byte length followed by the
+        // data, padded to the size of the largest block.
+        size_t maxSize = 0;
+        for (auto& buf : batch.m_points)
+            maxSize = (std::max)(maxSize, buf.size());
+        size_t eltSize = (sizeof(uint32_t) + maxSize + 3) & ~(size_t)3;
+
+        points.resize(eltSize * count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::vector<char>& buf = batch.m_points[i];
+            char *pos = points.data() + i * eltSize;
+            uint32_t len = (uint32_t)buf.size();
+            memcpy(pos, &len, sizeof(len));
+            memcpy(pos + sizeof(len), buf.data(), buf.size());
+        }
+        statement->BindLongVarRaw(points.data(), (long)eltSize);
     }
 
+    // :4 - :9
+    size_t numOrdinates = m_3d ? 6 : 4;
+    for (size_t i = 0; i < numOrdinates; ++i)
+        statement->Bind(batch.m_ordinates[i].data());
+
+    // The GDAL error handler that turns OCI errors into exceptions is only
+    // installed on the main thread, so check the status as well.
+    bool ok;
+    std::string error;
     try
     {
-        statement->Execute();
+        ok = statement->Execute((int)count);
+        if (!ok)
+            error = CPLGetLastErrorMsg();
     }
     catch (std::runtime_error const& e)
     {
-        std::ostringstream oss;
-        oss << "Failed to insert block # into '" << m_blockTableName <<
-            "' table. Does the table exist? "  << std::endl;
-        oss << e.what() << std::endl;
-        throw std::runtime_error(oss.str());
+        ok = false;
+        error = e.what();
     }
 
     if (m_streamChunks)
         // We don't use a locator unless we're stream-writing the data.
-        OWStatement::Free(&locator, 1);
+        OWStatement::Free(locators.data(), (int)count);
 
-    m_connection->DestroyType(&sdo_elem_info);
-    m_connection->DestroyType(&sdo_ordinates);
+    if (!ok)
+    {
+        std::ostringstream oss;
+        oss << "Failed to insert " << count << " blocks into '" <<
+            m_blockTableName << "' table. Does the table exist? " <<
+            std::endl << error << std::endl;
+        throw pdal_error(oss.str());
+    }
 }
 
 
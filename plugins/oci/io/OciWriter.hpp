@@ -36,6 +36,10 @@
 
 #include <pdal/DbWriter.hpp>
 #include <pdal/GDALUtils.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <future>
+#include <memory>
 
 pdal::Writer* createOciWriter();
 
@@ -48,6 +52,7 @@ class PDAL_DLL OciWriter : public DbWriter
 {
 public:
     OciWriter();
+    ~OciWriter();
 
     static void * create();
     static int32_t destroy(void *);
@@ -56,6 +61,19 @@ public:
     Options getDefaultOptions();
 
 private:
+    // Blocks waiting to be inserted with a single statement execution.
+    // The scalar columns are kept in arrays so they can be bound directly.
+    struct BlockBatch
+    {
+        std::vector<long> m_ids;
+        std::vector<long> m_numPoints;
+        std::vector<std::vector<char>> m_points;
+        std::vector<double> m_ordinates[6];
+
+        size_t size() const
+            { return m_ids.size(); }
+    };
+
     template<typename T>
     T getDefaultedOption(const Options& options,
         const std::string& option_name)
@@ -72,6 +90,10 @@ private:
     virtual void done(PointTableRef table);
     void writeInit();
     void writeTile(const PointViewPtr view);
+    std::string blockInsertSql();
+    void flushBlocks();
+    void finishLoads();
+    void insertBlocks(Connection connection, BlockBatch& batch);
 
     void runCommand(std::ostringstream const& command);
     void wipeBlockTable();
@@ -85,9 +107,6 @@ private:
     void runFileSQL(std::string const& filename);
     bool isGeographic(int32_t srid);
     std::string loadSQLData(std::string const& filename);
-    void setOrdinates(Statement statement, OCIArray* ordinates,
-        const BOX3D& extent);
-    void setElements(Statement statement, OCIArray* elem_info);
     void updatePCExtent();
     std::string shutOff_SDO_PC_Trigger();
     void turnOn_SDO_PC_Trigger(std::string trigger_name);
@@ -114,6 +133,7 @@ private:
     bool m_overwrite;
     bool m_trace;
     bool m_compression;
+    bool m_dimensional;
 
     std::string m_baseTableName;
     std::string m_cloudColumnName;
@@ -132,6 +152,16 @@ private:
     bool m_streamChunks;
     Orientation::Enum m_orientation;
     std::string m_connSpec;
+    uint32_t m_batchSize;
+    uint32_t m_sessions;
+    std::string m_blockInsert;
+    BlockBatch m_batch;
+    // Extra sessions that insert batches while the next one is packed.
+    std::vector<Connection> m_loaders;
+    std::vector<std::unique_ptr<BlockBatch>> m_loadBatches;
+    std::vector<std::future<void>> m_loads;
+    std::unique_ptr<ThreadPool> m_pool;
+    size_t m_nextLoader;
 
     OciWriter& operator=(const OciWriter&); // not implemented
     OciWriter(const OciWriter&); // not implemented
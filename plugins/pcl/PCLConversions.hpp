@@ -39,6 +39,9 @@
 
 #include <pdal/PointView.hpp>
 
+#include <algorithm>
+#include <vector>
+
 #include <pcl/io/pcd_io.h>
 #include <pcl/for_each_type.h>
 #include <pcl/point_types.h>
@@ -49,13 +52,10 @@ namespace pdal
 namespace pclsupport
 {
 
-template<typename CLOUDFETCH>
-void setValues(PointViewPtr view, Dimension::Id::Enum dim, size_t numPts,
-    CLOUDFETCH fetcher)
-{
-    for (size_t i = 0; i < numPts; ++i)
-        view->setField(dim, i, fetcher(i));
-}
+// PCL's clouds own arrays of float points, so views can't be handed to PCL
+// in place.  Conversions are done a batch of points at a time, reading and
+// writing whole columns of the view at once.
+const point_count_t ConversionBatchSize = 4096;
 
 /**
  * \brief Convert PCD point cloud to PDAL.
@@ -65,50 +65,72 @@ void setValues(PointViewPtr view, Dimension::Id::Enum dim, size_t numPts,
 template <typename CloudT>
 void PCDtoPDAL(CloudT &cloud, PointViewPtr view, BOX3D const& bounds)
 {
-    typedef typename pcl::traits::fieldList<typename CloudT::PointType>::type
-        FieldList;
+    typedef typename CloudT::PointType PointT;
+    typedef typename pcl::traits::fieldList<PointT>::type FieldList;
 
-    if (pcl::traits::has_xyz<typename CloudT::PointType>::value)
-    {
-        auto getX = [&cloud, &bounds](size_t i)
-            { return cloud.points[i].x + bounds.minx; };
-        auto getY = [&cloud, &bounds](size_t i)
-            { return cloud.points[i].y + bounds.miny; };
-        auto getZ = [&cloud, &bounds](size_t i)
-            { return cloud.points[i].z + bounds.minz; };
-        setValues(view, Dimension::Id::X, cloud.points.size(), getX);
-        setValues(view, Dimension::Id::Y, cloud.points.size(), getY);
-        setValues(view, Dimension::Id::Z, cloud.points.size(), getZ);
-    }
+    const bool hasXyz = pcl::traits::has_xyz<PointT>::value;
+    const bool hasIntensity = pcl::traits::has_intensity<PointT>::value;
+    const bool hasColor = pcl::traits::has_color<PointT>::value;
 
-    if (pcl::traits::has_intensity<typename CloudT::PointType>::value)
+    const point_count_t batchSize = ConversionBatchSize;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    std::vector<double> zs(batchSize);
+    std::vector<float> intensities(batchSize);
+    std::vector<uint8_t> reds(batchSize);
+    std::vector<uint8_t> greens(batchSize);
+    std::vector<uint8_t> blues(batchSize);
+    for (PointId begin = 0; begin < cloud.points.size(); begin += batchSize)
     {
-        for (size_t i = 0; i < cloud.points.size(); ++i)
+        point_count_t count = (std::min)(batchSize,
+            (point_count_t)cloud.points.size() - begin);
+
+        if (hasXyz)
         {
-            float f;
-            bool hasIntensity = true;
-
-            typename CloudT::PointType p = cloud.points[i];
-            pcl::for_each_type<FieldList>
-                (pcl::CopyIfFieldExists<typename CloudT::PointType, float>
-                    (p, "intensity", hasIntensity, f));
-            view->setField(Dimension::Id::Intensity, i, f);
+            for (PointId i = 0; i < count; ++i)
+            {
+                const PointT& p = cloud.points[begin + i];
+                xs[i] = p.x + bounds.minx;
+                ys[i] = p.y + bounds.miny;
+                zs[i] = p.z + bounds.minz;
+            }
+            view->setFieldArray(Dimension::Id::X, begin, count, xs.data());
+            view->setFieldArray(Dimension::Id::Y, begin, count, ys.data());
+            view->setFieldArray(Dimension::Id::Z, begin, count, zs.data());
         }
-    }
 
-    if (pcl::traits::has_color<typename CloudT::PointType>::value)
-    {
-        for (size_t i = 0; i < cloud.points.size(); ++i)
+        if (hasIntensity)
         {
-            uint32_t v;
-
-            typename CloudT::PointType p = cloud.points[i];
-            pcl::for_each_type<FieldList>
-               (pcl::CopyIfFieldExists<typename CloudT::PointType, uint32_t>
-                   (p, "rgba", v));
-            view->setField<uint8_t>(Dimension::Id::Red, i, (v & 0x00FF0000) >> 16);
-            view->setField<uint8_t>(Dimension::Id::Green, i, (v & 0x0000FF00) >> 8);
-            view->setField<uint8_t>(Dimension::Id::Blue, i, (v & 0x000000FF));
+            for (PointId i = 0; i < count; ++i)
+            {
+                bool found = true;
+                pcl::for_each_type<FieldList>
+                    (pcl::CopyIfFieldExists<PointT, float>
+                        (cloud.points[begin + i], "intensity", found,
+                         intensities[i]));
+            }
+            view->setFieldArray(Dimension::Id::Intensity, begin, count,
+                intensities.data());
+        }
+
+        if (hasColor)
+        {
+            for (PointId i = 0; i < count; ++i)
+            {
+                uint32_t v;
+                pcl::for_each_type<FieldList>
+                    (pcl::CopyIfFieldExists<PointT, uint32_t>
+                        (cloud.points[begin + i], "rgba", v));
+                reds[i] = (v & 0x00FF0000) >> 16;
+                greens[i] = (v & 0x0000FF00) >> 8;
+                blues[i] = (v & 0x000000FF);
+            }
+            view->setFieldArray(Dimension::Id::Red, begin, count,
+                reds.data());
+            view->setFieldArray(Dimension::Id::Green, begin, count,
+                greens.data());
+            view->setFieldArray(Dimension::Id::Blue, begin, count,
+                blues.data());
         }
     }
 }
@@ -130,59 +152,71 @@ void PCDtoPDAL(CloudT &cloud, PointViewPtr view)
 template <typename CloudT>
 void PDALtoPCD(PointViewPtr view, CloudT &cloud, BOX3D const& bounds)
 {
-    typedef typename pcl::traits::fieldList<typename CloudT::PointType>::type
-        FieldList;
+    typedef typename CloudT::PointType PointT;
+    typedef typename pcl::traits::fieldList<PointT>::type FieldList;
 
     cloud.width = view->size();
     cloud.height = 1;  // unorganized point cloud
     cloud.is_dense = false;
     cloud.points.resize(cloud.width);
 
-    if (pcl::traits::has_xyz<typename CloudT::PointType>::value)
+    const bool hasXyz = pcl::traits::has_xyz<PointT>::value;
+    const bool hasIntensity = pcl::traits::has_intensity<PointT>::value;
+    const bool hasColor = pcl::traits::has_color<PointT>::value;
+
+    const point_count_t batchSize = ConversionBatchSize;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    std::vector<double> zs(batchSize);
+    std::vector<float> intensities(batchSize);
+    std::vector<uint8_t> reds(batchSize);
+    std::vector<uint8_t> greens(batchSize);
+    std::vector<uint8_t> blues(batchSize);
+    for (PointId begin = 0; begin < view->size(); begin += batchSize)
     {
-        for (size_t i = 0; i < cloud.points.size(); ++i)
+        point_count_t count = (std::min)(batchSize, view->size() - begin);
+
+        if (hasXyz)
         {
-            double xd = view->getFieldAs<double>(Dimension::Id::X, i) - bounds.minx;
-            double yd = view->getFieldAs<double>(Dimension::Id::Y, i) - bounds.miny;
-            double zd = view->getFieldAs<double>(Dimension::Id::Z, i) - bounds.minz;
-
-            typename CloudT::PointType p = cloud.points[i];
-            p.x = (float)xd;
-            p.y = (float)yd;
-            p.z = (float)zd;
-            cloud.points[i] = p;
+            view->getFieldArray(Dimension::Id::X, begin, count, xs.data());
+            view->getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+            view->getFieldArray(Dimension::Id::Z, begin, count, zs.data());
+            for (PointId i = 0; i < count; ++i)
+            {
+                PointT& p = cloud.points[begin + i];
+                p.x = (float)(xs[i] - bounds.minx);
+                p.y = (float)(ys[i] - bounds.miny);
+                p.z = (float)(zs[i] - bounds.minz);
+            }
         }
-    }
 
-    if (pcl::traits::has_intensity<typename CloudT::PointType>::value)
-    {
-        for (size_t i = 0; i < cloud.points.size(); ++i)
+        if (hasIntensity)
         {
-            typename CloudT::PointType p = cloud.points[i];
-
-            float f = view->getFieldAs<float>(Dimension::Id::Intensity, i);
-            pcl::for_each_type<FieldList>
-                (pcl::SetIfFieldExists<typename CloudT::PointType, float>
-                    (p, "intensity", f));
-            cloud.points[i] = p;
+            view->getFieldArray(Dimension::Id::Intensity, begin, count,
+                intensities.data());
+            for (PointId i = 0; i < count; ++i)
+                pcl::for_each_type<FieldList>
+                    (pcl::SetIfFieldExists<PointT, float>
+                        (cloud.points[begin + i], "intensity",
+                         intensities[i]));
         }
-    }
 
-    if (pcl::traits::has_color<typename CloudT::PointType>::value)
-    {
-        for (size_t i = 0; i < cloud.points.size(); ++i)
+        if (hasColor)
         {
-            typename CloudT::PointType p = cloud.points[i];
-
-            uint8_t r = view->getFieldAs<uint8_t>(Dimension::Id::Red, i);
-            uint8_t g = view->getFieldAs<uint8_t>(Dimension::Id::Green, i);
-            uint8_t b = view->getFieldAs<uint8_t>(Dimension::Id::Blue, i);
-            pcl::for_each_type<FieldList> (
-                pcl::SetIfFieldExists<typename CloudT::PointType, uint32_t> (
-                    p, "rgba", ((uint8_t)r) << 16 | ((uint8_t)g) << 8 | ((uint8_t)b)
-                )
-            );
-            cloud.points[i] = p;
+            view->getFieldArray(Dimension::Id::Red, begin, count,
+                reds.data());
+            view->getFieldArray(Dimension::Id::Green, begin, count,
+                greens.data());
+            view->getFieldArray(Dimension::Id::Blue, begin, count,
+                blues.data());
+            for (PointId i = 0; i < count; ++i)
+                pcl::for_each_type<FieldList> (
+                    pcl::SetIfFieldExists<PointT, uint32_t> (
+                        cloud.points[begin + i], "rgba",
+                        (uint32_t)reds[i] << 16 | (uint32_t)greens[i] << 8 |
+                        (uint32_t)blues[i]
+                    )
+                );
         }
     }
 }
@@ -196,5 +230,36 @@ void PDALtoPCD(PointViewPtr view, CloudT &cloud)
 }
 
 
+/**
+ * \brief Find the points of a filtered cloud in its source.
+ *
+ * Filters that only remove points leave the others unchanged and in
+ * order.  When every point of \a filtered is found that way in \a cloud,
+ * the indices of the points are returned in \a ids, so that the source
+ * points can be kept whole instead of being converted back from PCL.
+ * Where points share coordinates, the first unused one is taken.
+ *
+ * \return  Whether all the points of \a filtered were found.
+ */
+template <typename CloudT>
+bool findSubset(const CloudT& cloud, const CloudT& filtered,
+    std::vector<PointId>& ids)
+{
+    ids.clear();
+    ids.reserve(filtered.points.size());
+    size_t j = 0;
+    for (const auto& p : filtered.points)
+    {
+        while (j < cloud.points.size() && !(cloud.points[j].x == p.x &&
+                cloud.points[j].y == p.y && cloud.points[j].z == p.z))
+            ++j;
+        if (j == cloud.points.size())
+            return false;
+        ids.push_back(j++);
+    }
+    return true;
+}
+
+
 }  // namespace pcl
 }  // namespace pdal
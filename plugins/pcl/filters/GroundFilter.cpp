@@ -40,6 +40,7 @@
 #include <pdal/PointTable.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/ThreadPool.hpp>
 
 #include <pcl/point_types.h>
 #include <pcl/console/print.h>
@@ -47,6 +48,11 @@
 #include <pcl/io/pcd_io.h>
 #include <pcl/segmentation/progressive_morphological_filter.h>
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+
 namespace pdal
 {
 
@@ -68,6 +74,22 @@ void GroundFilter::processOptions(const Options& options)
     m_cellSize = options.getValueOrDefault<double>("cellSize", 1);
     m_classify = options.getValueOrDefault<bool>("classify", true);
     m_extract = options.getValueOrDefault<bool>("extract", false);
+    m_tileSize = options.getValueOrDefault<double>("tileSize", 0);
+    m_native = options.getValueOrDefault<bool>("native", m_tileSize > 0);
+    m_buffer = options.getValueOrDefault<double>("buffer", -1);
+    if (m_tileSize > 0 && !m_native)
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Tiled filtering requires the native "
+            "morphology.";
+        throw pdal_error(oss.str());
+    }
+    if (m_native && m_cellSize <= 0)
+    {
+        std::ostringstream oss;
+        oss << getName() << ": Option 'cellSize' must be positive.";
+        throw pdal_error(oss.str());
+    }
 }
 
 void GroundFilter::addDimensions(PointLayoutPtr layout)
@@ -75,13 +97,8 @@ void GroundFilter::addDimensions(PointLayoutPtr layout)
     layout->registerDim(Dimension::Id::Classification);
 }
 
-PointViewSet GroundFilter::run(PointViewPtr input)
+std::vector<PointId> GroundFilter::pclGround(PointViewPtr input)
 {
-    bool logOutput = log()->getLevel() > LogLevel::Debug1;
-    if (logOutput)
-        log()->floatPrecision(8);
-    log()->get(LogLevel::Debug2) << "Process GroundFilter...\n";
-
     // convert PointView to PointXYZ
     typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
     Cloud::Ptr cloud(new Cloud);
@@ -125,17 +142,258 @@ PointViewSet GroundFilter::run(PointViewPtr input)
     pcl::PointIndicesPtr idx(new pcl::PointIndices);
     pmf.extract(idx->indices);
 
+    return std::vector<PointId>(idx->indices.begin(), idx->indices.end());
+}
+
+
+namespace
+{
+
+// One iteration of the progressive filter: the half width of the window
+// in cells and the height above the opened surface at which a point stops
+// being ground.
+struct MorphStep
+{
+    int m_half;
+    double m_threshold;
+};
+
+
+// Replace the 'n' values 'stride' apart starting at 'data' with the
+// minimum (or maximum) of the 2 * half + 1 values centered on each.
+void slide(double *data, size_t n, size_t stride, int half, bool max,
+    std::vector<double>& line, std::deque<size_t>& q)
+{
+    line.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        line[i] = data[i * stride];
+
+    auto better = [max](double a, double b)
+        { return max ? a >= b : a <= b; };
+
+    q.clear();
+    for (size_t i = 0; i < n + half; ++i)
+    {
+        if (i < n)
+        {
+            while (q.size() && better(line[i], line[q.back()]))
+                q.pop_back();
+            q.push_back(i);
+        }
+        if (i < (size_t)half)
+            continue;
+        size_t o = i - half;
+        while (q.front() + half < o)
+            q.pop_front();
+        data[o * stride] = line[q.front()];
+    }
+}
+
+
+// Apply the progressive morphological filter to the points of one tile,
+// clearing 'ground' for the points found not to be ground.  Cells are
+// numbered from the origin (ox, oy) so that neighboring tiles share them.
+void morphGround(const std::vector<double>& xs, const std::vector<double>& ys,
+    const std::vector<double>& zs, double ox, double oy, double cellSize,
+    const std::vector<MorphStep>& steps, std::vector<char>& ground)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    size_t count = xs.size();
+    if (!count)
+        return;
+
+    std::vector<int64_t> cx(count);
+    std::vector<int64_t> cy(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        cx[i] = (int64_t)std::floor((xs[i] - ox) / cellSize);
+        cy[i] = (int64_t)std::floor((ys[i] - oy) / cellSize);
+    }
+    int64_t minCx = *std::min_element(cx.begin(), cx.end());
+    int64_t minCy = *std::min_element(cy.begin(), cy.end());
+    size_t cols = *std::max_element(cx.begin(), cx.end()) - minCx + 1;
+    size_t rows = *std::max_element(cy.begin(), cy.end()) - minCy + 1;
+    std::vector<size_t> cells(count);
+    for (size_t i = 0; i < count; ++i)
+        cells[i] = (cy[i] - minCy) * cols + (cx[i] - minCx);
+
+    std::vector<size_t> candidates(count);
+    for (size_t i = 0; i < count; ++i)
+        candidates[i] = i;
+
+    std::vector<double> surface;
+    std::vector<char> occupied;
+    std::vector<double> line;
+    std::deque<size_t> q;
+    for (const MorphStep& step : steps)
+    {
+        // Lowest point of each cell, eroded with the minimum and dilated
+        // with the maximum of the window over occupied cells.
+        surface.assign(rows * cols, inf);
+        occupied.assign(rows * cols, 0);
+        for (size_t i : candidates)
+        {
+            surface[cells[i]] = (std::min)(surface[cells[i]], zs[i]);
+            occupied[cells[i]] = 1;
+        }
+        for (size_t r = 0; r < rows; ++r)
+            slide(surface.data() + r * cols, cols, 1, step.m_half, false,
+                line, q);
+        for (size_t c = 0; c < cols; ++c)
+            slide(surface.data() + c, rows, cols, step.m_half, false,
+                line, q);
+        for (size_t c = 0; c < surface.size(); ++c)
+            if (!occupied[c])
+                surface[c] = -inf;
+        for (size_t r = 0; r < rows; ++r)
+            slide(surface.data() + r * cols, cols, 1, step.m_half, true,
+                line, q);
+        for (size_t c = 0; c < cols; ++c)
+            slide(surface.data() + c, rows, cols, step.m_half, true,
+                line, q);
+
+        size_t kept = 0;
+        for (size_t i : candidates)
+            if (zs[i] - surface[cells[i]] < step.m_threshold)
+                candidates[kept++] = i;
+            else
+                ground[i] = 0;
+        candidates.resize(kept);
+    }
+}
+
+} // unnamed namespace
+
+
+std::vector<PointId> GroundFilter::nativeGround(PointView& view)
+{
+    // Windows and thresholds as PCL's filter computes them for its default
+    // exponential growth with base 2.
+    std::vector<MorphStep> steps;
+    double window = 0;
+    double prevWindow = 0;
+    for (int i = 0; window < m_maxWindowSize; ++i)
+    {
+        window = m_cellSize * (2 * std::pow(2.0, i) + 1);
+        double threshold = m_initialDistance;
+        if (i)
+            threshold += m_slope * (window - prevWindow) * m_cellSize;
+        threshold = (std::min)(threshold, m_maxDistance);
+        steps.push_back(MorphStep{(int)(window / (2 * m_cellSize)),
+            threshold});
+        prevWindow = window;
+    }
+
+    BOX3D bounds = view.calculateBounds();
+    double buffer = m_buffer < 0 ? window : m_buffer;
+    size_t tileCols = 1;
+    size_t tileRows = 1;
+    if (m_tileSize > 0)
+    {
+        tileCols = (size_t)((bounds.maxx - bounds.minx) / m_tileSize) + 1;
+        tileRows = (size_t)((bounds.maxy - bounds.miny) / m_tileSize) + 1;
+    }
+    else
+        buffer = 0;
+
+    // Tile column or row of a coordinate, clamped to the tiles.
+    auto tileIndex = [this](double v, double minv, size_t count) -> size_t
+    {
+        if (m_tileSize <= 0)
+            return 0;
+        double t = std::floor((v - minv) / m_tileSize);
+        return (size_t)(std::max)(0.0, (std::min)(t, (double)count - 1));
+    };
+
+    // Each tile gets the points in its core and in a buffer around it, so
+    // that the windows near its edges see the ground beyond them.
+    std::vector<std::vector<PointId>> members(tileCols * tileRows);
+    const point_count_t batchSize = 4096;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
+    for (PointId begin = 0; begin < view.size(); begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, view.size() - begin);
+        view.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+        view.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        for (PointId i = 0; i < count; ++i)
+        {
+            size_t c0 = tileIndex(xs[i] - buffer, bounds.minx, tileCols);
+            size_t c1 = tileIndex(xs[i] + buffer, bounds.minx, tileCols);
+            size_t r0 = tileIndex(ys[i] - buffer, bounds.miny, tileRows);
+            size_t r1 = tileIndex(ys[i] + buffer, bounds.miny, tileRows);
+            for (size_t r = r0; r <= r1; ++r)
+                for (size_t c = c0; c <= c1; ++c)
+                    members[r * tileCols + c].push_back(begin + i);
+        }
+    }
+
+    // Tiles are filtered at once.  Each point is decided by the one tile
+    // whose core holds it, so the workers write disjoint flags.
+    std::vector<char> isGround(view.size(), 0);
+    auto filterTiles = [&](size_t first, size_t last)
+    {
+        std::vector<double> tx;
+        std::vector<double> ty;
+        std::vector<double> tz;
+        std::vector<char> ground;
+        for (size_t t = first; t < last; ++t)
+        {
+            const std::vector<PointId>& ids = members[t];
+            tx.resize(ids.size());
+            ty.resize(ids.size());
+            tz.resize(ids.size());
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                tx[i] = view.getFieldAs<double>(Dimension::Id::X, ids[i]);
+                ty[i] = view.getFieldAs<double>(Dimension::Id::Y, ids[i]);
+                tz[i] = view.getFieldAs<double>(Dimension::Id::Z, ids[i]);
+            }
+            ground.assign(ids.size(), 1);
+            morphGround(tx, ty, tz, bounds.minx, bounds.miny, m_cellSize,
+                steps, ground);
+
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                size_t c = tileIndex(tx[i], bounds.minx, tileCols);
+                size_t r = tileIndex(ty[i], bounds.miny, tileRows);
+                if (r * tileCols + c == t)
+                    isGround[ids[i]] = ground[i];
+            }
+            std::vector<PointId>().swap(members[t]);
+        }
+    };
+    ThreadPool::shared().parallelFor(members.size(), 1, filterTiles);
+
+    std::vector<PointId> ground;
+    for (PointId i = 0; i < isGround.size(); ++i)
+        if (isGround[i])
+            ground.push_back(i);
+    return ground;
+}
+
+
+PointViewSet GroundFilter::run(PointViewPtr input)
+{
+    bool logOutput = log()->getLevel() > LogLevel::Debug1;
+    if (logOutput)
+        log()->floatPrecision(8);
+    log()->get(LogLevel::Debug2) << "Process GroundFilter...\n";
+
+    std::vector<PointId> ground = m_native ? nativeGround(*input) :
+        pclGround(input);
+
     PointViewSet viewSet;
-    if (!idx->indices.empty() && (m_classify || m_extract))
+    if (!ground.empty() && (m_classify || m_extract))
     {
 
         if (m_classify)
         {
-            log()->get(LogLevel::Debug2) << "Labeled " << idx->indices.size() << " ground returns!\n";
+            log()->get(LogLevel::Debug2) << "Labeled " << ground.size() << " ground returns!\n";
 
             // set the classification label of ground returns as 2
             // (corresponding to ASPRS LAS specification)
-            for (const auto& i : idx->indices)
+            for (const auto& i : ground)
             { input->setField(Dimension::Id::Classification, i, 2); }
 
             viewSet.insert(input);
@@ -143,11 +401,11 @@ PointViewSet GroundFilter::run(PointViewPtr input)
 
         if (m_extract)
         {
-            log()->get(LogLevel::Debug2) << "Extracted " << idx->indices.size() << " ground returns!\n";
+            log()->get(LogLevel::Debug2) << "Extracted " << ground.size() << " ground returns!\n";
 
             // create new PointView containing only ground returns
             PointViewPtr output = input->makeNew();
-            for (const auto& i : idx->indices)
+            for (const auto& i : ground)
             {
                 output->appendPoint(*input, i);
             }
@@ -158,7 +416,7 @@ PointViewSet GroundFilter::run(PointViewPtr input)
     }
     else
     {
-        if (idx->indices.empty())
+        if (ground.empty())
             log()->get(LogLevel::Debug2) << "Filtered cloud has no ground returns!\n";
 
         if (!(m_classify || m_extract))
@@ -38,6 +38,7 @@
 #include <pdal/Stage.hpp>
 
 #include <memory>
+#include <vector>
 
 namespace pdal
 {
@@ -65,10 +66,15 @@ private:
     double m_cellSize;
     bool m_classify;
     bool m_extract;
+    bool m_native;
+    double m_tileSize;
+    double m_buffer;
 
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void processOptions(const Options& options);
     virtual PointViewSet run(PointViewPtr view);
+    std::vector<PointId> pclGround(PointViewPtr view);
+    std::vector<PointId> nativeGround(PointView& view);
 
     GroundFilter& operator=(const GroundFilter&); // not implemented
     GroundFilter(const GroundFilter&); // not implemented
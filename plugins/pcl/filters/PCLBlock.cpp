@@ -132,7 +132,15 @@ PointViewSet PCLBlock::run(PointViewPtr input)
         return viewSet;
     }
 
-    pclsupport::PCDtoPDAL(*cloud_f, output, buffer_bounds);
+    // Most filters only remove points.  Their results are taken from the
+    // input with every dimension intact, rather than copied back from the
+    // cloud's floats.
+    std::vector<PointId> ids;
+    if (pclsupport::findSubset(*cloud, *cloud_f, ids))
+        for (PointId id : ids)
+            output->appendPoint(*input, id);
+    else
+        pclsupport::PCDtoPDAL(*cloud_f, output, buffer_bounds);
 
     log()->get(LogLevel::Debug2) << cloud->points.size() << " before, " <<
                                  cloud_f->points.size() << " after" << std::endl;
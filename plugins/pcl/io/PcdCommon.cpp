@@ -34,6 +34,14 @@
 
 #include "PcdCommon.hpp"
 
+#include <pdal/pdal_internal.hpp>
+#include <pdal/Utils.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <sstream>
+
 namespace pdal
 {
 
@@ -53,4 +61,337 @@ Dimension::IdList fileDimensions()
     return ids;
 }
 
+namespace pcd
+{
+
+Dimension::Type::Enum Field::dimType() const
+{
+    using namespace Dimension;
+
+    switch (m_type)
+    {
+    case 'F':
+        if (m_size == 4)
+            return Type::Float;
+        if (m_size == 8)
+            return Type::Double;
+        break;
+    case 'U':
+        if (m_size == 1)
+            return Type::Unsigned8;
+        if (m_size == 2)
+            return Type::Unsigned16;
+        if (m_size == 4)
+            return Type::Unsigned32;
+        if (m_size == 8)
+            return Type::Unsigned64;
+        break;
+    case 'I':
+        if (m_size == 1)
+            return Type::Signed8;
+        if (m_size == 2)
+            return Type::Signed16;
+        if (m_size == 4)
+            return Type::Signed32;
+        if (m_size == 8)
+            return Type::Signed64;
+        break;
+    }
+    std::ostringstream oss;
+    oss << "Invalid PCD field '" << m_name << "' of type " << m_type <<
+        " and size " << m_size << ".";
+    throw pdal_error(oss.str());
+}
+
+
+size_t Header::pointSize() const
+{
+    size_t size = 0;
+    for (const Field& f : m_fields)
+        size += f.bytes();
+    return size;
+}
+
+
+void Header::read(std::istream& in)
+{
+    m_fields.clear();
+    bool havePoints = false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        Utils::trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream iss(line);
+        std::string key;
+        iss >> key;
+        std::vector<std::string> vals;
+        std::string val;
+        while (iss >> val)
+            vals.push_back(val);
+
+        auto setEach = [this, &key, &vals](
+            const std::function<void(Field&, const std::string&)>& f)
+        {
+            if (vals.size() != m_fields.size())
+                throw pdal_error("PCD header has " +
+                    std::to_string(vals.size()) + " values of " + key +
+                    " for " + std::to_string(m_fields.size()) +
+                    " fields.");
+            for (size_t i = 0; i < vals.size(); ++i)
+                f(m_fields[i], vals[i]);
+        };
+
+        try
+        {
+            if (key == "VERSION" && vals.size())
+                m_version = vals[0];
+            else if (key == "FIELDS" || key == "COLUMNS")
+            {
+                for (const std::string& name : vals)
+                {
+                    Field f;
+                    f.m_name = name;
+                    m_fields.push_back(f);
+                }
+            }
+            else if (key == "SIZE")
+                setEach([](Field& f, const std::string& v)
+                    { f.m_size = std::stoul(v); });
+            else if (key == "TYPE")
+                setEach([](Field& f, const std::string& v)
+                    { f.m_type = v.empty() ? 0 : v[0]; });
+            else if (key == "COUNT")
+                setEach([](Field& f, const std::string& v)
+                    { f.m_count = std::stoul(v); });
+            else if (key == "WIDTH" && vals.size())
+                m_width = std::stoull(vals[0]);
+            else if (key == "HEIGHT" && vals.size())
+                m_height = std::stoull(vals[0]);
+            else if (key == "VIEWPOINT")
+            {
+                std::string vp;
+                for (const std::string& v : vals)
+                    vp += (vp.empty() ? "" : " ") + v;
+                m_viewpoint = vp;
+            }
+            else if (key == "POINTS" && vals.size())
+            {
+                m_numPoints = std::stoull(vals[0]);
+                havePoints = true;
+            }
+            else if (key == "DATA" && vals.size())
+            {
+                if (vals[0] == "ascii")
+                    m_format = Format::Ascii;
+                else if (vals[0] == "binary")
+                    m_format = Format::Binary;
+                else if (vals[0] == "binary_compressed")
+                    m_format = Format::BinaryCompressed;
+                else
+                    throw pdal_error("Invalid PCD data format '" +
+                        vals[0] + "'.");
+                m_dataOffset = in.tellg();
+                if (!havePoints)
+                    m_numPoints = m_width * m_height;
+                if (m_fields.empty())
+                    throw pdal_error("PCD header has no fields.");
+                for (const Field& f : m_fields)
+                    if (f.m_name != "_")
+                        f.dimType();
+                return;
+            }
+        }
+        catch (std::logic_error&)
+        {
+            throw pdal_error("Invalid PCD header line '" + line + "'.");
+        }
+    }
+    throw pdal_error("PCD header has no DATA line.");
+}
+
+
+void Header::write(std::ostream& out) const
+{
+    out << "# .PCD v" << m_version << " - Point Cloud Data file format\n";
+    out << "VERSION " << m_version << "\n";
+    out << "FIELDS";
+    for (const Field& f : m_fields)
+        out << " " << f.m_name;
+    out << "\nSIZE";
+    for (const Field& f : m_fields)
+        out << " " << f.m_size;
+    out << "\nTYPE";
+    for (const Field& f : m_fields)
+        out << " " << f.m_type;
+    out << "\nCOUNT";
+    for (const Field& f : m_fields)
+        out << " " << f.m_count;
+    out << "\nWIDTH " << m_width << "\n";
+    out << "HEIGHT " << m_height << "\n";
+    out << "VIEWPOINT " << m_viewpoint << "\n";
+    out << "POINTS " << m_numPoints << "\n";
+    out << "DATA ";
+    switch (m_format)
+    {
+    case Format::Ascii:
+        out << "ascii";
+        break;
+    case Format::Binary:
+        out << "binary";
+        break;
+    case Format::BinaryCompressed:
+        out << "binary_compressed";
+        break;
+    }
+    out << "\n";
+}
+
+
+namespace
+{
+
+// Parameters of the LZF format.
+const size_t LzfMaxLiteral = 1 << 5;
+const size_t LzfMaxOffset = 1 << 13;
+const size_t LzfMaxMatch = (1 << 8) + (1 << 3);
+const unsigned LzfHashLog = 16;
+
+inline unsigned lzfHash(const unsigned char *p)
+{
+    uint32_t v = (p[0] << 16) | (p[1] << 8) | p[2];
+    return ((v * 2654435761u) >> (32 - LzfHashLog)) & ((1 << LzfHashLog) - 1);
+}
+
+} // unnamed namespace
+
+
+std::vector<char> lzfCompress(const char *inbuf, size_t inLen)
+{
+    const unsigned char *in = (const unsigned char *)inbuf;
+
+    std::vector<char> out;
+    out.reserve(inLen + inLen / LzfMaxLiteral + 1);
+    // Positions + 1 of the last sequence of three bytes with each hash.
+    std::vector<size_t> table(1 << LzfHashLog, 0);
+
+    // Each literal run starts with a control byte holding its length - 1.
+    size_t lit = 0;
+    size_t litPos = out.size();
+    out.push_back(0);
+
+    size_t ip = 0;
+    while (ip < inLen)
+    {
+        size_t match = 0;
+        size_t off = 0;
+        if (ip + 2 < inLen)
+        {
+            size_t& slot = table[lzfHash(in + ip)];
+            size_t ref = slot;
+            slot = ip + 1;
+            if (ref && ip - ref < LzfMaxOffset &&
+                std::memcmp(in + ref - 1, in + ip, 3) == 0)
+            {
+                off = ip - ref;
+                size_t max = (std::min)(LzfMaxMatch, inLen - ip);
+                match = 3;
+                while (match < max && in[ref - 1 + match] == in[ip + match])
+                    match++;
+            }
+        }
+
+        if (!match)
+        {
+            out.push_back(in[ip++]);
+            if (++lit == LzfMaxLiteral)
+            {
+                out[litPos] = (char)(lit - 1);
+                lit = 0;
+                litPos = out.size();
+                out.push_back(0);
+            }
+            continue;
+        }
+
+        // End the literal run, dropping its control byte if it's empty.
+        if (lit)
+            out[litPos] = (char)(lit - 1);
+        else
+            out.pop_back();
+
+        const size_t len = match - 2;
+        if (len < 7)
+            out.push_back((char)((off >> 8) + (len << 5)));
+        else
+        {
+            out.push_back((char)((off >> 8) + (7 << 5)));
+            out.push_back((char)(len - 7));
+        }
+        out.push_back((char)(off & 0xFF));
+
+        for (size_t i = ip + 1; i < ip + match && i + 2 < inLen; ++i)
+            table[lzfHash(in + i)] = i + 1;
+        ip += match;
+
+        lit = 0;
+        litPos = out.size();
+        out.push_back(0);
+    }
+    if (lit)
+        out[litPos] = (char)(lit - 1);
+    else
+        out.pop_back();
+    return out;
+}
+
+
+bool lzfDecompress(const char *inbuf, size_t inLen, char *outbuf,
+    size_t outLen)
+{
+    const unsigned char *in = (const unsigned char *)inbuf;
+    const unsigned char *inEnd = in + inLen;
+    unsigned char *out = (unsigned char *)outbuf;
+    unsigned char *op = out;
+    unsigned char *outEnd = out + outLen;
+
+    while (in < inEnd)
+    {
+        size_t ctrl = *in++;
+        if (ctrl < LzfMaxLiteral)
+        {
+            ctrl++;
+            if ((size_t)(outEnd - op) < ctrl || (size_t)(inEnd - in) < ctrl)
+                return false;
+            std::memcpy(op, in, ctrl);
+            op += ctrl;
+            in += ctrl;
+            continue;
+        }
+
+        size_t len = ctrl >> 5;
+        size_t off = (ctrl & 0x1F) << 8;
+        if (len == 7)
+        {
+            if (in == inEnd)
+                return false;
+            len += *in++;
+        }
+        if (in == inEnd)
+            return false;
+        off += *in++;
+        len += 2;
+        if ((size_t)(outEnd - op) < len || (size_t)(op - out) < off + 1)
+            return false;
+        // The match can overlap the bytes being written.
+        const unsigned char *ref = op - off - 1;
+        for (size_t i = 0; i < len; ++i)
+            *op++ = *ref++;
+    }
+    return op == outEnd;
+}
+
+} // namespace pcd
 } // namespace pdal
@@ -36,9 +36,80 @@
 
 #include <pdal/Dimension.hpp>
 
+#include <iostream>
+#include <string>
+#include <vector>
+
 namespace pdal
 {
 
 PDAL_DLL Dimension::IdList fileDimensions();
 
+namespace pcd
+{
+
+enum class Format
+{
+    Ascii,
+    Binary,
+    BinaryCompressed
+};
+
+struct Field
+{
+    Field() : m_size(4), m_type('F'), m_count(1)
+        {}
+    Field(const std::string& name, size_t size, char type) :
+        m_name(name), m_size(size), m_type(type), m_count(1)
+        {}
+
+    std::string m_name;
+    // Bytes of each element.
+    size_t m_size;
+    // 'F' (floating point), 'U' (unsigned) or 'I' (signed).
+    char m_type;
+    // Number of elements.
+    size_t m_count;
+
+    // PDAL type of an element.  Throws pdal_error if there's none.
+    Dimension::Type::Enum dimType() const;
+    size_t bytes() const
+        { return m_size * m_count; }
+};
+
+// The header of a PCD file, which ends with the DATA line.
+struct Header
+{
+    Header() : m_version("0.7"), m_width(0), m_height(1),
+        m_viewpoint("0 0 0 1 0 0 0"), m_numPoints(0),
+        m_format(Format::Ascii), m_dataOffset(0)
+        {}
+
+    std::string m_version;
+    std::vector<Field> m_fields;
+    uint64_t m_width;
+    uint64_t m_height;
+    std::string m_viewpoint;
+    uint64_t m_numPoints;
+    Format m_format;
+    // Position of the point data in the file.
+    std::streamoff m_dataOffset;
+
+    // Bytes of a point record.
+    size_t pointSize() const;
+    // Parse a header, leaving the stream at the start of the point data.
+    // Throws pdal_error if the header is invalid.
+    void read(std::istream& in);
+    void write(std::ostream& out) const;
+};
+
+// Compress data with LZF, the compression of binary_compressed PCD data.
+PDAL_DLL std::vector<char> lzfCompress(const char *in, size_t inLen);
+// Decompress LZF data into 'out', which must hold exactly 'outLen' bytes.
+// Returns false if the data is invalid or doesn't decompress to 'outLen'
+// bytes.
+PDAL_DLL bool lzfDecompress(const char *in, size_t inLen, char *out,
+    size_t outLen);
+
+} // namespace pcd
 } // namespace pdal
@@ -33,15 +33,11 @@
 ****************************************************************************/
 
 #include "PcdReader.hpp"
-#include "point_types.hpp"
-
-#include <boost/algorithm/string.hpp>
-
-#include <pcl/io/pcd_io.h>
-#include <pcl/io/impl/pcd_io.hpp>
 
 #include <pdal/PointView.hpp>
-#include "PCLConversions.hpp"
+#include <pdal/util/FileUtils.hpp>
+
+#include <cstring>
 
 namespace pdal
 {
@@ -55,31 +51,248 @@ CREATE_SHARED_PLUGIN(1, 0, PcdReader, Reader, s_info)
 
 std::string PcdReader::getName() const { return s_info.name; }
 
-void PcdReader::ready(PointTableRef table)
+PcdReader::~PcdReader()
 {
-    pcl::PCLPointCloud2 cloud;
-    pcl::PCDReader r;
-    r.readHeader(m_filename, cloud);
-    m_numPts = cloud.height * cloud.width;
+    FileUtils::closeFile(m_stream);
+}
+
+
+void PcdReader::initialize()
+{
+    std::istream *in = FileUtils::openFile(m_filename, true);
+    try
+    {
+        m_header.read(*in);
+    }
+    catch (pdal_error& err)
+    {
+        FileUtils::closeFile(in);
+        throw pdal_error(getName() + ": " + err.what() + "  File: '" +
+            m_filename + "'.");
+    }
+    FileUtils::closeFile(in);
+    m_numPts = m_header.m_numPoints;
 }
 
 
 void PcdReader::addDimensions(PointLayoutPtr layout)
 {
+    using namespace Dimension;
+
     layout->registerDims(getDefaultDimensions());
+
+    m_fields.clear();
+    size_t offset = 0;
+    for (const pcd::Field& pf : m_header.m_fields)
+    {
+        Field f;
+        f.m_field = pf;
+        f.m_offset = offset;
+        f.m_id = Id::Unknown;
+        f.m_type = Type::None;
+        f.m_color = false;
+        offset += pf.bytes();
+
+        // Padding and fields of several elements, such as histograms,
+        // aren't read.
+        if (pf.m_name == "_" || pf.m_count != 1)
+        {
+            m_fields.push_back(f);
+            continue;
+        }
+
+        f.m_type = pf.dimType();
+        if (pf.m_name == "x")
+            f.m_id = Id::X;
+        else if (pf.m_name == "y")
+            f.m_id = Id::Y;
+        else if (pf.m_name == "z")
+            f.m_id = Id::Z;
+        else if (pf.m_name == "intensity")
+            f.m_id = Id::Intensity;
+        else if ((pf.m_name == "rgb" || pf.m_name == "rgba") &&
+            pf.m_size == 4)
+            f.m_color = true;
+        else
+            f.m_id = layout->registerOrAssignDim(pf.m_name, f.m_type);
+        m_fields.push_back(f);
+    }
+}
+
+
+void PcdReader::ready(PointTableRef)
+{
+    FileUtils::closeFile(m_stream);
+    m_stream = FileUtils::openFile(m_filename, true);
+    m_stream->seekg(m_header.m_dataOffset);
+    m_index = 0;
+    m_columns.clear();
+
+    if (m_header.m_format != pcd::Format::BinaryCompressed)
+        return;
+
+    // Compressed data is the compressed and raw sizes followed by the LZF
+    // compressed columns.
+    uint32_t sizes[2];
+    m_stream->read((char *)sizes, sizeof(sizes));
+    const size_t rawSize = m_numPts * m_header.pointSize();
+    if (!*m_stream || sizes[1] != rawSize)
+        throw pdal_error(getName() + ": Invalid compressed point data in '" +
+            m_filename + "'.");
+    std::vector<char> compressed(sizes[0]);
+    m_stream->read(compressed.data(), compressed.size());
+    m_columns.resize(rawSize);
+    if (!*m_stream || !pcd::lzfDecompress(compressed.data(),
+            compressed.size(), m_columns.data(), m_columns.size()))
+        throw pdal_error(getName() + ": Invalid compressed point data in '" +
+            m_filename + "'.");
+}
+
+
+void PcdReader::setPoint(PointView& view, PointId idx, const Field& f,
+    const char *pos)
+{
+    if (f.m_color)
+    {
+        uint32_t rgb;
+        std::memcpy(&rgb, pos, sizeof(rgb));
+        view.setField(Dimension::Id::Red, idx, (uint16_t)((rgb >> 16) & 0xFF));
+        view.setField(Dimension::Id::Green, idx, (uint16_t)((rgb >> 8) & 0xFF));
+        view.setField(Dimension::Id::Blue, idx, (uint16_t)(rgb & 0xFF));
+    }
+    else if (f.m_id != Dimension::Id::Unknown)
+        view.setField(f.m_id, f.m_type, idx, pos);
+}
+
+
+point_count_t PcdReader::read(PointViewPtr view, point_count_t count)
+{
+    count = (std::min)(count, m_numPts - m_index);
+    const PointId idx = view->size();
+    switch (m_header.m_format)
+    {
+    case pcd::Format::Ascii:
+        for (PointId i = 0; i < count; ++i)
+            readAscii(*view, idx + i);
+        break;
+    case pcd::Format::Binary:
+        readBinary(*view, idx, count);
+        break;
+    case pcd::Format::BinaryCompressed:
+        readColumns(*view, idx, count);
+        break;
+    }
+    if (m_cb)
+        for (PointId i = 0; i < count; ++i)
+            m_cb(*view, idx + i);
+    m_index += count;
+    return count;
+}
+
+
+void PcdReader::readAscii(PointView& view, PointId idx)
+{
+    std::string line;
+    do
+    {
+        if (!std::getline(*m_stream, line))
+            throw pdal_error(getName() + ": Unexpected end of point data "
+                "in '" + m_filename + "'.");
+        Utils::trim(line);
+    } while (line.empty());
+
+    std::istringstream iss(line);
+    std::string tok;
+    for (const Field& f : m_fields)
+    {
+        for (size_t i = 0; i < f.m_field.m_count; ++i)
+            if (!(iss >> tok))
+                throw pdal_error(getName() + ": Too few values in line '" +
+                    line + "' of '" + m_filename + "'.");
+        if (f.m_id == Dimension::Id::Unknown && !f.m_color)
+            continue;
+        try
+        {
+            if (f.m_color)
+            {
+                // Packed colors are written as an integer or, for fields
+                // of type F, sometimes as the float with the same bits.
+                uint32_t rgb;
+                if (f.m_field.m_type == 'F' &&
+                    tok.find_first_of(".eE") != std::string::npos)
+                {
+                    float v = std::stof(tok);
+                    std::memcpy(&rgb, &v, sizeof(rgb));
+                }
+                else
+                    rgb = (uint32_t)std::stoul(tok);
+                setPoint(view, idx, f, (const char *)&rgb);
+            }
+            else
+                view.setField(f.m_id, idx, std::stod(tok));
+        }
+        catch (std::logic_error&)
+        {
+            throw pdal_error(getName() + ": Invalid value '" + tok +
+                "' for field '" + f.m_field.m_name + "' in '" +
+                m_filename + "'.");
+        }
+    }
 }
 
 
-point_count_t PcdReader::read(PointViewPtr view, point_count_t /*count*/)
+void PcdReader::readBinary(PointView& view, PointId idx, point_count_t count)
 {
-    pcl::PointCloud<XYZIRGBA>::Ptr cloud(new pcl::PointCloud<XYZIRGBA>);
+    // Points are read this many at a time.
+    const point_count_t BlockPoints = 65536;
 
-    pcl::PCDReader r;
-    r.read<XYZIRGBA>(m_filename, *cloud);
+    const size_t pointSize = m_header.pointSize();
+    std::vector<char> buf(pointSize * (std::min)(count, BlockPoints));
+    while (count)
+    {
+        const point_count_t n = (std::min)(count, BlockPoints);
+        m_stream->read(buf.data(), n * pointSize);
+        if ((size_t)m_stream->gcount() != n * pointSize)
+            throw pdal_error(getName() + ": Unexpected end of point data "
+                "in '" + m_filename + "'.");
+        const char *pos = buf.data();
+        for (PointId i = 0; i < n; ++i, pos += pointSize)
+            for (const Field& f : m_fields)
+                setPoint(view, idx + i, f, pos + f.m_offset);
+        idx += n;
+        count -= n;
+    }
+}
 
-    pclsupport::PCDtoPDAL(*cloud, view);
 
-    return cloud->points.size();
+void PcdReader::readColumns(PointView& view, PointId idx, point_count_t count)
+{
+    // Each field is a column of values for all the points, so a field's
+    // column starts at its offset in a point times the number of points.
+    // Fields are set a column at a time, the first one adding the points.
+    bool added = false;
+    for (const Field& f : m_fields)
+    {
+        if (f.m_id == Dimension::Id::Unknown && !f.m_color)
+            continue;
+        const size_t bytes = f.m_field.bytes();
+        const char *pos = m_columns.data() + m_numPts * f.m_offset +
+            m_index * bytes;
+        for (PointId i = 0; i < count; ++i, pos += bytes)
+            setPoint(view, idx + i, f, pos);
+        added = true;
+    }
+    if (!added)
+        for (PointId i = 0; i < count; ++i)
+            view.setField(Dimension::Id::X, idx + i, 0.0);
+}
+
+
+void PcdReader::done(PointTableRef)
+{
+    FileUtils::closeFile(m_stream);
+    m_stream = NULL;
+    m_columns.clear();
 }
 
 } // namespace pdal
@@ -40,13 +40,20 @@
 
 #include "PcdCommon.hpp"
 
+#include <memory>
+#include <vector>
+
 namespace pdal
 {
 
+// Reads PCD files without going through PCL.  Binary and ASCII point data
+// is read a chunk at a time, so the reader can be streamed.
 class PDAL_DLL PcdReader : public pdal::Reader
 {
 public:
-    PcdReader() : Reader() {};
+    PcdReader() : Reader(), m_numPts(0), m_index(0), m_stream(NULL)
+        {}
+    ~PcdReader();
 
     static void * create();
     static int32_t destroy(void *);
@@ -57,12 +64,46 @@ public:
         return fileDimensions();
     };
 
+    virtual bool streamable() const
+        { return true; }
+    virtual point_count_t numPoints() const
+        { return m_numPts; }
+
 private:
+    // A field of the file and where it goes in the point table.
+    struct Field
+    {
+        pcd::Field m_field;
+        size_t m_offset;
+        // Dimension of a field with one element, or Unknown.
+        Dimension::Id::Enum m_id;
+        Dimension::Type::Enum m_type;
+        // Whether the field is packed RGB, read into Red, Green and Blue.
+        bool m_color;
+    };
+
+    pcd::Header m_header;
+    std::vector<Field> m_fields;
     point_count_t m_numPts;
+    point_count_t m_index;
+    std::istream *m_stream;
+    // Decompressed binary_compressed data, a column for each field.
+    std::vector<char> m_columns;
 
+    virtual void initialize();
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void ready(PointTableRef table);
     virtual point_count_t read(PointViewPtr view, point_count_t count);
+    virtual void done(PointTableRef table);
+
+    void setPoint(PointView& view, PointId idx, const Field& f,
+        const char *pos);
+    void readAscii(PointView& view, PointId idx);
+    void readBinary(PointView& view, PointId idx, point_count_t count);
+    void readColumns(PointView& view, PointId idx, point_count_t count);
+
+    PcdReader& operator=(const PcdReader&); // not implemented
+    PcdReader(const PcdReader&); // not implemented
 };
 
 } // namespace pdal
@@ -33,19 +33,12 @@
 ****************************************************************************/
 
 #include "PcdWriter.hpp"
-#include "point_types.hpp"
 
 #include <algorithm>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
-#include <map>
 
-#include <boost/algorithm/string.hpp>
-#include <boost/algorithm/string/erase.hpp>
-
-#include <pcl/io/pcd_io.h>
-#include <pcl/io/impl/pcd_io.hpp>
-
-#include "PCLConversions.hpp"
 #include <pdal/PointView.hpp>
 #include <pdal/pdal_macros.hpp>
 
@@ -61,10 +54,98 @@ CREATE_SHARED_PLUGIN(1, 0, PcdWriter, Writer, s_info)
 
 std::string PcdWriter::getName() const { return s_info.name; }
 
+namespace
+{
+
+// Points are converted and written this many at a time.
+const point_count_t BlockPoints = 65536;
+
+// The fields written, those of the PCL point type that the writer used
+// to convert through.  X, Y and Z are written relative to the minimum of
+// the view's bounds.
+struct PointRecord
+{
+    float x;
+    float y;
+    float z;
+    float intensity;
+    uint32_t rgba;
+};
+
+pcd::Header makeHeader(point_count_t numPoints, pcd::Format format)
+{
+    pcd::Header h;
+    h.m_fields.push_back(pcd::Field("x", 4, 'F'));
+    h.m_fields.push_back(pcd::Field("y", 4, 'F'));
+    h.m_fields.push_back(pcd::Field("z", 4, 'F'));
+    h.m_fields.push_back(pcd::Field("intensity", 4, 'F'));
+    h.m_fields.push_back(pcd::Field("rgba", 4, 'U'));
+    h.m_width = numPoints;
+    h.m_height = 1;
+    h.m_numPoints = numPoints;
+    h.m_format = format;
+    return h;
+}
+
+// Fetch a block of points, leaving fields for dimensions the view doesn't
+// have zero.
+void getRecords(const PointView& view, PointId begin, point_count_t count,
+    const BOX3D& bounds, std::vector<PointRecord>& recs)
+{
+    using namespace Dimension;
+
+    std::vector<double> xs(count);
+    std::vector<double> ys(count);
+    std::vector<double> zs(count);
+    std::vector<float> intensities(count, 0);
+    std::vector<uint8_t> reds(count, 0);
+    std::vector<uint8_t> greens(count, 0);
+    std::vector<uint8_t> blues(count, 0);
+
+    view.getFieldArray(Id::X, begin, count, xs.data());
+    view.getFieldArray(Id::Y, begin, count, ys.data());
+    view.getFieldArray(Id::Z, begin, count, zs.data());
+    if (view.hasDim(Id::Intensity))
+        view.getFieldArray(Id::Intensity, begin, count, intensities.data());
+    if (view.hasDim(Id::Red))
+        view.getFieldArray(Id::Red, begin, count, reds.data());
+    if (view.hasDim(Id::Green))
+        view.getFieldArray(Id::Green, begin, count, greens.data());
+    if (view.hasDim(Id::Blue))
+        view.getFieldArray(Id::Blue, begin, count, blues.data());
+
+    recs.resize(count);
+    for (PointId i = 0; i < count; ++i)
+    {
+        PointRecord& r = recs[i];
+        r.x = (float)(xs[i] - bounds.minx);
+        r.y = (float)(ys[i] - bounds.miny);
+        r.z = (float)(zs[i] - bounds.minz);
+        r.intensity = intensities[i];
+        r.rgba = (uint32_t)reds[i] << 16 | (uint32_t)greens[i] << 8 |
+            (uint32_t)blues[i];
+    }
+}
+
+} // unnamed namespace
+
+
 void PcdWriter::processOptions(const Options& ops)
 {
     m_filename = ops.getValueOrThrow<std::string>("filename");
-    m_compressed = ops.getValueOrDefault("compression", false);
+
+    std::string format = ops.getValueOrDefault<std::string>("format",
+        ops.getValueOrDefault("compression", false) ?
+        "binary_compressed" : "ascii");
+    if (format == "ascii")
+        m_format = pcd::Format::Ascii;
+    else if (format == "binary")
+        m_format = pcd::Format::Binary;
+    else if (format == "binary_compressed")
+        m_format = pcd::Format::BinaryCompressed;
+    else
+        throw pdal_error(getName() + ": Invalid format '" + format +
+            "'.  Must be 'ascii', 'binary' or 'binary_compressed'.");
 }
 
 
@@ -74,6 +155,8 @@ Options PcdWriter::getDefaultOptions()
 
     options.add("filename", "", "Filename to write PCD file to");
     options.add("compression", false, "Write binary compressed data?");
+    options.add("format", "ascii", "Layout of the point data: ascii, "
+        "binary or binary_compressed");
 
     return options;
 }
@@ -81,17 +164,118 @@ Options PcdWriter::getDefaultOptions()
 
 void PcdWriter::write(const PointViewPtr view)
 {
-    pcl::PointCloud<XYZIRGBA>::Ptr cloud(new pcl::PointCloud<XYZIRGBA>);
-    BOX3D const& buffer_bounds = view->calculateBounds();
-    pclsupport::PDALtoPCD(view, *cloud, buffer_bounds);
+    const BOX3D bounds = view->calculateBounds();
+
+    std::ostream *out = FileUtils::createFile(m_filename, true);
+    if (!out)
+        throw pdal_error(getName() + ": Unable to open '" + m_filename +
+            "' for writing.");
+    try
+    {
+        makeHeader(view->size(), m_format).write(*out);
+        switch (m_format)
+        {
+        case pcd::Format::Ascii:
+            writeAscii(*out, *view, bounds);
+            break;
+        case pcd::Format::Binary:
+            writeBinary(*out, *view, bounds);
+            break;
+        case pcd::Format::BinaryCompressed:
+            writeCompressed(*out, *view, bounds);
+            break;
+        }
+        out->flush();
+        if (!*out)
+            throw pdal_error(getName() + ": Unable to write '" +
+                m_filename + "'.");
+    }
+    catch (...)
+    {
+        FileUtils::closeFile(out);
+        throw;
+    }
+    FileUtils::closeFile(out);
+}
 
-    pcl::PCDWriter w;
 
-    if (m_compressed)
-        w.writeBinaryCompressed<XYZIRGBA>(m_filename, *cloud);
-    else
-        w.writeASCII<XYZIRGBA>(m_filename, *cloud);
+void PcdWriter::writeAscii(std::ostream& out, const PointView& view,
+    const BOX3D& bounds)
+{
+    std::vector<PointRecord> recs;
+    out << std::setprecision(8);
+    for (PointId begin = 0; begin < view.size(); begin += BlockPoints)
+    {
+        point_count_t count = (std::min)(BlockPoints, view.size() - begin);
+        getRecords(view, begin, count, bounds, recs);
+        for (const PointRecord& r : recs)
+            out << r.x << " " << r.y << " " << r.z << " " << r.intensity <<
+                " " << r.rgba << "\n";
+    }
+}
+
+
+void PcdWriter::writeBinary(std::ostream& out, const PointView& view,
+    const BOX3D& bounds)
+{
+    // Records are packed as PCD points are laid out, without padding.
+    const size_t pointSize = 5 * 4;
+    std::vector<PointRecord> recs;
+    std::vector<char> buf;
+    for (PointId begin = 0; begin < view.size(); begin += BlockPoints)
+    {
+        point_count_t count = (std::min)(BlockPoints, view.size() - begin);
+        getRecords(view, begin, count, bounds, recs);
+        buf.resize(count * pointSize);
+        char *pos = buf.data();
+        for (const PointRecord& r : recs)
+        {
+            std::memcpy(pos, &r.x, 4);
+            std::memcpy(pos + 4, &r.y, 4);
+            std::memcpy(pos + 8, &r.z, 4);
+            std::memcpy(pos + 12, &r.intensity, 4);
+            std::memcpy(pos + 16, &r.rgba, 4);
+            pos += pointSize;
+        }
+        out.write(buf.data(), buf.size());
+    }
 }
 
 
+void PcdWriter::writeCompressed(std::ostream& out, const PointView& view,
+    const BOX3D& bounds)
+{
+    // The data is a column of values for each field, compressed together.
+    const point_count_t numPoints = view.size();
+    std::vector<char> columns(numPoints * 5 * 4);
+    char *x = columns.data();
+    char *y = x + numPoints * 4;
+    char *z = y + numPoints * 4;
+    char *intensity = z + numPoints * 4;
+    char *rgba = intensity + numPoints * 4;
+
+    std::vector<PointRecord> recs;
+    for (PointId begin = 0; begin < numPoints; begin += BlockPoints)
+    {
+        point_count_t count = (std::min)(BlockPoints, numPoints - begin);
+        getRecords(view, begin, count, bounds, recs);
+        for (PointId i = 0; i < count; ++i)
+        {
+            const size_t pos = (begin + i) * 4;
+            std::memcpy(x + pos, &recs[i].x, 4);
+            std::memcpy(y + pos, &recs[i].y, 4);
+            std::memcpy(z + pos, &recs[i].z, 4);
+            std::memcpy(intensity + pos, &recs[i].intensity, 4);
+            std::memcpy(rgba + pos, &recs[i].rgba, 4);
+        }
+    }
+
+    std::vector<char> compressed =
+        pcd::lzfCompress(columns.data(), columns.size());
+    uint32_t sizes[2] = { (uint32_t)compressed.size(),
+        (uint32_t)columns.size() };
+    out.write((const char *)sizes, sizeof(sizes));
+    out.write(compressed.data(), compressed.size());
+}
+
 } // namespaces
@@ -38,6 +38,8 @@
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/StageFactory.hpp>
 
+#include "PcdCommon.hpp"
+
 #include <vector>
 #include <string>
 
@@ -59,8 +61,15 @@ private:
     virtual void processOptions(const Options&);
     virtual void write(const PointViewPtr view);
 
+    void writeAscii(std::ostream& out, const PointView& view,
+        const BOX3D& bounds);
+    void writeBinary(std::ostream& out, const PointView& view,
+        const BOX3D& bounds);
+    void writeCompressed(std::ostream& out, const PointView& view,
+        const BOX3D& bounds);
+
     std::string m_filename;
-    bool m_compressed;
+    pcd::Format m_format;
 
     PcdWriter& operator=(const PcdWriter&); // not implemented
     PcdWriter(const PcdWriter&); // not implemented
@@ -71,6 +71,9 @@ GroundKernel::GroundKernel()
     , m_cellSize(1)
     , m_classify(true)
     , m_extract(false)
+    , m_native(false)
+    , m_tileSize(0)
+    , m_buffer(-1)
 {}
 
 void GroundKernel::validateSwitches()
@@ -100,6 +103,9 @@ void GroundKernel::addSwitches()
     ("cellSize", po::value<double>(&m_cellSize)->default_value(1), "cell size")
     ("classify", po::bool_switch(&m_classify), "apply classification labels?")
     ("extract", po::bool_switch(&m_extract), "extract ground returns?")
+    ("native", po::bool_switch(&m_native), "use PDAL's morphology rather than PCL's?")
+    ("tileSize", po::value<double>(&m_tileSize)->default_value(0), "size of tiles filtered in parallel (0 for none)")
+    ("buffer", po::value<double>(&m_buffer)->default_value(-1), "overlap of tiles (-1 for the largest window)")
     ;
 
     addSwitchSet(file_options);
@@ -127,6 +133,9 @@ int GroundKernel::execute()
     groundOptions.add<double>("cellSize", m_cellSize);
     groundOptions.add<bool>("classify", m_classify);
     groundOptions.add<bool>("extract", m_extract);
+    groundOptions.add<bool>("native", m_native || m_tileSize > 0);
+    groundOptions.add<double>("tileSize", m_tileSize);
+    groundOptions.add<double>("buffer", m_buffer);
 
     StageFactory f;
     std::unique_ptr<Stage> groundStage(f.createStage("filters.ground"));
@@ -72,6 +72,9 @@ private:
     double m_cellSize;
     bool m_classify;
     bool m_extract;
+    bool m_native;
+    double m_tileSize;
+    double m_buffer;
 };
 
 } // namespace pdal
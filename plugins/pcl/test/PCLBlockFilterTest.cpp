@@ -182,6 +182,60 @@ TEST(PCLBlockFilterTest, PCLBlockFilterTest_filter_PassThrough)
     test_filter("filters/pcl/filter_PassThrough_2.json", 33);
 }
 
+// Filters that only remove points return the input points themselves, not
+// points converted back from PCL's floats.
+TEST(PCLBlockFilterTest, PCLBlockFilterTest_subset)
+{
+    StageFactory f;
+
+    Options readerOptions;
+    readerOptions.add("filename",
+        Support::datapath("autzen/autzen-point-format-3.las"));
+    std::unique_ptr<Stage> reader(f.createStage("readers.las"));
+    reader->setOptions(readerOptions);
+
+    std::unique_ptr<Stage> source(f.createStage("readers.las"));
+    source->setOptions(readerOptions);
+
+    PointTable inTable;
+    source->prepare(inTable);
+    PointViewPtr input = *source->execute(inTable).begin();
+
+    Options filterOptions;
+    filterOptions.add("filename",
+        Support::datapath("filters/pcl/example_PassThrough_1.json"));
+    std::unique_ptr<Stage> filter(f.createStage("filters.pclblock"));
+    filter->setOptions(filterOptions);
+    filter->setInput(*reader);
+
+    PointTable table;
+    filter->prepare(table);
+    PointViewSet viewSet = filter->execute(table);
+    ASSERT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    ASSERT_EQ(view->size(), 81u);
+
+    using namespace Dimension;
+    PointId j = 0;
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        double x = view->getFieldAs<double>(Id::X, i);
+        double y = view->getFieldAs<double>(Id::Y, i);
+        while (j < input->size() &&
+            (input->getFieldAs<double>(Id::X, j) != x ||
+             input->getFieldAs<double>(Id::Y, j) != y))
+            ++j;
+        ASSERT_LT(j, input->size());
+        EXPECT_EQ(view->getFieldAs<double>(Id::Z, i),
+            input->getFieldAs<double>(Id::Z, j));
+        EXPECT_EQ(view->getFieldAs<double>(Id::GpsTime, i),
+            input->getFieldAs<double>(Id::GpsTime, j));
+        EXPECT_EQ(view->getFieldAs<int>(Id::Intensity, i),
+            input->getFieldAs<int>(Id::Intensity, j));
+        ++j;
+    }
+}
+
 TEST(PCLBlockFilterTest, PCLBlockFilterTest_filter_PMF)
 {
     // explicitly with all defaults
@@ -242,3 +296,47 @@ TEST(PCLBlockFilterTest, PCLBlockFilterTest_filter_VoxelGrid)
     // test LeafSize
     test_filter("filters/pcl/filter_VoxelGrid.json", 81);
 }
+
+static point_count_t groundCount(const Options& groundOptions)
+{
+    StageFactory f;
+
+    Options readerOptions;
+    readerOptions.add("filename",
+        Support::datapath("autzen/autzen-point-format-3.las"));
+    std::unique_ptr<Stage> reader(f.createStage("readers.las"));
+    reader->setOptions(readerOptions);
+
+    Options options(groundOptions);
+    options.add("extract", true);
+    std::unique_ptr<Stage> ground(f.createStage("filters.ground"));
+    EXPECT_TRUE(ground.get());
+    ground->setOptions(options);
+    ground->setInput(*reader);
+
+    PointTable table;
+    ground->prepare(table);
+    PointViewSet viewSet = ground->execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    return (*viewSet.begin())->size();
+}
+
+TEST(GroundFilterTest, native)
+{
+    Options options;
+    options.add("native", true);
+    point_count_t whole = groundCount(options);
+    EXPECT_GT(whole, 0u);
+
+    // With buffers that reach past the data every tile sees all the points,
+    // so tiling can't change the result.
+    Options tiled;
+    tiled.add("tileSize", 100);
+    tiled.add("buffer", 1e6);
+    EXPECT_EQ(groundCount(tiled), whole);
+
+    Options pcl;
+    pcl.add("tileSize", 100);
+    pcl.add("native", false);
+    EXPECT_THROW(groundCount(pcl), pdal_error);
+}
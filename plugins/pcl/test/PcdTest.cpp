@@ -0,0 +1,200 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <null/NullWriter.hpp>
+
+#include "io/PcdCommon.hpp"
+#include "io/PcdReader.hpp"
+#include "io/PcdWriter.hpp"
+
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+const point_count_t NumPoints = 100000;
+
+PointViewPtr makeView(PointTable& table)
+{
+    using namespace Dimension;
+
+    table.layout()->registerDims(PcdReader::getDefaultDimensions());
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < NumPoints; ++i)
+    {
+        view->setField(Id::X, i, 1000 + (i % 1000) * .25);
+        view->setField(Id::Y, i, 2000 + (i / 1000) * .5);
+        view->setField(Id::Z, i, 10 + (i % 17));
+        view->setField(Id::Intensity, i, i % 4096);
+        view->setField(Id::Red, i, i % 256);
+        view->setField(Id::Green, i, (i / 256) % 256);
+        view->setField(Id::Blue, i, 255 - i % 256);
+    }
+    return view;
+}
+
+void roundTrip(const std::string& format)
+{
+    using namespace Dimension;
+
+    std::string filename(Support::temppath("pcdtest.pcd"));
+    FileUtils::deleteFile(filename);
+
+    PointTable table;
+    PointViewPtr view = makeView(table);
+    {
+        BufferReader reader;
+        reader.addView(view);
+
+        Options ops;
+        ops.add("filename", filename);
+        ops.add("format", format);
+        PcdWriter writer;
+        writer.setOptions(ops);
+        writer.setInput(reader);
+        writer.prepare(table);
+        writer.execute(table);
+    }
+
+    Options ops;
+    ops.add("filename", filename);
+    PcdReader reader;
+    reader.setOptions(ops);
+    PointTable inTable;
+    reader.prepare(inTable);
+    PointViewSet viewSet = reader.execute(inTable);
+    ASSERT_EQ(viewSet.size(), 1u);
+    PointViewPtr in = *viewSet.begin();
+    ASSERT_EQ(in->size(), NumPoints);
+
+    // The writer writes X, Y and Z relative to the minimum of the bounds.
+    for (PointId i = 0; i < NumPoints; i += 7)
+    {
+        EXPECT_FLOAT_EQ(in->getFieldAs<float>(Id::X, i),
+            view->getFieldAs<float>(Id::X, i) - 1000);
+        EXPECT_FLOAT_EQ(in->getFieldAs<float>(Id::Y, i),
+            view->getFieldAs<float>(Id::Y, i) - 2000);
+        EXPECT_FLOAT_EQ(in->getFieldAs<float>(Id::Z, i),
+            view->getFieldAs<float>(Id::Z, i) - 10);
+        EXPECT_EQ(in->getFieldAs<int>(Id::Intensity, i),
+            view->getFieldAs<int>(Id::Intensity, i));
+        EXPECT_EQ(in->getFieldAs<int>(Id::Red, i),
+            view->getFieldAs<int>(Id::Red, i));
+        EXPECT_EQ(in->getFieldAs<int>(Id::Green, i),
+            view->getFieldAs<int>(Id::Green, i));
+        EXPECT_EQ(in->getFieldAs<int>(Id::Blue, i),
+            view->getFieldAs<int>(Id::Blue, i));
+    }
+
+    // A file read a chunk at a time gives the same number of points.
+    PcdReader streamReader;
+    streamReader.setOptions(ops);
+    NullWriter writer;
+    writer.setInput(streamReader);
+    FixedPointTable streamTable(1000);
+    writer.prepare(streamTable);
+    EXPECT_TRUE(writer.pipelineStreamable());
+    EXPECT_EQ(writer.executeStream(streamTable), NumPoints);
+
+    FileUtils::deleteFile(filename);
+}
+
+} // unnamed namespace
+
+TEST(PcdTest, lzf)
+{
+    std::vector<char> raw(100000);
+    for (size_t i = 0; i < raw.size(); ++i)
+        raw[i] = (char)((i / 7) % 13 + (i % 3));
+
+    std::vector<char> compressed = pcd::lzfCompress(raw.data(), raw.size());
+    EXPECT_LT(compressed.size(), raw.size() / 4);
+
+    std::vector<char> out(raw.size());
+    EXPECT_TRUE(pcd::lzfDecompress(compressed.data(), compressed.size(),
+        out.data(), out.size()));
+    EXPECT_TRUE(out == raw);
+
+    // The wrong size or truncated data fails.
+    EXPECT_FALSE(pcd::lzfDecompress(compressed.data(), compressed.size(),
+        out.data(), out.size() - 1));
+    EXPECT_FALSE(pcd::lzfDecompress(compressed.data(), compressed.size() / 2,
+        out.data(), out.size()));
+}
+
+TEST(PcdTest, ascii)
+{
+    roundTrip("ascii");
+}
+
+TEST(PcdTest, binary)
+{
+    roundTrip("binary");
+}
+
+TEST(PcdTest, binaryCompressed)
+{
+    roundTrip("binary_compressed");
+}
+
+TEST(PcdTest, header)
+{
+    std::istringstream in(
+        "# .PCD v0.7 - Point Cloud Data file format\n"
+        "VERSION 0.7\n"
+        "FIELDS x y z rgb _ normal\n"
+        "SIZE 4 4 4 4 1 4\n"
+        "TYPE F F F F U F\n"
+        "COUNT 1 1 1 1 4 3\n"
+        "WIDTH 10\n"
+        "HEIGHT 2\n"
+        "VIEWPOINT 0 0 0 1 0 0 0\n"
+        "DATA binary\n");
+    pcd::Header h;
+    h.read(in);
+    EXPECT_EQ(h.m_fields.size(), 6u);
+    EXPECT_EQ(h.m_numPoints, 20u);
+    EXPECT_EQ(h.pointSize(), 16u + 4u + 12u);
+    EXPECT_TRUE(h.m_format == pcd::Format::Binary);
+
+    std::istringstream bad("FIELDS x y\nSIZE 4\nDATA ascii\n");
+    EXPECT_THROW(h.read(bad), pdal_error);
+}
@@ -38,11 +38,15 @@
 #include <boost/algorithm/string.hpp>
 
 #include "libpq-fe.h"
+#include <pdal/ConnectionPool.hpp>
 #include <pdal/pdal_error.hpp>
 #include <pdal/Options.hpp>
 #include <pdal/Compression.hpp>
 #include <pdal/Utils.hpp>
 
+#include <string>
+#include <vector>
+
 namespace pdal
 {
 
@@ -86,6 +90,57 @@ inline PGconn* pg_connect(std::string const& connection)
     return conn;
 }
 
+inline void pg_close(void *session)
+{
+    PQfinish((PGconn *)session);
+}
+
+inline std::string pg_pool_key(std::string const& connection)
+{
+    return "pgpointcloud:" + connection;
+}
+
+// Take an idle session for 'connection' from the connection pool, or open
+// a new one if there isn't one that's still connected.
+inline PGconn* pg_acquire(std::string const& connection)
+{
+    ConnectionPool& pool = ConnectionPool::shared();
+    while (PGconn *session = (PGconn *)pool.acquire(pg_pool_key(connection)))
+    {
+        // Reading what's waiting on the socket notices a session that the
+        // server has closed, without a round trip.
+        if (PQconsumeInput(session) && PQstatus(session) == CONNECTION_OK)
+            return session;
+        PQfinish(session);
+    }
+    return pg_connect(connection);
+}
+
+// Give a session back to the connection pool.  A session that's in a
+// transaction or running a statement is closed instead.
+inline void pg_release(std::string const& connection, PGconn* session)
+{
+    if (!session)
+        return;
+    if (PQstatus(session) != CONNECTION_OK ||
+        PQtransactionStatus(session) != PQTRANS_IDLE)
+    {
+        PQfinish(session);
+        return;
+    }
+
+    // Drop session state, such as settings made by pre_sql, so that it
+    // doesn't leak into the next stage to use the session.
+    PGresult *result = PQexec(session, "DISCARD ALL");
+    bool ok = result && PQresultStatus(result) == PGRES_COMMAND_OK;
+    PQclear(result);
+    if (ok)
+        ConnectionPool::shared().release(pg_pool_key(connection), session,
+            pg_close);
+    else
+        PQfinish(session);
+}
+
 inline void pg_execute(PGconn* session, std::string const& sql)
 {
     PGresult *result = PQexec(session, sql.c_str());
@@ -146,6 +201,158 @@ inline PGresult* pg_query_result(PGconn* session, std::string const& sql)
     return result;
 }
 
+// Start a COPY ... FROM STDIN statement, after which rows are sent with
+// pg_copy_put() and the statement is finished with pg_copy_end().
+inline void pg_copy_begin(PGconn* session, std::string const& sql)
+{
+    PGresult *result = PQexec(session, sql.c_str());
+    if ( (!result) || (PQresultStatus(result) != PGRES_COPY_IN) )
+    {
+        std::string errmsg = std::string(PQerrorMessage(session));
+        PQclear(result);
+        throw pdal_error(errmsg);
+    }
+    PQclear(result);
+}
+
+inline void pg_copy_put(PGconn* session, std::string const& data)
+{
+    if ( PQputCopyData(session, data.data(), (int)data.size()) != 1 )
+        throw pdal_error(std::string(PQerrorMessage(session)));
+}
+
+inline void pg_copy_end(PGconn* session)
+{
+    if ( PQputCopyEnd(session, NULL) != 1 )
+        throw pdal_error(std::string(PQerrorMessage(session)));
+
+    // Errors in the copied rows are only reported now.
+    std::string errmsg;
+    PGresult *result;
+    while ( (result = PQgetResult(session)) )
+    {
+        if ( errmsg.empty() && PQresultStatus(result) != PGRES_COMMAND_OK )
+            errmsg = std::string(PQresultErrorMessage(result));
+        PQclear(result);
+    }
+    if ( errmsg.size() )
+        throw pdal_error(errmsg);
+}
+
+// Statements that are sent together and answered in a single round trip.
+// The statements are pipelined when libpq supports it and are otherwise run
+// one at a time.  A statement can't hold several commands or start a COPY.
+class PgPipeline
+{
+public:
+    PgPipeline(PGconn* session) : m_session(session)
+    {}
+
+    ~PgPipeline()
+    {
+        for (PGresult *result : m_results)
+            PQclear(result);
+    }
+
+    // Add a statement, returning the index of its result.
+    size_t add(std::string const& sql)
+    {
+        m_statements.push_back(Statement{sql, std::string(), false});
+        return m_statements.size() - 1;
+    }
+
+    // Add a statement with a text value for its parameter $1.
+    size_t add(std::string const& sql, std::string const& param)
+    {
+        m_statements.push_back(Statement{sql, param, true});
+        return m_statements.size() - 1;
+    }
+
+    size_t size() const
+        { return m_statements.size(); }
+
+    // Run the statements, throwing the first error.
+    void run()
+    {
+        std::string errmsg;
+#ifdef LIBPQ_HAS_PIPELINING
+        if (PQenterPipelineMode(m_session) != 1)
+            throw pdal_error(std::string(PQerrorMessage(m_session)));
+        for (Statement& s : m_statements)
+        {
+            const char *param = s.m_param.c_str();
+            if (!PQsendQueryParams(m_session, s.m_sql.c_str(),
+                s.m_hasParam ? 1 : 0, NULL, s.m_hasParam ? &param : NULL,
+                NULL, NULL, 0))
+                throw pdal_error(std::string(PQerrorMessage(m_session)));
+        }
+        if (!PQpipelineSync(m_session))
+            throw pdal_error(std::string(PQerrorMessage(m_session)));
+
+        // A statement's results end with a NULL.  Those after a failed
+        // statement come back as aborted.
+        for (size_t i = 0; i < m_statements.size(); ++i)
+        {
+            addResult(PQgetResult(m_session), errmsg);
+            while (PGresult *extra = PQgetResult(m_session))
+                PQclear(extra);
+        }
+        PQclear(PQgetResult(m_session));
+        PQexitPipelineMode(m_session);
+#else
+        for (Statement& s : m_statements)
+        {
+            if (errmsg.size())
+            {
+                m_results.push_back(NULL);
+                continue;
+            }
+            const char *param = s.m_param.c_str();
+            addResult(PQexecParams(m_session, s.m_sql.c_str(),
+                s.m_hasParam ? 1 : 0, NULL, s.m_hasParam ? &param : NULL,
+                NULL, NULL, 0), errmsg);
+        }
+#endif
+        if (errmsg.size())
+            throw pdal_error(errmsg);
+    }
+
+    // The result of a statement, once the pipeline has been run.
+    PGresult* result(size_t idx) const
+        { return m_results[idx]; }
+
+private:
+    struct Statement
+    {
+        std::string m_sql;
+        std::string m_param;
+        bool m_hasParam;
+    };
+
+    PGconn* m_session;
+    std::vector<Statement> m_statements;
+    std::vector<PGresult*> m_results;
+
+    void addResult(PGresult *result, std::string& errmsg)
+    {
+        ExecStatusType status = PQresultStatus(result);
+        if (result && (status == PGRES_TUPLES_OK ||
+            status == PGRES_COMMAND_OK))
+        {
+            m_results.push_back(result);
+            return;
+        }
+        if (errmsg.empty())
+            errmsg = result ? std::string(PQresultErrorMessage(result)) :
+                std::string(PQerrorMessage(m_session));
+        PQclear(result);
+        m_results.push_back(NULL);
+    }
+
+    PgPipeline& operator=(const PgPipeline&); // not implemented
+    PgPipeline(const PgPipeline&); // not implemented
+};
+
 inline std::string pg_quote_identifier(std::string const& name)
 {
     return std::string("\"") + Utils::replaceAll(name, "\"", "\"\"") + "\"";
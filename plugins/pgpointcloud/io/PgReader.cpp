@@ -35,9 +35,15 @@
 
 #include "PgReader.hpp"
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/XMLSchema.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
 #include <iostream>
+#include <mutex>
 
 namespace pdal
 {
@@ -52,16 +58,17 @@ CREATE_SHARED_PLUGIN(1, 0, PgReader, Reader, s_info)
 
 std::string PgReader::getName() const { return s_info.name; }
 
-PgReader::PgReader() : m_session(NULL), m_pcid(0), m_cached_point_count(0),
-    m_cached_max_points(0)
+PgReader::PgReader() : m_session(NULL), m_fetch_size(100), m_connections(1),
+    m_pcid(0),
+    m_cached_point_count(0), m_cached_max_points(0), m_cur_result(NULL),
+    m_fetch_pending(false)
 {}
 
 
 PgReader::~PgReader()
 {
     //ABELL - Do bad things happen if we don't do this?  Already in done().
-    if (m_session)
-        PQfinish(m_session);
+    pg_release(m_connection, m_session);
 }
 
 
@@ -74,6 +81,12 @@ Options PgReader::getDefaultOptions()
     ops.add("schema", "", "Schema to read out of");
     ops.add("column", "", "Column to read out of");
     ops.add("where", "", "SQL where clause to filter query");
+    ops.add("fetch", 100, "Number of patches to fetch from the cursor at "
+        "a time");
+    ops.add("connections", 1, "Number of connections that read ranges of "
+        "patches at once");
+    ops.add("id_column", "id", "Integer column whose ranges are read by "
+        "each connection");
     ops.add("spatialreference", "",
         "override the source data spatialreference");
 
@@ -95,6 +108,15 @@ void PgReader::processOptions(const Options& options)
 
     // Read other preferences
     m_where = options.getValueOrDefault<std::string>("where", "");
+    m_fetch_size = options.getValueOrDefault<uint32_t>("fetch", 100);
+    if (m_fetch_size == 0)
+        throw pdal_error(getName() + ": Option 'fetch' must be greater "
+            "than 0.");
+    m_connections = options.getValueOrDefault<uint32_t>("connections", 1);
+    if (m_connections == 0)
+        throw pdal_error(getName() + ": Option 'connections' must be "
+            "greater than 0.");
+    m_id_column = options.getValueOrDefault<std::string>("id_column", "id");
 
     // Spatial reference.
     setSpatialReference(options.getValueOrDefault<SpatialReference>(
@@ -132,6 +154,12 @@ point_count_t PgReader::getNumPoints() const
 
 
 std::string PgReader::getDataQuery() const
+{
+    return dataQuery(m_where);
+}
+
+
+std::string PgReader::dataQuery(const std::string& where) const
 {
     std::ostringstream oss;
     oss << "SELECT text(PC_Uncompress(" << pg_quote_identifier(m_column_name) <<
@@ -141,8 +169,8 @@ std::string PgReader::getDataQuery() const
     if (!m_schema_name.empty())
         oss << pg_quote_identifier(m_schema_name) << ".";
     oss << pg_quote_identifier(m_table_name);
-    if (!m_where.empty())
-        oss << " WHERE " << m_where;
+    if (!where.empty())
+        oss << " WHERE " << where;
 
     log()->get(LogLevel::Debug) << "Constructed data query " <<
         oss.str() << std::endl;
@@ -257,29 +285,34 @@ void PgReader::ready(PointTableRef /*table*/)
     m_cur_row = 0;
     m_cur_nrows = 0;
     m_cur_result = NULL;
+    m_fetch_pending = false;
 
     if (getSpatialReference().empty())
         setSpatialReference(fetchSpatialReference());
 
-    CursorSetup();
+    if (m_connections > 1)
+        setupPartitions();
+    else
+        CursorSetup();
 }
 
 
 void PgReader::done(PointTableRef /*table*/)
 {
-    CursorTeardown();
-    if (m_session)
-        PQfinish(m_session);
-    m_session = NULL;
+    if (m_connections == 1)
+        CursorTeardown();
     if (m_cur_result)
         PQclear(m_cur_result);
+    m_cur_result = NULL;
+    pg_release(m_connection, m_session);
+    m_session = NULL;
 }
 
 void PgReader::initialize()
 {
     // First thing we do, is set up a connection
     if (!m_session)
-        m_session = pg_connect(m_connection);
+        m_session = pg_acquire(m_connection);
 
 }
 
@@ -293,11 +326,21 @@ void PgReader::CursorSetup()
 
     log()->get(LogLevel::Debug) << "SQL cursor prepared: " <<
         oss.str() << std::endl;
+    SendFetch();
 }
 
 
 void PgReader::CursorTeardown()
 {
+    // The rows of a FETCH that was sent must be taken before the cursor
+    // can be closed.
+    if (m_fetch_pending)
+    {
+        PGresult *result;
+        while ((result = PQgetResult(m_session)))
+            PQclear(result);
+        m_fetch_pending = false;
+    }
     pg_execute(m_session, "CLOSE cur");
     pg_commit(m_session);
     log()->get(LogLevel::Debug) << "SQL cursor closed." << std::endl;
@@ -306,53 +349,74 @@ void PgReader::CursorTeardown()
 
 point_count_t PgReader::readPgPatch(PointViewPtr view, point_count_t numPts)
 {
-    point_count_t numRemaining = m_patch.remaining;
-    PointId nextId = view->size();
-    point_count_t numRead = 0;
+    point_count_t numRead = (std::min)(numPts, m_patch.remaining);
 
     size_t offset = (m_patch.count - m_patch.remaining) * packedPointSize();
-    char *pos = (char *)(m_patch.binary.data() + offset);
+    const char *pos = (const char *)(m_patch.binary.data() + offset);
 
-    while (numRead < numPts && numRemaining > 0)
-    {
-        writePoint(*view.get(), nextId, pos);
-        pos += packedPointSize();
-        numRemaining--;
-        nextId++;
-        numRead++;
-    }
-    m_patch.remaining = numRemaining;
+    unpackPoints(*view, view->size(), numRead, pos);
+    m_patch.remaining -= numRead;
     return numRead;
 }
 
 
+// Ask for the next patches from the cursor without waiting for them, so
+// that the server finds and sends them while the patches at hand are
+// decoded.
+void PgReader::SendFetch()
+{
+    std::ostringstream oss;
+    oss << "FETCH " << m_fetch_size << " FROM cur";
+    if (log()->getLevel() > LogLevel::Debug3)
+        log()->get(LogLevel::Debug3) << "SQL: " << oss.str() << std::endl;
+    if (!PQsendQuery(m_session, oss.str().c_str()))
+        throw pdal_error(PQerrorMessage(m_session));
+    m_fetch_pending = true;
+}
+
+
 bool PgReader::NextBuffer()
 {
     if (m_cur_row >= m_cur_nrows || !m_cur_result)
     {
-        static std::string fetch = "FETCH 2 FROM cur";
         if (m_cur_result)
             PQclear(m_cur_result);
-        m_cur_result = pg_query_result(m_session, fetch);
-        bool logOutput = (log()->getLevel() > LogLevel::Debug3);
-        if (logOutput)
-            log()->get(LogLevel::Debug3) << "SQL: " << fetch << std::endl;
-        if ((PQresultStatus(m_cur_result) != PGRES_TUPLES_OK) ||
-            (PQntuples(m_cur_result) == 0))
+        m_cur_result = NULL;
+
+        // A FETCH is only left unsent once one returns fewer rows than
+        // asked for.
+        if (!m_fetch_pending)
         {
-            PQclear(m_cur_result);
-            m_cur_result = NULL;
             m_atEnd = true;
             return false;
         }
+        m_cur_result = PQgetResult(m_session);
+        PGresult *result;
+        while ((result = PQgetResult(m_session)))
+            PQclear(result);
+        m_fetch_pending = false;
+        if (!m_cur_result || PQresultStatus(m_cur_result) != PGRES_TUPLES_OK)
+        {
+            std::string errmsg(PQerrorMessage(m_session));
+            PQclear(m_cur_result);
+            m_cur_result = NULL;
+            throw pdal_error(errmsg);
+        }
 
         m_cur_row = 0;
         m_cur_nrows = PQntuples(m_cur_result);
+        if (m_cur_nrows == m_fetch_size)
+            SendFetch();
+        if (m_cur_nrows == 0)
+        {
+            m_atEnd = true;
+            return false;
+        }
     }
-    m_patch.hex = PQgetvalue(m_cur_result, m_cur_row, 0);
     m_patch.count = atoi(PQgetvalue(m_cur_result, m_cur_row, 1));
     m_patch.remaining = m_patch.count;
-    m_patch.update_binary();
+    m_patch.update_binary(PQgetvalue(m_cur_result, m_cur_row, 0),
+        PQgetlength(m_cur_result, m_cur_row, 0));
 
     m_cur_row++;
     return true;
@@ -363,6 +427,8 @@ point_count_t PgReader::read(PointViewPtr view, point_count_t count)
 {
     if (eof())
         return 0;
+    if (m_connections > 1)
+        return readPartitions(view, count);
 
     log()->get(LogLevel::Debug) << "readBufferImpl called with "
         "PointView filled to " << view->size() << " points" <<
@@ -382,4 +448,275 @@ point_count_t PgReader::read(PointViewPtr view, point_count_t count)
     return totalNumRead;
 }
 
+
+// Patches decoded by the connections of a partitioned read that are waiting
+// to be added to the view.
+struct PgReader::PartitionQueue
+{
+    PartitionQueue(size_t running, size_t capacity) : m_running(running),
+        m_capacity(capacity), m_stop(false)
+    {}
+
+    std::mutex m_mutex;
+    // Signaled when a patch is added or taken, when a connection finishes
+    // and when the read stops.
+    std::condition_variable m_cv;
+    std::deque<Patch> m_patches;
+    // Number of connections still reading.
+    size_t m_running;
+    // Connections wait while this many patches are queued.
+    size_t m_capacity;
+    bool m_stop;
+};
+
+
+// Split the ids of the patches to be read into a range for each connection.
+void PgReader::setupPartitions()
+{
+    m_partitions.clear();
+
+    std::string where(m_where.size() ? "(" + m_where + ") AND " : "");
+    std::string id(pg_quote_identifier(m_id_column));
+    std::ostringstream oss;
+    oss << "SELECT min(" << id << "), max(" << id << ") FROM ";
+    if (!m_schema_name.empty())
+        oss << pg_quote_identifier(m_schema_name) << ".";
+    oss << pg_quote_identifier(m_table_name);
+    if (m_where.size())
+        oss << " WHERE " << m_where;
+
+    PGresult *result = pg_query_result(m_session, oss.str());
+    if (PQntuples(result) == 0 || PQgetisnull(result, 0, 0))
+    {
+        PQclear(result);
+        m_atEnd = true;
+        return;
+    }
+    int64_t minId = std::strtoll(PQgetvalue(result, 0, 0), NULL, 10);
+    int64_t maxId = std::strtoll(PQgetvalue(result, 0, 1), NULL, 10);
+    PQclear(result);
+
+    uint64_t span = (uint64_t)(maxId - minId) + 1;
+    uint64_t parts = (std::min)((uint64_t)m_connections, span);
+    for (uint64_t i = 0; i < parts; ++i)
+    {
+        // Both bounds are inclusive.
+        int64_t begin = minId + (int64_t)(span * i / parts);
+        int64_t end = minId + (int64_t)(span * (i + 1) / parts) - 1;
+        std::ostringstream cond;
+        cond << where << id << " BETWEEN " << begin << " AND " << end;
+        m_partitions.push_back(dataQuery(cond.str()));
+    }
+    log()->get(LogLevel::Debug) << "Reading ids " << minId << " to " <<
+        maxId << " of " << id << " in " << parts << " partitions" <<
+        std::endl;
+}
+
+
+// Read the patches of every partition, each on its own connection.  The
+// order of the patches of different partitions isn't fixed.
+point_count_t PgReader::readPartitions(PointViewPtr view, point_count_t count)
+{
+    m_atEnd = true;
+    if (m_partitions.empty())
+        return 0;
+    if (view->table().appendSafe())
+        return readPartitionViews(view, count);
+
+    // Points can only be added to the table from this thread, so the
+    // connections queue the patches they decode and the points are added
+    // to the view as the patches arrive.
+
+    PartitionQueue queue(m_partitions.size(),
+        m_partitions.size() * m_fetch_size);
+    ThreadPool pool(m_partitions.size());
+    std::vector<std::future<void>> futures;
+    for (const std::string& query : m_partitions)
+        futures.push_back(pool.submit([this, &queue, query]()
+            { readPartition(query, queue); }));
+
+    auto stop = [&queue]()
+    {
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        queue.m_stop = true;
+        queue.m_cv.notify_all();
+    };
+
+    point_count_t total = 0;
+    try
+    {
+        while (total < count)
+        {
+            std::unique_lock<std::mutex> lock(queue.m_mutex);
+            queue.m_cv.wait(lock, [&queue]()
+                { return queue.m_patches.size() || queue.m_running == 0; });
+            if (queue.m_patches.empty())
+                break;
+            m_patch = std::move(queue.m_patches.front());
+            queue.m_patches.pop_front();
+            queue.m_cv.notify_all();
+            lock.unlock();
+
+            total += readPgPatch(view, count - total);
+        }
+    }
+    catch (...)
+    {
+        stop();
+        for (auto& f : futures)
+            f.wait();
+        throw;
+    }
+    stop();
+    for (auto& f : futures)
+        pool.wait(f);
+    return total;
+}
+
+
+// Read the patches of every partition when the table can be appended to
+// from several threads.  Each connection adds the points of its patches to
+// a view of its own, and the views are appended to 'view' at the end.
+point_count_t PgReader::readPartitionViews(PointViewPtr view,
+    point_count_t count)
+{
+    readyUnpack();
+
+    std::atomic<point_count_t> remaining(count);
+    std::vector<PointViewPtr> views;
+    for (size_t i = 0; i < m_partitions.size(); ++i)
+        views.push_back(view->makeNew());
+
+    ThreadPool pool(m_partitions.size());
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < m_partitions.size(); ++i)
+    {
+        const std::string& query = m_partitions[i];
+        PointView& partView = *views[i];
+        futures.push_back(pool.submit([this, &query, &partView, &remaining]()
+            { unpackPartition(query, partView, remaining); }));
+    }
+    try
+    {
+        for (auto& f : futures)
+            pool.wait(f);
+    }
+    catch (...)
+    {
+        // Claim what's left so that the other connections stop.
+        remaining = 0;
+        for (auto& f : futures)
+            f.wait();
+        throw;
+    }
+
+    point_count_t total = 0;
+    for (PointViewPtr& v : views)
+        total += v->size();
+    view->append(views);
+    return total;
+}
+
+
+// Fetch the patches of a partition on a connection of its own and hand
+// each to 'take' once it's decoded, until 'take' returns false.
+void PgReader::fetchPartition(const std::string& query,
+    const std::function<bool(Patch&)>& take)
+{
+    PGconn *session = pg_acquire(m_connection);
+    try
+    {
+        pg_begin(session);
+        pg_execute(session, "DECLARE cur NO SCROLL CURSOR FOR " + query);
+        std::string fetch("FETCH " + std::to_string(m_fetch_size) +
+            " FROM cur");
+
+        bool stopped = false;
+        while (!stopped)
+        {
+            PGresult *result = pg_query_result(session, fetch);
+            int rows = PQntuples(result);
+            for (int row = 0; row < rows && !stopped; ++row)
+            {
+                Patch patch;
+                patch.count = atoi(PQgetvalue(result, row, 1));
+                patch.remaining = patch.count;
+                patch.update_binary(PQgetvalue(result, row, 0),
+                    PQgetlength(result, row, 0));
+                stopped = !take(patch);
+            }
+            PQclear(result);
+            if (rows < (int)m_fetch_size)
+                break;
+        }
+        pg_execute(session, "CLOSE cur");
+        pg_commit(session);
+    }
+    catch (...)
+    {
+        pg_release(m_connection, session);
+        throw;
+    }
+    pg_release(m_connection, session);
+}
+
+
+// Read the patches of a partition and queue them for the reading thread.
+void PgReader::readPartition(const std::string& query,
+    PartitionQueue& queue)
+{
+    struct Finish
+    {
+        PartitionQueue& m_queue;
+
+        ~Finish()
+        {
+            std::lock_guard<std::mutex> lock(m_queue.m_mutex);
+            m_queue.m_running--;
+            m_queue.m_cv.notify_all();
+        }
+    } finish = { queue };
+
+    auto take = [&queue](Patch& patch)
+    {
+        std::unique_lock<std::mutex> lock(queue.m_mutex);
+        queue.m_cv.wait(lock, [&queue]()
+            { return queue.m_stop ||
+                queue.m_patches.size() < queue.m_capacity; });
+        if (queue.m_stop)
+            return false;
+        queue.m_patches.push_back(std::move(patch));
+        queue.m_cv.notify_all();
+        return true;
+    };
+    fetchPartition(query, take);
+}
+
+
+// Read the patches of a partition into 'view'.  Points are claimed from
+// 'remaining', the number still to be read by all the connections.
+void PgReader::unpackPartition(const std::string& query, PointView& view,
+    std::atomic<point_count_t>& remaining)
+{
+    auto take = [this, &view, &remaining](Patch& patch)
+    {
+        point_count_t avail = remaining.load();
+        point_count_t numRead;
+        do
+        {
+            numRead = (std::min)(avail, patch.count);
+        } while (!remaining.compare_exchange_weak(avail, avail - numRead));
+        if (numRead == 0)
+            return false;
+
+        // Claim the patch's points as one range so that connections only
+        // contend when the table allocates a block.
+        PointId begin = view.appendRange(numRead);
+        unpackPoints(view, begin, numRead,
+            (const char *)patch.binary.data());
+        return numRead == patch.count;
+    };
+    fetchPartition(query, take);
+}
+
 } // pdal
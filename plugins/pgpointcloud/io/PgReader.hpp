@@ -41,6 +41,8 @@
 
 #include "PgCommon.hpp"
 
+#include <atomic>
+#include <functional>
 #include <vector>
 
 namespace pdal
@@ -56,7 +58,6 @@ class PDAL_DLL PgReader : public DbReader
 
         point_count_t count;
         point_count_t remaining;
-        std::string hex;
 
         std::vector<uint8_t> binary;
         static const uint32_t trim = 26;
@@ -67,17 +68,18 @@ class PDAL_DLL PgReader : public DbReader
                 '\255')
 #define HEXOF(x) (x - _base(x))
 
-        inline void update_binary()
+        // Decode the points of the hex WKB patch 'hex', of length 'size',
+        // skipping the patch header.
+        inline void update_binary(const char *hex, size_t size)
         {
-            // http://stackoverflow.com/questions/8197838/convert-a-long-hex-string-in-to-int-array-with-sscanf
-            binary.resize((hex.size() - trim)/2);
-
-            char const* source = hex.c_str() + trim;
-            char const* p = 0;
-
-            for (p = source; p && *p; p += 2)
-                binary[(p - source) >> 1] =
-                    ((HEXOF(*p)) << 4) + HEXOF(*(p + 1));
+            binary.resize(size > trim ? (size - trim) / 2 : 0);
+
+            const char *p = hex + trim;
+            for (uint8_t& b : binary)
+            {
+                b = (uint8_t)((HEXOF(p[0]) << 4) + HEXOF(p[1]));
+                p += 2;
+            }
         }
     };
 
@@ -110,10 +112,23 @@ private:
     SpatialReference fetchSpatialReference() const;
     uint32_t fetchPcid() const;
     point_count_t readPgPatch(PointViewPtr view, point_count_t numPts);
+    std::string dataQuery(const std::string& where) const;
+
+    // Partitioned reads, over several connections at once.
+    struct PartitionQueue;
+    void setupPartitions();
+    point_count_t readPartitions(PointViewPtr view, point_count_t count);
+    point_count_t readPartitionViews(PointViewPtr view, point_count_t count);
+    void fetchPartition(const std::string& query,
+        const std::function<bool(Patch&)>& take);
+    void readPartition(const std::string& query, PartitionQueue& queue);
+    void unpackPartition(const std::string& query, PointView& view,
+        std::atomic<point_count_t>& remaining);
 
     // Internal functions for managing scroll cursor
     void CursorSetup();
     void CursorTeardown();
+    void SendFetch();
     bool NextBuffer();
 
     PGconn* m_session;
@@ -122,6 +137,11 @@ private:
     std::string m_schema_name;
     std::string m_column_name;
     std::string m_where;
+    uint32_t m_fetch_size;
+    uint32_t m_connections;
+    std::string m_id_column;
+    // The data query of each partition of a partitioned read.
+    std::vector<std::string> m_partitions;
     mutable uint32_t m_pcid;
     mutable point_count_t m_cached_point_count;
     mutable point_count_t m_cached_max_points;
@@ -130,6 +150,8 @@ private:
     uint32_t m_cur_row;
     uint32_t m_cur_nrows;
     PGresult* m_cur_result;
+    // Whether a FETCH has been sent whose rows haven't been taken.
+    bool m_fetch_pending;
     Patch m_patch;
 
     PgReader& operator=(const PgReader&); // not implemented
@@ -33,16 +33,15 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
-#include <boost/format.hpp>
-
 #include "PgWriter.hpp"
 
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
 #include <pdal/util/FileUtils.hpp>
-#include <pdal/util/Endian.hpp>
 #include <pdal/XMLSchema.hpp>
 
+#include <algorithm>
+
 namespace pdal
 {
 
@@ -56,8 +55,6 @@ CREATE_SHARED_PLUGIN(1, 0, PgWriter, Writer, s_info)
 std::string PgWriter::getName() const { return s_info.name; }
 
 // TO DO:
-// - change INSERT into COPY
-//
 // - PCID / Schema consistency. If a PCID is specified,
 // must it be consistent with the buffer schema? Or should
 // the writer shove the data into the database schema as best
@@ -73,14 +70,14 @@ PgWriter::PgWriter()
     , m_srid(0)
     , m_pcid(0)
     , m_overwrite(true)
+    , m_copying(false)
     , m_schema_is_initialized(false)
 {}
 
 
 PgWriter::~PgWriter()
 {
-    if (m_session)
-        PQfinish(m_session);
+    pg_release(m_connection, m_session);
 }
 
 
@@ -108,7 +105,7 @@ void PgWriter::processOptions(const Options& options)
     m_pre_sql = options.getValueOrDefault<std::string>("pre_sql");
     // Post-SQL can be *either* a SQL file to execute, *or* a SQL statement
     // to execute. We find out which one here.
-    std::string post_sql = options.getValueOrDefault<std::string>("post_sql");
+    m_post_sql = options.getValueOrDefault<std::string>("post_sql");
 }
 
 //
@@ -119,7 +116,7 @@ void PgWriter::processOptions(const Options& options)
 //
 void PgWriter::initialize()
 {
-    m_session = pg_connect(m_connection);
+    m_session = pg_acquire(m_connection);
 }
 
 //
@@ -162,8 +159,9 @@ void PgWriter::writeInit()
     if (m_schema_is_initialized)
         return;
 
-    // Start up the database connection
-    pg_begin(m_session);
+    // Statements that don't wait on each other's results are pipelined, so
+    // that setting up the table only takes a few round trips.
+    PgPipeline queries(m_session);
 
     // Pre-SQL can be *either* a SQL file to execute, *or* a SQL statement
     // to execute. We find out which one here.
@@ -177,26 +175,39 @@ void PgWriter::writeInit()
             // filename to open, we'll use that instead.
             sql = m_pre_sql;
         }
-        pg_execute(m_session, sql);
+        // Pre-SQL may be several commands, which can't be pipelined, so
+        // it's sent along with the BEGIN as a single query.
+        pg_execute(m_session, "BEGIN;\n" + sql);
     }
+    else
+        queries.add("BEGIN");
+
+    size_t tables = queries.add(tableExistsQuery(m_table_name));
+    size_t formats = queries.add(formatsQuery());
+    queries.run();
 
-    bool bHaveTable = CheckTableExists(m_table_name);
+    bool bHaveTable = CheckTableExists(m_table_name, queries.result(tables));
+
+    PgPipeline commands(m_session);
 
     // Apply the over-write preference if it is set
     if (m_overwrite && bHaveTable)
     {
-        DeleteTable(m_schema_name, m_table_name);
+        DeleteTable(commands, m_schema_name, m_table_name);
         bHaveTable = false;
     }
 
     // Read or create a PCID for our new table
-    m_pcid = SetupSchema(m_srid);
+    m_pcid = SetupSchema(commands, queries.result(formats), m_srid);
 
     // Create the table!
     if (! bHaveTable)
     {
-        CreateTable(m_schema_name, m_table_name, m_column_name, m_pcid);
+        CreateTable(commands, m_schema_name, m_table_name, m_column_name,
+            m_pcid);
     }
+    if (commands.size())
+        commands.run();
 
     m_schema_is_initialized = true;
 }
@@ -210,6 +221,12 @@ void PgWriter::write(const PointViewPtr view)
 
 void PgWriter::done(PointTableRef /*table*/)
 {
+    if (m_copying)
+    {
+        m_copying = false;
+        pg_copy_end(m_session);
+    }
+
     //CreateIndex(m_schema_name, m_table_name, m_column_name);
 
     if (m_post_sql.size())
@@ -222,33 +239,35 @@ void PgWriter::done(PointTableRef /*table*/)
             // filename to open, we'll use that instead.
             sql = m_post_sql;
         }
-        pg_execute(m_session, sql);
+        // Post-SQL may be several commands, so the COMMIT is sent with it
+        // to save a round trip.
+        pg_execute(m_session, sql + ";\nCOMMIT");
     }
+    else
+        pg_commit(m_session);
+}
+
 
-    pg_commit(m_session);
-    return;
+// The query whose result SetupSchema() picks or makes a PCID from.
+std::string PgWriter::formatsQuery() const
+{
+    if (m_pcid)
+        return "SELECT pcid FROM pointcloud_formats WHERE pcid = " +
+            std::to_string(m_pcid);
+    return "SELECT pcid, schema FROM pointcloud_formats";
 }
 
 
-uint32_t PgWriter::SetupSchema(uint32_t srid)
+uint32_t PgWriter::SetupSchema(PgPipeline& commands, PGresult *formats,
+    uint32_t srid)
 {
+    std::ostringstream oss;
 
     // If the user has specified a PCID they want to use,
     // does it exist in the database?
-    std::ostringstream oss;
-    long schema_count;
     if (m_pcid)
     {
-        oss << "SELECT Count(pcid) FROM pointcloud_formats WHERE pcid = " <<
-            m_pcid;
-        char *count_str = pg_query_once(m_session, oss.str());
-        if (!count_str)
-            throw pdal_error("Unable to count pcid's in table "
-                "`pointcloud_formats`");
-        schema_count = atoi(count_str);
-        free(count_str);
-        oss.str("");
-        if (schema_count == 0)
+        if (PQntuples(formats) == 0)
         {
             oss << "requested PCID '" << m_pcid <<
                 "' does not exist in POINTCLOUD_FORMATS";
@@ -257,17 +276,6 @@ uint32_t PgWriter::SetupSchema(uint32_t srid)
         return m_pcid;
     }
 
-    // Do we have any existing schemas in the POINTCLOUD_FORMATS table?
-    uint32_t pcid = 0;
-    oss << "SELECT Count(pcid) FROM pointcloud_formats";
-    char *schema_count_str = pg_query_once(m_session, oss.str());
-    if (!schema_count_str)
-        throw pdal_error("Unable to count pcid's in table "
-            "`pointcloud_formats`");
-    schema_count = atoi(schema_count_str);
-    free(schema_count_str);
-    oss.str("");
-
     // Create an XML output schema.
     std::string compression;
     /* If the writer specifies a compression, we should set that */
@@ -284,52 +292,30 @@ uint32_t PgWriter::SetupSchema(uint32_t srid)
     std::string xml = schema.xml();
 
     // Do any of the existing schemas match the one we want to use?
-    if (schema_count > 0)
+    uint32_t pcid = 1;
+    for (int i = 0; i < PQntuples(formats); ++i)
     {
-        PGresult *result = pg_query_result(m_session,
-            "SELECT pcid, schema FROM pointcloud_formats");
-        for (int i = 0; i < PQntuples(result); ++i)
+        uint32_t existing = atoi(PQgetvalue(formats, i, 0));
+        char *schema_str = PQgetvalue(formats, i, 1);
+
+        if (xml == schema_str)
         {
-            char *pcid_str = PQgetvalue(result, i, 0);
-            char *schema_str = PQgetvalue(result, i, 1);
-
-            if (xml == schema_str)
-            {
-                m_pcid = atoi(pcid_str);
-                PQclear(result);
-                return m_pcid;
-            }
+            m_pcid = existing;
+            return m_pcid;
         }
-        PQclear(result);
-    }
-
-    if (schema_count == 0)
-        pcid = 1;
-    else
-    {
-        char *pcid_str = pg_query_once(m_session,
-                "SELECT Max(pcid)+1 AS pcid FROM pointcloud_formats");
-        if (!pcid_str)
-            throw pdal_error("Unable to get the max pcid from "
-                "`pointcloud_formats`");
-        pcid = atoi(pcid_str);
+        pcid = (std::max)(pcid, existing + 1);
     }
 
-    const char* paramValues = xml.c_str();
     oss << "INSERT INTO pointcloud_formats (pcid, srid, schema) "
         "VALUES (" << pcid << "," << srid << ",$1)";
-    PGresult *result = PQexecParams(m_session, oss.str().c_str(), 1,
-            NULL, &paramValues, NULL, NULL, 0);
-    if (PQresultStatus(result) != PGRES_COMMAND_OK)
-        throw pdal_error(PQresultErrorMessage(result));
-    PQclear(result);
+    commands.add(oss.str(), xml);
     m_pcid = pcid;
     return m_pcid;
 }
 
 
-void PgWriter::DeleteTable(std::string const& schema_name,
-                         std::string const& table_name)
+void PgWriter::DeleteTable(PgPipeline& commands,
+    std::string const& schema_name, std::string const& table_name)
 {
     std::ostringstream oss;
 
@@ -341,7 +327,7 @@ void PgWriter::DeleteTable(std::string const& schema_name,
     }
     oss << table_name;
 
-    pg_execute(m_session, oss.str());
+    commands.add(oss.str());
 }
 
 
@@ -381,20 +367,23 @@ bool PgWriter::CheckPostGISExists()
 }
 
 
-bool PgWriter::CheckTableExists(std::string const& name)
+std::string PgWriter::tableExistsQuery(std::string const& name) const
 {
     std::ostringstream oss;
     oss << "SELECT count(*) FROM pg_tables WHERE tablename ILIKE '" <<
         name << "'";
+    return oss.str();
+}
+
 
+bool PgWriter::CheckTableExists(std::string const& name, PGresult *tables)
+{
     log()->get(LogLevel::Debug) << "checking for table '" << name <<
         "' existence ... " << std::endl;
 
-    char *count_str = pg_query_once(m_session, oss.str());
-    if (!count_str)
+    if (PQntuples(tables) == 0)
         throw pdal_error("Unable to check for the existence of `pg_table`");
-    int count = atoi(count_str);
-    free(count_str);
+    int count = atoi(PQgetvalue(tables, 0, 0));
 
     if (count == 1)
         return true;
@@ -404,9 +393,9 @@ bool PgWriter::CheckTableExists(std::string const& name)
     return false;
 }
 
-void PgWriter::CreateTable(std::string const& schema_name,
-    std::string const& table_name, std::string const& column_name,
-    uint32_t pcid)
+void PgWriter::CreateTable(PgPipeline& commands,
+    std::string const& schema_name, std::string const& table_name,
+    std::string const& column_name, uint32_t pcid)
 {
     std::ostringstream oss;
     oss << "CREATE TABLE ";
@@ -419,7 +408,7 @@ void PgWriter::CreateTable(std::string const& schema_name,
         oss << "(" << pcid << ")";
     oss << ")";
 
-    pg_execute(m_session, oss.str());
+    commands.add(oss.str());
 }
 
 
@@ -439,76 +428,72 @@ void PgWriter::CreateIndex(std::string const& schema_name,
 }
 
 
-void PgWriter::writeTile(const PointViewPtr view)
+// Append the bytes in 'buf' to the patch as hex digits.
+void PgWriter::appendHex(const char *buf, size_t size)
 {
-    std::vector<char> storage(m_packedPointSize);
-    std::string hexrep;
-    size_t maxHexrepSize = m_packedPointSize * view->size() * 2;
-    hexrep.reserve(maxHexrepSize);
+    static const char syms[] = "0123456789ABCDEF";
 
-    m_insert.clear();
-    m_insert.reserve(maxHexrepSize + 3000);
-
-    for (PointId idx = 0; idx < view->size(); ++idx)
+    size_t pos = m_patch.size();
+    m_patch.resize(pos + size * 2);
+    char *out = &m_patch[pos];
+    for (size_t i = 0; i < size; ++i)
     {
-        size_t written = readPoint(*view.get(), idx, storage.data());
-
-        /* We are always getting uncompressed bytes off the block_data */
-        /* so we always used compression type 0 (uncompressed) in writing */
-        /* our WKB */
-        static char syms[] = "0123456789ABCDEF";
-        for (size_t i = 0; i != written; i++)
-        {
-            hexrep.push_back(syms[((storage[i] >> 4) & 0xf)]);
-            hexrep.push_back(syms[storage[i] & 0xf]);
-        }
+        unsigned char c = (unsigned char)buf[i];
+        *out++ = syms[c >> 4];
+        *out++ = syms[c & 0xf];
     }
+}
 
-    std::string insert_into("INSERT INTO ");
-    std::string values(" (" + pg_quote_identifier(m_column_name) +
-                       ") VALUES ('");
 
-    m_insert.append(insert_into);
+// Send the view as a patch on the COPY statement, which is started with
+// the first patch and ended in done().  The patch is written as a line of
+// hex WKB, the text form of a PcPatch.
+void PgWriter::writeTile(const PointViewPtr view)
+{
+    if (!m_copying)
+    {
+        std::string sql("COPY ");
+        if (m_schema_name.size())
+            sql += pg_quote_identifier(m_schema_name) + ".";
+        sql += pg_quote_identifier(m_table_name) + " (" +
+            pg_quote_identifier(m_column_name) + ") FROM STDIN";
+        pg_copy_begin(m_session, sql);
+        m_copying = true;
+    }
 
-    if (m_schema_name.size())
+    // The WKB header: a little-endian marker, then the PCID, the
+    // compression and the number of points.  Dimensional patches are sent
+    // as pgpointcloud's own dimensional patches (compression 1), with each
+    // dimension zlib-compressed, so the server doesn't have to compress
+    // them.  Everything else is sent uncompressed and left to the server.
+    bool dimensional =
+        (m_patch_compression_type == CompressionType::Dimensional);
+    if (dimensional)
+    {
+        m_points.clear();
+        packDimensional(*view, 0, view->size(), m_points, false);
+    }
+    else
     {
-        m_insert.append(pg_quote_identifier(m_schema_name));
-        m_insert.append(".");
+        m_points.resize(m_packedPointSize * view->size());
+        m_points.resize(packPoints(*view, 0, view->size(), m_points.data()));
     }
 
-    m_insert.append(pg_quote_identifier(m_table_name));
-    m_insert.append(values);
-
-    std::ostringstream options;
-
-    uint32_t num_points = view->size();
-    int32_t pcid = m_pcid;
-    CompressionType::Enum compression_v = CompressionType::None;
-    uint32_t compression = static_cast<uint32_t>(compression_v);
-
-#ifdef BOOST_LITTLE_ENDIAN
-    // needs to be 1 byte
-    options << boost::format("%02x") % 1;
-    SWAP_ENDIANNESS(pcid);
-    SWAP_ENDIANNESS(compression);
-    SWAP_ENDIANNESS(num_points);
-#elif BOOST_BIG_ENDIAN
-    // needs to be 1 byte
-    options << boost::format("%02x") % 0;
-#endif
-
-    // needs to be 4 bytes
-    options << boost::format("%08x") % pcid;
-    // needs to be 4 bytes
-    options << boost::format("%08x") % compression;
-    // needs to be 4 bytes
-    options << boost::format("%08x") % num_points;
-
-    m_insert.append(options.str());
-    m_insert.append(hexrep);
-    m_insert.append("')");
-
-    pg_execute(m_session, m_insert);
+    char header[13];
+    uint32_t values[3] = { m_pcid, dimensional ? 1u : 0u,
+        (uint32_t)view->size() };
+    header[0] = 1;
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t b = 0; b < 4; ++b)
+            header[1 + i * 4 + b] = (char)((values[i] >> (b * 8)) & 0xff);
+
+    m_patch.clear();
+    m_patch.reserve((sizeof(header) + m_points.size()) * 2 + 1);
+    appendHex(header, sizeof(header));
+    appendHex(m_points.data(), m_points.size());
+    m_patch.push_back('\n');
+
+    pg_copy_put(m_session, m_patch);
 }
 
 } // namespace pdal
@@ -39,6 +39,9 @@
 #include <pdal/StageFactory.hpp>
 #include "PgCommon.hpp"
 
+#include <string>
+#include <vector>
+
 namespace pdal
 {
 
@@ -67,18 +70,24 @@ private:
 
     void writeInit();
     void writeTile(const PointViewPtr view);
+    void appendHex(const char *buf, size_t size);
 
-    bool CheckTableExists(std::string const& name);
+    std::string tableExistsQuery(std::string const& name) const;
+    bool CheckTableExists(std::string const& name, PGresult *tables);
     bool CheckPointCloudExists();
     bool CheckPostGISExists();
-    uint32_t SetupSchema(uint32_t srid);
+    std::string formatsQuery() const;
+    uint32_t SetupSchema(PgPipeline& commands, PGresult *formats,
+                         uint32_t srid);
 
-    void CreateTable(std::string const& schema_name,
+    void CreateTable(PgPipeline& commands,
+                     std::string const& schema_name,
                      std::string const& table_name,
                      std::string const& column_name,
                      uint32_t pcid);
 
-    void DeleteTable(std::string const& schema_name,
+    void DeleteTable(PgPipeline& commands,
+                     std::string const& schema_name,
                      std::string const& table_name);
 
     void CreateIndex(std::string const& schema_name,
@@ -97,7 +106,10 @@ private:
     uint32_t m_srid;
     uint32_t m_pcid;
     bool m_overwrite;
-    std::string m_insert;
+    // Patches are sent with a single COPY that's open while writing.
+    bool m_copying;
+    std::vector<char> m_points;
+    std::string m_patch;
     Orientation::Enum m_orientation;
     std::string m_pre_sql;
     std::string m_post_sql;
@@ -58,6 +58,7 @@ void PredicateFilter::processOptions(const Options& options)
             options.getValueOrThrow<std::string>("script"));
     m_module = options.getValueOrThrow<std::string>("module");
     m_function = options.getValueOrThrow<std::string>("function");
+    m_chunkSize = options.getValueOrDefault<point_count_t>("chunk_size", 0);
 }
 
 
@@ -83,22 +84,32 @@ void PredicateFilter::ready(PointTableRef table)
 
 PointViewSet PredicateFilter::run(PointViewPtr view)
 {
-    m_pythonMethod->resetArguments();
-    m_pythonMethod->begin(*view);
-    m_pythonMethod->execute();
-
-    if (!m_pythonMethod->hasOutputVariable("Mask"))
-        throw python_error("Mask variable not set in predicate "
-            "filter function");
-
     PointViewPtr outview = view->makeNew();
 
-    void *pydata =
-        m_pythonMethod->extractResult("Mask", Dimension::Type::Unsigned8);
-    char *ok = (char *)pydata;
-    for (PointId idx = 0; idx < view->size(); ++idx)
-        if (*ok++)
-            outview->appendPoint(*view, idx);
+    // The script is run on chunks of the points so that the arrays
+    // passed to it are limited in size.
+    point_count_t chunk = m_chunkSize ? m_chunkSize : view->size();
+    for (PointId first = 0; first < view->size(); first += chunk)
+    {
+        point_count_t count = (std::min)(chunk, view->size() - first);
+        m_pythonMethod->resetArguments();
+        m_pythonMethod->begin(*view, first, count);
+        m_pythonMethod->execute();
+
+        if (!m_pythonMethod->hasOutputVariable("Mask"))
+            throw python_error("Mask variable not set in predicate "
+                "filter function");
+
+        std::ptrdiff_t stride;
+        char *ok = (char *)m_pythonMethod->extractResult("Mask",
+            Dimension::Type::Unsigned8, count, stride);
+        for (PointId idx = first; idx < first + count; ++idx)
+        {
+            if (*ok)
+                outview->appendPoint(*view, idx);
+            ok += stride;
+        }
+    }
 
     PointViewSet viewSet;
     viewSet.insert(outview);
@@ -59,6 +59,8 @@ private:
     std::string m_source;
     std::string m_module;
     std::string m_function;
+    // Points passed to each run of the script, or 0 for all of them.
+    point_count_t m_chunkSize;
 
     virtual void processOptions(const Options& options);
     virtual void ready(PointTableRef table);
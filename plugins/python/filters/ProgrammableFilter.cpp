@@ -68,6 +68,7 @@ void ProgrammableFilter::processOptions(const Options& options)
             options.getValueOrThrow<std::string>("script"));
     m_module = options.getValueOrThrow<std::string>("module");
     m_function = options.getValueOrThrow<std::string>("function");
+    m_chunkSize = options.getValueOrDefault<point_count_t>("chunk_size", 0);
 
     auto addDims = options.getOptions("add_dimension");
     for (auto it = addDims.cbegin(); it != addDims.cend(); ++it)
@@ -101,10 +102,18 @@ void ProgrammableFilter::filter(PointView& view)
 {
     log()->get(LogLevel::Debug5) << "Python script " << *m_script <<
         " processing " << view.size() << " points." << std::endl;
-    m_pythonMethod->resetArguments();
-    m_pythonMethod->begin(view);
-    m_pythonMethod->execute();
-    m_pythonMethod->end(view);
+
+    // The script is run on chunks of the points so that the arrays
+    // passed to it are limited in size.
+    point_count_t chunk = m_chunkSize ? m_chunkSize : view.size();
+    for (PointId first = 0; first < view.size(); first += chunk)
+    {
+        point_count_t count = (std::min)(chunk, view.size() - first);
+        m_pythonMethod->resetArguments();
+        m_pythonMethod->begin(view, first, count);
+        m_pythonMethod->execute();
+        m_pythonMethod->end(view, first, count);
+    }
 }
 
 
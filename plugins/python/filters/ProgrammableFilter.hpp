@@ -61,6 +61,8 @@ private:
     std::string m_source;
     std::string m_module;
     std::string m_function;
+    // Points passed to each run of the script, or 0 for all of them.
+    point_count_t m_chunkSize;
     std::vector<std::string> m_addDimensions;
 
     virtual void processOptions(const Options& options);
@@ -179,3 +179,56 @@ TEST(ProgrammableFilterTest, add_dimension)
         EXPECT_EQ(view->getFieldAs<uint16_t>(psid_id, i), 2);
     }
 }
+
+TEST(ProgrammableFilterTest, chunks)
+{
+    StageFactory f;
+
+    BOX3D bounds(0.0, 0.0, 0.0, 999.0, 999.0, 999.0);
+
+    Options ops;
+    ops.add("bounds", bounds);
+    ops.add("num_points", 1000);
+    ops.add("mode", "ramp");
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    // Y is changed in place and X through outs.  Z records the number of
+    // points the function saw.
+    Option source("source", "import numpy as np\n"
+        "def myfunc(ins,outs):\n"
+        "  Y = ins['Y']\n"
+        "  Y *= 2\n"
+        "  outs['X'] = ins['X'] + 10\n"
+        "  outs['Y'] = Y\n"
+        "  outs['Z'] = np.zeros(Y.size, dtype=np.double) + Y.size\n"
+        "  return True\n"
+    );
+    Options opts;
+    opts.add(source);
+    opts.add("module", "MyModule");
+    opts.add("function", "myfunc");
+    opts.add("chunk_size", 300);
+
+    std::unique_ptr<Stage> filter(f.createStage("filters.programmable"));
+    filter->setOptions(opts);
+    filter->setInput(reader);
+
+    PointTable table;
+    filter->prepare(table);
+    PointViewSet viewSet = filter->execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 1000u);
+
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::X, i),
+            i + 10.0);
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::Y, i),
+            i * 2.0);
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::Z, i),
+            i < 900 ? 300.0 : 100.0);
+    }
+}
@@ -46,68 +46,205 @@ namespace pdal
 {
 
 
+namespace
+{
+
+// Number of targets in a batch, and the number of batches that may wait
+// to be read.
+const std::size_t BatchTargets = 16384;
+const std::size_t MaxQueuedBatches = 4;
+
+} // unnamed namespace
+
+
 Dimension::Id::Enum getTimeDimensionId(bool syncToPps)
 {
     return syncToPps ? Dimension::Id::GpsTime : Dimension::Id::InternalTime;
 }
 
 
+void RxpPointcloud::Batch::reserve(std::size_t n)
+{
+    x.reserve(n);
+    y.reserve(n);
+    z.reserve(n);
+    time.reserve(n);
+    amplitude.reserve(n);
+    reflectance.reserve(n);
+    returnNumber.reserve(n);
+    numberOfReturns.reserve(n);
+    echoRange.reserve(n);
+    deviation.reserve(n);
+    backgroundRadiation.reserve(n);
+    isPpsLocked.reserve(n);
+}
+
+
 RxpPointcloud::RxpPointcloud(
         const std::string& uri,
         bool syncToPps,
-        bool minimal,
-        PointTableRef table)
+        bool minimal)
     : scanlib::pointcloud(syncToPps)
-    , m_view(new PointView(table))
-    , m_idx(0)
     , m_syncToPps(syncToPps)
     , m_minimal(minimal)
     , m_rc(scanlib::basic_rconnection::create(uri))
     , m_dec(m_rc)
+    , m_started(false)
+    , m_finished(false)
+    , m_stopping(false)
+    , m_currentOffset(0)
 {}
 
 
 RxpPointcloud::~RxpPointcloud()
 {
+    stop();
     m_rc->close();
 }
 
 
-point_count_t RxpPointcloud::read(PointViewPtr view, point_count_t count)
+void RxpPointcloud::stop()
 {
-    point_count_t numRead = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    if (m_decoder.joinable())
+        m_decoder.join();
+}
 
-    if (m_idx < m_view->size())
+
+// Runs on the decoding thread.
+void RxpPointcloud::decode()
+{
+    try
+    {
+        for (m_dec.get(m_rxpbuf); !m_dec.eoi(); m_dec.get(m_rxpbuf))
+        {
+            dispatch(m_rxpbuf.begin(), m_rxpbuf.end());
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping)
+                break;
+        }
+        if (m_filling && m_filling->size())
+            push(std::move(m_filling));
+    }
+    catch (...)
     {
-        numRead += writeSavedPoints(view, count);
-        if (numRead == count)
-            return numRead;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_error = std::current_exception();
     }
 
-    for (m_dec.get(m_rxpview); !m_dec.eoi(); m_dec.get(m_rxpview))
     {
-        dispatch(m_rxpview.begin(), m_rxpview.end());
-        if (m_view->size() - m_idx + numRead >= count) break;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
     }
+    m_cv.notify_all();
+}
 
-    numRead += writeSavedPoints(view, count - numRead);
 
-    return numRead;
+void RxpPointcloud::push(BatchPtr batch)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]()
+        { return m_queue.size() < MaxQueuedBatches || m_stopping; });
+    if (m_stopping)
+        return;
+    m_queue.push_back(std::move(batch));
+    lock.unlock();
+    m_cv.notify_all();
+}
+
+
+// Returns the next batch, or nothing once the input is exhausted.
+RxpPointcloud::BatchPtr RxpPointcloud::pop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]() { return m_queue.size() || m_finished; });
+    if (m_queue.empty())
+    {
+        if (m_error)
+        {
+            std::exception_ptr error = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+        return BatchPtr();
+    }
+    BatchPtr batch(std::move(m_queue.front()));
+    m_queue.pop_front();
+    lock.unlock();
+    m_cv.notify_all();
+    return batch;
 }
 
 
-point_count_t RxpPointcloud::writeSavedPoints(PointViewPtr view, point_count_t count)
+point_count_t RxpPointcloud::read(PointViewPtr view, point_count_t count)
 {
+    if (!m_started)
+    {
+        m_started = true;
+        m_decoder = std::thread(&RxpPointcloud::decode, this);
+    }
+
     point_count_t numRead = 0;
-    while (m_idx < m_view->size() && numRead < count)
+    while (numRead < count)
     {
-        view.appendPoint(*m_view, m_idx);
-        ++m_idx, ++numRead;
+        if (!m_current || m_currentOffset == m_current->size())
+        {
+            m_current = pop();
+            m_currentOffset = 0;
+            if (!m_current)
+                break;
+        }
+
+        const std::size_t n = std::min<std::size_t>(count - numRead,
+            m_current->size() - m_currentOffset);
+        writeBatch(*view, *m_current, m_currentOffset, n);
+        m_currentOffset += n;
+        numRead += n;
     }
+
     return numRead;
-};
+}
+
 
+void RxpPointcloud::writeBatch(PointView& view, const Batch& batch,
+    std::size_t begin, std::size_t count) const
+{
+    using namespace Dimension;
 
+    const PointId first = view.size();
+    view.setFieldArray(Id::X, first, count, batch.x.data() + begin);
+    view.setFieldArray(Id::Y, first, count, batch.y.data() + begin);
+    view.setFieldArray(Id::Z, first, count, batch.z.data() + begin);
+    view.setFieldArray(getTimeDimensionId(m_syncToPps), first, count,
+        batch.time.data() + begin);
+    if (!m_minimal)
+    {
+        view.setFieldArray(Id::Amplitude, first, count,
+            batch.amplitude.data() + begin);
+        view.setFieldArray(Id::Reflectance, first, count,
+            batch.reflectance.data() + begin);
+        view.setFieldArray(Id::ReturnNumber, first, count,
+            batch.returnNumber.data() + begin);
+        view.setFieldArray(Id::NumberOfReturns, first, count,
+            batch.numberOfReturns.data() + begin);
+        view.setFieldArray(Id::EchoRange, first, count,
+            batch.echoRange.data() + begin);
+        view.setFieldArray(Id::Deviation, first, count,
+            batch.deviation.data() + begin);
+        view.setFieldArray(Id::BackgroundRadiation, first, count,
+            batch.backgroundRadiation.data() + begin);
+        view.setFieldArray(Id::IsPpsLocked, first, count,
+            batch.isPpsLocked.data() + begin);
+    }
+}
+
+
+// Runs on the decoding thread.
 void RxpPointcloud::on_echo_transformed(echo_type echo)
 {
     if (!(scanlib::pointcloud::single == echo || scanlib::pointcloud::last == echo))
@@ -116,30 +253,37 @@ void RxpPointcloud::on_echo_transformed(echo_type echo)
         return;
     }
 
-    using namespace Dimension;
+    if (!m_filling)
+    {
+        m_filling.reset(new Batch);
+        m_filling->reserve(BatchTargets);
+    }
 
-    point_count_t idx = m_view->size();
-    unsigned int returnNumber = 1;
-    Id::Enum timeId = getTimeDimensionId(m_syncToPps);
+    Batch& b = *m_filling;
+    uint8_t returnNumber = 1;
     for (const auto& t : targets)
     {
-        m_view->setField(Id::X, idx, t.vertex[0]);
-        m_view->setField(Id::Y, idx, t.vertex[1]);
-        m_view->setField(Id::Z, idx, t.vertex[2]);
-        m_view->setField(timeId, idx, t.time);
+        b.x.push_back(t.vertex[0]);
+        b.y.push_back(t.vertex[1]);
+        b.z.push_back(t.vertex[2]);
+        b.time.push_back(t.time);
         if (!m_minimal)
         {
-            m_view->setField(Id::Amplitude, idx, t.amplitude);
-            m_view->setField(Id::Reflectance, idx, t.reflectance);
-            m_view->setField(Id::ReturnNumber, idx, returnNumber);
-            m_view->setField(Id::NumberOfReturns, idx, targets.size());
-            m_view->setField(Id::EchoRange, idx, t.echo_range);
-            m_view->setField(Id::Deviation, idx, t.deviation);
-            m_view->setField(Id::BackgroundRadiation, idx, t.background_radiation);
-            m_view->setField(Id::IsPpsLocked, idx, t.is_pps_locked);
+            b.amplitude.push_back(t.amplitude);
+            b.reflectance.push_back(t.reflectance);
+            b.returnNumber.push_back(returnNumber);
+            b.numberOfReturns.push_back((uint8_t)targets.size());
+            b.echoRange.push_back(t.echo_range);
+            b.deviation.push_back(t.deviation);
+            b.backgroundRadiation.push_back(t.background_radiation);
+            b.isPpsLocked.push_back(t.is_pps_locked);
         }
-        ++idx, ++returnNumber;
+        ++returnNumber;
     }
+
+    // The echoes of a shot stay in one batch.
+    if (b.size() >= BatchTargets)
+        push(std::move(m_filling));
 }
 
 
@@ -43,6 +43,14 @@
 
 #include <riegl/scanlib.hpp>
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <pdal/pdal_macros.hpp>
 #include <pdal/PointTable.hpp>
 #include <pdal/PointView.hpp>
@@ -55,14 +63,18 @@ namespace pdal
 Dimension::Id::Enum getTimeDimensionId(bool syncToPps);
 
 
+// Packets are decoded and their targets collected on a thread of their own.
+// Targets are handed to the reading thread in batches through a queue of
+// bounded length, so a scan streams through without all of its targets
+// being held, and the decoding of one batch overlaps the conversion of
+// the last into PDAL fields.
 class PDAL_DLL RxpPointcloud : public scanlib::pointcloud
 {
 public:
     RxpPointcloud(
             const std::string& uri,
             bool isSyncToPps,
-            bool m_minimal,
-            PointTableRef table);
+            bool m_minimal);
     virtual ~RxpPointcloud();
 
     point_count_t read(PointViewPtr view, point_count_t count);
@@ -76,16 +88,58 @@ protected:
     void on_echo_transformed(echo_type echo);
 
 private:
-    virtual point_count_t writeSavedPoints(PointViewPtr view, point_count_t count);
+    // The targets of a batch, a vector per dimension so that each can be
+    // set in a view a range at a time.
+    struct Batch
+    {
+        void reserve(std::size_t n);
+        std::size_t size() const
+            { return x.size(); }
+
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> z;
+        std::vector<double> time;
+        std::vector<float> amplitude;
+        std::vector<float> reflectance;
+        std::vector<uint8_t> returnNumber;
+        std::vector<uint8_t> numberOfReturns;
+        std::vector<double> echoRange;
+        std::vector<float> deviation;
+        std::vector<float> backgroundRadiation;
+        std::vector<uint8_t> isPpsLocked;
+    };
+    typedef std::unique_ptr<Batch> BatchPtr;
+
+    void decode();
+    void push(BatchPtr batch);
+    BatchPtr pop();
+    void writeBatch(PointView& view, const Batch& batch, std::size_t begin,
+        std::size_t count) const;
+    void stop();
 
-    PointViewPtr m_view;
-    point_count_t m_idx;
     bool m_syncToPps;
     bool m_minimal;
     std::shared_ptr<scanlib::basic_rconnection> m_rc;
     scanlib::decoder_rxpmarker m_dec;
     scanlib::buffer m_rxpbuf;
 
+    // Batch being filled by the decoding thread.
+    BatchPtr m_filling;
+
+    std::thread m_decoder;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<BatchPtr> m_queue;
+    bool m_started;
+    bool m_finished;
+    bool m_stopping;
+    std::exception_ptr m_error;
+
+    // Batch being handed out by read() and the number of its targets that
+    // have been.
+    BatchPtr m_current;
+    std::size_t m_currentOffset;
 };
 
 
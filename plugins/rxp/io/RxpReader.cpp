@@ -110,6 +110,7 @@ void RxpReader::processOptions(const Options& options)
     m_uri = extractRivlibURI(options);
     m_syncToPps = options.getValueOrDefault<bool>("sync_to_pps",
                                                   DEFAULT_SYNC_TO_PPS);
+    m_minimal = options.getValueOrDefault<bool>("minimal", DEFAULT_MINIMAL);
 }
 
 
@@ -121,7 +122,7 @@ void RxpReader::addDimensions(PointLayoutPtr layout)
 
 void RxpReader::ready(PointTableRef table)
 {
-    m_pointcloud.reset(new RxpPointcloud(m_uri, m_syncToPps, m_minimal, table));
+    m_pointcloud.reset(new RxpPointcloud(m_uri, m_syncToPps, m_minimal));
 }
 
 
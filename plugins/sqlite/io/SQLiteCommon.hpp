@@ -35,15 +35,18 @@
 #pragma once
 
 #include <pdal/pdal_error.hpp>
+#include <pdal/ConnectionPool.hpp>
 #include <pdal/Options.hpp>
 #include <pdal/Log.hpp>
 #include <pdal/XMLSchema.hpp>
 #include <pdal/Compression.hpp>
+#include <pdal/util/FileUtils.hpp>
 
 #include <boost/algorithm/string.hpp>
 
 #include <sqlite3.h>
 #include <memory>
+#include <mutex>
 #include <sstream>
 
 namespace pdal
@@ -105,6 +108,14 @@ public:
         null = false;
 
     }
+
+    // Take the bytes of 'buffer' without copying them.
+    blob(std::vector<uint8_t>&& buffer) : column()
+    {
+        blobBuf = std::move(buffer);
+        blobLen = blobBuf.size();
+        null = false;
+    }
 };
 
 typedef std::vector<column> row;
@@ -113,7 +124,8 @@ typedef std::vector<row> records;
 class Patch
 {
 public:
-    Patch() : count(0), remaining(0), m_isCompressed(false), idx(0)
+    Patch() : count(0), remaining(0), m_isCompressed(false),
+        m_isDimensional(false), idx(0)
     {}
 
     point_count_t count;
@@ -121,6 +133,7 @@ public:
 
     MetadataNode m_metadata;
     bool m_isCompressed;
+    bool m_isDimensional;
     std::string m_compVersion;
     std::vector<unsigned char> buf;
     size_t idx;
@@ -165,42 +178,48 @@ public:
         , m_connection(connection)
         , m_session(0)
         , m_statement(0)
+        , m_insertStatement(0)
         , m_position(-1)
+        , m_hasSpatialite(false)
+        , m_poolable(true)
     {
-        m_log->get(LogLevel::Debug3) << "Setting up config " << std::endl;
-        sqlite3_shutdown();
-        sqlite3_config(SQLITE_CONFIG_LOG, log_callback, this);
-        sqlite3_initialize();
-        m_log->get(LogLevel::Debug3) << "Set up config " << std::endl;
+        // sqlite can only be configured before it's initialized, and it
+        // can't be shut down while pooled sessions are open, so the log
+        // callback is set up once.  It writes to the newest session's log.
+        static std::once_flag flag;
+        std::call_once(flag, []()
+        {
+            sqlite3_config(SQLITE_CONFIG_LOG, log_callback, (void *)NULL);
+            sqlite3_initialize();
+        });
+        std::lock_guard<std::mutex> lock(logMutex());
+        currentLog() = m_log;
     }
 
     ~SQLite()
     {
+        sqlite3_finalize(m_statement);
+        sqlite3_finalize(m_insertStatement);
+        release();
 
-        if (m_session)
-        {
-#ifdef sqlite3_close_v2
-            sqlite3_close_v2(m_session);
-#else
-            sqlite3_close(m_session);
-#endif
-        }
-        sqlite3_shutdown();
-
-    }
-    void log(int num, char const* msg)
-    {
-        std::ostringstream oss;
-        oss << "SQLite code: " << num << " msg: '" << msg << "'";
-        m_log->get(LogLevel::Debug) << oss.str() << std::endl;
+        std::lock_guard<std::mutex> lock(logMutex());
+        if (currentLog() == m_log)
+            currentLog().reset();
     }
 
-    static void log_callback(void *p, int num, char const* msg)
+    static void log_callback(void *, int num, char const* msg)
     {
-        SQLite* sql = reinterpret_cast<SQLite*>(p);
-        sql->log(num, msg);
+        std::lock_guard<std::mutex> lock(logMutex());
+        if (currentLog())
+            currentLog()->get(LogLevel::Debug) << "SQLite code: " << num <<
+                " msg: '" << msg << "'" << std::endl;
     }
 
+    // Keep the session out of the connection pool when it's closed, as
+    // when settings have been made that a later stage shouldn't inherit.
+    void setPoolable(bool poolable)
+        { m_poolable = poolable; }
+
 
     void connect(bool bWrite=false)
     {
@@ -209,6 +228,26 @@ public:
             throw connection_failed("unable to connect to sqlite3 database, no connection string was given!");
         }
 
+        m_poolKey = std::string("sqlite:") + (bWrite ? "rw:" : "ro:") +
+            m_connection;
+        while (PooledSession *pooled =
+            (PooledSession *)ConnectionPool::shared().acquire(m_poolKey))
+        {
+            // A pooled session is no good once its file has been removed.
+            if (!FileUtils::fileExists(m_connection))
+            {
+                closePooled(pooled);
+                continue;
+            }
+            m_log->get(LogLevel::Debug3) << "Reusing pooled session" <<
+                std::endl;
+            m_session = pooled->m_session;
+            m_hasSpatialite = pooled->m_hasSpatialite;
+            m_spatialiteModule = pooled->m_spatialiteModule;
+            delete pooled;
+            return;
+        }
+
         int flags = SQLITE_OPEN_NOMUTEX;
         if (bWrite)
         {
@@ -258,7 +297,9 @@ public:
         m_position = 0;
         m_columns.clear();
         m_data.clear();
-        sqlite3_reset(m_statement);
+        // The rows are copied out, so the last query's statement is done.
+        sqlite3_finalize(m_statement);
+        m_statement = 0;
 
         m_log->get(LogLevel::Debug3) << "Querying '" << query.c_str() <<"'"<< std::endl;
 
@@ -369,26 +410,37 @@ public:
         return (int64_t)sqlite3_last_insert_rowid(m_session);
     }
 
+    // The statement is prepared once and reused for as long as it's the
+    // statement given, so that rows inserted one call at a time aren't
+    // parsed again for each call.
     bool insert(std::string const& statement, records const& rs)
     {
         records::size_type rows = rs.size();
 
-        int res = sqlite3_prepare_v2(m_session,
-                                  statement.c_str(),
-                                  static_cast<int>(statement.size()),
-                                  &m_statement,
-                                  0);
-        m_log->get(LogLevel::Debug3) << "Inserting '" << statement << "'"<<
-            std::endl;
-
-        if (res != SQLITE_OK)
+        if (!m_insertStatement || statement != m_insertSql)
         {
-            char const* zErrMsg = sqlite3_errmsg(m_session);
+            sqlite3_finalize(m_insertStatement);
+            m_insertStatement = 0;
+            m_insertSql.clear();
+
+            int res = sqlite3_prepare_v2(m_session,
+                                      statement.c_str(),
+                                      static_cast<int>(statement.size()),
+                                      &m_insertStatement,
+                                      0);
+            m_log->get(LogLevel::Debug3) << "Preparing insert '" <<
+                statement << "'"<< std::endl;
+
+            if (res != SQLITE_OK)
+            {
+                char const* zErrMsg = sqlite3_errmsg(m_session);
 
-              std::ostringstream ss;
-              ss << "sqlite insert prepare: "
-                 << zErrMsg;
-              throw sqlite_driver_error(ss.str());
+                  std::ostringstream ss;
+                  ss << "sqlite insert prepare: "
+                     << zErrMsg;
+                  throw sqlite_driver_error(ss.str());
+            }
+            m_insertSql = statement;
         }
 
         for (records::size_type r = 0; r < rows; ++r)
@@ -400,24 +452,25 @@ public:
                 const column& c = rs[r][pos];
                 if (c.null)
                 {
-                    didBind = sqlite3_bind_null(m_statement, pos+1);
+                    didBind = sqlite3_bind_null(m_insertStatement, pos+1);
                 }
                 else if (c.blobLen != 0)
                 {
-                    didBind = sqlite3_bind_blob(m_statement, pos+1,
+                    didBind = sqlite3_bind_blob(m_insertStatement, pos+1,
                                                 &(c.blobBuf.front()),
                                                 static_cast<int>(c.blobLen),
                                                 SQLITE_STATIC);
                 }
                 else
                 {
-                    didBind = sqlite3_bind_text(m_statement, pos+1,
+                    didBind = sqlite3_bind_text(m_insertStatement, pos+1,
                         c.data.c_str(), static_cast<int>(c.data.length()),
                         SQLITE_STATIC);
                 }
 
                 if (SQLITE_OK != didBind)
                 {
+                    sqlite3_reset(m_insertStatement);
                     std::ostringstream oss;
                     oss << "Failure to bind row number '"
                         << r <<"' at position number '" <<pos <<"'";
@@ -425,23 +478,31 @@ public:
                 }
             }
 
-            res = sqlite3_step(m_statement);
-
+            int res = sqlite3_step(m_insertStatement);
+            std::string errMsg;
             if (res != SQLITE_DONE && res != SQLITE_ROW)
-            {
-                char const* zErrMsg = sqlite3_errmsg(m_session);
+                errMsg = sqlite3_errmsg(m_session);
+
+            // The bound values belong to 'rs', so they're let go of here.
+            sqlite3_reset(m_insertStatement);
+            sqlite3_clear_bindings(m_insertStatement);
 
+            if (errMsg.size())
+            {
                 std::ostringstream ss;
-                ss << "sqlite insert failure: " << zErrMsg;
+                ss << "sqlite insert failure: " << errMsg;
                 throw sqlite_driver_error(ss.str());
             }
         }
-        sqlite3_finalize(m_statement);
         return true;
     }
 
     bool spatialite(const std::string& module_name="")
     {
+        // Loading spatialite is slow, and a pooled session may have it.
+        if (m_hasSpatialite && m_spatialiteModule == module_name)
+            return true;
+
         std::string so_extension;
         std::string lib_extension;
 #ifdef __APPLE__
@@ -482,6 +543,8 @@ public:
         execute(oss.str());
         oss.str("");
 
+        m_hasSpatialite = true;
+        m_spatialiteModule = module_name;
         return true;
 
     }
@@ -517,10 +580,72 @@ private:
     std::string m_connection;
     sqlite3* m_session;
     sqlite3_stmt* m_statement;
+    sqlite3_stmt* m_insertStatement;
+    std::string m_insertSql;
     records m_data;
     records::size_type m_position;
     std::map<std::string, int32_t> m_columns;
     std::vector<std::string> m_types;
+    std::string m_poolKey;
+    bool m_hasSpatialite;
+    std::string m_spatialiteModule;
+    bool m_poolable;
+
+    // A session waiting in the connection pool.
+    struct PooledSession
+    {
+        sqlite3 *m_session;
+        bool m_hasSpatialite;
+        std::string m_spatialiteModule;
+    };
+
+    static std::mutex& logMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static LogPtr& currentLog()
+    {
+        static LogPtr log;
+        return log;
+    }
+
+    static void close(sqlite3 *session)
+    {
+#ifdef sqlite3_close_v2
+        sqlite3_close_v2(session);
+#else
+        sqlite3_close(session);
+#endif
+    }
+
+    static void closePooled(void *p)
+    {
+        PooledSession *pooled = (PooledSession *)p;
+        close(pooled->m_session);
+        delete pooled;
+    }
+
+    // Give the session to the connection pool, unless it's in the middle
+    // of a transaction or has statements that haven't been finalized.
+    void release()
+    {
+        if (!m_session)
+            return;
+        if (m_poolable && sqlite3_get_autocommit(m_session) &&
+            !sqlite3_next_stmt(m_session, NULL))
+        {
+            PooledSession *pooled = new PooledSession;
+            pooled->m_session = m_session;
+            pooled->m_hasSpatialite = m_hasSpatialite;
+            pooled->m_spatialiteModule = m_spatialiteModule;
+            ConnectionPool::shared().release(m_poolKey, pooled, closePooled);
+        }
+        else
+            close(m_session);
+        m_session = 0;
+    }
 
     void check_error(std::string const& msg)
     {
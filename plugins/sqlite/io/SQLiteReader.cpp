@@ -34,6 +34,9 @@
 
 #include "SQLiteReader.hpp"
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <limits>
 
 namespace pdal
 {
@@ -99,9 +102,12 @@ Options SQLiteReader::getDefaultOptions()
         "Connection string to connect to database");
     Option query("query", "",
         "SELECT statement that returns point cloud");
+    Option bounds("bounds", BOX3D(),
+        "Read only the patches whose extent intersects these bounds");
 
     options.add(connection);
     options.add(query);
+    options.add(bounds);
 
     return options;
 }
@@ -152,6 +158,18 @@ void SQLiteReader::processOptions(const Options& options)
     m_query = options.getValueOrThrow<std::string>("query");
     m_connection = options.getValueOrDefault<std::string>("connection", "");
     m_modulename = options.getValueOrDefault<std::string>("module", "");
+    m_bounds = options.getValueOrDefault<BOX3D>("bounds", BOX3D());
+}
+
+
+// Patches are only chosen by their extent, so points of the patches read
+// may be outside the bounds.
+bool SQLiteReader::setBounds(const BOX3D& bounds)
+{
+    if (bounds.empty() || !m_bounds.empty())
+        return false;
+    m_bounds = bounds;
+    return true;
 }
 
 
@@ -198,10 +216,10 @@ void SQLiteReader::addDimensions(PointLayoutPtr layout)
         FileUtils::closeFile(out);
     }
 
-    XMLSchema schema(s.data);
-    m_patch->m_metadata = schema.getMetadata();
+    std::shared_ptr<const XMLSchema> schema = XMLSchema::cached(s.data);
+    m_patch->m_metadata = schema->getMetadata();
 
-    loadSchema(layout, schema);
+    loadSchema(layout, *schema);
 }
 
 
@@ -209,95 +227,149 @@ void SQLiteReader::ready(PointTableRef table)
 {
     m_at_end = false;
     b_doneQuery = false;
+    m_decoded.clear();
+
+    MetadataNode comp = m_patch->m_metadata.findChild("compression");
+    m_patch->m_isCompressed = boost::iequals(comp.value(), "lazperf");
+    m_patch->m_isDimensional = boost::iequals(comp.value(), "dimensional");
+    m_patch->m_compVersion = m_patch->m_metadata.findChild("version").value();
+    log()->get(LogLevel::Debug3) << "patch compression? "
+                                 << m_patch->m_isCompressed << std::endl;
+    if (m_patch->m_isCompressed)
+        log()->get(LogLevel::Debug3) << "patch compression version: "
+                                     << m_patch->m_compVersion << std::endl;
 
     m_session.reset(new SQLite(m_connection, log()));
     m_session->connect(false); // don't connect in write mode
 }
 
 
-bool SQLiteReader::nextBuffer()
+// The query, limited to patches whose EXTENT intersects the bounds if
+// there are any.
+std::string SQLiteReader::dataQuery() const
 {
-    return m_session->next();
+    if (m_bounds.empty())
+        return m_query;
+
+    std::ostringstream oss;
+    oss.precision(std::numeric_limits<double>::max_digits10);
+    oss << "SELECT * FROM (" << m_query << ") AS q WHERE "
+        "MbrIntersects(q.extent, BuildMbr(" << m_bounds.minx << ", " <<
+        m_bounds.miny << ", " << m_bounds.maxx << ", " << m_bounds.maxy <<
+        ", ST_SRID(q.extent)))";
+    return oss.str();
 }
 
 
-point_count_t SQLiteReader::readPatch(PointViewPtr view, point_count_t numPts)
+// Fetch the next patches from the query results and decompress them on
+// the thread pool.  Returns false if there are no more patches.
+bool SQLiteReader::fetchPatches()
 {
-    const row* r = m_session->get();
-    if (!r)
-        throw pdal_error("readPatch with no data in session!");
-    std::map<std::string, int32_t> const& columns = m_session->columns();
+    std::vector<const row *> rows;
+    if (!b_doneQuery)
+    {
+        m_session->query(dataQuery());
+        b_doneQuery = true;
+        if (const row *r = m_session->get())
+        {
+            validateQuery();
+            rows.push_back(r);
+        }
+        else
+            return false;
+    }
 
-    // Availability of positions already validated
-    int32_t position = columns.find("POINTS")->second;
+    const size_t maxPatches = 4 * ThreadPool::shared().size();
+    while (rows.size() < maxPatches && m_session->next())
+        rows.push_back(m_session->get());
+    if (rows.empty())
+        return false;
 
-    MetadataNode comp = m_patch->m_metadata.findChild("compression");
-    m_patch->m_isCompressed = boost::iequals(comp.value(), "lazperf");
-    m_patch->m_compVersion = m_patch->m_metadata.findChild("version").value();
+    size_t first = m_decoded.size();
+    for (const row *r : rows)
+    {
+        DecodedPatch patch;
+        patch.m_row = r;
+        patch.m_read = 0;
+        patch.m_points = NULL;
+        m_decoded.push_back(std::move(patch));
+    }
+
+    auto decode = [this, first](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            decodePatch(m_decoded[first + i]);
+    };
+    if (m_patch->m_isCompressed || m_patch->m_isDimensional)
+        ThreadPool::shared().parallelFor(rows.size(), 1, decode);
+    else
+        decode(0, rows.size());
+    return true;
+}
 
-    position = columns.find("NUM_POINTS")->second;
-    int32_t count = boost::lexical_cast<int32_t>((*r)[position].data);
-    m_patch->remaining = count;
-    m_patch->count = count;
 
-    log()->get(LogLevel::Debug3) << "patch compression? "
-                                 << m_patch->m_isCompressed << std::endl;
+// Find the points of the patch, decompressing them if needed.  This may
+// run on the thread pool, so it only reads the row and fills in the
+// patch.
+void SQLiteReader::decodePatch(DecodedPatch& patch) const
+{
+    std::map<std::string, int32_t> const& columns = m_session->columns();
+    const row& r = *patch.m_row;
 
-    if (m_patch->m_isCompressed)
-        log()->get(LogLevel::Debug3) << "patch compression version: "
-                                     << m_patch->m_compVersion << std::endl;
+    // Availability of positions already validated
+    int32_t position = columns.find("NUM_POINTS")->second;
+    patch.m_count = boost::lexical_cast<point_count_t>(r[position].data);
 
     position = columns.find("POINTS")->second;
-
-    point_count_t numRead = 0;
-    PointId nextId = view->size();
+    const std::vector<uint8_t>& blob = r[position].blobBuf;
     if (m_patch->m_isCompressed)
     {
 #ifdef PDAL_HAVE_LAZPERF
-        LazPerfDecompressor<Patch> decompressor(*m_patch, dbDimTypes());
+        if (blob.empty())
+            throw pdal_error("Compressed patch size was 0!");
 
         // Set the data into the patch.
-        m_patch->setBytes((*r)[position].blobBuf);
-        std::vector<char> tmpBuf(decompressor.pointSize());
-        while (numRead < numPts && count > 0)
-        {
-            decompressor.decompress(tmpBuf.data(), tmpBuf.size());
-            writePoint(*view.get(), nextId, tmpBuf.data());
-
-            if (m_cb)
-                m_cb(*view, nextId);
-
-            nextId++;
-            numRead++;
-            count--;
-        }
+        Patch compressed;
+        compressed.setBytes(blob);
+        LazPerfDecompressor<Patch> decompressor(compressed, dbDimTypes());
+        patch.m_buf.resize(patch.m_count * decompressor.pointSize());
+        decompressor.decompress(patch.m_buf.data(), patch.m_buf.size());
+        patch.m_points = patch.m_buf.data();
 #else
         throw pdal_error("Can't decompress without LAZperf.");
 #endif
-
-        log()->get(LogLevel::Debug3) << "Compressed byte size: " <<
-            m_patch->byte_size() << std::endl;
-        if (!m_patch->byte_size())
-            throw pdal_error("Compressed patch size was 0!");
-        log()->get(LogLevel::Debug3) << "Uncompressed byte size: " <<
-            (m_patch->count * packedPointSize()) << std::endl;
+    }
+    else if (m_patch->m_isDimensional)
+    {
+        unpackDimensional((const char *)blob.data(), blob.size(),
+            patch.m_count, patch.m_buf);
+        patch.m_points = patch.m_buf.data();
     }
     else
     {
-        const char *pos = (const char *)&((*r)[position].blobBuf[0]);
-        while (numRead < numPts && count > 0)
-        {
-            writePoint(*view.get(), nextId, pos);
-
-            pos += packedPointSize();
-            if (m_cb)
-                m_cb(*view, nextId);
-            nextId++;
-            numRead++;
-            count--;
-        }
+        if (blob.size() < patch.m_count * packedPointSize())
+            throw pdal_error("Patch is smaller than its points.");
+        patch.m_points = (const char *)blob.data();
     }
-    m_patch->remaining -= numRead;
+}
+
+
+// Add up to 'numPts' points of the first decoded patch to the view.
+point_count_t SQLiteReader::readPatch(PointViewPtr view, point_count_t numPts)
+{
+    DecodedPatch& patch = m_decoded.front();
+
+    point_count_t numRead = (std::min)(numPts, patch.m_count - patch.m_read);
+    PointId nextId = view->size();
+    const char *pos = patch.m_points + patch.m_read * packedPointSize();
+
+    unpackPoints(*view, nextId, numRead, pos);
+    if (m_cb)
+        for (PointId idx = nextId; idx < nextId + numRead; ++idx)
+            m_cb(*view, idx);
+    patch.m_read += numRead;
+    if (patch.m_read == patch.m_count)
+        m_decoded.pop_front();
     return numRead;
 }
 
@@ -307,36 +379,19 @@ point_count_t SQLiteReader::read(PointViewPtr view, point_count_t count)
     if (eof())
         return 0;
 
-    log()->get(LogLevel::Debug4) << "read called with "
+    PDAL_LOG(log(), LogLevel::Debug4) << "read called with "
         "PointView filled to " << view->size() << " points" <<
         std::endl;
 
     point_count_t totalNumRead = 0;
-    if (! b_doneQuery)
-    {
-        // read first patch
-        m_session->query(m_query);
-        validateQuery();
-        b_doneQuery = true;
-        totalNumRead = readPatch(view, count);
-    }
-
-    int patch_count(0);
     while (totalNumRead < count)
     {
-        if (m_patch->remaining == 0)
+        if (m_decoded.empty() && !fetchPatches())
         {
-            if (!nextBuffer())
-            {
-                m_at_end = true;
-                return totalNumRead;
-            }
+            m_at_end = true;
+            break;
         }
-        PointId bufBegin = view->size();
-        point_count_t numRead = readPatch(view, count - totalNumRead);
-        PointId bufEnd = bufBegin + numRead;
-        totalNumRead += numRead;
-        patch_count++;
+        totalNumRead += readPatch(view, count - totalNumRead);
     }
     return totalNumRead;
 }
@@ -40,6 +40,7 @@
 
 #include "SQLiteCommon.hpp"
 
+#include <deque>
 #include <vector>
 
 namespace pdal
@@ -56,11 +57,25 @@ public:
     std::string getName() const;
 
     Options getDefaultOptions();
+    virtual bool setBounds(const BOX3D& bounds);
     SpatialReference fetchSpatialReference(std::string const& query) const;
     SQLite& getSession()
         { return *m_session.get(); }
 
 private:
+    // The points of a patch that's been fetched and, if needed,
+    // decompressed.
+    struct DecodedPatch
+    {
+        const row *m_row;
+        point_count_t m_count;
+        // Number of points already added to the view.
+        point_count_t m_read;
+        // The packed points, in the row's blob when uncompressed.
+        const char *m_points;
+        std::vector<char> m_buf;
+    };
+
     std::unique_ptr<SQLite> m_session;
     std::string m_query;
     std::string m_schemaFile;
@@ -68,6 +83,8 @@ private:
     std::string m_modulename;
     boost::optional<SpatialReference> m_spatialRef;
     PatchPtr m_patch;
+    BOX3D m_bounds;
+    std::deque<DecodedPatch> m_decoded;
 
     bool m_at_end;
     bool b_doneQuery;
@@ -81,8 +98,10 @@ private:
         { return m_at_end; }
 
     void validateQuery() const;
+    std::string dataQuery() const;
+    bool fetchPatches();
+    void decodePatch(DecodedPatch& patch) const;
     point_count_t readPatch(PointViewPtr view, point_count_t count);
-    bool nextBuffer();
 
     SQLiteReader& operator=(const SQLiteReader&); // not implemented
     SQLiteReader(const SQLiteReader&); // not implemented
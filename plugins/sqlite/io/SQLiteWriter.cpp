@@ -35,6 +35,7 @@
 #include "SQLiteWriter.hpp"
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/pdal_internal.hpp>
 #include <pdal/util/FileUtils.hpp>
 
@@ -67,9 +68,20 @@ SQLiteWriter::SQLiteWriter() :
     , m_orientation(Orientation::PointMajor)
     , m_is3d(false)
     , m_doCompression(false)
+    , m_dimensional(false)
+    , m_bulkLoad(false)
+    , m_patchesPerCommit(0)
 {}
 
 
+SQLiteWriter::~SQLiteWriter()
+{
+    // Tiles still being made refer to this writer.
+    for (auto& p : m_pending)
+        p.m_future.wait();
+}
+
+
 void SQLiteWriter::processOptions(const Options& options)
 {
     m_connection =
@@ -94,7 +106,20 @@ void SQLiteWriter::processOptions(const Options& options)
     m_srid =
         m_options.getValueOrDefault<uint32_t>("srid", 4326);
     m_is3d = m_options.getValueOrDefault<bool>("is3d", false);
-    m_doCompression = m_options.getValueOrDefault<bool>("compression", false);
+    // 'compression' was a switch for LAZperf and still accepts a boolean.
+    std::string compression =
+        m_options.getValueOrDefault<std::string>("compression", "false");
+    if (boost::iequals(compression, "dimensional"))
+        m_dimensional = true;
+    else if (boost::iequals(compression, "lazperf"))
+        m_doCompression = true;
+    else if (!boost::iequals(compression, "none"))
+        m_doCompression = m_options.getValueOrDefault<bool>("compression",
+            false);
+    processPrecision(options, m_doCompression);
+    m_bulkLoad = m_options.getValueOrDefault<bool>("bulk_load", false);
+    m_patchesPerCommit =
+        m_options.getValueOrDefault<uint32_t>("patches_per_commit", 0);
 }
 
 
@@ -107,6 +132,14 @@ void SQLiteWriter::initialize()
         m_session = std::unique_ptr<SQLite>(new SQLite(m_connection, log()));
         m_session->connect(true);
         log()->get(LogLevel::Debug) << "Connected to database" << std::endl;
+        if (m_bulkLoad)
+        {
+            // Trade safety against a crash mid-load for fewer disk syncs.
+            // A later stage shouldn't get the session with these settings.
+            m_session->setPoolable(false);
+            m_session->execute("PRAGMA synchronous = OFF");
+            m_session->execute("PRAGMA journal_mode = MEMORY");
+        }
         bool bHaveSpatialite = m_session->doesTableExist("geometry_columns");
         log()->get(LogLevel::Debug) << "Have spatialite?: " <<
             bHaveSpatialite << std::endl;
@@ -126,8 +159,6 @@ void SQLiteWriter::initialize()
         oss << "Unable to connect to database with error '" << e.what() << "'";
         throw pdal_error(oss.str());
     }
-
-    m_patch = PatchPtr(new Patch());
 }
 
 
@@ -395,6 +426,8 @@ bool SQLiteWriter::IsValidGeometryWKT(std::string const& input) const
 
 void SQLiteWriter::done(PointTableRef table)
 {
+    insertPending(0);
+
     if (m_doCreateIndex)
     {
         CreateIndexes(m_block_table, "extent", m_is3d);
@@ -453,6 +486,13 @@ void SQLiteWriter::CreateCloud()
         m.add("compression", "lazperf");
         m.add("version", "1.0");
     }
+    else if (m_dimensional)
+    {
+        Metadata metadata;
+        m = metadata.getNode();
+        m.add("compression", "dimensional");
+        m.add("version", "1.0");
+    }
     XMLSchema schema(dbDimTypes(), m);
     std::string xml = schema.xml();
 
@@ -499,72 +539,158 @@ void SQLiteWriter::CreateCloud()
 }
 
 
+// Tiles are made on the thread pool when the table allows, ahead of their
+// insertion, which happens in the order the views were written.
 void SQLiteWriter::writeTile(const PointViewPtr view)
 {
-    using namespace std;
-
-    Patch outpatch;
+    PendingTile p;
+    p.m_tile.reset(new Tile);
 
-    if (m_doCompression)
+    // A streamed chunk's points are replaced once this returns.
+    if (dynamic_cast<FixedPointTable *>(&view->table()))
     {
-#ifdef PDAL_HAVE_LAZPERF
-        LazPerfCompressor<Patch> compressor(*m_patch, dbDimTypes());
+        Tile *tile = p.m_tile.get();
+        packTile(*view, *tile);
+        p.m_future = ThreadPool::shared().submit([this, tile]()
+            { compressTile(*tile); });
+        m_pending.push_back(std::move(p));
+        insertPending(ThreadPool::shared().size());
+    }
+    else if (view->table().threadSafe())
+    {
+        p.m_view = view;
+        Tile *tile = p.m_tile.get();
+        p.m_future = ThreadPool::shared().submit([this, view, tile]()
+            { makeTile(*view, *tile); });
+        m_pending.push_back(std::move(p));
+        insertPending(ThreadPool::shared().size());
+    }
+    else
+    {
+        insertPending(0);
+        makeTile(*view, *p.m_tile);
+        insertTile(*p.m_tile);
+    }
+}
 
-        std::vector<char> outbuf(m_packedPointSize);
-        for (PointId idx = 0; idx < view->size(); idx++)
+
+// Insert the oldest pending tiles until no more than 'maxPending' are left.
+void SQLiteWriter::insertPending(size_t maxPending)
+{
+    while (m_pending.size() > maxPending)
+    {
+        PendingTile& p = m_pending.front();
+        try
+        {
+            ThreadPool::shared().wait(p.m_future);
+        }
+        catch (...)
         {
-            size_t size = readPoint(*view.get(), idx, outbuf.data());
-            // Read the data and write to the patch.
-            compressor.compress(outbuf.data(), size);
+            m_pending.pop_front();
+            throw;
         }
-        compressor.done();
+        insertTile(*p.m_tile);
+        m_pending.pop_front();
+    }
+}
+
+
+// Pack or compress the points of the view into a patch and find its
+// bounds.  This runs on the thread pool, so it only reads the view and
+// fills in the tile.
+void SQLiteWriter::makeTile(const PointView& view, Tile& tile)
+{
+    packTile(view, tile);
+    compressTile(tile);
+}
+
+
+// Pack the points of the view into a tile and find its bounds.  Points to
+// be compressed with LAZperf are left packed for compressTile().
+void SQLiteWriter::packTile(const PointView& view, Tile& tile)
+{
+    if (m_dimensional)
+    {
+        std::vector<char> outbuf;
+        packDimensional(view, 0, view.size(), outbuf, true);
+        tile.m_bytes.assign(outbuf.begin(), outbuf.end());
+    }
+    else
+    {
+        tile.m_bytes.resize(m_packedPointSize * view.size());
+        size_t size = packPoints(view, 0, view.size(),
+            (char *)tile.m_bytes.data());
+        tile.m_bytes.resize(size);
+    }
+
+    uint32_t precision(9);
+    BOX3D b = view.calculateBounds(true);
+    tile.m_count = view.size();
+    tile.m_extent = b.toWKT(precision); // polygons are only 2d, not cubes
+    tile.m_box = b.toBox(precision, 3);
+}
+
+
+// Compress the packed points of a tile with LAZperf if asked.
+void SQLiteWriter::compressTile(Tile& tile)
+{
+    if (!m_doCompression)
+        return;
+
+#ifdef PDAL_HAVE_LAZPERF
+    Patch patch;
+    LazPerfCompressor<Patch> compressor(patch, dbDimTypes());
+
+    // The points are packed, so compress them one at a time.
+    size_t pointSize = tile.m_count ? tile.m_bytes.size() / tile.m_count : 0;
+    const char *pos = (const char *)tile.m_bytes.data();
+    for (point_count_t i = 0; i < tile.m_count; ++i, pos += pointSize)
+        compressor.compress(pos, pointSize);
+    compressor.done();
+    tile.m_bytes = std::move(patch.buf);
 #else
-        throw pdal_error("Can't compress without LAZperf.");
+    throw pdal_error("Can't compress without LAZperf.");
 #endif
+}
 
-        size_t viewSize = view->size() * view->pointSize();
-        double percent = (double) m_patch->byte_size()/(double) viewSize;
+
+void SQLiteWriter::insertTile(Tile& tile)
+{
+    if (m_doCompression || m_dimensional)
+    {
+        size_t viewSize = tile.m_count * m_packedPointSize;
+        double percent = (double)tile.m_bytes.size() / (double)viewSize;
         percent = percent * 100;
-        log()->get(LogLevel::Debug3) << "Compressing tile by " <<
+        PDAL_LOG(log(), LogLevel::Debug3) << "Compressing tile by " <<
             boost::str(boost::format("%.2f") % (100 - percent)) <<
             "%" << std::endl;
     }
     else
-    {
-        std::vector<char> storage(m_packedPointSize);
-
-        for (PointId idx = 0; idx < view->size(); idx++)
-        {
-            size_t size = readPoint(*view.get(), idx, storage.data());
-            m_patch->putBytes((const unsigned char *)storage.data(), size);
-        }
-        log()->get(LogLevel::Debug3) << "uncompressed size: " <<
-            m_patch->getBytes().size() << std::endl;
-    }
+        PDAL_LOG(log(), LogLevel::Debug3) << "uncompressed size: " <<
+            tile.m_bytes.size() << std::endl;
+    PDAL_LOG(log(), LogLevel::Debug3) << "extent: " << tile.m_extent << std::endl;
+    PDAL_LOG(log(), LogLevel::Debug3) << "bbox: " << tile.m_box << std::endl;
 
     records rs;
     row r;
 
-    uint32_t precision(9);
-    BOX3D b = view->calculateBounds(true);
-    std::string bounds = b.toWKT(precision); // polygons are only 2d, not cubes
-
-    std::string box = b.toBox(precision, 3);
-    log()->get(LogLevel::Debug3) << "extent: " << bounds << std::endl;
-    log()->get(LogLevel::Debug3) << "bbox: " << box << std::endl;
-
     r.push_back(column(m_obj_id));
     r.push_back(column(m_block_id));
-    r.push_back(column(view->size()));
-    r.push_back(blob((const char*)(&m_patch->getBytes()[0]),
-        m_patch->getBytes().size()));
-    r.push_back(column(bounds));
+    r.push_back(column(tile.m_count));
+    r.push_back(blob(std::move(tile.m_bytes)));
+    r.push_back(column(tile.m_extent));
     r.push_back(column(m_srid));
-    r.push_back(column(box));
-    rs.push_back(r);
+    r.push_back(column(tile.m_box));
+    rs.push_back(std::move(r));
     m_session->insert(m_block_insert_query.str(), rs);
     m_block_id++;
 
+    // Start a new transaction every so many patches if asked.
+    if (m_patchesPerCommit && (m_block_id % m_patchesPerCommit) == 0)
+    {
+        m_session->commit();
+        m_session->begin();
+    }
 }
 
 } // namespaces
@@ -38,6 +38,9 @@
 #include <pdal/StageFactory.hpp>
 #include "SQLiteCommon.hpp"
 
+#include <deque>
+#include <future>
+
 namespace pdal
 {
 
@@ -46,12 +49,31 @@ class PDAL_DLL SQLiteWriter : public DbWriter
 {
 public:
     SQLiteWriter();
+    ~SQLiteWriter();
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
 
 private:
+    // A patch ready to be inserted into the block table.
+    struct Tile
+    {
+        point_count_t m_count;
+        std::string m_extent;
+        std::string m_box;
+        std::vector<uint8_t> m_bytes;
+    };
+
+    // A view whose tile is being made on the thread pool.  When streaming,
+    // the view's points are packed before the next chunk replaces them, so
+    // only compression is left to the pool and no view is kept.
+    struct PendingTile
+    {
+        PointViewPtr m_view;
+        std::unique_ptr<Tile> m_tile;
+        std::future<void> m_future;
+    };
 
     SQLiteWriter& operator=(const SQLiteWriter&); // not implemented
     SQLiteWriter(const SQLiteWriter&); // not implemented
@@ -63,6 +85,11 @@ private:
 
     void writeInit();
     void writeTile(const PointViewPtr view);
+    void makeTile(const PointView& view, Tile& tile);
+    void packTile(const PointView& view, Tile& tile);
+    void compressTile(Tile& tile);
+    void insertTile(Tile& tile);
+    void insertPending(size_t maxPending);
     void CreateBlockTable();
     void CreateCloudTable();
     bool CheckTableExists(std::string const& name);
@@ -94,8 +121,11 @@ private:
     std::string m_connection;
     std::string m_modulename;
     bool m_is3d;
-    bool m_doCompression;;
-    PatchPtr m_patch;
+    bool m_doCompression;
+    bool m_dimensional;
+    bool m_bulkLoad;
+    uint32_t m_patchesPerCommit;
+    std::deque<PendingTile> m_pending;
 };
 
 } // namespaces
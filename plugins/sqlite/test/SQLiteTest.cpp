@@ -35,6 +35,7 @@
 #include <pdal/pdal_test_main.hpp>
 
 #include <pdal/util/FileUtils.hpp>
+#include <pdal/ConnectionPool.hpp>
 #include <pdal/StageFactory.hpp>
 
 #include <pdal/PointView.hpp>
@@ -43,6 +44,10 @@
 
 #include "Support.hpp"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 using namespace pdal;
 
 Options getSQLITEOptions()
@@ -74,7 +79,7 @@ Options getSQLITEOptions()
     return options;
 }
 
-void testReadWrite(bool compression, bool scaling)
+void testReadWrite(const std::string& compression, bool scaling)
 {
     // remove file from earlier run, if needed
     std::string tempFilename =
@@ -137,24 +142,186 @@ void testReadWrite(bool compression, bool scaling)
 
 TEST(SQLiteTest, readWrite)
 {
-    testReadWrite(false, false);
+    testReadWrite("none", false);
 }
 
 #ifdef PDAL_HAVE_LAZPERF
 TEST(SQLiteTest, readWriteCompress)
 {
-    testReadWrite(true, false);
+    testReadWrite("lazperf", false);
 }
 #endif
 
+TEST(SQLiteTest, readWriteDimensional)
+{
+    testReadWrite("dimensional", false);
+}
+
+TEST(SQLiteTest, readWriteDimensionalScale)
+{
+    testReadWrite("dimensional", true);
+}
+
 TEST(SQLiteTest, readWriteScale)
 {
-    testReadWrite(false, true);
+    testReadWrite("none", true);
 }
 
 #ifdef PDAL_HAVE_LAZPERF
 TEST(SQLiteTest, readWriteCompressScale)
 {
-    testReadWrite(true, true);
+    testReadWrite("lazperf", true);
 }
 #endif
+
+
+// Many patches, inserted over several transactions, must read back as the
+// points that were written, and be chosen by their extent.
+TEST(SQLiteTest, readWriteTiles)
+{
+    std::string tempFilename =
+        getSQLITEOptions().getValueOrThrow<std::string>("connection");
+
+    Options sqliteOptions = getSQLITEOptions();
+    sqliteOptions.add("bulk_load", true);
+    sqliteOptions.add("patches_per_commit", 7);
+
+    Options lasReadOpts;
+    lasReadOpts.add("filename", Support::datapath("las/1.2-with-color.las"));
+
+    LasReader reader;
+    reader.setOptions(lasReadOpts);
+
+    StageFactory f;
+    std::unique_ptr<Stage> chipper(f.createStage("filters.chipper"));
+    Options chipperOpts;
+    chipperOpts.add("capacity", 15);
+    chipper->setOptions(chipperOpts);
+    chipper->setInput(reader);
+
+    std::unique_ptr<Stage> sqliteWriter(f.createStage("writers.sqlite"));
+    sqliteWriter->setOptions(sqliteOptions);
+    sqliteWriter->setInput(*chipper);
+
+    PointTable table;
+    sqliteWriter->prepare(table);
+    PointViewSet written = sqliteWriter->execute(table);
+    EXPECT_GT(written.size(), 7U);
+
+    std::unique_ptr<Stage> sqliteReader(f.createStage("readers.sqlite"));
+    sqliteReader->setOptions(sqliteOptions);
+
+    PointTable table2;
+    sqliteReader->prepare(table2);
+    PointViewSet viewSet = sqliteReader->execute(table2);
+    EXPECT_EQ(viewSet.size(), 1U);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 1065U);
+
+    using namespace Dimension;
+
+    auto sorted = [](const PointView& v)
+    {
+        std::vector<std::pair<double, double>> points;
+        for (PointId idx = 0; idx < v.size(); ++idx)
+            points.push_back(std::make_pair(
+                v.getFieldAs<double>(Id::GpsTime, idx),
+                v.getFieldAs<double>(Id::X, idx)));
+        std::sort(points.begin(), points.end());
+        return points;
+    };
+    std::vector<std::pair<double, double>> expected;
+    for (auto& v : written)
+    {
+        auto points = sorted(*v);
+        expected.insert(expected.end(), points.begin(), points.end());
+    }
+    std::sort(expected.begin(), expected.end());
+    std::vector<std::pair<double, double>> actual = sorted(*view);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i)
+    {
+        EXPECT_DOUBLE_EQ(actual[i].first, expected[i].first);
+        EXPECT_NEAR(actual[i].second, expected[i].second, 0.01);
+    }
+
+    // Only the patches that intersect the bounds are read, which hold every
+    // point inside them.
+    BOX3D bounds(636000, 849000, 0, 637000, 851000, 0);
+    auto inside = [&bounds](const PointView& v)
+    {
+        point_count_t count = 0;
+        for (PointId idx = 0; idx < v.size(); ++idx)
+        {
+            double x = v.getFieldAs<double>(Id::X, idx);
+            double y = v.getFieldAs<double>(Id::Y, idx);
+            if (x >= bounds.minx && x <= bounds.maxx &&
+                y >= bounds.miny && y <= bounds.maxy)
+                count++;
+        }
+        return count;
+    };
+
+    Options boundsOptions(sqliteOptions);
+    boundsOptions.add("bounds", bounds);
+    std::unique_ptr<Stage> boundsReader(f.createStage("readers.sqlite"));
+    boundsReader->setOptions(boundsOptions);
+
+    PointTable table3;
+    boundsReader->prepare(table3);
+    viewSet = boundsReader->execute(table3);
+    EXPECT_EQ(viewSet.size(), 1U);
+    PointViewPtr boundsView = *viewSet.begin();
+    EXPECT_LT(boundsView->size(), view->size());
+    EXPECT_GT(inside(*boundsView), 0u);
+    EXPECT_EQ(inside(*boundsView), inside(*view));
+
+    FileUtils::deleteFile(tempFilename);
+}
+
+
+// Stages that are done with a database leave their sessions for the next
+// stage that uses it.
+TEST(SQLiteTest, reuseConnections)
+{
+    std::string tempFilename =
+        getSQLITEOptions().getValueOrThrow<std::string>("connection");
+    FileUtils::deleteFile(tempFilename);
+    ConnectionPool& pool = ConnectionPool::shared();
+    pool.clear();
+
+    Options lasReadOpts;
+    lasReadOpts.add("filename", Support::datapath("las/1.2-with-color.las"));
+    lasReadOpts.add("count", 11);
+
+    LasReader reader;
+    reader.setOptions(lasReadOpts);
+
+    StageFactory f;
+    {
+        std::unique_ptr<Stage> sqliteWriter(f.createStage("writers.sqlite"));
+        sqliteWriter->setOptions(getSQLITEOptions());
+        sqliteWriter->setInput(reader);
+
+        PointTable table;
+        sqliteWriter->prepare(table);
+        sqliteWriter->execute(table);
+    }
+    EXPECT_EQ(pool.idle("sqlite:rw:" + tempFilename), 1u);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        std::unique_ptr<Stage> sqliteReader(f.createStage("readers.sqlite"));
+        sqliteReader->setOptions(getSQLITEOptions());
+
+        PointTable table;
+        sqliteReader->prepare(table);
+        PointViewSet viewSet = sqliteReader->execute(table);
+        EXPECT_EQ(viewSet.size(), 1U);
+        EXPECT_EQ((*viewSet.begin())->size(), 11U);
+    }
+    EXPECT_EQ(pool.idle("sqlite:ro:" + tempFilename), 1u);
+
+    pool.clear();
+    FileUtils::deleteFile(tempFilename);
+}
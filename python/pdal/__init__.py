@@ -0,0 +1,6 @@
+# The native extension is only there when PDAL was built with Python
+# support.
+try:
+    from pdal.libpdalpython import Pipeline
+except ImportError:
+    pass
@@ -0,0 +1,421 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+// Native part of the pdal Python package.  A Pipeline is built from
+// pipeline XML, executed in-process with the GIL released, and returns
+// the points of each resulting view as a dict of numpy arrays, one for
+// each dimension.  Where a dimension's values are stored evenly spaced in
+// the point table, its array refers to the table's memory rather than a
+// copy.  Such arrays are read-only and keep the pipeline alive.
+
+#include <Python.h>
+
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+#include <pdal/PDALUtils.hpp>
+#include <pdal/PipelineManager.hpp>
+#include <pdal/PipelineReader.hpp>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace pdal;
+
+namespace
+{
+
+typedef struct
+{
+    PyObject_HEAD
+    PipelineManager *m_manager;
+    bool m_executed;
+} PyPipeline;
+
+
+int numpyType(Dimension::Type::Enum t)
+{
+    using namespace Dimension;
+
+    switch (t)
+    {
+    case Type::Float:
+        return NPY_FLOAT;
+    case Type::Double:
+        return NPY_DOUBLE;
+    case Type::Signed8:
+        return NPY_BYTE;
+    case Type::Signed16:
+        return NPY_SHORT;
+    case Type::Signed32:
+        return NPY_INT;
+    case Type::Signed64:
+        return NPY_LONGLONG;
+    case Type::Unsigned8:
+        return NPY_UBYTE;
+    case Type::Unsigned16:
+        return NPY_USHORT;
+    case Type::Unsigned32:
+        return NPY_UINT;
+    case Type::Unsigned64:
+        return NPY_ULONGLONG;
+    default:
+        return -1;
+    }
+}
+
+
+// An array of the values of 'dim' for the points of 'view', copied out of
+// the table as type T.
+template<typename T>
+PyObject *copyColumn(const PointView& view, Dimension::Id::Enum dim,
+    int type)
+{
+    npy_intp count = (npy_intp)view.size();
+    PyObject *arr = PyArray_SimpleNew(1, &count, type);
+    if (arr && count)
+        view.getFieldArray(dim, 0, view.size(),
+            (T *)PyArray_DATA((PyArrayObject *)arr));
+    return arr;
+}
+
+
+PyObject *copyColumn(const PointView& view, Dimension::Id::Enum dim,
+    Dimension::Type::Enum t)
+{
+    using namespace Dimension;
+
+    int type = numpyType(t);
+    switch (t)
+    {
+    case Type::Float:
+        return copyColumn<float>(view, dim, type);
+    case Type::Double:
+        return copyColumn<double>(view, dim, type);
+    case Type::Signed8:
+        return copyColumn<int8_t>(view, dim, type);
+    case Type::Signed16:
+        return copyColumn<int16_t>(view, dim, type);
+    case Type::Signed32:
+        return copyColumn<int32_t>(view, dim, type);
+    case Type::Signed64:
+        return copyColumn<int64_t>(view, dim, type);
+    case Type::Unsigned8:
+        return copyColumn<uint8_t>(view, dim, type);
+    case Type::Unsigned16:
+        return copyColumn<uint16_t>(view, dim, type);
+    case Type::Unsigned32:
+        return copyColumn<uint32_t>(view, dim, type);
+    case Type::Unsigned64:
+        return copyColumn<uint64_t>(view, dim, type);
+    default:
+        PyErr_SetString(PyExc_TypeError, "Unsupported dimension type.");
+        return NULL;
+    }
+}
+
+
+// The values of 'dim' as an array over the table's memory, or NULL if
+// they aren't stored as plain, evenly spaced values.  The array holds a
+// reference to 'owner'.
+PyObject *mapColumn(const PointView& view, const Dimension::Detail *dd,
+    PyObject *owner)
+{
+    if (dd->packed() || dd->computed() || dd->scaled() || view.empty())
+        return NULL;
+
+    std::ptrdiff_t stride;
+    const char *data = view.fieldSpan(dd->id(), 0, view.size(), stride);
+    if (!data)
+        return NULL;
+
+    npy_intp count = (npy_intp)view.size();
+    npy_intp strides = (npy_intp)stride;
+    PyObject *arr = PyArray_New(&PyArray_Type, 1, &count,
+        numpyType(dd->type()), &strides, (void *)data, 0, 0, NULL);
+    if (!arr)
+        return NULL;
+    Py_INCREF(owner);
+    if (PyArray_SetBaseObject((PyArrayObject *)arr, owner) < 0)
+    {
+        Py_DECREF(arr);
+        return NULL;
+    }
+    return arr;
+}
+
+
+PyObject *viewColumns(const PointView& view, PyObject *owner)
+{
+    PyObject *columns = PyDict_New();
+    if (!columns)
+        return NULL;
+
+    PointLayoutPtr layout = view.layout();
+    for (auto id : layout->dims())
+    {
+        const Dimension::Detail *dd = layout->dimDetail(id);
+        PyObject *arr = mapColumn(view, dd, owner);
+        if (!arr && !PyErr_Occurred())
+        {
+            // Scaled values are handed out as the values they stand for.
+            Dimension::Type::Enum t =
+                dd->scaled() ? Dimension::Type::Double : dd->type();
+            arr = copyColumn(view, id, t);
+        }
+        if (!arr ||
+            PyDict_SetItemString(columns, layout->dimName(id).c_str(), arr))
+        {
+            Py_XDECREF(arr);
+            Py_DECREF(columns);
+            return NULL;
+        }
+        Py_DECREF(arr);
+    }
+    return columns;
+}
+
+
+void Pipeline_dealloc(PyPipeline *self)
+{
+    delete self->m_manager;
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+int Pipeline_init(PyPipeline *self, PyObject *args, PyObject *kwargs)
+{
+    static const char *keywords[] = { "xml", "block_size", NULL };
+
+    const char *xml;
+    // Views that fit in a block of the table can be mapped without a copy,
+    // so blocks are made large.  Memory for a block is only touched as
+    // points are added to it.
+    unsigned long long blockSize = 1 << 24;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|K", (char **)keywords,
+            &xml, &blockSize))
+        return -1;
+    if (blockSize == 0)
+    {
+        PyErr_SetString(PyExc_ValueError, "block_size must be positive.");
+        return -1;
+    }
+
+    try
+    {
+        std::unique_ptr<PipelineManager> manager(
+            new PipelineManager((point_count_t)blockSize));
+        PipelineReader reader(*manager);
+        std::istringstream in(xml);
+        reader.readPipeline(in);
+        delete self->m_manager;
+        self->m_manager = manager.release();
+        self->m_executed = false;
+    }
+    catch (std::exception& e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return -1;
+    }
+    return 0;
+}
+
+
+PyObject *Pipeline_execute(PyPipeline *self, PyObject *)
+{
+    if (!self->m_manager)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Pipeline isn't initialized.");
+        return NULL;
+    }
+
+    point_count_t count(0);
+    std::string error;
+    // Other Python threads can run while the pipeline does.
+    Py_BEGIN_ALLOW_THREADS
+    try
+    {
+        count = self->m_manager->execute();
+    }
+    catch (std::exception& e)
+    {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    if (error.size())
+    {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return NULL;
+    }
+    self->m_executed = true;
+    return PyLong_FromUnsignedLongLong(count);
+}
+
+
+PyObject *Pipeline_getArrays(PyPipeline *self, void *)
+{
+    if (!self->m_executed)
+    {
+        PyErr_SetString(PyExc_RuntimeError,
+            "Pipeline hasn't been executed.");
+        return NULL;
+    }
+
+    const PointViewSet& views = self->m_manager->views();
+    PyObject *list = PyList_New(views.size());
+    if (!list)
+        return NULL;
+    Py_ssize_t i = 0;
+    for (auto const& view : views)
+    {
+        PyObject *columns = viewColumns(*view, (PyObject *)self);
+        if (!columns)
+        {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i++, columns);
+    }
+    return list;
+}
+
+
+PyObject *Pipeline_getMetadata(PyPipeline *self, void *)
+{
+    if (!self->m_executed)
+    {
+        PyErr_SetString(PyExc_RuntimeError,
+            "Pipeline hasn't been executed.");
+        return NULL;
+    }
+
+    std::string json;
+    try
+    {
+        json = utils::toJSON(self->m_manager->getMetadata());
+    }
+    catch (std::exception& e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+    return PyUnicode_FromStringAndSize(json.data(), json.size());
+}
+
+
+PyMethodDef Pipeline_methods[] =
+{
+    { "execute", (PyCFunction)Pipeline_execute, METH_NOARGS,
+        "Execute the pipeline and return the number of points produced." },
+    { NULL, NULL, 0, NULL }
+};
+
+
+PyGetSetDef Pipeline_getset[] =
+{
+    { (char *)"arrays", (getter)Pipeline_getArrays, NULL,
+        (char *)"For each view produced, a dict of a numpy array of the "
+        "values of each dimension.", NULL },
+    { (char *)"metadata", (getter)Pipeline_getMetadata, NULL,
+        (char *)"Metadata of the executed pipeline, as JSON.", NULL },
+    { NULL, NULL, NULL, NULL, NULL }
+};
+
+
+PyTypeObject PipelineType =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pdal.libpdalpython.Pipeline",  // tp_name
+    sizeof(PyPipeline),             // tp_basicsize
+};
+
+#if PY_MAJOR_VERSION >= 3
+PyModuleDef pdalModule =
+{
+    PyModuleDef_HEAD_INIT,
+    "libpdalpython",
+    "Execution of PDAL pipelines.",
+    -1,
+    NULL
+};
+#endif
+
+
+PyObject *initModule()
+{
+    PipelineType.tp_flags = Py_TPFLAGS_DEFAULT;
+    PipelineType.tp_doc = "Pipeline(xml, block_size=16777216)\n\n"
+        "A pipeline described by pipeline XML.  Points are stored in blocks "
+        "of\n'block_size' points; the values of views that fit in a block "
+        "are handed\nout without copying.";
+    PipelineType.tp_new = PyType_GenericNew;
+    PipelineType.tp_init = (initproc)Pipeline_init;
+    PipelineType.tp_dealloc = (destructor)Pipeline_dealloc;
+    PipelineType.tp_methods = Pipeline_methods;
+    PipelineType.tp_getset = Pipeline_getset;
+    if (PyType_Ready(&PipelineType) < 0)
+        return NULL;
+
+#if PY_MAJOR_VERSION >= 3
+    PyObject *module = PyModule_Create(&pdalModule);
+#else
+    PyObject *module = Py_InitModule3("libpdalpython", NULL,
+        "Execution of PDAL pipelines.");
+#endif
+    if (!module)
+        return NULL;
+    Py_INCREF(&PipelineType);
+    PyModule_AddObject(module, "Pipeline", (PyObject *)&PipelineType);
+    return module;
+}
+
+} // unnamed namespace
+
+
+#if PY_MAJOR_VERSION >= 3
+PyMODINIT_FUNC PyInit_libpdalpython()
+{
+    import_array();
+    return initModule();
+}
+#else
+PyMODINIT_FUNC initlibpdalpython()
+{
+    import_array();
+    initModule();
+}
+#endif
+
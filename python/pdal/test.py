@@ -1,8 +1,14 @@
+import os
 import unittest
 
 import pipeline_xml as pxml
 import version
 
+try:
+    from libpdalpython import Pipeline
+except ImportError:
+    Pipeline = None
+
 class TestXML(unittest.TestCase):
 
     def test_simplest_xml(self):
@@ -50,5 +56,54 @@ class TestXML(unittest.TestCase):
         self.assertRaises(ValueError, setattr, reader, 'source', otherreader)
 
 
+DATADIR = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                       '..', '..', 'test', 'data')
+
+LAS_XML = '''<?xml version="1.0" encoding="utf-8"?>
+<Pipeline version="1.0">
+  <Reader type="readers.las">
+    <Option name="filename">%s</Option>
+  </Reader>
+</Pipeline>
+''' % os.path.join(DATADIR, 'las', '1.2-with-color.las')
+
+
+@unittest.skipIf(Pipeline is None, 'PDAL was built without Python support')
+class TestPipeline(unittest.TestCase):
+
+    def test_arrays(self):
+        p = Pipeline(LAS_XML)
+        self.assertEqual(p.execute(), 1065)
+        arrays = p.arrays
+        self.assertEqual(len(arrays), 1)
+        columns = arrays[0]
+        self.assertEqual(len(columns['X']), 1065)
+        self.assertAlmostEqual(columns['X'][0], 637012.24, 2)
+        self.assertEqual(columns['Intensity'].dtype.name, 'uint16')
+
+    def test_zero_copy(self):
+        p = Pipeline(LAS_XML)
+        p.execute()
+        intensity = p.arrays[0]['Intensity']
+        # A mapped array refers to the point table and can't be written.
+        self.assertFalse(intensity.flags.writeable)
+        self.assertFalse(intensity.flags.owndata)
+        # The array keeps the pipeline's memory alive.
+        del p
+        self.assertEqual(len(intensity), 1065)
+
+    def test_metadata(self):
+        p = Pipeline(LAS_XML)
+        p.execute()
+        self.assertIn('readers.las', p.metadata)
+
+    def test_not_executed(self):
+        p = Pipeline(LAS_XML)
+        self.assertRaises(RuntimeError, getattr, p, 'arrays')
+
+    def test_bad_xml(self):
+        self.assertRaises(RuntimeError, Pipeline, '<Pipeline')
+
+
 if __name__ == '__main__':
     unittest.main()
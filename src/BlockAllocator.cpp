@@ -0,0 +1,220 @@
+/******************************************************************************
+* Copyright (c) 2014, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/BlockAllocator.hpp>
+
+#include <new>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace pdal
+{
+
+namespace
+{
+
+// Huge pages are 2MB on the platforms we care about.  Rounding mappings to
+// this size keeps munmap() happy when the mapping came from the huge page
+// pool.
+const std::size_t HugePageSize = 2 * 1024 * 1024;
+
+std::size_t roundUp(std::size_t size, std::size_t unit)
+{
+    return ((size + unit - 1) / unit) * unit;
+}
+
+} // unnamed namespace
+
+
+std::size_t MappedAllocator::mappedSize(std::size_t size) const
+{
+#ifndef _WIN32
+    std::size_t unit = m_hugePages ? HugePageSize :
+        (std::size_t)sysconf(_SC_PAGESIZE);
+    return roundUp(size, unit);
+#else
+    return size;
+#endif
+}
+
+
+char *MappedAllocator::allocate(std::size_t size)
+{
+#ifndef _WIN32
+    std::size_t len = mappedSize(size);
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    if (m_prefault)
+        flags |= MAP_POPULATE;
+#endif
+
+    void *buf = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (m_hugePages)
+        buf = mmap(NULL, len, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB,
+            -1, 0);
+#endif
+    if (buf == MAP_FAILED)
+    {
+        buf = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (buf == MAP_FAILED)
+            throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        if (m_hugePages)
+            madvise(buf, len, MADV_HUGEPAGE);
+#endif
+    }
+#ifndef MAP_POPULATE
+    if (m_prefault)
+    {
+        std::size_t pageSize = (std::size_t)sysconf(_SC_PAGESIZE);
+        for (std::size_t off = 0; off < len; off += pageSize)
+            ((volatile char *)buf)[off] = 0;
+    }
+#endif
+    return (char *)buf;
+#else
+    return new char[size];
+#endif
+}
+
+
+void MappedAllocator::deallocate(char *buf, std::size_t size)
+{
+#ifndef _WIN32
+    munmap(buf, mappedSize(size));
+#else
+    delete [] buf;
+#endif
+}
+
+
+char *PoolAllocator::allocate(std::size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto fi = m_free.find(size);
+        if (fi != m_free.end() && fi->second.size())
+        {
+            char *buf = fi->second.back();
+            fi->second.pop_back();
+            m_pooledBytes -= size;
+            return buf;
+        }
+    }
+    return m_source->allocate(size);
+}
+
+
+void PoolAllocator::deallocate(char *buf, std::size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_maxBytes == 0 || m_pooledBytes + size <= m_maxBytes)
+        {
+            m_free[size].push_back(buf);
+            m_pooledBytes += size;
+            return;
+        }
+    }
+    m_source->deallocate(buf, size);
+}
+
+
+void PoolAllocator::release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto fi = m_free.begin(); fi != m_free.end(); ++fi)
+        for (auto bi = fi->second.begin(); bi != fi->second.end(); ++bi)
+            m_source->deallocate(*bi, fi->first);
+    m_free.clear();
+    m_pooledBytes = 0;
+}
+
+
+std::size_t PoolAllocator::pooledBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_pooledBytes;
+}
+
+
+AccountingAllocator::~AccountingAllocator()
+{
+    // Blocks that weren't returned can't be credited by size, since the
+    // size isn't known.  Tables free all of their blocks, so this only
+    // guards against leaking the accounts.
+    for (auto& a : m_accounts)
+        if (a.second)
+            a.second->release();
+}
+
+
+char *AccountingAllocator::allocate(std::size_t size)
+{
+    char *buf = m_source->allocate(size);
+    memory::Account *a = memory::charge(memory::TableBlocks, size);
+    if (a)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_accounts[buf] = a;
+    }
+    return buf;
+}
+
+
+void AccountingAllocator::deallocate(char *buf, std::size_t size)
+{
+    memory::Account *a = NULL;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_accounts.find(buf);
+        if (it != m_accounts.end())
+        {
+            a = it->second;
+            m_accounts.erase(it);
+        }
+    }
+    memory::credit(a, memory::TableBlocks, size);
+    m_source->deallocate(buf, size);
+}
+
+} // namespace pdal
@@ -0,0 +1,117 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/ConnectionPool.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace pdal
+{
+
+ConnectionPool::ConnectionPool(std::size_t maxIdle) : m_maxIdle(maxIdle)
+{}
+
+
+ConnectionPool::~ConnectionPool()
+{
+    clear();
+}
+
+
+ConnectionPool& ConnectionPool::shared()
+{
+    static ConnectionPool pool([]()
+    {
+        const char *env = std::getenv("PDAL_DB_POOL_SIZE");
+        return env ? (std::size_t)std::max(std::atol(env), 0L) :
+            (std::size_t)4;
+    }());
+    return pool;
+}
+
+
+void *ConnectionPool::acquire(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_idle.find(key);
+    if (it == m_idle.end() || it->second.empty())
+        return NULL;
+    void *conn = it->second.back().m_conn;
+    it->second.pop_back();
+    return conn;
+}
+
+
+void ConnectionPool::release(const std::string& key, void *conn,
+    Closer close)
+{
+    if (!conn)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<Idle>& idle = m_idle[key];
+        if (idle.size() < m_maxIdle)
+        {
+            idle.push_back(Idle{conn, close});
+            return;
+        }
+    }
+    // Closing can mean a round trip to the server, so it's done without
+    // holding the lock.
+    close(conn);
+}
+
+
+void ConnectionPool::clear()
+{
+    std::map<std::string, std::vector<Idle>> idle;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        idle.swap(m_idle);
+    }
+    for (auto& key : idle)
+        for (auto& i : key.second)
+            i.m_close(i.m_conn);
+}
+
+
+std::size_t ConnectionPool::idle(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_idle.find(key);
+    return it == m_idle.end() ? 0 : it->second.size();
+}
+
+} // namespace pdal
@@ -0,0 +1,212 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <pdal/pdal_types.hpp>
+
+namespace pdal
+{
+
+// Copy loops used to move dimension values between DB packed point records
+// and point tables, and the transforms of dimensional patches.  Sizes are
+// template arguments so that the common cases compile to a single load and
+// store per value instead of a call to memcpy.
+namespace DbPacking
+{
+
+template<std::size_t SIZE>
+inline void copyValues(char *dst, std::ptrdiff_t dstStride, const char *src,
+    std::ptrdiff_t srcStride, point_count_t count)
+{
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        std::memcpy(dst, src, SIZE);
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+// Copy 'count' values of 'size' bytes, stepping 'dst' and 'src' by their
+// strides.
+inline void copyValues(std::size_t size, char *dst, std::ptrdiff_t dstStride,
+    const char *src, std::ptrdiff_t srcStride, point_count_t count)
+{
+    switch (size)
+    {
+    case 1:
+        copyValues<1>(dst, dstStride, src, srcStride, count);
+        break;
+    case 2:
+        copyValues<2>(dst, dstStride, src, srcStride, count);
+        break;
+    case 4:
+        copyValues<4>(dst, dstStride, src, srcStride, count);
+        break;
+    case 8:
+        copyValues<8>(dst, dstStride, src, srcStride, count);
+        break;
+    default:
+        for (point_count_t i = 0; i < count; ++i)
+        {
+            std::memcpy(dst, src, size);
+            dst += dstStride;
+            src += srcStride;
+        }
+        break;
+    }
+}
+
+// Collect values 'stride' bytes apart into an array.
+template<typename T>
+inline void gather(const char *src, std::ptrdiff_t stride,
+    point_count_t count, T *out)
+{
+    copyValues<sizeof(T)>((char *)out, sizeof(T), src, stride, count);
+}
+
+// Spread an array of values out to 'stride' bytes apart.
+template<typename T>
+inline void scatter(const T *in, point_count_t count, char *dst,
+    std::ptrdiff_t stride)
+{
+    copyValues<sizeof(T)>(dst, stride, (const char *)in, sizeof(T), count);
+}
+
+// Compression of a dimension in a dimensional patch.  Each dimension of
+// the patch is a codec byte, the little-endian uint32 size of the data and
+// the data.  None and Zlib are the codes pgpointcloud uses for the same
+// encodings.  DeltaZlib is our own: the differences between successive
+// values, as unsigned integers of the value size, byte-shuffled and then
+// compressed with zlib.
+namespace DimCodec
+{
+enum Enum
+{
+    None = 0,
+    Zlib = 3,
+    DeltaZlib = 4
+};
+} // namespace DimCodec
+
+template<typename T>
+inline void deltaEncode(char *buf, point_count_t count)
+{
+    T prev = 0;
+    for (point_count_t i = 0; i < count; ++i, buf += sizeof(T))
+    {
+        T v;
+        std::memcpy(&v, buf, sizeof(T));
+        T d = v - prev;
+        prev = v;
+        std::memcpy(buf, &d, sizeof(T));
+    }
+}
+
+template<typename T>
+inline void deltaDecode(char *buf, point_count_t count)
+{
+    T prev = 0;
+    for (point_count_t i = 0; i < count; ++i, buf += sizeof(T))
+    {
+        T d;
+        std::memcpy(&d, buf, sizeof(T));
+        prev += d;
+        std::memcpy(buf, &prev, sizeof(T));
+    }
+}
+
+// Replace an array of values by the differences between them.
+inline void deltaEncode(std::size_t size, char *buf, point_count_t count)
+{
+    switch (size)
+    {
+    case 1:
+        deltaEncode<uint8_t>(buf, count);
+        break;
+    case 2:
+        deltaEncode<uint16_t>(buf, count);
+        break;
+    case 4:
+        deltaEncode<uint32_t>(buf, count);
+        break;
+    case 8:
+        deltaEncode<uint64_t>(buf, count);
+        break;
+    }
+}
+
+// Reverse deltaEncode().
+inline void deltaDecode(std::size_t size, char *buf, point_count_t count)
+{
+    switch (size)
+    {
+    case 1:
+        deltaDecode<uint8_t>(buf, count);
+        break;
+    case 2:
+        deltaDecode<uint16_t>(buf, count);
+        break;
+    case 4:
+        deltaDecode<uint32_t>(buf, count);
+        break;
+    case 8:
+        deltaDecode<uint64_t>(buf, count);
+        break;
+    }
+}
+
+// Put the first bytes of all the values first, then the second bytes and
+// so on, so that the bytes that rarely change are together.
+inline void shuffle(std::size_t size, const char *in, char *out,
+    point_count_t count)
+{
+    for (std::size_t b = 0; b < size; ++b)
+        copyValues<1>(out + b * count, 1, in + b, size, count);
+}
+
+// Reverse shuffle().
+inline void unshuffle(std::size_t size, const char *in, char *out,
+    point_count_t count)
+{
+    for (std::size_t b = 0; b < size; ++b)
+        copyValues<1>(out + b, size, in + b * count, 1, count);
+}
+
+} // namespace DbPacking
+} // namespace pdal
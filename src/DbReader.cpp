@@ -32,14 +32,17 @@
 
 #include <pdal/DbReader.hpp>
 
+#include "DbPacking.hpp"
+
+#include <zlib.h>
+
 namespace pdal
 {
 
 void DbReader::loadSchema(PointLayoutPtr layout,
     const std::string& schemaString)
 {
-    XMLSchema schema(schemaString);
-    loadSchema(layout, schema);
+    loadSchema(layout, *XMLSchema::cached(schemaString));
 }
 
 void DbReader::loadSchema(PointLayoutPtr layout, const XMLSchema& schema)
@@ -62,6 +65,7 @@ void DbReader::loadSchema(PointLayoutPtr layout, const XMLSchema& schema)
             layout->registerOrAssignDim(di->m_name, di->m_dimType.m_type);
         m_packedPointSize += Dimension::size(di->m_dimType.m_type);
     }
+    m_unpackPlanned = false;
 }
 
 
@@ -77,6 +81,7 @@ void DbReader::updateSchema(const XMLSchema& schema)
         di->m_dimType.m_id = m_layout->findDim(di->m_name);
         m_packedPointSize += Dimension::size(di->m_dimType.m_type);
     }
+    m_unpackPlanned = false;
 }
 
 
@@ -155,4 +160,239 @@ void DbReader::writePoint(PointView& view, PointId idx, const char *buf)
     }
 }
 
+
+// Work out how each dimension is unpacked.  This waits for the first
+// unpackPoints() call since the layout isn't finalized when the schema is
+// loaded.
+void DbReader::planUnpack()
+{
+    using namespace Dimension;
+
+    m_unpackPlan.clear();
+    m_unpackIdentity = true;
+    size_t offset = 0;
+    for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
+    {
+        const DimType& dimType = di->m_dimType;
+        const Dimension::Detail *dd = m_layout->dimDetail(dimType.m_id);
+
+        UnpackField f;
+        f.m_dimType = dimType;
+        f.m_offset = offset;
+        f.m_scaled = dimType.m_type == Type::Signed32 &&
+            (dimType.m_id == Id::X || dimType.m_id == Id::Y ||
+             dimType.m_id == Id::Z);
+        f.m_raw = !f.m_scaled && !dd->scaled() &&
+            dd->type() == dimType.m_type;
+        if (!f.m_raw || (size_t)dd->offset() != offset)
+            m_unpackIdentity = false;
+        m_unpackPlan.push_back(f);
+        offset += Dimension::size(dimType.m_type);
+    }
+    if (m_unpackPlan.empty() || m_layout->pointSize() != m_packedPointSize)
+        m_unpackIdentity = false;
+    m_unpackPlanned = true;
+}
+
+
+namespace
+{
+
+template<typename T>
+void unpackTyped(PointView& view, Dimension::Id::Enum id, PointId begin,
+    point_count_t count, const char *pos, std::ptrdiff_t stride)
+{
+    std::vector<T> values(count);
+    DbPacking::gather(pos, stride, count, values.data());
+    view.setFieldArray(id, begin, count, values.data());
+}
+
+} // unnamed namespace
+
+
+void DbReader::unpackField(PointView& view, const UnpackField& f,
+    PointId begin, point_count_t count, const char *buf)
+{
+    using namespace Dimension;
+
+    const std::ptrdiff_t pointSize = (std::ptrdiff_t)m_packedPointSize;
+    const DimType& dt = f.m_dimType;
+    const char *pos = buf + f.m_offset;
+
+    if (f.m_scaled)
+    {
+        std::vector<int32_t> ints(count);
+        DbPacking::gather(pos, pointSize, count, ints.data());
+        std::vector<double> values(count);
+        for (point_count_t i = 0; i < count; ++i)
+            values[i] = (ints[i] * dt.m_xform.m_scale) + dt.m_xform.m_offset;
+        view.setFieldArray(dt.m_id, begin, count, values.data());
+        return;
+    }
+
+    switch (dt.m_type)
+    {
+    case Type::Float:
+        unpackTyped<float>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::Double:
+        unpackTyped<double>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::Signed8:
+        unpackTyped<int8_t>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::Signed16:
+        unpackTyped<int16_t>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::Signed32:
+        unpackTyped<int32_t>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::Signed64:
+        unpackTyped<int64_t>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::Unsigned8:
+        unpackTyped<uint8_t>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::Unsigned16:
+        unpackTyped<uint16_t>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::Unsigned32:
+        unpackTyped<uint32_t>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::Unsigned64:
+        unpackTyped<uint64_t>(view, dt.m_id, begin, count, pos, pointSize);
+        break;
+    case Type::None:
+        break;
+    }
+}
+
+
+/// Write the packed data of consecutive points into a view, as
+/// writePoint() would for each of them.
+/// \param[in] view  PointView to write to.
+/// \param[in] begin  Index of first point to write.  Points past the end
+///   of the view are added to it.
+/// \param[in] count  Number of points to write.
+/// \param[in] buf  Pointer to packed DB point data.
+void DbReader::unpackPoints(PointView& view, PointId begin,
+    point_count_t count, const char *buf)
+{
+    if (count == 0 || m_dims.empty())
+        return;
+    if (!m_unpackPlanned)
+        planUnpack();
+
+    // Points are added to the view by setting the first dimension through
+    // the converting path.  Once they exist, the bytes of dimensions
+    // stored as packed are copied into the table.
+    auto fi = m_unpackPlan.begin();
+    if (begin + count > view.size())
+        unpackField(view, *fi++, begin, count, buf);
+
+    const std::ptrdiff_t pointSize = (std::ptrdiff_t)m_packedPointSize;
+    std::ptrdiff_t stride;
+    if (m_unpackIdentity)
+    {
+        char *pos = view.fieldSpan(m_unpackPlan.front().m_dimType.m_id,
+            begin, count, stride);
+        if (pos && stride == pointSize)
+        {
+            memcpy(pos, buf, count * m_packedPointSize);
+            return;
+        }
+    }
+
+    for (; fi != m_unpackPlan.end(); ++fi)
+    {
+        if (fi->m_raw)
+        {
+            char *pos = view.fieldSpan(fi->m_dimType.m_id, begin, count,
+                stride);
+            if (pos)
+            {
+                DbPacking::copyValues(Dimension::size(fi->m_dimType.m_type),
+                    pos, stride, buf + fi->m_offset, pointSize, count);
+                continue;
+            }
+        }
+        unpackField(view, *fi, begin, count, buf);
+    }
+}
+
+
+/// Decode a dimensional patch, as written by DbWriter::packDimensional(),
+/// into packed point data.
+/// \param[in] buf  Dimensional patch data.
+/// \param[in] size  Size of the patch data.
+/// \param[in] count  Number of points in the patch.
+/// \param[out] out  Buffer filled with packed point data.
+void DbReader::unpackDimensional(const char *buf, size_t size,
+    point_count_t count, std::vector<char>& out) const
+{
+    using namespace DbPacking;
+
+    out.resize(count * m_packedPointSize);
+
+    std::vector<char> values;
+    std::vector<char> shuffled;
+    size_t pos = 0;
+    size_t offset = 0;
+    for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
+    {
+        const std::string& name = di->m_name;
+        size_t valueSize = Dimension::size(di->m_dimType.m_type);
+
+        if (size - pos < 5)
+            throw pdal_error("Dimensional patch ends before dimension '" +
+                name + "'.");
+        uint8_t codec = (uint8_t)buf[pos];
+        uint32_t dataSize = 0;
+        for (size_t b = 0; b < 4; ++b)
+            dataSize |= (uint32_t)(uint8_t)buf[pos + 1 + b] << (b * 8);
+        pos += 5;
+        if (size - pos < dataSize)
+            throw pdal_error("Dimensional patch data for dimension '" +
+                name + "' is truncated.");
+        const char *data = buf + pos;
+        pos += dataSize;
+
+        values.resize(count * valueSize);
+        uLongf rawSize = values.size();
+        switch (codec)
+        {
+        case DimCodec::None:
+            if (dataSize != values.size())
+                throw pdal_error("Dimensional patch data for dimension '" +
+                    name + "' is the wrong size.");
+            memcpy(values.data(), data, dataSize);
+            break;
+        case DimCodec::Zlib:
+            if (uncompress((Bytef *)values.data(), &rawSize,
+                (const Bytef *)data, dataSize) != Z_OK ||
+                rawSize != values.size())
+                throw pdal_error("Unable to decompress dimension '" +
+                    name + "'.");
+            break;
+        case DimCodec::DeltaZlib:
+            shuffled.resize(values.size());
+            if (uncompress((Bytef *)shuffled.data(), &rawSize,
+                (const Bytef *)data, dataSize) != Z_OK ||
+                rawSize != values.size())
+                throw pdal_error("Unable to decompress dimension '" +
+                    name + "'.");
+            unshuffle(valueSize, shuffled.data(), values.data(), count);
+            deltaDecode(valueSize, values.data(), count);
+            break;
+        default:
+            throw pdal_error("Unsupported compression of dimension '" +
+                name + "' in dimensional patch.");
+        }
+
+        copyValues(valueSize, out.data() + offset, m_packedPointSize,
+            values.data(), valueSize, count);
+        offset += valueSize;
+    }
+}
+
 } // namespace pdal
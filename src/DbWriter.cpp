@@ -32,6 +32,10 @@
 
 #include <pdal/DbWriter.hpp>
 
+#include "DbPacking.hpp"
+
+#include <zlib.h>
+
 namespace pdal
 {
 
@@ -61,14 +65,69 @@ DimTypeList DbWriter::dimTypes(PointTableRef table)
 }
 
 
+/// Read the 'precision' option, a list of entries like "GpsTime=0.000001"
+/// giving the precision to which Float and Double dimensions are kept in
+/// LAZperf patches.
+/// \param[in] options  Stage options.
+/// \param[in] lazperf  Whether the writer compresses with LAZperf.
+void DbWriter::processPrecision(const Options& options, bool lazperf)
+{
+    m_precisionSpec = options.getValueOrDefault<StringList>("precision");
+    if (m_precisionSpec.size() && !lazperf)
+        throw pdal_error(getName() + ": option 'precision' requires "
+            "'lazperf' compression.");
+}
+
+
 // Placing this here allows validation of dimensions before execution begins.
 void DbWriter::prepared(PointTableRef table)
 {
+    using namespace Dimension;
+
     m_dimTypes = dimTypes(table);
+
+    m_precision.clear();
+    for (const std::string& spec : m_precisionSpec)
+    {
+        StringList parts = Utils::split2(spec, '=');
+        double precision = 0;
+        if (parts.size() == 2)
+        {
+            Utils::trim(parts[0]);
+            Utils::trim(parts[1]);
+            try
+            {
+                precision = boost::lexical_cast<double>(parts[1]);
+            }
+            catch (boost::bad_lexical_cast&)
+            {}
+        }
+        if (precision <= 0)
+        {
+            std::ostringstream oss;
+            oss << getName() << ": invalid 'precision' entry '" << spec <<
+                "'.  Entries should be of the form <dimension>=<precision>.";
+            throw pdal_error(oss.str());
+        }
+
+        auto di = std::find_if(m_dimTypes.begin(), m_dimTypes.end(),
+            [&table, &parts](const DimType& dt)
+            { return table.layout()->dimName(dt.m_id) == parts[0]; });
+        if (di == m_dimTypes.end() ||
+            (di->m_type != Type::Float && di->m_type != Type::Double))
+        {
+            std::ostringstream oss;
+            oss << getName() << ": dimension '" << parts[0] << "' of "
+                "'precision' option isn't a Float or Double dimension "
+                "being written.";
+            throw pdal_error(oss.str());
+        }
+        m_precision[di->m_id] = precision;
+    }
 }
 
 
-void DbWriter::ready(PointTableRef /*table*/)
+void DbWriter::ready(PointTableRef table)
 {
     using namespace Dimension;
 
@@ -93,22 +152,56 @@ void DbWriter::ready(PointTableRef /*table*/)
     // Sorting messes up the offsets in the DimType objects.
     std::sort(m_dimTypes.begin(), m_dimTypes.end(), cmp);
 
-    // Now store away the offset of X, Y and Z if they exist.
-    m_xPackedOffset = -1;
-    m_yPackedOffset = -1;
-    m_zPackedOffset = -1;
-    int offset = 0;
+    // With location scaling, X, Y and Z are read through typed handles and
+    // the other dimensions are packed as usual.
+    m_otherDimTypes.clear();
+    m_otherPointSize = 0;
+    m_packedPointSize = 0;
+    m_xHandle = DimHandle<double>();
+    m_yHandle = DimHandle<double>();
+    m_zHandle = DimHandle<double>();
+    PointLayoutPtr layout = table.layout();
     for (auto di = m_dimTypes.begin(); di != m_dimTypes.end(); ++di)
     {
         if (di->m_id == Id::X)
-            m_xPackedOffset = offset;
+            m_xHandle = DimHandle<double>(layout->dimDetail(Id::X));
         else if (di->m_id == Id::Y)
-            m_yPackedOffset = offset;
+            m_yHandle = DimHandle<double>(layout->dimDetail(Id::Y));
         else if (di->m_id == Id::Z)
-            m_zPackedOffset = offset;
-        offset += Dimension::size(di->m_type);
+            m_zHandle = DimHandle<double>(layout->dimDetail(Id::Z));
+        else
+        {
+            m_otherDimTypes.push_back(*di);
+            m_otherPointSize += Dimension::size(di->m_type);
+        }
+        m_packedPointSize += Dimension::size(di->m_type);
+    }
+
+    // Work out once how each dimension is packed so that packPoints()
+    // doesn't need to.
+    m_packPlan.clear();
+    m_dbPointSize = 0;
+    m_packIdentity = true;
+    DimTypeList dbDims = dbDimTypes();
+    for (auto di = dbDims.begin(); di != dbDims.end(); ++di)
+    {
+        const Dimension::Detail *dd = layout->dimDetail(di->m_id);
+
+        PackField f;
+        f.m_id = di->m_id;
+        f.m_type = di->m_type;
+        f.m_offset = m_dbPointSize;
+        f.m_xform = di->m_xform;
+        f.m_scaled = m_locationScaling &&
+            (di->m_id == Id::X || di->m_id == Id::Y || di->m_id == Id::Z);
+        f.m_raw = !f.m_scaled && !dd->scaled() && dd->type() == di->m_type;
+        if (!f.m_raw || (size_t)dd->offset() != f.m_offset)
+            m_packIdentity = false;
+        m_packPlan.push_back(f);
+        m_dbPointSize += Dimension::size(di->m_type);
     }
-    m_packedPointSize = offset;
+    if (m_packPlan.empty() || layout->pointSize() != m_dbPointSize)
+        m_packIdentity = false;
 }
 
 
@@ -120,7 +213,14 @@ DimTypeList DbWriter::dbDimTypes() const
 
     DimTypeList dimTypes;
     for (auto di = m_dimTypes.begin(); di != m_dimTypes.end(); ++di)
-        dimTypes.push_back(DimType(di->m_id, di->m_type, XForm()));
+    {
+        // A scale on a Float or Double dimension has LAZperf keep it to
+        // that precision.
+        auto pi = m_precision.find(di->m_id);
+        XForm xform = (pi == m_precision.end() ? XForm() :
+            XForm(pi->second, 0));
+        dimTypes.push_back(DimType(di->m_id, di->m_type, xform));
+    }
 
     if (!m_locationScaling)
         return dimTypes;
@@ -191,58 +291,210 @@ size_t DbWriter::readField(const PointView& view, char *pos, DimType dimType,
 }
 
 
-/// Read a point's data packed into a buffer.
+namespace
+{
+
+template<typename T>
+void packField(const PointView& view, Dimension::Id::Enum id, PointId begin,
+    point_count_t count, char *pos, std::ptrdiff_t stride)
+{
+    std::vector<T> values(count);
+    view.getFieldArray(id, begin, count, values.data());
+    DbPacking::scatter(values.data(), count, pos, stride);
+}
+
+} // unnamed namespace
+
+
+/// Pack the data of a range of points into a buffer, as readPoint() would
+/// for each of them.
 /// \param[in] view  PointView to read from.
-/// \param[in] idx  Index of point to read.
+/// \param[in] begin  Index of first point to read.
+/// \param[in] count  Number of points to read.
 /// \param[in] outbuf  Buffer to write to.
 /// \return  Number of bytes written to buffer.
-size_t DbWriter::readPoint(const PointView& view, PointId idx, char *outbuf)
+size_t DbWriter::packPoints(const PointView& view, PointId begin,
+    point_count_t count, char *outbuf) const
 {
-    view.getPackedPoint(m_dimTypes, idx, outbuf);
+    using namespace Dimension;
 
-    auto iconvert = [](const XForm& xform, const char *inpos, char *outpos)
-    {
-        double d;
-        int32_t i;
+    const std::ptrdiff_t pointSize = (std::ptrdiff_t)m_dbPointSize;
+    if (count == 0)
+        return 0;
 
-        memcpy(&d, inpos, sizeof(double));
-        d = (d - xform.m_offset) / xform.m_scale;
-        i = boost::numeric_cast<int32_t>(lround(d));
-        memcpy(outpos, &i, sizeof(int32_t));
-    };
+    // Points stored just as they're packed are copied whole.
+    std::ptrdiff_t stride;
+    if (m_packIdentity)
+    {
+        const char *pos =
+            view.fieldSpan(m_packPlan.front().m_id, begin, count, stride);
+        if (pos && stride == pointSize)
+        {
+            memcpy(outbuf, pos, count * m_dbPointSize);
+            return count * m_dbPointSize;
+        }
+    }
 
-    if (m_locationScaling)
+    // Otherwise pack a dimension at a time, copying the bytes of those
+    // stored as packed and converting the rest.
+    for (auto& f : m_packPlan)
     {
-        int outOffset;
-
-        if (m_xPackedOffset >= 0)
-            outOffset = m_xPackedOffset;
-        else if (m_yPackedOffset >= 0)
-            outOffset = m_yPackedOffset;
-        else if (m_zPackedOffset >= 0)
-            outOffset = m_zPackedOffset;
-        else
-            outOffset = m_packedPointSize;  //So we return the proper size.
+        char *out = outbuf + f.m_offset;
+        if (f.m_raw)
+        {
+            const char *pos = view.fieldSpan(f.m_id, begin, count, stride);
+            if (pos)
+            {
+                DbPacking::copyValues(Dimension::size(f.m_type), out,
+                    pointSize, pos, stride, count);
+                continue;
+            }
+        }
 
-        if (m_xPackedOffset >= 0)
+        if (f.m_scaled)
         {
-            iconvert(m_xXform, outbuf + m_xPackedOffset, outbuf + outOffset);
-            outOffset += sizeof(int);
+            std::vector<double> values(count);
+            view.getFieldArray(f.m_id, begin, count, values.data());
+            for (point_count_t i = 0; i < count; ++i)
+            {
+                double d = (values[i] - f.m_xform.m_offset) /
+                    f.m_xform.m_scale;
+                int32_t v = boost::numeric_cast<int32_t>(lround(d));
+                memcpy(out + i * pointSize, &v, sizeof(int32_t));
+            }
+            continue;
         }
-        if (m_yPackedOffset >= 0)
+
+        switch (f.m_type)
+        {
+        case Type::Float:
+            packField<float>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::Double:
+            packField<double>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::Signed8:
+            packField<int8_t>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::Signed16:
+            packField<int16_t>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::Signed32:
+            packField<int32_t>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::Signed64:
+            packField<int64_t>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::Unsigned8:
+            packField<uint8_t>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::Unsigned16:
+            packField<uint16_t>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::Unsigned32:
+            packField<uint32_t>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::Unsigned64:
+            packField<uint64_t>(view, f.m_id, begin, count, out, pointSize);
+            break;
+        case Type::None:
+            break;
+        }
+    }
+    return count * m_dbPointSize;
+}
+
+
+/// Append the data of a range of points to a buffer as a dimensional
+/// patch: the values of each dimension in turn, each compressed on its own.
+/// Values of a dimension vary much less than the fields of a point, so
+/// they compress better.
+/// \param[in] view  PointView to read from.
+/// \param[in] begin  Index of first point to read.
+/// \param[in] count  Number of points to read.
+/// \param[in] out  Buffer to append to.
+/// \param[in] delta  Compress the differences between successive values
+///   rather than the values.  pgpointcloud doesn't read these.
+void DbWriter::packDimensional(const PointView& view, PointId begin,
+    point_count_t count, std::vector<char>& out, bool delta) const
+{
+    using namespace DbPacking;
+
+    std::vector<char> packed(count * m_dbPointSize);
+    packPoints(view, begin, count, packed.data());
+
+    std::vector<char> values;
+    std::vector<char> shuffled;
+    for (auto& f : m_packPlan)
+    {
+        size_t size = Dimension::size(f.m_type);
+        values.resize(count * size);
+        copyValues(size, values.data(), size, packed.data() + f.m_offset,
+            m_dbPointSize, count);
+
+        const char *raw = values.data();
+        uint8_t codec = DimCodec::Zlib;
+        if (delta)
         {
-            iconvert(m_yXform, outbuf + m_yPackedOffset, outbuf + outOffset);
-            outOffset += sizeof(int);
+            deltaEncode(size, values.data(), count);
+            shuffled.resize(values.size());
+            shuffle(size, values.data(), shuffled.data(), count);
+            raw = shuffled.data();
+            codec = DimCodec::DeltaZlib;
         }
-        if (m_zPackedOffset >= 0)
+
+        // Compression is for speed: the values are already arranged to
+        // compress well.
+        size_t start = out.size();
+        uLongf compSize = compressBound(values.size());
+        out.resize(start + 5 + compSize);
+        if (compress2((Bytef *)out.data() + start + 5, &compSize,
+            (const Bytef *)raw, values.size(), Z_BEST_SPEED) != Z_OK)
         {
-            iconvert(m_zXform, outbuf + m_zPackedOffset, outbuf + outOffset);
-            outOffset += sizeof(int);
+            throw pdal_error("Unable to compress dimension '" +
+                Dimension::name(f.m_id) + "'.");
         }
-        return outOffset;
+        out.resize(start + 5 + compSize);
+        out[start] = (char)codec;
+        for (size_t b = 0; b < 4; ++b)
+            out[start + 1 + b] = (char)((compSize >> (b * 8)) & 0xff);
     }
-    else
+}
+
+
+/// Read a point's data packed into a buffer.
+/// \param[in] view  PointView to read from.
+/// \param[in] idx  Index of point to read.
+/// \param[in] outbuf  Buffer to write to.
+/// \return  Number of bytes written to buffer.
+size_t DbWriter::readPoint(const PointView& view, PointId idx, char *outbuf)
+{
+    if (!m_locationScaling)
+    {
+        view.getPackedPoint(m_dimTypes, idx, outbuf);
         return m_packedPointSize;
+    }
+
+    // X, Y and Z are sorted to the end of the packed point.
+    view.getPackedPoint(m_otherDimTypes, idx, outbuf);
+    char *pos = outbuf + m_otherPointSize;
+
+    auto iconvert = [&view, idx, &pos](const DimHandle<double>& h,
+        const XForm& xform)
+    {
+        if (!h.valid())
+            return;
+
+        double d = (view.getField(h, idx) - xform.m_offset) / xform.m_scale;
+        int32_t i = boost::numeric_cast<int32_t>(lround(d));
+        memcpy(pos, &i, sizeof(int32_t));
+        pos += sizeof(int32_t);
+    };
+
+    iconvert(m_xHandle, m_xXform);
+    iconvert(m_yHandle, m_yXform);
+    iconvert(m_zHandle, m_zXform);
+    return pos - outbuf;
 }
 
 } // namespace pdal
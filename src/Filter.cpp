@@ -34,6 +34,9 @@
 
 #include <pdal/Filter.hpp>
 #include <pdal/PipelineWriter.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <algorithm>
 
 namespace pdal
 {
@@ -58,5 +61,62 @@ boost::property_tree::ptree Filter::serializePipeline() const
     return root;
 }
 
+void Filter::parallelFilter(PointView& view,
+    const std::function<void(PointId, PointId)>& f)
+{
+    // Below this many points per range the cost of handing ranges to the
+    // pool outweighs the work.
+    const point_count_t grain = 16384;
+
+    // Ranges check for an interrupt before they start, so a long filter
+    // can be stopped part way through.
+    UserCallback& callback = *m_callback;
+    auto checked = [&callback, &f](PointId begin, PointId end)
+    {
+        callback.checkInterrupt();
+        f(begin, end);
+    };
+
+    if (!view.table().threadSafe() || view.size() < 2 * grain)
+    {
+        const point_count_t step = 16 * grain;
+        for (PointId begin = 0; begin < view.size(); begin += step)
+            checked(begin, std::min(begin + step, (PointId)view.size()));
+        return;
+    }
+    ThreadPool::shared().parallelFor(view.size(), grain, checked);
+}
+
+
+void Filter::filter(PointView& view)
+{
+    if (!pointwise())
+        return;
+    auto range = [this, &view](PointId begin, PointId end)
+    {
+        filterRange(view, begin, end);
+    };
+    parallelFilter(view, range);
+}
+
+
+void Filter::filterFused(const std::vector<Filter *>& filters,
+    PointView& view)
+{
+    // A block's fields stay in cache from one filter to the next.
+    const point_count_t blockSize = 4096;
+
+    auto fused = [&filters, &view](PointId first, PointId last)
+    {
+        for (PointId begin = first; begin < last; begin += blockSize)
+        {
+            PointId end = (std::min)(begin + blockSize, last);
+            for (Filter *f : filters)
+                f->filterRange(view, begin, end);
+        }
+    };
+    filters.back()->parallelFilter(view, fused);
+}
+
 
 } // namespace pdal
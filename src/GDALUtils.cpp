@@ -35,6 +35,8 @@
 #include <pdal/GDALUtils.hpp>
 #include <pdal/Utils.hpp>
 
+#include <ogr_srs_api.h>
+
 #include <functional>
 #include <map>
 
@@ -131,6 +133,7 @@ void GlobalDebug::log(::CPLErr code, int num, char const* msg)
         std::vector<LogPtr>::const_iterator i;
 
         std::map<std::ostream*, LogPtr> streams;
+        std::lock_guard<std::mutex> lock(m_mutex);
         for (i = m_logs.begin(); i != m_logs.end(); ++i)
         {
             streams.insert(std::pair<std::ostream*, LogPtr>((*i)->getLogStream(), *i));
@@ -152,6 +155,226 @@ GlobalDebug::~GlobalDebug()
 }
 
 
+ErrorCapture::ErrorCapture(LogPtr log) : m_log(log), m_failed(false),
+    m_errorNum(0)
+{
+    CPLPushErrorHandlerEx(&ErrorCapture::trampoline, this);
+}
+
+
+ErrorCapture::~ErrorCapture()
+{
+    CPLPopErrorHandler();
+}
+
+
+void CPL_STDCALL ErrorCapture::trampoline(::CPLErr code, int num,
+    char const* msg)
+{
+    ErrorCapture* capture =
+        static_cast<ErrorCapture*>(CPLGetErrorHandlerUserData());
+    if (!capture)
+        return;
+
+    if (code == CE_Failure || code == CE_Fatal)
+    {
+        capture->m_failed = true;
+        capture->m_errorNum = num;
+        capture->m_error = msg ? msg : "";
+    }
+    else if (code == CE_Debug && capture->m_log)
+        capture->m_log->get(LogLevel::Debug) << "GDAL debug: " << msg <<
+            std::endl;
+}
+
+
+void ErrorCapture::clear()
+{
+    m_failed = false;
+    m_errorNum = 0;
+    m_error.clear();
+}
+
+
+void ErrorCapture::check(const std::string& context) const
+{
+    if (!m_failed)
+        return;
+    std::ostringstream oss;
+    oss << context << " GDAL Failure number=" << m_errorNum << ": " <<
+        m_error;
+    throw pdal::gdal_error(oss.str());
+}
+
+
+DatasetPool::Dataset& DatasetPool::Dataset::operator=(Dataset&& other)
+{
+    if (this != &other)
+    {
+        release();
+        m_pool = other.m_pool;
+        m_ds = other.m_ds;
+        other.m_ds = NULL;
+    }
+    return *this;
+}
+
+
+void DatasetPool::Dataset::release()
+{
+    if (m_ds)
+        m_pool->release(m_ds);
+    m_ds = NULL;
+}
+
+
+DatasetPool::~DatasetPool()
+{
+    for (GDALDatasetH ds : m_free)
+        GDALClose(ds);
+}
+
+
+DatasetPool::Dataset DatasetPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.size())
+        {
+            GDALDatasetH ds = m_free.back();
+            m_free.pop_back();
+            return Dataset(this, ds);
+        }
+    }
+
+    // Opening can be slow, so it's done without holding the lock.
+    ErrorCapture errors;
+    GDALDatasetH ds = GDALOpen(m_filename.c_str(), GA_ReadOnly);
+    if (!ds)
+    {
+        std::string msg("Unable to open GDAL datasource '" + m_filename +
+            "'.");
+        if (errors.failed())
+            msg += " " + errors.lastError();
+        throw pdal::gdal_error(msg);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_opened++;
+    return Dataset(this, ds);
+}
+
+
+void DatasetPool::release(GDALDatasetH ds)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(ds);
+}
+
+
+namespace
+{
+
+// References and sets of idle transformations kept before the cache is
+// emptied.  A job only sees a handful of systems, so this is only reached
+// by long-running processes.
+const size_t MaxSrsCacheEntries = 1024;
+
+struct ReferenceDeleter
+{
+    void operator()(void *ref)
+        { OSRDestroySpatialReference(ref); }
+};
+
+struct TransformDeleter
+{
+    void operator()(void *transform)
+        { OCTDestroyCoordinateTransformation(transform); }
+};
+
+} // unnamed namespace
+
+
+SrsCache& SrsCache::get()
+{
+    static SrsCache cache;
+
+    return cache;
+}
+
+
+// Find or parse the cached copy of a reference.  The mutex must be held.
+SrsCache::ReferencePtr SrsCache::parsedReference(const std::string& wkt)
+{
+    auto ri = m_references.find(wkt);
+    if (ri != m_references.end())
+        return ri->second;
+
+    ReferencePtr ref(OSRNewSpatialReference(NULL), ReferenceDeleter());
+    if (OSRSetFromUserInput(ref.get(), wkt.c_str()) != OGRERR_NONE)
+        throw pdal_error("Could not import coordinate system '" + wkt + "'.");
+    if (m_references.size() >= MaxSrsCacheEntries)
+        m_references.clear();
+    m_references[wkt] = ref;
+    m_parsed++;
+    return ref;
+}
+
+
+SrsCache::ReferencePtr SrsCache::reference(const std::string& wkt)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return ReferencePtr(OSRClone(parsedReference(wkt).get()),
+        ReferenceDeleter());
+}
+
+
+SrsCache::TransformPtr SrsCache::takeTransform(const std::string& inWkt,
+    const std::string& outWkt)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<TransformPtr>& idle =
+        m_transforms[std::make_pair(inWkt, outWkt)];
+    if (idle.size())
+    {
+        TransformPtr transform = idle.back();
+        idle.pop_back();
+        return transform;
+    }
+
+    ReferencePtr in = parsedReference(inWkt);
+    ReferencePtr out = parsedReference(outWkt);
+    TransformPtr transform(OCTNewCoordinateTransformation(in.get(),
+        out.get()), TransformDeleter());
+    if (!transform)
+        throw pdal_error("Could not construct coordinate transformation.");
+    m_created++;
+    return transform;
+}
+
+
+void SrsCache::giveTransform(const std::string& inWkt,
+    const std::string& outWkt, TransformPtr transform)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_transforms.size() >= MaxSrsCacheEntries)
+        m_transforms.clear();
+    m_transforms[std::make_pair(inWkt, outWkt)].push_back(transform);
+}
+
+
+void SrsCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_references.clear();
+    m_transforms.clear();
+    m_parsed = 0;
+    m_created = 0;
+}
+
+
 VSILFileBuffer::VSILFileBuffer(VSILFILE* fp)
     : m_fp(fp)
 {}
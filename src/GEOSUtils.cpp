@@ -0,0 +1,102 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include <pdal/GEOSUtils.hpp>
+
+#ifdef PDAL_HAVE_GEOS
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace pdal
+{
+namespace geos
+{
+
+namespace
+{
+
+thread_local std::string t_error;
+
+void errorHandler(const char *fmt, ...)
+{
+    char buf[1024];
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    t_error = buf;
+}
+
+void warningHandler(const char * /*fmt*/, ...)
+{}
+
+struct Context
+{
+    Context() : m_handle(initGEOS_r(warningHandler, errorHandler))
+    {}
+    ~Context()
+        { finishGEOS_r(m_handle); }
+
+    GEOSContextHandle_t m_handle;
+};
+
+} // unnamed namespace
+
+
+GEOSContextHandle_t context()
+{
+    thread_local Context t_context;
+
+    return t_context.m_handle;
+}
+
+
+const std::string& lastError()
+{
+    return t_error;
+}
+
+
+void clearError()
+{
+    t_error.clear();
+}
+
+} // namespace geos
+} // namespace pdal
+
+#endif // PDAL_HAVE_GEOS
@@ -50,6 +50,7 @@ namespace pdal
 
 static GlobalEnvironment* t = 0;
 static std::once_flag flag;
+static std::mutex gdalMutex;
 
 GlobalEnvironment& GlobalEnvironment::get()
 {
@@ -101,6 +102,8 @@ GlobalEnvironment::GlobalEnvironment()
 
 void GlobalEnvironment::initializeGDAL(LogPtr log)
 {
+    // Stages may be prepared on several threads at once.
+    std::lock_guard<std::mutex> lock(gdalMutex);
     if (!m_bIsGDALInitialized)
     {
         (void) GDALAllRegister();
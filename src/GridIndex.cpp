@@ -0,0 +1,261 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <pdal/GridIndex.hpp>
+#include <pdal/ThreadPool.hpp>
+
+namespace pdal
+{
+
+GridIndex::GridIndex(const PointView& buf) : m_buf(buf), m_dims(3),
+    m_cellSize(1)
+{
+    for (std::size_t d = 0; d < 3; ++d)
+    {
+        m_min[d] = 0;
+        m_cells[d] = 1;
+    }
+}
+
+void GridIndex::build(bool b3d)
+{
+    m_dims = b3d && m_buf.hasDim(Dimension::Id::Z) ? 3 : 2;
+
+    const point_count_t count = m_buf.size();
+    const point_count_t batchSize = 4096;
+    const Dimension::Id::Enum dims[] =
+        { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z };
+    std::vector<double> coords(count * m_dims);
+    std::vector<double> batch(batchSize);
+    double max[3];
+    for (std::size_t d = 0; d < 3; ++d)
+    {
+        m_min[d] = m_buf.empty() ? 0 : (std::numeric_limits<double>::max)();
+        max[d] = m_buf.empty() ? 0 : std::numeric_limits<double>::lowest();
+        m_cells[d] = 1;
+    }
+    for (PointId begin = 0; begin < count; begin += batchSize)
+    {
+        point_count_t n = (std::min)(batchSize, count - begin);
+        for (std::size_t d = 0; d < m_dims; ++d)
+        {
+            m_buf.getFieldArray(dims[d], begin, n, batch.data());
+            for (point_count_t i = 0; i < n; ++i)
+            {
+                coords[(begin + i) * m_dims + d] = batch[i];
+                m_min[d] = (std::min)(m_min[d], batch[i]);
+                max[d] = (std::max)(max[d], batch[i]);
+            }
+        }
+    }
+
+    // Size the cells to hold a few points each on average over the
+    // dimensions with any extent, then grow them if that makes many more
+    // cells than points, as it does for a very thin cloud.
+    const double perCell = 4;
+    double volume = 1;
+    int extents = 0;
+    for (std::size_t d = 0; d < m_dims; ++d)
+        if (max[d] > m_min[d])
+        {
+            volume *= max[d] - m_min[d];
+            extents++;
+        }
+    m_cellSize = extents ?
+        std::pow(volume * perCell / count, 1.0 / extents) : 1;
+    double cells;
+    do
+    {
+        cells = 1;
+        for (std::size_t d = 0; d < m_dims; ++d)
+            cells *= std::floor((max[d] - m_min[d]) / m_cellSize) + 1;
+        if (cells > 4.0 * count + 64)
+            m_cellSize *= 2;
+    } while (cells > 4.0 * count + 64);
+    for (std::size_t d = 0; d < m_dims; ++d)
+        m_cells[d] = (std::size_t)((max[d] - m_min[d]) / m_cellSize) + 1;
+
+    // Group the points by cell with a counting sort.
+    std::vector<std::size_t> cellOf(count);
+    m_offsets.assign((std::size_t)cells + 1, 0);
+    for (PointId i = 0; i < count; ++i)
+    {
+        const double *p = &coords[i * m_dims];
+        std::size_t c = 0;
+        for (std::size_t d = m_dims; d-- > 0;)
+            c = c * m_cells[d] + cell(p, d);
+        cellOf[i] = c;
+        m_offsets[c + 1]++;
+    }
+    for (std::size_t c = 1; c < m_offsets.size(); ++c)
+        m_offsets[c] += m_offsets[c - 1];
+
+    std::vector<PointId> next(m_offsets.begin(), m_offsets.end() - 1);
+    m_ids.resize(count);
+    m_coords.resize(count * m_dims);
+    for (PointId i = 0; i < count; ++i)
+    {
+        const PointId pos = next[cellOf[i]]++;
+        m_ids[pos] = i;
+        std::copy(coords.begin() + i * m_dims,
+            coords.begin() + (i + 1) * m_dims,
+            m_coords.begin() + pos * m_dims);
+    }
+}
+
+// Cell of a coordinate along dimension 'd', clamped to the grid.
+std::size_t GridIndex::cell(const double *xyz, std::size_t d) const
+{
+    double c = std::floor((xyz[d] - m_min[d]) / m_cellSize);
+    return (std::size_t)(std::max)(0.0,
+        (std::min)(c, (double)m_cells[d] - 1));
+}
+
+void GridIndex::knnBatch(const double *xyz, point_count_t n,
+    point_count_t k, PointId *ids, double *sqrDists) const
+{
+    if (k > size())
+        throw pdal_error("GridIndex: can't find more neighbors than the "
+            "number of points indexed.");
+    if (k == 0)
+        return;
+
+    auto query = [this, xyz, k, ids, sqrDists](std::size_t first,
+        std::size_t last)
+    {
+        typedef std::pair<double, PointId> Neighbor;
+        std::vector<Neighbor> heap;
+        heap.reserve(k + 1);
+        for (std::size_t q = first; q < last; ++q)
+        {
+            const double *point = xyz + q * 3;
+            long center[3] = { 0, 0, 0 };
+            for (std::size_t d = 0; d < m_dims; ++d)
+                center[d] = (long)cell(point, d);
+
+            // 'heap' holds the nearest points found so far, farthest
+            // first.
+            heap.clear();
+            for (long r = 0; ; ++r)
+            {
+                long lo[3];
+                long hi[3];
+                for (std::size_t d = 0; d < 3; ++d)
+                {
+                    lo[d] = (std::max)(center[d] - r, 0L);
+                    hi[d] = (std::min)(center[d] + r, (long)m_cells[d] - 1);
+                }
+
+                // Search the cells at distance 'r' from the center cell.
+                for (long z = lo[2]; z <= hi[2]; ++z)
+                for (long y = lo[1]; y <= hi[1]; ++y)
+                for (long x = lo[0]; x <= hi[0]; ++x)
+                {
+                    if (std::abs(x - center[0]) != r &&
+                        std::abs(y - center[1]) != r &&
+                        std::abs(z - center[2]) != r)
+                        continue;
+                    // Skip cells farther than the kth neighbor.
+                    if (heap.size() == k)
+                    {
+                        const long pos[3] = { x, y, z };
+                        double cellDist = 0;
+                        for (std::size_t d = 0; d < m_dims; ++d)
+                        {
+                            double low = m_min[d] + pos[d] * m_cellSize;
+                            double out = (std::max)(0.0, (std::max)(
+                                low - point[d],
+                                point[d] - (low + m_cellSize)));
+                            cellDist += out * out;
+                        }
+                        if (cellDist >= heap.front().first)
+                            continue;
+                    }
+                    std::size_t c = ((std::size_t)z * m_cells[1] + y) *
+                        m_cells[0] + x;
+                    for (PointId i = m_offsets[c]; i < m_offsets[c + 1];
+                        ++i)
+                    {
+                        const double *p = &m_coords[i * m_dims];
+                        double dist = 0;
+                        for (std::size_t d = 0; d < m_dims; ++d)
+                            dist += (p[d] - point[d]) * (p[d] - point[d]);
+                        if (heap.size() < k || dist < heap.front().first)
+                        {
+                            heap.push_back(Neighbor(dist, m_ids[i]));
+                            std::push_heap(heap.begin(), heap.end());
+                            if (heap.size() > k)
+                            {
+                                std::pop_heap(heap.begin(), heap.end());
+                                heap.pop_back();
+                            }
+                        }
+                    }
+                }
+
+                // Stop when every cell is searched, or when every cell
+                // not yet searched is farther than the kth neighbor.
+                double bound = (std::numeric_limits<double>::max)();
+                for (std::size_t d = 0; d < m_dims; ++d)
+                {
+                    if (center[d] - r > 0)
+                        bound = (std::min)(bound, point[d] -
+                            (m_min[d] + (center[d] - r) * m_cellSize));
+                    if (center[d] + r < (long)m_cells[d] - 1)
+                        bound = (std::min)(bound, m_min[d] +
+                            (center[d] + r + 1) * m_cellSize - point[d]);
+                }
+                if (bound == (std::numeric_limits<double>::max)())
+                    break;
+                if (heap.size() == k && bound > 0 &&
+                    heap.front().first <= bound * bound)
+                    break;
+            }
+
+            std::sort_heap(heap.begin(), heap.end());
+            for (point_count_t i = 0; i < k; ++i)
+            {
+                ids[q * k + i] = heap[i].second;
+                sqrDists[q * k + i] = heap[i].first;
+            }
+        }
+    };
+    ThreadPool::shared().parallelFor(n, 256, query);
+}
+
+} // namespace pdal
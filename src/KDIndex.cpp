@@ -33,15 +33,35 @@
 ****************************************************************************/
 
 #include <pdal/KDIndex.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <pdal/Utils.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 
 #include "nanoflann.hpp"
 
 namespace pdal
 {
 
+// A saved index is the header below followed by nanoflann's own
+// serialization of the tree.  Values are written in the byte order of the
+// machine.
+namespace
+{
+
+const char kdMagic[8] = { 'P', 'D', 'A', 'L', 'K', 'D', 'I', 'X' };
+const uint32_t kdVersion = 1;
+
+} // unnamed namespace
+
 KDIndex::KDIndex(const PointView& buf)
     : m_buf(buf)
     , m_3d(buf.hasDim(Dimension::Id::Z))
+    , m_dims(0)
     , m_index()
 { }
 
@@ -50,56 +70,196 @@ KDIndex::~KDIndex()
 
 std::size_t KDIndex::kdtree_get_point_count() const
 {
-    return m_buf.size();
+    return m_dims ? m_coords.size() / m_dims : 0;
+}
+
+double KDIndex::kdtree_distance(
+        const PointId idx_p2,
+        point_count_t size) const
+{
+    const double *p1 = &m_coords[idx_p2 * m_dims];
+    const double *p2 = &m_coords[(size - 1) * m_dims];
+
+    double output(0);
+    for (std::size_t d = 0; d < m_dims; ++d)
+        output += (p1[d] - p2[d]) * (p1[d] - p2[d]);
+    return output;
 }
 
-double KDIndex::kdtree_get_pt(const PointId idx, int dim) const
+void KDIndex::fillCache(bool b3D)
 {
-    Dimension::Id::Enum id = Dimension::Id::Unknown;
-    switch (dim)
+    m_3d = b3D;
+    m_dims = m_3d && m_buf.hasDim(Dimension::Id::Z) ? 3 : 2;
+
+    // Fetch the coordinates in batches and interleave them so that a
+    // point's coordinates are adjacent for the tree's distance loops.
+    const point_count_t count = m_buf.size();
+    const point_count_t batchSize = 4096;
+    m_coords.resize(count * m_dims);
+
+    auto fill = [this, count, batchSize](std::size_t first, std::size_t last)
     {
-    case 0:
-        id = Dimension::Id::X;
-        break;
-    case 1:
-        id = Dimension::Id::Y;
-        break;
-    case 2:
-        id = Dimension::Id::Z;
-        break;
-    }
-    return m_buf.getFieldAs<double>(id, idx);
+        const Dimension::Id::Enum dims[] =
+            { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z };
+        std::vector<double> batch(batchSize);
+
+        for (PointId begin = first; begin < last; begin += batchSize)
+        {
+            point_count_t n =
+                (std::min)(batchSize, (point_count_t)(last - begin));
+            for (std::size_t d = 0; d < m_dims; ++d)
+            {
+                m_buf.getFieldArray(dims[d], begin, n, batch.data());
+                double *out = &m_coords[begin * m_dims + d];
+                for (point_count_t i = 0; i < n; ++i)
+                    out[i * m_dims] = batch[i];
+            }
+        }
+    };
+    if (m_buf.table().threadSafe())
+        ThreadPool::shared().parallelFor(count, 16 * batchSize, fill);
+    else
+        fill(0, count);
 }
 
-double KDIndex::kdtree_distance(
-        const PointId idx_p2,
-        point_count_t size) const
+bool KDIndex::current(const PointView& view, bool b3D) const
 {
-    double d0 = m_buf.getFieldAs<double>(Dimension::Id::X, idx_p2) -
-        m_buf.getFieldAs<double>(Dimension::Id::X, size - 1);
-    double d1 = m_buf.getFieldAs<double>(Dimension::Id::Y, idx_p2) -
-        m_buf.getFieldAs<double>(Dimension::Id::Y, size - 1);
+    std::size_t dims = b3D && view.hasDim(Dimension::Id::Z) ? 3 : 2;
+    if (!m_index || &view != &m_buf || dims != m_dims ||
+        view.size() != kdtree_get_point_count())
+        return false;
 
-    double output(d0 * d0 + d1 * d1);
-    if (m_3d)
+    const point_count_t batchSize = 4096;
+    std::atomic<bool> same(true);
+    auto compare = [this, &same, batchSize](std::size_t first,
+        std::size_t last)
     {
-        double d2 = m_buf.getFieldAs<double>(Dimension::Id::Z, idx_p2) -
-            m_buf.getFieldAs<double>(Dimension::Id::Z, size - 1);
-        output += d2 * d2;
-    }
-    return output;
+        const Dimension::Id::Enum ids[] =
+            { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z };
+        std::vector<double> batch(batchSize);
+
+        for (PointId begin = first; begin < last && same; begin += batchSize)
+        {
+            point_count_t n =
+                (std::min)(batchSize, (point_count_t)(last - begin));
+            for (std::size_t d = 0; d < m_dims; ++d)
+            {
+                m_buf.getFieldArray(ids[d], begin, n, batch.data());
+                const double *cached = &m_coords[begin * m_dims + d];
+                for (point_count_t i = 0; i < n; ++i)
+                    if (cached[i * m_dims] != batch[i])
+                    {
+                        same = false;
+                        return;
+                    }
+            }
+        }
+    };
+    if (m_buf.table().threadSafe())
+        ThreadPool::shared().parallelFor(view.size(), 16 * batchSize,
+            compare);
+    else
+        compare(0, view.size());
+    return same;
+}
+
+uint64_t KDIndex::hash() const
+{
+    uint64_t dims = m_dims;
+    uint64_t h = Utils::hash64(&dims, sizeof(dims));
+    return Utils::hash64(m_coords.data(), m_coords.size() * sizeof(double), h);
 }
 
 void KDIndex::build(bool b3D)
 {
-    m_3d = b3D;
-    int nDims = m_3d && m_buf.hasDim(Dimension::Id::Z) ? 3 : 2;
+    fillCache(b3D);
     m_index.reset(
             new my_kd_tree_t(
-                nDims,
+                m_dims,
                 *this,
-                nanoflann::KDTreeSingleIndexAdaptorParams(10, nDims)));
+                nanoflann::KDTreeSingleIndexAdaptorParams(10, m_dims)));
     m_index->buildIndex();
+    m_treeCharge = memory::Charge(memory::SpatialIndex,
+        m_index->usedMemory());
+}
+
+void KDIndex::build(const std::string& cacheFile, bool b3D)
+{
+    if (load(cacheFile, b3D))
+        return;
+    build(b3D);
+    save(cacheFile);
+}
+
+bool KDIndex::load(const std::string& filename, bool b3D)
+{
+    m_index.reset();
+    m_treeCharge = memory::Charge();
+    fillCache(b3D);
+
+    FILE *fp = fopen(filename.c_str(), "rb");
+    if (!fp)
+        return false;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t dims;
+    uint64_t count;
+    uint64_t h;
+    bool ok = fread(magic, sizeof(magic), 1, fp) == 1 &&
+        memcmp(magic, kdMagic, sizeof(magic)) == 0 &&
+        fread(&version, sizeof(version), 1, fp) == 1 &&
+        version == kdVersion &&
+        fread(&dims, sizeof(dims), 1, fp) == 1 && dims == m_dims &&
+        fread(&count, sizeof(count), 1, fp) == 1 &&
+        count == kdtree_get_point_count() &&
+        fread(&h, sizeof(h), 1, fp) == 1 && h == hash();
+    if (ok)
+    {
+        std::unique_ptr<my_kd_tree_t> index(
+            new my_kd_tree_t(
+                m_dims,
+                *this,
+                nanoflann::KDTreeSingleIndexAdaptorParams(10, m_dims)));
+        try
+        {
+            index->loadIndex(fp);
+            m_index = std::move(index);
+            m_treeCharge = memory::Charge(memory::SpatialIndex,
+                m_index->usedMemory());
+        }
+        catch (std::runtime_error&)
+        {
+            ok = false;
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+void KDIndex::save(const std::string& filename) const
+{
+    if (!m_index)
+        throw pdal_error("KDIndex: can't save an index that hasn't been "
+            "built.");
+
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+        throw pdal_error("KDIndex: unable to open '" + filename +
+            "' for writing.");
+
+    uint32_t dims = (uint32_t)m_dims;
+    uint64_t count = kdtree_get_point_count();
+    uint64_t h = hash();
+    fwrite(kdMagic, sizeof(kdMagic), 1, fp);
+    fwrite(&kdVersion, sizeof(kdVersion), 1, fp);
+    fwrite(&dims, sizeof(dims), 1, fp);
+    fwrite(&count, sizeof(count), 1, fp);
+    fwrite(&h, sizeof(h), 1, fp);
+    m_index->saveIndex(fp);
+    bool ok = !ferror(fp);
+    if (fclose(fp) != 0 || !ok)
+        throw pdal_error("KDIndex: error writing '" + filename + "'.");
 }
 
 std::vector<std::size_t> KDIndex::radius(
@@ -131,19 +291,59 @@ std::vector<PointId> KDIndex::neighbors(
         double const& z,
         point_count_t k) const
 {
-    std::vector<PointId> output(k);
-    std::vector<double> out_dist_sqr(k);
+    std::vector<PointId> output;
+    std::vector<double> out_dist_sqr;
+    neighbors(x, y, z, k, output, out_dist_sqr);
+    output.resize(k);
+    return output;
+}
+
+void KDIndex::neighbors(
+        double const& x,
+        double const& y,
+        double const& z,
+        point_count_t k,
+        std::vector<PointId>& ids,
+        std::vector<double>& sqrDists) const
+{
+    ids.resize(k);
+    sqrDists.resize(k);
+    if (k == 0)
+        return;
     nanoflann::KNNResultSet<double, PointId, point_count_t> resultSet(k);
 
-    resultSet.init(&output[0], &out_dist_sqr[0]);
+    resultSet.init(&ids[0], &sqrDists[0]);
 
-    std::vector<double> pt;
-    pt.push_back(x);
-    pt.push_back(y);
-    if (m_3d)
-        pt.push_back(z);
-    m_index->findNeighbors(resultSet, &pt[0], nanoflann::SearchParams(10));
-    return output;
+    double pt[3] = { x, y, z };
+    m_index->findNeighbors(resultSet, pt, nanoflann::SearchParams(10));
+    ids.resize(resultSet.size());
+    sqrDists.resize(resultSet.size());
+}
+
+void KDIndex::knnBatch(const double *xyz, point_count_t n, point_count_t k,
+        PointId *ids, double *sqrDists) const
+{
+    if (k > kdtree_get_point_count())
+        throw pdal_error("KDIndex: can't find more neighbors than the "
+            "number of points indexed.");
+    if (k == 0)
+        return;
+
+    // Each query writes straight into its own rows of the output, so
+    // nothing is allocated per query.
+    auto query = [this, xyz, k, ids, sqrDists](std::size_t first,
+        std::size_t last)
+    {
+        nanoflann::SearchParams params(10);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            nanoflann::KNNResultSet<double, PointId, point_count_t>
+                resultSet(k);
+            resultSet.init(ids + i * k, sqrDists + i * k);
+            m_index->findNeighbors(resultSet, xyz + i * 3, params);
+        }
+    };
+    ThreadPool::shared().parallelFor(n, 256, query);
 }
 
 } // namespace pdal
@@ -34,6 +34,8 @@
 
 #include <pdal/GlobalEnvironment.hpp>
 #include <pdal/Kernel.hpp>
+#include <pdal/PluginManager.hpp>
+#include <pdal/Trace.hpp>
 #include <iostream>
 
 #include <boost/algorithm/string.hpp>
@@ -220,8 +222,32 @@ int Kernel::run(int argc, const char* argv[], const std::string& appName)
     if (startup_status)
         return startup_status;
 
+    if (m_traceFile.size())
+        trace::start(m_traceFile);
+
     int execution_status = do_execution();
 
+    // A trace of a failed run is written too, since that's often the one
+    // that's wanted.
+    if (m_traceFile.size())
+    {
+        try
+        {
+            trace::stop();
+        }
+        catch (pdal_error const& e)
+        {
+            printError(std::string("PDAL: ") + e.what());
+        }
+    }
+
+    if (m_isDebug)
+    {
+        PluginManager& pm = PluginManager::getInstance();
+        std::cerr << "Loaded " << pm.loadedCount() << " plugin(s) in " <<
+            pm.loadTime() << " seconds" << std::endl;
+    }
+
     // note we will try to shutdown cleanly even if we got an error condition
     // in the execution phase
 
@@ -538,6 +564,7 @@ void Kernel::addBasicSwitchSet()
     ("verbose,v", po::value<uint32_t>(&m_verboseLevel)->default_value(0), "Set verbose message level")
     ("version", po::value<bool>(&m_showVersion)->zero_tokens()->implicit_value(true), "Show version info")
     ("visualize", po::value<bool>(&m_visualize)->zero_tokens()->implicit_value(true), "Visualize result")
+    ("trace", po::value<std::string>(&m_traceFile), "Write a Chrome trace of the run to this file")
     ("stdin,s", po::value<bool>(&m_usestdin)->zero_tokens()->implicit_value(true), "Read pipeline XML from stdin")
     ("heartbeat", po::value< std::vector<std::string> >(&m_heartbeat_shell_command), "Shell command to run for every progress heartbeat")
     ("scale", po::value< std::string >(&m_scales),
@@ -37,18 +37,25 @@
 #include <pdal/PluginManager.hpp>
 #include <pdal/Utils.hpp>
 
+#include <bench/BenchKernel.hpp>
+#include <density/DensityKernel.hpp>
 #include <delta/DeltaKernel.hpp>
 #include <diff/DiffKernel.hpp>
 #include <info/InfoKernel.hpp>
+#include <lasindex/LasIndexKernel.hpp>
+#include <merge/MergeKernel.hpp>
 #include <pipeline/PipelineKernel.hpp>
 #include <random/RandomKernel.hpp>
+#include <serve/ServeKernel.hpp>
 #include <sort/SortKernel.hpp>
+#include <tile/TileKernel.hpp>
 #include <translate/TranslateKernel.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/tokenizer.hpp>
 
+#include <mutex>
 #include <sstream>
 #include <stdio.h> // for funcptr
 #include <string>
@@ -57,19 +64,39 @@
 namespace pdal
 {
 
-KernelFactory::KernelFactory(bool no_plugins)
+namespace
 {
-    PluginManager & pm = PluginManager::getInstance();
-    if (!no_plugins) { pm.loadAll(PF_PluginType_Kernel); }
+
+// Register the kernels built into the library.  This only needs to happen
+// once no matter how many factories are created.
+void registerBuiltins()
+{
+    PluginManager::initializePlugin(BenchKernel_InitPlugin);
+    PluginManager::initializePlugin(DensityKernel_InitPlugin);
     PluginManager::initializePlugin(DeltaKernel_InitPlugin);
     PluginManager::initializePlugin(DiffKernel_InitPlugin);
     PluginManager::initializePlugin(InfoKernel_InitPlugin);
+    PluginManager::initializePlugin(LasIndexKernel_InitPlugin);
+    PluginManager::initializePlugin(MergeKernel_InitPlugin);
     PluginManager::initializePlugin(PipelineKernel_InitPlugin);
     PluginManager::initializePlugin(RandomKernel_InitPlugin);
+    PluginManager::initializePlugin(ServeKernel_InitPlugin);
     PluginManager::initializePlugin(SortKernel_InitPlugin);
+    PluginManager::initializePlugin(TileKernel_InitPlugin);
     PluginManager::initializePlugin(TranslateKernel_InitPlugin);
 }
 
+} // unnamed namespace
+
+KernelFactory::KernelFactory(bool no_plugins)
+{
+    static std::once_flag builtinFlag;
+    std::call_once(builtinFlag, registerBuiltins);
+
+    PluginManager & pm = PluginManager::getInstance();
+    if (!no_plugins) { pm.loadAll(PF_PluginType_Kernel); }
+}
+
 std::unique_ptr<Kernel> KernelFactory::createKernel(std::string const& kernel_name)
 {
     PluginManager & pm = PluginManager::getInstance();
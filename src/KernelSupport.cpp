@@ -50,15 +50,34 @@ PipelineManager* KernelSupport::makePipeline(const std::string& inputFile)
         throw app_runtime_error("file not found: " + inputFile);
 
     PipelineManager* output = new PipelineManager;
+    addInput(*output, inputFile);
+    return output;
+}
+
+
+PipelineManager* KernelSupport::makePipeline(const std::string& inputFile,
+    PointTableRef table)
+{
+    if (!pdal::FileUtils::fileExists(inputFile))
+        throw app_runtime_error("file not found: " + inputFile);
 
+    PipelineManager* output = new PipelineManager(table);
+    addInput(*output, inputFile);
+    return output;
+}
+
+
+void KernelSupport::addInput(PipelineManager& manager,
+    const std::string& inputFile)
+{
     if (inputFile == "STDIN")
     {
-        PipelineReader pipeReader(*output);
+        PipelineReader pipeReader(manager);
         pipeReader.readPipeline(std::cin);
     }
     else if (boost::filesystem::extension(inputFile) == ".xml")
     {
-        PipelineReader pipeReader(*output);
+        PipelineReader pipeReader(manager);
         pipeReader.readPipeline(inputFile);
     }
     else
@@ -69,9 +88,8 @@ PipelineManager* KernelSupport::makePipeline(const std::string& inputFile)
         if (driver.empty())
             throw app_runtime_error("Cannot determine input file type of " +
                 inputFile);
-        output->addReader(driver);
+        manager.addReader(driver);
     }
-    return output;
 }
 
 
@@ -35,17 +35,135 @@
 #include <pdal/Log.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <condition_variable>
+#include <mutex>
 #include <ostream>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 namespace pdal
 {
 
 using namespace LogLevel;
 
+// Collects what's written to it into lines and queues each line in a ring
+// for a background thread to write to the target stream.  Writers only
+// wait for the lock on the ring, never on the target.
+class AsyncLogBuf : public std::streambuf
+{
+public:
+    AsyncLogBuf(std::ostream& target, std::size_t capacity) :
+        m_target(target), m_ring(capacity ? capacity : 1), m_head(0),
+        m_size(0), m_dropped(0), m_done(false)
+    {
+        m_thread = std::thread(&AsyncLogBuf::run, this);
+    }
+
+    ~AsyncLogBuf()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_line.size())
+                queue();
+            m_done = true;
+        }
+        m_ready.notify_one();
+        m_thread.join();
+    }
+
+protected:
+    virtual int_type overflow(int_type c)
+    {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof(c);
+        char ch = traits_type::to_char_type(c);
+        xsputn(&ch, 1);
+        return c;
+    }
+
+    virtual std::streamsize xsputn(const char *s, std::streamsize n)
+    {
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (std::streamsize i = 0; i < n; ++i)
+            {
+                m_line.push_back(s[i]);
+                if (s[i] == '\n')
+                {
+                    queue();
+                    queued = true;
+                }
+            }
+        }
+        if (queued)
+            m_ready.notify_one();
+        return n;
+    }
+
+private:
+    std::ostream& m_target;
+    std::vector<std::string> m_ring;
+    std::size_t m_head;
+    std::size_t m_size;
+    std::size_t m_dropped;
+    bool m_done;
+    std::string m_line;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::thread m_thread;
+
+    // Move the current line to the ring, or drop it if the ring is full.
+    // Called with the lock held.
+    void queue()
+    {
+        if (m_size == m_ring.size())
+            m_dropped++;
+        else
+        {
+            m_ring[(m_head + m_size) % m_ring.size()].swap(m_line);
+            m_size++;
+        }
+        m_line.clear();
+    }
+
+    void run()
+    {
+        std::vector<std::string> lines;
+        while (true)
+        {
+            std::size_t dropped;
+            bool done;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [this]{ return m_size || m_done; });
+                for (; m_size; m_size--)
+                {
+                    lines.push_back(std::string());
+                    lines.back().swap(m_ring[m_head]);
+                    m_head = (m_head + 1) % m_ring.size();
+                }
+                dropped = m_dropped;
+                m_dropped = 0;
+                done = m_done;
+            }
+            if (dropped)
+                m_target << "(" << dropped << " log lines dropped)\n";
+            for (const std::string& line : lines)
+                m_target << line;
+            lines.clear();
+            m_target.flush();
+            if (done)
+                break;
+        }
+    }
+};
+
 Log::Log(std::string const& leaderString,
          std::string const& outputName)
-    : m_level(Error)
+    : m_target(NULL)
+    , m_level(Error)
     , m_deleteStreamOnCleanup(false)
     , m_leader(leaderString)
 {
@@ -73,7 +191,8 @@ Log::Log(std::string const& leaderString,
 
 Log::Log(std::string const& leaderString,
          std::ostream* v)
-    : m_level(Error)
+    : m_target(NULL)
+    , m_level(Error)
     , m_deleteStreamOnCleanup(false)
     , m_leader(leaderString)
 {
@@ -85,6 +204,13 @@ Log::Log(std::string const& leaderString,
 
 Log::~Log()
 {
+    // Write what's queued before the target goes away.
+    if (m_asyncBuf)
+    {
+        m_asyncStream.reset();
+        m_asyncBuf.reset();
+        m_log = m_target;
+    }
 
     if (m_deleteStreamOnCleanup)
     {
@@ -95,6 +221,18 @@ Log::~Log()
     m_log = 0;
 }
 
+void Log::setAsync(std::size_t capacity)
+{
+    if (m_asyncBuf)
+        return;
+    m_target = m_log;
+    m_asyncBuf.reset(new AsyncLogBuf(*m_target, capacity));
+    m_asyncStream.reset(new std::ostream(m_asyncBuf.get()));
+    m_asyncStream->copyfmt(*m_target);
+    m_log = m_asyncStream.get();
+}
+
+
 void Log::floatPrecision(int level)
 {
     m_log->setf(std::ios_base::fixed, std::ios_base::floatfield);
@@ -0,0 +1,128 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/MemoryAccount.hpp>
+
+namespace pdal
+{
+namespace memory
+{
+
+namespace
+{
+
+thread_local Account *t_current = NULL;
+
+} // unnamed namespace
+
+
+const char *categoryName(Category c)
+{
+    switch (c)
+    {
+    case TableBlocks:
+        return "table";
+    case ViewIndex:
+        return "view_index";
+    case SpatialIndex:
+        return "spatial_index";
+    case Temporary:
+        return "temporary";
+    default:
+        return "";
+    }
+}
+
+
+void Account::allocated(Category c, std::size_t bytes)
+{
+    Counts& counts = m_counts[c];
+    uint64_t cur = counts.m_current.fetch_add(bytes,
+        std::memory_order_relaxed) + bytes;
+    counts.m_total.fetch_add(bytes, std::memory_order_relaxed);
+    uint64_t peak = counts.m_peak.load(std::memory_order_relaxed);
+    while (cur > peak && !counts.m_peak.compare_exchange_weak(peak, cur,
+            std::memory_order_relaxed))
+        ;
+}
+
+
+void Account::freed(Category c, std::size_t bytes)
+{
+    m_counts[c].m_current.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+
+Account *current()
+{
+    return t_current;
+}
+
+
+Scope::Scope(Account *a) : m_prev(t_current)
+{
+    t_current = a;
+}
+
+
+Scope::~Scope()
+{
+    t_current = m_prev;
+}
+
+
+Account *charge(Category c, std::size_t bytes)
+{
+    Account *a = t_current;
+    if (a)
+    {
+        a->retain();
+        a->allocated(c, bytes);
+    }
+    return a;
+}
+
+
+void credit(Account *a, Category c, std::size_t bytes)
+{
+    if (a)
+    {
+        a->freed(c, bytes);
+        a->release();
+    }
+}
+
+} // namespace memory
+} // namespace pdal
+
@@ -0,0 +1,502 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <algorithm>
+#include <limits>
+
+#include <pdal/OctreeIndex.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
+
+namespace
+{
+    using namespace pdal;
+
+    // The bounds of a node.
+    struct Cube
+    {
+        double min[3];
+        double max[3];
+
+        double center(int axis) const
+        {
+            return min[axis] + (max[axis] - min[axis]) / 2;
+        }
+
+        // Returns the bounds of an octant of this cube.  Bits 0, 1 and 2 of
+        // the octant select the upper half in X, Y and Z.
+        Cube octant(int o) const
+        {
+            Cube c(*this);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (o & (1 << axis))
+                    c.min[axis] = center(axis);
+                else
+                    c.max[axis] = center(axis);
+            }
+            return c;
+        }
+
+        // Returns true if the cube shares any space with the box, including
+        // its faces.
+        bool overlaps(const BOX3D& box) const
+        {
+            return box.minx <= max[0] && box.maxx >= min[0] &&
+                box.miny <= max[1] && box.maxy >= min[1] &&
+                box.minz <= max[2] && box.maxz >= min[2];
+        }
+    };
+
+} // anonymous namespace
+
+namespace pdal
+{
+
+// The octree is stored flat, as is QuadIndex.  Each node holds one point,
+// the one nearest the center of the node's bounds among the points within
+// them that aren't held higher up.  Nodes are stored in preorder, so the
+// subtree of a node is the range of nodes starting at it, and its first
+// child directly follows it.
+struct OctreeIndex::OImpl
+{
+    OImpl(const PointView& view, std::size_t topLevel);
+
+    std::size_t getDepth() const
+        { return m_depth; }
+
+    BOX3D getBounds() const;
+
+    std::vector<std::size_t> getFills() const;
+
+    std::vector<PointId> getPoints(
+            const BOX3D *box,
+            std::size_t depthBegin,
+            std::size_t depthEnd) const;
+
+    std::vector<PointId> getVoxels(
+            std::size_t depth,
+            double& xStep,
+            double& yStep,
+            double& zStep) const;
+
+private:
+    struct Entry
+    {
+        double pos[3];
+        PointId id;
+    };
+
+    std::size_t m_topLevel;
+    // The point of each node.
+    std::vector<Entry> m_points;
+    // The number of nodes in the subtree of each node.
+    std::vector<PointId> m_sizes;
+    // Bit o is set when a node has a child in octant o.
+    std::vector<uint8_t> m_octants;
+    // Space to group points by octant while building.
+    std::vector<Entry> m_scratch;
+    Cube m_bounds;
+    std::size_t m_depth;
+
+    void readPoints(const PointView& view);
+    std::size_t build(
+            PointId begin,
+            PointId end,
+            const Cube& cube,
+            std::size_t curDepth);
+
+    template<typename F>
+    void visit(F f) const;
+};
+
+OctreeIndex::OImpl::OImpl(const PointView& view, std::size_t topLevel)
+    : m_topLevel(topLevel)
+    , m_depth(0)
+{
+    readPoints(view);
+    m_sizes.resize(m_points.size());
+    m_octants.resize(m_points.size());
+    if (m_points.size())
+    {
+        m_scratch.resize(m_points.size());
+        m_depth = build(0, m_points.size(), m_bounds, 0);
+        std::vector<Entry>().swap(m_scratch);
+    }
+}
+
+void OctreeIndex::OImpl::readPoints(const PointView& view)
+{
+    const point_count_t batchSize = 4096;
+    const Dimension::Id::Enum dims[] =
+        { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z };
+    std::vector<double> values(batchSize);
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        m_bounds.min[axis] = (std::numeric_limits<double>::max)();
+        m_bounds.max[axis] = std::numeric_limits<double>::lowest();
+    }
+
+    m_points.resize(view.size());
+    for (PointId begin = 0; begin < view.size(); begin += batchSize)
+    {
+        point_count_t count = (std::min)(batchSize, view.size() - begin);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            view.getFieldArray(dims[axis], begin, count, values.data());
+            for (PointId i = 0; i < count; ++i)
+            {
+                const double v(values[i]);
+                m_points[begin + i].pos[axis] = v;
+                m_bounds.min[axis] = (std::min)(m_bounds.min[axis], v);
+                m_bounds.max[axis] = (std::max)(m_bounds.max[axis], v);
+            }
+        }
+        for (PointId i = 0; i < count; ++i)
+            m_points[begin + i].id = begin + i;
+    }
+}
+
+// Build the subtree of the points in [begin, end), which fall within
+// 'cube', and return the depth of its deepest node.  As in QuadIndex, the
+// nodes are built from a stack, since identical points form chains of
+// nodes, and large octants are built in parallel.
+std::size_t OctreeIndex::OImpl::build(
+        PointId begin,
+        PointId end,
+        const Cube& cube,
+        std::size_t curDepth)
+{
+    struct Task
+    {
+        PointId begin;
+        PointId end;
+        Cube cube;
+        std::size_t depth;
+    };
+    const point_count_t parallelSize(16384);
+
+    std::vector<Task> tasks;
+    Task root = { begin, end, cube, curDepth };
+    tasks.push_back(root);
+
+    std::size_t maxDepth(curDepth);
+    while (tasks.size())
+    {
+        const Task task(tasks.back());
+        tasks.pop_back();
+        begin = task.begin;
+        end = task.end;
+        maxDepth = (std::max)(maxDepth, task.depth);
+
+        const double center[3] = { task.cube.center(0),
+            task.cube.center(1), task.cube.center(2) };
+        auto sqDist = [&center](const Entry& e)
+        {
+            double d(0);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const double delta(e.pos[axis] - center[axis]);
+                d += delta * delta;
+            }
+            return d;
+        };
+
+        // Keep the first point of those nearest the center.
+        PointId nearest(begin);
+        double nearestDist(sqDist(m_points[begin]));
+        for (PointId i = begin + 1; i < end; ++i)
+        {
+            const double dist(sqDist(m_points[i]));
+            if (dist < nearestDist)
+            {
+                nearest = i;
+                nearestDist = dist;
+            }
+        }
+        std::swap(m_points[begin], m_points[nearest]);
+        m_sizes[begin] = end - begin;
+
+        // Group the rest by octant.  A point on a center plane goes to the
+        // upper half.
+        auto octant = [&center](const Entry& e)
+        {
+            return (e.pos[0] < center[0] ? 0 : 1) |
+                (e.pos[1] < center[1] ? 0 : 2) |
+                (e.pos[2] < center[2] ? 0 : 4);
+        };
+        PointId bounds[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+        for (PointId i = begin + 1; i < end; ++i)
+            bounds[octant(m_points[i]) + 1]++;
+        bounds[0] = begin + 1;
+        for (int o = 0; o < 8; ++o)
+            bounds[o + 1] += bounds[o];
+
+        PointId next[8];
+        std::copy(bounds, bounds + 8, next);
+        for (PointId i = begin + 1; i < end; ++i)
+            m_scratch[next[octant(m_points[i])]++] = m_points[i];
+        std::copy(m_scratch.begin() + begin + 1, m_scratch.begin() + end,
+            m_points.begin() + begin + 1);
+
+        uint8_t octants(0);
+        int large(0);
+        for (int o = 0; o < 8; ++o)
+        {
+            if (bounds[o] != bounds[o + 1])
+                octants |= (1 << o);
+            if (bounds[o + 1] - bounds[o] >= parallelSize)
+                large++;
+        }
+        m_octants[begin] = octants;
+
+        if (large > 1)
+        {
+            std::size_t depths[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+            auto buildOctants = [this, &bounds, &depths, &task](
+                std::size_t first, std::size_t last)
+            {
+                for (std::size_t o = first; o < last; ++o)
+                    if (bounds[o] != bounds[o + 1])
+                        depths[o] = build(bounds[o], bounds[o + 1],
+                            task.cube.octant(o), task.depth + 1);
+            };
+            ThreadPool::shared().parallelFor(8, 1, buildOctants);
+            maxDepth = (std::max)(maxDepth,
+                *std::max_element(depths, depths + 8));
+            continue;
+        }
+
+        for (int o = 0; o < 8; ++o)
+        {
+            if (bounds[o] == bounds[o + 1])
+                continue;
+            Task t = { bounds[o], bounds[o + 1], task.cube.octant(o),
+                task.depth + 1 };
+            tasks.push_back(t);
+        }
+    }
+    return maxDepth;
+}
+
+// Visit the nodes in preorder, calling f(node, cube, depth, cell), where
+// 'cell' is the position of the node among those of its level.  Children
+// are visited only when f returns true.
+template<typename F>
+void OctreeIndex::OImpl::visit(F f) const
+{
+    struct Frame
+    {
+        PointId node;
+        Cube cube;
+        std::size_t depth;
+        std::size_t cell[3];
+    };
+
+    if (m_points.empty())
+        return;
+
+    std::vector<Frame> stack;
+    Frame root = { 0, m_bounds, m_topLevel, { 0, 0, 0 } };
+    stack.push_back(root);
+    while (stack.size())
+    {
+        const Frame frame(stack.back());
+        stack.pop_back();
+        if (!f(frame.node, frame.cube, frame.depth, frame.cell))
+            continue;
+
+        // Push the children last to first so that they're visited in
+        // order.
+        PointId children[8];
+        int octants[8];
+        int count(0);
+        PointId child(frame.node + 1);
+        for (int o = 0; o < 8; ++o)
+            if (m_octants[frame.node] & (1 << o))
+            {
+                children[count] = child;
+                octants[count++] = o;
+                child += m_sizes[child];
+            }
+        while (count--)
+        {
+            const int o(octants[count]);
+            Frame next = { children[count], frame.cube.octant(o),
+                frame.depth + 1, { 0, 0, 0 } };
+            for (int axis = 0; axis < 3; ++axis)
+                next.cell[axis] = frame.cell[axis] * 2 + ((o >> axis) & 1);
+            stack.push_back(next);
+        }
+    }
+}
+
+BOX3D OctreeIndex::OImpl::getBounds() const
+{
+    if (m_points.empty())
+        return BOX3D();
+    return BOX3D(m_bounds.min[0], m_bounds.min[1], m_bounds.min[2],
+        m_bounds.max[0], m_bounds.max[1], m_bounds.max[2]);
+}
+
+std::vector<std::size_t> OctreeIndex::OImpl::getFills() const
+{
+    std::vector<std::size_t> fills;
+    if (m_points.size())
+        fills.resize(m_depth + 1);
+
+    visit([this, &fills](PointId, const Cube&, std::size_t depth,
+        const std::size_t *)
+    {
+        ++fills[depth - m_topLevel];
+        return true;
+    });
+    return fills;
+}
+
+std::vector<PointId> OctreeIndex::OImpl::getPoints(
+        const BOX3D *box,
+        std::size_t depthBegin,
+        std::size_t depthEnd) const
+{
+    std::vector<PointId> results;
+
+    visit([&](PointId node, const Cube& cube, std::size_t depth,
+        const std::size_t *)
+    {
+        if (box && !cube.overlaps(*box))
+            return false;
+
+        const Entry& e(m_points[node]);
+        if (depth >= depthBegin && (depth < depthEnd || depthEnd == 0) &&
+            (!box || box->contains(e.pos[0], e.pos[1], e.pos[2])))
+            results.push_back(e.id);
+        return depth + 1 < depthEnd || depthEnd == 0;
+    });
+    return results;
+}
+
+std::vector<PointId> OctreeIndex::OImpl::getVoxels(
+        std::size_t depth,
+        double& xStep,
+        double& yStep,
+        double& zStep) const
+{
+    std::vector<PointId> results;
+    xStep = yStep = zStep = 0;
+    if (m_points.empty() || depth < m_topLevel)
+        return results;
+
+    const std::size_t level(depth - m_topLevel);
+    if (3 * level >= 8 * sizeof(std::size_t) - 1)
+        throw pdal_error("OctreeIndex: too many voxels at the "
+            "requested depth.");
+    const std::size_t side((std::size_t)1 << level);
+    xStep = (m_bounds.max[0] - m_bounds.min[0]) / side;
+    yStep = (m_bounds.max[1] - m_bounds.min[1]) / side;
+    zStep = (m_bounds.max[2] - m_bounds.min[2]) / side;
+
+    results.resize(side * side * side, std::numeric_limits<PointId>::max());
+    visit([&](PointId node, const Cube&, std::size_t curDepth,
+        const std::size_t *cell)
+    {
+        if (curDepth < depth)
+            return true;
+        results[(cell[2] * side + cell[1]) * side + cell[0]] =
+            m_points[node].id;
+        return false;
+    });
+    return results;
+}
+
+OctreeIndex::OctreeIndex(const PointView& view, std::size_t topLevel)
+    : m_oImpl(new OImpl(view, topLevel))
+{ }
+
+OctreeIndex::~OctreeIndex()
+{ }
+
+BOX3D OctreeIndex::getBounds() const
+{
+    return m_oImpl->getBounds();
+}
+
+std::size_t OctreeIndex::getDepth() const
+{
+    return m_oImpl->getDepth();
+}
+
+std::vector<std::size_t> OctreeIndex::getFills() const
+{
+    return m_oImpl->getFills();
+}
+
+std::vector<PointId> OctreeIndex::getPoints(std::size_t depthEnd) const
+{
+    return m_oImpl->getPoints(nullptr, 0, depthEnd);
+}
+
+std::vector<PointId> OctreeIndex::getPoints(
+        std::size_t depthBegin,
+        std::size_t depthEnd) const
+{
+    return m_oImpl->getPoints(nullptr, depthBegin, depthEnd);
+}
+
+std::vector<PointId> OctreeIndex::getPoints(
+        const BOX3D& box,
+        std::size_t depthEnd) const
+{
+    return m_oImpl->getPoints(&box, 0, depthEnd);
+}
+
+std::vector<PointId> OctreeIndex::getPoints(
+        const BOX3D& box,
+        std::size_t depthBegin,
+        std::size_t depthEnd) const
+{
+    return m_oImpl->getPoints(&box, depthBegin, depthEnd);
+}
+
+std::vector<PointId> OctreeIndex::getVoxels(
+        std::size_t depth,
+        double& xStep,
+        double& yStep,
+        double& zStep) const
+{
+    return m_oImpl->getVoxels(depth, xStep, yStep, zStep);
+}
+
+} // namespace pdal
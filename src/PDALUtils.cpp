@@ -39,102 +39,178 @@ using namespace std;
 namespace pdal
 {
 
-namespace {
-
-void toJSON(const MetadataNode& m, std::ostream& o, int level);
-void arrayToJSON(const MetadataNodeList& children, std::ostream& o, int level);
-void arrayEltToJSON(const MetadataNode& m, std::ostream& o, int level);
-void subnodesToJSON(const MetadataNode& parent, std::ostream& o, int level)
+// Writes metadata as JSON straight from the nodes, without copying the
+// lists of subnodes or their names and without flushing at each line.
+class MetadataJsonWriter
 {
-    const std::string indent(level * 2, ' ');
-
-    std::vector<std::string> names = parent.childNames();
+public:
+    MetadataJsonWriter(std::ostream& out) : m_out(out)
+    {}
 
-    o << indent << "{" << endl;
-    for (auto ni = names.begin(); ni != names.end(); ++ni)
+    void write(const MetadataNode& m)
     {
-        MetadataNodeList children = parent.children(*ni);
-
-        MetadataNode& node = *children.begin();
-        if (node.kind() == MetadataType::Array)
+        const MetadataNodeImpl& impl = *m.m_impl;
+        if (impl.m_name.empty())
+            subnodes(impl, 0);
+        else if (impl.m_kind == MetadataType::Array)
         {
-            o << indent << "  \"" << node.name() << "\":" << std::endl;
-            arrayToJSON(children, o, level + 1);
+            MetadataImplList children;
+            for (auto const& si : impl.m_subnodes)
+                children.insert(children.end(), si.second.begin(),
+                    si.second.end());
+            array(children, 0);
         }
         else
-            toJSON(node, o, level + 1);
-        if (ni != names.rbegin().base() - 1)
-            o << ",";
-        o << std::endl;
+        {
+            m_out << "{\n";
+            node(impl, 1);
+            m_out << "\n}";
+        }
+        m_out << std::endl;
     }
-    o << indent << "}";
-}
 
-void arrayToJSON(const MetadataNodeList& children, std::ostream& o, int level)
-{
-    const std::string indent(level * 2, ' ');
+private:
+    std::ostream& m_out;
 
-    o << indent << "[" << std::endl;
-    for (auto ci = children.begin(); ci != children.end(); ++ci)
+    void indent(int level)
     {
-        const MetadataNode& m = *ci;
+        static const std::string spaces(64, ' ');
+        for (std::size_t n = level * 2; n; )
+        {
+            std::size_t count = (std::min)(n, spaces.size());
+            m_out.write(spaces.data(), count);
+            n -= count;
+        }
+    }
 
-        arrayEltToJSON(m, o, level + 1);
-        if (ci != children.rbegin().base() - 1)
-            o << ",";
-        o << std::endl;
+    bool quoted(const MetadataNodeImpl& n)
+    {
+        return n.m_type == MetadataNodeImpl::StringType ||
+            n.m_type == MetadataNodeImpl::Base64BinaryType ||
+            n.m_type == MetadataNodeImpl::UuidType;
     }
-    o << indent << "]";
-}
 
-void arrayEltToJSON(const MetadataNode& m, std::ostream& o, int level)
-{
-    std::string indent(level * 2, ' ');
-    std::string value = m.jsonValue();
-    bool children = m.hasChildren();
+    bool hasValue(const MetadataNodeImpl& n)
+        { return quoted(n) || !n.value().empty(); }
 
-    // This is a case from XML.  In JSON, you can't have two values.
-    if (!value.empty() && children)
+    // Quotes not already escaped are escaped.
+    void value(const MetadataNodeImpl& n)
     {
-        o << value << "," << std::endl;
-        subnodesToJSON(m, o, level);
+        const std::string& v = n.value();
+        if (!quoted(n))
+        {
+            m_out << v;
+            return;
+        }
+        m_out << '"';
+        std::size_t start = 0;
+        for (std::size_t i = 0; i < v.size(); ++i)
+            if (v[i] == '"' && (!i || v[i - 1] != '\\'))
+            {
+                m_out.write(v.data() + start, i - start);
+                m_out << '\\';
+                start = i;
+            }
+        m_out.write(v.data() + start, v.size() - start);
+        m_out << '"';
     }
-    else if (!value.empty())
-        o << indent << value;
-    else
-        subnodesToJSON(m, o, level);
-    // There is the case where we have a name and no value to handle.  What
-    // should be done?
-}
 
-void toJSON(const MetadataNode& m, std::ostream& o, int level)
-{
-    std::string indent(level * 2, ' ');
-    std::string name = m.name();
-    std::string value = m.jsonValue();
-    bool children = m.hasChildren();
+    void name(const MetadataNodeImpl& n)
+        { m_out << '"' << (n.m_name.empty() ? "unnamed" : n.m_name) << '"'; }
 
-    if (name.empty())
-        name = "unnamed";
+    void subnodes(const MetadataNodeImpl& parent, int level)
+    {
+        indent(level);
+        m_out << "{\n";
+        for (auto si = parent.m_subnodes.begin();
+            si != parent.m_subnodes.end(); ++si)
+        {
+            const MetadataImplList& children = si->second;
+            const MetadataNodeImpl& n = *children.front();
+            if (n.m_kind == MetadataType::Array)
+            {
+                indent(level);
+                m_out << "  \"" << n.m_name << "\":\n";
+                array(children, level + 1);
+            }
+            else
+                node(n, level + 1);
+            if (std::next(si) != parent.m_subnodes.end())
+                m_out << ",";
+            m_out << "\n";
+        }
+        indent(level);
+        m_out << "}";
+    }
 
-    // This is a case from XML.  In JSON, you can't have two values.
-    if (!value.empty() && children)
+    void array(const MetadataImplList& children, int level)
     {
-        o << indent << "\"" << name << "\": " << value << "," << std::endl;
-        o << indent << "\"" << name << "\": ";
-        subnodesToJSON(m, o, level);
+        indent(level);
+        m_out << "[\n";
+        for (auto ci = children.begin(); ci != children.end(); ++ci)
+        {
+            arrayElt(**ci, level + 1);
+            if (std::next(ci) != children.end())
+                m_out << ",";
+            m_out << "\n";
+        }
+        indent(level);
+        m_out << "]";
     }
-    else if (!value.empty())
-        o << indent << "\"" << name << "\": " << value;
-    else
+
+    // In JSON, you can't have two values, but nodes from XML can have both
+    // a value and children.
+    void arrayElt(const MetadataNodeImpl& n, int level)
     {
-        o << indent << "\"" << name << "\":" << std::endl;
-        subnodesToJSON(m, o, level);
+        bool children = !n.m_subnodes.empty();
+        if (hasValue(n) && children)
+        {
+            value(n);
+            m_out << ",\n";
+            subnodes(n, level);
+        }
+        else if (hasValue(n))
+        {
+            indent(level);
+            value(n);
+        }
+        else
+            subnodes(n, level);
     }
-    // There is the case where we have a name and no value to handle.  What
-    // should be done?
-}
 
+    void node(const MetadataNodeImpl& n, int level)
+    {
+        bool children = !n.m_subnodes.empty();
+        if (hasValue(n) && children)
+        {
+            indent(level);
+            name(n);
+            m_out << ": ";
+            value(n);
+            m_out << ",\n";
+            indent(level);
+            name(n);
+            m_out << ": ";
+            subnodes(n, level);
+        }
+        else if (hasValue(n))
+        {
+            indent(level);
+            name(n);
+            m_out << ": ";
+            value(n);
+        }
+        else
+        {
+            indent(level);
+            name(n);
+            m_out << ":\n";
+            subnodes(n, level);
+        }
+    }
+};
+
+namespace {
 
 void toJSON(const Options& opts, std::ostream& o, int level);
 void toJSON(const Option& opt, std::ostream& o, int level)
@@ -195,18 +271,7 @@ std::string toJSON(const MetadataNode& m)
 
 void toJSON(const MetadataNode& m, std::ostream& o)
 {
-    if (m.name().empty())
-        pdal::subnodesToJSON(m, o, 0);
-    else if (m.kind() == MetadataType::Array)
-        pdal::arrayToJSON(m.children(), o, 0);
-    else
-    {
-        o << "{" << std::endl;
-        pdal::toJSON(m, o, 1);
-        o << std::endl;
-        o << "}";
-    }
-    o << std::endl;
+    MetadataJsonWriter(o).write(m);
 }
 
 std::string toJSON(const Options& opts)
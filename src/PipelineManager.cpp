@@ -34,7 +34,19 @@
 
 #include <pdal/PipelineManager.hpp>
 
+#include <pdal/pdal_config.hpp>
+#include <pdal/Reader.hpp>
 #include <pdal/Utils.hpp>
+#include <pdal/Writer.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include "PipelineScheduler.hpp"
+
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 
 //#include <boost/optional.hpp>
 
@@ -83,11 +95,181 @@ Stage& PipelineManager::addWriter(const std::string& type)
 }
 
 
+void PipelineManager::setMemoryBudget(std::size_t bytes,
+    const std::string& spillDir)
+{
+    if (!m_tablePtr)
+        throw pdal_error("Can't set the memory budget of a point table "
+            "not owned by the pipeline manager.");
+    m_tablePtr->setMemoryBudget(bytes, spillDir);
+}
+
+
+void PipelineManager::shareCallback() const
+{
+    if (m_callback)
+        for (auto const& stage : m_stages)
+            stage->setUserCallback(m_callback);
+}
+
+
+std::vector<Stage *> PipelineManager::endpoints() const
+{
+    std::vector<Stage *> ends;
+    Stage *last = getStage();
+    for (auto const& sp : m_stages)
+    {
+        Stage *stage = sp.get();
+        if (stage != last && !dynamic_cast<Writer *>(stage))
+            continue;
+
+        bool isInput = false;
+        for (auto const& other : m_stages)
+        {
+            const std::vector<Stage *>& inputs = other->getInputs();
+            if (std::find(inputs.begin(), inputs.end(), stage) !=
+                    inputs.end())
+                isInput = true;
+        }
+        if (stage == last || !isInput)
+            ends.push_back(stage);
+    }
+    return ends;
+}
+
+
 void PipelineManager::prepare() const
 {
-    Stage *s = getStage();
-    if (s)
-       s->prepare(m_table);
+    shareCallback();
+
+    std::vector<Stage *> ends = endpoints();
+    if (ends.size() > 1)
+        PipelineScheduler::prepare(ends, m_table);
+    else if (ends.size())
+        ends.front()->prepare(m_table);
+}
+
+
+namespace
+{
+
+const char *cacheMagic = "pdal-result-cache 1";
+
+// The files the readers or the writers of a pipeline name, or nothing if
+// one of them doesn't name a file.
+std::vector<std::string> stageFiles(
+    const std::vector<std::unique_ptr<Stage>>& stages, bool readers)
+{
+    std::vector<std::string> files;
+    for (auto const& sp : stages)
+    {
+        Stage *stage = sp.get();
+        if (readers ? !dynamic_cast<Reader *>(stage) :
+            !dynamic_cast<Writer *>(stage))
+            continue;
+        std::string filename =
+            stage->getOptions().getValueOrDefault<std::string>("filename");
+        if (filename.empty())
+            return std::vector<std::string>();
+        files.push_back(filename);
+    }
+    return files;
+}
+
+} // unnamed namespace
+
+
+// The path of the cache record for the pipeline as it stands, or an empty
+// string if the pipeline can't be cached.  The record is named by a hash of
+// the PDAL version, the serialized pipeline and the names, sizes and times
+// of the input files.
+std::string PipelineManager::cacheRecord() const
+{
+    std::vector<std::string> inputs = stageFiles(m_stages, true);
+    if (inputs.empty() || stageFiles(m_stages, false).empty())
+        return std::string();
+
+    std::ostringstream key;
+    key << GetFullVersionString() << '\n';
+    for (Stage *end : endpoints())
+    {
+        boost::property_tree::ptree tree;
+        tree.add_child("Pipeline", end->serializePipeline());
+        boost::property_tree::write_xml(key, tree);
+    }
+    for (const std::string& filename : inputs)
+    {
+        if (!FileUtils::fileExists(filename))
+            return std::string();
+        key << '\n' << FileUtils::fileSize(filename) << ' ' <<
+            FileUtils::lastWriteTime(filename) << ' ' << filename;
+    }
+
+    std::string s = key.str();
+    std::ostringstream name;
+    name << std::hex << std::setfill('0') << std::setw(16) <<
+        Utils::hash64(s.data(), s.size()) << ".cache";
+    return FileUtils::toAbsolutePath(name.str(), m_cacheDir);
+}
+
+
+// Read the point count from a cache record, returning false if there's no
+// record or a file the recorded run wrote has changed since.
+bool PipelineManager::readCacheRecord(const std::string& record,
+    point_count_t& count)
+{
+    std::ifstream in(record);
+    std::string line;
+    if (!std::getline(in, line) || line != cacheMagic || !(in >> count))
+        return false;
+
+    uintmax_t size;
+    std::time_t time;
+    while (in >> size >> time)
+    {
+        std::string filename;
+        in.get();
+        if (!std::getline(in, filename) || !FileUtils::fileExists(filename) ||
+            FileUtils::fileSize(filename) != size ||
+            FileUtils::lastWriteTime(filename) != time)
+            return false;
+    }
+    return in.eof();
+}
+
+
+// Record the point count of a run along with the size and time of the files
+// it wrote.  Nothing is recorded if a writer didn't leave its file, as one
+// that splits its output wouldn't.
+void PipelineManager::writeCacheRecord(const std::string& record,
+    point_count_t count)
+{
+    std::ostringstream out;
+    out << cacheMagic << '\n' << count << '\n';
+    for (const std::string& filename : stageFiles(m_stages, false))
+    {
+        if (!FileUtils::fileExists(filename))
+            return;
+        out << FileUtils::fileSize(filename) << ' ' <<
+            FileUtils::lastWriteTime(filename) << ' ' << filename << '\n';
+    }
+
+    if (!FileUtils::directoryExists(m_cacheDir) &&
+        !FileUtils::createDirectory(m_cacheDir))
+        throw pdal_error("Unable to create result cache directory '" +
+            m_cacheDir + "'.");
+
+    // Write to the side and rename so that a concurrent run never reads
+    // half a record.
+    std::string temp = record + ".tmp";
+    {
+        std::ofstream f(temp);
+        f << out.str();
+        if (!f)
+            throw pdal_error("Unable to write result cache record '" +
+                record + "'.");
+    }
+    FileUtils::renameFile(record, temp);
 }
 
 
@@ -95,20 +277,62 @@ point_count_t PipelineManager::execute()
 {
     prepare();
 
-    Stage *s = getStage();
-    if (!s)
+    std::vector<Stage *> ends = endpoints();
+    if (ends.empty())
         return 0;
-    m_viewSet = s->execute(m_table);
+
+    m_cacheHit = false;
+    std::string record;
+    if (m_cacheDir.size())
+    {
+        record = cacheRecord();
+        point_count_t cnt;
+        if (record.size() && readCacheRecord(record, cnt))
+        {
+            m_viewSet.clear();
+            m_cacheHit = true;
+            return cnt;
+        }
+    }
+    if (ends.size() > 1)
+    {
+        // Each writer gets a thread of its own if the table allows it.
+        std::size_t concurrency = m_table.appendSafe() ?
+            (std::max)(m_concurrency, ends.size()) : 1;
+        m_viewSet = PipelineScheduler(concurrency).execute(ends, m_table);
+    }
+    else if (m_concurrency > 1 && m_table.appendSafe())
+        m_viewSet = PipelineScheduler(m_concurrency).execute(*ends.front(),
+            m_table);
+    else
+        m_viewSet = ends.front()->execute(m_table);
     point_count_t cnt = 0;
     for (auto pi = m_viewSet.begin(); pi != m_viewSet.end(); ++pi)
     {
         PointViewPtr view = *pi;
         cnt += view->size();
     }
+    if (record.size())
+        writeCacheRecord(record, cnt);
     return cnt;
 }
 
 
+point_count_t PipelineManager::executeStream(FixedPointTable& table)
+{
+    Stage *s = getStage();
+    if (!s)
+        return 0;
+    if (endpoints().size() > 1)
+        throw pdal_error("Pipelines with more than one writer can't be "
+            "streamed.");
+    shareCallback();
+    s->prepare(table);
+    m_viewSet.clear();
+    return s->executeStream(table);
+}
+
+
 MetadataNode PipelineManager::getMetadata() const
 {
     MetadataNode output("stages");
@@ -383,10 +383,14 @@ void PipelineReader::collect_attributes(map_t& attrs, const ptree& tree)
 }
 
 
-Stage *PipelineReader::parseElement_Writer(const ptree& tree)
+// Parse a <Writer>.  If 'input' is given, the writer's input is that stage
+// and the element has no child stages.
+Stage *PipelineReader::parseElement_Writer(const ptree& tree, Stage *input)
 {
     Options options(m_baseOptions);
     StageParserContext context;
+    if (input)
+        context.setCardinality(StageParserContext::None);
 
     map_t attrs;
     collect_attributes(attrs, tree);
@@ -430,6 +434,8 @@ Stage *PipelineReader::parseElement_Writer(const ptree& tree)
 
     context.validate();
     Stage& writer(m_manager.addWriter(type));
+    if (input)
+        writer.setInput(*input);
     for (auto sp : prevStages)
         writer.setInput(*sp);
     writer.setOptions(options);
@@ -437,6 +443,47 @@ Stage *PipelineReader::parseElement_Writer(const ptree& tree)
 }
 
 
+// Parse a <Writers> element: a single reader or filter whose points are
+// written by each of the <Writer> elements beside it, which have no child
+// stages of their own.  The input is read and filtered once.
+void PipelineReader::parseElement_Writers(const ptree& tree)
+{
+    Stage *input = NULL;
+    for (auto iter = tree.begin(); iter != tree.end(); ++iter)
+    {
+        const std::string& name = iter->first;
+        if (name == "Filter" || name == "Reader")
+        {
+            if (input)
+                throw pipeline_xml_error("extra child stages found in "
+                    "Writers element");
+            input = parseElement_anystage(name, iter->second);
+        }
+    }
+    if (!input)
+        throw pipeline_xml_error("expected child stage missing in Writers "
+            "element");
+
+    int numWriters = 0;
+    for (auto iter = tree.begin(); iter != tree.end(); ++iter)
+    {
+        const std::string& name = iter->first;
+        if (name == "Writer")
+        {
+            parseElement_Writer(iter->second, input);
+            numWriters++;
+        }
+        else if (name != "Filter" && name != "Reader" &&
+            name != "<xmlattr>")
+            throw pipeline_xml_error("unknown child of Writers element: " +
+                name);
+    }
+    if (numWriters == 0)
+        throw pipeline_xml_error("expected Writer element missing in "
+            "Writers element");
+}
+
+
 bool PipelineReader::parseElement_Pipeline(const ptree& tree)
 {
     Stage *stage = NULL;
@@ -467,6 +514,12 @@ bool PipelineReader::parseElement_Pipeline(const ptree& tree)
             writer = parseElement_Writer(subtree);
             isWriter = true;
         }
+        else if (name == "Writers")
+        {
+            parseElement_Writers(subtree);
+            writer = m_manager.getStage();
+            isWriter = true;
+        }
         else if (name == "<xmlattr>")
         {
             // ignore it, already parsed
@@ -0,0 +1,186 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include "PipelineScheduler.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace pdal
+{
+
+void PipelineScheduler::prepare(const std::vector<Stage *>& endpoints,
+    PointTableRef table)
+{
+    std::set<Stage *> prepared;
+    for (Stage *stage : endpoints)
+        prepareStage(stage, table, prepared);
+}
+
+
+void PipelineScheduler::prepareStage(Stage *stage, PointTableRef table,
+    std::set<Stage *>& prepared)
+{
+    if (!prepared.insert(stage).second)
+        return;
+    for (Stage *input : stage->getInputs())
+        prepareStage(input, table, prepared);
+    stage->prepareStage(table);
+}
+
+
+PointViewSet PipelineScheduler::execute(Stage& endpoint, PointTableRef table)
+{
+    return execute(std::vector<Stage *>(1, &endpoint), table);
+}
+
+
+PointViewSet PipelineScheduler::execute(const std::vector<Stage *>& endpoints,
+    PointTableRef table)
+{
+    table.layout()->finalize();
+
+    std::vector<Node *> ends;
+    for (Stage *stage : endpoints)
+        ends.push_back(addNode(stage, table));
+    m_remaining = m_nodes.size();
+
+    // This thread is one of the workers.
+    std::size_t numThreads = std::min(m_concurrency, m_nodes.size());
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < numThreads; ++i)
+        threads.push_back(std::thread([this, &table](){ work(table); }));
+    work(table);
+    for (auto& t : threads)
+        t.join();
+
+    if (m_error)
+        std::rethrow_exception(m_error);
+    PointViewSet views;
+    for (Node *end : ends)
+        views.insert(end->m_views.begin(), end->m_views.end());
+    return views;
+}
+
+
+// Add the node for a stage and those of the stages that feed it.  Readers'
+// views are made here, in the order in which Stage::execute() would make
+// them, so that the views of a merge come out in the same order.
+PipelineScheduler::Node *PipelineScheduler::addNode(Stage *stage,
+    PointTableRef table)
+{
+    auto it = m_nodes.find(stage);
+    if (it != m_nodes.end())
+        return &it->second;
+
+    Node& node = m_nodes[stage];
+    node.m_stage = stage;
+    for (Stage *input : stage->getInputs())
+    {
+        Node *in = addNode(input, table);
+        in->m_outputs.push_back(&node);
+        node.m_waiting++;
+    }
+    if (node.m_waiting == 0)
+    {
+        node.m_views.insert(PointViewPtr(new PointView(table)));
+        m_ready.push_back(&node);
+    }
+    return &node;
+}
+
+
+void PipelineScheduler::work(PointTableRef table)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_cv.wait(lock,
+            [this](){ return m_error || !m_remaining || !m_ready.empty(); });
+        if (m_error || !m_remaining)
+            return;
+
+        Node *node = m_ready.front();
+        m_ready.pop_front();
+        try
+        {
+            runNode(node, table, lock);
+        }
+        catch (...)
+        {
+            if (!lock.owns_lock())
+                lock.lock();
+            if (!m_error)
+                m_error = std::current_exception();
+            m_cv.notify_all();
+            return;
+        }
+
+        m_remaining--;
+        for (Node *out : node->m_outputs)
+            if (--out->m_waiting == 0)
+                m_ready.push_back(out);
+        m_cv.notify_all();
+    }
+}
+
+
+// Run a stage on the views of its inputs.  Called with the lock held, which
+// is released while the stage processes points.
+void PipelineScheduler::runNode(Node *node, PointTableRef table,
+    std::unique_lock<std::mutex>& lock)
+{
+    Stage *stage = node->m_stage;
+    PointViewSet views;
+    if (stage->getInputs().empty())
+        views.swap(node->m_views);
+    for (Stage *input : stage->getInputs())
+    {
+        Node& in = m_nodes[input];
+        views.insert(in.m_views.begin(), in.m_views.end());
+        // Nothing else needs the input's views.
+        if (in.m_outputs.size() == 1)
+            in.m_views.clear();
+    }
+
+    stage->startRun(table);
+    lock.unlock();
+    PointViewSet outViews = stage->runViews(table, views);
+    lock.lock();
+    stage->finishRun(table);
+    node->m_views.swap(outViews);
+}
+
+} // namespace pdal
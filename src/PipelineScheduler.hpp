@@ -0,0 +1,106 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <pdal/Stage.hpp>
+
+namespace pdal
+{
+
+// Executes the pipeline ending at a stage by running each stage once all
+// of its inputs have run, rather than recursively as Stage::execute() does.
+// Up to a fixed number of stages whose inputs are ready run at once, so
+// independent branches (the readers feeding a merge, say) overlap.  The
+// table must be appendSafe() unless the concurrency is one.
+//
+// A pipeline may have several endpoints, such as writers that share an
+// input.  Each stage runs once however many stages take its views.
+class PipelineScheduler
+{
+public:
+    PipelineScheduler(std::size_t concurrency) : m_concurrency(concurrency),
+        m_remaining(0)
+    {}
+
+    // Prepare each stage of the pipelines ending at 'endpoints' once,
+    // after its inputs.
+    static void prepare(const std::vector<Stage *>& endpoints,
+        PointTableRef table);
+    PointViewSet execute(Stage& endpoint, PointTableRef table);
+    // Returns the views of all the endpoints.
+    PointViewSet execute(const std::vector<Stage *>& endpoints,
+        PointTableRef table);
+
+private:
+    struct Node
+    {
+        Node() : m_stage(NULL), m_waiting(0)
+        {}
+
+        Stage *m_stage;
+        // Number of inputs that haven't run.
+        std::size_t m_waiting;
+        std::vector<Node *> m_outputs;
+        PointViewSet m_views;
+    };
+
+    std::size_t m_concurrency;
+    std::map<Stage *, Node> m_nodes;
+    std::deque<Node *> m_ready;
+    std::size_t m_remaining;
+    std::exception_ptr m_error;
+    // Guards the scheduling state.  Stages' ready() and done() are also
+    // called with it held, since they may change the table's metadata.
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+
+    static void prepareStage(Stage *stage, PointTableRef table,
+        std::set<Stage *>& prepared);
+    Node *addNode(Stage *stage, PointTableRef table);
+    void work(PointTableRef table);
+    void runNode(Node *node, PointTableRef table,
+        std::unique_lock<std::mutex>& lock);
+};
+
+} // namespace pdal
@@ -131,11 +131,43 @@ void PipelineWriter::writeMetadata(boost::property_tree::ptree& tree,
 }
 
 
+// Several writers of one input are written as a <Writers> element holding
+// the shared input and a <Writer>, without child stages, for each writer.
+static ptree generateTreeFromWriters(const std::vector<Stage *>& writers)
+{
+    const Stage *input = NULL;
+    ptree writersTree;
+    for (Stage *w : writers)
+    {
+        if (w->getInputs().size() != 1 ||
+            (input && w->getInputs()[0] != input))
+            throw pdal_error("Can't write a pipeline whose writers don't "
+                "share a single input.");
+        input = w->getInputs()[0];
+
+        ptree writerTree;
+        writerTree.add("<xmlattr>.type", w->getName());
+        PipelineWriter::write_option_ptree(writerTree, w->getOptions());
+        writersTree.add_child("Writer", writerTree);
+    }
+    ptree subtree = input->serializePipeline();
+    writersTree.add_child(subtree.begin()->first, subtree.begin()->second);
+
+    ptree tree;
+    ptree& attrtree = tree.add_child("Pipeline", ptree());
+    attrtree.put("<xmlattr>.version", "1.0");
+    attrtree.add_child("Writers", writersTree);
+    return tree;
+}
+
+
 void PipelineWriter::writePipeline(const std::string& filename) const
 {
-    Stage *stage = m_manager.getStage();
+    std::vector<Stage *> endpoints = m_manager.endpoints();
 
-    ptree tree = generateTreeFromStage(*stage);
+    ptree tree = (endpoints.size() > 1) ?
+        generateTreeFromWriters(endpoints) :
+        generateTreeFromStage(*m_manager.getStage());
 #if BOOST_VERSION >= 105600
     const xml_parser::xml_writer_settings<std::string> settings(' ', 4);
 #else
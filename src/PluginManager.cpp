@@ -41,12 +41,14 @@
 
 #include <boost/filesystem.hpp>
 
+#include <pdal/ConnectionPool.hpp>
 #include <pdal/pdal_defines.h>
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/Utils.hpp>
 
 #include "DynamicLibrary.h"
 
+#include <chrono>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -98,6 +100,22 @@ PluginManager& PluginManager::getInstance()
 
 int32_t PluginManager::loadAll(PF_PluginType type)
 {
+    for (const auto& path : pluginPaths())
+        loadByPath(path, type);
+    return 0;
+}
+
+
+// Find the libraries in the directories of PDAL_DRIVER_PATH, or the
+// default plugin directories if it isn't set.
+const std::vector<std::string>& PluginManager::pluginPaths()
+{
+    if (m_scanned)
+        return m_pluginPaths;
+    m_scanned = true;
+
+    auto start = std::chrono::steady_clock::now();
+
     std::string driver_path("PDAL_DRIVER_PATH");
     std::string pluginDir = Utils::getenv(driver_path);
 
@@ -114,9 +132,33 @@ int32_t PluginManager::loadAll(PF_PluginType type)
     pluginPathVec = Utils::split2(pluginDir, ':');
 
     for (const auto& pluginPath : pluginPathVec)
-        loadAll(pluginPath, type);
+    {
+        if (pluginPath.empty() || !FileUtils::fileExists(pluginPath) ||
+            !boost::filesystem::is_directory(pluginPath))
+            continue;
 
-    return 0;
+        boost::filesystem::directory_iterator dir(pluginPath), it, end;
+        for (it = dir; it != end; ++it)
+        {
+            boost::filesystem::path full_path = it->path();
+
+            if (boost::filesystem::is_directory(full_path))
+                continue;
+
+            std::string ext = full_path.extension().string();
+            if (ext != dynamicLibraryExtension)
+                continue;
+
+            std::string name = Utils::tolower(full_path.filename().string());
+            if (Utils::startsWith(name, "libpdal_plugin_"))
+                m_pluginPaths.push_back(full_path.string());
+        }
+    }
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    m_loadTime += elapsed.count();
+    return m_pluginPaths;
 }
 
 
@@ -164,7 +206,8 @@ int32_t PluginManager::initializePlugin(PF_InitFunc initFunc)
 }
 
 
-PluginManager::PluginManager() : m_inInitializePlugin(false)
+PluginManager::PluginManager() : m_inInitializePlugin(false),
+    m_scanned(false), m_loadTime(0.0)
 {
     m_version.major = 1;
     m_version.minor = 0;
@@ -179,6 +222,10 @@ PluginManager::~PluginManager()
 
 int32_t PluginManager::shutdown()
 {
+    // Pooled connections are closed by the plugins that made them, so they
+    // must go before the plugins are unloaded.
+    ConnectionPool::shared().clear();
+
     int32_t result = 0;
     for (auto const& func : m_exitFuncVec)
     {
@@ -202,65 +249,50 @@ int32_t PluginManager::shutdown()
 
 int32_t PluginManager::guessLoadByPath(const std::string& driverName)
 {
-    // parse the driver name into an expected pluginName, e.g.,
-    // writers.las => libpdal_plugin_writer_las
+    // parse the driver name into an expected plugin name, e.g.,
+    // readers.greyhound => libpdal_plugin_reader_greyhound
 
     std::vector<std::string> driverNameVec;
     driverNameVec = Utils::split2(driverName, '.');
+    if (driverNameVec.size() < 2)
+        return -1;
 
-    std::string pluginName = "libpdal_plugin_" + driverNameVec[0] + "_" +
-        driverNameVec[1];
-
-    std::string driver_path("PDAL_DRIVER_PATH");
-    std::string pluginDir = Utils::getenv(driver_path);
-
-    // Default path below if not set.
-    if (pluginDir.size() == 0)
+    PF_PluginType type;
+    std::string typeName;
+    if (driverNameVec[0] == "kernels")
     {
-        std::ostringstream oss;
-        oss << PDAL_PLUGIN_INSTALL_PATH <<
-            ":/usr/local/lib:./lib:../lib:../bin";
-        pluginDir = oss.str();
+        type = PF_PluginType_Kernel;
+        typeName = "kernel";
     }
-
-    std::vector<std::string> pluginPathVec = Utils::split2(pluginDir, ':');
-    for (const auto& pluginPath : pluginPathVec)
+    else if (driverNameVec[0] == "filters")
     {
-        boost::filesystem::path path(pluginPath);
-
-        if (!FileUtils::fileExists(path.string()) ||
-            !boost::filesystem::is_directory(path))
-            continue;
-
-        boost::filesystem::directory_iterator dir(path), it, end;
-        // Looks like directory_iterator doesn't support range-based for loop in
-        // Boost v1.55. It fails Travis anyway, so I reverted it.
-        for (it = dir; it != end; ++it)
-        {
-            boost::filesystem::path full_path = it->path();
-            
-            if (boost::filesystem::is_directory(full_path))
-                continue;
-
-            std::string ext = full_path.extension().string();
-            if (ext != dynamicLibraryExtension)
-                continue;
+        type = PF_PluginType_Filter;
+        typeName = "filter";
+    }
+    else if (driverNameVec[0] == "writers")
+    {
+        type = PF_PluginType_Writer;
+        typeName = "writer";
+    }
+    else
+    {
+        type = PF_PluginType_Reader;
+        typeName = "reader";
+    }
+    std::string pluginName = "libpdal_plugin_" + typeName + "_" +
+        Utils::tolower(driverNameVec[1]);
 
-            PF_PluginType type;
-            if (driverNameVec[0] == "readers")
-                type = PF_PluginType_Reader;
-            else if (driverNameVec[0] == "kernels")
-                type = PF_PluginType_Kernel;
-            else if (driverNameVec[0] == "filters")
-                type = PF_PluginType_Filter;
-            else if (driverNameVec[0] == "writers")
-                type = PF_PluginType_Writer;
-            else
-                type = PF_PluginType_Reader;
-
-            loadByPath(full_path.string(), type);
-        }
-   }
+    // Load only the library named for the driver if there is one.  Some
+    // libraries provide drivers with other names, so failing that load
+    // every library of the driver's type.
+    for (const auto& path : pluginPaths())
+    {
+        boost::filesystem::path p(path);
+        if (Utils::tolower(p.stem().string()) == pluginName)
+            loadByPath(path, type);
+    }
+    if (m_exactMatchMap.find(driverName) == m_exactMatchMap.end())
+        loadAll(type);
     return 0;
 }
 
@@ -303,20 +335,24 @@ int32_t PluginManager::loadByPath(const std::string& pluginPath,
     if (!isValid)
         return -1;
 
-    if (m_dynamicLibraryMap.find(path.string()) != m_dynamicLibraryMap.end())
+    std::string fullPath = boost::filesystem::complete(path).string();
+    if (m_dynamicLibraryMap.find(fullPath) != m_dynamicLibraryMap.end())
         return -1;
 
+    auto start = std::chrono::steady_clock::now();
     std::string errorString;
-    DynamicLibrary *d =
-        loadLibrary(boost::filesystem::complete(path).string(), errorString);
-    if (!d)
-        return -1;
+    DynamicLibrary *d = loadLibrary(fullPath, errorString);
 
-    PF_InitFunc initFunc = (PF_InitFunc)(d->getSymbol("PF_initPlugin"));
-    if (!initFunc)
-        return -1;
+    int32_t result = -1;
+    PF_InitFunc initFunc =
+        d ? (PF_InitFunc)(d->getSymbol("PF_initPlugin")) : NULL;
+    if (initFunc)
+        result = std::max(0, initializePlugin(initFunc));
 
-    return std::max(0, initializePlugin(initFunc));
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    m_loadTime += elapsed.count();
+    return result;
 }
 
 void *PluginManager::createObject(const std::string& objectType)
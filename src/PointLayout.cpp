@@ -35,13 +35,28 @@
 #include <pdal/PointLayout.hpp>
 #include <pdal/Utils.hpp>
 
+#include <algorithm>
+
 namespace pdal
 {
 
+namespace
+{
+
+void removeId(Dimension::IdList& ids, Dimension::Id::Enum id)
+{
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+}
+
+} // unnamed namespace
+
 PointLayout::PointLayout()
     : m_detail(Dimension::COUNT)
     , m_used()
     , m_propIds()
+    , m_propNames()
+    , m_computeFuncs()
+    , m_dependents()
     , m_nextFree(Dimension::PROPRIETARY)
     , m_pointSize(0)
     , m_finalized(false)
@@ -78,11 +93,58 @@ void PointLayout::registerDim(Dimension::Id::Enum id)
 
 void PointLayout::registerDim(Dimension::Id::Enum id, Dimension::Type::Enum type)
 {
-    Dimension::Detail dd = m_detail[id];
+    Dimension::Detail dd = storedDetail(id);
+    if (dd.scaled())
+    {
+        // Someone wants the values unscaled, so give up on scaling rather
+        // than lose precision.
+        dd.setXForm(XForm());
+        type = resolveType(type, Dimension::Type::Double);
+    }
     dd.setType(resolveType(type, dd.type()));
     update(dd, Dimension::name(id));
 }
 
+void PointLayout::registerScaledDim(Dimension::Id::Enum id,
+    Dimension::Type::Enum type, const XForm& xform)
+{
+    Dimension::Detail dd = storedDetail(id);
+    if (dd.type() == Dimension::Type::None)
+    {
+        dd.setType(type);
+        dd.setXForm(xform);
+    }
+    else if (!dd.scaled() || dd.type() != type ||
+        dd.xform().m_scale != xform.m_scale ||
+        dd.xform().m_offset != xform.m_offset)
+    {
+        dd.setXForm(XForm());
+        dd.setType(resolveType(Dimension::Type::Double, dd.type()));
+    }
+    update(dd, Dimension::name(id));
+}
+
+void PointLayout::registerPackedDim(Dimension::Id::Enum id, int bits)
+{
+    if (bits < 1 || bits > 8)
+        throw pdal_error("Packed dimension '" + dimName(id) + "' must "
+            "have from 1 to 8 bits.");
+
+    Dimension::Detail dd = storedDetail(id);
+    if (dd.type() == Dimension::Type::None)
+    {
+        dd.setType(Dimension::Type::Unsigned8);
+        dd.setPacking(bits, 0);
+    }
+    else if (dd.packed())
+        dd.setPacking((std::max)(bits, dd.bits()), 0);
+    else
+        // Someone registered the dimension unpacked and may set values
+        // that wouldn't fit.
+        dd.setType(resolveType(Dimension::Type::Unsigned8, dd.type()));
+    update(dd, Dimension::name(id));
+}
+
 Dimension::Id::Enum PointLayout::assignDim(const std::string& name,
     Dimension::Type::Enum type)
 {
@@ -91,7 +153,7 @@ Dimension::Id::Enum PointLayout::assignDim(const std::string& name,
     auto di = m_propIds.find(name);
     if (di != m_propIds.end())
         id = di->second;
-    Dimension::Detail dd = m_detail[id];
+    Dimension::Detail dd = storedDetail(id);
     dd.setType(resolveType(type, dd.type()));
     if (update(dd, name))
     {
@@ -99,13 +161,14 @@ Dimension::Id::Enum PointLayout::assignDim(const std::string& name,
         {
             m_nextFree++;
             m_propIds[name] = id;
+            m_propNames.push_back(name);
         }
         return id;
     }
     return Dimension::Id::Unknown;
 }
 
-Dimension::Id::Enum PointLayout::registerOrAssignDim(const std::string name,
+Dimension::Id::Enum PointLayout::registerOrAssignDim(const std::string& name,
    Dimension::Type::Enum type)
 {
     Dimension::Id::Enum id = Dimension::id(name);
@@ -117,6 +180,108 @@ Dimension::Id::Enum PointLayout::registerOrAssignDim(const std::string name,
     return assignDim(name, type);
 }
 
+void PointLayout::registerComputedDim(Dimension::Id::Enum id,
+    const Dimension::IdList& deps, ComputeFunc func)
+{
+    if (!func)
+        throw pdal_error("No function provided for computed dimension '" +
+            dimName(id) + "'.");
+
+    // Values someone is going to store win over computed ones.
+    Dimension::Detail dd = m_detail[id];
+    if (hasDim(id) && !dd.computed())
+        return;
+
+    dd.setType(Dimension::Type::Double);
+    dd.setXForm(XForm());
+    dd.setPacking(0, 0);
+    dd.setComputed(true);
+    update(dd, dimName(id));
+    updateComputed(dd, deps, func);
+}
+
+Dimension::Id::Enum PointLayout::assignComputedDim(const std::string& name,
+    const Dimension::IdList& deps, ComputeFunc func)
+{
+    Dimension::Id::Enum id = findProprietaryDim(name);
+    if (id != Dimension::Id::Unknown)
+    {
+        registerComputedDim(id, deps, func);
+        return id;
+    }
+    if (!func)
+        throw pdal_error("No function provided for computed dimension '" +
+            name + "'.");
+
+    id = (Dimension::Id::Enum)m_nextFree;
+    Dimension::Detail dd = m_detail[id];
+    dd.setType(Dimension::Type::Double);
+    dd.setComputed(true);
+    update(dd, name);
+    m_nextFree++;
+    m_propIds[name] = id;
+    m_propNames.push_back(name);
+    updateComputed(dd, deps, func);
+    return id;
+}
+
+const PointLayout::ComputeFunc& PointLayout::computeFunc(
+    Dimension::Id::Enum id) const
+{
+    auto fi = m_computeFuncs.find(id);
+    if (fi == m_computeFuncs.end())
+        throw pdal_error("Dimension '" + dimName(id) + "' isn't computed.");
+    return fi->second;
+}
+
+const Dimension::IdList& PointLayout::dependents(Dimension::Id::Enum id) const
+{
+    static const Dimension::IdList none;
+
+    auto di = m_dependents.find(id);
+    return (di != m_dependents.end() ? di->second : none);
+}
+
+void PointLayout::updateComputed(const Dimension::Detail& dd,
+    const Dimension::IdList& deps, ComputeFunc func)
+{
+    Dimension::Id::Enum id = dd.id();
+
+    m_computeFuncs[id] = func;
+    for (auto& dep : m_dependents)
+        removeId(dep.second, id);
+    for (auto dep : deps)
+    {
+        if (dep == id)
+            throw pdal_error("Computed dimension '" + dimName(id) +
+                "' can't depend on itself.");
+        Dimension::IdList& list = m_dependents[dep];
+        if (!Utils::contains(list, id))
+            list.push_back(id);
+
+        // Changing what a computed dependency depends on changes this
+        // dimension too.
+        if (m_detail[dep].computed())
+            for (auto& other : m_dependents)
+                if (Utils::contains(other.second, dep) &&
+                        !Utils::contains(other.second, id))
+                    other.second.push_back(id);
+    }
+}
+
+Dimension::Detail PointLayout::storedDetail(Dimension::Id::Enum id) const
+{
+    // A computed dimension that gets registered normally starts over as
+    // a stored one.
+    Dimension::Detail dd = m_detail[id];
+    if (dd.computed())
+    {
+        dd = Dimension::Detail();
+        dd.setId(id);
+    }
+    return dd;
+}
+
 DimTypeList PointLayout::dimTypes() const
 {
     DimTypeList dimTypes;
@@ -153,10 +318,9 @@ std::string PointLayout::dimName(Dimension::Id::Enum id) const
     std::string name = Dimension::name(id);
     if (!name.empty())
         return name;
-    for (auto pi = m_propIds.begin();
-            pi != m_propIds.end(); ++pi)
-        if (pi->second == id)
-            return pi->first;
+    size_t prop = (size_t)id - Dimension::PROPRIETARY;
+    if (id >= Dimension::PROPRIETARY && prop < m_propNames.size())
+        return m_propNames[prop];
     return "";
 }
 
@@ -172,12 +336,13 @@ const Dimension::IdList& PointLayout::dims() const
 
 Dimension::Type::Enum PointLayout::dimType(Dimension::Id::Enum id) const
 {
-    return dimDetail(id)->type();
+    const Dimension::Detail *dd = dimDetail(id);
+    return dd->scaled() ? Dimension::Type::Double : dd->type();
 }
 
 size_t PointLayout::dimSize(Dimension::Id::Enum id) const
 {
-    return dimDetail(id)->size();
+    return Dimension::size(dimType(id));
 }
 
 size_t PointLayout::dimOffset(Dimension::Id::Enum id) const
@@ -202,6 +367,11 @@ bool PointLayout::update(Dimension::Detail dd, const std::string& name)
         throw pdal_error("Can't update layout after points have been added.");
     }
 
+    // Only unscaled bytes are packed.
+    if (dd.packed() &&
+        (dd.type() != Dimension::Type::Unsigned8 || dd.scaled()))
+        dd.setPacking(0, 0);
+
     Dimension::DetailList detail;
 
     bool used = Utils::contains(m_used, dd.id());
@@ -234,11 +404,40 @@ bool PointLayout::update(Dimension::Detail dd, const std::string& name)
 
         int offset = 0;
         std::sort(detail.begin(), detail.end(), sorter);
-        for (auto& d : detail)
+
+        // Computed dimensions take no space.
+        auto computed = std::stable_partition(detail.begin(), detail.end(),
+            [](const Dimension::Detail& d){ return !d.computed(); });
+        for (auto di = computed; di != detail.end(); ++di)
+            di->setOffset(-1);
+
+        auto packed = std::stable_partition(detail.begin(), computed,
+            [](const Dimension::Detail& d){ return !d.packed(); });
+        for (auto di = detail.begin(); di != packed; ++di)
         {
-            d.setOffset(offset);
-            offset += (int)d.size();
+            di->setOffset(offset);
+            offset += (int)di->size();
         }
+
+        // Packed dimensions fill the bytes that follow, widest first, each
+        // going in the first byte with room for it.
+        std::stable_sort(packed, computed,
+            [](const Dimension::Detail& d1, const Dimension::Detail& d2)
+            { return d1.bits() > d2.bits(); });
+        std::vector<int> bitsUsed;
+        for (auto di = packed; di != computed; ++di)
+        {
+            size_t byte = 0;
+            while (byte < bitsUsed.size() &&
+                    bitsUsed[byte] + di->bits() > 8)
+                byte++;
+            if (byte == bitsUsed.size())
+                bitsUsed.push_back(0);
+            di->setOffset(offset + (int)byte);
+            di->setPacking(di->bits(), bitsUsed[byte]);
+            bitsUsed[byte] += di->bits();
+        }
+        offset += (int)bitsUsed.size();
         //NOTE - I tried forcing all points to be aligned on 8-byte boundaries
         // in case this would matter to the optimized memcpy, but it made
         // no difference.  No sense wasting space for no difference.
@@ -251,6 +450,10 @@ bool PointLayout::update(Dimension::Detail dd, const std::string& name)
     for (auto& dtemp : detail)
         m_detail[dtemp.id()] = dtemp;
 
+    if (!dd.computed() && m_computeFuncs.erase(dd.id()))
+        for (auto& dep : m_dependents)
+            removeId(dep.second, dd.id());
+
     return true;
 }
 
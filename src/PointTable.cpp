@@ -33,6 +33,19 @@
 ****************************************************************************/
 
 #include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/portable_endian.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace pdal
 {
@@ -46,6 +59,140 @@ SpatialReference BasePointTable::spatialRef() const
 }
 
 
+namespace
+{
+
+// A packed dimension is a few bits of the byte at 'pos'.
+void getPacked(const Dimension::Detail *d, const char *pos, void *value)
+{
+    *(uint8_t *)value = ((uint8_t)*pos >> d->shift()) & d->mask();
+}
+
+// Set the bits of a packed dimension, leaving those of the dimensions it
+// shares the byte with.
+void setPacked(const PointLayout& layout, const Dimension::Detail *d,
+    char *pos, const void *value)
+{
+    uint8_t v = *(const uint8_t *)value;
+    if (v > d->mask())
+    {
+        std::ostringstream oss;
+        oss << "Value " << (int)v << " of dimension '" <<
+            layout.dimName(d->id()) << "' doesn't fit in its " <<
+            d->bits() << " packed bits.";
+        throw pdal_error(oss.str());
+    }
+    uint8_t bits = (uint8_t)(d->mask() << d->shift());
+    *pos = (char)(((uint8_t)*pos & ~bits) | (uint8_t)(v << d->shift()));
+}
+
+} // unnamed namespace
+
+
+// Tables hand out the IDs of added points in order, so points added one at
+// a time make up a range.
+PointId BasePointTable::reserveRange(point_count_t count)
+{
+    if (count == 0)
+        return 0;
+    PointId first = addPoint();
+    for (point_count_t i = 1; i < count; ++i)
+        addPoint();
+    return first;
+}
+
+
+void BasePointTable::copyField(const Dimension::Detail *from,
+    const Dimension::Detail *to, PointId idx, point_count_t count)
+{
+    char buf[sizeof(double)];
+    for (PointId i = idx; i < idx + count; ++i)
+    {
+        getField(from, i, buf);
+        setField(to, i, buf);
+    }
+}
+
+
+// Tables that can't get at the stored bytes rebuild the dimension's bits.
+void BasePointTable::getPackedBytes(const Dimension::Detail *d, PointId idx,
+    point_count_t count, uint8_t *out)
+{
+    for (PointId i = idx; i < idx + count; ++i)
+    {
+        uint8_t v;
+        getField(d, i, &v);
+        *out++ = (uint8_t)(v << d->shift());
+    }
+}
+
+
+bool BasePointTable::getComputed(Dimension::Id::Enum id, PointId idx,
+    double& value)
+{
+    if (!hasComputed())
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_computedMutex);
+    auto bi = m_computed.find(computedKey(id, idx));
+    if (bi == m_computed.end())
+        return false;
+    const ComputedBlock& block = bi->second;
+    std::size_t pos = idx % ComputedBlockPtCnt;
+    if (!block.m_valid[pos])
+        return false;
+    value = block.m_values[pos];
+    return true;
+}
+
+
+void BasePointTable::setComputed(Dimension::Id::Enum id, const PointId *ids,
+    const double *values, point_count_t count)
+{
+    std::lock_guard<std::mutex> lock(m_computedMutex);
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        ComputedBlock& block = m_computed[computedKey(id, ids[i])];
+        if (block.m_values.empty())
+        {
+            block.m_values.resize(ComputedBlockPtCnt);
+            block.m_valid.resize(ComputedBlockPtCnt);
+        }
+        std::size_t pos = ids[i] % ComputedBlockPtCnt;
+        block.m_values[pos] = values[i];
+        block.m_valid[pos] = 1;
+    }
+    m_hasComputed = true;
+}
+
+
+void BasePointTable::clearDependents(Dimension::Id::Enum id, PointId idx)
+{
+    const Dimension::IdList& deps = layout()->dependents(id);
+    if (deps.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_computedMutex);
+    for (auto dep : deps)
+    {
+        auto bi = m_computed.find(computedKey(dep, idx));
+        if (bi != m_computed.end())
+            bi->second.m_valid[idx % ComputedBlockPtCnt] = 0;
+    }
+}
+
+
+void BasePointTable::clearComputed()
+{
+    if (!hasComputed())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_computedMutex);
+    m_computed.clear();
+    m_hasComputed = false;
+}
+
+
 void BasePointTable::setSpatialRef(const SpatialReference& sref)
 {
     MetadataNode mp = m_metadata->m_private;
@@ -53,40 +200,1101 @@ void BasePointTable::setSpatialRef(const SpatialReference& sref)
 }
 
 
+namespace
+{
+
+int seek64(std::FILE *f, int64_t pos)
+{
+#ifdef _WIN32
+    return _fseeki64(f, pos, SEEK_SET);
+#else
+    return fseeko(f, pos, SEEK_SET);
+#endif
+}
+
+} // unnamed namespace
+
+
 PointTable::~PointTable()
 {
-    for (auto vi = m_blocks.begin(); vi != m_blocks.end(); ++vi)
-        delete [] *vi;
+    for (auto si = m_slabs.begin(); si != m_slabs.end(); ++si)
+        m_allocator->deallocate(si->first, si->second);
+    if (m_spillFile)
+        std::fclose(m_spillFile);
 }
 
+
+void PointTable::setBlockSize(point_count_t blockPtCnt)
+{
+    if (m_blocks.size())
+        throw pdal_error("Can't change the block size of a point table "
+            "once storage has been allocated.");
+    if (blockPtCnt == 0)
+        throw pdal_error("Point table block size must be positive.");
+    m_blockPtCnt = blockPtCnt;
+}
+
+
+void PointTable::setMemoryBudget(std::size_t bytes,
+    const std::string& spillDir)
+{
+    if (m_blocks.size())
+        throw pdal_error("Can't set the memory budget of a point table "
+            "once storage has been allocated.");
+    m_memoryBudget = bytes;
+    m_spillDir = spillDir;
+}
+
+
+void PointTable::reserve(point_count_t count)
+{
+    std::lock_guard<std::mutex> lock(m_addMutex);
+    std::size_t blocks = (m_numPts + count + m_blockPtCnt - 1) / m_blockPtCnt;
+    // Don't reserve memory that would just be spilled.
+    if (m_memoryBudget)
+        blocks = std::min(blocks, residentLimit());
+    if (blocks > m_blocks.size())
+        allocateBlocks(blocks - m_blocks.size());
+}
+
+
+void PointTable::allocateBlocks(std::size_t count)
+{
+    std::size_t blockBytes = pointsToBytes(m_blockPtCnt);
+    char *buf = m_allocator->allocate(blockBytes * count);
+    m_slabs.push_back(std::make_pair(buf, blockBytes * count));
+    for (std::size_t i = 0; i < count; ++i)
+        addBlock(buf + (i * blockBytes));
+}
+
+
+void PointTable::addBlock(char *buf)
+{
+    // Other threads may be reading the block list, so a full list is
+    // copied rather than grown in place.
+    if (m_blocks.size() == m_blocks.capacity())
+    {
+        std::vector<char *> blocks;
+        blocks.reserve((std::max)(2 * m_blocks.size(), (std::size_t)16));
+        blocks.assign(m_blocks.begin(), m_blocks.end());
+        m_blocks.swap(blocks);
+        m_oldBlockLists.push_back(std::move(blocks));
+    }
+    m_blocks.push_back(buf);
+    m_blockPtrs.store(m_blocks.data(), std::memory_order_release);
+    m_capacity.store(m_blocks.size() * m_blockPtCnt,
+        std::memory_order_release);
+    if (m_memoryBudget)
+    {
+        m_lastBlock = m_blocks.size() - 1;
+        m_lru.push_front(m_lastBlock);
+        m_lruPos.push_back(m_lru.begin());
+        m_spillPos.push_back(-1);
+    }
+}
+
+
 PointId PointTable::addPoint()
 {
-    if (m_numPts % m_blockPtCnt == 0)
+    // Without a memory budget points may be added from several threads at
+    // once.  Only adding a block takes the lock.
+    if (!m_memoryBudget)
+    {
+        PointId idx = m_numPts++;
+        if (idx >= m_capacity.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(m_addMutex);
+            while (idx >= m_capacity)
+                allocateBlocks(1);
+        }
+        return idx;
+    }
+
+    if (m_numPts == capacity())
     {
-        char *buf = new char[pointsToBytes(m_blockPtCnt)];
-        m_blocks.push_back(buf);
+        // Once the budget is used up, the memory of the least recently
+        // used block is reused for the new one.
+        if (m_memoryBudget && m_lru.size() >= residentLimit())
+            addBlock(evictBlock());
+        else
+            allocateBlocks(1);
     }
     return m_numPts++;
 }
 
 
-char *PointTable::getPoint(PointId idx)
+PointId PointTable::reserveRange(point_count_t count)
+{
+    if (m_memoryBudget)
+        return BasePointTable::reserveRange(count);
+
+    // The blocks a range needs are allocated together, as by reserve().
+    PointId first = m_numPts.fetch_add(count);
+    point_count_t end = first + count;
+    if (end > m_capacity.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(m_addMutex);
+        if (end > m_capacity)
+            allocateBlocks((end - m_capacity + m_blockPtCnt - 1) /
+                m_blockPtCnt);
+    }
+    return first;
+}
+
+
+std::size_t PointTable::residentLimit() const
 {
-    char *buf = m_blocks[idx / m_blockPtCnt];
-    return buf + pointsToBytes(idx % m_blockPtCnt);
+    std::size_t blockBytes = m_layout->pointSize() * m_blockPtCnt;
+    return std::max(m_memoryBudget / std::max(blockBytes, (std::size_t)1),
+        (std::size_t)2);
+}
+
+
+// Make a block the most recently used one, reading it from the spill file
+// if necessary.
+char *PointTable::touchBlock(std::size_t block)
+{
+    if (!m_blocks[block])
+    {
+        char *buf = evictBlock();
+        std::size_t blockBytes = pointsToBytes(m_blockPtCnt);
+        if (seek64(m_spillFile, m_spillPos[block]) ||
+            std::fread(buf, 1, blockBytes, m_spillFile) != blockBytes)
+            throw pdal_error("Unable to read point data from spill file.");
+        m_loadedBytes += blockBytes;
+        m_blocks[block] = buf;
+        m_lruPos[block] = m_lru.insert(m_lru.begin(), block);
+    }
+    else
+        m_lru.splice(m_lru.begin(), m_lru, m_lruPos[block]);
+    m_lastBlock = block;
+    return m_blocks[block];
+}
+
+
+// Write the least recently used block to the spill file and return the
+// memory that held it.
+char *PointTable::evictBlock()
+{
+    if (!m_spillFile)
+        openSpillFile();
+
+    std::size_t block = m_lru.back();
+    m_lru.pop_back();
+
+    std::size_t blockBytes = pointsToBytes(m_blockPtCnt);
+    if (m_spillPos[block] < 0)
+    {
+        m_spillPos[block] = m_spillEnd;
+        m_spillEnd += blockBytes;
+    }
+    char *buf = m_blocks[block];
+    if (seek64(m_spillFile, m_spillPos[block]) ||
+        std::fwrite(buf, 1, blockBytes, m_spillFile) != blockBytes)
+        throw pdal_error("Unable to write point data to spill file.");
+    m_spilledBytes += blockBytes;
+    m_blocks[block] = NULL;
+    return buf;
+}
+
+
+void PointTable::openSpillFile()
+{
+#ifndef _WIN32
+    if (m_spillDir.size())
+    {
+        std::string name(m_spillDir + "/pdal_spill_XXXXXX");
+        int fd = mkstemp(&name[0]);
+        if (fd >= 0)
+        {
+            // The file goes away when it's closed.
+            unlink(name.c_str());
+            m_spillFile = fdopen(fd, "w+b");
+        }
+    }
+    else
+#endif
+        m_spillFile = std::tmpfile();
+    if (!m_spillFile)
+        throw pdal_error("Unable to create point table spill file.");
 }
 
 
 void PointTable::setField(const Dimension::Detail *d, PointId idx,
     const void *value)
 {
-    std::memcpy(getDimension(d, idx), value, d->size());
+    if (d->packed())
+        setPacked(*m_layout, d, getDimension(d, idx), value);
+    else
+        std::memcpy(getDimension(d, idx), value, d->size());
 }
 
 void PointTable::getField(const Dimension::Detail *d, PointId idx, void *value)
 {
-    std::memcpy(value, getDimension(d, idx), d->size());
+    if (d->packed())
+        getPacked(d, getDimension(d, idx), value);
+    else
+        std::memcpy(value, getDimension(d, idx), d->size());
+}
+
+
+// A block holds whole points, so the values of a dimension within it are a
+// point apart.  Blocks that may be spilled can move, so aren't handed out.
+char *PointTable::getFieldSpan(const Dimension::Detail *d, PointId idx,
+    point_count_t count, std::ptrdiff_t& stride)
+{
+    if (m_memoryBudget || count == 0 || d->packed() ||
+        idx / m_blockPtCnt != (idx + count - 1) / m_blockPtCnt)
+        return NULL;
+    stride = (std::ptrdiff_t)m_layout->pointSize();
+    return getDimension(d, idx);
 }
 
-} // namespace pdal
 
+// The points of each block are copied with the block in memory.
+void PointTable::copyField(const Dimension::Detail *from,
+    const Dimension::Detail *to, PointId idx, point_count_t count)
+{
+    if (from->packed() || to->packed())
+    {
+        char buf[sizeof(double)];
+        for (PointId i = idx; i < idx + count; ++i)
+        {
+            getField(from, i, buf);
+            setField(to, i, buf);
+        }
+        return;
+    }
+
+    const std::size_t pointSize = m_layout->pointSize();
+    const std::size_t size = from->size();
+    while (count)
+    {
+        point_count_t n = (std::min)(count,
+            m_blockPtCnt - idx % m_blockPtCnt);
+        char *pos = getPoint(idx);
+        for (point_count_t i = 0; i < n; ++i, pos += pointSize)
+            std::memcpy(pos + to->offset(), pos + from->offset(), size);
+        idx += n;
+        count -= n;
+    }
+}
+
+
+void PointTable::getPackedBytes(const Dimension::Detail *d, PointId idx,
+    point_count_t count, uint8_t *out)
+{
+    const std::size_t pointSize = m_layout->pointSize();
+    while (count)
+    {
+        point_count_t n = (std::min)(count,
+            m_blockPtCnt - idx % m_blockPtCnt);
+        const char *pos = getDimension(d, idx);
+        for (point_count_t i = 0; i < n; ++i, pos += pointSize)
+            *out++ = (uint8_t)*pos;
+        idx += n;
+        count -= n;
+    }
+}
+
+
+ColumnPointTable::~ColumnPointTable()
+{
+    for (auto si = m_slabs.begin(); si != m_slabs.end(); ++si)
+        m_allocator->deallocate(si->first, si->second);
+}
+
+
+void ColumnPointTable::setBlockSize(point_count_t blockPtCnt)
+{
+    if (m_numBlocks)
+        throw pdal_error("Can't change the block size of a point table "
+            "once storage has been allocated.");
+    if (blockPtCnt == 0)
+        throw pdal_error("Point table block size must be positive.");
+    m_blockPtCnt = blockPtCnt;
+}
+
+
+// The layout can't change once points have been added, so the columns
+// are set up when storage is first allocated.
+void ColumnPointTable::initColumns()
+{
+    if (m_colIndex.size())
+        return;
+    m_colIndex.resize(m_layout->pointSize());
+
+    // Packed dimensions that share a byte share its column.
+    std::vector<bool> placed(m_layout->pointSize());
+    const Dimension::IdList& dims = m_layout->dims();
+    for (auto di = dims.begin(); di != dims.end(); ++di)
+    {
+        const Dimension::Detail *d = m_layout->dimDetail(*di);
+        if (d->computed() || placed[d->offset()])
+            continue;
+        placed[d->offset()] = true;
+        m_colIndex[d->offset()] = m_columns.size();
+        m_columns.push_back(Column(d->size()));
+    }
+}
+
+
+void ColumnPointTable::reserve(point_count_t count)
+{
+    std::size_t blocks = (m_numPts + count + m_blockPtCnt - 1) / m_blockPtCnt;
+    if (blocks > m_numBlocks)
+        allocateBlocks(blocks - m_numBlocks);
+}
+
+
+void ColumnPointTable::allocateBlocks(std::size_t count)
+{
+    initColumns();
+    for (auto ci = m_columns.begin(); ci != m_columns.end(); ++ci)
+    {
+        std::size_t blockBytes = ci->m_size * m_blockPtCnt;
+        char *buf = m_allocator->allocate(blockBytes * count);
+        m_slabs.push_back(std::make_pair(buf, blockBytes * count));
+        for (std::size_t i = 0; i < count; ++i)
+            ci->m_blocks.push_back(buf + (i * blockBytes));
+    }
+    m_numBlocks += count;
+}
+
+
+PointId ColumnPointTable::addPoint()
+{
+    if (m_numPts == capacity())
+        allocateBlocks(1);
+    return m_numPts++;
+}
+
+
+char *ColumnPointTable::getPoint(PointId idx)
+{
+    throw pdal_error("ColumnPointTable doesn't store points contiguously.");
+}
+
+
+void ColumnPointTable::setField(const Dimension::Detail *d, PointId idx,
+    const void *value)
+{
+    if (d->packed())
+        setPacked(*m_layout, d, getDimension(d, idx), value);
+    else
+        std::memcpy(getDimension(d, idx), value, d->size());
+}
+
+
+void ColumnPointTable::getField(const Dimension::Detail *d, PointId idx,
+    void *value)
+{
+    if (d->packed())
+        getPacked(d, getDimension(d, idx), value);
+    else
+        std::memcpy(value, getDimension(d, idx), d->size());
+}
+
+
+char *ColumnPointTable::getFieldSpan(const Dimension::Detail *d,
+    PointId idx, point_count_t count, std::ptrdiff_t& stride)
+{
+    if (count == 0 || d->packed() || idx / m_blockPtCnt != (idx + count - 1) / m_blockPtCnt)
+        return NULL;
+    stride = (std::ptrdiff_t)d->size();
+    return getDimension(d, idx);
+}
+
+
+// Within a block, the values of a dimension are contiguous, so each block's
+// share of the points is a single copy.
+void ColumnPointTable::copyField(const Dimension::Detail *from,
+    const Dimension::Detail *to, PointId idx, point_count_t count)
+{
+    if (from->packed() || to->packed())
+    {
+        char buf[sizeof(double)];
+        for (PointId i = idx; i < idx + count; ++i)
+        {
+            getField(from, i, buf);
+            setField(to, i, buf);
+        }
+        return;
+    }
+
+    while (count)
+    {
+        point_count_t n = (std::min)(count,
+            m_blockPtCnt - idx % m_blockPtCnt);
+        std::memcpy(getDimension(to, idx), getDimension(from, idx),
+            n * from->size());
+        idx += n;
+        count -= n;
+    }
+}
+
+
+// The bytes of a packed column are contiguous within a block.
+void ColumnPointTable::getPackedBytes(const Dimension::Detail *d,
+    PointId idx, point_count_t count, uint8_t *out)
+{
+    while (count)
+    {
+        point_count_t n = (std::min)(count,
+            m_blockPtCnt - idx % m_blockPtCnt);
+        std::memcpy(out, getDimension(d, idx), n);
+        out += n;
+        idx += n;
+        count -= n;
+    }
+}
+
+namespace
+{
+
+// Read a little-endian value of type 'type' at 'pos'.
+template<typename T>
+T readValue(const char *pos, Dimension::Type::Enum type)
+{
+    using namespace Dimension;
+
+    switch (type)
+    {
+    case Type::Unsigned8:
+        return (T)*(const uint8_t *)pos;
+    case Type::Signed8:
+        return (T)*(const int8_t *)pos;
+    case Type::Unsigned16:
+    case Type::Signed16:
+    {
+        uint16_t u;
+        std::memcpy(&u, pos, sizeof(u));
+        u = le16toh(u);
+        if (type == Type::Signed16)
+            return (T)(int16_t)u;
+        return (T)u;
+    }
+    case Type::Unsigned32:
+    case Type::Signed32:
+    case Type::Float:
+    {
+        uint32_t u;
+        std::memcpy(&u, pos, sizeof(u));
+        u = le32toh(u);
+        if (type == Type::Signed32)
+            return (T)(int32_t)u;
+        if (type == Type::Float)
+        {
+            float f;
+            std::memcpy(&f, &u, sizeof(f));
+            return (T)f;
+        }
+        return (T)u;
+    }
+    case Type::Unsigned64:
+    case Type::Signed64:
+    case Type::Double:
+    {
+        uint64_t u;
+        std::memcpy(&u, pos, sizeof(u));
+        u = le64toh(u);
+        if (type == Type::Signed64)
+            return (T)(int64_t)u;
+        if (type == Type::Double)
+        {
+            double d;
+            std::memcpy(&d, &u, sizeof(d));
+            return (T)d;
+        }
+        return (T)u;
+    }
+    default:
+        return 0;
+    }
+}
+
+
+// Store 'v' as type 'type' at 'out'.
+template<typename T>
+void writeValue(T v, Dimension::Type::Enum type, void *out)
+{
+    using namespace Dimension;
+
+    switch (type)
+    {
+    case Type::Unsigned8:
+        *(uint8_t *)out = (uint8_t)v;
+        break;
+    case Type::Signed8:
+        *(int8_t *)out = (int8_t)v;
+        break;
+    case Type::Unsigned16:
+        *(uint16_t *)out = (uint16_t)v;
+        break;
+    case Type::Signed16:
+        *(int16_t *)out = (int16_t)v;
+        break;
+    case Type::Unsigned32:
+        *(uint32_t *)out = (uint32_t)v;
+        break;
+    case Type::Signed32:
+        *(int32_t *)out = (int32_t)v;
+        break;
+    case Type::Unsigned64:
+        *(uint64_t *)out = (uint64_t)v;
+        break;
+    case Type::Signed64:
+        *(int64_t *)out = (int64_t)v;
+        break;
+    case Type::Float:
+        *(float *)out = (float)v;
+        break;
+    case Type::Double:
+        *(double *)out = (double)v;
+        break;
+    default:
+        break;
+    }
+}
+
+} // unnamed namespace
+
+
+MappedPointTable::~MappedPointTable()
+{
+    unmap();
+    for (auto ci = m_columns.begin(); ci != m_columns.end(); ++ci)
+        for (auto bi = ci->m_blocks.begin(); bi != ci->m_blocks.end(); ++bi)
+            if (*bi)
+                m_allocator->deallocate(*bi, ci->m_size * m_blockPtCnt);
+}
+
+
+void MappedPointTable::mapFile(const std::string& filename, uint64_t offset,
+    point_count_t count, std::size_t recordSize)
+{
+    if (mapped())
+        throw pdal_error("Point table already maps a file.");
+    if (m_numPts)
+        throw pdal_error("Can't map a file into a point table that "
+            "already contains points.");
+    if (!m_layout->finalized())
+        throw pdal_error("Can't map a file before the point layout is "
+            "finalized.");
+#ifndef _WIN32
+    if (count == 0)
+        return;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw pdal_error("Unable to open '" + filename + "' for mapping.");
+
+    struct stat st;
+    uint64_t end = offset + (uint64_t)count * recordSize;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < end)
+    {
+        close(fd);
+        throw pdal_error("File '" + filename + "' is too short to contain "
+            "the point records to be mapped.");
+    }
+
+    // Mappings must start on a page boundary.
+    uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t start = offset - (offset % pageSize);
+    m_mapSize = (std::size_t)(end - start);
+    void *p = mmap(NULL, m_mapSize, PROT_READ, MAP_PRIVATE, fd, (off_t)start);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        m_mapSize = 0;
+        throw pdal_error("Unable to map '" + filename + "'.");
+    }
+    madvise(p, m_mapSize, MADV_SEQUENTIAL);
+
+    m_map = (char *)p;
+    m_records = m_map + (offset - start);
+    m_mappedCnt = count;
+    m_recordSize = recordSize;
+    m_mappedDims.resize(m_layout->pointSize() * 8);
+#else
+    throw pdal_error("Memory mapped point tables aren't supported on "
+        "this platform.");
+#endif
+}
+
+
+void MappedPointTable::unmap()
+{
+#ifndef _WIN32
+    if (m_map)
+        munmap(m_map, m_mapSize);
+#endif
+    m_map = NULL;
+    m_records = NULL;
+    m_mapSize = 0;
+}
+
+
+void MappedPointTable::mapDim(Dimension::Id::Enum id, std::size_t pos,
+    Dimension::Type::Enum type, double scale, double offset)
+{
+    if (!mapped())
+        return;
+    if (pos + Dimension::size(type) > m_recordSize)
+        throw pdal_error("Mapped dimension '" + m_layout->dimName(id) +
+            "' extends past the end of the point record.");
+    const Dimension::Detail *d = m_layout->dimDetail(id);
+    if (d->type() == Dimension::Type::None)
+        throw pdal_error("Can't map dimension '" + m_layout->dimName(id) +
+            "', which isn't in the point layout.");
+    if (d->computed())
+        throw pdal_error("Can't map computed dimension '" +
+            m_layout->dimName(id) + "'.");
+
+    MappedDim& m = m_mappedDims[slot(d)];
+    m.m_type = type;
+    m.m_pos = pos;
+    m.m_scale = scale;
+    m.m_offset = offset;
+}
+
+
+void MappedPointTable::mapBits(Dimension::Id::Enum id, std::size_t pos,
+    int shift, int bits)
+{
+    mapDim(id, pos, Dimension::Type::Unsigned8);
+    if (!mapped())
+        return;
+    MappedDim& m = m_mappedDims[slot(m_layout->dimDetail(id))];
+    m.m_shift = shift;
+    m.m_mask = (1 << bits) - 1;
+}
+
+
+bool MappedPointTable::isMapped(Dimension::Id::Enum id) const
+{
+    if (!mapped())
+        return false;
+    const Dimension::Detail *d = m_layout->dimDetail(id);
+    if (d->type() == Dimension::Type::None || d->computed())
+        return false;
+    return m_mappedDims[slot(d)].m_type != Dimension::Type::None;
+}
+
+
+void MappedPointTable::initColumns()
+{
+    if (m_colIndex.size())
+        return;
+    m_colIndex.resize(m_layout->pointSize());
+
+    // Packed dimensions that share a byte share its column.
+    std::vector<bool> placed(m_layout->pointSize());
+    const Dimension::IdList& dims = m_layout->dims();
+    for (auto di = dims.begin(); di != dims.end(); ++di)
+    {
+        const Dimension::Detail *d = m_layout->dimDetail(*di);
+        if (d->computed() || placed[d->offset()])
+            continue;
+        placed[d->offset()] = true;
+        m_colIndex[d->offset()] = m_columns.size();
+        m_columns.push_back(Column(d->size()));
+    }
+}
+
+
+PointId MappedPointTable::addPoint()
+{
+    if (m_numPts == 0)
+        initColumns();
+    return m_numPts++;
+}
+
+
+char *MappedPointTable::getPoint(PointId idx)
+{
+    if (idx < m_mappedCnt)
+        return const_cast<char *>(m_records + idx * m_recordSize);
+    throw pdal_error("MappedPointTable doesn't store added points "
+        "contiguously.");
+}
+
+
+char *MappedPointTable::getSideDimension(const Dimension::Detail *d,
+    PointId idx, bool create)
+{
+    Column& c = m_columns[m_colIndex[d->offset()]];
+    std::size_t block = idx / m_blockPtCnt;
+    if (block >= c.m_blocks.size())
+    {
+        if (!create)
+            return NULL;
+        c.m_blocks.resize(block + 1, NULL);
+    }
+    char *buf = c.m_blocks[block];
+    if (!buf)
+    {
+        if (!create)
+            return NULL;
+        std::size_t size = c.m_size * m_blockPtCnt;
+        buf = m_allocator->allocate(size);
+        std::memset(buf, 0, size);
+        c.m_blocks[block] = buf;
+    }
+    return buf + (c.m_size * (idx % m_blockPtCnt));
+}
+
+
+void MappedPointTable::setField(const Dimension::Detail *d, PointId idx,
+    const void *value)
+{
+    if (idx < m_mappedCnt &&
+        m_mappedDims[slot(d)].m_type != Dimension::Type::None)
+        throw pdal_error("Can't set dimension '" +
+            m_layout->dimName(d->id()) + "' of a point in a mapped file.");
+    if (d->packed())
+        setPacked(*m_layout, d, getSideDimension(d, idx, true), value);
+    else
+        std::memcpy(getSideDimension(d, idx, true), value, d->size());
+}
+
+
+void MappedPointTable::getField(const Dimension::Detail *d, PointId idx,
+    void *value)
+{
+    if (idx < m_mappedCnt)
+    {
+        const MappedDim& m = m_mappedDims[slot(d)];
+        if (m.m_type != Dimension::Type::None)
+        {
+            getMappedField(m, d, idx, value);
+            return;
+        }
+    }
+
+    // Side fields that have never been set read as zero.
+    char *pos = getSideDimension(d, idx, false);
+    if (pos && d->packed())
+        getPacked(d, pos, value);
+    else if (pos)
+        std::memcpy(value, pos, d->size());
+    else
+        std::memset(value, 0, d->size());
+}
+
+
+void MappedPointTable::getMappedField(const MappedDim& m,
+    const Dimension::Detail *d, PointId idx, void *value) const
+{
+    using namespace Dimension;
+
+    const char *pos = m_records + idx * m_recordSize + m.m_pos;
+    bool scaled = (m.m_scale != 1.0 || m.m_offset != 0.0);
+
+    // A layout dimension scaled just like the file needs no conversion.
+    if (d->scaled() && m.m_type == d->type() && !m.m_mask &&
+        m.m_scale == d->xform().m_scale && m.m_offset == d->xform().m_offset)
+    {
+        writeValue(readValue<int64_t>(pos, m.m_type), d->type(), value);
+        return;
+    }
+
+    if (m.m_mask)
+    {
+        uint64_t u = (readValue<uint64_t>(pos, m.m_type) >> m.m_shift) &
+            m.m_mask;
+        writeValue(u, d->type(), value);
+    }
+    else if (scaled || d->scaled() || base(m.m_type) == BaseType::Floating ||
+        base(d->type()) == BaseType::Floating)
+    {
+        double v = readValue<double>(pos, m.m_type) * m.m_scale + m.m_offset;
+        if (d->scaled())
+            v = (v - d->xform().m_offset) / d->xform().m_scale;
+        if (base(d->type()) != BaseType::Floating)
+            v = std::round(v);
+        writeValue(v, d->type(), value);
+    }
+    else if (base(m.m_type) == BaseType::Signed)
+        writeValue(readValue<int64_t>(pos, m.m_type), d->type(), value);
+    else
+        writeValue(readValue<uint64_t>(pos, m.m_type), d->type(), value);
+}
+
+
+namespace
+{
+
+// Read a value of type 'type' in the byte order of the host at 'pos'.
+template<typename T>
+T readNative(const char *pos, Dimension::Type::Enum type)
+{
+    using namespace Dimension;
+
+    switch (type)
+    {
+    case Type::Unsigned8:
+        return (T)*(const uint8_t *)pos;
+    case Type::Signed8:
+        return (T)*(const int8_t *)pos;
+    case Type::Unsigned16:
+    { uint16_t v; std::memcpy(&v, pos, sizeof(v)); return (T)v; }
+    case Type::Signed16:
+    { int16_t v; std::memcpy(&v, pos, sizeof(v)); return (T)v; }
+    case Type::Unsigned32:
+    { uint32_t v; std::memcpy(&v, pos, sizeof(v)); return (T)v; }
+    case Type::Signed32:
+    { int32_t v; std::memcpy(&v, pos, sizeof(v)); return (T)v; }
+    case Type::Unsigned64:
+    { uint64_t v; std::memcpy(&v, pos, sizeof(v)); return (T)v; }
+    case Type::Signed64:
+    { int64_t v; std::memcpy(&v, pos, sizeof(v)); return (T)v; }
+    case Type::Float:
+    { float v; std::memcpy(&v, pos, sizeof(v)); return (T)v; }
+    case Type::Double:
+    { double v; std::memcpy(&v, pos, sizeof(v)); return (T)v; }
+    default:
+        return 0;
+    }
+}
+
+// Convert the value of type 'inType' at 'in' to type 'outType' at 'out'.
+void convertNative(const void *in, Dimension::Type::Enum inType, void *out,
+    Dimension::Type::Enum outType)
+{
+    using namespace Dimension;
+
+    const char *pos = (const char *)in;
+    if (base(inType) == BaseType::Floating ||
+        base(outType) == BaseType::Floating)
+    {
+        double v = readNative<double>(pos, inType);
+        if (base(outType) != BaseType::Floating)
+            v = std::round(v);
+        writeValue(v, outType, out);
+    }
+    else if (base(inType) == BaseType::Signed)
+        writeValue(readNative<int64_t>(pos, inType), outType, out);
+    else
+        writeValue(readNative<uint64_t>(pos, inType), outType, out);
+}
+
+} // unnamed namespace
+
+
+ExternalPointTable::~ExternalPointTable()
+{
+    for (auto ci = m_columns.begin(); ci != m_columns.end(); ++ci)
+        for (auto bi = ci->m_blocks.begin(); bi != ci->m_blocks.end(); ++bi)
+            if (*bi)
+                m_allocator->deallocate(*bi, ci->m_size * m_blockPtCnt);
+}
+
+
+void ExternalPointTable::addArray(Dimension::Id::Enum id,
+    Dimension::Type::Enum type, void *data, std::ptrdiff_t stride)
+{
+    if (m_layout->finalized())
+        throw pdal_error("Can't add an array for dimension '" +
+            m_layout->dimName(id) + "' once the point layout is finalized.");
+    if (!data)
+        throw pdal_error("Array for dimension '" + m_layout->dimName(id) +
+            "' is NULL.");
+    Array& a = m_arrays[id];
+    a.m_type = type;
+    a.m_data = (char *)data;
+    a.m_stride = stride ? stride : (std::ptrdiff_t)Dimension::size(type);
+    m_layout->registerDim(id, type);
+}
+
+
+void ExternalPointTable::appendExternal(PointView& view)
+{
+    if (&view.table() != this)
+        throw pdal_error("Can't add the external points of a table to a "
+            "view of another table.");
+    if (m_numPts)
+        throw pdal_error("Can't add external points to a point table that "
+            "already contains points.");
+    view.appendTablePoints(m_externalCnt);
+}
+
+
+// The layout is finalized by the time points are added, so the arrays are
+// matched to the dimensions' offsets then.
+void ExternalPointTable::initColumns()
+{
+    if (m_colIndex.size())
+        return;
+    m_colIndex.resize(m_layout->pointSize());
+    m_offsetArrays.resize(m_layout->pointSize());
+
+    for (auto ai = m_arrays.begin(); ai != m_arrays.end(); ++ai)
+    {
+        const Dimension::Detail *d = m_layout->dimDetail(ai->first);
+        if (d->packed() || d->computed())
+            throw pdal_error("Dimension '" + m_layout->dimName(ai->first) +
+                "' can't be held in an external array.");
+        m_offsetArrays[d->offset()] = ai->second;
+    }
+
+    // Packed dimensions that share a byte share its column.
+    std::vector<bool> placed(m_layout->pointSize());
+    const Dimension::IdList& dims = m_layout->dims();
+    for (auto di = dims.begin(); di != dims.end(); ++di)
+    {
+        const Dimension::Detail *d = m_layout->dimDetail(*di);
+        if (d->computed() || placed[d->offset()])
+            continue;
+        placed[d->offset()] = true;
+        m_colIndex[d->offset()] = m_columns.size();
+        m_columns.push_back(Column(d->size(),
+            !d->packed() && m_offsetArrays[d->offset()].m_data));
+    }
+}
+
+
+// Side storage for a block is allocated when its first point is added, but
+// not for columns whose values for all of the block's points are external.
+PointId ExternalPointTable::addPoint()
+{
+    if (m_numPts == 0)
+        initColumns();
+    PointId idx = m_numPts++;
+    if (idx % m_blockPtCnt == 0)
+    {
+        bool allExternal = idx + m_blockPtCnt <= m_externalCnt;
+        for (auto ci = m_columns.begin(); ci != m_columns.end(); ++ci)
+        {
+            char *buf = NULL;
+            if (!(ci->m_external && allExternal))
+            {
+                std::size_t size = ci->m_size * m_blockPtCnt;
+                buf = m_allocator->allocate(size);
+                std::memset(buf, 0, size);
+                m_sideBytes += size;
+            }
+            ci->m_blocks.push_back(buf);
+        }
+    }
+    return idx;
+}
+
+
+char *ExternalPointTable::getPoint(PointId idx)
+{
+    throw pdal_error("ExternalPointTable doesn't store points "
+        "contiguously.");
+}
+
+
+void ExternalPointTable::setField(const Dimension::Detail *d, PointId idx,
+    const void *value)
+{
+    if (const Array *a = array(d, idx))
+    {
+        char *pos = a->m_data + idx * a->m_stride;
+        if (a->m_type == d->type())
+            std::memcpy(pos, value, d->size());
+        else
+            convertNative(value, d->type(), pos, a->m_type);
+    }
+    else if (d->packed())
+        setPacked(*m_layout, d, getSideDimension(d, idx), value);
+    else
+        std::memcpy(getSideDimension(d, idx), value, d->size());
+}
+
+
+void ExternalPointTable::getField(const Dimension::Detail *d, PointId idx,
+    void *value)
+{
+    if (const Array *a = array(d, idx))
+    {
+        const char *pos = a->m_data + idx * a->m_stride;
+        if (a->m_type == d->type())
+            std::memcpy(value, pos, d->size());
+        else
+            convertNative(pos, a->m_type, value, d->type());
+    }
+    else if (d->packed())
+        getPacked(d, getSideDimension(d, idx), value);
+    else
+        std::memcpy(value, getSideDimension(d, idx), d->size());
+}
+
+
+// Values in the caller's array of the layout's type are handed out as they
+// are, so getFieldArray() reads columns without a copy per value.
+char *ExternalPointTable::getFieldSpan(const Dimension::Detail *d,
+    PointId idx, point_count_t count, std::ptrdiff_t& stride)
+{
+    if (count == 0 || d->packed())
+        return NULL;
+    if (const Array *a = array(d, idx))
+    {
+        if (a->m_type != d->type() || idx + count > m_externalCnt)
+            return NULL;
+        stride = a->m_stride;
+        return a->m_data + idx * a->m_stride;
+    }
+    if (idx / m_blockPtCnt != (idx + count - 1) / m_blockPtCnt ||
+        (m_offsetArrays[d->offset()].m_data && idx < m_externalCnt))
+        return NULL;
+    stride = (std::ptrdiff_t)d->size();
+    return getSideDimension(d, idx);
+}
+
+
+PointId FixedPointTable::addPoint()
+{
+    if (m_numPts == m_capacity)
+        throw pdal_error("Can't add a point to a full fixed point table.");
+    // The layout is finalized by the time points are added.
+    if (m_buf.empty())
+        m_buf.resize(m_layout->pointSize() * m_capacity * m_slots);
+    return m_base + m_numPts++;
+}
+
+
+void FixedPointTable::zeroChunk(int slot)
+{
+    // Storage that's yet to be allocated starts out zeroed.
+    if (m_buf.empty())
+        return;
+    const std::size_t chunkBytes = m_layout->pointSize() * m_capacity;
+    std::fill(m_buf.begin() + slot * chunkBytes,
+        m_buf.begin() + (slot + 1) * chunkBytes, 0);
+}
+
+
+void FixedPointTable::setField(const Dimension::Detail *d, PointId idx,
+    const void *value)
+{
+    if (d->packed())
+        setPacked(*m_layout, d, getPoint(idx) + d->offset(), value);
+    else
+        std::memcpy(getPoint(idx) + d->offset(), value, d->size());
+}
+
+
+void FixedPointTable::getField(const Dimension::Detail *d, PointId idx,
+    void *value)
+{
+    if (d->packed())
+        getPacked(d, getPoint(idx) + d->offset(), value);
+    else
+        std::memcpy(value, getPoint(idx) + d->offset(), d->size());
+}
+
+
+void FixedPointTable::getPackedBytes(const Dimension::Detail *d,
+    PointId idx, point_count_t count, uint8_t *out)
+{
+    const std::size_t pointSize = m_layout->pointSize();
+    const char *pos = getPoint(idx) + d->offset();
+    for (point_count_t i = 0; i < count; ++i, pos += pointSize)
+        *out++ = (uint8_t)*pos;
+}
+
+} // namespace pdal
@@ -33,9 +33,12 @@
 ****************************************************************************/
 
 #include <iomanip>
+#include <mutex>
 
+#include <pdal/KDIndex.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/PointViewIter.hpp>
+#include <pdal/ThreadPool.hpp>
 
 #include <boost/lexical_cast.hpp>
 
@@ -56,38 +59,96 @@ PointViewIter PointView::end()
 
 BOX3D PointView::calculateBounds(bool is3d) const
 {
-    BOX3D output;
+    const std::size_t dims = is3d ? 3 : 2;
+    const uint64_t generation = m_pointTable.coordsGeneration();
+    if (m_boundsDims >= (int)dims && m_boundsSize == size() &&
+        m_boundsGeneration == generation)
+    {
+        if (is3d)
+            return m_bounds;
+        return BOX3D(m_bounds.minx, m_bounds.miny,
+            m_bounds.maxx, m_bounds.maxy);
+    }
 
+    // The coordinates are read a column at a time in batches, and the
+    // minimum and maximum of each range of points are found on a worker
+    // thread when the table allows it.
+    const Dimension::Id::Enum ids[] =
+        { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z };
+    const point_count_t batchSize = 4096;
+    std::mutex mutex;
     bool first = true;
-    for (PointId idx = 0; idx < size(); idx++)
+    double lo[3];
+    double hi[3];
+    auto reduce = [&](std::size_t begin, std::size_t end)
     {
-        double x = getFieldAs<double>(Dimension::Id::X, idx);
-        double y = getFieldAs<double>(Dimension::Id::Y, idx);
-        double z = getFieldAs<double>(Dimension::Id::Z, idx);
-
-        if (is3d)
+        std::vector<double> batch(batchSize);
+        double rlo[3];
+        double rhi[3];
+        for (PointId b = begin; b < end; b += batchSize)
         {
-            if (first)
+            point_count_t n = (std::min)(batchSize, (point_count_t)(end - b));
+            for (std::size_t d = 0; d < dims; ++d)
             {
-                output = BOX3D(x, y, z, x, y, z);
-                first = false;
+                getFieldArray(ids[d], b, n, batch.data());
+                double l = batch[0];
+                double h = batch[0];
+                for (point_count_t i = 1; i < n; ++i)
+                {
+                    l = batch[i] < l ? batch[i] : l;
+                    h = batch[i] > h ? batch[i] : h;
+                }
+                if (b == begin)
+                {
+                    rlo[d] = l;
+                    rhi[d] = h;
+                }
+                else
+                {
+                    rlo[d] = (std::min)(rlo[d], l);
+                    rhi[d] = (std::max)(rhi[d], h);
+                }
             }
-            output.grow(x,y,z);
         }
-        else
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t d = 0; d < dims; ++d)
         {
-            if (first)
-            {
-                output = BOX3D(x, y, x, y);
-                first = false;
-            }
-            output.grow(x, y);
+            if (first || rlo[d] < lo[d])
+                lo[d] = rlo[d];
+            if (first || rhi[d] > hi[d])
+                hi[d] = rhi[d];
         }
-    }
+        first = false;
+    };
+    if (size() > 16 * batchSize && m_pointTable.threadSafe())
+        ThreadPool::shared().parallelFor(size(), 16 * batchSize, reduce);
+    else if (size())
+        reduce(0, size());
+
+    BOX3D output;
+    if (size())
+        output = is3d ? BOX3D(lo[0], lo[1], lo[2], hi[0], hi[1], hi[2]) :
+            BOX3D(lo[0], lo[1], hi[0], hi[1]);
+    m_bounds = output;
+    m_boundsDims = (int)dims;
+    m_boundsSize = size();
+    m_boundsGeneration = generation;
     return output;
 }
 
 
+const KDIndex& PointView::spatialIndex(bool b3d) const
+{
+    if (!m_spatialIndex || !m_spatialIndex->current(*this, b3d))
+    {
+        m_spatialIndex.reset(new KDIndex(*this));
+        m_spatialIndex->build(b3d);
+    }
+    return *m_spatialIndex;
+}
+
+
 BOX3D PointView::calculateBounds(const PointViewSet& set, bool is3d)
 {
     BOX3D out;
@@ -100,6 +161,165 @@ BOX3D PointView::calculateBounds(const PointViewSet& set, bool is3d)
 }
 
 
+void PointView::append(const std::vector<PointViewPtr>& views)
+{
+    size_t i = 0;
+    for (; i < views.size(); ++i)
+    {
+        const PointIdList& src = views[i]->m_index;
+        bool adjacent = m_index.identity() && src.identity() &&
+            m_index.size() == size() &&
+            (empty() || views[i]->empty() ||
+                src.first() == m_index.first() + size());
+        if (!adjacent)
+            break;
+        append(*views[i]);
+    }
+    if (i == views.size())
+        return;
+
+    const point_count_t oldSize = size();
+    point_count_t total = m_index.size();
+    for (size_t j = i; j < views.size(); ++j)
+        total += views[j]->size();
+
+    PointIdList::Ids ids;
+    ids.reserve(total);
+    for (PointId id = 0; id < oldSize; ++id)
+        ids.push_back(m_index[id]);
+    for (size_t j = i; j < views.size(); ++j)
+    {
+        const PointIdList& src = views[j]->m_index;
+        for (PointId id = 0; id < views[j]->size(); ++id)
+            ids.push_back(src[id]);
+        m_size += views[j]->size();
+    }
+    // Temporary points follow the view's points in the index.
+    for (PointId id = oldSize; id < m_index.size(); ++id)
+        ids.push_back(m_index[id]);
+    m_index.assign(std::move(ids));
+    clearTemps();
+}
+
+
+void PointView::copyField(Dimension::Id::Enum from, Dimension::Id::Enum to,
+    PointId begin, point_count_t count)
+{
+    PointLayoutPtr layout = m_pointTable.layout();
+    const Dimension::Detail *src = layout->dimDetail(from);
+    const Dimension::Detail *dst = layout->dimDetail(to);
+    const XForm& srcXform = src->xform();
+    const XForm& dstXform = dst->xform();
+
+    bool raw = !src->computed() && !dst->computed() &&
+        src->type() == dst->type() && src->scaled() == dst->scaled() &&
+        (!src->scaled() || (srcXform.m_scale == dstXform.m_scale &&
+            srcXform.m_offset == dstXform.m_offset));
+    if (!raw)
+    {
+        const point_count_t batchSize = 4096;
+        std::vector<double> values(batchSize);
+        for (PointId b = begin; b < begin + count; b += batchSize)
+        {
+            point_count_t n = (std::min)(batchSize, begin + count - b);
+            getFieldArray(from, b, n, values.data());
+            setFieldArray(to, b, n, values.data());
+        }
+        return;
+    }
+
+    if (isCoord(to))
+        m_pointTable.coordsChanged();
+
+    // Points that are consecutive in the table are copied at once.
+    PointId idx = begin;
+    while (idx < begin + count)
+    {
+        PointId first = m_index[idx];
+        point_count_t n = 1;
+        if (m_index.identity())
+            n = begin + count - idx;
+        else
+            while (idx + n < begin + count && m_index[idx + n] == first + n)
+                n++;
+        m_pointTable.copyField(src, dst, first, n);
+        if (m_pointTable.hasComputed())
+            for (PointId i = 0; i < n; ++i)
+                fieldChanged(to, m_index[idx + i]);
+        idx += n;
+    }
+}
+
+
+// Values are computed for the block of points of the view that holds
+// 'idx', as most callers go on to read the points that follow.
+double PointView::computedField(const Dimension::Detail *dd,
+    PointId idx) const
+{
+    double value;
+    if (m_pointTable.getComputed(dd->id(), m_index[idx], value))
+        return value;
+
+    const point_count_t blockSize = BasePointTable::ComputedBlockPtCnt;
+    PointId start = idx;
+    point_count_t count = 1;
+    // Temporary points are computed alone.
+    if (idx < size())
+    {
+        start = idx - idx % blockSize;
+        count = (std::min)(blockSize, size() - start);
+    }
+
+    PointViewPtr block = makeNew();
+    std::vector<PointId> ids(count);
+    for (PointId i = 0; i < count; ++i)
+    {
+        block->appendPoint(*this, start + i);
+        ids[i] = m_index[start + i];
+    }
+    std::vector<double> values(count);
+    m_pointTable.layout()->computeFunc(dd->id())(*block, values.data());
+    m_pointTable.setComputed(dd->id(), ids.data(), values.data(), count);
+    return values[idx - start];
+}
+
+
+void PointView::matchPacked(Dimension::Id::Enum dim, PointId begin,
+    point_count_t count, const char *flags, char *match) const
+{
+    PointLayoutPtr layout = m_pointTable.layout();
+    const Dimension::Detail *d = layout->dimDetail(dim);
+    if (!d->packed())
+        throw pdal_error("Dimension '" + layout->dimName(dim) +
+            "' isn't packed.");
+
+    // The result for every byte, whatever the bits of the other
+    // dimensions in it.
+    char lookup[256];
+    for (int b = 0; b < 256; ++b)
+        lookup[b] = flags[(b >> d->shift()) & d->mask()];
+
+    // Gather the bytes of points that are consecutive in the table at
+    // once, then look them up in place.
+    uint8_t *bytes = (uint8_t *)match;
+    PointId idx = begin;
+    while (idx < begin + count)
+    {
+        PointId first = m_index[idx];
+        point_count_t n = 1;
+        if (m_index.identity())
+            n = begin + count - idx;
+        else
+            while (idx + n < begin + count && m_index[idx + n] == first + n)
+                n++;
+        m_pointTable.getPackedBytes(d, first, n, bytes + (idx - begin));
+        idx += n;
+    }
+    for (point_count_t i = 0; i < count; ++i)
+        match[i] = lookup[bytes[i]];
+}
+
+
 void PointView::dump(std::ostream& ostr) const
 {
     using std::endl;
@@ -119,6 +339,11 @@ void PointView::dump(std::ostream& ostr) const
             ostr << Dimension::name(d) << " (" <<
                 Dimension::interpretationName(dd->type()) << ") : ";
 
+            if (dd->scaled())
+            {
+                ostr << getFieldAs<double>(d, idx) << endl;
+                continue;
+            }
             switch (dd->type())
             {
             case Dimension::Type::Signed8:
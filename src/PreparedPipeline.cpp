@@ -0,0 +1,109 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include <pdal/PreparedPipeline.hpp>
+
+#include <pdal/PipelineReader.hpp>
+
+#include <algorithm>
+
+namespace pdal
+{
+
+PreparedPipeline::PreparedPipeline(const std::string& filename) :
+    m_table(new PointTable())
+{
+    PipelineReader reader(m_manager);
+    m_isWriter = reader.readPipeline(filename);
+    findReaders(m_manager.getStage());
+}
+
+
+PreparedPipeline::PreparedPipeline(std::istream& input) :
+    m_table(new PointTable())
+{
+    PipelineReader reader(m_manager);
+    m_isWriter = reader.readPipeline(input);
+    findReaders(m_manager.getStage());
+}
+
+
+void PreparedPipeline::findReaders(Stage *stage)
+{
+    if (!stage)
+        return;
+    if (stage->getInputs().empty() &&
+        std::find(m_readers.begin(), m_readers.end(), stage) ==
+            m_readers.end())
+        m_readers.push_back(stage);
+    for (Stage *input : stage->getInputs())
+        findReaders(input);
+}
+
+
+void PreparedPipeline::setFilename(Stage *stage, const std::string& filename)
+{
+    Options opts = stage->getOptions();
+    opts.remove("filename");
+    opts.add("filename", filename);
+    stage->setOptions(opts);
+}
+
+
+point_count_t PreparedPipeline::execute(const std::string& inFilename,
+    const std::string& outFilename)
+{
+    Stage *s = getStage();
+    if (!s)
+        return 0;
+
+    for (Stage *reader : m_readers)
+        setFilename(reader, inFilename);
+    if (m_isWriter && outFilename.size())
+        setFilename(s, outFilename);
+
+    // The views refer to the table, so they go first.
+    m_viewSet.clear();
+    m_table.reset(new PointTable());
+    s->prepare(*m_table);
+    m_viewSet = s->execute(*m_table);
+
+    point_count_t cnt = 0;
+    for (auto const& view : m_viewSet)
+        cnt += view->size();
+    return cnt;
+}
+
+} // namespace pdal
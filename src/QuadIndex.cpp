@@ -32,13 +32,19 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <algorithm>
 #include <limits>
 #include <cmath>
+#include <cstring>
 #include <memory>
 
+#include <pdal/MemoryAccount.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/QuadIndex.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/Utils.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/MappedFile.hpp>
 
 namespace
 {
@@ -86,11 +92,14 @@ namespace
         }
 
         // Returns true if the requested point is contained within this BBox.
-        bool contains(const Point& p) const
+        bool contains(double x, double y) const
         {
-            return p.x >= min.x && p.y >= min.y && p.x < max.x && p.y < max.y;
+            return x >= min.x && y >= min.y && x < max.x && y < max.y;
         }
 
+        // Returns the bounds of a quadrant of this BBox.
+        BBox quadrant(int q) const;
+
         const Point min;
         const Point max;
 
@@ -104,384 +113,69 @@ namespace
         BBox& operator=(const BBox&); // not implemented
     };
 
-} // anonymous namespace
-
-namespace pdal
-{
-
-// Recursive quadtree implementation.
-struct Tree
-{
-    Tree(BBox bbox, const QuadPointRef* data = 0)
-        : bbox(bbox)
-        , data(data)
-        , nw()
-        , ne()
-        , se()
-        , sw()
-    { }
-
-    void getFills(std::vector<std::size_t>& fills, std::size_t level = 0) const;
-
-    // Returns depth resulting from the insertion of this point.
-    std::size_t addPoint(const QuadPointRef* toAdd, std::size_t curDepth = 0);
-
-    void getPoints(
-            std::vector<PointId>& results,
-            std::size_t depthBegin,
-            std::size_t depthEnd,
-            std::size_t curDepth) const;
-
-    void getPoints(
-            std::vector<PointId>& results,
-            std::size_t rasterize,
-            double xBegin,
-            double xEnd,
-            double xStep,
-            double yBegin,
-            double yEnd,
-            double yStep,
-            std::size_t curDepth) const;
-
-    void getPoints(
-            std::vector<PointId>& results,
-            double xBegin,
-            double xEnd,
-            double xStep,
-            double yBegin,
-            double yEnd,
-            double yStep) const;
-
-    void getPoints(
-            std::vector<PointId>& results,
-            const BBox& query,
-            std::size_t depthBegin,
-            std::size_t depthEnd,
-            std::size_t curDepth) const;
-
-    const BBox bbox;
-    const QuadPointRef* data;
-
-    std::unique_ptr<Tree> nw;
-    std::unique_ptr<Tree> ne;
-    std::unique_ptr<Tree> se;
-    std::unique_ptr<Tree> sw;
-};
-
-std::size_t Tree::addPoint(const QuadPointRef* toAdd, const std::size_t curDepth)
-{
-    if (data)
-    {
-        const Point& center(bbox.center);
-
-        if (toAdd->point.sqDist(center) < data->point.sqDist(center))
-        {
-            std::swap(data, toAdd);
-        }
-
-        const std::size_t nextDepth(curDepth + 1);
-
-        if (toAdd->point.x < center.x)
-        {
-            if (toAdd->point.y < center.y)
-            {
-                if (sw)
-                {
-                    return sw->addPoint(toAdd, nextDepth);
-                }
-                else
-                {
-                    sw.reset(new Tree(
-                            BBox(
-                                Point(bbox.min.x, bbox.min.y),
-                                Point(center.x, center.y)),
-                            toAdd));
-
-                    return nextDepth;
-                }
-            }
-            else
-            {
-                if (nw)
-                {
-                    return nw->addPoint(toAdd, nextDepth);
-                }
-                else
-                {
-                    nw.reset(new Tree(
-                            BBox(
-                                Point(bbox.min.x, center.y),
-                                Point(center.x, bbox.max.y)),
-                            toAdd));
-
-                    return nextDepth;
-                }
-            }
-        }
-        else
-        {
-            if (toAdd->point.y < center.y)
-            {
-                if (se)
-                {
-                    return se->addPoint(toAdd, nextDepth);
-                }
-                else
-                {
-                    se.reset(new Tree(
-                            BBox(
-                                Point(center.x, bbox.min.y),
-                                Point(bbox.max.x, center.y)),
-                            toAdd));
-
-                    return nextDepth;
-                }
-            }
-            else
-            {
-                if (ne)
-                {
-                    return ne->addPoint(toAdd, nextDepth);
-                }
-                else
-                {
-                    ne.reset(new Tree(
-                            BBox(
-                                Point(center.x, center.y),
-                                Point(bbox.max.x, bbox.max.y)),
-                            toAdd));
-
-                    return nextDepth;
-                }
-            }
-        }
-    }
-    else
+    // Quadrants, in the order that children are stored and visited.
+    enum Quadrant
     {
-        data = toAdd;
-        return curDepth;
-    }
-}
+        Nw,
+        Ne,
+        Se,
+        Sw
+    };
 
-void Tree::getFills(std::vector<std::size_t>& fills, std::size_t level) const
-{
-    if (data)
+    BBox BBox::quadrant(int q) const
     {
-        if (level >= fills.size())
+        switch (q)
         {
-            fills.resize(level + 1);
+        case Nw:
+            return BBox(Point(min.x, center.y), Point(center.x, max.y));
+        case Ne:
+            return BBox(Point(center.x, center.y), Point(max.x, max.y));
+        case Se:
+            return BBox(Point(center.x, min.y), Point(max.x, center.y));
+        default:
+            return BBox(Point(min.x, min.y), Point(center.x, center.y));
         }
-
-        ++fills.at(level);
-    }
-
-    ++level;
-
-    if (nw) nw->getFills(fills, level);
-    if (ne) ne->getFills(fills, level);
-    if (sw) sw->getFills(fills, level);
-    if (se) se->getFills(fills, level);
-}
-
-void Tree::getPoints(
-        std::vector<PointId>& results,
-        const std::size_t depthBegin,
-        const std::size_t depthEnd,
-        std::size_t curDepth) const
-{
-    if (data && curDepth >= depthBegin)
-    {
-        results.push_back(data->pbIndex);
-    }
-
-    if (++curDepth < depthEnd || depthEnd == 0)
-    {
-        if (nw) nw->getPoints(results, depthBegin, depthEnd, curDepth);
-        if (ne) ne->getPoints(results, depthBegin, depthEnd, curDepth);
-        if (se) se->getPoints(results, depthBegin, depthEnd, curDepth);
-        if (sw) sw->getPoints(results, depthBegin, depthEnd, curDepth);
     }
-}
-
-void Tree::getPoints(
-        std::vector<PointId>& results,
-        const std::size_t rasterize,
-        const double xBegin,
-        const double xEnd,
-        const double xStep,
-        const double yBegin,
-        const double yEnd,
-        const double yStep,
-        std::size_t curDepth) const
-{
-    if (curDepth == rasterize)
-    {
-        if (data)
-        {
-            const std::size_t xOffset(
-                    Utils::sround((bbox.center.x - xBegin) / xStep));
-            const double yOffset(
-                    Utils::sround((bbox.center.y - yBegin) / yStep));
 
-            const std::size_t index(
-                Utils::sround(yOffset * (xEnd - xBegin) / xStep + xOffset));
+    // A saved index is a header of the magic, the version, the number of
+    // points and a hash of their coordinates, then the bounds and depth of
+    // the tree and its nodes.  Values are in the byte order of the machine.
+    const char quadMagic[8] = { 'P', 'D', 'A', 'L', 'Q', 'D', 'I', 'X' };
+    const uint32_t quadVersion = 2;
 
-            results.at(index) = data->pbIndex;
-        }
-    }
-    else if (++curDepth <= rasterize)
+    template<typename T>
+    void append(std::ostream& out, const T& value)
     {
-        if (nw) nw->getPoints(
-                results,
-                rasterize,
-                xBegin,
-                xEnd,
-                xStep,
-                yBegin,
-                yEnd,
-                yStep,
-                curDepth);
-
-        if (ne) ne->getPoints(
-                results,
-                rasterize,
-                xBegin,
-                xEnd,
-                xStep,
-                yBegin,
-                yEnd,
-                yStep,
-                curDepth);
-
-        if (se) se->getPoints(
-                results,
-                rasterize,
-                xBegin,
-                xEnd,
-                xStep,
-                yBegin,
-                yEnd,
-                yStep,
-                curDepth);
-
-        if (sw) sw->getPoints(
-                results,
-                rasterize,
-                xBegin,
-                xEnd,
-                xStep,
-                yBegin,
-                yEnd,
-                yStep,
-                curDepth);
+        out.write((const char *)&value, sizeof(value));
     }
-}
 
-void Tree::getPoints(
-        std::vector<PointId>& results,
-        const double xBegin,
-        const double xEnd,
-        const double xStep,
-        const double yBegin,
-        const double yEnd,
-        const double yStep) const
-{
-    if (!bbox.overlaps(xBegin, xEnd, yBegin, yEnd))
+    template<typename T>
+    bool extract(const char*& pos, const char *end, T& value)
     {
-        return;
+        if (end - pos < (std::ptrdiff_t)sizeof(value))
+            return false;
+        memcpy(&value, pos, sizeof(value));
+        pos += sizeof(value);
+        return true;
     }
 
-    if (nw) nw->getPoints(
-            results,
-            xBegin,
-            xEnd,
-            xStep,
-            yBegin,
-            yEnd,
-            yStep);
-
-    if (ne) ne->getPoints(
-            results,
-            xBegin,
-            xEnd,
-            xStep,
-            yBegin,
-            yEnd,
-            yStep);
-
-    if (se) se->getPoints(
-            results,
-            xBegin,
-            xEnd,
-            xStep,
-            yBegin,
-            yEnd,
-            yStep);
-
-    if (sw) sw->getPoints(
-            results,
-            xBegin,
-            xEnd,
-            xStep,
-            yBegin,
-            yEnd,
-            yStep);
-
-    // Add data after calling child nodes so we prefer upper levels of the tree.
-    if (
-            data &&
-            data->point.x >= xBegin &&
-            data->point.y >= yBegin &&
-            data->point.x < xEnd - xStep &&
-            data->point.y < yEnd - yStep)
-    {
-        const std::size_t xOffset(
-                Utils::sround((data->point.x - xBegin) / xStep));
-        const std::size_t yOffset(
-                Utils::sround((data->point.y - yBegin) / yStep));
-
-        const std::size_t index(
-            Utils::sround(yOffset * (xEnd - xBegin) / xStep + xOffset));
-
-        if (index < results.size())
-        {
-            results.at(index) = data->pbIndex;
-        }
-    }
-}
+} // anonymous namespace
 
-void Tree::getPoints(
-        std::vector<PointId>& results,
-        const BBox& query,
-        const std::size_t depthBegin,
-        const std::size_t depthEnd,
-        std::size_t curDepth) const
+namespace pdal
 {
-    if (!query.overlaps(bbox))
-    {
-        return;
-    }
-
-    if (data &&
-        query.contains(data->point) &&
-        curDepth >= depthBegin &&
-        (curDepth < depthEnd || depthEnd == 0))
-    {
-        results.push_back(data->pbIndex);
-    }
-
-    if (++curDepth < depthEnd || depthEnd == 0)
-    {
-        if (nw) nw->getPoints(results, query, depthBegin, depthEnd, curDepth);
-        if (ne) ne->getPoints(results, query, depthBegin, depthEnd, curDepth);
-        if (se) se->getPoints(results, query, depthBegin, depthEnd, curDepth);
-        if (sw) sw->getPoints(results, query, depthBegin, depthEnd, curDepth);
-    }
-}
 
+// The quadtree is stored flat.  Each node holds one point, the one nearest
+// the center of the node's bounds among the points that fall within them
+// and aren't held higher up.  The rest are passed to the four quadrants.
+// Nodes are stored in preorder, so the subtree of a node is the range of
+// nodes starting at it, and its first child directly follows it.
 struct QuadIndex::QImpl
 {
     QImpl(const PointView& view, std::size_t topLevel);
+    QImpl(
+            const PointView& view,
+            const std::string& cacheFile,
+            std::size_t topLevel);
     QImpl(
             const PointView& view,
             double xMin,
@@ -536,48 +230,114 @@ struct QuadIndex::QImpl
             std::size_t depthBegin,
             std::size_t depthEnd) const;
 
+    std::vector<PointId> getNextLevels(
+            const BOX3D* box,
+            std::size_t& cursor,
+            std::size_t levels) const;
+
+    void save(const std::string& filename) const;
+
+private:
+    struct Entry
+    {
+        double x;
+        double y;
+        PointId id;
+    };
+    // Storage of the tree, charged to the current memory account.
+    template<typename T>
+    using Nodes = memory::Vector<T, memory::SpatialIndex>;
+
     std::size_t m_topLevel;
-    std::vector<std::shared_ptr<QuadPointRef> > m_pointRefVec;
-    std::unique_ptr<Tree> m_tree;
+    // The point of each node.
+    Nodes<Entry> m_points;
+    // The number of nodes in the subtree of each node.
+    Nodes<PointId> m_sizes;
+    // Bit q is set when a node has a child in quadrant q.
+    Nodes<uint8_t> m_quadrants;
+    // Space to group points by quadrant while building.
+    Nodes<Entry> m_scratch;
+    std::unique_ptr<BBox> m_bbox;
     std::size_t m_depth;
     std::vector<std::size_t> m_fills;
+
+    void readPoints(const PointView& view);
+    void buildTree();
+    void buildTree(double xMin, double yMin, double xMax, double yMax);
+    std::size_t build(
+            PointId begin,
+            PointId end,
+            const BBox& bbox,
+            std::size_t curDepth);
+    bool load(const std::string& filename);
+    static uint64_t hash(const Nodes<Entry>& points);
+
+    template<typename F>
+    void forChildren(PointId node, F f) const;
+
+    void getFills(PointId node, std::size_t level);
+
+    void getPoints(
+            std::vector<PointId>& results,
+            PointId node,
+            std::size_t depthBegin,
+            std::size_t depthEnd,
+            std::size_t curDepth) const;
+
+    void getPoints(
+            std::vector<PointId>& results,
+            PointId node,
+            const BBox& bbox,
+            std::size_t rasterize,
+            double xBegin,
+            double xEnd,
+            double xStep,
+            double yBegin,
+            double yEnd,
+            double yStep,
+            std::size_t curDepth) const;
+
+    void getPoints(
+            std::vector<PointId>& results,
+            PointId node,
+            const BBox& bbox,
+            double xBegin,
+            double xEnd,
+            double xStep,
+            double yBegin,
+            double yEnd,
+            double yStep) const;
+
+    void getPoints(
+            std::vector<PointId>& results,
+            PointId node,
+            const BBox& bbox,
+            const BBox& query,
+            std::size_t depthBegin,
+            std::size_t depthEnd,
+            std::size_t curDepth) const;
 };
 
 QuadIndex::QImpl::QImpl(const PointView& view, std::size_t topLevel)
     : m_topLevel(topLevel)
-    , m_pointRefVec()
-    , m_tree()
     , m_depth(0)
-    , m_fills()
 {
-    m_pointRefVec.resize(view.size());
-
-    double xMin(std::numeric_limits<double>::max());
-    double yMin(std::numeric_limits<double>::max());
-    double xMax(std::numeric_limits<double>::min());
-    double yMax(std::numeric_limits<double>::min());
-
-    for (PointId i(0); i < view.size(); ++i)
-    {
-        m_pointRefVec[i].reset(
-                new QuadPointRef(
-                    Point(
-                        view.getFieldAs<double>(Dimension::Id::X, i),
-                        view.getFieldAs<double>(Dimension::Id::Y, i)),
-                i));
-
-        const QuadPointRef* pointRef(m_pointRefVec[i].get());
-        if (pointRef->point.x < xMin) xMin = pointRef->point.x;
-        if (pointRef->point.x > xMax) xMax = pointRef->point.x;
-        if (pointRef->point.y < yMin) yMin = pointRef->point.y;
-        if (pointRef->point.y > yMax) yMax = pointRef->point.y;
-    }
-
-    m_tree.reset(new Tree(BBox(Point(xMin, yMin), Point(xMax, yMax))));
+    readPoints(view);
+    buildTree();
+}
 
-    for (std::size_t i = 0; i < m_pointRefVec.size(); ++i)
+QuadIndex::QImpl::QImpl(
+        const PointView& view,
+        const std::string& cacheFile,
+        std::size_t topLevel)
+    : m_topLevel(topLevel)
+    , m_depth(0)
+{
+    readPoints(view);
+    if (!load(cacheFile))
     {
-        m_depth = std::max(m_tree->addPoint(m_pointRefVec[i].get()), m_depth);
+        buildTree();
+        save(cacheFile);
     }
 }
 
@@ -589,51 +349,343 @@ QuadIndex::QImpl::QImpl(
         double yMax,
         std::size_t topLevel)
     : m_topLevel(topLevel)
-    , m_pointRefVec()
-    , m_tree()
     , m_depth(0)
-    , m_fills()
 {
-    m_pointRefVec.resize(view.size());
+    readPoints(view);
+    buildTree(xMin, yMin, xMax, yMax);
+}
+
+QuadIndex::QImpl::QImpl(
+        const std::vector<std::shared_ptr<QuadPointRef> >& points,
+        double xMin,
+        double yMin,
+        double xMax,
+        double yMax,
+        std::size_t topLevel)
+    : m_topLevel(topLevel)
+    , m_depth(0)
+{
+    m_points.resize(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        m_points[i].x = points[i]->point.x;
+        m_points[i].y = points[i]->point.y;
+        m_points[i].id = (PointId)points[i]->pbIndex;
+    }
+    buildTree(xMin, yMin, xMax, yMax);
+}
+
+void QuadIndex::QImpl::readPoints(const PointView& view)
+{
+    const point_count_t batchSize = 4096;
+    std::vector<double> xs(batchSize);
+    std::vector<double> ys(batchSize);
 
-    for (PointId i(0); i < view.size(); ++i)
+    m_points.resize(view.size());
+    for (PointId begin = 0; begin < view.size(); begin += batchSize)
     {
-        m_pointRefVec[i].reset(
-                new QuadPointRef(
-                    Point(
-                        view.getFieldAs<double>(Dimension::Id::X, i),
-                        view.getFieldAs<double>(Dimension::Id::Y, i)),
-                i));
+        point_count_t count = (std::min)(batchSize, view.size() - begin);
+        view.getFieldArray(Dimension::Id::X, begin, count, xs.data());
+        view.getFieldArray(Dimension::Id::Y, begin, count, ys.data());
+        for (PointId i = 0; i < count; ++i)
+        {
+            m_points[begin + i].x = xs[i];
+            m_points[begin + i].y = ys[i];
+            m_points[begin + i].id = begin + i;
+        }
     }
+}
 
-    m_tree.reset(new Tree(BBox(Point(xMin, yMin), Point(xMax, yMax))));
+void QuadIndex::QImpl::buildTree()
+{
+    double xMin(std::numeric_limits<double>::max());
+    double yMin(std::numeric_limits<double>::max());
+    double xMax(std::numeric_limits<double>::min());
+    double yMax(std::numeric_limits<double>::min());
 
-    for (std::size_t i = 0; i < m_pointRefVec.size(); ++i)
+    for (const Entry& e : m_points)
     {
-        m_depth = std::max(m_tree->addPoint(m_pointRefVec[i].get()), m_depth);
+        if (e.x < xMin) xMin = e.x;
+        if (e.x > xMax) xMax = e.x;
+        if (e.y < yMin) yMin = e.y;
+        if (e.y > yMax) yMax = e.y;
     }
+    buildTree(xMin, yMin, xMax, yMax);
 }
 
-QuadIndex::QImpl::QImpl(
-        const std::vector<std::shared_ptr<QuadPointRef> >& points,
+void QuadIndex::QImpl::buildTree(
         double xMin,
         double yMin,
         double xMax,
-        double yMax,
-        std::size_t topLevel)
-    : m_topLevel(topLevel)
-    , m_pointRefVec(points.size())
-    , m_tree()
-    , m_depth(0)
-    , m_fills()
+        double yMax)
 {
-    m_tree.reset(new Tree(BBox(Point(xMin, yMin), Point(xMax, yMax))));
+    m_bbox.reset(new BBox(Point(xMin, yMin), Point(xMax, yMax)));
+    m_sizes.resize(m_points.size());
+    m_quadrants.resize(m_points.size());
+    m_depth = 0;
+    m_fills.clear();
+    if (m_points.size())
+    {
+        m_scratch.resize(m_points.size());
+        m_depth = build(0, m_points.size(), *m_bbox, 0);
+        Nodes<Entry>().swap(m_scratch);
+    }
+}
 
-    for (std::size_t i = 0; i < points.size(); ++i)
+// Build the subtree of the points in [begin, end), which fall within
+// 'bbox', and return the depth of its deepest node.  The points are in the
+// order that they arrive at the node.  That order decides which point the
+// node keeps when two are as near its center, so it is kept for the points
+// passed on, to build the same tree as inserting the points one at a time.
+//
+// Nodes are built from a stack rather than by recursion, since points
+// outside the bounds of the tree form chains of nodes as deep as there
+// are points.  Large quadrants are built in parallel.
+std::size_t QuadIndex::QImpl::build(
+        PointId begin,
+        PointId end,
+        const BBox& bbox,
+        std::size_t curDepth)
+{
+    struct Task
+    {
+        PointId begin;
+        PointId end;
+        double bounds[4];
+        std::size_t depth;
+    };
+    const point_count_t parallelSize(16384);
+
+    std::vector<Task> tasks;
+    Task root = { begin, end,
+        { bbox.min.x, bbox.min.y, bbox.max.x, bbox.max.y }, curDepth };
+    tasks.push_back(root);
+
+    std::size_t maxDepth(curDepth);
+    while (tasks.size())
+    {
+        const Task task(tasks.back());
+        tasks.pop_back();
+        begin = task.begin;
+        end = task.end;
+        maxDepth = (std::max)(maxDepth, task.depth);
+
+        const BBox box(Point(task.bounds[0], task.bounds[1]),
+            Point(task.bounds[2], task.bounds[3]));
+        const Point& center(box.center);
+        auto sqDist = [&center](const Entry& e)
+        {
+            return (e.x - center.x) * (e.x - center.x) +
+                (e.y - center.y) * (e.y - center.y);
+        };
+
+        // Each point that arrives either replaces the one the node holds,
+        // if it's nearer the center, or is passed on.  The points passed
+        // on are left in the order that they leave the node.
+        Entry held(m_points[begin]);
+        double heldDist(sqDist(held));
+        for (PointId i = begin + 1; i < end; ++i)
+        {
+            const double dist(sqDist(m_points[i]));
+            if (dist < heldDist)
+            {
+                std::swap(held, m_points[i]);
+                heldDist = dist;
+            }
+        }
+        m_points[begin] = held;
+        m_sizes[begin] = end - begin;
+
+        // Group the rest by quadrant, keeping their order.  A point on a
+        // center line goes to the north or east.
+        auto quadrant = [&center](const Entry& e)
+        {
+            if (e.x < center.x)
+                return e.y < center.y ? Sw : Nw;
+            return e.y < center.y ? Se : Ne;
+        };
+        PointId bounds[5] = { 0, 0, 0, 0, 0 };
+        for (PointId i = begin + 1; i < end; ++i)
+            bounds[quadrant(m_points[i]) + 1]++;
+        bounds[0] = begin + 1;
+        for (int q = 0; q < 4; ++q)
+            bounds[q + 1] += bounds[q];
+
+        PointId next[4] = { bounds[0], bounds[1], bounds[2], bounds[3] };
+        for (PointId i = begin + 1; i < end; ++i)
+            m_scratch[next[quadrant(m_points[i])]++] = m_points[i];
+        std::copy(m_scratch.begin() + begin + 1, m_scratch.begin() + end,
+            m_points.begin() + begin + 1);
+
+        uint8_t quadrants(0);
+        int large(0);
+        for (int q = 0; q < 4; ++q)
+        {
+            if (bounds[q] != bounds[q + 1])
+                quadrants |= (1 << q);
+            if (bounds[q + 1] - bounds[q] >= parallelSize)
+                large++;
+        }
+        m_quadrants[begin] = quadrants;
+
+        // Quadrants of a node that splits into more than one large
+        // quadrant are built in parallel, each from its own stack.
+        if (large > 1)
+        {
+            std::size_t depths[4] = { 0, 0, 0, 0 };
+            auto buildQuadrants = [this, &bounds, &box, &depths, &task](
+                std::size_t first, std::size_t last)
+            {
+                for (std::size_t q = first; q < last; ++q)
+                    if (bounds[q] != bounds[q + 1])
+                        depths[q] = build(bounds[q], bounds[q + 1],
+                            box.quadrant(q), task.depth + 1);
+            };
+            ThreadPool::shared().parallelFor(4, 1, buildQuadrants);
+            maxDepth = (std::max)(maxDepth,
+                *std::max_element(depths, depths + 4));
+            continue;
+        }
+
+        for (int q = 0; q < 4; ++q)
+        {
+            if (bounds[q] == bounds[q + 1])
+                continue;
+            const BBox child(box.quadrant(q));
+            Task t = { bounds[q], bounds[q + 1],
+                { child.min.x, child.min.y, child.max.x, child.max.y },
+                task.depth + 1 };
+            tasks.push_back(t);
+        }
+    }
+    return maxDepth;
+}
+
+// Call f(child, quadrant) for each child of 'node'.
+template<typename F>
+void QuadIndex::QImpl::forChildren(PointId node, F f) const
+{
+    PointId child(node + 1);
+    for (int q = 0; q < 4; ++q)
+        if (m_quadrants[node] & (1 << q))
+        {
+            f(child, q);
+            child += m_sizes[child];
+        }
+}
+
+uint64_t QuadIndex::QImpl::hash(const Nodes<Entry>& points)
+{
+    uint64_t h = Utils::hash64(NULL, 0);
+    for (const Entry& e : points)
+    {
+        h = Utils::hash64(&e.x, sizeof(double), h);
+        h = Utils::hash64(&e.y, sizeof(double), h);
+    }
+    return h;
+}
+
+// Load the tree of the points just read from a view.
+bool QuadIndex::QImpl::load(const std::string& filename)
+{
+    if (!FileUtils::fileExists(filename))
+        return false;
+
+    MappedFile file;
+    try
+    {
+        file.open(filename);
+    }
+    catch (pdal_error&)
+    {
+        return false;
+    }
+
+    const char *pos = file.data();
+    const char *end = pos + file.size();
+    char magic[8];
+    uint32_t version;
+    uint64_t count;
+    uint64_t h;
+    double bounds[4];
+    uint64_t depth;
+    if (!extract(pos, end, magic) ||
+        memcmp(magic, quadMagic, sizeof(magic)) != 0 ||
+        !extract(pos, end, version) || version != quadVersion ||
+        !extract(pos, end, count) || count != m_points.size() ||
+        !extract(pos, end, h) || h != hash(m_points) ||
+        !extract(pos, end, bounds) || !extract(pos, end, depth))
+        return false;
+
+    const std::size_t nodeSize(2 * sizeof(PointId) + sizeof(uint8_t));
+    if ((std::size_t)(end - pos) != count * nodeSize)
+        return false;
+
+    std::vector<PointId> ids(count);
+    Nodes<PointId> sizes(count);
+    Nodes<uint8_t> quadrants(count);
+    memcpy(ids.data(), pos, count * sizeof(PointId));
+    pos += count * sizeof(PointId);
+    memcpy(sizes.data(), pos, count * sizeof(PointId));
+    pos += count * sizeof(PointId);
+    memcpy(quadrants.data(), pos, count);
+    for (std::size_t i = 0; i < count; ++i)
+        if (ids[i] >= count || sizes[i] == 0 || sizes[i] > count - i ||
+            quadrants[i] > 15)
+            return false;
+
+    Nodes<Entry> points(count);
+    for (std::size_t i = 0; i < count; ++i)
+        points[i] = m_points[ids[i]];
+    m_points.swap(points);
+    m_sizes.swap(sizes);
+    m_quadrants.swap(quadrants);
+    m_bbox.reset(new BBox(Point(bounds[0], bounds[1]),
+        Point(bounds[2], bounds[3])));
+    m_depth = depth;
+    return true;
+}
+
+void QuadIndex::QImpl::save(const std::string& filename) const
+{
+    if (!m_bbox)
+        throw pdal_error("QuadIndex: can't save an empty index.");
+
+    // Hash the points in the order of the view that they came from.
+    Nodes<Entry> points(m_points.size());
+    for (const Entry& e : m_points)
     {
-        m_pointRefVec[i] = points[i];
-        m_depth = std::max(m_tree->addPoint(m_pointRefVec[i].get()), m_depth);
+        if (e.id >= points.size())
+            throw pdal_error("QuadIndex: can only save an index of the "
+                "points of a view.");
+        points[e.id] = e;
     }
+    const uint64_t h(hash(points));
+
+    std::ostream *ostr = FileUtils::createFile(filename, true);
+    if (!ostr)
+        throw pdal_error("QuadIndex: unable to open '" + filename +
+            "' for writing.");
+
+    ostr->write(quadMagic, sizeof(quadMagic));
+    append(*ostr, quadVersion);
+    append(*ostr, (uint64_t)m_points.size());
+    append(*ostr, h);
+    append(*ostr, m_bbox->min.x);
+    append(*ostr, m_bbox->min.y);
+    append(*ostr, m_bbox->max.x);
+    append(*ostr, m_bbox->max.y);
+    append(*ostr, (uint64_t)m_depth);
+    for (const Entry& e : m_points)
+        append(*ostr, e.id);
+    ostr->write((const char *)m_sizes.data(),
+        m_sizes.size() * sizeof(PointId));
+    ostr->write((const char *)m_quadrants.data(), m_quadrants.size());
+
+    bool ok(ostr->good());
+    FileUtils::closeFile(ostr);
+    if (!ok)
+        throw pdal_error("QuadIndex: error writing '" + filename + "'.");
 }
 
 void QuadIndex::QImpl::getBounds(
@@ -642,12 +694,12 @@ void QuadIndex::QImpl::getBounds(
         double& xMax,
         double& yMax) const
 {
-    if (m_tree)
+    if (m_bbox)
     {
-        xMin = m_tree->bbox.min.x;
-        yMin = m_tree->bbox.min.y;
-        xMax = m_tree->bbox.max.x;
-        yMax = m_tree->bbox.max.y;
+        xMin = m_bbox->min.x;
+        yMin = m_bbox->min.y;
+        xMax = m_bbox->max.x;
+        yMax = m_bbox->max.y;
     }
 }
 
@@ -658,28 +710,64 @@ std::size_t QuadIndex::QImpl::getDepth() const
 
 std::vector<std::size_t> QuadIndex::QImpl::getFills()
 {
-    if (m_tree && !m_fills.size())
+    if (m_points.size() && !m_fills.size())
     {
-        m_tree->getFills(m_fills);
+        getFills(0, 0);
     }
 
     return m_fills;
 }
 
+void QuadIndex::QImpl::getFills(PointId node, std::size_t level)
+{
+    if (level >= m_fills.size())
+    {
+        m_fills.resize(level + 1);
+    }
+
+    ++m_fills.at(level);
+
+    forChildren(node, [this, level](PointId child, int)
+        { getFills(child, level + 1); });
+}
+
 std::vector<PointId> QuadIndex::QImpl::getPoints(
         const std::size_t minDepth,
         const std::size_t maxDepth) const
 {
     std::vector<PointId> results;
 
-    if (m_tree)
+    if (m_points.size())
     {
-        m_tree->getPoints(results, minDepth, maxDepth, m_topLevel);
+        getPoints(results, 0, minDepth, maxDepth, m_topLevel);
     }
 
     return results;
 }
 
+void QuadIndex::QImpl::getPoints(
+        std::vector<PointId>& results,
+        const PointId node,
+        const std::size_t depthBegin,
+        const std::size_t depthEnd,
+        std::size_t curDepth) const
+{
+    if (curDepth >= depthBegin)
+    {
+        results.push_back(m_points[node].id);
+    }
+
+    if (++curDepth < depthEnd || depthEnd == 0)
+    {
+        forChildren(node,
+            [this, &results, depthBegin, depthEnd, curDepth](
+                PointId child, int)
+            {
+                getPoints(results, child, depthBegin, depthEnd, curDepth);
+            });
+    }
+}
+
 std::vector<PointId> QuadIndex::QImpl::getPoints(
         const std::size_t rasterize,
         double& xBegin,
@@ -691,36 +779,84 @@ std::vector<PointId> QuadIndex::QImpl::getPoints(
 {
     std::vector<PointId> results;
 
-    if (m_tree)
+    if (m_bbox)
     {
         const std::size_t exp(std::pow(2, rasterize));
-        const double xWidth(m_tree->bbox.max.x - m_tree->bbox.min.x);
-        const double yWidth(m_tree->bbox.max.y - m_tree->bbox.min.y);
+        const double xWidth(m_bbox->max.x - m_bbox->min.x);
+        const double yWidth(m_bbox->max.y - m_bbox->min.y);
 
         xStep = xWidth / exp;
         yStep = yWidth / exp;
-        xBegin =    m_tree->bbox.min.x + (xStep / 2);
-        yBegin =    m_tree->bbox.min.y + (yStep / 2);
-        xEnd =      m_tree->bbox.max.x + (xStep / 2); // One tick past the end.
-        yEnd =      m_tree->bbox.max.y + (yStep / 2);
+        xBegin =    m_bbox->min.x + (xStep / 2);
+        yBegin =    m_bbox->min.y + (yStep / 2);
+        xEnd =      m_bbox->max.x + (xStep / 2); // One tick past the end.
+        yEnd =      m_bbox->max.y + (yStep / 2);
 
         results.resize(exp * exp, std::numeric_limits<PointId>::max());
 
-        m_tree->getPoints(
-                results,
-                rasterize,
-                xBegin,
-                xEnd,
-                xStep,
-                yBegin,
-                yEnd,
-                yStep,
-                m_topLevel);
+        if (m_points.size())
+            getPoints(
+                    results,
+                    0,
+                    *m_bbox,
+                    rasterize,
+                    xBegin,
+                    xEnd,
+                    xStep,
+                    yBegin,
+                    yEnd,
+                    yStep,
+                    m_topLevel);
     }
 
     return results;
 }
 
+void QuadIndex::QImpl::getPoints(
+        std::vector<PointId>& results,
+        const PointId node,
+        const BBox& bbox,
+        const std::size_t rasterize,
+        const double xBegin,
+        const double xEnd,
+        const double xStep,
+        const double yBegin,
+        const double yEnd,
+        const double yStep,
+        std::size_t curDepth) const
+{
+    if (curDepth == rasterize)
+    {
+        const std::size_t xOffset(
+                Utils::sround((bbox.center.x - xBegin) / xStep));
+        const double yOffset(
+                Utils::sround((bbox.center.y - yBegin) / yStep));
+
+        const std::size_t index(
+            Utils::sround(yOffset * (xEnd - xBegin) / xStep + xOffset));
+
+        results.at(index) = m_points[node].id;
+    }
+    else if (++curDepth <= rasterize)
+    {
+        forChildren(node, [&](PointId child, int q)
+            {
+                getPoints(
+                        results,
+                        child,
+                        bbox.quadrant(q),
+                        rasterize,
+                        xBegin,
+                        xEnd,
+                        xStep,
+                        yBegin,
+                        yEnd,
+                        yStep,
+                        curDepth);
+            });
+    }
+}
+
 std::vector<PointId> QuadIndex::QImpl::getPoints(
         const double xBegin,
         const double xEnd,
@@ -731,25 +867,81 @@ std::vector<PointId> QuadIndex::QImpl::getPoints(
 {
     std::vector<PointId> results;
 
-    if (m_tree)
+    if (m_bbox)
     {
         const std::size_t width (Utils::sround((xEnd - xBegin) / xStep));
         const std::size_t height(Utils::sround((yEnd - yBegin) / yStep));
         results.resize(width * height, std::numeric_limits<PointId>::max());
 
-        m_tree->getPoints(
-                results,
-                xBegin,
-                xEnd,
-                xStep,
-                yBegin,
-                yEnd,
-                yStep);
+        if (m_points.size())
+            getPoints(
+                    results,
+                    0,
+                    *m_bbox,
+                    xBegin,
+                    xEnd,
+                    xStep,
+                    yBegin,
+                    yEnd,
+                    yStep);
     }
 
     return results;
 }
 
+void QuadIndex::QImpl::getPoints(
+        std::vector<PointId>& results,
+        const PointId node,
+        const BBox& bbox,
+        const double xBegin,
+        const double xEnd,
+        const double xStep,
+        const double yBegin,
+        const double yEnd,
+        const double yStep) const
+{
+    if (!bbox.overlaps(xBegin, xEnd, yBegin, yEnd))
+    {
+        return;
+    }
+
+    forChildren(node, [&](PointId child, int q)
+        {
+            getPoints(
+                    results,
+                    child,
+                    bbox.quadrant(q),
+                    xBegin,
+                    xEnd,
+                    xStep,
+                    yBegin,
+                    yEnd,
+                    yStep);
+        });
+
+    // Add data after calling child nodes so we prefer upper levels of the tree.
+    const Entry& data(m_points[node]);
+    if (
+            data.x >= xBegin &&
+            data.y >= yBegin &&
+            data.x < xEnd - xStep &&
+            data.y < yEnd - yStep)
+    {
+        const std::size_t xOffset(
+                Utils::sround((data.x - xBegin) / xStep));
+        const std::size_t yOffset(
+                Utils::sround((data.y - yBegin) / yStep));
+
+        const std::size_t index(
+            Utils::sround(yOffset * (xEnd - xBegin) / xStep + xOffset));
+
+        if (index < results.size())
+        {
+            results.at(index) = data.id;
+        }
+    }
+}
+
 std::vector<PointId> QuadIndex::QImpl::getPoints(
         double xMin,
         double yMin,
@@ -761,10 +953,12 @@ std::vector<PointId> QuadIndex::QImpl::getPoints(
     std::vector<PointId> results;
 
     // Making BBox from external parameters here, so do some light validation.
-    if (m_tree)
+    if (m_points.size())
     {
-        m_tree->getPoints(
+        getPoints(
                 results,
+                0,
+                *m_bbox,
                 BBox(
                     Point(std::min(xMin, xMax), std::min(yMin, yMax)),
                     Point(std::max(xMin, xMax), std::max(yMin, yMax))),
@@ -776,6 +970,59 @@ std::vector<PointId> QuadIndex::QImpl::getPoints(
     return results;
 }
 
+void QuadIndex::QImpl::getPoints(
+        std::vector<PointId>& results,
+        const PointId node,
+        const BBox& bbox,
+        const BBox& query,
+        const std::size_t depthBegin,
+        const std::size_t depthEnd,
+        std::size_t curDepth) const
+{
+    if (!query.overlaps(bbox))
+    {
+        return;
+    }
+
+    const Entry& data(m_points[node]);
+    if (query.contains(data.x, data.y) &&
+        curDepth >= depthBegin &&
+        (curDepth < depthEnd || depthEnd == 0))
+    {
+        results.push_back(data.id);
+    }
+
+    if (++curDepth < depthEnd || depthEnd == 0)
+    {
+        forChildren(node, [&](PointId child, int q)
+            {
+                getPoints(results, child, bbox.quadrant(q), query,
+                    depthBegin, depthEnd, curDepth);
+            });
+    }
+}
+
+std::vector<PointId> QuadIndex::QImpl::getNextLevels(
+        const BOX3D* box,
+        std::size_t& cursor,
+        std::size_t levels) const
+{
+    std::vector<PointId> results;
+    if (!levels || !m_points.size() || cursor > m_depth)
+        return results;
+
+    const std::size_t depthBegin(m_topLevel + cursor);
+    const std::size_t depthEnd(depthBegin + levels);
+    if (box)
+        results = getPoints(box->minx, box->miny, box->maxx, box->maxy,
+            depthBegin, depthEnd);
+    else
+        results = getPoints(depthBegin, depthEnd);
+    cursor += levels;
+
+    return results;
+}
+
 QuadIndex::QuadIndex(const PointView& view, std::size_t topLevel)
     : m_qImpl(new QImpl(view, topLevel))
 { }
@@ -800,9 +1047,21 @@ QuadIndex::QuadIndex(
     : m_qImpl(new QImpl(points, xMin, yMin, xMax, yMax, topLevel))
 { }
 
+QuadIndex::QuadIndex(
+        const PointView& view,
+        const std::string& cacheFile,
+        std::size_t topLevel)
+    : m_qImpl(new QImpl(view, cacheFile, topLevel))
+{ }
+
 QuadIndex::~QuadIndex()
 { }
 
+void QuadIndex::save(const std::string& filename) const
+{
+    m_qImpl->save(filename);
+}
+
 void QuadIndex::getBounds(
         double& xMin,
         double& yMin,
@@ -904,5 +1163,20 @@ std::vector<PointId> QuadIndex::getPoints(
             depthEnd);
 }
 
+std::vector<PointId> QuadIndex::getNextLevels(
+        std::size_t& cursor,
+        std::size_t levels) const
+{
+    return m_qImpl->getNextLevels(nullptr, cursor, levels);
+}
+
+std::vector<PointId> QuadIndex::getNextLevels(
+        const BOX3D& box,
+        std::size_t& cursor,
+        std::size_t levels) const
+{
+    return m_qImpl->getNextLevels(&box, cursor, levels);
+}
+
 } // namespace pdal
 
@@ -0,0 +1,113 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/RadixSort.hpp>
+#include <pdal/ThreadPool.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace pdal
+{
+
+// The pairs are split into a chunk for each worker.  Each pass over a byte
+// of the keys counts the digits of each chunk in parallel and then
+// scatters each chunk to its place.  Passes over bytes that are the same
+// for every key are skipped.
+void radixSort(std::vector<RadixPair>& pairs)
+{
+    ThreadPool& pool = ThreadPool::shared();
+    const size_t count = pairs.size();
+    const size_t chunks = (std::max)((size_t)1,
+        (std::min)(pool.size(), count / 65536));
+    auto chunkBegin = [count, chunks](size_t c)
+        { return (count * c) / chunks; };
+
+    std::vector<RadixPair> buf(count);
+    std::vector<RadixPair> *src = &pairs;
+    std::vector<RadixPair> *dst = &buf;
+    std::vector<std::array<size_t, 256>> counts(chunks);
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        pool.parallelFor(chunks, 1, [&](size_t first, size_t last)
+        {
+            for (size_t c = first; c < last; ++c)
+            {
+                std::array<size_t, 256>& cnt = counts[c];
+                cnt.fill(0);
+                for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i)
+                    cnt[((*src)[i].first >> shift) & 0xFF]++;
+            }
+        });
+
+        // Turn the counts into the position at which each chunk writes
+        // each digit.
+        size_t pos = 0;
+        bool trivial = false;
+        for (size_t digit = 0; digit < 256; ++digit)
+        {
+            size_t total = 0;
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                size_t n = counts[c][digit];
+                counts[c][digit] = pos;
+                pos += n;
+                total += n;
+            }
+            if (total == count)
+                trivial = true;
+        }
+        if (trivial)
+            continue;
+
+        pool.parallelFor(chunks, 1, [&](size_t first, size_t last)
+        {
+            for (size_t c = first; c < last; ++c)
+            {
+                std::array<size_t, 256>& offsets = counts[c];
+                for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i)
+                {
+                    const RadixPair& p = (*src)[i];
+                    (*dst)[offsets[(p.first >> shift) & 0xFF]++] = p;
+                }
+            }
+        });
+        std::swap(src, dst);
+    }
+    if (src != &pairs)
+        pairs.swap(*src);
+}
+
+} // namespace pdal
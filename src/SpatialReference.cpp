@@ -33,8 +33,12 @@
  ****************************************************************************/
 
 #include <pdal/SpatialReference.hpp>
+#include <pdal/GDALUtils.hpp>
 #include <pdal/PDALUtils.hpp>
 
+#include <map>
+#include <mutex>
+
 #include <boost/algorithm/string/trim.hpp>
 
 // gdal
@@ -60,6 +64,49 @@
 namespace pdal
 {
 
+namespace
+{
+
+// The answers to OGR queries about references, kept by WKT since the same
+// few references are asked about again and again.
+template <typename K, typename V>
+class Memo
+{
+public:
+    template <typename F>
+    V get(const K& key, F compute)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto vi = m_values.find(key);
+            if (vi != m_values.end())
+                return vi->second;
+        }
+        V v = compute();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_values.size() >= 1024)
+            m_values.clear();
+        m_values[key] = v;
+        return v;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::map<K, V> m_values;
+};
+
+typedef std::pair<std::string, int> WktKey;
+typedef std::pair<std::string, std::string> WktPair;
+
+Memo<WktKey, std::string> s_wkt;
+Memo<WktKey, std::string> s_parts;
+Memo<std::string, std::string> s_proj4;
+Memo<std::string, bool> s_geographic;
+Memo<WktPair, bool> s_same;
+
+} // unnamed namespace
+
+
 SpatialReference::SpatialReference(const std::string& s)
 {
     setFromUserInput(s);
@@ -83,25 +130,33 @@ std::string SpatialReference::getWKT(WKTModeFlag mode_flag , bool pretty) const
 {
     std::string result_wkt = m_wkt;
 
+    if (result_wkt.empty())
+        return result_wkt;
+
     if ((mode_flag == eHorizontalOnly
             && strstr(result_wkt.c_str(),"COMPD_CS") != NULL)
             || pretty)
     {
-        OGRSpatialReference* poSRS =
-            (OGRSpatialReference*)OSRNewSpatialReference(result_wkt.c_str());
-        char *pszWKT = NULL;
-
-        if (mode_flag == eHorizontalOnly)
-            poSRS->StripVertical();
-        if (pretty)
-            poSRS->exportToPrettyWkt(&pszWKT, FALSE);
-        else
-            poSRS->exportToWkt(&pszWKT);
-
-        OSRDestroySpatialReference(poSRS);
-
-        result_wkt = pszWKT;
-        CPLFree(pszWKT);
+        auto compute = [&result_wkt, mode_flag, pretty]()
+        {
+            gdal::SrsCache::ReferencePtr ref =
+                gdal::SrsCache::get().reference(result_wkt);
+            OGRSpatialReference* poSRS = (OGRSpatialReference*)ref.get();
+            char *pszWKT = NULL;
+
+            if (mode_flag == eHorizontalOnly)
+                poSRS->StripVertical();
+            if (pretty)
+                poSRS->exportToPrettyWkt(&pszWKT, FALSE);
+            else
+                poSRS->exportToWkt(&pszWKT);
+
+            std::string wkt(pszWKT);
+            CPLFree(pszWKT);
+            return wkt;
+        };
+        result_wkt = s_wkt.get(WktKey(result_wkt,
+            (int)mode_flag | (pretty ? 4 : 0)), compute);
     }
 
     return result_wkt;
@@ -133,64 +188,73 @@ void SpatialReference::setFromUserInput(std::string const& v)
 
 std::string SpatialReference::getProj4() const
 {
-    std::string tmp;
-
     std::string wkt = getWKT(eCompoundOK);
-    const char* poWKT = wkt.c_str();
 
-    OGRSpatialReference srs(NULL);
-    if (OGRERR_NONE == srs.importFromWkt(const_cast<char **>(&poWKT)))
+    auto compute = [&wkt]()
     {
-        char* proj4 = 0;
-        srs.exportToProj4(&proj4);
-        tmp = proj4;
-        CPLFree(proj4);
-
-        boost::algorithm::trim(tmp);
-    }
-
-    return tmp;
+        std::string tmp;
+        const char* poWKT = wkt.c_str();
+
+        OGRSpatialReference srs(NULL);
+        if (OGRERR_NONE == srs.importFromWkt(const_cast<char **>(&poWKT)))
+        {
+            char* proj4 = 0;
+            srs.exportToProj4(&proj4);
+            tmp = proj4;
+            CPLFree(proj4);
+
+            boost::algorithm::trim(tmp);
+        }
+        return tmp;
+    };
+    return s_proj4.get(wkt, compute);
 }
 
 std::string SpatialReference::getVertical() const
 {
-    std::string tmp("");
-
-    OGRSpatialReference* poSRS =
-        (OGRSpatialReference*)OSRNewSpatialReference(m_wkt.c_str());
-    char *pszWKT = NULL;
+    if (m_wkt.empty())
+        return m_wkt;
 
-    OGR_SRSNode* node = poSRS->GetAttrNode("VERT_CS");
-    if (node && poSRS)
+    auto compute = [this]()
     {
-        node->exportToWkt(&pszWKT);
-        tmp = pszWKT;
-        CPLFree(pszWKT);
-        OSRDestroySpatialReference(poSRS);
-    }
+        std::string tmp("");
+
+        gdal::SrsCache::ReferencePtr ref =
+            gdal::SrsCache::get().reference(m_wkt);
+        OGRSpatialReference* poSRS = (OGRSpatialReference*)ref.get();
+        char *pszWKT = NULL;
 
-    return tmp;
+        OGR_SRSNode* node = poSRS->GetAttrNode("VERT_CS");
+        if (node)
+        {
+            node->exportToWkt(&pszWKT);
+            tmp = pszWKT;
+            CPLFree(pszWKT);
+        }
+        return tmp;
+    };
+    return s_parts.get(WktKey(m_wkt, 0), compute);
 }
 
 std::string SpatialReference::getHorizontal() const
 {
-    std::string tmp("");
+    if (m_wkt.empty())
+        return m_wkt;
 
-    OGRSpatialReference* poSRS =
-        (OGRSpatialReference*)OSRNewSpatialReference(m_wkt.c_str());
-    char *pszWKT = NULL;
-
-    if (poSRS)
+    auto compute = [this]()
     {
-        poSRS->StripVertical();
+        gdal::SrsCache::ReferencePtr ref =
+            gdal::SrsCache::get().reference(m_wkt);
+        OGRSpatialReference* poSRS = (OGRSpatialReference*)ref.get();
+        char *pszWKT = NULL;
 
+        poSRS->StripVertical();
         poSRS->exportToWkt(&pszWKT);
-        tmp = pszWKT;
+        std::string tmp(pszWKT);
         CPLFree(pszWKT);
-        OSRDestroySpatialReference(poSRS);
-    }
-
-    return tmp;
+        return tmp;
+    };
+    return s_parts.get(WktKey(m_wkt, 1), compute);
 }
 
 void SpatialReference::setProj4(std::string const& v)
@@ -212,16 +276,24 @@ void SpatialReference::setProj4(std::string const& v)
 
 bool SpatialReference::equals(const SpatialReference& input) const
 {
-    OGRSpatialReferenceH current =
-        OSRNewSpatialReference(getWKT(eCompoundOK, false).c_str());
-    OGRSpatialReferenceH other =
-        OSRNewSpatialReference(input.getWKT(eCompoundOK, false).c_str());
-
-    int output = OSRIsSame(current, other);
-    OSRDestroySpatialReference(current);
-    OSRDestroySpatialReference(other);
-
-    return (output == 1);
+    std::string current = getWKT(eCompoundOK, false);
+    std::string other = input.getWKT(eCompoundOK, false);
+    if (current == other)
+        return true;
+    if (current.empty() || other.empty())
+        return false;
+
+    auto compute = [&current, &other]()
+    {
+        gdal::SrsCache& cache = gdal::SrsCache::get();
+        gdal::SrsCache::ReferencePtr currentRef = cache.reference(current);
+        gdal::SrsCache::ReferencePtr otherRef = cache.reference(other);
+        return (OSRIsSame(currentRef.get(), otherRef.get()) == 1);
+    };
+    // Sameness doesn't depend on the order of the references.
+    if (other < current)
+        std::swap(current, other);
+    return s_same.get(WktPair(current, other), compute);
 }
 
 
@@ -246,11 +318,16 @@ const std::string& SpatialReference::getName() const
 
 bool SpatialReference::isGeographic() const
 {
-    OGRSpatialReferenceH current =
-        OSRNewSpatialReference(getWKT(eCompoundOK, false).c_str());
-    bool output = OSRIsGeographic(current);
-    OSRDestroySpatialReference(current);
-    return output;
+    std::string wkt = getWKT(eCompoundOK, false);
+    if (wkt.empty())
+        return false;
+
+    auto compute = [&wkt]()
+    {
+        gdal::SrsCache::ReferencePtr ref = gdal::SrsCache::get().reference(wkt);
+        return (bool)OSRIsGeographic(ref.get());
+    };
+    return s_geographic.get(wkt, compute);
 }
 
 int calculateZone(double longitude, double latitude )
@@ -32,18 +32,66 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <pdal/Filter.hpp>
 #include <pdal/GlobalEnvironment.hpp>
+#include <pdal/MemoryAccount.hpp>
 #include <pdal/Stage.hpp>
 #include <pdal/SpatialReference.hpp>
+#include <pdal/Trace.hpp>
 #include <pdal/UserCallback.hpp>
 
+#include "BoundedQueue.hpp"
 #include "StageRunner.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace pdal
 {
 
+namespace
+{
+
+// Adds the wall and CPU time from its construction to its destruction to a
+// pair of totals.
+class ProfileTimer
+{
+public:
+    ProfileTimer(double& time, double& cpuTime) : m_time(time),
+        m_cpuTime(cpuTime), m_start(std::chrono::steady_clock::now()),
+        m_cpuStart(std::clock())
+    {}
+
+    ~ProfileTimer()
+    {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - m_start;
+        m_time += elapsed.count();
+        m_cpuTime += (double)(std::clock() - m_cpuStart) / CLOCKS_PER_SEC;
+    }
+
+private:
+    double& m_time;
+    double& m_cpuTime;
+    std::chrono::steady_clock::time_point m_start;
+    std::clock_t m_cpuStart;
+};
+
+point_count_t countPoints(const PointViewSet& views)
+{
+    point_count_t count = 0;
+    for (auto const& v : views)
+        count += v->size();
+    return count;
+}
+
+} // unnamed namespace
+
 
 Stage::Stage()
   : m_callback(new UserCallback)
@@ -56,6 +104,7 @@ void Stage::Construct()
 {
     m_debug = false;
     m_verbose = 0;
+    m_account = memory::AccountPtr(new memory::Account);
 }
 
 
@@ -66,12 +115,28 @@ void Stage::prepare(PointTableRef table)
         Stage *prev = m_inputs[i];
         prev->prepare(table);
     }
-    l_processOptions(m_options);
-    processOptions(m_options);
-    l_initialize(table);
-    initialize();
-    addDimensions(table.layout());
-    prepared(table);
+    prepareStage(table);
+}
+
+
+// Prepare the stage itself, once its inputs have been prepared.
+void Stage::prepareStage(PointTableRef table)
+{
+    m_profile = StageProfile();
+    m_account = memory::AccountPtr(new memory::Account);
+    {
+        ProfileTimer timer(m_profile.m_prepareTime,
+            m_profile.m_prepareCpuTime);
+        trace::Span span("stage", "prepare", *this);
+        memory::Scope scope(m_account.get());
+        l_processOptions(m_options);
+        processOptions(m_options);
+        l_initialize(table);
+        initialize();
+        addDimensions(table.layout());
+        prepared(table);
+    }
+    recordMemory();
 }
 
 
@@ -79,6 +144,10 @@ PointViewSet Stage::execute(PointTableRef table)
 {
     table.layout()->finalize();
 
+    std::vector<Filter *> run = fusedRun();
+    if (run.size() > 1)
+        return executeFused(run, table);
+
     PointViewSet views;
     if (m_inputs.empty())
     {
@@ -94,28 +163,478 @@ PointViewSet Stage::execute(PointTableRef table)
         }
     }
 
+    startRun(table);
+    PointViewSet outViews = runViews(table, views);
+    finishRun(table);
+    return outViews;
+}
+
+
+// Find the run of point-wise filters, each with a single input, that ends
+// at this stage.  The filters are returned first filter first.
+std::vector<Filter *> Stage::fusedRun()
+{
+    std::vector<Filter *> run;
+    for (Stage *s = this; s->m_inputs.size() == 1; s = s->m_inputs[0])
+    {
+        Filter *f = dynamic_cast<Filter *>(s);
+        if (!f || !f->pointwise())
+            break;
+        run.push_back(f);
+    }
+    std::reverse(run.begin(), run.end());
+    return run;
+}
+
+
+// Execute a run of point-wise filters ending at this stage.  Each view from
+// the stage below the run makes one pass through memory, a block of points
+// going through every filter of the run in turn, rather than one pass for
+// each filter.
+PointViewSet Stage::executeFused(const std::vector<Filter *>& run,
+    PointTableRef table)
+{
+    Stage *input = run.front()->getInputs()[0];
+    PointViewSet views = input->execute(table);
+
+    for (Stage *s : run)
+        s->startRun(table);
+    point_count_t count = countPoints(views);
+    {
+        ProfileTimer timer(m_profile.m_executeTime,
+            m_profile.m_executeCpuTime);
+        trace::Span span("stage", "fused", *this);
+        memory::Scope scope(m_account.get());
+        for (auto const& view : views)
+            Filter::filterFused(run, *view);
+    }
+    for (Stage *s : run)
+    {
+        s->m_profile.m_pointsIn += count;
+        s->m_profile.m_pointsOut += count;
+        s->finishRun(table);
+    }
+    return views;
+}
+
+
+void Stage::startRun(PointTableRef table)
+{
+    ProfileTimer timer(m_profile.m_executeTime, m_profile.m_executeCpuTime);
+    trace::Span span("stage", "ready", *this);
+    memory::Scope scope(m_account.get());
+    ready(table);
+}
+
+
+void Stage::finishRun(PointTableRef table)
+{
+    ProfileTimer timer(m_profile.m_executeTime, m_profile.m_executeCpuTime);
+    trace::Span span("stage", "done", *this);
+    memory::Scope scope(m_account.get());
+    l_done(table);
+    done(table);
+    m_profile.m_peakTableBytes =
+        (std::max)(m_profile.m_peakTableBytes, table.storageBytes());
+    recordMemory();
+}
+
+
+void Stage::recordMemory()
+{
+    for (int i = 0; i < memory::NumCategories; ++i)
+    {
+        memory::Category c = (memory::Category)i;
+        m_profile.m_peakBytes[c] = m_account->peak(c);
+        m_profile.m_allocatedBytes[c] = m_account->total(c);
+    }
+}
+
+
+// Run the stage on each of a set of views, in parallel if possible.
+PointViewSet Stage::runViews(PointTableRef table, const PointViewSet& views)
+{
+    ProfileTimer timer(m_profile.m_executeTime, m_profile.m_executeCpuTime);
+    trace::Span span("stage", "execute", *this);
+    memory::Scope scope(m_account.get());
+    m_profile.m_pointsIn += countPoints(views);
+
     PointViewSet outViews;
     std::vector<StageRunnerPtr> runners;
 
-    ready(table);
+    // Views are run in parallel only when both the stage and the table
+    // allow it.
+    ThreadPool *pool = NULL;
+    if (views.size() > 1 && viewParallel() && table.threadSafe())
+        pool = &ThreadPool::shared();
+
     for (auto const& it : views)
     {
-        StageRunnerPtr runner(new StageRunner(this, it));
+        StageRunnerPtr runner(new StageRunner(this, it, pool));
         runners.push_back(runner);
         runner->run();
     }
+
+    // Every runner has to finish before an error can be passed on, since
+    // the runners refer to this stage and its views.
+    std::exception_ptr error;
     for (auto const& it : runners)
     {
         StageRunnerPtr runner(it);
-        PointViewSet temp = runner->wait();
-        outViews.insert(temp.begin(), temp.end());
+        try
+        {
+            PointViewSet temp = runner->wait();
+            outViews.insert(temp.begin(), temp.end());
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
     }
-    l_done(table);
-    done(table);
+    if (error)
+        std::rethrow_exception(error);
+    m_profile.m_pointsOut += countPoints(outViews);
+    return outViews;
+}
+
+
+// Read a chunk of points when streaming.
+point_count_t Stage::l_readChunk(PointViewPtr view, point_count_t count)
+{
+    ProfileTimer timer(m_profile.m_executeTime, m_profile.m_executeCpuTime);
+    trace::Span span("stage", "read", *this);
+    memory::Scope scope(m_account.get());
+    count = readChunk(view, count);
+    m_profile.m_pointsOut += count;
+    return count;
+}
+
+
+// Run the stage on a chunk of points when streaming.
+PointViewSet Stage::l_run(PointViewPtr view)
+{
+    ProfileTimer timer(m_profile.m_executeTime, m_profile.m_executeCpuTime);
+    trace::Span span("stage", "run", *this);
+    memory::Scope scope(m_account.get());
+    m_profile.m_pointsIn += view->size();
+    PointViewSet outViews = run(view);
+    m_profile.m_pointsOut += countPoints(outViews);
+    return outViews;
+}
+
+
+// Hand on the points held back by a stage when streaming.
+PointViewSet Stage::l_flush(PointViewPtr view, point_count_t count)
+{
+    ProfileTimer timer(m_profile.m_executeTime, m_profile.m_executeCpuTime);
+    trace::Span span("stage", "flush", *this);
+    memory::Scope scope(m_account.get());
+    PointViewSet outViews = flush(view, count);
+    m_profile.m_pointsOut += countPoints(outViews);
     return outViews;
 }
 
 
+point_count_t Stage::executeStream(FixedPointTable& table)
+{
+    table.layout()->finalize();
+
+    // Stages in the order in which they process points, reader first.
+    // A stage with several inputs can only be streamed when each of them
+    // is a reader.  Those readers are then read one after the other and
+    // their points passed on as if the stage itself had read them.  Chunks
+    // are zeroed before such readers fill them, since one reader may lack
+    // dimensions that another has.
+    std::vector<Stage *> stages;
+    std::vector<Stage *> sources;
+    for (Stage *s = this; s; s = s->m_inputs.size() == 1 ? s->m_inputs[0] :
+        NULL)
+    {
+        if (!s->streamable())
+            throw pdal_error("Can't stream pipeline.  Stage '" +
+                s->getName() + "' can't process points in chunks.");
+        if (s->m_inputs.size() > 1)
+        {
+            for (Stage *in : s->m_inputs)
+            {
+                if (in->m_inputs.size() || !in->streamable())
+                    throw pdal_error("Can't stream pipeline.  Inputs of "
+                        "stage '" + s->getName() + "' must be streamable "
+                        "readers.");
+                sources.push_back(in);
+            }
+        }
+        stages.push_back(s);
+    }
+    std::reverse(stages.begin(), stages.end());
+    if (sources.empty())
+        sources.push_back(stages.front());
+
+    for (Stage *s : sources)
+        if (s != stages.front())
+            s->startRun(table);
+    for (Stage *s : stages)
+        s->startRun(table);
+
+    point_count_t total = (table.slots() > 1 && stages.size() > 1) ?
+        streamPipelined(sources, stages, table) :
+        streamSerial(sources, stages, table);
+    flushStages(stages, table);
+
+    for (Stage *s : sources)
+        if (s != stages.front())
+            s->finishRun(table);
+    for (Stage *s : stages)
+        s->finishRun(table);
+    return total;
+}
+
+
+// Read the next chunk from a list of sources, moving on to the next source
+// once the current one runs out.  Returns 0 when all sources are done.
+point_count_t Stage::readSources(const std::vector<Stage *>& sources,
+    std::size_t& current, PointViewPtr view, point_count_t count)
+{
+    for (; current < sources.size(); ++current)
+    {
+        point_count_t read = sources[current]->l_readChunk(view, count);
+        if (read)
+            return read;
+    }
+    return 0;
+}
+
+
+// Run a sequence of stages on the views of a chunk.
+PointViewSet Stage::runChunk(std::vector<Stage *>::const_iterator begin,
+    std::vector<Stage *>::const_iterator end, PointViewSet views)
+{
+    for (auto si = begin; si != end; ++si)
+    {
+        PointViewSet outViews;
+        for (auto const& it : views)
+        {
+            PointViewSet temp = (*si)->l_run(it);
+            outViews.insert(temp.begin(), temp.end());
+        }
+        views.swap(outViews);
+    }
+    return views;
+}
+
+
+point_count_t Stage::streamSerial(const std::vector<Stage *>& sources,
+    const std::vector<Stage *>& stages, FixedPointTable& table)
+{
+    std::size_t current = 0;
+    point_count_t total = 0;
+    while (true)
+    {
+        table.reset();
+        if (sources.size() > 1)
+            table.zeroChunk(0);
+        PointViewPtr view(new PointView(table));
+        point_count_t count =
+            readSources(sources, current, view, table.capacity());
+        if (count == 0)
+            break;
+        total += count;
+
+        PointViewSet views;
+        views.insert(view);
+        runChunk(stages.begin() + 1, stages.end(), views);
+    }
+    return total;
+}
+
+
+// Once all chunks have been processed, have each stage after the reader,
+// in order, hand on the points it held back, a chunk at a time, and pass
+// them through the stages that follow.  This runs after every thread of a
+// pipelined run is done, so any slot may be used.
+void Stage::flushStages(const std::vector<Stage *>& stages,
+    FixedPointTable& table)
+{
+    for (auto si = stages.begin() + 1; si != stages.end(); ++si)
+    {
+        while (true)
+        {
+            table.reset();
+            PointViewPtr view(new PointView(table));
+            PointViewSet views = (*si)->l_flush(view, table.capacity());
+            if (views.empty())
+                break;
+            runChunk(si + 1, stages.end(), views);
+        }
+    }
+}
+
+
+// The reader fills chunk slots on its own thread, the filters run on this
+// thread and the last stage (normally a writer) on a third, so reading,
+// filtering and writing overlap.  A chunk's slot is reused only once the
+// last stage is done with it, so a reader that gets ahead waits.
+point_count_t Stage::streamPipelined(const std::vector<Stage *>& sources,
+    const std::vector<Stage *>& stages, FixedPointTable& table)
+{
+    // A chunk with a negative slot marks the end of the points.
+    struct Chunk
+    {
+        int slot;
+        PointViewSet views;
+    };
+
+    const int slots = table.slots();
+    BoundedQueue<int> freeSlots(slots);
+    BoundedQueue<Chunk> filterQueue(slots);
+    BoundedQueue<Chunk> writeQueue(slots);
+    for (int slot = 0; slot < slots; ++slot)
+        freeSlots.push(slot);
+
+    // The first error stops every thread.
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto fail = [&]()
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+            error = std::current_exception();
+        freeSlots.close();
+        filterQueue.close();
+        writeQueue.close();
+    };
+
+    point_count_t total = 0;
+    std::thread reader([&]()
+    {
+        try
+        {
+            std::size_t current = 0;
+            int slot;
+            while (freeSlots.pop(slot))
+            {
+                table.startChunk(slot);
+                if (sources.size() > 1)
+                    table.zeroChunk(slot);
+                PointViewPtr view(new PointView(table));
+                point_count_t count = readSources(sources, current, view,
+                    table.capacity());
+                total += count;
+
+                Chunk chunk;
+                chunk.slot = count ? slot : -1;
+                if (count)
+                    chunk.views.insert(view);
+                if (!filterQueue.push(chunk) || count == 0)
+                    break;
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+    });
+
+    std::thread writer([&]()
+    {
+        try
+        {
+            Chunk chunk;
+            while (writeQueue.pop(chunk) && chunk.slot >= 0)
+            {
+                runChunk(stages.end() - 1, stages.end(), chunk.views);
+                chunk.views.clear();
+                if (!freeSlots.push(chunk.slot))
+                    break;
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+    });
+
+    try
+    {
+        Chunk chunk;
+        while (filterQueue.pop(chunk))
+        {
+            if (chunk.slot >= 0)
+                chunk.views = runChunk(stages.begin() + 1, stages.end() - 1,
+                    chunk.views);
+            if (!writeQueue.push(chunk) || chunk.slot < 0)
+                break;
+        }
+    }
+    catch (...)
+    {
+        fail();
+    }
+    reader.join();
+    writer.join();
+
+    if (error)
+        std::rethrow_exception(error);
+    return total;
+}
+
+
+MetadataNode Stage::pipelineProfile() const
+{
+    MetadataNode root("pipeline_profile");
+    addProfile(root);
+    return root;
+}
+
+
+void Stage::addProfile(MetadataNode& parent) const
+{
+    for (Stage *s : m_inputs)
+        s->addProfile(parent);
+
+    MetadataNode m = parent.addList(getName());
+    m.add("prepare_time", m_profile.m_prepareTime,
+        "Seconds spent preparing the stage");
+    m.add("prepare_cpu_time", m_profile.m_prepareCpuTime,
+        "CPU seconds used while preparing the stage");
+    m.add("execute_time", m_profile.m_executeTime,
+        "Seconds spent executing the stage");
+    m.add("execute_cpu_time", m_profile.m_executeCpuTime,
+        "CPU seconds used while executing the stage");
+    m.add("points_in", m_profile.m_pointsIn, "Points passed to the stage");
+    m.add("points_out", m_profile.m_pointsOut,
+        "Points produced by the stage");
+    m.add("peak_table_bytes", m_profile.m_peakTableBytes,
+        "Bytes of point storage in the table once the stage had run");
+    MetadataNode mem = m.add("memory");
+    for (int i = 0; i < memory::NumCategories; ++i)
+    {
+        memory::Category c = (memory::Category)i;
+        MetadataNode cat = mem.add(memory::categoryName(c));
+        cat.add("peak_bytes", m_profile.m_peakBytes[c],
+            "Most bytes charged to the stage at once");
+        cat.add("allocated_bytes", m_profile.m_allocatedBytes[c],
+            "Bytes allocated by the stage");
+    }
+}
+
+
+bool Stage::pipelineStreamable() const
+{
+    if (!streamable())
+        return false;
+    if (m_inputs.size() > 1)
+    {
+        for (Stage *in : m_inputs)
+            if (in->m_inputs.size() || !in->streamable())
+                return false;
+        return true;
+    }
+    return m_inputs.empty() || m_inputs[0]->pipelineStreamable();
+}
+
+
 void Stage::l_initialize(PointTableRef table)
 {
     m_metadata = table.metadata().add(getName());
@@ -152,6 +671,10 @@ void Stage::l_processOptions(const Options& options)
         }
     }
     m_log->setLevel((LogLevel::Enum)m_verbose);
+    // Stages that share the stream of their input's log share its thread.
+    uint32_t asyncLines = options.getValueOrDefault<uint32_t>("log_async", 0);
+    if (asyncLines && (m_inputs.empty() || options.hasOption("log")))
+        m_log->setAsync(asyncLines);
 
     // If the user gave us an SRS via options, take that.
     try
@@ -42,29 +42,41 @@
 #include <colorization/ColorizationFilter.hpp>
 #include <crop/CropFilter.hpp>
 #include <decimation/DecimationFilter.hpp>
+#include <dedup/DedupFilter.hpp>
+#include <expression/ExpressionFilter.hpp>
 #include <ferry/FerryFilter.hpp>
+#include <hag/HAGFilter.hpp>
 #include <merge/MergeFilter.hpp>
 #include <mortonorder/MortonOrderFilter.hpp>
+#include <normal/NormalFilter.hpp>
+#include <outlier/OutlierFilter.hpp>
+#include <overlap/OverlapFilter.hpp>
 #include <range/RangeFilter.hpp>
 #include <reprojection/ReprojectionFilter.hpp>
 #include <sort/SortFilter.hpp>
 #include <splitter/SplitterFilter.hpp>
 #include <stats/StatsFilter.hpp>
+#include <tile/TileFilter.hpp>
 #include <transformation/TransformationFilter.hpp>
 
 // readers
 #include <bpf/BpfReader.hpp>
 #include <faux/FauxReader.hpp>
 #include <las/LasReader.hpp>
+#include <octree/OctreeReader.hpp>
 #include <optech/OptechReader.hpp>
 #include <pdal/BufferReader.hpp>
 #include <qfit/QfitReader.hpp>
 #include <sbet/SbetReader.hpp>
 #include <terrasolid/TerrasolidReader.hpp>
+#include <text/TextReader.hpp>
+#include <velodyne/VelodyneReader.hpp>
 
 // writers
 #include <bpf/BpfWriter.hpp>
+#include <gdal/GDALWriter.hpp>
 #include <las/LasWriter.hpp>
+#include <octree/OctreeWriter.hpp>
 #include <rialto/RialtoWriter.hpp>
 #include <sbet/SbetWriter.hpp>
 #include <text/TextWriter.hpp>
@@ -75,6 +87,7 @@
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <stdio.h> // for funcptr
@@ -91,9 +104,11 @@ std::string StageFactory::inferReaderDriver(const std::string& filename)
 
     std::string ext = boost::filesystem::extension(filename);
     std::map<std::string, std::string> drivers;
+    drivers["arrow"] = "readers.arrow";
     drivers["bin"] = "readers.terrasolid";
     drivers["bpf"] = "readers.bpf";
     drivers["cpd"] = "readers.optech";
+    drivers["csv"] = "readers.text";
     drivers["greyhound"] = "readers.greyhound";
     drivers["icebridge"] = "readers.icebridge";
     drivers["las"] = "readers.las";
@@ -101,11 +116,14 @@ std::string StageFactory::inferReaderDriver(const std::string& filename)
     drivers["nitf"] = "readers.nitf";
     drivers["nsf"] = "readers.nitf";
     drivers["ntf"] = "readers.nitf";
+    drivers["parquet"] = "readers.parquet";
     drivers["pcd"] = "readers.pcd";
     drivers["qi"] = "readers.qfit";
     drivers["rxp"] = "readers.rxp";
     drivers["sbet"] = "readers.sbet";
     drivers["sqlite"] = "readers.sqlite";
+    drivers["txt"] = "readers.text";
+    drivers["xyz"] = "readers.text";
 
     if (ext == "") return "";
     ext = ext.substr(1, ext.length()-1);
@@ -124,17 +142,21 @@ std::string StageFactory::inferWriterDriver(const std::string& filename)
     boost::to_lower(ext);
 
     std::map<std::string, std::string> drivers;
+    drivers["arrow"] = "writers.arrow";
     drivers["bpf"] = "writers.bpf";
     drivers["csv"] = "writers.text";
     drivers["json"] = "writers.text";
     drivers["las"] = "writers.las";
     drivers["laz"] = "writers.las";
     drivers["ntf"] = "writers.nitf";
+    drivers["parquet"] = "writers.parquet";
     drivers["pcd"] = "writers.pcd";
     drivers["pclviz"] = "writers.pclvisualizer";
     drivers["ria"] = "writers.rialto";
     drivers["sbet"] = "writers.sbet";
     drivers["sqlite"] = "writers.sqlite";
+    drivers["tif"] = "writers.gdal";
+    drivers["tiff"] = "writers.gdal";
     drivers["txt"] = "writers.text";
     drivers["xyz"] = "writers.text";
 
@@ -174,49 +196,74 @@ pdal::Options StageFactory::inferWriterOptionsChanges(const std::string& filenam
     return options;
 }
 
-StageFactory::StageFactory(bool no_plugins)
+namespace
 {
-    PluginManager & pm = PluginManager::getInstance();
-    if (!no_plugins)
-    {
-        pm.loadAll(PF_PluginType_Filter);
-        pm.loadAll(PF_PluginType_Reader);
-        pm.loadAll(PF_PluginType_Writer);
-    }
 
+// Register the stages built into the library.  This only needs to happen
+// once no matter how many factories are created.
+void registerBuiltins()
+{
     // filters
     PluginManager::initializePlugin(ChipperFilter_InitPlugin);
     PluginManager::initializePlugin(ColorizationFilter_InitPlugin);
     PluginManager::initializePlugin(CropFilter_InitPlugin);
     PluginManager::initializePlugin(DecimationFilter_InitPlugin);
+    PluginManager::initializePlugin(DedupFilter_InitPlugin);
+    PluginManager::initializePlugin(ExpressionFilter_InitPlugin);
     PluginManager::initializePlugin(FerryFilter_InitPlugin);
+    PluginManager::initializePlugin(HAGFilter_InitPlugin);
     PluginManager::initializePlugin(MergeFilter_InitPlugin);
     PluginManager::initializePlugin(MortonOrderFilter_InitPlugin);
+    PluginManager::initializePlugin(NormalFilter_InitPlugin);
+    PluginManager::initializePlugin(OutlierFilter_InitPlugin);
+    PluginManager::initializePlugin(OverlapFilter_InitPlugin);
     PluginManager::initializePlugin(RangeFilter_InitPlugin);
     PluginManager::initializePlugin(ReprojectionFilter_InitPlugin);
     PluginManager::initializePlugin(SortFilter_InitPlugin);
     PluginManager::initializePlugin(SplitterFilter_InitPlugin);
     PluginManager::initializePlugin(StatsFilter_InitPlugin);
+    PluginManager::initializePlugin(TileFilter_InitPlugin);
     PluginManager::initializePlugin(TransformationFilter_InitPlugin);
 
     // readers
     PluginManager::initializePlugin(BpfReader_InitPlugin);
     PluginManager::initializePlugin(FauxReader_InitPlugin);
     PluginManager::initializePlugin(LasReader_InitPlugin);
+    PluginManager::initializePlugin(OctreeReader_InitPlugin);
     PluginManager::initializePlugin(OptechReader_InitPlugin);
     PluginManager::initializePlugin(QfitReader_InitPlugin);
     PluginManager::initializePlugin(SbetReader_InitPlugin);
     PluginManager::initializePlugin(TerrasolidReader_InitPlugin);
+    PluginManager::initializePlugin(TextReader_InitPlugin);
+    PluginManager::initializePlugin(VelodyneReader_InitPlugin);
 
     // writers
     PluginManager::initializePlugin(BpfWriter_InitPlugin);
+    PluginManager::initializePlugin(GDALWriter_InitPlugin);
     PluginManager::initializePlugin(LasWriter_InitPlugin);
+    PluginManager::initializePlugin(OctreeWriter_InitPlugin);
     PluginManager::initializePlugin(RialtoWriter_InitPlugin);
     PluginManager::initializePlugin(SbetWriter_InitPlugin);
     PluginManager::initializePlugin(TextWriter_InitPlugin);
     PluginManager::initializePlugin(NullWriter_InitPlugin);
 }
 
+} // unnamed namespace
+
+StageFactory::StageFactory(bool no_plugins)
+{
+    static std::once_flag builtinFlag;
+    std::call_once(builtinFlag, registerBuiltins);
+
+    PluginManager & pm = PluginManager::getInstance();
+    if (!no_plugins)
+    {
+        pm.loadAll(PF_PluginType_Filter);
+        pm.loadAll(PF_PluginType_Reader);
+        pm.loadAll(PF_PluginType_Writer);
+    }
+}
+
 /// Create a stage and return a pointer to the created stage.  Caller takes
 /// ownership and is responsible for stage cleanup.
 ///
@@ -34,31 +34,57 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
 
 #include <pdal/Stage.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <pdal/Trace.hpp>
 
 namespace pdal
 {
 
+// Runs a stage on a single view, either right away or as a task in a
+// thread pool.
 class StageRunner
 {
 public:
-    StageRunner(Stage *s, PointViewPtr view) :
-        m_stage(s), m_view(view)
+    StageRunner(Stage *s, PointViewPtr view, ThreadPool *pool = NULL) :
+        m_stage(s), m_view(view), m_pool(pool)
     {}
 
-    // For now this is all synchronous
     void run()
-        { m_viewSet = m_stage->run(m_view); }
+    {
+        if (m_pool)
+            m_future = m_pool->submit([this](){ runStage(); });
+        else
+            runStage();
+    }
 
+    // Wait for the run to finish and return the resulting views.
     PointViewSet wait()
-        { return m_viewSet; }
+    {
+        if (m_future.valid())
+            m_pool->wait(m_future);
+        return m_viewSet;
+    }
 
 private:
     Stage *m_stage;
     PointViewPtr m_view;
+    ThreadPool *m_pool;
+    std::future<void> m_future;
     PointViewSet m_viewSet;
+
+    // Runners that haven't started when an interrupt is requested don't
+    // start.
+    void runStage()
+    {
+        m_stage->m_callback->checkInterrupt();
+        trace::Span span("runner", "view", *m_stage);
+        memory::Scope scope(m_stage->m_account.get());
+        m_viewSet = m_stage->run(m_view);
+    }
 };
 typedef std::shared_ptr<StageRunner> StageRunnerPtr;
 
@@ -33,10 +33,18 @@
 ****************************************************************************/
 
 #include <pdal/StreamFactory.hpp>
+#include <pdal/ThreadPool.hpp>
 #include <pdal/util/FileUtils.hpp>
+#include <pdal/Utils.hpp>
 
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <mutex>
 #include <sstream>
 
+#include <cpl_vsi.h>
+
 namespace pdal
 {
 
@@ -216,6 +224,386 @@ void FilenameSubsetStreamFactory::deallocate(std::istream& stream)
 }
 
 
+// --------------------------------------------------------------------
+
+MappedSubsetStreamFactory::StreamSet::StreamSet(const char *begin,
+        std::size_t length) :
+    m_buf(const_cast<char *>(begin), length), m_stream(&m_buf)
+{}
+
+
+MappedSubsetStreamFactory::MappedSubsetStreamFactory(const std::string& name,
+        uint64_t offset, uint64_t length) : StreamFactory()
+{
+    m_file.open(name);
+    if (offset > m_file.size() || length > m_file.size() - offset)
+    {
+        std::ostringstream oss;
+        oss << "Unable to map " << length << " bytes at offset " <<
+            offset << " of '" << name << "'.  The file is only " <<
+            m_file.size() << " bytes long.";
+        throw pdal_error(oss.str());
+    }
+    m_begin = m_file.data() + offset;
+    m_length = (std::size_t)length;
+}
+
+
+MappedSubsetStreamFactory::~MappedSubsetStreamFactory()
+{
+    for (auto& s : m_streams)
+        delete s.second;
+}
+
+
+std::istream& MappedSubsetStreamFactory::allocate()
+{
+    StreamSet *set = new StreamSet(m_begin, m_length);
+    m_streams.insert(std::make_pair(&set->m_stream, set));
+    return set->m_stream;
+}
+
+
+void MappedSubsetStreamFactory::deallocate(std::istream& stream)
+{
+    Map::iterator iter = m_streams.find(&stream);
+    if (iter == m_streams.end())
+        throw pdal_error("incorrect stream deallocation");
+
+    delete iter->second;
+    m_streams.erase(iter);
+}
+
+
+// --------------------------------------------------------------------
+
+// The blocks of a remote file and the GDAL handles they're fetched with.
+// Each fetch uses a handle of its own, since GDAL handles can't be shared
+// between threads.
+class RemoteFile
+{
+public:
+    struct Block
+    {
+        Block() : m_ready(false), m_failed(false)
+            {}
+
+        std::vector<char> m_data;
+        bool m_ready;
+        bool m_failed;
+    };
+    typedef std::shared_ptr<Block> BlockPtr;
+
+    RemoteFile(const std::string& url, std::size_t blockSize,
+            std::size_t cacheBlocks, std::size_t readAhead) :
+        m_url(url), m_blockSize((std::max)(blockSize, (std::size_t)1)),
+        m_cacheBlocks((std::max)(cacheBlocks, readAhead + 1)),
+        m_readAhead(readAhead), m_lastBlock(0),
+        m_pool(new ThreadPool((std::max)(readAhead, (std::size_t)1)))
+    {
+        m_path = vsiPath(url);
+        VSIStatBufL stat;
+        if (VSIStatL(m_path.c_str(), &stat) != 0)
+            throw pdal_error("Unable to open remote file '" + url + "'.");
+        m_size = (uint64_t)stat.st_size;
+        m_numBlocks = (m_size + m_blockSize - 1) / m_blockSize;
+    }
+
+    ~RemoteFile()
+    {
+        // Let fetches in progress finish before the handles are closed.
+        m_pool.reset();
+        for (VSILFILE *fp : m_handles)
+            VSIFCloseL(fp);
+    }
+
+    static std::string vsiPath(const std::string& url)
+    {
+        if (Utils::startsWith(url, "s3://"))
+            return "/vsis3/" + url.substr(5);
+        if (Utils::startsWith(url, "http://") ||
+            Utils::startsWith(url, "https://"))
+            return "/vsicurl/" + url;
+        return url;
+    }
+
+    uint64_t size() const
+        { return m_size; }
+    std::size_t blockSize() const
+        { return m_blockSize; }
+
+    // The block holding byte 'pos', fetched if it isn't cached.  Returns
+    // NULL past the end of the file.  Throws pdal_error if the block can't
+    // be fetched.
+    BlockPtr block(uint64_t pos)
+    {
+        const uint64_t idx = pos / m_blockSize;
+        if (idx >= m_numBlocks)
+            return BlockPtr();
+
+        BlockPtr b;
+        bool fetchHere = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            b = find(idx);
+            if (!b)
+            {
+                b = insert(idx);
+                fetchHere = true;
+            }
+            // Reads that follow on from the last one fetch the blocks
+            // after them in the background.
+            if (m_readAhead && idx == m_lastBlock + 1)
+                for (uint64_t i = idx + 1;
+                    i <= idx + m_readAhead && i < m_numBlocks; ++i)
+                    if (!find(i, false))
+                    {
+                        BlockPtr ahead = insert(i);
+                        m_pool->submit([this, i, ahead]()
+                            { fetch(i, ahead); });
+                    }
+            m_lastBlock = idx;
+        }
+
+        if (fetchHere)
+            fetch(idx, b);
+        else
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_fetched.wait(lock, [&b]() { return b->m_ready; });
+        }
+        if (b->m_failed)
+        {
+            std::ostringstream oss;
+            oss << "Unable to read " << m_blockSize << " bytes at offset " <<
+                idx * m_blockSize << " of '" << m_url << "'.";
+            throw pdal_error(oss.str());
+        }
+        return b;
+    }
+
+private:
+    std::string m_url;
+    std::string m_path;
+    uint64_t m_size;
+    uint64_t m_numBlocks;
+    std::size_t m_blockSize;
+    std::size_t m_cacheBlocks;
+    std::size_t m_readAhead;
+    uint64_t m_lastBlock;
+
+    std::mutex m_mutex;
+    std::condition_variable m_fetched;
+    // Cached and pending blocks, with their indexes in order of use, most
+    // recent first.
+    typedef std::list<uint64_t> LruList;
+    std::map<uint64_t, std::pair<BlockPtr, LruList::iterator>> m_blocks;
+    LruList m_lru;
+    // Handles not in use.
+    std::vector<VSILFILE *> m_handles;
+    std::unique_ptr<ThreadPool> m_pool;
+
+    // Find a block in the cache, marking it as used if 'touch' is set.
+    BlockPtr find(uint64_t idx, bool touch = true)
+    {
+        auto it = m_blocks.find(idx);
+        if (it == m_blocks.end())
+            return BlockPtr();
+        if (touch)
+            m_lru.splice(m_lru.begin(), m_lru, it->second.second);
+        return it->second.first;
+    }
+
+    // Add a pending block to the cache, dropping the least recently used
+    // blocks that have been fetched if the cache is full.  The blocks that
+    // streams hold stay alive until they're released.
+    BlockPtr insert(uint64_t idx)
+    {
+        BlockPtr b(new Block);
+        m_lru.push_front(idx);
+        m_blocks[idx] = std::make_pair(b, m_lru.begin());
+
+        auto it = m_lru.end();
+        while (m_blocks.size() > m_cacheBlocks && it != m_lru.begin())
+        {
+            --it;
+            auto bi = m_blocks.find(*it);
+            if (!bi->second.first->m_ready)
+                continue;
+            m_blocks.erase(bi);
+            it = m_lru.erase(it);
+        }
+        return b;
+    }
+
+    void fetch(uint64_t idx, BlockPtr b)
+    {
+        VSILFILE *fp = NULL;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_handles.size())
+            {
+                fp = m_handles.back();
+                m_handles.pop_back();
+            }
+        }
+        if (!fp)
+            fp = VSIFOpenL(m_path.c_str(), "rb");
+
+        const uint64_t pos = idx * m_blockSize;
+        std::size_t count = (std::size_t)(std::min)((uint64_t)m_blockSize,
+            m_size - pos);
+        std::vector<char> data(count);
+        bool ok = fp && VSIFSeekL(fp, (vsi_l_offset)pos, SEEK_SET) == 0 &&
+            VSIFReadL(data.data(), 1, count, fp) == count;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (fp)
+            m_handles.push_back(fp);
+        b->m_data.swap(data);
+        b->m_failed = !ok;
+        b->m_ready = true;
+        // A failed block is dropped so that it's requested again.
+        if (!ok)
+        {
+            auto bi = m_blocks.find(idx);
+            if (bi != m_blocks.end() && bi->second.first == b)
+            {
+                m_lru.erase(bi->second.second);
+                m_blocks.erase(bi);
+            }
+        }
+        m_fetched.notify_all();
+    }
+};
+
+
+// Stream buffer whose get area is the cached block holding the current
+// position.
+class RemoteStreambuf : public std::streambuf
+{
+public:
+    RemoteStreambuf(std::shared_ptr<RemoteFile> file) : m_file(file),
+        m_blockPos(0)
+    {}
+
+protected:
+    virtual int_type underflow()
+    {
+        uint64_t pos = m_blockPos + (uint64_t)(gptr() - eback());
+        m_block.reset();
+        setg(NULL, NULL, NULL);
+        if (pos >= m_file->size())
+            return traits_type::eof();
+
+        m_block = m_file->block(pos);
+        const uint64_t start = pos - pos % m_file->blockSize();
+        char *data = m_block->m_data.data();
+        setg(data, data + (pos - start), data + m_block->m_data.size());
+        m_blockPos = start;
+        return traits_type::to_int_type(*gptr());
+    }
+
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+        std::ios_base::openmode which = std::ios_base::in)
+    {
+        uint64_t cur = m_blockPos + (uint64_t)(gptr() - eback());
+        int64_t pos;
+        if (dir == std::ios_base::beg)
+            pos = off;
+        else if (dir == std::ios_base::cur)
+            pos = (int64_t)cur + off;
+        else
+            pos = (int64_t)m_file->size() + off;
+        return seekpos(pos, which);
+    }
+
+    virtual pos_type seekpos(pos_type p,
+        std::ios_base::openmode which = std::ios_base::in)
+    {
+        if (!(which & std::ios_base::in) || (off_type)p < 0 ||
+            (uint64_t)(off_type)p > m_file->size())
+            return pos_type(off_type(-1));
+
+        const uint64_t pos = (uint64_t)(off_type)p;
+        if (m_block && pos >= m_blockPos &&
+            pos < m_blockPos + m_block->m_data.size())
+            setg(eback(), eback() + (pos - m_blockPos), egptr());
+        else
+        {
+            // The block is fetched by the next read.
+            m_block.reset();
+            setg(NULL, NULL, NULL);
+            m_blockPos = pos;
+        }
+        return p;
+    }
+
+private:
+    std::shared_ptr<RemoteFile> m_file;
+    RemoteFile::BlockPtr m_block;
+    // Position in the file of the start of the get area, or of the next
+    // read when there's no block.
+    uint64_t m_blockPos;
+};
+
+
+RemoteStreamFactory::StreamSet::StreamSet(std::shared_ptr<RemoteFile> file) :
+    m_buf(new RemoteStreambuf(file)), m_stream(m_buf.get())
+{}
+
+
+RemoteStreamFactory::StreamSet::~StreamSet()
+{}
+
+
+RemoteStreamFactory::RemoteStreamFactory(const std::string& url,
+        std::size_t blockSize, std::size_t cacheBlocks,
+        std::size_t readAhead) : StreamFactory(),
+    m_file(new RemoteFile(url, blockSize, cacheBlocks, readAhead))
+{}
+
+
+RemoteStreamFactory::~RemoteStreamFactory()
+{
+    for (auto& s : m_streams)
+        delete s.second;
+}
+
+
+bool RemoteStreamFactory::remote(const std::string& path)
+{
+    return Utils::startsWith(path, "http://") ||
+        Utils::startsWith(path, "https://") ||
+        Utils::startsWith(path, "s3://");
+}
+
+
+uint64_t RemoteStreamFactory::size() const
+{
+    return m_file->size();
+}
+
+
+std::istream& RemoteStreamFactory::allocate()
+{
+    StreamSet *set = new StreamSet(m_file);
+    m_streams.insert(std::make_pair(&set->m_stream, set));
+    return set->m_stream;
+}
+
+
+void RemoteStreamFactory::deallocate(std::istream& stream)
+{
+    Map::iterator iter = m_streams.find(&stream);
+    if (iter == m_streams.end())
+        throw pdal_error("incorrect stream deallocation");
+
+    delete iter->second;
+    m_streams.erase(iter);
+}
+
+
 // --------------------------------------------------------------------
 
 
@@ -0,0 +1,246 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/ThreadPool.hpp>
+#include <pdal/Trace.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+
+namespace pdal
+{
+
+namespace
+{
+
+// The pool whose worker is running on this thread, if any, and the
+// worker's index.
+thread_local ThreadPool *t_pool = NULL;
+thread_local std::size_t t_index = 0;
+
+} // unnamed namespace
+
+
+ThreadPool::ThreadPool(std::size_t numThreads) : m_pending(0), m_next(0),
+    m_active(0), m_stop(false)
+{
+    numThreads = std::max(numThreads, (std::size_t)1);
+    m_active = numThreads;
+    for (std::size_t i = 0; i < numThreads; ++i)
+        m_queues.push_back(std::unique_ptr<Queue>(new Queue));
+    for (std::size_t i = 0; i < numThreads; ++i)
+        m_threads.push_back(std::thread(&ThreadPool::work, this, i));
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& t : m_threads)
+        t.join();
+}
+
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool([]()
+    {
+        const char *env = std::getenv("PDAL_NUM_THREADS");
+        long n = env ? std::atol(env) : 0;
+        return n > 0 ? (std::size_t)n :
+            (std::size_t)std::thread::hardware_concurrency();
+    }());
+    return pool;
+}
+
+
+void ThreadPool::setActive(std::size_t count)
+{
+    count = std::min(std::max(count, (std::size_t)1), m_threads.size());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_active = count;
+    }
+    m_cv.notify_all();
+}
+
+
+std::future<void> ThreadPool::submit(Task task)
+{
+    TaskPtr t(new std::packaged_task<void()>(task));
+    std::future<void> future = t->get_future();
+
+    Queue& q = *m_queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(q.m_mutex);
+        q.m_tasks.push_back(t);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending++;
+    }
+    m_cv.notify_one();
+    return future;
+}
+
+
+void ThreadPool::wait(std::future<void>& future)
+{
+    while (future.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready)
+    {
+        if (!runOne(currentQueue()))
+            future.wait_for(std::chrono::milliseconds(1));
+    }
+    future.get();
+}
+
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain,
+    const std::function<void(std::size_t, std::size_t)>& f)
+{
+    // A few ranges per worker lets workers that finish early steal.
+    std::size_t ranges = std::min(count / std::max(grain, (std::size_t)1),
+        size() * 4);
+    if (ranges <= 1)
+    {
+        f(0, count);
+        return;
+    }
+
+    std::vector<std::future<void>> futures;
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < ranges; ++i)
+    {
+        std::size_t end = (count * (i + 1)) / ranges;
+        futures.push_back(submit([&f, begin, end](){ f(begin, end); }));
+        begin = end;
+    }
+
+    // Wait for every range before passing on an error, since the ranges
+    // refer to 'f'.
+    std::exception_ptr error;
+    for (auto& future : futures)
+    {
+        try
+        {
+            wait(future);
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+// Workers submit to their own queue.  Other threads spread their tasks
+// across the queues.
+std::size_t ThreadPool::currentQueue()
+{
+    if (t_pool == this)
+        return t_index;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_next++ % m_queues.size();
+}
+
+
+void ThreadPool::work(std::size_t index)
+{
+    t_pool = this;
+    t_index = index;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // Tasks on the queues of sleeping workers are stolen by the
+            // active ones.
+            m_cv.wait(lock, [this, index]()
+                { return m_stop || (m_pending && index < m_active); });
+            if (m_stop && !m_pending)
+                return;
+        }
+        if (!runOne(index))
+            std::this_thread::yield();
+    }
+}
+
+
+// Run the newest task on our own queue or else the oldest one on another
+// worker's queue.
+bool ThreadPool::runOne(std::size_t index)
+{
+    TaskPtr task;
+    {
+        Queue& q = *m_queues[index];
+        std::lock_guard<std::mutex> lock(q.m_mutex);
+        if (q.m_tasks.size())
+        {
+            task = q.m_tasks.back();
+            q.m_tasks.pop_back();
+        }
+    }
+    for (std::size_t i = 1; !task && i < m_queues.size(); ++i)
+    {
+        Queue& q = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(q.m_mutex);
+        if (q.m_tasks.size())
+        {
+            task = q.m_tasks.front();
+            q.m_tasks.pop_front();
+        }
+    }
+    if (!task)
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending--;
+    }
+    {
+        trace::Span span("pool", "task");
+        (*task)();
+    }
+    return true;
+}
+
+} // namespace pdal
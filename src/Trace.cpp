@@ -0,0 +1,246 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/Trace.hpp>
+#include <pdal/Stage.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pdal
+{
+namespace trace
+{
+
+namespace detail
+{
+    std::atomic<bool> g_enabled(false);
+}
+
+namespace
+{
+
+struct Event
+{
+    std::string m_name;
+    const char *m_category;
+    double m_start;     // Microseconds since the clock origin.
+    double m_duration;
+};
+
+// Events of one thread.  The lock is only contended while the trace is
+// being written.
+struct ThreadBuf
+{
+    int m_tid;
+    std::mutex m_mutex;
+    std::vector<Event> m_events;
+};
+typedef std::shared_ptr<ThreadBuf> ThreadBufPtr;
+
+struct State
+{
+    std::mutex m_mutex;
+    std::string m_filename;
+    std::vector<ThreadBufPtr> m_bufs;
+    std::chrono::steady_clock::time_point m_origin;
+
+    State() : m_origin(std::chrono::steady_clock::now())
+    {}
+};
+
+State& state()
+{
+    static State s;
+    return s;
+}
+
+double now()
+{
+    using namespace std::chrono;
+
+    return duration<double, std::micro>(steady_clock::now() -
+        state().m_origin).count();
+}
+
+// The calling thread's buffer, registered with the trace on first use.
+// The trace holds a reference so that events outlive the thread.
+ThreadBuf& threadBuf()
+{
+    thread_local ThreadBufPtr buf;
+
+    if (!buf)
+    {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.m_mutex);
+        buf.reset(new ThreadBuf);
+        buf->m_tid = (int)s.m_bufs.size() + 1;
+        s.m_bufs.push_back(buf);
+    }
+    return *buf;
+}
+
+void writeString(std::ostream& out, const std::string& s)
+{
+    out << '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') <<
+                (int)c << std::dec << std::setfill(' ');
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+// Starts tracing from PDAL_TRACE and writes the trace at exit.
+struct EnvInit
+{
+    EnvInit()
+    {
+        const char *filename = std::getenv("PDAL_TRACE");
+        if (filename && *filename)
+            start(filename);
+    }
+
+    ~EnvInit()
+    {
+        try
+        {
+            stop();
+        }
+        catch (pdal_error& err)
+        {
+            std::cerr << "PDAL: " << err.what() << std::endl;
+        }
+    }
+};
+EnvInit envInit;
+
+} // unnamed namespace
+
+
+void start(const std::string& filename)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.m_mutex);
+
+    s.m_filename = filename;
+    for (auto& buf : s.m_bufs)
+    {
+        std::lock_guard<std::mutex> bufLock(buf->m_mutex);
+        buf->m_events.clear();
+    }
+    detail::g_enabled = true;
+}
+
+
+void stop()
+{
+    if (!detail::g_enabled.exchange(false))
+        return;
+
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.m_mutex);
+
+    std::ofstream out(s.m_filename);
+    if (!out)
+        throw pdal_error("Unable to open trace file '" + s.m_filename + "'.");
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (auto& buf : s.m_bufs)
+    {
+        std::lock_guard<std::mutex> bufLock(buf->m_mutex);
+        if (buf->m_events.empty())
+            continue;
+
+        if (!first)
+            out << ",";
+        first = false;
+        out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"tid\":" << buf->m_tid << ",\"args\":{\"name\":\"thread " <<
+            buf->m_tid << "\"}}";
+        for (const Event& e : buf->m_events)
+        {
+            out << ",\n{\"name\":";
+            writeString(out, e.m_name);
+            out << ",\"cat\":\"" << e.m_category << "\",\"ph\":\"X\","
+                "\"ts\":" << e.m_start << ",\"dur\":" << e.m_duration <<
+                ",\"pid\":1,\"tid\":" << buf->m_tid << "}";
+        }
+        buf->m_events.clear();
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    if (!out)
+        throw pdal_error("Unable to write trace file '" + s.m_filename + "'.");
+}
+
+
+void Span::begin(const char *category, const std::string& name)
+{
+    m_category = category;
+    m_name = name;
+    m_start = now();
+}
+
+
+void Span::begin(const char *category, const char *phase, const Stage& stage)
+{
+    begin(category, stage.getName() + " " + phase);
+}
+
+
+void Span::end()
+{
+    double finish = now();
+    ThreadBuf& buf = threadBuf();
+    std::lock_guard<std::mutex> lock(buf.m_mutex);
+    buf.m_events.push_back(Event { std::move(m_name), m_category, m_start,
+        finish - m_start });
+}
+
+} // namespace trace
+} // namespace pdal
+
@@ -0,0 +1,148 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#define _USE_MATH_DEFINES
+#include <pdal/Trajectory.hpp>
+#include <pdal/PointView.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pdal
+{
+
+namespace
+{
+
+// Interpolate between two angles the short way around.
+double interpolateAngle(double a, double b, double frac)
+{
+    double diff = b - a;
+    if (diff > M_PI)
+        diff -= 2 * M_PI;
+    else if (diff < -M_PI)
+        diff += 2 * M_PI;
+    return a + diff * frac;
+}
+
+// Number of segments to step through before falling back to a search.
+const std::size_t MaxSteps = 8;
+
+} // unnamed namespace
+
+
+Trajectory::Trajectory(const PointView& view)
+{
+    using namespace Dimension;
+
+    m_poses.reserve(view.size());
+    for (PointId idx = 0; idx < view.size(); ++idx)
+    {
+        Pose p;
+        p.time = view.getFieldAs<double>(Id::GpsTime, idx);
+        p.x = view.getFieldAs<double>(Id::X, idx);
+        p.y = view.getFieldAs<double>(Id::Y, idx);
+        p.z = view.getFieldAs<double>(Id::Z, idx);
+        p.roll = view.getFieldAs<double>(Id::Roll, idx);
+        p.pitch = view.getFieldAs<double>(Id::Pitch, idx);
+        p.heading = view.getFieldAs<double>(Id::PlatformHeading, idx);
+        add(p);
+    }
+}
+
+
+void Trajectory::add(const Pose& pose)
+{
+    if (m_poses.size() && pose.time < m_poses.back().time)
+        throw pdal_error("Trajectory poses must be added in time order.");
+    m_poses.push_back(pose);
+}
+
+
+Trajectory::Pose Trajectory::interpolate(double time) const
+{
+    std::size_t hint = 0;
+    return interpolate(time, hint);
+}
+
+
+Trajectory::Pose Trajectory::interpolate(double time, std::size_t& hint) const
+{
+    if (m_poses.empty())
+        throw pdal_error("Can't interpolate an empty trajectory.");
+    if (time <= m_poses.front().time)
+        return m_poses.front();
+    if (time >= m_poses.back().time)
+        return m_poses.back();
+
+    hint = findSegment(time, hint);
+    const Pose& p0 = m_poses[hint];
+    const Pose& p1 = m_poses[hint + 1];
+
+    double frac = (time - p0.time) / (p1.time - p0.time);
+    Pose p;
+    p.time = time;
+    p.x = p0.x + (p1.x - p0.x) * frac;
+    p.y = p0.y + (p1.y - p0.y) * frac;
+    p.z = p0.z + (p1.z - p0.z) * frac;
+    p.roll = interpolateAngle(p0.roll, p1.roll, frac);
+    p.pitch = interpolateAngle(p0.pitch, p1.pitch, frac);
+    p.heading = interpolateAngle(p0.heading, p1.heading, frac);
+    return p;
+}
+
+
+// Find the segment i such that pose i is at or before 'time' and pose
+// i + 1 is after it.  'time' must be strictly inside the trajectory.
+std::size_t Trajectory::findSegment(double time, std::size_t hint) const
+{
+    auto later = [](double t, const Pose& p) { return t < p.time; };
+
+    std::size_t last = m_poses.size() - 2;
+    std::size_t i = std::min(hint, last);
+    if (m_poses[i].time <= time)
+    {
+        for (std::size_t steps = 0; steps < MaxSteps; ++steps, ++i)
+            if (time < m_poses[i + 1].time)
+                return i;
+        auto it = std::upper_bound(m_poses.begin() + i, m_poses.end(), time,
+            later);
+        return (it - m_poses.begin()) - 1;
+    }
+    auto it = std::upper_bound(m_poses.begin(), m_poses.begin() + i, time,
+        later);
+    return (it - m_poses.begin()) - 1;
+}
+
+} // namespace pdal
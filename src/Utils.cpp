@@ -159,6 +159,15 @@ int Utils::putenv(const char* env)
 #endif
 }
 
+bool Utils::gmtime(std::time_t t, std::tm& tm)
+{
+#ifdef _WIN32
+    return ::gmtime_s(&tm, &t) == 0;
+#else
+    return ::gmtime_r(&t, &tm) != NULL;
+#endif
+}
+
 void Utils::eatwhitespace(istream& s)
 {
     while (true)
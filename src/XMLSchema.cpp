@@ -41,7 +41,9 @@
 #include <list>
 #include <cstdlib>
 #include <map>
+#include <mutex>
 #include <algorithm>
+#include <unordered_map>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/erase.hpp>
@@ -174,6 +176,35 @@ XMLSchema::XMLSchema(std::string xml, std::string xsd,
 }
 
 
+std::shared_ptr<const XMLSchema> XMLSchema::cached(const std::string& xml,
+    const std::string& xsd)
+{
+    typedef std::unordered_map<std::string,
+        std::shared_ptr<const XMLSchema>> SchemaMap;
+
+    // A process sees few distinct schemas, so this limit is only there to
+    // keep one that sees many from growing without bound.
+    const size_t MaxCached = 256;
+    static std::mutex mutex;
+    static SchemaMap schemas;
+
+    // Validation depends on the XSD, so it's part of the key.
+    std::string key(xsd);
+    key.push_back('\0');
+    key += xml;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto si = schemas.find(key);
+    if (si != schemas.end())
+        return si->second;
+    if (schemas.size() >= MaxCached)
+        schemas.clear();
+    std::shared_ptr<const XMLSchema> schema(new XMLSchema(xml, xsd));
+    schemas.insert(std::make_pair(key, schema));
+    return schema;
+}
+
+
 XMLSchema::XMLSchema(const DimTypeList& dims, MetadataNode m,
     Orientation::Enum orientation) : m_orientation(orientation), m_metadata(m)
 {
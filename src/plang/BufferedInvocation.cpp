@@ -52,30 +52,51 @@ BufferedInvocation::BufferedInvocation(const Script& script)
 {}
 
 
-void BufferedInvocation::begin(PointView& view)
+void BufferedInvocation::begin(PointView& view, PointId first,
+    point_count_t count)
 {
     PointLayoutPtr layout(view.m_pointTable.layout());
     Dimension::IdList const& dims = layout->dims();
 
+    m_spans.clear();
     for (auto di = dims.begin(); di != dims.end(); ++di)
     {
         Dimension::Id::Enum d = *di;
         const Dimension::Detail *dd = layout->dimDetail(d);
-        void *data = malloc(dd->size() * view.size());
+        // Scaled dimensions are passed as doubles.
+        Dimension::Type::Enum type = layout->dimType(d);
+        std::string name = layout->dimName(*di);
+
+        std::ptrdiff_t stride = 0;
+        char *span = NULL;
+        if (!dd->scaled() && dd->type() == type)
+            span = view.fieldSpan(d, first, count, stride);
+        m_spans.push_back(span);
+        if (span)
+        {
+            insertArgument(name, (uint8_t *)span, type, count, stride);
+            continue;
+        }
+
+        size_t size = Dimension::size(type);
+        void *data = malloc(size * count);
         m_buffers.push_back(data);  // Hold pointer for deallocation
         char *p = (char *)data;
-        for (PointId idx = 0; idx < view.size(); ++idx)
+        for (PointId idx = first; idx < first + count; ++idx)
         {
-            view.getFieldInternal(d, idx, (void *)p);
-            p += dd->size();
+            if (dd->scaled())
+                view.getField(p, d, type, idx);
+            else
+                view.getFieldInternal(d, idx, (void *)p);
+            p += size;
         }
-        std::string name = layout->dimName(*di);
-        insertArgument(name, (uint8_t *)data, dd->type(), view.size());
+        insertArgument(name, (uint8_t *)data, type, count);
     }
 }
 
 
-void BufferedInvocation::end(PointView& view)
+void BufferedInvocation::end(PointView& view, PointId first,
+    point_count_t count)
 {
     // for each entry in the script's outs dictionary,
     // look up that entry's name in the schema and then
@@ -88,29 +109,33 @@ void BufferedInvocation::end(PointView& view)
     PointLayoutPtr layout(view.m_pointTable.layout());
     Dimension::IdList const& dims = layout->dims();
 
-    for (auto di = dims.begin(); di != dims.end(); ++di)
+    for (size_t i = 0; i < dims.size(); ++i)
     {
-        Dimension::Id::Enum d = *di;
-        const Dimension::Detail *dd = layout->dimDetail(d);
-        std::string name = layout->dimName(*di);
+        Dimension::Id::Enum d = dims[i];
+        std::string name = layout->dimName(d);
         auto found = std::find(names.begin(), names.end(), name);
         if (found == names.end()) continue; // didn't have this dim in the names
 
         assert(name == *found);
         assert(hasOutputVariable(name));
 
-        size_t size = dd->size();
-        void *data = extractResult(name, dd->type());
-        char *p = (char *)data;
-        for (PointId idx = 0; idx < view.size(); ++idx)
+        Dimension::Type::Enum type = layout->dimType(d);
+        std::ptrdiff_t stride;
+        char *p = (char *)extractResult(name, type, count, stride);
+
+        // An input array changed in place and passed back needs no copy.
+        if (i < m_spans.size() && p == m_spans[i])
+            continue;
+        for (PointId idx = first; idx < first + count; ++idx)
         {
-            view.setField(d, dd->type(), idx, (void *)p);
-            p += size;
+            view.setField(d, type, idx, (void *)p);
+            p += stride;
         }
     }
     for (auto bi = m_buffers.begin(); bi != m_buffers.end(); ++bi)
         free(*bi);
     m_buffers.clear();
+    m_spans.clear();
 }
 
 } //namespace plang
@@ -140,14 +140,22 @@ void Invocation::resetArguments()
 
 
 void Invocation::insertArgument(std::string const& name, uint8_t* data,
-    Dimension::Type::Enum t, point_count_t count)
+    Dimension::Type::Enum t, point_count_t count, std::ptrdiff_t step)
 {
     npy_intp mydims = count;
     int nd = 1;
     npy_intp* dims = &mydims;
-    npy_intp stride = Dimension::size(t);
+    const npy_intp size = Dimension::size(t);
+    npy_intp stride = step ? step : size;
     npy_intp* strides = &stride;
-    int flags = NPY_CARRAY; // NPY_BEHAVED
+
+    // Values of a row of a point table are only aligned if the layout
+    // happens to put them on a multiple of their size.
+    int flags = NPY_WRITEABLE;
+    if (stride == size)
+        flags |= NPY_C_CONTIGUOUS;
+    if ((uintptr_t)data % size == 0 && stride % size == 0)
+        flags |= NPY_ALIGNED;
 
     const int pyDataType = getPythonDataType(t);
 
@@ -214,6 +222,24 @@ void *Invocation::extractResult(std::string const& name,
 }
 
 
+void *Invocation::extractResult(std::string const& name,
+    Dimension::Type::Enum t, point_count_t count, std::ptrdiff_t& stride)
+{
+    void *data = extractResult(name, t);
+    PyArrayObject* arr =
+        (PyArrayObject*)PyDict_GetItemString(m_varsOut, name.c_str());
+    if (PyArray_NDIM(arr) != 1 || PyArray_DIM(arr, 0) < (npy_intp)count)
+    {
+        std::ostringstream oss;
+        oss << "plang output variable '" << name << "' must be a one "
+            "dimensional array of at least " << count << " values";
+        throw python_error(oss.str());
+    }
+    stride = PyArray_STRIDE(arr, 0);
+    return data;
+}
+
+
 void Invocation::getOutputNames(std::vector<std::string>& names)
 {
     names.clear();
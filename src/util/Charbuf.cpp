@@ -53,7 +53,7 @@ std::ios::pos_type Charbuf::seekpos(std::ios::pos_type pos,
     pos -= m_bufOffset;
     if (which & std::ios_base::in)
     {
-        if (pos >= egptr() - eback())
+        if (pos > egptr() - eback())
             return -1;
         char *cpos = eback() + pos;
         setg(eback(), cpos, egptr());
@@ -85,7 +85,7 @@ Charbuf::seekoff(std::ios::off_type off, std::ios_base::seekdir dir,
             cpos = gptr() + off;
             break;
         case std::ios::end:
-            cpos = egptr() - off;
+            cpos = egptr() + off;
             break;
         default:
             break;  // Should never happen.
@@ -106,7 +106,7 @@ Charbuf::seekoff(std::ios::off_type off, std::ios_base::seekdir dir,
             cpos = pptr() + off;
             break;
         case std::ios::end:
-            cpos = egptr() - off;
+            cpos = epptr() + off;
             break;
         default:
             break;  // Should never happen.
@@ -41,6 +41,7 @@
 #include <boost/version.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -173,6 +174,12 @@ uintmax_t FileUtils::fileSize(const string& file)
 }
 
 
+std::time_t FileUtils::lastWriteTime(const string& file)
+{
+    return boost::filesystem::last_write_time(file);
+}
+
+
 string FileUtils::readFileIntoString(const string& filename)
 {
     istream* stream = FileUtils::openFile(filename, false);
@@ -284,4 +291,57 @@ string FileUtils::readFileAsString(string const& filename)
     return string();
 }
 
+namespace
+{
+
+bool wildcardMatch(const char *pattern, const char *name)
+{
+    for (; *pattern; ++pattern, ++name)
+    {
+        if (*pattern == '*')
+        {
+            // Try the rest of the pattern at each remaining position.
+            for (; *name; ++name)
+                if (wildcardMatch(pattern + 1, name))
+                    return true;
+            return wildcardMatch(pattern + 1, name);
+        }
+        if (!*name || (*pattern != '?' && *pattern != *name))
+            return false;
+    }
+    return !*name;
+}
+
+} // unnamed namespace
+
+vector<string> FileUtils::glob(const string& pattern)
+{
+    vector<string> filenames;
+
+    const boost::filesystem::path p(pattern);
+    boost::filesystem::path dir = p.parent_path();
+    const string filePattern = p.filename().string();
+    if (dir.empty())
+        dir = ".";
+    if (!boost::filesystem::is_directory(dir))
+        return filenames;
+
+    boost::filesystem::directory_iterator it(dir), end;
+    for (; it != end; ++it)
+    {
+        const boost::filesystem::path& full_path = it->path();
+        if (boost::filesystem::is_directory(full_path))
+            continue;
+        if (wildcardMatch(filePattern.c_str(),
+            full_path.filename().string().c_str()))
+        {
+            // Keep the directory as the caller wrote it.
+            filenames.push_back(p.parent_path().empty() ?
+                full_path.filename().string() : full_path.string());
+        }
+    }
+    std::sort(filenames.begin(), filenames.end());
+    return filenames;
+}
+
 } // namespace pdal
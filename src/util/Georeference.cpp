@@ -35,8 +35,7 @@
 #include <pdal/util/Georeference.hpp>
 
 #include <cmath>
-#include <iostream>
-#include <vector>
+#include <limits>
 
 
 namespace pdal
@@ -53,23 +52,6 @@ static const double a = 6378137.0;
 static const double f = 1 / 298.257223563;
 static const double e2 = 2 * f - f * f;
 
-
-Xyz rotate(const Xyz& point, const RotationMatrix& matrix)
-{
-    return Xyz(
-        matrix.m00 * point.X + matrix.m01 * point.Y + matrix.m02 * point.Z,
-        matrix.m10 * point.X + matrix.m11 * point.Y + matrix.m12 * point.Z,
-        matrix.m20 * point.X + matrix.m21 * point.Y + matrix.m22 * point.Z);
-}
-
-
-Xyz cartesianToCurvilinear(const Xyz& point, double latitude)
-{
-    double w = std::sqrt(1 - e2 * std::sin(latitude) * std::sin(latitude));
-    double n = a / w;
-    double m = a * (1 - e2) / (w * w * w);
-    return Xyz(point.X / (n * std::cos(latitude)), point.Y / m, point.Z);
-}
 }
 
 
@@ -77,14 +59,61 @@ Xyz georeferenceWgs84(double range, double scanAngle,
                       const RotationMatrix& boresightMatrix,
                       const RotationMatrix& imuMatrix, const Xyz& gpsPoint)
 {
-    Xyz pSocs = Xyz(range * std::sin(scanAngle), 0, -range * std::cos(scanAngle));
+    Xyz point(0, 0, 0);
+    georeferenceWgs84(1, &range, &scanAngle, boresightMatrix, &imuMatrix,
+        &gpsPoint, &point);
+    return point;
+}
 
-    Xyz pSocsAligned = rotate(pSocs, boresightMatrix);
-    Xyz pLocalLevel = rotate(pSocsAligned, imuMatrix);
-    Xyz pCurvilinear = cartesianToCurvilinear(pLocalLevel, gpsPoint.Y);
 
-    return Xyz(gpsPoint.X + pCurvilinear.X, gpsPoint.Y + pCurvilinear.Y,
-               gpsPoint.Z + pCurvilinear.Z);
+void georeferenceWgs84(std::size_t count, const double *range,
+                    const double *scanAngle,
+                    const RotationMatrix& boresightMatrix,
+                    const RotationMatrix *imuMatrix, const Xyz *gpsPoint,
+                    Xyz *out)
+{
+    const RotationMatrix& b = boresightMatrix;
+
+    double angle = std::numeric_limits<double>::quiet_NaN();
+    double sinAngle = 0;
+    double cosAngle = 0;
+    double latitude = std::numeric_limits<double>::quiet_NaN();
+    double xRadius = 0;
+    double yRadius = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (scanAngle[i] != angle)
+        {
+            angle = scanAngle[i];
+            sinAngle = std::sin(angle);
+            cosAngle = std::cos(angle);
+        }
+        if (gpsPoint[i].Y != latitude)
+        {
+            latitude = gpsPoint[i].Y;
+            double sinLat = std::sin(latitude);
+            double w = std::sqrt(1 - e2 * sinLat * sinLat);
+            double n = a / w;
+            xRadius = n * std::cos(latitude);
+            yRadius = a * (1 - e2) / (w * w * w);
+        }
+
+        // The point in the scanner's frame has no Y component, so only
+        // the first and last columns of the boresight matrix matter.
+        double sx = range[i] * sinAngle;
+        double sz = -range[i] * cosAngle;
+        double ax = b.m00 * sx + b.m02 * sz;
+        double ay = b.m10 * sx + b.m12 * sz;
+        double az = b.m20 * sx + b.m22 * sz;
+
+        const RotationMatrix& m = imuMatrix[i];
+        double lx = m.m00 * ax + m.m01 * ay + m.m02 * az;
+        double ly = m.m10 * ax + m.m11 * ay + m.m12 * az;
+        double lz = m.m20 * ax + m.m21 * ay + m.m22 * az;
+
+        out[i] = Xyz(gpsPoint[i].X + lx / xRadius,
+            gpsPoint[i].Y + ly / yRadius, gpsPoint[i].Z + lz);
+    }
 }
 }
 }
@@ -0,0 +1,96 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/util/MappedFile.hpp>
+#include <pdal/pdal_error.hpp>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pdal
+{
+
+void MappedFile::open(const std::string& filename)
+{
+    close();
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw pdal_error("Unable to open '" + filename + "'.");
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throw pdal_error("Unable to open '" + filename + "'.");
+    }
+    if (st.st_size)
+    {
+        void *p = mmap(NULL, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+            fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close(fd);
+            throw pdal_error("Unable to map '" + filename + "'.");
+        }
+        madvise(p, (std::size_t)st.st_size, MADV_SEQUENTIAL);
+        m_data = (const char *)p;
+        m_size = (std::size_t)st.st_size;
+        m_mapped = true;
+    }
+    ::close(fd);
+#else
+    m_buf = FileUtils::readFileIntoString(filename);
+    m_data = m_buf.data();
+    m_size = m_buf.size();
+#endif
+}
+
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+    if (m_mapped)
+        munmap(const_cast<char *>(m_data), m_size);
+#endif
+    m_mapped = false;
+    m_buf.clear();
+    m_data = NULL;
+    m_size = 0;
+}
+
+} // namespace pdal
@@ -0,0 +1,137 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "BenchSupport.hpp"
+
+#include <memory>
+
+#include <boost/filesystem.hpp>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/StageFactory.hpp>
+
+#include <FauxReader.hpp>
+
+namespace pdal
+{
+namespace bench
+{
+
+void sizes(benchmark::internal::Benchmark *b)
+{
+    b->RangeMultiplier(10)->Range(10000, 1000000)->
+        Unit(benchmark::kMillisecond);
+}
+
+
+Options fauxOptions(point_count_t count, const std::string& mode)
+{
+    Options options;
+    options.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 100));
+    options.add("mode", mode);
+    options.add("num_points", count);
+    options.add("seed", 1);
+    return options;
+}
+
+
+PointViewPtr fauxView(PointTableRef table, point_count_t count,
+    const std::string& extraDims)
+{
+    Options options(fauxOptions(count));
+    if (extraDims.size())
+        options.add("extra_dims", extraDims);
+
+    FauxReader reader;
+    reader.setOptions(options);
+    reader.prepare(table);
+    PointViewSet set = reader.execute(table);
+    return *set.begin();
+}
+
+
+std::string tempFile(const std::string& name)
+{
+    using namespace boost::filesystem;
+
+    static const path dir(temp_directory_path() /
+        unique_path("pdal-bench-%%%%%%%%"));
+    if (!exists(dir))
+        create_directories(dir);
+    return (dir / name).string();
+}
+
+
+void runFilter(benchmark::State& state, const std::string& driver,
+    const Options& options, const std::string& extraDims)
+{
+    StageFactory factory;
+    const point_count_t count = (point_count_t)state.range(0);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        // The layout is set up from both stages before any points are
+        // added, so the filter can add its dimensions.
+        PointTable table;
+        Options fauxOpts(fauxOptions(count));
+        if (extraDims.size())
+            fauxOpts.add("extra_dims", extraDims);
+        FauxReader faux;
+        faux.setOptions(fauxOpts);
+        faux.prepare(table);
+
+        BufferReader reader;
+        std::unique_ptr<Stage> filter(factory.createStage(driver));
+        filter->setOptions(options);
+        filter->setInput(reader);
+        filter->prepare(table);
+
+        PointViewSet set = faux.execute(table);
+        reader.addView(*set.begin());
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(filter->execute(table));
+    }
+    setPointsProcessed(state);
+}
+
+
+void setPointsProcessed(benchmark::State& state)
+{
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace bench
+} // namespace pdal
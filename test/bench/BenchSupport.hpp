@@ -0,0 +1,75 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/Stage.hpp>
+
+namespace pdal
+{
+namespace bench
+{
+
+// Point counts that benchmarks are run at.
+void sizes(benchmark::internal::Benchmark *b);
+
+// Options for a FauxReader of 'count' points spread over a 1000 x 1000
+// x 100 box, with the same points made each time.
+Options fauxOptions(point_count_t count,
+    const std::string& mode = "uniform");
+
+// Fill 'table' with 'count' points from a FauxReader and return them.
+// 'extraDims' is passed to the reader as its "extra_dims" option.
+PointViewPtr fauxView(PointTableRef table, point_count_t count,
+    const std::string& extraDims = "");
+
+// A file name in the system's temporary directory unique to the run.
+std::string tempFile(const std::string& name);
+
+// Time 'filter' run on 'count' points.  The points are made with a fresh
+// table before each run, outside the timing.
+void runFilter(benchmark::State& state, const std::string& driver,
+    const Options& options, const std::string& extraDims = "");
+
+// Report throughput in points for 'state', whose range(0) is a point count.
+void setPointsProcessed(benchmark::State& state);
+
+} // namespace bench
+} // namespace pdal
@@ -0,0 +1,147 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "BenchSupport.hpp"
+
+using namespace pdal;
+
+// Each filter is timed on uniformly-spread points.  filters.colorization
+// needs a raster and isn't included.
+
+namespace
+{
+
+void BM_Filter(benchmark::State& state, const std::string& driver,
+    Options options)
+{
+    bench::runFilter(state, driver, options);
+}
+
+
+Options opts(const std::string& name, const std::string& value)
+{
+    Options options;
+    options.add(name, value);
+    return options;
+}
+
+
+Options nested(const std::string& name, const std::string& value,
+    const Options& sub)
+{
+    Option opt(name, value);
+    opt.setOptions(sub);
+    Options options;
+    options.add(opt);
+    return options;
+}
+
+
+Options range()
+{
+    Options limits;
+    limits.add("min", 20);
+    limits.add("max", 80);
+    return nested("dimension", "Z", limits);
+}
+
+
+Options reprojection()
+{
+    Options options;
+    options.add("in_srs", "EPSG:26915");
+    options.add("out_srs", "EPSG:4326");
+    return options;
+}
+
+
+Options outlier(const std::string& mode)
+{
+    Options options;
+    options.add("mode", mode);
+    options.add("radius", 5.0);
+    return options;
+}
+
+#define PDAL_BENCH_FILTER(name, driver, options) \
+    BENCHMARK_CAPTURE(BM_Filter, name, std::string(driver), options)-> \
+        Apply(bench::sizes)
+
+PDAL_BENCH_FILTER(chipper, "filters.chipper", opts("capacity", "5000"));
+PDAL_BENCH_FILTER(crop, "filters.crop",
+    opts("bounds", "([0, 500], [0, 500])"));
+PDAL_BENCH_FILTER(decimation, "filters.decimation", opts("step", "10"));
+PDAL_BENCH_FILTER(decimation_voxel, "filters.decimation",
+    opts("mode", "voxel"));
+PDAL_BENCH_FILTER(dedup, "filters.dedup", opts("tolerance", ".01"));
+PDAL_BENCH_FILTER(expression, "filters.expression",
+    opts("expression", "Z > 50 && X < 500"));
+PDAL_BENCH_FILTER(ferry, "filters.ferry",
+    nested("dimension", "Z", opts("to", "Z2")));
+PDAL_BENCH_FILTER(merge, "filters.merge", Options());
+PDAL_BENCH_FILTER(mortonorder, "filters.mortonorder", Options());
+PDAL_BENCH_FILTER(normal, "filters.normal", opts("knn", "8"));
+PDAL_BENCH_FILTER(outlier_statistical, "filters.outlier",
+    outlier("statistical"));
+PDAL_BENCH_FILTER(outlier_radius, "filters.outlier", outlier("radius"));
+PDAL_BENCH_FILTER(range, "filters.range", range());
+PDAL_BENCH_FILTER(reprojection, "filters.reprojection", reprojection());
+PDAL_BENCH_FILTER(sort, "filters.sort", opts("dimension", "Z"));
+PDAL_BENCH_FILTER(splitter, "filters.splitter", opts("length", "100"));
+PDAL_BENCH_FILTER(stats, "filters.stats", Options());
+PDAL_BENCH_FILTER(tile, "filters.tile", opts("tile_size", "100"));
+PDAL_BENCH_FILTER(transformation, "filters.transformation",
+    opts("matrix", "0 1 0 0\n-1 0 0 0\n0 0 1 0\n0 0 0 1"));
+
+
+// filters.hag and filters.overlap need dimensions FauxReader doesn't
+// make by default.
+void BM_HAGFilter(benchmark::State& state)
+{
+    // Every class is as likely, so about one point in 256 is ground.
+    Options options;
+    options.add("class", 2);
+    bench::runFilter(state, "filters.hag", options, "Classification=uint8");
+}
+BENCHMARK(BM_HAGFilter)->Apply(bench::sizes);
+
+
+void BM_OverlapFilter(benchmark::State& state)
+{
+    bench::runFilter(state, "filters.overlap", Options(),
+        "PointSourceId=uint16, Classification=uint8");
+}
+BENCHMARK(BM_OverlapFilter)->Apply(bench::sizes);
+
+} // unnamed namespace
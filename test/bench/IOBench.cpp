@@ -0,0 +1,187 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "BenchSupport.hpp"
+
+#include <memory>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// Time writing points with 'driver', made before each run.
+void runWriter(benchmark::State& state, const std::string& driver,
+    const Options& options)
+{
+    StageFactory factory;
+    const point_count_t count = (point_count_t)state.range(0);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        PointTable table;
+        BufferReader reader;
+        reader.addView(bench::fauxView(table, count));
+        std::unique_ptr<Stage> writer(factory.createStage(driver));
+        writer->setOptions(options);
+        writer->setInput(reader);
+        writer->prepare(table);
+        state.ResumeTiming();
+
+        writer->execute(table);
+    }
+    bench::setPointsProcessed(state);
+}
+
+
+// Write 'count' points with 'driver' unless the file exists.
+void makeFile(const std::string& driver, const Options& options,
+    point_count_t count)
+{
+    if (FileUtils::fileExists(options.getValueOrThrow<std::string>("filename")))
+        return;
+
+    StageFactory factory;
+    PointTable table;
+    BufferReader reader;
+    reader.addView(bench::fauxView(table, count));
+    std::unique_ptr<Stage> writer(factory.createStage(driver));
+    writer->setOptions(options);
+    writer->setInput(reader);
+    writer->prepare(table);
+    writer->execute(table);
+}
+
+
+void runReader(benchmark::State& state, const std::string& driver,
+    const std::string& filename)
+{
+    StageFactory factory;
+    Options options;
+    options.add("filename", filename);
+    for (auto _ : state)
+    {
+        PointTable table;
+        std::unique_ptr<Stage> reader(factory.createStage(driver));
+        reader->setOptions(options);
+        reader->prepare(table);
+        benchmark::DoNotOptimize(reader->execute(table));
+    }
+    bench::setPointsProcessed(state);
+}
+
+
+Options lasOptions(const std::string& compression, point_count_t count)
+{
+    Options options;
+    options.add("filename", bench::tempFile("bench" +
+        std::to_string(count) + (compression == "false" ? ".las" : ".laz")));
+    options.add("compression", compression);
+    options.add("scale_x", .01);
+    options.add("scale_y", .01);
+    options.add("scale_z", .01);
+    return options;
+}
+
+
+void BM_LasWriter(benchmark::State& state, const std::string& compression)
+{
+    runWriter(state, "writers.las", lasOptions(compression,
+        (point_count_t)state.range(0)));
+}
+BENCHMARK_CAPTURE(BM_LasWriter, las, std::string("false"))->
+    Apply(bench::sizes);
+BENCHMARK_CAPTURE(BM_LasWriter, laz, std::string("true"))->
+    Apply(bench::sizes);
+
+
+void BM_LasReader(benchmark::State& state, const std::string& compression)
+{
+    const point_count_t count = (point_count_t)state.range(0);
+    Options options(lasOptions(compression, count));
+    makeFile("writers.las", options, count);
+    runReader(state, "readers.las",
+        options.getValueOrThrow<std::string>("filename"));
+}
+BENCHMARK_CAPTURE(BM_LasReader, las, std::string("false"))->
+    Apply(bench::sizes);
+BENCHMARK_CAPTURE(BM_LasReader, laz, std::string("true"))->
+    Apply(bench::sizes);
+
+
+// BPF files hold points interleaved ("point"), a dimension at a time
+// ("dimension") or a byte of each dimension at a time ("byte").
+Options bpfOptions(const std::string& format, point_count_t count)
+{
+    Options options;
+    options.add("filename", bench::tempFile("bench" + std::to_string(count) +
+        format + ".bpf"));
+    options.add("format", format);
+    return options;
+}
+
+
+void BM_BpfWriter(benchmark::State& state, const std::string& format)
+{
+    runWriter(state, "writers.bpf", bpfOptions(format,
+        (point_count_t)state.range(0)));
+}
+BENCHMARK_CAPTURE(BM_BpfWriter, point, std::string("point"))->
+    Apply(bench::sizes);
+BENCHMARK_CAPTURE(BM_BpfWriter, dimension, std::string("dimension"))->
+    Apply(bench::sizes);
+BENCHMARK_CAPTURE(BM_BpfWriter, byte, std::string("byte"))->
+    Apply(bench::sizes);
+
+
+void BM_BpfReader(benchmark::State& state, const std::string& format)
+{
+    const point_count_t count = (point_count_t)state.range(0);
+    Options options(bpfOptions(format, count));
+    makeFile("writers.bpf", options, count);
+    runReader(state, "readers.bpf",
+        options.getValueOrThrow<std::string>("filename"));
+}
+BENCHMARK_CAPTURE(BM_BpfReader, point, std::string("point"))->
+    Apply(bench::sizes);
+BENCHMARK_CAPTURE(BM_BpfReader, dimension, std::string("dimension"))->
+    Apply(bench::sizes);
+BENCHMARK_CAPTURE(BM_BpfReader, byte, std::string("byte"))->
+    Apply(bench::sizes);
+
+} // unnamed namespace
@@ -0,0 +1,183 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "BenchSupport.hpp"
+
+#include <random>
+
+#include <pdal/KDIndex.hpp>
+#include <pdal/QuadIndex.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+const int QueryCount = 1000;
+
+// Query points drawn from the same box as the indexed points.
+std::vector<double> queryPoints()
+{
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> xy(0, 1000);
+    std::uniform_real_distribution<double> z(0, 100);
+    std::vector<double> xyz;
+    for (int i = 0; i < QueryCount; ++i)
+    {
+        xyz.push_back(xy(gen));
+        xyz.push_back(xy(gen));
+        xyz.push_back(z(gen));
+    }
+    return xyz;
+}
+
+
+void BM_KDIndexBuild(benchmark::State& state, bool b3d)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    for (auto _ : state)
+    {
+        KDIndex index(*view);
+        index.build(b3d);
+        benchmark::DoNotOptimize(&index);
+    }
+    bench::setPointsProcessed(state);
+}
+BENCHMARK_CAPTURE(BM_KDIndexBuild, 2d, false)->Apply(bench::sizes);
+BENCHMARK_CAPTURE(BM_KDIndexBuild, 3d, true)->Apply(bench::sizes);
+
+
+void BM_KDIndexNeighbors(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    KDIndex index(*view);
+    index.build(true);
+    std::vector<double> xyz(queryPoints());
+    std::vector<PointId> ids;
+    std::vector<double> dists;
+    for (auto _ : state)
+        for (int i = 0; i < QueryCount; ++i)
+        {
+            const double *p = xyz.data() + i * 3;
+            index.neighbors(p[0], p[1], p[2], 8, ids, dists);
+            benchmark::DoNotOptimize(ids.data());
+        }
+    state.SetItemsProcessed(state.iterations() * QueryCount);
+}
+BENCHMARK(BM_KDIndexNeighbors)->Apply(bench::sizes);
+
+
+void BM_KDIndexKnnBatch(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    KDIndex index(*view);
+    index.build(true);
+    std::vector<double> xyz(queryPoints());
+    std::vector<PointId> ids(QueryCount * 8);
+    std::vector<double> dists(QueryCount * 8);
+    for (auto _ : state)
+    {
+        index.knnBatch(xyz.data(), QueryCount, 8, ids.data(), dists.data());
+        benchmark::DoNotOptimize(ids.data());
+    }
+    state.SetItemsProcessed(state.iterations() * QueryCount);
+}
+BENCHMARK(BM_KDIndexKnnBatch)->Apply(bench::sizes);
+
+
+void BM_KDIndexRadius(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    KDIndex index(*view);
+    index.build(true);
+    std::vector<double> xyz(queryPoints());
+    for (auto _ : state)
+        for (int i = 0; i < QueryCount; ++i)
+        {
+            const double *p = xyz.data() + i * 3;
+            benchmark::DoNotOptimize(index.radius(p[0], p[1], p[2], 10));
+        }
+    state.SetItemsProcessed(state.iterations() * QueryCount);
+}
+BENCHMARK(BM_KDIndexRadius)->Apply(bench::sizes);
+
+
+void BM_QuadIndexBuild(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    for (auto _ : state)
+    {
+        QuadIndex index(*view);
+        benchmark::DoNotOptimize(index.getDepth());
+    }
+    bench::setPointsProcessed(state);
+}
+BENCHMARK(BM_QuadIndexBuild)->Apply(bench::sizes);
+
+
+void BM_QuadIndexBox(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    QuadIndex index(*view);
+    std::vector<double> xyz(queryPoints());
+    for (auto _ : state)
+        for (int i = 0; i < QueryCount; ++i)
+        {
+            const double *p = xyz.data() + i * 3;
+            benchmark::DoNotOptimize(index.getPoints(p[0], p[1],
+                p[0] + 20, p[1] + 20));
+        }
+    state.SetItemsProcessed(state.iterations() * QueryCount);
+}
+BENCHMARK(BM_QuadIndexBox)->Apply(bench::sizes);
+
+
+void BM_QuadIndexRaster(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    QuadIndex index(*view);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(index.getPoints(0.0, 1000.0, 1.0, 0.0, 1000.0, 1.0));
+    bench::setPointsProcessed(state);
+}
+BENCHMARK(BM_QuadIndexRaster)->Apply(bench::sizes);
+
+} // unnamed namespace
@@ -0,0 +1,123 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "BenchSupport.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+void BM_PointTableAddPoint(benchmark::State& state)
+{
+    const point_count_t count = (point_count_t)state.range(0);
+    for (auto _ : state)
+    {
+        PointTable table;
+        table.layout()->registerDim(Dimension::Id::X);
+        table.layout()->registerDim(Dimension::Id::Y);
+        table.layout()->registerDim(Dimension::Id::Z);
+        PointView view(table);
+        for (PointId i = 0; i < count; ++i)
+            view.setField(Dimension::Id::X, i, (double)i);
+        benchmark::DoNotOptimize(view.size());
+    }
+    bench::setPointsProcessed(state);
+}
+BENCHMARK(BM_PointTableAddPoint)->Apply(bench::sizes);
+
+
+template<typename T>
+void BM_PointViewGetFieldAs(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0),
+        "Intensity=uint16");
+    for (auto _ : state)
+    {
+        T sum = 0;
+        for (PointId i = 0; i < view->size(); ++i)
+            sum += view->getFieldAs<T>(Dimension::Id::Intensity, i);
+        benchmark::DoNotOptimize(sum);
+    }
+    bench::setPointsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_PointViewGetFieldAs, uint16_t)->Apply(bench::sizes);
+BENCHMARK_TEMPLATE(BM_PointViewGetFieldAs, double)->Apply(bench::sizes);
+
+
+void BM_PointViewSetField(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    for (auto _ : state)
+        for (PointId i = 0; i < view->size(); ++i)
+            view->setField(Dimension::Id::Z, i, (double)i);
+    bench::setPointsProcessed(state);
+}
+BENCHMARK(BM_PointViewSetField)->Apply(bench::sizes);
+
+
+void BM_PointViewDimHandle(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    DimHandle<double> z = view->handle<double>(Dimension::Id::Z);
+    for (auto _ : state)
+    {
+        double sum = 0;
+        for (PointId i = 0; i < view->size(); ++i)
+            sum += view->getField(z, i);
+        benchmark::DoNotOptimize(sum);
+    }
+    bench::setPointsProcessed(state);
+}
+BENCHMARK(BM_PointViewDimHandle)->Apply(bench::sizes);
+
+
+void BM_PointViewGetFieldArray(benchmark::State& state)
+{
+    PointTable table;
+    PointViewPtr view = bench::fauxView(table, (point_count_t)state.range(0));
+    std::vector<double> values(view->size());
+    for (auto _ : state)
+    {
+        view->getFieldArray(Dimension::Id::Z, 0, view->size(), values.data());
+        benchmark::DoNotOptimize(values.data());
+    }
+    bench::setPointsProcessed(state);
+}
+BENCHMARK(BM_PointViewGetFieldArray)->Apply(bench::sizes);
+
+} // unnamed namespace
@@ -34,6 +34,7 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <cmath>
 #include <iterator>
 #include <sstream>
 #include <iostream>
@@ -185,6 +186,63 @@ TEST(Compression, types)
     }
 }
 
+TEST(Compression, quantized)
+{
+    using namespace Dimension;
+
+    // A point is a Double and a Float.
+    const size_t count = 1000;
+    std::vector<char> pts(count * 12);
+    char *pos = pts.data();
+    for (size_t i = 0; i < count; ++i)
+    {
+        double d = 123456.789 + i * .0001234567;
+        float f = (float)(10 + sin(i / 100.0));
+        memcpy(pos, &d, sizeof(d));
+        memcpy(pos + 8, &f, sizeof(f));
+        pos += 12;
+    }
+
+    auto compress = [&pts](const DimTypeList& dimTypes)
+    {
+        std::vector<unsigned char> rawBuf;
+        LazPerfBuf b(rawBuf);
+        LazPerfCompressor<LazPerfBuf> compressor(b, dimTypes);
+        compressor.compress(pts.data(), pts.size());
+        compressor.done();
+        return rawBuf;
+    };
+
+    DimTypeList exact;
+    exact.push_back(DimType(Id::GpsTime, Type::Double));
+    exact.push_back(DimType(Id::Z, Type::Float));
+
+    DimTypeList dimTypes;
+    dimTypes.push_back(DimType(Id::GpsTime, Type::Double, XForm(.000001, 0)));
+    dimTypes.push_back(DimType(Id::Z, Type::Float, XForm(.001, 10)));
+
+    std::vector<unsigned char> exactBuf = compress(exact);
+    std::vector<unsigned char> rawBuf = compress(dimTypes);
+    EXPECT_LT(rawBuf.size(), exactBuf.size());
+
+    LazPerfBuf b(rawBuf);
+    LazPerfDecompressor<LazPerfBuf> decompressor(b, dimTypes);
+    std::vector<char> outbuf(pts.size());
+    decompressor.decompress(outbuf.data(), outbuf.size());
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        double d, od;
+        float f, of;
+        memcpy(&d, pts.data() + i * 12, sizeof(d));
+        memcpy(&od, outbuf.data() + i * 12, sizeof(od));
+        memcpy(&f, pts.data() + i * 12 + 8, sizeof(f));
+        memcpy(&of, outbuf.data() + i * 12 + 8, sizeof(of));
+        EXPECT_LE(std::abs(d - od), .0000005 + 1e-9);
+        EXPECT_LE(std::abs(f - of), .0005 + 1e-5);
+    }
+}
+
 //
 // BOOST_AUTO_TEST_CASE(test_compress_copied_view)
 // {
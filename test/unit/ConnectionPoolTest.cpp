@@ -0,0 +1,95 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/ConnectionPool.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+int g_closed = 0;
+
+void closeInt(void *conn)
+{
+    delete (int *)conn;
+    g_closed++;
+}
+
+} // unnamed namespace
+
+TEST(ConnectionPoolTest, reuse)
+{
+    g_closed = 0;
+    {
+        ConnectionPool pool(2);
+        EXPECT_EQ(pool.acquire("a"), nullptr);
+
+        int *conn = new int(1);
+        pool.release("a", conn, closeInt);
+        EXPECT_EQ(pool.idle("a"), 1u);
+        EXPECT_EQ(pool.acquire("b"), nullptr);
+        EXPECT_EQ(pool.acquire("a"), conn);
+        EXPECT_EQ(pool.acquire("a"), nullptr);
+
+        // Connections beyond the limit are closed.
+        pool.release("a", conn, closeInt);
+        pool.release("a", new int(2), closeInt);
+        pool.release("a", new int(3), closeInt);
+        EXPECT_EQ(pool.idle("a"), 2u);
+        EXPECT_EQ(g_closed, 1);
+
+        pool.release("b", new int(4), closeInt);
+        EXPECT_EQ(pool.idle("b"), 1u);
+
+        pool.clear();
+        EXPECT_EQ(pool.idle("a"), 0u);
+        EXPECT_EQ(g_closed, 4);
+
+        pool.release("a", new int(5), closeInt);
+    }
+    // Idle connections are closed with the pool.
+    EXPECT_EQ(g_closed, 5);
+}
+
+TEST(ConnectionPoolTest, disabled)
+{
+    g_closed = 0;
+    ConnectionPool pool(0);
+    pool.release("a", new int(1), closeInt);
+    EXPECT_EQ(g_closed, 1);
+    EXPECT_EQ(pool.acquire("a"), nullptr);
+}
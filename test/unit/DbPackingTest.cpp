@@ -0,0 +1,283 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/DbReader.hpp>
+#include <pdal/DbWriter.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/XMLSchema.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// Packs the view it's given both a range at a time with packPoints() and a
+// point at a time with readPoint().
+class PackWriter : public DbWriter
+{
+public:
+    std::string getName() const
+        { return "writers.packtest"; }
+
+    std::string m_schema;
+    std::vector<char> m_packed;
+    std::vector<char> m_expected;
+
+private:
+    virtual void write(const PointViewPtr view)
+    {
+        DimTypeList dims = dbDimTypes();
+        m_schema = XMLSchema(dims).xml();
+
+        size_t pointSize = 0;
+        for (const DimType& dt : dims)
+            pointSize += Dimension::size(dt.m_type);
+        m_packed.resize(view->size() * pointSize);
+        m_expected.resize(view->size() * pointSize);
+
+        EXPECT_EQ(packPoints(*view, 0, view->size(), m_packed.data()),
+            m_packed.size());
+        char *pos = m_expected.data();
+        for (PointId idx = 0; idx < view->size(); ++idx)
+            pos += readPoint(*view, idx, pos);
+    }
+};
+
+class UnpackReader : public DbReader
+{
+public:
+    std::string getName() const
+        { return "readers.unpacktest"; }
+
+    void load(PointLayoutPtr layout, const std::string& schema)
+        { loadSchema(layout, schema); }
+    void unpack(PointView& view, PointId begin, point_count_t count,
+            const char *buf)
+        { unpackPoints(view, begin, count, buf); }
+};
+
+const point_count_t NumPoints = 1000;
+
+// Register X, Y and Z and, if 'extra', dimensions of other types and fill
+// the view with points.
+void fill(PointTableRef table, PointViewPtr view, bool extra)
+{
+    using namespace Dimension;
+
+    PointLayoutPtr layout = table.layout();
+    layout->registerDim(Id::X);
+    layout->registerDim(Id::Y);
+    layout->registerDim(Id::Z);
+    if (extra)
+    {
+        layout->registerDim(Id::Intensity, Type::Unsigned16);
+        layout->registerDim(Id::Classification, Type::Unsigned8);
+        layout->registerDim(Id::GpsTime, Type::Double);
+    }
+    for (PointId idx = 0; idx < NumPoints; ++idx)
+    {
+        view->setField(Id::X, idx, 1000 + idx * .25);
+        view->setField(Id::Y, idx, 2000 - idx * .5);
+        view->setField(Id::Z, idx, (double)(idx % 100));
+        if (extra)
+        {
+            view->setField(Id::Intensity, idx, idx * 60);
+            view->setField(Id::Classification, idx, idx % 32);
+            view->setField(Id::GpsTime, idx, idx * 1.5);
+        }
+    }
+}
+
+// Pack 'view' with 'options' and check the points against those packed a
+// point at a time.
+void pack(PointTableRef table, PointViewPtr view, const Options& options,
+    PackWriter& writer)
+{
+    BufferReader reader;
+    reader.addView(view);
+    writer.setOptions(options);
+    writer.setInput(reader);
+    writer.prepare(table);
+    writer.execute(table);
+
+    ASSERT_EQ(writer.m_packed.size(), writer.m_expected.size());
+    EXPECT_TRUE(writer.m_packed == writer.m_expected);
+}
+
+// Check that the dimensions of 'view' match those of 'expected'.
+void compare(const PointView& view, const PointView& expected,
+    bool extra, double tolerance = 0)
+{
+    using namespace Dimension;
+
+    ASSERT_EQ(view.size(), expected.size());
+    for (PointId idx = 0; idx < view.size(); ++idx)
+    {
+        EXPECT_NEAR(view.getFieldAs<double>(Id::X, idx),
+            expected.getFieldAs<double>(Id::X, idx), tolerance);
+        EXPECT_NEAR(view.getFieldAs<double>(Id::Y, idx),
+            expected.getFieldAs<double>(Id::Y, idx), tolerance);
+        EXPECT_NEAR(view.getFieldAs<double>(Id::Z, idx),
+            expected.getFieldAs<double>(Id::Z, idx), tolerance);
+        if (extra)
+        {
+            EXPECT_EQ(view.getFieldAs<int>(Id::Intensity, idx),
+                expected.getFieldAs<int>(Id::Intensity, idx));
+            EXPECT_EQ(view.getFieldAs<int>(Id::Classification, idx),
+                expected.getFieldAs<int>(Id::Classification, idx));
+            EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::GpsTime, idx),
+                expected.getFieldAs<double>(Id::GpsTime, idx));
+        }
+    }
+}
+
+} // unnamed namespace
+
+// The packed points are laid out as the points of the table, so they're
+// copied whole.
+TEST(DbPackingTest, identity)
+{
+    PointTable table;
+    PointViewPtr view(new PointView(table));
+    fill(table, view, false);
+
+    PackWriter writer;
+    pack(table, view, Options(), writer);
+    ASSERT_EQ(writer.m_packed.size(), NumPoints * 3 * sizeof(double));
+
+    PointTable outTable;
+    UnpackReader reader;
+    reader.load(outTable.layout(), writer.m_schema);
+    outTable.layout()->finalize();
+    PointView outView(outTable);
+    reader.unpack(outView, 0, NumPoints, writer.m_packed.data());
+    compare(outView, *view, false);
+}
+
+// The writer orders the dimensions by ID with X, Y and Z last, unlike the
+// table, and the reader's table holds some dimensions in wider types.
+TEST(DbPackingTest, reorderedAndWidened)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    PointViewPtr view(new PointView(table));
+    fill(table, view, true);
+
+    PackWriter writer;
+    pack(table, view, Options(), writer);
+
+    PointTable outTable;
+    outTable.layout()->registerDim(Id::Intensity, Type::Unsigned32);
+    outTable.layout()->registerDim(Id::Classification, Type::Unsigned16);
+    UnpackReader reader;
+    reader.load(outTable.layout(), writer.m_schema);
+    outTable.layout()->finalize();
+    EXPECT_EQ(outTable.layout()->dimType(Id::Intensity), Type::Unsigned32);
+
+    PointView outView(outTable);
+    // Unpack in two ranges to add points to a view that has some.
+    reader.unpack(outView, 0, 400, writer.m_packed.data());
+    reader.unpack(outView, 400, NumPoints - 400,
+        writer.m_packed.data() + 400 * (writer.m_packed.size() / NumPoints));
+    compare(outView, *view, true);
+}
+
+// With a scale, X, Y and Z are stored as Signed32.
+TEST(DbPackingTest, scaledLocation)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    PointViewPtr view(new PointView(table));
+    fill(table, view, true);
+
+    Options options;
+    options.add("scale_x", .01);
+    options.add("scale_y", .01);
+    options.add("scale_z", .01);
+    options.add("offset_x", 1000);
+    PackWriter writer;
+    pack(table, view, options, writer);
+
+    XMLSchema schema(writer.m_schema);
+    for (const XMLDim& dim : schema.xmlDims())
+        if (dim.m_name == "X" || dim.m_name == "Y" || dim.m_name == "Z")
+        {
+            EXPECT_EQ(dim.m_dimType.m_type, Type::Signed32);
+        }
+
+    PointTable outTable;
+    UnpackReader reader;
+    reader.load(outTable.layout(), writer.m_schema);
+    outTable.layout()->finalize();
+    PointView outView(outTable);
+    reader.unpack(outView, 0, NumPoints, writer.m_packed.data());
+    compare(outView, *view, true, .005);
+}
+
+// Points of a view whose points aren't in the order of the table are
+// packed and unpacked a dimension at a time.
+TEST(DbPackingTest, reorderedView)
+{
+    PointTable table;
+    PointViewPtr view(new PointView(table));
+    fill(table, view, true);
+    PointViewPtr reversed = view->makeNew();
+    for (PointId idx = NumPoints; idx > 0; --idx)
+        reversed->appendPoint(*view, idx - 1);
+
+    PackWriter writer;
+    pack(table, reversed, Options(), writer);
+
+    // Overwrite the points of another reversed view.
+    PointTable outTable;
+    UnpackReader reader;
+    reader.load(outTable.layout(), writer.m_schema);
+    outTable.layout()->finalize();
+    PointView outView(outTable);
+    for (PointId idx = 0; idx < NumPoints; ++idx)
+        outView.setField(Dimension::Id::X, idx, 0);
+    PointView outReversed(outTable);
+    for (PointId idx = NumPoints; idx > 0; --idx)
+        outReversed.appendPoint(outView, idx - 1);
+    reader.unpack(outReversed, 0, NumPoints, writer.m_packed.data());
+    compare(outReversed, *reversed, true);
+    // The points are in the table in the original order.
+    compare(outView, *view, true);
+}
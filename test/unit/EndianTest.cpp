@@ -0,0 +1,106 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <vector>
+
+#include <pdal/util/Endian.hpp>
+#include <pdal/util/Extractor.hpp>
+#include <pdal/util/Inserter.hpp>
+
+using namespace pdal;
+
+TEST(EndianTest, swap)
+{
+    std::vector<uint16_t> u16 { 0x0102, 0xA0B0 };
+    Endian::swapBytes(u16.data(), u16.size());
+    EXPECT_EQ(u16[0], 0x0201);
+    EXPECT_EQ(u16[1], 0xB0A0);
+
+    std::vector<uint32_t> u32 { 0x01020304, 0xA0B0C0D0 };
+    Endian::swapBytes(u32.data(), u32.size());
+    EXPECT_EQ(u32[0], 0x04030201u);
+    EXPECT_EQ(u32[1], 0xD0C0B0A0u);
+
+    std::vector<uint64_t> u64 { 0x0102030405060708ULL };
+    Endian::swapBytes(u64.data(), u64.size());
+    EXPECT_EQ(u64[0], 0x0807060504030201ULL);
+
+    std::vector<int32_t> i32 { -2 };
+    Endian::hostToBig(i32.data(), i32.size());
+    const unsigned char *c = (const unsigned char *)i32.data();
+    EXPECT_EQ(c[0], 0xFF);
+    EXPECT_EQ(c[3], 0xFE);
+    Endian::bigToHost(i32.data(), i32.size());
+    EXPECT_EQ(i32[0], -2);
+}
+
+// Bulk conversions agree with the scalar extractor and inserter.
+TEST(EndianTest, convert)
+{
+    const size_t count = 1001;
+
+    std::vector<char> buf(count * sizeof(double));
+    LeInserter out(buf.data(), buf.size());
+    for (size_t i = 0; i < count; ++i)
+        out << (double)i / 3 - 100;
+
+    std::vector<double> doubles(count);
+    Endian::fromLittle<double>(buf.data(), count, doubles.data());
+    LeExtractor in(buf.data(), buf.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+        double d;
+        in >> d;
+        EXPECT_EQ(doubles[i], d);
+    }
+
+    // Encode as big-endian int16 and decode to double, unaligned.
+    std::vector<int16_t> shorts;
+    for (size_t i = 0; i < count; ++i)
+        shorts.push_back((int16_t)(i * 37 - 20000));
+    std::vector<char> be(count * sizeof(int16_t) + 1);
+    Endian::toBig<int16_t>(shorts.data(), count, be.data() + 1);
+    EXPECT_EQ((unsigned char)be[1], (uint16_t)shorts[0] >> 8);
+    Endian::fromBig<int16_t>(be.data() + 1, count, doubles.data());
+    for (size_t i = 0; i < count; ++i)
+        EXPECT_EQ(doubles[i], (double)shorts[i]);
+
+    std::vector<float> floats(count);
+    Endian::toLittle<float>(doubles.data(), count, buf.data());
+    Endian::fromLittle<float>(buf.data(), count, floats.data());
+    for (size_t i = 0; i < count; ++i)
+        EXPECT_FLOAT_EQ(floats[i], (float)shorts[i]);
+}
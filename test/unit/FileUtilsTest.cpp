@@ -162,3 +162,18 @@ TEST(FileUtilsTest, test_isAbsolute)
     const bool b = FileUtils::isAbsolutePath("a/b/foo.txt");
     EXPECT_TRUE(!b);
 }
+
+TEST(FileUtilsTest, test_glob)
+{
+    std::vector<std::string> files =
+        FileUtils::glob(Support::datapath("las/utm1?.las"));
+    ASSERT_EQ(files.size(), 2u);
+    compare_paths(files[0], Support::datapath("las/utm15.las"));
+    compare_paths(files[1], Support::datapath("las/utm17.las"));
+
+    files = FileUtils::glob(Support::datapath("las/*-with-color*.las"));
+    EXPECT_EQ(files.size(), 2u);
+
+    files = FileUtils::glob(Support::datapath("las/*.nothing"));
+    EXPECT_EQ(files.size(), 0u);
+}
@@ -36,9 +36,12 @@
 #include <pdal/pdal_test_main.hpp>
 
 #include <pdal/GDALUtils.hpp>
+#include <pdal/GlobalEnvironment.hpp>
 #include <pdal/util/FileUtils.hpp>
 #include "Support.hpp"
 
+#include <thread>
+
 #ifdef PDAL_COMPILER_MSVC
 #  pragma warning(push)
 #  pragma warning(disable: 4512)  // assignment operator could not be generated
@@ -205,3 +208,88 @@ TEST(GDALUtilsTest, test_wrapped_vsifile_subsequence)
 
     FileUtils::deleteFile(tempfile);
 }
+
+TEST(GDALUtilsTest, error_capture)
+{
+    gdal::ErrorCapture outer;
+    {
+        gdal::ErrorCapture inner;
+        CPLError(CE_Failure, CPLE_AppDefined, "first");
+        EXPECT_TRUE(inner.failed());
+        EXPECT_EQ(inner.lastErrorNum(), CPLE_AppDefined);
+        EXPECT_EQ(inner.lastError(), "first");
+        EXPECT_THROW(inner.check("Test:"), pdal::gdal_error);
+        inner.clear();
+        EXPECT_FALSE(inner.failed());
+        EXPECT_NO_THROW(inner.check("Test:"));
+    }
+    EXPECT_FALSE(outer.failed());
+
+    // Each thread reports to its own capture.
+    std::thread t([]()
+    {
+        gdal::ErrorCapture capture;
+        CPLError(CE_Failure, CPLE_AppDefined, "second");
+        EXPECT_EQ(capture.lastError(), "second");
+    });
+    t.join();
+    EXPECT_FALSE(outer.failed());
+
+    CPLError(CE_Failure, CPLE_AppDefined, "third");
+    EXPECT_EQ(outer.lastError(), "third");
+}
+
+TEST(GDALUtilsTest, dataset_pool)
+{
+    GlobalEnvironment::get().initializeGDAL(LogPtr());
+
+    gdal::DatasetPool pool(Support::datapath("autzen/autzen.jpg"));
+    {
+        gdal::DatasetPool::Dataset a = pool.acquire();
+        gdal::DatasetPool::Dataset b = pool.acquire();
+        EXPECT_TRUE((bool)a);
+        EXPECT_TRUE(a.get() != b.get());
+        EXPECT_EQ(pool.opened(), 2u);
+    }
+    // Released handles are reused.
+    {
+        gdal::DatasetPool::Dataset a = pool.acquire();
+        EXPECT_TRUE(GDALGetRasterXSize(a.get()) > 0);
+        EXPECT_EQ(pool.opened(), 2u);
+    }
+
+    gdal::DatasetPool bad(Support::datapath("nonexistent.tif"));
+    EXPECT_THROW(bad.acquire(), pdal::gdal_error);
+}
+
+TEST(GDALUtilsTest, srs_cache)
+{
+    GlobalEnvironment::get().initializeGDAL(LogPtr());
+
+    gdal::SrsCache& cache = gdal::SrsCache::get();
+    cache.clear();
+
+    // Each caller gets its own copy of a reference parsed once.
+    gdal::SrsCache::ReferencePtr a = cache.reference("EPSG:4326");
+    gdal::SrsCache::ReferencePtr b = cache.reference("EPSG:4326");
+    EXPECT_TRUE(a.get() != b.get());
+    EXPECT_EQ(cache.parsed(), 1u);
+    EXPECT_THROW(cache.reference("not a reference"), pdal::pdal_error);
+
+    gdal::SrsCache::TransformPtr t1 =
+        cache.takeTransform("EPSG:4326", "EPSG:32610");
+    gdal::SrsCache::TransformPtr t2 =
+        cache.takeTransform("EPSG:4326", "EPSG:32610");
+    EXPECT_TRUE(t1.get() != t2.get());
+    EXPECT_EQ(cache.created(), 2u);
+    EXPECT_EQ(cache.parsed(), 2u);
+
+    void *given = t1.get();
+    cache.giveTransform("EPSG:4326", "EPSG:32610", t1);
+    t1.reset();
+    gdal::SrsCache::TransformPtr t3 =
+        cache.takeTransform("EPSG:4326", "EPSG:32610");
+    EXPECT_EQ(t3.get(), given);
+    EXPECT_EQ(cache.created(), 2u);
+    cache.clear();
+}
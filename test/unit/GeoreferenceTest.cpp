@@ -37,6 +37,7 @@
 #include <pdal/util/Georeference.hpp>
 
 #include <cmath>
+#include <vector>
 
 
 namespace pdal
@@ -124,5 +125,38 @@ TEST(Georeference, WithImu)
     EXPECT_DOUBLE_EQ(2.0000004696006983, point.Y);
     EXPECT_DOUBLE_EQ(3, point.Z);
 }
+
+
+TEST(Georeference, Batch)
+{
+    RotationMatrix boresight(0, 1, 0, 0, 0, -1, -1, 0, 0);
+    std::vector<double> range;
+    std::vector<double> angle;
+    std::vector<RotationMatrix> imu;
+    std::vector<Xyz> gps;
+    for (int i = 0; i < 20; ++i)
+    {
+        // Pairs of returns share a pulse's angle and position.
+        int pulse = i / 2;
+        range.push_back(100 + i);
+        angle.push_back(pulse * .05 - .3);
+        double h = pulse * .1;
+        imu.push_back(RotationMatrix(std::cos(h), std::sin(h), 0,
+            -std::sin(h), std::cos(h), 0, 0, 0, 1));
+        gps.push_back(Xyz(-2 + pulse * 1e-4, .7 + pulse * 1e-4, 500));
+    }
+
+    std::vector<Xyz> out(range.size(), Xyz(0, 0, 0));
+    georeferenceWgs84(range.size(), range.data(), angle.data(), boresight,
+        imu.data(), gps.data(), out.data());
+    for (size_t i = 0; i < range.size(); ++i)
+    {
+        Xyz point = georeferenceWgs84(range[i], angle[i], boresight, imu[i],
+            gps[i]);
+        EXPECT_DOUBLE_EQ(point.X, out[i].X);
+        EXPECT_DOUBLE_EQ(point.Y, out[i].Y);
+        EXPECT_DOUBLE_EQ(point.Z, out[i].Z);
+    }
+}
 }
 }
@@ -0,0 +1,165 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <random>
+
+#include <pdal/GridIndex.hpp>
+#include <pdal/KDIndex.hpp>
+#include <pdal/PointView.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// Compare the neighbor distances of a grid index and a KD index, which
+// may order tied neighbors differently.
+void compare(const PointView& view, bool b3d, point_count_t k,
+    const std::vector<double>& xyz)
+{
+    KDIndex kd(view);
+    kd.build(b3d);
+    GridIndex grid(view);
+    grid.build(b3d);
+
+    point_count_t n = xyz.size() / 3;
+    std::vector<PointId> kdIds(n * k);
+    std::vector<double> kdDists(n * k);
+    std::vector<PointId> gridIds(n * k);
+    std::vector<double> gridDists(n * k);
+    kd.knnBatch(xyz.data(), n, k, kdIds.data(), kdDists.data());
+    grid.knnBatch(xyz.data(), n, k, gridIds.data(), gridDists.data());
+    for (std::size_t i = 0; i < n * k; ++i)
+        ASSERT_DOUBLE_EQ(gridDists[i], kdDists[i]) << "at " << i;
+}
+
+PointViewPtr makeView(PointTableRef table)
+{
+    using namespace Dimension;
+
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    return PointViewPtr(new PointView(table));
+}
+
+} // unnamed namespace
+
+TEST(GridIndexTest, random)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    PointViewPtr view = makeView(table);
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> dist(0, 100);
+    for (PointId i = 0; i < 5000; ++i)
+    {
+        view->setField(Id::X, i, dist(gen));
+        view->setField(Id::Y, i, dist(gen));
+        view->setField(Id::Z, i, dist(gen));
+    }
+
+    // Query the points themselves and points outside the bounds.
+    std::vector<double> xyz;
+    for (PointId i = 0; i < 500; ++i)
+    {
+        xyz.push_back(view->getFieldAs<double>(Id::X, i));
+        xyz.push_back(view->getFieldAs<double>(Id::Y, i));
+        xyz.push_back(view->getFieldAs<double>(Id::Z, i));
+    }
+    for (int i = 0; i < 50; ++i)
+    {
+        xyz.push_back(dist(gen) * 3 - 100);
+        xyz.push_back(dist(gen) * 3 - 100);
+        xyz.push_back(dist(gen) * 3 - 100);
+    }
+    compare(*view, true, 8, xyz);
+    compare(*view, false, 8, xyz);
+    compare(*view, true, 1, xyz);
+}
+
+// Points in flat, dense clusters with a few far away.
+TEST(GridIndexTest, clustered)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    PointViewPtr view = makeView(table);
+    std::mt19937 gen(9);
+    std::normal_distribution<double> dist(0, 1);
+    std::uniform_real_distribution<double> far(-10000, 10000);
+    for (PointId i = 0; i < 5000; ++i)
+    {
+        double cx = (i % 4) * 50;
+        view->setField(Id::X, i, i % 500 ? cx + dist(gen) : far(gen));
+        view->setField(Id::Y, i, i % 500 ? dist(gen) : far(gen));
+        view->setField(Id::Z, i, 10.0);
+    }
+
+    std::vector<double> xyz;
+    for (PointId i = 0; i < view->size(); i += 7)
+    {
+        xyz.push_back(view->getFieldAs<double>(Id::X, i));
+        xyz.push_back(view->getFieldAs<double>(Id::Y, i));
+        xyz.push_back(view->getFieldAs<double>(Id::Z, i));
+    }
+    compare(*view, true, 12, xyz);
+}
+
+TEST(GridIndexTest, tooManyNeighbors)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    PointViewPtr view = makeView(table);
+    for (PointId i = 0; i < 3; ++i)
+    {
+        view->setField(Id::X, i, (double)i);
+        view->setField(Id::Y, i, (double)i);
+        view->setField(Id::Z, i, (double)i);
+    }
+
+    GridIndex grid(*view);
+    grid.build();
+    double xyz[3] = { 0, 0, 0 };
+    PointId ids[3];
+    double sqrDists[3];
+    grid.knnBatch(xyz, 1, 3, ids, sqrDists);
+    EXPECT_EQ(ids[0], 0u);
+    EXPECT_DOUBLE_EQ(sqrDists[2], 12.0);
+    EXPECT_THROW(grid.knnBatch(xyz, 1, 4, ids, sqrDists), pdal_error);
+}
@@ -0,0 +1,244 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <algorithm>
+#include <random>
+
+#include <pdal/KDIndex.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+PointViewPtr randomView(PointTableRef table, point_count_t count)
+{
+    using namespace Dimension;
+
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(0, 100);
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < count; ++i)
+    {
+        view->setField(Id::X, i, dist(gen));
+        view->setField(Id::Y, i, dist(gen));
+        view->setField(Id::Z, i, dist(gen));
+    }
+    return view;
+}
+
+// Squared distances from a point to every point of a view, sorted.
+std::vector<double> bruteForce(const PointView& view, const double *pt,
+    bool b3d)
+{
+    using namespace Dimension;
+
+    std::vector<double> dists;
+    for (PointId i = 0; i < view.size(); ++i)
+    {
+        double dx = view.getFieldAs<double>(Id::X, i) - pt[0];
+        double dy = view.getFieldAs<double>(Id::Y, i) - pt[1];
+        double dz = b3d ? view.getFieldAs<double>(Id::Z, i) - pt[2] : 0;
+        dists.push_back(dx * dx + dy * dy + dz * dz);
+    }
+    std::sort(dists.begin(), dists.end());
+    return dists;
+}
+
+void checkBatch(bool b3d)
+{
+    PointTable table;
+    PointViewPtr view = randomView(table, 5000);
+    KDIndex index(*view);
+    index.build(b3d);
+
+    const point_count_t n = 1000;
+    const point_count_t k = 6;
+    std::vector<double> xyz;
+    for (PointId i = 0; i < n; ++i)
+    {
+        xyz.push_back(i * 0.1);
+        xyz.push_back(100 - i * 0.1);
+        xyz.push_back(50);
+    }
+    std::vector<PointId> ids(n * k);
+    std::vector<double> sqrDists(n * k);
+    index.knnBatch(xyz.data(), n, k, ids.data(), sqrDists.data());
+
+    for (PointId i = 0; i < n; ++i)
+    {
+        std::vector<double> expected = bruteForce(*view, &xyz[i * 3], b3d);
+        std::vector<PointId> single =
+            index.neighbors(xyz[i * 3], xyz[i * 3 + 1], xyz[i * 3 + 2], k);
+        for (point_count_t j = 0; j < k; ++j)
+        {
+            EXPECT_DOUBLE_EQ(sqrDists[i * k + j], expected[j]);
+            EXPECT_EQ(ids[i * k + j], single[j]);
+        }
+    }
+}
+
+} // unnamed namespace
+
+TEST(KDIndexTest, knnBatch)
+{
+    checkBatch(true);
+}
+
+TEST(KDIndexTest, knnBatch2d)
+{
+    checkBatch(false);
+}
+
+TEST(KDIndexTest, tooManyNeighbors)
+{
+    PointTable table;
+    PointViewPtr view = randomView(table, 10);
+    KDIndex index(*view);
+    index.build();
+
+    double pt[3] = { 0, 0, 0 };
+    std::vector<PointId> ids(11);
+    std::vector<double> sqrDists(11);
+    EXPECT_THROW(index.knnBatch(pt, 1, 11, ids.data(), sqrDists.data()),
+        pdal_error);
+}
+
+TEST(KDIndexTest, saveLoad)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    PointViewPtr view = randomView(table, 5000);
+    std::string filename(Support::temppath("kdindex.idx"));
+    FileUtils::deleteFile(filename);
+
+    KDIndex built(*view);
+    built.build(filename);
+    EXPECT_TRUE(FileUtils::fileExists(filename));
+
+    KDIndex loaded(*view);
+    EXPECT_TRUE(loaded.load(filename));
+    for (PointId i = 0; i < 100; ++i)
+    {
+        double x = i;
+        double y = 100 - i;
+        double z = 50;
+        EXPECT_EQ(loaded.neighbors(x, y, z, 4), built.neighbors(x, y, z, 4));
+    }
+
+    // The saved index is of 3D points.
+    KDIndex flat(*view);
+    EXPECT_FALSE(flat.load(filename, false));
+
+    // The saved index no longer matches the points.
+    view->setField(Id::X, 0, 500.0);
+    KDIndex changed(*view);
+    EXPECT_FALSE(changed.load(filename));
+
+    FileUtils::deleteFile(filename);
+    EXPECT_FALSE(changed.load(filename));
+}
+
+// Queries of the packed coordinates find what a search of the view's own
+// values finds, for single precision coordinates and for Z far from X and
+// Y.
+TEST(KDIndexTest, matchesView)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X, Type::Float);
+    table.layout()->registerDim(Id::Y, Type::Float);
+    table.layout()->registerDim(Id::Z);
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> dist(0, 100);
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < 3000; ++i)
+    {
+        view->setField(Id::X, i, dist(gen));
+        view->setField(Id::Y, i, dist(gen));
+        view->setField(Id::Z, i, 1000 + dist(gen) / 10);
+    }
+
+    for (bool b3d : { false, true })
+    {
+        KDIndex index(*view);
+        index.build(b3d);
+        for (int q = 0; q < 200; ++q)
+        {
+            double pt[3] = { dist(gen), dist(gen), 1000 + dist(gen) / 10 };
+
+            std::vector<std::pair<double, PointId>> expected;
+            for (PointId i = 0; i < view->size(); ++i)
+            {
+                double dx = view->getFieldAs<double>(Id::X, i) - pt[0];
+                double dy = view->getFieldAs<double>(Id::Y, i) - pt[1];
+                double dz = b3d ?
+                    view->getFieldAs<double>(Id::Z, i) - pt[2] : 0;
+                expected.push_back(
+                    std::make_pair(dx * dx + dy * dy + dz * dz, i));
+            }
+            std::sort(expected.begin(), expected.end());
+
+            std::vector<PointId> ids =
+                index.neighbors(pt[0], pt[1], pt[2], 8);
+            ASSERT_EQ(ids.size(), 8u);
+            for (size_t j = 0; j < ids.size(); ++j)
+                EXPECT_EQ(ids[j], expected[j].second);
+
+            // The radius is of squared distance.
+            const double r = 16;
+            std::vector<std::size_t> found =
+                index.radius(pt[0], pt[1], pt[2], r);
+            std::sort(found.begin(), found.end());
+            std::vector<std::size_t> inside;
+            for (auto& e : expected)
+                if (e.first < r)
+                    inside.push_back(e.second);
+            std::sort(inside.begin(), inside.end());
+            EXPECT_EQ(found, inside);
+        }
+    }
+}
@@ -0,0 +1,149 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <limits>
+#include <sstream>
+
+#include <pdal/util/IStream.hpp>
+#include <pdal/util/OStream.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+template<typename STREAM>
+void writeValues(STREAM& out, int count)
+{
+    for (int i = 0; i < count; ++i)
+        out << (uint8_t)i << (int16_t)-i << (uint32_t)(i * 1000) <<
+            (int64_t)i * std::numeric_limits<int32_t>::max() <<
+            (float)i / 3 << (double)i / 7;
+}
+
+} // unnamed namespace
+
+// Values written through the buffered stream match those written through
+// OLeStream and read back through both input streams.
+TEST(LeStreamTest, roundtrip)
+{
+    const int count = 5000;
+
+    std::ostringstream plain;
+    OLeStream out(&plain);
+    writeValues(out, count);
+
+    std::ostringstream buffered;
+    {
+        // Small buffer so that values straddle the flushes.
+        BufferedOLeStream bout(&buffered, 13);
+        writeValues(bout, count);
+        EXPECT_EQ(bout.position(), (std::streampos)(count * 27));
+    }
+    EXPECT_EQ(plain.str(), buffered.str());
+
+    std::istringstream iss(buffered.str());
+    BufferedILeStream in(&iss, 100);
+    for (int i = 0; i < count; ++i)
+    {
+        uint8_t u8;
+        int16_t i16;
+        uint32_t u32;
+        int64_t i64;
+        float f;
+        double d;
+
+        in >> u8 >> i16 >> u32 >> i64 >> f >> d;
+        EXPECT_EQ(u8, (uint8_t)i);
+        EXPECT_EQ(i16, (int16_t)-i);
+        EXPECT_EQ(u32, (uint32_t)(i * 1000));
+        EXPECT_EQ(i64, (int64_t)i * std::numeric_limits<int32_t>::max());
+        EXPECT_FLOAT_EQ(f, (float)i / 3);
+        EXPECT_DOUBLE_EQ(d, (double)i / 7);
+    }
+    EXPECT_TRUE((bool)in);
+    EXPECT_EQ(in.position(), (std::streampos)(count * 27));
+
+    uint32_t u32;
+    in >> u32;
+    EXPECT_FALSE((bool)in);
+}
+
+TEST(LeStreamTest, seek)
+{
+    std::ostringstream oss;
+    {
+        BufferedOLeStream out(&oss);
+        for (uint32_t i = 0; i < 1000; ++i)
+            out << i;
+        // Overwrite the first value.
+        out.seek(0);
+        out << (uint32_t)12345;
+    }
+
+    std::istringstream iss(oss.str());
+    BufferedILeStream in(&iss, 64);
+    uint32_t u32;
+
+    in >> u32;
+    EXPECT_EQ(u32, 12345u);
+
+    // Within the window.
+    in.seek(8 * sizeof(uint32_t));
+    in >> u32;
+    EXPECT_EQ(u32, 8u);
+
+    // Outside the window and back again.
+    in.seek(900 * sizeof(uint32_t));
+    in >> u32;
+    EXPECT_EQ(u32, 900u);
+    in.skip(9 * sizeof(uint32_t));
+    in >> u32;
+    EXPECT_EQ(u32, 910u);
+    in.seek(4);
+    in >> u32;
+    EXPECT_EQ(u32, 1u);
+
+    // Blocks larger than the window are read through.
+    std::vector<char> buf(200 * sizeof(uint32_t));
+    in.get(buf);
+    EXPECT_EQ(in.position(), (std::streampos)(202 * sizeof(uint32_t)));
+    in >> u32;
+    EXPECT_EQ(u32, 202u);
+    EXPECT_EQ(buf[0], 2);
+    EXPECT_EQ(buf[199 * sizeof(uint32_t)], (char)201);
+    EXPECT_TRUE((bool)in);
+}
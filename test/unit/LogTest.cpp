@@ -39,6 +39,9 @@
 #include <FauxReader.hpp>
 #include "Support.hpp"
 
+#include <cstdio>
+#include <sstream>
+
 using namespace pdal;
 
 TEST(LogTest, test_one)
@@ -84,6 +87,71 @@ TEST(LogTest, test_one)
     EXPECT_TRUE(ok);
 }
 
+TEST(LogTest, disabled)
+{
+    std::ostringstream out;
+    Log log("test", &out);
+    log.setLevel(LogLevel::Debug);
+
+    int calls = 0;
+    auto entry = [&calls]()
+    {
+        calls++;
+        return "entry";
+    };
+    PDAL_LOG(&log, LogLevel::Debug) << entry() << std::endl;
+    PDAL_LOG(&log, LogLevel::Debug5) << entry() << std::endl;
+    log.write(LogLevel::Debug5, [&](std::ostream& o){ o << entry(); });
+    EXPECT_EQ(calls, 1);
+    EXPECT_NE(out.str().find("entry\n"), std::string::npos);
+}
+
+
+TEST(LogTest, async)
+{
+    std::ostringstream out;
+    {
+        Log log("test", &out);
+        log.setLevel(LogLevel::Debug);
+        log.setAsync(1000);
+        for (int i = 0; i < 100; ++i)
+            log.get(LogLevel::Debug) << "line " << i << std::endl;
+    }
+    std::istringstream in(out.str());
+    std::string line;
+    int count = 0;
+    while (std::getline(in, line))
+    {
+        EXPECT_NE(line.find("line " + std::to_string(count)),
+            std::string::npos);
+        count++;
+    }
+    EXPECT_EQ(count, 100);
+
+    // Lines that don't fit in the ring are dropped and counted.
+    std::ostringstream out2;
+    {
+        Log log("test", &out2);
+        log.setAsync(1);
+        for (int i = 0; i < 1000; ++i)
+            log.get(LogLevel::Error) << "line " << i << std::endl;
+    }
+    std::istringstream in2(out2.str());
+    int total = 0;
+    while (std::getline(in2, line))
+    {
+        int dropped;
+        if (sscanf(line.c_str(), "(%d log lines dropped)", &dropped) == 1)
+            total += dropped;
+        else
+        {
+            EXPECT_NE(line.find("line "), std::string::npos);
+            total++;
+        }
+    }
+    EXPECT_EQ(total, 1000);
+}
+
 #ifdef PDAL_HAVE_PYTHON
 
 TEST(LogTest, test_two_a)
@@ -0,0 +1,153 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <thread>
+
+#include <pdal/KDIndex.hpp>
+#include <pdal/MemoryAccount.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <FauxReader.hpp>
+
+using namespace pdal;
+
+TEST(MemoryAccountTest, allocator)
+{
+    memory::AccountPtr account(new memory::Account);
+    typedef memory::Vector<double, memory::Temporary> Doubles;
+
+    // Nothing is charged without a current account.
+    Doubles uncharged(100);
+
+    {
+        memory::Scope scope(account.get());
+        EXPECT_EQ(memory::current(), account.get());
+
+        Doubles v(1000);
+        EXPECT_EQ(account->current(memory::Temporary), 8000u);
+        {
+            Doubles w(500);
+            EXPECT_EQ(account->current(memory::Temporary), 12000u);
+        }
+        EXPECT_EQ(account->current(memory::Temporary), 8000u);
+        EXPECT_EQ(account->peak(memory::Temporary), 12000u);
+        EXPECT_EQ(account->total(memory::Temporary), 12000u);
+        EXPECT_EQ(account->current(memory::ViewIndex), 0u);
+
+        // Memory freed on another thread, outside the scope, is still
+        // credited to the account that was charged.
+        Doubles *moved = new Doubles(std::move(v));
+        std::thread t([moved](){ delete moved; });
+        t.join();
+    }
+    EXPECT_EQ(memory::current(), (memory::Account *)NULL);
+    EXPECT_EQ(account->current(memory::Temporary), 0u);
+    EXPECT_EQ(account->total(memory::Temporary), 12000u);
+}
+
+
+TEST(MemoryAccountTest, charge)
+{
+    memory::AccountPtr account(new memory::Account);
+
+    memory::Scope scope(account.get());
+    {
+        memory::Charge c(memory::SpatialIndex, 100);
+        EXPECT_EQ(account->current(memory::SpatialIndex), 100u);
+        memory::Charge d;
+        d = std::move(c);
+        EXPECT_EQ(account->current(memory::SpatialIndex), 100u);
+    }
+    EXPECT_EQ(account->current(memory::SpatialIndex), 0u);
+    EXPECT_EQ(account->peak(memory::SpatialIndex), 100u);
+}
+
+
+TEST(MemoryAccountTest, stages)
+{
+    Options ops;
+    ops.add("bounds", BOX3D(0.0, 0.0, 0.0, 100.0, 100.0, 100.0));
+    ops.add("mode", "random");
+    ops.add("num_points", 10000);
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    uint64_t tableBytes;
+    {
+        PointTable table;
+        reader.prepare(table);
+        reader.execute(table);
+        tableBytes = table.storageBytes();
+    }
+
+    const StageProfile& p = reader.profile();
+    EXPECT_EQ(p.m_peakBytes[memory::TableBlocks], tableBytes);
+    EXPECT_EQ(p.m_allocatedBytes[memory::TableBlocks], tableBytes);
+    EXPECT_EQ(p.m_peakBytes[memory::Temporary], 0u);
+
+    MetadataNode profile = reader.pipelineProfile();
+    MetadataNode table = profile.findChild("readers.faux").
+        findChild("memory").findChild("table");
+    EXPECT_EQ(table.findChild("peak_bytes").value<uint64_t>(), tableBytes);
+}
+
+
+TEST(MemoryAccountTest, index)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+    PointView view(table);
+    for (PointId i = 0; i < 1000; ++i)
+    {
+        view.setField(Dimension::Id::X, i, i);
+        view.setField(Dimension::Id::Y, i, i % 10);
+        view.setField(Dimension::Id::Z, i, 0);
+    }
+
+    memory::AccountPtr account(new memory::Account);
+    {
+        memory::Scope scope(account.get());
+        KDIndex index(view);
+        index.build();
+        // The coordinates and the tree.
+        EXPECT_GT(account->current(memory::SpatialIndex),
+            1000 * 3 * sizeof(double));
+    }
+    EXPECT_EQ(account->current(memory::SpatialIndex), 0u);
+}
@@ -37,6 +37,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <pdal/Metadata.hpp>
+#include <pdal/PDALUtils.hpp>
 
 using namespace pdal;
 
@@ -158,6 +159,68 @@ TEST(MetadataTest, typed_value)
 }
 
 
+// Numbers are held as numbers and read back as those of their text.
+TEST(MetadataTest, numbers)
+{
+    MetadataNode m;
+    MetadataNode big = m.add("big", (uint64_t)70000);
+    EXPECT_EQ(big.value<uint64_t>(), 70000u);
+    EXPECT_EQ(big.value<int>(), 70000);
+    EXPECT_EQ(big.value(), "70000");
+    auto redir = Utils::redirect(std::cerr);
+    EXPECT_EQ(big.value<uint16_t>(), 0u);
+    Utils::restore(std::cerr, redir);
+
+    MetadataNode neg = m.add("neg", -5);
+    EXPECT_EQ(neg.value<long long>(), -5);
+    EXPECT_EQ(neg.value<double>(), -5.0);
+
+    MetadataNode f = m.add("f", 1.1f);
+    EXPECT_EQ(f.value(), "1.10000002");
+    EXPECT_EQ(f.value<float>(), 1.1f);
+    EXPECT_EQ(f.value<double>(), 1.10000002);
+
+    MetadataNode d = m.add("d", 0.1);
+    EXPECT_EQ(d.value<double>(), 0.1);
+    EXPECT_EQ(d.type(), "double");
+
+    // Updating a number with text replaces its text too.
+    MetadataNode u = m.addOrUpdate("u", 3);
+    EXPECT_EQ(u.value(), "3");
+    u = m.addOrUpdate("u", std::string("three"));
+    EXPECT_EQ(u.value(), "three");
+    EXPECT_EQ(u.type(), "string");
+}
+
+
+TEST(MetadataTest, json)
+{
+    MetadataNode m("root");
+    m.add("count", 3u);
+    m.add("name", std::string("a \"b\""));
+    MetadataNode l = m.add("list");
+    l.addList("x", 1.5);
+    l.addList("x", true);
+
+    EXPECT_EQ(utils::toJSON(m),
+        "{\n"
+        "  \"root\":\n"
+        "  {\n"
+        "    \"count\": 3,\n"
+        "    \"list\":\n"
+        "    {\n"
+        "      \"x\":\n"
+        "      [\n"
+        "        1.5,\n"
+        "        true\n"
+        "      ]\n"
+        "    },\n"
+        "    \"name\": \"a \\\"b\\\"\"\n"
+        "  }\n"
+        "}\n");
+}
+
+
 TEST(MetadataTest, test_construction_with_srs)
 {
     MetadataNode m;
@@ -0,0 +1,149 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+#include <pdal/OctreeIndex.hpp>
+#include <pdal/PointView.hpp>
+
+using namespace pdal;
+
+TEST(OctreeIndexTest, structure)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+
+    // Point i is at the corner of octant 7 - i and the last point is at
+    // the center.
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < 8; ++i)
+    {
+        int o = 7 - i;
+        view->setField(Id::X, i, (o & 1) ? 10.0 : 0.0);
+        view->setField(Id::Y, i, (o & 2) ? 10.0 : 0.0);
+        view->setField(Id::Z, i, (o & 4) ? 10.0 : 0.0);
+    }
+    view->setField(Id::X, 8, 5.0);
+    view->setField(Id::Y, 8, 5.0);
+    view->setField(Id::Z, 8, 5.0);
+
+    OctreeIndex idx(*view);
+    EXPECT_EQ(idx.getDepth(), 1u);
+    EXPECT_EQ(idx.getFills(), std::vector<std::size_t>({ 1, 8 }));
+    EXPECT_EQ(idx.getPoints(),
+        std::vector<PointId>({ 8, 7, 6, 5, 4, 3, 2, 1, 0 }));
+    EXPECT_EQ(idx.getPoints(1), std::vector<PointId>({ 8 }));
+    EXPECT_EQ(idx.getPoints(1, 0).size(), 8u);
+    EXPECT_EQ(idx.getPoints(BOX3D(0, 0, 0, 5, 5, 5)),
+        std::vector<PointId>({ 8, 7 }));
+    EXPECT_EQ(idx.getPoints(BOX3D(0, 0, 0, 5, 5, 5), 1, 0),
+        std::vector<PointId>({ 7 }));
+
+    double xStep, yStep, zStep;
+    EXPECT_EQ(idx.getVoxels(0, xStep, yStep, zStep),
+        std::vector<PointId>({ 8 }));
+    EXPECT_DOUBLE_EQ(xStep, 10.0);
+
+    std::vector<PointId> voxels(idx.getVoxels(1, xStep, yStep, zStep));
+    ASSERT_EQ(voxels.size(), 8u);
+    for (int o = 0; o < 8; ++o)
+        EXPECT_EQ(voxels[o], (PointId)(7 - o));
+    EXPECT_DOUBLE_EQ(zStep, 5.0);
+
+    voxels = idx.getVoxels(2, xStep, yStep, zStep);
+    ASSERT_EQ(voxels.size(), 64u);
+    EXPECT_EQ(std::count(voxels.begin(), voxels.end(),
+        std::numeric_limits<PointId>::max()), 64);
+}
+
+// Check box queries against a scan of the points, with enough points that
+// the tree is built in parallel.
+TEST(OctreeIndexTest, boxes)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(0, 100);
+    PointViewPtr view(new PointView(table));
+    const PointId count(200000);
+    for (PointId i = 0; i < count; ++i)
+    {
+        view->setField(Id::X, i, dist(gen));
+        view->setField(Id::Y, i, dist(gen));
+        // A few identical points.
+        view->setField(Id::Z, i, i % 1000 ? dist(gen) : 50.0);
+    }
+
+    OctreeIndex idx(*view);
+    std::vector<PointId> all(idx.getPoints());
+    ASSERT_EQ(all.size(), count);
+    std::sort(all.begin(), all.end());
+    for (PointId i = 0; i < count; ++i)
+        ASSERT_EQ(all[i], i);
+
+    std::vector<std::size_t> fills(idx.getFills());
+    EXPECT_EQ(fills.size(), idx.getDepth() + 1);
+    EXPECT_EQ(fills[0], 1u);
+    EXPECT_EQ(fills[1], 8u);
+
+    for (int b = 0; b < 10; ++b)
+    {
+        double x(dist(gen)), y(dist(gen)), z(dist(gen));
+        BOX3D box(x, y, z, x + 20, y + 10, z + 5);
+
+        std::vector<PointId> expected;
+        for (PointId i = 0; i < count; ++i)
+            if (box.contains(view->getFieldAs<double>(Id::X, i),
+                view->getFieldAs<double>(Id::Y, i),
+                view->getFieldAs<double>(Id::Z, i)))
+                expected.push_back(i);
+
+        std::vector<PointId> found(idx.getPoints(box));
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+    }
+}
@@ -37,6 +37,8 @@
 #include "Support.hpp"
 
 #include <pdal/PipelineManager.hpp>
+#include <pdal/PipelineReader.hpp>
+#include <pdal/PipelineWriter.hpp>
 #include <pdal/util/FileUtils.hpp>
 
 using namespace pdal;
@@ -71,6 +73,185 @@ TEST(PipelineManagerTest, basic)
 }
 
 
+namespace
+{
+
+// The manager owns the table, so it has to outlive the view.
+PointViewPtr mergeFour(PipelineManager& mgr, std::size_t concurrency)
+{
+    mgr.setConcurrency(concurrency);
+
+    std::vector<Stage *> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        Options opts;
+        opts.add("filename", Support::datapath("las/1.2-with-color.las"));
+        Stage& reader = mgr.addReader("readers.las");
+        reader.setOptions(opts);
+        readers.push_back(&reader);
+    }
+    // The last stage added is the end of the pipeline.
+    Stage& merge = mgr.addFilter("filters.merge");
+    for (Stage *reader : readers)
+        merge.setInput(*reader);
+
+    EXPECT_EQ(mgr.execute(), 4 * 1065U);
+    EXPECT_EQ(mgr.views().size(), 1U);
+    return *mgr.views().begin();
+}
+
+} // unnamed namespace
+
+
+// Readers feeding a merge run at once, but the merged points come out in
+// the same order as when they run one at a time.
+TEST(PipelineManagerTest, concurrency)
+{
+    PipelineManager serialMgr;
+    PointViewPtr serial = mergeFour(serialMgr, 1);
+    PipelineManager concurrentMgr;
+    PointViewPtr concurrent = mergeFour(concurrentMgr, 4);
+
+    ASSERT_EQ(serial->size(), concurrent->size());
+    for (PointId idx = 0; idx < serial->size(); ++idx)
+    {
+        EXPECT_DOUBLE_EQ(serial->getFieldAs<double>(Dimension::Id::X, idx),
+            concurrent->getFieldAs<double>(Dimension::Id::X, idx));
+        EXPECT_EQ(serial->getFieldAs<uint16_t>(Dimension::Id::Intensity, idx),
+            concurrent->getFieldAs<uint16_t>(Dimension::Id::Intensity, idx));
+    }
+}
+
+TEST(PipelineManagerTest, profile)
+{
+    std::string outfile(Support::temppath("profile.las"));
+    FileUtils::deleteFile(outfile);
+
+    PipelineManager mgr;
+    Options optsR;
+    optsR.add("filename", Support::datapath("las/1.2-with-color.las"));
+    Stage& reader = mgr.addReader("readers.las");
+    reader.setOptions(optsR);
+
+    Options optsW;
+    optsW.add("filename", outfile);
+    Stage& writer = mgr.addWriter("writers.las");
+    writer.setInput(reader);
+    writer.setOptions(optsW);
+    mgr.execute();
+
+    EXPECT_EQ(reader.profile().m_pointsOut, 1065U);
+    EXPECT_EQ(writer.profile().m_pointsIn, 1065U);
+    EXPECT_GT(writer.profile().m_peakTableBytes, 0U);
+    EXPECT_GE(reader.profile().m_executeTime, 0.0);
+
+    MetadataNode profile = writer.pipelineProfile();
+    EXPECT_EQ(profile.name(), "pipeline_profile");
+    MetadataNode r = profile.findChild("readers.las");
+    EXPECT_EQ(r.findChild("points_out").value<point_count_t>(), 1065U);
+    MetadataNode w = profile.findChild("writers.las");
+    EXPECT_EQ(w.findChild("points_in").value<point_count_t>(), 1065U);
+    FileUtils::deleteFile(outfile);
+}
+
+TEST(PipelineManagerTest, resultCache)
+{
+    std::string outfile(Support::temppath("cached.las"));
+    std::string cacheDir(Support::temppath("resultcache"));
+    FileUtils::deleteFile(outfile);
+    FileUtils::deleteDirectory(cacheDir);
+
+    auto run = [&](const std::string& minorVersion, bool& hit)
+    {
+        PipelineManager mgr;
+        mgr.setResultCache(cacheDir);
+        Options optsR;
+        optsR.add("filename", Support::datapath("las/1.2-with-color.las"));
+        Stage& reader = mgr.addReader("readers.las");
+        reader.setOptions(optsR);
+
+        Options optsW;
+        optsW.add("filename", outfile);
+        optsW.add("minor_version", minorVersion);
+        Stage& writer = mgr.addWriter("writers.las");
+        writer.setInput(reader);
+        writer.setOptions(optsW);
+        point_count_t cnt = mgr.execute();
+        hit = mgr.cacheHit();
+        EXPECT_EQ(mgr.views().empty(), hit);
+        return cnt;
+    };
+
+    bool hit;
+    EXPECT_EQ(run("2", hit), 1065U);
+    EXPECT_FALSE(hit);
+    EXPECT_EQ(run("2", hit), 1065U);
+    EXPECT_TRUE(hit);
+
+    // A change to an option or to the output runs the pipeline again.
+    EXPECT_EQ(run("3", hit), 1065U);
+    EXPECT_FALSE(hit);
+    EXPECT_EQ(run("2", hit), 1065U);
+    EXPECT_FALSE(hit);
+    FileUtils::deleteFile(outfile);
+    EXPECT_EQ(run("2", hit), 1065U);
+    EXPECT_FALSE(hit);
+    EXPECT_EQ(run("2", hit), 1065U);
+    EXPECT_TRUE(hit);
+
+    FileUtils::deleteFile(outfile);
+    FileUtils::deleteDirectory(cacheDir);
+}
+
+// Writers in a <Writers> element share their input, which is only run once.
+TEST(PipelineManagerTest, tee)
+{
+    std::string out1(Support::temppath("tee1.las"));
+    std::string out2(Support::temppath("tee2.las"));
+    std::string xml(Support::temppath("tee.xml"));
+    FileUtils::deleteFile(out1);
+    FileUtils::deleteFile(out2);
+
+    {
+        PipelineManager mgr;
+        PipelineReader specReader(mgr);
+        EXPECT_TRUE(specReader.readPipeline(
+            Support::configuredpath("pipeline/pipeline_tee.xml")));
+
+        std::vector<Stage *> ends = mgr.endpoints();
+        ASSERT_EQ(ends.size(), 2U);
+        Stage *crop = ends[0]->getInputs()[0];
+        EXPECT_EQ(crop, ends[1]->getInputs()[0]);
+
+        EXPECT_EQ(mgr.execute(), 1065U);
+        EXPECT_EQ(crop->profile().m_pointsOut, 1065U);
+        EXPECT_EQ(ends[0]->profile().m_pointsIn, 1065U);
+        EXPECT_EQ(ends[1]->profile().m_pointsIn, 1065U);
+        FixedPointTable table(100);
+        EXPECT_THROW(mgr.executeStream(table), pdal_error);
+
+        PipelineWriter(mgr).writePipeline(xml);
+    }
+
+    for (const std::string& out : { out1, out2 })
+    {
+        PipelineManager mgr;
+        Options opts;
+        opts.add("filename", out);
+        mgr.addReader("readers.las").setOptions(opts);
+        EXPECT_EQ(mgr.execute(), 1065U);
+    }
+
+    // The written pipeline is a tee of the same two writers.
+    PipelineManager mgr;
+    PipelineReader(mgr).readPipeline(xml);
+    EXPECT_EQ(mgr.endpoints().size(), 2U);
+
+    FileUtils::deleteFile(out1);
+    FileUtils::deleteFile(out2);
+    FileUtils::deleteFile(xml);
+}
+
 //ABELL - Mosaic
 /**
 TEST(PipelineManagerTest, PipelineManagerTest_test2)
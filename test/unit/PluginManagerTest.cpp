@@ -0,0 +1,109 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <memory>
+
+#include <pdal/PipelineManager.hpp>
+#include <pdal/PluginManager.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/Utils.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+using namespace pdal;
+
+// The tests run in order: the plugin checks must come before the missing
+// driver check, which falls back to loading every filter plugin.
+
+TEST(PluginManagerTest, builtinLoadsNothing)
+{
+    PluginManager& pm = PluginManager::getInstance();
+    std::size_t loaded = pm.loadedCount();
+
+    StageFactory f;
+    std::unique_ptr<Stage> las(f.createStage("readers.las"));
+    std::unique_ptr<Stage> crop(f.createStage("filters.crop"));
+    std::unique_ptr<Stage> text(f.createStage("writers.text"));
+    EXPECT_TRUE(las.get());
+    EXPECT_TRUE(crop.get());
+    EXPECT_TRUE(text.get());
+    EXPECT_EQ(pm.loadedCount(), loaded);
+}
+
+// Creating a plugin stage should load the one library named for it and no
+// other.  Only plugins that were built are checked.
+TEST(PluginManagerTest, pluginLoadsLazily)
+{
+    PluginManager& pm = PluginManager::getInstance();
+    std::string dir = Utils::getenv("PDAL_DRIVER_PATH");
+    if (dir.empty())
+        return;
+
+    StringList paths = FileUtils::glob(dir + "/libpdal_plugin_filter_*");
+    for (auto& path : paths)
+    {
+        // .../libpdal_plugin_filter_<name>.<ext> => filters.<name>
+        std::string::size_type start = path.rfind("_") + 1;
+        std::string driver = "filters." +
+            path.substr(start, path.rfind(".") - start);
+
+        std::size_t loaded = pm.loadedCount();
+        StageFactory f;
+        std::unique_ptr<Stage> stage(f.createStage(driver));
+        EXPECT_TRUE(stage.get()) << driver;
+        EXPECT_EQ(pm.loadedCount(), loaded + 1) << driver;
+
+        // A second request is served from the registration map.
+        std::unique_ptr<Stage> again(f.createStage(driver));
+        EXPECT_TRUE(again.get()) << driver;
+        EXPECT_EQ(pm.loadedCount(), loaded + 1) << driver;
+    }
+}
+
+TEST(PluginManagerTest, missingPlugin)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> stage(f.createStage("filters.nosuchfilter"));
+    EXPECT_FALSE(stage.get());
+    stage.reset(f.createStage("readers.nosuchreader"));
+    EXPECT_FALSE(stage.get());
+    stage.reset(f.createStage("nodot"));
+    EXPECT_FALSE(stage.get());
+
+    PipelineManager mgr;
+    EXPECT_THROW(mgr.addReader("readers.nosuchreader"), pdal_error);
+    EXPECT_THROW(mgr.addFilter("filters.nosuchfilter"), pdal_error);
+    EXPECT_THROW(mgr.addWriter("writers.nosuchwriter"), pdal_error);
+}
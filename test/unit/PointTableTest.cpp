@@ -38,6 +38,8 @@
 #include <las/LasReader.hpp>
 #include "Support.hpp"
 
+#include <thread>
+
 using namespace pdal;
 
 TEST(PointTable, resolveType)
@@ -104,6 +106,43 @@ TEST(PointTable, resolveType)
     EXPECT_EQ(layout->dimType(Id::Z), Type::Double);
 }
 
+TEST(PointTable, dimNames)
+{
+    using namespace Dimension;
+
+    // Every predefined name maps back to its dimension, in any case.
+    for (int i = (int)Id::X; i <= (int)Id::HeightAboveGround; ++i)
+    {
+        Id::Enum id = (Id::Enum)i;
+        std::string name = Dimension::name(id);
+        if (name.empty())
+            continue;
+        EXPECT_EQ(Dimension::id(name), id) << name;
+        EXPECT_EQ(Dimension::id(boost::to_lower_copy(name)), id) << name;
+    }
+    EXPECT_EQ(Dimension::id("ScanAngle"), Id::ScanAngleRank);
+    EXPECT_EQ(Dimension::id("time"), Id::OffsetTime);
+    EXPECT_EQ(Dimension::id("NearInfrared"), Id::Infrared);
+    EXPECT_EQ(Dimension::id("Nothing"), Id::Unknown);
+
+    PointTable table;
+    PointLayoutPtr layout = table.layout();
+
+    EXPECT_EQ(layout->registerOrAssignDim("intensity", Type::Unsigned16),
+        Id::Intensity);
+    Id::Enum foo = layout->registerOrAssignDim("Foo", Type::Double);
+    Id::Enum bar = layout->registerOrAssignDim("Bar", Type::Float);
+    EXPECT_NE(foo, bar);
+    EXPECT_EQ(layout->registerOrAssignDim("Foo", Type::Double), foo);
+    EXPECT_EQ(layout->findDim("Intensity"), Id::Intensity);
+    EXPECT_EQ(layout->findDim("Foo"), foo);
+    EXPECT_EQ(layout->findProprietaryDim("Bar"), bar);
+    EXPECT_EQ(layout->findDim("Baz"), Id::Unknown);
+    EXPECT_EQ(layout->dimName(foo), "Foo");
+    EXPECT_EQ(layout->dimName(bar), "Bar");
+    EXPECT_EQ(layout->dimName(Id::Intensity), "Intensity");
+}
+
 TEST(PointTable, userView)
 {
     class UserTable : public PointTable
@@ -176,3 +215,358 @@ TEST(PointTable, userView)
     EXPECT_TRUE(called);
 }
 
+
+TEST(PointTable, columnTable)
+{
+    Options opts;
+    opts.add("filename", Support::datapath("las/simple.las"));
+
+    LasReader defReader;
+    defReader.setOptions(opts);
+    PointTable defTable;
+    defReader.prepare(defTable);
+    PointViewSet viewSet = defReader.execute(defTable);
+    PointViewPtr defView = *viewSet.begin();
+
+    LasReader colReader;
+    colReader.setOptions(opts);
+    ColumnPointTable colTable;
+    colReader.prepare(colTable);
+    viewSet = colReader.execute(colTable);
+    PointViewPtr colView = *viewSet.begin();
+
+    EXPECT_EQ(defView->size(), colView->size());
+    EXPECT_EQ(defView->dims(), colView->dims());
+
+    Dimension::IdList dims = colView->dims();
+    for (PointId idx = 0; idx < colView->size(); ++idx)
+        for (auto di = dims.begin(); di != dims.end(); ++di)
+            EXPECT_DOUBLE_EQ(defView->getFieldAs<double>(*di, idx),
+                colView->getFieldAs<double>(*di, idx));
+}
+
+TEST(PointTable, packed)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    PointLayoutPtr layout = table.layout();
+    layout->registerDim(Id::X);
+    layout->registerPackedDim(Id::ReturnNumber, 3);
+    layout->registerPackedDim(Id::NumberOfReturns, 3);
+    layout->registerPackedDim(Id::ScanDirectionFlag, 1);
+    layout->registerPackedDim(Id::EdgeOfFlightLine, 1);
+    layout->registerPackedDim(Id::Classification, 5);
+    EXPECT_THROW(layout->registerPackedDim(Id::UserData, 9), pdal_error);
+    layout->finalize();
+
+    // Thirteen bits take two bytes.
+    EXPECT_EQ(layout->pointSize(), 10u);
+    EXPECT_EQ(layout->dimType(Id::ReturnNumber), Type::Unsigned8);
+    EXPECT_TRUE(layout->dimDetail(Id::Classification)->packed());
+
+    PointView view(table);
+    for (PointId idx = 0; idx < 100; ++idx)
+    {
+        view.setField(Id::X, idx, idx);
+        view.setField(Id::ReturnNumber, idx, idx % 8);
+        view.setField(Id::NumberOfReturns, idx, 7 - idx % 8);
+        view.setField(Id::ScanDirectionFlag, idx, idx % 2);
+        view.setField(Id::EdgeOfFlightLine, idx, (idx / 2) % 2);
+        view.setField(Id::Classification, idx, idx % 32);
+    }
+    for (PointId idx = 0; idx < 100; ++idx)
+    {
+        EXPECT_EQ(view.getFieldAs<double>(Id::X, idx), idx);
+        EXPECT_EQ(view.getFieldAs<PointId>(Id::ReturnNumber, idx), idx % 8);
+        EXPECT_EQ(view.getFieldAs<PointId>(Id::NumberOfReturns, idx),
+            7 - idx % 8);
+        EXPECT_EQ(view.getFieldAs<PointId>(Id::ScanDirectionFlag, idx),
+            idx % 2);
+        EXPECT_EQ(view.getFieldAs<PointId>(Id::EdgeOfFlightLine, idx),
+            (idx / 2) % 2);
+        EXPECT_EQ(view.getFieldAs<PointId>(Id::Classification, idx),
+            idx % 32);
+    }
+    EXPECT_THROW(view.setField(Id::ReturnNumber, 0, 8), pdal_error);
+    EXPECT_EQ(view.getFieldAs<int>(Id::NumberOfReturns, 0), 7);
+
+    // Classification[2:2], tested on the packed bytes.
+    std::vector<char> flags(32, 0);
+    flags[2] = 1;
+    std::vector<char> match(100);
+    view.matchPacked(Id::Classification, 0, 100, flags.data(),
+        match.data());
+    for (PointId idx = 0; idx < 100; ++idx)
+        EXPECT_EQ(match[idx], idx % 32 == 2 ? 1 : 0);
+    EXPECT_THROW(view.matchPacked(Id::X, 0, 100, flags.data(),
+        match.data()), pdal_error);
+
+    // Registering a wider type unpacks the dimension.
+    PointTable wideTable;
+    wideTable.layout()->registerPackedDim(Id::UserData, 4);
+    wideTable.layout()->registerDim(Id::UserData, Type::Unsigned16);
+    EXPECT_FALSE(wideTable.layout()->dimDetail(Id::UserData)->packed());
+    EXPECT_EQ(wideTable.layout()->pointSize(), 2u);
+}
+
+TEST(PointTable, compactFlags)
+{
+    Options opts;
+    opts.add("filename", Support::datapath("las/simple.las"));
+
+    LasReader defReader;
+    defReader.setOptions(opts);
+    PointTable defTable;
+    defReader.prepare(defTable);
+    PointViewSet viewSet = defReader.execute(defTable);
+    PointViewPtr defView = *viewSet.begin();
+
+    opts.add("compact_flags", true);
+    LasReader colReader;
+    colReader.setOptions(opts);
+    ColumnPointTable colTable;
+    colReader.prepare(colTable);
+    viewSet = colReader.execute(colTable);
+    PointViewPtr colView = *viewSet.begin();
+
+    // Four flag bytes become one.
+    EXPECT_EQ(colTable.layout()->pointSize() + 3,
+        defTable.layout()->pointSize());
+    EXPECT_EQ(defView->size(), colView->size());
+    EXPECT_EQ(defView->dims(), colView->dims());
+
+    Dimension::IdList dims = colView->dims();
+    for (PointId idx = 0; idx < colView->size(); ++idx)
+        for (auto di = dims.begin(); di != dims.end(); ++di)
+            EXPECT_DOUBLE_EQ(defView->getFieldAs<double>(*di, idx),
+                colView->getFieldAs<double>(*di, idx));
+}
+
+TEST(PointTable, allocators)
+{
+    auto fill = [](PointTableRef table)
+    {
+        table.layout()->registerDim(Dimension::Id::X);
+        table.layout()->registerDim(Dimension::Id::Intensity);
+        table.layout()->finalize();
+
+        PointView view(table);
+        for (PointId i = 0; i < 100000; ++i)
+        {
+            view.setField(Dimension::Id::X, i, i * 2.5);
+            view.setField(Dimension::Id::Intensity, i, i % 1000);
+        }
+        for (PointId i = 0; i < 100000; ++i)
+        {
+            EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Dimension::Id::X, i),
+                i * 2.5);
+            EXPECT_EQ(view.getFieldAs<uint16_t>(Dimension::Id::Intensity, i),
+                i % 1000);
+        }
+    };
+
+    {
+        PointTable table(BlockAllocatorPtr(new MappedAllocator));
+        fill(table);
+    }
+    {
+        ColumnPointTable table(BlockAllocatorPtr(new MappedAllocator(false)));
+        fill(table);
+    }
+
+    std::shared_ptr<PoolAllocator> pool(new PoolAllocator);
+    {
+        PointTable table(pool);
+        fill(table);
+    }
+    // Two blocks of 10 byte points.
+    size_t pooled = pool->pooledBytes();
+    EXPECT_EQ(pooled, 2u * 65536 * 10);
+    {
+        // Reuses the pooled blocks.
+        PointTable table(pool);
+        fill(table);
+        EXPECT_EQ(pool->pooledBytes(), 0u);
+    }
+    EXPECT_EQ(pool->pooledBytes(), pooled);
+    pool->release();
+    EXPECT_EQ(pool->pooledBytes(), 0u);
+}
+
+namespace
+{
+
+class CountingAllocator : public HeapAllocator
+{
+public:
+    CountingAllocator() : m_count(0)
+        {}
+
+    virtual char *allocate(std::size_t size)
+    {
+        m_count++;
+        return HeapAllocator::allocate(size);
+    }
+
+    int m_count;
+};
+
+} // unnamed namespace
+
+TEST(PointTable, reserve)
+{
+    std::shared_ptr<CountingAllocator> alloc(new CountingAllocator);
+    PointTable table(alloc, 1000);
+    EXPECT_EQ(table.blockSize(), 1000u);
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->finalize();
+
+    PointView view(table);
+    view.reserve(2500);
+    EXPECT_EQ(table.capacity(), 3000u);
+    EXPECT_EQ(alloc->m_count, 1);
+    EXPECT_THROW(table.setBlockSize(5000), pdal_error);
+
+    for (PointId i = 0; i < 3000; ++i)
+        view.setField(Dimension::Id::X, i, i);
+    EXPECT_EQ(alloc->m_count, 1);
+    view.setField(Dimension::Id::X, 3000, 3000);
+    EXPECT_EQ(alloc->m_count, 2);
+    EXPECT_EQ(table.capacity(), 4000u);
+    for (PointId i = 0; i <= 3000; ++i)
+        EXPECT_EQ(view.getFieldAs<PointId>(Dimension::Id::X, i), i);
+
+    std::shared_ptr<CountingAllocator> colAlloc(new CountingAllocator);
+    ColumnPointTable colTable(colAlloc, 1000);
+    colTable.layout()->registerDim(Dimension::Id::X);
+    colTable.layout()->registerDim(Dimension::Id::Y);
+    colTable.layout()->finalize();
+    colTable.reserve(2500);
+    EXPECT_EQ(colTable.capacity(), 3000u);
+    // One allocation for each column.
+    EXPECT_EQ(colAlloc->m_count, 2);
+
+    PointView colView(colTable);
+    for (PointId i = 0; i < 3000; ++i)
+    {
+        colView.setField(Dimension::Id::X, i, i);
+        colView.setField(Dimension::Id::Y, i, i * 2);
+    }
+    EXPECT_EQ(colAlloc->m_count, 2);
+    for (PointId i = 0; i < 3000; ++i)
+    {
+        EXPECT_EQ(colView.getFieldAs<PointId>(Dimension::Id::X, i), i);
+        EXPECT_EQ(colView.getFieldAs<PointId>(Dimension::Id::Y, i), i * 2);
+    }
+}
+
+TEST(PointTable, spill)
+{
+    std::shared_ptr<CountingAllocator> alloc(new CountingAllocator);
+    PointTable table(alloc, 1000);
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->finalize();
+    // Room for three blocks of 16000 bytes.
+    table.setMemoryBudget(50000);
+    EXPECT_EQ(table.memoryBudget(), 50000u);
+
+    PointView view(table);
+    view.reserve(10000);
+    EXPECT_EQ(table.capacity(), 3000u);
+    for (PointId i = 0; i < 10000; ++i)
+    {
+        view.setField(Dimension::Id::X, i, i);
+        view.setField(Dimension::Id::Y, i, i * 2.5);
+    }
+    EXPECT_EQ(alloc->m_count, 1);
+    EXPECT_EQ(table.spilledBytes(), 7u * 16000);
+    EXPECT_EQ(table.loadedBytes(), 0u);
+    EXPECT_THROW(table.setMemoryBudget(0), pdal_error);
+
+    // Read back in reverse to force each block to be reloaded.
+    for (PointId i = 10000; i-- > 0;)
+    {
+        EXPECT_EQ(view.getFieldAs<PointId>(Dimension::Id::X, i), i);
+        EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Dimension::Id::Y, i),
+            i * 2.5);
+    }
+    EXPECT_EQ(table.loadedBytes(), 7u * 16000);
+    EXPECT_EQ(alloc->m_count, 1);
+}
+
+TEST(PointTable, reserveRange)
+{
+    std::shared_ptr<CountingAllocator> alloc(new CountingAllocator);
+    PointTable table(alloc, 1000);
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->finalize();
+
+    // A range is a single allocation, however many blocks it spans.
+    PointView view(table);
+    EXPECT_EQ(view.appendRange(2500), 0u);
+    EXPECT_EQ(view.size(), 2500u);
+    EXPECT_EQ(alloc->m_count, 1);
+    EXPECT_EQ(view.appendRange(300), 2500u);
+    EXPECT_EQ(alloc->m_count, 1);
+    EXPECT_EQ(view.tableId(2799), 2799u);
+
+    // Readers on several threads fill ranges of their own views.
+    const int numThreads = 4;
+    const point_count_t rangeSize = 1500;
+    const int rangesEach = 20;
+    std::vector<PointViewPtr> views;
+    for (int t = 0; t < numThreads; ++t)
+        views.push_back(view.makeNew());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t)
+        threads.push_back(std::thread([&views, t, rangeSize, rangesEach]()
+        {
+            PointView& v(*views[t]);
+            for (int r = 0; r < rangesEach; ++r)
+            {
+                PointId first = v.appendRange(rangeSize);
+                for (PointId i = first; i < first + rangeSize; ++i)
+                {
+                    v.setField(Dimension::Id::X, i, t);
+                    v.setField(Dimension::Id::Y, i, i);
+                }
+            }
+        }));
+    for (auto& t : threads)
+        t.join();
+
+    std::vector<bool> seen(2800 + numThreads * rangesEach * rangeSize);
+    for (int t = 0; t < numThreads; ++t)
+    {
+        PointView& v(*views[t]);
+        ASSERT_EQ(v.size(), rangesEach * rangeSize);
+        for (PointId i = 0; i < v.size(); ++i)
+        {
+            EXPECT_EQ(v.getFieldAs<int>(Dimension::Id::X, i), t);
+            EXPECT_EQ(v.getFieldAs<PointId>(Dimension::Id::Y, i), i);
+            // Each range is contiguous in the table.
+            if (i % rangeSize)
+            {
+                EXPECT_EQ(v.tableId(i), v.tableId(i - 1) + 1);
+            }
+            ASSERT_LT(v.tableId(i), seen.size());
+            EXPECT_FALSE(seen[v.tableId(i)]);
+            seen[v.tableId(i)] = true;
+        }
+    }
+    EXPECT_EQ(table.capacity(), 123000u);
+
+    // Tables that add points one at a time give ranges too.
+    ColumnPointTable colTable;
+    colTable.layout()->registerDim(Dimension::Id::X);
+    colTable.layout()->finalize();
+    PointView colView(colTable);
+    colView.setField(Dimension::Id::X, 0, 1);
+    EXPECT_EQ(colView.appendRange(10), 1u);
+    EXPECT_EQ(colView.size(), 11u);
+    EXPECT_EQ(colView.tableId(10), 10u);
+}
@@ -38,6 +38,7 @@
 
 #include <boost/property_tree/xml_parser.hpp>
 
+#include <pdal/KDIndex.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/PointViewIter.hpp>
 #include <pdal/PDALUtils.hpp>
@@ -162,6 +163,110 @@ TEST(PointViewTest, getFloat)
 }
 
 
+TEST(PointViewTest, getSetArray)
+{
+    PointTable table;
+    PointViewPtr view = makeTestView(table);
+
+    std::vector<double> d(17);
+    view->getFieldArray(Dimension::Id::X, 0, 17, d.data());
+    for (int i = 0; i < 17; i++)
+        EXPECT_DOUBLE_EQ(d[i], i * 10.0);
+
+    std::vector<uint8_t> u(5);
+    view->getFieldArray(Dimension::Id::Classification, 3, 5, u.data());
+    for (int i = 0; i < 5; i++)
+        EXPECT_EQ(u[i], i + 4u);
+
+    // Y values past 2 don't fit in a uint8_t.
+    EXPECT_THROW(view->getFieldArray(Dimension::Id::Y, 0, 5, u.data()),
+        pdal_error);
+
+    for (int i = 0; i < 17; i++)
+        d[i] = i * 2.0;
+    view->setFieldArray(Dimension::Id::X, 0, 17, d.data());
+    for (int i = 0; i < 17; i++)
+        EXPECT_EQ(view->getFieldAs<int32_t>(Dimension::Id::X, i), i * 2);
+
+    // Setting past the end of the view appends points.
+    d.resize(20, 1.0);
+    view->setFieldArray(Dimension::Id::Y, 15, 5, d.data() + 15);
+    EXPECT_EQ(view->size(), 20u);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::Y, 16), 32.0);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::Y, 19), 1.0);
+
+    EXPECT_THROW(view->setFieldArray(Dimension::Id::Y, 25, 1, d.data()),
+        pdal_error);
+}
+
+
+TEST(PointViewTest, idList)
+{
+    PointIdList ids;
+
+    for (PointId i = 10; i < 20; ++i)
+        ids.push_back(i);
+    EXPECT_TRUE(ids.identity());
+    EXPECT_EQ(ids.size(), 10u);
+    EXPECT_EQ(ids[0], 10u);
+    EXPECT_EQ(ids[9], 19u);
+
+    PointIdList more;
+    for (PointId i = 20; i < 25; ++i)
+        more.push_back(i);
+    ids.insert(ids.size(), more, more.size());
+    EXPECT_TRUE(ids.identity());
+    EXPECT_EQ(ids.size(), 15u);
+    EXPECT_EQ(ids[14], 24u);
+
+    ids.set(3, 100);
+    EXPECT_FALSE(ids.identity());
+    EXPECT_EQ(ids[2], 12u);
+    EXPECT_EQ(ids[3], 100u);
+    EXPECT_EQ(ids[4], 14u);
+
+    ids.insert(0, more, 2);
+    EXPECT_EQ(ids.size(), 17u);
+    EXPECT_EQ(ids[0], 20u);
+    EXPECT_EQ(ids[1], 21u);
+    EXPECT_EQ(ids[2], 10u);
+    EXPECT_EQ(ids.data()[5], 100u);
+}
+
+
+TEST(PointViewTest, subset)
+{
+    PointTable table;
+    PointViewPtr view = makeTestView(table);
+
+    PointViewPtr sub = view->makeSubset(5, 10);
+    EXPECT_EQ(sub->size(), 5u);
+    for (PointId i = 0; i < sub->size(); ++i)
+        EXPECT_EQ(sub->getFieldAs<int32_t>(Dimension::Id::X, i),
+            (int32_t)((i + 5) * 10));
+
+    // Reordering the parent must not disturb the subset.
+    std::reverse(view->begin(), view->end());
+    EXPECT_EQ(view->getFieldAs<int32_t>(Dimension::Id::X, 0), 160);
+    for (PointId i = 0; i < sub->size(); ++i)
+        EXPECT_EQ(sub->getFieldAs<int32_t>(Dimension::Id::X, i),
+            (int32_t)((i + 5) * 10));
+
+    // Nor reordering the subset the parent.
+    PointViewPtr sub2 = view->makeSubset(0, 3);
+    std::reverse(sub2->begin(), sub2->end());
+    EXPECT_EQ(sub2->getFieldAs<int32_t>(Dimension::Id::X, 0), 140);
+    EXPECT_EQ(view->getFieldAs<int32_t>(Dimension::Id::X, 0), 160);
+
+    // Appending to a subset leaves its parent alone.
+    sub2->appendPoint(*view, 10);
+    EXPECT_EQ(sub2->size(), 4u);
+    EXPECT_EQ(sub2->getFieldAs<int32_t>(Dimension::Id::X, 3), 60);
+    EXPECT_EQ(view->size(), 17u);
+    EXPECT_EQ(view->getFieldAs<int32_t>(Dimension::Id::X, 3), 130);
+}
+
+
 TEST(PointViewTest, copy)
 {
     PointTable table;
@@ -214,6 +319,105 @@ TEST(PointViewTest, assignment)
 }
 
 
+TEST(PointViewTest, scaled)
+{
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+
+    layout->registerScaledDim(Dimension::Id::X, Dimension::Type::Signed32,
+        XForm(.01, 1000));
+    layout->registerScaledDim(Dimension::Id::Y, Dimension::Type::Signed32,
+        XForm(.01, 1000));
+    // Conflicting scaling falls back to doubles.
+    layout->registerScaledDim(Dimension::Id::Y, Dimension::Type::Signed32,
+        XForm(.001, 1000));
+    layout->registerScaledDim(Dimension::Id::Z, Dimension::Type::Signed32,
+        XForm(.01, 0));
+    // So does unscaled registration.
+    layout->registerDim(Dimension::Id::Z);
+    layout->finalize();
+
+    EXPECT_TRUE(layout->dimDetail(Dimension::Id::X)->scaled());
+    EXPECT_FALSE(layout->dimDetail(Dimension::Id::Y)->scaled());
+    EXPECT_FALSE(layout->dimDetail(Dimension::Id::Z)->scaled());
+    EXPECT_EQ(layout->dimDetail(Dimension::Id::X)->size(), 4u);
+    EXPECT_EQ(layout->dimType(Dimension::Id::X), Dimension::Type::Double);
+    EXPECT_EQ(layout->dimType(Dimension::Id::Y), Dimension::Type::Double);
+    EXPECT_EQ(layout->pointSize(), 20u);
+
+    PointView view(table);
+    for (PointId i = 0; i < 100; ++i)
+        view.setField(Dimension::Id::X, i, 1000 + i * 1.25);
+    for (PointId i = 0; i < 100; ++i)
+    {
+        EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Dimension::Id::X, i),
+            1000 + i * 1.25);
+        int32_t raw;
+        view.getRawField(Dimension::Id::X, i, &raw);
+        EXPECT_EQ(raw, (int32_t)(i * 125));
+    }
+
+    std::vector<double> d(100);
+    view.getFieldArray(Dimension::Id::X, 0, 100, d.data());
+    for (PointId i = 0; i < 100; ++i)
+        EXPECT_DOUBLE_EQ(d[i], 1000 + i * 1.25);
+    for (PointId i = 0; i < 100; ++i)
+        d[i] = 900 + i * .5;
+    view.setFieldArray(Dimension::Id::X, 0, 100, d.data());
+    for (PointId i = 0; i < 100; ++i)
+        EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Dimension::Id::X, i),
+            900 + i * .5);
+}
+
+
+TEST(PointViewTest, handles)
+{
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+    layout->registerDim(Dimension::Id::Classification);
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Z, Dimension::Type::Signed32);
+    layout->finalize();
+
+    PointView view(table);
+    DimHandle<uint8_t> cls = view.handle<uint8_t>(Dimension::Id::Classification);
+    DimHandle<double> x = view.handle<double>(Dimension::Id::X);
+    DimHandle<double> z = view.handle<double>(Dimension::Id::Z);
+    DimHandle<double> t = view.handle<double>(Dimension::Id::GpsTime);
+
+    EXPECT_TRUE(cls.valid());
+    EXPECT_TRUE(cls.native());
+    EXPECT_TRUE(x.native());
+    EXPECT_FALSE(t.valid());
+    EXPECT_EQ(z.id(), Dimension::Id::Z);
+    // Z is stored as a signed integer, so access through a double handle
+    // is converted.
+    EXPECT_FALSE(z.native());
+
+    for (PointId i = 0; i < 20; ++i)
+    {
+        view.setField(cls, i, (uint8_t)(i + 1));
+        view.setField(x, i, i * 1.5);
+        view.setField(z, i, (double)i * -2);
+    }
+    ASSERT_EQ(view.size(), 20u);
+    for (PointId i = 0; i < view.size(); ++i)
+    {
+        EXPECT_EQ(view.getField(cls, i),
+            view.getFieldAs<uint8_t>(Dimension::Id::Classification, i));
+        EXPECT_EQ(view.getField(cls, i), i + 1);
+        EXPECT_DOUBLE_EQ(view.getField(x, i), i * 1.5);
+        EXPECT_EQ(view.getFieldAs<int32_t>(Dimension::Id::Z, i),
+            (int32_t)i * -2);
+        EXPECT_DOUBLE_EQ(view.getField(z, i), (double)i * -2);
+    }
+
+    EXPECT_TRUE(view.compare(x, 1, 2));
+    EXPECT_FALSE(view.compare(x, 2, 1));
+    EXPECT_TRUE(view.compare(z, 2, 1));
+}
+
+
 TEST(PointViewTest, metaview)
 {
     PointTable table;
@@ -416,6 +620,52 @@ TEST(PointViewTest, calcBounds)
     check_bounds(box_bs, 0.0, 3.0, 0.0, 3.0, 0.0, 3.0);
 }
 
+// Cached bounds follow changes made through the view, through other views
+// of the same points and by adding points.
+TEST(PointViewTest, cachedBounds)
+{
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+    layout->finalize();
+
+    // Enough points that the bounds are found on several threads.
+    const point_count_t count = 300000;
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < count; ++i)
+    {
+        view->setField(Dimension::Id::X, i, (double)i);
+        view->setField(Dimension::Id::Y, i, -(double)i);
+        view->setField(Dimension::Id::Z, i, (double)(i % 100));
+    }
+
+    BOX3D b = view->calculateBounds();
+    EXPECT_EQ(b, BOX3D(0, -(double)(count - 1), 0, count - 1, 0, 99));
+    b = view->calculateBounds(false);
+    EXPECT_DOUBLE_EQ(b.maxx, count - 1);
+    EXPECT_DOUBLE_EQ(b.miny, -(double)(count - 1));
+
+    view->setField(Dimension::Id::X, 5, -10.0);
+    EXPECT_DOUBLE_EQ(view->calculateBounds().minx, -10.0);
+
+    PointViewPtr subset = view->makeSubset(100, 200);
+    subset->setField(Dimension::Id::Z, 3, 1000.0);
+    EXPECT_DOUBLE_EQ(view->calculateBounds().maxz, 1000.0);
+    EXPECT_DOUBLE_EQ(subset->calculateBounds().minz, 0.0);
+
+    std::vector<double> zs(10, -50.0);
+    view->setFieldArray(Dimension::Id::Z, count - 10, 10, zs.data());
+    EXPECT_DOUBLE_EQ(view->calculateBounds().minz, -50.0);
+
+    view->setField(Dimension::Id::Y, count, 1.0);
+    b = view->calculateBounds();
+    EXPECT_DOUBLE_EQ(b.maxy, 1.0);
+    EXPECT_DOUBLE_EQ(b.maxx, count - 1);
+}
+
 TEST(PointViewTest, order)
 {
     PointTable table;
@@ -442,3 +692,152 @@ TEST(PointViewTest, order)
         pi = si;
     }
 }
+
+TEST(PointViewTest, applyPermutation)
+{
+    PointTable table;
+    PointViewPtr view = makeTestView(table);
+    const point_count_t count = view->size();
+
+    // Reverse the points by plain order.
+    std::vector<PointId> order;
+    for (PointId i = 0; i < count; ++i)
+        order.push_back(count - 1 - i);
+    view->applyPermutation(order);
+    for (PointId i = 0; i < count; ++i)
+        EXPECT_EQ(view->getFieldAs<int32_t>(Dimension::Id::X, i),
+            (int32_t)(count - 1 - i) * 10);
+
+    // And back by sorted (key, id) pairs.
+    std::vector<std::pair<uint64_t, PointId>> pairs;
+    for (PointId i = 0; i < count; ++i)
+        pairs.push_back(std::make_pair(i, count - 1 - i));
+    view->applyPermutation(pairs);
+    verifyTestView(*view, count);
+
+    // A subset is permuted without disturbing the view it came from.
+    PointViewPtr subset = view->makeSubset(2, 5);
+    subset->applyPermutation(std::vector<PointId>{ 2, 0, 1 });
+    EXPECT_EQ(subset->getFieldAs<int32_t>(Dimension::Id::X, 0), 40);
+    EXPECT_EQ(subset->getFieldAs<int32_t>(Dimension::Id::X, 1), 20);
+    EXPECT_EQ(subset->getFieldAs<int32_t>(Dimension::Id::X, 2), 30);
+    verifyTestView(*view, count);
+}
+
+TEST(PointViewTest, computedDim)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    PointLayoutPtr layout = table.layout();
+    layout->registerDim(Id::X);
+    layout->registerDim(Id::Z);
+    int calls = 0;
+    layout->registerComputedDim(Id::HeightAboveGround, { Id::Z },
+        [&calls](PointView& v, double *out)
+        {
+            calls++;
+            for (PointId i = 0; i < v.size(); ++i)
+                out[i] = v.getFieldAs<double>(Id::Z, i) - 100;
+        });
+    Id::Enum slope = layout->assignComputedDim("Slope", { Id::X },
+        [](PointView& v, double *out)
+        {
+            for (PointId i = 0; i < v.size(); ++i)
+                out[i] = v.getFieldAs<double>(Id::X, i) * 2;
+        });
+
+    // Computed dimensions take no space.
+    EXPECT_EQ(layout->pointSize(), 16u);
+    EXPECT_TRUE(layout->hasDim(Id::HeightAboveGround));
+    EXPECT_EQ(layout->dimType(Id::HeightAboveGround), Type::Double);
+
+    PointView view(table);
+    for (PointId i = 0; i < 10000; ++i)
+    {
+        view.setField(Id::X, i, (double)i);
+        view.setField(Id::Z, i, (double)i + 100);
+    }
+    EXPECT_EQ(calls, 0);
+
+    // Values are computed a block at a time and kept.
+    EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::HeightAboveGround, 5), 5);
+    EXPECT_EQ(calls, 1);
+    std::vector<double> values(100);
+    view.getFieldArray(Id::HeightAboveGround, 0, 100, values.data());
+    EXPECT_EQ(calls, 1);
+    for (PointId i = 0; i < 100; ++i)
+        EXPECT_DOUBLE_EQ(values[i], (double)i);
+    EXPECT_EQ(view.getFieldAs<int>(Id::HeightAboveGround, 9000), 9000);
+    EXPECT_EQ(calls, 2);
+    EXPECT_DOUBLE_EQ(view.getFieldAs<double>(slope, 7), 14);
+
+    // Setting a dependency changes the value.
+    view.setField(Id::Z, 5, 150.0);
+    EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::HeightAboveGround, 5), 50);
+    EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Id::HeightAboveGround, 6), 6);
+    view.setField(Id::X, 7, 1.0);
+    EXPECT_DOUBLE_EQ(view.getFieldAs<double>(slope, 7), 2);
+
+    // Subsets share the table's values.
+    PointViewPtr subset = view.makeSubset(5, 7);
+    EXPECT_DOUBLE_EQ(subset->getFieldAs<double>(Id::HeightAboveGround, 0),
+        50);
+
+    EXPECT_THROW(view.setField(Id::HeightAboveGround, 0, 1.0), pdal_error);
+    EXPECT_EQ(view.size(), 10000u);
+
+    // Registering the dimension normally makes it stored.
+    PointTable stored;
+    stored.layout()->registerDim(Id::Z);
+    stored.layout()->registerComputedDim(Id::HeightAboveGround, { Id::Z },
+        [](PointView&, double *) {});
+    stored.layout()->registerDim(Id::HeightAboveGround);
+    EXPECT_FALSE(stored.layout()->dimDetail(
+        Id::HeightAboveGround)->computed());
+    EXPECT_EQ(stored.layout()->pointSize(), 16u);
+    EXPECT_TRUE(stored.layout()->dependents(Id::Z).empty());
+}
+
+TEST(PointViewTest, spatialIndex)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    table.layout()->registerDim(Id::Classification);
+
+    PointView view(table);
+    for (PointId i = 0; i < 100; ++i)
+    {
+        view.setField(Id::X, i, (double)i);
+        view.setField(Id::Y, i, (double)i);
+        view.setField(Id::Z, i, 0.0);
+    }
+
+    // The index is kept while the coordinates don't change.
+    const KDIndex *index = &view.spatialIndex();
+    EXPECT_EQ(&view.spatialIndex(), index);
+    EXPECT_EQ(view.spatialIndex().neighbors(10.2, 10.2, 0)[0], 10u);
+    view.setField(Id::Classification, 0, 2);
+    EXPECT_EQ(&view.spatialIndex(), index);
+
+    // Moving a point rebuilds it.
+    view.setField(Id::X, 50, 10.3);
+    view.setField(Id::Y, 50, 10.3);
+    EXPECT_EQ(view.spatialIndex().neighbors(10.2, 10.2, 0)[0], 50u);
+
+    // As does adding one, or asking for a 2D index.
+    view.setField(Id::X, 100, 10.2);
+    view.setField(Id::Y, 100, 10.2);
+    view.setField(Id::Z, 100, 5.0);
+    EXPECT_EQ(view.spatialIndex().neighbors(10.2, 10.2, 0)[0], 50u);
+    EXPECT_EQ(view.spatialIndex(false).neighbors(10.2, 10.2, 0)[0], 100u);
+
+    // A copy of the view gets its own index.
+    PointView copy(view);
+    EXPECT_EQ(copy.spatialIndex().neighbors(10.2, 10.2, 5)[0], 100u);
+    EXPECT_NE(&copy.spatialIndex(), &view.spatialIndex());
+}
@@ -0,0 +1,93 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <sstream>
+
+#include <pdal/PreparedPipeline.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <LasReader.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+point_count_t lasPointCount(const std::string& filename)
+{
+    Options opts;
+    opts.add("filename", filename);
+    LasReader reader;
+    reader.setOptions(opts);
+    return reader.preview().m_pointCount;
+}
+
+} // unnamed namespace
+
+// One pipeline run against several files in turn writes each file's points
+// and only those.
+TEST(PreparedPipelineTest, reuse)
+{
+    std::istringstream xml(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+        "<Pipeline version=\"1.0\">"
+        "  <Writer type=\"writers.las\">"
+        "    <Option name=\"filename\">placeholder.las</Option>"
+        "    <Reader type=\"readers.las\">"
+        "      <Option name=\"filename\">placeholder.las</Option>"
+        "    </Reader>"
+        "  </Writer>"
+        "</Pipeline>");
+    PreparedPipeline pipeline(xml);
+    EXPECT_TRUE(pipeline.isWriterPipeline());
+
+    std::vector<std::string> inputs;
+    inputs.push_back(Support::datapath("las/1.2-with-color.las"));
+    inputs.push_back(Support::datapath("las/simple.las"));
+    inputs.push_back(Support::datapath("las/1.2-with-color.las"));
+
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+    {
+        std::string outfile(Support::temppath("prepared.las"));
+        FileUtils::deleteFile(outfile);
+
+        point_count_t count = lasPointCount(inputs[i]);
+        EXPECT_EQ(pipeline.execute(inputs[i], outfile), count);
+        EXPECT_EQ(lasPointCount(outfile), count);
+        FileUtils::deleteFile(outfile);
+    }
+}
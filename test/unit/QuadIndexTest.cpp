@@ -0,0 +1,131 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <random>
+
+#include <pdal/PointView.hpp>
+#include <pdal/QuadIndex.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+TEST(QuadIndexTest, cache)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> dist(0, 100);
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < 2000; ++i)
+    {
+        view->setField(Id::X, i, dist(gen));
+        view->setField(Id::Y, i, dist(gen));
+    }
+
+    std::string filename(Support::temppath("quadindex.idx"));
+    FileUtils::deleteFile(filename);
+
+    QuadIndex built(*view);
+    QuadIndex saved(*view, filename);
+    EXPECT_TRUE(FileUtils::fileExists(filename));
+    QuadIndex loaded(*view, filename);
+
+    EXPECT_EQ(loaded.getDepth(), built.getDepth());
+    EXPECT_EQ(loaded.getFills(), built.getFills());
+    EXPECT_EQ(loaded.getPoints(), built.getPoints());
+    EXPECT_EQ(loaded.getPoints(10, 20, 40, 60),
+        built.getPoints(10, 20, 40, 60));
+    EXPECT_EQ(loaded.getPoints(0, 5), built.getPoints(0, 5));
+
+    // A file that doesn't match the points is replaced.
+    view->setField(Id::X, 0, 50.0);
+    QuadIndex changed(*view, filename);
+    QuadIndex rebuilt(*view);
+    EXPECT_EQ(changed.getPoints(), rebuilt.getPoints());
+    QuadIndex reloaded(*view, filename);
+    EXPECT_EQ(reloaded.getPoints(), rebuilt.getPoints());
+
+    FileUtils::deleteFile(filename);
+}
+
+TEST(QuadIndexTest, structure)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+
+    PointViewPtr view(new PointView(table));
+    const double coords[][2] = { { 0, 0 }, { 10, 10 }, { 5, 5 }, { 1, 9 } };
+    for (PointId i = 0; i < 4; ++i)
+    {
+        view->setField(Id::X, i, coords[i][0]);
+        view->setField(Id::Y, i, coords[i][1]);
+    }
+
+    // The point nearest the center is at the top and the others are in
+    // the quadrants, which are visited in the order NW, NE, SE, SW.
+    QuadIndex idx(*view);
+    EXPECT_EQ(idx.getDepth(), 1u);
+    EXPECT_EQ(idx.getFills(), std::vector<std::size_t>({ 1, 3 }));
+    EXPECT_EQ(idx.getPoints(), std::vector<PointId>({ 2, 3, 1, 0 }));
+    EXPECT_EQ(idx.getPoints(1), std::vector<PointId>({ 2 }));
+    EXPECT_EQ(idx.getPoints(1, 0), std::vector<PointId>({ 3, 1, 0 }));
+    EXPECT_EQ(idx.getPoints(0.0, 0.0, 5.0, 9.5),
+        std::vector<PointId>({ 3, 0 }));
+
+    std::size_t cursor(0);
+    EXPECT_EQ(idx.getNextLevels(cursor), std::vector<PointId>({ 2 }));
+    EXPECT_EQ(cursor, 1u);
+    EXPECT_EQ(idx.getNextLevels(cursor), std::vector<PointId>({ 3, 1, 0 }));
+    EXPECT_EQ(cursor, 2u);
+    EXPECT_TRUE(idx.getNextLevels(cursor).empty());
+
+    cursor = 0;
+    EXPECT_EQ(idx.getNextLevels(cursor, 2),
+        std::vector<PointId>({ 2, 3, 1, 0 }));
+
+    BOX3D box(0, 0, 0, 5, 9.5, 0);
+    cursor = 0;
+    EXPECT_TRUE(idx.getNextLevels(box, cursor).empty());
+    EXPECT_EQ(idx.getNextLevels(box, cursor), std::vector<PointId>({ 3, 0 }));
+}
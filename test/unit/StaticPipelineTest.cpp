@@ -0,0 +1,198 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StaticPipeline.hpp>
+#include <pdal/Writer.hpp>
+#include <FauxReader.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+Options readerOptions()
+{
+    Options ops;
+    ops.add("bounds", BOX3D(0.0, 0.0, 0.0, 100.0, 100.0, 100.0));
+    ops.add("mode", "random");
+    ops.add("num_points", 5000);
+    ops.add("seed", 23);
+    return ops;
+}
+
+std::array<double, 16> translation(double x, double y, double z)
+{
+    std::array<double, 16> m = {{ 1, 0, 0, x, 0, 1, 0, y, 0, 0, 1, z,
+        0, 0, 0, 1 }};
+    return m;
+}
+
+// A kernel defined outside PDAL.
+struct Scale
+{
+    static const bool movesPoints = true;
+    static const bool dropsPoints = false;
+
+    double m_factor;
+
+    void operator()(pointwise::PointBlock& block) const
+    {
+        for (point_count_t i = 0; i < block.m_size; ++i)
+            block.m_z[i] *= m_factor;
+    }
+};
+
+// Records the positions of the points it's given.
+class PositionRecorder : public Writer
+{
+public:
+    std::string getName() const
+        { return "writers.positionrecorder"; }
+    virtual bool streamable() const
+        { return true; }
+
+    std::vector<std::array<double, 3>> m_points;
+
+private:
+    virtual void write(const PointViewPtr view)
+    {
+        for (PointId i = 0; i < view->size(); ++i)
+        {
+            std::array<double, 3> p = {{
+                view->getFieldAs<double>(Dimension::Id::X, i),
+                view->getFieldAs<double>(Dimension::Id::Y, i),
+                view->getFieldAs<double>(Dimension::Id::Z, i) }};
+            m_points.push_back(p);
+        }
+    }
+};
+
+} // unnamed namespace
+
+// The chain keeps and moves the same points as the filters it stands in
+// for would, whether the points are streamed or not.
+TEST(StaticPipelineTest, chain)
+{
+    FauxReader allReader;
+    allReader.setOptions(readerOptions());
+    PointTable allTable;
+    allReader.prepare(allTable);
+    PointViewPtr all = *allReader.execute(allTable).begin();
+
+    std::vector<std::array<double, 3>> expected;
+    for (PointId i = 0; i < all->size(); ++i)
+    {
+        double x = all->getFieldAs<double>(Dimension::Id::X, i);
+        double y = all->getFieldAs<double>(Dimension::Id::Y, i);
+        double z = all->getFieldAs<double>(Dimension::Id::Z, i);
+        if (z >= 25 && z <= 75 && x <= 50)
+        {
+            std::array<double, 3> p = {{ x + 10, y - 5, (z + 1) * 2 }};
+            expected.push_back(p);
+        }
+    }
+    EXPECT_GT(expected.size(), 0u);
+    EXPECT_LT(expected.size(), all->size());
+
+    for (int streamed = 0; streamed < 2; ++streamed)
+    {
+        FauxReader reader;
+        reader.setOptions(readerOptions());
+        typedef StaticPipeline<pointwise::Range<Dimension::Id::Z>,
+            pointwise::Crop, pointwise::Transform, Scale> Chain;
+        EXPECT_TRUE(Chain::Traits::movesPoints);
+        EXPECT_TRUE(Chain::Traits::dropsPoints);
+        Scale scale = { 2 };
+        Chain chain(pointwise::Range<Dimension::Id::Z>(25, 75),
+            pointwise::Crop(BOX3D(0, 0, 0, 50, 100, 100)),
+            pointwise::Transform(translation(10, -5, 1)), scale);
+        chain.setInput(reader);
+        PositionRecorder writer;
+        writer.setInput(chain);
+
+        if (streamed)
+        {
+            FixedPointTable table(1000);
+            writer.prepare(table);
+            EXPECT_TRUE(writer.pipelineStreamable());
+            writer.executeStream(table);
+        }
+        else
+        {
+            PointTable table;
+            writer.prepare(table);
+            writer.execute(table);
+        }
+
+        ASSERT_EQ(writer.m_points.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+            for (size_t d = 0; d < 3; ++d)
+                EXPECT_DOUBLE_EQ(writer.m_points[i][d], expected[i][d]);
+    }
+}
+
+// A chain that only moves points hands on the view it was given.
+TEST(StaticPipelineTest, block)
+{
+    typedef StaticPipeline<pointwise::Transform> Chain;
+    EXPECT_TRUE(Chain::Traits::movesPoints);
+    EXPECT_FALSE(Chain::Traits::dropsPoints);
+    Chain chain((pointwise::Transform(translation(1, 2, 3))));
+
+    std::unique_ptr<pointwise::PointBlock> block(new pointwise::PointBlock);
+    block->m_size = 2;
+    for (int i = 0; i < 2; ++i)
+    {
+        block->m_x[i] = i;
+        block->m_y[i] = i;
+        block->m_z[i] = i;
+        block->m_keep[i] = 1;
+    }
+    chain(*block);
+    EXPECT_EQ(block->m_x[1], 2);
+    EXPECT_EQ(block->m_y[1], 3);
+    EXPECT_EQ(block->m_z[1], 4);
+    EXPECT_EQ(block->m_keep[1], 1);
+
+    FauxReader reader;
+    reader.setOptions(readerOptions());
+    chain.setInput(reader);
+    PointTable table;
+    chain.prepare(table);
+    PointViewSet viewSet = chain.execute(table);
+    EXPECT_EQ((*viewSet.begin())->size(), 5000u);
+}
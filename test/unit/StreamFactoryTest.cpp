@@ -34,8 +34,10 @@
 
 #include <pdal/pdal_test_main.hpp>
 
-#include <sstream>
 #include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
 
 #include <pdal/StreamFactory.hpp>
 #include <pdal/util/FileUtils.hpp>
@@ -157,4 +159,108 @@ TEST(StreamFactoryTest, test2)
         f.deallocate(s3);
         // f.deallocate(s2);   // let the dtor do it for us
     }
+
+    {
+        const std::string nam = Support::datapath("text/text.txt");
+        MappedSubsetStreamFactory f(nam, 0, FileUtils::fileSize(nam));
+
+        std::istream& s1 = f.allocate();
+        std::istream& s2 = f.allocate();
+
+        check_contents(s1);
+        check_contents(s2);
+
+        f.deallocate(s1);
+        ASSERT_THROW(f.deallocate(s1), pdal_error);
+    }
+
+    {
+        MappedSubsetStreamFactory f(Support::datapath("text/text.txt"), 20, 6);
+
+        std::istream& s1 = f.allocate();
+        std::istream& s2 = f.allocate();
+
+        check_contents_sub(s1);
+        check_contents_sub(s2);
+
+        // Positions are relative to the start of the region.
+        s1.clear();
+        s1.seekg(0);
+        EXPECT_EQ(s1.tellg(), 0);
+        std::string buf;
+        s1 >> buf;
+        EXPECT_EQ(buf, "allows");
+
+        f.deallocate(s2);
+    }
+
+    {
+        const std::string nam = Support::datapath("text/text.txt");
+        uint64_t size = FileUtils::fileSize(nam);
+        EXPECT_THROW(MappedSubsetStreamFactory(nam, size - 5, 6), pdal_error);
+    }
+
+    {
+        // Blocks smaller than the words read.
+        RemoteStreamFactory f(Support::datapath("text/text.txt"), 3, 2, 1);
+
+        std::istream& s1 = f.allocate();
+        std::istream& s2 = f.allocate();
+
+        check_contents(s1);
+        check_contents(s2);
+
+        f.deallocate(s1);
+        ASSERT_THROW(f.deallocate(s1), pdal_error);
+    }
+}
+
+
+// Local paths go through GDAL's file system as they stand, which lets the
+// block cache and read-ahead be checked without a server.
+TEST(StreamFactoryTest, remote)
+{
+    EXPECT_TRUE(RemoteStreamFactory::remote("https://host/dir/file.laz"));
+    EXPECT_TRUE(RemoteStreamFactory::remote("s3://bucket/file.laz"));
+    EXPECT_FALSE(RemoteStreamFactory::remote(Support::datapath("las/1.2-with-color.las")));
+    EXPECT_THROW(RemoteStreamFactory(Support::datapath("las/nosuch.las")),
+        pdal_error);
+
+    const std::string nam = Support::datapath("las/1.2-with-color.las");
+    std::istream *in = FileUtils::openFile(nam);
+    std::string contents((std::istreambuf_iterator<char>(*in)),
+        std::istreambuf_iterator<char>());
+    FileUtils::closeFile(in);
+
+    RemoteStreamFactory f(nam, 1000, 3, 2);
+    EXPECT_EQ(f.size(), contents.size());
+
+    // Sequential reads, with read-ahead, in pieces that straddle blocks.
+    std::istream& s1 = f.allocate();
+    std::string data;
+    std::vector<char> buf(777);
+    while (s1.read(buf.data(), buf.size()) || s1.gcount())
+        data.append(buf.data(), (size_t)s1.gcount());
+    EXPECT_TRUE(data == contents);
+
+    // Seeks in and out of the cached blocks from two streams.
+    std::istream& s2 = f.allocate();
+    s1.clear();
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> dist(0, contents.size() - 100);
+    for (size_t i = 0; i < 200; ++i)
+    {
+        std::istream& s = (i % 2) ? s1 : s2;
+        size_t pos = dist(gen);
+        s.seekg(pos);
+        EXPECT_EQ((size_t)s.tellg(), pos);
+        s.read(buf.data(), 100);
+        ASSERT_EQ(s.gcount(), 100);
+        EXPECT_EQ(std::string(buf.data(), 100), contents.substr(pos, 100));
+    }
+
+    s2.seekg(-10, std::ios_base::end);
+    s2.read(buf.data(), 20);
+    EXPECT_EQ(s2.gcount(), 10);
+    EXPECT_TRUE(s2.eof());
 }
@@ -0,0 +1,237 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <atomic>
+#include <set>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <LasReader.hpp>
+#include <RangeFilter.hpp>
+#include <SplitterFilter.hpp>
+#include <TransformationFilter.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+TEST(ThreadPoolTest, submit)
+{
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4u);
+
+    std::atomic<int> count(0);
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 100; ++i)
+        futures.push_back(pool.submit([&count](){ count++; }));
+    for (auto& f : futures)
+        pool.wait(f);
+    EXPECT_EQ(count, 100);
+}
+
+
+TEST(ThreadPoolTest, setActive)
+{
+    ThreadPool pool(4);
+    pool.setActive(2);
+    EXPECT_EQ(pool.size(), 2u);
+
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 100; ++i)
+        futures.push_back(pool.submit([&mutex, &ids]()
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            std::lock_guard<std::mutex> lock(mutex);
+            ids.insert(std::this_thread::get_id());
+        }));
+    // Wait without running tasks on this thread.
+    for (auto& f : futures)
+        f.get();
+    EXPECT_LE(ids.size(), 2u);
+
+    pool.setActive(100);
+    EXPECT_EQ(pool.size(), 4u);
+    pool.setActive(0);
+    EXPECT_EQ(pool.size(), 1u);
+}
+
+
+TEST(ThreadPoolTest, error)
+{
+    ThreadPool pool(2);
+
+    std::future<void> f =
+        pool.submit([](){ throw pdal_error("Task failed."); });
+    EXPECT_THROW(pool.wait(f), pdal_error);
+}
+
+
+// Tasks that wait on other tasks shouldn't tie up the workers.
+TEST(ThreadPoolTest, nested)
+{
+    ThreadPool pool(2);
+
+    std::atomic<int> count(0);
+    auto outer = [&pool, &count]()
+    {
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < 10; ++i)
+            futures.push_back(pool.submit([&count](){ count++; }));
+        for (auto& f : futures)
+            pool.wait(f);
+    };
+
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 10; ++i)
+        futures.push_back(pool.submit(outer));
+    for (auto& f : futures)
+        pool.wait(f);
+    EXPECT_EQ(count, 100);
+}
+
+
+TEST(ThreadPoolTest, parallelFor)
+{
+    ThreadPool pool(4);
+
+    std::vector<int> visits(100000);
+    pool.parallelFor(visits.size(), 1000,
+        [&visits](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                visits[i]++;
+        });
+    for (int v : visits)
+        EXPECT_EQ(v, 1);
+
+    EXPECT_THROW(pool.parallelFor(visits.size(), 1000,
+        [](std::size_t begin, std::size_t)
+        {
+            if (begin)
+                throw pdal_error("Range failed.");
+        }), pdal_error);
+}
+
+
+// A view large enough to be split is filtered in parallel and the kept
+// points stay in order.
+TEST(ThreadPoolTest, parallelRange)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+
+    const point_count_t count = 200000;
+    PointViewPtr view(new PointView(table));
+    for (PointId idx = 0; idx < count; ++idx)
+        view->setField(Dimension::Id::X, idx, (double)idx);
+
+    BufferReader reader;
+    reader.addView(view);
+
+    Options range;
+    range.add("min", 1000);
+    range.add("max", 149999);
+    Option dim("dimension", "X");
+    dim.setOptions(range);
+    Options ops;
+    ops.add(dim);
+
+    RangeFilter filter;
+    filter.setOptions(ops);
+    filter.setInput(reader);
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    ASSERT_EQ(viewSet.size(), 1u);
+    PointViewPtr out = *viewSet.begin();
+    ASSERT_EQ(out->size(), 149000u);
+    for (PointId idx = 0; idx < out->size(); ++idx)
+        EXPECT_EQ(out->getFieldAs<double>(Dimension::Id::X, idx), idx + 1000);
+}
+
+
+// The views made by the splitter are transformed in parallel.
+TEST(ThreadPoolTest, parallelViews)
+{
+    Options readerOps;
+    readerOps.add("filename", Support::datapath("las/1.2-with-color.las"));
+    LasReader reader;
+    reader.setOptions(readerOps);
+
+    Options splitterOps;
+    splitterOps.add("length", 100);
+    SplitterFilter splitter;
+    splitter.setOptions(splitterOps);
+    splitter.setInput(reader);
+
+    Options xformOps;
+    xformOps.add("matrix", "1 0 0 1\n0 1 0 2\n0 0 1 3\n0 0 0 1");
+    TransformationFilter xform;
+    xform.setOptions(xformOps);
+    xform.setInput(splitter);
+    EXPECT_TRUE(xform.viewParallel());
+
+    PointTable table;
+    xform.prepare(table);
+    PointViewSet viewSet = xform.execute(table);
+    EXPECT_GT(viewSet.size(), 1u);
+
+    PointTable origTable;
+    LasReader origReader;
+    origReader.setOptions(readerOps);
+    origReader.prepare(origTable);
+    PointViewPtr orig = *origReader.execute(origTable).begin();
+
+    BOX3D bounds = PointView::calculateBounds(viewSet);
+    BOX3D origBounds = orig->calculateBounds();
+    EXPECT_NEAR(bounds.minx, origBounds.minx + 1, 1e-6);
+    EXPECT_NEAR(bounds.maxy, origBounds.maxy + 2, 1e-6);
+    EXPECT_NEAR(bounds.minz, origBounds.minz + 3, 1e-6);
+
+    point_count_t count = 0;
+    double sumX = 0;
+    for (auto const& v : viewSet)
+    {
+        count += v->size();
+        for (PointId idx = 0; idx < v->size(); ++idx)
+            sumX += v->getFieldAs<double>(Dimension::Id::X, idx);
+    }
+    double origSumX = 0;
+    for (PointId idx = 0; idx < orig->size(); ++idx)
+        origSumX += orig->getFieldAs<double>(Dimension::Id::X, idx);
+    EXPECT_EQ(count, orig->size());
+    EXPECT_NEAR(sumX, origSumX + count, 1e-3);
+}
@@ -0,0 +1,119 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <fstream>
+#include <thread>
+
+#include <pdal/PointTable.hpp>
+#include <pdal/Trace.hpp>
+#include <FauxReader.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+std::string traceText(const std::string& filename)
+{
+    std::ifstream in(filename);
+    return std::string(std::istreambuf_iterator<char>(in),
+        std::istreambuf_iterator<char>());
+}
+
+} // unnamed namespace
+
+TEST(TraceTest, spans)
+{
+    std::string filename(Support::temppath("trace.json"));
+    FileUtils::deleteFile(filename);
+
+    // Spans made while tracing is off aren't recorded.
+    {
+        trace::Span span("test", "before");
+    }
+
+    trace::start(filename);
+    EXPECT_TRUE(trace::enabled());
+    {
+        trace::Span span("test", "outer");
+        std::thread t([](){ trace::Span span("test", "in \"thread\""); });
+        t.join();
+    }
+    trace::stop();
+    EXPECT_FALSE(trace::enabled());
+
+    std::string text(traceText(filename));
+    EXPECT_EQ(text.find("{\"traceEvents\":["), 0u);
+    EXPECT_NE(text.find("\"name\":\"outer\""), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"in \\\"thread\\\"\""), std::string::npos);
+    // Each thread gets its own track.
+    size_t pos = text.find("thread_name");
+    EXPECT_NE(pos, std::string::npos);
+    EXPECT_NE(text.find("thread_name", pos + 1), std::string::npos);
+    EXPECT_EQ(text.find("before"), std::string::npos);
+    FileUtils::deleteFile(filename);
+}
+
+
+TEST(TraceTest, stages)
+{
+    std::string filename(Support::temppath("trace.json"));
+    FileUtils::deleteFile(filename);
+
+    Options ops;
+    ops.add("bounds", BOX3D(0.0, 0.0, 0.0, 10.0, 10.0, 10.0));
+    ops.add("mode", "ramp");
+    ops.add("num_points", 10);
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    PointTable table;
+    reader.prepare(table);
+    trace::start(filename);
+    reader.execute(table);
+    trace::stop();
+
+    std::string text(traceText(filename));
+    EXPECT_NE(text.find("\"name\":\"readers.faux execute\""),
+        std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"readers.faux read\""),
+        std::string::npos);
+    EXPECT_NE(text.find("\"cat\":\"io\""), std::string::npos);
+    FileUtils::deleteFile(filename);
+}
@@ -0,0 +1,110 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#define _USE_MATH_DEFINES
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/Trajectory.hpp>
+
+#include <cmath>
+
+using namespace pdal;
+
+namespace
+{
+
+Trajectory::Pose makePose(double time, double value, double heading)
+{
+    Trajectory::Pose p;
+    p.time = time;
+    p.x = value;
+    p.y = -value;
+    p.z = 2 * value;
+    p.roll = value / 10;
+    p.pitch = -value / 10;
+    p.heading = heading;
+    return p;
+}
+
+} // unnamed namespace
+
+TEST(TrajectoryTest, interpolate)
+{
+    Trajectory traj;
+    EXPECT_THROW(traj.interpolate(0), pdal_error);
+
+    for (int i = 0; i < 100; ++i)
+        traj.add(makePose(i, i * i, 0));
+    EXPECT_THROW(traj.add(makePose(50, 0, 0)), pdal_error);
+
+    Trajectory::Pose p = traj.interpolate(10.25);
+    EXPECT_DOUBLE_EQ(p.time, 10.25);
+    EXPECT_DOUBLE_EQ(p.x, 100 + 21 * .25);
+    EXPECT_DOUBLE_EQ(p.y, -(100 + 21 * .25));
+    EXPECT_DOUBLE_EQ(p.z, 2 * (100 + 21 * .25));
+    EXPECT_DOUBLE_EQ(p.roll, (100 + 21 * .25) / 10);
+
+    // Times outside the trajectory get the end poses.
+    EXPECT_DOUBLE_EQ(traj.interpolate(-5).x, 0);
+    EXPECT_DOUBLE_EQ(traj.interpolate(500).x, 99 * 99);
+}
+
+TEST(TrajectoryTest, hint)
+{
+    Trajectory traj;
+    for (int i = 0; i < 1000; ++i)
+        traj.add(makePose(i * .5, i, 0));
+
+    // Forward, repeated, backward and far jumps all give the same poses
+    // as a lookup without a hint.
+    std::size_t hint = 0;
+    double times[] = { .1, .2, .7, .7, 3.9, 3.1, 250.2, 12.6, 499.4,
+        499.5, 0, 0.3 };
+    for (double t : times)
+    {
+        Trajectory::Pose p = traj.interpolate(t, hint);
+        EXPECT_DOUBLE_EQ(p.x, traj.interpolate(t).x);
+        EXPECT_DOUBLE_EQ(p.x, std::min(t * 2, 999.0));
+    }
+}
+
+TEST(TrajectoryTest, heading)
+{
+    // Headings either side of north interpolate through north, not south.
+    Trajectory traj;
+    traj.add(makePose(0, 0, 2 * M_PI - .1));
+    traj.add(makePose(1, 0, .1));
+    Trajectory::Pose p = traj.interpolate(.75);
+    EXPECT_NEAR(std::fmod(p.heading, 2 * M_PI), .05, 1e-12);
+}
@@ -107,3 +107,22 @@ TEST(UserCallbackTest, test1)
     EXPECT_TRUE(!ok);
     EXPECT_DOUBLE_EQ(100.0*(151.0/300.0), cb.getPercentComplete());
 }
+
+
+TEST(UserCallbackTest, poller)
+{
+    UserCallback cb;
+    cb.setTotal(1000);
+    ProgressPoller poller(cb, 100);
+
+    for (point_count_t count = 0; count < 1000; ++count)
+        poller.poll(count);
+    EXPECT_EQ(cb.getHeartbeats(), 10U);
+    EXPECT_DOUBLE_EQ(cb.getPercentComplete(), 90.0);
+
+    // An interrupt from elsewhere is seen at the next invocation.
+    cb.interrupt();
+    EXPECT_TRUE(cb.interrupted());
+    EXPECT_NO_THROW(poller.poll(999));
+    EXPECT_THROW(poller.poll(1000), pipeline_interrupt);
+}
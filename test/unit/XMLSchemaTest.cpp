@@ -212,3 +212,37 @@ TEST(XMLSchemaTest, utf8)
     EXPECT_EQ(m.name(), metaName);
     EXPECT_EQ(m.value(), metaValue);
 }
+
+// A schema is parsed once and then shared by everyone who asks for it.
+TEST(XMLSchemaTest, cached)
+{
+    using namespace pdal;
+
+    std::string xml6 = ReadXML(TestConfig::g_data_path +
+        "../../schemas/6-dim-schema.xml");
+    std::string xml16 = ReadXML(TestConfig::g_data_path +
+        "../../schemas/16-dim-schema.xml");
+
+    std::shared_ptr<const XMLSchema> s1 = XMLSchema::cached(xml6);
+    std::shared_ptr<const XMLSchema> s2 = XMLSchema::cached(xml6);
+    std::shared_ptr<const XMLSchema> s3 = XMLSchema::cached(xml16);
+    EXPECT_EQ(s1.get(), s2.get());
+    EXPECT_NE(s1.get(), s3.get());
+
+    XMLSchema direct(xml6);
+    XMLDimList dims = direct.xmlDims();
+    XMLDimList cachedDims = s1->xmlDims();
+    ASSERT_EQ(dims.size(), cachedDims.size());
+    for (size_t i = 0; i < dims.size(); ++i)
+    {
+        EXPECT_EQ(dims[i].m_name, cachedDims[i].m_name);
+        EXPECT_EQ(dims[i].m_dimType.m_type, cachedDims[i].m_dimType.m_type);
+    }
+    EXPECT_EQ(s3->xmlDims().size(), 16u);
+
+    // Validation is part of what's cached.
+    std::string xsd = ReadXML(TestConfig::g_data_path+"../../schemas/LAS.xsd");
+    std::shared_ptr<const XMLSchema> s4 = XMLSchema::cached(xml6, xsd);
+    EXPECT_NE(s1.get(), s4.get());
+    EXPECT_EQ(s4->xmlDims().size(), dims.size());
+}
@@ -179,3 +179,25 @@ TEST(pc2pcTest, pc2pc_test_switches)
     FileUtils::deleteFile(outputLas);
     FileUtils::deleteFile(outputLaz);
 }
+
+
+TEST(pc2pcTest, pc2pc_test_batch)
+{
+    const std::string cmd = appName();
+    const std::string out1 = Support::temppath("batch-utm15.las");
+    const std::string out2 = Support::temppath("batch-utm17.las");
+
+    FileUtils::deleteFile(out1);
+    FileUtils::deleteFile(out2);
+
+    std::string output;
+    int stat = Utils::run_shell_command(cmd + " --batch " +
+        Support::datapath("las/utm1?.las") + " --threads 2 -o " +
+        Support::temppath("batch-#.las"), output);
+    EXPECT_EQ(stat, 0);
+    EXPECT_TRUE(fileIsOkay(out1));
+    EXPECT_TRUE(fileIsOkay(out2));
+
+    FileUtils::deleteFile(out1);
+    FileUtils::deleteFile(out2);
+}
@@ -0,0 +1,234 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <LasWriter.hpp>
+
+#include "Support.hpp"
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace pdal;
+
+namespace
+{
+
+std::string appName()
+{
+    return Support::binpath(Support::exename("pdal") + " delta");
+}
+
+// Write points with the X values 'xs', Y and Z of zero, to 'filename'.
+void writeLas(const std::string& filename, const std::vector<double>& xs)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < xs.size(); ++i)
+    {
+        view->setField(Dimension::Id::X, i, xs[i]);
+        view->setField(Dimension::Id::Y, i, 0);
+        view->setField(Dimension::Id::Z, i, 0);
+    }
+
+    BufferReader reader;
+    reader.addView(view);
+    Options ops;
+    ops.add("filename", filename);
+    LasWriter writer;
+    writer.setOptions(ops);
+    writer.setInput(reader);
+    writer.prepare(table);
+    writer.execute(table);
+}
+
+class pcdeltaTest : public ::testing::Test
+{
+protected:
+    pcdeltaTest() : m_source(Support::temppath("delta_source.las")),
+        m_candidate(Support::temppath("delta_candidate.las"))
+    {}
+
+    // With a radius of 1, the first source point has a candidate within
+    // the radius, the second one only in an adjacent cell, farther than
+    // the radius, and the third none in the adjacent cells.
+    virtual void SetUp()
+    {
+        writeLas(m_source, { 0.5, 10, 50 });
+        writeLas(m_candidate, { 0, 11.5, 100 });
+    }
+
+    virtual void TearDown()
+    {
+        FileUtils::deleteFile(m_source);
+        FileUtils::deleteFile(m_candidate);
+    }
+
+    std::string command(const std::string& args) const
+        { return appName() + " " + m_source + " " + m_candidate + " " + args; }
+
+    std::string m_source;
+    std::string m_candidate;
+};
+
+} // unnamed namespace
+
+
+TEST_F(pcdeltaTest, radiusSummary)
+{
+    std::string output;
+    EXPECT_EQ(Utils::run_shell_command(command("--radius 1 --json"),
+        output), 0);
+
+    std::istringstream in(output);
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(in, tree);
+    EXPECT_EQ(tree.get<double>("approximation.radius"), 1.0);
+    EXPECT_EQ(tree.get<point_count_t>("approximation.exact"), 1u);
+    EXPECT_EQ(tree.get<point_count_t>("approximation.inexact"), 1u);
+    EXPECT_EQ(tree.get<point_count_t>("approximation.unmatched"), 1u);
+
+    // The point without a match is left out of the deltas.
+    EXPECT_FLOAT_EQ(tree.get<float>("min.x"), -1.5f);
+    EXPECT_FLOAT_EQ(tree.get<float>("max.x"), 0.5f);
+    EXPECT_FLOAT_EQ(tree.get<float>("mean.x"), -0.5f);
+}
+
+// The detail output uses the same neighbors as the summary.
+TEST_F(pcdeltaTest, radiusDetail)
+{
+    std::string output;
+    EXPECT_EQ(Utils::run_shell_command(command("--radius 1 --detail"),
+        output), 0);
+
+    // The header, then the ID and X, Y and Z deltas of each point with a
+    // match, then a blank line.
+    std::istringstream in(output);
+    std::string line;
+    std::vector<StringList> rows;
+    while (std::getline(in, line))
+        if (line.size())
+            rows.push_back(Utils::split2(line, ','));
+    ASSERT_EQ(rows.size(), 3u);
+    ASSERT_EQ(rows[1].size(), 4u);
+    ASSERT_EQ(rows[2].size(), 4u);
+    EXPECT_EQ(std::stoi(rows[1][0]), 0);
+    EXPECT_DOUBLE_EQ(std::stod(rows[1][1]), 0.5);
+    EXPECT_EQ(std::stoi(rows[2][0]), 1);
+    EXPECT_DOUBLE_EQ(std::stod(rows[2][1]), -1.5);
+    EXPECT_DOUBLE_EQ(std::stod(rows[2][2]), 0);
+}
+
+// Without a radius, every source point gets its nearest candidate.
+TEST_F(pcdeltaTest, exact)
+{
+    std::string output;
+    EXPECT_EQ(Utils::run_shell_command(command("--json"), output), 0);
+
+    std::istringstream in(output);
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(in, tree);
+    EXPECT_EQ(tree.count("approximation"), 0u);
+    EXPECT_FLOAT_EQ(tree.get<float>("min.x"), -1.5f);
+    EXPECT_FLOAT_EQ(tree.get<float>("max.x"), 38.5f);
+}
+
+// Detail is written a line to a point, each ended with '\n', and a blank
+// line after the last.
+TEST_F(pcdeltaTest, detailCSV)
+{
+    std::string output;
+    EXPECT_EQ(Utils::run_shell_command(command("--detail"), output), 0);
+    EXPECT_EQ(output,
+        "\"ID\",\"DeltaX\",\"DeltaY\",\"DeltaZ\"\n"
+        "0,0.500000000000,0.000000000000,0.000000000000\n"
+        "1,-1.500000000000,0.000000000000,0.000000000000\n"
+        "2,38.500000000000,0.000000000000,0.000000000000\n"
+        "\n");
+
+    EXPECT_EQ(Utils::run_shell_command(command("--detail --2d"), output), 0);
+    EXPECT_EQ(output,
+        "\"ID\",\"DeltaX\",\"DeltaY\"\n"
+        "0,0.500000000000,0.000000000000\n"
+        "1,-1.500000000000,0.000000000000\n"
+        "2,38.500000000000,0.000000000000\n"
+        "\n");
+}
+
+// JSON detail is a "delta" array with an object of numbers for each point.
+TEST_F(pcdeltaTest, detailJSON)
+{
+    std::string output;
+    EXPECT_EQ(Utils::run_shell_command(command("--detail --json"), output),
+        0);
+    EXPECT_EQ(output,
+        "{\n"
+        "    \"delta\": [\n"
+        "        { \"i\": 0, \"xd\": 0.5, \"yd\": 0, \"zd\": 0 },\n"
+        "        { \"i\": 1, \"xd\": -1.5, \"yd\": 0, \"zd\": 0 },\n"
+        "        { \"i\": 2, \"xd\": 38.5, \"yd\": 0, \"zd\": 0 }\n"
+        "    ]\n"
+        "}\n");
+
+    std::istringstream in(output);
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(in, tree);
+    const boost::property_tree::ptree& deltas = tree.get_child("delta");
+    ASSERT_EQ(deltas.size(), 3u);
+    auto di = deltas.begin();
+    EXPECT_EQ(di->second.get<int>("i"), 0);
+    EXPECT_DOUBLE_EQ(di->second.get<double>("xd"), 0.5);
+    ++di;
+    EXPECT_EQ(di->second.get<int>("i"), 1);
+    EXPECT_DOUBLE_EQ(di->second.get<double>("xd"), -1.5);
+
+    // Points without a match are left out.
+    EXPECT_EQ(Utils::run_shell_command(
+        command("--detail --json --radius 1"), output), 0);
+    EXPECT_EQ(output,
+        "{\n"
+        "    \"delta\": [\n"
+        "        { \"i\": 0, \"xd\": 0.5, \"yd\": 0, \"zd\": 0 },\n"
+        "        { \"i\": 1, \"xd\": -1.5, \"yd\": 0, \"zd\": 0 }\n"
+        "    ]\n"
+        "}\n");
+}
@@ -0,0 +1,145 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/PipelineManager.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include "Support.hpp"
+
+#include <string>
+
+using namespace pdal;
+
+namespace
+{
+
+std::string appName()
+{
+    return Support::binpath(Support::exename("pdal") + " diff");
+}
+
+class pcdiffTest : public ::testing::Test
+{
+protected:
+    pcdiffTest() : m_source(Support::datapath("las/simple.las")),
+        m_shifted(Support::temppath("diff_shifted.las"))
+    {}
+
+    // Write a copy of the source with X moved by half a unit.
+    virtual void SetUp()
+    {
+        PipelineManager mgr;
+
+        Options readerOps;
+        readerOps.add("filename", m_source);
+        Stage& reader = mgr.addReader("readers.las");
+        reader.setOptions(readerOps);
+
+        Options xformOps;
+        xformOps.add("matrix", "1 0 0 0.5\n0 1 0 0\n0 0 1 0\n0 0 0 1");
+        Stage& xform = mgr.addFilter("filters.transformation");
+        xform.setInput(reader);
+        xform.setOptions(xformOps);
+
+        Options writerOps;
+        writerOps.add("filename", m_shifted);
+        writerOps.add("forward", "all");
+        Stage& writer = mgr.addWriter("writers.las");
+        writer.setInput(xform);
+        writer.setOptions(writerOps);
+        mgr.execute();
+    }
+
+    virtual void TearDown()
+        { FileUtils::deleteFile(m_shifted); }
+
+    int diff(const std::string& args, std::string& output)
+    {
+        return Utils::run_shell_command(appName() + " " + m_source + " " +
+            m_shifted + " --ignore-metadata " + args, output);
+    }
+
+    std::string m_source;
+    std::string m_shifted;
+};
+
+} // unnamed namespace
+
+
+TEST_F(pcdiffTest, identical)
+{
+    std::string output;
+    std::string cmd = appName() + " " + m_source + " " + m_source;
+
+    EXPECT_EQ(Utils::run_shell_command(cmd, output), 0);
+    EXPECT_EQ(output, "");
+    EXPECT_EQ(Utils::run_shell_command(cmd + " --stream --chunk-size 100",
+        output), 0);
+    EXPECT_EQ(output, "");
+}
+
+
+TEST_F(pcdiffTest, tolerance)
+{
+    std::string output;
+
+    for (std::string mode : { "", " --stream --chunk-size 100" })
+    {
+        EXPECT_EQ(diff(mode, output), 1);
+        EXPECT_NE(output.find("differs for dimension \\\"X\\\""),
+            std::string::npos);
+
+        EXPECT_EQ(diff("--tolerance X=0.51" + mode, output), 0);
+        EXPECT_EQ(diff("--tolerance X=0.49" + mode, output), 1);
+        EXPECT_EQ(diff("--tolerance 1" + mode, output), 0);
+    }
+}
+
+
+TEST_F(pcdiffTest, maxDiffs)
+{
+    std::string output;
+
+    for (std::string mode : { "", " --stream --chunk-size 100" })
+    {
+        EXPECT_EQ(diff("--max-diffs 5" + mode, output), 1);
+        EXPECT_NE(output.find("\"count\": \"5\""), std::string::npos);
+
+        // Every point's X differs.
+        EXPECT_EQ(diff("--max-diffs 0" + mode, output), 1);
+        EXPECT_NE(output.find("\"count\": \"1065\""), std::string::npos);
+    }
+}
@@ -0,0 +1,157 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/Utils.hpp>
+
+#include "Support.hpp"
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <string>
+
+using namespace pdal;
+
+namespace
+{
+
+typedef boost::property_tree::ptree ptree;
+
+std::string appName()
+{
+    return Support::binpath(Support::exename("pdal") + " info");
+}
+
+// Run pdal info on the simple LAS file with 'args' and parse its output.
+ptree info(const std::string& args)
+{
+    std::string output;
+    EXPECT_EQ(Utils::run_shell_command(appName() + " " +
+        Support::datapath("las/simple.las") + " " + args, output), 0);
+
+    ptree tree;
+    std::istringstream in(output);
+    boost::property_tree::read_json(in, tree);
+    return tree;
+}
+
+// The statistics of each dimension, by name.
+std::map<std::string, ptree> statistics(const ptree& tree)
+{
+    std::map<std::string, ptree> stats;
+    for (auto& s : tree.get_child("stats.statistic"))
+        stats[s.second.get<std::string>("name")] = s.second;
+    return stats;
+}
+
+} // unnamed namespace
+
+
+// Streamed statistics are those of the points read whole into a mapped
+// table.
+TEST(pcinfoStatsTest, streamMatchesStandard)
+{
+    std::map<std::string, ptree> streamed(statistics(info("--stats")));
+    std::map<std::string, ptree> standard(
+        statistics(info("--stats --mmap")));
+
+    ASSERT_EQ(streamed.size(), standard.size());
+    ASSERT_TRUE(streamed.count("X"));
+    for (auto& s : standard)
+    {
+        const ptree& a = streamed[s.first];
+        const ptree& b = s.second;
+        EXPECT_EQ(a.get<point_count_t>("count"), 1065u) << s.first;
+        EXPECT_EQ(a.get<std::string>("count"), b.get<std::string>("count"));
+        EXPECT_EQ(a.get<std::string>("minimum"),
+            b.get<std::string>("minimum")) << s.first;
+        EXPECT_EQ(a.get<std::string>("maximum"),
+            b.get<std::string>("maximum")) << s.first;
+        for (const char *name : { "average", "variance", "stddev" })
+        {
+            double av = a.get<double>(name);
+            double bv = b.get<double>(name);
+            EXPECT_NEAR(av, bv, 1e-9 * (std::max)(1.0, std::fabs(bv))) <<
+                s.first << " " << name;
+        }
+    }
+}
+
+// A sample of about 100 of the 1065 points is every 11th point from a
+// random start, and the statistics are of the sample alone.
+TEST(pcinfoStatsTest, sample)
+{
+    std::map<std::string, ptree> all(statistics(info("--stats")));
+
+    ptree tree(info("--stats --sample 100"));
+    const point_count_t step = tree.get<point_count_t>("sample.step");
+    const point_count_t offset = tree.get<point_count_t>("sample.offset");
+    EXPECT_EQ(step, 11u);
+    EXPECT_LT(offset, step);
+
+    std::map<std::string, ptree> sampled(statistics(tree));
+    ASSERT_EQ(sampled.size(), all.size());
+    for (auto& s : sampled)
+    {
+        EXPECT_EQ(s.second.get<point_count_t>("count"),
+            (1065 - offset + step - 1) / step) << s.first;
+        EXPECT_GE(s.second.get<double>("minimum"),
+            all[s.first].get<double>("minimum")) << s.first;
+        EXPECT_LE(s.second.get<double>("maximum"),
+            all[s.first].get<double>("maximum")) << s.first;
+    }
+}
+
+// A sample at least as large as the file is the whole file.
+TEST(pcinfoStatsTest, sampleAll)
+{
+    ptree tree(info("--stats --sample 5000"));
+    EXPECT_EQ(tree.count("sample"), 0u);
+    for (auto& s : statistics(tree))
+        EXPECT_EQ(s.second.get<point_count_t>("count"), 1065u) << s.first;
+}
+
+// Points can't be dumped from a sample.
+TEST(pcinfoStatsTest, sampleWithPoint)
+{
+    std::string output;
+    EXPECT_NE(Utils::run_shell_command(appName() + " " +
+        Support::datapath("las/simple.las") + " --sample 10 --point 1",
+        output), 0);
+}
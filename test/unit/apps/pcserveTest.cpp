@@ -0,0 +1,191 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/util/FileUtils.hpp>
+
+#include "Support.hpp"
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace pdal;
+
+namespace
+{
+
+std::string appName()
+{
+    return Support::binpath(Support::exename("pdal") + " serve");
+}
+
+// Connect to the server listening on 'socketPath'.  Returns -1 if no server
+// is listening.
+int connectTo(const std::string& socketPath)
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(),
+        sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// Send a pipeline to the server and parse its reply.
+boost::property_tree::ptree request(const std::string& socketPath,
+    const std::string& xml)
+{
+    boost::property_tree::ptree tree;
+    int fd = connectTo(socketPath);
+    if (fd < 0)
+        return tree;
+
+    const char *pos = xml.data();
+    std::size_t left = xml.size();
+    while (left)
+    {
+        ssize_t count = write(fd, pos, left);
+        if (count <= 0)
+            break;
+        pos += count;
+        left -= count;
+    }
+    shutdown(fd, SHUT_WR);
+
+    std::string reply;
+    char buf[4096];
+    ssize_t count;
+    while ((count = read(fd, buf, sizeof(buf))) > 0)
+        reply.append(buf, count);
+    close(fd);
+
+    std::istringstream in(reply);
+    boost::property_tree::read_json(in, tree);
+    return tree;
+}
+
+} // unnamed namespace
+
+
+// A good and a bad pipeline are sent at once to a server running two jobs
+// at a time.  Each gets its own result.
+TEST(pcserveTest, jobs)
+{
+    std::string socketPath = Support::temppath("serve.sock");
+    std::string pidFile = Support::temppath("serve.pid");
+    FileUtils::deleteFile(socketPath);
+    FileUtils::deleteFile(pidFile);
+
+    std::string cmd = appName() + " " + socketPath +
+        " --jobs 2 > /dev/null 2>&1 & echo $! > " + pidFile;
+    ASSERT_EQ(std::system(cmd.c_str()), 0);
+    pid_t pid = 0;
+    std::ifstream(pidFile) >> pid;
+    ASSERT_GT(pid, 0);
+
+    // Wait for the server to listen.
+    int fd = -1;
+    for (int i = 0; i < 100 && fd < 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        fd = connectTo(socketPath);
+    }
+    if (fd < 0)
+        kill(pid, SIGTERM);
+    ASSERT_GE(fd, 0);
+    // The connection that found the server sends nothing.
+    shutdown(fd, SHUT_WR);
+    close(fd);
+
+    std::string good =
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        "<Pipeline version=\"1.0\">\n"
+        "  <Reader type=\"readers.las\">\n"
+        "    <Option name=\"filename\">" +
+            Support::datapath("las/simple.las") + "</Option>\n"
+        "  </Reader>\n"
+        "</Pipeline>\n";
+    std::string bad =
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        "<Pipeline version=\"1.0\">\n"
+        "  <Reader type=\"readers.nosuchformat\">\n"
+        "    <Option name=\"filename\">nosuchfile</Option>\n"
+        "  </Reader>\n"
+        "</Pipeline>\n";
+
+    boost::property_tree::ptree goodResult;
+    boost::property_tree::ptree badResult;
+    std::thread goodThread([&]()
+        { goodResult = request(socketPath, good); });
+    std::thread badThread([&]()
+        { badResult = request(socketPath, bad); });
+    goodThread.join();
+    badThread.join();
+
+    EXPECT_EQ(goodResult.get<std::string>("result.status", ""), "ok");
+    EXPECT_EQ(goodResult.get<point_count_t>("result.count", 0), 1065u);
+    EXPECT_GE(goodResult.get<double>("result.time", -1), 0);
+    EXPECT_FALSE(goodResult.get_optional<std::string>("result.message"));
+
+    EXPECT_EQ(badResult.get<std::string>("result.status", ""), "error");
+    EXPECT_FALSE(badResult.get<std::string>("result.message", "").empty());
+    EXPECT_FALSE(badResult.get_optional<point_count_t>("result.count"));
+
+    // The server removes its socket when it stops.
+    kill(pid, SIGTERM);
+    for (int i = 0; i < 100 && FileUtils::fileExists(socketPath); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(FileUtils::fileExists(socketPath));
+    FileUtils::deleteFile(pidFile);
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/util/FileUtils.hpp>
+#include <LasReader.hpp>
+
+#include "Support.hpp"
+
+#include <string>
+
+using namespace pdal;
+
+namespace
+{
+
+std::string appName()
+{
+    return Support::binpath(Support::exename("pdal") + " sort");
+}
+
+PointViewPtr readLas(const std::string& filename, PointTableRef table)
+{
+    Options ops;
+    ops.add("filename", filename);
+    LasReader reader;
+    reader.setOptions(ops);
+    reader.prepare(table);
+    return *reader.execute(table).begin();
+}
+
+} // unnamed namespace
+
+
+// Sorting out of core, in runs smaller than the file, orders the points
+// as sorting in memory does.
+TEST(pcsortTest, runs)
+{
+    std::string source = Support::datapath("las/simple.las");
+    std::string inMemory = Support::temppath("sort_memory.las");
+    std::string outOfCore = Support::temppath("sort_runs.las");
+
+    for (std::string order : { "morton", "hilbert" })
+    {
+        std::string output;
+        std::string cmd = appName() + " " + source + " --order " + order;
+        EXPECT_EQ(Utils::run_shell_command(cmd + " " + inMemory, output), 0);
+        EXPECT_EQ(Utils::run_shell_command(cmd + " " + outOfCore +
+            " --run_size 100", output), 0);
+
+        PointTable memTable;
+        PointViewPtr memView = readLas(inMemory, memTable);
+        PointTable runTable;
+        PointViewPtr runView = readLas(outOfCore, runTable);
+        ASSERT_EQ(memView->size(), 1065u);
+        ASSERT_EQ(runView->size(), 1065u);
+        for (PointId i = 0; i < memView->size(); ++i)
+            for (auto dim : { Dimension::Id::X, Dimension::Id::Y,
+                Dimension::Id::Z, Dimension::Id::Intensity })
+                EXPECT_EQ(memView->getFieldAs<double>(dim, i),
+                    runView->getFieldAs<double>(dim, i));
+    }
+    FileUtils::deleteFile(inMemory);
+    FileUtils::deleteFile(outOfCore);
+}
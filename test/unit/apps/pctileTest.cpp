@@ -0,0 +1,118 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/util/FileUtils.hpp>
+#include <LasReader.hpp>
+
+#include "Support.hpp"
+
+#include <cmath>
+#include <map>
+#include <string>
+
+using namespace pdal;
+
+namespace
+{
+
+std::string appName()
+{
+    return Support::binpath(Support::exename("pdal") + " tile");
+}
+
+PointViewPtr readLas(const std::string& filename, PointTableRef table)
+{
+    Options ops;
+    ops.add("filename", filename);
+    LasReader reader;
+    reader.setOptions(ops);
+    reader.prepare(table);
+    return *reader.execute(table).begin();
+}
+
+// The name the kernel gives the tile of point 'idx' of 'view'.
+std::string tileName(const PointView& view, PointId idx, double length)
+{
+    double x = view.getFieldAs<double>(Dimension::Id::X, idx);
+    double y = view.getFieldAs<double>(Dimension::Id::Y, idx);
+    return std::to_string((int)std::floor(x / length)) + "_" +
+        std::to_string((int)std::floor(y / length));
+}
+
+} // unnamed namespace
+
+
+// With no memory for points and one spill file open at a time, every chunk
+// is spilled and spill files are closed and opened again.  The tiles still
+// get every point.
+TEST(pctileTest, spill)
+{
+    std::string source = Support::datapath("las/simple.las");
+    std::string dir = Support::temppath("tiles");
+    FileUtils::deleteDirectory(dir);
+    FileUtils::createDirectory(dir);
+
+    PointTable table;
+    PointViewPtr view = readLas(source, table);
+    std::map<std::string, point_count_t> expected;
+    for (PointId i = 0; i < view->size(); ++i)
+        expected[tileName(*view, i, 500)]++;
+    ASSERT_GT(expected.size(), 2u);
+
+    std::string output;
+    std::string cmd = appName() + " " + source + " " + dir + "/#.las" +
+        " --length 500 --chunk 100 --buffer 0 --max_open 1 --verbose 1 2>&1";
+    EXPECT_EQ(Utils::run_shell_command(cmd, output), 0);
+    EXPECT_NE(output.find(std::to_string(expected.size()) + " tiles"),
+        std::string::npos);
+    EXPECT_EQ(output.find(" 0 bytes spilled"), std::string::npos);
+
+    EXPECT_EQ(FileUtils::glob(dir + "/*.las").size(), expected.size());
+    point_count_t total = 0;
+    for (auto& e : expected)
+    {
+        std::string filename = dir + "/" + e.first + ".las";
+        ASSERT_TRUE(FileUtils::fileExists(filename));
+        PointTable tileTable;
+        PointViewPtr tileView = readLas(filename, tileTable);
+        EXPECT_EQ(tileView->size(), e.second);
+        for (PointId i = 0; i < tileView->size(); ++i)
+            EXPECT_EQ(tileName(*tileView, i, 500), e.first);
+        total += tileView->size();
+    }
+    EXPECT_EQ(total, view->size());
+    FileUtils::deleteDirectory(dir);
+}
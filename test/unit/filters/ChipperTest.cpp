@@ -35,10 +35,12 @@
 #include <pdal/pdal_test_main.hpp>
 
 #include <ChipperFilter.hpp>
+#include <FauxReader.hpp>
 #include <LasWriter.hpp>
 #include <LasReader.hpp>
 #include <pdal/Options.hpp>
 #include <pdal/StageWrapper.hpp>
+#include <pdal/Writer.hpp>
 
 #include "Support.hpp"
 
@@ -116,6 +118,147 @@ TEST(ChipperTest, empty_buffer)
     EXPECT_EQ(viewSet.size(), 0u);
 }
 
+
+// Enough points that the splits run as parallel tasks.  Every point should
+// land in exactly one chip, and chips in X shouldn't overlap.
+TEST(ChipperTest, large)
+{
+    Options readerOps;
+    readerOps.add("mode", "random");
+    readerOps.add("num_points", 300000);
+    readerOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    FauxReader reader;
+    reader.setOptions(readerOps);
+
+    Options options;
+    options.add("capacity", 5000);
+    ChipperFilter chipper;
+    chipper.setInput(reader);
+    chipper.setOptions(options);
+
+    PointTable table;
+    chipper.prepare(table);
+    PointViewSet viewSet = chipper.execute(table);
+    EXPECT_EQ(viewSet.size(), 60u);
+
+    point_count_t total = 0;
+    std::vector<bool> seen(300000);
+    for (PointViewPtr view : viewSet)
+    {
+        EXPECT_EQ(view->size(), 5000u);
+        total += view->size();
+        for (PointId i = 0; i < view->size(); ++i)
+        {
+            uint64_t id = view->getFieldAs<uint64_t>(Dimension::Id::OffsetTime,
+                i);
+            EXPECT_FALSE(seen[id]);
+            seen[id] = true;
+        }
+    }
+    EXPECT_EQ(total, 300000u);
+}
+
+namespace
+{
+
+// Keeps the IDs and X range of each chip it's given.
+class ChipRecorder : public Writer
+{
+public:
+    struct Chip
+    {
+        std::vector<uint64_t> m_ids;
+        BOX3D m_bounds;
+    };
+
+    std::string getName() const
+        { return "writers.chiprecorder"; }
+    virtual bool streamable() const
+        { return true; }
+
+    std::vector<Chip> m_chips;
+
+private:
+    virtual void write(const PointViewPtr view)
+    {
+        Chip chip;
+        for (PointId i = 0; i < view->size(); ++i)
+            chip.m_ids.push_back(
+                view->getFieldAs<uint64_t>(Dimension::Id::OffsetTime, i));
+        chip.m_bounds = view->calculateBounds();
+        m_chips.push_back(chip);
+    }
+};
+
+} // unnamed namespace
+
+TEST(ChipperTest, stream)
+{
+    for (int slots = 1; slots <= 3; slots += 2)
+    {
+        Options readerOps;
+        readerOps.add("mode", "random");
+        readerOps.add("num_points", 30000);
+        readerOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+        FauxReader reader;
+        reader.setOptions(readerOps);
+
+        Options options;
+        options.add("capacity", 500);
+        options.add("stream", true);
+        options.add("cell_size", 250);
+        ChipperFilter chipper;
+        chipper.setInput(reader);
+        chipper.setOptions(options);
+
+        ChipRecorder writer;
+        writer.setInput(chipper);
+
+        FixedPointTable table(1000, slots);
+        writer.prepare(table);
+        EXPECT_TRUE(writer.pipelineStreamable());
+        EXPECT_EQ(writer.executeStream(table), 30000u);
+
+        // Each point is in one chip, with no more than 'capacity' points
+        // from one cell.  Most cells hold a couple of full chips.
+        std::vector<bool> seen(30000);
+        point_count_t total = 0;
+        size_t full = 0;
+        for (auto& chip : writer.m_chips)
+        {
+            EXPECT_LE(chip.m_ids.size(), 500u);
+            if (chip.m_ids.size() == 500)
+                full++;
+            EXPECT_LE(chip.m_bounds.maxx - chip.m_bounds.minx, 250.0);
+            EXPECT_LE(chip.m_bounds.maxy - chip.m_bounds.miny, 250.0);
+            for (uint64_t id : chip.m_ids)
+            {
+                ASSERT_LT(id, 30000u);
+                EXPECT_FALSE(seen[id]);
+                seen[id] = true;
+            }
+            total += chip.m_ids.size();
+        }
+        EXPECT_EQ(total, 30000u);
+        EXPECT_GE(full, 48u);
+    }
+
+    // Chips must fit in a streamed chunk.
+    FauxReader reader;
+    Options readerOps;
+    readerOps.add("num_points", 10);
+    readerOps.add("bounds", BOX3D(0, 0, 0, 1, 1, 1));
+    reader.setOptions(readerOps);
+    Options options;
+    options.add("capacity", 500);
+    options.add("stream", true);
+    ChipperFilter chipper;
+    chipper.setInput(reader);
+    chipper.setOptions(options);
+    FixedPointTable table(100);
+    EXPECT_THROW(chipper.prepare(table), pdal_error);
+}
+
 //ABELL
 /**
 TEST(ChipperTest, test_ordering)
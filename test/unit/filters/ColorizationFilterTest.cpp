@@ -104,3 +104,112 @@ TEST(ColorizationFilterTest, ColorizationFilterTest_test_1)
     // We scaled this up to 16bit by multiplying by 255
     EXPECT_EQ(b, 47175u);
 }
+
+
+// Sorting by block and a small cache shouldn't change the colors.
+TEST(ColorizationFilterTest, cache)
+{
+    auto colorize = [](Options extra)
+    {
+        Options ops1;
+        ops1.add("filename",
+            Support::datapath("autzen/autzen-point-format-3.las"));
+        LasReader reader;
+        reader.setOptions(ops1);
+
+        Options options;
+        options.add("raster", Support::datapath("autzen/autzen.jpg"));
+        for (const Option& o : extra.getOptions())
+            options.add(o);
+
+        ColorizationFilter filter;
+        filter.setOptions(options);
+        filter.setInput(reader);
+
+        PointTable table;
+        filter.prepare(table);
+        PointViewSet viewSet = filter.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        PointViewPtr view = *viewSet.begin();
+
+        std::vector<uint16_t> colors;
+        for (PointId i = 0; i < view->size(); ++i)
+        {
+            colors.push_back(view->getFieldAs<uint16_t>(Dimension::Id::Red, i));
+            colors.push_back(
+                view->getFieldAs<uint16_t>(Dimension::Id::Green, i));
+            colors.push_back(
+                view->getFieldAs<uint16_t>(Dimension::Id::Blue, i));
+        }
+        return colors;
+    };
+
+    std::vector<uint16_t> colors = colorize(Options());
+
+    Options small;
+    small.add("cache_blocks", 1);
+    small.add("sort_by_block", true);
+    std::vector<uint16_t> cached = colorize(small);
+
+    EXPECT_EQ(colors[0], 210u);
+    EXPECT_EQ(colors[1], 205u);
+    EXPECT_EQ(colors[2], 185u);
+    EXPECT_TRUE(colors == cached);
+}
+
+
+TEST(ColorizationFilterTest, rasters)
+{
+    auto colorize = [](Options options)
+    {
+        Options ops1;
+        ops1.add("filename",
+            Support::datapath("autzen/autzen-point-format-3.las"));
+        LasReader reader;
+        reader.setOptions(ops1);
+
+        ColorizationFilter filter;
+        filter.setOptions(options);
+        filter.setInput(reader);
+
+        PointTable table;
+        filter.prepare(table);
+        PointViewSet viewSet = filter.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        return *viewSet.begin();
+    };
+
+    Options one;
+    one.add("raster", Support::datapath("autzen/autzen.jpg"));
+    PointViewPtr v1 = colorize(one);
+
+    // The first raster that covers a point is used.
+    Options two;
+    two.add("raster", Support::datapath("autzen/autzen.jpg"));
+    two.add("raster", Support::datapath("autzen/autzen.jpg"));
+    two.add("sort_by_block", true);
+    PointViewPtr v2 = colorize(two);
+
+    Options bilinear;
+    bilinear.add("raster", Support::datapath("autzen/autzen.jpg"));
+    bilinear.add("interpolation", "bilinear");
+    PointViewPtr v3 = colorize(bilinear);
+
+    ASSERT_EQ(v1->size(), v2->size());
+    ASSERT_EQ(v1->size(), v3->size());
+    for (PointId i = 0; i < v1->size(); ++i)
+    {
+        for (Dimension::Id::Enum dim :
+            { Dimension::Id::Red, Dimension::Id::Green, Dimension::Id::Blue })
+        {
+            uint16_t c = v1->getFieldAs<uint16_t>(dim, i);
+            EXPECT_EQ(c, v2->getFieldAs<uint16_t>(dim, i));
+            EXPECT_LE(v3->getFieldAs<uint16_t>(dim, i), 255u);
+        }
+    }
+
+    Options bad;
+    bad.add("raster", Support::datapath("autzen/autzen.jpg"));
+    bad.add("interpolation", "cubic");
+    EXPECT_THROW(colorize(bad), pdal_error);
+}
@@ -115,6 +115,209 @@ TEST(CropFilterTest, test_crop)
 }
 
 
+TEST(CropFilterTest, test_crop_outside)
+{
+    BOX3D srcBounds(0.0, 0.0, 0.0, 10.0, 100.0, 1000.0);
+    Options opts;
+    opts.add("bounds", srcBounds);
+    opts.add("num_points", 1000);
+    opts.add("mode", "ramp");
+    FauxReader reader;
+    reader.setOptions(opts);
+
+    BOX3D dstBounds(3.33333, 33.33333, 333.33333, 6.66666, 66.66666, 666.66666);
+    Options cropOpts;
+    cropOpts.add("bounds", dstBounds);
+    cropOpts.add("outside", true);
+
+    CropFilter filter;
+    filter.setOptions(cropOpts);
+    filter.setInput(reader);
+
+    PointTable table;
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 667u);
+    for (PointId i = 0; i < view->size(); ++i)
+        EXPECT_FALSE(dstBounds.contains(
+            view->getFieldAs<double>(Dimension::Id::X, i),
+            view->getFieldAs<double>(Dimension::Id::Y, i),
+            view->getFieldAs<double>(Dimension::Id::Z, i)));
+}
+
+
+// The LAS reader skips the points outside the bounds itself, which must
+// give the same points as cropping all of them.
+TEST(CropFilterTest, readerBounds)
+{
+    Options readerOps;
+    readerOps.add("filename", Support::datapath("las/simple.las"));
+
+    LasReader allReader;
+    allReader.setOptions(readerOps);
+    PointTable allTable;
+    allReader.prepare(allTable);
+    PointViewPtr all = *allReader.execute(allTable).begin();
+
+    BOX3D bounds(636000, 849000, 400, 637000, 851000, 500);
+    std::vector<PointId> inside;
+    for (PointId idx = 0; idx < all->size(); ++idx)
+    {
+        double x = all->getFieldAs<double>(Dimension::Id::X, idx);
+        double y = all->getFieldAs<double>(Dimension::Id::Y, idx);
+        double z = all->getFieldAs<double>(Dimension::Id::Z, idx);
+        if (bounds.contains(x, y, z))
+            inside.push_back(idx);
+    }
+    EXPECT_GT(inside.size(), 0u);
+    EXPECT_LT(inside.size(), all->size());
+
+    for (bool outside : { false, true })
+    {
+        LasReader reader;
+        reader.setOptions(readerOps);
+
+        Options cropOps;
+        cropOps.add("bounds", bounds);
+        cropOps.add("outside", outside);
+        CropFilter crop;
+        crop.setOptions(cropOps);
+        crop.setInput(reader);
+
+        PointTable table;
+        crop.prepare(table);
+        PointViewSet viewSet = crop.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        PointViewPtr view = *viewSet.begin();
+
+        // The bounds are only handed to the reader when cropping to them.
+        EXPECT_EQ(reader.setBounds(bounds), outside);
+        if (outside)
+        {
+            EXPECT_EQ(view->size(), all->size() - inside.size());
+            continue;
+        }
+        ASSERT_EQ(view->size(), inside.size());
+        for (PointId idx = 0; idx < view->size(); ++idx)
+            for (Dimension::Id::Enum dim :
+                { Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z,
+                  Dimension::Id::GpsTime })
+                EXPECT_EQ(view->getFieldAs<double>(dim, idx),
+                    all->getFieldAs<double>(dim, inside[idx]));
+    }
+}
+
+
+TEST(CropFilterTest, test_crop_polygon_outside)
+{
+#ifdef PDAL_HAVE_GEOS
+    Options ops1;
+    ops1.add("filename", Support::datapath("las/1.2-with-color.las"));
+    LasReader reader;
+    reader.setOptions(ops1);
+
+    std::istream* wkt_stream =
+        FileUtils::openFile(Support::datapath("autzen/autzen-selection.wkt"));
+    std::stringstream strbuf;
+    strbuf << wkt_stream->rdbuf();
+    FileUtils::closeFile(wkt_stream);
+
+    Options options;
+    options.add("polygon", strbuf.str());
+    options.add("outside", true);
+
+    CropFilter crop;
+    crop.setInput(reader);
+    crop.setOptions(options);
+
+    PointTable table;
+    crop.prepare(table);
+    PointViewSet viewSet = crop.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 1065u - 47u);
+#endif
+}
+
+
+TEST(CropFilterTest, test_crop_polygons)
+{
+#ifdef PDAL_HAVE_GEOS
+    const std::vector<std::string> polys =
+    {
+        "POLYGON ((10 10, 40 10, 40 40, 10 40, 10 10))",
+        "POLYGON ((30 30, 90 30, 60 80, 30 30))",
+        "POLYGON ((0 60, 30 60, 30 90, 0 90, 0 60), "
+            "(10 70, 20 70, 20 80, 10 80, 10 70))"
+    };
+
+    Options readerOps;
+    readerOps.add("bounds", BOX3D(0, 0, 0, 100, 100, 100));
+    readerOps.add("count", 10000);
+    readerOps.add("mode", "uniform");
+    readerOps.add("seed", 42);
+
+    // Crop with each polygon alone.
+    std::vector<point_count_t> counts;
+    for (const std::string& poly : polys)
+    {
+        FauxReader reader;
+        reader.setOptions(readerOps);
+
+        Options cropOps;
+        cropOps.add("polygon", poly);
+        CropFilter crop;
+        crop.setOptions(cropOps);
+        crop.setInput(reader);
+
+        PointTable table;
+        crop.prepare(table);
+        PointViewSet viewSet = crop.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        counts.push_back((*viewSet.begin())->size());
+        EXPECT_GT(counts.back(), 0u);
+    }
+
+    // Crop with all of them at once.
+    FauxReader reader;
+    reader.setOptions(readerOps);
+
+    Options cropOps;
+    for (const std::string& poly : polys)
+        cropOps.add("polygon", poly);
+    CropFilter crop;
+    crop.setOptions(cropOps);
+    crop.setInput(reader);
+
+    PointTable table;
+    crop.prepare(table);
+    PointViewSet viewSet = crop.execute(table);
+    ASSERT_EQ(viewSet.size(), polys.size());
+    size_t i = 0;
+    for (PointViewPtr view : viewSet)
+        EXPECT_EQ(view->size(), counts[i++]);
+
+    // The first view has the points of the first, square polygon.
+    PointViewPtr first = *viewSet.begin();
+    for (PointId idx = 0; idx < first->size(); ++idx)
+    {
+        double x = first->getFieldAs<double>(Dimension::Id::X, idx);
+        double y = first->getFieldAs<double>(Dimension::Id::Y, idx);
+        EXPECT_TRUE(x >= 10 && x <= 40 && y >= 10 && y <= 40);
+    }
+
+    cropOps.add("outside", true);
+    CropFilter crop2;
+    crop2.setOptions(cropOps);
+    crop2.setInput(reader);
+    PointTable table2;
+    EXPECT_THROW(crop2.prepare(table2), pdal_error);
+#endif
+}
+
+
 TEST(CropFilterTest, test_crop_polygon)
 {
 #ifdef PDAL_HAVE_GEOS
@@ -36,8 +36,11 @@
 
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/Writer.hpp>
 #include <DecimationFilter.hpp>
 #include <FauxReader.hpp>
+#include <LasReader.hpp>
+#include "Support.hpp"
 
 using namespace pdal;
 
@@ -82,3 +85,298 @@ TEST(DecimationFilterTest, DecimationFilterTest_test1)
     EXPECT_EQ(t1, 10u);
     EXPECT_EQ(t2, 20u);
 }
+
+// The LAS reader skips the dropped points itself, which must give the
+// same points as decimating them afterward.
+TEST(DecimationFilterTest, readerStride)
+{
+    Options readerOps;
+    readerOps.add("filename", Support::datapath("las/simple.las"));
+
+    LasReader allReader;
+    allReader.setOptions(readerOps);
+    PointTable allTable;
+    allReader.prepare(allTable);
+    PointViewPtr all = *allReader.execute(allTable).begin();
+
+    for (point_count_t limit : { 0, 500 })
+    {
+        LasReader reader;
+        reader.setOptions(readerOps);
+
+        Options decimationOps;
+        decimationOps.add("step", 10);
+        decimationOps.add("offset", 2);
+        decimationOps.add("limit", limit);
+        DecimationFilter filter;
+        filter.setOptions(decimationOps);
+        filter.setInput(reader);
+
+        PointTable table;
+        filter.prepare(table);
+        PointViewSet viewSet = filter.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        PointViewPtr view = *viewSet.begin();
+
+        point_count_t last = limit ? limit : all->size();
+        EXPECT_EQ(view->size(), (last - 2 + 9) / 10);
+        for (PointId i = 0; i < view->size(); ++i)
+            EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::X, i),
+                all->getFieldAs<double>(Dimension::Id::X, 2 + i * 10));
+    }
+}
+
+namespace
+{
+
+// The view is of 'table', which must outlive it.
+PointViewPtr thin(PointTableRef table, Options readerOps,
+    Options decimationOps)
+{
+    FauxReader reader;
+    reader.setOptions(readerOps);
+
+    DecimationFilter filter;
+    filter.setOptions(decimationOps);
+    filter.setInput(reader);
+
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    return *viewSet.begin();
+}
+
+Options rampOptions()
+{
+    Options ops;
+    ops.add("bounds", BOX3D(0.0, 0.0, 0.0, 99.0, 99.0, 99.0));
+    ops.add("mode", "ramp");
+    ops.add("num_points", 100);
+    return ops;
+}
+
+double distance2(PointView& v1, PointId i1, PointView& v2, PointId i2)
+{
+    double dx = v1.getFieldAs<double>(Dimension::Id::X, i1) -
+        v2.getFieldAs<double>(Dimension::Id::X, i2);
+    double dy = v1.getFieldAs<double>(Dimension::Id::Y, i1) -
+        v2.getFieldAs<double>(Dimension::Id::Y, i2);
+    double dz = v1.getFieldAs<double>(Dimension::Id::Z, i1) -
+        v2.getFieldAs<double>(Dimension::Id::Z, i2);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Records the OffsetTime of the points it's given.
+class IdRecorder : public Writer
+{
+public:
+    std::string getName() const
+        { return "writers.idrecorder"; }
+    virtual bool streamable() const
+        { return true; }
+
+    std::vector<uint64_t> m_ids;
+
+private:
+    virtual void write(const PointViewPtr view)
+    {
+        for (PointId i = 0; i < view->size(); ++i)
+            m_ids.push_back(
+                view->getFieldAs<uint64_t>(Dimension::Id::OffsetTime, i));
+    }
+};
+
+std::vector<uint64_t> ids(PointView& view)
+{
+    std::vector<uint64_t> out;
+    for (PointId i = 0; i < view.size(); ++i)
+        out.push_back(view.getFieldAs<uint64_t>(Dimension::Id::OffsetTime, i));
+    return out;
+}
+
+} // unnamed namespace
+
+// The first point in each cell is kept.
+TEST(DecimationFilterTest, voxel)
+{
+    Options decimationOps;
+    decimationOps.add("mode", "voxel");
+    decimationOps.add("cell", 10);
+
+    PointTable table;
+    PointViewPtr view = thin(table, rampOptions(), decimationOps);
+    EXPECT_EQ(view->size(), 10u);
+    for (PointId i = 0; i < view->size(); ++i)
+        EXPECT_EQ(view->getFieldAs<uint64_t>(Dimension::Id::OffsetTime, i),
+            i * 10);
+}
+
+TEST(DecimationFilterTest, poisson)
+{
+    // Points are sqrt(3) apart along the diagonal, so every sixth is kept.
+    Options decimationOps;
+    decimationOps.add("mode", "poisson");
+    decimationOps.add("radius", 10);
+
+    PointTable table;
+    PointViewPtr view = thin(table, rampOptions(), decimationOps);
+    EXPECT_EQ(view->size(), 17u);
+    for (PointId i = 0; i < view->size(); ++i)
+        EXPECT_EQ(view->getFieldAs<uint64_t>(Dimension::Id::OffsetTime, i),
+            i * 6);
+}
+
+// No two kept points are within the radius and every point is within the
+// radius of a kept point.
+TEST(DecimationFilterTest, poissonRandom)
+{
+    Options readerOps;
+    readerOps.add("bounds", BOX3D(-200.0, -200.0, 0.0, 200.0, 200.0, 20.0));
+    readerOps.add("mode", "random");
+    readerOps.add("num_points", 5000);
+    readerOps.add("seed", 17);
+
+    Options decimationOps;
+    decimationOps.add("mode", "poisson");
+    decimationOps.add("radius", 15);
+    PointTable thinTable;
+    PointViewPtr view = thin(thinTable, readerOps, decimationOps);
+
+    FauxReader reader;
+    reader.setOptions(readerOps);
+    PointTable table;
+    reader.prepare(table);
+    PointViewPtr all = *reader.execute(table).begin();
+
+    const double r2 = 15.0 * 15.0;
+    EXPECT_LT(view->size(), all->size());
+    for (PointId i = 0; i < view->size(); ++i)
+        for (PointId j = i + 1; j < view->size(); ++j)
+            EXPECT_GE(distance2(*view, i, *view, j), r2);
+    for (PointId i = 0; i < all->size(); ++i)
+    {
+        bool covered = false;
+        for (PointId j = 0; !covered && j < view->size(); ++j)
+            covered = distance2(*all, i, *view, j) <= r2;
+        EXPECT_TRUE(covered);
+    }
+}
+
+// Exactly 'count' points are kept, in order, and the same ones whether the
+// points are streamed or not.
+TEST(DecimationFilterTest, random)
+{
+    Options readerOps;
+    readerOps.add("bounds", BOX3D(0.0, 0.0, 0.0, 100.0, 100.0, 100.0));
+    readerOps.add("mode", "random");
+    readerOps.add("num_points", 140000);
+    readerOps.add("seed", 11);
+
+    Options decimationOps;
+    decimationOps.add("mode", "random");
+    decimationOps.add("count", 250);
+    decimationOps.add("seed", 3);
+    PointTable t1;
+    std::vector<uint64_t> sample = ids(*thin(t1, readerOps, decimationOps));
+    EXPECT_EQ(sample.size(), 250u);
+    EXPECT_TRUE(std::is_sorted(sample.begin(), sample.end()));
+    EXPECT_TRUE(std::adjacent_find(sample.begin(), sample.end()) ==
+        sample.end());
+    // The sample spreads through the points.
+    EXPECT_LT(sample.front(), 7000u);
+    EXPECT_GT(sample.back(), 133000u);
+
+    PointTable t2;
+    EXPECT_EQ(ids(*thin(t2, readerOps, decimationOps)), sample);
+    Options otherOps(decimationOps);
+    otherOps.remove("seed");
+    otherOps.add("seed", 4);
+    PointTable t3;
+    EXPECT_NE(ids(*thin(t3, readerOps, otherOps)), sample);
+
+    for (int slots = 1; slots <= 3; slots += 2)
+    {
+        FauxReader reader;
+        reader.setOptions(readerOps);
+        DecimationFilter filter;
+        filter.setOptions(decimationOps);
+        filter.setInput(reader);
+        IdRecorder writer;
+        writer.setInput(filter);
+
+        FixedPointTable table(1000, slots);
+        writer.prepare(table);
+        EXPECT_TRUE(writer.pipelineStreamable());
+        EXPECT_EQ(writer.executeStream(table), 140000u);
+        EXPECT_EQ(writer.m_ids, sample);
+    }
+
+    // Asking for more points than there are keeps them all.
+    Options allOps;
+    allOps.add("mode", "random");
+    allOps.add("count", 1000);
+    PointTable t4;
+    EXPECT_EQ(thin(t4, rampOptions(), allOps)->size(), 100u);
+}
+
+// Each cell keeps its own number of points.
+TEST(DecimationFilterTest, stratified)
+{
+    Options decimationOps;
+    decimationOps.add("mode", "stratified");
+    decimationOps.add("cell", 25);
+    decimationOps.add("count", 3);
+
+    PointTable table;
+    PointViewPtr view = thin(table, rampOptions(), decimationOps);
+    EXPECT_EQ(view->size(), 12u);
+    std::vector<int> perCell(4);
+    for (PointId i = 0; i < view->size(); ++i)
+        perCell[(int)(view->getFieldAs<double>(Dimension::Id::X, i) / 25)]++;
+    for (int n : perCell)
+        EXPECT_EQ(n, 3);
+
+    Options readerOps;
+    readerOps.add("filename", Support::datapath("las/simple.las"));
+    LasReader reader;
+    reader.setOptions(readerOps);
+
+    Options classOps;
+    classOps.add("mode", "stratified");
+    classOps.add("strata", "classification");
+    classOps.add("count", 7);
+    DecimationFilter filter;
+    filter.setOptions(classOps);
+    filter.setInput(reader);
+
+    PointTable classTable;
+    filter.prepare(classTable);
+    PointViewSet viewSet = filter.execute(classTable);
+    PointViewPtr classes = *viewSet.begin();
+    std::map<int, int> perClass;
+    for (PointId i = 0; i < classes->size(); ++i)
+        perClass[classes->getFieldAs<int>(
+            Dimension::Id::Classification, i)]++;
+    EXPECT_EQ(perClass.size(), 2u);
+    for (auto& cp : perClass)
+        EXPECT_EQ(cp.second, 7);
+}
+
+TEST(DecimationFilterTest, badMode)
+{
+    Options decimationOps;
+    decimationOps.add("mode", "foo");
+    PointTable t1;
+    EXPECT_THROW(thin(t1, rampOptions(), decimationOps), pdal_error);
+
+    Options cellOps;
+    cellOps.add("mode", "voxel");
+    cellOps.add("cell", 0);
+    PointTable t2;
+    EXPECT_THROW(thin(t2, rampOptions(), cellOps), pdal_error);
+
+    Options countOps;
+    countOps.add("mode", "random");
+    PointTable t3;
+    EXPECT_THROW(thin(t3, rampOptions(), countOps), pdal_error);
+}
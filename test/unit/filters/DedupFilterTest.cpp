@@ -0,0 +1,174 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <DedupFilter.hpp>
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+PointViewPtr dedup(PointTableRef table, PointViewPtr view,
+    const Options& options)
+{
+    BufferReader reader;
+    reader.addView(view);
+
+    DedupFilter filter;
+    filter.setOptions(options);
+    filter.setInput(reader);
+
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    return *viewSet.begin();
+}
+
+void registerDims(PointTableRef table)
+{
+    using namespace Dimension;
+
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    table.layout()->registerDim(Id::GpsTime);
+    table.layout()->registerDim(Id::PointSourceId);
+}
+
+void addPoint(PointView& view, double x, double y, double z, double t,
+    int source)
+{
+    using namespace Dimension;
+
+    PointId idx = view.size();
+    view.setField(Id::X, idx, x);
+    view.setField(Id::Y, idx, y);
+    view.setField(Id::Z, idx, z);
+    view.setField(Id::GpsTime, idx, t);
+    view.setField(Id::PointSourceId, idx, source);
+}
+
+std::vector<int> sources(const PointView& view)
+{
+    std::vector<int> out;
+    for (PointId i = 0; i < view.size(); ++i)
+        out.push_back(view.getFieldAs<int>(Dimension::Id::PointSourceId, i));
+    return out;
+}
+
+} // unnamed namespace
+
+TEST(DedupFilterTest, exact)
+{
+    PointTable table;
+    registerDims(table);
+    PointViewPtr view(new PointView(table));
+    addPoint(*view, 1, 2, 3, 10, 1);
+    addPoint(*view, 1, 2, 3.001, 10, 2);
+    addPoint(*view, 1, 2, 3, 11, 3);
+    addPoint(*view, 0, 0, 0, 10, 4);
+    addPoint(*view, 1, 2, 3, 10, 5);
+    addPoint(*view, -0.0, 0, 0, 12, 6);
+
+    PointViewPtr out = dedup(table, view, Options());
+    EXPECT_EQ(sources(*out), std::vector<int>({ 1, 2, 4 }));
+
+    Options options;
+    options.add("gpstime", true);
+    out = dedup(table, view, options);
+    EXPECT_EQ(sources(*out), std::vector<int>({ 1, 2, 3, 4, 6 }));
+}
+
+TEST(DedupFilterTest, tolerance)
+{
+    PointTable table;
+    registerDims(table);
+    PointViewPtr view(new PointView(table));
+    addPoint(*view, 1.01, 2.02, 3.03, 10, 1);
+    addPoint(*view, 1.04, 2.01, 3.09, 10.4, 2);
+    addPoint(*view, 1.11, 2.02, 3.03, 10, 3);
+    addPoint(*view, 1.05, 2.05, 3.05, 11.2, 4);
+
+    Options options;
+    options.add("tolerance", .1);
+    PointViewPtr out = dedup(table, view, options);
+    EXPECT_EQ(sources(*out), std::vector<int>({ 1, 3 }));
+
+    options.add("gpstime", true);
+    options.add("time_tolerance", 1);
+    out = dedup(table, view, options);
+    EXPECT_EQ(sources(*out), std::vector<int>({ 1, 3, 4 }));
+}
+
+// Enough points to be split into ranges, with the second half repeating
+// the first.
+TEST(DedupFilterTest, parallel)
+{
+    PointTable table;
+    registerDims(table);
+    PointViewPtr view(new PointView(table));
+    const int count = 300000;
+    for (int i = 0; i < count; ++i)
+    {
+        int p = i % (count / 2);
+        addPoint(*view, p % 500, p / 500, p % 7, i, 0);
+    }
+
+    // Times identify the points here.
+    PointViewPtr out = dedup(table, view, Options());
+    ASSERT_EQ(out->size(), (point_count_t)count / 2);
+    for (PointId i = 0; i < out->size(); ++i)
+        EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::GpsTime, i), (int)i);
+}
+
+TEST(DedupFilterTest, badOptions)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+    PointViewPtr view(new PointView(table));
+
+    Options time;
+    time.add("gpstime", true);
+    EXPECT_THROW(dedup(table, view, time), pdal_error);
+
+    Options tolerance;
+    tolerance.add("tolerance", -1);
+    EXPECT_THROW(dedup(table, view, tolerance), pdal_error);
+}
@@ -0,0 +1,169 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/StageFactory.hpp>
+#include <ExpressionFilter.hpp>
+#include <FauxReader.hpp>
+#include <LasReader.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+TEST(ExpressionFilterTest, create)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> filter(f.createStage("filters.expression"));
+    EXPECT_TRUE(filter.get());
+}
+
+// A test passes the same points as the equivalent ranges.
+TEST(ExpressionFilterTest, test)
+{
+    Options lasOps;
+    lasOps.add("filename", Support::datapath("las/1.2-with-color.las"));
+
+    LasReader reader1;
+    reader1.setOptions(lasOps);
+    Options exprOps;
+    exprOps.add("expression",
+        "Classification == 2 && Z > 440 || Intensity < 50");
+    ExpressionFilter expr;
+    expr.setOptions(exprOps);
+    expr.setInput(reader1);
+
+    PointTable table1;
+    expr.prepare(table1);
+    PointViewSet viewSet = expr.execute(table1);
+    ASSERT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+
+    LasReader reader2;
+    reader2.setOptions(lasOps);
+    PointTable table2;
+    reader2.prepare(table2);
+    viewSet = reader2.execute(table2);
+    PointViewPtr all = *viewSet.begin();
+
+    point_count_t count = 0;
+    for (PointId i = 0; i < all->size(); ++i)
+    {
+        int c = all->getFieldAs<int>(Dimension::Id::Classification, i);
+        double z = all->getFieldAs<double>(Dimension::Id::Z, i);
+        int intensity = all->getFieldAs<int>(Dimension::Id::Intensity, i);
+        if ((c == 2 && z > 440) || intensity < 50)
+        {
+            ASSERT_LT(count, view->size());
+            EXPECT_DOUBLE_EQ(z,
+                view->getFieldAs<double>(Dimension::Id::Z, count));
+            count++;
+        }
+    }
+    EXPECT_EQ(count, view->size());
+    EXPECT_GT(count, 0u);
+    EXPECT_LT(count, all->size());
+}
+
+// Assignments set existing dimensions and add new ones, and are seen by
+// the expressions that follow.
+TEST(ExpressionFilterTest, assign)
+{
+    Options fauxOps;
+    fauxOps.add("mode", "ramp");
+    fauxOps.add("num_points", 5000);
+    fauxOps.add("bounds", BOX3D(0, 0, 0, 4999, 4999, 4999));
+    FauxReader reader;
+    reader.setOptions(fauxOps);
+
+    Options exprOps;
+    exprOps.add("expression", "Z = Z * 0.3048");
+    exprOps.add("expression", "Height = round(Z) - min(X, 100)");
+    exprOps.add("expression", "!(Height < 0)");
+    ExpressionFilter expr;
+    expr.setOptions(exprOps);
+    expr.setInput(reader);
+
+    PointTable table;
+    expr.prepare(table);
+    PointViewSet viewSet = expr.execute(table);
+    ASSERT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+
+    Dimension::Id::Enum height = table.layout()->findDim("Height");
+    ASSERT_NE(height, Dimension::Id::Unknown);
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        double x = view->getFieldAs<double>(Dimension::Id::X, i);
+        double z = view->getFieldAs<double>(Dimension::Id::Z, i);
+        EXPECT_DOUBLE_EQ(z, x * 0.3048);
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(height, i),
+            std::round(z) - (std::min)(x, 100.0));
+        EXPECT_GE(view->getFieldAs<double>(height, i), 0);
+    }
+
+    point_count_t count = 0;
+    for (int x = 0; x < 5000; ++x)
+        if (std::round(x * 0.3048) - (std::min)(x, 100) >= 0)
+            count++;
+    EXPECT_EQ(view->size(), count);
+    EXPECT_LT(count, 5000u);
+}
+
+TEST(ExpressionFilterTest, errors)
+{
+    auto prepare = [](const std::string& text)
+    {
+        Options fauxOps;
+        fauxOps.add("mode", "constant");
+        fauxOps.add("num_points", 10);
+        FauxReader reader;
+        reader.setOptions(fauxOps);
+
+        Options exprOps;
+        exprOps.add("expression", text);
+        ExpressionFilter expr;
+        expr.setOptions(exprOps);
+        expr.setInput(reader);
+        PointTable table;
+        expr.prepare(table);
+    };
+
+    EXPECT_NO_THROW(prepare("X > 3"));
+    EXPECT_THROW(prepare("X >"), pdal_error);
+    EXPECT_THROW(prepare("(X > 3"), pdal_error);
+    EXPECT_THROW(prepare("X 3"), pdal_error);
+    EXPECT_THROW(prepare("foo(X)"), pdal_error);
+    EXPECT_THROW(prepare("Nonesuch > 3"), pdal_error);
+}
@@ -106,3 +106,111 @@ TEST(FerryFilterTest, test_ferry_invalid)
     EXPECT_THROW(ferry.prepare(table), pdal_error);
 }
 
+
+namespace
+{
+
+Option ferryOption(const std::string& from, const std::string& to)
+{
+    Option dim("dimension", from, "");
+    Options dimOps;
+    dimOps.add("to", to);
+    dim.setOptions(dimOps);
+    return dim;
+}
+
+void checkCopy(BasePointTable& table)
+{
+    Options ops1;
+    ops1.add("filename", Support::datapath("las/1.2-with-color.las"));
+    LasReader reader;
+    reader.setOptions(ops1);
+
+    Options options;
+    options.add(ferryOption("Z", "Z2"));
+    options.add(ferryOption("Intensity", "Intensity2"));
+    FerryFilter ferry;
+    ferry.setInput(reader);
+    ferry.setOptions(options);
+
+    ferry.prepare(table);
+    PointViewSet viewSet = ferry.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 1065u);
+
+    PointLayoutPtr layout(table.layout());
+    Dimension::Id::Enum z2 = layout->findDim("Z2");
+    Dimension::Id::Enum intensity2 = layout->findDim("Intensity2");
+    EXPECT_EQ(layout->dimType(intensity2), Dimension::Type::Unsigned16);
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::Z, i),
+            view->getFieldAs<double>(z2, i));
+        EXPECT_EQ(view->getFieldAs<uint16_t>(Dimension::Id::Intensity, i),
+            view->getFieldAs<uint16_t>(intensity2, i));
+    }
+}
+
+} // unnamed namespace
+
+// New dimensions take the source's type and are copied in bulk.
+TEST(FerryFilterTest, copyTypes)
+{
+    PointTable table;
+    checkCopy(table);
+
+    ColumnPointTable columnTable;
+    columnTable.setBlockSize(100);
+    checkCopy(columnTable);
+}
+
+// The points of a view needn't be consecutive in the table.
+TEST(FerryFilterTest, copyField)
+{
+    ColumnPointTable table;
+    table.setBlockSize(4);
+    table.layout()->registerDim(Dimension::Id::X);
+    Dimension::Id::Enum copy =
+        table.layout()->assignDim("Copy", Dimension::Type::Double);
+    table.layout()->finalize();
+
+    PointView view(table);
+    for (PointId i = 0; i < 10; ++i)
+    {
+        view.setField(Dimension::Id::X, i, i * 1.5);
+        view.setField(copy, i, -1.0);
+    }
+
+    // The run of points 2 - 5 crosses a block.
+    PointView some(table);
+    for (PointId i = 7; i < 10; i += 2)
+        some.appendPoint(view, i);
+    for (PointId i = 2; i < 6; ++i)
+        some.appendPoint(view, i);
+    some.copyField(Dimension::Id::X, copy, 0, some.size());
+
+    for (PointId i = 0; i < 10; ++i)
+    {
+        bool copied = i == 7 || i == 9 || (i >= 2 && i < 6);
+        EXPECT_DOUBLE_EQ(copied ? i * 1.5 : -1.0,
+            view.getFieldAs<double>(copy, i));
+    }
+}
+
+TEST(FerryFilterTest, unknownDimension)
+{
+    Options ops1;
+    ops1.add("filename", Support::datapath("las/1.2-with-color.las"));
+    LasReader reader;
+    reader.setOptions(ops1);
+
+    Options options;
+    options.add(ferryOption("Foo", "Bar"));
+    FerryFilter ferry;
+    ferry.setInput(reader);
+    ferry.setOptions(options);
+
+    PointTable table;
+    EXPECT_THROW(ferry.prepare(table), pdal_error);
+}
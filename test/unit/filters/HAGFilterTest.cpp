@@ -0,0 +1,170 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <HAGFilter.hpp>
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+
+#include <array>
+
+using namespace pdal;
+
+namespace
+{
+
+// Ground points at the centers of a 20 x 20 grid of cells one apart,
+// except those in the hole, followed by points above the ground.  Returns
+// the heights above ground of the points that aren't ground.
+std::vector<double> heights(double (*ground)(double, double), int hole,
+    const std::vector<std::array<double, 3>>& points)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    table.layout()->registerDim(Id::Classification);
+
+    PointViewPtr view(new PointView(table));
+    PointId idx = 0;
+    for (int i = 0; i < 20; ++i)
+        for (int j = 0; j < 20; ++j)
+        {
+            if (i >= 10 - hole && i < 10 + hole &&
+                j >= 10 - hole && j < 10 + hole)
+                continue;
+            double x = i + .5;
+            double y = j + .5;
+            view->setField(Id::X, idx, x);
+            view->setField(Id::Y, idx, y);
+            view->setField(Id::Z, idx, ground(x, y));
+            view->setField(Id::Classification, idx++, 2);
+        }
+    PointId first = idx;
+    for (auto& p : points)
+    {
+        view->setField(Id::X, idx, p[0]);
+        view->setField(Id::Y, idx, p[1]);
+        view->setField(Id::Z, idx, p[2]);
+        view->setField(Id::Classification, idx++, 1);
+    }
+
+    BufferReader reader;
+    reader.addView(view);
+
+    HAGFilter filter;
+    filter.setInput(reader);
+
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr out = *viewSet.begin();
+
+    std::vector<double> hags;
+    for (PointId i = first; i < out->size(); ++i)
+        hags.push_back(out->getFieldAs<double>(Id::HeightAboveGround, i));
+    return hags;
+}
+
+double sloped(double x, double y)
+{
+    return 100 + .1 * x - .3 * y;
+}
+
+double flat(double, double)
+{
+    return 50;
+}
+
+} // unnamed namespace
+
+// Between the centers of the cells the ground is interpolated, which is
+// exact for a plane.
+TEST(HAGFilterTest, sloped)
+{
+    std::vector<std::array<double, 3>> points;
+    points.push_back({{ 3.2, 7.9, sloped(3.2, 7.9) + 5 }});
+    points.push_back({{ 12.5, 1.0, sloped(12.5, 1.0) + 12.25 }});
+    points.push_back({{ 19.5, 19.5, sloped(19.5, 19.5) - 1 }});
+
+    std::vector<double> hags = heights(sloped, 0, points);
+    ASSERT_EQ(hags.size(), 3u);
+    EXPECT_NEAR(hags[0], 5, 1e-9);
+    EXPECT_NEAR(hags[1], 12.25, 1e-9);
+    EXPECT_NEAR(hags[2], -1, 1e-9);
+}
+
+// Cells without ground are filled from their neighbors, and points beyond
+// the ground take the height of its edge.
+TEST(HAGFilterTest, hole)
+{
+    std::vector<std::array<double, 3>> points;
+    points.push_back({{ 10, 10, 53 }});
+    points.push_back({{ 8.7, 11.2, 60 }});
+    points.push_back({{ -5, 30, 51 }});
+
+    std::vector<double> hags = heights(flat, 3, points);
+    ASSERT_EQ(hags.size(), 3u);
+    EXPECT_NEAR(hags[0], 3, 1e-9);
+    EXPECT_NEAR(hags[1], 10, 1e-9);
+    EXPECT_NEAR(hags[2], 1, 1e-9);
+}
+
+TEST(HAGFilterTest, noGround)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    table.layout()->registerDim(Id::Classification);
+
+    PointViewPtr view(new PointView(table));
+    view->setField(Id::X, 0, 1);
+    view->setField(Id::Y, 0, 1);
+    view->setField(Id::Z, 0, 1);
+    view->setField(Id::Classification, 0, 1);
+
+    BufferReader reader;
+    reader.addView(view);
+
+    HAGFilter filter;
+    filter.setInput(reader);
+    filter.prepare(table);
+    EXPECT_THROW(filter.execute(table), pdal_error);
+}
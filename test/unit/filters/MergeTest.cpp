@@ -36,6 +36,10 @@
 
 #include <pdal/PipelineManager.hpp>
 #include <pdal/PipelineReader.hpp>
+#include <DecimationFilter.hpp>
+#include <FauxReader.hpp>
+#include <MergeFilter.hpp>
+#include <NullWriter.hpp>
 
 #include "Support.hpp"
 
@@ -54,3 +58,176 @@ TEST(MergeTest, test1)
     PointViewPtr view = *viewSet.begin();
     EXPECT_EQ(view->size(), 2130u);
 }
+
+// Views whose points are spread through the table are merged in the order
+// they were run, as are those that follow on from one another.
+TEST(MergeTest, order)
+{
+    using namespace pdal;
+
+    auto rampOptions = [](double x)
+    {
+        Options ops;
+        ops.add("mode", "ramp");
+        ops.add("num_points", 100);
+        ops.add("bounds", BOX3D(x, 0, 0, x + 99, 99, 99));
+        return ops;
+    };
+
+    FauxReader reader1;
+    reader1.setOptions(rampOptions(0));
+    FauxReader reader2;
+    reader2.setOptions(rampOptions(1000));
+    FauxReader reader3;
+    reader3.setOptions(rampOptions(2000));
+
+    Options decimationOps;
+    decimationOps.add("step", 10);
+    DecimationFilter decimation2;
+    decimation2.setOptions(decimationOps);
+    decimation2.setInput(reader2);
+
+    MergeFilter merge;
+    merge.setInput(reader1);
+    merge.setInput(decimation2);
+    merge.setInput(reader3);
+
+    PointTable table;
+    merge.prepare(table);
+    PointViewSet viewSet = merge.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 210u);
+
+    for (PointId i = 0; i < 100; ++i)
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::X, i), i);
+    for (PointId i = 0; i < 10; ++i)
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::X, 100 + i),
+            1000.0 + i * 10);
+    for (PointId i = 0; i < 100; ++i)
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::X, 110 + i),
+            2000.0 + i);
+}
+
+// Inputs sorted by a dimension are interleaved so that the output is
+// sorted by it too.  Unsorted inputs are sorted first.
+TEST(MergeTest, sorted)
+{
+    using namespace pdal;
+
+    auto rampOptions = [](double x, double step)
+    {
+        Options ops;
+        ops.add("mode", "ramp");
+        ops.add("num_points", 100);
+        ops.add("bounds", BOX3D(x, 0, 0, x + 99 * step, 99, 99));
+        return ops;
+    };
+
+    FauxReader reader1;
+    reader1.setOptions(rampOptions(0, 1));
+    FauxReader reader2;
+    reader2.setOptions(rampOptions(.5, 2));
+    Options randomOps;
+    randomOps.add("mode", "uniform");
+    randomOps.add("num_points", 100);
+    randomOps.add("bounds", BOX3D(0, 0, 0, 200, 99, 99));
+    FauxReader reader3;
+    reader3.setOptions(randomOps);
+
+    Options mergeOps;
+    mergeOps.add("sort_dimension", "X");
+    MergeFilter merge;
+    merge.setOptions(mergeOps);
+    merge.setInput(reader1);
+    merge.setInput(reader2);
+    merge.setInput(reader3);
+
+    PointTable table;
+    merge.prepare(table);
+    PointViewSet viewSet = merge.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 300u);
+
+    for (PointId i = 1; i < view->size(); ++i)
+        EXPECT_LE(view->getFieldAs<double>(Dimension::Id::X, i - 1),
+            view->getFieldAs<double>(Dimension::Id::X, i));
+}
+
+// Readers feeding a merge are streamed one after the other.
+TEST(MergeTest, stream)
+{
+    using namespace pdal;
+
+    auto uniformOptions = [](double x, int count)
+    {
+        Options ops;
+        ops.add("mode", "uniform");
+        ops.add("num_points", count);
+        ops.add("bounds", BOX3D(x, 0, 0, x + 100, 100, 100));
+        return ops;
+    };
+
+    for (int slots = 1; slots < 3; ++slots)
+    {
+        std::vector<double> xs;
+        auto record = [&xs](PointView& v, PointId idx)
+            { xs.push_back(v.getFieldAs<double>(Dimension::Id::X, idx)); };
+
+        FauxReader reader1;
+        reader1.setOptions(uniformOptions(0, 250));
+        reader1.setReadCb(record);
+        FauxReader reader2;
+        reader2.setOptions(uniformOptions(1000, 130));
+        reader2.setReadCb(record);
+
+        MergeFilter merge;
+        merge.setInput(reader1);
+        merge.setInput(reader2);
+        NullWriter writer;
+        writer.setInput(merge);
+
+        FixedPointTable table(100, slots);
+        writer.prepare(table);
+        EXPECT_TRUE(writer.pipelineStreamable());
+        EXPECT_EQ(writer.executeStream(table), 380u);
+        ASSERT_EQ(xs.size(), 380u);
+        for (size_t i = 0; i < xs.size(); ++i)
+        {
+            if (i < 250)
+                EXPECT_LT(xs[i], 1000);
+            else
+                EXPECT_GE(xs[i], 1000);
+        }
+    }
+
+    // Interleaving sorted inputs needs all of their points.
+    Options mergeOps;
+    mergeOps.add("sort_dimension", "X");
+    FauxReader reader1;
+    reader1.setOptions(uniformOptions(0, 10));
+    FauxReader reader2;
+    reader2.setOptions(uniformOptions(0, 10));
+    MergeFilter merge;
+    merge.setOptions(mergeOps);
+    merge.setInput(reader1);
+    merge.setInput(reader2);
+    FixedPointTable table(100);
+    merge.prepare(table);
+    EXPECT_FALSE(merge.pipelineStreamable());
+
+    // Only readers can be streamed into a merge.
+    Options decimationOps;
+    decimationOps.add("step", 2);
+    DecimationFilter decimation;
+    decimation.setOptions(decimationOps);
+    decimation.setInput(reader2);
+    MergeFilter merge2;
+    merge2.setInput(reader1);
+    merge2.setInput(decimation);
+    FixedPointTable table2(100);
+    merge2.prepare(table2);
+    EXPECT_FALSE(merge2.pipelineStreamable());
+    EXPECT_THROW(merge2.executeStream(table2), pdal_error);
+}
@@ -0,0 +1,166 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+#include <MortonOrderFilter.hpp>
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// Sort a shuffled 16 x 16 grid of points.
+PointViewPtr sortGrid(const std::string& order)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+
+    std::vector<int> cells(256);
+    for (int i = 0; i < 256; ++i)
+        cells[i] = i;
+    std::mt19937 generator(1);
+    std::shuffle(cells.begin(), cells.end(), generator);
+
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < cells.size(); ++i)
+    {
+        view->setField(Dimension::Id::X, i, cells[i] / 16);
+        view->setField(Dimension::Id::Y, i, cells[i] % 16);
+    }
+
+    BufferReader reader;
+    reader.addView(view);
+
+    Options options;
+    if (order.size())
+        options.add("order", order);
+    MortonOrderFilter filter;
+    filter.setOptions(options);
+    filter.setInput(reader);
+
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    return *viewSet.begin();
+}
+
+int x(PointViewPtr view, PointId idx)
+{
+    return view->getFieldAs<int>(Dimension::Id::X, idx);
+}
+
+int y(PointViewPtr view, PointId idx)
+{
+    return view->getFieldAs<int>(Dimension::Id::Y, idx);
+}
+
+} // unnamed namespace
+
+TEST(MortonOrderFilterTest, morton)
+{
+    PointViewPtr view = sortGrid("");
+    ASSERT_EQ(view->size(), 256u);
+
+    // Each run of four points is a 2 x 2 square, in Z order.
+    for (PointId i = 0; i < view->size(); i += 4)
+    {
+        int x0 = x(view, i);
+        int y0 = y(view, i);
+        EXPECT_EQ(x0 % 2, 0);
+        EXPECT_EQ(y0 % 2, 0);
+        EXPECT_EQ(x(view, i + 1), x0);
+        EXPECT_EQ(y(view, i + 1), y0 + 1);
+        EXPECT_EQ(x(view, i + 2), x0 + 1);
+        EXPECT_EQ(y(view, i + 2), y0);
+        EXPECT_EQ(x(view, i + 3), x0 + 1);
+        EXPECT_EQ(y(view, i + 3), y0 + 1);
+    }
+    EXPECT_EQ(x(view, 255), 15);
+    EXPECT_EQ(y(view, 255), 15);
+}
+
+TEST(MortonOrderFilterTest, hilbert)
+{
+    PointViewPtr view = sortGrid("hilbert");
+    ASSERT_EQ(view->size(), 256u);
+
+    // Successive points on a Hilbert curve are neighbors.
+    EXPECT_EQ(x(view, 0), 0);
+    EXPECT_EQ(y(view, 0), 0);
+    for (PointId i = 1; i < view->size(); ++i)
+    {
+        int dist = std::abs(x(view, i) - x(view, i - 1)) +
+            std::abs(y(view, i) - y(view, i - 1));
+        EXPECT_EQ(dist, 1);
+    }
+    EXPECT_EQ(x(view, 255), 15);
+    EXPECT_EQ(y(view, 255), 0);
+}
+
+TEST(MortonOrderFilterTest, lod)
+{
+    PointViewPtr view = sortGrid("lod");
+    ASSERT_EQ(view->size(), 256u);
+
+    // The first point is one of the four nearest the center and the next
+    // four are one from each quadrant.
+    EXPECT_TRUE(x(view, 0) == 7 || x(view, 0) == 8);
+    EXPECT_TRUE(y(view, 0) == 7 || y(view, 0) == 8);
+    int quadrants(0);
+    for (PointId i = 1; i < 5; ++i)
+    {
+        int q = (x(view, i) > 7 ? 2 : 0) + (y(view, i) > 7 ? 1 : 0);
+        quadrants |= 1 << q;
+    }
+    EXPECT_EQ(quadrants, 0xF);
+
+    // Every point is written once.
+    std::vector<int> seen(256);
+    for (PointId i = 0; i < view->size(); ++i)
+        ++seen[x(view, i) * 16 + y(view, i)];
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), 256);
+}
+
+TEST(MortonOrderFilterTest, badOrder)
+{
+    EXPECT_THROW(sortGrid("peano"), pdal_error);
+}
@@ -0,0 +1,160 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <NormalFilter.hpp>
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+
+#include <cmath>
+
+using namespace pdal;
+
+namespace
+{
+
+PointViewPtr runNormal(PointTableRef table, PointViewPtr view,
+    const Options& options)
+{
+    BufferReader reader;
+    reader.addView(view);
+
+    NormalFilter filter;
+    filter.setOptions(options);
+    filter.setInput(reader);
+
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    return *viewSet.begin();
+}
+
+} // unnamed namespace
+
+// Every point of a plane has the plane's normal, turned up, and no
+// curvature, whichever index finds the neighbors.
+TEST(NormalFilterTest, plane)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    PointId idx = 0;
+    for (int x = 0; x < 20; ++x)
+        for (int y = 0; y < 20; ++y)
+        {
+            view->setField(Id::X, idx, x);
+            view->setField(Id::Y, idx, y);
+            view->setField(Id::Z, idx++, 100 - .5 * x + .25 * y);
+        }
+
+    for (std::string index : { "kdtree", "grid" })
+    {
+        Options options;
+        options.add("knn", 6);
+        options.add("index", index);
+        PointViewPtr out = runNormal(table, view, options);
+        ASSERT_EQ(out->size(), 400u);
+
+        double len = std::sqrt(.5 * .5 + .25 * .25 + 1);
+        for (PointId i = 0; i < out->size(); ++i)
+        {
+            EXPECT_NEAR(out->getFieldAs<double>(Id::NormalX, i), .5 / len,
+                1e-6);
+            EXPECT_NEAR(out->getFieldAs<double>(Id::NormalY, i), -.25 / len,
+                1e-6);
+            EXPECT_NEAR(out->getFieldAs<double>(Id::NormalZ, i), 1 / len,
+                1e-6);
+            EXPECT_NEAR(out->getFieldAs<double>(Id::Curvature, i), 0, 1e-9);
+        }
+    }
+}
+
+// The normals of points on a band around a sphere point out from its
+// center, and its points are curved.
+TEST(NormalFilterTest, sphere)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    PointId idx = 0;
+    for (int i = 10; i <= 30; ++i)
+        for (int j = 0; j < 80; ++j)
+        {
+            double theta = M_PI * i / 40;
+            double phi = 2 * M_PI * j / 80;
+            view->setField(Id::X, idx, 10 * std::sin(theta) * std::cos(phi));
+            view->setField(Id::Y, idx, 10 * std::sin(theta) * std::sin(phi));
+            view->setField(Id::Z, idx++, 10 * std::cos(theta));
+        }
+
+    PointViewPtr out = runNormal(table, view, Options());
+    for (PointId i = 0; i < out->size(); ++i)
+    {
+        double x = out->getFieldAs<double>(Id::X, i) / 10;
+        double y = out->getFieldAs<double>(Id::Y, i) / 10;
+        double z = out->getFieldAs<double>(Id::Z, i) / 10;
+        double dot = x * out->getFieldAs<double>(Id::NormalX, i) +
+            y * out->getFieldAs<double>(Id::NormalY, i) +
+            z * out->getFieldAs<double>(Id::NormalZ, i);
+        EXPECT_NEAR(std::fabs(dot), 1, .01) << "Point " << i;
+        EXPECT_GE(out->getFieldAs<double>(Id::NormalZ, i), 0);
+        EXPECT_GT(out->getFieldAs<double>(Id::Curvature, i), 0);
+    }
+}
+
+TEST(NormalFilterTest, badOptions)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    PointViewPtr view(new PointView(table));
+
+    Options options;
+    options.add("knn", 2);
+    EXPECT_THROW(runNormal(table, view, options), pdal_error);
+}
@@ -0,0 +1,170 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <OutlierFilter.hpp>
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// A 20 x 20 grid of points one apart, followed by points far off it.
+// Returns the classifications after filtering.
+std::vector<int> classify(const Options& options)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    table.layout()->registerDim(Id::Classification);
+
+    PointViewPtr view(new PointView(table));
+    PointId idx = 0;
+    for (int x = 0; x < 20; ++x)
+        for (int y = 0; y < 20; ++y)
+        {
+            view->setField(Id::X, idx, x);
+            view->setField(Id::Y, idx, y);
+            view->setField(Id::Z, idx, (x + y) % 2 * .1);
+            view->setField(Id::Classification, idx++, 1);
+        }
+    double far[][3] = { { 50, 50, 0 }, { -40, 5, 3 }, { 10, 10, 30 } };
+    for (auto& p : far)
+    {
+        view->setField(Id::X, idx, p[0]);
+        view->setField(Id::Y, idx, p[1]);
+        view->setField(Id::Z, idx, p[2]);
+        view->setField(Id::Classification, idx++, 1);
+    }
+
+    BufferReader reader;
+    reader.addView(view);
+
+    OutlierFilter filter;
+    filter.setOptions(options);
+    filter.setInput(reader);
+
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr out = *viewSet.begin();
+
+    std::vector<int> classes;
+    for (PointId i = 0; i < out->size(); ++i)
+        classes.push_back(out->getFieldAs<int>(Id::Classification, i));
+    return classes;
+}
+
+void checkOutliers(const std::vector<int>& classes, int outlierClass)
+{
+    ASSERT_EQ(classes.size(), 403u);
+    for (size_t i = 0; i < 400; ++i)
+        EXPECT_EQ(classes[i], 1) << "Point " << i;
+    for (size_t i = 400; i < 403; ++i)
+        EXPECT_EQ(classes[i], outlierClass) << "Point " << i;
+}
+
+} // unnamed namespace
+
+TEST(OutlierFilterTest, statistical)
+{
+    Options options;
+    options.add("mean_k", 4);
+    options.add("multiplier", 3);
+    checkOutliers(classify(options), 7);
+}
+
+TEST(OutlierFilterTest, radius)
+{
+    Options options;
+    options.add("mode", "radius");
+    options.add("radius", 1.5);
+    options.add("min_k", 3);
+    options.add("class", 18);
+    checkOutliers(classify(options), 18);
+}
+
+// A buffer as large as the radius finds every neighbor that the whole view
+// would, so tiles give the same result.
+TEST(OutlierFilterTest, tiled)
+{
+    Options options;
+    options.add("mode", "radius");
+    options.add("radius", 1.5);
+    options.add("min_k", 3);
+    options.add("tile_size", 7);
+    checkOutliers(classify(options), 7);
+
+    Options statistical;
+    statistical.add("mean_k", 4);
+    statistical.add("multiplier", 3);
+    statistical.add("tile_size", 7);
+    statistical.add("buffer", 3);
+    checkOutliers(classify(statistical), 7);
+}
+
+TEST(OutlierFilterTest, gridIndex)
+{
+    Options options;
+    options.add("mean_k", 4);
+    options.add("multiplier", 3);
+    options.add("index", "grid");
+    checkOutliers(classify(options), 7);
+
+    options.add("tile_size", 7);
+    options.add("buffer", 3);
+    checkOutliers(classify(options), 7);
+}
+
+TEST(OutlierFilterTest, badOptions)
+{
+    Options mode;
+    mode.add("mode", "nearest");
+    EXPECT_THROW(classify(mode), pdal_error);
+
+    Options radius;
+    radius.add("mode", "radius");
+    radius.add("radius", 0);
+    EXPECT_THROW(classify(radius), pdal_error);
+
+    Options index;
+    index.add("index", "octree");
+    EXPECT_THROW(classify(index), pdal_error);
+}
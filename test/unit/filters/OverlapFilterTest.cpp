@@ -0,0 +1,126 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <OverlapFilter.hpp>
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+PointViewPtr overlap(PointTableRef table, PointViewPtr view,
+    const Options& options)
+{
+    BufferReader reader;
+    reader.addView(view);
+
+    OverlapFilter filter;
+    filter.setOptions(options);
+    filter.setInput(reader);
+
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    return *viewSet.begin();
+}
+
+} // unnamed namespace
+
+// Two strips ten cells wide overlap by four cells.  Points of the second
+// strip in the overlap are marked.
+TEST(OverlapFilterTest, strips)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    table.layout()->registerDim(Id::PointSourceId);
+    table.layout()->registerDim(Id::Classification);
+
+    PointViewPtr view(new PointView(table));
+    PointId idx = 0;
+    for (int source = 2; source > 0; --source)
+    {
+        double start = source == 1 ? .5 : 6.5;
+        for (int i = 0; i < 10; ++i)
+            for (int j = 0; j < 5; ++j)
+            {
+                view->setField(Id::X, idx, start + i);
+                view->setField(Id::Y, idx, j + .5);
+                view->setField(Id::Z, idx, 0);
+                view->setField(Id::PointSourceId, idx, source);
+                view->setField(Id::Classification, idx++, 1);
+            }
+    }
+
+    Options options;
+    options.add("class", 17);
+    PointViewPtr out = overlap(table, view, options);
+    ASSERT_EQ(out->size(), 100u);
+
+    int marked = 0;
+    for (PointId i = 0; i < out->size(); ++i)
+    {
+        int source = out->getFieldAs<int>(Id::PointSourceId, i);
+        double x = out->getFieldAs<double>(Id::X, i);
+        int expected = (source == 2 && x < 10) ? 17 : 1;
+        EXPECT_EQ(out->getFieldAs<int>(Id::Classification, i), expected) <<
+            "Point " << i;
+        if (expected == 17)
+            marked++;
+    }
+    EXPECT_EQ(marked, 20);
+}
+
+TEST(OverlapFilterTest, noSource)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    view->setField(Id::X, 0, 1);
+    view->setField(Id::Y, 0, 1);
+    view->setField(Id::Z, 0, 1);
+    EXPECT_THROW(overlap(table, view, Options()), pdal_error);
+}
@@ -308,3 +308,89 @@ TEST(RangeFilterTest, negativeValues)
     EXPECT_FLOAT_EQ(1.0, view->getFieldAs<double>(Dimension::Id::Z, 2));
 }
 
+
+namespace
+{
+
+PointViewPtr rampFilter(const std::vector<Option>& dims)
+{
+    BOX3D srcBounds(0.0, 0.0, 1.0, 0.0, 0.0, 10.0);
+
+    Options ops;
+    ops.add("bounds", srcBounds);
+    ops.add("mode", "ramp");
+    ops.add("num_points", 10);
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    Options rangeOps;
+    for (const Option& dim : dims)
+        rangeOps.add(dim);
+
+    RangeFilter filter;
+    filter.setOptions(rangeOps);
+    filter.setInput(reader);
+
+    PointTable table;
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(1u, viewSet.size());
+    return *viewSet.begin();
+}
+
+Option rangeOption(const std::string& name, double min, double max,
+    bool invert = false)
+{
+    Options range;
+    range.add("min", min);
+    range.add("max", max);
+    if (invert)
+        range.add("invert", true);
+
+    Option dim("dimension", name);
+    dim.setOptions(range);
+    return dim;
+}
+
+} // unnamed namespace
+
+// Ranges of the same dimension are OR-ed.
+TEST(RangeFilterTest, alternatives)
+{
+    PointViewPtr view = rampFilter({ rangeOption("Z", 1, 2),
+        rangeOption("Z", 8, 9) });
+
+    EXPECT_EQ(4u, view->size());
+    EXPECT_FLOAT_EQ(1.0, view->getFieldAs<double>(Dimension::Id::Z, 0));
+    EXPECT_FLOAT_EQ(2.0, view->getFieldAs<double>(Dimension::Id::Z, 1));
+    EXPECT_FLOAT_EQ(8.0, view->getFieldAs<double>(Dimension::Id::Z, 2));
+    EXPECT_FLOAT_EQ(9.0, view->getFieldAs<double>(Dimension::Id::Z, 3));
+}
+
+TEST(RangeFilterTest, invert)
+{
+    PointViewPtr view = rampFilter({ rangeOption("Z", 3, 8, true) });
+
+    EXPECT_EQ(4u, view->size());
+    EXPECT_FLOAT_EQ(1.0, view->getFieldAs<double>(Dimension::Id::Z, 0));
+    EXPECT_FLOAT_EQ(2.0, view->getFieldAs<double>(Dimension::Id::Z, 1));
+    EXPECT_FLOAT_EQ(9.0, view->getFieldAs<double>(Dimension::Id::Z, 2));
+    EXPECT_FLOAT_EQ(10.0, view->getFieldAs<double>(Dimension::Id::Z, 3));
+}
+
+// Fractional bounds on an integer dimension.
+TEST(RangeFilterTest, integer)
+{
+    PointViewPtr view = rampFilter({ rangeOption("OffsetTime", 2.5, 4.5),
+        rangeOption("Z", 0, 100) });
+
+    EXPECT_EQ(2u, view->size());
+    EXPECT_EQ(3u, view->getFieldAs<uint32_t>(Dimension::Id::OffsetTime, 0));
+    EXPECT_EQ(4u, view->getFieldAs<uint32_t>(Dimension::Id::OffsetTime, 1));
+}
+
+TEST(RangeFilterTest, unknownDimension)
+{
+    EXPECT_THROW(rampFilter({ rangeOption("Foo", 0, 1) }), pdal_error);
+}
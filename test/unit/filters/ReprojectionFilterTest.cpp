@@ -34,8 +34,14 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <cmath>
+
+#include <ogr_srs_api.h>
+
+#include <pdal/BufferReader.hpp>
 #include <pdal/SpatialReference.hpp>
 #include <LasReader.hpp>
+#include <FastTransform.hpp>
 #include <ReprojectionFilter.hpp>
 #include <pdal/PointView.hpp>
 
@@ -105,6 +111,192 @@ TEST(ReprojectionFilterTest, ReprojectionFilterTest_test_1)
 #endif
 
 
+#if defined(PDAL_HAVE_GEOS) && defined(PDAL_HAVE_GEOTIFF)
+// The fast path should give the same answer as GDAL.
+TEST(ReprojectionFilterTest, fast)
+{
+    PointTable table;
+
+    Options ops1;
+    ops1.add("filename", Support::datapath("las/utm15.las"));
+    LasReader reader;
+    reader.setOptions(ops1);
+
+    Options options;
+    options.add("out_srs", "EPSG:4326");
+    options.add("fast", true);
+
+    ReprojectionFilter reprojectionFilter;
+    reprojectionFilter.setOptions(options);
+    reprojectionFilter.setInput(reader);
+
+    reprojectionFilter.prepare(table);
+    PointViewSet viewSet = reprojectionFilter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+
+    double x, y, z;
+    getPoint(*view.get(), x, y, z);
+
+    EXPECT_FLOAT_EQ(x, -93.351563);
+    EXPECT_FLOAT_EQ(y, 41.577148);
+    EXPECT_FLOAT_EQ(z, 16.000000);
+}
+
+
+// A matrix is applied to the reprojected points.
+TEST(ReprojectionFilterTest, matrix)
+{
+    PointTable table;
+
+    Options ops1;
+    ops1.add("filename", Support::datapath("las/utm15.las"));
+    LasReader reader;
+    reader.setOptions(ops1);
+
+    Options options;
+    options.add("out_srs", "EPSG:4326");
+    options.add("matrix", "0 1 0 0\n1 0 0 0\n0 0 2 1\n0 0 0 1");
+
+    ReprojectionFilter reprojectionFilter;
+    reprojectionFilter.setOptions(options);
+    reprojectionFilter.setInput(reader);
+
+    reprojectionFilter.prepare(table);
+    PointViewSet viewSet = reprojectionFilter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+
+    double x, y, z;
+    getPoint(*view.get(), x, y, z);
+
+    EXPECT_FLOAT_EQ(x, 41.577148);
+    EXPECT_FLOAT_EQ(y, -93.351563);
+    EXPECT_FLOAT_EQ(z, 33.000000);
+}
+
+
+// Points transformed in batches on several threads come out as they did
+// when each point was transformed with its own OCTTransform call.
+TEST(ReprojectionFilterTest, batchMatchesPointwise)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDims({ Id::X, Id::Y, Id::Z });
+
+    // Several batches, the last of them partial.
+    const point_count_t count = 20000;
+    PointViewPtr input(new PointView(table));
+    for (PointId idx = 0; idx < count; ++idx)
+    {
+        input->setField(Id::X, idx, 480000 + (idx * 7919) % 40000);
+        input->setField(Id::Y, idx, 4580000 + (idx * 104729) % 40000);
+        input->setField(Id::Z, idx, (idx % 1000) * .1);
+    }
+    std::vector<double> xs(count);
+    std::vector<double> ys(count);
+    std::vector<double> zs(count);
+    input->getFieldArray(Id::X, 0, count, xs.data());
+    input->getFieldArray(Id::Y, 0, count, ys.data());
+    input->getFieldArray(Id::Z, 0, count, zs.data());
+
+    const std::string inWkt = SpatialReference("EPSG:26915").
+        getWKT(SpatialReference::eCompoundOK);
+    const std::string outWkt = SpatialReference("EPSG:4326").
+        getWKT(SpatialReference::eCompoundOK);
+
+    BufferReader reader;
+    reader.addView(input);
+
+    Options options;
+    options.add("in_srs", inWkt);
+    options.add("out_srs", outWkt);
+
+    ReprojectionFilter reprojectionFilter;
+    reprojectionFilter.setOptions(options);
+    reprojectionFilter.setInput(reader);
+
+    reprojectionFilter.prepare(table);
+    PointViewSet viewSet = reprojectionFilter.execute(table);
+    ASSERT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    ASSERT_EQ(view->size(), count);
+
+    OGRSpatialReferenceH inRef = OSRNewSpatialReference(inWkt.c_str());
+    OGRSpatialReferenceH outRef = OSRNewSpatialReference(outWkt.c_str());
+    OGRCoordinateTransformationH transform =
+        OCTNewCoordinateTransformation(inRef, outRef);
+    ASSERT_TRUE(transform);
+    for (PointId idx = 0; idx < count; ++idx)
+    {
+        ASSERT_TRUE(OCTTransform(transform, 1, &xs[idx], &ys[idx],
+            &zs[idx]));
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::X, idx), xs[idx]);
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::Y, idx), ys[idx]);
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::Z, idx), zs[idx]);
+    }
+    OCTDestroyCoordinateTransformation(transform);
+    OSRDestroySpatialReference(inRef);
+    OSRDestroySpatialReference(outRef);
+}
+#endif
+
+
+namespace
+{
+
+FastTransform::System utm(int zone)
+{
+    FastTransform::System sys;
+    sys.m_kind = FastTransform::TransverseMercator;
+    sys.m_centralMeridian = zone * 6 - 183;
+    sys.m_scale = 0.9996;
+    sys.m_falseEasting = 500000;
+    return sys;
+}
+
+void check(const FastTransform::System& from, const FastTransform::System& to,
+    double x, double y, double z, double toX, double toY, double toZ,
+    double tolerance)
+{
+    double xx = x;
+    double yy = y;
+    double zz = z;
+    FastTransform(from, to).transform(1, &xx, &yy, &zz);
+    EXPECT_NEAR(xx, toX, tolerance);
+    EXPECT_NEAR(yy, toY, tolerance);
+    EXPECT_NEAR(zz, toZ, tolerance);
+
+    FastTransform(to, from).transform(1, &xx, &yy, &zz);
+    EXPECT_NEAR(xx, x, 1e-9 + 1e-14 * std::fabs(x));
+    EXPECT_NEAR(yy, y, 1e-9 + 1e-14 * std::fabs(y));
+    EXPECT_NEAR(zz, z, 1e-6);
+}
+
+} // unnamed namespace
+
+TEST(ReprojectionFilterTest, fastTransform)
+{
+    FastTransform::System geo;
+    FastTransform::System web;
+    web.m_kind = FastTransform::WebMercator;
+    FastTransform::System ecef;
+    ecef.m_kind = FastTransform::Geocentric;
+
+    check(geo, utm(31), 3, 0, 10, 500000, 0, 10, 1e-3);
+    check(geo, utm(31), 0, 0, 0, 166021.4431, 0, 0, 1e-3);
+    check(geo, utm(13), -105, 40, 0, 500000, 4427757.2187, 0, 1e-3);
+    check(geo, web, 180, 0, 0, 20037508.342789244, 0, 0, 1e-6);
+    check(geo, ecef, 0, 0, 0, 6378137, 0, 0, 1e-6);
+    check(geo, ecef, 0, 90, 0, 0, 0, 6356752.314245, 1e-6);
+    check(geo, ecef, 45, 45, 1000, 3194919.145061, 3194919.145061,
+        4488055.515647, 1e-6);
+    check(utm(13), ecef, 500000, 4427757.2187, 0,
+        -1266325.909, -4725992.631, 4077985.572, 1e-2);
+}
+
+
 /**
  This test would pass but for the strange scaling of the dimension, which
  exceeds an integer.
@@ -110,3 +110,79 @@ TEST(SortFilterTest, pipeline)
         EXPECT_TRUE(d1 <= d2);
     }
 }
+
+namespace
+{
+
+// Sort random points by GpsTime and then by ReturnNumber and check the
+// order.  Points equal in both keep their original order.
+void doMultiSort(point_count_t count, const Options& extra)
+{
+    Options opts;
+    opts.add("dimension", "GpsTime, ReturnNumber");
+    for (const Option& o : extra.getOptions())
+        opts.add(o);
+
+    SortFilter filter;
+    filter.setOptions(opts);
+
+    PointTable table;
+    PointViewPtr view(new PointView(table));
+
+    table.layout()->registerDim(Dimension::Id::GpsTime);
+    table.layout()->registerDim(Dimension::Id::ReturnNumber);
+    table.layout()->registerDim(Dimension::Id::PointSourceId);
+
+    std::default_random_engine generator;
+    std::uniform_int_distribution<int> times(-50, 50);
+    std::uniform_int_distribution<int> returns(1, 5);
+
+    for (PointId i = 0; i < count; ++i)
+    {
+        view->setField(Dimension::Id::GpsTime, i, times(generator) / 4.0);
+        view->setField(Dimension::Id::ReturnNumber, i, returns(generator));
+        view->setField(Dimension::Id::PointSourceId, i, i);
+    }
+
+    filter.prepare(table);
+    FilterWrapper::ready(filter, table);
+    FilterWrapper::filter(filter, *view.get());
+    FilterWrapper::done(filter, table);
+
+    EXPECT_EQ(count, view->size());
+    for (PointId i = 1; i < count; ++i)
+    {
+        double t1 = view->getFieldAs<double>(Dimension::Id::GpsTime, i - 1);
+        double t2 = view->getFieldAs<double>(Dimension::Id::GpsTime, i);
+        int r1 = view->getFieldAs<int>(Dimension::Id::ReturnNumber, i - 1);
+        int r2 = view->getFieldAs<int>(Dimension::Id::ReturnNumber, i);
+        uint16_t s1 =
+            view->getFieldAs<uint16_t>(Dimension::Id::PointSourceId, i - 1);
+        uint16_t s2 =
+            view->getFieldAs<uint16_t>(Dimension::Id::PointSourceId, i);
+        ASSERT_LE(t1, t2);
+        if (t1 == t2)
+        {
+            ASSERT_LE(r1, r2);
+            if (r1 == r2)
+            {
+                ASSERT_LT(s1, s2);
+            }
+        }
+    }
+}
+
+} // unnamed namespace
+
+TEST(SortFilterTest, multiple)
+{
+    doMultiSort(20000, Options());
+}
+
+// A memory limit of a megabyte sorts 60000 points in several runs.
+TEST(SortFilterTest, external)
+{
+    Options opts;
+    opts.add("max_memory", 1);
+    doMultiSort(60000, opts);
+}
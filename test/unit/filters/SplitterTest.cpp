@@ -34,6 +34,7 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <pdal/BufferReader.hpp>
 #include <pdal/StageFactory.hpp>
 #include <pdal/StageWrapper.hpp>
 #include <LasReader.hpp>
@@ -99,3 +100,50 @@ TEST(SplitterTest, test_tile_filter)
         EXPECT_EQ(view->size(), counts[i]);
     }
 }
+
+// With an origin, cells are aligned to it rather than to the first point.
+TEST(SplitterTest, origin)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < 20; ++i)
+    {
+        view->setField(Dimension::Id::X, i, 4.5 - i * .5);
+        view->setField(Dimension::Id::Y, i, 1.0);
+    }
+
+    BufferReader r;
+    r.addView(view);
+
+    Options o;
+    o.add("length", 2);
+    o.add("origin_x", 0.0);
+    o.add("origin_y", 0.0);
+
+    SplitterFilter s;
+    s.setOptions(o);
+    s.setInput(r);
+
+    s.prepare(table);
+    PointViewSet viewSet = s.execute(table);
+
+    std::vector<PointViewPtr> views(viewSet.begin(), viewSet.end());
+    auto sorter = [](PointViewPtr p1, PointViewPtr p2)
+    {
+        return p1->calculateBounds().minx < p2->calculateBounds().minx;
+    };
+    std::sort(views.begin(), views.end(), sorter);
+
+    ASSERT_EQ(views.size(), 6u);
+    size_t counts[] = { 2, 4, 4, 4, 4, 2 };
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        BOX3D b = views[i]->calculateBounds();
+        EXPECT_EQ(views[i]->size(), counts[i]);
+        EXPECT_EQ(std::floor(b.minx / 2), std::floor(b.maxx / 2));
+        EXPECT_EQ(std::floor(b.minx / 2), (double)i - 3);
+    }
+}
@@ -180,3 +180,96 @@ TEST(StatsFilterTest, metadata)
     }
 }
 
+
+
+// Enough points that the view is summarized in parallel chunks.
+TEST(StatsFilterTest, moments)
+{
+    BOX3D bounds(0.0, 0.0, 0.0, 199999.0, 0.0, 0.0);
+    Options ops;
+    ops.add("bounds", bounds);
+    ops.add("num_points", 200000);
+    ops.add("mode", "ramp");
+
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(ops);
+
+    Options filterOps;
+    filterOps.add("dimensions", "X");
+    filterOps.add("percentiles", "0 10 50 90 100");
+    filterOps.add("histograms", "X:0:200000:4");
+    StatsFilter filter;
+    filter.setInput(*reader);
+    filter.setOptions(filterOps);
+
+    PointTable table;
+    filter.prepare(table);
+    filter.execute(table);
+
+    // X is 0 through 199999.
+    const stats::Summary& statsX = filter.getStats(Dimension::Id::X);
+    const double n = 200000;
+    EXPECT_EQ(statsX.count(), 200000u);
+    EXPECT_DOUBLE_EQ(statsX.minimum(), 0.0);
+    EXPECT_DOUBLE_EQ(statsX.maximum(), n - 1);
+    EXPECT_DOUBLE_EQ(statsX.average(), (n - 1) / 2);
+    EXPECT_NEAR(statsX.variance(), n * (n + 1) / 12, 1e-6 * n * n);
+
+    EXPECT_DOUBLE_EQ(statsX.percentile(0), 0.0);
+    EXPECT_DOUBLE_EQ(statsX.percentile(100), n - 1);
+    EXPECT_NEAR(statsX.percentile(10), n / 10, n / 100);
+    EXPECT_NEAR(statsX.percentile(50), n / 2, n / 100);
+    EXPECT_NEAR(statsX.percentile(90), n * 9 / 10, n / 100);
+    EXPECT_THROW(statsX.percentile(25), pdal_error);
+
+    const stats::Histogram& h = statsX.histogram();
+    ASSERT_EQ(h.counts().size(), 4u);
+    for (point_count_t c : h.counts())
+        EXPECT_EQ(c, 50000u);
+    EXPECT_EQ(h.underflow(), 0u);
+    EXPECT_EQ(h.overflow(), 0u);
+}
+
+
+// Summaries of parts of a stream merge to the summary of the whole.
+TEST(StatsFilterTest, merge)
+{
+    stats::Summary whole("whole");
+    stats::Summary first("first");
+    stats::Summary second("second");
+    std::vector<double> values { 4, 8, 15, 16, 23, 42, -7, 3.5 };
+
+    whole.insert(values.data(), values.size());
+    first.insert(values.data(), 3);
+    for (size_t i = 3; i < values.size(); ++i)
+        second.insert(values[i]);
+    first.merge(second);
+
+    EXPECT_EQ(first.count(), whole.count());
+    EXPECT_DOUBLE_EQ(first.minimum(), -7.0);
+    EXPECT_DOUBLE_EQ(first.maximum(), 42.0);
+    EXPECT_DOUBLE_EQ(first.average(), whole.average());
+    EXPECT_DOUBLE_EQ(first.variance(), whole.variance());
+    EXPECT_NEAR(whole.variance(), 221.4598214286, 1e-9);
+}
+
+
+TEST(StatsFilterTest, badOptions)
+{
+    StageFactory f;
+    for (std::string opt : { "percentiles", "histograms" })
+    {
+        std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+        reader->setOptions(Options());
+
+        Options filterOps;
+        filterOps.add(opt, opt == "percentiles" ? "50 101" : "X:10:0:4");
+        StatsFilter filter;
+        filter.setInput(*reader);
+        filter.setOptions(filterOps);
+
+        PointTable table;
+        EXPECT_THROW(filter.prepare(table), pdal_error);
+    }
+}
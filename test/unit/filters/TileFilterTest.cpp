@@ -0,0 +1,249 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <TileFilter.hpp>
+#include <pdal/BufferReader.hpp>
+#include <pdal/PluginManager.hpp>
+#include <pdal/PointView.hpp>
+
+#include <cmath>
+#include <set>
+#include <utility>
+
+using namespace pdal;
+
+namespace
+{
+
+// Makes a new point 0.6 along X from each point, in place of the points,
+// as smoothing filters do.
+class ShiftFilter : public Filter
+{
+public:
+    std::string getName() const
+        { return "filters.tiletestshift"; }
+    virtual bool appendParallel() const
+        { return true; }
+
+    static void *create()
+        { return new ShiftFilter; }
+    static int32_t destroy(void *p)
+        { delete (ShiftFilter *)p; return 0; }
+
+private:
+    virtual PointViewSet run(PointViewPtr view)
+    {
+        PointViewPtr out = view->makeNew();
+        out->appendRange(view->size());
+        for (PointId i = 0; i < view->size(); ++i)
+        {
+            using namespace Dimension;
+            out->setField(Id::X, i, view->getFieldAs<double>(Id::X, i) + 0.6);
+            out->setField(Id::Y, i, view->getFieldAs<double>(Id::Y, i));
+            out->setField(Id::Z, i, view->getFieldAs<double>(Id::Z, i));
+        }
+        PointViewSet viewSet;
+        viewSet.insert(out);
+        return viewSet;
+    }
+};
+
+// A 30 x 30 grid of points one apart, with Z alternating between 0 and 1,
+// followed by points far off it.
+PointViewPtr tile(PointTableRef table, const Options& options)
+{
+    using namespace Dimension;
+
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    table.layout()->registerDim(Id::Classification);
+
+    PointViewPtr view(new PointView(table));
+    PointId idx = 0;
+    for (int x = 0; x < 30; ++x)
+        for (int y = 0; y < 30; ++y)
+        {
+            view->setField(Id::X, idx, x);
+            view->setField(Id::Y, idx, y);
+            view->setField(Id::Z, idx, (x + y) % 2);
+            view->setField(Id::Classification, idx++, 1);
+        }
+    double far[][3] = { { 60, 60, 0 }, { -40, 5, 0 }, { 14.5, 14.5, 30 } };
+    for (auto& p : far)
+    {
+        view->setField(Id::X, idx, p[0]);
+        view->setField(Id::Y, idx, p[1]);
+        view->setField(Id::Z, idx, p[2]);
+        view->setField(Id::Classification, idx++, 1);
+    }
+
+    BufferReader reader;
+    reader.addView(view);
+
+    TileFilter filter;
+    filter.setOptions(options);
+    filter.setInput(reader);
+
+    filter.prepare(table);
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    return *viewSet.begin();
+}
+
+// The X and Y of each point, which are distinct.
+std::set<std::pair<double, double>> positions(const PointView& view)
+{
+    std::set<std::pair<double, double>> out;
+    for (PointId i = 0; i < view.size(); ++i)
+        out.insert(std::make_pair(
+            view.getFieldAs<double>(Dimension::Id::X, i),
+            view.getFieldAs<double>(Dimension::Id::Y, i)));
+    return out;
+}
+
+} // unnamed namespace
+
+// With a buffer as large as the radius, points near the edges of the tiles
+// see all their neighbors, so only the far points are outliers.
+TEST(TileFilterTest, outlier)
+{
+    Options outlier;
+    outlier.add("mode", "radius");
+    outlier.add("radius", 1.5);
+    outlier.add("min_k", 3);
+    Option filter("filter", "filters.outlier");
+    filter.setOptions(outlier);
+
+    Options options;
+    options.add("tile_size", 7);
+    options.add("buffer", 1.5);
+    options.add(filter);
+
+    PointTable table;
+    PointViewPtr out = tile(table, options);
+    ASSERT_EQ(out->size(), 903u);
+    EXPECT_EQ(positions(*out).size(), 903u);
+    for (PointId i = 0; i < out->size(); ++i)
+    {
+        double x = out->getFieldAs<double>(Dimension::Id::X, i);
+        bool far = x != std::floor(x) || x < 0 || x >= 30;
+        EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::Classification, i),
+            far ? 7 : 1) << "Point " << i;
+    }
+}
+
+// The range filter keeps the points with Z of 0, a checkerboard of points
+// with neighbors on their diagonals, and the two far points with it.  The
+// outlier filter then marks the far points.  No buffer copy is kept.
+TEST(TileFilterTest, chain)
+{
+    Options range;
+    range.add("min", 0);
+    range.add("max", 0.5);
+    Option dim("dimension", "Z");
+    dim.setOptions(range);
+    Options rangeOptions;
+    rangeOptions.add(dim);
+    Option rangeFilter("filter", "filters.range");
+    rangeFilter.setOptions(rangeOptions);
+
+    Options outlier;
+    outlier.add("mode", "radius");
+    outlier.add("radius", 1.5);
+    outlier.add("min_k", 1);
+    Option outlierFilter("filter", "filters.outlier");
+    outlierFilter.setOptions(outlier);
+
+    Options options;
+    options.add("tile_size", 10);
+    options.add("buffer", 1.5);
+    options.add(rangeFilter);
+    options.add(outlierFilter);
+
+    PointTable table;
+    PointViewPtr out = tile(table, options);
+    ASSERT_EQ(out->size(), 452u);
+    EXPECT_EQ(positions(*out).size(), 452u);
+    int outliers = 0;
+    for (PointId i = 0; i < out->size(); ++i)
+    {
+        EXPECT_EQ(out->getFieldAs<double>(Dimension::Id::Z, i), 0);
+        if (out->getFieldAs<int>(Dimension::Id::Classification, i) == 7)
+            outliers++;
+    }
+    EXPECT_EQ(outliers, 2);
+}
+
+// A point made from a buffer copy is kept when it lands inside the tile,
+// so each shifted point is kept once, whichever tile made it.
+TEST(TileFilterTest, newPoints)
+{
+    PF_RegisterParams rp;
+    rp.version.major = 1;
+    rp.version.minor = 0;
+    rp.createFunc = ShiftFilter::create;
+    rp.destroyFunc = ShiftFilter::destroy;
+    rp.description = "Tile test shift filter";
+    rp.pluginType = PF_PluginType_Filter;
+    PluginManager::registerObject("filters.tiletestshift", &rp);
+
+    Options options;
+    options.add("tile_size", 7);
+    options.add("buffer", 1.5);
+    options.add("filter", "filters.tiletestshift");
+
+    PointTable table;
+    PointViewPtr out = tile(table, options);
+    ASSERT_EQ(out->size(), 903u);
+    std::set<std::pair<double, double>> found = positions(*out);
+    EXPECT_EQ(found.size(), 903u);
+    for (int x = 0; x < 30; ++x)
+        for (int y = 0; y < 30; ++y)
+            EXPECT_TRUE(found.count(std::make_pair(x + 0.6, (double)y))) <<
+                x << ", " << y;
+}
+
+TEST(TileFilterTest, badOptions)
+{
+    PointTable table;
+    EXPECT_THROW(tile(table, Options()), pdal_error);
+
+    Options reader;
+    reader.add("filter", "readers.las");
+    PointTable table2;
+    EXPECT_THROW(tile(table2, reader), pdal_error);
+}
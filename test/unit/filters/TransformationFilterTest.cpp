@@ -34,6 +34,7 @@
 
 #include <pdal/pdal_test_main.hpp>
 #include <FauxReader.hpp>
+#include <FerryFilter.hpp>
 #include <TransformationFilter.hpp>
 
 #include <pdal/StageFactory.hpp>
@@ -171,4 +172,123 @@ TEST_F(TransformationFilterTest, Rotation)
 }
 
 
+// Enough points that the vector loops and the scalar remainder both run.
+TEST(TransformationMatrix, transformPoints)
+{
+    TransformationMatrix m = transformationMatrixFromString(
+        "0.5 -2 3 10\n1.5 0.25 -1 -20\n-3 4 0.125 30\n0 0 0 1");
+
+    const point_count_t count = 1023;
+    std::vector<double> x(count);
+    std::vector<double> y(count);
+    std::vector<double> z(count);
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        x[i] = i * 1.25;
+        y[i] = 1000.0 - i;
+        z[i] = i * 0.01 - 5;
+    }
+
+    std::vector<double> tx(x);
+    std::vector<double> ty(y);
+    std::vector<double> tz(z);
+    transformPoints(m, count, tx.data(), ty.data(), tz.data());
+
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        EXPECT_DOUBLE_EQ(x[i] * m[0] + y[i] * m[1] + z[i] * m[2] + m[3],
+            tx[i]);
+        EXPECT_DOUBLE_EQ(x[i] * m[4] + y[i] * m[5] + z[i] * m[6] + m[7],
+            ty[i]);
+        EXPECT_DOUBLE_EQ(x[i] * m[8] + y[i] * m[9] + z[i] * m[10] + m[11],
+            tz[i]);
+    }
+}
+
+
+TEST_F(TransformationFilterTest, Ramp)
+{
+    Options readerOpts;
+    readerOpts.add("mode", "ramp");
+    readerOpts.add("num_points", 10000);
+    readerOpts.add("bounds", BOX3D(0, 0, 0, 9999, 19998, 29997));
+    m_reader.setOptions(readerOpts);
+
+    Options filterOpts;
+    filterOpts.add("matrix", "0 1 0 0\n-1 0 0 0\n0 0 2 1\n0 0 0 1");
+    m_filter.setOptions(filterOpts);
+
+    PointTable table;
+    m_filter.prepare(table);
+    PointViewSet viewSet = m_filter.execute(table);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(10000u, view->size());
+
+    for (point_count_t i = 0; i < view->size(); ++i)
+    {
+        EXPECT_DOUBLE_EQ(2.0 * i,
+            view->getFieldAs<double>(Dimension::Id::X, i));
+        EXPECT_DOUBLE_EQ(-1.0 * i,
+            view->getFieldAs<double>(Dimension::Id::Y, i));
+        EXPECT_DOUBLE_EQ(6.0 * i + 1,
+            view->getFieldAs<double>(Dimension::Id::Z, i));
+    }
+}
+
+
+
+// A run of point-wise filters is fused, each block of points going through
+// every filter in turn.  The filters must see each point in pipeline order.
+TEST_F(TransformationFilterTest, Fused)
+{
+    Options readerOpts;
+    readerOpts.add("mode", "ramp");
+    readerOpts.add("num_points", 50000);
+    readerOpts.add("bounds", BOX3D(0, 0, 0, 49999, 49999, 49999));
+    m_reader.setOptions(readerOpts);
+
+    Options filterOpts;
+    filterOpts.add("matrix", "1 0 0 1\n0 1 0 0\n0 0 1 0\n0 0 0 1");
+    m_filter.setOptions(filterOpts);
+
+    FerryFilter ferry;
+    Option dim("dimension", "X", "");
+    Options dimOps;
+    dimOps.add("to", "X2");
+    dim.setOptions(dimOps);
+    Options ferryOpts;
+    ferryOpts.add(dim);
+    ferry.setOptions(ferryOpts);
+    ferry.setInput(m_filter);
+
+    TransformationFilter rotate;
+    Options rotateOpts;
+    rotateOpts.add("matrix", "0 1 0 0\n-1 0 0 0\n0 0 1 0\n0 0 0 1");
+    rotate.setOptions(rotateOpts);
+    rotate.setInput(ferry);
+    EXPECT_TRUE(m_filter.pointwise());
+    EXPECT_TRUE(ferry.pointwise());
+
+    PointTable table;
+    rotate.prepare(table);
+    PointViewSet viewSet = rotate.execute(table);
+    PointViewPtr view = *viewSet.begin();
+    ASSERT_EQ(50000u, view->size());
+
+    Dimension::Id::Enum x2 = table.layout()->findDim("X2");
+    for (point_count_t i = 0; i < view->size(); ++i)
+    {
+        EXPECT_DOUBLE_EQ(i + 1.0, view->getFieldAs<double>(x2, i));
+        EXPECT_DOUBLE_EQ(1.0 * i,
+            view->getFieldAs<double>(Dimension::Id::X, i));
+        EXPECT_DOUBLE_EQ(-1.0 - i,
+            view->getFieldAs<double>(Dimension::Id::Y, i));
+    }
+    for (Stage *s : std::vector<Stage *>{ &m_filter, &ferry, &rotate })
+    {
+        EXPECT_EQ(50000u, s->profile().m_pointsIn);
+        EXPECT_EQ(50000u, s->profile().m_pointsOut);
+    }
+}
+
 }
@@ -39,6 +39,8 @@
 #include <pdal/Utils.hpp>
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/ThreadPool.hpp>
+#include <BpfCompressor.hpp>
 #include <BpfReader.hpp>
 #include <BpfWriter.hpp>
 
@@ -71,10 +73,8 @@ template<typename LeftIter, typename RightIter>
         ::testing::AssertionFailure() << message;
 }
 
-void test_file_type(const std::string& filename)
+void test_file_type(const std::string& filename, PointTableRef table)
 {
-    PointTable table;
-
     Options ops;
 
     ops.add("filename", filename);
@@ -127,6 +127,13 @@ void test_file_type(const std::string& filename)
     }
 }
 
+void test_file_type(const std::string& filename)
+{
+    PointTable table;
+
+    test_file_type(filename, table);
+}
+
 void test_roundtrip(Options& writerOps)
 {
     std::string infile(
@@ -163,6 +170,51 @@ TEST(BPFTest, test_point_major)
         Support::datapath("bpf/autzen-utm-chipped-25-v3-interleaved.bpf"));
 }
 
+TEST(BPFTest, test_point_major_mapped)
+{
+    MappedPointTable table;
+
+    test_file_type(
+        Support::datapath("bpf/autzen-utm-chipped-25-v3-interleaved.bpf"),
+        table);
+    EXPECT_TRUE(table.mapped());
+}
+
+// Points set with setPointIds() are found by seeking to each.
+TEST(BPFTest, pointIds)
+{
+    std::string filename(
+        Support::datapath("bpf/autzen-utm-chipped-25-v3-interleaved.bpf"));
+    Options ops;
+    ops.add("filename", filename);
+
+    PointTable allTable;
+    BpfReader allReader;
+    allReader.setOptions(ops);
+    allReader.prepare(allTable);
+    PointViewSet viewSet = allReader.execute(allTable);
+    PointViewPtr all = *viewSet.begin();
+    const PointId last = all->size() - 1;
+
+    // Out of order, with a repeat and an index past the last point.
+    std::vector<PointId> ids { last, 506, 3, 507, 0, 3, last + 10 };
+    std::vector<PointId> expected { 0, 3, 506, 507, last };
+
+    PointTable table;
+    BpfReader reader;
+    reader.setOptions(ops);
+    reader.prepare(table);
+    ASSERT_TRUE(reader.setPointIds(ids));
+    viewSet = reader.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    ASSERT_EQ(view->size(), expected.size());
+    for (PointId i = 0; i < view->size(); ++i)
+        for (Dimension::Id::Enum dim : table.layout()->dims())
+            EXPECT_EQ(view->getFieldAs<double>(dim, i),
+                all->getFieldAs<double>(dim, expected[i]));
+}
+
 TEST(BPFTest, test_dim_major)
 {
     test_file_type(
@@ -246,6 +298,193 @@ TEST(BPFTest, roundtrip_point_compression)
     test_roundtrip(ops);
 }
 
+TEST(BPFTest, roundtrip_compression_level)
+{
+    Options ops;
+
+    ops.add("format", "DIMENSION");
+    ops.add("compression", "zlib");
+    ops.add("compression_level", 9);
+    test_roundtrip(ops);
+}
+
+TEST(BPFTest, roundtrip_delta_shuffle)
+{
+    const char *formats[] = { "POINT", "DIMENSION", "BYTE" };
+    for (const char *format : formats)
+    {
+        Options ops;
+
+        ops.add("format", format);
+        ops.add("compression", true);
+        ops.add("delta_shuffle", true);
+        test_roundtrip(ops);
+    }
+}
+
+#ifdef PDAL_HAVE_LZ4
+TEST(BPFTest, roundtrip_lz4)
+{
+    Options ops;
+
+    ops.add("format", "DIMENSION");
+    ops.add("compression", "lz4");
+    test_roundtrip(ops);
+
+    Options hcOps;
+    hcOps.add("format", "BYTE");
+    hcOps.add("compression", "lz4");
+    hcOps.add("compression_level", 9);
+    test_roundtrip(hcOps);
+}
+#endif
+
+#ifdef PDAL_HAVE_ZSTD
+TEST(BPFTest, roundtrip_zstd)
+{
+    Options ops;
+
+    ops.add("format", "POINT");
+    ops.add("compression", "zstd");
+    test_roundtrip(ops);
+}
+#endif
+
+namespace
+{
+
+// Write the autzen test file to 'outfile' with 'writerOps'.
+void write_autzen(Options writerOps, const std::string& outfile)
+{
+    Options readerOps;
+    readerOps.add("filename",
+        Support::datapath("bpf/autzen-utm-chipped-25-v3-interleaved.bpf"));
+    BpfReader reader;
+    reader.setOptions(readerOps);
+
+    writerOps.add("filename", outfile);
+    BpfWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(reader);
+
+    FileUtils::deleteFile(outfile);
+    PointTable table;
+    writer.prepare(table);
+    writer.execute(table);
+}
+
+PointViewPtr read_bpf(const std::string& filename, PointTableRef table)
+{
+    Options ops;
+    ops.add("filename", filename);
+    BpfReader reader;
+    reader.setOptions(ops);
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    return *viewSet.begin();
+}
+
+} // unnamed namespace
+
+// Each codec PDAL was built with reads back, at several levels and in each
+// format, exactly the values of the file written without compression.
+TEST(BPFTest, roundtrip_codecs)
+{
+    struct Codec
+    {
+        BpfCompression::Enum m_codec;
+        const char *m_name;
+        std::vector<int> m_levels;
+    };
+    const Codec codecs[] = {
+        { BpfCompression::Zlib, "zlib", { 0, 1, 6, 9 } },
+        { BpfCompression::Lz4, "lz4", { 0, 1, 9, 12 } },
+        { BpfCompression::Zstd, "zstd", { 1, 3, 19 } } };
+    const char *formats[] = { "POINT", "DIMENSION", "BYTE" };
+
+    const std::string plainfile(Support::temppath("plain.bpf"));
+    const std::string outfile(Support::temppath("codec.bpf"));
+    for (const char *format : formats)
+    {
+        Options plainOps;
+        plainOps.add("format", format);
+        write_autzen(plainOps, plainfile);
+        PointTable plainTable;
+        PointViewPtr plain = read_bpf(plainfile, plainTable);
+        const Dimension::IdList dims = plainTable.layout()->dims();
+
+        for (const Codec& c : codecs)
+        {
+            if (!BpfCompressor::supported(c.m_codec))
+                continue;
+            for (int level : c.m_levels)
+            {
+                Options ops;
+                ops.add("format", format);
+                ops.add("compression", c.m_name);
+                ops.add("compression_level", level);
+                write_autzen(ops, outfile);
+
+                PointTable table;
+                PointViewPtr view = read_bpf(outfile, table);
+                ASSERT_EQ(view->size(), plain->size()) << format << " " <<
+                    c.m_name << " " << level;
+                for (PointId idx = 0; idx < view->size(); ++idx)
+                    for (Dimension::Id::Enum dim : dims)
+                        ASSERT_EQ(view->getFieldAs<double>(dim, idx),
+                            plain->getFieldAs<double>(dim, idx)) <<
+                            format << " " << c.m_name << " " << level <<
+                            " point " << idx << " " << Dimension::name(dim);
+            }
+        }
+    }
+    FileUtils::deleteFile(plainfile);
+    FileUtils::deleteFile(outfile);
+}
+
+// The deflated test files were written before blocks were inflated on the
+// thread pool.  Read with one worker or several, they hold the same values
+// as the uncompressed files.
+TEST(BPFTest, deflate_matches_plain)
+{
+    const char *names[][2] = {
+        { "autzen-utm-chipped-25-v3-deflate-interleaved.bpf",
+          "autzen-utm-chipped-25-v3-interleaved.bpf" },
+        { "autzen-utm-chipped-25-v3-deflate.bpf",
+          "autzen-utm-chipped-25-v3.bpf" },
+        { "autzen-utm-chipped-25-v3-deflate-segregated.bpf",
+          "autzen-utm-chipped-25-v3-segregated.bpf" } };
+
+    ThreadPool& pool = ThreadPool::shared();
+    const std::size_t active = pool.size();
+    for (auto& name : names)
+    {
+        PointTable plainTable;
+        PointViewPtr plain =
+            read_bpf(Support::datapath(std::string("bpf/") + name[1]),
+            plainTable);
+        const Dimension::IdList dims = plainTable.layout()->dims();
+
+        for (std::size_t threads : { (std::size_t)1, active })
+        {
+            pool.setActive(threads);
+            PointTable table;
+            PointViewPtr view =
+                read_bpf(Support::datapath(std::string("bpf/") + name[0]),
+                table);
+            pool.setActive(active);
+
+            ASSERT_EQ(view->size(), plain->size()) << name[0];
+            for (PointId idx = 0; idx < view->size(); ++idx)
+                for (Dimension::Id::Enum dim : dims)
+                    ASSERT_EQ(view->getFieldAs<double>(dim, idx),
+                        plain->getFieldAs<double>(dim, idx)) << name[0] <<
+                        " threads " << threads << " point " << idx << " " <<
+                        Dimension::name(dim);
+        }
+    }
+}
+
 TEST(BPFTest, roundtrip_scaling)
 {
     Options ops;
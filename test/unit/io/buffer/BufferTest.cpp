@@ -37,6 +37,7 @@
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
 #include <pdal/BufferReader.hpp>
+#include <pdal/StaticPipeline.hpp>
 #include <StatsFilter.hpp>
 
 using namespace pdal;
@@ -94,4 +95,78 @@ TEST(ViewTest, test_basic)
     EXPECT_FLOAT_EQ(zSummary.average(), -9.5);
 }
 
+// Points held in the caller's arrays are read and moved in place.
+TEST(ViewTest, external)
+{
+    struct Record
+    {
+        float m_z;
+        uint16_t m_intensity;
+    };
+
+    const point_count_t count = 131072;
+    std::vector<double> xs(count);
+    std::vector<double> ys(count);
+    std::vector<Record> records(count);
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        xs[i] = i;
+        ys[i] = 2.0 * i;
+        records[i].m_z = -0.5f * i;
+        records[i].m_intensity = i % 1000;
+    }
+
+    ExternalPointTable table(count);
+    table.addArray(Dimension::Id::X, Dimension::Type::Double, xs.data());
+    table.addArray(Dimension::Id::Y, Dimension::Type::Double, ys.data());
+    table.addArray(Dimension::Id::Z, Dimension::Type::Float,
+        &records[0].m_z, sizeof(Record));
+    table.addArray(Dimension::Id::Intensity, Dimension::Type::Unsigned16,
+        &records[0].m_intensity, sizeof(Record));
+    table.layout()->registerDim(Dimension::Id::Classification);
+
+    BufferReader r;
+    r.addExternal(table);
+
+    std::array<double, 16> m = {{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 1,
+        0, 0, 0, 1 }};
+    StaticPipeline<pointwise::Transform> shift((pointwise::Transform(m)));
+    shift.setInput(r);
+
+    StatsFilter s;
+    s.setInput(shift);
+
+    s.prepare(table);
+    PointViewSet viewSet = s.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), count);
+
+    EXPECT_EQ(xs[10], 10);
+    EXPECT_FLOAT_EQ(records[10].m_z, -4);
+    EXPECT_FLOAT_EQ(s.getStats(Dimension::Id::Intensity).maximum(), 999);
+    EXPECT_FLOAT_EQ(s.getStats(Dimension::Id::Y).maximum(),
+        2.0 * (count - 1));
+
+    std::vector<double> out(count);
+    view->getFieldArray(Dimension::Id::X, 0, count, out.data());
+    EXPECT_TRUE(out == xs);
+
+    // Only the dimension without an array takes memory.
+    EXPECT_EQ(table.storageBytes(), count);
+    view->setField(Dimension::Id::Classification, 7, 2);
+    EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Classification, 7), 2);
+
+    // Points added later are kept by the table.
+    view->setField(Dimension::Id::X, count, -3.0);
+    EXPECT_EQ(view->size(), count + 1);
+    EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::X, count), -3.0);
+    EXPECT_EQ(xs.size(), count);
+
+    ExternalPointTable late(1);
+    late.layout()->finalize();
+    EXPECT_THROW(late.addArray(Dimension::Id::X, Dimension::Type::Double,
+        xs.data()), pdal_error);
+}
+
 }
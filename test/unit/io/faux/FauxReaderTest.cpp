@@ -36,6 +36,8 @@
 
 #include <FauxReader.hpp>
 
+#include <algorithm>
+
 using namespace pdal;
 
 TEST(FauxReaderTest, test_constant_mode_sequential_iter)
@@ -214,3 +216,218 @@ TEST(FauxReaderTest, test_return_number)
         EXPECT_EQ(numberOfReturns, 9);
     }
 }
+
+
+namespace
+{
+
+PointViewSet readFaux(Options ops, PointTableRef table)
+{
+    std::shared_ptr<FauxReader> reader(new FauxReader);
+    reader->setOptions(ops);
+    reader->prepare(table);
+    return reader->execute(table);
+}
+
+} // unnamed namespace
+
+
+TEST(FauxReaderTest, seed)
+{
+    Options ops;
+    ops.add("bounds", BOX3D(0, 0, 0, 100, 100, 100));
+    ops.add("count", 500);
+    ops.add("mode", "terrain");
+    ops.add("seed", 1234);
+    ops.add("time_order", "shuffled");
+
+    PointTable table1;
+    PointViewPtr view1 = *readFaux(ops, table1).begin();
+    PointTable table2;
+    PointViewPtr view2 = *readFaux(ops, table2).begin();
+    ASSERT_EQ(view1->size(), 500u);
+    ASSERT_EQ(view2->size(), 500u);
+    for (PointId i = 0; i < view1->size(); ++i)
+    {
+        for (auto dim : { Dimension::Id::X, Dimension::Id::Y,
+            Dimension::Id::Z, Dimension::Id::OffsetTime })
+            EXPECT_EQ(view1->getFieldAs<double>(dim, i),
+                view2->getFieldAs<double>(dim, i));
+    }
+
+    ops.remove("seed");
+    ops.add("seed", 4321);
+    PointTable table3;
+    PointViewPtr view3 = *readFaux(ops, table3).begin();
+    int same = 0;
+    for (PointId i = 0; i < view1->size(); ++i)
+        if (view1->getFieldAs<double>(Dimension::Id::X, i) ==
+            view3->getFieldAs<double>(Dimension::Id::X, i))
+            same++;
+    EXPECT_LT(same, 5);
+}
+
+
+TEST(FauxReaderTest, terrain)
+{
+    Options ops;
+    ops.add("bounds", BOX3D(1.0, 2.0, 3.0, 101.0, 102.0, 103.0));
+    ops.add("count", 2000);
+    ops.add("mode", "terrain");
+    ops.add("clusters", 3);
+    ops.add("seed", 1);
+
+    PointTable table;
+    PointViewPtr view = *readFaux(ops, table).begin();
+    ASSERT_EQ(view->size(), 2000u);
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        double x = view->getFieldAs<double>(Dimension::Id::X, i);
+        double y = view->getFieldAs<double>(Dimension::Id::Y, i);
+        double z = view->getFieldAs<double>(Dimension::Id::Z, i);
+        EXPECT_GE(x, 1.0);
+        EXPECT_LE(x, 101.0);
+        EXPECT_GE(y, 2.0);
+        EXPECT_LE(y, 102.0);
+        EXPECT_GE(z, 3.0);
+        EXPECT_LE(z, 103.0);
+    }
+}
+
+
+TEST(FauxReaderTest, shuffledTime)
+{
+    Options ops;
+    ops.add("count", 1000);
+    ops.add("mode", "constant");
+    ops.add("time_order", "shuffled");
+
+    PointTable table;
+    PointViewPtr view = *readFaux(ops, table).begin();
+    ASSERT_EQ(view->size(), 1000u);
+
+    std::vector<uint64_t> times;
+    bool sorted = true;
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        times.push_back(
+            view->getFieldAs<uint64_t>(Dimension::Id::OffsetTime, i));
+        if (times.back() != i)
+            sorted = false;
+    }
+    EXPECT_FALSE(sorted);
+    std::sort(times.begin(), times.end());
+    for (PointId i = 0; i < times.size(); ++i)
+        EXPECT_EQ(times[i], i);
+
+    ops.remove("time_order");
+    ops.add("time_order", "backwards");
+    PointTable table2;
+    EXPECT_THROW(readFaux(ops, table2), pdal_error);
+}
+
+
+TEST(FauxReaderTest, extraDims)
+{
+    Options ops;
+    ops.add("count", 1000);
+    ops.add("mode", "uniform");
+    ops.add("extra_dims", "Intensity=uint16, Foo=int8, Bar = float");
+
+    PointTable table;
+    PointViewPtr view = *readFaux(ops, table).begin();
+    ASSERT_EQ(view->size(), 1000u);
+
+    PointLayoutPtr layout(table.layout());
+    Dimension::Id::Enum foo = layout->findDim("Foo");
+    Dimension::Id::Enum bar = layout->findDim("Bar");
+    ASSERT_NE(foo, Dimension::Id::Unknown);
+    ASSERT_NE(bar, Dimension::Id::Unknown);
+    EXPECT_EQ(layout->dimType(Dimension::Id::Intensity),
+        Dimension::Type::Unsigned16);
+    EXPECT_EQ(layout->dimType(foo), Dimension::Type::Signed8);
+    EXPECT_EQ(layout->dimType(bar), Dimension::Type::Float);
+
+    bool negative = false;
+    bool large = false;
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        if (view->getFieldAs<int>(foo, i) < 0)
+            negative = true;
+        if (view->getFieldAs<int>(Dimension::Id::Intensity, i) > 255)
+            large = true;
+        float f = view->getFieldAs<float>(bar, i);
+        EXPECT_GE(f, 0.0f);
+        EXPECT_LE(f, 1.0f);
+    }
+    EXPECT_TRUE(negative);
+    EXPECT_TRUE(large);
+
+    ops.remove("extra_dims");
+    ops.add("extra_dims", "Foo=complex");
+    PointTable table2;
+    EXPECT_THROW(readFaux(ops, table2), pdal_error);
+}
+
+
+TEST(FauxReaderTest, numViews)
+{
+    Options ops;
+    ops.add("count", 1001);
+    ops.add("mode", "constant");
+    ops.add("num_views", 4);
+
+    PointTable table;
+    PointViewSet viewSet = readFaux(ops, table);
+    ASSERT_EQ(viewSet.size(), 4u);
+
+    std::vector<uint64_t> times;
+    for (PointViewPtr view : viewSet)
+    {
+        EXPECT_GE(view->size(), 250u);
+        EXPECT_LE(view->size(), 251u);
+        for (PointId i = 0; i < view->size(); ++i)
+            times.push_back(
+                view->getFieldAs<uint64_t>(Dimension::Id::OffsetTime, i));
+    }
+    ASSERT_EQ(times.size(), 1001u);
+    std::sort(times.begin(), times.end());
+    for (PointId i = 0; i < times.size(); ++i)
+        EXPECT_EQ(times[i], i);
+}
+
+
+TEST(FauxReaderTest, stream)
+{
+    Options ops;
+    ops.add("bounds", BOX3D(0, 0, 0, 100, 100, 100));
+    ops.add("count", 1000);
+    ops.add("mode", "uniform");
+    ops.add("seed", 1234);
+
+    PointTable table;
+    PointViewPtr view = *readFaux(ops, table).begin();
+    ASSERT_EQ(view->size(), 1000u);
+
+    // Streamed in chunks, the same points are generated in the same order.
+    std::vector<double> xs;
+    FauxReader reader;
+    reader.setOptions(ops);
+    reader.setReadCb([&xs](PointView& v, PointId idx)
+        { xs.push_back(v.getFieldAs<double>(Dimension::Id::X, idx)); });
+    FixedPointTable streamTable(100);
+    reader.prepare(streamTable);
+    EXPECT_TRUE(reader.pipelineStreamable());
+    EXPECT_EQ(reader.executeStream(streamTable), 1000u);
+    ASSERT_EQ(xs.size(), 1000u);
+    for (PointId i = 0; i < view->size(); ++i)
+        EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::X, i), xs[i]);
+
+    ops.remove("mode");
+    ops.add("mode", "ramp");
+    FauxReader ramp;
+    ramp.setOptions(ops);
+    FixedPointTable rampTable(100);
+    ramp.prepare(rampTable);
+    EXPECT_FALSE(ramp.pipelineStreamable());
+}
@@ -0,0 +1,231 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <GDALWriter.hpp>
+#include <LasReader.hpp>
+
+#include <gdal.h>
+
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+// Values of a band of a raster, row by row from the north.
+std::vector<double> readBand(const std::string& filename, int bandNum,
+    int& width, int& height)
+{
+    std::vector<double> data;
+    GDALDatasetH ds = GDALOpen(filename.c_str(), GA_ReadOnly);
+    EXPECT_TRUE(ds != NULL);
+    if (!ds)
+        return data;
+    width = GDALGetRasterXSize(ds);
+    height = GDALGetRasterYSize(ds);
+    data.resize(width * height);
+    GDALRasterBandH band = GDALGetRasterBand(ds, bandNum);
+    EXPECT_EQ(GDALRasterIO(band, GF_Read, 0, 0, width, height, data.data(),
+        width, height, GDT_Float64, 0, 0), CE_None);
+    GDALClose(ds);
+    return data;
+}
+
+} // unnamed namespace
+
+TEST(GDALWriterTest, grid)
+{
+    std::string outfile(Support::temppath("grid.tif"));
+    FileUtils::deleteFile(outfile);
+
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    auto add = [&view](double x, double y, double z)
+    {
+        PointId idx = view->size();
+        view->setField(Dimension::Id::X, idx, x);
+        view->setField(Dimension::Id::Y, idx, y);
+        view->setField(Dimension::Id::Z, idx, z);
+    };
+    add(0, 0, 1);
+    add(0.1, 0, 3);
+    add(2, 1, 5);
+    // Outside the bounds.
+    add(5, 5, 100);
+
+    BufferReader reader;
+    reader.addView(view);
+
+    Options ops;
+    ops.add("filename", outfile);
+    ops.add("resolution", 1);
+    ops.add("radius", .5);
+    ops.add("output_type", "min,max,mean,count");
+    ops.add("bounds", "([0, 2], [0, 1])");
+    GDALWriter writer;
+    writer.setOptions(ops);
+    writer.setInput(reader);
+    writer.prepare(table);
+    writer.execute(table);
+
+    int width, height;
+    std::vector<double> min = readBand(outfile, 1, width, height);
+    ASSERT_EQ(width, 3);
+    ASSERT_EQ(height, 2);
+    std::vector<double> max = readBand(outfile, 2, width, height);
+    std::vector<double> mean = readBand(outfile, 3, width, height);
+    std::vector<double> count = readBand(outfile, 4, width, height);
+
+    // Row 1 is the southern row.
+    EXPECT_DOUBLE_EQ(min[3], 1);
+    EXPECT_DOUBLE_EQ(max[3], 3);
+    EXPECT_DOUBLE_EQ(mean[3], 2);
+    EXPECT_DOUBLE_EQ(count[3], 2);
+    EXPECT_DOUBLE_EQ(count[2], 1);
+    EXPECT_DOUBLE_EQ(mean[2], 5);
+    EXPECT_DOUBLE_EQ(count[0], -9999);
+    EXPECT_DOUBLE_EQ(count[4], -9999);
+    FileUtils::deleteFile(outfile);
+}
+
+// With a radius of 0 each point is counted once, in the cell that
+// contains it.
+TEST(GDALWriterTest, bin)
+{
+    std::string outfile(Support::temppath("bingrid.tif"));
+    FileUtils::deleteFile(outfile);
+
+    Options readerOps;
+    readerOps.add("filename", Support::datapath("las/1.2-with-color.las"));
+    LasReader reader;
+    reader.setOptions(readerOps);
+
+    Options ops;
+    ops.add("filename", outfile);
+    ops.add("resolution", 10);
+    ops.add("radius", 0);
+    ops.add("output_type", "count");
+    ops.add("nodata", 0);
+    GDALWriter writer;
+    writer.setOptions(ops);
+    writer.setInput(reader);
+    FixedPointTable table(100);
+    writer.prepare(table);
+    EXPECT_EQ(writer.executeStream(table), 1065u);
+
+    int width, height;
+    std::vector<double> count = readBand(outfile, 1, width, height);
+    double total = 0;
+    for (double c : count)
+        total += c;
+    EXPECT_DOUBLE_EQ(total, 1065);
+    FileUtils::deleteFile(outfile);
+}
+
+// A streamed raster matches one written from a whole view.
+TEST(GDALWriterTest, stream)
+{
+    std::string infile(Support::datapath("las/1.2-with-color.las"));
+    std::string outfile(Support::temppath("grid.tif"));
+    std::string streamfile(Support::temppath("streamgrid.tif"));
+    FileUtils::deleteFile(outfile);
+    FileUtils::deleteFile(streamfile);
+
+    Options readerOps;
+    readerOps.add("filename", infile);
+    Options writerOps;
+    writerOps.add("resolution", 10);
+    writerOps.add("output_type", "count,mean,stdev");
+
+    {
+        LasReader reader;
+        reader.setOptions(readerOps);
+        Options ops(writerOps);
+        ops.add("filename", outfile);
+        GDALWriter writer;
+        writer.setOptions(ops);
+        writer.setInput(reader);
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+
+    {
+        LasReader reader;
+        reader.setOptions(readerOps);
+        Options ops(writerOps);
+        ops.add("filename", streamfile);
+        GDALWriter writer;
+        writer.setOptions(ops);
+        writer.setInput(reader);
+        FixedPointTable table(100);
+        writer.prepare(table);
+        EXPECT_TRUE(writer.pipelineStreamable());
+        EXPECT_EQ(writer.executeStream(table), 1065u);
+    }
+
+    // Bands are mean, count and stdev.
+    for (int band = 1; band <= 3; ++band)
+    {
+        int width, height, streamWidth, streamHeight;
+        std::vector<double> whole = readBand(outfile, band, width, height);
+        std::vector<double> streamed =
+            readBand(streamfile, band, streamWidth, streamHeight);
+        ASSERT_EQ(width, streamWidth);
+        ASSERT_EQ(height, streamHeight);
+        double total = 0;
+        for (size_t i = 0; i < whole.size(); ++i)
+        {
+            EXPECT_NEAR(whole[i], streamed[i], 1e-6);
+            if (band == 2 && whole[i] > 0)
+                total += whole[i];
+        }
+        if (band == 2)
+        {
+            EXPECT_GE(total, 1065);
+        }
+    }
+    FileUtils::deleteFile(outfile);
+    FileUtils::deleteFile(streamfile);
+}
@@ -34,9 +34,16 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <fstream>
+
+#include <pdal/BufferReader.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <FauxReader.hpp>
+#include <LasIndex.hpp>
 #include <LasReader.hpp>
+#include <LasWriter.hpp>
 #include "Support.hpp"
 
 using namespace pdal;
@@ -268,6 +275,145 @@ TEST(LasReaderTest, inspect)
     std::sort(qi.m_dimNames.begin(), qi.m_dimNames.end());
     EXPECT_TRUE(CheckEqualCollections(qi.m_dimNames.begin(),
         qi.m_dimNames.end(), std::begin(dims)));
+
+    MetadataNode m = qi.m_metadata;
+    EXPECT_EQ(m.findChild("dataformat_id").value<uint32_t>(), 0u);
+    EXPECT_EQ(m.findChild("count").value<uint32_t>(), 5380u);
+    point_count_t returns = 0;
+    for (auto& n : m.children("count_by_return"))
+        returns += n.value<point_count_t>();
+    EXPECT_EQ(returns, 5380u);
+}
+
+// Only the requested dimensions (and X, Y and Z) are registered and read.
+TEST(LasReaderTest, dimensions)
+{
+    auto read = [](const std::string& dims, PointTable& table)
+    {
+        Options ops;
+        ops.add("filename", Support::datapath("las/1.2-with-color.las"));
+        if (dims.size())
+            ops.add("dimensions", dims);
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        return *viewSet.begin();
+    };
+
+    PointTable allTable;
+    PointViewPtr all = read("", allTable);
+
+    PointTable table;
+    PointViewPtr view = read("classification, Red", table);
+    EXPECT_EQ(table.layout()->dims().size(), 5u);
+    EXPECT_TRUE(table.layout()->hasDim(Dimension::Id::Classification));
+    EXPECT_TRUE(table.layout()->hasDim(Dimension::Id::Red));
+    EXPECT_FALSE(table.layout()->hasDim(Dimension::Id::Intensity));
+    EXPECT_FALSE(table.layout()->hasDim(Dimension::Id::Green));
+
+    ASSERT_EQ(view->size(), all->size());
+    for (PointId idx = 0; idx < view->size(); ++idx)
+    {
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::Y, idx),
+            all->getFieldAs<double>(Dimension::Id::Y, idx));
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Classification, idx),
+            all->getFieldAs<int>(Dimension::Id::Classification, idx));
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Red, idx),
+            all->getFieldAs<int>(Dimension::Id::Red, idx));
+    }
+
+    PointTable badTable;
+    EXPECT_THROW(read("Classification, Foo", badTable), pdal_error);
+}
+
+
+// The data of an EVLR that isn't needed is skipped rather than read.
+TEST(LasReaderTest, largeEvlr)
+{
+    std::string infile(Support::datapath("las/1.2-with-color.las"));
+    std::string outfile(Support::temppath("evlr.las"));
+    FileUtils::deleteFile(outfile);
+
+    std::vector<uint8_t> blob(200000);
+    for (size_t i = 0; i < blob.size(); ++i)
+        blob[i] = (uint8_t)i;
+    Option vlr("vlr", Utils::base64_encode(blob));
+    Options vlrOps;
+    vlrOps.add("record_id", 42);
+    vlrOps.add("user_id", "PDAL");
+    vlr.setOptions(vlrOps);
+
+    {
+        Options readerOps;
+        readerOps.add("filename", infile);
+        LasReader reader;
+        reader.setOptions(readerOps);
+
+        Options writerOps;
+        writerOps.add("filename", outfile);
+        writerOps.add("minor_version", 4);
+        writerOps.add(vlr);
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(reader);
+
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+
+    auto readFile = [](const std::string& filename)
+    {
+        Options ops;
+        ops.add("filename", filename);
+        LasReader reader;
+        reader.setOptions(ops);
+        PointTable table;
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(reader.header().eVlrCount(), 1u);
+        return *viewSet.begin();
+    };
+
+    Options ops;
+    ops.add("filename", infile);
+    LasReader reader;
+    reader.setOptions(ops);
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    PointViewPtr expected = *viewSet.begin();
+
+    PointViewPtr view = readFile(outfile);
+    ASSERT_EQ(view->size(), expected->size());
+    for (PointId idx = 0; idx < view->size(); idx += 100)
+    {
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::X, idx),
+            expected->getFieldAs<double>(Dimension::Id::X, idx));
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Red, idx),
+            expected->getFieldAs<int>(Dimension::Id::Red, idx));
+    }
+    FileUtils::deleteFile(outfile);
+}
+
+
+// The dimensions and extra bytes schema of a preview come from the VLRs.
+TEST(LasReaderTest, inspectExtraBytes)
+{
+    Options ops;
+    ops.add("filename", Support::datapath("las/extrabytes.las"));
+
+    LasReader reader;
+    reader.setOptions(ops);
+    QuickInfo qi = reader.preview();
+    EXPECT_EQ(qi.m_dimNames.size(), 24u);
+
+    std::vector<std::string> names;
+    for (auto& n : qi.m_metadata.children("extra_dims"))
+        names.push_back(n.findChild("name").value());
+    EXPECT_NE(std::find(names.begin(), names.end(), "Colors0"), names.end());
+    EXPECT_NE(std::find(names.begin(), names.end(), "Flags1"), names.end());
 }
 
 //ABELL - Find another way to do this.
@@ -371,6 +517,119 @@ TEST(LasReaderTest, extraBytes)
     }
 }
 
+TEST(LasReaderTest, mapped)
+{
+    auto test = [](const std::string& filename)
+    {
+        Options readOps;
+        readOps.add("filename", Support::datapath(filename));
+
+        PointTable table;
+        LasReader reader;
+        reader.setOptions(readOps);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        PointViewPtr view = *viewSet.begin();
+
+        MappedPointTable mapTable;
+        LasReader mapReader;
+        mapReader.setOptions(readOps);
+        mapReader.prepare(mapTable);
+        viewSet = mapReader.execute(mapTable);
+        PointViewPtr mapView = *viewSet.begin();
+
+        EXPECT_TRUE(mapTable.mapped());
+        EXPECT_TRUE(mapTable.isMapped(Dimension::Id::X));
+        ASSERT_EQ(view->size(), mapView->size());
+
+        // Some dimensions, like ScanChannel of LAS 1.4 files with older
+        // point formats, are registered but never read.
+        Dimension::IdList dims;
+        for (auto id : table.layout()->dims())
+            if (mapTable.isMapped(id))
+                dims.push_back(id);
+        EXPECT_GE(dims.size(), 12u);
+        for (PointId idx = 0; idx < view->size(); ++idx)
+            for (auto di = dims.begin(); di != dims.end(); ++di)
+                EXPECT_EQ(view->getFieldAs<double>(*di, idx),
+                    mapView->getFieldAs<double>(*di, idx));
+
+        EXPECT_THROW(mapView->setField(Dimension::Id::X, 0, 1.0),
+            pdal_error);
+    };
+
+    test("las/simple.las");
+    test("las/1.2-with-color.las");
+    test("las/permutations/1.2_0.las");
+    test("las/permutations/1.2_1.las");
+    test("las/extrabytes.las");
+}
+
+
+TEST(LasReaderTest, mappedSideTable)
+{
+    Options readOps;
+    readOps.add("filename", Support::datapath("las/simple.las"));
+
+    MappedPointTable table;
+    table.layout()->registerDim(Dimension::Id::Amplitude,
+        Dimension::Type::Double);
+    LasReader reader;
+    reader.setOptions(readOps);
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    EXPECT_FALSE(table.isMapped(Dimension::Id::Amplitude));
+    for (PointId idx = 0; idx < view->size(); ++idx)
+        EXPECT_EQ(view->getFieldAs<double>(
+            Dimension::Id::Amplitude, idx), 0.0);
+
+    for (PointId idx = 0; idx < view->size(); ++idx)
+        view->setField(Dimension::Id::Amplitude, idx,
+            view->getFieldAs<double>(Dimension::Id::Z, idx) - 400);
+    for (PointId idx = 0; idx < view->size(); ++idx)
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(
+            Dimension::Id::Amplitude, idx),
+            view->getFieldAs<double>(Dimension::Id::Z, idx) - 400);
+}
+
+
+TEST(LasReaderTest, compactXyz)
+{
+    Options readOps;
+    readOps.add("filename", Support::datapath("las/1.2-with-color.las"));
+
+    PointTable table;
+    LasReader reader;
+    reader.setOptions(readOps);
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    readOps.add("compact_xyz", true);
+    PointTable compactTable;
+    LasReader compactReader;
+    compactReader.setOptions(readOps);
+    compactReader.prepare(compactTable);
+    viewSet = compactReader.execute(compactTable);
+    PointViewPtr compactView = *viewSet.begin();
+
+    EXPECT_EQ(compactTable.layout()->pointSize() + 12,
+        table.layout()->pointSize());
+    ASSERT_EQ(view->size(), compactView->size());
+    for (PointId idx = 0; idx < view->size(); ++idx)
+    {
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::X, idx),
+            compactView->getFieldAs<double>(Dimension::Id::X, idx));
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::Y, idx),
+            compactView->getFieldAs<double>(Dimension::Id::Y, idx));
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::Z, idx),
+            compactView->getFieldAs<double>(Dimension::Id::Z, idx));
+    }
+}
+
+
 TEST(LasReaderTest, callback)
 {
     PointTable table;
@@ -392,3 +651,501 @@ TEST(LasReaderTest, callback)
     EXPECT_EQ(count, (point_count_t)1065);
 }
 
+namespace
+{
+
+point_count_t countBounded(const std::string& filename, const BOX3D& bounds)
+{
+    Options ops;
+    ops.add("filename", filename);
+    ops.add("bounds", bounds);
+    LasReader reader;
+    reader.setOptions(ops);
+
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    PointViewPtr view = *viewSet.begin();
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        double x = view->getFieldAs<double>(Dimension::Id::X, i);
+        double y = view->getFieldAs<double>(Dimension::Id::Y, i);
+        EXPECT_TRUE(x >= bounds.minx && x <= bounds.maxx);
+        EXPECT_TRUE(y >= bounds.miny && y <= bounds.maxy);
+    }
+    return view->size();
+}
+
+} // unnamed namespace
+
+TEST(LasReaderTest, bounds)
+{
+    std::string filename(Support::temppath("bounds.las"));
+    std::string indexname(LasIndex::filename(filename));
+    FileUtils::deleteFile(filename);
+    FileUtils::deleteFile(indexname);
+    {
+        std::ifstream in(Support::datapath("las/simple.las"),
+            std::ios::binary);
+        std::ofstream out(filename, std::ios::binary);
+        out << in.rdbuf();
+    }
+
+    // Count the points in the lower left of the file by hand.
+    Options ops;
+    ops.add("filename", filename);
+    LasReader reader;
+    reader.setOptions(ops);
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    BOX3D all = reader.header().getBounds();
+    BOX3D bounds(all.minx, all.miny, all.minx + (all.maxx - all.minx) / 3,
+        all.miny + (all.maxy - all.miny) / 2);
+    point_count_t expected = 0;
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        double x = view->getFieldAs<double>(Dimension::Id::X, i);
+        double y = view->getFieldAs<double>(Dimension::Id::Y, i);
+        if (x >= bounds.minx && x <= bounds.maxx &&
+            y >= bounds.miny && y <= bounds.maxy)
+            expected++;
+    }
+    EXPECT_GT(expected, 0u);
+    EXPECT_LT(expected, view->size());
+
+    // Without an index the whole file is scanned.
+    EXPECT_EQ(countBounded(filename, bounds), expected);
+
+    LasIndex index;
+    index.setup(all, 10);
+    for (PointId i = 0; i < view->size(); ++i)
+        index.addPoint(i, view->getFieldAs<double>(Dimension::Id::X, i),
+            view->getFieldAs<double>(Dimension::Id::Y, i));
+    index.complete(50);
+    {
+        std::ofstream out(indexname, std::ios::binary);
+        index.write(out);
+    }
+
+    // The index must survive a round trip.
+    LasIndex copy;
+    {
+        std::ifstream in(indexname, std::ios::binary);
+        copy.read(in);
+    }
+    EXPECT_EQ(copy.cellCount(), index.cellCount());
+    EXPECT_EQ(copy.intervals(bounds), index.intervals(bounds));
+
+    point_count_t indexed = 0;
+    for (auto& i : index.intervals(bounds))
+        indexed += i.second - i.first;
+    EXPECT_LT(indexed, view->size());
+
+    EXPECT_EQ(countBounded(filename, bounds), expected);
+
+    FileUtils::deleteFile(filename);
+    FileUtils::deleteFile(indexname);
+}
+
+TEST(LasReaderTest, stride)
+{
+    auto readView = [](Options ops)
+    {
+        ops.add("filename", Support::datapath("las/simple.las"));
+        LasReader reader;
+        reader.setOptions(ops);
+        PointTable table;
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        return *viewSet.begin();
+    };
+
+    PointViewPtr all = readView(Options());
+
+    // Strides both near and far apart, so points are picked out of a block
+    // as well as read one at a time.
+    for (point_count_t stride : { 7, 1000 })
+    {
+        Options ops;
+        ops.add("start", 3);
+        ops.add("stride", stride);
+        PointViewPtr view = readView(ops);
+        ASSERT_EQ(view->size(), (all->size() - 3 + stride - 1) / stride);
+        for (PointId i = 0; i < view->size(); ++i)
+        {
+            PointId j = 3 + i * stride;
+            EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::X, i),
+                all->getFieldAs<double>(Dimension::Id::X, j));
+            EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::GpsTime, i),
+                all->getFieldAs<double>(Dimension::Id::GpsTime, j));
+        }
+    }
+
+    Options ops;
+    ops.add("start", 1000);
+    ops.add("count", 10);
+    PointViewPtr view = readView(ops);
+    ASSERT_EQ(view->size(), 10u);
+    EXPECT_EQ(view->getFieldAs<double>(Dimension::Id::X, 0),
+        all->getFieldAs<double>(Dimension::Id::X, 1000));
+
+    Options bad;
+    bad.add("stride", 0);
+    EXPECT_THROW(readView(bad), pdal_error);
+}
+
+// Points decoded a field at a time from blocks of records match those
+// decoded a record at a time, which is what a read with bounds does.
+TEST(LasReaderTest, blockMatchesPoint)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDims({ Id::X, Id::Y, Id::Z, Id::Intensity,
+        Id::ReturnNumber, Id::NumberOfReturns, Id::ScanDirectionFlag,
+        Id::EdgeOfFlightLine, Id::Classification, Id::ScanAngleRank,
+        Id::UserData, Id::PointSourceId, Id::GpsTime, Id::Red, Id::Green,
+        Id::Blue, Id::ScanChannel, Id::Infrared });
+    Id::Enum extra = table.layout()->registerOrAssignDim("Extra",
+        Type::Unsigned16);
+
+    // Several blocks of records, the last of them partial.
+    const point_count_t count = 60000;
+    PointViewPtr view(new PointView(table));
+    for (PointId idx = 0; idx < count; ++idx)
+    {
+        view->setField(Id::X, idx, (int)((idx * 7919) % 200000) - 100000);
+        view->setField(Id::Y, idx, (idx * 104729) % 100000 * .01);
+        view->setField(Id::Z, idx, (idx % 1000) * .01);
+        view->setField(Id::Intensity, idx, (idx * 31) % 65536);
+        view->setField(Id::ReturnNumber, idx, idx % 5 + 1);
+        view->setField(Id::NumberOfReturns, idx, 5);
+        view->setField(Id::ScanDirectionFlag, idx, idx % 2);
+        view->setField(Id::EdgeOfFlightLine, idx, (idx / 2) % 2);
+        view->setField(Id::Classification, idx, idx % 32);
+        view->setField(Id::ScanAngleRank, idx, (int)(idx % 181) - 90);
+        view->setField(Id::UserData, idx, idx % 256);
+        view->setField(Id::PointSourceId, idx, idx / 1000);
+        view->setField(Id::GpsTime, idx, idx * .001);
+        view->setField(Id::Red, idx, idx % 65536);
+        view->setField(Id::Green, idx, (idx * 3) % 65536);
+        view->setField(Id::Blue, idx, (idx * 5) % 65536);
+        view->setField(Id::ScanChannel, idx, idx % 4);
+        view->setField(Id::Infrared, idx, (idx * 7) % 65536);
+        view->setField(extra, idx, (idx * 11) % 65536);
+    }
+
+    const std::string filename(Support::temppath("block_point.las"));
+    auto read = [&filename](Options ops)
+    {
+        ops.add("filename", filename);
+        LasReader reader;
+        reader.setOptions(ops);
+        PointTable table;
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        return *viewSet.begin();
+    };
+
+    for (int format : { 0, 1, 2, 3, 6, 7, 8 })
+    {
+        FileUtils::deleteFile(filename);
+        {
+            BufferReader bufferReader;
+            bufferReader.addView(view);
+
+            Options writerOps;
+            writerOps.add("filename", filename);
+            writerOps.add("format", format);
+            writerOps.add("minor_version", format >= 6 ? 4 : 2);
+            writerOps.add("extra_dims", "Extra=uint16");
+            LasWriter writer;
+            writer.setOptions(writerOps);
+            writer.setInput(bufferReader);
+            writer.prepare(table);
+            writer.execute(table);
+        }
+
+        PointViewPtr block = read(Options());
+        Options boundsOps;
+        boundsOps.add("bounds", BOX3D(-1e6, -1e6, -1e6, 1e6, 1e6, 1e6));
+        PointViewPtr point = read(boundsOps);
+
+        ASSERT_EQ(block->size(), count) << "format " << format;
+        ASSERT_EQ(point->size(), count) << "format " << format;
+        const PointLayoutPtr layout = block->table().layout();
+        for (Dimension::Id::Enum dim : layout->dims())
+            for (PointId idx = 0; idx < count; ++idx)
+                ASSERT_EQ(block->getFieldAs<double>(dim, idx),
+                    point->getFieldAs<double>(dim, idx)) << "format " <<
+                    format << " point " << idx << " " <<
+                    layout->dimName(dim);
+
+        // Check a few fields against what was written, so that both paths
+        // can't be wrong the same way.
+        for (PointId idx = 0; idx < count; idx += 997)
+        {
+            EXPECT_DOUBLE_EQ(block->getFieldAs<double>(Id::X, idx),
+                view->getFieldAs<double>(Id::X, idx));
+            EXPECT_EQ(block->getFieldAs<int>(Id::ReturnNumber, idx),
+                view->getFieldAs<int>(Id::ReturnNumber, idx));
+            EXPECT_EQ(block->getFieldAs<int>(Id::Classification, idx),
+                view->getFieldAs<int>(Id::Classification, idx));
+            EXPECT_EQ(block->getFieldAs<int>(
+                layout->findDim("Extra"), idx),
+                view->getFieldAs<int>(extra, idx));
+        }
+    }
+    FileUtils::deleteFile(filename);
+}
+
+namespace
+{
+
+// Read the points with 'ids' from 'filename' with setPointIds() and check
+// them against those read from the whole file.
+void checkPointIds(const std::string& filename,
+    const std::vector<PointId>& ids, const std::vector<PointId>& expected)
+{
+    Options ops;
+    ops.add("filename", filename);
+
+    PointTable allTable;
+    LasReader allReader;
+    allReader.setOptions(ops);
+    allReader.prepare(allTable);
+    PointViewSet viewSet = allReader.execute(allTable);
+    PointViewPtr all = *viewSet.begin();
+
+    PointTable table;
+    LasReader reader;
+    reader.setOptions(ops);
+    reader.prepare(table);
+    ASSERT_TRUE(reader.setPointIds(ids));
+    viewSet = reader.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    ASSERT_EQ(view->size(), expected.size());
+    for (PointId i = 0; i < view->size(); ++i)
+        for (Dimension::Id::Enum dim : table.layout()->dims())
+            EXPECT_EQ(view->getFieldAs<double>(dim, i),
+                all->getFieldAs<double>(dim, expected[i]));
+}
+
+} // unnamed namespace
+
+// Points set with setPointIds() are read in ascending order, once each.
+TEST(LasReaderTest, pointIds)
+{
+    std::vector<PointId> ids { 1064, 500, 3, 501, 0, 3, 5000 };
+    std::vector<PointId> expected { 0, 3, 500, 501, 1064 };
+    checkPointIds(Support::datapath("las/simple.las"), ids, expected);
+}
+
+#if defined(PDAL_HAVE_LASZIP) || defined(PDAL_HAVE_LAZPERF)
+// Compressed points in other chunks are reached by seeking to the chunk.
+TEST(LasReaderTest, compressedPointIds)
+{
+    const point_count_t numPoints = 180000;
+    std::string filename(Support::temppath("point_ids.laz"));
+    FileUtils::deleteFile(filename);
+
+    {
+        Options fauxOps;
+        fauxOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+        fauxOps.add("num_points", numPoints);
+        fauxOps.add("mode", "ramp");
+        FauxReader faux;
+        faux.setOptions(fauxOps);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        writerOps.add("compression", true);
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(faux);
+
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+
+    // Points in the same chunk and in later chunks, given out of order.
+    std::vector<PointId> ids { 170001, 5, 50001, 49999, 100000, 6, 5 };
+    std::vector<PointId> expected { 5, 6, 49999, 50001, 100000, 170001 };
+    checkPointIds(filename, ids, expected);
+    FileUtils::deleteFile(filename);
+}
+#endif
+
+// Enough points to fill several read buffers, so that blocks are read
+// ahead of those being decoded.
+// Several files are read as one, with the dimensions of all of them.
+TEST(LasReaderTest, filenames)
+{
+    std::vector<std::string> filenames;
+    for (int i = 0; i < 3; ++i)
+    {
+        std::string filename(Support::temppath("multi_" +
+            std::to_string(i) + ".las"));
+        FileUtils::deleteFile(filename);
+        filenames.push_back(filename);
+
+        Options fauxOps;
+        double min = 100.0 * i;
+        fauxOps.add("bounds", BOX3D(min, min, 0, min + 50, min + 50, 50));
+        fauxOps.add("num_points", 100 * (i + 1));
+        fauxOps.add("mode", "ramp");
+        FauxReader faux;
+        faux.setOptions(fauxOps);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        // Only the last file has color.
+        writerOps.add("format", i == 2 ? 3 : 1);
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(faux);
+
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+
+    auto read = [](Options ops, PointTable& table)
+    {
+        ops.add("filenames", Support::temppath("multi_?.las"));
+        LasReader reader;
+        reader.setOptions(ops);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        return *viewSet.begin();
+    };
+
+    PointTable table;
+    PointViewPtr view = read(Options(), table);
+    EXPECT_TRUE(table.layout()->hasDim(Dimension::Id::Red));
+    ASSERT_EQ(view->size(), 600u);
+    EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::X, 0), 0, .01);
+    EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::X, 99), 50, .01);
+    EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::X, 100), 100, .01);
+    EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::X, 599), 250, .01);
+    EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Red, 0), 0);
+
+    // Files outside the bounds aren't read.
+    Options boundsOps;
+    boundsOps.add("bounds", BOX3D(90, 90, 0, 160, 160, 50));
+    PointTable boundsTable;
+    view = read(boundsOps, boundsTable);
+    EXPECT_FALSE(boundsTable.layout()->hasDim(Dimension::Id::Red));
+    ASSERT_EQ(view->size(), 200u);
+    for (PointId i = 0; i < view->size(); ++i)
+        EXPECT_GE(view->getFieldAs<double>(Dimension::Id::X, i), 100);
+
+    for (auto& filename : filenames)
+        FileUtils::deleteFile(filename);
+}
+
+
+TEST(LasReaderTest, readAhead)
+{
+    const point_count_t numPoints = 150000;
+    std::string filename(Support::temppath("read_ahead.las"));
+    FileUtils::deleteFile(filename);
+
+    {
+        Options fauxOps;
+        fauxOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+        fauxOps.add("num_points", numPoints);
+        fauxOps.add("mode", "ramp");
+        FauxReader faux;
+        faux.setOptions(fauxOps);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(faux);
+
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+
+    Options ops;
+    ops.add("filename", filename);
+    LasReader reader;
+    reader.setOptions(ops);
+
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    PointViewPtr view = *viewSet.begin();
+    ASSERT_EQ(view->size(), numPoints);
+
+    const double delta = 1000.0 / (numPoints - 1);
+    for (PointId i = 0; i < view->size(); i += 997)
+        EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::Y, i),
+            i * delta, .01);
+    EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::Y, numPoints - 1),
+        1000.0, .01);
+    FileUtils::deleteFile(filename);
+}
+
+#ifdef PDAL_HAVE_LASZIP
+// Enough points for several LASzip chunks, so that they can be decompressed
+// on more than one thread.
+TEST(LasReaderTest, parallelUnzip)
+{
+    const point_count_t numPoints = 180000;
+    std::string filename(Support::temppath("parallel_unzip.laz"));
+    FileUtils::deleteFile(filename);
+
+    {
+        Options fauxOps;
+        fauxOps.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+        fauxOps.add("num_points", numPoints);
+        fauxOps.add("mode", "ramp");
+        FauxReader faux;
+        faux.setOptions(fauxOps);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        writerOps.add("compression", true);
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(faux);
+
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+
+    Options ops;
+    ops.add("filename", filename);
+    LasReader reader;
+    reader.setOptions(ops);
+
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    ASSERT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    ASSERT_EQ(view->size(), numPoints);
+
+    // Ramp mode steps each coordinate by the same amount from point to
+    // point, so points from each chunk must land in order.
+    const double delta = 1000.0 / (numPoints - 1);
+    for (PointId i = 0; i < view->size(); i += 997)
+    {
+        EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::X, i),
+            i * delta, .01);
+        EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::Z, i),
+            i * delta, .01);
+    }
+    FileUtils::deleteFile(filename);
+}
+#endif
@@ -36,13 +36,17 @@
 
 #include <stdlib.h>
 
+#include <pdal/util/Extractor.hpp>
 #include <pdal/util/FileUtils.hpp>
+#include <pdal/util/IStream.hpp>
 #include <LasHeader.hpp>
 #include <LasReader.hpp>
 #include <LasWriter.hpp>
 
+#include <pdal/BufferReader.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/StageWrapper.hpp>
+#include <pdal/ThreadPool.hpp>
 
 #include "Support.hpp"
 
@@ -111,6 +115,681 @@ TEST(LasWriterTest, auto_offset)
     FileUtils::deleteFile(FILENAME);
 }
 
+// Writing a file in two parts, the second appended to the first, must
+// give the same points and header summary as the input.
+TEST(LasWriterTest, append)
+{
+    std::string infile(Support::datapath("las/simple.las"));
+    std::string outfile(Support::temppath("append.las"));
+    FileUtils::deleteFile(outfile);
+
+    auto writePart = [&](Options readerOps, Options writerOps)
+    {
+        readerOps.add("filename", infile);
+        LasReader reader;
+        reader.setOptions(readerOps);
+
+        writerOps.add("filename", outfile);
+        writerOps.add("format", 3);
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(reader);
+
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    };
+
+    Options firstOps;
+    firstOps.add("count", 400);
+    writePart(firstOps, Options());
+
+    Options restOps;
+    restOps.add("start", 400);
+    Options appendOps;
+    appendOps.add("append", true);
+    writePart(restOps, appendOps);
+
+    // A different point format can't be appended.
+    Options badOps;
+    badOps.add("append", true);
+    badOps.add("format", 1);
+    {
+        Options readerOps;
+        readerOps.add("filename", infile);
+        LasReader reader;
+        reader.setOptions(readerOps);
+        badOps.add("filename", outfile);
+        LasWriter writer;
+        writer.setOptions(badOps);
+        writer.setInput(reader);
+        PointTable table;
+        writer.prepare(table);
+        EXPECT_THROW(writer.execute(table), pdal_error);
+    }
+
+    auto readAll = [](const std::string& filename, LasHeader& header)
+    {
+        Options ops;
+        ops.add("filename", filename);
+        LasReader reader;
+        reader.setOptions(ops);
+        PointTable table;
+        reader.prepare(table);
+        header = reader.header();
+        PointViewSet viewSet = reader.execute(table);
+        return *viewSet.begin();
+    };
+    LasHeader inHeader;
+    LasHeader outHeader;
+    PointViewPtr in = readAll(infile, inHeader);
+    PointViewPtr out = readAll(outfile, outHeader);
+
+    // The summary must cover the points of both parts.
+    BOX3D bounds;
+    std::vector<uint64_t> returns(inHeader.maxReturnCount());
+    for (PointId i = 0; i < in->size(); ++i)
+    {
+        bounds.grow(in->getFieldAs<double>(Dimension::Id::X, i),
+            in->getFieldAs<double>(Dimension::Id::Y, i),
+            in->getFieldAs<double>(Dimension::Id::Z, i));
+        returns[in->getFieldAs<int>(Dimension::Id::ReturnNumber, i) - 1]++;
+    }
+    EXPECT_EQ(outHeader.pointCount(), inHeader.pointCount());
+    EXPECT_EQ(outHeader.getBounds(), bounds);
+    for (size_t i = 0; i < returns.size(); ++i)
+        EXPECT_EQ(outHeader.pointCountByReturn(i), returns[i]);
+
+    ASSERT_EQ(out->size(), in->size());
+    for (PointId i = 0; i < in->size(); i += 7)
+    {
+        EXPECT_DOUBLE_EQ(out->getFieldAs<double>(Dimension::Id::X, i),
+            in->getFieldAs<double>(Dimension::Id::X, i));
+        EXPECT_DOUBLE_EQ(out->getFieldAs<double>(Dimension::Id::GpsTime, i),
+            in->getFieldAs<double>(Dimension::Id::GpsTime, i));
+    }
+    FileUtils::deleteFile(outfile);
+}
+
+// A '#' in the filename writes a file for each view, split into files of
+// no more than 'shard_points' points.
+TEST(LasWriterTest, shard)
+{
+    std::string infile(Support::datapath("las/1.2-with-color.las"));
+    std::string outfile(Support::temppath("shard_#.las"));
+    auto shardFile = [](int shard)
+        { return Support::temppath("shard_" + std::to_string(shard) +
+            ".las"); };
+
+    Options readerOps;
+    readerOps.add("filename", infile);
+    PointTable table;
+    LasReader reader;
+    reader.setOptions(readerOps);
+    reader.prepare(table);
+    PointViewPtr in = *reader.execute(table).begin();
+    ASSERT_EQ(in->size(), 1065u);
+
+    // Two views, as written by the splitter.
+    BufferReader bufReader;
+    bufReader.addView(in->makeSubset(0, 900));
+    bufReader.addView(in->makeSubset(900, in->size()));
+
+    Options writerOps;
+    writerOps.add("filename", outfile);
+    writerOps.add("shard_points", 400);
+    LasWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(bufReader);
+    writer.prepare(table);
+    EXPECT_FALSE(writer.streamable());
+    writer.execute(table);
+
+    PointId base = 0;
+    std::vector<point_count_t> counts { 400, 400, 100, 165 };
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        Options ops;
+        ops.add("filename", shardFile(i + 1));
+        PointTable outTable;
+        LasReader outReader;
+        outReader.setOptions(ops);
+        outReader.prepare(outTable);
+        EXPECT_EQ(outReader.header().pointCount(), counts[i]);
+        PointViewPtr out = *outReader.execute(outTable).begin();
+        ASSERT_EQ(out->size(), counts[i]);
+        for (PointId idx = 0; idx < out->size(); idx += 11)
+        {
+            EXPECT_DOUBLE_EQ(out->getFieldAs<double>(Dimension::Id::X, idx),
+                in->getFieldAs<double>(Dimension::Id::X, base + idx));
+            EXPECT_EQ(out->getFieldAs<uint16_t>(Dimension::Id::Red, idx),
+                in->getFieldAs<uint16_t>(Dimension::Id::Red, base + idx));
+        }
+        base += counts[i];
+        FileUtils::deleteFile(shardFile(i + 1));
+    }
+    EXPECT_FALSE(FileUtils::fileExists(shardFile(counts.size() + 1)));
+
+    // Limits need somewhere to put the number of the file.
+    Options badOps;
+    badOps.add("filename", Support::temppath("shard.las"));
+    badOps.add("shard_bytes", 10000);
+    LasWriter badWriter;
+    badWriter.setOptions(badOps);
+    badWriter.setInput(bufReader);
+    EXPECT_THROW(badWriter.prepare(table), pdal_error);
+}
+
+TEST(LasWriterTest, stream)
+{
+    std::string infile(Support::datapath("las/1.2-with-color.las"));
+    std::string outfile(Support::temppath("streamed.las"));
+    FileUtils::deleteFile(outfile);
+
+    Options readerOps;
+    readerOps.add("filename", infile);
+    LasReader reader;
+    reader.setOptions(readerOps);
+
+    Options writerOps;
+    writerOps.add("filename", outfile);
+    LasWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(reader);
+
+    FixedPointTable streamTable(100);
+    writer.prepare(streamTable);
+    EXPECT_TRUE(writer.pipelineStreamable());
+    EXPECT_EQ(writer.executeStream(streamTable), 1065u);
+
+    PointTable inTable;
+    LasReader inReader;
+    inReader.setOptions(readerOps);
+    inReader.prepare(inTable);
+    PointViewPtr inView = *inReader.execute(inTable).begin();
+
+    Options outOps;
+    outOps.add("filename", outfile);
+    PointTable outTable;
+    LasReader outReader;
+    outReader.setOptions(outOps);
+    outReader.prepare(outTable);
+    EXPECT_EQ(outReader.header().pointCount(), 1065u);
+    PointViewPtr outView = *outReader.execute(outTable).begin();
+
+    ASSERT_EQ(inView->size(), outView->size());
+    for (PointId idx = 0; idx < inView->size(); ++idx)
+    {
+        using namespace Dimension;
+
+        EXPECT_DOUBLE_EQ(inView->getFieldAs<double>(Id::X, idx),
+            outView->getFieldAs<double>(Id::X, idx));
+        EXPECT_DOUBLE_EQ(inView->getFieldAs<double>(Id::Y, idx),
+            outView->getFieldAs<double>(Id::Y, idx));
+        EXPECT_DOUBLE_EQ(inView->getFieldAs<double>(Id::Z, idx),
+            outView->getFieldAs<double>(Id::Z, idx));
+        EXPECT_EQ(inView->getFieldAs<uint16_t>(Id::Intensity, idx),
+            outView->getFieldAs<uint16_t>(Id::Intensity, idx));
+        EXPECT_EQ(inView->getFieldAs<uint16_t>(Id::Red, idx),
+            outView->getFieldAs<uint16_t>(Id::Red, idx));
+    }
+
+    // Auto offsets depend on all the points written.
+    writerOps.add("offset_x", "auto");
+    LasWriter autoWriter;
+    autoWriter.setOptions(writerOps);
+    autoWriter.setInput(reader);
+    FixedPointTable autoTable(100);
+    autoWriter.prepare(autoTable);
+    EXPECT_FALSE(autoWriter.pipelineStreamable());
+    EXPECT_THROW(autoWriter.executeStream(autoTable), pdal_error);
+}
+
+
+// With several chunk slots the reader runs ahead of the writer on its own
+// thread.  The points must still be written in order.
+TEST(LasWriterTest, streamPipelined)
+{
+    std::string infile(Support::datapath("las/1.2-with-color.las"));
+    std::string outfile(Support::temppath("streamed.las"));
+    FileUtils::deleteFile(outfile);
+
+    Options readerOps;
+    readerOps.add("filename", infile);
+    LasReader reader;
+    reader.setOptions(readerOps);
+
+    Options writerOps;
+    writerOps.add("filename", outfile);
+    LasWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(reader);
+
+    FixedPointTable streamTable(50, 3);
+    EXPECT_EQ(streamTable.slots(), 3);
+    writer.prepare(streamTable);
+    EXPECT_EQ(writer.executeStream(streamTable), 1065u);
+
+    PointTable inTable;
+    LasReader inReader;
+    inReader.setOptions(readerOps);
+    inReader.prepare(inTable);
+    PointViewPtr inView = *inReader.execute(inTable).begin();
+
+    Options outOps;
+    outOps.add("filename", outfile);
+    PointTable outTable;
+    LasReader outReader;
+    outReader.setOptions(outOps);
+    outReader.prepare(outTable);
+    EXPECT_EQ(outReader.header().pointCount(), 1065u);
+    PointViewPtr outView = *outReader.execute(outTable).begin();
+
+    ASSERT_EQ(inView->size(), outView->size());
+    for (PointId idx = 0; idx < inView->size(); ++idx)
+    {
+        using namespace Dimension;
+
+        EXPECT_DOUBLE_EQ(inView->getFieldAs<double>(Id::X, idx),
+            outView->getFieldAs<double>(Id::X, idx));
+        EXPECT_DOUBLE_EQ(inView->getFieldAs<double>(Id::Y, idx),
+            outView->getFieldAs<double>(Id::Y, idx));
+        EXPECT_EQ(inView->getFieldAs<uint16_t>(Id::Intensity, idx),
+            outView->getFieldAs<uint16_t>(Id::Intensity, idx));
+    }
+}
+
+
+// Points whose return number is too high for the format are dropped
+// without leaving holes, and fields with no dimension get their defaults.
+TEST(LasWriterTest, discardHighReturns)
+{
+    std::string outfile(Support::temppath("discard.las"));
+    FileUtils::deleteFile(outfile);
+
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+    table.layout()->registerDim(Dimension::Id::ReturnNumber);
+    table.layout()->registerDim(Dimension::Id::NumberOfReturns);
+
+    // Ten pulses of seven returns each.
+    PointViewPtr view(new PointView(table));
+    for (PointId idx = 0; idx < 70; ++idx)
+    {
+        view->setField(Dimension::Id::X, idx, (double)idx);
+        view->setField(Dimension::Id::Y, idx, 2.0 * idx);
+        view->setField(Dimension::Id::Z, idx, 3.0 * idx);
+        view->setField(Dimension::Id::ReturnNumber, idx, idx % 7 + 1);
+        view->setField(Dimension::Id::NumberOfReturns, idx, 7);
+    }
+
+    BufferReader bufferReader;
+    bufferReader.addView(view);
+
+    Options writerOps;
+    writerOps.add("filename", outfile);
+    writerOps.add("discard_high_return_numbers", true);
+    LasWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(bufferReader);
+    writer.prepare(table);
+    writer.execute(table);
+
+    Options readerOps;
+    readerOps.add("filename", outfile);
+    LasReader reader;
+    reader.setOptions(readerOps);
+    PointTable readTable;
+    reader.prepare(readTable);
+    PointViewSet viewSet = reader.execute(readTable);
+    PointViewPtr out = *viewSet.begin();
+
+    ASSERT_EQ(out->size(), 50u);
+    EXPECT_EQ(reader.getNumPoints(), 50u);
+    for (PointId idx = 0; idx < out->size(); ++idx)
+    {
+        PointId orig = (idx / 5) * 7 + idx % 5;
+        EXPECT_DOUBLE_EQ(out->getFieldAs<double>(Dimension::Id::X, idx),
+            (double)orig);
+        EXPECT_DOUBLE_EQ(out->getFieldAs<double>(Dimension::Id::Z, idx),
+            3.0 * orig);
+        EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::ReturnNumber, idx),
+            (int)(idx % 5 + 1));
+        EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::NumberOfReturns, idx),
+            5);
+        EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::Intensity, idx), 0);
+        EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::Classification, idx),
+            0);
+        EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::ScanDirectionFlag,
+            idx), 0);
+    }
+    FileUtils::deleteFile(outfile);
+}
+
+#ifdef PDAL_HAVE_LAZPERF
+// Points written with the lazperf engine span several chunks and can be
+// read back by either engine, and from the middle of a chunk.
+TEST(LasWriterTest, lazperf)
+{
+    std::string outfile(Support::temppath("lazperf.laz"));
+    FileUtils::deleteFile(outfile);
+
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+    table.layout()->registerDim(Dimension::Id::Intensity);
+    table.layout()->registerDim(Dimension::Id::GpsTime);
+    table.layout()->registerDim(Dimension::Id::Red);
+
+    const point_count_t count = 120000;
+    PointViewPtr view(new PointView(table));
+    for (PointId idx = 0; idx < count; ++idx)
+    {
+        view->setField(Dimension::Id::X, idx, (double)(idx % 1000));
+        view->setField(Dimension::Id::Y, idx, (double)(idx / 1000));
+        view->setField(Dimension::Id::Z, idx, (double)(idx % 77));
+        view->setField(Dimension::Id::Intensity, idx, idx % 300);
+        view->setField(Dimension::Id::GpsTime, idx, idx * .5);
+        view->setField(Dimension::Id::Red, idx, idx % 65536);
+    }
+
+    BufferReader bufferReader;
+    bufferReader.addView(view);
+
+    Options writerOps;
+    writerOps.add("filename", outfile);
+    writerOps.add("compression", "lazperf");
+    writerOps.add("format", 3);
+    writerOps.add("scale_x", 1);
+    writerOps.add("scale_y", 1);
+    writerOps.add("scale_z", 1);
+    LasWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(bufferReader);
+    writer.prepare(table);
+    writer.execute(table);
+
+    auto check = [count](const std::string& engine, point_count_t start,
+        point_count_t stride)
+    {
+        Options readerOps;
+        readerOps.add("filename", Support::temppath("lazperf.laz"));
+        readerOps.add("compression", engine);
+        readerOps.add("start", start);
+        readerOps.add("stride", stride);
+        LasReader reader;
+        reader.setOptions(readerOps);
+        PointTable readTable;
+        reader.prepare(readTable);
+        PointViewSet viewSet = reader.execute(readTable);
+        PointViewPtr out = *viewSet.begin();
+
+        EXPECT_TRUE(reader.header().compressed());
+        ASSERT_EQ(out->size(), (count - start + stride - 1) / stride);
+        for (PointId idx = 0; idx < out->size(); ++idx)
+        {
+            PointId orig = start + idx * stride;
+            EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::X, idx),
+                (int)(orig % 1000));
+            EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::Y, idx),
+                (int)(orig / 1000));
+            EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::Z, idx),
+                (int)(orig % 77));
+            EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::Intensity, idx),
+                (int)(orig % 300));
+            EXPECT_DOUBLE_EQ(out->getFieldAs<double>(Dimension::Id::GpsTime,
+                idx), orig * .5);
+            EXPECT_EQ(out->getFieldAs<int>(Dimension::Id::Red, idx),
+                (int)(orig % 65536));
+        }
+    };
+    check("lazperf", 0, 1);
+    check("lazperf", 49999, 7);
+#ifdef PDAL_HAVE_LASZIP
+    check("laszip", 0, 1);
+#endif
+    FileUtils::deleteFile(outfile);
+}
+#endif
+
+#ifdef PDAL_HAVE_LASZIP
+namespace
+{
+
+// Return the data of the LASzip VLR of a LAS file.
+std::vector<char> lasZipVlr(const std::string& filename)
+{
+    ILeStream in(filename);
+    uint16_t headerSize;
+    uint32_t numVlrs;
+    in.seek(94);
+    in >> headerSize;
+    in.seek(100);
+    in >> numVlrs;
+    in.seek(headerSize);
+    for (uint32_t i = 0; i < numVlrs; ++i)
+    {
+        std::string userId;
+        uint16_t recordId;
+        uint16_t length;
+        in.skip(2);
+        in.get(userId, 16);
+        in >> recordId >> length;
+        in.skip(32);
+        std::vector<char> data(length);
+        in.get(data);
+        if (userId == "laszip encoded" && recordId == 22204)
+            return data;
+    }
+    return std::vector<char>();
+}
+
+} // unnamed namespace
+
+// Points packed on several threads are compressed into the same chunks as
+// points packed on one.
+TEST(LasWriterTest, laszipThreaded)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDims({ Id::X, Id::Y, Id::Z, Id::Intensity,
+        Id::ReturnNumber, Id::NumberOfReturns, Id::Classification,
+        Id::PointSourceId, Id::GpsTime });
+
+    // Several chunks, and several of the writer's one meg blocks.
+    const point_count_t count = 160000;
+    PointViewPtr view(new PointView(table));
+    for (PointId idx = 0; idx < count; ++idx)
+    {
+        view->setField(Id::X, idx, (idx * 7919) % 100000 * .01);
+        view->setField(Id::Y, idx, (idx * 104729) % 100000 * .01);
+        view->setField(Id::Z, idx, (idx % 1000) * .01);
+        view->setField(Id::Intensity, idx, (idx * 31) % 65536);
+        view->setField(Id::ReturnNumber, idx, idx % 3 + 1);
+        view->setField(Id::NumberOfReturns, idx, 3);
+        view->setField(Id::Classification, idx, idx % 32);
+        view->setField(Id::PointSourceId, idx, idx / 10000);
+        view->setField(Id::GpsTime, idx, idx * .001);
+    }
+
+    auto write = [&table, &view](std::size_t threads)
+    {
+        std::string filename(Support::temppath("threaded_" +
+            std::to_string(threads) + ".laz"));
+        FileUtils::deleteFile(filename);
+
+        BufferReader bufferReader;
+        bufferReader.addView(view);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        writerOps.add("compression", "laszip");
+        writerOps.add("format", 1);
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(bufferReader);
+        writer.prepare(table);
+
+        ThreadPool& pool = ThreadPool::shared();
+        std::size_t active = pool.size();
+        pool.setActive(threads);
+        writer.execute(table);
+        pool.setActive(active);
+        return filename;
+    };
+    const std::string serialFile(write(1));
+    const std::string threadedFile(write(4));
+
+    EXPECT_EQ(FileUtils::readFileIntoString(serialFile),
+        FileUtils::readFileIntoString(threadedFile));
+
+    // The point data starts with the offset of the chunk table, which
+    // starts with its version and the number of chunks.
+    std::vector<char> vlr(lasZipVlr(threadedFile));
+    ASSERT_GE(vlr.size(), 34u);
+    uint32_t chunkSize;
+    LeExtractor vlrData(vlr.data(), vlr.size());
+    vlrData.skip(12);
+    vlrData >> chunkSize;
+    ASSERT_GT(chunkSize, 0u);
+
+    ILeStream in(threadedFile);
+    uint32_t pointOffset;
+    int64_t tableOffset;
+    uint32_t tableVersion;
+    uint32_t numChunks;
+    in.seek(96);
+    in >> pointOffset;
+    in.seek(pointOffset);
+    in >> tableOffset;
+    ASSERT_GT(tableOffset, (int64_t)pointOffset);
+    ASSERT_LT(tableOffset, (int64_t)FileUtils::fileSize(threadedFile));
+    in.seek(tableOffset);
+    in >> tableVersion >> numChunks;
+    EXPECT_EQ(tableVersion, 0u);
+    EXPECT_EQ(numChunks, (count + chunkSize - 1) / chunkSize);
+    EXPECT_GT(numChunks, 1u);
+
+    Options readerOps;
+    readerOps.add("filename", threadedFile);
+    LasReader reader;
+    reader.setOptions(readerOps);
+    PointTable readTable;
+    reader.prepare(readTable);
+    PointViewSet viewSet = reader.execute(readTable);
+    PointViewPtr out = *viewSet.begin();
+
+    ASSERT_EQ(out->size(), count);
+    const Dimension::IdList dims = table.layout()->dims();
+    for (PointId idx = 0; idx < count; ++idx)
+        for (Dimension::Id::Enum dim : dims)
+            ASSERT_DOUBLE_EQ(out->getFieldAs<double>(dim, idx),
+                view->getFieldAs<double>(dim, idx)) << "point " << idx <<
+                " " << Dimension::name(dim);
+
+    FileUtils::deleteFile(serialFile);
+    FileUtils::deleteFile(threadedFile);
+}
+#endif
+
+#if defined(PDAL_HAVE_LAZPERF) && defined(PDAL_HAVE_LASZIP)
+// The same points written by each engine are described by the same LASzip
+// VLR and read back the same by each engine.
+TEST(LasWriterTest, lazperfMatchesLaszip)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDims({ Id::X, Id::Y, Id::Z, Id::Intensity,
+        Id::ReturnNumber, Id::NumberOfReturns, Id::Classification,
+        Id::ScanAngleRank, Id::PointSourceId, Id::GpsTime, Id::Red,
+        Id::Green, Id::Blue });
+
+    const point_count_t count = 110000;
+    PointViewPtr view(new PointView(table));
+    for (PointId idx = 0; idx < count; ++idx)
+    {
+        view->setField(Id::X, idx, (idx * 7919) % 100000 * .01);
+        view->setField(Id::Y, idx, (idx * 104729) % 100000 * .01);
+        view->setField(Id::Z, idx, (idx % 1000) * .01);
+        view->setField(Id::Intensity, idx, (idx * 31) % 65536);
+        view->setField(Id::ReturnNumber, idx, idx % 3 + 1);
+        view->setField(Id::NumberOfReturns, idx, 3);
+        view->setField(Id::Classification, idx, idx % 32);
+        view->setField(Id::ScanAngleRank, idx, (int)(idx % 181) - 90);
+        view->setField(Id::PointSourceId, idx, idx / 10000);
+        view->setField(Id::GpsTime, idx, idx * .001);
+        view->setField(Id::Red, idx, idx % 65536);
+        view->setField(Id::Green, idx, (idx * 3) % 65536);
+        view->setField(Id::Blue, idx, (idx * 5) % 65536);
+    }
+
+    auto write = [&table, &view](const std::string& engine)
+    {
+        std::string filename(Support::temppath(engine + "_engine.laz"));
+        FileUtils::deleteFile(filename);
+
+        BufferReader bufferReader;
+        bufferReader.addView(view);
+
+        Options writerOps;
+        writerOps.add("filename", filename);
+        writerOps.add("compression", engine);
+        writerOps.add("format", 3);
+        LasWriter writer;
+        writer.setOptions(writerOps);
+        writer.setInput(bufferReader);
+        writer.prepare(table);
+        writer.execute(table);
+        return filename;
+    };
+    const std::string lazperfFile(write("lazperf"));
+    const std::string laszipFile(write("laszip"));
+
+    // The version and options the writer records may differ.
+    std::vector<char> lazperfVlr(lasZipVlr(lazperfFile));
+    std::vector<char> laszipVlr(lasZipVlr(laszipFile));
+    ASSERT_EQ(lazperfVlr.size(), laszipVlr.size());
+    ASSERT_GE(lazperfVlr.size(), 34u);
+    EXPECT_TRUE(std::equal(lazperfVlr.begin(), lazperfVlr.begin() + 4,
+        laszipVlr.begin()));
+    EXPECT_TRUE(std::equal(lazperfVlr.begin() + 12, lazperfVlr.begin() + 16,
+        laszipVlr.begin() + 12));
+    EXPECT_TRUE(std::equal(lazperfVlr.begin() + 32, lazperfVlr.end(),
+        laszipVlr.begin() + 32));
+
+    const Dimension::IdList dims = table.layout()->dims();
+    const StringList engines { "lazperf", "laszip" };
+    for (const std::string& filename : { lazperfFile, laszipFile })
+        for (const std::string& engine : engines)
+        {
+            Options readerOps;
+            readerOps.add("filename", filename);
+            readerOps.add("compression", engine);
+            LasReader reader;
+            reader.setOptions(readerOps);
+            PointTable readTable;
+            reader.prepare(readTable);
+            PointViewSet viewSet = reader.execute(readTable);
+            PointViewPtr out = *viewSet.begin();
+
+            ASSERT_EQ(out->size(), count) << filename << " " << engine;
+            for (PointId idx = 0; idx < count; ++idx)
+                for (Dimension::Id::Enum dim : dims)
+                    ASSERT_DOUBLE_EQ(out->getFieldAs<double>(dim, idx),
+                        view->getFieldAs<double>(dim, idx)) <<
+                        filename << " " << engine << " point " << idx <<
+                        " " << Dimension::name(dim);
+        }
+    FileUtils::deleteFile(lazperfFile);
+    FileUtils::deleteFile(laszipFile);
+}
+#endif
+
 TEST(LasWriterTest, extra_dims)
 {
     Options readerOps;
@@ -406,6 +1085,28 @@ TEST(LasWriterTest, version1_2)
 **/
 
 
+TEST(LasWriterTest, summaryMerge)
+{
+    SummaryData whole;
+    SummaryData parts[2];
+    for (int i = 0; i < 10; ++i)
+    {
+        whole.addPoint(i, -i, 2 * i, i % 3 + 1);
+        parts[i % 2].addPoint(i, -i, 2 * i, i % 3 + 1);
+    }
+    SummaryData merged;
+    merged.merge(parts[0]);
+    merged.merge(parts[1]);
+    // An empty summary leaves the bounds alone.
+    merged.merge(SummaryData());
+
+    EXPECT_EQ(merged.getTotalNumPoints(), whole.getTotalNumPoints());
+    EXPECT_EQ(merged.getBounds(), whole.getBounds());
+    for (int r = 0; r < 3; ++r)
+        EXPECT_EQ(merged.getReturnCount(r), whole.getReturnCount(r));
+}
+
+
 //ABELL
 /**
 TEST(LasWriterTest, test_summary_data_add_point)
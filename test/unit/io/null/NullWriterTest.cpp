@@ -0,0 +1,86 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <FauxReader.hpp>
+#include <NullWriter.hpp>
+
+using namespace pdal;
+
+TEST(NullWriterTest, benchmark)
+{
+    Options readerOps;
+    readerOps.add("count", 1000);
+    readerOps.add("mode", "ramp");
+    FauxReader reader;
+    reader.setOptions(readerOps);
+
+    Options writerOps;
+    writerOps.add("benchmark", true);
+    NullWriter writer;
+    writer.setOptions(writerOps);
+    writer.setInput(reader);
+
+    PointTable table;
+    writer.prepare(table);
+    writer.execute(table);
+
+    MetadataNode m = writer.getMetadata().findChild("benchmark");
+    ASSERT_TRUE(m.valid());
+    EXPECT_EQ(m.findChild("points").value<point_count_t>(), 1000u);
+    EXPECT_EQ(m.findChild("bytes").value<uint64_t>(),
+        1000 * table.layout()->pointSize());
+    EXPECT_GE(m.findChild("seconds").value<double>(), 0.0);
+    MetadataNode stage = m.findChild("stages").findChild("readers.faux");
+    ASSERT_TRUE(stage.valid());
+    EXPECT_EQ(stage.findChild("points_out").value<point_count_t>(), 1000u);
+}
+
+TEST(NullWriterTest, noBenchmark)
+{
+    Options readerOps;
+    readerOps.add("count", 100);
+    readerOps.add("mode", "constant");
+    FauxReader reader;
+    reader.setOptions(readerOps);
+
+    NullWriter writer;
+    writer.setInput(reader);
+
+    PointTable table;
+    writer.prepare(table);
+    writer.execute(table);
+    EXPECT_FALSE(writer.getMetadata().findChild("benchmark").valid());
+}
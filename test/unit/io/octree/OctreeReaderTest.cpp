@@ -0,0 +1,242 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/Options.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/util/Bounds.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "OctreeReader.hpp"
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+const point_count_t NumPoints = 20000;
+
+// Write random points to an octree with small nodes.
+void writeOctree(const std::string& dir)
+{
+    Options ro;
+    ro.add("bounds", BOX3D(1.0, 2.0, 3.0, 101.0, 52.0, 13.0));
+    ro.add("count", NumPoints);
+    ro.add("mode", "random");
+
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(ro);
+
+    Options wo;
+    wo.add("filename", dir);
+    wo.add("overwrite", true);
+    wo.add("max_node_points", 1000);
+    wo.add("resolution", 8);
+    wo.add("compression", "false");
+
+    std::unique_ptr<Stage> writer(f.createStage("writers.octree"));
+    writer->setOptions(wo);
+    writer->setInput(*reader);
+
+    PointTable table;
+    writer->prepare(table);
+    writer->execute(table);
+}
+
+PointViewPtr readOctree(PointTableRef table, const Options& options)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.octree"));
+    reader->setOptions(options);
+    reader->prepare(table);
+    PointViewSet views = reader->execute(table);
+    EXPECT_EQ(views.size(), 1u);
+    return *views.begin();
+}
+
+class OctreeReaderTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestCase()
+    {
+        writeOctree(dir());
+    }
+
+    static void TearDownTestCase()
+    {
+        FileUtils::deleteDirectory(dir());
+    }
+
+    static std::string dir()
+    {
+        return Support::temppath("OctreeReaderTest");
+    }
+};
+
+} // unnamed namespace
+
+TEST_F(OctreeReaderTest, testConstructor)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.octree"));
+    EXPECT_TRUE(reader.get());
+    EXPECT_EQ(reader->getName(), "readers.octree");
+}
+
+TEST_F(OctreeReaderTest, testRead)
+{
+    // The directory and the index name the same octree.
+    for (const std::string& filename : { dir(), dir() + "/octree.json" })
+    {
+        Options options;
+        options.add("filename", filename);
+        PointTable table;
+        PointViewPtr view = readOctree(table, options);
+        EXPECT_EQ(view->size(), NumPoints);
+
+        BOX3D bounds = view->calculateBounds();
+        EXPECT_NEAR(bounds.minx, 1.0, .1);
+        EXPECT_NEAR(bounds.maxx, 101.0, .1);
+        EXPECT_NEAR(bounds.miny, 2.0, .1);
+        EXPECT_NEAR(bounds.maxy, 52.0, .1);
+        EXPECT_NEAR(bounds.minz, 3.0, .1);
+        EXPECT_NEAR(bounds.maxz, 13.0, .1);
+    }
+}
+
+TEST_F(OctreeReaderTest, testBounds)
+{
+    Options all;
+    all.add("filename", dir());
+    PointTable allTable;
+    PointViewPtr allView = readOctree(allTable, all);
+
+    BOX3D bounds(20.0, 10.0, 0.0, 50.0, 40.0, 20.0);
+    point_count_t inside = 0;
+    for (PointId idx = 0; idx < allView->size(); ++idx)
+    {
+        double x = allView->getFieldAs<double>(Dimension::Id::X, idx);
+        double y = allView->getFieldAs<double>(Dimension::Id::Y, idx);
+        double z = allView->getFieldAs<double>(Dimension::Id::Z, idx);
+        if (bounds.contains(x, y, z))
+            inside++;
+    }
+    EXPECT_TRUE(inside > 0);
+    EXPECT_TRUE(inside < NumPoints);
+
+    Options options;
+    options.add("filename", dir());
+    options.add("bounds", bounds);
+    PointTable table;
+    PointViewPtr view = readOctree(table, options);
+    EXPECT_EQ(view->size(), inside);
+    EXPECT_TRUE(bounds.contains(view->calculateBounds()));
+}
+
+TEST_F(OctreeReaderTest, testDepth)
+{
+    namespace pt = boost::property_tree;
+
+    pt::ptree index;
+    pt::read_json(dir() + "/octree.json", index);
+    point_count_t rootCount = index.get<point_count_t>("hierarchy.0-0-0-0");
+    EXPECT_TRUE(rootCount > 0);
+    EXPECT_TRUE(rootCount < NumPoints);
+
+    Options options;
+    options.add("filename", dir());
+    options.add("depth", 0);
+    PointTable table;
+    PointViewPtr view = readOctree(table, options);
+    EXPECT_EQ(view->size(), rootCount);
+
+    // The octree is about 100 wide and nodes have 8 cells across, so the
+    // root's points are about 12.5 apart and its children's 6.25.
+    Options resOptions;
+    resOptions.add("filename", dir());
+    resOptions.add("resolution", 20);
+    PointTable resTable;
+    view = readOctree(resTable, resOptions);
+    EXPECT_EQ(view->size(), rootCount);
+
+    resOptions.remove("resolution");
+    resOptions.add("resolution", 10);
+    PointTable res1Table;
+    PointViewPtr res1View = readOctree(res1Table, resOptions);
+
+    Options depthOptions;
+    depthOptions.add("filename", dir());
+    depthOptions.add("depth", 1);
+    PointTable depthTable;
+    PointViewPtr depthView = readOctree(depthTable, depthOptions);
+    EXPECT_EQ(res1View->size(), depthView->size());
+    EXPECT_TRUE(depthView->size() > rootCount);
+}
+
+TEST_F(OctreeReaderTest, testStream)
+{
+    Options options;
+    options.add("filename", dir());
+
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.octree"));
+    reader->setOptions(options);
+    std::unique_ptr<Stage> writer(f.createStage("writers.null"));
+    writer->setInput(*reader);
+
+    FixedPointTable table(100);
+    writer->prepare(table);
+    EXPECT_EQ(writer->executeStream(table), NumPoints);
+}
+
+TEST(OctreeReaderErrorTest, testMissing)
+{
+    Options options;
+    options.add("filename", Support::temppath("OctreeMissing"));
+
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.octree"));
+    reader->setOptions(options);
+    PointTable table;
+    EXPECT_THROW(reader->prepare(table), pdal_error);
+}
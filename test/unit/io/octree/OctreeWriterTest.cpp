@@ -0,0 +1,231 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/Options.hpp>
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/util/Bounds.hpp>
+#include <pdal/util/FileUtils.hpp>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <LasReader.hpp>
+#include "OctreeWriter.hpp"
+#include "Support.hpp"
+
+#include <vector>
+
+using namespace pdal;
+
+namespace
+{
+
+// Write 'count' random points to an octree with small nodes.
+void writeOctree(const std::string& dir, point_count_t count, bool stream,
+    int memoryBudget = 0)
+{
+    Options ro;
+    ro.add("bounds", BOX3D(1.0, 2.0, 3.0, 101.0, 52.0, 13.0));
+    ro.add("count", count);
+    ro.add("mode", "random");
+
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(ro);
+
+    Options wo;
+    wo.add("filename", dir);
+    wo.add("overwrite", true);
+    wo.add("max_node_points", 1000);
+    wo.add("resolution", 8);
+    wo.add("compression", "false");
+    wo.add("memory_budget", memoryBudget);
+
+    std::unique_ptr<Stage> writer(f.createStage("writers.octree"));
+    writer->setOptions(wo);
+    writer->setInput(*reader);
+
+    if (stream)
+    {
+        FixedPointTable table(100);
+        writer->prepare(table);
+        EXPECT_EQ(writer->executeStream(table), count);
+    }
+    else
+    {
+        PointTable table;
+        writer->prepare(table);
+        writer->execute(table);
+    }
+}
+
+// Check that the nodes listed in the index hold the points they should.
+void checkOctree(const std::string& dir, point_count_t count)
+{
+    namespace pt = boost::property_tree;
+
+    pt::ptree index;
+    pt::read_json(dir + "/octree.json", index);
+    EXPECT_EQ(index.get<point_count_t>("points"), count);
+    EXPECT_EQ(index.get<std::string>("dataType"), "las");
+
+    std::vector<double> cube;
+    for (auto& v : index.get_child("bounds"))
+        cube.push_back(v.second.get_value<double>());
+    ASSERT_EQ(cube.size(), 6u);
+    EXPECT_NEAR(cube[3] - cube[0], 100.0, .1);
+    EXPECT_NEAR(cube[4] - cube[1], 100.0, .1);
+    EXPECT_NEAR(cube[5] - cube[2], 100.0, .1);
+
+    std::map<OctreeKey, point_count_t> nodes;
+    for (auto& node : index.get_child("hierarchy"))
+    {
+        OctreeKey key;
+        ASSERT_TRUE(key.parse(node.first)) << node.first;
+        EXPECT_EQ(key.toString(), node.first);
+        nodes[key] = node.second.get_value<point_count_t>();
+    }
+    EXPECT_TRUE(nodes.size() > 1);
+
+    point_count_t total = 0;
+    for (auto& node : nodes)
+    {
+        const OctreeKey& key = node.first;
+
+        // Every node but the root hangs from a node in the index.
+        if (key.d)
+        {
+            OctreeKey parent(key.d - 1, key.x / 2, key.y / 2,
+                key.z / 2);
+            EXPECT_TRUE(nodes.count(parent)) << key.toString();
+        }
+
+        std::string filename(dir + "/data/" + key.toString() + ".las");
+        if (node.second == 0)
+        {
+            EXPECT_FALSE(FileUtils::fileExists(filename));
+            continue;
+        }
+
+        Options ro;
+        ro.add("filename", filename);
+        LasReader reader;
+        reader.setOptions(ro);
+        PointTable table;
+        reader.prepare(table);
+        PointViewSet views = reader.execute(table);
+        PointViewPtr view = *views.begin();
+        ASSERT_EQ(view->size(), node.second);
+        total += view->size();
+
+        // The points are inside the node, to within the scale.
+        double size = (cube[3] - cube[0]) / (1 << key.d);
+        BOX3D b(cube[0] + key.x * size - .01, cube[1] + key.y * size - .01,
+            cube[2] + key.z * size - .01, cube[0] + (key.x + 1) * size + .01,
+            cube[1] + (key.y + 1) * size + .01,
+            cube[2] + (key.z + 1) * size + .01);
+        EXPECT_TRUE(b.contains(view->calculateBounds())) << key.toString();
+
+        // Nodes with children hold no more than a point per cell.
+        OctreeKey child = key.child(0);
+        bool hasChildren = false;
+        for (auto ni = nodes.lower_bound(child); ni != nodes.end() &&
+                ni->first.d == child.d; ++ni)
+            if (ni->first.x / 2 == key.x && ni->first.y / 2 == key.y &&
+                ni->first.z / 2 == key.z)
+                hasChildren = true;
+        if (hasChildren)
+            EXPECT_TRUE(view->size() <= 8 * 8 * 8) << key.toString();
+        else
+            EXPECT_TRUE(view->size() <= 1000) << key.toString();
+    }
+    EXPECT_EQ(total, count);
+}
+
+} // unnamed namespace
+
+TEST(OctreeWriterTest, testConstructor)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> writer(f.createStage("writers.octree"));
+    EXPECT_TRUE(writer.get());
+    EXPECT_EQ(writer->getName(), "writers.octree");
+}
+
+TEST(OctreeWriterTest, testWrite)
+{
+    const std::string dir(Support::temppath("OctreeTest"));
+    writeOctree(dir, 50000, false);
+    checkOctree(dir, 50000);
+    FileUtils::deleteDirectory(dir);
+}
+
+TEST(OctreeWriterTest, testStream)
+{
+    // A budget of a megabyte spills most of the points to disk.
+    const std::string dir(Support::temppath("OctreeStreamTest"));
+    writeOctree(dir, 50000, true, 1);
+    checkOctree(dir, 50000);
+    FileUtils::deleteDirectory(dir);
+}
+
+TEST(OctreeWriterTest, testNoOverwrite)
+{
+    const std::string dir(Support::temppath("OctreeTest"));
+    FileUtils::createDirectory(dir);
+
+    Options ro;
+    ro.add("bounds", BOX3D(1.0, 2.0, 3.0, 11.0, 12.0, 13.0));
+    ro.add("count", 10);
+    ro.add("mode", "ramp");
+
+    Options wo;
+    wo.add("filename", dir);
+
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(ro);
+    std::unique_ptr<Stage> writer(f.createStage("writers.octree"));
+    writer->setOptions(wo);
+    writer->setInput(*reader);
+
+    PointTable table;
+    writer->prepare(table);
+    EXPECT_THROW(writer->execute(table), pdal_error);
+    FileUtils::deleteDirectory(dir);
+}
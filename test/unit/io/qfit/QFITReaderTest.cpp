@@ -111,3 +111,27 @@ TEST(QFITReaderTest, test_14_word)
     Check_Point(*view, 1, 244.306260, 35.623280, 1056.409000000, 903);
     Check_Point(*view, 2, 244.306204, 35.623257, 1056.483000000, 903);
 }
+
+TEST(QFITReaderTest, test_start)
+{
+    Options options;
+
+    options.add("filename", Support::datapath("qfit/10-word.qi"));
+    options.add("flip_coordinates", false);
+    options.add("scale_z", 0.001f);
+    options.add("start", 1);
+    options.add("count", 2);
+
+    std::shared_ptr<QfitReader> reader(new QfitReader);
+    reader->setOptions(options);
+
+    PointTable table;
+    reader->prepare(table);
+    PointViewSet viewSet = reader->execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 2u);
+
+    Check_Point(*view, 0, 221.826740, 59.205161, 32.0190, 0);
+    Check_Point(*view, 1, 221.826658, 59.205164, 32.0000, 0);
+}
@@ -6,6 +6,10 @@
 #include <pdal/util/Bounds.hpp>
 #include <pdal/util/FileUtils.hpp>
 
+#include <boost/filesystem.hpp>
+
+#include <set>
+
 #include "RialtoWriter.hpp"
 #include "Support.hpp"
 
@@ -90,3 +94,136 @@ TEST(RialtoWriterTest, testWriteHeaderNoOverwrite)
     EXPECT_THROW(writer->execute(table), pdal_error);
 }
 
+
+TEST(RialtoWriterTest, testWriteTiles)
+{
+    // Enough points that the pyramid is split and built in parallel.
+    const point_count_t count = 20000;
+    const int32_t maxLevel = 5;
+    BOX3D bounds(1.0, 2.0, 3.0, 11.0, 12.0, 13.0);
+
+    Options ro;
+    ro.add("bounds", bounds);
+    ro.add("count", count);
+    ro.add("mode", "random");
+
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(ro);
+
+    Options wo;
+    wo.add("filename", Support::temppath("RialtoTest"));
+    wo.add("max_level", maxLevel);
+    wo.add("overwrite", true);
+
+    std::unique_ptr<Stage> writer(f.createStage("writers.rialto"));
+    writer->setOptions(wo);
+    writer->setInput(*reader);
+
+    PointTable table;
+    writer->prepare(table);
+    writer->execute(table);
+
+    size_t pointSize = 0;
+    for (const auto& dt : table.layout()->dimTypes())
+        pointSize += Dimension::size(dt.m_type);
+
+    // Each level holds every 4^(maxLevel - level)th point, split among
+    // its tiles.
+    for (int32_t level = 0; level <= maxLevel; ++level)
+    {
+        std::string dir(Support::temppath("RialtoTest/") +
+            std::to_string(level));
+        uintmax_t bytes = 0;
+        size_t tiles = 0;
+        for (boost::filesystem::recursive_directory_iterator it(dir), end;
+                it != end; ++it)
+        {
+            if (!boost::filesystem::is_regular_file(it->status()))
+                continue;
+            uintmax_t size = boost::filesystem::file_size(it->path());
+            EXPECT_EQ((size - 1) % pointSize, 0u);
+            bytes += size - 1;
+            tiles++;
+        }
+        point_count_t skip = 1 << (2 * (maxLevel - level));
+        EXPECT_EQ(bytes / pointSize, (count + skip - 1) / skip);
+        EXPECT_GE(tiles, 1u);
+        EXPECT_LE(tiles, 2u << (2 * level));
+    }
+    FileUtils::deleteDirectory(Support::temppath("RialtoTest"));
+}
+
+
+// The tiles hold the points packed just as they were when the writer
+// packed a copy of every point as it arrived: each record of a tile is
+// a packed point of the input, and the deepest level holds every point.
+TEST(RialtoWriterTest, testTileRecords)
+{
+    const point_count_t count = 20000;
+    const int32_t maxLevel = 3;
+
+    Options ro;
+    ro.add("bounds", BOX3D(1.0, 2.0, 3.0, 11.0, 12.0, 13.0));
+    ro.add("count", count);
+    ro.add("mode", "random");
+
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.faux"));
+    reader->setOptions(ro);
+
+    Options wo;
+    wo.add("filename", Support::temppath("RialtoRecords"));
+    wo.add("max_level", maxLevel);
+    wo.add("overwrite", true);
+
+    std::unique_ptr<Stage> writer(f.createStage("writers.rialto"));
+    writer->setOptions(wo);
+    writer->setInput(*reader);
+
+    PointTable table;
+    writer->prepare(table);
+    PointViewSet viewSet = writer->execute(table);
+    ASSERT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+
+    const DimTypeList dims = view->dimTypes();
+    size_t pointSize = 0;
+    for (const auto& dt : dims)
+        pointSize += Dimension::size(dt.m_type);
+
+    std::multiset<std::string> packed;
+    std::vector<char> buf(pointSize);
+    for (PointId idx = 0; idx < view->size(); ++idx)
+    {
+        view->getPackedPoint(dims, idx, buf.data());
+        packed.insert(std::string(buf.data(), pointSize));
+    }
+
+    for (int32_t level = 0; level <= maxLevel; ++level)
+    {
+        std::string dir(Support::temppath("RialtoRecords/") +
+            std::to_string(level));
+        std::multiset<std::string> records;
+        for (boost::filesystem::recursive_directory_iterator it(dir), end;
+                it != end; ++it)
+        {
+            if (!boost::filesystem::is_regular_file(it->status()))
+                continue;
+            std::string data =
+                FileUtils::readFileIntoString(it->path().string());
+            ASSERT_EQ((data.size() - 1) % pointSize, 0u);
+            for (size_t pos = 0; pos + 1 < data.size(); pos += pointSize)
+            {
+                std::string record(data.substr(pos, pointSize));
+                EXPECT_TRUE(packed.count(record)) << it->path().string();
+                records.insert(record);
+            }
+        }
+        if (level == maxLevel)
+        {
+            EXPECT_TRUE(records == packed);
+        }
+    }
+    FileUtils::deleteDirectory(Support::temppath("RialtoRecords"));
+}
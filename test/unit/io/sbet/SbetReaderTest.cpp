@@ -38,6 +38,7 @@
 #include <pdal/PipelineReader.hpp>
 #include <pdal/PipelineManager.hpp>
 #include <pdal/PointView.hpp>
+#include <pdal/Trajectory.hpp>
 
 #include <SbetReader.hpp>
 
@@ -115,6 +116,52 @@ TEST(SbetReaderTest, testRead)
                7.179027672314571e-02);
 }
 
+TEST(SbetReaderTest, testReadMapped)
+{
+    Option filename("filename", Support::datapath("sbet/2-points.sbet"), "");
+    Options options(filename);
+    SbetReader reader;
+    reader.setOptions(options);
+
+    MappedPointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_TRUE(table.mapped());
+    EXPECT_EQ(view->size(), 2u);
+
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::GpsTime, 1),
+        1.516310078318641e+05);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::X, 0),
+        -2.041654392303940e+00);
+    EXPECT_DOUBLE_EQ(
+        view->getFieldAs<double>(Dimension::Id::ZBodyAngRate, 1),
+        7.179027672314571e-02);
+}
+
+TEST(SbetReaderTest, testTrajectory)
+{
+    Option filename("filename", Support::datapath("sbet/2-points.sbet"), "");
+    Options options(filename);
+    SbetReader reader;
+    reader.setOptions(options);
+
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    Trajectory traj(**viewSet.begin());
+    ASSERT_EQ(traj.size(), 2u);
+
+    double t0 = 1.516310028360710e+05;
+    double t1 = 1.516310078318641e+05;
+    Trajectory::Pose p = traj.interpolate((t0 + t1) / 2);
+    EXPECT_DOUBLE_EQ(p.y, (5.680211852972264e-01 + 5.680211834722869e-01) / 2);
+    EXPECT_DOUBLE_EQ(p.z, (1.077152953296560e+02 + 1.077151424357507e+02) / 2);
+    EXPECT_DOUBLE_EQ(p.heading,
+        (3.046773230278662e+00 + 3.047131105236811e+00) / 2);
+}
+
 TEST(SbetReaderTest, testBadFile)
 {
     Option filename("filename", Support::datapath("sbet/badfile.sbet"), "");
@@ -125,4 +125,31 @@ TEST_F(TerrasolidReaderTest, ReadingPoints)
     EXPECT_EQ(0, view->getFieldAs<uint8_t>(Dimension::Id::Flag, 0));
     EXPECT_EQ(0, view->getFieldAs<uint8_t>(Dimension::Id::Mark, 0));
 }
+
+
+TEST(TerrasolidReader, Start)
+{
+    Options options;
+    options.add("filename", getTestfilePath());
+    TerrasolidReader reader;
+    reader.setOptions(options);
+    PointTable table;
+    reader.prepare(table);
+    PointViewPtr all = *reader.execute(table).begin();
+    ASSERT_EQ(all->size(), 1000u);
+
+    options.add("start", 990);
+    options.add("count", 20);
+    TerrasolidReader partial;
+    partial.setOptions(options);
+    PointTable partialTable;
+    partial.prepare(partialTable);
+    PointViewPtr view = *partial.execute(partialTable).begin();
+    ASSERT_EQ(view->size(), 10u);
+
+    for (PointId i = 0; i < view->size(); ++i)
+        for (Dimension::Id::Enum dim : partialTable.layout()->dims())
+            EXPECT_DOUBLE_EQ(all->getFieldAs<double>(dim, 990 + i),
+                view->getFieldAs<double>(dim, i));
+}
 }
@@ -0,0 +1,206 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <TextReader.hpp>
+#include <TextWriter.hpp>
+
+#include <fstream>
+
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+PointViewPtr readText(PointTableRef table, const std::string& filename,
+    Options ops = Options())
+{
+    ops.add("filename", filename);
+
+    TextReader r;
+    r.setOptions(ops);
+    r.prepare(table);
+    PointViewSet s = r.execute(table);
+    EXPECT_EQ(s.size(), 1u);
+    return *s.begin();
+}
+
+void writeFile(const std::string& filename, const std::string& text)
+{
+    std::ofstream out(filename, std::ios::binary);
+    out << text;
+}
+
+} // unnamed namespace
+
+TEST(TextReaderTest, roundtrip)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.layout()->registerDim(Id::Y);
+    table.layout()->registerDim(Id::Z);
+    table.layout()->registerDim(Id::Intensity);
+
+    // Enough points for the file to be split into several chunks.
+    const point_count_t count = 100000;
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < count; ++i)
+    {
+        view->setField(Id::X, i, 637000 + i * .125);
+        view->setField(Id::Y, i, 849000 - i * .25);
+        view->setField(Id::Z, i, (i % 1000) / 8.0 - 20);
+        view->setField(Id::Intensity, i, i % 65536);
+    }
+
+    BufferReader r;
+    r.addView(view);
+
+    std::string filename(Support::temppath("TextReaderTest.txt"));
+    FileUtils::deleteFile(filename);
+
+    Options ops;
+    ops.add("filename", filename);
+    TextWriter w;
+    w.setOptions(ops);
+    w.setInput(r);
+    w.prepare(table);
+    w.execute(table);
+
+    PointTable outTable;
+    PointViewPtr out = readText(outTable, filename);
+    FileUtils::deleteFile(filename);
+
+    EXPECT_TRUE(out->layout()->hasDim(Id::Intensity));
+    ASSERT_EQ(out->size(), count);
+    for (PointId i = 0; i < count; ++i)
+    {
+        EXPECT_DOUBLE_EQ(out->getFieldAs<double>(Id::X, i),
+            view->getFieldAs<double>(Id::X, i));
+        EXPECT_DOUBLE_EQ(out->getFieldAs<double>(Id::Y, i),
+            view->getFieldAs<double>(Id::Y, i));
+        EXPECT_DOUBLE_EQ(out->getFieldAs<double>(Id::Z, i),
+            view->getFieldAs<double>(Id::Z, i));
+        EXPECT_EQ(out->getFieldAs<uint16_t>(Id::Intensity, i),
+            view->getFieldAs<uint16_t>(Id::Intensity, i));
+    }
+}
+
+TEST(TextReaderTest, xyz)
+{
+    using namespace Dimension;
+
+    std::string filename(Support::temppath("TextReaderTest.xyz"));
+    writeFile(filename, "\n 1 2 3\n4.5\t-5e2  6\r\n\n7 8 9");
+
+    PointTable table;
+    PointViewPtr view = readText(table, filename);
+    ASSERT_EQ(view->size(), 3u);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::X, 1), 4.5);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::Y, 1), -500);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::Z, 2), 9);
+
+    // Names from the 'header' option, which may be custom dimensions.
+    Options ops;
+    ops.add("header", "Y,X,Height");
+    PointTable headerTable;
+    view = readText(headerTable, filename, ops);
+    ASSERT_EQ(view->size(), 3u);
+    Id::Enum height = view->layout()->findDim("Height");
+    EXPECT_NE(height, Id::Unknown);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::Y, 0), 1);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::X, 0), 2);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(height, 0), 3);
+
+    FileUtils::deleteFile(filename);
+}
+
+TEST(TextReaderTest, count)
+{
+    using namespace Dimension;
+
+    std::string filename(Support::temppath("TextReaderTest.csv"));
+    writeFile(filename, "X;Y;Z\n1;2;3\n4;5;6\n7;8;9\n");
+
+    Options ops;
+    ops.add("separator", ";");
+    ops.add("count", 2);
+    PointTable table;
+    PointViewPtr view = readText(table, filename, ops);
+    ASSERT_EQ(view->size(), 2u);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Id::Z, 1), 6);
+
+    FileUtils::deleteFile(filename);
+}
+
+TEST(TextReaderTest, errors)
+{
+    std::string filename(Support::temppath("TextReaderTest.csv"));
+
+    writeFile(filename, "X,Y,Z\n1,2,3\n4,five,6\n");
+    {
+        PointTable table;
+        EXPECT_THROW(readText(table, filename), pdal_error);
+    }
+    writeFile(filename, "X,Y,Z\n1,2\n");
+    {
+        PointTable table;
+        EXPECT_THROW(readText(table, filename), pdal_error);
+    }
+    writeFile(filename, "X,Y,Z\n1,2,3,4\n");
+    {
+        PointTable table;
+        EXPECT_THROW(readText(table, filename), pdal_error);
+    }
+    writeFile(filename, "X,Y,X\n1,2,3\n");
+    {
+        PointTable table;
+        EXPECT_THROW(readText(table, filename), pdal_error);
+    }
+
+    FileUtils::deleteFile(filename);
+}
+
+TEST(TextReaderTest, inferDriver)
+{
+    EXPECT_EQ(StageFactory::inferReaderDriver("foo.csv"), "readers.text");
+    EXPECT_EQ(StageFactory::inferReaderDriver("foo.xyz"), "readers.text");
+}
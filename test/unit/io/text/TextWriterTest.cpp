@@ -0,0 +1,161 @@
+/******************************************************************************
+* Copyright (c) 2016, Hobu Inc. (info@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/BufferReader.hpp>
+#include <pdal/PointView.hpp>
+#include <TextWriter.hpp>
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+std::vector<double> testValues()
+{
+    std::vector<double> values { 0, -0.0, 1, -1, 0.5, 1.5, 2.5, 0.0625,
+        -0.0625, 0.0005, 0.0015, -0.0001, 0.1, 0.2, 0.3, 123.4567895,
+        637012.24, 849028.31, 431.66, 246.45121, 1e12, -1e15, 1e20,
+        1.7976931348623157e308, 5e-324, 3.14159265358979,
+        std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN() };
+
+    // A spread of ordinary coordinates and times.
+    for (int i = 0; i < 40000; ++i)
+        values.push_back((i - 20000) * 1234.56789 / 7 + i * 1e-4);
+    return values;
+}
+
+// Write the values as X with writers.text and return the text.
+std::string writeValues(const std::vector<double>& values, int precision,
+    const std::string& format)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < values.size(); ++i)
+    {
+        view->setField(Dimension::Id::X, i, values[i]);
+        view->setField(Dimension::Id::Y, i, i);
+        view->setField(Dimension::Id::Z, i, -values[i] / 3);
+    }
+
+    BufferReader r;
+    r.addView(view);
+
+    std::string filename(Support::temppath("TextWriterTest.txt"));
+    FileUtils::deleteFile(filename);
+
+    Options ops;
+    ops.add("filename", filename);
+    ops.add("precision", precision);
+    ops.add("format", format);
+    ops.add("order", "X,Y,Z");
+    ops.add("keep_unspecified", false);
+
+    TextWriter w;
+    w.setOptions(ops);
+    w.setInput(r);
+    w.prepare(table);
+    w.execute(table);
+
+    std::string text = FileUtils::readFileIntoString(filename);
+    FileUtils::deleteFile(filename);
+    return text;
+}
+
+// What the writer produced when it formatted with an ostream.
+std::ostream& streamValue(std::ostream& out, double v, int precision)
+{
+    return out << std::fixed << std::setprecision(precision) << v;
+}
+
+} // unnamed namespace
+
+TEST(TextWriterTest, csv)
+{
+    std::vector<double> values = testValues();
+    for (int precision : { 0, 3, 8, 17 })
+    {
+        std::ostringstream expected;
+        expected << "\"X\",\"Y\",\"Z\"\n";
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            streamValue(expected, values[i], precision) << ",";
+            streamValue(expected, (double)i, precision) << ",";
+            streamValue(expected, -values[i] / 3, precision) << "\n";
+        }
+        EXPECT_EQ(writeValues(values, precision, "csv"), expected.str()) <<
+            "precision " << precision;
+    }
+}
+
+TEST(TextWriterTest, geojson)
+{
+    std::vector<double> values = testValues();
+    const int precision = 3;
+
+    std::ostringstream expected;
+    expected << "{ \"type\": \"FeatureCollection\", \"features\": [";
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        double x = values[i];
+        double z = -values[i] / 3;
+
+        if (i)
+            expected << ",";
+        expected << "{ \"type\":\"Feature\",\"geometry\": "
+            "{ \"type\": \"Point\", \"coordinates\": [";
+        streamValue(expected, x, precision) << ",";
+        streamValue(expected, (double)i, precision) << ",";
+        streamValue(expected, z, precision) << "]},";
+        expected << "\"properties\": {\"X\":\"";
+        streamValue(expected, x, precision) << "\",\"Y\":\"";
+        streamValue(expected, (double)i, precision) << "\",\"Z\":\"";
+        streamValue(expected, z, precision) << "\"}}";
+    }
+    expected << "]}";
+    EXPECT_EQ(writeValues(values, precision, "geojson"), expected.str());
+}
@@ -0,0 +1,215 @@
+/******************************************************************************
+* Copyright (c) 2015, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/Writer.hpp>
+#include <RingBuffer.hpp>
+#include <VelodyneReader.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace pdal;
+
+namespace
+{
+
+// A data packet with a return from laser 1 and laser 2 in the first
+// firing of every block.
+std::vector<uint8_t> makePacket(uint32_t stamp)
+{
+    std::vector<uint8_t> packet(VelodyneReader::PacketSize);
+    for (int b = 0; b < 12; ++b)
+    {
+        uint8_t *block = packet.data() + b * 100;
+        block[0] = 0xFF;
+        block[1] = 0xEE;
+        uint16_t azimuth = b * 40;
+        block[2] = azimuth & 0xFF;
+        block[3] = azimuth >> 8;
+        // 10 m and 5 m in 2 mm units.
+        block[4 + 3] = 5000 & 0xFF;
+        block[4 + 4] = 5000 >> 8;
+        block[4 + 5] = 17;
+        block[4 + 6] = 2500 & 0xFF;
+        block[4 + 7] = 2500 >> 8;
+        block[4 + 8] = 99;
+    }
+    uint8_t *tail = packet.data() + 1200;
+    for (int i = 0; i < 4; ++i)
+        tail[i] = (stamp >> (8 * i)) & 0xFF;
+    return packet;
+}
+
+class PointCounter : public Writer
+{
+public:
+    PointCounter() : m_count(0), m_chunks(0)
+        {}
+
+    std::string getName() const
+        { return "writers.pointcounter"; }
+    virtual bool streamable() const
+        { return true; }
+
+    point_count_t m_count;
+    int m_chunks;
+
+private:
+    virtual void write(const PointViewPtr view)
+    {
+        m_count += view->size();
+        m_chunks++;
+    }
+};
+
+} // unnamed namespace
+
+TEST(VelodyneReaderTest, create)
+{
+    StageFactory f;
+    std::unique_ptr<Stage> reader(f.createStage("readers.velodyne"));
+    EXPECT_TRUE(reader.get());
+}
+
+TEST(VelodyneReaderTest, ring)
+{
+    RingBuffer<int> ring(5);
+    EXPECT_EQ(ring.capacity(), 8u);
+
+    int in[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    EXPECT_TRUE(ring.push(in, 6));
+    EXPECT_FALSE(ring.push(in, 3));
+    int out[8];
+    EXPECT_EQ(ring.pop(out, 4), 4u);
+    EXPECT_EQ(out[3], 3);
+    // Wraps around the end.
+    EXPECT_TRUE(ring.push(in, 6));
+    EXPECT_EQ(ring.size(), 8u);
+    EXPECT_EQ(ring.pop(out, 8), 8u);
+    EXPECT_EQ(out[0], 4);
+    EXPECT_EQ(out[2], 0);
+    EXPECT_EQ(out[7], 5);
+    EXPECT_EQ(ring.pop(out, 8), 0u);
+}
+
+TEST(VelodyneReaderTest, decode)
+{
+    std::vector<uint8_t> packet = makePacket(1000000);
+    std::vector<VelodyneReader::Point> points;
+    EXPECT_TRUE(VelodyneReader::decodePacket(packet.data(), points));
+    ASSERT_EQ(points.size(), 24u);
+
+    // Laser 1 points 1 degree up, laser 2 13 degrees down.
+    const VelodyneReader::Point& p = points[0];
+    EXPECT_EQ(p.m_channel, 1);
+    EXPECT_EQ(p.m_intensity, 17);
+    double alpha = (0.4 * 2.304 / 110.592) * M_PI / 180;
+    double omega = M_PI / 180;
+    EXPECT_NEAR(p.m_x, 10 * std::cos(omega) * std::sin(alpha), 1e-9);
+    EXPECT_NEAR(p.m_y, 10 * std::cos(omega) * std::cos(alpha), 1e-9);
+    EXPECT_NEAR(p.m_z, 10 * std::sin(omega), 1e-9);
+    EXPECT_NEAR(p.m_time, 1.0 + 2.304e-6, 1e-12);
+
+    const VelodyneReader::Point& q = points[1];
+    EXPECT_EQ(q.m_channel, 2);
+    EXPECT_NEAR(q.m_z, 5 * std::sin(-13 * M_PI / 180), 1e-9);
+
+    packet[100] = 0;
+    EXPECT_FALSE(VelodyneReader::decodePacket(packet.data(), points));
+}
+
+// Packets sent to the reader come out of a streamed pipeline in chunks
+// that don't wait for more points than have arrived.
+TEST(VelodyneReaderTest, stream)
+{
+    const uint16_t port = 23681;
+    Options ops;
+    ops.add("address", "127.0.0.1");
+    ops.add("port", port);
+    ops.add("timeout", 0.5);
+    ops.add("latency", 0.05);
+    VelodyneReader reader;
+    reader.setOptions(ops);
+    PointCounter writer;
+    writer.setInput(reader);
+
+    const int packets = 40;
+    std::thread sender([port, packets]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        int s = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        for (int i = 0; i < packets; ++i)
+        {
+            std::vector<uint8_t> packet = makePacket(i * 1000);
+            sendto(s, packet.data(), packet.size(), 0,
+                (struct sockaddr *)&addr, sizeof(addr));
+            // A position packet, which is skipped.
+            sendto(s, packet.data(), 512, 0, (struct sockaddr *)&addr,
+                sizeof(addr));
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        close(s);
+    });
+
+    FixedPointTable table(10000);
+    writer.prepare(table);
+    EXPECT_TRUE(writer.pipelineStreamable());
+    point_count_t count = writer.executeStream(table);
+    sender.join();
+
+    EXPECT_EQ(count, (point_count_t)packets * 24);
+    EXPECT_EQ(writer.m_count, count);
+    // The points come in several chunks even though all would fit in one.
+    EXPECT_GT(writer.m_chunks, 1);
+
+    MetadataNode m = reader.getMetadata();
+    EXPECT_EQ(m.findChild("packets").value<int>(), packets);
+    EXPECT_EQ(m.findChild("packets_dropped").value<int>(), 0);
+    EXPECT_EQ(m.findChild("bad_packets").value<int>(), packets);
+}